@@ -0,0 +1,212 @@
+#include "AllocationTracking.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+
+// The replacements below are only compiled in with TEXT_RENDERER_ALLOCATION_TRACKING, defined in Debug builds.
+// Without it nothing is counted, and every count reads 0
+namespace
+{
+    // Plain data, so it needs no dynamic initialization and is safe to touch from inside operator new
+    thread_local AllocationCounts ThreadAllocationCounts;
+
+    thread_local AllocationCounts ThreadSubsystemAllocationCounts[AllocationSubsystemCount];
+
+    thread_local AllocationSubsystem ThreadAllocationSubsystem = AllocationSubsystem::Other;
+
+
+    #ifdef TEXT_RENDERER_ALLOCATION_TRACKING
+
+    void CountAllocation(const std::size_t sizeInBytes)
+    {
+        AllocationCounts& subsystemCounts = ThreadSubsystemAllocationCounts[static_cast<std::size_t>(ThreadAllocationSubsystem)];
+
+        ++ThreadAllocationCounts.Count;
+        ThreadAllocationCounts.Bytes += sizeInBytes;
+
+        ++subsystemCounts.Count;
+        subsystemCounts.Bytes += sizeInBytes;
+    };
+
+
+    /// <summary>
+    /// Allocate like the standard operator new: if the allocation fails, the new_handler is called to free memory and it's tried again.
+    /// Without a handler, std::bad_alloc is thrown. Only allocations that succeed are counted
+    /// </summary>
+    template<typename TAllocate>
+    void* CountedAllocate(const std::size_t sizeInBytes, TAllocate&& allocate)
+    {
+        while(true)
+        {
+            if(void* memory = allocate(sizeInBytes != 0 ? sizeInBytes : 1))
+            {
+                CountAllocation(sizeInBytes);
+                return memory;
+            };
+
+            const std::new_handler handler = std::get_new_handler();
+
+            if(handler == nullptr)
+                throw std::bad_alloc();
+
+            handler();
+        };
+    };
+
+    #endif
+};
+
+
+AllocationCounts GetThreadAllocationCounts()
+{
+    return ThreadAllocationCounts;
+};
+
+AllocationCounts GetThreadAllocationCounts(const AllocationSubsystem subsystem)
+{
+    return ThreadSubsystemAllocationCounts[static_cast<std::size_t>(subsystem)];
+};
+
+AllocationSubsystem SetThreadAllocationSubsystem(const AllocationSubsystem subsystem)
+{
+    const AllocationSubsystem previousSubsystem = ThreadAllocationSubsystem;
+
+    ThreadAllocationSubsystem = subsystem;
+
+    return previousSubsystem;
+};
+
+
+
+#ifdef TEXT_RENDERER_ALLOCATION_TRACKING
+
+void* operator new(const std::size_t sizeInBytes)
+{
+    return CountedAllocate(sizeInBytes, [](const std::size_t size)
+    {
+        return std::malloc(size);
+    });
+};
+
+void* operator new[](const std::size_t sizeInBytes)
+{
+    return operator new(sizeInBytes);
+};
+
+// The nothrow forms report failure, after the new_handler had its chance, as a null pointer
+void* operator new(const std::size_t sizeInBytes, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(sizeInBytes);
+    }
+    catch(const std::bad_alloc&)
+    {
+        return nullptr;
+    };
+};
+
+void* operator new[](const std::size_t sizeInBytes, const std::nothrow_t&) noexcept
+{
+    return operator new(sizeInBytes, std::nothrow);
+};
+
+
+void* operator new(const std::size_t sizeInBytes, const std::align_val_t alignment)
+{
+    return CountedAllocate(sizeInBytes, [alignment](const std::size_t size)
+    {
+        return _aligned_malloc(size, static_cast<std::size_t>(alignment));
+    });
+};
+
+void* operator new[](const std::size_t sizeInBytes, const std::align_val_t alignment)
+{
+    return operator new(sizeInBytes, alignment);
+};
+
+void* operator new(const std::size_t sizeInBytes, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(sizeInBytes, alignment);
+    }
+    catch(const std::bad_alloc&)
+    {
+        return nullptr;
+    };
+};
+
+void* operator new[](const std::size_t sizeInBytes, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return operator new(sizeInBytes, alignment, std::nothrow);
+};
+
+
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+};
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+};
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+};
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+};
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+};
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+};
+
+
+// Aligned memory comes from _aligned_malloc, which has to be freed with _aligned_free
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    _aligned_free(memory);
+};
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+    _aligned_free(memory);
+};
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+    _aligned_free(memory);
+};
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept
+{
+    _aligned_free(memory);
+};
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    _aligned_free(memory);
+};
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    _aligned_free(memory);
+};
+
+#endif
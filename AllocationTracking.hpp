@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// <summary>
+/// Whether the global operator new is replaced to count allocations, with TEXT_RENDERER_ALLOCATION_TRACKING. Debug builds define it
+/// </summary>
+#ifdef TEXT_RENDERER_ALLOCATION_TRACKING
+constexpr bool AllocationTrackingEnabled = true;
+#else
+constexpr bool AllocationTrackingEnabled = false;
+#endif
+
+
+/// <summary>
+/// Allocations made through the global operator new, counted per thread by the replacements in AllocationTracking.cpp.
+/// Always 0 unless AllocationTrackingEnabled
+/// </summary>
+struct AllocationCounts
+{
+    std::uint64_t Count = 0;
+
+    std::uint64_t Bytes = 0;
+
+
+    AllocationCounts operator - (const AllocationCounts& other) const
+    {
+        return { Count - other.Count, Bytes - other.Bytes };
+    };
+};
+
+
+/// <summary>
+/// The part of the renderer an allocation is charged to, see AllocationSubsystemScope
+/// </summary>
+enum class AllocationSubsystem : std::uint32_t
+{
+    /// <summary>
+    /// Anything outside a subsystem scope
+    /// </summary>
+    Other,
+
+    Layout,
+
+    Shader,
+
+    Font,
+
+    Input,
+
+    Count,
+};
+
+constexpr std::size_t AllocationSubsystemCount = static_cast<std::size_t>(AllocationSubsystem::Count);
+
+
+/// <summary>
+/// Everything the calling thread allocated since it started.
+/// Counted per thread, so allocations on other threads (uploads, captures, the driver's) don't show up in a measurement taken on this one
+/// </summary>
+AllocationCounts GetThreadAllocationCounts();
+
+/// <summary>
+/// What the calling thread allocated while a subsystem was current
+/// </summary>
+AllocationCounts GetThreadAllocationCounts(const AllocationSubsystem subsystem);
+
+/// <summary>
+/// Charge the calling thread's following allocations to a subsystem
+/// </summary>
+/// <returns> The subsystem that was current </returns>
+AllocationSubsystem SetThreadAllocationSubsystem(const AllocationSubsystem subsystem);
+
+
+/// <summary>
+/// Charges the calling thread's allocations to a subsystem for the lifetime of the scope. Scopes nest, the innermost one wins
+/// </summary>
+class AllocationSubsystemScope
+{
+
+private:
+
+    AllocationSubsystem _previousSubsystem = AllocationSubsystem::Other;
+
+
+public:
+
+    AllocationSubsystemScope(const AllocationSubsystem subsystem) :
+        _previousSubsystem(SetThreadAllocationSubsystem(subsystem))
+    {
+    };
+
+    AllocationSubsystemScope(const AllocationSubsystemScope&) = delete;
+    AllocationSubsystemScope& operator = (const AllocationSubsystemScope&) = delete;
+
+    ~AllocationSubsystemScope()
+    {
+        SetThreadAllocationSubsystem(_previousSubsystem);
+    };
+
+};
+
+
+/// <summary>
+/// A subsystem's name, for reports
+/// </summary>
+constexpr const char* GetAllocationSubsystemName(const AllocationSubsystem subsystem)
+{
+    switch(subsystem)
+    {
+        case AllocationSubsystem::Layout:
+            return "Layout";
+
+        case AllocationSubsystem::Shader:
+            return "Shader";
+
+        case AllocationSubsystem::Font:
+            return "Font";
+
+        case AllocationSubsystem::Input:
+            return "Input";
+
+        default:
+            return "Other";
+    };
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FontManager.hpp"
+#include "FontSprite.hpp"
+#include "JobSystem.hpp"
+#include "MappedFile.hpp"
+#include "ShaderProgram.hpp"
+#include "Task.hpp"
+
+
+/// <summary>
+/// Loads fonts and shader programs as coroutines, so the first frames can be drawn while assets stream in.
+/// Each load reads its files on the loader's I/O thread, decodes them on a JobSystem, and creates its GL objects on the render thread
+/// inside Update, which the frame calls at a point where the context is free. Nothing blocks the render thread but the GL calls themselves.
+/// Loads are Tasks: start them, keep them until IsDone, then take their result
+/// </summary>
+class AssetLoader
+{
+
+private:
+
+    JobSystem& _jobs;
+
+    /// <summary>
+    /// Every decode running on _jobs, waited for on destruction
+    /// </summary>
+    JobGroup _decodeJobs;
+
+    TaskThread _ioThread;
+
+    TaskQueue _renderThread;
+
+    const ITextureLoader* _textureLoader = nullptr;
+
+
+public:
+
+    /// <param name="jobs"> Where files are decoded, must outlive the loader </param>
+    /// <param name="textureLoader"> Decodes font images, one is picked by the path's extension if null </param>
+    AssetLoader(JobSystem& jobs, const ITextureLoader* textureLoader = nullptr) :
+        _jobs(jobs),
+        _textureLoader(textureLoader)
+    {
+    };
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator = (const AssetLoader&) = delete;
+
+    /// <summary>
+    /// Loads that haven't finished have to be destroyed first, a decode that's still running is waited for
+    /// </summary>
+    ~AssetLoader()
+    {
+        _jobs.Wait(_decodeJobs);
+    };
+
+
+public:
+
+    /// <summary>
+    /// (Render thread) Run the loads' render thread steps, should be called once per frame while no other GL work is in flight on the context
+    /// </summary>
+    /// <returns> The number of steps run </returns>
+    std::size_t Update()
+    {
+        return _renderThread.RunPending();
+    };
+
+
+    /// <summary>
+    /// Load a font's atlas. The key's program must be ready, see LoadShaderProgram
+    /// </summary>
+    /// <returns> The font, or null if its file couldn't be read </returns>
+    Task<std::shared_ptr<FontSprite>> LoadFont(const FontKey key)
+    {
+        const std::filesystem::path path = key.TexturePath;
+
+        const std::shared_ptr<const MappedFile> file = co_await ReadFile(path);
+
+        if(file->IsMapped() == false)
+            co_return nullptr;
+
+
+        co_await OnWorker();
+
+        FontSprite::DecodedAtlas atlas = FontSprite::DecodeAtlas(file, path, _textureLoader, { key.GlyphWidth, key.GlyphHeight }, key.Format);
+
+
+        co_await OnRenderThread();
+
+        co_return std::make_shared<FontSprite>(key.GlyphWidth, key.GlyphHeight, *key.Program, std::move(atlas), 32, SSBOMode::SubData, CharacterPacking::Bits32, key.GenerateMipmaps);
+    };
+
+    /// <summary>
+    /// Compile and link a program, in the driver's background threads where it has them. Finishes during the first Update the program is ready in
+    /// </summary>
+    /// <param name="defines"> See ShaderProgram </param>
+    Task<std::unique_ptr<ShaderProgram>> LoadShaderProgram(const std::string vertexShaderPath, const std::string fragmentShaderPath, std::vector<std::string> defines = { })
+    {
+        // Shaders are small, but a cold disk still shouldn't stall the frame that compiles them
+        co_await ReadFile(vertexShaderPath);
+        co_await ReadFile(fragmentShaderPath);
+
+
+        co_await OnRenderThread();
+
+        std::unique_ptr<ShaderProgram> program = std::make_unique<ShaderProgram>(vertexShaderPath, fragmentShaderPath, true, ShaderCompileMode::Asynchronous, std::move(defines));
+
+        while(program->IsReady() == false)
+        {
+            co_await OnRenderThread();
+        };
+
+        co_return program;
+    };
+
+
+    /// <summary>
+    /// Map a file and read it into memory, on the I/O thread
+    /// </summary>
+    Task<std::shared_ptr<const MappedFile>> ReadFile(const std::filesystem::path path)
+    {
+        co_await _ioThread.Schedule();
+
+        std::shared_ptr<const MappedFile> file = std::make_shared<const MappedFile>(path);
+
+        file->ReadAhead();
+
+        co_return file;
+    };
+
+
+public:
+
+    // Await these to hop between threads in loads of your own
+
+    TaskQueue::ScheduleAwaiter OnIOThread()
+    {
+        return _ioThread.Schedule();
+    };
+
+    JobSystemAwaiter OnWorker()
+    {
+        return ResumeOn(_jobs, _decodeJobs);
+    };
+
+    /// <summary>
+    /// Continues in the next Update
+    /// </summary>
+    TaskQueue::ScheduleAwaiter OnRenderThread()
+    {
+        return _renderThread.Schedule();
+    };
+
+};
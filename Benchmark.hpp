@@ -0,0 +1,601 @@
+#pragma once
+
+#include <Windows.h>
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FontSprite.hpp"
+#include "TextBatch.hpp"
+#include "FrameUniformBuffer.hpp"
+#include "FrameCapture.hpp"
+#include "DrawCapture.hpp"
+
+
+/// <summary>
+/// A text rendering workload, drawn for a number of frames
+/// </summary>
+struct BenchmarkWorkload
+{
+    std::string Name;
+
+    /// <summary>
+    /// The length of every drawn string
+    /// </summary>
+    std::size_t CharactersPerString = 0;
+
+    /// <summary>
+    /// How many strings, each a separate FontSprite::Draw, are drawn per frame
+    /// </summary>
+    std::size_t StringCount = 1;
+
+    /// <summary>
+    /// One character of every string changes every frame, otherwise the text is the same every frame
+    /// </summary>
+    bool ChangingText = false;
+
+    std::uint32_t FrameCount = 100;
+};
+
+
+/// <summary>
+/// The averaged measurements of a workload
+/// </summary>
+struct BenchmarkResult
+{
+    std::string Name;
+
+    std::size_t CharactersPerString = 0;
+    std::size_t StringCount = 0;
+    bool ChangingText = false;
+    std::uint32_t FrameCount = 0;
+
+    /// <summary>
+    /// The time spent issuing a frame's draws
+    /// </summary>
+    double CPUMillisecondsPerFrame = 0.0;
+
+    /// <summary>
+    /// The time the GPU spent executing a frame, from GL_TIME_ELAPSED queries
+    /// </summary>
+    double GPUMillisecondsPerFrame = 0.0;
+
+    /// <summary>
+    /// Characters drawn per second of the slower of the CPU and GPU
+    /// </summary>
+    double GlyphsPerSecond = 0.0;
+
+    double BytesUploadedPerFrame = 0.0;
+
+    /// <summary>
+    /// A hash of the last frame's pixels, changes if the workload is drawn differently
+    /// </summary>
+    std::uint64_t OutputChecksum = 0;
+};
+
+
+/// <summary>
+/// The workloads run by default, from a single character to 10 million, and from a single string to 10 thousand
+/// </summary>
+inline std::vector<BenchmarkWorkload> GetDefaultBenchmarkWorkloads()
+{
+    return
+    {
+        { .Name = "1 character",                 .CharactersPerString = 1,          .StringCount = 1,     .ChangingText = false, .FrameCount = 1000 },
+        { .Name = "1K characters",               .CharactersPerString = 1'000,      .StringCount = 1,     .ChangingText = false, .FrameCount = 1000 },
+        { .Name = "1K characters, changing",     .CharactersPerString = 1'000,      .StringCount = 1,     .ChangingText = true,  .FrameCount = 1000 },
+        { .Name = "100K characters",             .CharactersPerString = 100'000,    .StringCount = 1,     .ChangingText = false, .FrameCount = 200 },
+        { .Name = "100K characters, changing",   .CharactersPerString = 100'000,    .StringCount = 1,     .ChangingText = true,  .FrameCount = 200 },
+        { .Name = "10M characters",              .CharactersPerString = 10'000'000, .StringCount = 1,     .ChangingText = false, .FrameCount = 10 },
+        { .Name = "10M characters, changing",    .CharactersPerString = 10'000'000, .StringCount = 1,     .ChangingText = true,  .FrameCount = 10 },
+        { .Name = "100 strings",                 .CharactersPerString = 32,         .StringCount = 100,   .ChangingText = false, .FrameCount = 200 },
+        { .Name = "10K strings",                 .CharactersPerString = 32,         .StringCount = 10'000, .ChangingText = false, .FrameCount = 20 },
+        { .Name = "10K strings, changing",       .CharactersPerString = 32,         .StringCount = 10'000, .ChangingText = true,  .FrameCount = 20 },
+    };
+};
+
+/// <summary>
+/// A workload given on the command line, named after its parameters. Counts of 0 are raised to 1
+/// </summary>
+inline BenchmarkWorkload CreateBenchmarkWorkload(const std::size_t charactersPerString, const std::size_t stringCount, const std::uint32_t frameCount, const bool changingText)
+{
+    BenchmarkWorkload workload =
+    {
+        .CharactersPerString = std::max<std::size_t>(charactersPerString, 1),
+        .StringCount = std::max<std::size_t>(stringCount, 1),
+        .ChangingText = changingText,
+        .FrameCount = std::max<std::uint32_t>(frameCount, 1),
+    };
+
+    workload.Name = std::to_string(workload.CharactersPerString).append(workload.CharactersPerString == 1 ? " character" : " characters");
+
+    if(workload.StringCount > 1)
+        workload.Name.append(" x ").append(std::to_string(workload.StringCount)).append(" strings");
+
+    if(workload.ChangingText == true)
+        workload.Name.append(", changing");
+
+    return workload;
+};
+
+
+/// <summary>
+/// Draws workloads into an offscreen framebuffer and measures them. Requires a current context, which may belong to a hidden window
+/// </summary>
+class TextBenchmark
+{
+
+private:
+
+    std::reference_wrapper<FontSprite> _fontSprite;
+
+    std::reference_wrapper<const FrameUniformBuffer> _frameUniformBuffer;
+
+    std::uint32_t _width = 0;
+    std::uint32_t _height = 0;
+
+    std::uint32_t _framebuffer = 0;
+    std::uint32_t _colourRenderbuffer = 0;
+
+    /// <summary>
+    /// Reads each workload's last frame back for its checksum
+    /// </summary>
+    mutable FrameCapture _outputCapture;
+
+    /// <summary>
+    /// Written by the capture's worker, read once the capture was flushed
+    /// </summary>
+    mutable std::uint64_t _outputChecksum = 0;
+
+
+public:
+
+    /// <param name="fontSprite"> The font drawn with, its current settings (upload mode, packing, layout) are what's measured </param>
+    /// <param name="frameUniformBuffer"></param>
+    /// <param name="width"> The offscreen framebuffer's width </param>
+    /// <param name="height"> The offscreen framebuffer's height </param>
+    TextBenchmark(FontSprite& fontSprite,
+                  const FrameUniformBuffer& frameUniformBuffer,
+                  const std::uint32_t width = 1920,
+                  const std::uint32_t height = 1080) :
+        _fontSprite(fontSprite),
+        _frameUniformBuffer(frameUniformBuffer),
+        _width(width),
+        _height(height),
+        _outputCapture([this](const CapturedFrame& frame)
+        {
+            _outputChecksum = ChecksumPixels(frame.Pixels);
+        }, 1)
+    {
+        glCreateRenderbuffers(1, &_colourRenderbuffer);
+        glNamedRenderbufferStorage(_colourRenderbuffer, GL_RGBA8, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height));
+
+        glCreateFramebuffers(1, &_framebuffer);
+        glNamedFramebufferRenderbuffer(_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colourRenderbuffer);
+
+        wt::Assert(glCheckNamedFramebufferStatus(_framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Benchmark framebuffer is incomplete");
+    };
+
+    TextBenchmark(const TextBenchmark&) = delete;
+    TextBenchmark& operator = (const TextBenchmark&) = delete;
+
+    ~TextBenchmark()
+    {
+        glDeleteFramebuffers(1, &_framebuffer);
+        glDeleteRenderbuffers(1, &_colourRenderbuffer);
+    };
+
+
+public:
+
+    BenchmarkResult Run(const BenchmarkWorkload& workload) const
+    {
+        FontSprite& fontSprite = _fontSprite.get();
+
+        std::vector<std::string> strings = CreateStrings(workload);
+
+        // Strings are spread over the framebuffer in a grid, so most of them are visible
+        const std::size_t columns = std::max<std::size_t>(static_cast<std::size_t>(std::sqrt(static_cast<double>(strings.size()))), 1);
+
+        std::vector<glm::mat4> transforms(strings.size());
+
+        for(std::size_t index = 0; index < strings.size(); ++index)
+        {
+            const float x = static_cast<float>(index % columns) * (static_cast<float>(_width) / static_cast<float>(columns));
+            const float y = static_cast<float>(index / columns) * fontSprite.GetLineHeight();
+
+            transforms[index] = glm::translate(glm::mat4(1.0f), { x, y, 0.0f });
+        };
+
+
+        BenchmarkResult result = Measure(fontSprite, workload.FrameCount, workload.CharactersPerString * workload.StringCount, [&](const std::uint32_t frame)
+        {
+            if(workload.ChangingText == true)
+            {
+                for(std::string& text : strings)
+                {
+                    char& changedCharacter = text[frame % text.size()];
+
+                    changedCharacter = changedCharacter == 'x' ? 'y' : 'x';
+                };
+            };
+
+            fontSprite.Bind();
+
+            for(std::size_t index = 0; index < strings.size(); ++index)
+            {
+                fontSprite.Transform = transforms[index];
+
+                fontSprite.Draw(strings[index]);
+            };
+        });
+
+        result.Name = workload.Name;
+        result.CharactersPerString = workload.CharactersPerString;
+        result.StringCount = workload.StringCount;
+        result.ChangingText = workload.ChangingText;
+
+        return result;
+    };
+
+    std::vector<BenchmarkResult> Run(const std::vector<BenchmarkWorkload>& workloads) const
+    {
+        std::vector<BenchmarkResult> results;
+        results.reserve(workloads.size());
+
+        for(const BenchmarkWorkload& workload : workloads)
+        {
+            results.emplace_back(Run(workload));
+        };
+
+        return results;
+    };
+
+
+    /// <summary>
+    /// Play a draw capture back as fast as it goes, a frame of the capture per measured frame, see DrawRecorder.
+    /// Draws go to the benchmark's font, with the transform and layout they were recorded with
+    /// </summary>
+    /// <param name="capture"> The recorded frames </param>
+    /// <param name="textBatch"> Replays the recorded TextBatch calls, which are skipped without one </param>
+    /// <param name="name"> The result's name </param>
+    BenchmarkResult Replay(const DrawCapture& capture, TextBatch* textBatch = nullptr, const std::string& name = "Replay") const
+    {
+        FontSprite& fontSprite = _fontSprite.get();
+
+        const std::uint32_t frameCount = static_cast<std::uint32_t>(capture.GetFrameCount());
+
+        const TextLayoutOptions previousLayout = fontSprite.Layout;
+        const glm::mat4 previousBatchTransform = textBatch != nullptr ? textBatch->Transform : glm::mat4(1.0f);
+
+        std::size_t callCount = 0;
+
+        // The recorded TextBuffers, edited as they were, so their draws upload only what changed. A deque, so they never move
+        std::deque<TextBuffer> textBuffers;
+
+        BenchmarkResult result = Measure(fontSprite, frameCount, capture.GetCharacterCount() / std::max<std::size_t>(frameCount, 1), [&](const std::uint32_t frame)
+        {
+            fontSprite.Bind();
+
+            for(const CapturedDrawCall& call : capture.GetFrame(frame))
+            {
+                ++callCount;
+
+                switch(call.Command)
+                {
+                    case DrawCaptureCommand::Draw:
+                    {
+                        fontSprite.Transform = call.Transform;
+                        fontSprite.Layout = call.Layout;
+
+                        if(call.Utf8 == true)
+                            fontSprite.Draw(std::u8string_view(reinterpret_cast<const char8_t*>(call.Text.data()), call.Text.size()), call.Colour);
+                        else
+                            fontSprite.Draw(call.Text, call.Colour);
+
+                        break;
+                    };
+
+                    case DrawCaptureCommand::BufferEdit:
+                    {
+                        if(call.BufferIndex == textBuffers.size())
+                            textBuffers.emplace_back();
+
+                        TextBuffer& textBuffer = textBuffers[call.BufferIndex];
+
+                        if(call.EditPosition < textBuffer.GetSize())
+                            textBuffer.Erase(call.EditPosition, textBuffer.GetSize() - call.EditPosition);
+
+                        if(call.Text.empty() == false)
+                            textBuffer.Insert(call.EditPosition, call.Text);
+
+                        break;
+                    };
+
+                    case DrawCaptureCommand::BufferDraw:
+                    {
+                        fontSprite.Transform = call.Transform;
+                        fontSprite.Layout = call.Layout;
+
+                        fontSprite.Draw(textBuffers[call.BufferIndex], call.Colour);
+
+                        break;
+                    };
+
+                    case DrawCaptureCommand::BatchBegin:
+                    {
+                        if(textBatch != nullptr)
+                            textBatch->Begin();
+
+                        break;
+                    };
+
+                    case DrawCaptureCommand::BatchSubmit:
+                    {
+                        if(textBatch != nullptr)
+                            textBatch->Submit(call.Text, call.Origin, call.Colour, call.FontIndex, call.Layer, call.Scale, call.Style);
+
+                        break;
+                    };
+
+                    case DrawCaptureCommand::BatchPushClip:
+                    {
+                        if(textBatch != nullptr)
+                            textBatch->PushClip(call.Colour);
+
+                        break;
+                    };
+
+                    case DrawCaptureCommand::BatchPopClip:
+                    {
+                        if(textBatch != nullptr)
+                            textBatch->PopClip();
+
+                        break;
+                    };
+
+                    case DrawCaptureCommand::BatchFlush:
+                    {
+                        if(textBatch != nullptr)
+                        {
+                            textBatch->Transform = call.Transform;
+                            textBatch->Flush();
+
+                            // The font's program is bound again for its next draw
+                            fontSprite.Bind();
+                        };
+
+                        break;
+                    };
+
+                    default:
+                        break;
+                };
+            };
+
+            if(textBatch != nullptr)
+                textBatch->EndFrame();
+        });
+
+        fontSprite.Layout = previousLayout;
+
+        if(textBatch != nullptr)
+            textBatch->Transform = previousBatchTransform;
+
+        result.Name = name;
+        result.StringCount = callCount / std::max<std::size_t>(frameCount, 1);
+
+        return result;
+    };
+
+
+    /// <summary>
+    /// Draw frames into the offscreen framebuffer and measure them, e.g. for workloads that draw with another instance of the benchmark's font.
+    /// The font's transform is restored afterwards
+    /// </summary>
+    /// <param name="fontSprite"> The font whose uploads are counted, and whose EndFrame ends every frame </param>
+    /// <param name="frameCount"> How many frames to draw </param>
+    /// <param name="charactersPerFrame"> How many characters a frame draws, for the result's throughput </param>
+    /// <param name="drawFrame"> Issues a frame's draws, called with the frame's index </param>
+    /// <returns> The measurements, without the workload's description </returns>
+    template<typename TFunction>
+    BenchmarkResult Measure(FontSprite& fontSprite, const std::uint32_t frameCount, const std::size_t charactersPerFrame, TFunction&& drawFrame) const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        glViewport(0, 0, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height));
+
+        _frameUniformBuffer.get().Update(FrameData
+        {
+            .ScreenSpaceProjection = glm::ortho(0.0f, static_cast<float>(_width), static_cast<float>(_height), 0.0f, -1.0f, 1.0f),
+            .ViewportSize = { static_cast<float>(_width), static_cast<float>(_height) },
+        });
+
+
+        // Every frame gets its own query, they're only read once the whole run is done
+        std::vector<std::uint32_t> timeQueries(frameCount);
+        glCreateQueries(GL_TIME_ELAPSED, static_cast<GLsizei>(timeQueries.size()), timeQueries.data());
+
+        const glm::mat4 previousTransform = fontSprite.Transform;
+
+        const std::size_t firstUploadedByteCount = fontSprite.GetUploadedByteCount();
+
+        // Nothing before the run should be measured
+        glFinish();
+
+        const std::int64_t cpuBegin = GetCPUTime();
+
+        for(std::uint32_t frame = 0; frame < frameCount; ++frame)
+        {
+            glBeginQuery(GL_TIME_ELAPSED, timeQueries[frame]);
+
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            drawFrame(frame);
+
+            glEndQuery(GL_TIME_ELAPSED);
+
+            fontSprite.EndFrame();
+        };
+
+        const std::int64_t cpuEnd = GetCPUTime();
+
+        // Read after the time queries, so it isn't part of the measurement
+        _outputCapture.Capture(_width, _height, _framebuffer);
+
+        glFinish();
+
+        _outputCapture.Flush();
+
+
+        std::uint64_t gpuNanoseconds = 0;
+
+        for(const std::uint32_t query : timeQueries)
+        {
+            std::uint64_t elapsed = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+
+            gpuNanoseconds += elapsed;
+        };
+
+        glDeleteQueries(static_cast<GLsizei>(timeQueries.size()), timeQueries.data());
+
+
+        fontSprite.Transform = previousTransform;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+
+        const double measuredFrameCount = static_cast<double>(std::max(frameCount, 1u));
+
+        BenchmarkResult result
+        {
+            .FrameCount = frameCount,
+            .CPUMillisecondsPerFrame = static_cast<double>(cpuEnd - cpuBegin) * 1000.0 / static_cast<double>(GetCPUFrequency()) / measuredFrameCount,
+            .GPUMillisecondsPerFrame = static_cast<double>(gpuNanoseconds) / 1'000'000.0 / measuredFrameCount,
+            .BytesUploadedPerFrame = static_cast<double>(fontSprite.GetUploadedByteCount() - firstUploadedByteCount) / measuredFrameCount,
+            .OutputChecksum = _outputChecksum,
+        };
+
+        const double frameMilliseconds = std::max(result.CPUMillisecondsPerFrame, result.GPUMillisecondsPerFrame);
+
+        result.GlyphsPerSecond = frameMilliseconds > 0.0 ? static_cast<double>(charactersPerFrame) * 1000.0 / frameMilliseconds : 0.0;
+
+        return result;
+    };
+
+
+public:
+
+    FontSprite& GetFontSprite() const
+    {
+        return _fontSprite.get();
+    };
+
+    std::uint32_t GetWidth() const
+    {
+        return _width;
+    };
+
+    std::uint32_t GetHeight() const
+    {
+        return _height;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Printable text broken into 80 column lines
+    /// </summary>
+    static std::vector<std::string> CreateStrings(const BenchmarkWorkload& workload)
+    {
+        std::string text(workload.CharactersPerString, ' ');
+
+        for(std::size_t index = 0; index < text.size(); ++index)
+        {
+            text[index] = (index % 81) == 80 ? '\n' : static_cast<char>('!' + (index % 94));
+        };
+
+        return std::vector<std::string>(workload.StringCount, text);
+    };
+
+
+    /// <summary>
+    /// FNV-1a over a frame's pixels
+    /// </summary>
+    static std::uint64_t ChecksumPixels(const std::vector<std::byte>& pixels)
+    {
+        std::uint64_t hash = 0xCBF29CE484222325;
+
+        for(const std::byte pixel : pixels)
+        {
+            hash = (hash ^ static_cast<std::uint64_t>(pixel)) * 0x100000001B3;
+        };
+
+        return hash;
+    };
+
+
+    static std::int64_t GetCPUTime()
+    {
+        LARGE_INTEGER time;
+        QueryPerformanceCounter(&time);
+
+        return time.QuadPart;
+    };
+
+    static std::int64_t GetCPUFrequency()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+
+        return frequency.QuadPart;
+    };
+
+};
+
+
+/// <summary>
+/// Write results as a JSON array, one object per workload
+/// </summary>
+inline void WriteBenchmarkResultsJSON(std::ostream& stream, const std::vector<BenchmarkResult>& results)
+{
+    stream << "[\n";
+
+    for(std::size_t index = 0; index < results.size(); ++index)
+    {
+        const BenchmarkResult& result = results[index];
+
+        // Workload names are ours, nothing in them needs escaping
+        char line[512] = { };
+
+        std::snprintf(line, sizeof(line),
+                      "  { \"name\": \"%s\", \"charactersPerString\": %zu, \"stringCount\": %zu, \"changingText\": %s, \"frames\": %u, "
+                      "\"cpuMsPerFrame\": %.4f, \"gpuMsPerFrame\": %.4f, \"glyphsPerSecond\": %.0f, \"bytesUploadedPerFrame\": %.0f, \"outputChecksum\": \"%016llx\" }%s\n",
+                      result.Name.c_str(),
+                      result.CharactersPerString,
+                      result.StringCount,
+                      result.ChangingText == true ? "true" : "false",
+                      result.FrameCount,
+                      result.CPUMillisecondsPerFrame,
+                      result.GPUMillisecondsPerFrame,
+                      result.GlyphsPerSecond,
+                      result.BytesUploadedPerFrame,
+                      static_cast<unsigned long long>(result.OutputChecksum),
+                      index + 1 < results.size() ? "," : "");
+
+        stream << line;
+    };
+
+    stream << "]\n";
+};
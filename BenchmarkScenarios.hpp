@@ -0,0 +1,1028 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "FontSprite.hpp"
+#include "TextBatch.hpp"
+#include "TextStyle.hpp"
+
+
+/// <summary>
+/// How a scenario's text is drawn, see ScenarioBenchmark
+/// </summary>
+enum class BenchmarkMode
+{
+    /// <summary>
+    /// A Draw per character, each uploading its single character, the way text is drawn when every glyph is its own sprite
+    /// </summary>
+    PerCharacter,
+
+    /// <summary>
+    /// A Draw per string, uploaded with glNamedBufferSubData, see SSBOMode::SubData
+    /// </summary>
+    Bulk,
+
+    /// <summary>
+    /// A Draw per string, written straight into a persistently mapped ring, see SSBOMode::PersistentRing
+    /// </summary>
+    PersistentMapped,
+
+    /// <summary>
+    /// Every string submitted to a TextBatch, laid out on the CPU and drawn with a single draw per frame
+    /// </summary>
+    Batched,
+
+    /// <summary>
+    /// A DrawRetained per string, each with an instance of its own. The compute pass only lays a string out again once it's edited,
+    /// scrolling only changes the transform
+    /// </summary>
+    RetainedLayout,
+};
+
+inline constexpr std::array<BenchmarkMode, 5> BenchmarkModes =
+{
+    BenchmarkMode::PerCharacter,
+    BenchmarkMode::Bulk,
+    BenchmarkMode::PersistentMapped,
+    BenchmarkMode::Batched,
+    BenchmarkMode::RetainedLayout,
+};
+
+
+/// <summary>
+/// The mode's name in scenario files, results and the comparison table
+/// </summary>
+inline std::string_view GetBenchmarkModeName(const BenchmarkMode mode)
+{
+    switch(mode)
+    {
+        case BenchmarkMode::PerCharacter:
+            return "per-character";
+
+        case BenchmarkMode::Bulk:
+            return "bulk";
+
+        case BenchmarkMode::PersistentMapped:
+            return "persistent-mapped";
+
+        case BenchmarkMode::Batched:
+            return "batched";
+
+        case BenchmarkMode::RetainedLayout:
+            return "retained-layout";
+
+        default:
+            return "unknown";
+    };
+};
+
+inline std::optional<BenchmarkMode> FindBenchmarkMode(const std::string_view& name)
+{
+    for(const BenchmarkMode mode : BenchmarkModes)
+    {
+        if(GetBenchmarkModeName(mode) == name)
+            return mode;
+    };
+
+    return std::nullopt;
+};
+
+
+/// <summary>
+/// The atlas format's name in scenario files, as --bake-atlas takes it
+/// </summary>
+inline std::string_view GetAtlasFormatName(const AtlasFormat atlasFormat)
+{
+    switch(atlasFormat)
+    {
+        case AtlasFormat::ChromaKeyedRGBA:
+            return "rgba";
+
+        case AtlasFormat::DistanceField:
+            return "sdf";
+
+        case AtlasFormat::Subpixel:
+            return "lcd";
+
+        default:
+            return "coverage";
+    };
+};
+
+
+/// <summary>
+/// A scene to measure every mode with, see LoadBenchmarkScenarios
+/// </summary>
+struct BenchmarkScenario
+{
+    std::string Name;
+
+    /// <summary>
+    /// The atlas format the scene is meant for, "coverage", "sdf", "rgba" or "lcd". Scenes for another format than the loaded font's are skipped.
+    /// Empty for any
+    /// </summary>
+    std::string Font;
+
+    std::size_t StringCount = 1;
+
+    std::size_t CharactersPerString = 1'000;
+
+    /// <summary>
+    /// A line break follows every this many characters, 0 for strings of a single line
+    /// </summary>
+    std::size_t LineLength = 80;
+
+    /// <summary>
+    /// Characters changed every frame, spread over the strings. The same characters change in every mode
+    /// </summary>
+    std::size_t EditsPerFrame = 0;
+
+    /// <summary>
+    /// Differently coloured runs per string, 0 draws every string in one colour
+    /// </summary>
+    std::size_t SpansPerString = 0;
+
+    /// <summary>
+    /// The layout's wrap width in pixels, 0 for no wrapping. The batched and per-character modes place glyphs themselves and don't wrap
+    /// </summary>
+    float WrapWidth = 0.0f;
+
+    /// <summary>
+    /// How far the text scrolls up every frame, in pixels. It starts over every framebuffer height, so the text stays on screen
+    /// </summary>
+    float ScrollPixelsPerFrame = 0.0f;
+
+    std::uint32_t FrameCount = 100;
+
+    /// <summary>
+    /// The modes the scene is measured in, every one by default
+    /// </summary>
+    std::vector<BenchmarkMode> Modes = std::vector<BenchmarkMode>(BenchmarkModes.cbegin(), BenchmarkModes.cend());
+};
+
+
+/// <summary>
+/// A scene's measurements in one mode
+/// </summary>
+struct BenchmarkScenarioResult
+{
+    /// <summary>
+    /// Named after the scene
+    /// </summary>
+    BenchmarkResult Result;
+
+    BenchmarkMode Mode = BenchmarkMode::Bulk;
+};
+
+
+namespace BenchmarkScenarioParsing
+{
+    inline std::string_view Trim(const std::string_view& text)
+    {
+        const std::size_t first = text.find_first_not_of(" \t\r");
+
+        if(first == std::string_view::npos)
+            return { };
+
+        return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+    };
+
+    /// <summary>
+    /// Parse a number, leaving the target as it was unless the whole value is a number of at least the minimum
+    /// </summary>
+    template<typename TValue>
+    bool ParseValue(const std::string_view& value, TValue& target, const TValue minimum = TValue())
+    {
+        TValue parsed = TValue();
+
+        const std::from_chars_result result = std::from_chars(value.data(), value.data() + value.size(), parsed);
+
+        if(result.ec != std::errc() || result.ptr != value.data() + value.size() || parsed < minimum)
+            return false;
+
+        target = parsed;
+
+        return true;
+    };
+
+    /// <summary>
+    /// A comma separated list of mode names
+    /// </summary>
+    inline bool ParseModes(std::string_view value, std::vector<BenchmarkMode>& modes)
+    {
+        std::vector<BenchmarkMode> parsedModes;
+
+        while(value.empty() == false)
+        {
+            const std::size_t comma = value.find(',');
+
+            const std::optional<BenchmarkMode> mode = FindBenchmarkMode(Trim(value.substr(0, comma)));
+
+            if(mode.has_value() == false)
+                return false;
+
+            parsedModes.push_back(*mode);
+
+            value = comma != std::string_view::npos ? value.substr(comma + 1) : std::string_view();
+        };
+
+        if(parsedModes.empty() == true)
+            return false;
+
+        modes = std::move(parsedModes);
+
+        return true;
+    };
+
+    /// <summary>
+    /// The text of a value in a line written by WriteBenchmarkScenarioResultsJSON, without its quotes. Empty if the line has no such key
+    /// </summary>
+    inline std::string_view FindJSONValue(const std::string_view& line, const std::string_view& key)
+    {
+        const std::string quotedKey = "\"" + std::string(key) + "\": ";
+
+        const std::size_t keyOffset = line.find(quotedKey);
+
+        if(keyOffset == std::string_view::npos)
+            return { };
+
+        std::string_view value = line.substr(keyOffset + quotedKey.size());
+
+        if(value.starts_with('"') == true)
+        {
+            value = value.substr(1);
+
+            return value.substr(0, value.find('"'));
+        };
+
+        return Trim(value.substr(0, value.find_first_of(",}")));
+    };
+};
+
+
+/// <summary>
+/// Read scenes from a file of "[name]" sections, each followed by "key = value" lines. Lines starting with '#' are comments.
+/// The keys are font, strings, characters, lineLength, editsPerFrame, colourSpans, wrapWidth, scrollSpeed, frames and modes, see BenchmarkScenario.
+/// Malformed lines are reported and skipped
+/// </summary>
+/// <returns> Empty if the file can't be read </returns>
+inline std::vector<BenchmarkScenario> LoadBenchmarkScenarios(const std::filesystem::path& path)
+{
+    using namespace BenchmarkScenarioParsing;
+
+    std::ifstream file = std::ifstream(path);
+
+    if(file.is_open() == false)
+    {
+        std::cerr << "Unable to read benchmark scenarios from \"" << path.string() << "\"\n";
+        return { };
+    };
+
+    std::vector<BenchmarkScenario> scenarios;
+
+    std::string line;
+    std::size_t lineNumber = 0;
+
+    const auto report = [&](const std::string_view& problem)
+    {
+        std::cerr << "Scenario file \"" << path.string() << "\" line " << lineNumber << ": " << problem << "\n";
+    };
+
+    while(std::getline(file, line))
+    {
+        ++lineNumber;
+
+        const std::string_view text = Trim(line);
+
+        if(text.empty() == true || text.front() == '#')
+            continue;
+
+        if(text.front() == '[')
+        {
+            if(text.size() < 3 || text.back() != ']')
+                report("malformed scenario name");
+            else
+                scenarios.push_back(BenchmarkScenario { .Name = std::string(Trim(text.substr(1, text.size() - 2))) });
+
+            continue;
+        };
+
+        const std::size_t equals = text.find('=');
+
+        if(equals == std::string_view::npos || scenarios.empty() == true)
+        {
+            report("expected \"key = value\" after a [scenario name]");
+            continue;
+        };
+
+        const std::string_view key = Trim(text.substr(0, equals));
+        const std::string_view value = Trim(text.substr(equals + 1));
+
+        BenchmarkScenario& scenario = scenarios.back();
+
+        bool valid = true;
+
+        if(key == "font")
+            scenario.Font = std::string(value);
+        else if(key == "strings")
+            valid = ParseValue<std::size_t>(value, scenario.StringCount, 1);
+        else if(key == "characters")
+            valid = ParseValue<std::size_t>(value, scenario.CharactersPerString, 1);
+        else if(key == "lineLength")
+            valid = ParseValue(value, scenario.LineLength);
+        else if(key == "editsPerFrame")
+            valid = ParseValue(value, scenario.EditsPerFrame);
+        else if(key == "colourSpans")
+            valid = ParseValue(value, scenario.SpansPerString);
+        else if(key == "wrapWidth")
+            valid = ParseValue(value, scenario.WrapWidth);
+        else if(key == "scrollSpeed")
+            valid = ParseValue(value, scenario.ScrollPixelsPerFrame);
+        else if(key == "frames")
+            valid = ParseValue<std::uint32_t>(value, scenario.FrameCount, 1);
+        else if(key == "modes")
+            valid = ParseModes(value, scenario.Modes);
+        else
+        {
+            report("unknown key \"" + std::string(key) + "\"");
+            continue;
+        };
+
+        if(valid == false)
+            report("invalid value \"" + std::string(value) + "\" for \"" + std::string(key) + "\"");
+    };
+
+    return scenarios;
+};
+
+
+/// <summary>
+/// Measures scenes in each of their modes, with instances of a TextBenchmark's font drawing into its framebuffer.
+/// Every mode draws the same strings, edits and scroll, so their output checksums only differ where a mode draws differently, e.g. doesn't wrap
+/// </summary>
+class ScenarioBenchmark
+{
+
+private:
+
+    /// <summary>
+    /// A run of a string drawn by a single submit or draw. Strings are broken into runs at colour spans and, for a TextBatch, at line breaks
+    /// </summary>
+    struct TextRun
+    {
+        std::size_t FirstCharacter = 0;
+        std::size_t CharacterCount = 0;
+
+        /// <summary>
+        /// From the string's origin
+        /// </summary>
+        glm::vec2 Offset = { 0.0f, 0.0f };
+
+        glm::vec4 Colour = { 0.0f, 0.0f, 0.0f, 1.0f };
+    };
+
+
+    std::reference_wrapper<const TextBenchmark> _benchmark;
+
+    const ShaderProgram* _styledProgram = nullptr;
+
+    const ShaderProgram* _batchProgram = nullptr;
+
+
+public:
+
+    /// <param name="benchmark"> Measures the scenes, which are drawn with instances of its font </param>
+    /// <param name="styledProgram"> A FontShaderFeature::Styles variant of the font's program, which scenes with colour spans need for DrawStyled.
+    /// Without one they're only drawn per character and batched </param>
+    /// <param name="batchProgram"> A program built from TextBatchVertexShader.glsl and the font's fragment shader. Without one the batched mode is skipped </param>
+    ScenarioBenchmark(const TextBenchmark& benchmark, const ShaderProgram* styledProgram = nullptr, const ShaderProgram* batchProgram = nullptr) :
+        _benchmark(benchmark),
+        _styledProgram(styledProgram),
+        _batchProgram(batchProgram)
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// Why a scene can't be measured in a mode
+    /// </summary>
+    /// <returns> Empty if it can </returns>
+    std::string GetUnsupportedReason(const BenchmarkScenario& scenario, const BenchmarkMode mode) const
+    {
+        const AtlasFormat atlasFormat = _benchmark.get().GetFontSprite().GetAtlasFormat();
+
+        if(scenario.Font.empty() == false && scenario.Font != GetAtlasFormatName(atlasFormat))
+            return "the scene is for a \"" + scenario.Font + "\" atlas, the font's is \"" + std::string(GetAtlasFormatName(atlasFormat)) + "\"";
+
+        if(mode == BenchmarkMode::Batched && _batchProgram == nullptr)
+            return "there's no batch program";
+
+        if(scenario.SpansPerString > 0 && (mode == BenchmarkMode::Bulk || mode == BenchmarkMode::PersistentMapped) && _styledProgram == nullptr)
+            return "colour spans need a styled program";
+
+        // DrawRetained only keeps plain text
+        if(scenario.SpansPerString > 0 && mode == BenchmarkMode::RetainedLayout)
+            return "retained layouts don't keep colour spans";
+
+        return { };
+    };
+
+
+    BenchmarkScenarioResult Run(const BenchmarkScenario& scenario, const BenchmarkMode mode) const
+    {
+        const TextBenchmark& benchmark = _benchmark.get();
+
+        FontSprite& font = benchmark.GetFontSprite();
+
+        wt::Assert(GetUnsupportedReason(scenario, mode).empty() == true, "The scene can't be measured in this mode");
+
+
+        std::vector<std::string> strings = CreateStrings(scenario);
+
+        const std::vector<TextSpan> spans = CreateSpans(scenario);
+
+        const std::vector<glm::vec2> origins = GetStringOrigins(scenario, font);
+
+        // Runs only break at line breaks and spans, which edits never move, so they're found once
+        const std::vector<TextRun> runs = FindRuns(strings.front(), spans, mode == BenchmarkMode::Batched, font);
+
+        const std::size_t charactersPerFrame = scenario.StringCount * scenario.CharactersPerString;
+
+        // Every mode starts from the same seed, so they all make the same edits
+        std::uint64_t editState = 0x9E3779B97F4A7C15;
+
+        const auto nextRandom = [&]()
+        {
+            editState = editState * 6364136223846793005 + 1442695040888963407;
+
+            return static_cast<std::size_t>(editState >> 33);
+        };
+
+        const auto editText = [&]()
+        {
+            for(std::size_t edit = 0; edit < scenario.EditsPerFrame; ++edit)
+            {
+                std::string& text = strings[nextRandom() % strings.size()];
+
+                char& changedCharacter = text[nextRandom() % text.size()];
+
+                // Line breaks stay where they are
+                if(changedCharacter != '\n')
+                    changedCharacter = changedCharacter == 'x' ? 'y' : 'x';
+            };
+        };
+
+        const auto getScroll = [&](const std::uint32_t frame)
+        {
+            const float offset = std::fmod(static_cast<float>(frame) * scenario.ScrollPixelsPerFrame, static_cast<float>(benchmark.GetHeight()));
+
+            return glm::translate(glm::mat4(1.0f), { 0.0f, -offset, 0.0f });
+        };
+
+
+        // Only the draws' own uploads are counted, and every mode counts them the same way
+        std::size_t uploadedByteCount = 0;
+
+        BenchmarkResult result;
+
+        switch(mode)
+        {
+            case BenchmarkMode::PerCharacter:
+            {
+                FontSprite instance = FontSprite(font, 1, SSBOMode::SubData);
+
+                const std::size_t firstUploadedByteCount = instance.GetUploadedByteCount();
+
+                result = benchmark.Measure(font, scenario.FrameCount, charactersPerFrame, [&](const std::uint32_t frame)
+                {
+                    editText();
+
+                    const glm::mat4 scroll = getScroll(frame);
+
+                    instance.Bind();
+
+                    for(std::size_t index = 0; index < strings.size(); ++index)
+                    {
+                        const std::string& text = strings[index];
+
+                        for(const TextRun& run : runs)
+                        {
+                            glm::vec2 offset = origins[index] + run.Offset;
+
+                            for(std::size_t character = run.FirstCharacter; character < run.FirstCharacter + run.CharacterCount; ++character)
+                            {
+                                if(text[character] == '\n')
+                                {
+                                    offset = { origins[index].x, offset.y + font.GetLineHeight() };
+                                    continue;
+                                };
+
+                                instance.Transform = scroll * glm::translate(glm::mat4(1.0f), { offset, 0.0f });
+
+                                instance.Draw(std::string_view(text).substr(character, 1), run.Colour);
+
+                                offset.x += static_cast<float>(font.GetGlyphWidth());
+                            };
+                        };
+                    };
+
+                    instance.EndFrame();
+                });
+
+                uploadedByteCount = instance.GetUploadedByteCount() - firstUploadedByteCount;
+
+                break;
+            };
+
+            case BenchmarkMode::Bulk:
+            case BenchmarkMode::PersistentMapped:
+            {
+                FontSprite instance = FontSprite(font, static_cast<std::uint32_t>(charactersPerFrame),
+                                                 mode == BenchmarkMode::Bulk ? SSBOMode::SubData : SSBOMode::PersistentRing);
+
+                instance.Layout.WrapWidth = scenario.WrapWidth;
+
+                if(spans.empty() == false)
+                    instance.SetShaderProgram(*_styledProgram);
+
+                const std::size_t firstUploadedByteCount = instance.GetUploadedByteCount();
+
+                result = benchmark.Measure(instance, scenario.FrameCount, charactersPerFrame, [&](const std::uint32_t frame)
+                {
+                    editText();
+
+                    const glm::mat4 scroll = getScroll(frame);
+
+                    instance.Bind();
+
+                    for(std::size_t index = 0; index < strings.size(); ++index)
+                    {
+                        instance.Transform = scroll * glm::translate(glm::mat4(1.0f), { origins[index], 0.0f });
+
+                        if(spans.empty() == true)
+                            instance.Draw(strings[index]);
+                        else
+                            instance.DrawStyled(strings[index], spans);
+                    };
+                });
+
+                uploadedByteCount = instance.GetUploadedByteCount() - firstUploadedByteCount;
+
+                break;
+            };
+
+            case BenchmarkMode::Batched:
+            {
+                TextBatch batch = TextBatch(font, *_batchProgram, charactersPerFrame);
+
+                result = benchmark.Measure(font, scenario.FrameCount, charactersPerFrame, [&](const std::uint32_t frame)
+                {
+                    editText();
+
+                    batch.Begin();
+
+                    for(std::size_t index = 0; index < strings.size(); ++index)
+                    {
+                        const std::string_view text = strings[index];
+
+                        for(const TextRun& run : runs)
+                        {
+                            batch.Submit(text.substr(run.FirstCharacter, run.CharacterCount), origins[index] + run.Offset, run.Colour);
+                        };
+                    };
+
+                    // The batch writes its whole input every flush
+                    uploadedByteCount += sizeof(TextBatchHeader) + (batch.GetGlyphCount() * sizeof(GlyphInstance));
+
+                    batch.Transform = getScroll(frame);
+                    batch.Flush();
+
+                    batch.EndFrame();
+
+                    // The font's program is bound again for its next draw
+                    font.Bind();
+                });
+
+                break;
+            };
+
+            case BenchmarkMode::RetainedLayout:
+            {
+                std::vector<FontSprite> instances;
+                instances.reserve(strings.size());
+
+                for(const std::string& text : strings)
+                {
+                    FontSprite& instance = instances.emplace_back(font, static_cast<std::uint32_t>(text.size()), SSBOMode::SubData);
+
+                    instance.Layout.WrapWidth = scenario.WrapWidth;
+                };
+
+                const auto countUploadedBytes = [&]()
+                {
+                    std::size_t byteCount = 0;
+
+                    for(const FontSprite& instance : instances)
+                    {
+                        byteCount += instance.GetUploadedByteCount();
+                    };
+
+                    return byteCount;
+                };
+
+                const std::size_t firstUploadedByteCount = countUploadedBytes();
+
+                result = benchmark.Measure(font, scenario.FrameCount, charactersPerFrame, [&](const std::uint32_t frame)
+                {
+                    editText();
+
+                    const glm::mat4 scroll = getScroll(frame);
+
+                    for(std::size_t index = 0; index < strings.size(); ++index)
+                    {
+                        FontSprite& instance = instances[index];
+
+                        instance.Bind();
+
+                        instance.Transform = scroll * glm::translate(glm::mat4(1.0f), { origins[index], 0.0f });
+
+                        instance.DrawRetained(strings[index]);
+                    };
+                });
+
+                uploadedByteCount = countUploadedBytes() - firstUploadedByteCount;
+
+                break;
+            };
+
+            default:
+                break;
+        };
+
+
+        result.Name = scenario.Name;
+        result.CharactersPerString = scenario.CharactersPerString;
+        result.StringCount = scenario.StringCount;
+        result.ChangingText = scenario.EditsPerFrame > 0;
+        result.BytesUploadedPerFrame = static_cast<double>(uploadedByteCount) / static_cast<double>(std::max(scenario.FrameCount, 1u));
+
+        return BenchmarkScenarioResult
+        {
+            .Result = result,
+            .Mode = mode,
+        };
+    };
+
+    /// <summary>
+    /// Measure every scene in each of its modes. Combinations that can't be measured are reported and skipped
+    /// </summary>
+    std::vector<BenchmarkScenarioResult> Run(const std::vector<BenchmarkScenario>& scenarios) const
+    {
+        std::vector<BenchmarkScenarioResult> results;
+
+        for(const BenchmarkScenario& scenario : scenarios)
+        {
+            for(const BenchmarkMode mode : scenario.Modes)
+            {
+                if(const std::string reason = GetUnsupportedReason(scenario, mode); reason.empty() == false)
+                {
+                    std::cerr << "Skipped \"" << scenario.Name << "\" " << GetBenchmarkModeName(mode) << ", " << reason << "\n";
+                    continue;
+                };
+
+                results.emplace_back(Run(scenario, mode));
+            };
+        };
+
+        return results;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Printable text, with a line break after every LineLength characters
+    /// </summary>
+    static std::vector<std::string> CreateStrings(const BenchmarkScenario& scenario)
+    {
+        std::string text(scenario.CharactersPerString, ' ');
+
+        for(std::size_t index = 0; index < text.size(); ++index)
+        {
+            const bool lineBreak = scenario.LineLength > 0 && (index % (scenario.LineLength + 1)) == scenario.LineLength;
+
+            text[index] = lineBreak == true ? '\n' : static_cast<char>('!' + (index % 94));
+        };
+
+        return std::vector<std::string>(scenario.StringCount, text);
+    };
+
+    /// <summary>
+    /// Evenly spaced spans in a few alternating colours, the same for every string
+    /// </summary>
+    static std::vector<TextSpan> CreateSpans(const BenchmarkScenario& scenario)
+    {
+        static constexpr std::array<glm::vec4, 4> colours =
+        {
+            glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+            glm::vec4(0.6f, 0.1f, 0.1f, 1.0f),
+            glm::vec4(0.1f, 0.4f, 0.1f, 1.0f),
+            glm::vec4(0.1f, 0.2f, 0.7f, 1.0f),
+        };
+
+        const std::size_t spanCount = std::min(scenario.SpansPerString, scenario.CharactersPerString);
+
+        std::vector<TextSpan> spans;
+        spans.reserve(spanCount);
+
+        for(std::size_t index = 0; index < spanCount; ++index)
+        {
+            spans.push_back(MakeTextSpan(static_cast<std::uint32_t>(index * scenario.CharactersPerString / spanCount), colours[index % colours.size()]));
+        };
+
+        return spans;
+    };
+
+    /// <summary>
+    /// Strings are spread over the framebuffer in a grid like TextBenchmark's workloads, so most of them are visible
+    /// </summary>
+    std::vector<glm::vec2> GetStringOrigins(const BenchmarkScenario& scenario, const FontSprite& font) const
+    {
+        const std::size_t columns = std::max<std::size_t>(static_cast<std::size_t>(std::sqrt(static_cast<double>(scenario.StringCount))), 1);
+
+        const float columnWidth = static_cast<float>(_benchmark.get().GetWidth()) / static_cast<float>(columns);
+
+        std::vector<glm::vec2> origins(scenario.StringCount);
+
+        for(std::size_t index = 0; index < origins.size(); ++index)
+        {
+            origins[index] = { static_cast<float>(index % columns) * columnWidth, static_cast<float>(index / columns) * font.GetLineHeight() };
+        };
+
+        return origins;
+    };
+
+    /// <summary>
+    /// Break a string into runs at its spans and, if asked to, at its line breaks, which are left out of the runs.
+    /// A TextBatch lays every run out on a single line, so it's given a run per line at the line's offset
+    /// </summary>
+    static std::vector<TextRun> FindRuns(const std::string_view& text, const std::vector<TextSpan>& spans, const bool breakLines, const FontSprite& font)
+    {
+        std::vector<TextRun> runs;
+
+        const float glyphWidth = static_cast<float>(font.GetGlyphWidth());
+
+        glm::vec2 offset = { 0.0f, 0.0f };
+
+        std::size_t nextSpan = 0;
+
+        glm::vec4 colour = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+        TextRun run = { .Colour = colour };
+
+        for(std::size_t index = 0; index < text.size(); ++index)
+        {
+            const bool spanStarts = nextSpan < spans.size() && spans[nextSpan].FirstCharacter == index;
+            const bool lineBreak = breakLines == true && text[index] == '\n';
+
+            if(spanStarts == true)
+                colour = glm::unpackUnorm4x8(spans[nextSpan++].Colour);
+
+            if((spanStarts == true || lineBreak == true) && run.CharacterCount > 0)
+                runs.push_back(run);
+
+            if(spanStarts == true || lineBreak == true || run.CharacterCount == 0)
+                run = { .FirstCharacter = index + (lineBreak == true ? 1 : 0), .CharacterCount = 0, .Offset = offset, .Colour = colour };
+
+            if(text[index] == '\n')
+            {
+                offset = { 0.0f, offset.y + font.GetLineHeight() };
+
+                if(lineBreak == true)
+                {
+                    run.Offset = offset;
+                    continue;
+                };
+            }
+            else
+                offset.x += glyphWidth;
+
+            ++run.CharacterCount;
+        };
+
+        if(run.CharacterCount > 0)
+            runs.push_back(run);
+
+        return runs;
+    };
+
+};
+
+
+/// <summary>
+/// Write results as a JSON array, one object per scene and mode, which LoadBenchmarkScenarioResultsJSON reads back as a baseline
+/// </summary>
+inline void WriteBenchmarkScenarioResultsJSON(std::ostream& stream, const std::vector<BenchmarkScenarioResult>& results)
+{
+    stream << "[\n";
+
+    for(std::size_t index = 0; index < results.size(); ++index)
+    {
+        const BenchmarkResult& result = results[index].Result;
+
+        // Every object is a line of its own, LoadBenchmarkScenarioResultsJSON relies on it. Scene names are ours, nothing in them needs escaping
+        char line[640] = { };
+
+        std::snprintf(line, sizeof(line),
+                      "  { \"scenario\": \"%s\", \"mode\": \"%s\", \"charactersPerString\": %zu, \"stringCount\": %zu, \"changingText\": %s, \"frames\": %u, "
+                      "\"cpuMsPerFrame\": %.4f, \"gpuMsPerFrame\": %.4f, \"glyphsPerSecond\": %.0f, \"bytesUploadedPerFrame\": %.0f, \"outputChecksum\": \"%016llx\" }%s\n",
+                      result.Name.c_str(),
+                      GetBenchmarkModeName(results[index].Mode).data(),
+                      result.CharactersPerString,
+                      result.StringCount,
+                      result.ChangingText == true ? "true" : "false",
+                      result.FrameCount,
+                      result.CPUMillisecondsPerFrame,
+                      result.GPUMillisecondsPerFrame,
+                      result.GlyphsPerSecond,
+                      result.BytesUploadedPerFrame,
+                      static_cast<unsigned long long>(result.OutputChecksum),
+                      index + 1 < results.size() ? "," : "");
+
+        stream << line;
+    };
+
+    stream << "]\n";
+};
+
+
+/// <summary>
+/// Read results written by WriteBenchmarkScenarioResultsJSON, e.g. a baseline saved from an earlier run. Anything else in the file is skipped
+/// </summary>
+/// <returns> Empty if the file can't be read </returns>
+inline std::vector<BenchmarkScenarioResult> LoadBenchmarkScenarioResultsJSON(const std::filesystem::path& path)
+{
+    using namespace BenchmarkScenarioParsing;
+
+    std::ifstream file = std::ifstream(path);
+
+    if(file.is_open() == false)
+    {
+        std::cerr << "Unable to read benchmark results from \"" << path.string() << "\"\n";
+        return { };
+    };
+
+    std::vector<BenchmarkScenarioResult> results;
+
+    std::string line;
+
+    while(std::getline(file, line))
+    {
+        const std::optional<BenchmarkMode> mode = FindBenchmarkMode(FindJSONValue(line, "mode"));
+
+        if(line.find("\"scenario\": ") == std::string::npos || mode.has_value() == false)
+            continue;
+
+        const auto findNumber = [&](const std::string_view& key)
+        {
+            double value = 0.0;
+
+            ParseValue(FindJSONValue(line, key), value);
+
+            return value;
+        };
+
+        BenchmarkScenarioResult& result = results.emplace_back(BenchmarkScenarioResult
+        {
+            .Result =
+            {
+                .Name = std::string(FindJSONValue(line, "scenario")),
+                .CharactersPerString = static_cast<std::size_t>(findNumber("charactersPerString")),
+                .StringCount = static_cast<std::size_t>(findNumber("stringCount")),
+                .ChangingText = FindJSONValue(line, "changingText") == "true",
+                .FrameCount = static_cast<std::uint32_t>(findNumber("frames")),
+                .CPUMillisecondsPerFrame = findNumber("cpuMsPerFrame"),
+                .GPUMillisecondsPerFrame = findNumber("gpuMsPerFrame"),
+                .GlyphsPerSecond = findNumber("glyphsPerSecond"),
+                .BytesUploadedPerFrame = findNumber("bytesUploadedPerFrame"),
+            },
+            .Mode = *mode,
+        });
+
+        const std::string_view checksum = FindJSONValue(line, "outputChecksum");
+
+        std::from_chars(checksum.data(), checksum.data() + checksum.size(), result.Result.OutputChecksum, 16);
+    };
+
+    return results;
+};
+
+
+/// <summary>
+/// Print a table of every result, with each metric's change from the baseline's result of the same scene and mode.
+/// Changes for the worse beyond the threshold are marked with a '!', and counted in the last line
+/// </summary>
+/// <param name="stream"> Where the table is printed </param>
+/// <param name="results"> The current run's results </param>
+/// <param name="baseline"> The results compared against, may be empty </param>
+/// <param name="regressionThreshold"> The relative change that counts as a regression, 0.05 for 5% </param>
+/// <returns> The number of regressions </returns>
+inline std::size_t WriteBenchmarkComparisonTable(std::ostream& stream,
+                                                 const std::vector<BenchmarkScenarioResult>& results,
+                                                 const std::vector<BenchmarkScenarioResult>& baseline,
+                                                 const double regressionThreshold = 0.05)
+{
+    std::size_t regressionCount = 0;
+
+    // A metric's value and its change, e.g. "0.412 (+3.2%!)"
+    const auto formatMetric = [&](const double value, const std::optional<double> baselineValue, const bool higherIsBetter, const char* format)
+    {
+        char cell[64] = { };
+
+        const int length = std::snprintf(cell, sizeof(cell), format, value);
+
+        if(baselineValue.has_value() == false || *baselineValue == 0.0)
+            return std::string(cell);
+
+        const double change = (value - *baselineValue) / *baselineValue;
+
+        const bool regressed = (higherIsBetter == true ? -change : change) > regressionThreshold;
+
+        if(regressed == true)
+            ++regressionCount;
+
+        std::snprintf(cell + length, sizeof(cell) - static_cast<std::size_t>(length), " (%+.1f%%%s)", change * 100.0, regressed == true ? "!" : "");
+
+        return std::string(cell);
+    };
+
+    char line[256] = { };
+
+    std::snprintf(line, sizeof(line), "%-32s %-18s %-22s %-22s %-26s %-24s %s\n",
+                  "Scenario", "Mode", "CPU ms/frame", "GPU ms/frame", "Glyphs/s", "Bytes/frame", "Output");
+
+    stream << line;
+
+    for(const BenchmarkScenarioResult& scenarioResult : results)
+    {
+        const BenchmarkResult& result = scenarioResult.Result;
+
+        const auto baselineResult = std::find_if(baseline.cbegin(), baseline.cend(), [&](const BenchmarkScenarioResult& candidate)
+        {
+            return candidate.Result.Name == result.Name && candidate.Mode == scenarioResult.Mode;
+        });
+
+        const bool hasBaseline = baselineResult != baseline.cend();
+
+        const auto getBaseline = [&](const double BenchmarkResult::* metric) -> std::optional<double>
+        {
+            if(hasBaseline == false)
+                return std::nullopt;
+
+            return baselineResult->Result.*metric;
+        };
+
+        // The checksum changes whenever the scene is drawn differently, e.g. by a shader change, and then the timings aren't comparable either
+        const char* output = hasBaseline == false ? "new" :
+                             baselineResult->Result.OutputChecksum == result.OutputChecksum ? "same" : "changed";
+
+        std::snprintf(line, sizeof(line), "%-32.32s %-18s %-22s %-22s %-26s %-24s %s\n",
+                      result.Name.c_str(),
+                      GetBenchmarkModeName(scenarioResult.Mode).data(),
+                      formatMetric(result.CPUMillisecondsPerFrame, getBaseline(&BenchmarkResult::CPUMillisecondsPerFrame), false, "%.3f").c_str(),
+                      formatMetric(result.GPUMillisecondsPerFrame, getBaseline(&BenchmarkResult::GPUMillisecondsPerFrame), false, "%.3f").c_str(),
+                      formatMetric(result.GlyphsPerSecond, getBaseline(&BenchmarkResult::GlyphsPerSecond), true, "%.0f").c_str(),
+                      formatMetric(result.BytesUploadedPerFrame, getBaseline(&BenchmarkResult::BytesUploadedPerFrame), false, "%.0f").c_str(),
+                      output);
+
+        stream << line;
+    };
+
+    if(baseline.empty() == false)
+        stream << regressionCount << " regression" << (regressionCount == 1 ? "" : "s") << " over " << (regressionThreshold * 100.0) << "%\n";
+
+    return regressionCount;
+};
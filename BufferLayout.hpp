@@ -0,0 +1,301 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "DynamicSSBO.hpp"
+#include "StaticSSBOLayout.hpp"
+#include "SSBOReflection.hpp"
+#include "ShaderProgram.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A single value or array of a BufferLayout
+/// </summary>
+struct BufferLayoutField
+{
+    /// <summary>
+    /// The field's path, as in "TextColour", "Characters" or "Glyphs[0].Position".
+    /// Arrays of structs at the top of the block appear once, as their first element's members
+    /// </summary>
+    std::string Name;
+
+    std::size_t Offset = 0;
+
+    /// <summary>
+    /// The number of elements, 1 for single values and 0 for unsized arrays.
+    /// Members of a top-level array of structs take the struct array's count and stride
+    /// </summary>
+    std::size_t Count = 1;
+
+    /// <summary>
+    /// The distance between consecutive elements, 0 for single values
+    /// </summary>
+    std::size_t Stride = 0;
+
+    /// <summary>
+    /// The field's type, or its elements'. None for fields reflected from a program
+    /// </summary>
+    DataType Type = DataType::None;
+};
+
+
+/// <summary>
+/// A flat description of a buffer's layout, the common ground of the layout systems.
+/// Built from a compile-time StaticSSBOLayout, a runtime SSBOLayout, or the driver's reflection of a program's block,
+/// so the hand-computed std430 offsets can be checked against the driver, see ValidateBufferLayout
+/// </summary>
+class BufferLayout
+{
+
+private:
+
+    std::vector<BufferLayoutField> _fields;
+
+
+public:
+
+    BufferLayout() = default;
+
+    BufferLayout(std::vector<BufferLayoutField> fields) :
+        _fields(std::move(fields))
+    {
+    };
+
+
+public:
+
+    template<typename TStaticLayout>
+    static BufferLayout FromStaticLayout()
+    {
+        BufferLayout layout;
+
+        layout._fields.reserve(TStaticLayout::FieldCount);
+
+        for(std::size_t index = 0; index < TStaticLayout::FieldCount; ++index)
+        {
+            const std::size_t count = TStaticLayout::_fieldCounts[index];
+
+            layout._fields.push_back(BufferLayoutField
+            {
+                .Name = std::string(TStaticLayout::_fieldNames[index]),
+                .Offset = TStaticLayout::_fieldOffsets[index],
+                .Count = count,
+                .Stride = count == 1 ? 0 : TStaticLayout::GetStrideAt(index),
+                .Type = TStaticLayout::_fieldTypes[index],
+            });
+        };
+
+        return layout;
+    };
+
+    static BufferLayout FromSSBOLayout(const SSBOLayout& ssboLayout)
+    {
+        BufferLayout layout;
+
+        layout.AddNodes(ssboLayout._arena, LayoutArena::RootNodeIndex, "", true, nullptr);
+
+        return layout;
+    };
+
+    static BufferLayout FromReflection(const ReflectedSSBOLayout& reflectedLayout)
+    {
+        BufferLayout layout;
+
+        layout._fields.reserve(reflectedLayout.Variables.size());
+
+        for(const ReflectedSSBOVariable& variable : reflectedLayout.Variables)
+        {
+            // Top-level arrays of basic types report the same stride twice, only struct array members differ
+            const bool inStructArray = variable.TopLevelArrayStride != 0 && variable.ArrayStride != variable.TopLevelArrayStride;
+
+            // Only array names end in "[0]", the suffix is dropped to match the hand-built layouts
+            const bool isArray = variable.Name.ends_with("[0]") == true;
+
+            layout._fields.push_back(BufferLayoutField
+            {
+                .Name = isArray == true ? variable.Name.substr(0, variable.Name.size() - 3) : variable.Name,
+                .Offset = variable.Offset,
+                .Count = inStructArray == true ? variable.TopLevelArraySize : variable.ArraySize,
+                .Stride = inStructArray == true ? variable.TopLevelArrayStride : variable.ArrayStride,
+            });
+        };
+
+        return layout;
+    };
+
+
+public:
+
+    const std::vector<BufferLayoutField>& GetFields() const
+    {
+        return _fields;
+    };
+
+    const BufferLayoutField* Find(const std::string_view& name) const
+    {
+        for(const BufferLayoutField& field : _fields)
+        {
+            if(field.Name == name)
+                return &field;
+        };
+
+        return nullptr;
+    };
+
+
+    /// <summary>
+    /// Compare every field of this layout against another, usually the driver's
+    /// </summary>
+    /// <param name="other"> The layout that's trusted </param>
+    /// <returns> A line per mismatched field, empty if the layouts agree </returns>
+    std::vector<std::string> Compare(const BufferLayout& other) const
+    {
+        std::vector<std::string> mismatches;
+
+        for(const BufferLayoutField& field : _fields)
+        {
+            const BufferLayoutField* otherField = other.Find(field.Name);
+
+            if(otherField == nullptr)
+            {
+                mismatches.push_back(std::string("\"").append(field.Name).append("\" is missing"));
+                continue;
+            };
+
+            if(field.Offset != otherField->Offset)
+                mismatches.push_back(std::string("\"").append(field.Name).append("\" is at offset ").append(std::to_string(field.Offset)).append(", expected ").append(std::to_string(otherField->Offset)));
+
+            if(field.Count != otherField->Count)
+                mismatches.push_back(std::string("\"").append(field.Name).append("\" has ").append(std::to_string(field.Count)).append(" elements, expected ").append(std::to_string(otherField->Count)));
+
+            if(field.Count != 1 && field.Stride != otherField->Stride)
+                mismatches.push_back(std::string("\"").append(field.Name).append("\" has a stride of ").append(std::to_string(field.Stride)).append(", expected ").append(std::to_string(otherField->Stride)));
+        };
+
+        for(const BufferLayoutField& otherField : other._fields)
+        {
+            if(Find(otherField.Name) == nullptr)
+                mismatches.push_back(std::string("\"").append(otherField.Name).append("\" isn't part of the layout"));
+        };
+
+        return mismatches;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Flatten a node's children
+    /// </summary>
+    /// <param name="prefix"> The path of the node, ending in '.' for struct members </param>
+    /// <param name="topLevel"> Whether the children are members of the block itself, only top-level struct arrays are collapsed </param>
+    /// <param name="structArray"> The top-level struct array the children are members of, which gives them its count and stride </param>
+    /// <param name="elementOffset"> (Elements of nested struct arrays) How far the element is from the array's first, whose nodes it shares </param>
+    void AddNodes(const LayoutArena& arena, const std::uint32_t parentIndex, const std::string& prefix, const bool topLevel, const BufferLayoutField* structArray, const std::size_t elementOffset = 0)
+    {
+        for(std::uint32_t index = arena[parentIndex].FirstChild; index != InvalidNodeIndex; index = arena[index].NextSibling)
+        {
+            const LayoutNode& node = arena[index];
+
+            const std::string name = std::string(prefix).append(arena.GetName(index));
+
+            if(node.Type == DataType::Struct)
+            {
+                AddNodes(arena, index, std::string(name).append("."), false, structArray, elementOffset);
+                continue;
+            };
+
+            if(node.Type == DataType::Array && node.ArrayElementType == DataType::Struct)
+            {
+                if(node.FirstChild == InvalidNodeIndex)
+                    continue;
+
+                if(topLevel == true)
+                {
+                    const BufferLayoutField arrayField = BufferLayoutField
+                    {
+                        .Count = node.Unsized == true ? 0 : node.ArrayElementCount,
+                        .Stride = node.ArrayElementStride,
+                    };
+
+                    AddNodes(arena, node.FirstChild, std::string(name).append("[0]."), false, &arrayField, elementOffset);
+                    continue;
+                };
+
+                // Nested struct arrays are listed element by element, as the driver does. Only the first element has nodes, the others are it moved by their stride
+                for(std::size_t elementIndex = 0; elementIndex < node.ArrayElementCount; ++elementIndex)
+                {
+                    AddNodes(arena, node.FirstChild, std::string(name).append("[").append(std::to_string(elementIndex)).append("]."), false, structArray,
+                             elementOffset + (elementIndex * node.ArrayElementStride));
+                };
+
+                continue;
+            };
+
+
+            BufferLayoutField field = BufferLayoutField
+            {
+                .Name = name,
+                .Offset = node.Offset + elementOffset,
+                .Type = node.Type,
+            };
+
+            if(node.Type == DataType::Array)
+            {
+                field.Count = node.Unsized == true ? 0 : node.ArrayElementCount;
+                field.Stride = node.ArrayElementStride;
+                field.Type = node.ArrayElementType;
+            };
+
+            if(structArray != nullptr)
+            {
+                field.Count = structArray->Count;
+                field.Stride = structArray->Stride;
+            };
+
+            _fields.push_back(std::move(field));
+        };
+    };
+
+};
+
+
+/// <summary>
+/// Check a hand-built layout against the driver's layout of a program's block, and report every mismatch.
+/// Reflection waits for the program to link, so this is meant for debug startup checks
+/// </summary>
+/// <param name="layout"> The layout the CPU writes with </param>
+/// <param name="shaderProgram"> A program that declares the block </param>
+/// <param name="blockName"> The block's name </param>
+/// <returns> True if the layouts agree </returns>
+inline bool ValidateBufferLayout(const BufferLayout& layout, const ShaderProgram& shaderProgram, const std::string& blockName)
+{
+    const ReflectedSSBOLayout* reflectedLayout = shaderProgram.GetStorageBlockLayout(blockName);
+
+    if(reflectedLayout == nullptr)
+    {
+        std::cerr << "Layout check: program has no block \"" << blockName << "\"\n";
+        return false;
+    };
+
+    const std::vector<std::string> mismatches = layout.Compare(BufferLayout::FromReflection(*reflectedLayout));
+
+    for(const std::string& mismatch : mismatches)
+    {
+        std::cerr << "Layout check \"" << blockName << "\": " << mismatch << "\n";
+    };
+
+    wt::Assert(mismatches.empty() == true, [&]()
+    {
+        return std::string("Buffer layout doesn't match block \"").append(blockName).append("\", see the console");
+    });
+
+    return mismatches.empty() == true;
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GLStateCache.hpp"
+#include "GPUMemory.hpp"
+#include "BufferUsage.hpp"
+
+
+/// <summary>
+/// Recycles mutable GL buffers, so objects that are created and destroyed constantly, e.g. text widgets, don't create and delete buffers every time.
+/// Sizes are rounded up to powers of two so released buffers fit later requests.
+/// A released buffer is only handed out again once the commands issued before its release are done with it, its contents are left as they were
+/// </summary>
+class BufferPool
+{
+
+private:
+
+    struct PooledBuffer
+    {
+        std::uint32_t BufferID = 0;
+
+        std::size_t SizeInBytes = 0;
+
+        /// <summary>
+        /// Placed when the buffer was released
+        /// </summary>
+        GLsync Fence = nullptr;
+    };
+
+    std::vector<PooledBuffer> _freeBuffers;
+
+    /// <summary>
+    /// Buffers released beyond this are deleted instead of kept
+    /// </summary>
+    std::size_t _maxFreeBuffers = 0;
+
+    BufferUsage _usage = BufferUsage::RarelyUpdated;
+
+    std::size_t _createdCount = 0;
+    std::size_t _reusedCount = 0;
+
+
+public:
+
+    /// <param name="maxFreeBuffers"> The most released buffers kept for reuse </param>
+    /// <param name="usage"> How the buffers are written, which picks the storage new ones are created with </param>
+    BufferPool(const std::size_t maxFreeBuffers = 32, const BufferUsage usage = BufferUsage::RarelyUpdated) :
+        _maxFreeBuffers(maxFreeBuffers),
+        _usage(usage)
+    {
+    };
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator = (const BufferPool&) = delete;
+
+    ~BufferPool()
+    {
+        Clear();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Get a buffer of at least a size, a released one if one is free, otherwise a new one
+    /// </summary>
+    /// <returns> The buffer, which belongs to the caller until it's released </returns>
+    std::uint32_t Acquire(const std::size_t sizeInBytes)
+    {
+        const std::size_t pooledSizeInBytes = GetPooledSize(sizeInBytes);
+
+        for(auto freeBuffer = _freeBuffers.begin(); freeBuffer != _freeBuffers.end(); ++freeBuffer)
+        {
+            if(freeBuffer->SizeInBytes != pooledSizeInBytes || glClientWaitSync(freeBuffer->Fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+                continue;
+
+            const std::uint32_t bufferID = freeBuffer->BufferID;
+
+            glDeleteSync(freeBuffer->Fence);
+
+            _freeBuffers.erase(freeBuffer);
+
+            ++_reusedCount;
+
+            return bufferID;
+        };
+
+
+        std::uint32_t bufferID = 0;
+        glCreateBuffers(1, &bufferID);
+
+        CreateBufferStorage(bufferID, pooledSizeInBytes, _usage);
+
+        GPUMemory.TrackBuffer(bufferID, pooledSizeInBytes, GPUMemoryCategory::TextBuffer);
+
+        ++_createdCount;
+
+        return bufferID;
+    };
+
+    /// <summary>
+    /// Give a buffer back to the pool, commands already issued may still use it
+    /// </summary>
+    /// <param name="bufferID"> A buffer from Acquire, 0 is ignored </param>
+    /// <param name="sizeInBytes"> The size it was acquired with </param>
+    void Release(const std::uint32_t bufferID, const std::size_t sizeInBytes)
+    {
+        if(bufferID == 0)
+            return;
+
+        // The driver keeps the buffer alive until the commands using it are done
+        if(_freeBuffers.size() >= _maxFreeBuffers)
+        {
+            GLState.DeleteBuffer(bufferID);
+            return;
+        };
+
+        _freeBuffers.push_back(PooledBuffer
+        {
+            .BufferID = bufferID,
+            .SizeInBytes = GetPooledSize(sizeInBytes),
+            .Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+        });
+    };
+
+    /// <summary>
+    /// Delete every free buffer
+    /// </summary>
+    void Clear()
+    {
+        for(const PooledBuffer& freeBuffer : _freeBuffers)
+        {
+            glDeleteSync(freeBuffer.Fence);
+            GLState.DeleteBuffer(freeBuffer.BufferID);
+        };
+
+        _freeBuffers.clear();
+    };
+
+
+public:
+
+    /// <summary>
+    /// The size a buffer acquired for a size actually has
+    /// </summary>
+    static std::size_t GetPooledSize(const std::size_t sizeInBytes)
+    {
+        return std::bit_ceil(std::max<std::size_t>(sizeInBytes, 256));
+    };
+
+    std::size_t GetFreeCount() const
+    {
+        return _freeBuffers.size();
+    };
+
+    /// <summary>
+    /// The number of buffers Acquire had to create
+    /// </summary>
+    std::size_t GetCreatedCount() const
+    {
+        return _createdCount;
+    };
+
+    /// <summary>
+    /// The number of buffers Acquire handed out again
+    /// </summary>
+    std::size_t GetReusedCount() const
+    {
+        return _reusedCount;
+    };
+
+};
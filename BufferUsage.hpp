@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+
+
+/// <summary>
+/// How a buffer's contents are written, which decides how its storage is created and updated, see CreateBufferStorage.
+/// Buffers that are rewritten every frame through a pointer are better off as persistently mapped rings, see SSBOMode::PersistentRing
+/// </summary>
+enum class BufferUsage
+{
+    /// <summary>
+    /// Written once, or almost never, and read by the GPU every frame. Immutable storage, which the driver can keep in video memory
+    /// </summary>
+    Static,
+
+    /// <summary>
+    /// Updated in parts now and then, e.g. text that changes as it's edited with a header that doesn't. Mutable storage updated in place
+    /// </summary>
+    RarelyUpdated,
+
+    /// <summary>
+    /// Rewritten in full every frame. Mutable storage that's orphaned before every full rewrite, so the write never waits for draws still reading the old contents
+    /// </summary>
+    Streaming,
+};
+
+
+/// <summary>
+/// The usage hint mutable storage is created with
+/// </summary>
+constexpr GLenum GetBufferUsageHint(const BufferUsage usage)
+{
+    switch(usage)
+    {
+        case BufferUsage::Streaming:
+            return GL_STREAM_DRAW;
+
+        case BufferUsage::Static:
+            return GL_STATIC_DRAW;
+
+        default:
+            return GL_DYNAMIC_DRAW;
+    };
+};
+
+
+/// <summary>
+/// Create a buffer's storage the way its usage is best served. Every kind can still be written with glNamedBufferSubData
+/// </summary>
+inline void CreateBufferStorage(const std::uint32_t bufferID, const std::size_t sizeInBytes, const BufferUsage usage)
+{
+    if(usage == BufferUsage::Static)
+        glNamedBufferStorage(bufferID, static_cast<GLsizeiptr>(sizeInBytes), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    else
+        glNamedBufferData(bufferID, static_cast<GLsizeiptr>(sizeInBytes), nullptr, GetBufferUsageHint(usage));
+};
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "GLStateCache.hpp"
+
+
+/// <summary>
+/// The shader storage binding a CodepointGlyphTable is bound to
+/// </summary>
+constexpr std::uint32_t CodepointGlyphTableBindingIndex = 8;
+
+
+/// <summary>
+/// Maps codepoints to glyph indices in constant time, with a two-level page table.
+/// The low 8 bits of a codepoint select an entry within a page, the rest select the page from a directory that covers all of Unicode.
+/// Only pages with at least one glyph are allocated, every other directory entry points at page 0, which holds nothing but the default value.
+/// The same table is uploaded as a single buffer, the directory followed by the pages, so the shaders look glyphs up the same way
+/// </summary>
+class CodepointGlyphTable
+{
+
+public:
+
+    static constexpr std::uint32_t PageBits = 8;
+
+    static constexpr std::uint32_t PageSize = 1 << PageBits;
+
+    /// <summary>
+    /// The number of directory entries, enough pages for every codepoint up to U+10FFFF
+    /// </summary>
+    static constexpr std::uint32_t DirectorySize = 0x110000 >> PageBits;
+
+
+private:
+
+    /// <summary>
+    /// A page index per directory entry, 0 for pages without any glyphs
+    /// </summary>
+    std::vector<std::uint32_t> _directory;
+
+    /// <summary>
+    /// Every page's entries, back to back. Page 0 is the shared default page
+    /// </summary>
+    std::vector<std::uint32_t> _pages;
+
+    std::uint32_t _defaultValue = 0;
+
+
+    std::uint32_t _bufferID = 0;
+
+    /// <summary>
+    /// The number of uints the buffer was created with
+    /// </summary>
+    std::size_t _bufferCapacity = 0;
+
+    /// <summary>
+    /// The range of uints changed since the last upload, indexed as in the buffer: the directory, then the pages
+    /// </summary>
+    std::size_t _dirtyBegin = std::numeric_limits<std::size_t>::max();
+    std::size_t _dirtyEnd = 0;
+
+
+public:
+
+    /// <param name="defaultValue"> What codepoints without a glyph map to, usually the fallback glyph's index </param>
+    CodepointGlyphTable(const std::uint32_t defaultValue = 0) :
+        _directory(DirectorySize, 0),
+        _pages(PageSize, defaultValue),
+        _defaultValue(defaultValue),
+        _dirtyBegin(0),
+        _dirtyEnd(DirectorySize + PageSize)
+    {
+    };
+
+    CodepointGlyphTable(const CodepointGlyphTable&) = delete;
+    CodepointGlyphTable& operator = (const CodepointGlyphTable&) = delete;
+
+    ~CodepointGlyphTable()
+    {
+        GLState.DeleteBuffer(_bufferID);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Map a codepoint to a glyph, allocating its page if this is the page's first glyph
+    /// </summary>
+    void Set(const char32_t codepoint, const std::uint32_t value)
+    {
+        if(codepoint >= DirectorySize * PageSize)
+            return;
+
+        const std::uint32_t directoryIndex = static_cast<std::uint32_t>(codepoint) >> PageBits;
+
+        if(_directory[directoryIndex] == 0)
+        {
+            _directory[directoryIndex] = static_cast<std::uint32_t>(_pages.size() / PageSize);
+
+            _pages.insert(_pages.end(), PageSize, _defaultValue);
+
+            MarkDirty(directoryIndex, directoryIndex + 1);
+        };
+
+        const std::size_t pageIndex = GetPageEntryIndex(codepoint);
+
+        _pages[pageIndex] = value;
+
+        MarkDirty(DirectorySize + pageIndex, DirectorySize + pageIndex + 1);
+    };
+
+    /// <summary>
+    /// Map a codepoint back to the default value. Its page stays allocated
+    /// </summary>
+    void Reset(const char32_t codepoint)
+    {
+        if(codepoint >= DirectorySize * PageSize || _directory[static_cast<std::uint32_t>(codepoint) >> PageBits] == 0)
+            return;
+
+        const std::size_t pageIndex = GetPageEntryIndex(codepoint);
+
+        _pages[pageIndex] = _defaultValue;
+
+        MarkDirty(DirectorySize + pageIndex, DirectorySize + pageIndex + 1);
+    };
+
+    /// <summary>
+    /// Remove every mapping and free every page
+    /// </summary>
+    void Clear()
+    {
+        Clear(_defaultValue);
+    };
+
+    /// <summary>
+    /// Remove every mapping, free every page, and change what codepoints without a glyph map to
+    /// </summary>
+    void Clear(const std::uint32_t defaultValue)
+    {
+        _defaultValue = defaultValue;
+
+        std::fill(_directory.begin(), _directory.end(), 0);
+
+        _pages.assign(PageSize, _defaultValue);
+
+        MarkDirty(0, DirectorySize + PageSize);
+    };
+
+    /// <summary>
+    /// Look up a codepoint. Doesn't modify the table, so it can be called from any number of threads at once
+    /// </summary>
+    /// <returns> The codepoint's glyph, or the default value </returns>
+    std::uint32_t Find(const char32_t codepoint) const
+    {
+        if(codepoint >= DirectorySize * PageSize)
+            return _defaultValue;
+
+        return _pages[GetPageEntryIndex(codepoint)];
+    };
+
+
+    /// <summary>
+    /// Upload the changed part of the table, the buffer is recreated when new pages no longer fit
+    /// </summary>
+    void Upload()
+    {
+        if(_dirtyBegin >= _dirtyEnd)
+            return;
+
+        const std::size_t size = DirectorySize + _pages.size();
+
+        if(size > _bufferCapacity)
+        {
+            GLState.DeleteBuffer(_bufferID);
+
+            // Room for a few more pages, so a page at a time doesn't mean a buffer at a time
+            _bufferCapacity = size + (PageSize * 8);
+
+            glCreateBuffers(1, &_bufferID);
+            glNamedBufferStorage(_bufferID, static_cast<GLsizeiptr>(_bufferCapacity * sizeof(std::uint32_t)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+            _dirtyBegin = 0;
+            _dirtyEnd = size;
+        };
+
+        // The directory and the pages are separate arrays, written in up to 2 pieces
+        if(_dirtyBegin < DirectorySize)
+        {
+            const std::size_t end = std::min<std::size_t>(_dirtyEnd, DirectorySize);
+
+            glNamedBufferSubData(_bufferID, static_cast<GLintptr>(_dirtyBegin * sizeof(std::uint32_t)), static_cast<GLsizeiptr>((end - _dirtyBegin) * sizeof(std::uint32_t)), _directory.data() + _dirtyBegin);
+        };
+
+        if(_dirtyEnd > DirectorySize)
+        {
+            const std::size_t begin = std::max<std::size_t>(_dirtyBegin, DirectorySize) - DirectorySize;
+            const std::size_t end = std::min(_dirtyEnd - DirectorySize, _pages.size());
+
+            glNamedBufferSubData(_bufferID, static_cast<GLintptr>((DirectorySize + begin) * sizeof(std::uint32_t)), static_cast<GLsizeiptr>((end - begin) * sizeof(std::uint32_t)), _pages.data() + begin);
+        };
+
+        _dirtyBegin = std::numeric_limits<std::size_t>::max();
+        _dirtyEnd = 0;
+    };
+
+    /// <summary>
+    /// Bind the uploaded table to CodepointGlyphTableBindingIndex
+    /// </summary>
+    void Bind() const
+    {
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, CodepointGlyphTableBindingIndex, _bufferID);
+    };
+
+
+public:
+
+    std::uint32_t GetDefaultValue() const
+    {
+        return _defaultValue;
+    };
+
+    /// <summary>
+    /// The number of allocated pages, not counting the default page
+    /// </summary>
+    std::size_t GetPageCount() const
+    {
+        return (_pages.size() / PageSize) - 1;
+    };
+
+    /// <summary>
+    /// The size of the table, which is also the size of the uploaded data
+    /// </summary>
+    std::size_t GetSizeInBytes() const
+    {
+        return (_directory.size() + _pages.size()) * sizeof(std::uint32_t);
+    };
+
+
+private:
+
+    std::size_t GetPageEntryIndex(const char32_t codepoint) const
+    {
+        const std::uint32_t page = _directory[static_cast<std::uint32_t>(codepoint) >> PageBits];
+
+        return (static_cast<std::size_t>(page) * PageSize) + (static_cast<std::uint32_t>(codepoint) & (PageSize - 1));
+    };
+
+    void MarkDirty(const std::size_t begin, const std::size_t end)
+    {
+        _dirtyBegin = std::min(_dirtyBegin, begin);
+        _dirtyEnd = std::max(_dirtyEnd, end);
+    };
+
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "WindowsUtilities.hpp"
+#include "MappedFile.hpp"
+#include "GLStateCache.hpp"
+#include "ShaderIncludes.hpp"
+
+
+/// <summary>
+/// A program made of a single compute shader
+/// </summary>
+class ComputeProgram
+{
+
+private:
+
+    std::uint32_t _programID = 0;
+
+
+public:
+
+    ComputeProgram(const std::string& computeShaderPath)
+    {
+        const MappedFile computeShaderFile = MappedFile(computeShaderPath);
+        const ResolvedShaderSource resolvedComputeShader = ShaderIncludes.Resolve(computeShaderPath, computeShaderFile.GetText());
+        const std::string_view computeShaderSource = resolvedComputeShader.GetText();
+
+        const std::uint32_t computeShaderID = glCreateShader(GL_COMPUTE_SHADER);
+
+        const char* computeShaderSourcePointer = computeShaderSource.data();
+        const int computeShaderSourceLength = static_cast<int>(computeShaderSource.length());
+
+        glShaderSource(computeShaderID, 1, &computeShaderSourcePointer, &computeShaderSourceLength);
+        glCompileShader(computeShaderID);
+
+        CheckCompileStatus(computeShaderID);
+
+
+        _programID = glCreateProgram();
+
+        glAttachShader(_programID, computeShaderID);
+        glLinkProgram(_programID);
+
+        CheckLinkStatus();
+
+        glDetachShader(_programID, computeShaderID);
+        glDeleteShader(computeShaderID);
+    };
+
+    ComputeProgram(const ComputeProgram&) = delete;
+    ComputeProgram& operator = (const ComputeProgram&) = delete;
+
+    ~ComputeProgram()
+    {
+        GLState.DeleteProgram(_programID);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Bind the program and dispatch a number of work groups
+    /// </summary>
+    void Dispatch(const std::uint32_t groupsX, const std::uint32_t groupsY = 1, const std::uint32_t groupsZ = 1) const
+    {
+        GLState.UseProgram(_programID);
+        glDispatchCompute(groupsX, groupsY, groupsZ);
+    };
+
+
+    std::int32_t GetUniformLocation(const std::string& name) const
+    {
+        return glGetUniformLocation(_programID, name.c_str());
+    };
+
+
+    void SetUInt(const std::int32_t location, const std::uint32_t value) const
+    {
+        glProgramUniform1ui(_programID, location, value);
+    };
+
+    void SetFloat(const std::int32_t location, const float value) const
+    {
+        glProgramUniform1f(_programID, location, value);
+    };
+
+    void SetMatrix4(const std::int32_t location, const glm::mat4& matrix) const
+    {
+        glProgramUniformMatrix4fv(_programID, location, 1, false, glm::value_ptr(matrix));
+    };
+
+
+    std::uint32_t GetProgramID() const
+    {
+        return _programID;
+    };
+
+
+private:
+
+    void CheckCompileStatus(const std::uint32_t shaderID) const
+    {
+        int success = 0;
+        glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+
+        if(!success)
+        {
+            int bufferLength = 0;
+            glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &bufferLength);
+
+            std::string error;
+            error.resize(bufferLength);
+
+            glGetShaderInfoLog(shaderID, bufferLength, &bufferLength, error.data());
+
+            std::cerr << "Compute shader compilation error:\n" << error << "\n";
+
+            ShaderIncludes.PrintSourceStrings(std::cerr);
+
+            __debugbreak();
+        };
+    };
+
+    void CheckLinkStatus() const
+    {
+        int success = 0;
+        glGetProgramiv(_programID, GL_LINK_STATUS, &success);
+
+        if(!success)
+        {
+            int bufferLength = 0;
+            glGetProgramiv(_programID, GL_INFO_LOG_LENGTH, &bufferLength);
+
+            std::string error;
+            error.resize(bufferLength);
+
+            glGetProgramInfoLog(_programID, bufferLength, &bufferLength, error.data());
+
+            std::cerr << "Compute program link error:\n" << error << "\n";
+
+            __debugbreak();
+        };
+    };
+
+};
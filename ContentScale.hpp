@@ -0,0 +1,92 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <glm/vec2.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A font atlas rasterized for one content scale, e.g. 13x24 glyphs for 100% and 26x48 for 200%
+/// </summary>
+struct ScaledAtlas
+{
+    std::wstring_view Path;
+
+    glm::uvec2 GlyphSize = { 0, 0 };
+
+    /// <summary>
+    /// The content scale the glyphs were rasterized for, 1 for 96 DPI
+    /// </summary>
+    float Scale = 1.0f;
+};
+
+
+/// <summary>
+/// The atlas to draw with at a content scale: the smallest one rasterized at or above it, so glyphs are only ever sampled down,
+/// or the largest one if none reach it. Picking per monitor keeps text sharp on high-DPI screens without drawing from an atlas far larger than needed
+/// </summary>
+inline const ScaledAtlas& SelectScaledAtlas(const std::span<const ScaledAtlas> atlases, const float contentScale)
+{
+    wt::Assert(atlases.empty() == false, "No atlases to select from");
+
+    const ScaledAtlas* selected = nullptr;
+    const ScaledAtlas* largest = &atlases.front();
+
+    for(const ScaledAtlas& atlas : atlases)
+    {
+        if(atlas.Scale > largest->Scale)
+            largest = &atlas;
+
+        if(atlas.Scale >= contentScale && (selected == nullptr || atlas.Scale < selected->Scale))
+            selected = &atlas;
+    };
+
+    return selected != nullptr ? *selected : *largest;
+};
+
+
+/// <summary>
+/// The transform that draws text from an atlas rasterized for atlasScale at the window's content scale, placed at a position in window units.
+/// Window units are the window's own coordinates, they're contentScale framebuffer pixels each, so text keeps its size as it moves between monitors
+/// </summary>
+inline glm::mat4 GetContentScaleTransform(const glm::vec2& position, const float contentScale, const float atlasScale)
+{
+    const float glyphScale = contentScale / atlasScale;
+
+    return glm::scale(glm::translate(glm::mat4(1.0f), { position * contentScale, 0.0f }), { glyphScale, glyphScale, 1.0f });
+};
+
+
+/// <summary>
+/// A monitor's content scale, its DPI relative to 96. Only the horizontal scale is used, GLFW reports the same for both axes on every desktop
+/// </summary>
+inline float GetMonitorContentScale(GLFWmonitor* monitor)
+{
+    if(monitor == nullptr)
+        return 1.0f;
+
+    float scale = 1.0f;
+
+    glfwGetMonitorContentScale(monitor, &scale, nullptr);
+
+    return std::max(scale, 1.0f / 8.0f);
+};
+
+/// <summary>
+/// The content scale of the monitor a window is on
+/// </summary>
+inline float GetWindowContentScale(GLFWwindow* window)
+{
+    float scale = 1.0f;
+
+    glfwGetWindowContentScale(window, &scale, nullptr);
+
+    return std::max(scale, 1.0f / 8.0f);
+};
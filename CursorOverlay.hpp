@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include "RenderBackend.hpp"
+#include "FontSprite.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A solid rectangle of the overlay, matches the std430 layout of "CursorQuad" in CursorOverlayVertexShader.glsl
+/// </summary>
+struct CursorQuad
+{
+    /// <summary>
+    /// The top-left corner of the rectangle, in screen space
+    /// </summary>
+    glm::vec2 Position;
+
+    /// <summary>
+    /// The rectangle's size, in pixels
+    /// </summary>
+    glm::vec2 Size;
+
+    /// <summary>
+    /// Straight alpha
+    /// </summary>
+    glm::vec4 Colour;
+};
+
+static_assert(sizeof(CursorQuad) == 32, "CursorQuad must match the std430 struct size");
+
+
+/// <summary>
+/// The caret and selection, drawn as a few solid quads on top of the finished text rather than with it.
+/// The text stays in a RetainedFramebuffer, so a blink or a caret move only copies it to the window again and draws these quads,
+/// the glyph pass is skipped entirely. Together with on-demand rendering an idle editor costs a blit and a quad every blink.
+/// Draws through an IRenderBackend rather than GL
+/// </summary>
+class CursorOverlay
+{
+
+private:
+
+    std::reference_wrapper<IRenderBackend> _backend;
+
+    /// <summary>
+    /// Built from CursorOverlayVertexShader.glsl and CursorOverlayFragmentShader.glsl, alpha blended
+    /// </summary>
+    BackendPipeline _quadPipeline = BackendPipeline::None;
+
+    /// <summary>
+    /// The rectangles added since the last draw
+    /// </summary>
+    std::vector<CursorQuad> _queuedQuads;
+
+    /// <summary>
+    /// A streaming buffer, each frame's quads go into its own region
+    /// </summary>
+    BackendBuffer _quadBuffer = BackendBuffer::None;
+
+    std::size_t _regionSizeInBytes = 0;
+
+    /// <summary>
+    /// How much of the current frame's region the frame's earlier draws used
+    /// </summary>
+    std::size_t _regionWriteOffset = 0;
+
+    /// <summary>
+    /// When the caret was last made visible, blinks are counted from here
+    /// </summary>
+    double _blinkStart = 0.0;
+
+
+public:
+
+    /// <summary>
+    /// How long the caret stays shown, then hidden, in seconds. 0 doesn't blink
+    /// </summary>
+    double BlinkInterval = 0.53;
+
+    /// <summary>
+    /// The caret's width, in pixels
+    /// </summary>
+    float CaretWidth = 2.0f;
+
+    glm::vec4 CaretColour = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    glm::vec4 SelectionColour = { 0.2f, 0.4f, 0.9f, 0.35f };
+
+
+public:
+
+    /// <param name="backend"> The backend to draw with, has to outlive the overlay </param>
+    /// <param name="quadPipeline"> A pipeline built from CursorOverlayVertexShader.glsl and CursorOverlayFragmentShader.glsl, with alpha blending </param>
+    /// <param name="quadCapacity"> How many quads a frame holds before the buffer grows </param>
+    CursorOverlay(IRenderBackend& backend, const BackendPipeline quadPipeline, const std::size_t quadCapacity = 64) :
+        _backend(backend),
+        _quadPipeline(quadPipeline)
+    {
+        CreateQuadBuffer(quadCapacity * sizeof(CursorQuad));
+    };
+
+    CursorOverlay(const CursorOverlay&) = delete;
+    CursorOverlay& operator = (const CursorOverlay&) = delete;
+
+    ~CursorOverlay()
+    {
+        _backend.get().DestroyBuffer(_quadBuffer);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Show the caret from now on and start blinking again, call whenever the caret moves or the text is edited
+    /// </summary>
+    /// <param name="time"> As returned by glfwGetTime </param>
+    void ResetBlink(const double time)
+    {
+        _blinkStart = time;
+    };
+
+    bool IsCaretVisible(const double time) const
+    {
+        if(BlinkInterval <= 0.0)
+            return true;
+
+        return static_cast<std::int64_t>(std::floor((time - _blinkStart) / BlinkInterval)) % 2 == 0;
+    };
+
+    /// <summary>
+    /// When the caret next appears or disappears, for FrameScheduler::RequestRedrawAt. Negative if it doesn't blink
+    /// </summary>
+    double GetNextBlinkTime(const double time) const
+    {
+        if(BlinkInterval <= 0.0)
+            return -1.0;
+
+        return _blinkStart + (std::floor((time - _blinkStart) / BlinkInterval) + 1.0) * BlinkInterval;
+    };
+
+
+    /// <summary>
+    /// Queue the caret at the left edge of a glyph cell, if it's shown at the time
+    /// </summary>
+    /// <param name="cellRect"> The cell's top-left corner and size, in screen space </param>
+    void AddCaret(const glm::vec4& cellRect, const double time)
+    {
+        if(IsCaretVisible(time) == false)
+            return;
+
+        AddRect({ cellRect.x, cellRect.y }, { CaretWidth, cellRect.w }, CaretColour);
+    };
+
+    /// <summary>
+    /// Queue a selected range of cells, one rectangle per row. Selections don't blink
+    /// </summary>
+    /// <param name="cellRect"> A cell's top-left corner and size, in screen space </param>
+    void AddSelection(const glm::vec4& cellRect, const std::uint32_t cellCount)
+    {
+        AddRect({ cellRect.x, cellRect.y }, { cellRect.z * static_cast<float>(cellCount), cellRect.w }, SelectionColour);
+    };
+
+    /// <summary>
+    /// Queue a rectangle, in screen space
+    /// </summary>
+    void AddRect(const glm::vec2& position, const glm::vec2& size, const glm::vec4& colour)
+    {
+        _queuedQuads.emplace_back(CursorQuad { .Position = position, .Size = size, .Colour = colour });
+    };
+
+
+    /// <summary>
+    /// Draw the queued rectangles into the bound framebuffer with a single draw call, blended over what's there
+    /// </summary>
+    void Draw()
+    {
+        if(_queuedQuads.empty() == true)
+            return;
+
+        IRenderBackend& backend = _backend.get();
+
+        const std::size_t drawSizeInBytes = _queuedQuads.size() * sizeof(CursorQuad);
+
+        const std::size_t alignment = backend.GetStorageBufferOffsetAlignment();
+
+        std::size_t offset = ((_regionWriteOffset + alignment - 1) / alignment) * alignment;
+
+        // If the current frame's region is out of space, grow the buffer so the rest of the frame fits.
+        // The frame's earlier draws keep reading the old one, the backend frees it once they're done
+        if(offset + drawSizeInBytes > _regionSizeInBytes)
+        {
+            backend.DestroyBuffer(_quadBuffer);
+
+            CreateQuadBuffer((_regionSizeInBytes + drawSizeInBytes) * 2);
+
+            offset = 0;
+        };
+
+        // The mapping is write-only, quads are written whole and never read back
+        std::memcpy(backend.MapStreamingRegion(_quadBuffer) + offset, _queuedQuads.data(), drawSizeInBytes);
+
+        _regionWriteOffset = offset + drawSizeInBytes;
+
+        const std::uint32_t quadCount = static_cast<std::uint32_t>(_queuedQuads.size());
+
+        _queuedQuads.clear();
+
+
+        backend.BindPipeline(_quadPipeline);
+
+        backend.BindStorageBuffer(0, _quadBuffer, backend.GetStreamingRegionOffset(_quadBuffer) + offset, drawSizeInBytes);
+
+        backend.Draw(BackendPrimitive::TriangleStrip, GlyphQuadVertexCount, quadCount);
+    };
+
+
+    /// <summary>
+    /// Signal that all of the current frame's draws were issued, before the backend's EndFrame
+    /// </summary>
+    void EndFrame()
+    {
+        _regionWriteOffset = 0;
+    };
+
+
+private:
+
+    void CreateQuadBuffer(const std::size_t regionSizeInBytes)
+    {
+        _quadBuffer = _backend.get().CreateBuffer(BackendBufferDescription
+        {
+            .SizeInBytes = regionSizeInBytes,
+            .Usage = BackendBufferUsage::Streaming,
+        });
+
+        _regionSizeInBytes = regionSizeInBytes;
+        _regionWriteOffset = 0;
+    };
+
+};
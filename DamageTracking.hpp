@@ -0,0 +1,531 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/common.hpp>
+#include <glm/mat4x4.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "FontSprite.hpp"
+#include "TextBuffer.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A rectangle of window pixels, from the top-left corner like the screen-space projection
+/// </summary>
+struct DamageRect
+{
+    std::int32_t X = 0;
+    std::int32_t Y = 0;
+
+    std::int32_t Width = 0;
+    std::int32_t Height = 0;
+
+
+    bool IsEmpty() const
+    {
+        return Width <= 0 || Height <= 0;
+    };
+
+    /// <summary>
+    /// The smallest rectangle holding both
+    /// </summary>
+    DamageRect Union(const DamageRect& other) const
+    {
+        if(IsEmpty() == true)
+            return other;
+
+        if(other.IsEmpty() == true)
+            return *this;
+
+        const std::int32_t left = std::min(X, other.X);
+        const std::int32_t top = std::min(Y, other.Y);
+        const std::int32_t right = std::max(X + Width, other.X + other.Width);
+        const std::int32_t bottom = std::max(Y + Height, other.Y + other.Height);
+
+        return DamageRect { left, top, right - left, bottom - top };
+    };
+
+    DamageRect Clip(const std::int32_t width, const std::int32_t height) const
+    {
+        const std::int32_t left = std::clamp(X, 0, width);
+        const std::int32_t top = std::clamp(Y, 0, height);
+        const std::int32_t right = std::clamp(X + Width, 0, width);
+        const std::int32_t bottom = std::clamp(Y + Height, 0, height);
+
+        return DamageRect { left, top, right - left, bottom - top };
+    };
+};
+
+
+/// <summary>
+/// Works out which pixels of a monospaced TextBuffer's draw an edit changed, so only those have to be drawn again.
+/// Keeps the row and column every line of the text was laid out at, following TextLayoutComputeShader.glsl's rules for tabs and wrapping,
+/// and relays out only the lines from the first changed character on. Typing at the end of a large document touches a single glyph cell.
+/// Must see every change to the text, Update is called once per drawn frame before the text is drawn, which takes the dirty range
+/// </summary>
+class TextDamageTracker
+{
+
+private:
+
+    /// <summary>
+    /// A line of the text, up to and including its '\n'
+    /// </summary>
+    struct Line
+    {
+        std::size_t FirstCharacter = 0;
+
+        std::uint32_t FirstRow = 0;
+
+        /// <summary>
+        /// The row and column after the line's last character, where the next character on it would go
+        /// </summary>
+        std::uint32_t EndRow = 0;
+        std::uint32_t EndColumn = 0;
+    };
+
+
+    std::vector<Line> _lines;
+
+    /// <summary>
+    /// The layout the lines were built with, any change invalidates them
+    /// </summary>
+    TextLayoutOptions _layout;
+
+    std::uint32_t _glyphWidth = 0;
+
+    std::uint32_t _glyphHeight = 0;
+
+    /// <summary>
+    /// The text's size when it was last laid out. Erasing from the end leaves no dirty range, the size shows it
+    /// </summary>
+    std::size_t _characterCount = 0;
+
+    bool _valid = false;
+
+
+public:
+
+    /// <summary>
+    /// Lay out the text's changes since the last call and return the window pixels they touch, or nothing if the whole draw has to be redone,
+    /// e.g. on the first call, for proportional fonts or after the font's layout options changed. An empty rectangle means nothing changed.
+    /// Doesn't take the text's dirty range, the draw still needs it
+    /// </summary>
+    /// <param name="text"> The text, as it will be drawn </param>
+    /// <param name="font"> What the text is drawn with, its Transform places the text </param>
+    std::optional<DamageRect> Update(const TextBuffer& text, const FontSprite& font)
+    {
+        const TextDirtyRange dirtyRange = text.GetDirtyRange();
+
+        if(font.IsProportional() == true)
+        {
+            _valid = false;
+            return std::nullopt;
+        };
+
+        if(_valid == false || font.Layout != _layout || font.GetGlyphWidth() != _glyphWidth || font.GetGlyphHeight() != _glyphHeight)
+        {
+            _layout = font.Layout;
+            _glyphWidth = font.GetGlyphWidth();
+            _glyphHeight = font.GetGlyphHeight();
+
+            Relayout(text, 0);
+
+            _valid = true;
+
+            return std::nullopt;
+        };
+
+        if(dirtyRange.IsEmpty() == true && text.GetSize() == _characterCount)
+            return DamageRect { };
+
+
+        const std::size_t changeBegin = std::min(dirtyRange.Begin, text.GetSize());
+
+        const Line oldEnd = _lines.back();
+
+        // The text before the change is the same, so is its layout
+        const std::size_t lineIndex = FindLine(changeBegin);
+
+        const auto [firstRow, firstColumn] = LayOutUntil(text, _lines[lineIndex], changeBegin);
+
+        Relayout(text, lineIndex);
+
+        const Line& newEnd = _lines.back();
+
+        const std::uint32_t lastRow = std::max(oldEnd.EndRow, newEnd.EndRow);
+
+        // Only the cells from the first change to the end of the text changed
+        if(lastRow == firstRow)
+        {
+            const std::uint32_t lastColumn = std::max(oldEnd.EndColumn, newEnd.EndColumn);
+
+            return ToWindow(font, firstColumn, firstRow, std::max(lastColumn, firstColumn + 1), firstRow + 1);
+        };
+
+        // The rest of the first row, then every row below it, as wide as the text wraps at or as the window is
+        const std::uint32_t rowEnd = GetWrapColumns() != 0 ? GetWrapColumns() + 1 : UnwrappedColumns;
+
+        return ToWindow(font, firstColumn, firstRow, rowEnd, firstRow + 1).Union(ToWindow(font, 0, firstRow + 1, rowEnd, lastRow + 1));
+    };
+
+    /// <summary>
+    /// Forget the layout, the next Update lays the whole text out again
+    /// </summary>
+    void Invalidate()
+    {
+        _valid = false;
+    };
+
+    /// <summary>
+    /// The column and row the next character appended to the text goes to, where a caret at the end of the text is drawn.
+    /// Nothing while the layout isn't followed, e.g. for proportional fonts
+    /// </summary>
+    std::optional<glm::uvec2> GetEndCell() const
+    {
+        if(_valid == false)
+            return std::nullopt;
+
+        const Line& end = _lines.back();
+
+        std::uint32_t column = end.EndColumn;
+
+        // A full row wraps before the next character is placed
+        if(Advance(' ', column) == true)
+            return glm::uvec2(0, end.EndRow + 1);
+
+        return glm::uvec2(end.EndColumn, end.EndRow);
+    };
+
+    /// <summary>
+    /// The screen-space rectangle of a glyph cell, its top-left corner and size. Unlike the damage it has no margin
+    /// </summary>
+    glm::vec4 GetCellRect(const FontSprite& font, const glm::uvec2& cell) const
+    {
+        const float lineHeight = font.GetLineHeight();
+
+        const glm::vec4 topLeft = font.Transform * glm::vec4(static_cast<float>(cell.x * _glyphWidth), static_cast<float>(cell.y) * lineHeight, 0.0f, 1.0f);
+        const glm::vec4 bottomRight = font.Transform * glm::vec4(static_cast<float>((cell.x + 1) * _glyphWidth), static_cast<float>(cell.y + 1) * lineHeight, 0.0f, 1.0f);
+
+        return glm::vec4(glm::min(topLeft.x, bottomRight.x), glm::min(topLeft.y, bottomRight.y),
+                         glm::abs(bottomRight.x - topLeft.x), glm::abs(bottomRight.y - topLeft.y));
+    };
+
+    /// <summary>
+    /// Call onRow(firstCell, cellCount) for each row a range of the text's characters covers, e.g. to highlight a selection.
+    /// A selected newline covers a cell, so selected empty lines show. Rows past lastRow aren't visited, only the range's first line is searched for,
+    /// so a range of a whole large document costs the rows shown. Nothing while the layout isn't followed
+    /// </summary>
+    /// <param name="text"> The text, as it was last passed to Update </param>
+    /// <param name="begin"> The range's first character </param>
+    /// <param name="end"> One past the range's last character </param>
+    /// <param name="lastRow"> The last row to visit, e.g. the last one the window shows </param>
+    template<typename TOnRow>
+    void ForEachRowOf(const TextBuffer& text, const std::size_t begin, const std::size_t end, const std::uint32_t lastRow, const TOnRow& onRow) const
+    {
+        if(_valid == false || begin >= std::min(end, text.GetSize()))
+            return;
+
+        // Full rows of a wrapped line are drawn as wide as the text wraps at
+        const std::uint32_t wrapColumns = GetWrapColumns();
+
+        for(std::size_t lineIndex = FindLine(begin); lineIndex < _lines.size(); ++lineIndex)
+        {
+            const Line& line = _lines[lineIndex];
+
+            if(line.FirstCharacter >= end || line.FirstRow > lastRow)
+                return;
+
+            const bool endsInNewline = lineIndex + 1 < _lines.size();
+
+            const std::size_t lineEnd = endsInNewline == true ? _lines[lineIndex + 1].FirstCharacter : text.GetSize();
+
+            const auto [firstRow, firstColumn] = begin > line.FirstCharacter ? LayOutUntil(text, line, begin) : std::pair<std::uint32_t, std::uint32_t>(line.FirstRow, 0);
+
+            // The newline's own cell follows the line's last character
+            const auto [endRow, endColumn] = end < lineEnd ? LayOutUntil(text, line, end) :
+                                                             std::pair<std::uint32_t, std::uint32_t>(line.EndRow, line.EndColumn + (endsInNewline == true ? 1 : 0));
+
+            for(std::uint32_t row = firstRow; row <= std::min(endRow, lastRow); ++row)
+            {
+                const std::uint32_t rowBegin = row == firstRow ? firstColumn : 0;
+                const std::uint32_t rowEnd = row == endRow ? endColumn : wrapColumns;
+
+                if(rowEnd > rowBegin)
+                    onRow(glm::uvec2(rowBegin, row), rowEnd - rowBegin);
+            };
+        };
+    };
+
+
+private:
+
+    /// <summary>
+    /// How many columns a row without wrapping is assumed to span, anything past the window is clipped away
+    /// </summary>
+    static constexpr std::uint32_t UnwrappedColumns = 1u << 16;
+
+
+    std::uint32_t GetWrapColumns() const
+    {
+        return _layout.WrapWidth > 0.0f ? std::max(static_cast<std::uint32_t>(_layout.WrapWidth / static_cast<float>(_glyphWidth)), 1u) : 0u;
+    };
+
+    std::size_t FindLine(const std::size_t character) const
+    {
+        const auto line = std::upper_bound(_lines.cbegin(), _lines.cend(), character, [](const std::size_t character, const Line& line)
+        {
+            return character < line.FirstCharacter;
+        });
+
+        return static_cast<std::size_t>(std::max<std::ptrdiff_t>(line - _lines.cbegin() - 1, 0));
+    };
+
+
+    /// <summary>
+    /// Advance a column past a character the way the layout pass does, returns whether it wrapped onto a new row first
+    /// </summary>
+    bool Advance(const char character, std::uint32_t& column) const
+    {
+        const std::uint32_t tabSize = std::max(_layout.TabSize, 1u);
+        const std::uint32_t wrapColumns = GetWrapColumns();
+
+        std::uint32_t nextColumn = character == '\t' ? ((column / tabSize) + 1) * tabSize : column + 1;
+
+        const bool wrapped = wrapColumns != 0 && column != 0 && nextColumn > wrapColumns;
+
+        if(wrapped == true)
+        {
+            nextColumn -= column;
+            column = 0;
+        };
+
+        column = nextColumn;
+
+        return wrapped;
+    };
+
+    /// <summary>
+    /// The row and column a character of a line is laid out at, or where the next one would be if it's the text's end
+    /// </summary>
+    std::pair<std::uint32_t, std::uint32_t> LayOutUntil(const TextBuffer& text, const Line& line, const std::size_t character) const
+    {
+        std::uint32_t row = line.FirstRow;
+        std::uint32_t column = 0;
+
+        std::size_t remaining = character - line.FirstCharacter;
+
+        // One character past the ones before it, the character itself, which may wrap before it's placed
+        text.ForEachRun(line.FirstCharacter, remaining + 1, [&](const std::string_view& run)
+        {
+            for(const char runCharacter : run)
+            {
+                std::uint32_t nextColumn = column;
+
+                // A newline is placed without wrapping
+                const bool wrapped = runCharacter != '\n' && Advance(runCharacter, nextColumn) == true;
+
+                if(wrapped == true)
+                {
+                    ++row;
+                    column = 0;
+                };
+
+                if(remaining == 0)
+                    return;
+
+                --remaining;
+                column = nextColumn;
+            };
+        });
+
+        return { row, column };
+    };
+
+    /// <summary>
+    /// Lay out every line from one on, the lines before it are kept
+    /// </summary>
+    void Relayout(const TextBuffer& text, const std::size_t firstLine)
+    {
+        Line line = firstLine < _lines.size() ? _lines[firstLine] : Line { };
+
+        _lines.resize(firstLine);
+
+        line.EndRow = line.FirstRow;
+        line.EndColumn = 0;
+
+        std::size_t position = line.FirstCharacter;
+
+        text.ForEachRun(line.FirstCharacter, text.GetSize() - line.FirstCharacter, [&](const std::string_view& run)
+        {
+            for(const char character : run)
+            {
+                ++position;
+
+                if(character == '\n')
+                {
+                    _lines.emplace_back(line);
+
+                    line = Line { .FirstCharacter = position, .FirstRow = line.EndRow + 1, .EndRow = line.EndRow + 1 };
+
+                    continue;
+                };
+
+                if(Advance(character, line.EndColumn) == true)
+                    ++line.EndRow;
+            };
+        });
+
+        _lines.emplace_back(line);
+
+        _characterCount = text.GetSize();
+    };
+
+
+    /// <summary>
+    /// The window pixels of a block of glyph cells, [firstColumn, endColumn) by [firstRow, endRow)
+    /// </summary>
+    DamageRect ToWindow(const FontSprite& font, const std::uint32_t firstColumn, const std::uint32_t firstRow, const std::uint32_t endColumn, const std::uint32_t endRow) const
+    {
+        const float lineHeight = font.GetLineHeight();
+
+        // Glyphs taller than a row reach into the next one, and bold or decorated glyphs spill a pixel past their cell
+        const float overhang = std::max(static_cast<float>(_glyphHeight) - lineHeight, 0.0f);
+
+        const glm::vec4 topLeft = font.Transform * glm::vec4(static_cast<float>(firstColumn * _glyphWidth) - 1.0f,
+                                                             static_cast<float>(firstRow) * lineHeight - 1.0f, 0.0f, 1.0f);
+
+        const glm::vec4 bottomRight = font.Transform * glm::vec4(static_cast<float>(endColumn) * static_cast<float>(_glyphWidth) + 1.0f,
+                                                                 static_cast<float>(endRow) * lineHeight + overhang + 1.0f, 0.0f, 1.0f);
+
+        const float left = std::min(topLeft.x, bottomRight.x);
+        const float top = std::min(topLeft.y, bottomRight.y);
+        const float right = std::max(topLeft.x, bottomRight.x);
+        const float bottom = std::max(topLeft.y, bottomRight.y);
+
+        // Clamped so unwrapped rows don't overflow, the caller clips to the window
+        constexpr float Limit = 1 << 24;
+
+        const std::int32_t x = static_cast<std::int32_t>(std::clamp(std::floor(left), -Limit, Limit));
+        const std::int32_t y = static_cast<std::int32_t>(std::clamp(std::floor(top), -Limit, Limit));
+
+        return DamageRect { x, y,
+                            static_cast<std::int32_t>(std::clamp(std::ceil(right), -Limit, Limit)) - x,
+                            static_cast<std::int32_t>(std::clamp(std::ceil(bottom), -Limit, Limit)) - y };
+    };
+
+};
+
+
+/// <summary>
+/// A window-sized colour buffer that keeps its pixels from frame to frame, so a frame only has to draw what changed.
+/// The window's back buffer is undefined after a swap, and WGL has no swap-with-damage, so every frame is drawn into this
+/// and blitted whole into the back buffer, a copy that costs a fraction of drawing the text again
+/// </summary>
+class RetainedFramebuffer
+{
+
+private:
+
+    std::uint32_t _framebuffer = 0;
+
+    std::uint32_t _colourRenderbuffer = 0;
+
+    std::int32_t _width = 0;
+    std::int32_t _height = 0;
+
+
+public:
+
+    RetainedFramebuffer() = default;
+
+    RetainedFramebuffer(const RetainedFramebuffer&) = delete;
+    RetainedFramebuffer& operator = (const RetainedFramebuffer&) = delete;
+
+    ~RetainedFramebuffer()
+    {
+        Destroy();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Match the window's size, the contents are lost whenever it changes
+    /// </summary>
+    /// <returns> True if the buffer was recreated, and the whole frame has to be drawn </returns>
+    bool Resize(const std::int32_t width, const std::int32_t height)
+    {
+        if(_framebuffer != 0 && width == _width && height == _height)
+            return false;
+
+        Destroy();
+
+        _width = width;
+        _height = height;
+
+        glCreateRenderbuffers(1, &_colourRenderbuffer);
+        glNamedRenderbufferStorage(_colourRenderbuffer, GL_RGBA8, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height));
+
+        glCreateFramebuffers(1, &_framebuffer);
+        glNamedFramebufferRenderbuffer(_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colourRenderbuffer);
+
+        wt::Assert(glCheckNamedFramebufferStatus(_framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Retained framebuffer is incomplete");
+
+        return true;
+    };
+
+    /// <summary>
+    /// Draw into the buffer, only inside a damaged rectangle if one is given. Clears are scissored too
+    /// </summary>
+    /// <param name="damage"> The pixels to draw, unset for all of them </param>
+    void Bind(const std::optional<DamageRect>& damage) const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+
+        if(damage.has_value() == false)
+        {
+            glDisable(GL_SCISSOR_TEST);
+            return;
+        };
+
+        // The scissor's origin is the bottom-left corner
+        const DamageRect rect = damage->Clip(_width, _height);
+
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(rect.X, _height - rect.Y - rect.Height, rect.Width, rect.Height);
+    };
+
+    /// <summary>
+    /// Copy the whole buffer into the window's back buffer, and bind the window's framebuffer again
+    /// </summary>
+    void Present() const
+    {
+        glDisable(GL_SCISSOR_TEST);
+
+        glBlitNamedFramebuffer(_framebuffer, 0, 0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    };
+
+
+private:
+
+    void Destroy()
+    {
+        glDeleteFramebuffers(1, &_framebuffer);
+        glDeleteRenderbuffers(1, &_colourRenderbuffer);
+
+        _framebuffer = 0;
+        _colourRenderbuffer = 0;
+    };
+
+};
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <system_error>
+
+#include "MappedFile.hpp"
+#include "TextLayout.hpp"
+#include "TextMetrics.hpp"
+
+
+/// <summary>
+/// Identifies a document's contents without reading all of it: its size, when it was last written, and a hash of pages sampled across it
+/// </summary>
+struct DocumentFingerprint
+{
+    std::uint64_t SizeInBytes = 0;
+
+    std::int64_t LastWriteTime = 0;
+
+    std::uint64_t SampledHash = 0;
+
+
+    bool operator == (const DocumentFingerprint&) const = default;
+};
+
+
+/// <summary>
+/// The layout options and font a document's row counts were wrapped with. The font is known by a hash of its advances, which persists
+/// across runs unlike the advances' address
+/// </summary>
+struct DocumentWrapKey
+{
+    std::uint64_t FontHash = 0;
+
+    float WrapWidth = 0.0f;
+
+    std::uint32_t TabSize = 0;
+
+
+    bool operator == (const DocumentWrapKey&) const = default;
+};
+
+
+enum class DocumentLayoutCacheKind : std::uint32_t
+{
+    /// <summary>
+    /// Every line's start, 64 bits each
+    /// </summary>
+    LineStarts,
+
+    /// <summary>
+    /// How many rows every line wraps into with a DocumentWrapKey, 32 bits each
+    /// </summary>
+    RowCounts,
+};
+
+
+struct DocumentLayoutCacheHeader
+{
+    std::uint32_t Magic;
+    std::uint32_t Version;
+
+    DocumentLayoutCacheKind Kind;
+    std::uint32_t Reserved;
+
+    /// <summary>
+    /// The document the values were found in. It may have been appended to since, the values still hold for the part that was there
+    /// </summary>
+    DocumentFingerprint Fingerprint;
+
+    /// <summary>
+    /// (Row counts) What the lines were wrapped with
+    /// </summary>
+    DocumentWrapKey WrapKey;
+
+    std::uint64_t Count;
+    std::uint64_t DataOffset;
+};
+
+
+/// <summary>
+/// A sidecar file next to a large document that keeps what it takes long to find again: the line index, and the wrapped row counts of each width.
+/// Reopening the document maps it and starts from there, rather than scanning GBs for newlines and laying every paragraph out again.
+/// A sidecar is only used while its fingerprint matches the document, or the start of a document that was appended to since, like a log.
+/// Sidecars are written to a temporary file that then replaces the previous one, so a sidecar is never seen half written. See MappedDocument
+/// </summary>
+class DocumentLayoutCache
+{
+
+public:
+
+    static constexpr std::uint32_t Magic = 0x4C43444C; // "LDCL"
+
+    static constexpr std::uint32_t Version = 1;
+
+    /// <summary>
+    /// How many pages the fingerprint's hash samples, and their size
+    /// </summary>
+    static constexpr std::size_t SampleCount = 64;
+    static constexpr std::size_t SampleSizeInBytes = 4096;
+
+
+private:
+
+    std::unique_ptr<MappedFile> _file;
+
+    DocumentLayoutCacheHeader _header = { };
+
+    bool _valid = false;
+
+
+public:
+
+    /// <summary>
+    /// Map a sidecar and check it was written for the document, or the part of it that was there when it was written
+    /// </summary>
+    /// <param name="path"> The sidecar, see GetLineStartsPath and GetRowCountsPath </param>
+    /// <param name="documentPath"> The document </param>
+    /// <param name="documentText"> The document's mapped text </param>
+    /// <param name="kind"> What the sidecar must hold </param>
+    /// <param name="wrapKey"> (Row counts) What the rows must have been wrapped with </param>
+    DocumentLayoutCache(const std::filesystem::path& path,
+                        const std::filesystem::path& documentPath,
+                        const std::string_view& documentText,
+                        const DocumentLayoutCacheKind kind,
+                        const DocumentWrapKey& wrapKey = { }) :
+        _file(std::make_unique<MappedFile>(path, false))
+    {
+        const std::uint64_t fileSize = _file->GetSizeInBytes();
+
+        if(fileSize < sizeof(DocumentLayoutCacheHeader))
+            return;
+
+        std::memcpy(&_header, _file->GetBytes().data(), sizeof(DocumentLayoutCacheHeader));
+
+        const std::uint64_t valueSize = kind == DocumentLayoutCacheKind::LineStarts ? sizeof(std::uint64_t) : sizeof(std::uint32_t);
+
+        _valid = _header.Magic == Magic &&
+                 _header.Version == Version &&
+                 _header.Kind == kind &&
+                 (kind == DocumentLayoutCacheKind::LineStarts || _header.WrapKey == wrapKey) &&
+                 _header.DataOffset % alignof(std::uint64_t) == 0 &&
+                 _header.DataOffset <= fileSize &&
+                 _header.Count <= (fileSize - _header.DataOffset) / valueSize &&
+                 MatchesDocument(_header.Fingerprint, documentPath, documentText);
+    };
+
+    DocumentLayoutCache(const DocumentLayoutCache&) = delete;
+    DocumentLayoutCache& operator = (const DocumentLayoutCache&) = delete;
+
+
+public:
+
+    bool IsValid() const
+    {
+        return _valid;
+    };
+
+    const DocumentFingerprint& GetFingerprint() const
+    {
+        return _header.Fingerprint;
+    };
+
+    /// <summary>
+    /// (Line starts) In place in the mapped sidecar, only valid while it exists
+    /// </summary>
+    std::span<const std::uint64_t> GetLineStarts() const
+    {
+        if(_valid == false || _header.Kind != DocumentLayoutCacheKind::LineStarts)
+            return { };
+
+        return std::span<const std::uint64_t>(reinterpret_cast<const std::uint64_t*>(_file->GetBytes().data() + _header.DataOffset), static_cast<std::size_t>(_header.Count));
+    };
+
+    /// <summary>
+    /// (Row counts) In place in the mapped sidecar, only valid while it exists
+    /// </summary>
+    std::span<const std::uint32_t> GetRowCounts() const
+    {
+        if(_valid == false || _header.Kind != DocumentLayoutCacheKind::RowCounts)
+            return { };
+
+        return std::span<const std::uint32_t>(reinterpret_cast<const std::uint32_t*>(_file->GetBytes().data() + _header.DataOffset), static_cast<std::size_t>(_header.Count));
+    };
+
+
+public:
+
+    static std::filesystem::path GetLineStartsPath(const std::filesystem::path& documentPath)
+    {
+        std::filesystem::path path = documentPath;
+        path += ".lines";
+
+        return path;
+    };
+
+    static std::filesystem::path GetRowCountsPath(const std::filesystem::path& documentPath, const DocumentWrapKey& wrapKey)
+    {
+        char suffix[48] = { };
+
+        std::snprintf(suffix, sizeof(suffix), ".rows-%016llx", static_cast<unsigned long long>(HashWrapKey(wrapKey)));
+
+        std::filesystem::path path = documentPath;
+        path += suffix;
+
+        return path;
+    };
+
+
+    /// <summary>
+    /// The fingerprint of the document's mapped text
+    /// </summary>
+    static DocumentFingerprint GetFingerprint(const std::filesystem::path& documentPath, const std::string_view& documentText)
+    {
+        std::error_code error;
+        const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(documentPath, error);
+
+        return DocumentFingerprint
+        {
+            .SizeInBytes = documentText.size(),
+            .LastWriteTime = error ? 0 : static_cast<std::int64_t>(writeTime.time_since_epoch().count()),
+            .SampledHash = HashSamples(documentText),
+        };
+    };
+
+    /// <summary>
+    /// Whether a fingerprint is of the document, or of its start before something was appended
+    /// </summary>
+    static bool MatchesDocument(const DocumentFingerprint& fingerprint, const std::filesystem::path& documentPath, const std::string_view& documentText)
+    {
+        if(fingerprint.SizeInBytes > documentText.size())
+            return false;
+
+        // A file of the same size that was written since was edited in place, which the samples could miss
+        if(fingerprint.SizeInBytes == documentText.size())
+        {
+            std::error_code error;
+            const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(documentPath, error);
+
+            if(error || static_cast<std::int64_t>(writeTime.time_since_epoch().count()) != fingerprint.LastWriteTime)
+                return false;
+        };
+
+        return HashSamples(documentText.substr(0, static_cast<std::size_t>(fingerprint.SizeInBytes))) == fingerprint.SampledHash;
+    };
+
+    static DocumentWrapKey GetWrapKey(const TextLayoutOptions& options, const TextMetricsFont& font)
+    {
+        std::uint64_t fontHash = std::hash<std::uint64_t>()(font.GlyphWidth);
+
+        const auto combine = [&](const std::uint64_t value)
+        {
+            fontHash ^= value + 0x9E3779B97F4A7C15 + (fontHash << 6) + (fontHash >> 2);
+        };
+
+        combine(font.Proportional == true ? 1 : 0);
+
+        if(font.Advances != nullptr)
+            combine(std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(font.Advances->data()), sizeof(*font.Advances))));
+
+        return DocumentWrapKey
+        {
+            .FontHash = fontHash,
+            .WrapWidth = options.WrapWidth,
+            .TabSize = options.TabSize,
+        };
+    };
+
+
+    /// <summary>
+    /// Write a sidecar, replacing the previous one. A sidecar that's mapped can't be replaced, it has to be destroyed first
+    /// </summary>
+    /// <param name="path"> The sidecar, see GetLineStartsPath and GetRowCountsPath </param>
+    /// <param name="writeValues"> Called with a function that writes a span of values, as often as it takes </param>
+    /// <returns> False if the sidecar couldn't be written, e.g. the document's folder is read-only </returns>
+    template<typename TValue, typename TFunction>
+    static bool Write(const std::filesystem::path& path,
+                      const DocumentLayoutCacheKind kind,
+                      const DocumentFingerprint& fingerprint,
+                      const DocumentWrapKey& wrapKey,
+                      const std::uint64_t count,
+                      TFunction&& writeValues)
+    {
+        std::filesystem::path temporaryPath = path;
+        temporaryPath += ".tmp";
+
+        {
+            std::ofstream stream = std::ofstream(temporaryPath, std::ios::binary | std::ios::trunc);
+
+            if(stream.is_open() == false)
+                return false;
+
+            const DocumentLayoutCacheHeader header =
+            {
+                .Magic = Magic,
+                .Version = Version,
+                .Kind = kind,
+                .Reserved = 0,
+                .Fingerprint = fingerprint,
+                .WrapKey = wrapKey,
+                .Count = count,
+                .DataOffset = (sizeof(DocumentLayoutCacheHeader) + 15) & ~std::uint64_t { 15 },
+            };
+
+            constexpr char padding[16] = { };
+
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            stream.write(padding, static_cast<std::streamsize>(header.DataOffset - sizeof(header)));
+
+            writeValues([&](const std::span<const TValue>& values)
+            {
+                stream.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size_bytes()));
+            });
+
+            if(stream.good() == false)
+                return false;
+        };
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, path, error);
+
+        if(error)
+            std::filesystem::remove(temporaryPath, error);
+
+        return !error;
+    };
+
+
+private:
+
+    /// <summary>
+    /// A hash of SampleCount pages spread evenly over the text, first and last included. Short texts are hashed whole
+    /// </summary>
+    static std::uint64_t HashSamples(const std::string_view& text)
+    {
+        if(text.size() <= SampleCount * SampleSizeInBytes)
+            return std::hash<std::string_view>()(text);
+
+        std::uint64_t hash = 0;
+
+        const std::size_t lastSampleOffset = text.size() - SampleSizeInBytes;
+
+        for(std::size_t sample = 0; sample < SampleCount; ++sample)
+        {
+            const std::size_t offset = static_cast<std::size_t>(static_cast<std::uint64_t>(lastSampleOffset) * sample / (SampleCount - 1));
+
+            hash ^= std::hash<std::string_view>()(text.substr(offset, SampleSizeInBytes)) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        };
+
+        return hash;
+    };
+
+    static std::uint64_t HashWrapKey(const DocumentWrapKey& wrapKey)
+    {
+        std::uint64_t hash = wrapKey.FontHash;
+
+        hash ^= std::hash<float>()(wrapKey.WrapWidth) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<std::uint32_t>()(wrapKey.TabSize) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+
+        return hash;
+    };
+
+};
@@ -0,0 +1,635 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "TextLayout.hpp"
+#include "TextStyle.hpp"
+#include "TextBuffer.hpp"
+#include "MappedFile.hpp"
+#include "DynamicSSBO.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The calls a draw capture is made of, each is a byte followed by its arguments
+/// </summary>
+enum class DrawCaptureCommand : std::uint8_t
+{
+    /// <summary>
+    /// The end of a frame
+    /// </summary>
+    EndFrame,
+
+    /// <summary>
+    /// The transform of the draws and flushes that follow, 16 floats
+    /// </summary>
+    Transform,
+
+    /// <summary>
+    /// The layout options of the draws that follow: wrap width, tab size and line height
+    /// </summary>
+    Layout,
+
+    /// <summary>
+    /// A string the calls that follow refer to by the order it was added in: its size, 64 bits, and its bytes.
+    /// Every distinct string is only stored once, however often it's drawn
+    /// </summary>
+    String,
+
+    /// <summary>
+    /// FontSprite::Draw: the string, whether it's UTF-8, and the colour
+    /// </summary>
+    Draw,
+
+    /// <summary>
+    /// TextBatch::Begin
+    /// </summary>
+    BatchBegin,
+
+    /// <summary>
+    /// TextBatch::Submit: the string, origin, colour, font index and layer
+    /// </summary>
+    BatchSubmit,
+
+    /// <summary>
+    /// TextBatch::PushClip: the rectangle
+    /// </summary>
+    BatchPushClip,
+
+    /// <summary>
+    /// TextBatch::PopClip
+    /// </summary>
+    BatchPopClip,
+
+    /// <summary>
+    /// TextBatch::Flush, with the current transform
+    /// </summary>
+    BatchFlush,
+
+    /// <summary>
+    /// A recorded TextBuffer's text changed: the buffer's index, 32 bits, the position it changed from, 64 bits, and the size and bytes of its new text from there to its end.
+    /// A buffer's first edit, from position 0, adds it
+    /// </summary>
+    BufferEdit,
+
+    /// <summary>
+    /// FontSprite::Draw of a TextBuffer: the buffer's index and the colour
+    /// </summary>
+    BufferDraw,
+};
+
+
+/// <summary>
+/// A call read back from a draw capture, with the state it was made in
+/// </summary>
+struct CapturedDrawCall
+{
+    DrawCaptureCommand Command = DrawCaptureCommand::EndFrame;
+
+    glm::mat4 Transform = glm::mat4(1.0f);
+
+    TextLayoutOptions Layout;
+
+    /// <summary>
+    /// (Draw and BatchSubmit) The drawn string. (BufferEdit) The buffer's text from EditPosition on. Only valid while the capture exists
+    /// </summary>
+    std::string_view Text;
+
+    /// <summary>
+    /// (BufferEdit and BufferDraw) Which of the recorded TextBuffers, in the order they were first drawn in
+    /// </summary>
+    std::uint32_t BufferIndex = 0;
+
+    /// <summary>
+    /// (BufferEdit) Where the buffer's text changed from. Everything from there on is replaced by Text
+    /// </summary>
+    std::size_t EditPosition = 0;
+
+    /// <summary>
+    /// (Draw) The string is UTF-8, drawn with FontSprite::Draw(std::u8string_view)
+    /// </summary>
+    bool Utf8 = false;
+
+    /// <summary>
+    /// (Draw, BufferDraw and BatchSubmit) The text colour. (BatchPushClip) The clip rectangle
+    /// </summary>
+    glm::vec4 Colour = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    glm::vec2 Origin = { 0.0f, 0.0f };
+
+    std::uint32_t FontIndex = 0;
+
+    std::uint8_t Layer = 0;
+
+    /// <summary>
+    /// (BatchSubmit) See TextBatch::Submit
+    /// </summary>
+    float Scale = 1.0f;
+
+    GlyphStyle Style = GlyphStyle::None;
+};
+
+
+/// <summary>
+/// Records the text a FontSprite or TextBatch draws, and the state it's drawn with, into a compact binary file a frame at a time,
+/// so a workload seen in the field can be replayed and profiled without the data it was drawn from, see TextBenchmark::Replay.
+/// Plain, UTF-8 and TextBuffer draws of a FontSprite and the string submits of a TextBatch are recorded, the transform and layout only when they change,
+/// and every distinct string only once. A TextBuffer is recorded as edits of its text, only the changed range of a frame's draw is written.
+/// Styled, cached, paletted, ring and shaped draws aren't recorded
+/// </summary>
+class DrawRecorder
+{
+
+public:
+
+    static constexpr std::uint32_t Magic = 0x50414344; // "DCAP"
+
+    static constexpr std::uint32_t Version = 4;
+
+
+private:
+
+    std::ofstream _stream;
+
+    /// <summary>
+    /// The frame being recorded, written out by EndFrame
+    /// </summary>
+    std::vector<std::byte> _frameBytes;
+
+    std::unordered_map<std::string, std::uint32_t, TransparentStringHash, std::equal_to<>> _stringIDs;
+
+    glm::mat4 _transform = glm::mat4(1.0f);
+
+    TextLayoutOptions _layout;
+
+    /// <summary>
+    /// A TextBuffer drawn before, and its size when it was last recorded
+    /// </summary>
+    struct RecordedTextBuffer
+    {
+        std::uint32_t Index = 0;
+
+        std::size_t Size = 0;
+    };
+
+    /// <summary>
+    /// Only the TextBuffers' edits are recorded, their text is never interned as a string
+    /// </summary>
+    std::unordered_map<const TextBuffer*, RecordedTextBuffer> _textBuffers;
+
+    std::uint64_t _frameCount = 0;
+
+
+public:
+
+    DrawRecorder(const std::filesystem::path& path) :
+        _stream(path, std::ios::binary | std::ios::trunc)
+    {
+        wt::Assert(_stream.is_open() == true, [&]()
+        {
+            return std::string("Unable to write a draw capture to \"").append(path.string()).append("\"");
+        });
+
+        _stream.write(reinterpret_cast<const char*>(&Magic), sizeof(Magic));
+        _stream.write(reinterpret_cast<const char*>(&Version), sizeof(Version));
+    };
+
+    DrawRecorder(const DrawRecorder&) = delete;
+    DrawRecorder& operator = (const DrawRecorder&) = delete;
+
+    ~DrawRecorder()
+    {
+        // Draws after the last EndFrame still make a frame
+        if(_frameBytes.empty() == false)
+            EndFrame();
+    };
+
+
+public:
+
+    void RecordDraw(const glm::mat4& transform, const TextLayoutOptions& layout, const std::string_view& text, const glm::vec4& textColour, const bool utf8 = false)
+    {
+        RecordState(transform, layout);
+
+        const std::uint32_t stringID = RecordString(text);
+
+        Write(DrawCaptureCommand::Draw);
+        Write(stringID);
+        Write(static_cast<std::uint8_t>(utf8));
+        Write(textColour);
+    };
+
+    /// <summary>
+    /// Record a TextBuffer's draw. Only the text changed since it was last recorded is read, and written as an edit of the recorded text
+    /// </summary>
+    /// <param name="dirtyRange"> What changed since the buffer was last drawn, see TextBuffer::TakeDirtyRange </param>
+    void RecordDraw(const glm::mat4& transform, const TextLayoutOptions& layout, const TextBuffer& text, const TextDirtyRange& dirtyRange, const glm::vec4& textColour)
+    {
+        RecordState(transform, layout);
+
+        const auto [recorded, added] = _textBuffers.try_emplace(&text, RecordedTextBuffer
+        {
+            .Index = static_cast<std::uint32_t>(_textBuffers.size()),
+        });
+
+        RecordedTextBuffer& buffer = recorded->second;
+
+        const std::size_t size = text.GetSize();
+
+        // A dirty range runs to the end of the text, so everything from its start is replaced.
+        // A size change without one means the range was taken elsewhere, and the whole text is written again
+        if(added == true || dirtyRange.IsEmpty() == false || size != buffer.Size)
+        {
+            const std::size_t position = added == false && dirtyRange.IsEmpty() == false ? std::min(dirtyRange.Begin, std::min(buffer.Size, size)) : 0;
+
+            Write(DrawCaptureCommand::BufferEdit);
+            Write(buffer.Index);
+            Write(static_cast<std::uint64_t>(position));
+            Write(static_cast<std::uint64_t>(size - position));
+
+            text.ForEachRun(position, size - position, [&](const std::string_view& run)
+            {
+                const std::byte* bytes = reinterpret_cast<const std::byte*>(run.data());
+                _frameBytes.insert(_frameBytes.end(), bytes, bytes + run.size());
+            });
+
+            buffer.Size = size;
+        };
+
+        Write(DrawCaptureCommand::BufferDraw);
+        Write(buffer.Index);
+        Write(textColour);
+    };
+
+
+    void RecordBatchBegin()
+    {
+        Write(DrawCaptureCommand::BatchBegin);
+    };
+
+    void RecordBatchSubmit(const std::string_view& text, const glm::vec2& origin, const glm::vec4& textColour, const std::uint32_t fontIndex, const std::uint8_t layer,
+                           const float scale, const GlyphStyle style)
+    {
+        const std::uint32_t stringID = RecordString(text);
+
+        Write(DrawCaptureCommand::BatchSubmit);
+        Write(stringID);
+        Write(origin);
+        Write(textColour);
+        Write(fontIndex);
+        Write(layer);
+        Write(scale);
+        Write(style);
+    };
+
+    void RecordBatchPushClip(const glm::vec4& rect)
+    {
+        Write(DrawCaptureCommand::BatchPushClip);
+        Write(rect);
+    };
+
+    void RecordBatchPopClip()
+    {
+        Write(DrawCaptureCommand::BatchPopClip);
+    };
+
+    void RecordBatchFlush(const glm::mat4& transform)
+    {
+        RecordState(transform, _layout);
+
+        Write(DrawCaptureCommand::BatchFlush);
+    };
+
+
+    /// <summary>
+    /// End the frame and write it to the file
+    /// </summary>
+    void EndFrame()
+    {
+        Write(DrawCaptureCommand::EndFrame);
+
+        _stream.write(reinterpret_cast<const char*>(_frameBytes.data()), static_cast<std::streamsize>(_frameBytes.size()));
+        _frameBytes.clear();
+
+        ++_frameCount;
+    };
+
+    std::uint64_t GetFrameCount() const
+    {
+        return _frameCount;
+    };
+
+
+private:
+
+    void RecordState(const glm::mat4& transform, const TextLayoutOptions& layout)
+    {
+        if(transform != _transform)
+        {
+            _transform = transform;
+
+            Write(DrawCaptureCommand::Transform);
+            Write(transform);
+        };
+
+        if(layout != _layout)
+        {
+            _layout = layout;
+
+            Write(DrawCaptureCommand::Layout);
+            Write(layout.WrapWidth);
+            Write(layout.TabSize);
+            Write(layout.LineHeight);
+        };
+    };
+
+    /// <summary>
+    /// The ID of a string, adding it to the capture if it's new
+    /// </summary>
+    std::uint32_t RecordString(const std::string_view& text)
+    {
+        if(const auto existing = _stringIDs.find(text); existing != _stringIDs.cend())
+            return existing->second;
+
+        const std::uint32_t stringID = static_cast<std::uint32_t>(_stringIDs.size());
+
+        _stringIDs.emplace(text, stringID);
+
+        Write(DrawCaptureCommand::String);
+        Write(static_cast<std::uint64_t>(text.size()));
+
+        const std::byte* bytes = reinterpret_cast<const std::byte*>(text.data());
+        _frameBytes.insert(_frameBytes.end(), bytes, bytes + text.size());
+
+        return stringID;
+    };
+
+    template<typename TValue>
+    void Write(const TValue& value)
+    {
+        static_assert(std::is_trivially_copyable_v<TValue> == true);
+
+        const std::byte* bytes = reinterpret_cast<const std::byte*>(&value);
+        _frameBytes.insert(_frameBytes.end(), bytes, bytes + sizeof(TValue));
+    };
+
+};
+
+
+/// <summary>
+/// A draw capture written by a DrawRecorder, mapped and decoded into its calls. The strings stay in the mapped file
+/// </summary>
+class DrawCapture
+{
+
+private:
+
+    MappedFile _file;
+
+    std::vector<CapturedDrawCall> _calls;
+
+    /// <summary>
+    /// Where each frame's calls start in _calls, and where the last one ends
+    /// </summary>
+    std::vector<std::size_t> _frameStarts;
+
+    std::size_t _characterCount = 0;
+
+    bool _valid = false;
+
+
+public:
+
+    DrawCapture(const std::filesystem::path& path) :
+        _file(path, false)
+    {
+        _valid = Decode();
+
+        wt::Assert(_valid, [&]()
+        {
+            return std::string("\"").append(path.string()).append("\" is not a valid draw capture");
+        });
+    };
+
+    DrawCapture(const DrawCapture&) = delete;
+    DrawCapture& operator = (const DrawCapture&) = delete;
+
+
+public:
+
+    bool IsValid() const
+    {
+        return _valid;
+    };
+
+    std::size_t GetFrameCount() const
+    {
+        return _frameStarts.empty() == true ? 0 : _frameStarts.size() - 1;
+    };
+
+    /// <summary>
+    /// A frame's calls, the EndFrame left out
+    /// </summary>
+    std::span<const CapturedDrawCall> GetFrame(const std::size_t frame) const
+    {
+        return std::span<const CapturedDrawCall>(_calls).subspan(_frameStarts[frame], _frameStarts[frame + 1] - _frameStarts[frame]);
+    };
+
+    /// <summary>
+    /// The characters drawn and submitted over every frame
+    /// </summary>
+    std::size_t GetCharacterCount() const
+    {
+        return _characterCount;
+    };
+
+
+private:
+
+    bool Decode()
+    {
+        const std::span<const std::byte> bytes = _file.GetBytes();
+
+        std::size_t position = 0;
+
+        const auto read = [&]<typename TValue>(TValue& value)
+        {
+            if(bytes.size() - position < sizeof(TValue))
+                return false;
+
+            std::memcpy(&value, bytes.data() + position, sizeof(TValue));
+            position += sizeof(TValue);
+
+            return true;
+        };
+
+
+        std::uint32_t magic = 0;
+        std::uint32_t version = 0;
+
+        if(read(magic) == false || read(version) == false || magic != DrawRecorder::Magic || version != DrawRecorder::Version)
+            return false;
+
+        std::vector<std::string_view> strings;
+
+        // The size of each recorded TextBuffer's text, after its last edit
+        std::vector<std::size_t> bufferSizes;
+
+        // The state the calls are made in, carried from call to call
+        CapturedDrawCall call;
+
+        const auto readString = [&]()
+        {
+            std::uint32_t stringID = 0;
+
+            if(read(stringID) == false || stringID >= strings.size())
+                return false;
+
+            call.Text = strings[stringID];
+            _characterCount += call.Text.size();
+
+            return true;
+        };
+
+        _frameStarts.emplace_back(0);
+
+        while(position < bytes.size())
+        {
+            DrawCaptureCommand command = DrawCaptureCommand::EndFrame;
+
+            if(read(command) == false)
+                return false;
+
+            bool complete = true;
+
+            switch(command)
+            {
+                case DrawCaptureCommand::EndFrame:
+                {
+                    _frameStarts.emplace_back(_calls.size());
+                    continue;
+                };
+
+                case DrawCaptureCommand::Transform:
+                {
+                    if(read(call.Transform) == false)
+                        return false;
+
+                    continue;
+                };
+
+                case DrawCaptureCommand::Layout:
+                {
+                    if(read(call.Layout.WrapWidth) == false || read(call.Layout.TabSize) == false || read(call.Layout.LineHeight) == false)
+                        return false;
+
+                    continue;
+                };
+
+                case DrawCaptureCommand::String:
+                {
+                    std::uint64_t size = 0;
+
+                    if(read(size) == false || bytes.size() - position < size)
+                        return false;
+
+                    strings.emplace_back(reinterpret_cast<const char*>(bytes.data() + position), static_cast<std::size_t>(size));
+                    position += static_cast<std::size_t>(size);
+
+                    continue;
+                };
+
+                case DrawCaptureCommand::Draw:
+                {
+                    std::uint8_t utf8 = 0;
+
+                    complete = readString() && read(utf8) && read(call.Colour);
+                    call.Utf8 = utf8 != 0;
+
+                    break;
+                };
+
+                case DrawCaptureCommand::BatchSubmit:
+                {
+                    complete = readString() && read(call.Origin) && read(call.Colour) && read(call.FontIndex) && read(call.Layer) && read(call.Scale) && read(call.Style);
+                    break;
+                };
+
+                case DrawCaptureCommand::BatchPushClip:
+                {
+                    complete = read(call.Colour);
+                    break;
+                };
+
+                case DrawCaptureCommand::BufferEdit:
+                {
+                    std::uint64_t editPosition = 0;
+                    std::uint64_t size = 0;
+
+                    if(read(call.BufferIndex) == false || read(editPosition) == false || read(size) == false || bytes.size() - position < size)
+                        return false;
+
+                    // A buffer is added by its first edit, which replaces all of its text
+                    if(call.BufferIndex == bufferSizes.size() && editPosition == 0)
+                        bufferSizes.emplace_back(0);
+
+                    if(call.BufferIndex >= bufferSizes.size() || editPosition > bufferSizes[call.BufferIndex])
+                        return false;
+
+                    call.EditPosition = static_cast<std::size_t>(editPosition);
+                    call.Text = std::string_view(reinterpret_cast<const char*>(bytes.data() + position), static_cast<std::size_t>(size));
+                    position += static_cast<std::size_t>(size);
+
+                    bufferSizes[call.BufferIndex] = call.EditPosition + call.Text.size();
+
+                    break;
+                };
+
+                case DrawCaptureCommand::BufferDraw:
+                {
+                    complete = read(call.BufferIndex) && call.BufferIndex < bufferSizes.size() && read(call.Colour);
+
+                    if(complete == true)
+                        _characterCount += bufferSizes[call.BufferIndex];
+
+                    break;
+                };
+
+                case DrawCaptureCommand::BatchBegin:
+                case DrawCaptureCommand::BatchPopClip:
+                case DrawCaptureCommand::BatchFlush:
+                    break;
+
+                default:
+                    return false;
+            };
+
+            if(complete == false)
+                return false;
+
+            call.Command = command;
+
+            _calls.emplace_back(call);
+        };
+
+        // Calls after the last EndFrame belong to a frame that was cut off
+        _calls.resize(_frameStarts.back());
+
+        return true;
+    };
+
+};
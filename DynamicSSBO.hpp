@@ -1,117 +1,919 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/packing.hpp>
 #include <glad/glad.h>
 
 #include "WindowsUtilities.hpp"
+#include "ProfileZones.hpp"
 
 
 enum class DataType
 {
     UInt32,
 
+    Int32,
+
+    Float,
+
     Vec2f,
 
+    /// <summary>
+    /// 12 bytes aligned to 16, a scalar can follow it in its last 4 bytes
+    /// </summary>
+    Vec3f,
+
     Vec4f,
 
     Mat4f,
 
-    Array,
+    /// <summary>
+    /// Two half floats in a uint, see PackedHalf2 and UnpackHalf2 in PackedData.glsl
+    /// </summary>
+    Half2,
+
+    /// <summary>
+    /// Four half floats in a uvec2, see PackedHalf4 and UnpackHalf4 in PackedData.glsl
+    /// </summary>
+    Half4,
+
+    /// <summary>
+    /// Four 8-bit normalized values in a uint, e.g. a colour, see PackedUnorm8x4 and UnpackUnorm8x4 in PackedData.glsl
+    /// </summary>
+    Unorm8x4,
+
+    Array,
+
+    Struct,
+
+    None,
+};
+
+
+static constexpr std::size_t DataTypeSizeInBytes(DataType type)
+{
+    switch(type)
+    {
+        case DataType::UInt32:
+            return sizeof(std::uint32_t);
+            break;
+
+        case DataType::Int32:
+            return sizeof(std::int32_t);
+            break;
+
+        case DataType::Float:
+            return sizeof(float);
+            break;
+
+        case DataType::Vec2f:
+            return sizeof(glm::vec2);
+            break;
+
+        case DataType::Vec3f:
+            return sizeof(glm::vec3);
+            break;
+
+        case DataType::Vec4f:
+            return sizeof(glm::vec4);
+            break;
+
+        case DataType::Mat4f:
+            return sizeof(glm::mat4);
+            break;
+
+        case DataType::Half2:
+        case DataType::Unorm8x4:
+            return sizeof(std::uint32_t);
+            break;
+
+        case DataType::Half4:
+            return sizeof(glm::uvec2);
+            break;
+
+
+        case DataType::Array:
+        case DataType::Struct:
+            return 0;
+            break;
+
+        default:
+        {
+            wt::Assert(false, "No such type");
+            __debugbreak();
+            return static_cast<std::size_t>(-1);
+        };
+    };
+};
+
+
+/// <summary>
+/// The std430 base alignment of a scalar data type
+/// </summary>
+/// <param name="type"></param>
+/// <returns></returns>
+static constexpr std::size_t DataTypeAlignment(DataType type)
+{
+    switch(type)
+    {
+        case DataType::UInt32:
+        case DataType::Int32:
+        case DataType::Float:
+        case DataType::Half2:
+        case DataType::Unorm8x4:
+            return 4;
+            break;
+
+        case DataType::Vec2f:
+        case DataType::Half4:
+            return 8;
+            break;
+
+        case DataType::Vec3f:
+        case DataType::Vec4f:
+        case DataType::Mat4f:
+            return 16;
+            break;
+
+        default:
+        {
+            wt::Assert(false, "No such type");
+            __debugbreak();
+            return static_cast<std::size_t>(-1);
+        };
+    };
+};
+
+
+/// <summary>
+/// The GLSL name of a scalar data type, as used in block declarations
+/// </summary>
+/// <param name="type"></param>
+/// <returns></returns>
+static constexpr std::string_view DataTypeGLSLName(DataType type)
+{
+    switch(type)
+    {
+        case DataType::UInt32:
+        case DataType::Half2:
+        case DataType::Unorm8x4:
+            return "uint";
+
+        case DataType::Int32:
+            return "int";
+
+        case DataType::Float:
+            return "float";
+
+        case DataType::Vec2f:
+            return "vec2";
+
+        case DataType::Vec3f:
+            return "vec3";
+
+        case DataType::Vec4f:
+            return "vec4";
+
+        case DataType::Mat4f:
+            return "mat4";
+
+        case DataType::Half4:
+            return "uvec2";
+
+        default:
+            return "";
+    };
+};
+
+
+/// <summary>
+/// Two half floats, the value written into a DataType::Half2 element. Half the size of a vec2, for values that don't need full precision, e.g. glyph offsets
+/// </summary>
+struct PackedHalf2
+{
+    std::uint32_t Bits = 0;
+
+
+    static PackedHalf2 Pack(const glm::vec2& value)
+    {
+        return PackedHalf2 { .Bits = glm::packHalf2x16(value) };
+    };
+};
+
+/// <summary>
+/// Four half floats, the value written into a DataType::Half4 element
+/// </summary>
+struct PackedHalf4
+{
+    glm::uvec2 Bits = { 0, 0 };
+
+
+    static PackedHalf4 Pack(const glm::vec4& value)
+    {
+        return PackedHalf4 { .Bits = { glm::packHalf2x16({ value.x, value.y }), glm::packHalf2x16({ value.z, value.w }) } };
+    };
+};
+
+/// <summary>
+/// Four 8-bit normalized values, the value written into a DataType::Unorm8x4 element. A quarter the size of a vec4 colour
+/// </summary>
+struct PackedUnorm8x4
+{
+    std::uint32_t Bits = 0;
+
+
+    /// <param name="value"> Clamped to [0, 1] </param>
+    static PackedUnorm8x4 Pack(const glm::vec4& value)
+    {
+        return PackedUnorm8x4 { .Bits = glm::packUnorm4x8(value) };
+    };
+};
+
+
+/// <summary>
+/// A CPU copy of a buffer that layout values are written into instead of the buffer itself, see SSBOLayout::EnableShadow.
+/// A write is a memcpy that records the bytes it touched, Flush merges the touched ranges and uploads each in a single call,
+/// so setting a layout's values one at a time costs a handful of buffer calls a frame rather than one each
+/// </summary>
+class SSBOShadow
+{
+
+private:
+
+    struct DirtyRange
+    {
+        std::size_t Begin = 0;
+
+        std::size_t End = 0;
+    };
+
+
+private:
+
+    std::uint32_t _bufferID = 0;
+
+    std::vector<std::byte> _data;
+
+    /// <summary>
+    /// The ranges written since the last Flush, unsorted and possibly overlapping until they're merged
+    /// </summary>
+    std::vector<DirtyRange> _dirtyRanges;
+
+
+public:
+
+    /// <summary>
+    /// Dirty ranges this close are uploaded as one. Re-uploading the unchanged bytes between them costs less than another call
+    /// </summary>
+    static constexpr std::size_t MergeDistance = 256;
+
+
+public:
+
+    /// <param name="bufferID"> The buffer Flush uploads to </param>
+    /// <param name="sizeInBytes"> The size of the buffer's layout </param>
+    SSBOShadow(const std::uint32_t bufferID, const std::size_t sizeInBytes) :
+        _bufferID(bufferID),
+        _data(sizeInBytes)
+    {
+    };
+
+
+public:
+
+    void Write(const std::size_t offset, const void* data, const std::size_t sizeInBytes)
+    {
+        WT_ASSERT(offset + sizeInBytes <= _data.size(), []()
+        {
+            return "Write is outside the shadowed buffer";
+        });
+
+        std::memcpy(_data.data() + offset, data, sizeInBytes);
+
+        MarkDirty(offset, sizeInBytes);
+    };
+
+    void MarkDirty(const std::size_t offset, const std::size_t sizeInBytes)
+    {
+        const std::size_t end = offset + sizeInBytes;
+
+        // Values are mostly written in order, e.g. a struct's members one after another, so most writes simply extend the last range
+        if(_dirtyRanges.empty() == false && offset <= _dirtyRanges.back().End && end >= _dirtyRanges.back().Begin)
+        {
+            _dirtyRanges.back().Begin = std::min(_dirtyRanges.back().Begin, offset);
+            _dirtyRanges.back().End = std::max(_dirtyRanges.back().End, end);
+            return;
+        };
+
+        _dirtyRanges.push_back(DirtyRange { .Begin = offset, .End = end });
+    };
+
+    /// <summary>
+    /// Upload everything written since the last Flush, e.g. once a frame before the buffer is used
+    /// </summary>
+    /// <returns> The number of upload calls made </returns>
+    std::size_t Flush()
+    {
+        MergeDirtyRanges();
+
+        for(const DirtyRange& range : _dirtyRanges)
+        {
+            glNamedBufferSubData(_bufferID, static_cast<GLintptr>(range.Begin), static_cast<GLsizeiptr>(range.End - range.Begin), _data.data() + range.Begin);
+        };
+
+        const std::size_t uploadCount = _dirtyRanges.size();
+
+        _dirtyRanges.clear();
+
+        return uploadCount;
+    };
+
+    /// <summary>
+    /// Copy everything written since the last Flush into a persistently mapped copy of the layout, instead of uploading it.
+    /// A ring region that didn't hold the previous values needs all of them, see GetData
+    /// </summary>
+    /// <param name="mappedBuffer"> A pointer to the start of the mapped layout </param>
+    /// <returns> The number of copies made </returns>
+    std::size_t Flush(std::byte* mappedBuffer)
+    {
+        MergeDirtyRanges();
+
+        for(const DirtyRange& range : _dirtyRanges)
+        {
+            std::memcpy(mappedBuffer + range.Begin, _data.data() + range.Begin, range.End - range.Begin);
+        };
+
+        const std::size_t copyCount = _dirtyRanges.size();
+
+        _dirtyRanges.clear();
+
+        return copyCount;
+    };
+
+    /// <summary>
+    /// Change the shadowed size, e.g. once the layout's trailing array was resized. Bytes past the old size start zeroed and unwritten
+    /// </summary>
+    void Resize(const std::size_t sizeInBytes)
+    {
+        _data.resize(sizeInBytes);
+
+        std::erase_if(_dirtyRanges, [sizeInBytes](const DirtyRange& range)
+        {
+            return range.Begin >= sizeInBytes;
+        });
+
+        for(DirtyRange& range : _dirtyRanges)
+        {
+            range.End = std::min(range.End, sizeInBytes);
+        };
+    };
+
+
+public:
+
+    /// <summary>
+    /// The layout's current values, as they'll be once flushed
+    /// </summary>
+    std::span<const std::byte> GetData() const
+    {
+        return _data;
+    };
+
+    std::uint32_t GetBufferID() const
+    {
+        return _bufferID;
+    };
+
+    /// <summary>
+    /// The number of ranges written since the last Flush, before they're merged
+    /// </summary>
+    std::size_t GetDirtyRangeCount() const
+    {
+        return _dirtyRanges.size();
+    };
+
+
+private:
+
+    void MergeDirtyRanges()
+    {
+        if(_dirtyRanges.size() < 2)
+            return;
+
+        std::sort(_dirtyRanges.begin(), _dirtyRanges.end(), [](const DirtyRange& left, const DirtyRange& right)
+        {
+            return left.Begin < right.Begin;
+        });
+
+        std::size_t mergedCount = 0;
+
+        for(std::size_t index = 1; index < _dirtyRanges.size(); ++index)
+        {
+            DirtyRange& merged = _dirtyRanges[mergedCount];
+            const DirtyRange& range = _dirtyRanges[index];
+
+            if(range.Begin <= merged.End + MergeDistance)
+                merged.End = std::max(merged.End, range.End);
+            else
+                _dirtyRanges[++mergedCount] = range;
+        };
+
+        _dirtyRanges.resize(mergedCount + 1);
+    };
+
+};
+
+
+/// <summary>
+/// A layout element resolved ahead of time. 
+/// Holds everything needed to write the element, so hot paths don't have to look it up by name
+/// </summary>
+struct ElementHandle
+{
+    std::size_t Offset = 0;
+
+    std::size_t SizeInBytes = 0;
+
+    DataType Type = DataType::None;
+
+    /// <summary>
+    /// (Arrays) The type of the array's elements
+    /// </summary>
+    DataType ArrayElementType = DataType::None;
+
+    /// <summary>
+    /// (Arrays) The number of elements, 0 for unsized arrays
+    /// </summary>
+    std::size_t ArrayElementCount = 0;
+
+    /// <summary>
+    /// (Arrays) The distance in bytes between two consecutive elements
+    /// </summary>
+    std::size_t ArrayElementStride = 0;
+
+
+    template<typename T>
+    void Set(const std::uint32_t bufferID, const T& value) const
+    {
+        AssertValueSize<T>();
+
+        glNamedBufferSubData(bufferID, Offset, sizeof(T), &value);
+    };
+
+    /// <summary>
+    /// Write a value into a shadow copy of the buffer, it's uploaded by the shadow's next Flush
+    /// </summary>
+    template<typename T>
+    void Set(SSBOShadow& shadow, const T& value) const
+    {
+        AssertValueSize<T>();
+
+        shadow.Write(Offset, &value, sizeof(T));
+    };
+
+    /// <summary>
+    /// Write a value directly into mapped buffer memory
+    /// </summary>
+    /// <param name="mappedBuffer"> A pointer to the start of the mapped layout </param>
+    /// <param name="value"> The value to write </param>
+    template<typename T>
+    void Write(std::byte* mappedBuffer, const T& value) const
+    {
+        AssertValueSize<T>();
+
+        std::memcpy(mappedBuffer + Offset, &value, sizeof(T));
+    };
+
+    /// <summary>
+    /// Upload a contiguous range of array elements using a single buffer call
+    /// </summary>
+    /// <param name="bufferID"> The buffer to write into </param>
+    /// <param name="firstIndex"> The index of the first element to write </param>
+    /// <param name="values"> The values to write, one per array element </param>
+    template<typename T>
+    void SetRange(const std::uint32_t bufferID, const std::size_t firstIndex, const std::span<const T>& values) const
+    {
+        if(values.empty() == true)
+            return;
+
+        AssertRange<T>(firstIndex, values.size());
+
+        glNamedBufferSubData(bufferID, GetElementOffset(firstIndex), values.size_bytes(), values.data());
+    };
+
+    /// <summary>
+    /// Write a contiguous range of array elements into a shadow copy of the buffer, as a single dirty range
+    /// </summary>
+    template<typename T>
+    void SetRange(SSBOShadow& shadow, const std::size_t firstIndex, const std::span<const T>& values) const
+    {
+        if(values.empty() == true)
+            return;
+
+        AssertRange<T>(firstIndex, values.size());
+
+        shadow.Write(GetElementOffset(firstIndex), values.data(), values.size_bytes());
+    };
+
+
+    constexpr std::size_t GetElementOffset(const std::size_t index) const
+    {
+        return Offset + (index * ArrayElementStride);
+    };
+
+
+private:
+
+    template<typename T>
+    void AssertRange(const std::size_t firstIndex, const std::size_t count) const
+    {
+        WT_ASSERT(Type == DataType::Array && ArrayElementType != DataType::Struct, []()
+        {
+            return "Bulk upload is only supported for scalar arrays";
+        });
+
+        WT_ASSERT(sizeof(T) == ArrayElementStride, []()
+        {
+            return "Invalid value type. Value size doesn't match array element stride";
+        });
+
+        WT_ASSERT(ArrayElementCount == 0 || firstIndex + count <= ArrayElementCount, []()
+        {
+            return "Invalid range";
+        });
+    };
+
+    template<typename T>
+    void AssertValueSize() const
+    {
+        WT_ASSERT(Type != DataType::Array && Type != DataType::Struct && Type != DataType::None, []()
+        {
+            return "Cannot write a single value into a non-scalar element";
+        });
+
+        WT_ASSERT(sizeof(T) == SizeInBytes, []()
+        {
+            return "Invalid value type. Value size doesn't match element size";
+        });
+    };
+};
+
+
+/// <summary>
+/// Lets string-keyed maps be searched with a string_view without constructing a std::string
+/// </summary>
+struct TransparentStringHash
+{
+    using is_transparent = void;
+
+    std::size_t operator()(const std::string_view& value) const
+    {
+        return std::hash<std::string_view>()(value);
+    };
+};
+
+
+static constexpr std::uint32_t InvalidNodeIndex = static_cast<std::uint32_t>(-1);
+
+
+/// <summary>
+/// A single element of a layout.
+/// Nodes live contiguously inside a LayoutArena and refer to each other by index, so an arena can be copied as a whole
+/// </summary>
+struct LayoutNode
+{
+    DataType Type = DataType::None;
+
+    std::size_t Offset = 0;
+
+    std::size_t SizeInBytes = 0;
+
+
+    /// <summary>
+    /// Where the node's name starts inside the arena's name pool
+    /// </summary>
+    std::uint32_t NameOffset = 0;
+
+    std::uint32_t NameLength = 0;
+
+    /// <summary>
+    /// The name's hash, calculated once when the node is added so lookups only compare names on a hash match
+    /// </summary>
+    std::size_t NameHash = 0;
+
+
+    /// <summary>
+    /// (Structs, struct arrays) A node's children form a linked list, in declaration order
+    /// </summary>
+    std::uint32_t FirstChild = InvalidNodeIndex;
+
+    std::uint32_t LastChild = InvalidNodeIndex;
+
+    std::uint32_t NextSibling = InvalidNodeIndex;
+
+    std::uint32_t ChildCount = 0;
+
+
+    /// <summary>
+    /// (Arrays) The type of the array's elements
+    /// </summary>
+    DataType ArrayElementType = DataType::None;
+
+    std::size_t ArrayElementCount = static_cast<std::size_t>(-1);
+
+    /// <summary>
+    /// (Scalar arrays) The distance in bytes between two consecutive elements
+    /// </summary>
+    std::size_t ArrayElementStride = 0;
+
+    /// <summary>
+    /// True if this is a runtime-sized array, such as "uint Characters[]".
+    /// An unsized array must be the last element of a layout
+    /// </summary>
+    bool Unsized = false;
+};
+
+static_assert(std::is_trivially_copyable<LayoutNode>::value == true, "LayoutNode must stay trivially copyable");
+
+
+/// <summary>
+/// Owns every node of a layout, and their names
+/// </summary>
+class LayoutArena
+{
+
+public:
+
+    /// <summary>
+    /// The implicit struct that holds a layout's top-level elements
+    /// </summary>
+    static constexpr std::uint32_t RootNodeIndex = 0;
+
+
+private:
+
+    std::vector<LayoutNode> _nodes;
+
+    /// <summary>
+    /// Every node's name, back to back
+    /// </summary>
+    std::vector<char> _names;
+
+
+public:
+
+    LayoutArena()
+    {
+        _nodes.emplace_back(LayoutNode
+        {
+            .Type = DataType::Struct,
+        });
+    };
+
+
+public:
+
+    std::uint32_t AddNode(const std::uint32_t parentIndex, const DataType type, const std::string_view& name)
+    {
+        const std::uint32_t nodeIndex = static_cast<std::uint32_t>(_nodes.size());
+
+        _nodes.emplace_back(LayoutNode
+        {
+            .Type = type,
+            .SizeInBytes = DataTypeSizeInBytes(type),
+            .NameOffset = static_cast<std::uint32_t>(_names.size()),
+            .NameLength = static_cast<std::uint32_t>(name.size()),
+            .NameHash = TransparentStringHash()(name),
+        });
+
+        _names.insert(_names.end(), name.cbegin(), name.cend());
+
+
+        LayoutNode& parent = _nodes[parentIndex];
+
+        if(parent.FirstChild == InvalidNodeIndex)
+            parent.FirstChild = nodeIndex;
+        else
+            _nodes[parent.LastChild].NextSibling = nodeIndex;
+
+        parent.LastChild = nodeIndex;
+        ++parent.ChildCount;
+
+        return nodeIndex;
+    };
+
+    /// <summary>
+    /// Find a node's direct child by name
+    /// </summary>
+    /// <param name="parentIndex"></param>
+    /// <param name="name"></param>
+    /// <returns> The child's index, or InvalidNodeIndex if there's no such child </returns>
+    std::uint32_t FindChild(const std::uint32_t parentIndex, const std::string_view& name) const
+    {
+        const std::size_t nameHash = TransparentStringHash()(name);
+
+        for(std::uint32_t childIndex = _nodes[parentIndex].FirstChild; childIndex != InvalidNodeIndex; childIndex = _nodes[childIndex].NextSibling)
+        {
+            if(_nodes[childIndex].NameHash == nameHash && GetName(childIndex) == name)
+                return childIndex;
+        };
+
+        return InvalidNodeIndex;
+    };
+
+    /// <summary>
+    /// Drop a node's children. The children must be the last nodes in the arena, starting at nodeCount
+    /// </summary>
+    /// <param name="parentIndex"></param>
+    /// <param name="nodeCount"> The node count to shrink the arena back to </param>
+    void RemoveChildren(const std::uint32_t parentIndex, const std::uint32_t nodeCount)
+    {
+        wt::Assert(parentIndex < nodeCount, []()
+        {
+            return "Cannot remove a node's children without removing the node itself";
+        });
 
-    Struct,
+        _nodes.resize(nodeCount);
+        _names.resize(static_cast<std::size_t>(_nodes.back().NameOffset) + _nodes.back().NameLength);
 
-    None,
-};
+        LayoutNode& parent = _nodes[parentIndex];
 
+        parent.FirstChild = InvalidNodeIndex;
+        parent.LastChild = InvalidNodeIndex;
+        parent.ChildCount = 0;
+    };
 
-static constexpr std::size_t DataTypeSizeInBytes(DataType type)
-{
-    switch(type)
-    {
-        case DataType::UInt32:
-            return sizeof(std::uint32_t);
-            break;
 
-        case DataType::Vec2f:
-            return sizeof(glm::vec2);
-            break;
+public:
 
-        case DataType::Vec4f:
-            return sizeof(glm::vec4);
-            break;
+    LayoutNode& operator [](const std::uint32_t nodeIndex)
+    {
+        return _nodes[nodeIndex];
+    };
 
-        case DataType::Mat4f:
-            return sizeof(glm::mat4);
-            break;
+    const LayoutNode& operator [](const std::uint32_t nodeIndex) const
+    {
+        return _nodes[nodeIndex];
+    };
 
+    std::string_view GetName(const std::uint32_t nodeIndex) const
+    {
+        const LayoutNode& node = _nodes[nodeIndex];
 
-        case DataType::Array:
-        case DataType::Struct:
-            return 0;
-            break;
+        return std::string_view(_names.data() + node.NameOffset, node.NameLength);
+    };
 
-        default:
-        {
-            wt::Assert(false, "No such type");
-            __debugbreak();
-            return static_cast<std::size_t>(-1);
-        };
+    std::uint32_t GetNodeCount() const
+    {
+        return static_cast<std::uint32_t>(_nodes.size());
     };
 };
 
 
-class SSBOLayout;
-
+/// <summary>
+/// A lightweight view of a layout element.
+/// Elements are cheap to copy and only valid while the layout that created them is alive
+/// </summary>
 class IElement
 {
-    friend class SSBOLayout;
 
 protected:
 
+    LayoutArena* _arena = nullptr;
+
+    std::uint32_t _nodeIndex = InvalidNodeIndex;
+
+
+    /// <summary>
+    /// (Scalar array elements) Array elements have no node of their own, so their values are stored in the view.
+    /// (Elements inside a struct array) The distance from the array's first element, whose nodes every element shares, to the viewed one
+    /// </summary>
     std::size_t _offset = 0;
 
     DataType _elementType = DataType::None;
 
-    std::size_t _sizeInBytes = 0;
-
 
-protected:
+public:
 
-    IElement() = default;
+    IElement(LayoutArena& arena, std::uint32_t nodeIndex, std::size_t elementOffset = 0) :
+        _arena(&arena),
+        _nodeIndex(nodeIndex),
+        _offset(elementOffset)
+    {
+    };
 
+    IElement(DataType type, std::size_t offset) :
+        _offset(offset),
+        _elementType(type)
+    {
+    };
 
-    virtual ~IElement() = default;
 
 public:
 
     std::size_t GetOffset() const
     {
-        return _offset;
+        if(_nodeIndex == InvalidNodeIndex)
+            return _offset;
+
+        return GetNode().Offset + _offset;
     };
 
     std::size_t GetSizeInBytes() const
     {
-        return _sizeInBytes;
+        if(_nodeIndex == InvalidNodeIndex)
+            return DataTypeSizeInBytes(_elementType);
+
+        return GetNode().SizeInBytes;
     };
 
     DataType GetElementType() const
     {
-        return _elementType;
+        if(_nodeIndex == InvalidNodeIndex)
+            return _elementType;
+
+        return GetNode().Type;
+    };
+
+
+    ElementHandle GetHandle() const
+    {
+        ElementHandle handle
+        {
+            .Offset = GetOffset(),
+            .SizeInBytes = GetSizeInBytes(),
+            .Type = GetElementType(),
+        };
+
+        if(handle.Type == DataType::Array)
+        {
+            const LayoutNode& node = GetNode();
+
+            handle.ArrayElementType = node.ArrayElementType;
+            handle.ArrayElementCount = node.Unsized == true ? 0 : node.ArrayElementCount;
+            handle.ArrayElementStride = node.ArrayElementStride;
+        };
+
+        return handle;
+    };
+
+
+    static constexpr bool IsOfType(DataType)
+    {
+        return true;
+    };
+
+
+protected:
+
+    LayoutNode& GetNode() const
+    {
+        return (*_arena)[_nodeIndex];
     };
 };
 
 
+/// <summary>
+/// Create an element view of a node, making sure the node is of the view's type
+/// </summary>
+/// <param name="arena"></param>
+/// <param name="nodeIndex"></param>
+/// <returns></returns>
+template<typename TElement>
+requires std::derived_from<TElement, IElement>
+static TElement MakeElement(LayoutArena& arena, const std::uint32_t nodeIndex, const std::size_t elementOffset = 0)
+{
+    WT_ASSERT(TElement::IsOfType(arena[nodeIndex].Type) == true, "Invalid element cast");
+
+    return TElement(arena, nodeIndex, elementOffset);
+};
+
+
 class ScalarElement : public IElement
 {
 public:
 
-    ScalarElement(DataType type)
+    using IElement::IElement;
+
+
+    static constexpr bool IsOfType(DataType type)
     {
-        _elementType = type;
-        _sizeInBytes = DataTypeSizeInBytes(type);
+        return type != DataType::Array && type != DataType::Struct && type != DataType::None;
     };
 
 public:
@@ -119,7 +921,41 @@ public:
     template<typename T>
     void Set(const std::uint32_t bufferID, const T& value) const
     {
-        switch(_elementType)
+        AssertValueType<T>();
+
+        glNamedBufferSubData(bufferID, GetOffset(), GetSizeInBytes(), &value);
+    };
+
+    /// <summary>
+    /// Write a value into a shadow copy of the buffer, it's uploaded by the shadow's next Flush
+    /// </summary>
+    template<typename T>
+    void Set(SSBOShadow& shadow, const T& value) const
+    {
+        AssertValueType<T>();
+
+        shadow.Write(GetOffset(), &value, GetSizeInBytes());
+    };
+
+    /// <summary>
+    /// Write a value directly into mapped buffer memory
+    /// </summary>
+    /// <param name="mappedBuffer"> A pointer to the start of the mapped layout </param>
+    /// <param name="value"> The value to write </param>
+    template<typename T>
+    void Write(std::byte* mappedBuffer, const T& value) const
+    {
+        AssertValueType<T>();
+
+        std::memcpy(mappedBuffer + GetOffset(), &value, GetSizeInBytes());
+    };
+
+private:
+
+    template<typename T>
+    void AssertValueType() const
+    {
+        switch(GetElementType())
         {
             case DataType::UInt32:
             {
@@ -130,6 +966,24 @@ public:
                 break;
             };
 
+            case DataType::Int32:
+            {
+                wt::Assert(std::is_same <T, std::int32_t>::value == true, []()
+                {
+                    return std::string("Invalid value type. Expected \"DataType::Int32\"");
+                });
+                break;
+            };
+
+            case DataType::Float:
+            {
+                wt::Assert(std::is_same <T, float>::value == true, []()
+                {
+                    return std::string("Invalid value type. Expected \"DataType::Float\"");
+                });
+                break;
+            };
+
             case DataType::Vec2f:
             {
                 wt::Assert(std::is_same <T, glm::vec2>::value == true, []()
@@ -139,6 +993,15 @@ public:
                 break;
             };
 
+            case DataType::Vec3f:
+            {
+                wt::Assert(std::is_same <T, glm::vec3>::value == true, []()
+                {
+                    return std::string("Invalid value type. Expected \"DataType::Vec3f\"");
+                });
+                break;
+            };
+
             case DataType::Vec4f:
             {
                 wt::Assert(std::is_same <T, glm::vec4>::value == true, []()
@@ -157,75 +1020,91 @@ public:
                 break;
             };
 
+            case DataType::Half2:
+            {
+                wt::Assert(std::is_same <T, PackedHalf2>::value == true, []()
+                {
+                    return std::string("Invalid value type. Expected \"DataType::Half2\"");
+                });
+                break;
+            };
+
+            case DataType::Half4:
+            {
+                wt::Assert(std::is_same <T, PackedHalf4>::value == true, []()
+                {
+                    return std::string("Invalid value type. Expected \"DataType::Half4\"");
+                });
+                break;
+            };
+
+            case DataType::Unorm8x4:
+            {
+                wt::Assert(std::is_same <T, PackedUnorm8x4>::value == true, []()
+                {
+                    return std::string("Invalid value type. Expected \"DataType::Unorm8x4\"");
+                });
+                break;
+            };
+
             default:
                 wt::Assert(false, "Invalid element");
         };
-
-        glNamedBufferSubData(bufferID, _offset, _sizeInBytes, &value);
     };
 };
 
 class ArrayElement;
 class StructElement : public IElement
 {
-    friend class SSBOLayout;
-
-private:
-
-    std::vector<std::pair<std::string, std::shared_ptr<IElement>>> _structElements;
+public:
 
+    using IElement::IElement;
 
-public:
 
-    StructElement()
+    static constexpr bool IsOfType(DataType type)
     {
-        _elementType = DataType::Struct;
-        _sizeInBytes = DataTypeSizeInBytes(_elementType);
+        return type == DataType::Struct;
     };
 
 public:
 
     template<typename TElement>
     requires std::derived_from<TElement, IElement>
-        std::shared_ptr<TElement> Get(const std::string_view& name)
+        TElement Get(const std::string_view& name) const
     {
-        wt::Assert(_elementType == DataType::Struct, [&]()
+        WT_ASSERT(GetElementType() == DataType::Struct, [&]()
         {
             return "Attempting to retrieve struct member on non-struct element";
         });
 
-        for(auto& [elementName, structElement] : _structElements)
-        {
-            if(elementName == name)
-            {
-                auto castResult = std::dynamic_pointer_cast<TElement, IElement>(structElement);
-
-                wt::Assert(castResult != nullptr, "Invalid element cast");
-
-                return castResult;
-            };
-        };
+        const std::uint32_t memberIndex = _arena->FindChild(_nodeIndex, name);
 
-        wt::Assert(false, [&]()
+        WT_ASSERT(memberIndex != InvalidNodeIndex, [&]()
         {
             return std::string("No such element \"").append(name).append("\" was found");
         });
 
-        return nullptr;
+        // Members of a struct array's element are offset as much as the element is
+        return MakeElement<TElement>(*_arena, memberIndex, _offset);
     };
 
-    template<typename TElement>
-    requires std::derived_from<TElement, IElement>
-        const std::shared_ptr<TElement> Get(const std::string_view& name) const
+    /// <summary>
+    /// Resolve a member once, so it can be written without repeating the lookup
+    /// </summary>
+    /// <param name="name"> The member's name </param>
+    /// <returns></returns>
+    ElementHandle GetHandle(const std::string_view& name) const
     {
-        return Get<TElement>(name);
+        return Get<IElement>(name).GetHandle();
     };
 
+    using IElement::GetHandle;
+
 
 
     template<typename TElement, DataType dataType>
     requires std::derived_from<TElement, IElement>
-        std::shared_ptr<TElement> Add(const std::string_view& name)
+        TElement Add(const std::string_view& name) const
     {
         if constexpr(std::is_same<TElement, StructElement>::value == true && dataType != DataType::Struct)
         {
@@ -241,25 +1120,21 @@ public:
         };
 
 
-        const auto elementResult = Add(dataType, name);
-
-        return std::dynamic_pointer_cast<TElement, IElement>(elementResult);
+        return TElement(*_arena, Add(dataType, name));
     };
 
 
     template<typename TElement>
     requires std::derived_from<TElement, IElement>
-        std::shared_ptr<TElement> Add(const std::string_view& name)
+        TElement Add(const std::string_view& name) const
     {
         if constexpr(std::is_same<TElement, StructElement>::value == true)
         {
-            const auto elementResult = Add(DataType::Struct, name);
-            return std::dynamic_pointer_cast<StructElement, IElement>(elementResult);
+            return TElement(*_arena, Add(DataType::Struct, name));
         }
         else if constexpr(std::is_same<TElement, ArrayElement>::value == true)
         {
-            const auto  elementResult = Add(DataType::Struct, name);
-            return std::dynamic_pointer_cast<ArrayElement, IElement>(elementResult);
+            return TElement(*_arena, Add(DataType::Array, name));
         }
         else
         {
@@ -271,67 +1146,62 @@ public:
 
 private:
 
-    std::shared_ptr<IElement> Add(DataType dataType, const std::string_view& name);
+    std::uint32_t Add(DataType dataType, const std::string_view& name) const;
 
 };
 
 class ArrayElement : public IElement
 {
-    friend class SSBOLayout;
-
-private:
-
-    std::vector<std::shared_ptr<IElement>> _arrayElements;
-
-    DataType _arrayElementType = DataType::None;
-
-    std::size_t _arrayElementCount = static_cast<std::size_t>(-1);
+public:
 
+    using IElement::IElement;
 
-public:
 
-    ArrayElement()
+    static constexpr bool IsOfType(DataType type)
     {
-        _elementType = DataType::Array;
-        _sizeInBytes = DataTypeSizeInBytes(_elementType);
+        return type == DataType::Array;
     };
 
 public:
 
     template<typename TElement>
     requires std::derived_from<TElement, IElement>
-        std::shared_ptr<TElement> GetAtIndex(std::size_t index)
+        TElement GetAtIndex(std::size_t index) const
     {
-        wt::Assert(_elementType == DataType::Array, []()
+        WT_ASSERT(GetElementType() == DataType::Array, []()
         {
             return "Cannot index into non-array element";
         });
 
-        wt::Assert(_arrayElements.empty() == false, []()
-        {
-            return "Element array is empty";
-        });
+        const LayoutNode& node = GetNode();
 
-        wt::Assert(index >= 0 && index < _arrayElements.size(),
+        WT_ASSERT(node.Unsized == true || index < node.ArrayElementCount,
                    []()
         {
             return "Invalid index";
         });
 
-        auto element = _arrayElements[index];
 
-        return std::dynamic_pointer_cast<TElement, IElement>(element);
-    };
+        // A laid out struct array only stores its first element, the others are views of it moved by a multiple of the stride
+        if(node.ArrayElementType == DataType::Struct)
+        {
+            WT_ASSERT(node.FirstChild != InvalidNodeIndex, []()
+            {
+                return "Element array is empty";
+            });
 
-    template<typename TElement>
-    requires std::derived_from<TElement, IElement>
-        const std::shared_ptr<TElement> GetAtIndex(std::size_t index) const
-    {
-        return GetAtIndex<TElement>(index);
+            return MakeElement<TElement>(*_arena, node.FirstChild, _offset + (index * node.ArrayElementStride));
+        };
+
+
+        // Scalar array elements aren't stored, their offset is calculated from the array's base offset and stride
+        WT_ASSERT(TElement::IsOfType(node.ArrayElementType) == true, "Invalid element cast");
+
+        return TElement(node.ArrayElementType, GetElementOffset(index));
     };
 
 
-    void SetArray(DataType arrayType, std::size_t elementCount)
+    void SetArray(DataType arrayType, std::size_t elementCount) const
     {
         wt::Assert(elementCount >= 1, []()
         {
@@ -343,390 +1213,527 @@ public:
             return "Invalid data type";
         });
 
-        _arrayElementType = arrayType;
-        _arrayElementCount = elementCount;
+        LayoutNode& node = GetNode();
+
+        node.ArrayElementType = arrayType;
+        node.ArrayElementCount = elementCount;
+    };
+
+    /// <summary>
+    /// Make this a runtime-sized array of scalars, as in "uint Characters[]"
+    /// </summary>
+    /// <param name="arrayType"> The array's element type </param>
+    void SetUnsizedArray(DataType arrayType) const
+    {
+        wt::Assert(arrayType != DataType::None && arrayType != DataType::Struct && arrayType != DataType::Array, []()
+        {
+            return "Unsized arrays can only hold scalar types";
+        });
+
+        LayoutNode& node = GetNode();
+
+        node.ArrayElementType = arrayType;
+        node.ArrayElementCount = 0;
+        node.Unsized = true;
     };
 
-    std::shared_ptr<StructElement> SetCustomArrayType(std::size_t elementCount)
+    StructElement SetCustomArrayType(std::size_t elementCount) const
     {
         SetArray(DataType::Struct, elementCount);
 
-        return std::dynamic_pointer_cast<StructElement, IElement>(_arrayElements.emplace_back(std::make_shared<StructElement>()));
+        // The raw array holds a single struct describing every element, laying out the array creates the rest
+        return StructElement(*_arena, _arena->AddNode(_nodeIndex, DataType::Struct, std::string_view()));
+    };
+
+
+    /// <summary>
+    /// Upload a contiguous range of array elements using a single buffer call
+    /// </summary>
+    /// <param name="bufferID"> The buffer to write into </param>
+    /// <param name="firstIndex"> The index of the first element to write </param>
+    /// <param name="values"> The values to write, one per array element </param>
+    template<typename T>
+    void SetRange(const std::uint32_t bufferID, const std::size_t firstIndex, const std::span<const T>& values) const
+    {
+        GetHandle().SetRange(bufferID, firstIndex, values);
+    };
+
+    /// <summary>
+    /// Write a contiguous range of array elements into a shadow copy of the buffer, as a single dirty range
+    /// </summary>
+    template<typename T>
+    void SetRange(SSBOShadow& shadow, const std::size_t firstIndex, const std::span<const T>& values) const
+    {
+        GetHandle().SetRange(shadow, firstIndex, values);
+    };
+
+
+public:
+
+    DataType GetArrayElementType() const
+    {
+        return GetNode().ArrayElementType;
+    };
+
+    std::size_t GetElementCount() const
+    {
+        return GetNode().ArrayElementCount;
+    };
+
+    std::size_t GetElementStride() const
+    {
+        return GetNode().ArrayElementStride;
+    };
+
+    bool IsUnsized() const
+    {
+        return GetNode().Unsized;
+    };
+
+    /// <summary>
+    /// (Scalar arrays) The offset of an element inside the buffer
+    /// </summary>
+    /// <param name="index"></param>
+    /// <returns></returns>
+    std::size_t GetElementOffset(const std::size_t index) const
+    {
+        const LayoutNode& node = GetNode();
+
+        return node.Offset + _offset + (index * node.ArrayElementStride);
     };
+};
+
+
+class RawLayout
+{
+    friend class SSBOLayout;
+
+private:
+
+    LayoutArena _arena;
 
 
 public:
 
-    constexpr DataType GetArrayElementType()
+    template<typename TElement, DataType dataType>
+    requires std::derived_from<TElement, IElement>
+        TElement Add(const std::string_view& name)
+    {
+        return GetRoot().Add<TElement, dataType>(name);
+    };
+
+    template<typename TElement>
+    requires std::derived_from<TElement, IElement>
+        TElement Add(const std::string_view& name)
     {
-        return _arrayElementType;
+        return GetRoot().Add<TElement>(name);
     };
 
-    constexpr std::size_t GetElementCount()
+
+private:
+
+    /// <summary>
+    /// The layout's top-level elements are the members of an implicit root struct
+    /// </summary>
+    /// <returns></returns>
+    StructElement GetRoot()
     {
-        return _arrayElementCount;
+        return StructElement(_arena, LayoutArena::RootNodeIndex);
     };
 };
 
 
-class RawLayout
+class SSBOLayout
 {
-    friend class SSBOLayout;
+    friend class BufferLayout;
 
 private:
 
-    std::vector<std::pair<std::string, std::shared_ptr<IElement>>> _layoutElements;
-
-public:
+    std::size_t _sizeInBytes = 0;
 
+    /// <summary>
+    /// The element stride of the layout's unsized array, 0 if the layout doesn't end with one
+    /// </summary>
+    std::size_t _trailingArrayStride = 0;
 
-    template<typename TElement, DataType dataType>
-    requires std::derived_from<TElement, IElement>
-        std::shared_ptr<TElement> Add(const std::string_view& name)
-    {
-        if constexpr(std::is_same<TElement, StructElement>::value == true && dataType != DataType::Struct)
-        {
-            static_assert(false, "Incompatable (Struct) element types");
-        }
-        else if constexpr(std::is_same<TElement, ArrayElement>::value == true && dataType != DataType::Array)
-        {
-            static_assert(false, "Incompatable (Array) element types");
-        }
-        else if constexpr(std::is_same<TElement, ScalarElement>::value == true && (dataType == DataType::None || dataType == DataType::Struct || dataType == DataType::Array))
-        {
-            static_assert(false, "Incompatable (Scalar) element types");
-        };
+    /// <summary>
+    /// The laid out elements. Mutable since the element views handed out by const lookups refer to it
+    /// </summary>
+    mutable LayoutArena _arena;
 
+    /// <summary>
+    /// The optional CPU copy of the buffer the layout is written to, see EnableShadow
+    /// </summary>
+    std::unique_ptr<SSBOShadow> _shadow;
 
-        const auto elementResult = Add(dataType, name);
 
-        return std::dynamic_pointer_cast<TElement, IElement>(elementResult);
-    };
+public:
 
-    template<typename TElement>
-    requires std::derived_from<TElement, IElement>
-        std::shared_ptr<TElement> Add(const std::string_view& name)
+    SSBOLayout(const RawLayout& rawLayout)
     {
-        if constexpr(std::is_same<TElement, StructElement>::value == true)
-        {
-            const auto elementResult = Add(DataType::Struct, name);
-            return std::dynamic_pointer_cast<StructElement, IElement>(elementResult);
-        }
-        else if constexpr(std::is_same<TElement, ArrayElement>::value == true)
-        {
-            const auto  elementResult = Add(DataType::Array, name);
-            return std::dynamic_pointer_cast<ArrayElement, IElement>(elementResult);
-        }
-        else
-        {
-            static_assert(false, "Incompatable (Scalar) element types");
-        };
-    };
+        TEXT_RENDERER_ZONE("SSBOLayout::CreateLayout");
 
+        std::size_t currentOffset = 0;
 
-private:
-
-    std::shared_ptr<IElement> Add(DataType dataType, const std::string_view& name)
-    {
-        wt::Assert(name.empty() == false, []()
-        {
-            return "Invalid member name";
-        });
+        CreateLayout(rawLayout._arena, LayoutArena::RootNodeIndex, LayoutArena::RootNodeIndex, currentOffset);
 
-        wt::Assert(dataType != DataType::None, []()
-        {
-            return "Invalid data type";
-        });
 
-        wt::Assert([&]()
-        {
-            for(auto& [elementName, structElement] : _layoutElements)
-            {
-                if(elementName == name)
-                {
-                    return false;
-                };
-            };
+        const LayoutNode& root = _arena[LayoutArena::RootNodeIndex];
 
-            return true;
-        },
-                   [&]()
+        wt::Assert(root.ChildCount > 0, [&]()
         {
-            return std::string("Duplicate member name \"").append(name).append("\"");
+            return std::string("Layout is empty");
         });
 
+        const LayoutNode& endElement = _arena[root.LastChild];
 
-        if(dataType == DataType::Struct)
-        {
-            auto insertResult = _layoutElements.emplace_back(std::make_pair(name, std::make_shared<StructElement>()));
-            return insertResult.second;
-        }
-        else if(dataType == DataType::Array)
+        _sizeInBytes = endElement.Offset + endElement.SizeInBytes;
+
+        // An unsized array contributes nothing to the fixed size of the layout, its elements are added by GetSizeInBytes(count)
+        for(std::uint32_t index = root.FirstChild; index != InvalidNodeIndex; index = _arena[index].NextSibling)
         {
-            auto insertResult = _layoutElements.emplace_back(std::make_pair(name, std::make_shared<ArrayElement>()));
-            return insertResult.second;
-        };
+            const LayoutNode& node = _arena[index];
 
+            if(node.Type != DataType::Array || node.Unsized == false)
+                continue;
 
-        auto insertResult = _layoutElements.emplace_back(std::make_pair(name, std::make_shared<ScalarElement>(dataType)));
-        return insertResult.second;
+            wt::Assert(index == root.LastChild, [&]()
+            {
+                return std::string("Unsized array \"").append(_arena.GetName(index)).append("\" must be the last element in the layout");
+            });
+
+            _trailingArrayStride = node.ArrayElementStride;
+        };
     };
-};
 
 
-class SSBOLayout
-{
+public:
 
-private:
+    template<typename TElement>
+    requires std::derived_from<TElement, IElement>
+        TElement Get(const std::string_view& name) const
+    {
+        return StructElement(_arena, LayoutArena::RootNodeIndex).Get<TElement>(name);
+    };
 
-    std::size_t _sizeInBytes = 0;
+    /// <summary>
+    /// Resolve an element once, so it can be written in hot paths without a name lookup
+    /// </summary>
+    /// <param name="name"> The element's name </param>
+    /// <returns></returns>
+    ElementHandle GetHandle(const std::string_view& name) const
+    {
+        return Get<IElement>(name).GetHandle();
+    };
 
-    std::unordered_map<std::string, std::shared_ptr<IElement>> _layoutElements;
 
+    constexpr std::size_t GetSizeInBytes() const
+    {
+        return _sizeInBytes;
+    };
+
+    /// <summary>
+    /// The size of a buffer holding this layout, with a given element count for the trailing unsized array
+    /// </summary>
+    /// <param name="trailingArrayElementCount"> The number of elements in the unsized array </param>
+    /// <returns></returns>
+    constexpr std::size_t GetSizeInBytes(const std::size_t trailingArrayElementCount) const
+    {
+        return _sizeInBytes + (trailingArrayElementCount * _trailingArrayStride);
+    };
 
-public:
 
-    SSBOLayout(RawLayout& rawLayout)
+    /// <summary>
+    /// Keep a CPU copy of a buffer with this layout. Elements set through GetShadow() only write the copy, Flush uploads what changed in as few calls as possible.
+    /// For layouts whose values change one at a time, e.g. a colour here and a size there, where every immediate Set would be its own driver call
+    /// </summary>
+    /// <param name="bufferID"> The buffer the copy is flushed to </param>
+    /// <param name="trailingArrayElementCount"> The number of elements of the layout's unsized array, if it ends with one </param>
+    void EnableShadow(const std::uint32_t bufferID, const std::size_t trailingArrayElementCount = 0)
     {
-        const auto layout = CreateLayout(rawLayout);
+        _shadow = std::make_unique<SSBOShadow>(bufferID, GetSizeInBytes(trailingArrayElementCount));
+    };
 
-        auto endElement = layout.back().second;
+    bool HasShadow() const
+    {
+        return _shadow != nullptr;
+    };
 
-        _sizeInBytes = endElement->GetOffset() + endElement->GetSizeInBytes();
+    SSBOShadow& GetShadow() const
+    {
+        wt::Assert(_shadow != nullptr, "Layout has no shadow, see EnableShadow");
 
-        _layoutElements.insert(layout.begin(), layout.end());
+        return *_shadow;
     };
 
+    /// <summary>
+    /// Upload the shadow's changes, see SSBOShadow::Flush
+    /// </summary>
+    /// <returns> The number of upload calls made </returns>
+    std::size_t Flush() const
+    {
+        return _shadow != nullptr ? _shadow->Flush() : 0;
+    };
 
-public:
 
-    template<typename TElement>
-    requires std::derived_from<TElement, IElement>
-        std::shared_ptr<TElement> Get(const std::string_view& name)
+    /// <summary>
+    /// Change the element count of the array at the end of the layout, without recalculating the rest of the layout
+    /// </summary>
+    /// <param name="name"> The name of the array </param>
+    /// <param name="elementCount"> The new element count </param>
+    void ResizeTrailingArray(const std::string_view& name, const std::size_t elementCount)
     {
-        wt::Assert(_layoutElements.empty() == false, [&]()
+        const std::uint32_t arrayIndex = _arena.FindChild(LayoutArena::RootNodeIndex, name);
+
+        wt::Assert(arrayIndex != InvalidNodeIndex && _arena[arrayIndex].Type == DataType::Array, [&]()
         {
-            return std::string("Layout is empty");
+            return std::string("No such array \"").append(name).append("\" was found");
         });
 
-        auto findResult = _layoutElements.find(name.data());
+        LayoutNode& arrayNode = _arena[arrayIndex];
 
-        wt::Assert(findResult != _layoutElements.end(), [&]()
+        wt::Assert(arrayNode.Offset + arrayNode.SizeInBytes == _sizeInBytes, [&]()
         {
-            return std::string("No such element \"").append(name).append("\" was found");
+            return std::string("Array \"").append(name).append("\" is not the last element in the layout");
         });
 
-        auto element = std::dynamic_pointer_cast<TElement, IElement>(findResult->second);
-
-        wt::Assert(element != nullptr, "Invalid element cast");
-
-        return element;
-    };
-
-    template<typename TElement>
-    requires std::derived_from<TElement, IElement>
-        const std::shared_ptr<TElement> Get(const std::string_view& name) const
-    {
-        wt::Assert(_layoutElements.empty() == false, [&]()
+        wt::Assert(arrayNode.ArrayElementType != DataType::Struct && arrayNode.Unsized == false, []()
         {
-            return std::string("Layout is empty");
+            return "Only sized scalar arrays can be resized";
         });
 
-        auto findResult = _layoutElements.find(name.data());
-
-        wt::Assert(findResult != _layoutElements.end(), [&]()
+        wt::Assert(elementCount >= 1, []()
         {
-            return std::string("No such element \"").append(name).append("\" was found");
+            return "Invalid array size";
         });
 
-        const auto element = std::dynamic_pointer_cast<TElement, IElement>(findResult->second);
-
-        wt::Assert(element != nullptr, "Invalid element cast");
 
-        return element;
-    };
+        arrayNode.ArrayElementCount = elementCount;
+        arrayNode.SizeInBytes = arrayNode.ArrayElementStride * elementCount;
 
+        _sizeInBytes = arrayNode.Offset + arrayNode.SizeInBytes;
 
-    constexpr std::size_t GetSizeInBytes() const
-    {
-        return _sizeInBytes;
+        if(_shadow != nullptr)
+            _shadow->Resize(_sizeInBytes);
     };
 
 
 private:
 
-    std::vector<std::pair<std::string, std::shared_ptr<IElement>>> CreateLayout(RawLayout& rawLayout, std::size_t offset = 0) const
+    /// <summary>
+    /// Lay out a raw node's children as children of a node in this layout
+    /// </summary>
+    /// <param name="rawArena"> The raw layout's arena </param>
+    /// <param name="rawParentIndex"> The raw node whose children are laid out </param>
+    /// <param name="parentIndex"> The node in this layout the children are added to </param>
+    /// <param name="currentOffset"> The offset the first child starts at, updated to the end of the last child </param>
+    void CreateLayout(const LayoutArena& rawArena, const std::uint32_t rawParentIndex, const std::uint32_t parentIndex, std::size_t& currentOffset)
     {
-        std::vector<std::pair<std::string, std::shared_ptr<IElement>>> layoutResult;
+        for(std::uint32_t rawIndex = rawArena[rawParentIndex].FirstChild; rawIndex != InvalidNodeIndex; rawIndex = rawArena[rawIndex].NextSibling)
+        {
+            const LayoutNode& rawNode = rawArena[rawIndex];
 
-        std::size_t currentOffset = offset;
+            const std::uint32_t index = _arena.AddNode(parentIndex, rawNode.Type, rawArena.GetName(rawIndex));
 
 
-        for(const auto& [name, element] : rawLayout._layoutElements)
-        {
-            if(element->GetElementType() == DataType::Array)
+            if(rawNode.Type == DataType::Array)
             {
-                auto arrayElement = std::dynamic_pointer_cast<ArrayElement, IElement>(element);
+                _arena[index].ArrayElementType = rawNode.ArrayElementType;
+                _arena[index].ArrayElementCount = rawNode.ArrayElementCount;
+                _arena[index].Unsized = rawNode.Unsized;
 
-                if(arrayElement->GetArrayElementType() == DataType::Struct)
+                if(rawNode.ArrayElementType == DataType::Struct)
                 {
-                    RawLayout rawArrayStructLayout;
-
-                    for(std::size_t i = 0; i < arrayElement->GetElementCount(); ++i)
+                    wt::Assert(rawNode.FirstChild != InvalidNodeIndex, []()
                     {
-                        auto rawStructLayout = std::dynamic_pointer_cast<StructElement, IElement>(rawArrayStructLayout.Add(DataType::Struct, std::string("[").append(std::to_string(i)).append("]")));
-
-                        auto structLayout = std::dynamic_pointer_cast<StructElement, IElement>(arrayElement->_arrayElements[0]);
+                        return "Struct array has no element type";
+                    });
 
-                        for(auto& [structElementName, structElement] : structLayout->_structElements)
-                        {
-                            rawStructLayout->Add(structElement->GetElementType(), structElementName);
-                        };
-                    };
+                    // Only the first element is laid out, every element has the same members at the same distance from its start,
+                    // so element i is the first one moved by i strides and an array costs the same however long it is
+                    const std::uint32_t firstStructIndex = _arena.AddNode(index, DataType::Struct, "[0]");
 
-                    const auto arrayStructLayout = CreateLayout(rawArrayStructLayout, currentOffset);
+                    CreateStructLayout(rawArena, rawNode.FirstChild, firstStructIndex, currentOffset);
 
+                    LayoutNode& arrayNode = _arena[index];
+                    const LayoutNode& firstStruct = _arena[firstStructIndex];
 
-                    arrayElement->_arrayElements.clear();
-
-                    for(auto& arrayStructElement : arrayStructLayout)
-                    {
-                        arrayElement->_arrayElements.emplace_back(arrayStructElement.second);
-                    };
+                    arrayNode.Offset = firstStruct.Offset;
+                    arrayNode.ArrayElementStride = firstStruct.SizeInBytes;
+                    arrayNode.SizeInBytes = arrayNode.ArrayElementStride * arrayNode.ArrayElementCount;
 
-                    const auto arrayStructLayoutEnd = std::prev((arrayStructLayout.cend()));
-                    currentOffset = arrayStructLayoutEnd->second->GetOffset() + arrayStructLayoutEnd->second->GetSizeInBytes();
+                    currentOffset = arrayNode.Offset + arrayNode.SizeInBytes;
                 }
                 else
                 {
-                    const std::size_t arrayElementSizeInBytes = DataTypeSizeInBytes(arrayElement->_arrayElementType);
-                    arrayElement->_offset = GetCorrectOffset(currentOffset, arrayElementSizeInBytes);
-                    arrayElement->_sizeInBytes = arrayElementSizeInBytes * arrayElement->_arrayElementCount;
+                    // std430 scalar arrays are aligned to, and strided by, their element's alignment,
+                    // so the offset of any element can be calculated instead of stored
+                    const std::size_t arrayElementAlignment = DataTypeAlignment(rawNode.ArrayElementType);
+                    const std::size_t arrayElementSizeInBytes = DataTypeSizeInBytes(rawNode.ArrayElementType);
 
-                    RawLayout rawArrayLayout;
+                    LayoutNode& arrayNode = _arena[index];
 
-                    for(std::size_t i = 0; i < arrayElement->_arrayElementCount; ++i)
-                    {
-                        rawArrayLayout.Add(arrayElement->_arrayElementType, std::string("[").append(std::to_string(i)).append("]"));
-                    };
-
-                    const auto arrayLayout = CreateLayout(rawArrayLayout, currentOffset);
-
-                    for(auto& arrayLayoutElement : arrayLayout)
-                    {
-                        arrayElement->_arrayElements.emplace_back(arrayLayoutElement.second);
-                    };
+                    arrayNode.Offset = AlignOffset(currentOffset, arrayElementAlignment);
+                    arrayNode.ArrayElementStride = AlignOffset(arrayElementSizeInBytes, arrayElementAlignment);
+                    arrayNode.SizeInBytes = arrayNode.ArrayElementStride * arrayNode.ArrayElementCount;
 
-                    const auto arrayLayoutEnd = std::prev((arrayLayout.cend()));
-                    currentOffset = arrayLayoutEnd->second->GetOffset() + arrayElementSizeInBytes;
+                    currentOffset = arrayNode.Offset + arrayNode.SizeInBytes;
                 };
-
-                layoutResult.emplace_back(std::make_pair(name, arrayElement));
             }
-            else if(element->GetElementType() == DataType::Struct)
+            else if(rawNode.Type == DataType::Struct)
+            {
+                CreateStructLayout(rawArena, rawIndex, index, currentOffset);
+            }
+            else
             {
-                auto elementAsStruct = std::dynamic_pointer_cast<StructElement, IElement>(element);
+                LayoutNode& node = _arena[index];
 
+                // Aligned to the type's own std430 alignment, a vec3 takes 16-byte alignment but only 12 bytes, and a vec2 never straddles 8 bytes
+                node.Offset = AlignOffset(currentOffset, DataTypeAlignment(node.Type));
+                currentOffset = node.Offset + node.SizeInBytes;
+            };
+        };
+    };
 
-                RawLayout rawStructLayout;
 
-                for(auto& [structElementName, structElement] : elementAsStruct->_structElements)
-                {
-                    rawStructLayout.Add(structElement->GetElementType(), structElementName);
-                };
+    void CreateStructLayout(const LayoutArena& rawArena, const std::uint32_t rawStructIndex, const std::uint32_t structIndex, std::size_t& currentOffset)
+    {
+        // TODO: Find a way to optimize struct size
 
-                // TODO: Find a way to optimize struct size 
+        // Calculate struct size by laying out the members from offset 0, then discard them
+        const std::uint32_t nodeCount = _arena.GetNodeCount();
 
-                // Calculate struct size
-                const auto structLayoutInitial = CreateLayout(rawStructLayout, 0);
+        std::size_t structSize = 0;
+        CreateLayout(rawArena, rawStructIndex, structIndex, structSize);
 
-                auto structLayoutEnd = std::prev(structLayoutInitial.end());
+        _arena.RemoveChildren(structIndex, nodeCount);
 
-                const std::size_t structSize = structLayoutEnd->second->GetOffset() + structLayoutEnd->second->GetSizeInBytes();
+        // std430 aligns a struct to its most aligned member, and pads its size to match
+        const std::size_t structAlignment = GetStructAlignment(rawArena, rawStructIndex);
 
+        _arena[structIndex].Offset = AlignOffset(currentOffset, structAlignment);
+        _arena[structIndex].SizeInBytes = AlignOffset(structSize, structAlignment);
 
-                elementAsStruct->_offset = GetCorrectOffset(currentOffset, structSize);
-                currentOffset = elementAsStruct->_offset;
+        currentOffset = _arena[structIndex].Offset;
 
-                elementAsStruct->_sizeInBytes = structSize;
+        CreateLayout(rawArena, rawStructIndex, structIndex, currentOffset);
 
+        currentOffset = _arena[structIndex].Offset + _arena[structIndex].SizeInBytes;
+    };
 
-                const auto structLayoutFinal = CreateLayout(rawStructLayout, currentOffset);
+    /// <summary>
+    /// The std430 alignment of a raw struct, the largest alignment of its members
+    /// </summary>
+    std::size_t GetStructAlignment(const LayoutArena& rawArena, const std::uint32_t rawStructIndex) const
+    {
+        std::size_t alignment = 4;
 
-                elementAsStruct->_structElements.clear();
+        for(std::uint32_t rawIndex = rawArena[rawStructIndex].FirstChild; rawIndex != InvalidNodeIndex; rawIndex = rawArena[rawIndex].NextSibling)
+        {
+            const LayoutNode& rawNode = rawArena[rawIndex];
 
-                for(auto& structLayoutElement : structLayoutFinal)
-                {
-                    elementAsStruct->_structElements.emplace_back(structLayoutElement);
-                };
+            if(rawNode.Type == DataType::Struct)
+                alignment = std::max(alignment, GetStructAlignment(rawArena, rawIndex));
+            else if(rawNode.Type == DataType::Array)
+                alignment = std::max(alignment, rawNode.ArrayElementType == DataType::Struct ? GetStructAlignment(rawArena, rawNode.FirstChild) : DataTypeAlignment(rawNode.ArrayElementType));
+            else
+                alignment = std::max(alignment, DataTypeAlignment(rawNode.Type));
+        };
 
-                structLayoutEnd = std::prev(structLayoutFinal.cend());
-                currentOffset = structLayoutEnd->second->GetOffset() + structLayoutEnd->second->GetSizeInBytes();
+        return alignment;
+    };
 
 
-                layoutResult.emplace_back(std::make_pair(name, elementAsStruct));
-            }
-            else
-            {
-                element->_offset = GetCorrectOffset(currentOffset, element->GetSizeInBytes());
-                currentOffset = element->GetOffset() + element->GetSizeInBytes();
+    /// <summary>
+    /// Round an offset up to a multiple of an alignment
+    /// </summary>
+    /// <param name="offset"></param>
+    /// <param name="alignment"></param>
+    /// <returns></returns>
+    constexpr std::size_t AlignOffset(std::size_t offset, std::size_t alignment) const
+    {
+        return (offset + (alignment - 1)) / alignment * alignment;
+    };
 
-                layoutResult.emplace_back(std::make_pair(name, element));
-            };
+};
 
 
-        };
 
-        return layoutResult;
-    };
+/// <summary>
+/// A finished layout that any number of buffers are written with. Immutable, so it can't be resized or shadowed,
+/// each buffer picks its own capacity through the layout's trailing unsized array, see SSBOLayout::GetSizeInBytes(count)
+/// </summary>
+using SharedSSBOLayout = std::shared_ptr<const SSBOLayout>;
 
 
-    constexpr std::size_t GetCorrectOffset(std::size_t offset, std::size_t sizeInBytes) const
+/// <summary>
+/// Builds each named layout once and hands the same definition to everything that asks for it again,
+/// so e.g. every text widget with the same block shares one layout tree rather than building its own. Not thread safe
+/// </summary>
+class SSBOLayoutRegistry
+{
+
+private:
+
+    std::unordered_map<std::string, SharedSSBOLayout, TransparentStringHash, std::equal_to<>> _layouts;
+
+
+public:
+
+    /// <summary>
+    /// The layout registered under a name, built by "describe" the first time it's asked for
+    /// </summary>
+    /// <param name="name"> The layout's name, usually its block's </param>
+    /// <param name="describe"> Adds the layout's elements to a RawLayout, only called if the layout wasn't built before </param>
+    template<typename TDescribe>
+    SharedSSBOLayout GetOrCreate(const std::string_view& name, TDescribe&& describe)
     {
-        const bool crossesBoundary = CrossesBoundary(offset, sizeInBytes);
+        const auto existing = _layouts.find(name);
 
-        if(crossesBoundary == true)
-        {
-            const std::size_t rawOffset = offset;
+        if(existing != _layouts.end())
+            return existing->second;
 
-            const std::size_t actualOffset = CalculateOffset(rawOffset);
+        RawLayout rawLayout;
 
-            const std::size_t padding = actualOffset - offset;
+        describe(rawLayout);
 
-            return actualOffset;
-        }
-        else
-        {
-            return offset;
-        };
+        SharedSSBOLayout layout = std::make_shared<const SSBOLayout>(rawLayout);
+
+        _layouts.emplace(std::string(name), layout);
+
+        return layout;
     };
 
-    constexpr std::size_t CalculateOffset(std::size_t rawOffset) const
+    /// <returns> The layout, or null if none was registered under the name </returns>
+    SharedSSBOLayout Find(const std::string_view& name) const
     {
-        const std::size_t correctedOffset = rawOffset + (16u - rawOffset % 16u) % 16u;
+        const auto existing = _layouts.find(name);
 
-        return correctedOffset;
+        return existing != _layouts.end() ? existing->second : nullptr;
     };
 
     /// <summary>
-    /// Check if an element crosses a 16-byte boundary
+    /// Forget every layout. Buffers that hold one keep it alive
     /// </summary>
-    /// <param name="offset"> </param>
-    /// <param name="size"></param>
-    /// <returns></returns>
-    constexpr bool CrossesBoundary(std::size_t offset, std::size_t sizeInBytes) const
+    void Clear()
     {
-        const std::size_t end = offset + sizeInBytes;
-
-        const std::size_t pageStart = offset / 16u;
-        const std::size_t pageEnd = end / 16u;
+        _layouts.clear();
+    };
 
-        return ((pageStart != pageEnd) && (end % 16 != 0u)) || (sizeInBytes > 16u);
+    std::size_t GetLayoutCount() const
+    {
+        return _layouts.size();
     };
 
 };
 
 
+/// <summary>
+/// Layouts shared across the application, only for the render thread
+/// </summary>
+inline SSBOLayoutRegistry SSBOLayouts;
+
+
 
 inline void SSBOTest()
 {
@@ -742,9 +1749,9 @@ inline void SSBOTest()
 
             SSBOLayout layout = SSBOLayout (rawLayout);
 
-            if(layout.Get<ScalarElement>("Uint_off_0")->GetOffset() != 0)
+            if(layout.Get<ScalarElement>("Uint_off_0").GetOffset() != 0)
                 __debugbreak();
-            if(layout.Get<ScalarElement>("Vec4_off_16")->GetOffset() != 16)
+            if(layout.Get<ScalarElement>("Vec4_off_16").GetOffset() != 16)
                 __debugbreak();
         };
 
@@ -762,15 +1769,15 @@ inline void SSBOTest()
 
             SSBOLayout layout = SSBOLayout (rawLayout);
 
-            if(layout.Get<ScalarElement>("Uint_off_0")->GetOffset() != 0)
+            if(layout.Get<ScalarElement>("Uint_off_0").GetOffset() != 0)
                 __debugbreak();
-            if(layout.Get<ScalarElement>("Uint_off_4")->GetOffset() != 4)
+            if(layout.Get<ScalarElement>("Uint_off_4").GetOffset() != 4)
                 __debugbreak();
-            if(layout.Get<ScalarElement>("Uint_off_8")->GetOffset() != 8)
+            if(layout.Get<ScalarElement>("Uint_off_8").GetOffset() != 8)
                 __debugbreak();
-            if(layout.Get<ScalarElement>("Uint_off_12")->GetOffset() != 12)
+            if(layout.Get<ScalarElement>("Uint_off_12").GetOffset() != 12)
                 __debugbreak();
-            if(layout.Get<ScalarElement>("Uint_off_16")->GetOffset() != 16)
+            if(layout.Get<ScalarElement>("Uint_off_16").GetOffset() != 16)
                 __debugbreak();
             int _ = 0;
         };
@@ -784,9 +1791,9 @@ inline void SSBOTest()
 
             SSBOLayout layout = SSBOLayout (rawLayout);
 
-            if(layout.Get<ScalarElement>("Vec2_off_0")->GetOffset() != 0)
+            if(layout.Get<ScalarElement>("Vec2_off_0").GetOffset() != 0)
                 __debugbreak();
-            if(layout.Get<ScalarElement>("Uint_off_8")->GetOffset() != 8)
+            if(layout.Get<ScalarElement>("Uint_off_8").GetOffset() != 8)
                 __debugbreak();
         };
 
@@ -799,9 +1806,32 @@ inline void SSBOTest()
 
             SSBOLayout layout = SSBOLayout (rawLayout);
 
-            if(layout.Get<ScalarElement>("Vec2_off_0")->GetOffset() != 0)
+            if(layout.Get<ScalarElement>("Vec2_off_0").GetOffset() != 0)
                 __debugbreak();
-            if(layout.Get<ScalarElement>("Vec2_off_8")->GetOffset() != 8)
+            if(layout.Get<ScalarElement>("Vec2_off_8").GetOffset() != 8)
+                __debugbreak();
+        };
+
+
+        // Vec3 - scalar in its last 4 bytes, packed types
+        {
+            RawLayout rawLayout;
+
+            rawLayout.Add<ScalarElement, DataType::Float>("Float_off_0");
+            rawLayout.Add<ScalarElement, DataType::Vec3f>("Vec3_off_16");
+            rawLayout.Add<ScalarElement, DataType::Unorm8x4>("Unorm_off_28");
+            rawLayout.Add<ScalarElement, DataType::Half2>("Half2_off_32");
+            rawLayout.Add<ScalarElement, DataType::Half4>("Half4_off_40");
+
+            SSBOLayout layout = SSBOLayout (rawLayout);
+
+            if(layout.Get<ScalarElement>("Vec3_off_16").GetOffset() != 16)
+                __debugbreak();
+            if(layout.Get<ScalarElement>("Unorm_off_28").GetOffset() != 28)
+                __debugbreak();
+            if(layout.Get<ScalarElement>("Half2_off_32").GetOffset() != 32)
+                __debugbreak();
+            if(layout.Get<ScalarElement>("Half4_off_40").GetOffset() != 40)
                 __debugbreak();
         };
 
@@ -812,7 +1842,7 @@ inline void SSBOTest()
 
             auto rawArrayElement = rawLayout.Add<ArrayElement, DataType::Array>("Uint_off_0");
 
-            rawArrayElement->SetArray(DataType::UInt32, 4);
+            rawArrayElement.SetArray(DataType::UInt32, 4);
 
             SSBOLayout layout = SSBOLayout(rawLayout);
 
@@ -820,16 +1850,16 @@ inline void SSBOTest()
 
             auto s = layout.Get<ArrayElement>("Uint_off_0");
 
-            if(layout.Get<ArrayElement>("Uint_off_0")->GetOffset() != 0)
+            if(layout.Get<ArrayElement>("Uint_off_0").GetOffset() != 0)
                 __debugbreak();
 
-            if(arrayElement->GetAtIndex<ScalarElement>(0)->GetOffset() != 0)
+            if(arrayElement.GetAtIndex<ScalarElement>(0).GetOffset() != 0)
                 __debugbreak();
-            if(arrayElement->GetAtIndex<ScalarElement>(1)->GetOffset() != 4)
+            if(arrayElement.GetAtIndex<ScalarElement>(1).GetOffset() != 4)
                 __debugbreak();
-            if(arrayElement->GetAtIndex<ScalarElement>(2)->GetOffset() != 8)
+            if(arrayElement.GetAtIndex<ScalarElement>(2).GetOffset() != 8)
                 __debugbreak();
-            if(arrayElement->GetAtIndex<ScalarElement>(3)->GetOffset() != 12)
+            if(arrayElement.GetAtIndex<ScalarElement>(3).GetOffset() != 12)
                 __debugbreak();
 
         };
@@ -840,7 +1870,7 @@ inline void SSBOTest()
 
             auto rawArrayElement = rawLayout.Add<ArrayElement, DataType::Array>("Uint_off_0");
 
-            rawArrayElement->SetArray(DataType::UInt32, 3);
+            rawArrayElement.SetArray(DataType::UInt32, 3);
 
             rawLayout.Add<ScalarElement, DataType::UInt32>("Uint_off_12");
 
@@ -848,17 +1878,17 @@ inline void SSBOTest()
 
             auto arrayElement = layout.Get<ArrayElement>("Uint_off_0");
 
-            if(layout.Get<ArrayElement>("Uint_off_0")->GetOffset() != 0)
+            if(layout.Get<ArrayElement>("Uint_off_0").GetOffset() != 0)
                 __debugbreak();
 
-            if(arrayElement->GetAtIndex<ScalarElement>(0)->GetOffset() != 0)
+            if(arrayElement.GetAtIndex<ScalarElement>(0).GetOffset() != 0)
                 __debugbreak();
-            if(arrayElement->GetAtIndex<ScalarElement>(1)->GetOffset() != 4)
+            if(arrayElement.GetAtIndex<ScalarElement>(1).GetOffset() != 4)
                 __debugbreak();
-            if(arrayElement->GetAtIndex<ScalarElement>(2)->GetOffset() != 8)
+            if(arrayElement.GetAtIndex<ScalarElement>(2).GetOffset() != 8)
                 __debugbreak();
 
-            if(layout.Get<ScalarElement>("Uint_off_12")->GetOffset() != 12)
+            if(layout.Get<ScalarElement>("Uint_off_12").GetOffset() != 12)
                 __debugbreak();
         };
 
@@ -871,24 +1901,24 @@ inline void SSBOTest()
 
             auto rawArrayElement = rawLayout.Add<ArrayElement, DataType::Array>("Array_off_16");
 
-            rawArrayElement->SetArray(DataType::Vec4f, 3);
+            rawArrayElement.SetArray(DataType::Vec4f, 3);
 
             SSBOLayout layout = SSBOLayout(rawLayout);
 
             auto arrayElement = layout.Get<ArrayElement>("Array_off_16");
 
 
-            if(layout.Get<ScalarElement>("Uint_off_0")->GetOffset() != 0)
+            if(layout.Get<ScalarElement>("Uint_off_0").GetOffset() != 0)
                 __debugbreak();
 
-            if(layout.Get<ArrayElement>("Array_off_16")->GetOffset() != 16)
+            if(layout.Get<ArrayElement>("Array_off_16").GetOffset() != 16)
                 __debugbreak();
 
-            if(arrayElement->GetAtIndex<ScalarElement>(0)->GetOffset() != 16)
+            if(arrayElement.GetAtIndex<ScalarElement>(0).GetOffset() != 16)
                 __debugbreak();
-            if(arrayElement->GetAtIndex<ScalarElement>(1)->GetOffset() != 32)
+            if(arrayElement.GetAtIndex<ScalarElement>(1).GetOffset() != 32)
                 __debugbreak();
-            if(arrayElement->GetAtIndex<ScalarElement>(2)->GetOffset() != 48)
+            if(arrayElement.GetAtIndex<ScalarElement>(2).GetOffset() != 48)
                 __debugbreak();
 
         };
@@ -902,8 +1932,8 @@ inline void SSBOTest()
 
             auto rawStructElement = structLayout.Add<StructElement, DataType::Struct>("Test_off_16");
 
-            rawStructElement->Add<ScalarElement, DataType::UInt32>("Test_Uint_off_16");
-            rawStructElement->Add<ScalarElement, DataType::Vec4f>("Test_Vec4_off_32");
+            rawStructElement.Add<ScalarElement, DataType::UInt32>("Test_Uint_off_16");
+            rawStructElement.Add<ScalarElement, DataType::Vec4f>("Test_Vec4_off_32");
 
             structLayout.Add<ScalarElement, DataType::UInt32>("Uint_off_48");
 
@@ -912,19 +1942,19 @@ inline void SSBOTest()
             auto structElement = layout.Get<StructElement>("Test_off_16");
 
 
-            if(layout.Get<ScalarElement>("Uint_off_0")->GetOffset() != 0)
+            if(layout.Get<ScalarElement>("Uint_off_0").GetOffset() != 0)
                 __debugbreak();
 
-            if(layout.Get<StructElement>("Test_off_16")->GetOffset() != 16)
+            if(layout.Get<StructElement>("Test_off_16").GetOffset() != 16)
                 __debugbreak();
 
-            if(structElement->Get<ScalarElement>("Test_Uint_off_16")->GetOffset() != 16)
+            if(structElement.Get<ScalarElement>("Test_Uint_off_16").GetOffset() != 16)
                 __debugbreak();
 
-            if(structElement->Get<ScalarElement>("Test_Vec4_off_32")->GetOffset() != 32)
+            if(structElement.Get<ScalarElement>("Test_Vec4_off_32").GetOffset() != 32)
                 __debugbreak();
 
-            if(layout.Get<ScalarElement>("Uint_off_48")->GetOffset() != 48)
+            if(layout.Get<ScalarElement>("Uint_off_48").GetOffset() != 48)
                 __debugbreak();
         };
 
@@ -937,14 +1967,14 @@ inline void SSBOTest()
 
             auto rawStructElement = structLayout.Add<StructElement, DataType::Struct>("Test_off_16");
 
-            rawStructElement->Add<ScalarElement, DataType::UInt32>("Test_Uint_off_16");
-            rawStructElement->Add<ScalarElement, DataType::Vec4f>("Test_Vec4_off_32");
+            rawStructElement.Add<ScalarElement, DataType::UInt32>("Test_Uint_off_16");
+            rawStructElement.Add<ScalarElement, DataType::Vec4f>("Test_Vec4_off_32");
 
 
             auto rawStructElement2 = structLayout.Add<StructElement, DataType::Struct>("Test2_off_48");
 
-            rawStructElement2->Add<ScalarElement, DataType::UInt32>("Test2_Uint_off_48");
-            rawStructElement2->Add<ScalarElement, DataType::Vec4f>("Test2_Mat4_off_64");
+            rawStructElement2.Add<ScalarElement, DataType::UInt32>("Test2_Uint_off_48");
+            rawStructElement2.Add<ScalarElement, DataType::Vec4f>("Test2_Mat4_off_64");
 
 
             SSBOLayout layout = SSBOLayout(structLayout);
@@ -953,25 +1983,25 @@ inline void SSBOTest()
             auto structElement2 = layout.Get<StructElement>("Test2_off_48");
 
 
-            if(layout.Get<ScalarElement>("Uint_off_0")->GetOffset() != 0)
+            if(layout.Get<ScalarElement>("Uint_off_0").GetOffset() != 0)
                 __debugbreak();
 
-            if(layout.Get<StructElement>("Test_off_16")->GetOffset() != 16)
+            if(layout.Get<StructElement>("Test_off_16").GetOffset() != 16)
                 __debugbreak();
 
-            if(structElement->Get<ScalarElement>("Test_Uint_off_16")->GetOffset() != 16)
+            if(structElement.Get<ScalarElement>("Test_Uint_off_16").GetOffset() != 16)
                 __debugbreak();
 
-            if(structElement->Get<ScalarElement>("Test_Vec4_off_32")->GetOffset() != 32)
+            if(structElement.Get<ScalarElement>("Test_Vec4_off_32").GetOffset() != 32)
                 __debugbreak();
 
-            if(layout.Get<StructElement>("Test2_off_48")->GetOffset() != 48)
+            if(layout.Get<StructElement>("Test2_off_48").GetOffset() != 48)
                 __debugbreak();
 
-            if(structElement2->Get<ScalarElement>("Test2_Uint_off_48")->GetOffset() != 48)
+            if(structElement2.Get<ScalarElement>("Test2_Uint_off_48").GetOffset() != 48)
                 __debugbreak();
 
-            if(structElement2->Get<ScalarElement>("Test2_Mat4_off_64")->GetOffset() != 64)
+            if(structElement2.Get<ScalarElement>("Test2_Mat4_off_64").GetOffset() != 64)
                 __debugbreak();
 
 
@@ -986,10 +2016,10 @@ inline void SSBOTest()
 
             auto rawArrayElement = structArrayLayout.Add<ArrayElement, DataType::Array>("Test_off_0");
 
-            auto arrayType = rawArrayElement->SetCustomArrayType(5);
+            auto arrayType = rawArrayElement.SetCustomArrayType(5);
 
-            arrayType->Add<ScalarElement, DataType::UInt32>("Test_Uint_off_0");
-            arrayType->Add<ScalarElement, DataType::Vec4f>("Test_Vec4_off_16");
+            arrayType.Add<ScalarElement, DataType::UInt32>("Test_Uint_off_0");
+            arrayType.Add<ScalarElement, DataType::Vec4f>("Test_Vec4_off_16");
 
 
             structArrayLayout.Add<ScalarElement, DataType::UInt32>("Uint_off_160");
@@ -999,23 +2029,23 @@ inline void SSBOTest()
 
             auto structArray = layout.Get<ArrayElement>("Test_off_0");
 
-            if(structArray->GetOffset() != 0)
+            if(structArray.GetOffset() != 0)
                 __debugbreak();
 
             for(std::size_t i = 0; i < 5; ++i)
             {
-                if(structArray->GetAtIndex<StructElement>(i)->GetOffset() != i * 32)
+                if(structArray.GetAtIndex<StructElement>(i).GetOffset() != i * 32)
                     __debugbreak();
 
 
-                if(structArray->GetAtIndex<StructElement>(i)->Get<ScalarElement>("Test_Uint_off_0")->GetOffset() != i * 32)
+                if(structArray.GetAtIndex<StructElement>(i).Get<ScalarElement>("Test_Uint_off_0").GetOffset() != i * 32)
                     __debugbreak();
 
-                if(structArray->GetAtIndex<StructElement>(i)->Get<ScalarElement>("Test_Vec4_off_16")->GetOffset() != (i * 32) + 16)
+                if(structArray.GetAtIndex<StructElement>(i).Get<ScalarElement>("Test_Vec4_off_16").GetOffset() != (i * 32) + 16)
                     __debugbreak();
             };
 
-            if(layout.Get<ScalarElement>("Uint_off_160")->GetOffset() != 160)
+            if(layout.Get<ScalarElement>("Uint_off_160").GetOffset() != 160)
                 __debugbreak();
 
         };
@@ -1029,10 +2059,10 @@ inline void SSBOTest()
 
             auto rawArrayElement = structArrayLayout.Add<ArrayElement, DataType::Array>("Test_off_16");
 
-            auto arrayType = rawArrayElement->SetCustomArrayType(5);
+            auto arrayType = rawArrayElement.SetCustomArrayType(5);
 
-            arrayType->Add<ScalarElement, DataType::UInt32>("Test_Uint_off_16");
-            arrayType->Add<ScalarElement, DataType::Vec4f>("Test_Vec4_off_32");
+            arrayType.Add<ScalarElement, DataType::UInt32>("Test_Uint_off_16");
+            arrayType.Add<ScalarElement, DataType::Vec4f>("Test_Vec4_off_32");
 
             structArrayLayout.Add<ScalarElement, DataType::UInt32>("Uint_off_176");
 
@@ -1041,25 +2071,54 @@ inline void SSBOTest()
 
             auto structArray = layout.Get<ArrayElement>("Test_off_16");
 
-            if(structArray->GetOffset() != 0)
+            if(structArray.GetOffset() != 16)
                 __debugbreak();
 
             for(std::size_t i = 0; i < 5; ++i)
             {
-                if(structArray->GetAtIndex<StructElement>(i)->GetOffset() != (i * 32) + 16)
+                if(structArray.GetAtIndex<StructElement>(i).GetOffset() != (i * 32) + 16)
                     __debugbreak();
 
 
-                if(structArray->GetAtIndex<StructElement>(i)->Get<ScalarElement>("Test_Uint_off_16")->GetOffset() != (i * 32) + 16)
+                if(structArray.GetAtIndex<StructElement>(i).Get<ScalarElement>("Test_Uint_off_16").GetOffset() != (i * 32) + 16)
                     __debugbreak();
 
-                if(structArray->GetAtIndex<StructElement>(i)->Get<ScalarElement>("Test_Vec4_off_32")->GetOffset() != ((i * 32) + 16) + 16)
+                if(structArray.GetAtIndex<StructElement>(i).Get<ScalarElement>("Test_Vec4_off_32").GetOffset() != ((i * 32) + 16) + 16)
                     __debugbreak();
             };
 
-            if(layout.Get<ScalarElement>("Uint_off_176")->GetOffset() != 176)
+            if(layout.Get<ScalarElement>("Uint_off_176").GetOffset() != 176)
+                __debugbreak();
+
+        };
+
+
+        // Array of structs holding an array of structs
+        {
+            RawLayout structArrayLayout;
+
+            auto outerType = structArrayLayout.Add<ArrayElement, DataType::Array>("Outer_off_0").SetCustomArrayType(1000);
+
+            outerType.Add<ScalarElement, DataType::UInt32>("Uint_off_0");
+
+            auto innerType = outerType.Add<ArrayElement, DataType::Array>("Inner_off_16").SetCustomArrayType(3);
+
+            innerType.Add<ScalarElement, DataType::Vec3f>("Vec3_off_16");
+            innerType.Add<ScalarElement, DataType::Float>("Float_off_28");
+
+            SSBOLayout layout = SSBOLayout(structArrayLayout);
+
+            const StructElement outer = layout.Get<ArrayElement>("Outer_off_0").GetAtIndex<StructElement>(999);
+            const StructElement inner = outer.Get<ArrayElement>("Inner_off_16").GetAtIndex<StructElement>(2);
+
+            if(outer.GetOffset() != 999 * 64)
                 __debugbreak();
 
+            if(inner.Get<ScalarElement>("Float_off_28").GetOffset() != (999 * 64) + 16 + (2 * 16) + 12)
+                __debugbreak();
+
+            if(layout.GetSizeInBytes() != 1000 * 64)
+                __debugbreak();
         };
 
 
@@ -1071,20 +2130,76 @@ inline void SSBOTest()
 
             auto rawStructElement = rawLayout.Add<StructElement, DataType::Struct>("Struct_off_4");
 
-            rawStructElement->Add < ScalarElement, DataType::UInt32>("Struct.Uint_off_4");
+            rawStructElement.Add < ScalarElement, DataType::UInt32>("Struct.Uint_off_4");
+
+            SSBOLayout layout = SSBOLayout(rawLayout);
+
+            if(layout.Get<ScalarElement>("Uint_off_0").GetOffset() != 0)
+                __debugbreak();
+
+            if(layout.Get<StructElement>("Struct_off_4").GetOffset() != 4)
+                __debugbreak();
+
+
+            if(layout.Get<StructElement>("Struct_off_4").Get<ScalarElement>("Struct.Uint_off_4").GetOffset() != 4)
+                __debugbreak();
+
+        };
+
+
+        // Shadow writes, touching and nearby ranges are merged
+        {
+            RawLayout rawLayout;
+
+            rawLayout.Add<ScalarElement, DataType::UInt32>("Uint_off_0");
+            rawLayout.Add<ScalarElement, DataType::UInt32>("Uint_off_4");
+            rawLayout.Add<ArrayElement, DataType::Array>("Array_off_16").SetArray(DataType::Vec4f, 64);
 
             SSBOLayout layout = SSBOLayout(rawLayout);
 
-            if(layout.Get<ScalarElement>("Uint_off_0")->GetOffset() != 0)
+            layout.EnableShadow(0);
+
+            const glm::vec4 first = glm::vec4(3.0f);
+
+            layout.Get<ScalarElement>("Uint_off_4").Set(layout.GetShadow(), 2u);
+            layout.Get<ScalarElement>("Uint_off_0").Set(layout.GetShadow(), 1u);
+            layout.GetHandle("Array_off_16").SetRange(layout.GetShadow(), 0, std::span<const glm::vec4>(&first, 1));
+            layout.Get<ArrayElement>("Array_off_16").GetAtIndex<ScalarElement>(63).Set(layout.GetShadow(), glm::vec4(4.0f));
+
+            if(layout.GetShadow().GetDirtyRangeCount() != 3)
                 __debugbreak();
 
-            if(layout.Get<StructElement>("Struct_off_4")->GetOffset() != 4)
+            std::vector<std::byte> mapped = std::vector<std::byte>(layout.GetSizeInBytes());
+
+            if(layout.GetShadow().Flush(mapped.data()) != 2)
+                __debugbreak();
+
+            if(std::memcmp(mapped.data(), layout.GetShadow().GetData().data(), mapped.size()) != 0)
                 __debugbreak();
+        };
 
+        // Shared layouts are only built once
+        {
+            SSBOLayoutRegistry registry;
+
+            std::size_t describeCount = 0;
+
+            const auto describe = [&describeCount](RawLayout& rawLayout)
+            {
+                rawLayout.Add<ScalarElement, DataType::UInt32>("Uint_off_0");
+                rawLayout.Add<ArrayElement, DataType::Array>("Array_off_16").SetUnsizedArray(DataType::Vec4f);
 
-            if(layout.Get<StructElement>("Struct_off_4")->Get<ScalarElement>("Struct.Uint_off_4")->GetOffset() != 4)
+                ++describeCount;
+            };
+
+            const SharedSSBOLayout first = registry.GetOrCreate("Test", describe);
+            const SharedSSBOLayout second = registry.GetOrCreate("Test", describe);
+
+            if(first != second || describeCount != 1 || registry.Find("Test") != first)
                 __debugbreak();
 
+            if(first->GetSizeInBytes(4) != 16 + (4 * 16))
+                __debugbreak();
         };
 
         int _ = 0;
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+
+/// <summary>
+/// A file built into the executable, see the EmbedAssets target in the project file
+/// </summary>
+struct EmbeddedAsset
+{
+    /// <summary>
+    /// The file's path relative to the project directory, with forward slashes, e.g. "Shaders/FontSpriteVertexShader.glsl"
+    /// </summary>
+    std::string_view Path;
+
+    /// <summary>
+    /// The file's contents. A zero follows the last byte, so text is also null-terminated
+    /// </summary>
+    std::span<const unsigned char> Bytes;
+
+
+    std::span<const std::byte> GetBytes() const
+    {
+        return std::as_bytes(Bytes);
+    };
+
+    std::string_view GetText() const
+    {
+        return std::string_view(reinterpret_cast<const char*>(Bytes.data()), Bytes.size());
+    };
+};
+
+
+// Release builds generate EmbeddedAssets, in the intermediate directory, from the EmbeddedAsset items of the project file.
+// Other builds read every file from disk as before
+#ifdef TEXT_RENDERER_EMBEDDED_ASSETS
+#include "EmbeddedAssets.generated.hpp"
+#else
+inline constexpr std::array<EmbeddedAsset, 0> EmbeddedAssets = { };
+#endif
+
+
+/// <summary>
+/// Find the embedded copy of a file, so it can be used without touching the filesystem
+/// </summary>
+/// <param name="path"> The file's path relative to the working directory, which is the project directory </param>
+/// <returns> Null if the file wasn't embedded </returns>
+inline const EmbeddedAsset* FindEmbeddedAsset(const std::filesystem::path& path)
+{
+    const std::string genericPath = path.lexically_normal().generic_string();
+
+    const auto asset = std::find_if(EmbeddedAssets.cbegin(), EmbeddedAssets.cend(), [&](const EmbeddedAsset& embeddedAsset)
+    {
+        return embeddedAsset.Path == genericPath;
+    });
+
+    return asset != EmbeddedAssets.cend() ? &*asset : nullptr;
+};
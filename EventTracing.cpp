@@ -0,0 +1,7 @@
+#include "EventTracing.hpp"
+
+
+// The provider's storage, declared by EventTracing.hpp. Defined once, here, since TraceLogging providers can't be defined in a header
+TRACELOGGING_DEFINE_PROVIDER(TextRendererTraceProvider,
+                             "OpenGL-TextRenderer",
+                             (0x52a7346b, 0xde5f, 0x5973, 0xa9, 0xfc, 0xa5, 0x74, 0x27, 0x12, 0x29, 0x1c));
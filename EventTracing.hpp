@@ -0,0 +1,215 @@
+#pragma once
+
+#include <Windows.h>
+#include <TraceLoggingProvider.h>
+#include <winmeta.h>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "WindowsUtilities.hpp"
+
+
+// "OpenGL-TextRenderer", {52a7346b-de5f-5973-a9fc-a5742712291c}. The GUID is the ETW hash of the name, so tools can enable the provider as "*OpenGL-TextRenderer".
+// Defined in EventTracing.cpp
+TRACELOGGING_DECLARE_PROVIDER(TextRendererTraceProvider);
+
+
+namespace WindowsUtilities
+{
+
+    /// <summary>
+    /// ETW events from the renderer, through a TraceLogging provider, for WPA and GPUView.
+    /// Events are timestamped by ETW with the same clock as the kernel's and the GPU scheduler's, so they line up with driver activity without any extra work.
+    /// Every function is a few instructions while nobody is listening, and no-ops before ProviderRegistration and after it's gone
+    /// </summary>
+    namespace EventTracing
+    {
+
+        /// <summary>
+        /// What a session can enable, events are filtered by these before their fields are evaluated
+        /// </summary>
+        enum Keyword : std::uint64_t
+        {
+            FrameKeyword = 0x1,
+
+            DrawKeyword = 0x2,
+
+            /// <summary>
+            /// GPU buffers growing
+            /// </summary>
+            MemoryKeyword = 0x4,
+
+            ShaderKeyword = 0x8,
+
+            TextureKeyword = 0x10,
+        };
+
+
+        /// <summary>
+        /// Registers the provider for the scope's lifetime, one per process, e.g. at the top of main
+        /// </summary>
+        class ProviderRegistration
+        {
+
+        public:
+
+            ProviderRegistration()
+            {
+                TraceLoggingRegister(TextRendererTraceProvider);
+            };
+
+            ProviderRegistration(const ProviderRegistration&) = delete;
+            ProviderRegistration& operator = (const ProviderRegistration&) = delete;
+
+            ~ProviderRegistration()
+            {
+                TraceLoggingUnregister(TextRendererTraceProvider);
+            };
+
+        };
+
+
+        /// <summary>
+        /// Whether a session is listening to a keyword, for events whose fields are costly to gather
+        /// </summary>
+        inline bool IsEnabled(const Keyword keyword)
+        {
+            return TraceLoggingProviderEnabled(TextRendererTraceProvider, WINEVENT_LEVEL_VERBOSE, keyword);
+        };
+
+
+        inline void FrameBegin(const std::uint64_t frameIndex)
+        {
+            TraceLoggingWrite(TextRendererTraceProvider, "Frame",
+                              TraceLoggingOpcode(WINEVENT_OPCODE_START),
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                              TraceLoggingKeyword(FrameKeyword),
+                              TraceLoggingUInt64(frameIndex, "FrameIndex"));
+        };
+
+        /// <param name="cpuMilliseconds"> From FrameBegin to the end of the frame's present </param>
+        inline void FrameEnd(const std::uint64_t frameIndex, const double cpuMilliseconds)
+        {
+            TraceLoggingWrite(TextRendererTraceProvider, "Frame",
+                              TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                              TraceLoggingKeyword(FrameKeyword),
+                              TraceLoggingUInt64(frameIndex, "FrameIndex"),
+                              TraceLoggingFloat64(cpuMilliseconds, "CPUMilliseconds"));
+        };
+
+        /// <summary>
+        /// Right before the buffers are swapped, the present GPUView shows follows it
+        /// </summary>
+        inline void Present(const std::uint64_t frameIndex)
+        {
+            TraceLoggingWrite(TextRendererTraceProvider, "Present",
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                              TraceLoggingKeyword(FrameKeyword),
+                              TraceLoggingUInt64(frameIndex, "FrameIndex"));
+        };
+
+
+        /// <param name="glyphCount"> The characters the draw laid out </param>
+        /// <param name="uploadedBytes"> Uploaded for the draw, its characters, spans and header </param>
+        inline void FontSpriteDraw(const std::uint64_t glyphCount, const std::uint64_t uploadedBytes)
+        {
+            TraceLoggingWrite(TextRendererTraceProvider, "FontSpriteDraw",
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                              TraceLoggingKeyword(DrawKeyword),
+                              TraceLoggingUInt64(glyphCount, "GlyphCount"),
+                              TraceLoggingUInt64(uploadedBytes, "UploadedBytes"));
+        };
+
+        /// <param name="buffer"> What grew, e.g. "FontSprite input" </param>
+        inline void BufferReallocation(const char* buffer, const std::uint64_t previousSizeInBytes, const std::uint64_t newSizeInBytes)
+        {
+            TraceLoggingWrite(TextRendererTraceProvider, "BufferReallocation",
+                              TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+                              TraceLoggingKeyword(MemoryKeyword),
+                              TraceLoggingString(buffer, "Buffer"),
+                              TraceLoggingUInt64(previousSizeInBytes, "PreviousSizeInBytes"),
+                              TraceLoggingUInt64(newSizeInBytes, "NewSizeInBytes"));
+        };
+
+
+        /// <summary>
+        /// A program was built from its sources, or loaded from the binary cache
+        /// </summary>
+        /// <param name="milliseconds"> Spent on the calling thread, an asynchronous compile finishes later, see ShaderProgramReady </param>
+        inline void ShaderProgramBuild(const std::string_view& vertexShaderPath, const std::string_view& fragmentShaderPath, const bool fromCache, const bool asynchronous, const double milliseconds)
+        {
+            TraceLoggingWrite(TextRendererTraceProvider, "ShaderProgramBuild",
+                              TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+                              TraceLoggingKeyword(ShaderKeyword),
+                              TraceLoggingCountedString(vertexShaderPath.data(), static_cast<std::uint16_t>(vertexShaderPath.size()), "VertexShader"),
+                              TraceLoggingCountedString(fragmentShaderPath.data(), static_cast<std::uint16_t>(fragmentShaderPath.size()), "FragmentShader"),
+                              TraceLoggingBool(fromCache, "FromCache"),
+                              TraceLoggingBool(asynchronous, "Asynchronous"),
+                              TraceLoggingFloat64(milliseconds, "Milliseconds"));
+        };
+
+        /// <summary>
+        /// An asynchronously built program was checked and is ready to draw with
+        /// </summary>
+        inline void ShaderProgramReady(const std::uint32_t programID)
+        {
+            TraceLoggingWrite(TextRendererTraceProvider, "ShaderProgramReady",
+                              TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+                              TraceLoggingKeyword(ShaderKeyword),
+                              TraceLoggingUInt32(programID, "ProgramID"));
+        };
+
+        /// <summary>
+        /// An atlas image was read and decoded, which needs no context
+        /// </summary>
+        inline void TextureDecode(const wchar_t* path, const std::uint32_t width, const std::uint32_t height, const double milliseconds)
+        {
+            TraceLoggingWrite(TextRendererTraceProvider, "TextureDecode",
+                              TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+                              TraceLoggingKeyword(TextureKeyword),
+                              TraceLoggingWideString(path, "Path"),
+                              TraceLoggingUInt32(width, "Width"),
+                              TraceLoggingUInt32(height, "Height"),
+                              TraceLoggingFloat64(milliseconds, "Milliseconds"));
+        };
+
+        /// <summary>
+        /// A decoded atlas was uploaded into a texture
+        /// </summary>
+        inline void TextureUpload(const std::uint32_t textureID, const std::uint64_t sizeInBytes, const double milliseconds)
+        {
+            TraceLoggingWrite(TextRendererTraceProvider, "TextureUpload",
+                              TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+                              TraceLoggingKeyword(TextureKeyword),
+                              TraceLoggingUInt32(textureID, "TextureID"),
+                              TraceLoggingUInt64(sizeInBytes, "SizeInBytes"),
+                              TraceLoggingFloat64(milliseconds, "Milliseconds"));
+        };
+
+
+        /// <summary>
+        /// A QueryPerformanceCounter reading, for the durations the events carry
+        /// </summary>
+        inline std::int64_t GetTime()
+        {
+            LARGE_INTEGER time;
+            QueryPerformanceCounter(&time);
+
+            return time.QuadPart;
+        };
+
+        inline double GetMillisecondsSince(const std::int64_t time)
+        {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+
+            return static_cast<double>(GetTime() - time) * 1000.0 / static_cast<double>(frequency.QuadPart);
+        };
+
+    };
+
+    namespace etw = EventTracing;
+
+};
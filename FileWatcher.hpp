@@ -0,0 +1,189 @@
+#pragma once
+
+#include <Windows.h>
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// Watches a directory for file changes on a background thread
+/// </summary>
+class FileWatcher
+{
+
+private:
+
+    std::filesystem::path _directory;
+
+    wt::SmartWin32Handle _directoryHandle = nullptr;
+
+    /// <summary>
+    /// Signaled to make the watcher thread exit
+    /// </summary>
+    wt::SmartWin32Handle _stopEvent = nullptr;
+
+
+    /// <summary>
+    /// The names of the files that changed since the last call to TakeChangedFiles, relative to the watched directory
+    /// </summary>
+    std::vector<std::filesystem::path> _changedFiles;
+
+    std::mutex _changedFilesMutex;
+
+
+    std::thread _watcherThread;
+
+
+public:
+
+    FileWatcher(const std::filesystem::path& directory) :
+        _directory(directory)
+    {
+        const HANDLE directoryHandle = CreateFileW(directory.c_str(),
+                                                   FILE_LIST_DIRECTORY,
+                                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                                   nullptr,
+                                                   OPEN_EXISTING,
+                                                   FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                                                   nullptr);
+
+        wt::Assert(directoryHandle != INVALID_HANDLE_VALUE, [&]()
+        {
+            return std::string("Unable to watch the directory \"").append(directory.string()).append("\"");
+        });
+
+        if(directoryHandle == INVALID_HANDLE_VALUE)
+            return;
+
+        _directoryHandle = directoryHandle;
+        _stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+        _watcherThread = std::thread(&FileWatcher::Watch, this);
+    };
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator = (const FileWatcher&) = delete;
+
+    ~FileWatcher()
+    {
+        if(_watcherThread.joinable() == false)
+            return;
+
+        SetEvent(_stopEvent);
+
+        _watcherThread.join();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Get, and clear, the list of files that changed
+    /// </summary>
+    /// <returns></returns>
+    std::vector<std::filesystem::path> TakeChangedFiles()
+    {
+        std::vector<std::filesystem::path> changedFiles;
+
+        const std::lock_guard lock = std::lock_guard(_changedFilesMutex);
+
+        changedFiles.swap(_changedFiles);
+
+        return changedFiles;
+    };
+
+
+    const std::filesystem::path& GetDirectory() const
+    {
+        return _directory;
+    };
+
+
+private:
+
+    void Watch()
+    {
+        wt::SmartWin32Handle changeEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+        // ReadDirectoryChangesW requires a DWORD aligned buffer
+        alignas(DWORD) std::array<std::byte, 16 * 1024> changeBuffer {};
+
+        while(true)
+        {
+            OVERLAPPED overlapped {};
+            overlapped.hEvent = changeEvent;
+
+            ResetEvent(changeEvent);
+
+            const BOOL readResult = ReadDirectoryChangesW(_directoryHandle,
+                                                          changeBuffer.data(),
+                                                          static_cast<DWORD>(changeBuffer.size()),
+                                                          FALSE,
+                                                          FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                                                          nullptr,
+                                                          &overlapped,
+                                                          nullptr);
+
+            if(readResult == FALSE)
+                return;
+
+
+            const HANDLE waitHandles[] = { changeEvent, _stopEvent };
+
+            const DWORD waitResult = WaitForMultipleObjects(2, waitHandles, FALSE, INFINITE);
+
+            // Stop requested, the pending read has to be cancelled before the buffer goes out of scope
+            if(waitResult != WAIT_OBJECT_0)
+            {
+                CancelIo(_directoryHandle);
+
+                DWORD bytesTransferred = 0;
+                GetOverlappedResult(_directoryHandle, &overlapped, &bytesTransferred, TRUE);
+
+                return;
+            };
+
+
+            DWORD bytesTransferred = 0;
+            GetOverlappedResult(_directoryHandle, &overlapped, &bytesTransferred, FALSE);
+
+            // The buffer overflowed, changes were lost but there's nothing to report
+            if(bytesTransferred == 0)
+                continue;
+
+            ReadChanges(changeBuffer.data());
+        };
+    };
+
+
+    /// <summary>
+    /// Add every file in a FILE_NOTIFY_INFORMATION chain to the changed files list
+    /// </summary>
+    /// <param name="changeBuffer"></param>
+    void ReadChanges(const std::byte* changeBuffer)
+    {
+        const std::lock_guard lock = std::lock_guard(_changedFilesMutex);
+
+        const std::byte* currentEntry = changeBuffer;
+
+        while(true)
+        {
+            const FILE_NOTIFY_INFORMATION* notifyInformation = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(currentEntry);
+
+            _changedFiles.emplace_back(std::wstring(notifyInformation->FileName, notifyInformation->FileNameLength / sizeof(wchar_t)));
+
+            if(notifyInformation->NextEntryOffset == 0)
+                break;
+
+            currentEntry += notifyInformation->NextEntryOffset;
+        };
+    };
+
+};
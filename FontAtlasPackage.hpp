@@ -0,0 +1,328 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "GlyphMetrics.hpp"
+#include "MappedFile.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// How a font atlas package's pixels are stored, always in the format they're uploaded in
+/// </summary>
+enum class FontAtlasPixelFormat : std::uint32_t
+{
+    /// <summary>
+    /// One byte per pixel, coverage or distance
+    /// </summary>
+    R8 = 0,
+
+    RGBA8 = 1,
+
+    BGRA8 = 2,
+
+    /// <summary>
+    /// Single channel 4x4 blocks of 8 bytes each, coverage or distance. Decompressed at load time where BC4 can't be sampled
+    /// </summary>
+    BC4 = 3,
+};
+
+
+/// <summary>
+/// Flags of a font atlas package
+/// </summary>
+enum class FontAtlasFlags : std::uint32_t
+{
+    None = 0,
+
+    /// <summary>
+    /// The single channel pixels are a signed distance field rather than coverage
+    /// </summary>
+    DistanceField = 1 << 0,
+
+    /// <summary>
+    /// The RGBA8 pixels are per-subpixel coverage, see GenerateSubpixelCoverage
+    /// </summary>
+    Subpixel = 1 << 1,
+};
+
+
+/// <summary>
+/// A kerning adjustment between two characters
+/// </summary>
+struct KerningPair
+{
+    std::uint32_t First = 0;
+    std::uint32_t Second = 0;
+
+    /// <summary>
+    /// Added to the first character's advance when it's followed by the second, in pixels
+    /// </summary>
+    float Adjustment = 0.0f;
+
+    std::uint32_t Padding = 0;
+};
+
+static_assert(sizeof(KerningPair) == 16, "KerningPair is part of the package format");
+
+
+/// <summary>
+/// The start of a ".fontatlas" package. Every section is 16 byte aligned, at the offsets given here
+/// </summary>
+struct FontAtlasHeader
+{
+    std::uint32_t Magic;
+    std::uint32_t Version;
+
+    FontAtlasPixelFormat PixelFormat;
+    FontAtlasFlags Flags;
+
+    std::uint32_t Width;
+    std::uint32_t Height;
+
+    std::uint32_t GlyphWidth;
+    std::uint32_t GlyphHeight;
+
+    std::uint32_t GlyphCount;
+    std::uint32_t KerningPairCount;
+
+    /// <summary>
+    /// GlyphCount GlyphMetrics, indexed by glyph
+    /// </summary>
+    std::uint64_t MetricsOffset;
+
+    /// <summary>
+    /// KerningPairCount KerningPairs, sorted by First then Second
+    /// </summary>
+    std::uint64_t KerningOffset;
+
+    /// <summary>
+    /// Tightly packed rows, top row first
+    /// </summary>
+    std::uint64_t PixelsOffset;
+    std::uint64_t PixelsSizeInBytes;
+};
+
+static_assert(sizeof(FontAtlasHeader) == 72, "FontAtlasHeader is part of the package format");
+
+
+/// <summary>
+/// The number of bytes a package's pixels take for a format
+/// </summary>
+inline std::uint64_t GetFontAtlasPixelsSizeInBytes(const FontAtlasPixelFormat pixelFormat, const std::uint32_t width, const std::uint32_t height)
+{
+    const std::uint64_t pixelCount = static_cast<std::uint64_t>(width) * height;
+
+    switch(pixelFormat)
+    {
+        case FontAtlasPixelFormat::R8:
+            return pixelCount;
+
+        case FontAtlasPixelFormat::BC4:
+            return ((static_cast<std::uint64_t>(width) + 3) / 4) * ((static_cast<std::uint64_t>(height) + 3) / 4) * 8;
+
+        default:
+            return pixelCount * 4;
+    };
+};
+
+
+/// <summary>
+/// A pre-baked font atlas: the glyph metrics, kerning table, and pixels already in the format the GPU samples.
+/// The file is mapped, and the pixels are uploaded straight out of the mapping. Packages built into the executable are read in place. See WriteFontAtlasPackage
+/// </summary>
+class FontAtlasPackage
+{
+
+public:
+
+    static constexpr std::uint32_t Magic = 0x4C544146; // "FATL"
+
+    static constexpr std::uint32_t Version = 1;
+
+    static constexpr std::wstring_view Extension = L".fontatlas";
+
+
+private:
+
+    /// <summary>
+    /// Null if the package is in memory
+    /// </summary>
+    std::shared_ptr<const MappedFile> _file;
+
+    std::span<const std::byte> _bytes;
+
+    FontAtlasHeader _header = { };
+
+    bool _valid = false;
+
+
+public:
+
+    FontAtlasPackage(const std::filesystem::path& path) :
+        FontAtlasPackage(std::make_shared<const MappedFile>(path), path)
+    {
+    };
+
+    /// <summary>
+    /// Read a package out of a file that's already mapped
+    /// </summary>
+    /// <param name="path"> The file's path, for error messages </param>
+    FontAtlasPackage(std::shared_ptr<const MappedFile> file, const std::filesystem::path& path) :
+        _file(std::move(file)),
+        _bytes(_file->GetBytes())
+    {
+        Validate(path);
+    };
+
+    /// <summary>
+    /// Read a package that's already in memory, e.g. an EmbeddedAsset
+    /// </summary>
+    /// <param name="bytes"> Must outlive the package </param>
+    /// <param name="path"> Where the package came from, for error messages </param>
+    FontAtlasPackage(const std::span<const std::byte>& bytes, const std::filesystem::path& path) :
+        _bytes(bytes)
+    {
+        Validate(path);
+    };
+
+
+public:
+
+    bool IsValid() const
+    {
+        return _valid;
+    };
+
+    const FontAtlasHeader& GetHeader() const
+    {
+        return _header;
+    };
+
+    bool IsDistanceField() const
+    {
+        return (static_cast<std::uint32_t>(_header.Flags) & static_cast<std::uint32_t>(FontAtlasFlags::DistanceField)) != 0;
+    };
+
+    bool IsSubpixel() const
+    {
+        return (static_cast<std::uint32_t>(_header.Flags) & static_cast<std::uint32_t>(FontAtlasFlags::Subpixel)) != 0;
+    };
+
+
+    std::vector<GlyphMetrics> ReadGlyphMetrics() const
+    {
+        std::vector<GlyphMetrics> metrics = std::vector<GlyphMetrics>(_valid == true ? _header.GlyphCount : 0);
+
+        std::memcpy(metrics.data(), _bytes.data() + _header.MetricsOffset, metrics.size() * sizeof(GlyphMetrics));
+
+        return metrics;
+    };
+
+    std::vector<KerningPair> ReadKerningPairs() const
+    {
+        std::vector<KerningPair> kerningPairs = std::vector<KerningPair>(_valid == true ? _header.KerningPairCount : 0);
+
+        std::memcpy(kerningPairs.data(), _bytes.data() + _header.KerningOffset, kerningPairs.size() * sizeof(KerningPair));
+
+        return kerningPairs;
+    };
+
+    /// <summary>
+    /// The pixels, in place in the mapped file or the memory. Only valid while the package exists
+    /// </summary>
+    std::span<const std::byte> GetPixels() const
+    {
+        if(_valid == false)
+            return { };
+
+        return _bytes.subspan(static_cast<std::size_t>(_header.PixelsOffset), static_cast<std::size_t>(_header.PixelsSizeInBytes));
+    };
+
+
+private:
+
+    void Validate(const std::filesystem::path& path)
+    {
+        if(_bytes.size() >= sizeof(FontAtlasHeader))
+            std::memcpy(&_header, _bytes.data(), sizeof(FontAtlasHeader));
+
+        const std::uint64_t packageSize = _bytes.size();
+
+        const auto sectionFits = [&](const std::uint64_t offset, const std::uint64_t sizeInBytes)
+        {
+            return offset <= packageSize && sizeInBytes <= packageSize - offset;
+        };
+
+        _valid = _header.Magic == Magic &&
+                 _header.Version == Version &&
+                 _header.PixelFormat <= FontAtlasPixelFormat::BC4 &&
+                 _header.PixelsSizeInBytes == GetFontAtlasPixelsSizeInBytes(_header.PixelFormat, _header.Width, _header.Height) &&
+                 sectionFits(_header.MetricsOffset, static_cast<std::uint64_t>(_header.GlyphCount) * sizeof(GlyphMetrics)) &&
+                 sectionFits(_header.KerningOffset, static_cast<std::uint64_t>(_header.KerningPairCount) * sizeof(KerningPair)) &&
+                 sectionFits(_header.PixelsOffset, _header.PixelsSizeInBytes);
+
+        wt::Assert(_valid, [&]()
+        {
+            return std::string("\"").append(path.string()).append("\" is not a valid font atlas package");
+        });
+    };
+
+};
+
+
+/// <summary>
+/// Write a font atlas package
+/// </summary>
+/// <param name="header"> The package's description, the magic, version, counts and offsets are filled in </param>
+/// <param name="kerningPairs"> Must be sorted by First then Second </param>
+inline void WriteFontAtlasPackage(std::ostream& stream,
+                                  FontAtlasHeader header,
+                                  const std::span<const GlyphMetrics> glyphMetrics,
+                                  const std::span<const KerningPair> kerningPairs,
+                                  const std::span<const std::byte> pixels)
+{
+    const auto alignSection = [](const std::uint64_t offset)
+    {
+        return (offset + 15) & ~std::uint64_t { 15 };
+    };
+
+    header.Magic = FontAtlasPackage::Magic;
+    header.Version = FontAtlasPackage::Version;
+
+    header.GlyphCount = static_cast<std::uint32_t>(glyphMetrics.size());
+    header.KerningPairCount = static_cast<std::uint32_t>(kerningPairs.size());
+
+    header.MetricsOffset = alignSection(sizeof(FontAtlasHeader));
+    header.KerningOffset = alignSection(header.MetricsOffset + glyphMetrics.size_bytes());
+    header.PixelsOffset = alignSection(header.KerningOffset + kerningPairs.size_bytes());
+    header.PixelsSizeInBytes = pixels.size_bytes();
+
+
+    std::uint64_t position = 0;
+
+    const auto writeSection = [&](const std::uint64_t offset, const void* data, const std::size_t sizeInBytes)
+    {
+        constexpr char padding[16] = { };
+
+        stream.write(padding, static_cast<std::streamsize>(offset - position));
+        stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(sizeInBytes));
+
+        position = offset + sizeInBytes;
+    };
+
+    writeSection(0, &header, sizeof(header));
+    writeSection(header.MetricsOffset, glyphMetrics.data(), glyphMetrics.size_bytes());
+    writeSection(header.KerningOffset, kerningPairs.data(), kerningPairs.size_bytes());
+    writeSection(header.PixelsOffset, pixels.data(), pixels.size_bytes());
+};
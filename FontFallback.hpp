@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "CodepointGlyphTable.hpp"
+#include "FontManager.hpp"
+#include "FontSet.hpp"
+#include "GlyphAtlas.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// An ordered list of fonts where codepoints the primary font has no glyph for are drawn from the first font after it that has one.
+/// Every codepoint is resolved once, the result is cached as a font index and glyph index in a CodepointGlyphTable,
+/// so text in mixed scripts costs a table lookup per character and still draws through one FontSet, in a single draw.
+/// Resolving modifies the table, so it happens as strings are submitted, laying them out only looks codepoints up, see TextBatch
+/// </summary>
+class FontFallbackChain
+{
+
+public:
+
+    /// <summary>
+    /// A codepoint's resolved glyph
+    /// </summary>
+    struct ResolvedGlyph
+    {
+        /// <summary>
+        /// The index of the font in the chain, and in its FontSet
+        /// </summary>
+        std::uint32_t FontIndex = 0;
+
+        /// <summary>
+        /// The glyph's index in its font's metrics, not in the set's combined ones
+        /// </summary>
+        std::uint32_t GlyphIndex = 0;
+    };
+
+
+private:
+
+    /// <summary>
+    /// The fonts, in fallback order. Holding their handles keeps them loaded for as long as the chain exists
+    /// </summary>
+    std::vector<FontHandle> _fonts;
+
+    FontSet _fontSet;
+
+    /// <summary>
+    /// Every resolved codepoint's font index in the high FontIndexBits bits and glyph index in the rest
+    /// </summary>
+    CodepointGlyphTable _resolvedGlyphs = CodepointGlyphTable(Unresolved);
+
+    std::size_t _resolvedCount = 0;
+
+
+public:
+
+    static constexpr std::uint32_t FontIndexBits = 8;
+
+    static constexpr std::uint32_t GlyphIndexBits = 32 - FontIndexBits;
+
+
+public:
+
+    /// <param name="fonts"> The primary font first, then its fallbacks in the order they're tried. Loaded, e.g. by a FontManager, and in the Coverage format </param>
+    /// <param name="allowBindless"> See FontSet </param>
+    FontFallbackChain(const std::initializer_list<FontHandle> fonts, const bool allowBindless = true) :
+        _fonts(fonts),
+        _fontSet(GetSprites(_fonts), allowBindless)
+    {
+        wt::Assert(_fonts.size() <= (1u << FontIndexBits), "Too many fonts in a fallback chain");
+    };
+
+    FontFallbackChain(const FontFallbackChain&) = delete;
+    FontFallbackChain& operator = (const FontFallbackChain&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Resolve every codepoint of a UTF-8 string that wasn't resolved before
+    /// </summary>
+    void Prepare(const std::string_view& text)
+    {
+        ForEachCodepoint(text, [this](const char32_t codepoint)
+        {
+            if(codepoint >= 32)
+                Resolve(codepoint);
+        });
+    };
+
+    /// <summary>
+    /// A codepoint's glyph, resolving it if it wasn't resolved before. Codepoints no font has a glyph for are drawn as the primary font's fallback glyph
+    /// </summary>
+    ResolvedGlyph Resolve(const char32_t codepoint)
+    {
+        std::uint32_t resolved = _resolvedGlyphs.Find(codepoint);
+
+        if(resolved == Unresolved)
+        {
+            resolved = Pack(0, _fonts.front()->GetGlyphIndex(codepoint));
+
+            for(std::uint32_t fontIndex = 0; fontIndex < _fonts.size(); ++fontIndex)
+            {
+                if(_fonts[fontIndex]->HasGlyph(codepoint) == true)
+                {
+                    resolved = Pack(fontIndex, _fonts[fontIndex]->GetGlyphIndex(codepoint));
+                    break;
+                };
+            };
+
+            _resolvedGlyphs.Set(codepoint, resolved);
+
+            ++_resolvedCount;
+        };
+
+        return Unpack(resolved);
+    };
+
+    /// <summary>
+    /// Look up a codepoint resolved by Prepare or Resolve. Doesn't modify the chain, so it can be called from any number of threads at once
+    /// </summary>
+    ResolvedGlyph Find(const char32_t codepoint) const
+    {
+        const std::uint32_t resolved = _resolvedGlyphs.Find(codepoint);
+
+        WT_ASSERT(resolved != Unresolved, "Codepoint looked up before it was resolved");
+
+        return Unpack(resolved);
+    };
+
+    /// <summary>
+    /// Forget every resolution, e.g. once a font's atlas was reloaded with different glyphs
+    /// </summary>
+    void Clear()
+    {
+        _resolvedGlyphs.Clear();
+
+        _resolvedCount = 0;
+    };
+
+
+public:
+
+    /// <summary>
+    /// The set every font of the chain is drawn through, font indices match the chain's
+    /// </summary>
+    const FontSet& GetFontSet() const
+    {
+        return _fontSet;
+    };
+
+    const FontSprite& GetFont(const std::uint32_t fontIndex) const
+    {
+        return *_fonts[fontIndex];
+    };
+
+    std::size_t GetFontCount() const
+    {
+        return _fonts.size();
+    };
+
+    /// <summary>
+    /// The number of codepoints resolved since the last Clear
+    /// </summary>
+    std::size_t GetResolvedCount() const
+    {
+        return _resolvedCount;
+    };
+
+
+private:
+
+    static constexpr std::uint32_t Unresolved = std::numeric_limits<std::uint32_t>::max();
+
+    static std::uint32_t Pack(const std::uint32_t fontIndex, const std::uint32_t glyphIndex)
+    {
+        WT_ASSERT(glyphIndex < (1u << GlyphIndexBits), "Glyph index doesn't fit in a resolved glyph");
+
+        return (fontIndex << GlyphIndexBits) | glyphIndex;
+    };
+
+    static ResolvedGlyph Unpack(const std::uint32_t resolved)
+    {
+        return ResolvedGlyph
+        {
+            .FontIndex = resolved >> GlyphIndexBits,
+            .GlyphIndex = resolved & ((1u << GlyphIndexBits) - 1),
+        };
+    };
+
+    static std::vector<const FontSprite*> GetSprites(const std::vector<FontHandle>& fonts)
+    {
+        wt::Assert(fonts.empty() == false, "A font fallback chain needs at least one font");
+
+        std::vector<const FontSprite*> sprites;
+
+        for(const FontHandle& font : fonts)
+        {
+            sprites.push_back(font.get());
+        };
+
+        return sprites;
+    };
+
+};
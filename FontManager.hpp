@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FontSprite.hpp"
+#include "ShaderProgram.hpp"
+#include "TextureLoader.hpp"
+#include "UploadWorker.hpp"
+
+
+/// <summary>
+/// A loaded font, shared by everything that draws in it. Text is drawn through instances of it, see FontSprite's instance constructor,
+/// which keep the atlas alive on their own
+/// </summary>
+using FontHandle = std::shared_ptr<const FontSprite>;
+
+
+/// <summary>
+/// What a FontManager caches fonts by, fonts that differ in any of these are loaded separately
+/// </summary>
+struct FontKey
+{
+    std::wstring TexturePath;
+
+    std::uint32_t GlyphWidth = 0;
+    std::uint32_t GlyphHeight = 0;
+
+    AtlasFormat Format = AtlasFormat::ChromaKeyedRGBA;
+
+    bool GenerateMipmaps = false;
+
+    /// <summary>
+    /// Fonts look their uniforms up in the program they're drawn with
+    /// </summary>
+    const ShaderProgram* Program = nullptr;
+
+
+    auto operator <=> (const FontKey&) const = default;
+};
+
+
+/// <summary>
+/// Loads every font atlas once. Fonts are cached by FontKey and handed out as FontHandles,
+/// a font stays cached for as long as a handle to it is held, and is loaded again after the last one is dropped.
+/// Only for the thread that owns the context
+/// </summary>
+class FontManager
+{
+
+private:
+
+    struct PendingFont
+    {
+        FontKey Key;
+
+        std::shared_ptr<FontSprite> Font;
+
+        std::promise<FontHandle> Loaded;
+
+        std::shared_future<FontHandle> Future;
+    };
+
+    std::map<FontKey, std::weak_ptr<const FontSprite>> _fonts;
+
+    /// <summary>
+    /// Fonts whose atlases are still loading on the upload worker, resolved by Update
+    /// </summary>
+    std::vector<PendingFont> _pendingFonts;
+
+    const ITextureLoader* _textureLoader = nullptr;
+
+    UploadWorker* _uploadWorker = nullptr;
+
+    std::size_t _loadCount = 0;
+
+
+public:
+
+    /// <param name="textureLoader"> Decodes font images, the default loader if null </param>
+    /// <param name="uploadWorker"> Loads atlases for LoadAsync, which loads synchronously without one </param>
+    FontManager(const ITextureLoader* textureLoader = nullptr, UploadWorker* uploadWorker = nullptr) :
+        _textureLoader(textureLoader),
+        _uploadWorker(uploadWorker)
+    {
+    };
+
+    FontManager(const FontManager&) = delete;
+    FontManager& operator = (const FontManager&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Get a font, loading its atlas if it isn't cached. If the font is still loading asynchronously this waits for it
+    /// </summary>
+    FontHandle Load(const FontKey& key)
+    {
+        const auto pendingFont = FindPending(key);
+
+        if(pendingFont != _pendingFonts.end())
+        {
+            pendingFont->Font->WaitUntilReady();
+
+            return Resolve(pendingFont);
+        };
+
+        if(FontHandle font = Find(key); font != nullptr)
+            return font;
+
+        const std::shared_ptr<FontSprite> font = LoadFont(key, nullptr);
+
+        _fonts[key] = font;
+
+        return font;
+    };
+
+    /// <summary>
+    /// Get a font, loading its atlas on the upload worker if it isn't cached.
+    /// The future is ready once the atlas is, during the Update that adopts it
+    /// </summary>
+    std::shared_future<FontHandle> LoadAsync(const FontKey& key)
+    {
+        const auto pendingFont = FindPending(key);
+
+        if(pendingFont != _pendingFonts.end())
+            return pendingFont->Future;
+
+        if(FontHandle font = Find(key); font != nullptr || _uploadWorker == nullptr)
+        {
+            std::promise<FontHandle> loaded;
+
+            loaded.set_value(font != nullptr ? std::move(font) : Load(key));
+
+            return loaded.get_future().share();
+        };
+
+
+        PendingFont& newFont = _pendingFonts.emplace_back(PendingFont
+        {
+            .Key = key,
+            .Font = LoadFont(key, _uploadWorker),
+        });
+
+        newFont.Future = newFont.Loaded.get_future().share();
+
+        _fonts[key] = newFont.Font;
+
+        return newFont.Future;
+    };
+
+    /// <summary>
+    /// Adopt the atlases that finished loading and resolve their futures, should be called once per frame
+    /// </summary>
+    /// <returns> The number of fonts that became ready </returns>
+    std::size_t Update()
+    {
+        std::size_t readyCount = 0;
+
+        for(std::size_t index = 0; index < _pendingFonts.size();)
+        {
+            FontSprite& font = *_pendingFonts[index].Font;
+
+            font.Update();
+
+            if(font.IsReady() == false)
+            {
+                ++index;
+                continue;
+            };
+
+            // The next font moves into its place
+            Resolve(_pendingFonts.begin() + static_cast<std::ptrdiff_t>(index));
+
+            ++readyCount;
+        };
+
+        // Fonts nobody holds anymore
+        std::erase_if(_fonts, [](const auto& font)
+        {
+            return font.second.expired() == true;
+        });
+
+        return readyCount;
+    };
+
+
+public:
+
+    /// <summary>
+    /// A cached font, or null if it isn't loaded or is still loading
+    /// </summary>
+    FontHandle Find(const FontKey& key) const
+    {
+        const auto font = _fonts.find(key);
+
+        if(font == _fonts.cend())
+            return nullptr;
+
+        FontHandle handle = font->second.lock();
+
+        if(handle == nullptr || handle->IsReady() == false)
+            return nullptr;
+
+        return handle;
+    };
+
+    /// <summary>
+    /// The number of atlases loaded since construction, a font that's requested again while it's cached doesn't count
+    /// </summary>
+    std::size_t GetLoadCount() const
+    {
+        return _loadCount;
+    };
+
+    std::size_t GetPendingCount() const
+    {
+        return _pendingFonts.size();
+    };
+
+
+private:
+
+    std::shared_ptr<FontSprite> LoadFont(const FontKey& key, UploadWorker* uploadWorker)
+    {
+        wt::Assert(key.Program != nullptr, "A font needs the program it's drawn with");
+
+        ++_loadCount;
+
+        return std::make_shared<FontSprite>(key.GlyphWidth, key.GlyphHeight, *key.Program, key.TexturePath, 32, SSBOMode::SubData, CharacterPacking::Bits32,
+                                            key.Format, key.GenerateMipmaps, _textureLoader, uploadWorker);
+    };
+
+    std::vector<PendingFont>::iterator FindPending(const FontKey& key)
+    {
+        return std::find_if(_pendingFonts.begin(), _pendingFonts.end(), [&](const PendingFont& pendingFont)
+        {
+            return pendingFont.Key == key;
+        });
+    };
+
+    /// <summary>
+    /// Hand a loaded font to its future and stop tracking it
+    /// </summary>
+    FontHandle Resolve(const std::vector<PendingFont>::iterator pendingFont)
+    {
+        FontHandle font = pendingFont->Font;
+
+        pendingFont->Loaded.set_value(font);
+
+        _pendingFonts.erase(pendingFont);
+
+        return font;
+    };
+
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#include "FontSprite.hpp"
+#include "GlyphMetrics.hpp"
+#include "GLExtensions.hpp"
+#include "WindowsUtilities.hpp"
+#include "GLStateCache.hpp"
+#include "GPUMemory.hpp"
+
+
+/// <summary>
+/// (Bindless) The shader storage binding the fonts' texture handles are bound to, see FontSetBindlessFragmentShader.glsl
+/// </summary>
+constexpr std::uint32_t FontTextureHandlesBindingIndex = 7;
+
+
+/// <summary>
+/// Several FontSprites' atlases and glyph metrics, combined so a TextBatch can draw text in any of them with a single draw call.
+/// Every glyph instance carries the index of its font.
+/// With GL_ARB_bindless_texture every atlas is sampled through its handle, otherwise the atlases are copied into the layers of one texture array
+/// </summary>
+class FontSet
+{
+
+private:
+
+    struct Font
+    {
+        const FontSprite* Sprite = nullptr;
+
+        /// <summary>
+        /// The index of the font's first glyph in the combined metrics table
+        /// </summary>
+        std::uint32_t FirstGlyph = 0;
+    };
+
+    std::vector<Font> _fonts;
+
+    /// <summary>
+    /// Every font's glyph metrics, back to back
+    /// </summary>
+    std::uint32_t _glyphMetricsSSBO = 0;
+
+    /// <summary>
+    /// (Bindless) A resident handle per font, indexed by font
+    /// </summary>
+    std::vector<GLuint64> _textureHandles;
+
+    std::uint32_t _textureHandlesSSBO = 0;
+
+    /// <summary>
+    /// (Texture array) A layer per font, as large as the largest atlas
+    /// </summary>
+    std::uint32_t _textureArrayID = 0;
+
+
+public:
+
+    /// <param name="fonts"> The fonts, indexed in order. Their atlases must be ready, in the Coverage format, and outlive the set </param>
+    /// <param name="allowBindless"> Use bindless textures if they're supported, the set's program must use the matching fragment shader, see IsBindless </param>
+    FontSet(const std::initializer_list<const FontSprite*> fonts, const bool allowBindless = true) :
+        FontSet(std::span<const FontSprite* const>(fonts.begin(), fonts.size()), allowBindless)
+    {
+    };
+
+    /// <param name="fonts"> See the initializer list constructor, for sets built at runtime, e.g. from a FontFallbackChain's fonts </param>
+    FontSet(const std::span<const FontSprite* const> fonts, const bool allowBindless = true) :
+        _fonts(fonts.size())
+    {
+        wt::Assert(fonts.size() > 0, "A font set needs at least one font");
+
+        // A TextBatch's glyph instances keep their font in 8 bits
+        wt::Assert(fonts.size() <= 256, "A font set has at most 256 fonts");
+
+        const bool bindless = allowBindless == true && GLExtensions.BindlessTexture == true;
+
+        std::uint32_t layerWidth = 0;
+        std::uint32_t layerHeight = 0;
+
+        std::uint32_t glyphCount = 0;
+
+        for(std::size_t index = 0; index < fonts.size(); ++index)
+        {
+            const FontSprite* sprite = fonts[index];
+
+            wt::Assert(sprite->IsReady() == true, "A font set's fonts must be loaded before the set is created");
+
+            // The fragment shaders treat the atlases as coverage
+            wt::Assert(sprite->_atlasFormat == AtlasFormat::Coverage, "A font set's fonts must use the Coverage atlas format");
+
+            _fonts[index] = Font
+            {
+                .Sprite = sprite,
+                .FirstGlyph = glyphCount,
+            };
+
+            glyphCount += static_cast<std::uint32_t>(sprite->_font->Metrics.size());
+
+            layerWidth = std::max(layerWidth, sprite->_font->Width);
+            layerHeight = std::max(layerHeight, sprite->_font->Height);
+        };
+
+
+        std::vector<GlyphMetrics> glyphMetrics;
+        glyphMetrics.reserve(glyphCount);
+
+        for(const Font& font : _fonts)
+        {
+            // Smaller atlases only fill the top-left of their layer
+            const glm::vec2 layerScale = bindless == true ?
+                glm::vec2(1.0f, 1.0f) :
+                glm::vec2(static_cast<float>(font.Sprite->_font->Width) / layerWidth, static_cast<float>(font.Sprite->_font->Height) / layerHeight);
+
+            for(GlyphMetrics metrics : font.Sprite->_font->Metrics)
+            {
+                metrics.TextureRect *= glm::vec4(layerScale, layerScale);
+
+                // The instance's font index picks the texture
+                metrics.Layer = 0;
+
+                // The set's fonts are all coverage, whatever a package's padding held
+                metrics.Flags = 0;
+
+                glyphMetrics.push_back(metrics);
+            };
+        };
+
+        glCreateBuffers(1, &_glyphMetricsSSBO);
+        glNamedBufferStorage(_glyphMetricsSSBO, static_cast<GLsizeiptr>(glyphMetrics.size() * sizeof(GlyphMetrics)), glyphMetrics.data(), 0);
+
+        GPUMemory.TrackBuffer(_glyphMetricsSSBO, glyphMetrics.size() * sizeof(GlyphMetrics), GPUMemoryCategory::FontData);
+
+
+        if(bindless == true)
+        {
+            for(const Font& font : _fonts)
+            {
+                // The texture's parameters are frozen once it has a handle
+                const GLuint64 handle = glGetTextureHandleARB(font.Sprite->_font->Texture.Get());
+
+                glMakeTextureHandleResidentARB(handle);
+
+                _textureHandles.push_back(handle);
+            };
+
+            glCreateBuffers(1, &_textureHandlesSSBO);
+            glNamedBufferStorage(_textureHandlesSSBO, static_cast<GLsizeiptr>(_textureHandles.size() * sizeof(GLuint64)), _textureHandles.data(), 0);
+
+            GPUMemory.TrackBuffer(_textureHandlesSSBO, _textureHandles.size() * sizeof(GLuint64), GPUMemoryCategory::FontData);
+
+            return;
+        };
+
+
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &_textureArrayID);
+
+        glTextureParameteri(_textureArrayID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(_textureArrayID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glTextureParameteri(_textureArrayID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(_textureArrayID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glTextureStorage3D(_textureArrayID, 1, GL_R8, static_cast<int>(layerWidth), static_cast<int>(layerHeight), static_cast<int>(_fonts.size()));
+
+        GPUMemory.TrackTexture(_textureArrayID, GetTextureSizeInBytes(layerWidth, layerHeight, _fonts.size(), 1, 8), GPUMemoryCategory::Atlas);
+
+        // Uncovered space around smaller atlases is never sampled, but is cleared anyway
+        glClearTexImage(_textureArrayID, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+
+        for(std::size_t index = 0; index < _fonts.size(); ++index)
+        {
+            const FontSprite& sprite = *_fonts[index].Sprite;
+
+            // BC4 packages sample as R8 here, the copy needs matching formats so they have to be loaded uncompressed
+            GLint internalFormat = 0;
+            glGetTextureLevelParameteriv(sprite._font->Texture.Get(), 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+
+            wt::Assert(internalFormat == GL_R8, "A font set's texture array fallback needs uncompressed atlases");
+
+            glCopyImageSubData(sprite._font->Texture.Get(), GL_TEXTURE_2D, 0, 0, 0, 0,
+                               _textureArrayID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<int>(index),
+                               static_cast<int>(sprite._font->Width), static_cast<int>(sprite._font->Height), 1);
+        };
+    };
+
+    FontSet(const FontSet&) = delete;
+    FontSet& operator = (const FontSet&) = delete;
+
+    ~FontSet()
+    {
+        for(const GLuint64 handle : _textureHandles)
+        {
+            glMakeTextureHandleNonResidentARB(handle);
+        };
+
+        GLState.DeleteBuffer(_textureHandlesSSBO);
+
+        GLState.DeleteTexture(_textureArrayID);
+
+        GLState.DeleteBuffer(_glyphMetricsSSBO);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Bind the combined metrics table, and either the texture handles or the texture array
+    /// </summary>
+    void Bind(const std::uint32_t textureUnit = 0) const
+    {
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, GlyphMetricsBindingIndex, _glyphMetricsSSBO);
+
+        if(IsBindless() == true)
+            GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, FontTextureHandlesBindingIndex, _textureHandlesSSBO);
+        else
+            GLState.BindTextureUnit(textureUnit, _textureArrayID);
+    };
+
+
+    /// <summary>
+    /// Whether the fonts are sampled through bindless handles.
+    /// If so the set is drawn with FontSetBindlessFragmentShader.glsl, otherwise with GlyphAtlasFragmentShader.glsl
+    /// </summary>
+    bool IsBindless() const
+    {
+        return _textureHandles.empty() == false;
+    };
+
+    std::size_t GetFontCount() const
+    {
+        return _fonts.size();
+    };
+
+    const FontSprite& GetFont(const std::uint32_t fontIndex) const
+    {
+        return *_fonts[fontIndex].Sprite;
+    };
+
+    /// <summary>
+    /// The index of a font's first glyph in the combined metrics table
+    /// </summary>
+    std::uint32_t GetFirstGlyph(const std::uint32_t fontIndex) const
+    {
+        return _fonts[fontIndex].FirstGlyph;
+    };
+
+};
@@ -2,351 +2,3171 @@
 #define WIN32_LEAN_AND_MEN
 
 #include <Windows.h>
-#include <objidl.h>
-#include <gdiplus.h>
 #include <GLFW/glfw3.h>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <string>
 #include <string_view>
 #include <glad/glad.h>
+#include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <array>
+#include <vector>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <optional>
+#include <filesystem>
+#include <format>
+#include <ostream>
+#include <span>
 
-#pragma comment(lib, "gdiplus.lib")
+#include "ShaderProgram.hpp"
+#include "ShaderStorageBuffer.hpp"
+#include "StaticSSBOLayout.hpp"
+#include "TextureLoader.hpp"
+#include "TextLayout.hpp"
+#include "GlyphRunCache.hpp"
+#include "TextMetrics.hpp"
+#include "TextBuffer.hpp"
+#include "GPUProfiler.hpp"
+#include "PipelineStatistics.hpp"
+#include "GlyphMetrics.hpp"
+#include "FontAtlasPackage.hpp"
+#include "UploadWorker.hpp"
+#include "GLStateCache.hpp"
+#include "GLObject.hpp"
+#include "GPUMemory.hpp"
+#include "BufferPool.hpp"
+#include "TextConversion.hpp"
+#include "NumberFormatting.hpp"
+#include "CodepointGlyphTable.hpp"
+#include "KerningTable.hpp"
+#include "TextStyle.hpp"
+#include "TextRing.hpp"
+#include "EventTracing.hpp"
+#include "DrawCapture.hpp"
+#include "ProfileZones.hpp"
+
+
+/// <summary>
+/// How many bits each character occupies inside the Characters[] array
+/// </summary>
+enum class CharacterPacking : std::uint32_t
+{
+    /// <summary>
+    /// One character per uint
+    /// </summary>
+    Bits32 = 32,
+
+    /// <summary>
+    /// Two characters per uint, for atlases with more than 256 glyphs
+    /// </summary>
+    Bits16 = 16,
+
+    /// <summary>
+    /// Four characters per uint
+    /// </summary>
+    Bits8 = 8,
+};
+
+
+/// <summary>
+/// How the font's atlas is stored on the GPU
+/// </summary>
+enum class AtlasFormat
+{
+    /// <summary>
+    /// The image as-is, the fragment shader discards pixels matching the chroma key.
+    /// Used with FontSpriteFragmentShader.glsl
+    /// </summary>
+    ChromaKeyedRGBA,
+
+    /// <summary>
+    /// A single channel GL_R8 texture, chroma-keyed pixels are converted to 0 coverage at load time.
+    /// Used with FontSpriteCoverageFragmentShader.glsl, which blends instead of discarding
+    /// </summary>
+    Coverage,
+
+    /// <summary>
+    /// A single channel GL_R8 signed distance field, generated from the chroma-keyed image at load time one glyph cell at a time.
+    /// Used with FontSpriteDistanceFieldFragmentShader.glsl, which reconstructs sharp edges at any scale, so a single atlas serves every text size
+    /// </summary>
+    DistanceField,
+
+    /// <summary>
+    /// An RGBA8 texture of per-subpixel coverage for horizontal RGB stripe LCDs, generated from the chroma-keyed image at load time.
+    /// Used with FontSpriteSubpixelFragmentShader.glsl, which blends every colour channel by its own coverage through dual-source blending.
+    /// Only for unscaled text drawn on whole pixels onto an opaque background, anything else shows colour fringes
+    /// </summary>
+    Subpixel,
+};
+
+
+/// <summary>
+/// (Distance field atlases) The largest distance from a glyph's edge the field represents, in atlas pixels
+/// </summary>
+constexpr float DistanceFieldSpread = 4.0f;
+
+
+/// <summary>
+/// The optional parts of the FontSprite shaders, bits of a ShaderVariants feature mask. See FontSprite::GetShaderFeatures
+/// </summary>
+enum class FontShaderFeature : std::uint32_t
+{
+    None = 0,
+
+    /// <summary>
+    /// Decorations, backgrounds, bold and per-span colours, for DrawStyled
+    /// </summary>
+    Styles = 1 << 0,
+
+    /// <summary>
+    /// Per-draw transforms and colours, for QueueCached
+    /// </summary>
+    MultiDraw = 1 << 1,
+
+    /// <summary>
+    /// (Distance field atlases) Supersampled edges, see FontSprite::Supersample
+    /// </summary>
+    Supersample = 1 << 2,
+
+    /// <summary>
+    /// Every shaded fragment adds a fixed amount of light instead of the text's colour, and FontSprite blends the draw additively,
+    /// so the brighter a pixel the more fragments were shaded for it. For finding overdraw, see OverdrawHeatmap.glsl
+    /// </summary>
+    OverdrawHeatmap = 1 << 3,
+
+    /// <summary>
+    /// Every glyph is offset and faded by its state in a TextAnimator, which must be bound when the text is drawn, see TextAnimator::Update
+    /// </summary>
+    Animation = 1 << 4,
+
+    /// <summary>
+    /// (Distance field atlases) An outline and a drop shadow drawn from the glyphs' own distance field, in the same draw, see FontSprite::Effects
+    /// </summary>
+    Effects = 1 << 5,
+
+    /// <summary>
+    /// The text is anchored in the world at its transform's origin and faces the camera, the frame's projection must then be a 3D one, see FontSprite::Billboard
+    /// </summary>
+    Billboard = 1 << 6,
+
+    /// <summary>
+    /// (Bitmap atlases) Glyphs are snapped to the pixel grid and their texels fetched by integer coordinates, so edges never bleed into a neighbour
+    /// and the atlas needs no padding. Only for text drawn at the atlas' own size, e.g. without a content scale, see AtlasSampling.glsl
+    /// </summary>
+    PixelSnap = 1 << 7,
+};
+
+/// <summary>
+/// The macro each FontShaderFeature defines, in bit order, for ShaderVariants
+/// </summary>
+inline const std::vector<std::string> FontShaderFeatureDefines = { "STYLED_TEXT", "MULTI_DRAW", "SUPERSAMPLE", "OVERDRAW_HEATMAP", "ANIMATED_TEXT", "TEXT_EFFECTS", "BILLBOARD_TEXT", "PIXEL_SNAPPED" };
+
+
+/// <summary>
+/// (Distance field atlases) An outline and drop shadow drawn with the text by FontShaderFeature::Effects programs.
+/// Both are thresholds of the distance field the glyph itself is drawn from, so decorated text is still one upload and one draw
+/// </summary>
+struct TextEffects
+{
+    /// <summary>
+    /// The outline's width around the glyphs, in the font's pixels, at most DistanceFieldSpread. 0 for no outline
+    /// </summary>
+    float OutlineWidth = 0.0f;
+
+    glm::vec4 OutlineColour = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    /// <summary>
+    /// How far the shadow is from the text, in the font's pixels
+    /// </summary>
+    glm::vec2 ShadowOffset = { 2.0f, 2.0f };
+
+    /// <summary>
+    /// How far the shadow's edge is blurred, in the font's pixels. The field ends DistanceFieldSpread pixels from the glyphs, so blurs are capped there
+    /// </summary>
+    float ShadowSoftness = 1.0f;
+
+    /// <summary>
+    /// Transparent for no shadow
+    /// </summary>
+    glm::vec4 ShadowColour = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+
+/// <summary>
+/// How a FontSprite's glyphs are blended onto what's under them
+/// </summary>
+struct TextBlending
+{
+    /// <summary>
+    /// Blend in linear light with premultiplied coverage, through GL_FRAMEBUFFER_SRGB, rather than straight alpha on the sRGB values.
+    /// Edges then have the weight the font was designed with instead of looking thin on dark text and bold on light text.
+    /// Only takes effect when the target is sRGB-encoded, e.g. a GL_SRGB8_ALPHA8 texture or a window created with GLFW_SRGB_CAPABLE
+    /// </summary>
+    bool Linear = false;
+
+    /// <summary>
+    /// Raises partial coverage before it's blended, 0 for none. Around 0.5 makes up for how much lighter small text looks blended linearly
+    /// </summary>
+    float Contrast = 0.0f;
+};
+
+
+/// <summary>
+/// How FontShaderFeature::Billboard programs size text anchored in the world. The glyphs are turned to face the camera in the vertex shader,
+/// so labels in a 3D scene need no per-label matrices on the CPU, only their anchor in the transform or in a queued draw's transform
+/// </summary>
+struct TextBillboard
+{
+    /// <summary>
+    /// World units per pixel of the font, or with ConstantScreenSize, window units per pixel of the font, see FrameData::ContentScale
+    /// </summary>
+    float Scale = 1.0f;
+
+    /// <summary>
+    /// Whether the text keeps its size on screen however far it is from the camera
+    /// </summary>
+    bool ConstantScreenSize = false;
+};
+
+
+/// <summary>
+/// The layout of the "Input" block read by FontSpriteVertexShader.glsl and TextLayoutComputeShader.glsl.
+/// The shaders don't declare the block themselves, they include its declaration generated from this layout, see FontSpriteInputInclude
+/// </summary>
+using FontSpriteInputLayout = StaticSSBOLayout<SSBOField<"GlyphWidth", DataType::UInt32>,
+                                               SSBOField<"GlyphHeight", DataType::UInt32>,
+
+                                               SSBOField<"TextureWidth", DataType::UInt32>,
+                                               SSBOField<"TextureHeight", DataType::UInt32>,
+
+                                               SSBOField<"ChromaKey", DataType::Vec4f>,
+
+                                               SSBOField<"TextColour", DataType::Vec4f>,
+
+                                               SSBOUnsizedArrayField<"Characters", DataType::UInt32>>;
+
+static_assert(FontSpriteInputLayout::GetOffset<"Characters">() == 48, "FontSpriteInputLayout doesn't match the shader's input block");
+static_assert(FontSpriteInputLayout::GetOffset<"Characters">() == TextRingHeaderSizeInBytes, "Text rings must leave room for the input block's header");
+
+/// <summary>
+/// The name shaders include the "Input" block's declaration by
+/// </summary>
+constexpr std::string_view FontSpriteInputInclude = "FontSpriteInput.glsl";
+
+/// <summary>
+/// Registered before main, so it's there before the first font's shaders are compiled
+/// </summary>
+inline const bool FontSpriteInputIncludeRegistered = ShaderIncludes.Register(std::string(FontSpriteInputInclude), FontSpriteInputLayout::GetGLSLDeclaration("Input", 0));
+
+
+/// <summary>
+/// Glyph quads are drawn as 4 vertex triangle strips, their corners are pulled from gl_VertexID
+/// </summary>
+constexpr std::int32_t GlyphQuadVertexCount = 4;
+
+
+struct Input
+{
+    std::uint32_t GlyphWidth;
+    std::uint32_t GlyphHeight;
+
+    std::uint32_t TextureWidth;
+    std::uint32_t TextureHeight;
+
+    glm::vec4 ChromaKey;
+
+    glm::vec4 TextColour;
+};
+
+
+/// <summary>
+/// Draw text from a textue
+/// </summary>
+class FontSprite
+{
+    friend class TextBatch;
+    friend class FontSet;
+    friend class TerminalGrid;
+
+public:
+
+    /// <summary>
+    /// A font's atlas decoded and converted into the format it's uploaded as, but not uploaded yet.
+    /// Decoding needs no context, so it can run on any thread, see DecodeAtlas and the constructor that takes one
+    /// </summary>
+    struct DecodedAtlas
+    {
+        AtlasFormat Format = AtlasFormat::ChromaKeyedRGBA;
+
+        FontAtlasPixelFormat PixelFormat = FontAtlasPixelFormat::R8;
+
+        std::uint32_t Width = 0;
+        std::uint32_t Height = 0;
+
+        /// <summary>
+        /// The pixels to upload, in ConvertedPixels or kept alive by PixelStorage. Moving the atlas keeps them where they are
+        /// </summary>
+        std::span<const std::byte> Pixels;
+
+        std::vector<std::byte> ConvertedPixels;
+
+        /// <summary>
+        /// The decoded image, or the mapped package
+        /// </summary>
+        std::shared_ptr<const void> PixelStorage;
+
+        /// <summary>
+        /// (Atlas packages) The package's own glyph metrics and kerning
+        /// </summary>
+        std::vector<GlyphMetrics> Metrics;
+
+        std::vector<KerningPair> Kerning;
+    };
+
+    /// <summary>
+    /// The colour image atlases are keyed out with, unless a font is given another
+    /// </summary>
+    static inline const glm::vec4 DefaultChromaKey = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+
+    /// <summary>
+    /// Decode and convert a font's atlas without uploading it, on any thread.
+    /// ".fontatlas" packages are only validated, their pixels stay in the mapped file
+    /// </summary>
+    /// <param name="file"> The mapped atlas image or package </param>
+    /// <param name="path"> The file's path, its extension picks how it's read </param>
+    /// <param name="textureLoader"> Decodes images, if null one is picked by the path's extension </param>
+    static DecodedAtlas DecodeAtlas(const std::shared_ptr<const MappedFile>& file,
+                                    const std::filesystem::path& path,
+                                    const ITextureLoader* textureLoader,
+                                    const glm::uvec2& glyphSize,
+                                    const AtlasFormat atlasFormat,
+                                    const glm::vec4& chromaKey = DefaultChromaKey)
+    {
+        const std::int64_t decodeStart = wt::etw::GetTime();
+
+        if(path.extension() == FontAtlasPackage::Extension)
+        {
+            const std::shared_ptr<const FontAtlasPackage> package = std::make_shared<const FontAtlasPackage>(file, path);
+            const FontAtlasHeader& header = package->GetHeader();
+
+            wt::Assert(header.GlyphWidth == glyphSize.x && header.GlyphHeight == glyphSize.y, "The font atlas package's glyph size doesn't match the font sprite's");
+
+            wt::Assert(IsPackageCompatible(*package, atlasFormat) == true, "The font atlas package was baked for a different atlas format");
+
+            return DecodePackage(package, path, atlasFormat, decodeStart);
+        };
+
+
+        const TextureImage image = (textureLoader != nullptr ? *textureLoader : GetTextureLoader(path)).Load(file, path);
+
+        DecodedAtlas atlas = DecodedAtlas
+        {
+            .Format = atlasFormat,
+            .Width = image.Width,
+            .Height = image.Height,
+            .PixelStorage = image.PixelStorage,
+        };
+
+        atlas.Pixels = ConvertAtlasImage(image, glyphSize, atlasFormat, chromaKey, atlas.PixelFormat, atlas.ConvertedPixels);
+
+        atlas.Metrics = BuildInkGlyphMetrics(image, glyphSize, atlasFormat, chromaKey);
+
+        wt::etw::TextureDecode(path.c_str(), atlas.Width, atlas.Height, wt::etw::GetMillisecondsSince(decodeStart));
+
+        return atlas;
+    };
+
+    /// <summary>
+    /// Read a ".fontatlas" package that's already in memory, e.g. the EmbeddedAsset of the default font, on any thread.
+    /// Nothing is copied, the pixels are uploaded straight out of the memory
+    /// </summary>
+    /// <param name="package"> Must outlive the decoded atlas </param>
+    /// <param name="path"> Where the package came from, for error messages </param>
+    /// <returns> Nothing if the package was baked for another glyph size or atlas format, the font is then decoded from its image instead </returns>
+    static std::optional<DecodedAtlas> DecodeAtlas(const std::span<const std::byte>& package,
+                                                   const std::filesystem::path& path,
+                                                   const glm::uvec2& glyphSize,
+                                                   const AtlasFormat atlasFormat)
+    {
+        const std::int64_t decodeStart = wt::etw::GetTime();
+
+        const std::shared_ptr<const FontAtlasPackage> packageView = std::make_shared<const FontAtlasPackage>(package, path);
+        const FontAtlasHeader& header = packageView->GetHeader();
+
+        if(header.GlyphWidth != glyphSize.x || header.GlyphHeight != glyphSize.y || IsPackageCompatible(*packageView, atlasFormat) == false)
+            return std::nullopt;
+
+        return DecodePackage(packageView, path, atlasFormat, decodeStart);
+    };
+
+
+private:
+
+    /// <summary>
+    /// The result of an atlas loaded on an UploadWorker, written by the worker before its fence
+    /// </summary>
+    struct LoadedAtlas
+    {
+        std::uint32_t TextureID = 0;
+
+        std::uint32_t Width = 0;
+        std::uint32_t Height = 0;
+
+        /// <summary>
+        /// (Atlas packages) The package's own glyph metrics and kerning, empty for images which are laid out as a grid
+        /// </summary>
+        std::vector<GlyphMetrics> Metrics;
+
+        std::vector<KerningPair> Kerning;
+    };
+
+    /// <summary>
+    /// Everything that comes from the font's atlas. Owned by the FontSprite that loaded the font and shared with every text instance created from it,
+    /// freed with the last of them
+    /// </summary>
+    struct SharedFont
+    {
+        /// <summary>
+        /// The loaded atlas, none until it's loaded
+        /// </summary>
+        GLTexture Texture;
+
+        /// <summary>
+        /// The total width of the font sprite
+        /// </summary>
+        std::uint32_t Width = 0;
+
+        /// <summary>
+        /// The total height of the font sprite
+        /// </summary>
+        std::uint32_t Height = 0;
+
+        /// <summary>
+        /// The number of character columns present in the font sprite
+        /// </summary>
+        std::uint32_t Columns = 0;
+
+        /// <summary>
+        /// The number of character rows present in the font sprite
+        /// </summary>
+        std::uint32_t Rows = 0;
+
+
+        /// <summary>
+        /// Glyph quads are generated from gl_VertexID, the VAO is empty but the core profile still requires one to draw
+        /// </summary>
+        GLVertexArray VertexArray = GLVertexArray::Create();
+
+        /// <summary>
+        /// The metrics of every glyph in the atlas, built once at load time
+        /// </summary>
+        std::vector<GlyphMetrics> Metrics;
+
+        /// <summary>
+        /// An immutable, read-only copy of Metrics the vertex shaders index by glyph
+        /// </summary>
+        GLBuffer MetricsSSBO;
+
+        /// <summary>
+        /// Character to glyph index, ASCII from the space up in atlas order. Bound for the layout pass, which looks every character up in it
+        /// </summary>
+        CodepointGlyphTable GlyphTable;
+
+        /// <summary>
+        /// (Atlas packages) KerningPairs by glyph index, for the layout pass
+        /// </summary>
+        KerningTable Kerning;
+
+        /// <summary>
+        /// (Atlas packages) Kerning adjustments between pairs of characters, sorted by First then Second
+        /// </summary>
+        std::vector<KerningPair> KerningPairs;
+
+        /// <summary>
+        /// Whether the glyphs' advances differ from the glyph width or the font has kerning, the layout then positions glyphs by their advances
+        /// </summary>
+        bool Proportional = false;
+
+        /// <summary>
+        /// Every character's advance, the advance of the glyph the layout pass draws it with. Control characters have none.
+        /// For measuring on the CPU, see GetTextMetrics
+        /// </summary>
+        std::array<float, 256> Advances = { };
+
+
+        /// <summary>
+        /// (Sub-data mode) Input buffers of instances that were destroyed or grew, handed to the next instance that needs one.
+        /// Their header is written once and their characters in parts as the text changes, so they're updated in place
+        /// </summary>
+        BufferPool InputBuffers = BufferPool(32, BufferUsage::RarelyUpdated);
+
+
+        /// <summary>
+        /// (Background loading) The atlas being loaded, null once it's adopted
+        /// </summary>
+        std::shared_ptr<LoadedAtlas> PendingAtlas;
+
+        UploadTicket PendingAtlasUpload;
+
+
+        SharedFont() = default;
+
+        SharedFont(const SharedFont&) = delete;
+        SharedFont& operator = (const SharedFont&) = delete;
+
+        ~SharedFont()
+        {
+            // The worker may still be writing into the texture
+            if(PendingAtlas != nullptr)
+            {
+                PendingAtlasUpload.Wait();
+
+                GLState.DeleteTexture(PendingAtlas->TextureID);
+            };
+        };
+    };
+
+    std::shared_ptr<SharedFont> _font;
+
+
+    /// <summary>
+    /// The width of a single glyph 
+    /// </summary>
+    std::uint32_t _glyphWidth = 0;
+
+    /// <summary>
+    /// The height of a single glyph 
+    /// </summary>
+    std::uint32_t _glyphHeight = 0;
+
+
+    /// <summary>
+    /// The spans of the last styled draw, see DrawStyled
+    /// </summary>
+    mutable GLBuffer _textSpansBuffer;
+
+    /// <summary>
+    /// How many spans _textSpansBuffer can hold
+    /// </summary>
+    mutable std::size_t _textSpansCapacity = 0;
+
+    /// <summary>
+    /// The colours paletted characters pick from, packed like span colours, see SetPalette
+    /// </summary>
+    GLBuffer _paletteBuffer;
+
+    std::reference_wrapper<const ShaderProgram> _shaderProgram;
+
+    UniformHandle _textTransformUniform;
+
+    /// <summary>
+    /// Set while SubmitQueued draws, the vertex shader then reads the transform and colour per gl_DrawID
+    /// </summary>
+    UniformHandle _multiDrawUniform;
+
+    /// <summary>
+    /// Only distance field shaders have it, see Supersample
+    /// </summary>
+    UniformHandle _supersampleUniform;
+
+    /// <summary>
+    /// The uniforms Effects is applied through, see UploadTextEffects
+    /// </summary>
+    struct TextEffectUniforms
+    {
+        UniformHandle Padding;
+        UniformHandle OutlineDistance;
+        UniformHandle OutlineColour;
+        UniformHandle ShadowOffset;
+        UniformHandle ShadowSoftness;
+        UniformHandle ShadowColour;
+    };
+
+    TextEffectUniforms _textEffectUniforms;
+
+    /// <summary>
+    /// Only FontShaderFeature::Billboard programs have them, see Billboard
+    /// </summary>
+    UniformHandle _billboardScaleUniform;
+    UniformHandle _billboardConstantScreenSizeUniform;
+
+    /// <summary>
+    /// Set from Blending, see TextBlending.glsl
+    /// </summary>
+    UniformHandle _linearBlendingUniform;
+    UniformHandle _coverageContrastUniform;
+
+    /// <summary>
+    /// Whether the program is a FontShaderFeature::Effects variant
+    /// </summary>
+    bool _textEffects = false;
+
+    /// <summary>
+    /// Whether the program is a FontShaderFeature::OverdrawHeatmap variant, whose draws are blended additively
+    /// </summary>
+    bool _overdrawHeatmap = false;
+
+    mutable std::uint32_t _inputSSBO2BufferID = 0;
+
+
+    /// <summary>
+    /// Character capacity, how many character we can write before we need to reallocate the buffer
+    /// </summary>
+    mutable std::size_t _capacity = 0;
+
+    /// <summary>
+    /// A CPU-side copy of the characters being drawn, converted to the SSBO's element type so they can be uploaded in bulk
+    /// </summary>
+    mutable std::vector<std::uint32_t> _characterStagingBuffer;
+
+    /// <summary>
+    /// (Sub-data mode) Character copies submitted to Uploads, waited on before the upload returns
+    /// </summary>
+    mutable std::vector<UploadTicket> _pendingCharacterUploads;
+
+    /// <summary>
+    /// How characters are packed into the Characters[] array
+    /// </summary>
+    CharacterPacking _characterPacking = CharacterPacking::Bits32;
+
+    /// <summary>
+    /// (Sub-data mode) A copy of the characters currently stored in the input buffer, used to upload only what changed
+    /// </summary>
+    mutable std::string _uploadedText;
+
+    /// <summary>
+    /// (Sub-data mode) The TextBuffer whose characters are currently stored in the input buffer, only its dirty range has to be uploaded
+    /// </summary>
+    mutable const TextBuffer* _uploadedTextBuffer = nullptr;
+
+    /// <summary>
+    /// (Sub-data mode) The ranges of a string that differ from _uploadedText, kept so diffing doesn't allocate
+    /// </summary>
+    mutable std::vector<TextDirtyRange> _changedRanges;
+
+    /// <summary>
+    /// UTF-8 text that isn't plain ASCII, decoded for drawing. Kept between draws so decoding doesn't allocate every time
+    /// </summary>
+
+    /// <summary>
+    /// The number of bytes written to input buffers since construction
+    /// </summary>
+    mutable std::size_t _uploadedByteCount = 0;
+
+    /// <summary>
+    /// _uploadedByteCount as of the last draw, the difference is reported with the next one
+    /// </summary>
+    mutable std::size_t _tracedUploadedByteCount = 0;
+
+    /// <summary>
+    /// (Sub-data mode) The text colour currently stored in the input buffer
+    /// </summary>
+    mutable std::optional<glm::vec4> _uploadedTextColour;
+
+
+    /// <summary>
+    /// Counts the layout passes, each one replaces the glyphs the previous one left in the TextLayout's buffers
+    /// </summary>
+    mutable std::uint64_t _layoutGeneration = 0;
+
+    /// <summary>
+    /// (DrawRetained) The pass whose glyphs are kept for redrawing, 0 if none, and the layout and font they were laid out with
+    /// </summary>
+    mutable std::uint64_t _retainedLayoutGeneration = 0;
+
+    mutable TextLayoutOptions _retainedLayout;
+
+    mutable TextMetricsFont _retainedLayoutFont;
+
+
+    /// <summary>
+    /// How character data is uploaded to the GPU
+    /// </summary>
+    SSBOMode _uploadMode = SSBOMode::SubData;
+
+    /// <summary>
+    /// (Ring mode) A persistently mapped buffer the input data is written into directly, one region per frame in flight
+    /// </summary>
+    std::optional<ShaderStorageBuffer> _inputRingBuffer;
+
+    /// <summary>
+    /// The colour that is treated as transparent in the font sprite 
+    /// </summary>
+    glm::vec4 _chromaKey = DefaultChromaKey;
+
+    /// <summary>
+    /// How the atlas is stored, must match the program's fragment shader
+    /// </summary>
+    AtlasFormat _atlasFormat = AtlasFormat::ChromaKeyedRGBA;
+
+    /// <summary>
+    /// Allocate and fill a full mip chain for the atlas, for text that's drawn scaled down
+    /// </summary>
+    bool _generateMipmaps = false;
+
+    /// <summary>
+    /// Positions every character of a draw, see Layout
+    /// </summary>
+    TextLayout _textLayout;
+
+    /// <summary>
+    /// Strings already laid out on the GPU, see DrawCached
+    /// </summary>
+    mutable std::optional<GlyphRunCache> _glyphRunCache;
+
+    /// <summary>
+    /// The table the interned strings drawn through the cache came from, their ids mean nothing in any other one
+    /// </summary>
+    mutable const StringTable* _internedStrings = nullptr;
+
+    /// <summary>
+    /// Strings already laid out on the CPU, see GetTextMetrics
+    /// </summary>
+    mutable TextMetricsCache _textMetricsCache;
+
+    /// <summary>
+    /// The metrics of text measured before the atlas is in, which aren't cached since the advances aren't known yet
+    /// </summary>
+    mutable TextMetrics _uncachedTextMetrics;
+
+    /// <summary>
+    /// (Sub-data mode) Whether the input buffer holds the atlas' size. An instance created while its font was loading only gets it in Update
+    /// </summary>
+    bool _inputHasAtlasSize = false;
+
+
+public:
+
+    /// <summary>
+    /// The text's transform. The projection is shared by all draws, and comes from the FrameUniformBuffer
+    /// </summary>
+    glm::mat4 Transform = glm::mat4(1.0f);
+
+    /// <summary>
+    /// How drawn text is broken into lines
+    /// </summary>
+    TextLayoutOptions Layout;
+
+    /// <summary>
+    /// If set, draws are profiled as "Text upload", "Text layout" and "Glyph draw" scopes
+    /// </summary>
+    GPUProfiler* Profiler = nullptr;
+
+    /// <summary>
+    /// If set, every glyph draw is counted as a "Glyph draw" batch
+    /// </summary>
+    PipelineStatisticsProfiler* PipelineStatistics = nullptr;
+
+    /// <summary>
+    /// If set, the plain, UTF-8 and TextBuffer draws are recorded for replaying, see DrawRecorder. Not carried over to copies
+    /// </summary>
+    DrawRecorder* Recorder = nullptr;
+
+    /// <summary>
+    /// (Sub-data mode) If set, character ranges of at least LargeUploadSize bytes are copied into the input buffer on the worker,
+    /// so the render thread doesn't stall on the driver's copy. The draw's commands wait on the GPU for the copy, the CPU only for its submission
+    /// </summary>
+    UploadWorker* Uploads = nullptr;
+
+    /// <summary>
+    /// (Sub-data mode) How the input buffer grows. Discard skips the GPU copy and uploads the next text in full,
+    /// which suits text that changes every frame anyway
+    /// </summary>
+    BufferGrowthMode InputGrowthMode = BufferGrowthMode::Copy;
+
+    /// <summary>
+    /// (Distance field atlases) Whether edges are sampled four times per pixel, which keeps small text from shimmering.
+    /// Applied by Bind, lowered by FrameBudgetController on heavy frames
+    /// </summary>
+    bool Supersample = true;
+
+    /// <summary>
+    /// (FontShaderFeature::Effects programs) The text's outline and shadow. Applied by Bind
+    /// </summary>
+    TextEffects Effects;
+
+    /// <summary>
+    /// (FontShaderFeature::Billboard programs) How the text is sized in the world. Applied by Bind
+    /// </summary>
+    TextBillboard Billboard;
+
+    /// <summary>
+    /// How the glyphs blend, per font. Applied by Bind and the draws
+    /// </summary>
+    TextBlending Blending;
+
+
+public:
+
+    FontSprite(const std::uint32_t glyphWidth,
+               const std::uint32_t glyphHeight,
+               const ShaderProgram& shaderProgram,
+               const std::wstring_view& texturePath,
+               const std::uint32_t capacity = 32,
+               const SSBOMode uploadMode = SSBOMode::SubData,
+               const CharacterPacking characterPacking = CharacterPacking::Bits32,
+               const AtlasFormat atlasFormat = AtlasFormat::ChromaKeyedRGBA,
+               const bool generateMipmaps = false,
+               const ITextureLoader* textureLoader = nullptr,
+               UploadWorker* uploadWorker = nullptr) :
+        _font(std::make_shared<SharedFont>()),
+        _glyphWidth (glyphWidth),
+        _glyphHeight(glyphHeight),
+        _shaderProgram(shaderProgram),
+        _capacity(capacity),
+        _characterPacking(characterPacking),
+        _uploadMode(uploadMode),
+        _atlasFormat(atlasFormat),
+        _generateMipmaps(generateMipmaps)
+    {
+        ResolveShaderProgram();
+
+        CreateInput();
+
+
+        if(uploadWorker == nullptr)
+        {
+            AdoptAtlas(LoadAtlas(texturePath, textureLoader, { _glyphWidth, _glyphHeight }, _atlasFormat, _generateMipmaps, _chromaKey));
+            UploadAtlasSize();
+            return;
+        };
+
+
+        // The atlas is decoded and uploaded on the worker, nothing is drawn until Update adopts it
+        _font->PendingAtlas = std::make_shared<LoadedAtlas>();
+
+        _font->PendingAtlasUpload = uploadWorker->Submit([atlas = _font->PendingAtlas,
+                                                          path = std::wstring(texturePath),
+                                                          textureLoader,
+                                                          glyphSize = glm::uvec2(_glyphWidth, _glyphHeight),
+                                                          atlasFormat = _atlasFormat,
+                                                          generateMipmaps = _generateMipmaps,
+                                                          chromaKey = _chromaKey]()
+        {
+            *atlas = LoadAtlas(path, textureLoader, glyphSize, atlasFormat, generateMipmaps, chromaKey);
+        });
+    };
+
+
+    /// <summary>
+    /// Create a font from an atlas that was decoded ahead of time, e.g. on a worker by AssetLoader, so only the upload is left to the current context
+    /// </summary>
+    /// <param name="atlas"> See DecodeAtlas, its format is the font's </param>
+    FontSprite(const std::uint32_t glyphWidth,
+               const std::uint32_t glyphHeight,
+               const ShaderProgram& shaderProgram,
+               DecodedAtlas&& atlas,
+               const std::uint32_t capacity = 32,
+               const SSBOMode uploadMode = SSBOMode::SubData,
+               const CharacterPacking characterPacking = CharacterPacking::Bits32,
+               const bool generateMipmaps = false) :
+        _font(std::make_shared<SharedFont>()),
+        _glyphWidth (glyphWidth),
+        _glyphHeight(glyphHeight),
+        _shaderProgram(shaderProgram),
+        _capacity(capacity),
+        _characterPacking(characterPacking),
+        _uploadMode(uploadMode),
+        _atlasFormat(atlas.Format),
+        _generateMipmaps(generateMipmaps)
+    {
+        ResolveShaderProgram();
+
+        CreateInput();
+
+        AdoptAtlas(UploadAtlas(std::move(atlas), _generateMipmaps));
+        UploadAtlasSize();
+    };
+
+
+    /// <summary>
+    /// A text instance of an already created font, e.g. one per text widget.
+    /// The atlas, glyph tables, VAO and program are the font's, and stay alive for as long as any instance uses them, so only an input buffer is set up,
+    /// and that comes from the font's pool of released ones when it can. The font may still be loading, see Update.
+    /// The instance starts with the font's Layout, profilers and upload worker
+    /// </summary>
+    /// <param name="font"> The font the text is drawn in </param>
+    /// <param name="capacity"> The instance's character capacity </param>
+    /// <param name="uploadMode"> How the instance's characters are uploaded </param>
+    FontSprite(const FontSprite& font,
+               const std::uint32_t capacity,
+               const SSBOMode uploadMode = SSBOMode::SubData) :
+        _font(font._font),
+        _glyphWidth(font._glyphWidth),
+        _glyphHeight(font._glyphHeight),
+        _shaderProgram(font._shaderProgram),
+        _textTransformUniform(font._textTransformUniform),
+        _multiDrawUniform(font._multiDrawUniform),
+        _supersampleUniform(font._supersampleUniform),
+        _textEffectUniforms(font._textEffectUniforms),
+        _billboardScaleUniform(font._billboardScaleUniform),
+        _billboardConstantScreenSizeUniform(font._billboardConstantScreenSizeUniform),
+        _linearBlendingUniform(font._linearBlendingUniform),
+        _coverageContrastUniform(font._coverageContrastUniform),
+        _textEffects(font._textEffects),
+        _overdrawHeatmap(font._overdrawHeatmap),
+        _capacity(capacity),
+        _characterPacking(font._characterPacking),
+        _uploadMode(uploadMode),
+        _chromaKey(font._chromaKey),
+        _atlasFormat(font._atlasFormat),
+        _generateMipmaps(font._generateMipmaps),
+        Layout(font.Layout),
+        Profiler(font.Profiler),
+        PipelineStatistics(font.PipelineStatistics),
+        Uploads(font.Uploads),
+        Supersample(font.Supersample),
+        Effects(font.Effects),
+        Billboard(font.Billboard),
+        Blending(font.Blending)
+    {
+        CreateInput();
+
+        if(IsReady() == true)
+            UploadAtlasSize();
+    };
+
+    FontSprite(const FontSprite&) = delete;
+    FontSprite& operator = (const FontSprite&) = delete;
+
+    /// <summary>
+    /// Every GL object moves along, nothing is recreated. A moved-from FontSprite has no font and may only be destroyed or assigned to.
+    /// TextBatches and FontSets that point to the sprite have to be pointed at its new place
+    /// </summary>
+    FontSprite(FontSprite&&) noexcept = default;
+
+    FontSprite& operator = (FontSprite&& other) noexcept
+    {
+        if(this != &other)
+        {
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+        };
+
+        return *this;
+    };
+
+    /// <summary>
+    /// The font's shared resources are freed with the last instance using them
+    /// </summary>
+    ~FontSprite()
+    {
+        // Moved from, the input buffer belongs to the sprite it moved into
+        if(_font == nullptr)
+            return;
+
+        // Draws already issued keep reading the input buffer, the pool only hands it out again once they're done
+        _font->InputBuffers.Release(_inputSSBO2BufferID, GetInputBufferSizeInBytes());
+    };
+
+
+public:
+
+    /// <summary>
+    /// Whether the atlas is loaded. Until then Bind and Draw do nothing
+    /// </summary>
+    bool IsReady() const
+    {
+        return _font->Texture.Get() != 0;
+    };
+
+    /// <summary>
+    /// (Background loading) Adopt the atlas once the upload worker is done with it, should be called once per frame.
+    /// Whichever of the font's instances is updated first adopts it, the others only pick up its size
+    /// </summary>
+    /// <returns> True if the atlas became ready, and the text should be redrawn </returns>
+    bool Update()
+    {
+        if(_font->PendingAtlas != nullptr && _font->PendingAtlasUpload.IsComplete() == true)
+        {
+            AdoptAtlas(std::move(*_font->PendingAtlas));
+
+            _font->PendingAtlas.reset();
+            _font->PendingAtlasUpload = UploadTicket();
+        };
+
+        if(IsReady() == false || _inputHasAtlasSize == true)
+            return false;
+
+        UploadAtlasSize();
+
+        return true;
+    };
+
+    /// <summary>
+    /// (Background loading) Block until the atlas is loaded, and adopt it
+    /// </summary>
+    void WaitUntilReady()
+    {
+        _font->PendingAtlasUpload.Wait();
+
+        Update();
+    };
+
+
+    /// <summary>
+    /// Draw with another variant of the font's shaders from now on, e.g. a FontShaderFeature::OverdrawHeatmap one.
+    /// Only this instance switches, and the program has to outlive it just like the one it was created with
+    /// </summary>
+    void SetShaderProgram(const ShaderProgram& shaderProgram)
+    {
+        _shaderProgram = shaderProgram;
+
+        ResolveShaderProgram();
+    };
+
+    const ShaderProgram& GetShaderProgram() const
+    {
+        return _shaderProgram.get();
+    };
+
+
+    void Bind(const std::uint32_t textureUnit = 0) const
+    {
+        if(IsReady() == false)
+            return;
+
+        _shaderProgram.get().Bind();
+
+        _shaderProgram.get().SetBool(_supersampleUniform, Supersample);
+
+        UploadTextEffects();
+
+        _shaderProgram.get().SetFloat(_billboardScaleUniform, Billboard.Scale);
+        _shaderProgram.get().SetBool(_billboardConstantScreenSizeUniform, Billboard.ConstantScreenSize);
+
+        _shaderProgram.get().SetBool(_linearBlendingUniform, Blending.Linear);
+        _shaderProgram.get().SetFloat(_coverageContrastUniform, std::max(Blending.Contrast, 0.0f));
+
+        GLState.BindTextureUnit(textureUnit, _font->Texture.Get());
+
+        GLState.BindAttributelessVertexArray(_font->VertexArray.Get());
+
+        BindGlyphMetrics();
+
+        // Ring ranges are bound per draw
+        if(_uploadMode == SSBOMode::PersistentRing)
+            return;
+
+        GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, _inputSSBO2BufferID);
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _inputSSBO2BufferID);
+    };
+
+
+    /// <summary>
+    /// Bind the glyph metrics table to GlyphMetricsBindingIndex
+    /// </summary>
+    void BindGlyphMetrics() const
+    {
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, GlyphMetricsBindingIndex, _font->MetricsSSBO.Get());
+    };
+
+
+    /// <summary>
+    /// Draw a string. Any contiguous characters will do, e.g. a std::pmr::string built in a FrameArena.
+    /// In sub-data mode only the characters that differ from the last string drawn are uploaded, see SetText
+    /// </summary>
+    /// <param name="text"> The text to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void Draw(const std::string_view& text, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        if(text.empty() == true || IsReady() == false)
+            return;
+
+        TEXT_RENDERER_ZONE("FontSprite::Draw");
+
+        if(Recorder != nullptr)
+            Recorder->RecordDraw(Transform, Layout, text, textColour);
+
+        SetText(text, textColour);
+
+        // Update uniforms
+        _shaderProgram.get().SetMatrix4(_textTransformUniform, Transform);
+
+        DrawUploadedCharacters(text.size());
+    };
+
+    /// <summary>
+    /// Draw a string whose layout is kept for as long as the string, Layout and the font stay the same, and only Transform changes.
+    /// Scrolling or zooming it then only changes the transform uniform, nothing is uploaded or laid out again until e.g. the wrap width changes.
+    /// The kept glyphs aren't culled, so the string should already be cut down to about what's visible, like a TextView's window.
+    /// Falls back to Draw in ring mode, whose input only lasts the frame
+    /// </summary>
+    /// <param name="text"> The text to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void DrawRetained(const std::string_view& text, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        if(text.empty() == true || IsReady() == false)
+            return;
+
+        if(_uploadMode == SSBOMode::PersistentRing)
+        {
+            Draw(text, textColour);
+            return;
+        };
+
+        if(Recorder != nullptr)
+            Recorder->RecordDraw(Transform, Layout, text, textColour);
+
+        // Any other draw in between lays its own glyphs over the kept ones
+        const bool layoutRetained = _retainedLayoutGeneration != 0 &&
+                                    _retainedLayoutGeneration == _layoutGeneration &&
+                                    _retainedLayout == Layout &&
+                                    _retainedLayoutFont == GetTextMetricsFont() &&
+                                    _uploadedTextBuffer == nullptr &&
+                                    std::string_view(_uploadedText) == text;
+
+        _shaderProgram.get().SetMatrix4(_textTransformUniform, Transform);
+
+        if(layoutRetained == true)
+        {
+            UploadTextColour(textColour);
+
+            DrawLaidOutGlyphs(text.size());
+            return;
+        };
+
+        SetText(text, textColour);
+
+        DrawUploadedCharacters(text.size(), 0, 0, { }, 0, { }, false);
+
+        _retainedLayoutGeneration = _layoutGeneration;
+        _retainedLayout = Layout;
+        _retainedLayoutFont = GetTextMetricsFont();
+    };
+
+    /// <summary>
+    /// Replace the text with a whole new string without drawing it, for producers that hand over a complete string every tick.
+    /// In sub-data mode the string is compared against the characters already in the input buffer a block at a time, and only the blocks
+    /// that changed are uploaded, so a string with a few changed characters costs about what the edits would. Drawing the same string
+    /// afterwards uploads nothing. In ring mode the whole string is written, and only lasts the frame
+    /// </summary>
+    /// <param name="text"> The text to be drawn next </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    /// <returns> The number of bytes uploaded </returns>
+    std::size_t SetText(const std::string_view& text, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        if(IsReady() == false)
+            return 0;
+
+        // Allocate buffer memory if necessary, at least doubling the capacity so repeated appends reallocate rarely
+        if(text.size() > _capacity)
+            Reserve(std::max(text.size(), _capacity * 2));
+
+        const std::size_t uploadedByteCount = _uploadedByteCount;
+
+        UploadString(text, textColour);
+
+        return _uploadedByteCount - uploadedByteCount;
+    };
+
+    /// <summary>
+    /// Draw UTF-8 text. Plain ASCII, the bulk of most text, is drawn like any string.
+    /// Anything else is uploaded as bytes, a byte per character, and decoded by the layout pass, so it costs no more bandwidth than its UTF-8
+    /// and nothing on the CPU. Malformed sequences are drawn as the replacement character, which is the missing glyph unless the font has one
+    /// </summary>
+    /// <param name="text"> The text to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void Draw(const std::u8string_view& text, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        if(TextConversionKernels::FindPlainRunSSE2(reinterpret_cast<const std::uint8_t*>(text.data()), text.size()) == text.size())
+        {
+            Draw(std::string_view(reinterpret_cast<const char*>(text.data()), text.size()), textColour);
+            return;
+        };
+
+        if(Recorder != nullptr && text.empty() == false && IsReady() == true)
+            Recorder->RecordDraw(Transform, Layout, std::string_view(reinterpret_cast<const char*>(text.data()), text.size()), textColour, true);
+
+        DrawPackedCharacters(std::span<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(text.data()), text.size()), textColour, CharacterEncoding { .Utf8 = true });
+    };
+
+    /// <summary>
+    /// Draw an integer, e.g. a counter, formatted on the stack rather than into a heap string, see FormatInteger
+    /// </summary>
+    void DrawNumber(const std::int64_t value, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        const FormattedNumber number = FormatInteger(value);
+
+        Draw(number.View(), textColour);
+    };
+
+    /// <summary>
+    /// Draw a number with a fixed number of decimals, e.g. a frame time, formatted on the stack rather than into a heap string, see FormatFixed
+    /// </summary>
+    /// <param name="decimals"> At most MaxFixedDecimals </param>
+    void DrawNumber(const double value, const std::uint32_t decimals, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        const FormattedNumber number = FormatFixed(value, decimals);
+
+        Draw(number.View(), textColour);
+    };
+
+    /// <summary>
+    /// Draw std::format output, e.g. a telemetry readout, formatted into a buffer on the stack rather than into a heap string.
+    /// Output past FormattedTextCapacity characters is cut off
+    /// </summary>
+    template<typename... TArguments>
+    void DrawFormat(const glm::vec4& textColour, const std::format_string<TArguments...> format, TArguments&&... arguments) const
+    {
+        std::array<char, FormattedTextCapacity> characters;
+
+        const std::format_to_n_result<char*> result = std::format_to_n(characters.data(), static_cast<std::ptrdiff_t>(characters.size()), format, std::forward<TArguments>(arguments)...);
+
+        Draw(std::string_view(characters.data(), static_cast<std::size_t>(result.out - characters.data())), textColour);
+    };
+
+    /// <summary>
+    /// Draw characters that are already packed, e.g. codepoints read out of a mapped file or a network buffer.
+    /// They're uploaded as they are, one element per character, and the layout pass reads them at the element's width,
+    /// so nothing is converted or copied on the CPU. The layout pass looks every character up in the font's glyph table,
+    /// characters without a glyph are drawn with the fallback glyph
+    /// </summary>
+    /// <param name="characters"> The characters to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void Draw(const std::span<const std::uint8_t>& characters, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        DrawPackedCharacters(characters, textColour);
+    };
+
+    void Draw(const std::span<const std::uint16_t>& characters, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        DrawPackedCharacters(characters, textColour);
+    };
+
+    void Draw(const std::span<const std::uint32_t>& characters, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        DrawPackedCharacters(characters, textColour);
+    };
+
+    /// <summary>
+    /// Set the colours DrawPaletted's characters pick from, e.g. a syntax highlighting theme. Index 0 is always the draw's own colour
+    /// </summary>
+    /// <param name="colours"> Up to 256 colours, the first one is never used </param>
+    void SetPalette(const std::span<const glm::vec4>& colours)
+    {
+        wt::Assert(colours.size() <= (1u << PaletteIndexBits<std::uint32_t>), "Too many palette colours");
+
+        std::array<std::uint32_t, 1u << PaletteIndexBits<std::uint32_t>> packedColours = { };
+
+        std::transform(colours.begin(), colours.end(), packedColours.begin(), PackSpanColour);
+
+        if(_paletteBuffer.Get() == 0)
+        {
+            _paletteBuffer = GLBuffer::Create();
+            glNamedBufferStorage(_paletteBuffer.Get(), static_cast<GLsizeiptr>(sizeof(packedColours)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+            GPUMemory.TrackBuffer(_paletteBuffer.Get(), sizeof(packedColours), GPUMemoryCategory::FontData);
+        };
+
+        glNamedBufferSubData(_paletteBuffer.Get(), 0, static_cast<GLsizeiptr>(sizeof(packedColours)), packedColours.data());
+    };
+
+    /// <summary>
+    /// Draw characters that each carry a palette index in their high bits, see PackPalettedCharacter, e.g. syntax highlighted code.
+    /// The colour costs no bandwidth beyond the character itself, unlike a colour per character, and the layout pass writes it into the glyph's instance.
+    /// 16-bit characters have 16 colours for characters below 4096, 32-bit ones 256 for any codepoint. Needs SetPalette and a program with FontShaderFeature::Styles
+    /// </summary>
+    /// <param name="characters"> The characters to be drawn </param>
+    /// <param name="textColour"> The colour of characters with palette index 0 </param>
+    void DrawPaletted(const std::span<const std::uint16_t>& characters, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        DrawPalettedCharacters(characters, textColour);
+    };
+
+    void DrawPaletted(const std::span<const std::uint32_t>& characters, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        DrawPalettedCharacters(characters, textColour);
+    };
+
+    /// <summary>
+    /// Draw a string whose spans each have their own colour and style, in a single draw.
+    /// The spans are uploaded next to the text, the layout pass finds every glyph's span and writes its colour and style into the glyph's instance
+    /// </summary>
+    /// <param name="text"> The text to be drawn </param>
+    /// <param name="spans"> Sorted by FirstCharacter. Characters before the first span are drawn in textColour. Spans with a background are drawn over it, see SetSpanBackground </param>
+    /// <param name="textColour"> The colour of characters no span covers </param>
+    void DrawStyled(const std::string_view& text, const std::span<const TextSpan>& spans, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        if(text.empty() == true || IsReady() == false)
+            return;
+
+        wt::Assert(std::is_sorted(spans.begin(), spans.end(), [](const TextSpan& left, const TextSpan& right)
+        {
+            return left.FirstCharacter < right.FirstCharacter;
+        }) == true, "Text spans must be sorted by their first character");
+
+        WT_ASSERT(_shaderProgram.get().HasDefine("STYLED_TEXT") == true, "Styled text needs a program with FontShaderFeature::Styles");
+
+        if(text.size() > _capacity)
+            Reserve(std::max(text.size(), _capacity * 2));
+
+        _shaderProgram.get().SetMatrix4(_textTransformUniform, Transform);
+
+        UploadString(text, textColour);
+
+        UploadTextSpans(spans);
+
+        DrawUploadedCharacters(text.size(), static_cast<std::uint32_t>(spans.size()), 0, { }, CountBackgroundCharacters(spans, text.size()));
+    };
+
+    /// <summary>
+    /// The instances a string drawn with DrawCached was laid out into with the current Layout, e.g. to animate it with a TextAnimator.
+    /// Null if the string isn't cached, it's laid out by its first DrawCached
+    /// </summary>
+    const GlyphRunCache::Run* FindCachedRun(const std::string& text) const
+    {
+        if(_glyphRunCache.has_value() == false)
+            return nullptr;
+
+        return _glyphRunCache->Find(text, Layout);
+    };
+
+    /// <summary>
+    /// Draw a string through the glyph run cache. The first time a string is drawn with the current Layout it's uploaded and laid out into the cache,
+    /// after that only Transform and the colour change, and the run is drawn as it is.
+    /// Cached runs aren't culled, so long strings that are mostly off screen are better drawn with Draw.
+    /// Falls back to Draw if the cache isn't enabled, see EnableGlyphRunCache
+    /// </summary>
+    /// <param name="text"> The text to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void DrawCached(const std::string& text, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        DrawCached(text, 0, GlyphRunCache::AllGlyphs, textColour);
+    };
+
+    /// <summary>
+    /// Draw some of a string's glyphs through the glyph run cache, e.g. a typewriter reveal or a page of a long string.
+    /// The range only changes the draw's base instance and instance count, so a reveal lays the string out once and uploads nothing after that.
+    /// Spaces and control characters have no glyph, see GlyphRunCache::CountGlyphs. Falls back to drawing the whole string, like DrawCached
+    /// </summary>
+    /// <param name="text"> The whole string, the same one every time so its run is found </param>
+    /// <param name="firstGlyph"> The first glyph drawn </param>
+    /// <param name="glyphCount"> Clamped to the string's end </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void DrawCached(const std::string& text, const std::uint32_t firstGlyph, const std::uint32_t glyphCount, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        DrawCachedRun(text, InternedString(), firstGlyph, glyphCount, textColour);
+    };
+
+    /// <summary>
+    /// Draw an interned string through the glyph run cache. Its run is found by id, so a string drawn every frame
+    /// isn't hashed, compared, converted or uploaded again, see StringTable
+    /// </summary>
+    /// <param name="strings"> The table the string was interned in, the same one for every interned string the sprite draws </param>
+    /// <param name="string"> The string to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void DrawCached(const StringTable& strings, const InternedString string, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        UseInternedStrings(strings);
+
+        DrawCachedRun(strings.Get(string), string, 0, GlyphRunCache::AllGlyphs, textColour);
+    };
+
+    /// <summary>
+    /// Queue an interned string through the glyph run cache, see QueueCached and the interned DrawCached
+    /// </summary>
+    void QueueCached(const StringTable& strings, const InternedString string, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        UseInternedStrings(strings);
+
+        QueueCachedRun(strings.Get(string), string, 0, GlyphRunCache::AllGlyphs, textColour);
+    };
+
+    /// <summary>
+    /// Queue a string through the glyph run cache, drawn with the current Transform by the next SubmitQueued.
+    /// Every queued string is drawn by a single multi-draw, for screens with many short strings that each used to be a draw call.
+    /// Strings that aren't cached yet are laid out right away, like DrawCached. Falls back to Draw if the cache isn't enabled
+    /// </summary>
+    /// <param name="text"> The text to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void QueueCached(const std::string& text, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        QueueCached(text, 0, GlyphRunCache::AllGlyphs, textColour);
+    };
+
+    /// <summary>
+    /// Queue some of a string's glyphs through the glyph run cache, see the DrawCached overload with a glyph range
+    /// </summary>
+    /// <param name="text"> The whole string, the same one every time so its run is found </param>
+    /// <param name="firstGlyph"> The first glyph drawn </param>
+    /// <param name="glyphCount"> Clamped to the string's end </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void QueueCached(const std::string& text, const std::uint32_t firstGlyph, const std::uint32_t glyphCount, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        QueueCachedRun(text, InternedString(), firstGlyph, glyphCount, textColour);
+    };
+
+    /// <summary>
+    /// Draw every string queued by QueueCached with one glMultiDrawArraysIndirect. Call once all of a frame's strings were queued
+    /// </summary>
+    void SubmitQueued() const
+    {
+        if(_glyphRunCache.has_value() == false || _glyphRunCache->GetQueuedDrawCount() == 0)
+            return;
+
+        WT_ASSERT(_shaderProgram.get().HasDefine("MULTI_DRAW") == true, "Queued text needs a program with FontShaderFeature::MultiDraw");
+
+        const ProfileScope drawScope = ProfileScope(Profiler, "Glyph draw", AllocationSubsystem::Font);
+        const PipelineStatisticsScope statisticsScope = PipelineStatisticsScope(PipelineStatistics, "Glyph draw");
+
+        // The vertex shader still reads the atlas size and chroma key out of the input block, the colour comes from the queued draws
+        if(_uploadMode == SSBOMode::PersistentRing)
+            UploadToRing(0, glm::vec4(1.0f), [](std::byte*) { });
+
+        _shaderProgram.get().SetBool(_multiDrawUniform, true);
+
+        _shaderProgram.get().Bind();
+
+        {
+            const std::optional<ScopedBlendFunc> blendFunc = BlendGlyphs();
+            const std::optional<ScopedEnable> linearBlending = BlendLinearly();
+
+            _glyphRunCache->Bind();
+
+            _glyphRunCache->SubmitQueued();
+        };
+
+        _shaderProgram.get().SetBool(_multiDrawUniform, false);
+    };
+
+    /// <summary>
+    /// Draw the contents of a TextBuffer. 
+    /// In sub-data mode only the range changed since the buffer was last drawn is uploaded, so edits don't have to be diffed against the previous text
+    /// </summary>
+    /// <param name="text"> The text to be drawn, its dirty range is consumed </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void Draw(TextBuffer& text, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        // The dirty range is kept for once the atlas is ready
+        if(IsReady() == false)
+            return;
+
+        const TextDirtyRange dirtyRange = text.TakeDirtyRange();
+
+        if(text.IsEmpty() == true)
+            return;
+
+        TEXT_RENDERER_ZONE("FontSprite::Draw");
+
+        if(Recorder != nullptr)
+            Recorder->RecordDraw(Transform, Layout, text, dirtyRange, textColour);
+
+        if(text.GetSize() > _capacity)
+            Reserve(std::max(text.GetSize(), _capacity * 2));
+
+        _shaderProgram.get().SetMatrix4(_textTransformUniform, Transform);
+
+
+        {
+            const ProfileScope uploadScope = ProfileScope(Profiler, "Text upload", AllocationSubsystem::Font);
+
+            if(_uploadMode == SSBOMode::PersistentRing)
+            {
+                // Every region of the ring is rewritten each frame anyway
+                UploadToRing(text.GetSize(), textColour, [&](std::byte* destination)
+                {
+                    PackTextBuffer(text, 0, text.GetSize(), destination);
+                });
+            }
+            else
+            {
+                // A different text was uploaded since this buffer was last drawn, all of it has to be uploaded again
+                if(_uploadedTextBuffer != &text)
+                    UploadToBuffer(text, TextDirtyRange { 0, text.GetSize() }, textColour);
+                else
+                    UploadToBuffer(text, dirtyRange, textColour);
+            };
+        };
+
+
+        DrawUploadedCharacters(text.GetSize());
+    };
+
+
+    /// <summary>
+    /// Draw a window of a TextRing's lines. Only the characters appended since the ring was last uploaded are written,
+    /// the layout pass reads the window straight out of the ring, wrapping around its end
+    /// </summary>
+    /// <param name="text"> The ring to draw from, its pending characters are uploaded </param>
+    /// <param name="window"> Which of the ring's characters to draw, see TextRing::GetLines and TextRing::GetLastLines </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void Draw(TextRing& text, const TextRingWindow& window, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        if(IsReady() == false)
+            return;
+
+        {
+            const ProfileScope uploadScope = ProfileScope(Profiler, "Text upload", AllocationSubsystem::Font);
+
+            text.Upload();
+
+            if(window.IsEmpty() == true)
+                return;
+
+            // The ring holds its own copy of the header, the vertex shader reads the colour and atlas size out of it
+            const Input header =
+            {
+                .GlyphWidth = _glyphWidth,
+                .GlyphHeight = _glyphHeight,
+                .TextureWidth = _font->Width,
+                .TextureHeight = _font->Height,
+                .ChromaKey = _chromaKey,
+                .TextColour = textColour,
+            };
+
+            glNamedBufferSubData(text.GetBufferID(), 0, sizeof(header), &header);
+
+            _uploadedByteCount += sizeof(header);
+        };
+
+        _shaderProgram.get().SetMatrix4(_textTransformUniform, Transform);
+
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, text.GetBufferID());
+
+        const CharacterRing ring =
+        {
+            .Capacity = static_cast<std::uint32_t>(text.GetCapacity()),
+            .FirstCharacter = static_cast<std::uint32_t>(window.FirstCharacter % text.GetCapacity()),
+        };
+
+        // Rings are always stored 8 bits per character, whatever the sprite's own packing
+        DrawUploadedCharacters(window.CharacterCount, 0, static_cast<std::uint32_t>(CharacterPacking::Bits8), ring);
+
+        // Ring ranges are bound per draw, otherwise the next draw expects the sprite's own input buffer
+        if(_uploadMode != SSBOMode::PersistentRing)
+            GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _inputSSBO2BufferID);
+    };
+
+
+    /// <summary>
+    /// Keep laid out strings on the GPU for DrawCached. Replaces and empties an existing cache
+    /// </summary>
+    /// <param name="instanceCapacity"> The total number of characters of every cached string </param>
+    /// <param name="runCapacity"> The number of strings that can be cached at once </param>
+    void EnableGlyphRunCache(const std::uint32_t instanceCapacity = 65536, const std::uint32_t runCapacity = 1024)
+    {
+        _glyphRunCache.reset();
+        _glyphRunCache.emplace(instanceCapacity, runCapacity);
+    };
+
+    /// <summary>
+    /// (Glyph run cache) The number of strings currently cached, 0 if the cache isn't enabled
+    /// </summary>
+    std::size_t GetCachedRunCount() const
+    {
+        return _glyphRunCache.has_value() == true ? _glyphRunCache->GetRunCount() : 0;
+    };
+
+
+    /// <summary>
+    /// Delete the font's pooled input buffers that no instance is using, e.g. from a GPUMemory eviction handler.
+    /// Instances created or grown later create new ones
+    /// </summary>
+    /// <returns> Whether any buffer was deleted </returns>
+    bool ReleasePooledBuffers() const
+    {
+        if(_font->InputBuffers.GetFreeCount() == 0)
+            return false;
+
+        _font->InputBuffers.Clear();
+
+        return true;
+    };
+
+
+    /// <summary>
+    /// Make sure strings of up to a number of characters can be drawn without reallocating the input buffer
+    /// </summary>
+    /// <param name="characterCount"> The number of characters to reserve space for </param>
+    void Reserve(const std::size_t characterCount) const
+    {
+        if(characterCount <= _capacity)
+            return;
+
+        const std::size_t previousBufferSizeInBytes = GetInputBufferSizeInBytes();
+
+        // Characters[] is unsized, so growing only changes the buffer size, the layout stays the same
+        _capacity = characterCount;
+
+        wt::etw::BufferReallocation("FontSprite input", previousBufferSizeInBytes, GetInputBufferSizeInBytes());
+
+
+        if(_uploadMode == SSBOMode::PersistentRing)
+        {
+            if(GetInputBufferSizeInBytes() > _inputRingBuffer->GetRegionSizeInBytes())
+                _inputRingBuffer->Reallocate(GetInputBufferSizeInBytes());
+
+            return;
+        };
+
+
+        // Pooled buffers are rounded up, the current one may already be large enough
+        if(BufferPool::GetPooledSize(GetInputBufferSizeInBytes()) == BufferPool::GetPooledSize(previousBufferSizeInBytes))
+            return;
+
+        const std::uint32_t newInputBuffer = _font->InputBuffers.Acquire(GetInputBufferSizeInBytes());
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, newInputBuffer);
+
+        const std::uint32_t previousInputBuffer = std::exchange(_inputSSBO2BufferID, newInputBuffer);
+
+        if(InputGrowthMode == BufferGrowthMode::Copy)
+            glCopyNamedBufferSubData(previousInputBuffer, newInputBuffer, 0, 0, previousBufferSizeInBytes);
+
+        // Draws already issued keep reading the old buffer, it's only reused once they're done instead of synchronizing now
+        _font->InputBuffers.Release(previousInputBuffer, previousBufferSizeInBytes);
+
+        if(InputGrowthMode == BufferGrowthMode::Copy)
+            return;
+
+        // Only the header is written back, the characters are uploaded in full by the draw that follows
+        FontSpriteInputLayout::Set<"GlyphWidth">(_inputSSBO2BufferID, _glyphWidth);
+        FontSpriteInputLayout::Set<"GlyphHeight">(_inputSSBO2BufferID, _glyphHeight);
+
+        FontSpriteInputLayout::Set<"TextureWidth">(_inputSSBO2BufferID, _font->Width);
+        FontSpriteInputLayout::Set<"TextureHeight">(_inputSSBO2BufferID, _font->Height);
+
+        FontSpriteInputLayout::Set<"ChromaKey">(_inputSSBO2BufferID, _chromaKey);
+
+        if(_uploadedTextColour.has_value() == true)
+            FontSpriteInputLayout::Set<"TextColour">(_inputSSBO2BufferID, *_uploadedTextColour);
+
+        _uploadedText.clear();
+        _uploadedTextBuffer = nullptr;
+    };
+
+
+    /// <summary>
+    /// Signal that all of the current frame's draws were issued. 
+    /// In ring mode this fences the frame's region and moves on to the next one
+    /// </summary>
+    void EndFrame() const
+    {
+        if(_inputRingBuffer.has_value() == true)
+            _inputRingBuffer->NextFrame();
+
+        if(_glyphRunCache.has_value() == true)
+            _glyphRunCache->EndFrame();
+    };
+
+
+    /// <summary>
+    /// The total number of bytes written to the GPU by draws since construction
+    /// </summary>
+    std::size_t GetUploadedByteCount() const
+    {
+        return _uploadedByteCount;
+    };
+
+
+    std::uint32_t GetGlyphWidth() const
+    {
+        return _glyphWidth;
+    };
+
+    std::uint32_t GetGlyphHeight() const
+    {
+        return _glyphHeight;
+    };
+
+    /// <summary>
+    /// The distance between rows of text, in pixels
+    /// </summary>
+    /// <returns></returns>
+    /// <summary>
+    /// Whether glyphs are positioned by their advances and kerning rather than in fixed width columns
+    /// </summary>
+    bool IsProportional() const
+    {
+        return _font->Proportional;
+    };
+
+    AtlasFormat GetAtlasFormat() const
+    {
+        return _atlasFormat;
+    };
+
+    /// <summary>
+    /// Whether the atlas has a glyph of its own for a codepoint, rather than drawing it as the missing glyph, see FontFallbackChain
+    /// </summary>
+    bool HasGlyph(const char32_t codepoint) const
+    {
+        // Missing characters map to the table's default value, the missing glyph
+        return _font->GlyphTable.Find(codepoint) != _font->GlyphTable.GetDefaultValue();
+    };
+
+    /// <summary>
+    /// The index of a codepoint's glyph in the atlas' metrics, the missing glyph's if it has none
+    /// </summary>
+    std::uint32_t GetGlyphIndex(const char32_t codepoint) const
+    {
+        return _font->GlyphTable.Find(codepoint);
+    };
+
+    float GetLineHeight() const
+    {
+        return Layout.LineHeight > 0.0f ? Layout.LineHeight : static_cast<float>(_glyphHeight);
+    };
+
+    /// <summary>
+    /// (Atlas packages) The adjustment to a character's advance when it's followed by another, in pixels.
+    /// The GPU layout applies the same adjustments through the glyph-indexed kerning table, this is for CPU-side measurement
+    /// </summary>
+    float GetKerning(const char32_t first, const char32_t second) const
+    {
+        const auto pair = std::lower_bound(_font->KerningPairs.cbegin(), _font->KerningPairs.cend(), std::pair(first, second), [](const KerningPair& kerningPair, const std::pair<char32_t, char32_t>& characters)
+        {
+            return std::pair<char32_t, char32_t>(kerningPair.First, kerningPair.Second) < characters;
+        });
+
+        if(pair == _font->KerningPairs.cend() || pair->First != first || pair->Second != second)
+            return 0.0f;
+
+        return pair->Adjustment;
+    };
+
+
+    /// <summary>
+    /// Lay a string out on the CPU with the current Layout, the way the layout pass will, for measuring and hit-testing it.
+    /// Cached by text and layout, a string measured before is only looked up. Only valid until the next call
+    /// </summary>
+    const TextMetrics& GetTextMetrics(const std::string_view& text) const
+    {
+        const TextMetricsFont font = GetTextMetricsFont();
+
+        const auto kerning = [this](const char32_t first, const char32_t second)
+        {
+            return GetKerning(first, second);
+        };
+
+        if(IsReady() == false)
+        {
+            _uncachedTextMetrics = TextMetrics::Build(text, Layout, font, kerning);
+
+            return _uncachedTextMetrics;
+        };
+
+        return _textMetricsCache.Get(text, Layout, font, kerning);
+    };
+
+    /// <summary>
+    /// What laying text out on the CPU needs to know about the font, see TextMetrics::Build. Instances sharing a font share its advances
+    /// </summary>
+    TextMetricsFont GetTextMetricsFont() const
+    {
+        return TextMetricsFont
+        {
+            .Advances = &_font->Advances,
+            .GlyphWidth = _glyphWidth,
+            .LineHeight = static_cast<float>(_glyphHeight),
+            .Proportional = _font->Proportional,
+        };
+    };
+
+    /// <summary>
+    /// The size a string is drawn at, the width of its widest row and the height of its rows, in pixels before the Transform
+    /// </summary>
+    glm::vec2 MeasureText(const std::string_view& text) const
+    {
+        return GetTextMetrics(text).GetSize();
+    };
+
+    /// <summary>
+    /// The character boundary of a string, as drawn with the current Transform, nearest to a point on screen. For placing a caret with the mouse
+    /// </summary>
+    /// <param name="point"> In screen space, e.g. the cursor's position </param>
+    /// <returns> A character index, the text's size for its end </returns>
+    std::size_t HitTest(const std::string_view& text, const glm::vec2& point) const
+    {
+        const glm::vec4 textPoint = glm::inverse(Transform) * glm::vec4(point, 0.0f, 1.0f);
+
+        return GetTextMetrics(text).HitTest({ textPoint.x, textPoint.y });
+    };
+
+
+    /// <summary>
+    /// The fewest shader features a font's draws need, so it can be drawn with the cheapest variant of its shaders.
+    /// Pass the result to ShaderVariants::Get, built with FontShaderFeatureDefines, for the program the font is created with
+    /// </summary>
+    /// <param name="atlasFormat"> The font's atlas format </param>
+    /// <param name="styled"> Whether the font is drawn with DrawStyled </param>
+    /// <param name="queued"> Whether the font is drawn with QueueCached </param>
+    static std::uint32_t GetShaderFeatures(const AtlasFormat atlasFormat, const bool styled, const bool queued)
+    {
+        std::uint32_t features = static_cast<std::uint32_t>(FontShaderFeature::None);
+
+        if(styled == true)
+            features |= static_cast<std::uint32_t>(FontShaderFeature::Styles);
+
+        if(queued == true)
+            features |= static_cast<std::uint32_t>(FontShaderFeature::MultiDraw);
+
+        if(atlasFormat == AtlasFormat::DistanceField)
+            features |= static_cast<std::uint32_t>(FontShaderFeature::Supersample);
+
+        return features;
+    };
+
+
+    /// <summary>
+    /// Convert a font image into an atlas package, in the pixel format the atlas format is uploaded in, with the image's grid as its glyph metrics.
+    /// Loading the package skips decoding and conversion entirely, its pixels are uploaded straight out of the mapped file
+    /// </summary>
+    /// <param name="image"> The font's image, laid out as a grid of glyphSize cells </param>
+    /// <param name="blockCompress"> (Coverage and distance field atlases) Store the pixels BC4 compressed, an eighth of their size in memory and on the GPU </param>
+    /// <param name="stream"> Receives the package, must be opened in binary mode </param>
+    static void BakeAtlasPackage(const TextureImage& image, const glm::uvec2& glyphSize, const AtlasFormat atlasFormat, const glm::vec4& chromaKey, const bool blockCompress, std::ostream& stream)
+    {
+        FontAtlasPixelFormat pixelFormat = FontAtlasPixelFormat::R8;
+
+        std::vector<std::byte> convertedPixels;
+
+        std::span<const std::byte> pixels = ConvertAtlasImage(image, glyphSize, atlasFormat, chromaKey, pixelFormat, convertedPixels);
+
+        std::vector<std::byte> compressedPixels;
+
+        if(blockCompress == true && pixelFormat == FontAtlasPixelFormat::R8)
+        {
+            compressedPixels.resize(GetBC4SizeInBytes(image.Width, image.Height));
+
+            CompressBC4(pixels.data(), image.Width, compressedPixels.data(), image.Width, image.Height);
+
+            pixelFormat = FontAtlasPixelFormat::BC4;
+            pixels = compressedPixels;
+        };
+
+        const std::vector<GlyphMetrics> glyphMetrics = BuildInkGlyphMetrics(image, glyphSize, atlasFormat, chromaKey);
+
+        const FontAtlasHeader header =
+        {
+            .PixelFormat = pixelFormat,
+            .Flags = atlasFormat == AtlasFormat::DistanceField ? FontAtlasFlags::DistanceField :
+                     atlasFormat == AtlasFormat::Subpixel ? FontAtlasFlags::Subpixel :
+                     FontAtlasFlags::None,
+            .Width = image.Width,
+            .Height = image.Height,
+            .GlyphWidth = glyphSize.x,
+            .GlyphHeight = glyphSize.y,
+        };
+
+        WriteFontAtlasPackage(stream, header, glyphMetrics, { }, pixels);
+    };
+
+
+private:
+
+    /// <summary>
+    /// The number of frames the CPU can write ahead of the GPU in ring mode
+    /// </summary>
+    static constexpr std::uint32_t FramesInFlight = 3;
+
+    /// <summary>
+    /// The most characters DrawFormat draws
+    /// </summary>
+    static constexpr std::size_t FormattedTextCapacity = 256;
+
+    /// <summary>
+    /// (Sub-data mode) Strings are diffed against the uploaded text in blocks of this many characters, each compared with a single memcmp
+    /// </summary>
+    static constexpr std::size_t TextDiffBlockSize = 64;
+
+    /// <summary>
+    /// (Sub-data mode) Changed ranges closer than this many characters are uploaded together, a few unchanged bytes cost less than another upload call
+    /// </summary>
+    static constexpr std::size_t TextDiffMergeDistance = 256;
+
+    /// <summary>
+    /// (Sub-data mode) Character ranges of this many bytes or more go through Uploads, if set
+    /// </summary>
+    static constexpr std::size_t LargeUploadSize = 1024 * 1024;
+
+
+    /// <summary>
+    /// Bind what the layout pass looks glyphs up in: the codepoint table, and for proportional fonts the metrics and kerning
+    /// </summary>
+    void BindLayoutTables() const
+    {
+        _font->GlyphTable.Bind();
+
+        if(_font->Proportional == false)
+            return;
+
+        BindGlyphMetrics();
+
+        _font->Kerning.Bind();
+    };
+
+
+    /// <summary>
+    /// Lay out the characters in the input block, then draw them
+    /// </summary>
+    /// <param name="characterCount"> The number of characters uploaded </param>
+    /// <param name="spanCount"> The number of spans uploaded for a styled draw, see DrawStyled </param>
+    /// <param name="bitsPerCharacter"> How the characters are packed, 0 for the sprite's own packing </param>
+    /// <param name="ring"> (Text rings) Where the characters are in the ring bound as the input block </param>
+    /// <param name="backgroundCount"> The number of characters in spans with a background </param>
+    /// <param name="encoding"> How the layout pass reads the characters, see TextLayout::Dispatch </param>
+    /// <param name="cullGlyphs"> False to keep the glyphs outside the viewport too, see DrawRetained </param>
+    void DrawUploadedCharacters(const std::size_t characterCount,
+                                const std::uint32_t spanCount = 0,
+                                const std::uint32_t bitsPerCharacter = 0,
+                                const CharacterRing& ring = { },
+                                const std::size_t backgroundCount = 0,
+                                const CharacterEncoding& encoding = { },
+                                const bool cullGlyphs = true) const
+    {
+        // The whole text is laid out, culled and compacted by the GPU, which also decides the draw's instance count.
+        // The layout pass switches programs so the draw's is bound again after it
+        {
+            const ProfileScope layoutScope = ProfileScope(Profiler, "Text layout", AllocationSubsystem::Layout);
+
+            BindLayoutTables();
+
+            _textLayout.Dispatch(characterCount, bitsPerCharacter != 0 ? bitsPerCharacter : static_cast<std::uint32_t>(_characterPacking),
+                                 _glyphWidth, _glyphHeight, Transform, Layout, _font->Proportional, spanCount, ring, backgroundCount, encoding, cullGlyphs);
+
+            ++_layoutGeneration;
+        };
+
+        DrawLaidOutGlyphs(characterCount);
+    };
+
+    /// <summary>
+    /// Draw the glyphs the last layout pass left in the TextLayout's buffers
+    /// </summary>
+    /// <param name="characterCount"> The number of characters they were laid out from, for tracing </param>
+    void DrawLaidOutGlyphs(const std::size_t characterCount) const
+    {
+        const ProfileScope drawScope = ProfileScope(Profiler, "Glyph draw", AllocationSubsystem::Font);
+        const PipelineStatisticsScope statisticsScope = PipelineStatisticsScope(PipelineStatistics, "Glyph draw");
+
+        _shaderProgram.get().Bind();
+
+        const std::optional<ScopedBlendFunc> blendFunc = BlendGlyphs();
+        const std::optional<ScopedEnable> linearBlending = BlendLinearly();
+
+        _textLayout.BindGlyphInstances();
+
+        _textLayout.DrawGlyphs();
+
+        // Everything uploaded since the previous draw was for this one
+        wt::etw::FontSpriteDraw(characterCount, _uploadedByteCount - std::exchange(_tracedUploadedByteCount, _uploadedByteCount));
+    };
+
+    /// <summary>
+    /// (Subpixel atlases) Blend the glyph draw by the fragment shader's second output, the coverage of each colour channel.
+    /// (Linear blending) Blend premultiplied coverage.
+    /// (Overdraw heatmaps) Add the draw's fragments up.
+    /// The blending before it is restored when the scope ends, so the rest of the frame blends as it did
+    /// </summary>
+    std::optional<ScopedBlendFunc> BlendGlyphs() const
+    {
+        // Fragments add up, whatever the atlas
+        if(_overdrawHeatmap == true)
+            return std::optional<ScopedBlendFunc>(std::in_place, GL_ONE, GL_ONE);
+
+        if(_atlasFormat == AtlasFormat::Subpixel)
+            return std::optional<ScopedBlendFunc>(std::in_place, GL_SRC1_COLOR, GL_ONE_MINUS_SRC1_COLOR);
+
+        if(Blending.Linear == true)
+            return std::optional<ScopedBlendFunc>(std::in_place, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+        return std::nullopt;
+    };
+
+    /// <summary>
+    /// (Linear blending) Let the framebuffer decode and encode sRGB around the blend, for the glyph draw
+    /// </summary>
+    std::optional<ScopedEnable> BlendLinearly() const
+    {
+        if(Blending.Linear == false || _overdrawHeatmap == true)
+            return std::nullopt;
+
+        return std::optional<ScopedEnable>(std::in_place, GL_FRAMEBUFFER_SRGB);
+    };
+
+
+    template<typename TCharacter>
+    void DrawPalettedCharacters(const std::span<const TCharacter>& characters, const glm::vec4& textColour) const
+    {
+        wt::Assert(_paletteBuffer.Get() != 0, "Paletted text needs a palette, see SetPalette");
+
+        WT_ASSERT(_shaderProgram.get().HasDefine("STYLED_TEXT") == true, "Paletted text needs a program with FontShaderFeature::Styles");
+
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, TextPaletteBindingIndex, _paletteBuffer.Get());
+
+        DrawPackedCharacters(characters, textColour, CharacterEncoding { .PaletteBits = PaletteIndexBits<TCharacter> });
+    };
+
+    /// <summary>
+    /// Upload characters that are already packed at their own width, and draw them
+    /// </summary>
+    /// <param name="encoding"> How the layout pass reads the characters, e.g. as UTF-8 bytes </param>
+    template<typename TCharacter>
+    void DrawPackedCharacters(const std::span<const TCharacter>& characters, const glm::vec4& textColour, const CharacterEncoding& encoding = { }) const
+    {
+        if(characters.empty() == true || IsReady() == false)
+            return;
+
+        constexpr std::size_t bitsPerCharacter = sizeof(TCharacter) * 8;
+
+        // Capacity is counted in characters of the sprite's own packing, this many take as many bytes as the packed characters
+        const std::size_t spriteCharacterCount = (characters.size_bytes() * 8 + (static_cast<std::size_t>(_characterPacking) - 1)) / static_cast<std::size_t>(_characterPacking);
+
+        if(spriteCharacterCount > _capacity)
+            Reserve(std::max(spriteCharacterCount, _capacity * 2));
+
+        _shaderProgram.get().SetMatrix4(_textTransformUniform, Transform);
+
+        {
+            const ProfileScope uploadScope = ProfileScope(Profiler, "Text upload", AllocationSubsystem::Font);
+
+            if(_uploadMode == SSBOMode::PersistentRing)
+            {
+                UploadToRing(spriteCharacterCount, textColour, [&](std::byte* destination)
+                {
+                    std::memcpy(destination, characters.data(), characters.size_bytes());
+                });
+            }
+            else
+            {
+                UploadTextColour(textColour);
+
+                glNamedBufferSubData(_inputSSBO2BufferID, FontSpriteInputLayout::GetOffset<"Characters">(), static_cast<GLsizeiptr>(characters.size_bytes()), characters.data());
+
+                _uploadedByteCount += characters.size_bytes();
+
+                // Neither string path can diff against these
+                _uploadedText.clear();
+                _uploadedTextBuffer = nullptr;
+            };
+        };
+
+        DrawUploadedCharacters(characters.size(), 0, static_cast<std::uint32_t>(bitsPerCharacter), { }, 0, encoding);
+    };
+
+
+    /// <summary>
+    /// Upload a string into the input block, however the sprite uploads. The input buffer must already fit it
+    /// </summary>
+    /// <param name="text"> The text to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void UploadString(const std::string_view& text, const glm::vec4& textColour) const
+    {
+        const ProfileScope uploadScope = ProfileScope(Profiler, "Text upload", AllocationSubsystem::Font);
+
+        if(_uploadMode == SSBOMode::PersistentRing)
+        {
+            UploadToRing(text.size(), textColour, [&](std::byte* destination)
+            {
+                PackCharacters(text, destination);
+            });
+        }
+        else
+            UploadToBuffer(text, textColour);
+    };
+
+
+    /// <summary>
+    /// Write a styled draw's spans, growing the buffer if necessary, and bind them to TextSpansBindingIndex
+    /// </summary>
+    void UploadTextSpans(const std::span<const TextSpan>& spans) const
+    {
+        if(spans.empty() == true)
+            return;
+
+        if(spans.size() > _textSpansCapacity)
+        {
+            _textSpansCapacity = std::max(spans.size(), _textSpansCapacity * 2);
+
+            _textSpansBuffer = GLBuffer::Create();
+            glNamedBufferStorage(_textSpansBuffer.Get(), static_cast<GLsizeiptr>(_textSpansCapacity * sizeof(TextSpan)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+            GPUMemory.TrackBuffer(_textSpansBuffer.Get(), _textSpansCapacity * sizeof(TextSpan), GPUMemoryCategory::TextBuffer);
+        };
+
+        glNamedBufferSubData(_textSpansBuffer.Get(), 0, static_cast<GLsizeiptr>(spans.size_bytes()), spans.data());
+
+        _uploadedByteCount += spans.size_bytes();
+
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, TextSpansBindingIndex, _textSpansBuffer.Get());
+    };
+
+
+    /// <summary>
+    /// Draw a string's run, found by its interned id if it has one, see DrawCached
+    /// </summary>
+    void DrawCachedRun(const std::string_view& text, const InternedString string, const std::uint32_t firstGlyph, const std::uint32_t glyphCount, const glm::vec4& textColour) const
+    {
+        if(text.empty() == true || IsReady() == false)
+            return;
+
+        if(_glyphRunCache.has_value() == false)
+        {
+            Draw(text, textColour);
+            return;
+        };
+
+        const GlyphRunCache::Run* run = FindRun(text, string);
+
+        const bool cacheMiss = run == nullptr;
+
+        if(cacheMiss == true)
+            run = AddRun(text, string);
+
+        // Too long for the whole cache
+        if(run == nullptr)
+        {
+            Draw(text, textColour);
+            return;
+        };
+
+
+        _shaderProgram.get().SetMatrix4(_textTransformUniform, Transform);
+
+        if(cacheMiss == true)
+            LayOutCachedRun(text, *run, textColour);
+        else
+        {
+            // The vertex shader still reads the colour and atlas size out of the input block, but no characters
+            const ProfileScope uploadScope = ProfileScope(Profiler, "Text upload", AllocationSubsystem::Font);
+
+            if(_uploadMode == SSBOMode::PersistentRing)
+                UploadToRing(0, textColour, [](std::byte*) { });
+            else
+                UploadTextColour(textColour);
+        };
+
+
+        const ProfileScope drawScope = ProfileScope(Profiler, "Glyph draw", AllocationSubsystem::Font);
+        const PipelineStatisticsScope statisticsScope = PipelineStatisticsScope(PipelineStatistics, "Glyph draw");
+
+        _shaderProgram.get().Bind();
+
+        const std::optional<ScopedBlendFunc> blendFunc = BlendGlyphs();
+        const std::optional<ScopedEnable> linearBlending = BlendLinearly();
+
+        _glyphRunCache->Bind();
+
+        // The whole run is drawn by the command its layout wrote
+        if(firstGlyph == 0 && glyphCount >= run->InstanceCount)
+            _glyphRunCache->DrawRun(*run);
+        else
+            _glyphRunCache->DrawRunRange(*run, firstGlyph, glyphCount);
+    };
+
+    /// <summary>
+    /// Queue a string's run, found by its interned id if it has one, see QueueCached
+    /// </summary>
+    void QueueCachedRun(const std::string_view& text, const InternedString string, const std::uint32_t firstGlyph, const std::uint32_t glyphCount, const glm::vec4& textColour) const
+    {
+        if(text.empty() == true || IsReady() == false)
+            return;
+
+        if(_glyphRunCache.has_value() == false)
+        {
+            Draw(text, textColour);
+            return;
+        };
+
+        const GlyphRunCache::Run* run = FindRun(text, string);
+
+        if(run == nullptr)
+        {
+            // Starting the cache over would overwrite the queued draws' runs, so they're drawn first
+            if(_glyphRunCache->HasRoomFor(text) == false)
+                SubmitQueued();
+
+            run = AddRun(text, string);
+
+            if(run == nullptr)
+            {
+                Draw(text, textColour);
+                return;
+            };
+
+            LayOutCachedRun(text, *run, textColour);
+        };
+
+        _glyphRunCache->Queue(*run, Transform, textColour, firstGlyph, glyphCount);
+    };
+
+    /// <summary>
+    /// A string's cached run, found by its interned id if it has one, or by its text. Runs found by text are remembered for the id
+    /// </summary>
+    const GlyphRunCache::Run* FindRun(const std::string_view& text, const InternedString string) const
+    {
+        if(string.IsValid() == false)
+            return _glyphRunCache->Find(text, Layout);
+
+        const GlyphRunCache::Run* run = _glyphRunCache->FindInterned(string, Layout);
+
+        if(run != nullptr)
+            return run;
+
+        run = _glyphRunCache->Find(text, Layout);
+
+        if(run != nullptr)
+            _glyphRunCache->Remember(string, *run);
+
+        return run;
+    };
+
+    /// <summary>
+    /// Allocate a string's run, remembered for its interned id if it has one. The caller lays it out
+    /// </summary>
+    const GlyphRunCache::Run* AddRun(const std::string_view& text, const InternedString string) const
+    {
+        const GlyphRunCache::Run* run = _glyphRunCache->Add(text, Layout);
+
+        if(run != nullptr && string.IsValid() == true)
+            _glyphRunCache->Remember(string, *run);
+
+        return run;
+    };
+
+    /// <summary>
+    /// Interned strings are only drawn from one table at a time, switching tables forgets the ids of the previous one
+    /// </summary>
+    void UseInternedStrings(const StringTable& strings) const
+    {
+        if(_internedStrings == &strings || _glyphRunCache.has_value() == false)
+            return;
+
+        _glyphRunCache->ForgetInterned();
+
+        _internedStrings = &strings;
+    };
+
+    /// <summary>
+    /// Upload a string and lay it out into its glyph run cache entry
+    /// </summary>
+    void LayOutCachedRun(const std::string_view& text, const GlyphRunCache::Run& run, const glm::vec4& textColour) const
+    {
+        if(text.size() > _capacity)
+            Reserve(std::max(text.size(), _capacity * 2));
+
+        UploadString(text, textColour);
+
+        const ProfileScope layoutScope = ProfileScope(Profiler, "Text layout", AllocationSubsystem::Layout);
+
+        BindLayoutTables();
+
+        _textLayout.DispatchInto(text.size(), static_cast<std::uint32_t>(_characterPacking), _glyphWidth, _glyphHeight, Layout,
+                                 _glyphRunCache->GetInstancesBuffer(), run.FirstInstance,
+                                 _glyphRunCache->GetCommandBuffer(), run.CommandIndex, _font->Proportional);
+    };
+
+    /// <summary>
+    /// Set the input block's text colour, if it changed
+    /// </summary>
+    /// <param name="textColour"></param>
+    void UploadTextColour(const glm::vec4& textColour) const
+    {
+        if(_uploadedTextColour != textColour)
+        {
+            FontSpriteInputLayout::Set<"TextColour">(_inputSSBO2BufferID, textColour);
+            _uploadedTextColour = textColour;
+
+            _uploadedByteCount += sizeof(textColour);
+        };
+    };
+
+
+    /// <summary>
+    /// Write the input block with glNamedBufferSubData, only the ranges of the text that changed since it was last written
+    /// </summary>
+    /// <param name="text"> The text to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void UploadToBuffer(const std::string_view& text, const glm::vec4& textColour) const
+    {
+        UploadTextColour(textColour);
+
+        FindChangedRanges(text);
+
+        // Packed characters are uploaded in whole uints
+        const std::size_t charactersPerWord = 32 / static_cast<std::size_t>(_characterPacking);
+
+        for(const TextDirtyRange& range : _changedRanges)
+        {
+            const std::size_t firstWord = range.Begin / charactersPerWord;
+            const std::size_t endWord = GetCharacterWordCount(range.End);
+
+            const std::size_t firstCharacter = firstWord * charactersPerWord;
+
+            // Convert the changed characters into the staging array..
+            _characterStagingBuffer.resize(endWord - firstWord);
+
+            PackCharacters(text.substr(firstCharacter, range.End - firstCharacter), reinterpret_cast<std::byte*>(_characterStagingBuffer.data()));
+
+            // ..and upload them to the SSBO in a single call
+            UploadCharacterWords(firstWord, _characterStagingBuffer);
+        };
+
+        WaitForCharacterUploads();
+
+        // Characters past the end of the text are never drawn, so the buffer now effectively holds exactly this text.
+        // Only the changed ranges are copied, the rest already matches
+        _uploadedText.resize(text.size());
+
+        for(const TextDirtyRange& range : _changedRanges)
+        {
+            std::memcpy(_uploadedText.data() + range.Begin, text.data() + range.Begin, range.End - range.Begin);
+        };
+
+        _uploadedTextBuffer = nullptr;
+    };
+
+    /// <summary>
+    /// Upload a range of a TextBuffer's characters with glNamedBufferSubData
+    /// </summary>
+    /// <param name="text"> The text to be drawn </param>
+    /// <param name="dirtyRange"> The characters that have to be uploaded </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    void UploadToBuffer(const TextBuffer& text, const TextDirtyRange& dirtyRange, const glm::vec4& textColour) const
+    {
+        UploadTextColour(textColour);
+
+        // The buffer no longer matches the string path's copy
+        _uploadedText.clear();
+        _uploadedTextBuffer = &text;
+
+        const std::size_t endCharacter = std::min(dirtyRange.End, text.GetSize());
+
+        if(dirtyRange.Begin >= endCharacter)
+            return;
+
+
+        // Packed characters are uploaded in whole uints
+        const std::size_t charactersPerWord = 32 / static_cast<std::size_t>(_characterPacking);
+
+        const std::size_t firstWord = dirtyRange.Begin / charactersPerWord;
+        const std::size_t endWord = GetCharacterWordCount(endCharacter);
+
+        const std::size_t firstCharacter = firstWord * charactersPerWord;
+
+        _characterStagingBuffer.resize(endWord - firstWord);
+
+        PackTextBuffer(text, firstCharacter, endCharacter - firstCharacter, reinterpret_cast<std::byte*>(_characterStagingBuffer.data()));
+
+        UploadCharacterWords(firstWord, _characterStagingBuffer);
+
+        WaitForCharacterUploads();
+    };
+
+    /// <summary>
+    /// Write packed characters into the input buffer's Characters array. Large ranges are copied on Uploads, see WaitForCharacterUploads
+    /// </summary>
+    /// <param name="firstWord"> The array index the words are written from </param>
+    /// <param name="words"> The packed characters </param>
+    void UploadCharacterWords(const std::size_t firstWord, const std::span<const std::uint32_t>& words) const
+    {
+        if(Uploads != nullptr && words.size_bytes() >= LargeUploadSize)
+        {
+            const std::byte* bytes = reinterpret_cast<const std::byte*>(words.data());
+
+            _pendingCharacterUploads.emplace_back(Uploads->UploadBuffer(_inputSSBO2BufferID, FontSpriteInputLayout::GetElementOffset<"Characters">(firstWord),
+                                                                        std::vector<std::byte>(bytes, bytes + words.size_bytes())));
+        }
+        else
+            FontSpriteInputLayout::SetRange<"Characters", std::uint32_t>(_inputSSBO2BufferID, firstWord, words);
+
+        _uploadedByteCount += words.size_bytes();
+    };
+
+    /// <summary>
+    /// Make the commands that follow wait for the character copies submitted to Uploads.
+    /// The CPU only waits until the worker has issued them, the GPU orders the copies before the draw
+    /// </summary>
+    void WaitForCharacterUploads() const
+    {
+        for(const UploadTicket& upload : _pendingCharacterUploads)
+        {
+            upload.WaitOnGPU();
+        };
+
+        _pendingCharacterUploads.clear();
+    };
 
-#include "ShaderProgram.hpp"
-#include "ShaderStorageBuffer.hpp"
-#include "DynamicSSBO.hpp"
 
+    /// <summary>
+    /// Compare a string against the characters currently stored in the input buffer, into _changedRanges.
+    /// Whole blocks are compared with memcmp, which the C runtime vectorizes, only the ends of a changed range are narrowed down to the character
+    /// </summary>
+    /// <param name="text"> The text about to be drawn </param>
+    void FindChangedRanges(const std::string_view& text) const
+    {
+        _changedRanges.clear();
 
-struct Input
-{
-    std::uint32_t GlyphWidth;
-    std::uint32_t GlyphHeight;
+        const std::size_t commonLength = std::min(text.size(), _uploadedText.size());
 
-    std::uint32_t TextureWidth;
-    std::uint32_t TextureHeight;
+        for(std::size_t blockStart = 0; blockStart < commonLength; blockStart += TextDiffBlockSize)
+        {
+            const std::size_t blockSize = std::min(TextDiffBlockSize, commonLength - blockStart);
 
-    glm::vec4 ChromaKey;
+            if(std::memcmp(text.data() + blockStart, _uploadedText.data() + blockStart, blockSize) == 0)
+                continue;
 
-    glm::vec4 TextColour;
-};
+            std::size_t begin = blockStart;
+            std::size_t end = blockStart + blockSize;
 
+            while(text[begin] == _uploadedText[begin])
+            {
+                ++begin;
+            };
 
-/// <summary>
-/// Draw text from a textue
-/// </summary>
-class FontSprite
-{
+            while(text[end - 1] == _uploadedText[end - 1])
+            {
+                --end;
+            };
 
-private:
+            AddChangedRange(begin, end);
+        };
+
+        // Characters beyond the old text's end are always new
+        if(text.size() > commonLength)
+            AddChangedRange(commonLength, text.size());
+    };
 
     /// <summary>
-    /// The ID of the loaded texture
+    /// Add a range to _changedRanges, after the ones already in it, joining it to the last if they're close
     /// </summary>
-    std::uint32_t _textureID = 0;
+    void AddChangedRange(const std::size_t begin, const std::size_t end) const
+    {
+        if(_changedRanges.empty() == false && begin - _changedRanges.back().End <= TextDiffMergeDistance)
+            _changedRanges.back().End = end;
+        else
+            _changedRanges.push_back(TextDirtyRange { begin, end });
+    };
 
 
     /// <summary>
-    /// The total height of the font sprite
+    /// Write the whole input block directly into the ring buffer's mapped memory and bind the written range
     /// </summary>
-    std::uint32_t _fontSpriteWidth = 0;
+    /// <param name="characterCount"> The number of characters to be drawn </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    /// <param name="packCharacters"> Called with the mapped Characters[] array, writes the packed characters into it </param>
+    template<typename TPackCharacters>
+    void UploadToRing(const std::size_t characterCount, const glm::vec4& textColour, TPackCharacters&& packCharacters) const
+    {
+        constexpr std::size_t charactersOffset = FontSpriteInputLayout::GetOffset<"Characters">();
+        const std::size_t drawSizeInBytes = FontSpriteInputLayout::GetSizeInBytes(GetCharacterWordCount(characterCount));
+
+        std::byte* range = _inputRingBuffer->Allocate(drawSizeInBytes);
+
+        // If the current frame's region is out of space, grow the ring so the rest of the frame fits
+        if(range == nullptr)
+        {
+            _inputRingBuffer->Reallocate((_inputRingBuffer->GetRegionSizeInBytes() + drawSizeInBytes) * 2);
+
+            range = _inputRingBuffer->Allocate(drawSizeInBytes);
+        };
+
+
+        FontSpriteInputLayout::Write<"GlyphWidth">(range, _glyphWidth);
+        FontSpriteInputLayout::Write<"GlyphHeight">(range, _glyphHeight);
+
+        FontSpriteInputLayout::Write<"TextureWidth">(range, _font->Width);
+        FontSpriteInputLayout::Write<"TextureHeight">(range, _font->Height);
+
+        FontSpriteInputLayout::Write<"ChromaKey">(range, _chromaKey);
+
+        FontSpriteInputLayout::Write<"TextColour">(range, textColour);
+
+
+        // Convert the texts' characters straight into the mapped buffer
+        packCharacters(range + charactersOffset);
+
+        _uploadedByteCount += drawSizeInBytes;
+
+
+        _inputRingBuffer->Bind();
+    };
+
 
     /// <summary>
-    /// The total height of the font sprite
+    /// Write a string's characters into a buffer using the sprite's character packing.
+    /// Bytes are written as they are, the layout pass maps characters the atlas has no glyph for to the missing glyph and skips control characters
     /// </summary>
-    std::uint32_t _fontSpriteHeight = 0;
+    /// <param name="text"> The characters to write </param>
+    /// <param name="destination"> Where to write the characters, must fit GetCharacterWordCount(text.size()) uints </param>
+    void PackCharacters(const std::string_view& text, std::byte* destination) const
+    {
+        PackGlyphCharacters(text, destination, static_cast<std::size_t>(_characterPacking));
+    };
 
 
     /// <summary>
-    /// The width of a single glyph 
+    /// Write a range of a TextBuffer's characters into a buffer, one piece at a time
     /// </summary>
-    std::uint32_t _glyphWidth = 0;
+    /// <param name="text"> The text to write from </param>
+    /// <param name="firstCharacter"> The first character to write, written to the start of "destination" </param>
+    /// <param name="characterCount"> The number of characters to write </param>
+    /// <param name="destination"> Where to write the characters, must fit GetCharacterWordCount(characterCount) uints </param>
+    void PackTextBuffer(const TextBuffer& text, const std::size_t firstCharacter, const std::size_t characterCount, std::byte* destination) const
+    {
+        const std::size_t bytesPerCharacter = static_cast<std::size_t>(_characterPacking) / 8;
+
+        text.ForEachRun(firstCharacter, characterCount, [&](const std::string_view& run)
+        {
+            // Packing is byte-granular, so a run can start in the middle of a uint
+            PackCharacters(run, destination);
+
+            destination += run.size() * bytesPerCharacter;
+        });
+    };
+
 
     /// <summary>
-    /// The height of a single glyph 
+    /// The number of uints required to store a number of packed characters
     /// </summary>
-    std::uint32_t _glyphHeight = 0;
+    /// <param name="characterCount"></param>
+    /// <returns></returns>
+    std::size_t GetCharacterWordCount(const std::size_t characterCount) const
+    {
+        const std::size_t charactersPerWord = 32 / static_cast<std::size_t>(_characterPacking);
+
+        return (characterCount + (charactersPerWord - 1)) / charactersPerWord;
+    };
 
+    /// <summary>
+    /// The size of an input buffer that can hold the current capacity's worth of characters
+    /// </summary>
+    /// <returns></returns>
+    std::size_t GetInputBufferSizeInBytes() const
+    {
+        return FontSpriteInputLayout::GetSizeInBytes(GetCharacterWordCount(_capacity));
+    };
 
     /// <summary>
-    /// The number of character columns present in the font sprite
+    /// Take ownership of a loaded atlas, and set up everything that depends on it
     /// </summary>
-    std::uint32_t _columns = 0;
+    void AdoptAtlas(LoadedAtlas&& atlas)
+    {
+        _font->Texture = GLTexture(std::exchange(atlas.TextureID, 0));
+        _font->Width = atlas.Width;
+        _font->Height = atlas.Height;
+
+        _font->Metrics = std::move(atlas.Metrics);
+        _font->KerningPairs = std::move(atlas.Kerning);
+
+        InitializeAtlas();
+    };
 
     /// <summary>
-    /// The number of character rows present in the font sprite
+    /// Set up everything that depends on the atlas' size, once it's known
     /// </summary>
-    std::uint32_t _rows = 0;
+    void InitializeAtlas()
+    {
+        _font->Columns = _font->Width / _glyphWidth;
+        _font->Rows = _font->Height / _glyphHeight;
 
+        // Packages come with their own metrics
+        if(_font->Metrics.empty() == true)
+            _font->Metrics = BuildGridGlyphMetrics({ _font->Width, _font->Height }, { _glyphWidth, _glyphHeight });
 
+        // The atlas' own glyphs, the missing glyph goes after them
+        const std::uint32_t glyphCount = static_cast<std::uint32_t>(_font->Metrics.size());
 
-    std::uint32_t _vao = 0;
+        // Characters without a glyph draw as the missing glyph. It has the fallback's metrics, or the first glyph's if even that's missing,
+        // so it takes up the same room, and shaders that don't draw it as a box draw the fallback
+        const std::uint32_t fallbackGlyph = static_cast<std::uint32_t>(FallbackGlyphCharacter - 32) < glyphCount ? static_cast<std::uint32_t>(FallbackGlyphCharacter - 32) : 0;
 
-    std::uint32_t _glyphVertexPositionsVBO = 0;
+        GlyphMetrics missingGlyph = _font->Metrics[fallbackGlyph];
+        missingGlyph.Flags = GlyphMissingFlag;
 
-    std::reference_wrapper<const ShaderProgram> _shaderProgram;
+        // A grid glyph's quad is only its ink, see BuildInkGlyphMetrics. The box still fills the cell the fallback was cut from
+        if(fallbackGlyph < _font->Columns * _font->Rows)
+        {
+            const GlyphMetrics fallbackCell = GetGridCellMetrics({ _font->Width, _font->Height }, { _glyphWidth, _glyphHeight }, fallbackGlyph);
 
-    mutable std::optional<SSBOLayout> _inputSSBO2;
-    mutable std::uint32_t _inputSSBO2BufferID = 0;
+            const glm::vec2 atlasSize = { static_cast<float>(_font->Width), static_cast<float>(_font->Height) };
 
+            const bool cutFromCell = missingGlyph.Advance == fallbackCell.Advance &&
+                                     glm::round(glm::vec2(missingGlyph.TextureRect) * atlasSize) == glm::round(glm::vec2(fallbackCell.TextureRect) * atlasSize) + missingGlyph.Bearing;
 
-    /// <summary>
-    /// Character capacity, how many character we can write before we need to reallocate the buffer
-    /// </summary>
-    mutable std::size_t _capacity = 0;
+            if(cutFromCell == true)
+            {
+                missingGlyph.TextureRect = fallbackCell.TextureRect;
+                missingGlyph.Size = fallbackCell.Size;
+                missingGlyph.Bearing = fallbackCell.Bearing;
+            };
+        };
 
-public:
+        _font->Metrics.push_back(missingGlyph);
 
-    glm::mat4 Transform = glm::mat4(1.0f);
+        _font->MetricsSSBO = GLBuffer::Create();
+        glNamedBufferStorage(_font->MetricsSSBO.Get(), static_cast<GLsizeiptr>(_font->Metrics.size() * sizeof(GlyphMetrics)), _font->Metrics.data(), 0);
 
-    glm::mat4 ScreenSpaceProjection = glm::mat4(1.0f);
+        GPUMemory.TrackBuffer(_font->MetricsSSBO.Get(), _font->Metrics.size() * sizeof(GlyphMetrics), GPUMemoryCategory::FontData);
 
+        _font->GlyphTable.Clear(glyphCount);
 
-public:
+        for(std::uint32_t glyphIndex = 0; glyphIndex < glyphCount; ++glyphIndex)
+        {
+            _font->GlyphTable.Set(static_cast<char32_t>(glyphIndex + 32), glyphIndex);
+        };
 
-    FontSprite(const std::uint32_t glyphWidth,
-               const std::uint32_t glyphHeight,
-               const ShaderProgram& shaderProgram,
-               const std::wstring_view& texturePath,
-               const std::uint32_t capacity = 32) :
-        _glyphWidth (glyphWidth),
-        _glyphHeight(glyphHeight),
-        _shaderProgram(shaderProgram),
-        _capacity(capacity)
-    {
-        _textureID = LoadTexture(texturePath);
+        _font->GlyphTable.Upload();
 
-        _columns = _fontSpriteWidth / glyphWidth;
-        _rows = _fontSpriteHeight / glyphHeight;
 
+        _font->Kerning.Build(_font->KerningPairs, glyphCount, [&](const char32_t codepoint)
+        {
+            return codepoint >= 32 && codepoint - 32 < glyphCount ? static_cast<std::uint32_t>(codepoint - 32) : KerningTable::NoGlyph;
+        });
+
+        _font->Kerning.Upload();
 
-        const float glyphWidthAsFloat = static_cast<float>(glyphWidth);
-        const float glyphHeightAsFloat = static_cast<float>(glyphHeight);
+        _font->Proportional = _font->Kerning.GetPairCount() > 0 || std::any_of(_font->Metrics.cbegin(), _font->Metrics.cend(), [&](const GlyphMetrics& metrics)
+        {
+            return metrics.Advance != static_cast<float>(_glyphWidth);
+        });
 
-        std::array<float, 12> glyphVertices =
+        // The same glyphs the layout pass looks up, characters without one advance by the missing glyph
+        for(std::uint32_t character = 32; character < _font->Advances.size(); ++character)
         {
-            // Top left
-            0.0f,  0.0f,
-            // Top right                           
-            glyphWidthAsFloat, 0.0f,
-            // Bottom left                         
-            0.0f, glyphHeightAsFloat,
+            const std::uint32_t glyph = character - 32 < glyphCount ? character - 32 : glyphCount;
+
+            _font->Advances[character] = _font->Metrics[glyph].Advance;
+        };
+
+        _textMetricsCache.Clear();
+    };
 
-            // Top right                           
-            glyphWidthAsFloat, 0.0f,
-            // Bottom right
-            glyphWidthAsFloat, glyphHeightAsFloat,
-            // Bottom left
-            0.0f, glyphHeightAsFloat,
+    /// <summary>
+    /// Set up the instance's input, the ring or an input buffer from the font's pool with the header written
+    /// </summary>
+    void CreateInput()
+    {
+        // In ring mode the whole input block is re-written every draw, so there's nothing to initialize
+        if(_uploadMode == SSBOMode::PersistentRing)
+        {
+            _inputRingBuffer.emplace(GetInputBufferSizeInBytes(), FramesInFlight);
+            return;
         };
 
+        _inputSSBO2BufferID = _font->InputBuffers.Acquire(GetInputBufferSizeInBytes());
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _inputSSBO2BufferID);
+
+
+        FontSpriteInputLayout::Set<"GlyphWidth">(_inputSSBO2BufferID, _glyphWidth);
+        FontSpriteInputLayout::Set<"GlyphHeight">(_inputSSBO2BufferID, _glyphHeight);
+
+        FontSpriteInputLayout::Set<"ChromaKey">(_inputSSBO2BufferID, _chromaKey);
+    };
+
+    /// <summary>
+    /// Resolve the uniforms the draws set on the current program
+    /// </summary>
+    void ResolveShaderProgram()
+    {
+        const ShaderProgram& shaderProgram = _shaderProgram.get();
+
+        _textTransformUniform = shaderProgram.GetUniformHandle("TextTransform");
+        _multiDrawUniform = shaderProgram.GetOptionalUniformHandle("MultiDraw");
+        _supersampleUniform = shaderProgram.GetOptionalUniformHandle("Supersample");
 
-        glCreateVertexArrays(1, &_vao);
-        glBindVertexArray(_vao);
+        _overdrawHeatmap = shaderProgram.HasDefine("OVERDRAW_HEATMAP");
 
-        // Glyph vertex positions
-        glCreateBuffers(1, &_glyphVertexPositionsVBO);
-        glNamedBufferData(_glyphVertexPositionsVBO, sizeof(glyphVertices), glyphVertices.data(), GL_STATIC_DRAW);
-        glVertexArrayVertexBuffer(_vao, 0, _glyphVertexPositionsVBO, 0, sizeof(float) * 2);
+        _textEffects = shaderProgram.HasDefine("TEXT_EFFECTS");
 
-        glVertexArrayAttribFormat(_vao, 0, 2, GL_FLOAT, false, 0);
-        glVertexArrayAttribBinding(_vao, 0, 0);
-        glEnableVertexArrayAttrib(_vao, 0);
+        _textEffectUniforms = TextEffectUniforms
+        {
+            .Padding = shaderProgram.GetOptionalUniformHandle("EffectPadding"),
+            .OutlineDistance = shaderProgram.GetOptionalUniformHandle("OutlineDistance"),
+            .OutlineColour = shaderProgram.GetOptionalUniformHandle("OutlineColour"),
+            .ShadowOffset = shaderProgram.GetOptionalUniformHandle("ShadowOffset"),
+            .ShadowSoftness = shaderProgram.GetOptionalUniformHandle("ShadowSoftness"),
+            .ShadowColour = shaderProgram.GetOptionalUniformHandle("ShadowColour"),
+        };
 
+        _billboardScaleUniform = shaderProgram.GetOptionalUniformHandle("BillboardScale");
+        _billboardConstantScreenSizeUniform = shaderProgram.GetOptionalUniformHandle("BillboardConstantScreenSize");
 
+        _linearBlendingUniform = shaderProgram.GetOptionalUniformHandle("LinearBlending");
+        _coverageContrastUniform = shaderProgram.GetOptionalUniformHandle("CoverageContrast");
+    };
 
-        RawLayout rawInputLayout;
+    /// <summary>
+    /// (FontShaderFeature::Effects programs) Convert Effects from pixels into the distance field's units, and set them on the program
+    /// </summary>
+    void UploadTextEffects() const
+    {
+        if(_textEffects == false)
+            return;
 
-        rawInputLayout.Add<ScalarElement, DataType::UInt32>("GlyphWidth");
-        rawInputLayout.Add<ScalarElement, DataType::UInt32>("GlyphHeight");
+        // The field goes from 0.5 at the edge to 0 DistanceFieldSpread pixels outside it
+        constexpr float distancePerPixel = 0.5f / DistanceFieldSpread;
 
-        rawInputLayout.Add<ScalarElement, DataType::UInt32>("TextureWidth");
-        rawInputLayout.Add<ScalarElement, DataType::UInt32>("TextureHeight");
+        const float outlineWidth = std::clamp(Effects.OutlineWidth, 0.0f, DistanceFieldSpread);
 
-        rawInputLayout.Add<ScalarElement, DataType::Vec4f>("ChromaKey");
-        
-        rawInputLayout.Add<ScalarElement, DataType::Vec4f>("TextColour");
+        const bool hasShadow = Effects.ShadowColour.a > 0.0f;
 
-        auto rawCharacterArrayLayout = rawInputLayout.Add<ArrayElement>("Characters");
-        rawCharacterArrayLayout->SetArray(DataType::UInt32, _capacity);
+        const float shadowSoftness = hasShadow == true ? std::clamp(Effects.ShadowSoftness, 0.0f, DistanceFieldSpread) : 0.0f;
 
-        _inputSSBO2 = SSBOLayout(rawInputLayout);
+        // Quads grow by as far as the effects reach past the glyph, plus a pixel for the smoothed edge
+        float padding = 0.0f;
 
-        glCreateBuffers(1, &_inputSSBO2BufferID);
+        if(outlineWidth > 0.0f || hasShadow == true)
+            padding = outlineWidth + shadowSoftness + 1.0f;
 
-        glNamedBufferData(_inputSSBO2BufferID, _inputSSBO2->GetSizeInBytes(), nullptr, GL_DYNAMIC_COPY);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _inputSSBO2BufferID);
+        if(hasShadow == true)
+            padding += std::max(std::abs(Effects.ShadowOffset.x), std::abs(Effects.ShadowOffset.y));
 
-        
-        _inputSSBO2->Get<ScalarElement>("GlyphWidth")->Set(_inputSSBO2BufferID, _glyphWidth);
-        _inputSSBO2->Get<ScalarElement>("GlyphHeight")->Set(_inputSSBO2BufferID, _glyphHeight);
+        const ShaderProgram& shaderProgram = _shaderProgram.get();
 
-        _inputSSBO2->Get<ScalarElement>("TextureWidth")->Set(_inputSSBO2BufferID, _fontSpriteWidth);
-        _inputSSBO2->Get<ScalarElement>("TextureHeight")->Set(_inputSSBO2BufferID, _fontSpriteHeight);
-        
-        _inputSSBO2->Get<ScalarElement>("ChromaKey")->Set(_inputSSBO2BufferID, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-       
-        // TODO: Refactor
+        shaderProgram.SetFloat(_textEffectUniforms.Padding, padding);
+        shaderProgram.SetFloat(_textEffectUniforms.OutlineDistance, 0.5f - (outlineWidth * distancePerPixel));
+        shaderProgram.SetVector4(_textEffectUniforms.OutlineColour, outlineWidth > 0.0f ? Effects.OutlineColour : glm::vec4(0.0f));
+        shaderProgram.SetVector2(_textEffectUniforms.ShadowOffset, Effects.ShadowOffset);
+        shaderProgram.SetFloat(_textEffectUniforms.ShadowSoftness, shadowSoftness * distancePerPixel);
+        shaderProgram.SetVector4(_textEffectUniforms.ShadowColour, hasShadow == true ? Effects.ShadowColour : glm::vec4(0.0f));
     };
 
-
-    ~FontSprite()
+    /// <summary>
+    /// Write the atlas' size into the input buffer, once the atlas is loaded
+    /// </summary>
+    void UploadAtlasSize()
     {
-        glDeleteBuffers(1, &_glyphVertexPositionsVBO);
+        _inputHasAtlasSize = true;
 
-        glDeleteTextures(1, &_textureID);
+        // Ring mode writes the size with every draw
+        if(_uploadMode == SSBOMode::PersistentRing)
+            return;
 
-        glDeleteVertexArrays(1, &_vao);
+        FontSpriteInputLayout::Set<"TextureWidth">(_inputSSBO2BufferID, _font->Width);
+        FontSpriteInputLayout::Set<"TextureHeight">(_inputSSBO2BufferID, _font->Height);
     };
 
+    /// <summary>
+    /// Build the glyph metrics table of an atlas laid out as a grid of equally sized glyphs
+    /// </summary>
+    static std::vector<GlyphMetrics> BuildGridGlyphMetrics(const glm::uvec2& atlasSize, const glm::uvec2& glyphSize)
+    {
+        const std::uint32_t columns = atlasSize.x / glyphSize.x;
+        const std::uint32_t rows = atlasSize.y / glyphSize.y;
 
-public:
+        std::vector<GlyphMetrics> glyphMetrics = std::vector<GlyphMetrics>(static_cast<std::size_t>(columns) * rows);
 
-    void Bind(const std::uint32_t textureUnit = 0) const
+        for(std::size_t glyphIndex = 0; glyphIndex < glyphMetrics.size(); ++glyphIndex)
+        {
+            glyphMetrics[glyphIndex] = GetGridCellMetrics(atlasSize, glyphSize, static_cast<std::uint32_t>(glyphIndex));
+        };
+
+        return glyphMetrics;
+    };
+
+    /// <summary>
+    /// The metrics of a grid atlas' glyph whose quad is its whole cell
+    /// </summary>
+    static GlyphMetrics GetGridCellMetrics(const glm::uvec2& atlasSize, const glm::uvec2& glyphSize, const std::uint32_t glyphIndex)
     {
-        _shaderProgram.get().Bind();
+        const std::uint32_t columns = atlasSize.x / glyphSize.x;
 
-        glActiveTexture(GL_TEXTURE0 + textureUnit);
-        glBindTexture(GL_TEXTURE_2D, _textureID);
+        const float textureWidth = static_cast<float>(atlasSize.x);
+        const float textureHeight = static_cast<float>(atlasSize.y);
 
-        glBindVertexArray(_vao);
+        const float glyphWidth = static_cast<float>(glyphSize.x);
+        const float glyphHeight = static_cast<float>(glyphSize.y);
 
-        glBindBuffer(GL_ARRAY_BUFFER, _glyphVertexPositionsVBO);
+        const float glyphX = static_cast<float>(glyphIndex % columns);
+        const float glyphY = static_cast<float>(glyphIndex / columns);
 
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _inputSSBO2BufferID);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _inputSSBO2BufferID);
+        // The texture's first row is the image's top row, so glyph rows go down as t goes up
+        return GlyphMetrics
+        {
+            .TextureRect =
+            {
+                (glyphX * glyphWidth) / textureWidth,
+                (glyphY * glyphHeight) / textureHeight,
+                ((glyphX + 1.0f) * glyphWidth) / textureWidth,
+                ((glyphY + 1.0f) * glyphHeight) / textureHeight,
+            },
+            .Size = { glyphWidth, glyphHeight },
+            .Bearing = { 0.0f, 0.0f },
+            .Advance = glyphWidth,
+        };
     };
 
-
-    void Draw(const std::string& text, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    /// <summary>
+    /// Build the glyph metrics of a grid atlas with every glyph's quad cut down to its ink, the pixels that aren't chroma-keyed,
+    /// plus the margin filtering or the distance field spread around them. Most of a monospace cell is empty, e.g. everything above a lowercase letter,
+    /// and none of it is rasterized and shaded only to be discarded or blended away. Cells without ink get empty quads, which draw nothing
+    /// </summary>
+    static std::vector<GlyphMetrics> BuildInkGlyphMetrics(const TextureImage& image, const glm::uvec2& glyphSize, const AtlasFormat atlasFormat, const glm::vec4& chromaKey)
     {
-        if(text.empty() == true)
-            return;
+        std::vector<GlyphMetrics> glyphMetrics = BuildGridGlyphMetrics({ image.Width, image.Height }, glyphSize);
 
-        // Allocate buffer memory if necessary
-        if(text.size() > _capacity)
-        {
-            _capacity = (text.size() + (_capacity / 2));
-            std::size_t previousBufferSizeInBytes = _inputSSBO2->GetSizeInBytes();
-            
-            RawLayout rawInputLayout;
+        const std::vector<std::byte> coverage = ExtractCoverage(image, chromaKey);
 
-            rawInputLayout.Add<ScalarElement, DataType::UInt32>("GlyphWidth");
-            rawInputLayout.Add<ScalarElement, DataType::UInt32>("GlyphHeight");
+        // The field fades out over DistanceFieldSpread past the ink, filtered and subpixel coverage over a pixel
+        const std::uint32_t margin = atlasFormat == AtlasFormat::DistanceField ? static_cast<std::uint32_t>(std::ceil(DistanceFieldSpread)) : 1u;
 
-            rawInputLayout.Add<ScalarElement, DataType::UInt32>("TextureWidth");
-            rawInputLayout.Add<ScalarElement, DataType::UInt32>("TextureHeight");
+        const std::uint32_t columns = image.Width / glyphSize.x;
 
-            rawInputLayout.Add<ScalarElement, DataType::Vec4f>("ChromaKey");
+        const float textureWidth = static_cast<float>(image.Width);
+        const float textureHeight = static_cast<float>(image.Height);
 
-            rawInputLayout.Add<ScalarElement, DataType::Vec4f>("TextColour");
+        for(std::size_t glyphIndex = 0; glyphIndex < glyphMetrics.size(); ++glyphIndex)
+        {
+            const std::uint32_t cellX = static_cast<std::uint32_t>(glyphIndex % columns) * glyphSize.x;
+            const std::uint32_t cellY = static_cast<std::uint32_t>(glyphIndex / columns) * glyphSize.y;
 
-            auto rawCharacterArrayLayout = rawInputLayout.Add<ArrayElement>("Characters");
-            rawCharacterArrayLayout->SetArray(DataType::UInt32, _capacity);
+            // The ink's bounds within the cell, the maximum exclusive
+            glm::uvec2 inkMinimum = glyphSize;
+            glm::uvec2 inkMaximum = { 0, 0 };
 
+            for(std::uint32_t y = 0; y < glyphSize.y; ++y)
+            {
+                const std::byte* row = coverage.data() + (static_cast<std::size_t>(cellY + y) * image.Width) + cellX;
 
-            _inputSSBO2 = SSBOLayout(rawInputLayout);
+                for(std::uint32_t x = 0; x < glyphSize.x; ++x)
+                {
+                    if(row[x] == std::byte { 0 })
+                        continue;
 
+                    inkMinimum = glm::min(inkMinimum, glm::uvec2(x, y));
+                    inkMaximum = glm::max(inkMaximum, glm::uvec2(x + 1, y + 1));
+                };
+            };
 
-            std::uint32_t newInputBuffer = 0;
-            glCreateBuffers(1, &newInputBuffer);
+            GlyphMetrics& metrics = glyphMetrics[glyphIndex];
 
-            glNamedBufferData(newInputBuffer, _inputSSBO2->GetSizeInBytes(), nullptr, GL_DYNAMIC_COPY);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, newInputBuffer);
+            if(inkMaximum.x == 0)
+            {
+                metrics.Size = { 0.0f, 0.0f };
+                metrics.TextureRect = { metrics.TextureRect.x, metrics.TextureRect.y, metrics.TextureRect.x, metrics.TextureRect.y };
+                continue;
+            };
 
-            glCopyNamedBufferSubData(_inputSSBO2BufferID, newInputBuffer, 0, 0, previousBufferSizeInBytes);
+            const glm::uvec2 minimum = inkMinimum - glm::min(inkMinimum, glm::uvec2(margin));
+            const glm::uvec2 maximum = glm::min(inkMaximum + glm::uvec2(margin), glyphSize);
 
-            glDeleteBuffers(1, &_inputSSBO2BufferID);
+            metrics.Bearing = glm::vec2(minimum);
+            metrics.Size = glm::vec2(maximum - minimum);
 
-            _inputSSBO2BufferID = newInputBuffer;
+            metrics.TextureRect =
+            {
+                static_cast<float>(cellX + minimum.x) / textureWidth,
+                static_cast<float>(cellY + minimum.y) / textureHeight,
+                static_cast<float>(cellX + maximum.x) / textureWidth,
+                static_cast<float>(cellY + maximum.y) / textureHeight,
+            };
         };
 
+        return glyphMetrics;
+    };
 
-        // Update uniforms
-        _shaderProgram.get().SetMatrix4("Projection", ScreenSpaceProjection);
-        _shaderProgram.get().SetMatrix4("TextTransform", Transform);
 
+    /// <summary>
+    /// Convert a chroma-keyed image into a coverage mask, one byte per pixel
+    /// </summary>
+    /// <param name="image"></param>
+    /// <returns></returns>
+    static std::vector<std::byte> ExtractCoverage(const TextureImage& image, const glm::vec4& chromaKeyColour)
+    {
+        std::array<std::uint8_t, 3> chromaKey =
+        {
+            static_cast<std::uint8_t>(chromaKeyColour.r * 255.0f + 0.5f),
+            static_cast<std::uint8_t>(chromaKeyColour.g * 255.0f + 0.5f),
+            static_cast<std::uint8_t>(chromaKeyColour.b * 255.0f + 0.5f),
+        };
+
+        if(image.PixelFormat == GL_BGRA)
+            std::swap(chromaKey[0], chromaKey[2]);
+
+
+        std::vector<std::byte> coverage = std::vector<std::byte>(static_cast<std::size_t>(image.Width) * image.Height);
 
-        // Set text foreground colour
-        _inputSSBO2->Get<ScalarElement>("TextColour")->Set(_inputSSBO2BufferID, textColour);
+        ExtractChromaKeyCoverage(image.Pixels.data(), static_cast<std::size_t>(image.Width) * 4,
+                                 coverage.data(), image.Width,
+                                 image.Width, image.Height,
+                                 chromaKey);
 
+        return coverage;
+    };
+
+    /// <summary>
+    /// Convert a chroma-keyed image into a signed distance field, one byte per pixel.
+    /// Every glyph cell gets a field of its own, so distances never reach into a neighbouring glyph
+    /// </summary>
+    static std::vector<std::byte> ExtractDistanceField(const TextureImage& image, const glm::uvec2& glyphSize, const glm::vec4& chromaKey)
+    {
+        const std::vector<std::byte> coverage = ExtractCoverage(image, chromaKey);
+
+        std::vector<std::byte> distanceField = std::vector<std::byte>(coverage.size());
 
-        // Copy texts' characters to the SSBO
-        for(std::size_t index = 0;
-            const auto & character : text)
+        // Partial cells at the right and bottom edges are converted too, as they are
+        for(std::uint32_t cellY = 0; cellY < image.Height; cellY += glyphSize.y)
         {
-            const std::uint32_t& characterAsInt = character;
+            for(std::uint32_t cellX = 0; cellX < image.Width; cellX += glyphSize.x)
+            {
+                const std::size_t cellOffset = (static_cast<std::size_t>(cellY) * image.Width) + cellX;
 
-            _inputSSBO2->Get<ArrayElement>("Characters")->GetAtIndex<ScalarElement>(index)->Set(_inputSSBO2BufferID, characterAsInt);
-            index++;
+                GenerateSignedDistanceField(coverage.data() + cellOffset, image.Width,
+                                            distanceField.data() + cellOffset, image.Width,
+                                            std::min(glyphSize.x, image.Width - cellX),
+                                            std::min(glyphSize.y, image.Height - cellY),
+                                            DistanceFieldSpread);
+            };
         };
 
+        return distanceField;
+    };
+
+    /// <summary>
+    /// Convert a chroma-keyed image into per-subpixel coverage, four bytes per pixel.
+    /// Filtering spreads coverage sideways, so it's done a glyph cell at a time like the distance field
+    /// </summary>
+    static std::vector<std::byte> ExtractSubpixelCoverage(const TextureImage& image, const glm::uvec2& glyphSize, const glm::vec4& chromaKey)
+    {
+        const std::vector<std::byte> coverage = ExtractCoverage(image, chromaKey);
+
+        std::vector<std::byte> subpixelCoverage = std::vector<std::byte>(coverage.size() * 4);
+
+        for(std::uint32_t cellY = 0; cellY < image.Height; cellY += glyphSize.y)
+        {
+            for(std::uint32_t cellX = 0; cellX < image.Width; cellX += glyphSize.x)
+            {
+                const std::size_t cellOffset = (static_cast<std::size_t>(cellY) * image.Width) + cellX;
+
+                GenerateSubpixelCoverage(coverage.data() + cellOffset, image.Width,
+                                         subpixelCoverage.data() + cellOffset * 4, static_cast<std::size_t>(image.Width) * 4,
+                                         std::min(glyphSize.x, image.Width - cellX),
+                                         std::min(glyphSize.y, image.Height - cellY));
+            };
+        };
 
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<std::int32_t>(text.size()));
+        return subpixelCoverage;
     };
 
+    /// <summary>
+    /// Load the font's atlas and upload it into immutable storage, on whichever context is current.
+    /// ".fontatlas" packages are uploaded straight out of the mapped file, anything else is decoded and converted first
+    /// </summary>
+    /// <param name="textureLoader"> Decodes images, if null one is picked by the path's extension </param>
+    static LoadedAtlas LoadAtlas(const std::wstring_view& texturePath,
+                                 const ITextureLoader* textureLoader,
+                                 const glm::uvec2& glyphSize,
+                                 const AtlasFormat atlasFormat,
+                                 const bool generateMipmaps,
+                                 const glm::vec4& chromaKey)
+    {
+        const std::filesystem::path path = texturePath;
 
-private:
+        return UploadAtlas(DecodeAtlas(std::make_shared<const MappedFile>(path), path, textureLoader, glyphSize, atlasFormat, chromaKey), generateMipmaps);
+    };
+
+    /// <summary>
+    /// Create the texture of a decoded atlas, on whichever context is current
+    /// </summary>
+    static LoadedAtlas UploadAtlas(DecodedAtlas&& atlas, const bool generateMipmaps)
+    {
+        const std::int64_t uploadStart = wt::etw::GetTime();
+
+        LoadedAtlas loadedAtlas = LoadedAtlas
+        {
+            .TextureID = CreateAtlasTexture(atlas.PixelFormat, { atlas.Width, atlas.Height }, atlas.Pixels, atlas.Format, generateMipmaps),
+            .Width = atlas.Width,
+            .Height = atlas.Height,
+            .Metrics = std::move(atlas.Metrics),
+            .Kerning = std::move(atlas.Kerning),
+        };
 
-    std::uint32_t LoadTexture(const std::wstring_view& texturePath)
+        wt::etw::TextureUpload(loadedAtlas.TextureID, atlas.Pixels.size_bytes(), wt::etw::GetMillisecondsSince(uploadStart));
+
+        return loadedAtlas;
+    };
+
+    /// <summary>
+    /// A validated package's atlas, its pixels stay where the package is
+    /// </summary>
+    static DecodedAtlas DecodePackage(const std::shared_ptr<const FontAtlasPackage>& package, const std::filesystem::path& path, const AtlasFormat atlasFormat, const std::int64_t decodeStart)
     {
-        // TODO: Make this texture loader more generic, in-case we may want to move to STBI or something
+        const FontAtlasHeader& header = package->GetHeader();
+
+        DecodedAtlas atlas = DecodedAtlas
+        {
+            .Format = atlasFormat,
+            .PixelFormat = header.PixelFormat,
+            .Width = header.Width,
+            .Height = header.Height,
+            .Pixels = package->GetPixels(),
+            .PixelStorage = package,
+            .Metrics = package->ReadGlyphMetrics(),
+            .Kerning = package->ReadKerningPairs(),
+        };
 
-        Gdiplus::GdiplusStartupInput gdiplusStartupInput;
-        ULONG_PTR gdiplusToken = 0;
-        Gdiplus::GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
+        wt::etw::TextureDecode(path.c_str(), atlas.Width, atlas.Height, wt::etw::GetMillisecondsSince(decodeStart));
 
-        Gdiplus::Bitmap* image = new Gdiplus::Bitmap(texturePath.data());
+        return atlas;
+    };
 
+    /// <summary>
+    /// Whether a package's pixels can be drawn as an atlas format
+    /// </summary>
+    static bool IsPackageCompatible(const FontAtlasPackage& package, const AtlasFormat atlasFormat)
+    {
+        const FontAtlasPixelFormat pixelFormat = package.GetHeader().PixelFormat;
 
-        _fontSpriteWidth = image->GetWidth();
-        _fontSpriteHeight = image->GetHeight();
+        switch(atlasFormat)
+        {
+            case AtlasFormat::ChromaKeyedRGBA:
+                return (pixelFormat == FontAtlasPixelFormat::RGBA8 || pixelFormat == FontAtlasPixelFormat::BGRA8) && package.IsSubpixel() == false;
 
-        Gdiplus::Rect rc(0, 0, static_cast<int>(_fontSpriteWidth), static_cast<int>(_fontSpriteHeight));
+            case AtlasFormat::Coverage:
+                return (pixelFormat == FontAtlasPixelFormat::R8 || pixelFormat == FontAtlasPixelFormat::BC4) && package.IsDistanceField() == false;
 
-        Gdiplus::BitmapData* bitmapData = new Gdiplus::BitmapData();
+            case AtlasFormat::DistanceField:
+                return (pixelFormat == FontAtlasPixelFormat::R8 || pixelFormat == FontAtlasPixelFormat::BC4) && package.IsDistanceField() == true;
 
-        image->RotateFlip(Gdiplus::RotateFlipType::Rotate180FlipX);
+            case AtlasFormat::Subpixel:
+                return pixelFormat == FontAtlasPixelFormat::RGBA8 && package.IsSubpixel() == true;
 
-        image->LockBits(&rc, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, bitmapData);
+            default:
+                return false;
+        };
+    };
 
+    /// <summary>
+    /// Convert a decoded image into the pixels an atlas format is uploaded as
+    /// </summary>
+    /// <param name="pixelFormat"> Receives the converted pixels' format </param>
+    /// <param name="convertedPixels"> Holds the converted pixels, if the image's own pixels can't be used as-is </param>
+    /// <returns> The pixels to upload, either the image's or convertedPixels </returns>
+    static std::span<const std::byte> ConvertAtlasImage(const TextureImage& image,
+                                                        const glm::uvec2& glyphSize,
+                                                        const AtlasFormat atlasFormat,
+                                                        const glm::vec4& chromaKey,
+                                                        FontAtlasPixelFormat& pixelFormat,
+                                                        std::vector<std::byte>& convertedPixels)
+    {
+        if(atlasFormat == AtlasFormat::ChromaKeyedRGBA)
+        {
+            pixelFormat = image.PixelFormat == GL_BGRA ? FontAtlasPixelFormat::BGRA8 : FontAtlasPixelFormat::RGBA8;
 
-        std::vector<std::uint32_t> pixels = std::vector<std::uint32_t>(static_cast<std::size_t>(_fontSpriteWidth) * _fontSpriteHeight);
+            return image.Pixels;
+        };
 
-        for(std::size_t y = 0; y < _fontSpriteHeight; y++)
+        if(atlasFormat == AtlasFormat::Subpixel)
         {
-            memcpy(&pixels[y * _fontSpriteWidth], reinterpret_cast<char*>(bitmapData->Scan0) + static_cast<std::size_t>(bitmapData->Stride) * y, static_cast<std::size_t>(_fontSpriteWidth) * 4);
+            pixelFormat = FontAtlasPixelFormat::RGBA8;
+
+            convertedPixels = ExtractSubpixelCoverage(image, glyphSize, chromaKey);
+
+            return convertedPixels;
+        };
+
+        pixelFormat = FontAtlasPixelFormat::R8;
 
-            for(std::size_t x = 0; x < _fontSpriteWidth; x++)
+        convertedPixels = atlasFormat == AtlasFormat::DistanceField ?
+            ExtractDistanceField(image, glyphSize, chromaKey) :
+            ExtractCoverage(image, chromaKey);
+
+        return convertedPixels;
+    };
+
+    /// <summary>
+    /// Create the atlas' texture from pixels already in their upload format.
+    /// The pixels are uploaded top row first, the shaders' texture coordinates account for the orientation
+    /// </summary>
+    /// <returns></returns>
+    static std::uint32_t CreateAtlasTexture(FontAtlasPixelFormat pixelFormat,
+                                            const glm::uvec2& size,
+                                            std::span<const std::byte> pixels,
+                                            const AtlasFormat atlasFormat,
+                                            const bool generateMipmaps)
+    {
+        const int width = static_cast<int>(size.x);
+        const int height = static_cast<int>(size.y);
+
+        // Scaled text samples the mip chain, otherwise a single level is enough
+        const int mipLevels = generateMipmaps == true ? static_cast<int>(std::bit_width(std::max(size.x, size.y))) : 1;
+
+        std::uint32_t textureID = 0;
+        glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+
+        // Distances interpolate, so a distance field is always filtered
+        const bool linearFiltering = atlasFormat == AtlasFormat::DistanceField;
+
+        glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, generateMipmaps == true ? GL_LINEAR_MIPMAP_LINEAR : (linearFiltering == true ? GL_LINEAR : GL_NEAREST));
+        glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, linearFiltering == true ? GL_LINEAR : GL_NEAREST);
+
+        glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+
+        std::vector<std::byte> decompressedPixels;
+
+        if(pixelFormat == FontAtlasPixelFormat::BC4)
+        {
+            // Compressed textures can't have their mips generated, so those are decompressed too
+            if(generateMipmaps == false && IsBC4Supported() == true)
             {
-                std::uint32_t& pixel = pixels[y * _fontSpriteWidth + x];
-                pixel = (pixel & 0xff00ff00) | ((pixel & 0xff) << 16) | ((pixel & 0xff0000) >> 16);
+                glTextureStorage2D(textureID, 1, GL_COMPRESSED_RED_RGTC1, width, height);
+
+                // 8 bytes per 4x4 block
+                GPUMemory.TrackTexture(textureID, GetTextureSizeInBytes(size.x, size.y, 1, 1, 4), GPUMemoryCategory::Atlas);
+
+                glCompressedTextureSubImage2D(textureID, 0, 0, 0, width, height, GL_COMPRESSED_RED_RGTC1, static_cast<GLsizei>(pixels.size()), pixels.data());
+
+                return textureID;
             };
+
+            decompressedPixels.resize(static_cast<std::size_t>(size.x) * size.y);
+
+            DecompressBC4(pixels.data(), decompressedPixels.data(), size.x, size.x, size.y);
+
+            pixelFormat = FontAtlasPixelFormat::R8;
+            pixels = decompressedPixels;
         };
 
-        image->UnlockBits(bitmapData);
+        if(pixelFormat == FontAtlasPixelFormat::R8)
+        {
+            glTextureStorage2D(textureID, mipLevels, GL_R8, width, height);
+
+            GPUMemory.TrackTexture(textureID, GetTextureSizeInBytes(size.x, size.y, 1, static_cast<std::size_t>(mipLevels), 8), GPUMemoryCategory::Atlas);
 
-        delete bitmapData;
-        delete image;
+            // Single byte rows, which aren't necessarily 4 byte aligned
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-        Gdiplus::GdiplusShutdown(gdiplusToken);
+            glTextureSubImage2D(textureID, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+        }
+        else
+        {
+            glTextureStorage2D(textureID, mipLevels, GL_RGBA8, width, height);
 
-        std::uint32_t textureID;
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
+            GPUMemory.TrackTexture(textureID, GetTextureSizeInBytes(size.x, size.y, 1, static_cast<std::size_t>(mipLevels), 32), GPUMemoryCategory::Atlas);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            // Rows are tightly packed, regardless of the width
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTextureSubImage2D(textureID, 0, 0, 0, width, height, pixelFormat == FontAtlasPixelFormat::BGRA8 ? GL_BGRA : GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        };
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<int>(_fontSpriteWidth), static_cast<int>(_fontSpriteHeight), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        if(generateMipmaps == true)
+            glGenerateTextureMipmap(textureID);
 
         return textureID;
     };
 
+    /// <summary>
+    /// Whether the current context can sample BC4 textures. RGTC is core, but drivers may still report it as emulated or unsupported
+    /// </summary>
+    static bool IsBC4Supported()
+    {
+        GLint supported = GL_FALSE;
+
+        glGetInternalformativ(GL_TEXTURE_2D, GL_COMPRESSED_RED_RGTC1, GL_INTERNALFORMAT_SUPPORTED, 1, &supported);
+
+        return supported == GL_TRUE;
+    };
+
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+
+/// <summary>
+/// A bump allocator for a frame's temporaries, reset at the start of every frame.
+/// Allocating is a pointer bump inside a single block and deallocating does nothing, the whole frame's memory is dropped at once by Reset.
+/// It's a std::pmr::memory_resource, so pmr containers (std::pmr::string, std::pmr::vector) allocate out of it.
+/// If a frame needs more than the block holds the rest comes from the heap, and the block grows on the next Reset so later frames fit.
+/// Only for the thread the frame is drawn on, and nothing allocated from it may be kept past the next Reset
+/// </summary>
+class FrameArena : public std::pmr::memory_resource
+{
+
+private:
+
+    std::unique_ptr<std::byte[]> _block;
+
+    std::size_t _capacity = 0;
+
+    /// <summary>
+    /// The bytes of the block handed out this frame, including alignment padding
+    /// </summary>
+    std::size_t _usedBytes = 0;
+
+    /// <summary>
+    /// Allocations that didn't fit in the block this frame, freed on Reset
+    /// </summary>
+    std::pmr::monotonic_buffer_resource _overflow = std::pmr::monotonic_buffer_resource(std::pmr::new_delete_resource());
+
+    std::size_t _overflowBytes = 0;
+
+    /// <summary>
+    /// The most any frame used so far
+    /// </summary>
+    std::size_t _peakBytes = 0;
+
+
+public:
+
+    /// <param name="capacity"> The block's initial size, enough for a typical frame's temporaries </param>
+    FrameArena(const std::size_t capacity = 256 * 1024) :
+        _block(std::make_unique_for_overwrite<std::byte[]>(capacity)),
+        _capacity(capacity)
+    {
+    };
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator = (const FrameArena&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Drop everything allocated since the last reset. Call at the start of a frame, once nothing refers to the previous frame's temporaries
+    /// </summary>
+    void Reset()
+    {
+        const std::size_t frameBytes = _usedBytes + _overflowBytes;
+
+        _peakBytes = std::max(_peakBytes, frameBytes);
+
+        // Grown once, to twice the frame that overflowed, rather than by every frame that's slightly larger
+        if(_overflowBytes > 0)
+        {
+            _capacity = frameBytes * 2;
+            _block = std::make_unique_for_overwrite<std::byte[]>(_capacity);
+        };
+
+        _overflow.release();
+
+        _usedBytes = 0;
+        _overflowBytes = 0;
+    };
+
+
+public:
+
+    /// <summary>
+    /// The bytes allocated since the last reset
+    /// </summary>
+    std::size_t GetUsedBytes() const
+    {
+        return _usedBytes + _overflowBytes;
+    };
+
+    std::size_t GetCapacity() const
+    {
+        return _capacity;
+    };
+
+    /// <summary>
+    /// The most any finished frame allocated
+    /// </summary>
+    std::size_t GetPeakBytes() const
+    {
+        return _peakBytes;
+    };
+
+
+private:
+
+    void* do_allocate(const std::size_t sizeInBytes, const std::size_t alignment) override
+    {
+        const std::uintptr_t blockStart = reinterpret_cast<std::uintptr_t>(_block.get());
+
+        // Alignments are powers of two
+        const std::uintptr_t start = (blockStart + _usedBytes + (alignment - 1)) & ~static_cast<std::uintptr_t>(alignment - 1);
+
+        const std::size_t end = static_cast<std::size_t>(start - blockStart) + sizeInBytes;
+
+        if(end <= _capacity)
+        {
+            _usedBytes = end;
+
+            return reinterpret_cast<void*>(start);
+        };
+
+        _overflowBytes += sizeInBytes;
+
+        return _overflow.allocate(sizeInBytes, alignment);
+    };
+
+    /// <summary>
+    /// Memory is only given back all at once, by Reset
+    /// </summary>
+    void do_deallocate(void*, std::size_t, std::size_t) override
+    {
+    };
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    };
+
+};
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "FontSprite.hpp"
+#include "GPUProfiler.hpp"
+#include "TextView.hpp"
+
+
+/// <summary>
+/// How much work text rendering is allowed, lowered one step at a time while frames run over budget
+/// </summary>
+enum class TextQuality : std::uint8_t
+{
+    /// <summary>
+    /// Nothing is prefetched either, scrolling past the viewport uploads the new lines on the frame that needs them
+    /// </summary>
+    Low,
+
+    /// <summary>
+    /// Distance field edges are sampled once per pixel
+    /// </summary>
+    Medium,
+
+    High,
+};
+
+
+/// <summary>
+/// What a TextQuality level turns on
+/// </summary>
+struct TextQualitySettings
+{
+    /// <summary>
+    /// See FontSprite::Supersample
+    /// </summary>
+    bool Supersample = true;
+
+    /// <summary>
+    /// A fraction of the views' own prefetch margin, see TextView::SetPrefetchLines
+    /// </summary>
+    float PrefetchScale = 1.0f;
+};
+
+
+/// <summary>
+/// Lowers text quality on frames that would miss the display's refresh, and raises it again once there's room.
+/// Frames are measured with the GPUProfiler's timer queries, so the decision lags a few frames behind the frames it's about.
+/// Quality drops after a few heavy frames in a row but only comes back after many light ones, with a gap between the two thresholds,
+/// so a frame cost near the budget doesn't flip it back and forth
+/// </summary>
+class FrameBudgetController
+{
+
+private:
+
+    /// <summary>
+    /// In milliseconds
+    /// </summary>
+    double _budget = 0.0;
+
+    /// <summary>
+    /// Frames under this fraction of the budget count towards raising the quality
+    /// </summary>
+    double _headroom = 0.0;
+
+    std::uint32_t _downgradeFrameCount = 0;
+    std::uint32_t _upgradeFrameCount = 0;
+
+
+    TextQuality _quality = TextQuality::High;
+
+    /// <summary>
+    /// Consecutive frames over the budget, and under its headroom. A frame between the two resets both
+    /// </summary>
+    std::uint32_t _heavyFrames = 0;
+    std::uint32_t _lightFrames = 0;
+
+    /// <summary>
+    /// The profiler's read back count when it was last measured, a frame with no new results isn't counted again
+    /// </summary>
+    std::uint64_t _lastReadBackCount = 0;
+
+    double _lastFrameMilliseconds = 0.0;
+
+    std::size_t _qualityChangeCount = 0;
+
+
+public:
+
+    /// <param name="budgetMilliseconds"> The time a frame may take, usually the refresh interval minus a margin </param>
+    /// <param name="downgradeFrameCount"> How many heavy frames in a row lower the quality </param>
+    /// <param name="upgradeFrameCount"> How many light frames in a row raise it </param>
+    /// <param name="headroom"> The fraction of the budget a frame must stay under to count as light </param>
+    FrameBudgetController(const double budgetMilliseconds,
+                          const std::uint32_t downgradeFrameCount = 3,
+                          const std::uint32_t upgradeFrameCount = 120,
+                          const double headroom = 0.7) :
+        _budget(budgetMilliseconds),
+        _headroom(headroom),
+        _downgradeFrameCount(downgradeFrameCount),
+        _upgradeFrameCount(upgradeFrameCount)
+    {
+        wt::Assert(downgradeFrameCount > 0 && upgradeFrameCount > 0, "Quality changes need at least a frame");
+        wt::Assert(headroom > 0.0 && headroom <= 1.0, "The headroom is a fraction of the budget");
+    };
+
+
+public:
+
+    /// <summary>
+    /// Measure the profiler's latest frame, the GPU time of its top-level scopes, should be called once per frame after EndFrame
+    /// </summary>
+    /// <param name="profiler"> The profiler the frames are recorded in </param>
+    /// <param name="presentScope"> The scope that presents the frame, left out as its time is mostly spent waiting for the display </param>
+    /// <returns> True if the quality changed, see Apply </returns>
+    bool Update(const GPUProfiler& profiler, const std::string_view& presentScope = "Present")
+    {
+        if(profiler.GetReadBackCount() == _lastReadBackCount)
+            return false;
+
+        _lastReadBackCount = profiler.GetReadBackCount();
+
+
+        double frameMilliseconds = 0.0;
+
+        for(const ProfileScopeResult& result : profiler.GetResults())
+        {
+            if(result.Depth == 0 && presentScope != result.Name)
+                frameMilliseconds += result.GPUMilliseconds;
+        };
+
+        return Update(frameMilliseconds);
+    };
+
+    /// <summary>
+    /// Count a frame measured some other way
+    /// </summary>
+    /// <param name="frameMilliseconds"> The frame's cost </param>
+    /// <returns> True if the quality changed, see Apply </returns>
+    bool Update(const double frameMilliseconds)
+    {
+        _lastFrameMilliseconds = frameMilliseconds;
+
+        if(frameMilliseconds > _budget)
+        {
+            ++_heavyFrames;
+            _lightFrames = 0;
+        }
+        else if(frameMilliseconds < _budget * _headroom)
+        {
+            ++_lightFrames;
+            _heavyFrames = 0;
+        }
+        else
+        {
+            _heavyFrames = 0;
+            _lightFrames = 0;
+        };
+
+
+        if(_heavyFrames >= _downgradeFrameCount && _quality != TextQuality::Low)
+            return SetQuality(static_cast<TextQuality>(static_cast<std::uint8_t>(_quality) - 1));
+
+        if(_lightFrames >= _upgradeFrameCount && _quality != TextQuality::High)
+            return SetQuality(static_cast<TextQuality>(static_cast<std::uint8_t>(_quality) + 1));
+
+        return false;
+    };
+
+    /// <summary>
+    /// Force a quality level, e.g. from a setting. Update keeps adjusting it from there
+    /// </summary>
+    /// <returns> True if the quality changed </returns>
+    bool SetQuality(const TextQuality quality)
+    {
+        _heavyFrames = 0;
+        _lightFrames = 0;
+
+        if(quality == _quality)
+            return false;
+
+        _quality = quality;
+
+        ++_qualityChangeCount;
+
+        return true;
+    };
+
+    void SetBudget(const double budgetMilliseconds)
+    {
+        _budget = budgetMilliseconds;
+    };
+
+
+public:
+
+    /// <summary>
+    /// Apply the current quality to a font, it takes effect on its next Bind
+    /// </summary>
+    void Apply(FontSprite& fontSprite) const
+    {
+        fontSprite.Supersample = GetSettings().Supersample;
+    };
+
+    /// <summary>
+    /// Apply the current quality to a view
+    /// </summary>
+    /// <param name="textView"> The view </param>
+    /// <param name="prefetchLines"> The view's prefetch margin at full quality </param>
+    void Apply(TextView& textView, const std::size_t prefetchLines) const
+    {
+        textView.SetPrefetchLines(static_cast<std::size_t>(static_cast<float>(prefetchLines) * GetSettings().PrefetchScale));
+    };
+
+
+public:
+
+    TextQuality GetQuality() const
+    {
+        return _quality;
+    };
+
+    TextQualitySettings GetSettings() const
+    {
+        return GetSettings(_quality);
+    };
+
+    static TextQualitySettings GetSettings(const TextQuality quality)
+    {
+        switch(quality)
+        {
+            case TextQuality::Low:
+                return TextQualitySettings { .Supersample = false, .PrefetchScale = 0.0f };
+
+            case TextQuality::Medium:
+                return TextQualitySettings { .Supersample = false, .PrefetchScale = 1.0f };
+
+            default:
+                return TextQualitySettings { };
+        };
+    };
+
+    double GetBudget() const
+    {
+        return _budget;
+    };
+
+    /// <summary>
+    /// The cost of the last frame counted, in milliseconds
+    /// </summary>
+    double GetLastFrameMilliseconds() const
+    {
+        return _lastFrameMilliseconds;
+    };
+
+    std::size_t GetQualityChangeCount() const
+    {
+        return _qualityChangeCount;
+    };
+
+};
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "PixelReadback.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A captured frame, handed to a FrameCapture's consumer on its worker thread
+/// </summary>
+struct CapturedFrame
+{
+    std::uint32_t Width = 0;
+    std::uint32_t Height = 0;
+
+    /// <summary>
+    /// The frame's number, counted from the capture's first frame
+    /// </summary>
+    std::uint64_t FrameIndex = 0;
+
+    /// <summary>
+    /// Tightly packed RGBA8, rows from the bottom of the framebuffer up
+    /// </summary>
+    std::vector<std::byte> Pixels;
+};
+
+
+/// <summary>
+/// Captures frames for recording and visual regression tests without stalling the frame.
+/// Each frame is read into a PixelReadback and only copied out a few frames later once its fence signalled,
+/// the copy is then handed to a worker thread, so encoding or diffing never runs on the render thread.
+/// Frames are handed over in order, and never dropped: if the worker falls behind, Capture waits for it
+/// </summary>
+class FrameCapture
+{
+
+private:
+
+    /// <summary>
+    /// Recreated, after its reads were collected, when a frame is larger than its slots
+    /// </summary>
+    std::optional<PixelReadback> _readback;
+
+    std::uint32_t _latencyFrames = 0;
+
+    std::uint64_t _nextFrame = 0;
+
+
+    /// <summary>
+    /// Runs on the worker for every frame
+    /// </summary>
+    std::function<void(const CapturedFrame&)> _consumer;
+
+    std::thread _worker;
+
+    std::mutex _framesLock;
+
+    std::condition_variable _framesChanged;
+
+    /// <summary>
+    /// Copied frames waiting for the consumer
+    /// </summary>
+    std::deque<CapturedFrame> _frames;
+
+    /// <summary>
+    /// Pixel storage the consumer is done with, reused so steady captures don't allocate
+    /// </summary>
+    std::vector<std::vector<std::byte>> _freePixels;
+
+    /// <summary>
+    /// The number of frames the worker is consuming right now, 0 or 1
+    /// </summary>
+    std::size_t _consumingCount = 0;
+
+    /// <summary>
+    /// The number of frames that can wait for the consumer before Capture waits for it
+    /// </summary>
+    std::size_t _maxQueuedFrames = 0;
+
+    bool _stopping = false;
+
+
+public:
+
+    /// <param name="consumer"> Called on the worker thread with every frame, in order </param>
+    /// <param name="latencyFrames"> How many frames later a frame is copied out, the number of reads in flight </param>
+    /// <param name="maxQueuedFrames"> How far the consumer may fall behind </param>
+    FrameCapture(std::function<void(const CapturedFrame&)> consumer, const std::uint32_t latencyFrames = 3, const std::size_t maxQueuedFrames = 8) :
+        _latencyFrames(latencyFrames),
+        _consumer(std::move(consumer)),
+        _maxQueuedFrames(maxQueuedFrames)
+    {
+        wt::Assert(maxQueuedFrames >= 1, "A frame capture has to be able to queue a frame");
+
+        _worker = std::thread([this]()
+        {
+            Run();
+        });
+    };
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator = (const FrameCapture&) = delete;
+
+    /// <summary>
+    /// Every frame captured so far is still handed to the consumer. Needs the capturing context current
+    /// </summary>
+    ~FrameCapture()
+    {
+        Flush();
+
+        {
+            const std::lock_guard lock = std::lock_guard(_framesLock);
+
+            _stopping = true;
+        };
+
+        _framesChanged.notify_all();
+
+        _worker.join();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Capture the current frame, after its draws and before the buffers are swapped.
+    /// Also hands frames that finished reading back to the worker
+    /// </summary>
+    /// <param name="width"> The frame's width, the whole framebuffer from its bottom-left corner is read </param>
+    /// <param name="height"> The frame's height </param>
+    /// <param name="framebufferID"> The framebuffer to capture, 0 for the window's back buffer </param>
+    /// <returns> The frame's index, see CapturedFrame::FrameIndex </returns>
+    std::uint64_t Capture(const std::uint32_t width, const std::uint32_t height, const std::uint32_t framebufferID = 0)
+    {
+        const auto handOver = std::bind_front(&FrameCapture::HandOver, this);
+
+        // A larger frame needs larger slots, the reads in flight are collected before the old ones go away
+        if(_readback.has_value() == false || _readback->CanRead(width, height) == false)
+        {
+            if(_readback.has_value() == true)
+                _readback->Drain(handOver);
+
+            _readback.emplace(width, height, _latencyFrames);
+        };
+
+        _readback->Collect(handOver);
+
+        if(_readback->GetPendingCount() == _readback->GetSlotCount())
+            _readback->Collect(handOver, true);
+
+        const std::uint64_t frameIndex = _nextFrame++;
+
+        _readback->Read(framebufferID, width, height, frameIndex);
+
+        return frameIndex;
+    };
+
+    /// <summary>
+    /// Wait until every captured frame was read back and consumed
+    /// </summary>
+    void Flush()
+    {
+        const auto handOver = std::bind_front(&FrameCapture::HandOver, this);
+
+        if(_readback.has_value() == true)
+            _readback->Drain(handOver);
+
+        std::unique_lock lock = std::unique_lock(_framesLock);
+
+        _framesChanged.wait(lock, [this]()
+        {
+            return _frames.empty() == true && _consumingCount == 0;
+        });
+    };
+
+
+public:
+
+    /// <summary>
+    /// The number of frames captured so far
+    /// </summary>
+    std::uint64_t GetCapturedCount() const
+    {
+        return _nextFrame;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Copy a finished read out of the readback's mapped memory, and queue it for the worker
+    /// </summary>
+    void HandOver(const ReadbackImage& image)
+    {
+        std::vector<std::byte> pixels;
+
+        {
+            std::unique_lock lock = std::unique_lock(_framesLock);
+
+            // Back-pressure instead of dropping, a regression test has to see every frame
+            _framesChanged.wait(lock, [this]()
+            {
+                return _frames.size() < _maxQueuedFrames;
+            });
+
+            if(_freePixels.empty() == false)
+            {
+                pixels = std::move(_freePixels.back());
+                _freePixels.pop_back();
+            };
+        };
+
+        pixels.resize(image.Pixels.size());
+
+        std::memcpy(pixels.data(), image.Pixels.data(), image.Pixels.size());
+
+        {
+            const std::lock_guard lock = std::lock_guard(_framesLock);
+
+            _frames.push_back(CapturedFrame
+            {
+                .Width = image.Width,
+                .Height = image.Height,
+                .FrameIndex = image.Tag,
+                .Pixels = std::move(pixels),
+            });
+        };
+
+        _framesChanged.notify_all();
+    };
+
+    void Run()
+    {
+        while(true)
+        {
+            CapturedFrame frame;
+
+            {
+                std::unique_lock lock = std::unique_lock(_framesLock);
+
+                _framesChanged.wait(lock, [this]()
+                {
+                    return _frames.empty() == false || _stopping == true;
+                });
+
+                if(_frames.empty() == true)
+                    break;
+
+                frame = std::move(_frames.front());
+                _frames.pop_front();
+
+                _consumingCount = 1;
+            };
+
+            // Waiting captures can go on while the frame is consumed
+            _framesChanged.notify_all();
+
+            _consumer(frame);
+
+            {
+                const std::lock_guard lock = std::lock_guard(_framesLock);
+
+                _freePixels.push_back(std::move(frame.Pixels));
+
+                _consumingCount = 0;
+            };
+
+            _framesChanged.notify_all();
+        };
+    };
+
+};
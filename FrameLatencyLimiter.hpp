@@ -0,0 +1,161 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "RenderBackend.hpp"
+#include "ProfileZones.hpp"
+
+
+/// <summary>
+/// Bounds how many frames the CPU may queue ahead of the GPU with a fence per frame.
+/// Persistently mapped rings already keep a region per frame in flight and fence each one, but they only wait once they've wrapped around,
+/// so on their own the CPU runs a whole ring ahead, and every queued frame is a frame of input latency.
+/// With a lower limit the CPU waits here, at the start of a frame, instead of in the middle of writing a ring region, and since the limit never
+/// exceeds the rings' region count a frame allowed to start never finds its regions still in use
+/// </summary>
+class FrameLatencyLimiter
+{
+
+public:
+
+    /// <summary>
+    /// The most frames that may be in flight, the number of regions of the persistently mapped rings
+    /// </summary>
+    static constexpr std::uint32_t MaxFramesInFlight = IRenderBackend::FramesInFlight;
+
+
+private:
+
+    /// <summary>
+    /// Fences of the frames in flight, oldest at _oldestFrame
+    /// </summary>
+    std::array<GLsync, MaxFramesInFlight> _frameFences = { };
+
+    std::uint32_t _oldestFrame = 0;
+    std::uint32_t _framesInFlight = 0;
+
+    std::uint32_t _maxLatency = 2;
+
+    /// <summary>
+    /// How long the last BeginFrame waited for the GPU
+    /// </summary>
+    double _lastWaitMilliseconds = 0.0;
+
+
+public:
+
+    /// <summary>
+    /// </summary>
+    /// <param name="maxLatency"> How many frames may be in flight, clamped to [1, MaxFramesInFlight] </param>
+    FrameLatencyLimiter(const std::uint32_t maxLatency = 2)
+    {
+        SetMaxLatency(maxLatency);
+    };
+
+    FrameLatencyLimiter(const FrameLatencyLimiter&) = delete;
+    FrameLatencyLimiter& operator = (const FrameLatencyLimiter&) = delete;
+
+    ~FrameLatencyLimiter()
+    {
+        for(GLsync& fence : _frameFences)
+        {
+            if(fence != nullptr)
+                glDeleteSync(fence);
+        };
+    };
+
+
+public:
+
+    /// <summary>
+    /// Wait until fewer than the maximum latency of frames are in flight. Call at the start of a frame, before anything is written to a ring
+    /// </summary>
+    void BeginFrame()
+    {
+        _lastWaitMilliseconds = 0.0;
+
+        if(_framesInFlight < _maxLatency)
+            return;
+
+        TEXT_RENDERER_ZONE("Frame latency wait");
+
+        const auto waitStart = std::chrono::steady_clock::now();
+
+        while(_framesInFlight >= _maxLatency)
+        {
+            WaitForOldestFrame();
+        };
+
+        _lastWaitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+    };
+
+    /// <summary>
+    /// Fence the frame's commands. Call once they were all issued, after the buffers were swapped
+    /// </summary>
+    void EndFrame()
+    {
+        // Only reachable if BeginFrame was skipped, the slot would otherwise be overwritten
+        if(_framesInFlight == MaxFramesInFlight)
+            WaitForOldestFrame();
+
+        const std::uint32_t newestFrame = (_oldestFrame + _framesInFlight) % MaxFramesInFlight;
+
+        _frameFences[newestFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ++_framesInFlight;
+    };
+
+
+    /// <summary>
+    /// How many frames may be in flight, clamped to [1, MaxFramesInFlight]. 1 waits for the GPU every frame, lowest latency and no overlap.
+    /// Lowering it takes effect on the next BeginFrame
+    /// </summary>
+    void SetMaxLatency(const std::uint32_t maxLatency)
+    {
+        _maxLatency = std::clamp(maxLatency, 1u, MaxFramesInFlight);
+    };
+
+    std::uint32_t GetMaxLatency() const
+    {
+        return _maxLatency;
+    };
+
+    std::uint32_t GetFramesInFlight() const
+    {
+        return _framesInFlight;
+    };
+
+    /// <summary>
+    /// How long the last BeginFrame blocked on the GPU, in milliseconds
+    /// </summary>
+    double GetLastWaitMilliseconds() const
+    {
+        return _lastWaitMilliseconds;
+    };
+
+
+private:
+
+    void WaitForOldestFrame()
+    {
+        GLsync& fence = _frameFences[_oldestFrame];
+
+        // Only flush on the first attempt, a single flush is enough for the fence to eventually signal
+        GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        while(waitResult == GL_TIMEOUT_EXPIRED)
+        {
+            waitResult = glClientWaitSync(fence, 0, 1'000'000);
+        };
+
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        _oldestFrame = (_oldestFrame + 1) % MaxFramesInFlight;
+        --_framesInFlight;
+    };
+
+};
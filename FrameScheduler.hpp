@@ -0,0 +1,574 @@
+#pragma once
+
+#include <Windows.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "GLExtensions.hpp"
+#include "WindowVisibility.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// When frames are drawn
+/// </summary>
+enum class RenderMode
+{
+    /// <summary>
+    /// Draw every iteration of the loop, only limited by the frame cap
+    /// </summary>
+    Continuous,
+
+    /// <summary>
+    /// Sleep in glfwWaitEvents until something requests a redraw, or an animation is running
+    /// </summary>
+    OnDemand,
+};
+
+
+/// <summary>
+/// What the scheduler sleeps on between frames
+/// </summary>
+enum class FrameWakeSource
+{
+    /// <summary>
+    /// GLFW's event queue, the scheduler processes window events. Only valid on the main thread
+    /// </summary>
+    WindowEvents,
+
+    /// <summary>
+    /// An event signaled by Wake, for a render thread that receives its input from another thread
+    /// </summary>
+    WakeEvent,
+};
+
+
+/// <summary>
+/// How buffer swaps are synchronized with the display
+/// </summary>
+enum class PresentMode
+{
+    /// <summary>
+    /// Swap immediately, tears
+    /// </summary>
+    Immediate,
+
+    /// <summary>
+    /// Swap on the vertical blank
+    /// </summary>
+    VSync,
+
+    /// <summary>
+    /// Swap on the vertical blank, unless the frame missed it, in which case it swaps immediately instead of waiting for the next one.
+    /// Requires swap_control_tear, falls back to VSync
+    /// </summary>
+    AdaptiveVSync,
+};
+
+
+/// <summary>
+/// The measurements of the most recent frames, in seconds
+/// </summary>
+struct FrameTimings
+{
+    /// <summary>
+    /// The time between the last two presents
+    /// </summary>
+    double FrameTime = 0.0;
+
+    /// <summary>
+    /// The time between latching input and submitting the last frame
+    /// </summary>
+    double WorkTime = 0.0;
+
+    /// <summary>
+    /// The time between the oldest input the last presented frame responded to, and the frame's present
+    /// </summary>
+    double InputLatency = 0.0;
+
+    double AverageInputLatency = 0.0;
+
+    double MaximumInputLatency = 0.0;
+};
+
+
+/// <summary>
+/// Decides when the render loop draws, and sleeps the thread in between.
+/// In on-demand mode a static window costs no CPU or GPU time at all.
+/// With v-sync and late-latching, frames start as late before the vertical blank as they can, so they respond to the most recent input
+/// </summary>
+class FrameScheduler
+{
+
+private:
+
+    /// <summary>
+    /// How much measurements are smoothed, the weight of a new sample
+    /// </summary>
+    static constexpr double SmoothingFactor = 0.1;
+
+    /// <summary>
+    /// Frames due within this many seconds are drawn now, timed waits can return slightly early
+    /// </summary>
+    static constexpr double FrameTimeTolerance = 0.0005;
+
+
+    RenderMode _renderMode = RenderMode::OnDemand;
+
+    FrameWakeSource _wakeSource = FrameWakeSource::WindowEvents;
+
+    /// <summary>
+    /// (Wake-event) Auto-reset, signaled by Wake
+    /// </summary>
+    mutable wt::SmartWin32Handle _wakeEvent = nullptr;
+
+    /// <summary>
+    /// (Wake-event) Ends timed waits, a wait timeout alone is rounded to the system's tick and overshoots a frame cap's deadline by up to 15 ms
+    /// </summary>
+    mutable wt::HighResolutionTimer _frameTimer;
+
+    PresentMode _presentMode = PresentMode::Immediate;
+
+    /// <summary>
+    /// The shortest time between two frames, in seconds. 0 doesn't cap the frame rate
+    /// </summary>
+    double _minimumFrameInterval = 0.0;
+
+    /// <summary>
+    /// (On-demand mode) How long the loop sleeps at most without any events, in seconds. 0 sleeps until the next event
+    /// </summary>
+    double _idleTimeout = 0.0;
+
+    WindowVisibility _visibility = WindowVisibility::Focused;
+
+    /// <summary>
+    /// The shortest time between two frames while the window is unfocused, in seconds
+    /// </summary>
+    double _unfocusedFrameInterval = 0.0;
+
+
+    bool _redrawRequested = true;
+
+    /// <summary>
+    /// When a redraw was requested for, see RequestRedrawAt. Negative if none is
+    /// </summary>
+    double _scheduledRedrawTime = -1.0;
+
+    /// <summary>
+    /// The number of running animations, the loop draws continuously while any are
+    /// </summary>
+    std::uint32_t _animationCount = 0;
+
+    double _lastFrameTime = 0.0;
+
+
+    /// <summary>
+    /// The display's refresh interval, in seconds. 0 if unknown, which disables late-latching
+    /// </summary>
+    double _refreshInterval = 0.0;
+
+    bool _lateLatching = false;
+
+    /// <summary>
+    /// How long before the predicted frame deadline the frame is done, in seconds
+    /// </summary>
+    double _latchMargin = 0.002;
+
+    /// <summary>
+    /// The smoothed time between LatchInput and Present
+    /// </summary>
+    double _averageWorkTime = 0.0;
+
+    double _latchTime = -1.0;
+
+    double _lastPresentTime = 0.0;
+
+    /// <summary>
+    /// When the oldest input not yet presented arrived, negative if there is none
+    /// </summary>
+    double _pendingInputTime = -1.0;
+
+
+    FrameTimings _timings;
+
+
+public:
+
+    /// <param name="renderMode"></param>
+    /// <param name="maximumFramesPerSecond"> The frame cap, 0 for none </param>
+    /// <param name="idleTimeout"> (On-demand mode) How often, in seconds, the loop wakes up without events, for polling work such as shader hot-reload. 0 never wakes up </param>
+    /// <param name="wakeSource"> What the loop sleeps on </param>
+    FrameScheduler(const RenderMode renderMode = RenderMode::OnDemand,
+                   const double maximumFramesPerSecond = 0.0,
+                   const double idleTimeout = 0.0,
+                   const FrameWakeSource wakeSource = FrameWakeSource::WindowEvents) :
+        _renderMode(renderMode),
+        _wakeSource(wakeSource),
+        _idleTimeout(idleTimeout)
+    {
+        SetFrameCap(maximumFramesPerSecond);
+
+        if(_wakeSource == FrameWakeSource::WakeEvent)
+            _wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    };
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator = (const FrameScheduler&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Process window events, sleeping until the next frame is due or an event arrives.
+    /// Follow with ShouldDraw to find out whether to draw
+    /// </summary>
+    void WaitForEvents() const
+    {
+        if(WantsFrame() == true)
+        {
+            const double timeUntilNextFrame = GetTimeUntilNextFrame();
+
+            // A frame is due, handle what's pending and draw it.
+            // Otherwise the frame cap, or the latch point, holds the frame back. Events are still handled while waiting
+            Wait(timeUntilNextFrame <= FrameTimeTolerance ? 0.0 : timeUntilNextFrame);
+            return;
+        };
+
+
+        double timeout = _idleTimeout > 0.0 ? _idleTimeout : -1.0;
+
+        // Sleep no longer than until a scheduled redraw, e.g. the caret's next blink. A hidden window has none to wake for
+        if(_scheduledRedrawTime >= 0.0 && _visibility != WindowVisibility::Hidden)
+        {
+            const double timeUntilRedraw = std::max(_scheduledRedrawTime - glfwGetTime(), 0.0);
+
+            timeout = timeout < 0.0 ? timeUntilRedraw : std::min(timeout, timeUntilRedraw);
+        };
+
+        Wait(timeout);
+    };
+
+    /// <summary>
+    /// (Wake-event) Interrupt WaitForEvents, from any thread
+    /// </summary>
+    void Wake() const
+    {
+        SetEvent(_wakeEvent);
+    };
+
+
+    /// <summary>
+    /// Whether a frame should be drawn now
+    /// </summary>
+    bool ShouldDraw() const
+    {
+        return WantsFrame() == true && GetTimeUntilNextFrame() <= FrameTimeTolerance;
+    };
+
+
+    /// <summary>
+    /// Handle any input that arrived since WaitForEvents, call right before the frame's text is uploaded.
+    /// In wake-event mode this only marks the latch point, the caller drains its own input right after
+    /// </summary>
+    void LatchInput()
+    {
+        if(_wakeSource == FrameWakeSource::WindowEvents)
+            glfwPollEvents();
+
+        _latchTime = glfwGetTime();
+    };
+
+    /// <summary>
+    /// Swap the window's buffers and measure the frame. Counts as FrameDrawn
+    /// </summary>
+    void Present(GLFWwindow* window)
+    {
+        const double submitTime = glfwGetTime();
+
+        if(_latchTime >= 0.0)
+        {
+            _timings.WorkTime = submitTime - _latchTime;
+            _averageWorkTime = _averageWorkTime + (_timings.WorkTime - _averageWorkTime) * SmoothingFactor;
+
+            _latchTime = -1.0;
+        };
+
+
+        glfwSwapBuffers(window);
+
+
+        // With v-sync the swap returns once the frame is queued for the vertical blank, which is as close to the present as we can observe
+        const double presentTime = glfwGetTime();
+
+        _timings.FrameTime = presentTime - _lastPresentTime;
+        _lastPresentTime = presentTime;
+
+        if(_pendingInputTime >= 0.0)
+        {
+            _timings.InputLatency = presentTime - _pendingInputTime;
+
+            _timings.AverageInputLatency = _timings.AverageInputLatency == 0.0 ?
+                _timings.InputLatency :
+                _timings.AverageInputLatency + (_timings.InputLatency - _timings.AverageInputLatency) * SmoothingFactor;
+
+            _timings.MaximumInputLatency = std::max(_timings.MaximumInputLatency, _timings.InputLatency);
+
+            _pendingInputTime = -1.0;
+        };
+
+        FrameDrawn();
+    };
+
+    /// <summary>
+    /// Signal that a frame was drawn, clears the pending redraw request.
+    /// Only needed when not presenting through Present
+    /// </summary>
+    void FrameDrawn()
+    {
+        _redrawRequested = false;
+
+        _lastFrameTime = glfwGetTime();
+
+        if(_scheduledRedrawTime >= 0.0 && _scheduledRedrawTime <= _lastFrameTime + FrameTimeTolerance)
+            _scheduledRedrawTime = -1.0;
+    };
+
+
+    /// <summary>
+    /// Something visible changed, draw a frame as soon as the frame cap allows
+    /// </summary>
+    void RequestRedraw()
+    {
+        _redrawRequested = true;
+    };
+
+    /// <summary>
+    /// Draw a frame once a time is reached, without drawing any before. Only the earliest of several requests is kept,
+    /// so something that changes periodically, like a blinking caret, requests its next change after every frame
+    /// </summary>
+    /// <param name="time"> When to draw, as returned by glfwGetTime </param>
+    void RequestRedrawAt(const double time)
+    {
+        if(_scheduledRedrawTime < 0.0 || time < _scheduledRedrawTime)
+            _scheduledRedrawTime = time;
+    };
+
+    /// <summary>
+    /// Input that changes what's drawn arrived, requests a redraw and starts measuring its latency
+    /// </summary>
+    /// <param name="inputTime"> When the input arrived, as returned by glfwGetTime. Negative for now </param>
+    void InputReceived(const double inputTime = -1.0)
+    {
+        if(_pendingInputTime < 0.0)
+            _pendingInputTime = inputTime >= 0.0 ? inputTime : glfwGetTime();
+
+        _redrawRequested = true;
+    };
+
+
+    /// <summary>
+    /// Keep drawing every frame until a matching EndAnimation
+    /// </summary>
+    void BeginAnimation()
+    {
+        ++_animationCount;
+    };
+
+    void EndAnimation()
+    {
+        if(_animationCount == 0)
+            return;
+
+        --_animationCount;
+
+        // Draw the animation's final state
+        _redrawRequested = true;
+    };
+
+
+    /// <summary>
+    /// A hidden window draws no frames at all, not even for animations or in continuous mode, and an unfocused one draws at most at the unfocused frame cap.
+    /// Requests made meanwhile are kept, so the window is brought up to date by the first frame after it's shown again
+    /// </summary>
+    void SetWindowVisibility(const WindowVisibility visibility)
+    {
+        if(visibility == _visibility)
+            return;
+
+        // Whatever was on screen before the window was hidden may be stale, or gone from the compositor
+        if(_visibility == WindowVisibility::Hidden)
+            _redrawRequested = true;
+
+        _visibility = visibility;
+    };
+
+    /// <summary>
+    /// Limit the frame rate while the window is unfocused, on top of the frame cap
+    /// </summary>
+    /// <param name="maximumFramesPerSecond"> 0 doesn't lower the frame rate </param>
+    void SetUnfocusedFrameCap(const double maximumFramesPerSecond)
+    {
+        _unfocusedFrameInterval = maximumFramesPerSecond > 0.0 ? 1.0 / maximumFramesPerSecond : 0.0;
+    };
+
+    void SetRenderMode(const RenderMode renderMode)
+    {
+        _renderMode = renderMode;
+        _redrawRequested = true;
+    };
+
+    /// <summary>
+    /// Set the swap interval of the current context
+    /// </summary>
+    /// <returns> The mode actually used, AdaptiveVSync falls back to VSync when unsupported </returns>
+    PresentMode SetPresentMode(const PresentMode presentMode)
+    {
+        _presentMode = presentMode;
+
+        if(_presentMode == PresentMode::AdaptiveVSync && GLExtensions.SwapControlTear == false)
+            _presentMode = PresentMode::VSync;
+
+        switch(_presentMode)
+        {
+            case PresentMode::Immediate:
+                glfwSwapInterval(0);
+                break;
+
+            case PresentMode::VSync:
+                glfwSwapInterval(1);
+                break;
+
+            case PresentMode::AdaptiveVSync:
+                glfwSwapInterval(-1);
+                break;
+        };
+
+        return _presentMode;
+    };
+
+    /// <summary>
+    /// Limit the frame rate, 0 removes the limit
+    /// </summary>
+    void SetFrameCap(const double maximumFramesPerSecond)
+    {
+        _minimumFrameInterval = maximumFramesPerSecond > 0.0 ? 1.0 / maximumFramesPerSecond : 0.0;
+    };
+
+    /// <summary>
+    /// The display's refresh rate, required for late-latching
+    /// </summary>
+    void SetRefreshRate(const double refreshRate)
+    {
+        _refreshInterval = refreshRate > 0.0 ? 1.0 / refreshRate : 0.0;
+    };
+
+    /// <summary>
+    /// (V-sync) Delay the start of frames until just enough time is left to finish them before the next vertical blank
+    /// </summary>
+    /// <param name="lateLatching"></param>
+    /// <param name="latchMargin"> How early, in seconds, frames aim to be done, covers variance in the frames' cost </param>
+    void SetLateLatching(const bool lateLatching, const double latchMargin = 0.002)
+    {
+        _lateLatching = lateLatching;
+        _latchMargin = latchMargin;
+    };
+
+
+    RenderMode GetRenderMode() const
+    {
+        return _renderMode;
+    };
+
+    PresentMode GetPresentMode() const
+    {
+        return _presentMode;
+    };
+
+    WindowVisibility GetVisibility() const
+    {
+        return _visibility;
+    };
+
+    /// <summary>
+    /// In seconds, 0 if the refresh rate wasn't set
+    /// </summary>
+    double GetRefreshInterval() const
+    {
+        return _refreshInterval;
+    };
+
+    const FrameTimings& GetTimings() const
+    {
+        return _timings;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Sleep until an event arrives or a timeout passes
+    /// </summary>
+    /// <param name="timeout"> In seconds, 0 only handles what's pending, negative waits indefinitely </param>
+    void Wait(const double timeout) const
+    {
+        if(_wakeSource == FrameWakeSource::WakeEvent)
+        {
+            if(timeout <= 0.0)
+            {
+                WaitForSingleObject(_wakeEvent, timeout < 0.0 ? INFINITE : 0);
+                return;
+            };
+
+            _frameTimer.Set(std::chrono::duration<double>(timeout));
+
+            const HANDLE handles[] = { _wakeEvent, _frameTimer.GetHandle() };
+
+            WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            return;
+        };
+
+
+        if(timeout == 0.0)
+            glfwPollEvents();
+        else if(timeout < 0.0)
+            glfwWaitEvents();
+        else
+            glfwWaitEventsTimeout(timeout);
+    };
+
+    bool WantsFrame() const
+    {
+        if(_visibility == WindowVisibility::Hidden)
+            return false;
+
+        return _renderMode == RenderMode::Continuous || _redrawRequested == true || _animationCount > 0 ||
+               (_scheduledRedrawTime >= 0.0 && glfwGetTime() >= _scheduledRedrawTime - FrameTimeTolerance);
+    };
+
+    double GetTimeUntilNextFrame() const
+    {
+        const double now = glfwGetTime();
+
+        const double frameInterval = _visibility == WindowVisibility::Unfocused ? std::max(_minimumFrameInterval, _unfocusedFrameInterval) : _minimumFrameInterval;
+
+        double nextFrameTime = _lastFrameTime + frameInterval;
+
+        if(_lateLatching == true && _presentMode != PresentMode::Immediate && _refreshInterval > 0.0)
+        {
+            // Vertical blanks keep their phase relative to the last present, find the next one the frame can still make.
+            // A frame that's only slightly late eats into the margin, rather than waiting a whole interval
+            const double frameDuration = _averageWorkTime + _latchMargin;
+
+            const double intervalsSincePresent = std::ceil((now + frameDuration - _lastPresentTime) / _refreshInterval - 0.05);
+            const double nextVerticalBlank = _lastPresentTime + std::max(intervalsSincePresent, 1.0) * _refreshInterval;
+
+            nextFrameTime = std::max(nextFrameTime, nextVerticalBlank - frameDuration);
+        };
+
+        return std::max(nextFrameTime - now, 0.0);
+    };
+
+};
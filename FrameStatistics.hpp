@@ -0,0 +1,600 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "GPUProfiler.hpp"
+#include "FrameScheduler.hpp"
+#include "GLCallCounting.hpp"
+#include "GPUMemory.hpp"
+#include "ProfileZones.hpp"
+
+
+/// <summary>
+/// A histogram of durations with a fixed relative precision, in the style of HdrHistogram.
+/// Values are in microseconds. Below 32 µs every value has a bucket of its own, above that every power of 2 is split into 32 buckets,
+/// so any recorded duration, up to about 19 hours, is known to within about 3%. Fixed size, recording never allocates
+/// </summary>
+class DurationHistogram
+{
+
+private:
+
+    /// <summary>
+    /// log2 of the number of buckets per power of 2
+    /// </summary>
+    static constexpr std::uint32_t SubBucketBits = 5;
+
+    static constexpr std::uint64_t SubBucketCount = 1ull << SubBucketBits;
+
+    /// <summary>
+    /// The largest power of 2 with buckets, longer durations are counted in the last bucket
+    /// </summary>
+    static constexpr std::uint32_t MaximumExponent = 35;
+
+
+public:
+
+    static constexpr std::size_t BucketCount = SubBucketCount + (MaximumExponent - SubBucketBits + 1) * SubBucketCount;
+
+
+private:
+
+    std::array<std::uint32_t, BucketCount> _buckets = { };
+
+    std::uint64_t _count = 0;
+
+    std::uint64_t _maximum = 0;
+
+
+public:
+
+    void Record(const double milliseconds)
+    {
+        const std::uint64_t microseconds = static_cast<std::uint64_t>(std::max(milliseconds, 0.0) * 1000.0 + 0.5);
+
+        ++_buckets[GetBucket(microseconds)];
+
+        ++_count;
+        _maximum = std::max(_maximum, microseconds);
+    };
+
+    void Reset()
+    {
+        _buckets.fill(0);
+
+        _count = 0;
+        _maximum = 0;
+    };
+
+    /// <summary>
+    /// Add another histogram's values to this one's
+    /// </summary>
+    void Add(const DurationHistogram& other)
+    {
+        if(other._count == 0)
+            return;
+
+        for(std::size_t bucket = 0; bucket < BucketCount; ++bucket)
+        {
+            _buckets[bucket] += other._buckets[bucket];
+        };
+
+        _count += other._count;
+        _maximum = std::max(_maximum, other._maximum);
+    };
+
+
+public:
+
+    std::uint64_t GetCount() const
+    {
+        return _count;
+    };
+
+    /// <summary>
+    /// Exact, unlike the percentiles
+    /// </summary>
+    double GetMaximum() const
+    {
+        return static_cast<double>(_maximum) / 1000.0;
+    };
+
+    /// <summary>
+    /// The duration a fraction of the values are at or below, in milliseconds. 0 if nothing was recorded
+    /// </summary>
+    /// <param name="percentile"> Between 0 and 1, e.g. 0.99 </param>
+    double GetPercentile(const double percentile) const
+    {
+        if(_count == 0)
+            return 0.0;
+
+        const std::uint64_t rank = std::max<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(percentile * static_cast<double>(_count))), 1);
+
+        std::uint64_t seen = 0;
+
+        for(std::size_t bucket = 0; bucket < BucketCount; ++bucket)
+        {
+            seen += _buckets[bucket];
+
+            // The bucket's middle, but never past the largest value actually recorded
+            if(seen >= rank)
+                return std::min(GetBucketMiddle(bucket), static_cast<double>(_maximum)) / 1000.0;
+        };
+
+        return GetMaximum();
+    };
+
+
+private:
+
+    static std::size_t GetBucket(const std::uint64_t microseconds)
+    {
+        if(microseconds < SubBucketCount)
+            return static_cast<std::size_t>(microseconds);
+
+        const std::uint32_t exponent = static_cast<std::uint32_t>(std::bit_width(microseconds)) - 1;
+
+        if(exponent > MaximumExponent)
+            return BucketCount - 1;
+
+        // The bits right below the leading one
+        const std::uint64_t subBucket = (microseconds >> (exponent - SubBucketBits)) - SubBucketCount;
+
+        return static_cast<std::size_t>(SubBucketCount + (exponent - SubBucketBits) * SubBucketCount + subBucket);
+    };
+
+    static double GetBucketMiddle(const std::size_t bucket)
+    {
+        if(bucket < SubBucketCount)
+            return static_cast<double>(bucket);
+
+        const std::uint64_t shift = (bucket - SubBucketCount) / SubBucketCount;
+        const std::uint64_t subBucket = (bucket - SubBucketCount) % SubBucketCount;
+
+        const std::uint64_t lowest = (SubBucketCount + subBucket) << shift;
+
+        return static_cast<double>(lowest) + static_cast<double>(1ull << shift) * 0.5;
+    };
+
+};
+
+
+/// <summary>
+/// What FrameStatistics measures
+/// </summary>
+enum class FrameMetric : std::uint32_t
+{
+    /// <summary>
+    /// From latching input to submitting the frame, see FrameTimings::WorkTime
+    /// </summary>
+    CPUFrameTime,
+
+    /// <summary>
+    /// The GPU time of the profiler's top-level scopes
+    /// </summary>
+    GPUFrameTime,
+
+    /// <summary>
+    /// The time between two presents, where stutter shows
+    /// </summary>
+    PresentInterval,
+
+    /// <summary>
+    /// The CPU time spent inside GL calls, only recorded while GL call counting is installed and timed
+    /// </summary>
+    DriverTime,
+};
+
+inline constexpr std::size_t FrameMetricCount = 4;
+
+
+/// <summary>
+/// A metric over a window of recent time
+/// </summary>
+struct FrameMetricSummary
+{
+    std::uint64_t Count = 0;
+
+    double P50 = 0.0;
+    double P99 = 0.0;
+    double Maximum = 0.0;
+};
+
+
+/// <summary>
+/// Frame time distributions for finding stutter, which an average frame rate hides.
+/// CPU frame time, GPU frame time, the present interval and, when counted, GL driver time are recorded into histograms, one per metric per second,
+/// and summarized over a sliding window of the last few seconds: percentiles, the maximum, and how many presents were hitches.
+/// Everything is preallocated, recording a frame costs a few array increments
+/// </summary>
+class FrameStatistics
+{
+
+public:
+
+    /// <summary>
+    /// How many intervals the statistics keep, the longest window
+    /// </summary>
+    static constexpr std::size_t IntervalCount = 10;
+
+
+private:
+
+    /// <summary>
+    /// IntervalCount histograms per metric, the current interval's at _currentInterval.
+    /// Allocated once, together they're too large for the stack
+    /// </summary>
+    std::vector<DurationHistogram> _histograms;
+
+    std::array<std::uint32_t, IntervalCount> _hitchCounts = { };
+
+    std::size_t _currentInterval = 0;
+
+    double _intervalStart = -1.0;
+
+    double _intervalSeconds = 1.0;
+
+    std::uint64_t _totalHitchCount = 0;
+
+    /// <summary>
+    /// The profiler readback last recorded, see RecordGPUFrame
+    /// </summary>
+    std::uint64_t _gpuReadBackCount = 0;
+
+    /// <summary>
+    /// The last frame's GL calls by entry point, see RecordGLCalls
+    /// </summary>
+    std::array<std::uint64_t, GLEntryPointCount> _glCalls = { };
+
+    bool _glCallsRecorded = false;
+
+    /// <summary>
+    /// The tracker whose memory is reported, see RecordGPUMemory
+    /// </summary>
+    const GPUMemoryTracker* _gpuMemory = nullptr;
+
+    /// <summary>
+    /// The zones reported, see RecordProfileZones
+    /// </summary>
+    const ZoneStatisticsBackend* _profileZones = nullptr;
+
+    /// <summary>
+    /// Where windows are summed, kept so summaries don't allocate either
+    /// </summary>
+    mutable DurationHistogram _window;
+
+
+public:
+
+    /// <summary>
+    /// Presents further apart than this are a hitch, in milliseconds. About 1.5 refresh intervals
+    /// </summary>
+    double HitchThreshold = 25.0;
+
+    /// <summary>
+    /// Presents further apart than this are the loop idling in on-demand mode rather than stutter, and aren't recorded
+    /// </summary>
+    double IdleThreshold = 250.0;
+
+
+public:
+
+    /// <param name="intervalSeconds"> How much time each histogram covers, the granularity the window slides at </param>
+    explicit FrameStatistics(const double intervalSeconds = 1.0) :
+        _histograms(FrameMetricCount * IntervalCount),
+        _intervalSeconds(intervalSeconds)
+    {
+    };
+
+    FrameStatistics(const FrameStatistics&) = delete;
+    FrameStatistics& operator = (const FrameStatistics&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Record a presented frame's CPU time and present interval
+    /// </summary>
+    /// <param name="time"> Now, in glfwGetTime seconds, which decides the frame's interval </param>
+    void RecordFrame(const FrameTimings& timings, const double time)
+    {
+        Advance(time);
+
+        Record(FrameMetric::CPUFrameTime, timings.WorkTime * 1000.0);
+
+        const double presentInterval = timings.FrameTime * 1000.0;
+
+        if(presentInterval > IdleThreshold)
+            return;
+
+        Record(FrameMetric::PresentInterval, presentInterval);
+
+        if(presentInterval > HitchThreshold)
+        {
+            ++_hitchCounts[_currentInterval];
+            ++_totalHitchCount;
+        };
+    };
+
+    /// <summary>
+    /// Record the GPU time of the profiler's latest frame, if it read one back since the last call. The frame is a few frames old by now
+    /// </summary>
+    void RecordGPUFrame(const GPUProfiler& profiler)
+    {
+        if(profiler.GetReadBackCount() == _gpuReadBackCount)
+            return;
+
+        _gpuReadBackCount = profiler.GetReadBackCount();
+
+        double gpuMilliseconds = 0.0;
+
+        for(const ProfileScopeResult& result : profiler.GetResults())
+        {
+            if(result.Depth == 0)
+                gpuMilliseconds += result.GPUMilliseconds;
+        };
+
+        Record(FrameMetric::GPUFrameTime, gpuMilliseconds);
+    };
+
+    /// <summary>
+    /// Record the GL calls of the frame the counter just ended, and the time spent in the driver if calls are timed
+    /// </summary>
+    void RecordGLCalls(const GLCallCounter& counter)
+    {
+        _glCalls = counter.GetLastFrame().Calls;
+        _glCallsRecorded = true;
+
+        if(GLCallTiming == true)
+            Record(FrameMetric::DriverTime, counter.GetLastFrameDriverMilliseconds());
+    };
+
+    /// <summary>
+    /// Report a tracker's GPU memory with the frame statistics. It's read whenever they're formatted, so it must outlive them
+    /// </summary>
+    void RecordGPUMemory(const GPUMemoryTracker& tracker)
+    {
+        _gpuMemory = &tracker;
+    };
+
+    /// <summary>
+    /// Report the last frame's profile zones with the frame statistics. Read whenever they're formatted, so it must outlive them
+    /// </summary>
+    void RecordProfileZones(const ZoneStatisticsBackend& zones)
+    {
+        _profileZones = &zones;
+    };
+
+    void Reset()
+    {
+        for(DurationHistogram& histogram : _histograms)
+        {
+            histogram.Reset();
+        };
+
+        _hitchCounts.fill(0);
+        _totalHitchCount = 0;
+    };
+
+
+public:
+
+    /// <summary>
+    /// A metric over the last few intervals, the current one included
+    /// </summary>
+    /// <param name="intervalCount"> The window's length in intervals, at most IntervalCount </param>
+    FrameMetricSummary GetSummary(const FrameMetric metric, const std::size_t intervalCount = IntervalCount) const
+    {
+        _window.Reset();
+
+        for(std::size_t back = 0; back < std::min(intervalCount, IntervalCount); ++back)
+        {
+            _window.Add(GetHistogram(metric, (_currentInterval + IntervalCount - back) % IntervalCount));
+        };
+
+        return FrameMetricSummary { .Count = _window.GetCount(),
+                                    .P50 = _window.GetPercentile(0.50),
+                                    .P99 = _window.GetPercentile(0.99),
+                                    .Maximum = _window.GetMaximum() };
+    };
+
+    /// <summary>
+    /// Hitches over the last few intervals
+    /// </summary>
+    std::uint64_t GetHitchCount(const std::size_t intervalCount = IntervalCount) const
+    {
+        std::uint64_t hitchCount = 0;
+
+        for(std::size_t back = 0; back < std::min(intervalCount, IntervalCount); ++back)
+        {
+            hitchCount += _hitchCounts[(_currentInterval + IntervalCount - back) % IntervalCount];
+        };
+
+        return hitchCount;
+    };
+
+    /// <summary>
+    /// Every hitch since the statistics were created or reset
+    /// </summary>
+    std::uint64_t GetTotalHitchCount() const
+    {
+        return _totalHitchCount;
+    };
+
+
+    /// <summary>
+    /// The statistics as a table over the last interval and the whole window, for drawing on screen or dumping
+    /// </summary>
+    /// <param name="memory"> Where the text is allocated, e.g. a FrameArena when it's drawn every frame </param>
+    std::pmr::string Format(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const
+    {
+        std::pmr::string text = std::pmr::string(memory);
+
+        char line[128] = { };
+
+        std::snprintf(line, sizeof(line), "Frame ms         p50(1s)  p99(1s) p50(%zus) p99(%zus) max(%zus)\n", IntervalCount, IntervalCount, IntervalCount);
+
+        text.append(line);
+
+        for(std::size_t metric = 0; metric < FrameMetricCount; ++metric)
+        {
+            const FrameMetricSummary recent = GetSummary(static_cast<FrameMetric>(metric), 1);
+            const FrameMetricSummary window = GetSummary(static_cast<FrameMetric>(metric));
+
+            // Only measured on request
+            if(static_cast<FrameMetric>(metric) == FrameMetric::DriverTime && window.Count == 0)
+                continue;
+
+            std::snprintf(line, sizeof(line), "%-16s %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+                          GetFrameMetricName(static_cast<FrameMetric>(metric)),
+                          recent.P50, recent.P99, window.P50, window.P99, window.Maximum);
+
+            text.append(line);
+        };
+
+        std::snprintf(line, sizeof(line), "Hitches (>%.1f ms) %llu in 1s, %llu in %zus, %llu total\n",
+                      HitchThreshold,
+                      static_cast<unsigned long long>(GetHitchCount(1)),
+                      static_cast<unsigned long long>(GetHitchCount()),
+                      IntervalCount,
+                      static_cast<unsigned long long>(_totalHitchCount));
+
+        text.append(line);
+
+        if(_glCallsRecorded == true)
+            AppendGLCalls(text);
+
+        if(_gpuMemory != nullptr)
+            text.append(_gpuMemory->Format(memory));
+
+        if(_profileZones != nullptr)
+            text.append(_profileZones->Format(memory));
+
+        return text;
+    };
+
+    void Dump(std::ostream& stream) const
+    {
+        stream << Format();
+    };
+
+
+    static const char* GetFrameMetricName(const FrameMetric metric)
+    {
+        switch(metric)
+        {
+            case FrameMetric::CPUFrameTime:
+                return "CPU frame";
+
+            case FrameMetric::GPUFrameTime:
+                return "GPU frame";
+
+            case FrameMetric::PresentInterval:
+                return "Present interval";
+
+            case FrameMetric::DriverTime:
+                return "GL driver";
+        };
+
+        return "";
+    };
+
+
+private:
+
+    /// <summary>
+    /// The last frame's GL call count, and the entry points called most
+    /// </summary>
+    void AppendGLCalls(std::pmr::string& text) const
+    {
+        constexpr std::size_t TopCount = 4;
+
+        std::array<std::size_t, GLEntryPointCount> entryPoints;
+        std::iota(entryPoints.begin(), entryPoints.end(), std::size_t(0));
+
+        std::partial_sort(entryPoints.begin(), entryPoints.begin() + TopCount, entryPoints.end(),
+                          [this](const std::size_t left, const std::size_t right) { return _glCalls[left] > _glCalls[right]; });
+
+        std::uint64_t totalCalls = 0;
+
+        for(const std::uint64_t calls : _glCalls)
+        {
+            totalCalls += calls;
+        };
+
+        char line[128] = { };
+
+        std::snprintf(line, sizeof(line), "GL calls %llu:", static_cast<unsigned long long>(totalCalls));
+        text.append(line);
+
+        for(std::size_t top = 0; top < TopCount && _glCalls[entryPoints[top]] > 0; ++top)
+        {
+            const std::string_view name = GLEntryPointNames[entryPoints[top]];
+
+            std::snprintf(line, sizeof(line), " %.*s %llu", static_cast<int>(name.size()), name.data(), static_cast<unsigned long long>(_glCalls[entryPoints[top]]));
+            text.append(line);
+        };
+
+        text.push_back('\n');
+    };
+
+    void Record(const FrameMetric metric, const double milliseconds)
+    {
+        GetHistogram(metric, _currentInterval).Record(milliseconds);
+    };
+
+    DurationHistogram& GetHistogram(const FrameMetric metric, const std::size_t interval)
+    {
+        return _histograms[static_cast<std::size_t>(metric) * IntervalCount + interval];
+    };
+
+    const DurationHistogram& GetHistogram(const FrameMetric metric, const std::size_t interval) const
+    {
+        return _histograms[static_cast<std::size_t>(metric) * IntervalCount + interval];
+    };
+
+    /// <summary>
+    /// Move on to the interval a time falls in, clearing every interval skipped over so an idle stretch doesn't leave old frames in the window
+    /// </summary>
+    void Advance(const double time)
+    {
+        if(_intervalStart < 0.0)
+        {
+            _intervalStart = time;
+            return;
+        };
+
+        const double elapsedIntervals = (time - _intervalStart) / _intervalSeconds;
+
+        if(elapsedIntervals < 1.0)
+            return;
+
+        const std::size_t skipped = std::min(static_cast<std::size_t>(elapsedIntervals), IntervalCount);
+
+        for(std::size_t step = 0; step < skipped; ++step)
+        {
+            _currentInterval = (_currentInterval + 1) % IntervalCount;
+
+            for(std::size_t metric = 0; metric < FrameMetricCount; ++metric)
+            {
+                GetHistogram(static_cast<FrameMetric>(metric), _currentInterval).Reset();
+            };
+
+            _hitchCounts[_currentInterval] = 0;
+        };
+
+        _intervalStart += static_cast<double>(static_cast<std::size_t>(elapsedIntervals)) * _intervalSeconds;
+    };
+
+};
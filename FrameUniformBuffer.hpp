@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/vec2.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "GLStateCache.hpp"
+
+
+/// <summary>
+/// Data shared by every draw in a frame, matches the std140 "FrameData" block in the vertex shaders
+/// </summary>
+struct FrameData
+{
+    glm::mat4 ScreenSpaceProjection = glm::mat4(1.0f);
+
+    glm::mat4 View = glm::mat4(1.0f);
+
+    glm::vec2 ViewportSize = { 0.0f, 0.0f };
+
+    /// <summary>
+    /// Time since startup, in seconds
+    /// </summary>
+    float Time = 0.0f;
+
+    /// <summary>
+    /// Framebuffer pixels per window unit of the monitor the window is on, see ContentScale.hpp
+    /// </summary>
+    float ContentScale = 1.0f;
+};
+
+static_assert(sizeof(FrameData) == 144, "FrameData must match the std140 block size");
+
+
+/// <summary>
+/// A uniform buffer holding the current frame's FrameData, bound once at a fixed binding point so every program can read it
+/// </summary>
+class FrameUniformBuffer
+{
+
+public:
+
+    /// <summary>
+    /// The uniform buffer binding point the shaders' "FrameData" block is bound to
+    /// </summary>
+    static constexpr std::uint32_t BindingIndex = 0;
+
+
+private:
+
+    std::uint32_t _bufferID = 0;
+
+    /// <summary>
+    /// (Lazy updates) The data last uploaded, or about to be by Upload
+    /// </summary>
+    mutable FrameData _frameData;
+
+    /// <summary>
+    /// (Lazy updates) Whether the projection, viewport or content scale changed since the last Upload, otherwise only the time is uploaded
+    /// </summary>
+    mutable bool _viewportDirty = false;
+
+
+public:
+
+    FrameUniformBuffer()
+    {
+        glCreateBuffers(1, &_bufferID);
+
+        const FrameData initialData = FrameData();
+        glNamedBufferStorage(_bufferID, sizeof(FrameData), &initialData, GL_DYNAMIC_STORAGE_BIT);
+
+        Bind();
+    };
+
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+
+    ~FrameUniformBuffer()
+    {
+        if(_bufferID != 0)
+            GLState.DeleteBuffer(_bufferID);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Upload the frame's data, should be called once per frame before any draws
+    /// </summary>
+    /// <param name="frameData"></param>
+    void Update(const FrameData& frameData) const
+    {
+        glNamedBufferSubData(_bufferID, 0, sizeof(FrameData), &frameData);
+    };
+
+    /// <summary>
+    /// Set the viewport the screen space projection maps, the projection is only rebuilt when the size changed and uploaded by the next Upload.
+    /// Lets a resize be picked up by the next frame instead of being drawn from inside the resize callback
+    /// </summary>
+    void SetViewportSize(const int width, const int height) const
+    {
+        const glm::vec2 viewportSize = glm::vec2(static_cast<float>(width), static_cast<float>(height));
+
+        if(viewportSize == _frameData.ViewportSize)
+            return;
+
+        _frameData.ScreenSpaceProjection = glm::ortho(0.0f, viewportSize.x, viewportSize.y, 0.0f, -1.0f, 1.0f);
+        _frameData.ViewportSize = viewportSize;
+
+        _viewportDirty = true;
+    };
+
+    /// <summary>
+    /// Set the content scale of the monitor the window is on, uploaded by the next Upload if it changed
+    /// </summary>
+    void SetContentScale(const float contentScale) const
+    {
+        if(contentScale == _frameData.ContentScale)
+            return;
+
+        _frameData.ContentScale = contentScale;
+
+        _viewportDirty = true;
+    };
+
+    float GetContentScale() const
+    {
+        return _frameData.ContentScale;
+    };
+
+    /// <summary>
+    /// Upload the frame's time, and the projection and viewport if SetViewportSize changed them. Should be called once per frame before any draws
+    /// </summary>
+    /// <param name="time"> Time since startup, in seconds </param>
+    void Upload(const float time) const
+    {
+        _frameData.Time = time;
+
+        if(_viewportDirty == true)
+        {
+            Update(_frameData);
+
+            _viewportDirty = false;
+            return;
+        };
+
+        glNamedBufferSubData(_bufferID, offsetof(FrameData, Time), sizeof(float), &_frameData.Time);
+    };
+
+
+    void Bind() const
+    {
+        GLState.BindBufferBase(GL_UNIFORM_BUFFER, BindingIndex, _bufferID);
+    };
+
+
+public:
+
+    std::uint32_t GetBufferID() const
+    {
+        return _bufferID;
+    };
+};
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <Windows.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+// Optional instrumentation of the GL entry points the renderer calls. InstallGLCallCounting swaps glad's function pointers for wrappers
+// that count every call, and optionally time it, before forwarding to the driver. Nothing is wrapped unless it's installed,
+// so the cost is only paid by runs that ask for it, e.g. with "--count-gl-calls"
+
+
+#pragma region Entry points
+
+// Every entry point the renderer calls. Names are only ever stringized or pasted, since glad defines each of them as a macro
+#define TEXT_RENDERER_GL_ENTRY_POINTS(X) \
+    X(glAttachShader) X(glBeginQuery) X(glBindBuffer) X(glBindBufferBase) X(glBindBufferRange) X(glBindFramebuffer) \
+    X(glBindProgramPipeline) X(glBindTextureUnit) X(glBindVertexArray) X(glBlendFunc) X(glBlendFuncSeparate) X(glBlitNamedFramebuffer) \
+    X(glCheckNamedFramebufferStatus) X(glClear) X(glClearColor) X(glClearNamedFramebufferfv) X(glClearTexImage) X(glClearTexSubImage) \
+    X(glClientWaitSync) X(glCompileShader) X(glCompressedTextureSubImage2D) X(glCopyImageSubData) X(glCopyNamedBufferSubData) \
+    X(glCreateBuffers) X(glCreateFramebuffers) X(glCreateProgram) X(glCreateProgramPipelines) X(glCreateQueries) X(glCreateRenderbuffers) \
+    X(glCreateShader) X(glCreateShaderProgramv) X(glCreateTextures) X(glCreateVertexArrays) X(glDebugMessageCallback) \
+    X(glDeleteBuffers) X(glDeleteFramebuffers) X(glDeleteProgram) X(glDeleteProgramPipelines) X(glDeleteQueries) X(glDeleteRenderbuffers) \
+    X(glDeleteShader) X(glDeleteSync) X(glDeleteTextures) X(glDeleteVertexArrays) X(glDetachShader) X(glDisable) X(glDispatchCompute) \
+    X(glDrawArraysIndirect) X(glDrawArraysInstanced) X(glEnable) X(glEndQuery) X(glFenceSync) X(glFinish) X(glFlush) \
+    X(glGenerateTextureMipmap) X(glGetInteger64v) X(glGetIntegerv) X(glGetInternalformativ) X(glGetProgramBinary) X(glGetProgramInfoLog) \
+    X(glGetProgramPipelineInfoLog) X(glGetProgramPipelineiv) X(glGetProgramResourceIndex) X(glGetProgramResourceName) X(glGetProgramResourceiv) \
+    X(glGetProgramiv) X(glGetQueryObjectiv) X(glGetQueryObjectui64v) X(glGetShaderInfoLog) X(glGetShaderiv) X(glGetString) \
+    X(glGetTextureLevelParameteriv) X(glGetUniformLocation) X(glInvalidateBufferData) X(glInvalidateBufferSubData) X(glLinkProgram) X(glMapNamedBufferRange) X(glMemoryBarrier) \
+    X(glMultiDrawArraysIndirect) X(glNamedBufferData) X(glNamedBufferStorage) X(glNamedBufferSubData) X(glNamedFramebufferReadBuffer) \
+    X(glNamedFramebufferRenderbuffer) X(glNamedFramebufferTexture) X(glNamedRenderbufferStorage) X(glPixelStorei) X(glProgramBinary) \
+    X(glProgramParameteri) X(glProgramUniform1f) X(glProgramUniform1i) X(glProgramUniform1ui) X(glProgramUniform2f) X(glProgramUniform3f) \
+    X(glProgramUniformMatrix4fv) X(glQueryCounter) X(glReadnPixels) X(glScissor) X(glShaderSource) X(glTextureParameteri) X(glTextureStorage2D) \
+    X(glTextureStorage3D) X(glTextureSubImage2D) X(glTextureSubImage3D) X(glUnmapNamedBuffer) X(glUseProgram) X(glUseProgramStages) \
+    X(glValidateProgramPipeline) X(glViewport) X(glWaitSync)
+
+
+#define TEXT_RENDERER_GL_ENTRY_POINT_NAME(name) #name,
+
+/// <summary>
+/// The wrapped entry points' names, an entry point's index in here indexes its counters
+/// </summary>
+inline constexpr std::array GLEntryPointNames = std::to_array<std::string_view>({ TEXT_RENDERER_GL_ENTRY_POINTS(TEXT_RENDERER_GL_ENTRY_POINT_NAME) });
+
+#undef TEXT_RENDERER_GL_ENTRY_POINT_NAME
+
+inline constexpr std::size_t GLEntryPointCount = GLEntryPointNames.size();
+
+
+consteval std::size_t GetGLEntryPointIndex(const std::string_view& name)
+{
+    return static_cast<std::size_t>(std::find(GLEntryPointNames.cbegin(), GLEntryPointNames.cend(), name) - GLEntryPointNames.cbegin());
+};
+
+#pragma endregion
+
+
+/// <summary>
+/// The GL calls a thread made, since it started or over a frame, see GLCallCounter
+/// </summary>
+struct GLCallCounts
+{
+    /// <summary>
+    /// By entry point, see GLEntryPointNames
+    /// </summary>
+    std::array<std::uint64_t, GLEntryPointCount> Calls = { };
+
+    /// <summary>
+    /// (Timed counting) QueryPerformanceCounter ticks spent inside each entry point
+    /// </summary>
+    std::array<std::int64_t, GLEntryPointCount> Ticks = { };
+
+
+    std::uint64_t GetTotalCalls() const
+    {
+        std::uint64_t totalCalls = 0;
+
+        for(const std::uint64_t calls : Calls)
+        {
+            totalCalls += calls;
+        };
+
+        return totalCalls;
+    };
+
+    std::int64_t GetTotalTicks() const
+    {
+        std::int64_t totalTicks = 0;
+
+        for(const std::int64_t ticks : Ticks)
+        {
+            totalTicks += ticks;
+        };
+
+        return totalTicks;
+    };
+};
+
+
+/// <summary>
+/// Every thread counts its own calls, so counting needs no atomics and a frame's counts are only the render thread's
+/// </summary>
+inline thread_local GLCallCounts ThreadGLCallCounts;
+
+/// <summary>
+/// Set by InstallGLCallCounting, nothing is counted before
+/// </summary>
+inline bool GLCallCountingInstalled = false;
+
+/// <summary>
+/// Whether wrapped calls are timed too, which costs two QueryPerformanceCounter calls per GL call. Set by InstallGLCallCounting
+/// </summary>
+inline bool GLCallTiming = false;
+
+
+namespace GLCallCountingDetail
+{
+
+    template<std::size_t Index, typename TFunction>
+    struct Wrapper;
+
+    template<std::size_t Index, typename TReturn, typename... TArguments>
+    struct Wrapper<Index, TReturn (APIENTRYP)(TArguments...)>
+    {
+        /// <summary>
+        /// glad's pointer, before it was replaced by Call
+        /// </summary>
+        static inline TReturn (APIENTRYP Driver)(TArguments...) = nullptr;
+
+
+        static TReturn APIENTRY Call(TArguments... arguments)
+        {
+            GLCallCounts& counts = ThreadGLCallCounts;
+
+            ++counts.Calls[Index];
+
+            if(GLCallTiming == false)
+                return Driver(arguments...);
+
+
+            LARGE_INTEGER begin;
+            QueryPerformanceCounter(&begin);
+
+            // Scoped, so functions that return something are timed too
+            struct Timer
+            {
+                std::int64_t& Ticks;
+                const std::int64_t Begin;
+
+                ~Timer()
+                {
+                    LARGE_INTEGER end;
+                    QueryPerformanceCounter(&end);
+
+                    Ticks += end.QuadPart - Begin;
+                };
+            };
+
+            const Timer timer = Timer { counts.Ticks[Index], begin.QuadPart };
+
+            return Driver(arguments...);
+        };
+    };
+
+};
+
+
+/// <summary>
+/// Wrap glad's function pointers, once glad is loaded and before the render thread starts.
+/// The pointers are process-wide, every thread's calls are counted from here on, each in its own ThreadGLCallCounts
+/// </summary>
+/// <param name="timed"> Whether the time spent inside the driver is measured as well </param>
+inline void InstallGLCallCounting(const bool timed)
+{
+    GLCallTiming = timed;
+    GLCallCountingInstalled = true;
+
+    #define TEXT_RENDERER_GL_WRAP(name)                                                                                          \
+    {                                                                                                                            \
+        using TWrapper = GLCallCountingDetail::Wrapper<GetGLEntryPointIndex(#name), decltype(glad_##name)>;                       \
+                                                                                                                                 \
+        /* Installing twice would wrap the wrapper */                                                                            \
+        if(glad_##name != nullptr && glad_##name != &TWrapper::Call)                                                             \
+        {                                                                                                                        \
+            TWrapper::Driver = glad_##name;                                                                                      \
+            glad_##name = &TWrapper::Call;                                                                                       \
+        };                                                                                                                       \
+    };
+
+    TEXT_RENDERER_GL_ENTRY_POINTS(TEXT_RENDERER_GL_WRAP)
+
+    #undef TEXT_RENDERER_GL_WRAP
+};
+
+
+/// <summary>
+/// Splits a thread's GL calls into frames. Only counts anything once InstallGLCallCounting was called
+/// </summary>
+class GLCallCounter
+{
+
+private:
+
+    /// <summary>
+    /// The thread's counts when the previous frame ended
+    /// </summary>
+    GLCallCounts _frameStart;
+
+    GLCallCounts _lastFrame;
+
+    double _millisecondsPerTick = 0.0;
+
+
+public:
+
+    GLCallCounter()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+
+        _millisecondsPerTick = 1000.0 / static_cast<double>(frequency.QuadPart);
+    };
+
+
+public:
+
+    /// <summary>
+    /// (The counted thread) End a frame, the calls since the previous EndFrame become GetLastFrame
+    /// </summary>
+    const GLCallCounts& EndFrame()
+    {
+        const GLCallCounts& counts = ThreadGLCallCounts;
+
+        for(std::size_t entryPoint = 0; entryPoint < GLEntryPointCount; ++entryPoint)
+        {
+            _lastFrame.Calls[entryPoint] = counts.Calls[entryPoint] - _frameStart.Calls[entryPoint];
+            _lastFrame.Ticks[entryPoint] = counts.Ticks[entryPoint] - _frameStart.Ticks[entryPoint];
+        };
+
+        _frameStart = counts;
+
+        return _lastFrame;
+    };
+
+    const GLCallCounts& GetLastFrame() const
+    {
+        return _lastFrame;
+    };
+
+    /// <summary>
+    /// The time the last frame spent inside the driver, 0 unless calls are timed
+    /// </summary>
+    double GetLastFrameDriverMilliseconds() const
+    {
+        return static_cast<double>(_lastFrame.GetTotalTicks()) * _millisecondsPerTick;
+    };
+
+};
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <Windows.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+#include <string_view>
+
+
+/// <summary>
+/// How much the GL validates, and what happens to the messages it reports
+/// </summary>
+enum class GLDiagnosticsLevel
+{
+    /// <summary>
+    /// A no-error context, the driver skips validation entirely. Errors are undefined behaviour
+    /// </summary>
+    Off,
+
+    /// <summary>
+    /// Debug output is asynchronous, messages are buffered and written out once per frame by FlushGLDebugLog
+    /// </summary>
+    AsyncLogging,
+
+    /// <summary>
+    /// Debug output is synchronous, every message is written out immediately and breaks into the debugger
+    /// </summary>
+    SynchronousBreak,
+};
+
+
+/// <summary>
+/// A bounded multi-producer, single-consumer queue of debug messages.
+/// The driver may call the debug callback from any of its threads, so pushing is lock-free and drops messages when full instead of blocking
+/// </summary>
+class GLDebugLog
+{
+
+public:
+
+    struct Message
+    {
+        GLenum Source = 0;
+        GLenum Type = 0;
+        GLuint ID = 0;
+        GLenum Severity = 0;
+
+        /// <summary>
+        /// Truncated to fit, null-terminated
+        /// </summary>
+        std::array<char, 256> Text = { };
+    };
+
+
+private:
+
+    static constexpr std::size_t Capacity = 256;
+
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+
+    struct Slot
+    {
+        /// <summary>
+        /// Equal to the slot's push position when free, one past it once written
+        /// </summary>
+        std::atomic<std::size_t> Sequence = 0;
+
+        Message Value;
+    };
+
+
+    std::array<Slot, Capacity> _slots;
+
+    alignas(64) std::atomic<std::size_t> _pushPosition = 0;
+
+    alignas(64) std::size_t _popPosition = 0;
+
+    std::atomic<std::size_t> _droppedCount = 0;
+
+
+public:
+
+    GLDebugLog()
+    {
+        for(std::size_t index = 0; index < Capacity; ++index)
+        {
+            _slots[index].Sequence.store(index, std::memory_order_relaxed);
+        };
+    };
+
+    GLDebugLog(const GLDebugLog&) = delete;
+    GLDebugLog& operator = (const GLDebugLog&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Add a message, from any thread
+    /// </summary>
+    /// <returns> False if the log was full and the message was dropped </returns>
+    bool Push(const GLenum source, const GLenum type, const GLuint id, const GLenum severity, const std::string_view& text)
+    {
+        std::size_t position = _pushPosition.load(std::memory_order_relaxed);
+
+        while(true)
+        {
+            Slot& slot = _slots[position & (Capacity - 1)];
+
+            const std::size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+
+            // The slot is free for this position, try to claim it
+            if(sequence == position)
+            {
+                if(_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) == true)
+                {
+                    slot.Value.Source = source;
+                    slot.Value.Type = type;
+                    slot.Value.ID = id;
+                    slot.Value.Severity = severity;
+
+                    const std::size_t length = std::min(text.size(), slot.Value.Text.size() - 1);
+
+                    std::memcpy(slot.Value.Text.data(), text.data(), length);
+                    slot.Value.Text[length] = '\0';
+
+                    slot.Sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                };
+            }
+            // The slot still holds an unread message from the previous lap, the log is full
+            else if(sequence < position)
+            {
+                _droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            // Another thread claimed the position first
+            else
+                position = _pushPosition.load(std::memory_order_relaxed);
+        };
+    };
+
+    /// <summary>
+    /// Take the oldest message. Only a single thread may pop
+    /// </summary>
+    /// <returns> False if the log is empty </returns>
+    bool Pop(Message& message)
+    {
+        Slot& slot = _slots[_popPosition & (Capacity - 1)];
+
+        if(slot.Sequence.load(std::memory_order_acquire) != _popPosition + 1)
+            return false;
+
+        message = slot.Value;
+
+        // Free the slot for the next lap
+        slot.Sequence.store(_popPosition + Capacity, std::memory_order_release);
+        ++_popPosition;
+
+        return true;
+    };
+
+    /// <summary>
+    /// Get, and clear, the number of messages dropped because the log was full
+    /// </summary>
+    std::size_t TakeDroppedCount()
+    {
+        return _droppedCount.exchange(0, std::memory_order_relaxed);
+    };
+
+};
+
+
+inline GLDiagnosticsLevel GLDiagnostics = GLDiagnosticsLevel::SynchronousBreak;
+
+inline GLDebugLog GLDebugMessages;
+
+
+inline const char* GetGLDebugSeverityName(const GLenum severity)
+{
+    switch(severity)
+    {
+        case GL_DEBUG_SEVERITY_HIGH:
+            return "High";
+
+        case GL_DEBUG_SEVERITY_MEDIUM:
+            return "Medium";
+
+        case GL_DEBUG_SEVERITY_LOW:
+            return "Low";
+
+        default:
+            return "Notification";
+    };
+};
+
+
+inline void APIENTRY GLDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+{
+    // Ignore unused parameter warnings
+    (void*)&userParam;
+
+    // Notifications are informational, only actual problems are reported
+    if(severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+        return;
+
+    const std::string_view text = length >= 0 ? std::string_view(message, static_cast<std::size_t>(length)) : std::string_view(message);
+
+    if(GLDiagnostics == GLDiagnosticsLevel::AsyncLogging)
+    {
+        GLDebugMessages.Push(source, type, id, severity, text);
+        return;
+    };
+
+
+    std::cerr << text << "\n";
+
+    __debugbreak();
+};
+
+
+/// <summary>
+/// Set the window hints the diagnostics level needs, before the window is created
+/// </summary>
+inline void SetGLDiagnosticsWindowHints(const GLDiagnosticsLevel level)
+{
+    // GLFW errors during window creation already follow the level
+    GLDiagnostics = level;
+
+    glfwWindowHint(GLFW_CONTEXT_NO_ERROR, level == GLDiagnosticsLevel::Off ? GLFW_TRUE : GLFW_FALSE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, level == GLDiagnosticsLevel::Off ? GLFW_FALSE : GLFW_TRUE);
+};
+
+/// <summary>
+/// Enable debug output for a diagnostics level, after the context is made current and glad is loaded
+/// </summary>
+inline void EnableGLDiagnostics(const GLDiagnosticsLevel level)
+{
+    GLDiagnostics = level;
+
+    switch(level)
+    {
+        case GLDiagnosticsLevel::Off:
+        {
+            glDisable(GL_DEBUG_OUTPUT);
+            break;
+        };
+
+        case GLDiagnosticsLevel::AsyncLogging:
+        {
+            glEnable(GL_DEBUG_OUTPUT);
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            glDebugMessageCallback(GLDebugCallback, nullptr);
+            break;
+        };
+
+        case GLDiagnosticsLevel::SynchronousBreak:
+        {
+            glEnable(GL_DEBUG_OUTPUT);
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            glDebugMessageCallback(GLDebugCallback, nullptr);
+            break;
+        };
+    };
+};
+
+/// <summary>
+/// (Async logging) Write out the buffered debug messages, should be called once per frame
+/// </summary>
+inline void FlushGLDebugLog(std::ostream& stream)
+{
+    GLDebugLog::Message message;
+
+    while(GLDebugMessages.Pop(message) == true)
+    {
+        stream << "GL " << GetGLDebugSeverityName(message.Severity) << " (" << message.ID << "): " << message.Text.data() << "\n";
+    };
+
+    if(const std::size_t droppedCount = GLDebugMessages.TakeDroppedCount(); droppedCount > 0)
+        stream << "GL debug log full, " << droppedCount << " messages dropped\n";
+};
+
+
+/// <summary>
+/// Parse a level from "off", "log" or "break"
+/// </summary>
+/// <returns> The default level if the name isn't recognized </returns>
+inline GLDiagnosticsLevel ParseGLDiagnosticsLevel(const std::string_view& name, const GLDiagnosticsLevel defaultLevel)
+{
+    if(name == "off")
+        return GLDiagnosticsLevel::Off;
+
+    if(name == "log")
+        return GLDiagnosticsLevel::AsyncLogging;
+
+    if(name == "break")
+        return GLDiagnosticsLevel::SynchronousBreak;
+
+    return defaultLevel;
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+
+// The glad loader only covers core 4.6, so the few extensions we use are declared and loaded here
+
+
+#pragma region GL_KHR_parallel_shader_compile
+
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+inline PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR = nullptr;
+
+#pragma endregion
+
+
+#pragma region GL_ARB_bindless_texture
+
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+inline PFNGLGETTEXTUREHANDLEARBPROC glGetTextureHandleARB = nullptr;
+inline PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glMakeTextureHandleResidentARB = nullptr;
+inline PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glMakeTextureHandleNonResidentARB = nullptr;
+
+#pragma endregion
+
+
+#pragma region GL_ARB_sparse_buffer
+
+#define GL_SPARSE_STORAGE_BIT_ARB 0x0400
+#define GL_SPARSE_BUFFER_PAGE_SIZE_ARB 0x82F8
+
+typedef void (APIENTRYP PFNGLNAMEDBUFFERPAGECOMMITMENTARBPROC)(GLuint buffer, GLintptr offset, GLsizeiptr size, GLboolean commit);
+
+inline PFNGLNAMEDBUFFERPAGECOMMITMENTARBPROC glNamedBufferPageCommitmentARB = nullptr;
+
+#pragma endregion
+
+
+#pragma region GL_NVX_gpu_memory_info, GL_ATI_meminfo
+
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+
+#pragma endregion
+
+
+/// <summary>
+/// Which of the optional extensions the current context supports
+/// </summary>
+struct GLExtensionSupport
+{
+    /// <summary>
+    /// GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile
+    /// </summary>
+    bool ParallelShaderCompile = false;
+
+    /// <summary>
+    /// WGL_EXT_swap_control_tear or GLX_EXT_swap_control_tear, allows a negative swap interval for adaptive v-sync
+    /// </summary>
+    bool SwapControlTear = false;
+
+    /// <summary>
+    /// GL_ARB_bindless_texture, textures are sampled through 64-bit handles instead of texture units
+    /// </summary>
+    bool BindlessTexture = false;
+
+    /// <summary>
+    /// GL_ARB_sparse_buffer with direct state access, buffers can reserve a virtual range and back only parts of it with memory
+    /// </summary>
+    bool SparseBuffer = false;
+
+    /// <summary>
+    /// GL_NVX_gpu_memory_info, the driver reports the device's total and free memory, see QueryGPUMemoryInfo
+    /// </summary>
+    bool GPUMemoryInfoNVX = false;
+
+    /// <summary>
+    /// GL_ATI_meminfo, the driver reports the device's free memory
+    /// </summary>
+    bool MemInfoATI = false;
+};
+
+inline GLExtensionSupport GLExtensions;
+
+
+/// <summary>
+/// Query and load the optional extensions. Must be called after the context is made current and glad is loaded
+/// </summary>
+inline void LoadGLExtensions()
+{
+    // The ARB version is identical, down to the enum values
+    if(glfwExtensionSupported("GL_KHR_parallel_shader_compile") == GLFW_TRUE)
+    {
+        glMaxShaderCompilerThreadsKHR = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+    }
+    else if(glfwExtensionSupported("GL_ARB_parallel_shader_compile") == GLFW_TRUE)
+    {
+        glMaxShaderCompilerThreadsKHR = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+    };
+
+    GLExtensions.ParallelShaderCompile = glMaxShaderCompilerThreadsKHR != nullptr;
+
+    // Only changes what glfwSwapInterval accepts, there's nothing to load
+    GLExtensions.SwapControlTear = glfwExtensionSupported("WGL_EXT_swap_control_tear") == GLFW_TRUE ||
+                                   glfwExtensionSupported("GLX_EXT_swap_control_tear") == GLFW_TRUE;
+
+    if(glfwExtensionSupported("GL_ARB_bindless_texture") == GLFW_TRUE)
+    {
+        glGetTextureHandleARB = reinterpret_cast<PFNGLGETTEXTUREHANDLEARBPROC>(glfwGetProcAddress("glGetTextureHandleARB"));
+        glMakeTextureHandleResidentARB = reinterpret_cast<PFNGLMAKETEXTUREHANDLERESIDENTARBPROC>(glfwGetProcAddress("glMakeTextureHandleResidentARB"));
+        glMakeTextureHandleNonResidentARB = reinterpret_cast<PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC>(glfwGetProcAddress("glMakeTextureHandleNonResidentARB"));
+    };
+
+    GLExtensions.BindlessTexture = glGetTextureHandleARB != nullptr &&
+                                   glMakeTextureHandleResidentARB != nullptr &&
+                                   glMakeTextureHandleNonResidentARB != nullptr;
+
+    // Some drivers only expose the named entry point under its EXT_direct_state_access name, the signature is the same
+    if(glfwExtensionSupported("GL_ARB_sparse_buffer") == GLFW_TRUE)
+    {
+        glNamedBufferPageCommitmentARB = reinterpret_cast<PFNGLNAMEDBUFFERPAGECOMMITMENTARBPROC>(glfwGetProcAddress("glNamedBufferPageCommitmentARB"));
+
+        if(glNamedBufferPageCommitmentARB == nullptr)
+            glNamedBufferPageCommitmentARB = reinterpret_cast<PFNGLNAMEDBUFFERPAGECOMMITMENTARBPROC>(glfwGetProcAddress("glNamedBufferPageCommitmentEXT"));
+    };
+
+    GLExtensions.SparseBuffer = glNamedBufferPageCommitmentARB != nullptr;
+
+    // Both are only queries, there's nothing to load
+    GLExtensions.GPUMemoryInfoNVX = glfwExtensionSupported("GL_NVX_gpu_memory_info") == GLFW_TRUE;
+    GLExtensions.MemInfoATI = glfwExtensionSupported("GL_ATI_meminfo") == GLFW_TRUE;
+};
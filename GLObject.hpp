@@ -0,0 +1,176 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <utility>
+
+#include "GLStateCache.hpp"
+
+
+/// <summary>
+/// Owns a GL object's name, and deletes it through GLState when it's destroyed or replaced.
+/// Move-only, a moved-from object owns nothing. Like the names themselves, only for the thread whose context created them
+/// </summary>
+/// <typeparam name="TObjectTraits"> Deletes, and optionally creates, objects of the kind </typeparam>
+template<typename TObjectTraits>
+class GLObject
+{
+
+private:
+
+    std::uint32_t _id = 0;
+
+
+public:
+
+    GLObject() = default;
+
+    /// <summary>
+    /// Take ownership of an existing object
+    /// </summary>
+    explicit GLObject(const std::uint32_t id) :
+        _id(id)
+    {
+    };
+
+    GLObject(const GLObject&) = delete;
+    GLObject& operator = (const GLObject&) = delete;
+
+    GLObject(GLObject&& other) noexcept :
+        _id(std::exchange(other._id, 0))
+    {
+    };
+
+    GLObject& operator = (GLObject&& other) noexcept
+    {
+        if(this != &other)
+            Reset(std::exchange(other._id, 0));
+
+        return *this;
+    };
+
+    ~GLObject()
+    {
+        Reset();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Create a new object of the kind
+    /// </summary>
+    static GLObject Create()
+    {
+        return GLObject(TObjectTraits::Create());
+    };
+
+
+public:
+
+    /// <summary>
+    /// Delete the owned object, and take ownership of another one if given
+    /// </summary>
+    void Reset(const std::uint32_t id = 0)
+    {
+        if(_id != 0)
+            TObjectTraits::Delete(_id);
+
+        _id = id;
+    };
+
+    /// <summary>
+    /// Give up ownership of the object without deleting it
+    /// </summary>
+    std::uint32_t Release()
+    {
+        return std::exchange(_id, 0);
+    };
+
+    std::uint32_t Get() const
+    {
+        return _id;
+    };
+
+};
+
+
+struct GLBufferTraits
+{
+    static std::uint32_t Create()
+    {
+        std::uint32_t bufferID = 0;
+        glCreateBuffers(1, &bufferID);
+
+        return bufferID;
+    };
+
+    static void Delete(const std::uint32_t bufferID)
+    {
+        GLState.DeleteBuffer(bufferID);
+    };
+};
+
+/// <summary>
+/// Textures are created with a target, so they're adopted rather than created through GLObject::Create
+/// </summary>
+struct GLTextureTraits
+{
+    static void Delete(const std::uint32_t textureID)
+    {
+        GLState.DeleteTexture(textureID);
+    };
+};
+
+struct GLVertexArrayTraits
+{
+    static std::uint32_t Create()
+    {
+        std::uint32_t vertexArrayID = 0;
+        glCreateVertexArrays(1, &vertexArrayID);
+
+        return vertexArrayID;
+    };
+
+    static void Delete(const std::uint32_t vertexArrayID)
+    {
+        GLState.DeleteVertexArray(vertexArrayID);
+    };
+};
+
+struct GLProgramTraits
+{
+    static std::uint32_t Create()
+    {
+        return glCreateProgram();
+    };
+
+    static void Delete(const std::uint32_t programID)
+    {
+        GLState.DeleteProgram(programID);
+    };
+};
+
+
+struct GLProgramPipelineTraits
+{
+    static std::uint32_t Create()
+    {
+        std::uint32_t pipelineID = 0;
+        glCreateProgramPipelines(1, &pipelineID);
+
+        return pipelineID;
+    };
+
+    static void Delete(const std::uint32_t pipelineID)
+    {
+        GLState.DeleteProgramPipeline(pipelineID);
+    };
+};
+
+
+using GLBuffer = GLObject<GLBufferTraits>;
+using GLTexture = GLObject<GLTextureTraits>;
+using GLVertexArray = GLObject<GLVertexArrayTraits>;
+using GLProgram = GLObject<GLProgramTraits>;
+using GLProgramPipeline = GLObject<GLProgramPipelineTraits>;
@@ -0,0 +1,524 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "RenderBackend.hpp"
+#include "GLStateCache.hpp"
+#include "GPUMemory.hpp"
+#include "ProgramPipeline.hpp"
+#include "ShaderProgram.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The GL 4.6 render backend: direct state access objects, bound through the GLState cache.
+/// Streaming buffers are persistently mapped and fenced once per frame for all of them, the way ShaderStorageBuffer's rings are fenced per buffer
+/// </summary>
+class GLRenderBackend : public IRenderBackend
+{
+
+private:
+
+    struct BufferSlot
+    {
+        std::uint32_t BufferID = 0;
+
+        BackendBufferUsage Usage = BackendBufferUsage::Static;
+
+        /// <summary>
+        /// (Streaming) The size of a region, aligned to the storage buffer offset alignment
+        /// </summary>
+        std::size_t RegionSizeInBytes = 0;
+
+        std::byte* MappedPointer = nullptr;
+    };
+
+    struct TextureSlot
+    {
+        std::uint32_t TextureID = 0;
+
+        BackendTextureFormat Format = BackendTextureFormat::RGBA8;
+    };
+
+    struct PipelineSlot
+    {
+        /// <summary>
+        /// Null for a program owned by the caller, see CreatePipeline(const ShaderProgram&, ...)
+        /// </summary>
+        std::unique_ptr<ShaderProgram> OwnedProgram;
+
+        const ShaderProgram* Program = nullptr;
+
+        /// <summary>
+        /// Set instead of Program for separately linked stages, see CreatePipeline(const ProgramPipeline&, ...)
+        /// </summary>
+        const ProgramPipeline* Pipeline = nullptr;
+
+        BackendBlendMode BlendMode = BackendBlendMode::Alpha;
+    };
+
+
+    /// <summary>
+    /// Handle N is at index N - 1, destroyed slots are reused
+    /// </summary>
+    std::vector<BufferSlot> _buffers;
+    std::vector<TextureSlot> _textures;
+    std::vector<PipelineSlot> _pipelines;
+
+    std::vector<std::uint32_t> _freeBuffers;
+    std::vector<std::uint32_t> _freeTextures;
+    std::vector<std::uint32_t> _freePipelines;
+
+    /// <summary>
+    /// Every draw is vertex-less, the core profile still requires a vertex array to be bound
+    /// </summary>
+    std::uint32_t _vertexArray = 0;
+
+    std::size_t _storageBufferOffsetAlignment = 0;
+
+    /// <summary>
+    /// One fence per frame in flight, signalled when the GPU is done with that frame's regions
+    /// </summary>
+    std::array<GLsync, FramesInFlight> _frameFences = { };
+
+    std::uint32_t _frameIndex = 0;
+
+    /// <summary>
+    /// Whether the current frame's fence was already waited for, only the first streaming write of a frame may have to
+    /// </summary>
+    bool _frameFenceWaited = false;
+
+
+public:
+
+    /// <summary>
+    /// Must be created on the thread the context is current on
+    /// </summary>
+    GLRenderBackend()
+    {
+        glCreateVertexArrays(1, &_vertexArray);
+
+        GLint alignment = 0;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+        _storageBufferOffsetAlignment = static_cast<std::size_t>(std::max(alignment, 1));
+    };
+
+    GLRenderBackend(const GLRenderBackend&) = delete;
+    GLRenderBackend& operator = (const GLRenderBackend&) = delete;
+
+    ~GLRenderBackend()
+    {
+        for(std::size_t index = 0; index < _buffers.size(); ++index)
+        {
+            if(_buffers[index].BufferID != 0)
+                DestroyBuffer(static_cast<BackendBuffer>(index + 1));
+        };
+
+        for(std::size_t index = 0; index < _textures.size(); ++index)
+        {
+            if(_textures[index].TextureID != 0)
+                DestroyTexture(static_cast<BackendTexture>(index + 1));
+        };
+
+        for(GLsync& fence : _frameFences)
+        {
+            if(fence != nullptr)
+                glDeleteSync(std::exchange(fence, nullptr));
+        };
+
+        GLState.DeleteVertexArray(_vertexArray);
+    };
+
+
+public:
+
+    BackendBuffer CreateBuffer(const BackendBufferDescription& description) override
+    {
+        BufferSlot slot = BufferSlot
+        {
+            .Usage = description.Usage,
+        };
+
+        glCreateBuffers(1, &slot.BufferID);
+
+        if(description.Usage == BackendBufferUsage::Streaming)
+        {
+            static constexpr GLbitfield storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            slot.RegionSizeInBytes = AlignToStorageBufferOffset(description.SizeInBytes);
+
+            const std::size_t sizeInBytes = slot.RegionSizeInBytes * FramesInFlight;
+
+            glNamedBufferStorage(slot.BufferID, static_cast<GLsizeiptr>(sizeInBytes), nullptr, storageFlags);
+
+            slot.MappedPointer = static_cast<std::byte*>(glMapNamedBufferRange(slot.BufferID, 0, static_cast<GLsizeiptr>(sizeInBytes), storageFlags));
+
+            wt::Assert(slot.MappedPointer != nullptr, "Failed to map a streaming buffer");
+
+            GPUMemory.TrackBuffer(slot.BufferID, sizeInBytes, GPUMemoryCategory::TextBuffer);
+        }
+        else
+        {
+            // Static buffers may still be updated, just rarely, so neither kind is immutable to the CPU
+            glNamedBufferStorage(slot.BufferID, static_cast<GLsizeiptr>(description.SizeInBytes), description.InitialData, GL_DYNAMIC_STORAGE_BIT);
+
+            GPUMemory.TrackBuffer(slot.BufferID, description.SizeInBytes, GPUMemoryCategory::TextBuffer);
+        };
+
+        return static_cast<BackendBuffer>(AddSlot(_buffers, _freeBuffers, std::move(slot)));
+    };
+
+    void DestroyBuffer(const BackendBuffer buffer) override
+    {
+        BufferSlot& slot = GetSlot(_buffers, buffer);
+
+        if(slot.MappedPointer != nullptr)
+            glUnmapNamedBuffer(slot.BufferID);
+
+        // GL keeps the storage alive until the commands that use it are done
+        GLState.DeleteBuffer(slot.BufferID);
+
+        slot = BufferSlot();
+
+        _freeBuffers.emplace_back(static_cast<std::uint32_t>(buffer));
+    };
+
+    void UpdateBuffer(const BackendBuffer buffer, const std::size_t offsetInBytes, const std::span<const std::byte>& bytes) override
+    {
+        const BufferSlot& slot = GetSlot(_buffers, buffer);
+
+        WT_ASSERT(slot.Usage != BackendBufferUsage::Streaming, "Streaming buffers are written through MapStreamingRegion");
+
+        glNamedBufferSubData(slot.BufferID, static_cast<GLintptr>(offsetInBytes), static_cast<GLsizeiptr>(bytes.size()), bytes.data());
+    };
+
+    std::byte* MapStreamingRegion(const BackendBuffer buffer) override
+    {
+        const BufferSlot& slot = GetSlot(_buffers, buffer);
+
+        WT_ASSERT(slot.Usage == BackendBufferUsage::Streaming, "Only streaming buffers are mapped");
+
+        WaitForFrameFence();
+
+        return slot.MappedPointer + slot.RegionSizeInBytes * _frameIndex;
+    };
+
+    std::size_t GetStreamingRegionOffset(const BackendBuffer buffer) const override
+    {
+        return GetSlot(_buffers, buffer).RegionSizeInBytes * _frameIndex;
+    };
+
+    std::size_t GetStorageBufferOffsetAlignment() const override
+    {
+        return _storageBufferOffsetAlignment;
+    };
+
+
+    BackendTexture CreateTexture(const BackendTextureDescription& description) override
+    {
+        TextureSlot slot = TextureSlot
+        {
+            .Format = description.Format,
+        };
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &slot.TextureID);
+
+        glTextureStorage2D(slot.TextureID, static_cast<GLsizei>(description.MipLevelCount), GetInternalFormat(description.Format),
+                           static_cast<GLsizei>(description.Width), static_cast<GLsizei>(description.Height));
+
+        const GLint magnificationFilter = description.LinearFiltering == true ? GL_LINEAR : GL_NEAREST;
+        const GLint minificationFilter = description.MipLevelCount > 1 ?
+            (description.LinearFiltering == true ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST) :
+            magnificationFilter;
+
+        glTextureParameteri(slot.TextureID, GL_TEXTURE_MIN_FILTER, minificationFilter);
+        glTextureParameteri(slot.TextureID, GL_TEXTURE_MAG_FILTER, magnificationFilter);
+        glTextureParameteri(slot.TextureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(slot.TextureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        GPUMemory.TrackTexture(slot.TextureID,
+                               GetTextureSizeInBytes(description.Width, description.Height, 1, description.MipLevelCount, GetBitsPerTexel(description.Format)),
+                               GPUMemoryCategory::Other);
+
+        return static_cast<BackendTexture>(AddSlot(_textures, _freeTextures, std::move(slot)));
+    };
+
+    void DestroyTexture(const BackendTexture texture) override
+    {
+        TextureSlot& slot = GetSlot(_textures, texture);
+
+        GLState.DeleteTexture(slot.TextureID);
+
+        slot = TextureSlot();
+
+        _freeTextures.emplace_back(static_cast<std::uint32_t>(texture));
+    };
+
+    void UpdateTexture(const BackendTexture texture, const std::uint32_t mipLevel,
+                       const std::uint32_t x, const std::uint32_t y, const std::uint32_t width, const std::uint32_t height,
+                       const std::span<const std::byte>& pixels) override
+    {
+        const TextureSlot& slot = GetSlot(_textures, texture);
+
+        if(slot.Format == BackendTextureFormat::BC4)
+        {
+            glCompressedTextureSubImage2D(slot.TextureID, static_cast<GLint>(mipLevel), static_cast<GLint>(x), static_cast<GLint>(y),
+                                          static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+                                          GL_COMPRESSED_RED_RGTC1, static_cast<GLsizei>(pixels.size()), pixels.data());
+            return;
+        };
+
+        const GLenum pixelFormat = slot.Format == BackendTextureFormat::R8 ? GL_RED :
+                                   slot.Format == BackendTextureFormat::RG8 ? GL_RG :
+                                   GL_RGBA;
+
+        // Rows are tightly packed, which single and double byte rows aren't necessarily to 4 bytes
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        glTextureSubImage2D(slot.TextureID, static_cast<GLint>(mipLevel), static_cast<GLint>(x), static_cast<GLint>(y),
+                            static_cast<GLsizei>(width), static_cast<GLsizei>(height), pixelFormat, GL_UNSIGNED_BYTE, pixels.data());
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    };
+
+
+    BackendPipeline CreatePipeline(const BackendPipelineDescription& description) override
+    {
+        std::unique_ptr<ShaderProgram> program = std::make_unique<ShaderProgram>(description.VertexShaderPath, description.FragmentShaderPath,
+                                                                                 true, ShaderCompileMode::Asynchronous, description.Defines);
+
+        const ShaderProgram* programPointer = program.get();
+
+        return static_cast<BackendPipeline>(AddSlot(_pipelines, _freePipelines, PipelineSlot
+        {
+            .OwnedProgram = std::move(program),
+            .Program = programPointer,
+            .BlendMode = description.BlendMode,
+        }));
+    };
+
+    /// <summary>
+    /// (GL only) A pipeline around a program built elsewhere, e.g. one of a ShaderVariants' variants, which keeps its hot-reload.
+    /// The program has to outlive the pipeline
+    /// </summary>
+    BackendPipeline CreatePipeline(const ShaderProgram& program, const BackendBlendMode blendMode)
+    {
+        return static_cast<BackendPipeline>(AddSlot(_pipelines, _freePipelines, PipelineSlot
+        {
+            .Program = &program,
+            .BlendMode = blendMode,
+        }));
+    };
+
+    /// <summary>
+    /// (GL only) A pipeline around separately linked stages, the ProgramPipeline has to outlive the backend's pipeline
+    /// </summary>
+    BackendPipeline CreatePipeline(const ProgramPipeline& pipeline, const BackendBlendMode blendMode)
+    {
+        return static_cast<BackendPipeline>(AddSlot(_pipelines, _freePipelines, PipelineSlot
+        {
+            .Pipeline = &pipeline,
+            .BlendMode = blendMode,
+        }));
+    };
+
+    void DestroyPipeline(const BackendPipeline pipeline) override
+    {
+        GetSlot(_pipelines, pipeline) = PipelineSlot();
+
+        _freePipelines.emplace_back(static_cast<std::uint32_t>(pipeline));
+    };
+
+
+    void BindPipeline(const BackendPipeline pipeline) override
+    {
+        const PipelineSlot& slot = GetSlot(_pipelines, pipeline);
+
+        if(slot.Pipeline != nullptr)
+            slot.Pipeline->Bind();
+        else
+            slot.Program->Bind();
+
+        switch(slot.BlendMode)
+        {
+            case BackendBlendMode::Opaque:
+            {
+                GLState.BlendFunc(GL_ONE, GL_ZERO);
+                break;
+            };
+
+            case BackendBlendMode::Alpha:
+            {
+                GLState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                break;
+            };
+
+            case BackendBlendMode::PremultipliedAlpha:
+            {
+                GLState.BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                break;
+            };
+
+            case BackendBlendMode::Additive:
+            {
+                GLState.BlendFunc(GL_ONE, GL_ONE);
+                break;
+            };
+        };
+
+        GLState.BindAttributelessVertexArray(_vertexArray);
+    };
+
+    void BindStorageBuffer(const std::uint32_t bindingIndex, const BackendBuffer buffer, const std::size_t offsetInBytes, const std::size_t sizeInBytes) override
+    {
+        GLState.BindBufferRange(GL_SHADER_STORAGE_BUFFER, bindingIndex, GetSlot(_buffers, buffer).BufferID, static_cast<GLintptr>(offsetInBytes), static_cast<GLsizeiptr>(sizeInBytes));
+    };
+
+    void BindUniformBuffer(const std::uint32_t bindingIndex, const BackendBuffer buffer, const std::size_t offsetInBytes, const std::size_t sizeInBytes) override
+    {
+        GLState.BindBufferRange(GL_UNIFORM_BUFFER, bindingIndex, GetSlot(_buffers, buffer).BufferID, static_cast<GLintptr>(offsetInBytes), static_cast<GLsizeiptr>(sizeInBytes));
+    };
+
+    void BindTexture(const std::uint32_t textureUnit, const BackendTexture texture) override
+    {
+        GLState.BindTextureUnit(textureUnit, GetSlot(_textures, texture).TextureID);
+    };
+
+    void Draw(const BackendPrimitive primitive, const std::uint32_t vertexCount, const std::uint32_t instanceCount,
+              const std::uint32_t firstVertex, const std::uint32_t firstInstance) override
+    {
+        const GLenum mode = primitive == BackendPrimitive::TriangleStrip ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+
+        glDrawArraysInstancedBaseInstance(mode, static_cast<GLint>(firstVertex), static_cast<GLsizei>(vertexCount), static_cast<GLsizei>(instanceCount), firstInstance);
+    };
+
+
+    void EndFrame() override
+    {
+        if(_frameFences[_frameIndex] != nullptr)
+            glDeleteSync(_frameFences[_frameIndex]);
+
+        _frameFences[_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        _frameIndex = (_frameIndex + 1) % FramesInFlight;
+
+        _frameFenceWaited = false;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Block until the GPU is done with the regions of the frame FramesInFlight frames ago, which the current frame reuses
+    /// </summary>
+    void WaitForFrameFence()
+    {
+        if(_frameFenceWaited == true)
+            return;
+
+        _frameFenceWaited = true;
+
+        GLsync& fence = _frameFences[_frameIndex];
+
+        if(fence == nullptr)
+            return;
+
+        // Only flush on the first attempt, a single flush is enough for the fence to eventually signal
+        GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        while(waitResult == GL_TIMEOUT_EXPIRED)
+        {
+            waitResult = glClientWaitSync(fence, 0, 1'000'000);
+        };
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    };
+
+    std::size_t AlignToStorageBufferOffset(const std::size_t offset) const
+    {
+        return ((offset + _storageBufferOffsetAlignment - 1) / _storageBufferOffsetAlignment) * _storageBufferOffsetAlignment;
+    };
+
+
+    template<typename TSlot>
+    static std::uint32_t AddSlot(std::vector<TSlot>& slots, std::vector<std::uint32_t>& freeHandles, TSlot&& slot)
+    {
+        if(freeHandles.empty() == false)
+        {
+            const std::uint32_t handle = freeHandles.back();
+            freeHandles.pop_back();
+
+            slots[handle - 1] = std::move(slot);
+
+            return handle;
+        };
+
+        slots.emplace_back(std::move(slot));
+
+        return static_cast<std::uint32_t>(slots.size());
+    };
+
+    template<typename TSlot, typename THandle>
+    static TSlot& GetSlot(std::vector<TSlot>& slots, const THandle handle)
+    {
+        WT_ASSERT(static_cast<std::uint32_t>(handle) != 0 && static_cast<std::uint32_t>(handle) <= slots.size(), "Invalid render backend handle");
+
+        return slots[static_cast<std::uint32_t>(handle) - 1];
+    };
+
+    template<typename TSlot, typename THandle>
+    static const TSlot& GetSlot(const std::vector<TSlot>& slots, const THandle handle)
+    {
+        WT_ASSERT(static_cast<std::uint32_t>(handle) != 0 && static_cast<std::uint32_t>(handle) <= slots.size(), "Invalid render backend handle");
+
+        return slots[static_cast<std::uint32_t>(handle) - 1];
+    };
+
+
+    static GLenum GetInternalFormat(const BackendTextureFormat format)
+    {
+        switch(format)
+        {
+            case BackendTextureFormat::R8:
+                return GL_R8;
+
+            case BackendTextureFormat::RG8:
+                return GL_RG8;
+
+            case BackendTextureFormat::BC4:
+                return GL_COMPRESSED_RED_RGTC1;
+
+            default:
+                return GL_RGBA8;
+        };
+    };
+
+    static std::size_t GetBitsPerTexel(const BackendTextureFormat format)
+    {
+        switch(format)
+        {
+            case BackendTextureFormat::R8:
+                return 8;
+
+            case BackendTextureFormat::RG8:
+                return 16;
+
+            case BackendTextureFormat::BC4:
+                return 4;
+
+            default:
+                return 32;
+        };
+    };
+
+};
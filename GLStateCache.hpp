@@ -0,0 +1,449 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "GPUMemory.hpp"
+
+
+/// <summary>
+/// Tracks the current context's bindings and blend factors, so binding an object that's already bound skips the driver call.
+/// Every bind of the tracked kinds has to go through the cache, or it goes out of sync.
+/// Bindings aren't known after a context is made current, or after code outside the renderer touched them, see Invalidate
+/// </summary>
+class GLStateCache
+{
+
+private:
+
+    /// <summary>
+    /// Marks a binding whose object isn't known, the next bind always reaches the driver
+    /// </summary>
+    static constexpr std::uint32_t UnknownBinding = 0xFFFFFFFF;
+
+    /// <summary>
+    /// Texture units and indexed bindings past these are passed through untracked
+    /// </summary>
+    static constexpr std::size_t TrackedTextureUnitCount = 16;
+    static constexpr std::size_t TrackedIndexedBindingCount = 16;
+
+
+    struct BufferRange
+    {
+        std::uint32_t Buffer = UnknownBinding;
+
+        /// <summary>
+        /// A size of 0 means the whole buffer is bound, from glBindBufferBase
+        /// </summary>
+        GLintptr Offset = 0;
+        GLsizeiptr Size = 0;
+    };
+
+    /// <summary>
+    /// The generic binding points that are tracked
+    /// </summary>
+    enum class BufferTarget : std::size_t
+    {
+        ShaderStorage,
+        Uniform,
+        DrawIndirect,
+        PixelUnpack,
+
+        Count,
+        Untracked = Count,
+    };
+
+
+    std::uint32_t _program = UnknownBinding;
+
+    std::uint32_t _programPipeline = UnknownBinding;
+
+    std::uint32_t _vertexArray = UnknownBinding;
+
+    std::array<std::uint32_t, TrackedTextureUnitCount> _textureUnits = { };
+
+    std::array<std::uint32_t, static_cast<std::size_t>(BufferTarget::Count)> _buffers = { };
+
+    std::array<BufferRange, TrackedIndexedBindingCount> _shaderStorageBindings = { };
+    std::array<BufferRange, TrackedIndexedBindingCount> _uniformBindings = { };
+
+    /// <summary>
+    /// The colour's source and destination factors, then the alpha's
+    /// </summary>
+    std::array<GLenum, 4> _blendFunc = { };
+
+
+    /// <summary>
+    /// The number of binds that were skipped since construction
+    /// </summary>
+    std::size_t _skippedBindCount = 0;
+
+    /// <summary>
+    /// The current context's own empty vertex array, 0 if the context's owner didn't provide one. See RenderWindow
+    /// </summary>
+    std::uint32_t _contextVertexArray = 0;
+
+
+public:
+
+    GLStateCache()
+    {
+        Invalidate();
+    };
+
+    GLStateCache(const GLStateCache&) = delete;
+    GLStateCache& operator = (const GLStateCache&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Forget every binding. Must be called after a context is made current, and after anything bound objects without the cache
+    /// </summary>
+    void Invalidate()
+    {
+        _program = UnknownBinding;
+        _programPipeline = UnknownBinding;
+        _vertexArray = UnknownBinding;
+
+        _textureUnits.fill(UnknownBinding);
+        _buffers.fill(UnknownBinding);
+
+        _shaderStorageBindings.fill(BufferRange { });
+        _uniformBindings.fill(BufferRange { });
+
+        _blendFunc.fill(UnknownBinding);
+    };
+
+
+    void UseProgram(const std::uint32_t programID)
+    {
+        if(Skip(_program, programID) == true)
+            return;
+
+        glUseProgram(programID);
+    };
+
+    /// <summary>
+    /// Bind a program pipeline. A program bound with UseProgram takes precedence over the pipeline, so it's unbound first
+    /// </summary>
+    void BindProgramPipeline(const std::uint32_t pipelineID)
+    {
+        UseProgram(0);
+
+        if(Skip(_programPipeline, pipelineID) == true)
+            return;
+
+        glBindProgramPipeline(pipelineID);
+    };
+
+    void BindVertexArray(const std::uint32_t vertexArrayID)
+    {
+        if(Skip(_vertexArray, vertexArrayID) == true)
+            return;
+
+        glBindVertexArray(vertexArrayID);
+    };
+
+    /// <summary>
+    /// Bind a vertex array for a draw that generates its vertices from gl_VertexID.
+    /// Vertex arrays aren't shared between contexts, so the current context's own empty one is preferred over the caller's
+    /// </summary>
+    /// <param name="vertexArrayID"> The caller's empty vertex array, created in the context it was constructed in </param>
+    void BindAttributelessVertexArray(const std::uint32_t vertexArrayID)
+    {
+        BindVertexArray(_contextVertexArray != 0 ? _contextVertexArray : vertexArrayID);
+    };
+
+    /// <summary>
+    /// Set the empty vertex array attribute-less draws use while the current context is current, 0 to use the callers' own
+    /// </summary>
+    void SetContextVertexArray(const std::uint32_t vertexArrayID)
+    {
+        _contextVertexArray = vertexArrayID;
+    };
+
+    void BindTextureUnit(const std::uint32_t textureUnit, const std::uint32_t textureID)
+    {
+        if(textureUnit < _textureUnits.size() && Skip(_textureUnits[textureUnit], textureID) == true)
+            return;
+
+        glBindTextureUnit(textureUnit, textureID);
+    };
+
+
+    void BindBuffer(const GLenum target, const std::uint32_t bufferID)
+    {
+        const BufferTarget trackedTarget = GetBufferTarget(target);
+
+        if(trackedTarget != BufferTarget::Untracked && Skip(_buffers[static_cast<std::size_t>(trackedTarget)], bufferID) == true)
+            return;
+
+        glBindBuffer(target, bufferID);
+    };
+
+    void BindBufferBase(const GLenum target, const std::uint32_t index, const std::uint32_t bufferID)
+    {
+        if(SkipIndexed(target, index, BufferRange { bufferID, 0, 0 }) == true)
+            return;
+
+        glBindBufferBase(target, index, bufferID);
+    };
+
+    void BindBufferRange(const GLenum target, const std::uint32_t index, const std::uint32_t bufferID, const GLintptr offset, const GLsizeiptr size)
+    {
+        if(SkipIndexed(target, index, BufferRange { bufferID, offset, size }) == true)
+            return;
+
+        glBindBufferRange(target, index, bufferID, offset, size);
+    };
+
+
+    void BlendFunc(const GLenum sourceFactor, const GLenum destinationFactor)
+    {
+        BlendFuncSeparate({ sourceFactor, destinationFactor, sourceFactor, destinationFactor });
+    };
+
+    void BlendFuncSeparate(const std::array<GLenum, 4>& blendFunc)
+    {
+        if(_blendFunc == blendFunc)
+        {
+            ++_skippedBindCount;
+            return;
+        };
+
+        _blendFunc = blendFunc;
+
+        glBlendFuncSeparate(blendFunc[0], blendFunc[1], blendFunc[2], blendFunc[3]);
+    };
+
+    /// <summary>
+    /// The current blend factors, as BlendFuncSeparate takes them. Only asks the driver if they aren't known
+    /// </summary>
+    std::array<GLenum, 4> GetBlendFunc()
+    {
+        if(_blendFunc[0] == UnknownBinding)
+        {
+            GLint blendFunc[4] = { };
+            glGetIntegerv(GL_BLEND_SRC_RGB, &blendFunc[0]);
+            glGetIntegerv(GL_BLEND_DST_RGB, &blendFunc[1]);
+            glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendFunc[2]);
+            glGetIntegerv(GL_BLEND_DST_ALPHA, &blendFunc[3]);
+
+            for(std::size_t index = 0; index < _blendFunc.size(); ++index)
+            {
+                _blendFunc[index] = static_cast<GLenum>(blendFunc[index]);
+            };
+        };
+
+        return _blendFunc;
+    };
+
+
+    /// <summary>
+    /// Delete objects, and forget them wherever they're bound so their names can be reused
+    /// </summary>
+    void DeleteProgram(const std::uint32_t programID)
+    {
+        if(_program == programID)
+            _program = UnknownBinding;
+
+        glDeleteProgram(programID);
+    };
+
+    void DeleteProgramPipeline(const std::uint32_t pipelineID)
+    {
+        if(_programPipeline == pipelineID)
+            _programPipeline = UnknownBinding;
+
+        glDeleteProgramPipelines(1, &pipelineID);
+    };
+
+    void DeleteVertexArray(const std::uint32_t vertexArrayID)
+    {
+        if(_vertexArray == vertexArrayID)
+            _vertexArray = UnknownBinding;
+
+        glDeleteVertexArrays(1, &vertexArrayID);
+    };
+
+    void DeleteTexture(const std::uint32_t textureID)
+    {
+        for(std::uint32_t& boundTexture : _textureUnits)
+        {
+            if(boundTexture == textureID)
+                boundTexture = UnknownBinding;
+        };
+
+        glDeleteTextures(1, &textureID);
+
+        GPUMemory.ReleaseTexture(textureID);
+    };
+
+    void DeleteBuffer(const std::uint32_t bufferID)
+    {
+        for(std::uint32_t& boundBuffer : _buffers)
+        {
+            if(boundBuffer == bufferID)
+                boundBuffer = UnknownBinding;
+        };
+
+        for(std::array<BufferRange, TrackedIndexedBindingCount>* bindings : { &_shaderStorageBindings, &_uniformBindings })
+        {
+            for(BufferRange& range : *bindings)
+            {
+                if(range.Buffer == bufferID)
+                    range = BufferRange { };
+            };
+        };
+
+        glDeleteBuffers(1, &bufferID);
+
+        GPUMemory.ReleaseBuffer(bufferID);
+    };
+
+
+    std::size_t GetSkippedBindCount() const
+    {
+        return _skippedBindCount;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Check a binding against the cache, and record the new object if it's different
+    /// </summary>
+    /// <returns> True if the object was already bound </returns>
+    bool Skip(std::uint32_t& binding, const std::uint32_t objectID)
+    {
+        if(binding == objectID)
+        {
+            ++_skippedBindCount;
+            return true;
+        };
+
+        binding = objectID;
+
+        return false;
+    };
+
+    bool SkipIndexed(const GLenum target, const std::uint32_t index, const BufferRange& range)
+    {
+        std::array<BufferRange, TrackedIndexedBindingCount>* bindings = target == GL_SHADER_STORAGE_BUFFER ? &_shaderStorageBindings :
+                                                                        target == GL_UNIFORM_BUFFER ? &_uniformBindings :
+                                                                        nullptr;
+
+        if(bindings != nullptr && index < bindings->size())
+        {
+            BufferRange& boundRange = (*bindings)[index];
+
+            if(boundRange.Buffer == range.Buffer && boundRange.Offset == range.Offset && boundRange.Size == range.Size)
+            {
+                ++_skippedBindCount;
+                return true;
+            };
+
+            boundRange = range;
+        };
+
+        // Indexed binds also change the generic binding point
+        const BufferTarget trackedTarget = GetBufferTarget(target);
+
+        if(trackedTarget != BufferTarget::Untracked)
+            _buffers[static_cast<std::size_t>(trackedTarget)] = range.Buffer;
+
+        return false;
+    };
+
+    static BufferTarget GetBufferTarget(const GLenum target)
+    {
+        switch(target)
+        {
+            case GL_SHADER_STORAGE_BUFFER:
+                return BufferTarget::ShaderStorage;
+
+            case GL_UNIFORM_BUFFER:
+                return BufferTarget::Uniform;
+
+            case GL_DRAW_INDIRECT_BUFFER:
+                return BufferTarget::DrawIndirect;
+
+            case GL_PIXEL_UNPACK_BUFFER:
+                return BufferTarget::PixelUnpack;
+
+            default:
+                return BufferTarget::Untracked;
+        };
+    };
+
+};
+
+
+/// <summary>
+/// The binding cache of the context current on this thread. Each thread only ever has one context current at a time
+/// </summary>
+inline thread_local GLStateCache GLState;
+
+
+/// <summary>
+/// Sets the blend factors for a scope, and puts back the ones before it when the scope ends
+/// </summary>
+class ScopedBlendFunc
+{
+
+private:
+
+    std::array<GLenum, 4> _previousBlendFunc = { };
+
+
+public:
+
+    ScopedBlendFunc(const GLenum sourceFactor, const GLenum destinationFactor) :
+        _previousBlendFunc(GLState.GetBlendFunc())
+    {
+        GLState.BlendFunc(sourceFactor, destinationFactor);
+    };
+
+    ScopedBlendFunc(const ScopedBlendFunc&) = delete;
+    ScopedBlendFunc& operator = (const ScopedBlendFunc&) = delete;
+
+    ~ScopedBlendFunc()
+    {
+        GLState.BlendFuncSeparate(_previousBlendFunc);
+    };
+
+};
+
+
+/// <summary>
+/// Enables a capability for a scope, e.g. GL_FRAMEBUFFER_SRGB, and disables it when the scope ends. The capability must be off outside the scope,
+/// it isn't queried
+/// </summary>
+class ScopedEnable
+{
+
+private:
+
+    GLenum _capability = 0;
+
+
+public:
+
+    ScopedEnable(const GLenum capability) :
+        _capability(capability)
+    {
+        glEnable(capability);
+    };
+
+    ScopedEnable(const ScopedEnable&) = delete;
+    ScopedEnable& operator = (const ScopedEnable&) = delete;
+
+    ~ScopedEnable()
+    {
+        glDisable(_capability);
+    };
+
+};
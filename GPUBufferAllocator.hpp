@@ -0,0 +1,319 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GLStateCache.hpp"
+#include "GPUMemory.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A range of one of a GPUBufferAllocator's buffers. A size of 0 means nothing is allocated
+/// </summary>
+struct GPUBufferRange
+{
+    std::uint32_t BufferID = 0;
+
+    std::size_t Offset = 0;
+
+    std::size_t SizeInBytes = 0;
+
+
+    bool IsValid() const
+    {
+        return SizeInBytes != 0;
+    };
+};
+
+
+/// <summary>
+/// Hands out aligned ranges of a few large immutable buffers, so many small buffers don't each need a GL object.
+/// Every block keeps a sorted free list, freed ranges merge with their neighbours, and a range can grow in place when the space after it is free.
+/// Ranges are written with glNamedBufferSubData and bound with glBindBufferRange. GL thread only
+/// </summary>
+class GPUBufferAllocator
+{
+
+private:
+
+    struct FreeRange
+    {
+        std::size_t Offset = 0;
+        std::size_t SizeInBytes = 0;
+    };
+
+    struct Block
+    {
+        std::uint32_t BufferID = 0;
+
+        std::size_t SizeInBytes = 0;
+
+        /// <summary>
+        /// Sorted by offset, neighbours are always merged
+        /// </summary>
+        std::vector<FreeRange> FreeRanges;
+    };
+
+
+    std::vector<Block> _blocks;
+
+    /// <summary>
+    /// The size of a new block, ranges larger than this get a block of their own
+    /// </summary>
+    std::size_t _blockSizeInBytes = 0;
+
+    /// <summary>
+    /// Every range starts at a multiple of this, the larger of the SSBO and UBO binding offset alignments
+    /// </summary>
+    std::size_t _alignment = 1;
+
+    std::size_t _allocatedBytes = 0;
+
+
+public:
+
+    /// <param name="blockSizeInBytes"> The size of each of the large buffers </param>
+    GPUBufferAllocator(const std::size_t blockSizeInBytes = 16 * 1024 * 1024) :
+        _blockSizeInBytes(blockSizeInBytes)
+    {
+        GLint storageAlignment = 0;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+
+        GLint uniformAlignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+
+        _alignment = static_cast<std::size_t>(std::max({ storageAlignment, uniformAlignment, 16 }));
+    };
+
+    GPUBufferAllocator(const GPUBufferAllocator&) = delete;
+    GPUBufferAllocator& operator = (const GPUBufferAllocator&) = delete;
+
+    ~GPUBufferAllocator()
+    {
+        for(const Block& block : _blocks)
+        {
+            GLState.DeleteBuffer(block.BufferID);
+        };
+    };
+
+
+public:
+
+    /// <summary>
+    /// Allocate a range, creating a new block if none of the existing ones has room
+    /// </summary>
+    /// <param name="sizeInBytes"> The range's size, rounded up to the alignment </param>
+    GPUBufferRange Allocate(const std::size_t sizeInBytes)
+    {
+        wt::Assert(sizeInBytes > 0, "Cannot allocate an empty buffer range");
+
+        const std::size_t alignedSize = AlignSize(sizeInBytes);
+
+        for(Block& block : _blocks)
+        {
+            const GPUBufferRange range = AllocateFromBlock(block, alignedSize);
+
+            if(range.IsValid() == true)
+                return range;
+        };
+
+        return AllocateFromBlock(CreateBlock(std::max(alignedSize, _blockSizeInBytes)), alignedSize);
+    };
+
+    /// <summary>
+    /// Return a range to its block. The range mustn't be in use by the GPU anymore
+    /// </summary>
+    void Free(GPUBufferRange& range)
+    {
+        if(range.IsValid() == false)
+            return;
+
+        Block& block = FindBlock(range.BufferID);
+
+        std::vector<FreeRange>& freeRanges = block.FreeRanges;
+
+        const auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), range.Offset, [](const FreeRange& freeRange, const std::size_t offset)
+        {
+            return freeRange.Offset < offset;
+        });
+
+        auto inserted = freeRanges.insert(next, FreeRange { range.Offset, range.SizeInBytes });
+
+        // Merge with the following range, then with the preceding one
+        if(std::next(inserted) != freeRanges.end() && inserted->Offset + inserted->SizeInBytes == std::next(inserted)->Offset)
+        {
+            inserted->SizeInBytes += std::next(inserted)->SizeInBytes;
+            freeRanges.erase(std::next(inserted));
+        };
+
+        if(inserted != freeRanges.begin() && std::prev(inserted)->Offset + std::prev(inserted)->SizeInBytes == inserted->Offset)
+        {
+            std::prev(inserted)->SizeInBytes += inserted->SizeInBytes;
+            freeRanges.erase(inserted);
+        };
+
+        _allocatedBytes -= range.SizeInBytes;
+
+        range = GPUBufferRange { };
+    };
+
+    /// <summary>
+    /// Resize a range, keeping its contents. Grows in place when the space right after the range is free,
+    /// otherwise a new range is allocated and the contents are copied on the GPU
+    /// </summary>
+    void Reallocate(GPUBufferRange& range, const std::size_t newSizeInBytes)
+    {
+        if(range.IsValid() == false)
+        {
+            range = Allocate(newSizeInBytes);
+            return;
+        };
+
+        const std::size_t alignedSize = AlignSize(newSizeInBytes);
+
+        if(alignedSize <= range.SizeInBytes)
+            return;
+
+        if(TryGrowInPlace(range, alignedSize) == true)
+            return;
+
+
+        GPUBufferRange newRange = Allocate(alignedSize);
+
+        glCopyNamedBufferSubData(range.BufferID, newRange.BufferID, static_cast<GLintptr>(range.Offset), static_cast<GLintptr>(newRange.Offset), static_cast<GLsizeiptr>(range.SizeInBytes));
+
+        Free(range);
+
+        range = newRange;
+    };
+
+
+    /// <summary>
+    /// Bind a range to an indexed SSBO or UBO binding
+    /// </summary>
+    static void BindRange(const GLenum target, const std::uint32_t index, const GPUBufferRange& range)
+    {
+        GLState.BindBufferRange(target, index, range.BufferID, static_cast<GLintptr>(range.Offset), static_cast<GLsizeiptr>(range.SizeInBytes));
+    };
+
+
+    std::size_t GetAlignment() const
+    {
+        return _alignment;
+    };
+
+    std::size_t GetBlockCount() const
+    {
+        return _blocks.size();
+    };
+
+    /// <summary>
+    /// The number of bytes handed out, including alignment padding
+    /// </summary>
+    std::size_t GetAllocatedBytes() const
+    {
+        return _allocatedBytes;
+    };
+
+
+private:
+
+    std::size_t AlignSize(const std::size_t sizeInBytes) const
+    {
+        return (sizeInBytes + (_alignment - 1)) / _alignment * _alignment;
+    };
+
+
+    Block& CreateBlock(const std::size_t sizeInBytes)
+    {
+        Block block = Block
+        {
+            .SizeInBytes = sizeInBytes,
+            .FreeRanges = { FreeRange { 0, sizeInBytes } },
+        };
+
+        // Dynamic storage keeps glNamedBufferSubData working on the immutable buffer
+        glCreateBuffers(1, &block.BufferID);
+        glNamedBufferStorage(block.BufferID, static_cast<GLsizeiptr>(sizeInBytes), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        GPUMemory.TrackBuffer(block.BufferID, sizeInBytes, GPUMemoryCategory::TextBuffer);
+
+        return _blocks.emplace_back(std::move(block));
+    };
+
+    Block& FindBlock(const std::uint32_t bufferID)
+    {
+        const auto block = std::find_if(_blocks.begin(), _blocks.end(), [&](const Block& block)
+        {
+            return block.BufferID == bufferID;
+        });
+
+        wt::Assert(block != _blocks.end(), "The range wasn't allocated by this allocator");
+
+        return *block;
+    };
+
+
+    /// <summary>
+    /// First fit. Sizes and offsets are always multiples of the alignment, so no range needs padding
+    /// </summary>
+    GPUBufferRange AllocateFromBlock(Block& block, const std::size_t alignedSize)
+    {
+        for(auto freeRange = block.FreeRanges.begin(); freeRange != block.FreeRanges.end(); ++freeRange)
+        {
+            if(freeRange->SizeInBytes < alignedSize)
+                continue;
+
+            const GPUBufferRange range = GPUBufferRange
+            {
+                .BufferID = block.BufferID,
+                .Offset = freeRange->Offset,
+                .SizeInBytes = alignedSize,
+            };
+
+            freeRange->Offset += alignedSize;
+            freeRange->SizeInBytes -= alignedSize;
+
+            if(freeRange->SizeInBytes == 0)
+                block.FreeRanges.erase(freeRange);
+
+            _allocatedBytes += alignedSize;
+
+            return range;
+        };
+
+        return { };
+    };
+
+    bool TryGrowInPlace(GPUBufferRange& range, const std::size_t alignedSize)
+    {
+        std::vector<FreeRange>& freeRanges = FindBlock(range.BufferID).FreeRanges;
+
+        const std::size_t rangeEnd = range.Offset + range.SizeInBytes;
+        const std::size_t extraBytes = alignedSize - range.SizeInBytes;
+
+        const auto next = std::find_if(freeRanges.begin(), freeRanges.end(), [&](const FreeRange& freeRange)
+        {
+            return freeRange.Offset == rangeEnd;
+        });
+
+        if(next == freeRanges.end() || next->SizeInBytes < extraBytes)
+            return false;
+
+        next->Offset += extraBytes;
+        next->SizeInBytes -= extraBytes;
+
+        if(next->SizeInBytes == 0)
+            freeRanges.erase(next);
+
+        range.SizeInBytes = alignedSize;
+        _allocatedBytes += extraBytes;
+
+        return true;
+    };
+
+};
@@ -0,0 +1,498 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GLExtensions.hpp"
+
+
+/// <summary>
+/// What a buffer or texture's memory is charged to, see GPUMemoryTracker
+/// </summary>
+enum class GPUMemoryCategory : std::uint32_t
+{
+    Other,
+
+    /// <summary>
+    /// Font and glyph atlas textures
+    /// </summary>
+    Atlas,
+
+    /// <summary>
+    /// Glyph metrics, palettes and other per-font tables
+    /// </summary>
+    FontData,
+
+    /// <summary>
+    /// Shader storage buffers, and the allocator blocks they're sub-allocated from
+    /// </summary>
+    TextBuffer,
+
+    /// <summary>
+    /// Anything that can be rebuilt, such as cached labels and glyph runs
+    /// </summary>
+    Cache,
+
+    Count,
+};
+
+constexpr std::size_t GPUMemoryCategoryCount = static_cast<std::size_t>(GPUMemoryCategory::Count);
+
+
+/// <summary>
+/// A category's name, for reports
+/// </summary>
+constexpr const char* GetGPUMemoryCategoryName(const GPUMemoryCategory category)
+{
+    switch(category)
+    {
+        case GPUMemoryCategory::Atlas:
+            return "Atlas";
+
+        case GPUMemoryCategory::FontData:
+            return "Font data";
+
+        case GPUMemoryCategory::TextBuffer:
+            return "Text buffer";
+
+        case GPUMemoryCategory::Cache:
+            return "Cache";
+
+        default:
+            return "Other";
+    };
+};
+
+
+/// <summary>
+/// The size of a texture's storage, with every mip level. Compressed formats pass their bits per texel, e.g. 4 for BC4
+/// </summary>
+constexpr std::size_t GetTextureSizeInBytes(std::size_t width, std::size_t height, const std::size_t layers, const std::size_t mipLevels, const std::size_t bitsPerTexel)
+{
+    std::size_t texels = 0;
+
+    for(std::size_t level = 0; level < mipLevels; ++level)
+    {
+        texels += width * height;
+
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    };
+
+    return (texels * layers * bitsPerTexel + 7) / 8;
+};
+
+
+/// <summary>
+/// What the driver reports about the device's memory, through GL_NVX_gpu_memory_info or GL_ATI_meminfo
+/// </summary>
+struct GPUMemoryInfo
+{
+    /// <summary>
+    /// Whether the driver reports anything at all
+    /// </summary>
+    bool Available = false;
+
+    /// <summary>
+    /// The memory the device has for the context, 0 where the driver only reports what's free
+    /// </summary>
+    std::uint64_t TotalBytes = 0;
+
+    std::uint64_t FreeBytes = 0;
+};
+
+/// <summary>
+/// Ask the driver how much memory is free. Only for the thread that owns the context
+/// </summary>
+inline GPUMemoryInfo QueryGPUMemoryInfo()
+{
+    GPUMemoryInfo info;
+
+    // Both report kilobytes
+    if(GLExtensions.GPUMemoryInfoNVX == true)
+    {
+        GLint totalKilobytes = 0;
+        GLint freeKilobytes = 0;
+
+        glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &totalKilobytes);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &freeKilobytes);
+
+        info.Available = true;
+        info.TotalBytes = static_cast<std::uint64_t>(totalKilobytes) * 1024;
+        info.FreeBytes = static_cast<std::uint64_t>(freeKilobytes) * 1024;
+    }
+    else if(GLExtensions.MemInfoATI == true)
+    {
+        // The total free memory, the largest free block, and the same two for auxiliary memory
+        GLint textureMemory[4] = { };
+
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, textureMemory);
+
+        info.Available = true;
+        info.FreeBytes = static_cast<std::uint64_t>(textureMemory[0]) * 1024;
+    };
+
+    return info;
+};
+
+
+/// <summary>
+/// Accounts for the memory of every buffer and texture the renderer creates, by category, and keeps it under a budget.
+/// Objects are tracked where they're created and released by GLState when they're deleted, so nothing has to remember to untrack them.
+/// Once per frame Update asks the driver how much memory is left, and while the tracked memory is over budget, or the driver is running
+/// out, runs the registered eviction handlers, so caches and atlases give memory back before the driver starts paging
+/// </summary>
+class GPUMemoryTracker
+{
+
+public:
+
+    /// <summary>
+    /// Frees some memory, e.g. by clearing a cache or dropping an atlas' unused pages
+    /// </summary>
+    /// <returns> Whether anything was freed, handlers that free nothing aren't run again until the next Update </returns>
+    using EvictionHandler = std::function<bool()>;
+
+
+private:
+
+    struct Allocation
+    {
+        std::uint64_t SizeInBytes = 0;
+
+        GPUMemoryCategory Category = GPUMemoryCategory::Other;
+    };
+
+    struct RegisteredEvictionHandler
+    {
+        GPUMemoryCategory Category = GPUMemoryCategory::Other;
+
+        EvictionHandler Evict;
+    };
+
+
+    /// <summary>
+    /// Objects are created on the upload worker's context too
+    /// </summary>
+    mutable std::mutex _mutex;
+
+    /// <summary>
+    /// Buffers and textures share a map, keyed by the object's name with the kind in the high bits, as names are only unique per kind
+    /// </summary>
+    std::unordered_map<std::uint64_t, Allocation> _allocations;
+
+    std::array<std::uint64_t, GPUMemoryCategoryCount> _categoryBytes = { };
+
+    std::uint64_t _totalBytes = 0;
+
+    std::uint64_t _peakBytes = 0;
+
+    /// <summary>
+    /// Run cheapest first, in the order they were added
+    /// </summary>
+    std::vector<RegisteredEvictionHandler> _evictionHandlers;
+
+    GPUMemoryInfo _driverInfo;
+
+    std::uint32_t _framesSinceQuery = 0;
+
+    std::uint64_t _evictionCount = 0;
+
+
+public:
+
+    /// <summary>
+    /// The most memory the renderer should use, 0 for no budget
+    /// </summary>
+    std::uint64_t Budget = 0;
+
+    /// <summary>
+    /// Per category budgets, 0 for none. Only that category's handlers run when one is exceeded
+    /// </summary>
+    std::array<std::uint64_t, GPUMemoryCategoryCount> CategoryBudgets = { };
+
+    /// <summary>
+    /// Evict once the driver reports less free memory than this, well before it has to start paging
+    /// </summary>
+    std::uint64_t MinimumFreeBytes = 64ull * 1024 * 1024;
+
+    /// <summary>
+    /// How many Updates apart the driver is queried, the query is cheap but not free
+    /// </summary>
+    std::uint32_t QueryInterval = 30;
+
+
+public:
+
+    GPUMemoryTracker() = default;
+
+    GPUMemoryTracker(const GPUMemoryTracker&) = delete;
+    GPUMemoryTracker& operator = (const GPUMemoryTracker&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Account for a buffer's storage. Tracking a buffer again, e.g. after its storage was respecified, replaces its size
+    /// </summary>
+    void TrackBuffer(const std::uint32_t bufferID, const std::size_t sizeInBytes, const GPUMemoryCategory category)
+    {
+        Track(GetKey(ObjectKind::Buffer, bufferID), sizeInBytes, category);
+    };
+
+    void TrackTexture(const std::uint32_t textureID, const std::size_t sizeInBytes, const GPUMemoryCategory category)
+    {
+        Track(GetKey(ObjectKind::Texture, textureID), sizeInBytes, category);
+    };
+
+    /// <summary>
+    /// Stop accounting for a deleted buffer, called by GLState. Untracked buffers are ignored
+    /// </summary>
+    void ReleaseBuffer(const std::uint32_t bufferID)
+    {
+        Release(GetKey(ObjectKind::Buffer, bufferID));
+    };
+
+    void ReleaseTexture(const std::uint32_t textureID)
+    {
+        Release(GetKey(ObjectKind::Texture, textureID));
+    };
+
+
+    /// <summary>
+    /// Register a way of freeing memory of a category. Handlers run in the order they were added, so cheap ones should come first
+    /// </summary>
+    void AddEvictionHandler(const GPUMemoryCategory category, EvictionHandler handler)
+    {
+        _evictionHandlers.push_back(RegisteredEvictionHandler
+        {
+            .Category = category,
+            .Evict = std::move(handler),
+        });
+    };
+
+    void ClearEvictionHandlers()
+    {
+        _evictionHandlers.clear();
+    };
+
+
+    /// <summary>
+    /// Query the driver every QueryInterval calls, and evict until every budget is met or nothing more can be freed.
+    /// Should be called once per frame, on the thread that owns the context
+    /// </summary>
+    /// <returns> The number of eviction handlers that freed something </returns>
+    std::size_t Update()
+    {
+        if(_framesSinceQuery == 0)
+            _driverInfo = QueryGPUMemoryInfo();
+
+        _framesSinceQuery = (_framesSinceQuery + 1) % (QueryInterval > 0 ? QueryInterval : 1);
+
+        std::size_t evictedCount = 0;
+
+        for(RegisteredEvictionHandler& handler : _evictionHandlers)
+        {
+            if(IsOverBudget(handler.Category) == false)
+                continue;
+
+            if(handler.Evict() == true)
+                ++evictedCount;
+        };
+
+        // The driver's numbers are stale after evicting, they're queried again on the next Update
+        if(evictedCount > 0)
+        {
+            _driverInfo.FreeBytes = 0;
+            _framesSinceQuery = 0;
+            _evictionCount += evictedCount;
+        };
+
+        return evictedCount;
+    };
+
+
+public:
+
+    std::uint64_t GetTotalBytes() const
+    {
+        std::scoped_lock lock = std::scoped_lock(_mutex);
+
+        return _totalBytes;
+    };
+
+    std::uint64_t GetCategoryBytes(const GPUMemoryCategory category) const
+    {
+        std::scoped_lock lock = std::scoped_lock(_mutex);
+
+        return _categoryBytes[static_cast<std::size_t>(category)];
+    };
+
+    /// <summary>
+    /// The most memory tracked at once
+    /// </summary>
+    std::uint64_t GetPeakBytes() const
+    {
+        std::scoped_lock lock = std::scoped_lock(_mutex);
+
+        return _peakBytes;
+    };
+
+    std::size_t GetObjectCount() const
+    {
+        std::scoped_lock lock = std::scoped_lock(_mutex);
+
+        return _allocations.size();
+    };
+
+    /// <summary>
+    /// What the driver reported at the last query
+    /// </summary>
+    const GPUMemoryInfo& GetDriverInfo() const
+    {
+        return _driverInfo;
+    };
+
+    /// <summary>
+    /// The number of eviction handlers that freed something, since the tracker was created
+    /// </summary>
+    std::uint64_t GetEvictionCount() const
+    {
+        return _evictionCount;
+    };
+
+    /// <summary>
+    /// Whether memory of a category should be freed: the overall budget or the category's is exceeded, or the driver is running out
+    /// </summary>
+    bool IsOverBudget(const GPUMemoryCategory category) const
+    {
+        const std::uint64_t categoryBudget = CategoryBudgets[static_cast<std::size_t>(category)];
+
+        if(categoryBudget != 0 && GetCategoryBytes(category) > categoryBudget)
+            return true;
+
+        if(Budget != 0 && GetTotalBytes() > Budget)
+            return true;
+
+        return _driverInfo.Available == true && _driverInfo.FreeBytes != 0 && _driverInfo.FreeBytes < MinimumFreeBytes;
+    };
+
+
+    /// <summary>
+    /// The tracked memory by category, the budget and what the driver reports, for the statistics overlay
+    /// </summary>
+    /// <param name="memory"> Where the text is allocated, e.g. a FrameArena when it's drawn every frame </param>
+    std::pmr::string Format(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const
+    {
+        std::pmr::string text = std::pmr::string(memory);
+
+        char line[128] = { };
+
+        std::snprintf(line, sizeof(line), "GPU memory %.1f MB (peak %.1f MB)", ToMegabytes(GetTotalBytes()), ToMegabytes(GetPeakBytes()));
+        text.append(line);
+
+        if(Budget != 0)
+        {
+            std::snprintf(line, sizeof(line), " of %.1f MB budget", ToMegabytes(Budget));
+            text.append(line);
+        };
+
+        if(_driverInfo.Available == true)
+        {
+            std::snprintf(line, sizeof(line), ", %.1f MB free", ToMegabytes(_driverInfo.FreeBytes));
+            text.append(line);
+        };
+
+        text.append("\n");
+
+        for(std::size_t category = 0; category < GPUMemoryCategoryCount; ++category)
+        {
+            const std::uint64_t bytes = GetCategoryBytes(static_cast<GPUMemoryCategory>(category));
+
+            if(bytes == 0)
+                continue;
+
+            std::snprintf(line, sizeof(line), " %s %.1f MB", GetGPUMemoryCategoryName(static_cast<GPUMemoryCategory>(category)), ToMegabytes(bytes));
+            text.append(line);
+        };
+
+        text.append("\n");
+
+        return text;
+    };
+
+
+private:
+
+    enum class ObjectKind : std::uint64_t
+    {
+        Buffer,
+        Texture,
+    };
+
+    static std::uint64_t GetKey(const ObjectKind kind, const std::uint32_t objectID)
+    {
+        return (static_cast<std::uint64_t>(kind) << 32) | objectID;
+    };
+
+    static double ToMegabytes(const std::uint64_t bytes)
+    {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    };
+
+
+    void Track(const std::uint64_t key, const std::size_t sizeInBytes, const GPUMemoryCategory category)
+    {
+        if(static_cast<std::uint32_t>(key) == 0)
+            return;
+
+        std::scoped_lock lock = std::scoped_lock(_mutex);
+
+        Allocation& allocation = _allocations[key];
+
+        Subtract(allocation);
+
+        allocation = Allocation { .SizeInBytes = sizeInBytes, .Category = category };
+
+        _categoryBytes[static_cast<std::size_t>(category)] += sizeInBytes;
+        _totalBytes += sizeInBytes;
+
+        _peakBytes = _totalBytes > _peakBytes ? _totalBytes : _peakBytes;
+    };
+
+    void Release(const std::uint64_t key)
+    {
+        std::scoped_lock lock = std::scoped_lock(_mutex);
+
+        const auto allocation = _allocations.find(key);
+
+        if(allocation == _allocations.end())
+            return;
+
+        Subtract(allocation->second);
+
+        _allocations.erase(allocation);
+    };
+
+    void Subtract(const Allocation& allocation)
+    {
+        _categoryBytes[static_cast<std::size_t>(allocation.Category)] -= allocation.SizeInBytes;
+        _totalBytes -= allocation.SizeInBytes;
+    };
+
+};
+
+
+/// <summary>
+/// Every context's objects, the upload worker's shared ones included
+/// </summary>
+inline GPUMemoryTracker GPUMemory;
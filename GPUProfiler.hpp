@@ -0,0 +1,531 @@
+#pragma once
+
+#include <Windows.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AllocationTracking.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The cost of a profiled scope in a single frame
+/// </summary>
+struct ProfileScopeResult
+{
+    const char* Name = nullptr;
+
+    /// <summary>
+    /// How many scopes this one is nested in
+    /// </summary>
+    std::uint32_t Depth = 0;
+
+    double GPUMilliseconds = 0.0;
+
+    double CPUMilliseconds = 0.0;
+
+    /// <summary>
+    /// Heap allocations made inside the scope, nested scopes included
+    /// </summary>
+    std::uint64_t Allocations = 0;
+
+    std::uint64_t AllocatedBytes = 0;
+};
+
+
+/// <summary>
+/// The heap allocations the profiling thread made during a frame, see AllocationTracking.hpp
+/// </summary>
+struct FrameAllocationResult
+{
+    AllocationCounts Total;
+
+    /// <summary>
+    /// The total split by the subsystem the allocations were charged to, indexed by AllocationSubsystem
+    /// </summary>
+    std::array<AllocationCounts, AllocationSubsystemCount> Subsystems = { };
+};
+
+
+/// <summary>
+/// Measures the GPU and CPU time of named scopes.
+/// GPU time comes from GL_TIMESTAMP queries, which are read back a few frames later so the CPU never waits on the GPU.
+/// CPU time comes from QueryPerformanceCounter.
+/// Heap allocations are counted too, per scope and per frame, and a frame can be held to an allocation limit, see MaxFrameAllocations
+/// </summary>
+class GPUProfiler
+{
+
+private:
+
+    struct Scope
+    {
+        const char* Name = nullptr;
+
+        std::uint32_t Depth = 0;
+
+        std::uint32_t BeginQuery = 0;
+        std::uint32_t EndQuery = 0;
+
+        std::int64_t CPUBegin = 0;
+        std::int64_t CPUEnd = 0;
+
+        AllocationCounts AllocationsBegin;
+        AllocationCounts AllocationsEnd;
+    };
+
+    struct Frame
+    {
+        std::vector<Scope> Scopes;
+
+        /// <summary>
+        /// The frame's queries were issued, and haven't been read back yet
+        /// </summary>
+        bool Pending = false;
+    };
+
+
+    /// <summary>
+    /// How many queries are created whenever the pool runs out
+    /// </summary>
+    static constexpr std::size_t QueryAllocationCount = 32;
+
+
+    /// <summary>
+    /// A frame's results are read back when its slot comes around again, this many frames later
+    /// </summary>
+    std::vector<Frame> _frames;
+
+    std::size_t _frameIndex = 0;
+
+    bool _inFrame = false;
+
+    /// <summary>
+    /// The indices of the current frame's open scopes, innermost last
+    /// </summary>
+    std::vector<std::size_t> _openScopes;
+
+
+    /// <summary>
+    /// Unused timestamp queries
+    /// </summary>
+    std::vector<std::uint32_t> _queryPool;
+
+    /// <summary>
+    /// Every query created, deleted on destruction
+    /// </summary>
+    std::vector<std::uint32_t> _queries;
+
+
+    std::int64_t _cpuFrequency = 1;
+
+    /// <summary>
+    /// The results of the most recently read back frame
+    /// </summary>
+    std::vector<ProfileScopeResult> _results;
+
+    /// <summary>
+    /// The number of frames whose results were read back
+    /// </summary>
+    std::uint64_t _readBackCount = 0;
+
+
+    /// <summary>
+    /// The thread's allocation counts when the previous frame ended, the next frame's allocations are counted from there
+    /// </summary>
+    std::optional<FrameAllocationResult> _allocationsBegin;
+
+    /// <summary>
+    /// The most recent frame's allocations. Unlike the scopes' times these don't wait for the GPU, so they're ready once the frame ends
+    /// </summary>
+    FrameAllocationResult _frameAllocations;
+
+    std::uint64_t _allocationLimitExceededCount = 0;
+
+
+public:
+
+    /// <summary>
+    /// Scopes aren't recorded while disabled
+    /// </summary>
+    bool Enabled = true;
+
+    /// <summary>
+    /// The most allocations a frame may make, e.g. 0 once the renderer reached a steady state.
+    /// A frame over the limit asserts and is counted, see GetAllocationLimitExceededCount. Unset, frames allocate freely
+    /// </summary>
+    std::optional<std::uint64_t> MaxFrameAllocations;
+
+
+public:
+
+    /// <param name="readbackLatency"> How many frames pass before a frame's results are read, enough for the GPU to be done with them </param>
+    GPUProfiler(const std::size_t readbackLatency = 4) :
+        _frames(std::max<std::size_t>(readbackLatency, 1))
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+
+        _cpuFrequency = frequency.QuadPart;
+    };
+
+    GPUProfiler(const GPUProfiler&) = delete;
+    GPUProfiler& operator = (const GPUProfiler&) = delete;
+
+    ~GPUProfiler()
+    {
+        glDeleteQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+    };
+
+
+public:
+
+    /// <summary>
+    /// Start recording a frame, reads back the results of the frame recorded in the same slot
+    /// </summary>
+    void BeginFrame()
+    {
+        if(Enabled == false)
+            return;
+
+        Frame& frame = _frames[_frameIndex];
+
+        if(frame.Pending == true)
+            ReadBack(frame);
+
+        frame.Scopes.clear();
+
+        // The first frame only counts from here, later ones also include what happened between frames, e.g. input
+        if(_allocationsBegin.has_value() == false)
+            _allocationsBegin = GetFrameAllocationCounts();
+
+        _inFrame = true;
+    };
+
+    void EndFrame()
+    {
+        if(_inFrame == false)
+            return;
+
+        wt::Assert(_openScopes.empty() == true, "Profiler frame ended with open scopes");
+
+        _frames[_frameIndex].Pending = true;
+        _frameIndex = (_frameIndex + 1) % _frames.size();
+
+        _inFrame = false;
+
+
+        const FrameAllocationResult allocationsEnd = GetFrameAllocationCounts();
+
+        _frameAllocations.Total = allocationsEnd.Total - _allocationsBegin->Total;
+
+        for(std::size_t subsystem = 0; subsystem < AllocationSubsystemCount; ++subsystem)
+        {
+            _frameAllocations.Subsystems[subsystem] = allocationsEnd.Subsystems[subsystem] - _allocationsBegin->Subsystems[subsystem];
+        };
+
+        _allocationsBegin = allocationsEnd;
+
+        if(MaxFrameAllocations.has_value() == true && _frameAllocations.Total.Count > *MaxFrameAllocations)
+        {
+            ++_allocationLimitExceededCount;
+
+            wt::Assert(false, [&]()
+            {
+                return std::string("Frame made ").append(std::to_string(_frameAllocations.Total.Count))
+                    .append(" allocations, the limit is ").append(std::to_string(*MaxFrameAllocations));
+            });
+        };
+    };
+
+
+    /// <summary>
+    /// Start timing a scope. Must be matched by EndScope, see ProfileScope
+    /// </summary>
+    /// <param name="name"> The scope's name, must outlive the profiler. Usually a literal </param>
+    /// <returns> False if nothing is being recorded, in which case EndScope must not be called </returns>
+    bool BeginScope(const char* name)
+    {
+        if(_inFrame == false)
+            return false;
+
+        Frame& frame = _frames[_frameIndex];
+
+        Scope& scope = frame.Scopes.emplace_back(Scope
+        {
+            .Name = name,
+            .Depth = static_cast<std::uint32_t>(_openScopes.size()),
+            .BeginQuery = AcquireQuery(),
+            .EndQuery = AcquireQuery(),
+        });
+
+        _openScopes.emplace_back(frame.Scopes.size() - 1);
+
+        glQueryCounter(scope.BeginQuery, GL_TIMESTAMP);
+
+        scope.AllocationsBegin = GetThreadAllocationCounts();
+        scope.CPUBegin = GetCPUTime();
+
+        return true;
+    };
+
+    void EndScope()
+    {
+        wt::Assert(_openScopes.empty() == false, "EndScope called without a matching BeginScope");
+
+        Scope& scope = _frames[_frameIndex].Scopes[_openScopes.back()];
+        _openScopes.pop_back();
+
+        scope.CPUEnd = GetCPUTime();
+        scope.AllocationsEnd = GetThreadAllocationCounts();
+
+        glQueryCounter(scope.EndQuery, GL_TIMESTAMP);
+    };
+
+
+    /// <summary>
+    /// The scopes of the most recently read back frame, in the order they began
+    /// </summary>
+    const std::vector<ProfileScopeResult>& GetResults() const
+    {
+        return _results;
+    };
+
+    /// <summary>
+    /// Find the result of a scope by name, nullptr if it wasn't recorded
+    /// </summary>
+    const ProfileScopeResult* GetResult(const std::string_view& name) const
+    {
+        for(const ProfileScopeResult& result : _results)
+        {
+            if(name == result.Name)
+                return &result;
+        };
+
+        return nullptr;
+    };
+
+    /// <summary>
+    /// Increases whenever GetResults changes, so frames that didn't read anything back aren't counted twice
+    /// </summary>
+    std::uint64_t GetReadBackCount() const
+    {
+        return _readBackCount;
+    };
+
+    /// <summary>
+    /// The allocations of the most recently ended frame
+    /// </summary>
+    const FrameAllocationResult& GetFrameAllocations() const
+    {
+        return _frameAllocations;
+    };
+
+    /// <summary>
+    /// The number of frames that made more allocations than MaxFrameAllocations
+    /// </summary>
+    std::uint64_t GetAllocationLimitExceededCount() const
+    {
+        return _allocationLimitExceededCount;
+    };
+
+    /// <summary>
+    /// The results as a table, one scope per line, for drawing on screen
+    /// </summary>
+    /// <param name="memory"> Where the text is allocated, e.g. a FrameArena since the table is rebuilt every frame </param>
+    std::pmr::string FormatResults(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const
+    {
+        std::pmr::string text = std::pmr::string("Scope             GPU ms   CPU ms  Allocs\n", memory);
+
+        for(const ProfileScopeResult& result : _results)
+        {
+            char line[112] = { };
+
+            std::snprintf(line, sizeof(line), "%*s%-*s %8.3f %8.3f %7llu\n",
+                          static_cast<int>(result.Depth * 2), "",
+                          static_cast<int>(16 - std::min<std::uint32_t>(result.Depth * 2, 16)), result.Name,
+                          result.GPUMilliseconds,
+                          result.CPUMilliseconds,
+                          static_cast<unsigned long long>(result.Allocations));
+
+            text.append(line);
+        };
+
+
+        char line[112] = { };
+
+        std::snprintf(line, sizeof(line), "Frame allocations %llu (%llu bytes)\n",
+                      static_cast<unsigned long long>(_frameAllocations.Total.Count),
+                      static_cast<unsigned long long>(_frameAllocations.Total.Bytes));
+
+        text.append(line);
+
+        for(std::size_t subsystem = 0; subsystem < AllocationSubsystemCount; ++subsystem)
+        {
+            std::snprintf(line, sizeof(line), "  %-16s %7llu\n",
+                          GetAllocationSubsystemName(static_cast<AllocationSubsystem>(subsystem)),
+                          static_cast<unsigned long long>(_frameAllocations.Subsystems[subsystem].Count));
+
+            text.append(line);
+        };
+
+        return text;
+    };
+
+
+private:
+
+    std::uint32_t AcquireQuery()
+    {
+        if(_queryPool.empty() == true)
+        {
+            const std::size_t firstNewQuery = _queries.size();
+
+            _queries.resize(firstNewQuery + QueryAllocationCount);
+            glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(QueryAllocationCount), _queries.data() + firstNewQuery);
+
+            _queryPool.insert(_queryPool.end(), _queries.cbegin() + firstNewQuery, _queries.cend());
+        };
+
+        const std::uint32_t query = _queryPool.back();
+        _queryPool.pop_back();
+
+        return query;
+    };
+
+
+    /// <summary>
+    /// Read a frame's results and return its queries to the pool.
+    /// If the GPU still isn't done with it the frame is dropped, rather than waited on
+    /// </summary>
+    void ReadBack(Frame& frame)
+    {
+        frame.Pending = false;
+
+        bool available = true;
+
+        for(const Scope& scope : frame.Scopes)
+        {
+            std::int32_t endAvailable = 0;
+            glGetQueryObjectiv(scope.EndQuery, GL_QUERY_RESULT_AVAILABLE, &endAvailable);
+
+            if(endAvailable == 0)
+            {
+                available = false;
+                break;
+            };
+        };
+
+
+        if(available == true)
+        {
+            _results.clear();
+
+            ++_readBackCount;
+
+            for(const Scope& scope : frame.Scopes)
+            {
+                std::uint64_t gpuBegin = 0;
+                std::uint64_t gpuEnd = 0;
+
+                glGetQueryObjectui64v(scope.BeginQuery, GL_QUERY_RESULT, &gpuBegin);
+                glGetQueryObjectui64v(scope.EndQuery, GL_QUERY_RESULT, &gpuEnd);
+
+                _results.emplace_back(ProfileScopeResult
+                {
+                    .Name = scope.Name,
+                    .Depth = scope.Depth,
+                    .GPUMilliseconds = static_cast<double>(gpuEnd - gpuBegin) / 1'000'000.0,
+                    .CPUMilliseconds = static_cast<double>(scope.CPUEnd - scope.CPUBegin) * 1000.0 / static_cast<double>(_cpuFrequency),
+                    .Allocations = scope.AllocationsEnd.Count - scope.AllocationsBegin.Count,
+                    .AllocatedBytes = scope.AllocationsEnd.Bytes - scope.AllocationsBegin.Bytes,
+                });
+            };
+        };
+
+
+        for(const Scope& scope : frame.Scopes)
+        {
+            _queryPool.emplace_back(scope.BeginQuery);
+            _queryPool.emplace_back(scope.EndQuery);
+        };
+    };
+
+
+    static FrameAllocationResult GetFrameAllocationCounts()
+    {
+        FrameAllocationResult counts =
+        {
+            .Total = GetThreadAllocationCounts(),
+        };
+
+        for(std::size_t subsystem = 0; subsystem < AllocationSubsystemCount; ++subsystem)
+        {
+            counts.Subsystems[subsystem] = GetThreadAllocationCounts(static_cast<AllocationSubsystem>(subsystem));
+        };
+
+        return counts;
+    };
+
+    static std::int64_t GetCPUTime()
+    {
+        LARGE_INTEGER time;
+        QueryPerformanceCounter(&time);
+
+        return time.QuadPart;
+    };
+
+};
+
+
+/// <summary>
+/// Times the lifetime of a scope. Does nothing if the profiler is null or not recording.
+/// A scope can also charge the allocations made inside it to a subsystem, which happens whether or not it's being timed
+/// </summary>
+class ProfileScope
+{
+
+private:
+
+    GPUProfiler* _profiler = nullptr;
+
+    /// <summary>
+    /// The subsystem that was charged before the scope, restored when it ends
+    /// </summary>
+    std::optional<AllocationSubsystem> _previousSubsystem;
+
+
+public:
+
+    /// <param name="subsystem"> The subsystem the scope's allocations are charged to, unset to keep the enclosing scope's </param>
+    ProfileScope(GPUProfiler* profiler, const char* name, const std::optional<AllocationSubsystem> subsystem = std::nullopt)
+    {
+        if(subsystem.has_value() == true)
+            _previousSubsystem = SetThreadAllocationSubsystem(*subsystem);
+
+        if(profiler != nullptr && profiler->BeginScope(name) == true)
+            _profiler = profiler;
+    };
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator = (const ProfileScope&) = delete;
+
+    ~ProfileScope()
+    {
+        if(_profiler != nullptr)
+            _profiler->EndScope();
+
+        if(_previousSubsystem.has_value() == true)
+            SetThreadAllocationSubsystem(*_previousSubsystem);
+    };
+
+};
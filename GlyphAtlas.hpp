@@ -0,0 +1,1388 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include "FontSprite.hpp"
+#include "GlyphRasterizer.hpp"
+#include "GLStateCache.hpp"
+#include "GPUMemory.hpp"
+#include "CodepointGlyphTable.hpp"
+#include "JobSystem.hpp"
+
+
+/// <summary>
+/// (Usage feedback) The shader storage binding a GlyphAtlas's usage bits are bound to, see TextBatchVertexShader.glsl
+/// </summary>
+constexpr std::uint32_t GlyphUsageBindingIndex = 19;
+
+
+/// <summary>
+/// Call a function with every codepoint of a UTF-8 string.
+/// Every byte that isn't a continuation byte produces exactly 1 codepoint, malformed sequences produce U+FFFD
+/// </summary>
+template<typename TFunction>
+inline void ForEachCodepoint(const std::string_view& text, TFunction&& function)
+{
+    constexpr char32_t replacementCharacter = 0xFFFD;
+
+    std::size_t position = 0;
+
+    while(position < text.size())
+    {
+        const std::uint8_t leadByte = static_cast<std::uint8_t>(text[position++]);
+
+        // A stray continuation byte, it belongs to no codepoint
+        if((leadByte & 0xC0) == 0x80)
+            continue;
+
+        if(leadByte < 0x80)
+        {
+            function(static_cast<char32_t>(leadByte));
+            continue;
+        };
+
+
+        std::size_t continuationCount = 0;
+        char32_t codepoint = 0;
+
+        if((leadByte & 0xE0) == 0xC0)
+        {
+            continuationCount = 1;
+            codepoint = leadByte & 0x1F;
+        }
+        else if((leadByte & 0xF0) == 0xE0)
+        {
+            continuationCount = 2;
+            codepoint = leadByte & 0x0F;
+        }
+        else if((leadByte & 0xF8) == 0xF0)
+        {
+            continuationCount = 3;
+            codepoint = leadByte & 0x07;
+        }
+        else
+        {
+            function(replacementCharacter);
+            continue;
+        };
+
+
+        std::size_t readCount = 0;
+
+        for(; readCount < continuationCount && position < text.size(); ++readCount)
+        {
+            const std::uint8_t continuationByte = static_cast<std::uint8_t>(text[position]);
+
+            if((continuationByte & 0xC0) != 0x80)
+                break;
+
+            codepoint = (codepoint << 6) | (continuationByte & 0x3F);
+            ++position;
+        };
+
+        // Truncated, overlong, or out of range
+        if(readCount != continuationCount || codepoint < 0x80 || codepoint > 0x10FFFF)
+            codepoint = replacementCharacter;
+
+        function(codepoint);
+    };
+};
+
+/// <summary>
+/// Whether a codepoint is drawn as a glyph instance. Control characters and the space only move the pen,
+/// a quad for them would be rasterized and shaded for nothing. The space is often a sixth of a text's characters
+/// </summary>
+constexpr bool HasGlyphInstance(const char32_t codepoint)
+{
+    return codepoint > 32;
+};
+
+/// <summary>
+/// The number of glyph instances a UTF-8 string lays out to, see HasGlyphInstance
+/// </summary>
+inline std::size_t CountUTF8Glyphs(const std::string_view& text)
+{
+    // Multi-byte sequences always decode to at least U+0080, so the lead bytes alone are enough
+    return static_cast<std::size_t>(std::count_if(text.cbegin(), text.cend(), [](const char character)
+    {
+        const std::uint8_t byte = static_cast<std::uint8_t>(character);
+
+        return (byte & 0xC0) != 0x80 && HasGlyphInstance(byte) == true;
+    }));
+};
+
+
+/// <summary>
+/// Packs rectangles into a fixed size area with the skyline bottom-left heuristic.
+/// The skyline is the top edge of everything packed so far, rectangles are placed on it as low as they'll fit
+/// </summary>
+class SkylineAllocator
+{
+
+private:
+
+    struct Segment
+    {
+        std::uint32_t X = 0;
+        std::uint32_t Y = 0;
+        std::uint32_t Width = 0;
+    };
+
+
+    std::uint32_t _width = 0;
+    std::uint32_t _height = 0;
+
+    /// <summary>
+    /// Left to right, together they always cover the whole width
+    /// </summary>
+    std::vector<Segment> _skyline;
+
+
+public:
+
+    SkylineAllocator(const std::uint32_t width, const std::uint32_t height) :
+        _width(width),
+        _height(height)
+    {
+        Reset();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Free every rectangle
+    /// </summary>
+    void Reset()
+    {
+        _skyline.assign(1, Segment { .X = 0, .Y = 0, .Width = _width });
+    };
+
+    /// <summary>
+    /// Find room for a rectangle
+    /// </summary>
+    /// <returns> The rectangle's top-left corner, or nothing if it doesn't fit </returns>
+    std::optional<glm::uvec2> Allocate(const std::uint32_t width, const std::uint32_t height)
+    {
+        std::size_t bestIndex = _skyline.size();
+        std::uint32_t bestY = std::numeric_limits<std::uint32_t>::max();
+        std::uint32_t bestWidth = std::numeric_limits<std::uint32_t>::max();
+
+        for(std::size_t index = 0; index < _skyline.size(); ++index)
+        {
+            const std::optional<std::uint32_t> y = Fit(index, width, height);
+
+            if(y.has_value() == false)
+                continue;
+
+            // Lowest first, then the narrowest segment, which leaves the wider ones for wider glyphs
+            if(*y < bestY || (*y == bestY && _skyline[index].Width < bestWidth))
+            {
+                bestIndex = index;
+                bestY = *y;
+                bestWidth = _skyline[index].Width;
+            };
+        };
+
+        if(bestIndex == _skyline.size())
+            return std::nullopt;
+
+
+        const std::uint32_t x = _skyline[bestIndex].X;
+
+        _skyline.insert(_skyline.begin() + static_cast<std::ptrdiff_t>(bestIndex), Segment { .X = x, .Y = bestY + height, .Width = width });
+
+        // Cut the segments the rectangle now shadows
+        for(std::size_t index = bestIndex + 1; index < _skyline.size();)
+        {
+            Segment& segment = _skyline[index];
+
+            const std::uint32_t shadowEnd = x + width;
+
+            if(segment.X >= shadowEnd)
+                break;
+
+            const std::uint32_t shadowed = std::min(shadowEnd - segment.X, segment.Width);
+
+            segment.X += shadowed;
+            segment.Width -= shadowed;
+
+            if(segment.Width == 0)
+                _skyline.erase(_skyline.begin() + static_cast<std::ptrdiff_t>(index));
+            else
+                break;
+        };
+
+        Merge();
+
+        return glm::uvec2(x, bestY);
+    };
+
+
+private:
+
+    /// <summary>
+    /// The height a rectangle whose left edge is at a segment's would be placed at
+    /// </summary>
+    /// <returns> Nothing if the rectangle would be out of bounds </returns>
+    std::optional<std::uint32_t> Fit(const std::size_t firstIndex, const std::uint32_t width, const std::uint32_t height) const
+    {
+        if(_skyline[firstIndex].X + width > _width)
+            return std::nullopt;
+
+        std::uint32_t y = 0;
+        std::uint32_t remainingWidth = width;
+
+        for(std::size_t index = firstIndex; remainingWidth > 0; ++index)
+        {
+            const Segment& segment = _skyline[index];
+
+            y = std::max(y, segment.Y);
+
+            if(y + height > _height)
+                return std::nullopt;
+
+            remainingWidth -= std::min(remainingWidth, segment.Width);
+        };
+
+        return y;
+    };
+
+    /// <summary>
+    /// Join neighbouring segments at the same height
+    /// </summary>
+    void Merge()
+    {
+        for(std::size_t index = 1; index < _skyline.size();)
+        {
+            if(_skyline[index - 1].Y == _skyline[index].Y)
+            {
+                _skyline[index - 1].Width += _skyline[index].Width;
+                _skyline.erase(_skyline.begin() + static_cast<std::ptrdiff_t>(index));
+            }
+            else
+                ++index;
+        };
+    };
+
+};
+
+
+/// <summary>
+/// A glyph atlas that's filled at runtime. Glyphs are rasterized the first time they're used,
+/// packed into the layers of a GL_R8 texture array, and their metrics written into a glyph metrics table indexed by slot.
+/// When the atlas is full the least recently used layer is evicted as a whole, so memory stays bounded for any character set.
+/// Only the changed part of each layer and of the table is uploaded, see Upload.
+/// Colour glyphs like emoji are packed into the layers of a second, GL_RGBA8 array, and flagged in their metrics so they're drawn in the same batch.
+/// With EnableAsyncRasterization, new glyphs are rasterized on a JobSystem and drawn as a placeholder until EndFrame packs them in
+/// </summary>
+class GlyphAtlas
+{
+
+public:
+
+    /// <summary>
+    /// What the layout needs to place a glyph
+    /// </summary>
+    struct Glyph
+    {
+        /// <summary>
+        /// The index of the glyph's metrics, EmptySlot if it has nothing to draw
+        /// </summary>
+        std::uint32_t Slot = 0;
+
+        float Advance = 0.0f;
+    };
+
+    /// <summary>
+    /// A slot with zero sized metrics. Glyphs without a bitmap, and glyphs that didn't fit, are drawn with it
+    /// </summary>
+    static constexpr std::uint32_t EmptySlot = 0;
+
+    /// <summary>
+    /// (Usage feedback) The number of frames whose usage bits can be on their way back at once, the frames of latency before eviction sees them
+    /// </summary>
+    static constexpr std::uint32_t UsageReadbackCount = 3;
+
+
+private:
+
+    static constexpr std::uint32_t NoLayer = std::numeric_limits<std::uint32_t>::max();
+
+    static constexpr std::uint32_t NoEntry = std::numeric_limits<std::uint32_t>::max();
+
+    /// <summary>
+    /// Set on the keys of glyphs acquired by their index in the font rather than by codepoint, e.g. a shaper's ligatures.
+    /// Codepoints end at U+10FFFF, so the two never collide
+    /// </summary>
+    static constexpr char32_t GlyphIndexKey = 0x80000000;
+
+    /// <summary>
+    /// Empty pixels left around every glyph, so neighbouring glyphs never bleed into each other
+    /// </summary>
+    static constexpr std::uint32_t GlyphPadding = 1;
+
+    /// <summary>
+    /// (Async rasterization) The coverage of the texel placeholders are drawn with, a faint box
+    /// </summary>
+    static constexpr std::uint8_t PlaceholderCoverage = 64;
+
+
+    struct Entry
+    {
+        Glyph Value;
+
+        std::uint32_t Layer = NoLayer;
+
+        /// <summary>
+        /// False if the glyph has a bitmap but didn't fit, it's rasterized again the next time it's used
+        /// </summary>
+        bool Resident = false;
+
+        /// <summary>
+        /// (Async rasterization) Being rasterized by a job, drawn as the placeholder until EndFrame places it
+        /// </summary>
+        bool Pending = false;
+    };
+
+    /// <summary>
+    /// (Async rasterization) A job's glyph, waiting for EndFrame to place it
+    /// </summary>
+    struct FinishedGlyph
+    {
+        char32_t Key = 0;
+
+        bool Rasterized = false;
+
+        RasterizedGlyph Glyph;
+    };
+
+    struct Layer
+    {
+        SkylineAllocator Allocator;
+
+        /// <summary>
+        /// A CPU copy of the layer, dirty rectangles are uploaded from it
+        /// </summary>
+        std::vector<std::uint8_t> Pixels;
+
+        /// <summary>
+        /// Whether the layer is one of the colour array's, with 4 bytes per pixel
+        /// </summary>
+        bool Colour = false;
+
+        /// <summary>
+        /// The changed rectangle, left, top, right, bottom. Empty when right is 0
+        /// </summary>
+        glm::uvec4 DirtyRect = { 0, 0, 0, 0 };
+
+        /// <summary>
+        /// The last frame any glyph in the layer was used in
+        /// </summary>
+        std::uint64_t LastUsedFrame = 0;
+
+        /// <summary>
+        /// (Usage feedback) The last frame the GPU drew any glyph in the layer, or a glyph was placed in it
+        /// </summary>
+        std::uint64_t LastDrawnFrame = 0;
+
+        /// <summary>
+        /// The keys of the glyphs packed into the layer, codepoints or glyph indices with GlyphIndexKey set
+        /// </summary>
+        std::vector<char32_t> Codepoints;
+    };
+
+    /// <summary>
+    /// (Usage feedback) A copy of a frame's usage bits on its way back to the CPU
+    /// </summary>
+    struct UsageReadback
+    {
+        std::uint32_t BufferID = 0;
+
+        const std::uint32_t* MappedBits = nullptr;
+
+        /// <summary>
+        /// Placed after the copy, null while the readback is free
+        /// </summary>
+        GLsync Fence = nullptr;
+
+        std::uint64_t Frame = 0;
+    };
+
+
+    std::reference_wrapper<const IGlyphRasterizer> _rasterizer;
+
+    std::uint32_t _layerSize = 0;
+
+    /// <summary>
+    /// The coverage layers, followed by the colour layers
+    /// </summary>
+    std::vector<Layer> _layers;
+
+    std::uint32_t _coverageLayerCount = 0;
+
+    std::uint32_t _textureID = 0;
+
+    /// <summary>
+    /// The colour layers' texture array, 0 without any
+    /// </summary>
+    std::uint32_t _colourTextureID = 0;
+
+
+    /// <summary>
+    /// Every known codepoint's index into _entries. Never uploaded, the shaders get slots from the layout
+    /// </summary>
+    CodepointGlyphTable _entryIndices = CodepointGlyphTable(NoEntry);
+
+    /// <summary>
+    /// Every known glyph index's index into _entries, for glyphs acquired by index
+    /// </summary>
+    CodepointGlyphTable _glyphIndexEntryIndices = CodepointGlyphTable(NoEntry);
+
+    std::vector<Entry> _entries;
+
+    /// <summary>
+    /// Entries of evicted glyphs, reused before _entries grows
+    /// </summary>
+    std::vector<std::uint32_t> _freeEntries;
+
+    /// <summary>
+    /// A CPU copy of the glyph metrics table
+    /// </summary>
+    std::vector<GlyphMetrics> _metrics;
+
+    std::uint32_t _metricsSSBO = 0;
+
+    std::vector<std::uint32_t> _freeSlots;
+
+    /// <summary>
+    /// The range of slots changed since the last upload
+    /// </summary>
+    std::uint32_t _dirtySlotBegin = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t _dirtySlotEnd = 0;
+
+
+    /// <summary>
+    /// (Usage feedback) A bit per slot, set by the vertex shader for every glyph it draws and cleared once a frame's bits were copied
+    /// </summary>
+    std::uint32_t _usageSSBO = 0;
+
+    std::vector<UsageReadback> _usageReadbacks;
+
+    /// <summary>
+    /// The oldest readback that wasn't collected yet, they're collected in the order they were made
+    /// </summary>
+    std::size_t _oldestUsageReadback = 0;
+    std::size_t _pendingUsageReadbacks = 0;
+
+    /// <summary>
+    /// (Usage feedback) The layer of every slot's glyph, for crediting the layers the usage bits name
+    /// </summary>
+    std::vector<std::uint32_t> _slotLayers;
+
+
+    std::uint64_t _frame = 1;
+
+
+    /// <summary>
+    /// (Async rasterization) Null while glyphs are rasterized when they're prepared
+    /// </summary>
+    JobSystem* _jobs = nullptr;
+
+    JobGroup _rasterizeJobs;
+
+    /// <summary>
+    /// (Async rasterization) Creates a rasterizer for every job that runs while the others are busy. Null if the jobs take turns with the atlas's
+    /// </summary>
+    std::function<std::unique_ptr<IGlyphRasterizer>()> _createRasterizer;
+
+    std::vector<std::unique_ptr<IGlyphRasterizer>> _idleRasterizers;
+
+    /// <summary>
+    /// Guards the idle rasterizers, or the atlas's rasterizer without a way to create more
+    /// </summary>
+    std::mutex _rasterizerMutex;
+
+    std::vector<FinishedGlyph> _finishedGlyphs;
+
+    /// <summary>
+    /// The finished glyphs being placed, kept to reuse its memory
+    /// </summary>
+    std::vector<FinishedGlyph> _placedGlyphs;
+
+    std::mutex _finishedGlyphsMutex;
+
+    std::size_t _pendingGlyphCount = 0;
+
+    /// <summary>
+    /// (Async rasterization) What pending glyphs are drawn with, a faint box sampled from a texel at the bottom of the first layer
+    /// </summary>
+    Glyph _placeholder = { .Slot = EmptySlot, .Advance = 0.0f };
+
+
+public:
+
+    /// <param name="rasterizer"> Must outlive the atlas </param>
+    /// <param name="layerSize"> The width and height of each texture layer </param>
+    /// <param name="layerCount"> The number of texture layers, at most layerSize * layerSize * layerCount bytes are used </param>
+    /// <param name="glyphCapacity"> The number of glyphs that can be resident at once </param>
+    /// <param name="colourLayerCount"> The number of RGBA layers for colour glyphs, 4 times the memory of a coverage layer.
+    /// Without any, colour glyphs are drawn in the text's colour by their alpha </param>
+    /// <param name="usageFeedback"> Evict the layers the GPU drew from least recently, rather than the ones prepared least recently.
+    /// The batches' vertex shader sets a bit per drawn glyph, which EndFrame reads back a few frames later without stalling, see UsageReadbackCount.
+    /// Glyphs that were prepared but clipped away or never drawn then don't keep their layers resident </param>
+    GlyphAtlas(const IGlyphRasterizer& rasterizer,
+               const std::uint32_t layerSize = 1024,
+               const std::uint32_t layerCount = 4,
+               const std::uint32_t glyphCapacity = 4096,
+               const std::uint32_t colourLayerCount = 0,
+               const bool usageFeedback = false) :
+        _rasterizer(rasterizer),
+        _layerSize(layerSize),
+        _coverageLayerCount(layerCount),
+        _metrics(std::max<std::uint32_t>(glyphCapacity, 2), GlyphMetrics { })
+    {
+        _layers.reserve(layerCount + colourLayerCount);
+
+        for(std::uint32_t index = 0; index < layerCount + colourLayerCount; ++index)
+        {
+            const bool colour = index >= layerCount;
+
+            _layers.emplace_back(Layer
+            {
+                .Allocator = SkylineAllocator(layerSize, layerSize),
+                .Pixels = std::vector<std::uint8_t>(static_cast<std::size_t>(layerSize) * layerSize * (colour == true ? 4 : 1), std::uint8_t { 0 }),
+                .Colour = colour,
+            });
+        };
+
+
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &_textureID);
+
+        glTextureParameteri(_textureID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(_textureID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glTextureParameteri(_textureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(_textureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glTextureStorage3D(_textureID, 1, GL_R8, static_cast<int>(layerSize), static_cast<int>(layerSize), static_cast<int>(layerCount));
+
+        GPUMemory.TrackTexture(_textureID, GetTextureSizeInBytes(layerSize, layerSize, layerCount, 1, 8), GPUMemoryCategory::Atlas);
+
+        glClearTexImage(_textureID, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+
+        if(colourLayerCount > 0)
+        {
+            glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &_colourTextureID);
+
+            glTextureParameteri(_colourTextureID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTextureParameteri(_colourTextureID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+            glTextureParameteri(_colourTextureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(_colourTextureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glTextureStorage3D(_colourTextureID, 1, GL_RGBA8, static_cast<int>(layerSize), static_cast<int>(layerSize), static_cast<int>(colourLayerCount));
+
+            GPUMemory.TrackTexture(_colourTextureID, GetTextureSizeInBytes(layerSize, layerSize, colourLayerCount, 1, 32), GPUMemoryCategory::Atlas);
+
+            glClearTexImage(_colourTextureID, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        };
+
+
+        glCreateBuffers(1, &_metricsSSBO);
+        glNamedBufferStorage(_metricsSSBO, static_cast<GLsizeiptr>(_metrics.size() * sizeof(GlyphMetrics)), _metrics.data(), GL_DYNAMIC_STORAGE_BIT);
+
+        GPUMemory.TrackBuffer(_metricsSSBO, _metrics.size() * sizeof(GlyphMetrics), GPUMemoryCategory::FontData);
+
+        // Handed out lowest first, slot 0 is reserved
+        for(std::uint32_t slot = static_cast<std::uint32_t>(_metrics.size()) - 1; slot > EmptySlot; --slot)
+        {
+            _freeSlots.emplace_back(slot);
+        };
+
+        if(usageFeedback == true)
+            CreateUsageFeedback();
+    };
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator = (const GlyphAtlas&) = delete;
+
+    /// <summary>
+    /// Usage readbacks that weren't collected are dropped
+    /// </summary>
+    ~GlyphAtlas()
+    {
+        // The jobs write into the atlas
+        if(_jobs != nullptr)
+            _jobs->Wait(_rasterizeJobs);
+
+        for(UsageReadback& readback : _usageReadbacks)
+        {
+            if(readback.Fence != nullptr)
+                glDeleteSync(readback.Fence);
+
+            glUnmapNamedBuffer(readback.BufferID);
+
+            GLState.DeleteBuffer(readback.BufferID);
+        };
+
+        GLState.DeleteBuffer(_usageSSBO);
+
+        GLState.DeleteBuffer(_metricsSSBO);
+
+        GLState.DeleteTexture(_colourTextureID);
+
+        GLState.DeleteTexture(_textureID);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Rasterize new glyphs on a job system rather than when they're prepared, so a page of new text doesn't hold up its frame.
+    /// Until a glyph is placed by the EndFrame after its job finished, it's drawn as a faint box of the placeholder's advance, and uploaded by the next Upload with the rest.
+    /// Has to be called before any glyph is prepared
+    /// </summary>
+    /// <param name="jobs"> Must outlive the atlas </param>
+    /// <param name="createRasterizer"> Creates a rasterizer of the same font, for each job that runs while the others are busy, e.g. a GDIGlyphRasterizer
+    /// since a device context can't be used by two threads at once. Without it the jobs take turns with the atlas's own rasterizer, off the render thread but one at a time </param>
+    /// <param name="placeholderAdvance"> How far a pending glyph moves the pen, by default half the line height. The text moves once the glyph is placed if it's off </param>
+    void EnableAsyncRasterization(JobSystem& jobs, std::function<std::unique_ptr<IGlyphRasterizer>()> createRasterizer = nullptr, const std::optional<float> placeholderAdvance = std::nullopt)
+    {
+        wt::Assert(_entries.empty() == true, "Async rasterization has to be enabled before any glyph is prepared");
+
+        _jobs = &jobs;
+        _createRasterizer = std::move(createRasterizer);
+
+        // The bottom row of the first layer is kept out of the packing, for the placeholder's texel
+        _layers[0].Allocator = SkylineAllocator(_layerSize, _layerSize - 1);
+
+        const float lineHeight = GetLineHeight();
+        const float advance = placeholderAdvance.value_or(lineHeight * 0.5f);
+
+        const std::uint32_t slot = _freeSlots.back();
+        _freeSlots.pop_back();
+
+        const float layerSize = static_cast<float>(_layerSize);
+
+        _metrics[slot] = GlyphMetrics
+        {
+            .TextureRect = { 0.0f, (layerSize - 1.0f) / layerSize, 1.0f / layerSize, 1.0f },
+            .Size = { advance * 0.75f, lineHeight * 0.5f },
+            .Bearing = { advance * 0.125f, lineHeight * 0.25f },
+            .Advance = advance,
+            .Layer = 0,
+            .Flags = 0,
+        };
+
+        _dirtySlotBegin = std::min(_dirtySlotBegin, slot);
+        _dirtySlotEnd = std::max(_dirtySlotEnd, slot + 1);
+
+        _placeholder = Glyph { .Slot = slot, .Advance = advance };
+
+        WritePlaceholderTexel();
+    };
+
+
+    /// <summary>
+    /// Make sure every glyph of a UTF-8 string is in the atlas, and mark them as used this frame
+    /// </summary>
+    void Prepare(const std::string_view& text)
+    {
+        ForEachCodepoint(text, [this](const char32_t codepoint)
+        {
+            if(codepoint >= 32)
+                Acquire(codepoint);
+        });
+    };
+
+    /// <summary>
+    /// Look up a prepared glyph. Doesn't modify the atlas, so it can be called from any number of threads at once
+    /// </summary>
+    Glyph FindGlyph(const char32_t codepoint) const
+    {
+        return FindEntry(codepoint);
+    };
+
+    /// <summary>
+    /// Make sure a glyph of the font is in the atlas by its index in the font, as a shaper outputs it, and mark it as used this frame
+    /// </summary>
+    void PrepareGlyphIndex(const std::uint32_t glyphIndex)
+    {
+        Acquire(GlyphIndexKey | glyphIndex);
+    };
+
+    /// <summary>
+    /// Look up a glyph prepared by its index in the font, see FindGlyph
+    /// </summary>
+    Glyph FindGlyphIndex(const std::uint32_t glyphIndex) const
+    {
+        return FindEntry(GlyphIndexKey | glyphIndex);
+    };
+
+
+    /// <summary>
+    /// Upload the changed rectangle of every layer and the changed slots of the metrics table, should be called before drawing
+    /// </summary>
+    void Upload()
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<int>(_layerSize));
+
+        for(std::size_t layerIndex = 0; layerIndex < _layers.size(); ++layerIndex)
+        {
+            Layer& layer = _layers[layerIndex];
+
+            if(layer.DirtyRect.z == 0)
+                continue;
+
+            const glm::uvec4 rect = layer.DirtyRect;
+
+            const std::size_t bytesPerPixel = layer.Colour == true ? 4 : 1;
+
+            glTextureSubImage3D(layer.Colour == true ? _colourTextureID : _textureID, 0,
+                                static_cast<int>(rect.x), static_cast<int>(rect.y), static_cast<int>(GetTextureLayer(static_cast<std::uint32_t>(layerIndex))),
+                                static_cast<int>(rect.z - rect.x), static_cast<int>(rect.w - rect.y), 1,
+                                layer.Colour == true ? GL_RGBA : GL_RED, GL_UNSIGNED_BYTE,
+                                layer.Pixels.data() + (((static_cast<std::size_t>(rect.y) * _layerSize) + rect.x) * bytesPerPixel));
+
+            layer.DirtyRect = { 0, 0, 0, 0 };
+        };
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+
+        if(_dirtySlotBegin < _dirtySlotEnd)
+        {
+            glNamedBufferSubData(_metricsSSBO,
+                                 static_cast<GLintptr>(_dirtySlotBegin * sizeof(GlyphMetrics)),
+                                 static_cast<GLsizeiptr>((_dirtySlotEnd - _dirtySlotBegin) * sizeof(GlyphMetrics)),
+                                 _metrics.data() + _dirtySlotBegin);
+
+            _dirtySlotBegin = std::numeric_limits<std::uint32_t>::max();
+            _dirtySlotEnd = 0;
+        };
+    };
+
+    /// <summary>
+    /// Bind the coverage texture array, the colour one to the next unit, and the metrics table to GlyphMetricsBindingIndex.
+    /// With usage feedback, the usage bits to GlyphUsageBindingIndex
+    /// </summary>
+    void Bind(const std::uint32_t textureUnit = 0) const
+    {
+        GLState.BindTextureUnit(textureUnit, _textureID);
+
+        if(_colourTextureID != 0)
+            GLState.BindTextureUnit(textureUnit + 1, _colourTextureID);
+
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, GlyphMetricsBindingIndex, _metricsSSBO);
+
+        if(_usageSSBO != 0)
+            GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, GlyphUsageBindingIndex, _usageSSBO);
+    };
+
+    /// <summary>
+    /// Signal that all of the current frame's glyphs were prepared and drawn. Layers used in the current frame are never evicted.
+    /// With usage feedback, the frame's usage bits start on their way back, and the bits of frames that finished drawing are collected.
+    /// With async rasterization, the glyphs whose jobs finished are placed, while the current frame's layers are still kept from eviction
+    /// </summary>
+    void EndFrame()
+    {
+        if(_usageSSBO != 0)
+        {
+            CollectUsage();
+            ReadUsage();
+        };
+
+        if(_jobs != nullptr)
+            PlaceFinishedGlyphs();
+
+        ++_frame;
+    };
+
+
+public:
+
+    float GetLineHeight() const
+    {
+        return _rasterizer.get().GetLineHeight();
+    };
+
+    std::uint32_t GetLayerSize() const
+    {
+        return _layerSize;
+    };
+
+    /// <summary>
+    /// The number of glyphs resident in the atlas
+    /// </summary>
+    std::size_t GetResidentGlyphCount() const
+    {
+        return (_metrics.size() - 1) - _freeSlots.size() - (_placeholder.Slot != EmptySlot ? 1 : 0);
+    };
+
+    /// <summary>
+    /// (Async rasterization) The number of glyphs drawn as the placeholder, that are being rasterized or wait for EndFrame
+    /// </summary>
+    std::size_t GetPendingGlyphCount() const
+    {
+        return _pendingGlyphCount;
+    };
+
+    /// <summary>
+    /// Whether the batches drawing with the atlas have to set its usage bits, see the constructor
+    /// </summary>
+    bool HasUsageFeedback() const
+    {
+        return _usageSSBO != 0;
+    };
+
+
+
+private:
+
+    /// <summary>
+    /// The entry table a key is in, and its index there
+    /// </summary>
+    const CodepointGlyphTable& GetEntryTable(const char32_t key) const
+    {
+        return (key & GlyphIndexKey) != 0 ? _glyphIndexEntryIndices : _entryIndices;
+    };
+
+    CodepointGlyphTable& GetEntryTable(const char32_t key)
+    {
+        return (key & GlyphIndexKey) != 0 ? _glyphIndexEntryIndices : _entryIndices;
+    };
+
+    Glyph FindEntry(const char32_t key) const
+    {
+        const std::uint32_t entryIndex = GetEntryTable(key).Find(key & ~GlyphIndexKey);
+
+        if(entryIndex == NoEntry)
+            return Glyph { .Slot = EmptySlot, .Advance = 0.0f };
+
+        const Entry& entry = _entries[entryIndex];
+
+        if(entry.Pending == true)
+            return _placeholder;
+
+        if(entry.Resident == false)
+            return Glyph { .Slot = EmptySlot, .Advance = entry.Value.Advance };
+
+        return entry.Value;
+    };
+
+
+    /// <summary>
+    /// Make sure a codepoint's glyph, or with GlyphIndexKey set a glyph index's, is in the atlas
+    /// </summary>
+    void Acquire(const char32_t codepoint)
+    {
+        CodepointGlyphTable& entryTable = GetEntryTable(codepoint);
+
+        std::uint32_t entryIndex = entryTable.Find(codepoint & ~GlyphIndexKey);
+
+        const bool inserted = entryIndex == NoEntry;
+
+        if(inserted == true)
+        {
+            entryIndex = CreateEntry();
+
+            entryTable.Set(codepoint & ~GlyphIndexKey, entryIndex);
+        };
+
+        Entry& entry = _entries[entryIndex];
+
+        if(inserted == false && entry.Resident == true)
+        {
+            if(entry.Layer != NoLayer)
+                _layers[entry.Layer].LastUsedFrame = _frame;
+
+            return;
+        };
+
+        // Already on its way, the placeholder stands in until then
+        if(entry.Pending == true)
+            return;
+
+        if(_jobs != nullptr)
+        {
+            RasterizeAsync(codepoint, entry);
+            return;
+        };
+
+
+        RasterizedGlyph glyph;
+
+        const bool rasterized = Rasterize(_rasterizer.get(), codepoint, glyph);
+
+        Insert(codepoint, entry, rasterized, glyph);
+    };
+
+    static bool Rasterize(const IGlyphRasterizer& rasterizer, const char32_t codepoint, RasterizedGlyph& glyph)
+    {
+        return (codepoint & GlyphIndexKey) != 0 ?
+            rasterizer.RasterizeGlyphIndex(codepoint & ~GlyphIndexKey, glyph) :
+            rasterizer.Rasterize(codepoint, glyph);
+    };
+
+    /// <summary>
+    /// Put a rasterized glyph into its entry, and into a layer if it has anything to draw
+    /// </summary>
+    void Insert(const char32_t codepoint, Entry& entry, const bool rasterized, RasterizedGlyph& glyph)
+    {
+        // Nothing to draw, the glyph still advances
+        if(rasterized == false || glyph.Width == 0 || glyph.Height == 0)
+        {
+            entry.Value = Glyph { .Slot = EmptySlot, .Advance = glyph.Advance };
+            entry.Resident = true;
+            return;
+        };
+
+        // Without colour layers a colour glyph is drawn like any other, its alpha is its coverage
+        if(glyph.Colour == true && _coverageLayerCount == _layers.size())
+        {
+            const std::size_t pixelCount = static_cast<std::size_t>(glyph.Width) * glyph.Height;
+
+            for(std::size_t pixel = 0; pixel < pixelCount; ++pixel)
+            {
+                glyph.Coverage[pixel] = glyph.Coverage[(pixel * 4) + 3];
+            };
+
+            glyph.Coverage.resize(pixelCount);
+            glyph.Colour = false;
+        };
+
+        entry.Value.Advance = glyph.Advance;
+
+        Place(codepoint, entry, glyph);
+    };
+
+    /// <summary>
+    /// Find room for a rasterized glyph, evicting a layer if there's none
+    /// </summary>
+    void Place(const char32_t codepoint, Entry& entry, const RasterizedGlyph& glyph)
+    {
+        entry.Resident = false;
+
+        const std::uint32_t paddedWidth = glyph.Width + GlyphPadding;
+        const std::uint32_t paddedHeight = glyph.Height + GlyphPadding;
+
+        // Would never fit, drawn as empty
+        if(paddedWidth > _layerSize || paddedHeight > _layerSize)
+        {
+            entry.Value.Slot = EmptySlot;
+            entry.Resident = true;
+            return;
+        };
+
+
+        if(_freeSlots.empty() == true && EvictLeastRecentlyUsedLayer() == false)
+            return;
+
+
+        // Colour glyphs only go into colour layers, and coverage glyphs only into coverage layers
+        std::uint32_t layerIndex = glyph.Colour == true ? _coverageLayerCount : 0;
+
+        const std::uint32_t layerEnd = glyph.Colour == true ? static_cast<std::uint32_t>(_layers.size()) : _coverageLayerCount;
+
+        std::optional<glm::uvec2> position;
+
+        for(; layerIndex < layerEnd && position.has_value() == false; ++layerIndex)
+        {
+            position = _layers[layerIndex].Allocator.Allocate(paddedWidth, paddedHeight);
+        };
+
+        if(position.has_value() == true)
+            --layerIndex;
+        else
+        {
+            const std::optional<std::uint32_t> evictedLayer = FindLeastRecentlyUsedLayer(glyph.Colour);
+
+            if(evictedLayer.has_value() == false)
+                return;
+
+            Evict(*evictedLayer);
+
+            layerIndex = *evictedLayer;
+            position = _layers[layerIndex].Allocator.Allocate(paddedWidth, paddedHeight);
+        };
+
+
+        Layer& layer = _layers[layerIndex];
+
+        const std::size_t bytesPerPixel = glyph.Colour == true ? 4 : 1;
+
+        for(std::uint32_t y = 0; y < glyph.Height; ++y)
+        {
+            std::copy_n(glyph.Coverage.data() + (static_cast<std::size_t>(y) * glyph.Width * bytesPerPixel),
+                        glyph.Width * bytesPerPixel,
+                        layer.Pixels.data() + ((((static_cast<std::size_t>(position->y) + y) * _layerSize) + position->x) * bytesPerPixel));
+        };
+
+        MarkDirty(layer, { position->x, position->y, position->x + glyph.Width, position->y + glyph.Height });
+
+        layer.Codepoints.emplace_back(codepoint);
+        layer.LastUsedFrame = _frame;
+
+        // Its first draw is only read back a few frames from now, until then the glyph counts as drawn
+        layer.LastDrawnFrame = _frame;
+
+
+        const std::uint32_t slot = _freeSlots.back();
+        _freeSlots.pop_back();
+
+        const float layerSize = static_cast<float>(_layerSize);
+
+        _metrics[slot] = GlyphMetrics
+        {
+            .TextureRect =
+            {
+                static_cast<float>(position->x) / layerSize,
+                static_cast<float>(position->y) / layerSize,
+                static_cast<float>(position->x + glyph.Width) / layerSize,
+                static_cast<float>(position->y + glyph.Height) / layerSize,
+            },
+            .Size = { static_cast<float>(glyph.Width), static_cast<float>(glyph.Height) },
+            .Bearing = glyph.Bearing,
+            .Advance = glyph.Advance,
+            .Layer = GetTextureLayer(layerIndex),
+            .Flags = glyph.Colour == true ? GlyphColourFlag : 0,
+        };
+
+        _dirtySlotBegin = std::min(_dirtySlotBegin, slot);
+        _dirtySlotEnd = std::max(_dirtySlotEnd, slot + 1);
+
+
+        entry.Value.Slot = slot;
+        entry.Layer = layerIndex;
+        entry.Resident = true;
+
+        if(_slotLayers.empty() == false)
+            _slotLayers[slot] = layerIndex;
+    };
+
+
+    /// <summary>
+    /// The layer used least recently, excluding the layers used in the current frame. With usage feedback, the one the GPU drew from least recently
+    /// </summary>
+    /// <param name="colour"> Only look at the colour layers, or only at the coverage layers </param>
+    std::optional<std::uint32_t> FindLeastRecentlyUsedLayer(const std::optional<bool> colour = std::nullopt) const
+    {
+        const bool drawn = _usageSSBO != 0;
+
+        const auto lastUsedFrame = [&](const std::uint32_t index)
+        {
+            return drawn == true ? _layers[index].LastDrawnFrame : _layers[index].LastUsedFrame;
+        };
+
+        std::optional<std::uint32_t> leastRecentlyUsed;
+
+        for(std::uint32_t index = 0; index < _layers.size(); ++index)
+        {
+            if(_layers[index].LastUsedFrame == _frame || (colour.has_value() == true && _layers[index].Colour != *colour))
+                continue;
+
+            if(leastRecentlyUsed.has_value() == false || lastUsedFrame(index) < lastUsedFrame(*leastRecentlyUsed))
+                leastRecentlyUsed = index;
+        };
+
+        return leastRecentlyUsed;
+    };
+
+    bool EvictLeastRecentlyUsedLayer()
+    {
+        const std::optional<std::uint32_t> layerIndex = FindLeastRecentlyUsedLayer();
+
+        if(layerIndex.has_value() == false)
+            return false;
+
+        Evict(*layerIndex);
+
+        return _freeSlots.empty() == false;
+    };
+
+    /// <summary>
+    /// Remove every glyph of a layer, they're rasterized again the next time they're used
+    /// </summary>
+    void Evict(const std::uint32_t layerIndex)
+    {
+        Layer& layer = _layers[layerIndex];
+
+        for(const char32_t codepoint : layer.Codepoints)
+        {
+            CodepointGlyphTable& entryTable = GetEntryTable(codepoint);
+
+            const std::uint32_t entryIndex = entryTable.Find(codepoint & ~GlyphIndexKey);
+
+            _freeSlots.emplace_back(_entries[entryIndex].Value.Slot);
+
+            if(_slotLayers.empty() == false)
+                _slotLayers[_entries[entryIndex].Value.Slot] = NoLayer;
+
+            entryTable.Reset(codepoint & ~GlyphIndexKey);
+            _freeEntries.emplace_back(entryIndex);
+        };
+
+        layer.Codepoints.clear();
+
+        layer.Allocator.Reset();
+
+        // The padding around new glyphs has to be empty, so the whole layer is cleared
+        std::fill(layer.Pixels.begin(), layer.Pixels.end(), std::uint8_t { 0 });
+
+        MarkDirty(layer, { 0, 0, _layerSize, _layerSize });
+
+        if(layerIndex == 0 && _placeholder.Slot != EmptySlot)
+            WritePlaceholderTexel();
+    };
+
+
+    /// <summary>
+    /// Schedule a job that rasterizes a glyph, its entry is pending until EndFrame places it
+    /// </summary>
+    void RasterizeAsync(const char32_t codepoint, Entry& entry)
+    {
+        entry.Pending = true;
+
+        ++_pendingGlyphCount;
+
+        _jobs->Schedule(_rasterizeJobs, [this, codepoint]()
+        {
+            FinishedGlyph finished = FinishedGlyph { .Key = codepoint };
+
+            if(_createRasterizer == nullptr)
+            {
+                const std::lock_guard lock = std::lock_guard(_rasterizerMutex);
+
+                finished.Rasterized = Rasterize(_rasterizer.get(), codepoint, finished.Glyph);
+            }
+            else
+            {
+                std::unique_ptr<IGlyphRasterizer> rasterizer = BorrowRasterizer();
+
+                finished.Rasterized = Rasterize(*rasterizer, codepoint, finished.Glyph);
+
+                const std::lock_guard lock = std::lock_guard(_rasterizerMutex);
+
+                _idleRasterizers.emplace_back(std::move(rasterizer));
+            };
+
+            const std::lock_guard lock = std::lock_guard(_finishedGlyphsMutex);
+
+            _finishedGlyphs.emplace_back(std::move(finished));
+        });
+    };
+
+    /// <summary>
+    /// An idle rasterizer, or a new one if they're all busy
+    /// </summary>
+    std::unique_ptr<IGlyphRasterizer> BorrowRasterizer()
+    {
+        {
+            const std::lock_guard lock = std::lock_guard(_rasterizerMutex);
+
+            if(_idleRasterizers.empty() == false)
+            {
+                std::unique_ptr<IGlyphRasterizer> rasterizer = std::move(_idleRasterizers.back());
+                _idleRasterizers.pop_back();
+
+                return rasterizer;
+            };
+        };
+
+        return _createRasterizer();
+    };
+
+    /// <summary>
+    /// Place every glyph whose job finished since the last frame, they're uploaded by the next Upload
+    /// </summary>
+    void PlaceFinishedGlyphs()
+    {
+        {
+            const std::lock_guard lock = std::lock_guard(_finishedGlyphsMutex);
+
+            std::swap(_finishedGlyphs, _placedGlyphs);
+        };
+
+        for(FinishedGlyph& finished : _placedGlyphs)
+        {
+            const std::uint32_t entryIndex = GetEntryTable(finished.Key).Find(finished.Key & ~GlyphIndexKey);
+
+            --_pendingGlyphCount;
+
+            if(entryIndex == NoEntry)
+                continue;
+
+            Entry& entry = _entries[entryIndex];
+
+            entry.Pending = false;
+
+            Insert(finished.Key, entry, finished.Rasterized, finished.Glyph);
+        };
+
+        _placedGlyphs.clear();
+    };
+
+    /// <summary>
+    /// Write the placeholder's texel, at the start of the first layer's bottom row
+    /// </summary>
+    void WritePlaceholderTexel()
+    {
+        Layer& layer = _layers[0];
+
+        layer.Pixels[static_cast<std::size_t>(_layerSize - 1) * _layerSize] = PlaceholderCoverage;
+
+        MarkDirty(layer, { 0, _layerSize - 1, 1, _layerSize });
+    };
+
+
+    void CreateUsageFeedback()
+    {
+        const std::size_t usageSizeInBytes = ((_metrics.size() + 31) / 32) * sizeof(std::uint32_t);
+
+        glCreateBuffers(1, &_usageSSBO);
+        glNamedBufferStorage(_usageSSBO, static_cast<GLsizeiptr>(usageSizeInBytes), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glClearNamedBufferData(_usageSSBO, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+        GPUMemory.TrackBuffer(_usageSSBO, usageSizeInBytes, GPUMemoryCategory::FontData);
+
+        // Client storage keeps the copies in system memory, where the CPU reads them, see PixelReadback
+        static constexpr GLbitfield storageFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT | GL_CLIENT_STORAGE_BIT;
+        static constexpr GLbitfield mapFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        _usageReadbacks.resize(UsageReadbackCount);
+
+        for(UsageReadback& readback : _usageReadbacks)
+        {
+            glCreateBuffers(1, &readback.BufferID);
+            glNamedBufferStorage(readback.BufferID, static_cast<GLsizeiptr>(usageSizeInBytes), nullptr, storageFlags);
+
+            readback.MappedBits = static_cast<const std::uint32_t*>(glMapNamedBufferRange(readback.BufferID, 0, static_cast<GLsizeiptr>(usageSizeInBytes), mapFlags));
+
+            wt::Assert(readback.MappedBits != nullptr, "Failed to map a glyph usage readback buffer");
+        };
+
+        _slotLayers.resize(_metrics.size(), NoLayer);
+    };
+
+    /// <summary>
+    /// Copy the frame's usage bits into a free readback and clear them for the next frame.
+    /// Without a free readback they're left to pile up, and are read with the next frame's
+    /// </summary>
+    void ReadUsage()
+    {
+        if(_pendingUsageReadbacks == _usageReadbacks.size())
+            return;
+
+        UsageReadback& readback = _usageReadbacks[(_oldestUsageReadback + _pendingUsageReadbacks) % _usageReadbacks.size()];
+
+        const GLsizeiptr usageSizeInBytes = static_cast<GLsizeiptr>(((_metrics.size() + 31) / 32) * sizeof(std::uint32_t));
+
+        // The shaders' atomics have to land before the copy reads them
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        glCopyNamedBufferSubData(_usageSSBO, readback.BufferID, 0, 0, usageSizeInBytes);
+        glClearNamedBufferData(_usageSSBO, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+        readback.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readback.Frame = _frame;
+
+        ++_pendingUsageReadbacks;
+    };
+
+    /// <summary>
+    /// Credit the layers of every glyph drawn in the frames whose readbacks finished, oldest first. Never waits
+    /// </summary>
+    void CollectUsage()
+    {
+        const std::size_t wordCount = (_metrics.size() + 31) / 32;
+
+        while(_pendingUsageReadbacks > 0)
+        {
+            UsageReadback& readback = _usageReadbacks[_oldestUsageReadback];
+
+            // The first poll flushes, so the fence is sure to signal eventually
+            if(glClientWaitSync(readback.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+                break;
+
+            glDeleteSync(readback.Fence);
+            readback.Fence = nullptr;
+
+            // A slot evicted and reused since the frame credits its new layer, which at worst keeps that layer a little longer
+            for(std::size_t word = 0; word < wordCount; ++word)
+            {
+                std::uint32_t bits = readback.MappedBits[word];
+
+                while(bits != 0)
+                {
+                    const std::uint32_t slot = static_cast<std::uint32_t>(word * 32) + static_cast<std::uint32_t>(std::countr_zero(bits));
+                    bits &= bits - 1;
+
+                    const std::uint32_t layerIndex = _slotLayers[slot];
+
+                    if(layerIndex != NoLayer)
+                        _layers[layerIndex].LastDrawnFrame = std::max(_layers[layerIndex].LastDrawnFrame, readback.Frame);
+                };
+            };
+
+            _oldestUsageReadback = (_oldestUsageReadback + 1) % _usageReadbacks.size();
+            --_pendingUsageReadbacks;
+        };
+    };
+
+
+    /// <summary>
+    /// A layer's index in its texture array, colour layers are numbered from 0 in theirs
+    /// </summary>
+    std::uint32_t GetTextureLayer(const std::uint32_t layerIndex) const
+    {
+        return _layers[layerIndex].Colour == true ? layerIndex - _coverageLayerCount : layerIndex;
+    };
+
+
+    std::uint32_t CreateEntry()
+    {
+        if(_freeEntries.empty() == true)
+        {
+            _entries.emplace_back();
+
+            return static_cast<std::uint32_t>(_entries.size() - 1);
+        };
+
+        const std::uint32_t entryIndex = _freeEntries.back();
+        _freeEntries.pop_back();
+
+        _entries[entryIndex] = Entry { };
+
+        return entryIndex;
+    };
+
+
+    static void MarkDirty(Layer& layer, const glm::uvec4& rect)
+    {
+        if(layer.DirtyRect.z == 0)
+        {
+            layer.DirtyRect = rect;
+            return;
+        };
+
+        layer.DirtyRect = { std::min(layer.DirtyRect.x, rect.x), std::min(layer.DirtyRect.y, rect.y),
+                            std::max(layer.DirtyRect.z, rect.z), std::max(layer.DirtyRect.w, rect.w) };
+    };
+
+};
@@ -0,0 +1,448 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <span>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include "GlyphRasterizer.hpp"
+#include "MappedFile.hpp"
+
+
+/// <summary>
+/// What a cached glyph's pixels are
+/// </summary>
+enum class GlyphRenderMode : std::uint32_t
+{
+    /// <summary>
+    /// One byte of coverage per pixel, or RGBA for colour glyphs, as an IGlyphRasterizer produces them
+    /// </summary>
+    Coverage,
+
+    /// <summary>
+    /// A signed distance field, 0.5 at the edge, see GenerateSignedDistanceField
+    /// </summary>
+    DistanceField,
+};
+
+
+/// <summary>
+/// The font, size and render mode glyphs are cached for
+/// </summary>
+struct GlyphCacheFont
+{
+    /// <summary>
+    /// A hash of the font file's contents, so the cache misses once the font is updated, see GDIGlyphRasterizer::GetFontHash
+    /// </summary>
+    std::uint64_t FontHash = 0;
+
+    std::uint32_t PixelHeight = 0;
+
+    GlyphRenderMode RenderMode = GlyphRenderMode::Coverage;
+
+
+    bool operator == (const GlyphCacheFont&) const = default;
+};
+
+
+struct GlyphCacheKey
+{
+    GlyphCacheFont Font;
+
+    /// <summary>
+    /// A codepoint, or a glyph index in the font with GlyphIndexBit set
+    /// </summary>
+    std::uint32_t Glyph = 0;
+
+    std::uint32_t Reserved = 0;
+
+
+    static constexpr std::uint32_t GlyphIndexBit = 0x80000000u;
+
+
+    bool operator == (const GlyphCacheKey&) const = default;
+};
+
+
+struct GlyphCacheKeyHash
+{
+    std::size_t operator () (const GlyphCacheKey& key) const
+    {
+        std::uint64_t hash = key.Font.FontHash;
+
+        hash ^= std::hash<std::uint32_t>()(key.Font.PixelHeight) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<std::uint32_t>()(static_cast<std::uint32_t>(key.Font.RenderMode)) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<std::uint32_t>()(key.Glyph) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+
+        return static_cast<std::size_t>(hash);
+    };
+};
+
+
+struct GlyphCacheHeader
+{
+    std::uint32_t Magic;
+    std::uint32_t Version;
+
+    std::uint64_t RecordCount;
+};
+
+
+/// <summary>
+/// A glyph in the cache file, followed by its pixels padded to 8 bytes
+/// </summary>
+struct GlyphCacheRecord
+{
+    GlyphCacheKey Key;
+
+    std::uint32_t Width;
+    std::uint32_t Height;
+
+    float BearingX;
+    float BearingY;
+
+    float Advance;
+
+    std::uint32_t Colour;
+
+    std::uint64_t PixelsSizeInBytes;
+};
+
+
+/// <summary>
+/// Rasterized glyphs kept on disk across runs, so a launch that draws the same fonts at the same sizes rasterizes nothing.
+/// The file is mapped and indexed when the cache is opened, and glyphs are read out of the mapping.
+/// Glyphs added since are kept in memory until Save, which writes a new file next to the old one and then replaces it.
+/// A file that doesn't parse is ignored and replaced by the next Save. Only for one thread, see CachedGlyphRasterizer
+/// </summary>
+class GlyphCacheFile
+{
+
+public:
+
+    static constexpr std::uint32_t Magic = 0x48434C47; // "GLCH"
+
+    static constexpr std::uint32_t Version = 1;
+
+
+private:
+
+    std::filesystem::path _path;
+
+    std::unique_ptr<MappedFile> _file;
+
+    /// <summary>
+    /// Where every glyph of the mapped file starts
+    /// </summary>
+    std::unordered_map<GlyphCacheKey, std::size_t, GlyphCacheKeyHash> _records;
+
+    /// <summary>
+    /// The end of the mapped file's last valid record, and the number of records before it
+    /// </summary>
+    std::size_t _recordsEnd = sizeof(GlyphCacheHeader);
+    std::uint64_t _recordCount = 0;
+
+    /// <summary>
+    /// Glyphs that aren't in the file yet
+    /// </summary>
+    std::unordered_map<GlyphCacheKey, RasterizedGlyph, GlyphCacheKeyHash> _added;
+
+
+public:
+
+    /// <param name="path"> The cache file, created by the first Save if it doesn't exist </param>
+    GlyphCacheFile(std::filesystem::path path) :
+        _path(std::move(path))
+    {
+        Open();
+    };
+
+    GlyphCacheFile(const GlyphCacheFile&) = delete;
+    GlyphCacheFile& operator = (const GlyphCacheFile&) = delete;
+
+    ~GlyphCacheFile()
+    {
+        Save();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Copy a cached glyph
+    /// </summary>
+    /// <returns> False if the glyph isn't cached </returns>
+    bool Find(const GlyphCacheKey& key, RasterizedGlyph& glyph) const
+    {
+        if(const auto added = _added.find(key); added != _added.cend())
+        {
+            glyph = added->second;
+            return true;
+        };
+
+        const auto record = _records.find(key);
+
+        if(record == _records.cend())
+            return false;
+
+
+        const std::byte* recordBytes = _file->GetBytes().data() + record->second;
+
+        GlyphCacheRecord header;
+        std::memcpy(&header, recordBytes, sizeof(GlyphCacheRecord));
+
+        glyph.Width = header.Width;
+        glyph.Height = header.Height;
+        glyph.Bearing = { header.BearingX, header.BearingY };
+        glyph.Advance = header.Advance;
+        glyph.Colour = header.Colour != 0;
+
+        const std::uint8_t* pixels = reinterpret_cast<const std::uint8_t*>(recordBytes + sizeof(GlyphCacheRecord));
+
+        glyph.Coverage.assign(pixels, pixels + header.PixelsSizeInBytes);
+
+        return true;
+    };
+
+    /// <summary>
+    /// Cache a glyph, it's written to the file by the next Save
+    /// </summary>
+    void Add(const GlyphCacheKey& key, const RasterizedGlyph& glyph)
+    {
+        if(_records.contains(key) == true)
+            return;
+
+        _added.insert_or_assign(key, glyph);
+    };
+
+    /// <summary>
+    /// Write the glyphs added since the file was opened. The file is written anew and replaces the old one, so it's never seen half written
+    /// </summary>
+    /// <returns> False if the file couldn't be written, the added glyphs are then kept for the next Save </returns>
+    bool Save()
+    {
+        if(_added.empty() == true)
+            return true;
+
+        std::filesystem::path temporaryPath = _path;
+        temporaryPath += ".tmp";
+
+        {
+            std::ofstream stream = std::ofstream(temporaryPath, std::ios::binary | std::ios::trunc);
+
+            if(stream.is_open() == false)
+                return false;
+
+            const GlyphCacheHeader header =
+            {
+                .Magic = Magic,
+                .Version = Version,
+                .RecordCount = _recordCount + _added.size(),
+            };
+
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            // The mapped file's records are copied as they are
+            if(_recordCount > 0)
+            {
+                const std::span<const std::byte> records = _file->GetBytes().subspan(sizeof(GlyphCacheHeader), _recordsEnd - sizeof(GlyphCacheHeader));
+
+                stream.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size()));
+            };
+
+            constexpr char padding[8] = { };
+
+            for(const auto& [key, glyph] : _added)
+            {
+                const GlyphCacheRecord record =
+                {
+                    .Key = key,
+                    .Width = glyph.Width,
+                    .Height = glyph.Height,
+                    .BearingX = glyph.Bearing.x,
+                    .BearingY = glyph.Bearing.y,
+                    .Advance = glyph.Advance,
+                    .Colour = glyph.Colour == true ? 1u : 0u,
+                    .PixelsSizeInBytes = glyph.Coverage.size(),
+                };
+
+                stream.write(reinterpret_cast<const char*>(&record), sizeof(record));
+                stream.write(reinterpret_cast<const char*>(glyph.Coverage.data()), static_cast<std::streamsize>(glyph.Coverage.size()));
+                stream.write(padding, static_cast<std::streamsize>(GetPaddedSize(glyph.Coverage.size()) - glyph.Coverage.size()));
+            };
+
+            if(stream.good() == false)
+                return false;
+        };
+
+        // A mapped file can't be replaced
+        _file.reset();
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, _path, error);
+
+        if(error)
+            std::filesystem::remove(temporaryPath, error);
+        else
+            _added.clear();
+
+        Open();
+
+        return _added.empty();
+    };
+
+
+public:
+
+    /// <summary>
+    /// The number of glyphs cached, on disk or not yet
+    /// </summary>
+    std::size_t GetGlyphCount() const
+    {
+        return _records.size() + _added.size();
+    };
+
+
+private:
+
+    /// <summary>
+    /// Map the file and index its records. A record that doesn't fit ends the file
+    /// </summary>
+    void Open()
+    {
+        _records.clear();
+        _recordsEnd = sizeof(GlyphCacheHeader);
+        _recordCount = 0;
+
+        _file = std::make_unique<MappedFile>(_path, false);
+
+        const std::span<const std::byte> bytes = _file->GetBytes();
+
+        if(bytes.size() < sizeof(GlyphCacheHeader))
+            return;
+
+        GlyphCacheHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(GlyphCacheHeader));
+
+        if(header.Magic != Magic || header.Version != Version)
+            return;
+
+
+        std::size_t offset = sizeof(GlyphCacheHeader);
+
+        for(std::uint64_t index = 0; index < header.RecordCount; ++index)
+        {
+            if(bytes.size() - offset < sizeof(GlyphCacheRecord))
+                break;
+
+            GlyphCacheRecord record;
+            std::memcpy(&record, bytes.data() + offset, sizeof(GlyphCacheRecord));
+
+            const std::size_t pixelsEnd = sizeof(GlyphCacheRecord) + GetPaddedSize(record.PixelsSizeInBytes);
+
+            const std::uint64_t pixelCount = static_cast<std::uint64_t>(record.Width) * record.Height;
+
+            if(record.PixelsSizeInBytes > bytes.size() - offset - sizeof(GlyphCacheRecord) ||
+               pixelsEnd > bytes.size() - offset ||
+               record.PixelsSizeInBytes != pixelCount * (record.Colour != 0 ? 4 : 1))
+                break;
+
+            _records.insert_or_assign(record.Key, offset);
+
+            offset += pixelsEnd;
+            ++_recordCount;
+        };
+
+        _recordsEnd = offset;
+    };
+
+    static std::size_t GetPaddedSize(const std::uint64_t sizeInBytes)
+    {
+        return static_cast<std::size_t>((sizeInBytes + 7) & ~std::uint64_t { 7 });
+    };
+
+};
+
+
+/// <summary>
+/// Looks glyphs up in a GlyphCacheFile before rasterizing them, and adds the ones it had to rasterize.
+/// Put in front of the rasterizer a GlyphAtlas rasterizes with
+/// </summary>
+class CachedGlyphRasterizer : public IGlyphRasterizer
+{
+
+private:
+
+    std::reference_wrapper<const IGlyphRasterizer> _rasterizer;
+
+    std::reference_wrapper<GlyphCacheFile> _cache;
+
+    GlyphCacheFont _font;
+
+
+public:
+
+    /// <param name="rasterizer"> Must outlive the cached rasterizer </param>
+    /// <param name="cache"> Must outlive the cached rasterizer, and may be shared by rasterizers of other fonts </param>
+    /// <param name="font"> What the rasterizer rasterizes </param>
+    CachedGlyphRasterizer(const IGlyphRasterizer& rasterizer, GlyphCacheFile& cache, const GlyphCacheFont& font) :
+        _rasterizer(rasterizer),
+        _cache(cache),
+        _font(font)
+    {
+    };
+
+
+public:
+
+    bool Rasterize(const char32_t codepoint, RasterizedGlyph& glyph) const override
+    {
+        const GlyphCacheKey key = GlyphCacheKey
+        {
+            .Font = _font,
+            .Glyph = static_cast<std::uint32_t>(codepoint),
+        };
+
+        if(_cache.get().Find(key, glyph) == true)
+            return true;
+
+        if(_rasterizer.get().Rasterize(codepoint, glyph) == false)
+            return false;
+
+        _cache.get().Add(key, glyph);
+
+        return true;
+    };
+
+    bool RasterizeGlyphIndex(const std::uint32_t glyphIndex, RasterizedGlyph& glyph) const override
+    {
+        const GlyphCacheKey key = GlyphCacheKey
+        {
+            .Font = _font,
+            .Glyph = glyphIndex | GlyphCacheKey::GlyphIndexBit,
+        };
+
+        if(_cache.get().Find(key, glyph) == true)
+            return true;
+
+        if(_rasterizer.get().RasterizeGlyphIndex(glyphIndex, glyph) == false)
+            return false;
+
+        _cache.get().Add(key, glyph);
+
+        return true;
+    };
+
+    float GetLineHeight() const override
+    {
+        return _rasterizer.get().GetLineHeight();
+    };
+
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+
+/// <summary>
+/// A single glyph's metrics, matches the std430 layout of "GlyphMetrics" in the vertex shaders
+/// </summary>
+struct GlyphMetrics
+{
+    /// <summary>
+    /// The glyph's texture coordinates, left, top, right, bottom
+    /// </summary>
+    glm::vec4 TextureRect;
+
+    /// <summary>
+    /// The size of the glyph's quad, in pixels
+    /// </summary>
+    glm::vec2 Size;
+
+    /// <summary>
+    /// The offset from the pen position to the quad's top-left corner, in pixels
+    /// </summary>
+    glm::vec2 Bearing;
+
+    /// <summary>
+    /// How far the pen moves after this glyph, in pixels
+    /// </summary>
+    float Advance;
+
+    /// <summary>
+    /// The texture array layer the glyph is in, see GlyphAtlas. Always 0 for a FontSprite's own atlas
+    /// </summary>
+    std::uint32_t Layer;
+
+    /// <summary>
+    /// GlyphColourFlag if the glyph is in a GlyphAtlas's colour layers, GlyphMissingFlag for a FontSprite's missing glyph, otherwise 0
+    /// </summary>
+    std::uint32_t Flags;
+
+    float Padding;
+};
+
+static_assert(sizeof(GlyphMetrics) == 48, "GlyphMetrics must match the std430 struct size");
+
+
+/// <summary>
+/// The shader storage binding the glyph metrics table is bound to
+/// </summary>
+constexpr std::uint32_t GlyphMetricsBindingIndex = 1;
+
+
+/// <summary>
+/// The glyph's texels are its colour, e.g. an emoji, rather than coverage the text's colour is drawn with. Layer is then a colour layer, see GlyphAtlas
+/// </summary>
+constexpr std::uint32_t GlyphColourFlag = 1;
+
+/// <summary>
+/// The glyph stands in for characters the atlas has no glyph for. The bitmap FontSprite shaders draw it as a hollow box, "tofu",
+/// so a missing character can't be mistaken for a real one. Its metrics are the fallback glyph's, which other shaders draw instead
+/// </summary>
+constexpr std::uint32_t GlyphMissingFlag = 2;
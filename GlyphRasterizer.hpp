@@ -0,0 +1,256 @@
+#pragma once
+
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A single glyph's coverage bitmap and metrics, as produced by an IGlyphRasterizer
+/// </summary>
+struct RasterizedGlyph
+{
+    /// <summary>
+    /// The bitmap's size in pixels, 0 for glyphs with nothing to draw like spaces
+    /// </summary>
+    std::uint32_t Width = 0;
+    std::uint32_t Height = 0;
+
+    /// <summary>
+    /// The offset from the pen position, at the top of the line, to the bitmap's top-left corner
+    /// </summary>
+    glm::vec2 Bearing = { 0.0f, 0.0f };
+
+    /// <summary>
+    /// How far the pen moves after this glyph, in pixels
+    /// </summary>
+    float Advance = 0.0f;
+
+    /// <summary>
+    /// One byte of coverage per pixel, tightly packed rows, top row first. Four bytes per pixel for colour glyphs
+    /// </summary>
+    std::vector<std::uint8_t> Coverage;
+
+    /// <summary>
+    /// Whether the glyph has colours of its own, e.g. an emoji. Coverage is then RGBA with straight alpha
+    /// </summary>
+    bool Colour = false;
+};
+
+
+/// <summary>
+/// Rasterizes glyphs from a font at a fixed pixel size, on demand
+/// </summary>
+class IGlyphRasterizer
+{
+
+public:
+
+    virtual ~IGlyphRasterizer() = default;
+
+
+public:
+
+    /// <summary>
+    /// Rasterize the glyph of a codepoint. Codepoints the font has no glyph for are rasterized as its missing glyph
+    /// </summary>
+    /// <returns> False if nothing could be rasterized for the codepoint </returns>
+    virtual bool Rasterize(const char32_t codepoint, RasterizedGlyph& glyph) const = 0;
+
+    /// <summary>
+    /// Rasterize one of the font's glyphs by its index in the font, as a shaper outputs them, see TextShaping.hpp
+    /// </summary>
+    /// <returns> False if nothing could be rasterized for the glyph, or if the rasterizer doesn't know glyphs by index </returns>
+    virtual bool RasterizeGlyphIndex(const std::uint32_t, RasterizedGlyph&) const
+    {
+        return false;
+    };
+
+    /// <summary>
+    /// The distance between rows of text, in pixels
+    /// </summary>
+    virtual float GetLineHeight() const = 0;
+
+};
+
+
+/// <summary>
+/// Rasterizes glyphs with GDI's GetGlyphOutline, from any installed font.
+/// Font linking isn't applied, and only the basic multilingual plane is supported
+/// </summary>
+class GDIGlyphRasterizer : public IGlyphRasterizer
+{
+
+private:
+
+    HDC _deviceContext = nullptr;
+
+    HFONT _font = nullptr;
+
+    HGDIOBJ _previousFont = nullptr;
+
+    TEXTMETRICW _textMetrics = { };
+
+
+public:
+
+    /// <param name="fontFamily"> The installed font's family name, like L"Consolas" </param>
+    /// <param name="pixelHeight"> The font's em height in pixels </param>
+    GDIGlyphRasterizer(const std::wstring_view& fontFamily, const std::uint32_t pixelHeight)
+    {
+        _deviceContext = CreateCompatibleDC(nullptr);
+
+        wt::Assert(_deviceContext != nullptr, "Failed to create a device context for glyph rasterization");
+
+        // A negative height selects by em size, rather than by cell height
+        _font = CreateFontW(-static_cast<int>(pixelHeight), 0, 0, 0,
+                            FW_NORMAL, FALSE, FALSE, FALSE,
+                            DEFAULT_CHARSET, OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY,
+                            DEFAULT_PITCH | FF_DONTCARE,
+                            std::wstring(fontFamily).c_str());
+
+        wt::Assert(_font != nullptr, "Failed to create the glyph rasterizer's font");
+
+        _previousFont = SelectObject(_deviceContext, _font);
+
+        GetTextMetricsW(_deviceContext, &_textMetrics);
+    };
+
+    GDIGlyphRasterizer(const GDIGlyphRasterizer&) = delete;
+    GDIGlyphRasterizer& operator = (const GDIGlyphRasterizer&) = delete;
+
+    ~GDIGlyphRasterizer()
+    {
+        SelectObject(_deviceContext, _previousFont);
+
+        DeleteObject(_font);
+
+        DeleteDC(_deviceContext);
+    };
+
+
+public:
+
+    bool Rasterize(const char32_t codepoint, RasterizedGlyph& glyph) const override
+    {
+        if(codepoint > 0xFFFF)
+            return false;
+
+
+        const wchar_t character = static_cast<wchar_t>(codepoint);
+
+        WORD glyphIndex = 0;
+
+        // Glyph 0 is the font's missing glyph, drawn for codepoints the font doesn't cover
+        if(GetGlyphIndicesW(_deviceContext, &character, 1, &glyphIndex, GGI_MARK_NONEXISTING_GLYPHS) == GDI_ERROR || glyphIndex == 0xFFFF)
+            glyphIndex = 0;
+
+        return RasterizeGlyphIndex(glyphIndex, glyph);
+    };
+
+    bool RasterizeGlyphIndex(const std::uint32_t glyphIndex, RasterizedGlyph& glyph) const override
+    {
+        if(glyphIndex > 0xFFFF)
+            return false;
+
+
+        // No transformation besides the font's own scale
+        const MAT2 identity =
+        {
+            .eM11 = { 0, 1 },
+            .eM12 = { 0, 0 },
+            .eM21 = { 0, 0 },
+            .eM22 = { 0, 1 },
+        };
+
+        GLYPHMETRICS metrics = { };
+
+        const DWORD bitmapSize = GetGlyphOutlineW(_deviceContext, glyphIndex, GGO_GRAY8_BITMAP | GGO_GLYPH_INDEX, &metrics, 0, nullptr, &identity);
+
+        if(bitmapSize == GDI_ERROR)
+            return false;
+
+
+        glyph.Advance = static_cast<float>(metrics.gmCellIncX);
+
+        // The glyph origin is relative to the baseline and y goes up, bearings are relative to the top of the line and y goes down
+        glyph.Bearing = { static_cast<float>(metrics.gmptGlyphOrigin.x), static_cast<float>(_textMetrics.tmAscent - metrics.gmptGlyphOrigin.y) };
+
+        // Spaces report a 1x1 black box, but have no bitmap
+        if(bitmapSize == 0)
+        {
+            glyph.Width = 0;
+            glyph.Height = 0;
+            glyph.Coverage.clear();
+
+            return true;
+        };
+
+
+        std::vector<std::uint8_t> bitmap = std::vector<std::uint8_t>(bitmapSize);
+
+        if(GetGlyphOutlineW(_deviceContext, glyphIndex, GGO_GRAY8_BITMAP | GGO_GLYPH_INDEX, &metrics, bitmapSize, bitmap.data(), &identity) == GDI_ERROR)
+            return false;
+
+
+        glyph.Width = metrics.gmBlackBoxX;
+        glyph.Height = metrics.gmBlackBoxY;
+
+        glyph.Coverage.resize(static_cast<std::size_t>(glyph.Width) * glyph.Height);
+
+        // GDI's rows are 4 byte aligned, with 65 levels of coverage
+        const std::size_t sourcePitch = (static_cast<std::size_t>(glyph.Width) + 3) & ~std::size_t { 3 };
+
+        for(std::size_t y = 0; y < glyph.Height; ++y)
+        {
+            for(std::size_t x = 0; x < glyph.Width; ++x)
+            {
+                const std::uint32_t level = bitmap[(y * sourcePitch) + x];
+
+                glyph.Coverage[(y * glyph.Width) + x] = static_cast<std::uint8_t>(((level * 255) + 32) / 64);
+            };
+        };
+
+        return true;
+    };
+
+    float GetLineHeight() const override
+    {
+        return static_cast<float>(_textMetrics.tmHeight + _textMetrics.tmExternalLeading);
+    };
+
+
+    /// <summary>
+    /// A hash of the font file's contents, for keying glyphs cached across runs, see GlyphCacheFont. 0 if GDI can't read the font's data
+    /// </summary>
+    std::uint64_t GetFontHash() const
+    {
+        const DWORD sizeInBytes = GetFontData(_deviceContext, 0, 0, nullptr, 0);
+
+        if(sizeInBytes == GDI_ERROR || sizeInBytes == 0)
+            return 0;
+
+        std::string data = std::string(sizeInBytes, '\0');
+
+        if(GetFontData(_deviceContext, 0, 0, data.data(), sizeInBytes) == GDI_ERROR)
+            return 0;
+
+        return static_cast<std::uint64_t>(std::hash<std::string>()(data));
+    };
+
+    /// <summary>
+    /// The device context the font is selected into, so a shaper can produce glyph indices of the same font, see UniscribeTextShaper
+    /// </summary>
+    HDC GetDeviceContext() const
+    {
+        return _deviceContext;
+    };
+
+};
@@ -0,0 +1,454 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "TextLayout.hpp"
+#include "StringTable.hpp"
+#include "ShaderStorageBuffer.hpp"
+#include "GLObject.hpp"
+#include "GLStateCache.hpp"
+#include "GPUMemory.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The shader storage binding of the queued draws' transforms and colours, read by FontSpriteVertexShader.glsl with gl_DrawID
+/// </summary>
+constexpr std::uint32_t QueuedDrawsBindingIndex = 13;
+
+
+/// <summary>
+/// A queued draw's own state, matches "QueuedDraw" in FontSpriteVertexShader.glsl
+/// </summary>
+struct QueuedDraw
+{
+    glm::mat4 Transform;
+
+    glm::vec4 Colour;
+};
+
+static_assert(sizeof(QueuedDraw) == 80, "QueuedDraw must match the std430 struct size");
+
+
+/// <summary>
+/// Laid out strings kept resident on the GPU, keyed by a hash of their text and layout options.
+/// Each run owns a range of one shared instance buffer and a draw command, so drawing a string that was seen before,
+/// at any transform, skips the upload and layout and is a single indirect draw with a base instance.
+/// Runs are never evicted individually, once either buffer is full the cache starts over
+/// </summary>
+class GlyphRunCache
+{
+
+public:
+
+    struct Run
+    {
+        /// <summary>
+        /// The run's text and options, compared on lookup so a hash collision is a miss rather than the wrong text
+        /// </summary>
+        std::string Text;
+
+        TextLayoutOptions Options;
+
+        /// <summary>
+        /// The run's first LaidOutGlyph in the instance buffer, and the draw command's base instance
+        /// </summary>
+        std::uint32_t FirstInstance = 0;
+
+        /// <summary>
+        /// The number of glyphs the layout writes. Cached runs aren't culled, so it's known up front, see Queue
+        /// </summary>
+        std::uint32_t InstanceCount = 0;
+
+        /// <summary>
+        /// The index of the run's DrawArraysIndirectCommand in the command buffer
+        /// </summary>
+        std::uint32_t CommandIndex = 0;
+
+        /// <summary>
+        /// The run's key in the cache, the hash of its text and options
+        /// </summary>
+        std::uint64_t Key = 0;
+
+        /// <summary>
+        /// Unique to every run the cache ever added, so a run an interned string remembers is known to have been replaced
+        /// </summary>
+        std::uint64_t Serial = 0;
+    };
+
+    /// <summary>
+    /// A glyph count that draws the rest of a run
+    /// </summary>
+    static constexpr std::uint32_t AllGlyphs = std::numeric_limits<std::uint32_t>::max();
+
+
+private:
+
+    /// <summary>
+    /// Glyphs within a run
+    /// </summary>
+    struct GlyphRange
+    {
+        std::uint32_t First = 0;
+        std::uint32_t Count = 0;
+    };
+
+
+    std::unordered_map<std::uint64_t, Run> _runs;
+
+    /// <summary>
+    /// The run an interned string was last drawn from
+    /// </summary>
+    struct InternedRun
+    {
+        std::uint64_t Key = 0;
+        std::uint64_t Serial = 0;
+    };
+
+    /// <summary>
+    /// Runs by interned string, so drawing one finds its run without hashing or comparing its text, see FindInterned
+    /// </summary>
+    std::unordered_map<std::uint32_t, InternedRun> _internedRuns;
+
+    std::uint64_t _nextSerial = 1;
+
+    /// <summary>
+    /// A 16 byte LaidOutGlyph per instance, every run's glyphs back to back
+    /// </summary>
+    GLBuffer _instancesBuffer;
+
+    /// <summary>
+    /// A DrawArraysIndirectCommand per run, filled by the layout pass
+    /// </summary>
+    GLBuffer _commandBuffer;
+
+    std::uint32_t _instanceCapacity = 0;
+    std::uint32_t _runCapacity = 0;
+
+    /// <summary>
+    /// The next free instance, runs are allocated linearly
+    /// </summary>
+    std::uint32_t _usedInstances = 0;
+
+    std::uint32_t _usedCommands = 0;
+
+
+    /// <summary>
+    /// The draws queued since the last SubmitQueued, a command and its transform and colour per draw
+    /// </summary>
+    std::vector<DrawArraysIndirectCommand> _queuedCommands;
+
+    std::vector<QueuedDraw> _queuedDraws;
+
+    /// <summary>
+    /// The queued draws and their commands are written into these in bulk on submit, persistently mapped so the write is a copy rather than a GL call
+    /// </summary>
+    ShaderStorageBuffer _queuedDrawRing = ShaderStorageBuffer(256 * sizeof(QueuedDraw), FramesInFlight, QueuedDrawsBindingIndex);
+
+    ShaderStorageBuffer _queuedCommandRing = ShaderStorageBuffer(256 * sizeof(DrawArraysIndirectCommand), FramesInFlight);
+
+
+public:
+
+    /// <param name="instanceCapacity"> The total number of characters all cached runs can hold </param>
+    /// <param name="runCapacity"> The number of runs that can be cached at once </param>
+    GlyphRunCache(const std::uint32_t instanceCapacity = 65536, const std::uint32_t runCapacity = 1024) :
+        _instanceCapacity(instanceCapacity),
+        _runCapacity(runCapacity)
+    {
+        wt::Assert(instanceCapacity > 0 && runCapacity > 0, "A glyph run cache needs room for at least one run");
+
+        _runs.reserve(runCapacity);
+
+        _instancesBuffer = GLBuffer::Create();
+        glNamedBufferStorage(_instancesBuffer.Get(), static_cast<GLsizeiptr>(static_cast<std::size_t>(instanceCapacity) * sizeof(std::uint32_t) * 4), nullptr, 0);
+
+        _commandBuffer = GLBuffer::Create();
+        glNamedBufferStorage(_commandBuffer.Get(), static_cast<GLsizeiptr>(static_cast<std::size_t>(runCapacity) * sizeof(DrawArraysIndirectCommand)), nullptr, 0);
+
+        GPUMemory.TrackBuffer(_instancesBuffer.Get(), static_cast<std::size_t>(instanceCapacity) * sizeof(std::uint32_t) * 4, GPUMemoryCategory::Cache);
+        GPUMemory.TrackBuffer(_commandBuffer.Get(), static_cast<std::size_t>(runCapacity) * sizeof(DrawArraysIndirectCommand), GPUMemoryCategory::Cache);
+    };
+
+    GlyphRunCache(const GlyphRunCache&) = delete;
+    GlyphRunCache& operator = (const GlyphRunCache&) = delete;
+
+    GlyphRunCache(GlyphRunCache&&) noexcept = default;
+    GlyphRunCache& operator = (GlyphRunCache&&) noexcept = default;
+
+
+public:
+
+    /// <summary>
+    /// Find a cached run
+    /// </summary>
+    /// <returns> The run, or null if the text wasn't laid out with these options yet </returns>
+    const Run* Find(const std::string_view& text, const TextLayoutOptions& options) const
+    {
+        const auto run = _runs.find(HashLaidOutText(text, options));
+
+        if(run == _runs.end() || run->second.Text != text || (run->second.Options == options) == false)
+            return nullptr;
+
+        return &run->second;
+    };
+
+    /// <summary>
+    /// Find the cached run an interned string was last drawn from, see Remember. Only the id is hashed, the run it remembers is still checked
+    /// to be the same one and laid out with the same options
+    /// </summary>
+    /// <returns> The run, or null if it was replaced, the cache started over, or the string wasn't drawn with these options yet </returns>
+    const Run* FindInterned(const InternedString string, const TextLayoutOptions& options) const
+    {
+        const auto interned = _internedRuns.find(string.ID);
+
+        if(interned == _internedRuns.end())
+            return nullptr;
+
+        const auto run = _runs.find(interned->second.Key);
+
+        if(run == _runs.end() || run->second.Serial != interned->second.Serial || (run->second.Options == options) == false)
+            return nullptr;
+
+        return &run->second;
+    };
+
+    /// <summary>
+    /// Remember the run an interned string is drawn from, for FindInterned. The run must be the string's own text.
+    /// Ids are only unique within one StringTable, strings from another one need ForgetInterned first
+    /// </summary>
+    void Remember(const InternedString string, const Run& run)
+    {
+        _internedRuns.insert_or_assign(string.ID, InternedRun { .Key = run.Key, .Serial = run.Serial });
+    };
+
+    /// <summary>
+    /// Forget every interned string's run, the runs themselves stay cached
+    /// </summary>
+    void ForgetInterned()
+    {
+        _internedRuns.clear();
+    };
+
+    /// <summary>
+    /// Allocate a run for a string, replacing a colliding one. The caller lays the text out into it, see TextLayout::DispatchInto
+    /// </summary>
+    /// <returns> The new run, or null if the text can never fit </returns>
+    const Run* Add(const std::string_view& text, const TextLayoutOptions& options)
+    {
+        if(text.size() > _instanceCapacity)
+            return nullptr;
+
+        // A run reserves an instance per character, the layout decides how many it actually uses
+        if(HasRoomFor(text) == false)
+            Clear();
+
+        const std::uint64_t key = HashLaidOutText(text, options);
+
+        const Run run = Run
+        {
+            .Text = std::string(text),
+            .Options = options,
+            .FirstInstance = _usedInstances,
+            .InstanceCount = CountGlyphs(text),
+            .CommandIndex = _usedCommands,
+            .Key = key,
+            .Serial = _nextSerial++,
+        };
+
+        _usedInstances += static_cast<std::uint32_t>(text.size());
+        ++_usedCommands;
+
+        return &(_runs.insert_or_assign(key, run).first->second);
+    };
+
+    /// <summary>
+    /// The number of glyphs a string is drawn with. Control characters and spaces only move the following glyphs, characters without a glyph are drawn as '?'.
+    /// A run's glyphs are in the order of its characters, so the first N characters of a run are its first CountGlyphs(text.substr(0, N)) glyphs
+    /// </summary>
+    static std::uint32_t CountGlyphs(const std::string_view& text)
+    {
+        return static_cast<std::uint32_t>(std::count_if(text.begin(), text.end(), [](const char character)
+        {
+            return static_cast<std::uint8_t>(character) > 32;
+        }));
+    };
+
+    /// <summary>
+    /// Check if a string can be added without starting over, which would overwrite the runs of draws that are still queued
+    /// </summary>
+    bool HasRoomFor(const std::string_view& text) const
+    {
+        return text.size() <= static_cast<std::size_t>(_instanceCapacity - _usedInstances) && _usedCommands < _runCapacity;
+    };
+
+    /// <summary>
+    /// Forget every run. Their buffer ranges are reused by the next runs
+    /// </summary>
+    void Clear()
+    {
+        _runs.clear();
+        _internedRuns.clear();
+
+        _usedInstances = 0;
+        _usedCommands = 0;
+    };
+
+
+    /// <summary>
+    /// Bind the instance buffer to GlyphInstancesBindingIndex, the draw's program must already be bound
+    /// </summary>
+    void Bind() const
+    {
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, GlyphInstancesBindingIndex, _instancesBuffer.Get());
+    };
+
+    /// <summary>
+    /// Draw a run with the instance count and base instance its layout wrote
+    /// </summary>
+    void DrawRun(const Run& run) const
+    {
+        GLState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBuffer.Get());
+
+        glDrawArraysIndirect(GL_TRIANGLE_STRIP, reinterpret_cast<const void*>(static_cast<std::uintptr_t>(run.CommandIndex) * sizeof(DrawArraysIndirectCommand)));
+    };
+
+    /// <summary>
+    /// Draw some of a run's glyphs, straight from its laid out instances, e.g. for a reveal or a page of a long run. Nothing is uploaded or laid out again
+    /// </summary>
+    /// <param name="firstGlyph"> The run's first glyph drawn, see CountGlyphs </param>
+    /// <param name="glyphCount"> Clamped to the run's end </param>
+    void DrawRunRange(const Run& run, const std::uint32_t firstGlyph, const std::uint32_t glyphCount) const
+    {
+        const GlyphRange range = ClampRange(run, firstGlyph, glyphCount);
+
+        if(range.Count == 0)
+            return;
+
+        // A glyph quad is a 4 vertex triangle strip
+        glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(range.Count), run.FirstInstance + range.First);
+    };
+
+
+    /// <summary>
+    /// Record a run's draw for the next SubmitQueued instead of drawing it now
+    /// </summary>
+    /// <param name="transform"> The run's transform, replaces TextTransform </param>
+    /// <param name="colour"> The run's colour, replaces the input block's TextColour </param>
+    /// <param name="firstGlyph"> The run's first glyph drawn, see DrawRunRange </param>
+    /// <param name="glyphCount"> Clamped to the run's end </param>
+    void Queue(const Run& run, const glm::mat4& transform, const glm::vec4& colour, const std::uint32_t firstGlyph = 0, const std::uint32_t glyphCount = AllGlyphs)
+    {
+        const GlyphRange range = ClampRange(run, firstGlyph, glyphCount);
+
+        if(range.Count == 0)
+            return;
+
+        // A glyph quad is a 4 vertex triangle strip
+        _queuedCommands.push_back(DrawArraysIndirectCommand { 4, range.Count, 0, run.FirstInstance + range.First });
+
+        _queuedDraws.push_back(QueuedDraw { transform, colour });
+    };
+
+    /// <summary>
+    /// Draw every queued run with a single glMultiDrawArraysIndirect, each draw selects its transform and colour with gl_DrawID.
+    /// The draw's program must already be bound, with the instance buffer, see Bind
+    /// </summary>
+    void SubmitQueued()
+    {
+        if(_queuedCommands.empty() == true)
+            return;
+
+        WriteToRing(_queuedCommandRing, _queuedCommands.data(), _queuedCommands.size() * sizeof(DrawArraysIndirectCommand));
+
+        WriteToRing(_queuedDrawRing, _queuedDraws.data(), _queuedDraws.size() * sizeof(QueuedDraw));
+
+        _queuedDrawRing.Bind();
+
+        GLState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, _queuedCommandRing.GetBufferID());
+
+        glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, reinterpret_cast<const void*>(_queuedCommandRing.GetAllocatedRangeOffset()), static_cast<GLsizei>(_queuedCommands.size()), 0);
+
+        _queuedCommands.clear();
+        _queuedDraws.clear();
+    };
+
+    /// <summary>
+    /// Signal that all of the current frame's queued draws were submitted, fences the frame's region of the queue's rings
+    /// </summary>
+    void EndFrame() const
+    {
+        _queuedDrawRing.NextFrame();
+        _queuedCommandRing.NextFrame();
+    };
+
+    /// <summary>
+    /// The number of draws waiting for SubmitQueued
+    /// </summary>
+    std::size_t GetQueuedDrawCount() const
+    {
+        return _queuedCommands.size();
+    };
+
+
+    std::uint32_t GetInstancesBuffer() const
+    {
+        return _instancesBuffer.Get();
+    };
+
+    std::uint32_t GetCommandBuffer() const
+    {
+        return _commandBuffer.Get();
+    };
+
+    std::size_t GetRunCount() const
+    {
+        return _runs.size();
+    };
+
+
+private:
+
+    /// <summary>
+    /// The number of frames of queued draws the CPU can write ahead of the GPU
+    /// </summary>
+    static constexpr std::uint32_t FramesInFlight = 3;
+
+
+    /// <summary>
+    /// Copy a submit's data into the current frame's region of a ring, growing the ring if the frame has used it up
+    /// </summary>
+    static void WriteToRing(const ShaderStorageBuffer& ring, const void* data, const std::size_t sizeInBytes)
+    {
+        std::byte* range = ring.Allocate(sizeInBytes);
+
+        if(range == nullptr)
+        {
+            ring.Reallocate((ring.GetRegionSizeInBytes() + sizeInBytes) * 2);
+
+            range = ring.Allocate(sizeInBytes);
+        };
+
+        std::memcpy(range, data, sizeInBytes);
+    };
+
+    static GlyphRange ClampRange(const Run& run, const std::uint32_t firstGlyph, const std::uint32_t glyphCount)
+    {
+        const std::uint32_t first = std::min(firstGlyph, run.InstanceCount);
+
+        return GlyphRange { .First = first, .Count = std::min(glyphCount, run.InstanceCount - first) };
+    };
+
+};
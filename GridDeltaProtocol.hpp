@@ -0,0 +1,683 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "TerminalGrid.hpp"
+#include "TextBuffer.hpp"
+
+
+/// <summary>
+/// The commands of a grid delta message, see GridDeltaEncoder for the format
+/// </summary>
+enum class GridDeltaOpcode : std::uint8_t
+{
+    /// <summary>
+    /// rows, columns. Every cell is blank afterwards, the sender follows with the whole grid
+    /// </summary>
+    Resize = 1,
+
+    /// <summary>
+    /// Signed row count, zigzag encoded, then a cell the rows scrolled into view are cleared to, see TerminalGrid::Scroll
+    /// </summary>
+    Scroll = 2,
+
+    /// <summary>
+    /// row, column, run count, then the runs: length, a field mask and the fields that differ from the previous cell
+    /// </summary>
+    Cells = 3,
+
+    /// <summary>
+    /// row, then a cell the whole row is filled with
+    /// </summary>
+    FillRow = 4,
+
+    /// <summary>
+    /// position, length, then the characters, see TextBuffer::Insert
+    /// </summary>
+    DocumentInsert = 5,
+
+    /// <summary>
+    /// position, count, see TextBuffer::Erase
+    /// </summary>
+    DocumentErase = 6,
+};
+
+
+/// <summary>
+/// What applying a message did
+/// </summary>
+enum class GridDeltaResult
+{
+    Applied,
+
+    /// <summary>
+    /// The message doesn't follow the last one applied, a message was lost. The receiver should ask for a full grid, see GridDeltaEncoder::Reset
+    /// </summary>
+    OutOfSequence,
+
+    /// <summary>
+    /// The message is cut off or refers to cells outside the grid. Commands before the bad one were applied
+    /// </summary>
+    Malformed,
+};
+
+
+/// <summary>
+/// Which of a cell's fields a run carries, the rest are the previous cell's
+/// </summary>
+namespace GridDeltaFields
+{
+    constexpr std::uint8_t Character = 1 << 0;
+    constexpr std::uint8_t Foreground = 1 << 1;
+    constexpr std::uint8_t Background = 1 << 2;
+    constexpr std::uint8_t Style = 1 << 3;
+};
+
+
+/// <summary>
+/// Turns the changes to a TerminalGrid, or to a document, into compact binary messages for a remote display, see GridDeltaDecoder.
+/// A message is a version byte, a sequence number and commands. Only the changed cells of a row are sent, as runs of identical cells,
+/// and every run only carries the fields that differ from the cell before it, so a line of same-coloured text costs about a byte per character.
+/// Integers are LEB128 varints, colours are 4 bytes little-endian. The encoder keeps a copy of what the receiver's grid holds to diff against,
+/// and doesn't care how messages are transported, only that they arrive in order, or are detected as lost
+/// </summary>
+class GridDeltaEncoder
+{
+
+public:
+
+    static constexpr std::uint8_t Version = 1;
+
+    /// <summary>
+    /// Unchanged cells between two changed ones shorter than this are sent rather than starting a new command, a command costs a few bytes
+    /// </summary>
+    static constexpr std::uint32_t MergeDistance = 4;
+
+
+private:
+
+    /// <summary>
+    /// The cells as the receiver has them, in visible order
+    /// </summary>
+    std::vector<TerminalCell> _shadow;
+
+    std::uint32_t _rows = 0;
+    std::uint32_t _columns = 0;
+
+    std::uint32_t _sequence = 0;
+
+    /// <summary>
+    /// Commands written since the last message was taken
+    /// </summary>
+    std::vector<std::byte> _commands;
+
+
+public:
+
+    /// <summary>
+    /// Forget what the receiver has, the next Encode sends the whole grid. For a new receiver, or one that lost a message
+    /// </summary>
+    void Reset()
+    {
+        _rows = 0;
+        _columns = 0;
+
+        _shadow.clear();
+    };
+
+    /// <summary>
+    /// Add the grid's changes since the last call to the next message
+    /// </summary>
+    void Encode(const TerminalGrid& grid)
+    {
+        if(grid.GetRows() != _rows || grid.GetColumns() != _columns)
+        {
+            _rows = grid.GetRows();
+            _columns = grid.GetColumns();
+
+            _shadow.assign(static_cast<std::size_t>(_rows) * _columns, TerminalCell());
+
+            WriteOpcode(GridDeltaOpcode::Resize);
+            WriteVarint(_rows);
+            WriteVarint(_columns);
+        };
+
+        for(std::uint32_t row = 0; row < _rows; ++row)
+        {
+            EncodeRow(grid, row);
+        };
+    };
+
+    /// <summary>
+    /// Send a scroll, call it along with TerminalGrid::Scroll so the rows moved aren't sent again
+    /// </summary>
+    void Scroll(const std::int32_t rowCount, const TerminalCell& blank = { })
+    {
+        const std::uint32_t distance = static_cast<std::uint32_t>(std::min<std::int64_t>(std::abs(static_cast<std::int64_t>(rowCount)), _rows));
+
+        if(distance == 0)
+            return;
+
+        const std::size_t movedCellCount = static_cast<std::size_t>(_rows - distance) * _columns;
+        const std::size_t distanceCellCount = static_cast<std::size_t>(distance) * _columns;
+
+        if(rowCount > 0)
+        {
+            std::move(_shadow.begin() + distanceCellCount, _shadow.end(), _shadow.begin());
+            std::fill(_shadow.begin() + movedCellCount, _shadow.end(), blank);
+        }
+        else
+        {
+            std::move_backward(_shadow.begin(), _shadow.begin() + movedCellCount, _shadow.end());
+            std::fill(_shadow.begin(), _shadow.begin() + distanceCellCount, blank);
+        };
+
+        WriteOpcode(GridDeltaOpcode::Scroll);
+        WriteVarint((static_cast<std::uint64_t>(rowCount) << 1) ^ static_cast<std::uint64_t>(static_cast<std::int64_t>(rowCount) >> 63));
+
+        TerminalCell previous = TerminalCell();
+        WriteCell(blank, previous);
+    };
+
+    /// <summary>
+    /// Send an insertion into the receiver's document
+    /// </summary>
+    void EncodeInsert(const std::size_t position, const std::string_view& text)
+    {
+        WriteOpcode(GridDeltaOpcode::DocumentInsert);
+        WriteVarint(position);
+        WriteVarint(text.size());
+
+        const std::byte* characters = reinterpret_cast<const std::byte*>(text.data());
+
+        _commands.insert(_commands.end(), characters, characters + text.size());
+    };
+
+    /// <summary>
+    /// Send an erasure from the receiver's document
+    /// </summary>
+    void EncodeErase(const std::size_t position, const std::size_t count)
+    {
+        WriteOpcode(GridDeltaOpcode::DocumentErase);
+        WriteVarint(position);
+        WriteVarint(count);
+    };
+
+    /// <summary>
+    /// Take the commands added since the last message as a message, nothing is written if nothing changed
+    /// </summary>
+    /// <param name="message"> Replaced with the message </param>
+    /// <returns> False if there are no changes to send </returns>
+    bool TakeMessage(std::vector<std::byte>& message)
+    {
+        message.clear();
+
+        if(_commands.empty() == true)
+            return false;
+
+        std::swap(message, _commands);
+        _commands.clear();
+
+        // The header goes in front, the commands are usually far larger
+        std::byte header[1 + 5];
+        std::size_t headerSize = 0;
+
+        header[headerSize++] = static_cast<std::byte>(Version);
+
+        for(std::uint32_t value = _sequence++; ; value >>= 7)
+        {
+            header[headerSize++] = static_cast<std::byte>((value & 0x7F) | (value >= 0x80 ? 0x80 : 0));
+
+            if(value < 0x80)
+                break;
+        };
+
+        message.insert(message.begin(), header, header + headerSize);
+
+        return true;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Write the changed spans of a row, unchanged gaps shorter than MergeDistance are sent along
+    /// </summary>
+    void EncodeRow(const TerminalGrid& grid, const std::uint32_t row)
+    {
+        TerminalCell* shadowRow = _shadow.data() + (static_cast<std::size_t>(row) * _columns);
+
+        // A row of a single cell, e.g. one that was cleared, is sent as that cell
+        if(GetRunLength(grid, row, 0, _columns) == _columns)
+        {
+            const TerminalCell& cell = grid.GetCell(row, 0);
+
+            if(std::all_of(shadowRow, shadowRow + _columns, [&](const TerminalCell& shadowCell) { return shadowCell == cell; }) == true)
+                return;
+
+            WriteOpcode(GridDeltaOpcode::FillRow);
+            WriteVarint(row);
+
+            TerminalCell previous = TerminalCell();
+            WriteCell(cell, previous);
+
+            std::fill(shadowRow, shadowRow + _columns, cell);
+
+            return;
+        };
+
+        std::uint32_t column = 0;
+
+        while(column < _columns)
+        {
+            if(grid.GetCell(row, column) == shadowRow[column])
+            {
+                ++column;
+                continue;
+            };
+
+            const std::uint32_t firstColumn = column;
+            std::uint32_t endColumn = column + 1;
+
+            for(std::uint32_t unchangedCount = 0; column < _columns && unchangedCount < MergeDistance; ++column)
+            {
+                if(grid.GetCell(row, column) == shadowRow[column])
+                    ++unchangedCount;
+                else
+                {
+                    unchangedCount = 0;
+                    endColumn = column + 1;
+                };
+            };
+
+            EncodeCells(grid, row, firstColumn, endColumn);
+
+            for(std::uint32_t index = firstColumn; index < endColumn; ++index)
+            {
+                shadowRow[index] = grid.GetCell(row, index);
+            };
+
+            column = endColumn;
+        };
+    };
+
+    void EncodeCells(const TerminalGrid& grid, const std::uint32_t row, const std::uint32_t firstColumn, const std::uint32_t endColumn)
+    {
+        WriteOpcode(GridDeltaOpcode::Cells);
+        WriteVarint(row);
+        WriteVarint(firstColumn);
+
+        // The runs are counted first, the count goes in front of them
+        std::uint32_t runCount = 0;
+
+        for(std::uint32_t column = firstColumn; column < endColumn; column += GetRunLength(grid, row, column, endColumn))
+        {
+            ++runCount;
+        };
+
+        WriteVarint(runCount);
+
+        TerminalCell previous = TerminalCell();
+
+        for(std::uint32_t column = firstColumn; column < endColumn; )
+        {
+            const std::uint32_t length = GetRunLength(grid, row, column, endColumn);
+
+            WriteVarint(length);
+            WriteCell(grid.GetCell(row, column), previous);
+
+            column += length;
+        };
+    };
+
+    /// <summary>
+    /// The number of cells from a column on that are the same as it
+    /// </summary>
+    static std::uint32_t GetRunLength(const TerminalGrid& grid, const std::uint32_t row, const std::uint32_t column, const std::uint32_t endColumn)
+    {
+        const TerminalCell& cell = grid.GetCell(row, column);
+
+        std::uint32_t length = 1;
+
+        while(column + length < endColumn && grid.GetCell(row, column + length) == cell)
+        {
+            ++length;
+        };
+
+        return length;
+    };
+
+    /// <summary>
+    /// Write a field mask and the fields of a cell that differ from the previous one
+    /// </summary>
+    void WriteCell(const TerminalCell& cell, TerminalCell& previous)
+    {
+        std::uint8_t fields = 0;
+
+        if(cell.Character != previous.Character)
+            fields |= GridDeltaFields::Character;
+
+        if(cell.Foreground != previous.Foreground)
+            fields |= GridDeltaFields::Foreground;
+
+        if(cell.Background != previous.Background)
+            fields |= GridDeltaFields::Background;
+
+        if(cell.Style != previous.Style)
+            fields |= GridDeltaFields::Style;
+
+        _commands.push_back(static_cast<std::byte>(fields));
+
+        if((fields & GridDeltaFields::Character) != 0)
+            WriteVarint(static_cast<std::uint32_t>(cell.Character));
+
+        if((fields & GridDeltaFields::Foreground) != 0)
+            WriteUInt32(cell.Foreground);
+
+        if((fields & GridDeltaFields::Background) != 0)
+            WriteUInt32(cell.Background);
+
+        if((fields & GridDeltaFields::Style) != 0)
+            WriteVarint(static_cast<std::uint32_t>(cell.Style));
+
+        previous = cell;
+    };
+
+    void WriteOpcode(const GridDeltaOpcode opcode)
+    {
+        _commands.push_back(static_cast<std::byte>(opcode));
+    };
+
+    void WriteVarint(std::uint64_t value)
+    {
+        while(value >= 0x80)
+        {
+            _commands.push_back(static_cast<std::byte>((value & 0x7F) | 0x80));
+            value >>= 7;
+        };
+
+        _commands.push_back(static_cast<std::byte>(value));
+    };
+
+    void WriteUInt32(const std::uint32_t value)
+    {
+        for(std::uint32_t shift = 0; shift < 32; shift += 8)
+        {
+            _commands.push_back(static_cast<std::byte>(value >> shift));
+        };
+    };
+
+};
+
+
+/// <summary>
+/// Applies a GridDeltaEncoder's messages on the display's side. Cells are written straight into the grid, which uploads only the rows they
+/// changed, and document commands into a TextBuffer, which uploads only its dirty range, so a message costs the receiver about what it changed
+/// </summary>
+class GridDeltaDecoder
+{
+
+private:
+
+    /// <summary>
+    /// The sequence number the next message should have
+    /// </summary>
+    std::uint32_t _expectedSequence = 0;
+
+    bool _synchronized = false;
+
+    std::span<const std::byte> _message;
+
+    std::size_t _offset = 0;
+
+
+public:
+
+    /// <summary>
+    /// Apply a message
+    /// </summary>
+    /// <param name="grid"> Where cell commands go, may be null if the sender only sends document commands </param>
+    /// <param name="document"> Where document commands go, may be null if the sender only sends cells </param>
+    GridDeltaResult Apply(const std::span<const std::byte>& message, TerminalGrid* grid, TextBuffer* document = nullptr)
+    {
+        _message = message;
+        _offset = 0;
+
+        std::uint64_t sequence = 0;
+
+        if(ReadByte() != GridDeltaEncoder::Version || ReadVarint(sequence) == false)
+            return GridDeltaResult::Malformed;
+
+        // The first message sets the sequence, after that every message has to follow the last
+        if(_synchronized == true && sequence != _expectedSequence)
+            return GridDeltaResult::OutOfSequence;
+
+        _synchronized = true;
+        _expectedSequence = static_cast<std::uint32_t>(sequence) + 1;
+
+        while(_offset < _message.size())
+        {
+            if(ApplyCommand(static_cast<GridDeltaOpcode>(ReadByte()), grid, document) == false)
+                return GridDeltaResult::Malformed;
+        };
+
+        return GridDeltaResult::Applied;
+    };
+
+    /// <summary>
+    /// Accept whatever message comes next, e.g. after asking the sender for the whole grid again
+    /// </summary>
+    void Resynchronize()
+    {
+        _synchronized = false;
+    };
+
+
+private:
+
+    bool ApplyCommand(const GridDeltaOpcode opcode, TerminalGrid* grid, TextBuffer* document)
+    {
+        switch(opcode)
+        {
+            case GridDeltaOpcode::Resize:
+            {
+                std::uint64_t rows = 0;
+                std::uint64_t columns = 0;
+
+                if(grid == nullptr || ReadVarint(rows) == false || ReadVarint(columns) == false ||
+                   rows == 0 || columns == 0 || rows > 0xFFFF || columns > 0xFFFF)
+                    return false;
+
+                grid->Resize(static_cast<std::uint32_t>(rows), static_cast<std::uint32_t>(columns));
+
+                // The sender's copy starts blank
+                for(std::uint32_t row = 0; row < grid->GetRows(); ++row)
+                {
+                    grid->ClearRow(row);
+                };
+
+                return true;
+            };
+
+            case GridDeltaOpcode::Scroll:
+            {
+                std::uint64_t zigzag = 0;
+
+                TerminalCell blank = TerminalCell();
+
+                if(grid == nullptr || ReadVarint(zigzag) == false || ReadCell(blank) == false)
+                    return false;
+
+                const std::int64_t rowCount = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+
+                grid->Scroll(static_cast<std::int32_t>(std::clamp<std::int64_t>(rowCount, -static_cast<std::int64_t>(grid->GetRows()), grid->GetRows())), blank);
+
+                return true;
+            };
+
+            case GridDeltaOpcode::Cells:
+            {
+                std::uint64_t row = 0;
+                std::uint64_t column = 0;
+                std::uint64_t runCount = 0;
+
+                if(grid == nullptr || ReadVarint(row) == false || ReadVarint(column) == false || ReadVarint(runCount) == false || row >= grid->GetRows())
+                    return false;
+
+                TerminalCell cell = TerminalCell();
+
+                for(std::uint64_t run = 0; run < runCount; ++run)
+                {
+                    std::uint64_t length = 0;
+
+                    if(ReadVarint(length) == false || ReadCell(cell) == false || length > grid->GetColumns() - std::min<std::uint64_t>(column, grid->GetColumns()))
+                        return false;
+
+                    for(std::uint64_t index = 0; index < length; ++index)
+                    {
+                        grid->SetCell(static_cast<std::uint32_t>(row), static_cast<std::uint32_t>(column++), cell);
+                    };
+                };
+
+                return true;
+            };
+
+            case GridDeltaOpcode::FillRow:
+            {
+                std::uint64_t row = 0;
+
+                TerminalCell cell = TerminalCell();
+
+                if(grid == nullptr || ReadVarint(row) == false || ReadCell(cell) == false || row >= grid->GetRows())
+                    return false;
+
+                grid->ClearRow(static_cast<std::uint32_t>(row), cell);
+
+                return true;
+            };
+
+            case GridDeltaOpcode::DocumentInsert:
+            {
+                std::uint64_t position = 0;
+                std::uint64_t length = 0;
+
+                if(document == nullptr || ReadVarint(position) == false || ReadVarint(length) == false || length > _message.size() - _offset)
+                    return false;
+
+                // Straight from the message into the document's add buffer
+                document->Insert(static_cast<std::size_t>(position), std::string_view(reinterpret_cast<const char*>(_message.data() + _offset), static_cast<std::size_t>(length)));
+
+                _offset += static_cast<std::size_t>(length);
+
+                return true;
+            };
+
+            case GridDeltaOpcode::DocumentErase:
+            {
+                std::uint64_t position = 0;
+                std::uint64_t count = 0;
+
+                if(document == nullptr || ReadVarint(position) == false || ReadVarint(count) == false)
+                    return false;
+
+                document->Erase(static_cast<std::size_t>(position), static_cast<std::size_t>(count));
+
+                return true;
+            };
+
+            default:
+                return false;
+        };
+    };
+
+    /// <summary>
+    /// Read a field mask and the fields it names into a cell holding the previous one
+    /// </summary>
+    bool ReadCell(TerminalCell& cell)
+    {
+        if(_offset >= _message.size())
+            return false;
+
+        const std::uint8_t fields = ReadByte();
+
+        std::uint64_t value = 0;
+
+        if((fields & GridDeltaFields::Character) != 0)
+        {
+            if(ReadVarint(value) == false || value > 0x10FFFF)
+                return false;
+
+            cell.Character = static_cast<char32_t>(value);
+        };
+
+        if((fields & GridDeltaFields::Foreground) != 0 && ReadUInt32(cell.Foreground) == false)
+            return false;
+
+        if((fields & GridDeltaFields::Background) != 0 && ReadUInt32(cell.Background) == false)
+            return false;
+
+        if((fields & GridDeltaFields::Style) != 0)
+        {
+            if(ReadVarint(value) == false)
+                return false;
+
+            cell.Style = static_cast<GlyphStyle>(static_cast<std::uint32_t>(value));
+        };
+
+        return true;
+    };
+
+    /// <summary>
+    /// The next byte, or 0 past the end, which is never a valid opcode or version
+    /// </summary>
+    std::uint8_t ReadByte()
+    {
+        if(_offset >= _message.size())
+            return 0;
+
+        return static_cast<std::uint8_t>(_message[_offset++]);
+    };
+
+    bool ReadVarint(std::uint64_t& value)
+    {
+        value = 0;
+
+        for(std::uint32_t shift = 0; shift < 64; shift += 7)
+        {
+            if(_offset >= _message.size())
+                return false;
+
+            const std::uint8_t byte = static_cast<std::uint8_t>(_message[_offset++]);
+
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+            if((byte & 0x80) == 0)
+                return true;
+        };
+
+        return false;
+    };
+
+    bool ReadUInt32(std::uint32_t& value)
+    {
+        if(_message.size() - _offset < 4)
+            return false;
+
+        value = 0;
+
+        for(std::uint32_t index = 0; index < 4; ++index)
+        {
+            value |= static_cast<std::uint32_t>(_message[_offset++]) << (index * 8);
+        };
+
+        return true;
+    };
+
+};
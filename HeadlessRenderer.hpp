@@ -0,0 +1,233 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <glm/vec4.hpp>
+
+#include "FrameUniformBuffer.hpp"
+#include "PixelReadback.hpp"
+#include "GLStateCache.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// Draws text images into an offscreen framebuffer and reads them back into memory, for generating images without a visible window.
+/// Needs a current context, a hidden window from InitializeGLFWWindow is enough since its own framebuffer is never drawn to.
+/// Images are read back asynchronously, with several frames in flight, and handed to a callback once they're done
+/// </summary>
+class HeadlessRenderer
+{
+
+private:
+
+    std::uint32_t _width = 0;
+    std::uint32_t _height = 0;
+
+    std::uint32_t _framebuffer = 0;
+    std::uint32_t _colourRenderbuffer = 0;
+
+    /// <summary>
+    /// Maps the framebuffer's pixels, bound in place of the window's while an image is drawn
+    /// </summary>
+    FrameUniformBuffer _frameUniformBuffer;
+
+    PixelReadback _readback;
+
+    /// <summary>
+    /// Receives every finished image, on the thread that renders
+    /// </summary>
+    std::function<void(const ReadbackImage&)> _onImage;
+
+    /// <summary>
+    /// The next image's tag, images are numbered in the order they were rendered
+    /// </summary>
+    std::uint64_t _nextImage = 0;
+
+
+public:
+
+    /// <param name="width"> The images' width </param>
+    /// <param name="height"> The images' height </param>
+    /// <param name="onImage"> Receives each image once it was read back, the pixels are only valid during the call </param>
+    /// <param name="framesInFlight"> The number of images that are drawn before the first one has to be read back </param>
+    HeadlessRenderer(const std::uint32_t width,
+                     const std::uint32_t height,
+                     std::function<void(const ReadbackImage&)> onImage,
+                     const std::uint32_t framesInFlight = 3) :
+        _width(width),
+        _height(height),
+        _readback(width, height, framesInFlight),
+        _onImage(std::move(onImage))
+    {
+        glCreateRenderbuffers(1, &_colourRenderbuffer);
+        glNamedRenderbufferStorage(_colourRenderbuffer, GL_RGBA8, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height));
+
+        glCreateFramebuffers(1, &_framebuffer);
+        glNamedFramebufferRenderbuffer(_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colourRenderbuffer);
+
+        wt::Assert(glCheckNamedFramebufferStatus(_framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Headless framebuffer is incomplete");
+
+        _frameUniformBuffer.SetViewportSize(static_cast<int>(_width), static_cast<int>(_height));
+    };
+
+    HeadlessRenderer(const HeadlessRenderer&) = delete;
+    HeadlessRenderer& operator = (const HeadlessRenderer&) = delete;
+
+    /// <summary>
+    /// Images still in flight are waited for and handed over first
+    /// </summary>
+    ~HeadlessRenderer()
+    {
+        Finish();
+
+        glDeleteFramebuffers(1, &_framebuffer);
+        glDeleteRenderbuffers(1, &_colourRenderbuffer);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Draw an image and start reading it back. Images that finished in the meantime are handed over first,
+    /// and if every readback is still in flight this waits for the oldest one.
+    /// Leaves the headless FrameUniformBuffer bound and the window's framebuffer bound again
+    /// </summary>
+    /// <param name="draw"> Issues the image's draws, e.g. FontSprite::Draw calls </param>
+    /// <param name="clearColour"> What the image is cleared to, transparent by default </param>
+    /// <returns> The image's tag, see ReadbackImage::Tag </returns>
+    template<typename TDraw>
+    std::uint64_t Render(TDraw&& draw, const glm::vec4& clearColour = { 0.0f, 0.0f, 0.0f, 0.0f })
+    {
+        _readback.Collect(_onImage);
+
+        if(_readback.GetPendingCount() == _readback.GetSlotCount())
+            _readback.Collect(_onImage, true);
+
+
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        glViewport(0, 0, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height));
+
+        glClearNamedFramebufferfv(_framebuffer, GL_COLOR, 0, &clearColour.x);
+
+        _frameUniformBuffer.Upload(0.0f);
+        _frameUniformBuffer.Bind();
+
+        draw();
+
+        const std::uint64_t image = _nextImage++;
+
+        _readback.Read(_framebuffer, _width, _height, image);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        return image;
+    };
+
+    /// <summary>
+    /// The buffer bound while an image is drawn, for anything that binds its own and has to bind the frame's again, e.g. a LabelCache
+    /// </summary>
+    const FrameUniformBuffer& GetFrameUniformBuffer() const
+    {
+        return _frameUniformBuffer;
+    };
+
+    /// <summary>
+    /// Hand over the images that finished since the last call, without waiting
+    /// </summary>
+    /// <returns> The number of images handed over </returns>
+    std::size_t Poll()
+    {
+        return _readback.Collect(_onImage);
+    };
+
+    /// <summary>
+    /// Wait for every image in flight and hand them over
+    /// </summary>
+    void Finish()
+    {
+        _readback.Drain(_onImage);
+    };
+
+
+public:
+
+    std::uint32_t GetWidth() const
+    {
+        return _width;
+    };
+
+    std::uint32_t GetHeight() const
+    {
+        return _height;
+    };
+
+    std::uint32_t GetFramebufferID() const
+    {
+        return _framebuffer;
+    };
+
+};
+
+
+/// <summary>
+/// Write a read back image as an uncompressed 32 bit BMP. BMP rows go from the bottom up like GL's, only red and blue swap places
+/// </summary>
+/// <returns> False if the file couldn't be written </returns>
+inline bool WriteReadbackImageBMP(const ReadbackImage& image, const std::filesystem::path& path)
+{
+    constexpr std::uint32_t fileHeaderSize = 14;
+    constexpr std::uint32_t infoHeaderSize = 40;
+
+    const std::uint32_t pixelsSize = image.Width * image.Height * 4;
+
+    std::vector<std::uint8_t> file;
+    file.reserve(fileHeaderSize + infoHeaderSize + pixelsSize);
+
+    const auto write = [&file](const std::uint32_t value, const std::uint32_t sizeInBytes)
+    {
+        for(std::uint32_t byte = 0; byte < sizeInBytes; ++byte)
+            file.push_back(static_cast<std::uint8_t>(value >> (byte * 8)));
+    };
+
+    // BITMAPFILEHEADER
+    write('B' | ('M' << 8), 2);
+    write(fileHeaderSize + infoHeaderSize + pixelsSize, 4);
+    write(0, 4);
+    write(fileHeaderSize + infoHeaderSize, 4);
+
+    // BITMAPINFOHEADER, a positive height is bottom-up, BI_RGB
+    write(infoHeaderSize, 4);
+    write(image.Width, 4);
+    write(image.Height, 4);
+    write(1, 2);
+    write(32, 2);
+    write(0, 4);
+    write(pixelsSize, 4);
+    write(2835, 4);
+    write(2835, 4);
+    write(0, 4);
+    write(0, 4);
+
+    for(std::size_t offset = 0; offset + 4 <= image.Pixels.size(); offset += 4)
+    {
+        file.push_back(static_cast<std::uint8_t>(image.Pixels[offset + 2]));
+        file.push_back(static_cast<std::uint8_t>(image.Pixels[offset + 1]));
+        file.push_back(static_cast<std::uint8_t>(image.Pixels[offset + 0]));
+        file.push_back(static_cast<std::uint8_t>(image.Pixels[offset + 3]));
+    };
+
+    std::ofstream stream = std::ofstream(path, std::ios::binary | std::ios::trunc);
+
+    if(stream.is_open() == false)
+        return false;
+
+    stream.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+
+    return stream.good();
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "FontSprite.hpp"
+#include "StringTable.hpp"
+
+
+/// <summary>
+/// Immediate-mode text for UI code that draws every label every frame, e.g. Text("fps", fpsText, { 8.0f, 8.0f }).
+/// Every label is known by an id and remembers what it drew last frame, so a label that didn't change is queued from its GPU-resident glyph run
+/// without being hashed, converted or uploaded again, and only labels that changed are laid out anew. Labels are drawn through the sprite's
+/// glyph run cache, which needs EnableGlyphRunCache and a program with FontShaderFeature::MultiDraw, and all of a frame's labels by one multi-draw in EndFrame.
+/// Labels that weren't drawn in a frame are forgotten
+/// </summary>
+class ImmediateText
+{
+
+private:
+
+    struct Label
+    {
+        /// <summary>
+        /// The text the label drew last, invalid once the strings started over
+        /// </summary>
+        InternedString String;
+
+        std::uint64_t LastFrame = 0;
+    };
+
+
+    std::reference_wrapper<FontSprite> _fontSprite;
+
+    /// <summary>
+    /// Every label's text. Runs are found by these ids, see FontSprite::QueueCached
+    /// </summary>
+    StringTable _strings;
+
+    std::unordered_map<std::uint64_t, Label> _labels;
+
+    /// <summary>
+    /// The most characters the strings hold before they start over, text that changes every frame would otherwise pile up
+    /// </summary>
+    std::size_t _characterCapacity = 0;
+
+    std::uint64_t _frame = 1;
+
+
+public:
+
+    /// <param name="fontSprite"> Must outlive the immediate text, with its glyph run cache enabled </param>
+    /// <param name="characterCapacity"> The most characters of label text kept before it starts over </param>
+    ImmediateText(FontSprite& fontSprite, const std::size_t characterCapacity = 1 << 20) :
+        _fontSprite(fontSprite),
+        _characterCapacity(characterCapacity)
+    {
+    };
+
+    ImmediateText(const ImmediateText&) = delete;
+    ImmediateText& operator = (const ImmediateText&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Draw a label this frame. It's queued, and drawn by EndFrame
+    /// </summary>
+    /// <param name="id"> Unique to the label and the same every frame, e.g. a hash of its place in the UI </param>
+    /// <param name="text"> The label's text, only laid out again when it differs from last frame's </param>
+    /// <param name="position"> Where the label's origin is, within the sprite's Transform </param>
+    /// <param name="textColour"> Changes without laying the label out again </param>
+    void Text(const std::uint64_t id, const std::string_view& text, const glm::vec2& position, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f })
+    {
+        if(text.empty() == true)
+            return;
+
+        Label& label = _labels[id];
+
+        label.LastFrame = _frame;
+
+        // Comparing with last frame's text is cheaper than hashing it, and most labels don't change
+        if(label.String.IsValid() == false || _strings.Get(label.String) != text)
+        {
+            if(_strings.GetCharacterCount() + text.size() > _characterCapacity)
+                StartOver();
+
+            label.String = _strings.Intern(text);
+        };
+
+        FontSprite& fontSprite = _fontSprite.get();
+
+        const glm::mat4 transform = fontSprite.Transform;
+
+        fontSprite.Transform = glm::translate(transform, glm::vec3(position, 0.0f));
+
+        fontSprite.QueueCached(_strings, label.String, textColour);
+
+        fontSprite.Transform = transform;
+    };
+
+    /// <summary>
+    /// Draw a label this frame, known by a name rather than a number, see Text
+    /// </summary>
+    void Text(const std::string_view& id, const std::string_view& text, const glm::vec2& position, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f })
+    {
+        Text(static_cast<std::uint64_t>(std::hash<std::string_view>()(id)), text, position, textColour);
+    };
+
+    /// <summary>
+    /// Draw every label of the frame and forget the labels that weren't drawn in it. Call once a frame, after its last Text
+    /// </summary>
+    void EndFrame()
+    {
+        _fontSprite.get().SubmitQueued();
+
+        std::erase_if(_labels, [this](const auto& label)
+        {
+            return label.second.LastFrame != _frame;
+        });
+
+        ++_frame;
+    };
+
+
+public:
+
+    std::size_t GetLabelCount() const
+    {
+        return _labels.size();
+    };
+
+    /// <summary>
+    /// The number of distinct texts the labels drew since the strings last started over
+    /// </summary>
+    std::size_t GetStringCount() const
+    {
+        return _strings.GetStringCount();
+    };
+
+
+private:
+
+    /// <summary>
+    /// Clear the strings, every label is interned again the next time it's drawn. The glyph run cache simply misses the old ids
+    /// </summary>
+    void StartOver()
+    {
+        // Draws queued earlier in the frame point at their runs rather than at the strings, they're unaffected
+        _strings.Clear();
+
+        for(auto& [id, label] : _labels)
+        {
+            label.String = InternedString();
+        };
+    };
+
+};
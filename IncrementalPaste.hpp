@@ -0,0 +1,205 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "TextBuffer.hpp"
+#include "TextConversion.hpp"
+#include "TextUndo.hpp"
+
+
+/// <summary>
+/// Splices pastes into a document a slice at a time, so a paste of hundreds of megabytes is decoded and uploaded over many frames
+/// instead of stalling one. Every frame decodes and appends slices until its time budget is spent, the document grows as it goes,
+/// and only the characters appended that frame are uploaded. Edits made after a paste have to wait until it's done, see IsPasting.
+/// Only for the thread that owns the document
+/// </summary>
+class IncrementalPaste
+{
+
+private:
+
+    struct PendingPaste
+    {
+        /// <summary>
+        /// The clipboard's text, as it was copied, decoded as it's spliced in
+        /// </summary>
+        std::string UTF8;
+
+        std::size_t Offset = 0;
+    };
+
+    std::deque<PendingPaste> _pending;
+
+    /// <summary>
+    /// A slice's converted characters, kept so slices don't allocate
+    /// </summary>
+    std::string _decoded;
+
+    /// <summary>
+    /// The bytes of every paste since the queue was last empty, and how many of them were spliced in, for the progress
+    /// </summary>
+    std::size_t _totalBytes = 0;
+    std::size_t _ingestedBytes = 0;
+
+
+public:
+
+    /// <summary>
+    /// How many bytes are decoded and appended at once. The time budget is checked between slices
+    /// </summary>
+    std::size_t SliceSizeInBytes = 256 * 1024;
+
+    /// <summary>
+    /// How long a frame may spend splicing, at least one slice is always spliced
+    /// </summary>
+    std::chrono::microseconds TimeBudget = std::chrono::microseconds(4000);
+
+
+public:
+
+    /// <summary>
+    /// Queue a paste behind any that aren't done yet
+    /// </summary>
+    /// <param name="utf8"> The pasted text, undecoded </param>
+    void Add(std::string&& utf8)
+    {
+        if(utf8.empty() == true)
+            return;
+
+        _totalBytes += utf8.size();
+
+        _pending.push_back(PendingPaste { .UTF8 = std::move(utf8) });
+    };
+
+    /// <summary>
+    /// Splice slices of the queued pastes into a document until the frame's time budget is spent
+    /// </summary>
+    /// <param name="history"> If given, every paste is logged in it as a single edit, however many slices it took </param>
+    /// <returns> The number of characters appended </returns>
+    std::size_t Ingest(TextBuffer& document, TextUndoHistory* history = nullptr)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        std::size_t appendedCount = 0;
+
+        while(_pending.empty() == false)
+        {
+            PendingPaste& paste = _pending.front();
+
+            const std::string_view slice = GetNextSlice(paste);
+
+            _decoded.clear();
+
+            DecodeUTF8ToGlyphText(slice, _decoded);
+
+            if(history == nullptr)
+                document.Append(_decoded);
+            else
+            {
+                // The slices are contiguous in the add buffer, so they all grow the paste's edit, which starts and ends on its own
+                if(paste.Offset == 0)
+                    history->BreakCoalescing();
+
+                history->Insert(document, document.GetSize(), _decoded, 0.0);
+            };
+
+            appendedCount += _decoded.size();
+
+            paste.Offset += slice.size();
+            _ingestedBytes += slice.size();
+
+            if(paste.Offset == paste.UTF8.size())
+            {
+                _pending.pop_front();
+
+                if(history != nullptr)
+                    history->BreakCoalescing();
+            };
+
+            if(std::chrono::steady_clock::now() - start >= TimeBudget)
+                break;
+        };
+
+        if(_pending.empty() == true)
+        {
+            _totalBytes = 0;
+            _ingestedBytes = 0;
+
+            // A huge paste shouldn't keep its scratch memory around
+            _decoded = std::string();
+        };
+
+        return appendedCount;
+    };
+
+    /// <summary>
+    /// Drop every paste that isn't done, what was already spliced in stays
+    /// </summary>
+    void Cancel()
+    {
+        _pending.clear();
+
+        _totalBytes = 0;
+        _ingestedBytes = 0;
+    };
+
+
+public:
+
+    bool IsPasting() const
+    {
+        return _pending.empty() == false;
+    };
+
+    /// <summary>
+    /// How much of the queued pastes was spliced in, between 0 and 1
+    /// </summary>
+    double GetProgress() const
+    {
+        return _totalBytes > 0 ? static_cast<double>(_ingestedBytes) / static_cast<double>(_totalBytes) : 1.0;
+    };
+
+    std::size_t GetTotalBytes() const
+    {
+        return _totalBytes;
+    };
+
+    std::size_t GetIngestedBytes() const
+    {
+        return _ingestedBytes;
+    };
+
+
+private:
+
+    /// <summary>
+    /// The next slice of a paste, cut so it doesn't split a UTF-8 sequence or a "\r\n", which are converted as one
+    /// </summary>
+    std::string_view GetNextSlice(const PendingPaste& paste) const
+    {
+        const std::string_view rest = std::string_view(paste.UTF8).substr(paste.Offset);
+
+        if(rest.size() <= SliceSizeInBytes)
+            return rest;
+
+        std::size_t size = SliceSizeInBytes;
+
+        // Continuation bytes are 10xxxxxx, back up to the sequence's first byte
+        while(size > 1 && (static_cast<std::uint8_t>(rest[size]) & 0xC0) == 0x80)
+        {
+            --size;
+        };
+
+        if(size > 1 && rest[size - 1] == '\r')
+            --size;
+
+        return rest.substr(0, size);
+    };
+
+};
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// Counts a set of scheduled jobs that haven't finished yet, see JobSystem::Wait
+/// </summary>
+class JobGroup
+{
+    friend class JobSystem;
+
+private:
+
+    std::atomic<std::size_t> _pendingCount = 0;
+
+
+public:
+
+    JobGroup() = default;
+
+    JobGroup(const JobGroup&) = delete;
+    JobGroup& operator = (const JobGroup&) = delete;
+
+
+public:
+
+    bool IsDone() const
+    {
+        return _pendingCount.load(std::memory_order_acquire) == 0;
+    };
+
+};
+
+
+/// <summary>
+/// A pool of worker threads with a work-stealing deque each.
+/// A worker runs its own jobs newest first, and when it runs out steals the oldest job of another worker.
+/// Threads that wait on a group run jobs too, so waiting never leaves a core idle
+/// </summary>
+class JobSystem
+{
+
+private:
+
+    struct Job
+    {
+        std::function<void()> Run;
+
+        JobGroup* Group = nullptr;
+    };
+
+    /// <summary>
+    /// Each deque is on its own cache line, so workers only contend when stealing
+    /// </summary>
+    struct alignas(64) WorkerQueue
+    {
+        std::mutex Lock;
+
+        std::deque<Job> Jobs;
+    };
+
+
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;
+
+    std::vector<std::thread> _workers;
+
+
+    /// <summary>
+    /// The number of jobs in all of the queues, idle workers sleep while it's 0
+    /// </summary>
+    std::atomic<std::size_t> _queuedCount = 0;
+
+    /// <summary>
+    /// Threads that aren't workers push to the queues in turn
+    /// </summary>
+    std::atomic<std::size_t> _nextQueue = 0;
+
+    std::mutex _sleepLock;
+
+    std::condition_variable _wakeUp;
+
+    std::atomic<bool> _stopping = false;
+
+
+    /// <summary>
+    /// The system the current thread is a worker of, and its queue's index
+    /// </summary>
+    static inline thread_local const JobSystem* _currentSystem = nullptr;
+
+    static inline thread_local std::size_t _currentQueue = 0;
+
+
+public:
+
+    /// <param name="workerCount"> The number of worker threads, by default one less than the number of cores since the calling thread also runs jobs while it waits </param>
+    /// <param name="scheduling"> The workers' priority and affinity, e.g. below normal so they never delay the render thread </param>
+    JobSystem(const std::size_t workerCount = std::max<std::size_t>(std::thread::hardware_concurrency(), 2) - 1, const wt::ThreadScheduling& scheduling = { })
+    {
+        const std::size_t queueCount = std::max<std::size_t>(workerCount, 1);
+
+        _queues.reserve(queueCount);
+
+        for(std::size_t index = 0; index < queueCount; ++index)
+        {
+            _queues.emplace_back(std::make_unique<WorkerQueue>());
+        };
+
+
+        _workers.reserve(queueCount);
+
+        for(std::size_t index = 0; index < queueCount; ++index)
+        {
+            _workers.emplace_back([this, index, scheduling]()
+            {
+                scheduling.ApplyToCurrentThread();
+
+                RunWorker(index);
+            });
+        };
+    };
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator = (const JobSystem&) = delete;
+
+    /// <summary>
+    /// Jobs still queued are run before the workers exit, so no group waited on elsewhere is left unfinished
+    /// </summary>
+    ~JobSystem()
+    {
+        {
+            const std::lock_guard lock = std::lock_guard(_sleepLock);
+
+            _stopping = true;
+        };
+
+        _wakeUp.notify_all();
+
+        for(std::thread& worker : _workers)
+        {
+            worker.join();
+        };
+
+        // The workers drain the queues before exiting, anything scheduled after they did is run here
+        while(TryRunJob(0) == true)
+        {
+        };
+    };
+
+
+public:
+
+    /// <summary>
+    /// Queue a job as part of a group. From a worker the job goes to the worker's own deque
+    /// </summary>
+    void Schedule(JobGroup& group, std::function<void()> job)
+    {
+        group._pendingCount.fetch_add(1, std::memory_order_relaxed);
+
+        const std::size_t queueIndex = _currentSystem == this ?
+            _currentQueue :
+            _nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+
+        WorkerQueue& queue = *_queues[queueIndex];
+
+        {
+            const std::lock_guard lock = std::lock_guard(queue.Lock);
+
+            queue.Jobs.emplace_back(Job
+            {
+                .Run = std::move(job),
+                .Group = &group,
+            });
+        };
+
+        _queuedCount.fetch_add(1, std::memory_order_release);
+
+        // A worker that just saw an empty system either hasn't started waiting, or is woken by this
+        {
+            const std::lock_guard lock = std::lock_guard(_sleepLock);
+        };
+
+        _wakeUp.notify_one();
+    };
+
+    /// <summary>
+    /// Block until every job in the group has finished, running queued jobs in the meantime
+    /// </summary>
+    void Wait(const JobGroup& group)
+    {
+        while(group.IsDone() == false)
+        {
+            if(TryRunJob(_currentSystem == this ? _currentQueue : 0) == false)
+                std::this_thread::yield();
+        };
+    };
+
+
+    /// <summary>
+    /// Run body(begin, end) over [0, count) in ranges of up to grainSize, in parallel, and wait for all of them
+    /// </summary>
+    /// <param name="grainSize"> The largest range a single job handles, large enough that a job outweighs scheduling it </param>
+    template<typename TBody>
+    void ParallelFor(const std::size_t count, const std::size_t grainSize, TBody&& body)
+    {
+        if(count == 0)
+            return;
+
+        const std::size_t rangeSize = std::max<std::size_t>(grainSize, 1);
+
+        // Not worth a hand off
+        if(count <= rangeSize)
+        {
+            body(std::size_t { 0 }, count);
+            return;
+        };
+
+
+        JobGroup group;
+
+        for(std::size_t begin = 0; begin < count; begin += rangeSize)
+        {
+            const std::size_t end = std::min(begin + rangeSize, count);
+
+            Schedule(group, [&body, begin, end]()
+            {
+                body(begin, end);
+            });
+        };
+
+        Wait(group);
+    };
+
+
+    std::size_t GetWorkerCount() const
+    {
+        return _workers.size();
+    };
+
+
+private:
+
+    void RunWorker(const std::size_t queueIndex)
+    {
+        _currentSystem = this;
+        _currentQueue = queueIndex;
+
+        while(true)
+        {
+            if(TryRunJob(queueIndex) == true)
+                continue;
+
+            // Only exits once every queue is empty
+            if(_stopping.load(std::memory_order_acquire) == true)
+                break;
+
+
+            std::unique_lock lock = std::unique_lock(_sleepLock);
+
+            _wakeUp.wait(lock, [this]()
+            {
+                return _queuedCount.load(std::memory_order_acquire) > 0 || _stopping.load(std::memory_order_relaxed) == true;
+            });
+        };
+    };
+
+
+    /// <summary>
+    /// Run a job, the newest one from the own queue if there is one, otherwise the oldest one from the first other queue that has one
+    /// </summary>
+    /// <returns> False if every queue was empty </returns>
+    bool TryRunJob(const std::size_t ownQueueIndex)
+    {
+        Job job;
+
+        bool found = TryPop(*_queues[ownQueueIndex], job, false);
+
+        for(std::size_t offset = 1; found == false && offset < _queues.size(); ++offset)
+        {
+            found = TryPop(*_queues[(ownQueueIndex + offset) % _queues.size()], job, true);
+        };
+
+        if(found == false)
+            return false;
+
+
+        _queuedCount.fetch_sub(1, std::memory_order_relaxed);
+
+        job.Run();
+
+        job.Group->_pendingCount.fetch_sub(1, std::memory_order_release);
+
+        return true;
+    };
+
+    static bool TryPop(WorkerQueue& queue, Job& job, const bool steal)
+    {
+        const std::lock_guard lock = std::lock_guard(queue.Lock);
+
+        if(queue.Jobs.empty() == true)
+            return false;
+
+        if(steal == true)
+        {
+            job = std::move(queue.Jobs.front());
+            queue.Jobs.pop_front();
+        }
+        else
+        {
+            job = std::move(queue.Jobs.back());
+            queue.Jobs.pop_back();
+        };
+
+        return true;
+    };
+
+};
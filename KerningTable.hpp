@@ -0,0 +1,194 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "FontAtlasPackage.hpp"
+#include "GLStateCache.hpp"
+
+
+/// <summary>
+/// The shader storage bindings a KerningTable's ranges and entries are bound to
+/// </summary>
+constexpr std::uint32_t KerningRangesBindingIndex = 9;
+constexpr std::uint32_t KerningEntriesBindingIndex = 10;
+
+
+/// <summary>
+/// Kerning pairs by glyph index, grouped by their first glyph.
+/// A glyph's pairs are Entries[Ranges[glyph] .. Ranges[glyph + 1]), sorted by the second glyph, so a lookup is a binary search over
+/// the few pairs that start with the same glyph instead of over every pair of the font. Uploaded as is for the layout pass
+/// </summary>
+class KerningTable
+{
+
+public:
+
+    static constexpr std::uint32_t NoGlyph = std::numeric_limits<std::uint32_t>::max();
+
+    /// <summary>
+    /// Matches the std430 layout of "KerningEntry" in TextLayoutComputeShader.glsl
+    /// </summary>
+    struct Entry
+    {
+        std::uint32_t SecondGlyph = 0;
+
+        float Adjustment = 0.0f;
+    };
+
+
+private:
+
+    /// <summary>
+    /// GlyphCount + 1 offsets into _entries
+    /// </summary>
+    std::vector<std::uint32_t> _ranges = std::vector<std::uint32_t>(1, 0);
+
+    std::vector<Entry> _entries;
+
+    std::uint32_t _rangesBuffer = 0;
+    std::uint32_t _entriesBuffer = 0;
+
+
+public:
+
+    KerningTable() = default;
+
+    KerningTable(const KerningTable&) = delete;
+    KerningTable& operator = (const KerningTable&) = delete;
+
+    ~KerningTable()
+    {
+        DestroyBuffers();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Group a font's kerning pairs by glyph
+    /// </summary>
+    /// <param name="pairs"> The pairs, by codepoint </param>
+    /// <param name="glyphCount"> The number of glyphs in the font </param>
+    /// <param name="getGlyphIndex"> Converts a codepoint to a glyph index, NoGlyph for codepoints the font doesn't have </param>
+    template<typename TGetGlyphIndex>
+    void Build(const std::vector<KerningPair>& pairs, const std::uint32_t glyphCount, TGetGlyphIndex&& getGlyphIndex)
+    {
+        struct GlyphPair
+        {
+            std::uint32_t FirstGlyph;
+            Entry Value;
+        };
+
+        std::vector<GlyphPair> glyphPairs;
+        glyphPairs.reserve(pairs.size());
+
+        for(const KerningPair& pair : pairs)
+        {
+            const std::uint32_t firstGlyph = getGlyphIndex(static_cast<char32_t>(pair.First));
+            const std::uint32_t secondGlyph = getGlyphIndex(static_cast<char32_t>(pair.Second));
+
+            if(firstGlyph >= glyphCount || secondGlyph >= glyphCount || pair.Adjustment == 0.0f)
+                continue;
+
+            glyphPairs.push_back(GlyphPair { firstGlyph, Entry { secondGlyph, pair.Adjustment } });
+        };
+
+        std::sort(glyphPairs.begin(), glyphPairs.end(), [](const GlyphPair& left, const GlyphPair& right)
+        {
+            return left.FirstGlyph != right.FirstGlyph ? left.FirstGlyph < right.FirstGlyph : left.Value.SecondGlyph < right.Value.SecondGlyph;
+        });
+
+
+        // Counting sort's prefix sum, every glyph's range ends where the next one's begins
+        _ranges.assign(static_cast<std::size_t>(glyphCount) + 1, 0);
+        _entries.clear();
+        _entries.reserve(glyphPairs.size());
+
+        for(const GlyphPair& glyphPair : glyphPairs)
+        {
+            ++_ranges[glyphPair.FirstGlyph + 1];
+
+            _entries.push_back(glyphPair.Value);
+        };
+
+        for(std::size_t index = 1; index < _ranges.size(); ++index)
+        {
+            _ranges[index] += _ranges[index - 1];
+        };
+    };
+
+    /// <summary>
+    /// Upload the table, replacing the previous upload
+    /// </summary>
+    void Upload()
+    {
+        DestroyBuffers();
+
+        glCreateBuffers(1, &_rangesBuffer);
+        glNamedBufferStorage(_rangesBuffer, static_cast<GLsizeiptr>(_ranges.size() * sizeof(std::uint32_t)), _ranges.data(), 0);
+
+        // Empty storage isn't allowed, fonts without kerning still get a single unused entry
+        const Entry unusedEntry = Entry { };
+
+        glCreateBuffers(1, &_entriesBuffer);
+        glNamedBufferStorage(_entriesBuffer,
+                             static_cast<GLsizeiptr>(std::max<std::size_t>(_entries.size(), 1) * sizeof(Entry)),
+                             _entries.empty() == true ? &unusedEntry : _entries.data(),
+                             0);
+    };
+
+    /// <summary>
+    /// Bind the ranges and entries to KerningRangesBindingIndex and KerningEntriesBindingIndex
+    /// </summary>
+    void Bind() const
+    {
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, KerningRangesBindingIndex, _rangesBuffer);
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, KerningEntriesBindingIndex, _entriesBuffer);
+    };
+
+
+    /// <summary>
+    /// The adjustment to the first glyph's advance when it's followed by the second, in pixels
+    /// </summary>
+    float Find(const std::uint32_t firstGlyph, const std::uint32_t secondGlyph) const
+    {
+        if(static_cast<std::size_t>(firstGlyph) + 1 >= _ranges.size())
+            return 0.0f;
+
+        const auto begin = _entries.cbegin() + _ranges[firstGlyph];
+        const auto end = _entries.cbegin() + _ranges[firstGlyph + 1];
+
+        const auto entry = std::lower_bound(begin, end, secondGlyph, [](const Entry& entry, const std::uint32_t glyph)
+        {
+            return entry.SecondGlyph < glyph;
+        });
+
+        if(entry == end || entry->SecondGlyph != secondGlyph)
+            return 0.0f;
+
+        return entry->Adjustment;
+    };
+
+    std::size_t GetPairCount() const
+    {
+        return _entries.size();
+    };
+
+
+private:
+
+    void DestroyBuffers()
+    {
+        GLState.DeleteBuffer(_rangesBuffer);
+        GLState.DeleteBuffer(_entriesBuffer);
+
+        _rangesBuffer = 0;
+        _entriesBuffer = 0;
+    };
+
+};
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+
+/// <summary>
+/// The most bytes compressing a number of bytes with CompressLZ4 can take, for incompressible input
+/// </summary>
+constexpr std::size_t GetLZ4CompressedSizeBound(const std::size_t sizeInBytes)
+{
+    return sizeInBytes + (sizeInBytes / 255) + 16;
+};
+
+
+/// <summary>
+/// Compress bytes into the LZ4 block format, readable by any LZ4 decoder's block API.
+/// A single-probe hash table, the fast mode of the reference encoder: text like logs compresses 3 to 5 times, at several hundred MB/s
+/// </summary>
+/// <param name="source"> The bytes to compress </param>
+/// <param name="destination"> Where to write the block, at least GetLZ4CompressedSizeBound(source.size()) bytes </param>
+/// <returns> The size of the block </returns>
+inline std::size_t CompressLZ4(const std::span<const std::byte>& source, const std::span<std::byte>& destination)
+{
+    constexpr std::size_t MinimumMatch = 4;
+
+    // The format ends every block with literals: the last match has to start 12 bytes and end 5 bytes before the end
+    constexpr std::size_t LastLiterals = 5;
+    constexpr std::size_t MatchFindLimit = 12;
+
+    constexpr std::uint32_t HashBits = 12;
+
+    constexpr std::size_t MaximumOffset = 65535;
+
+
+    const std::uint8_t* const sourceStart = reinterpret_cast<const std::uint8_t*>(source.data());
+    const std::uint8_t* const sourceEnd = sourceStart + source.size();
+
+    std::uint8_t* const destinationStart = reinterpret_cast<std::uint8_t*>(destination.data());
+    std::uint8_t* output = destinationStart;
+
+    const auto read32 = [](const std::uint8_t* bytes)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+
+        return value;
+    };
+
+    const auto writeLength = [&](std::size_t length)
+    {
+        for(; length >= 255; length -= 255)
+        {
+            *output++ = 255;
+        };
+
+        *output++ = static_cast<std::uint8_t>(length);
+    };
+
+    const std::uint8_t* literalStart = sourceStart;
+
+    if(source.size() >= MatchFindLimit)
+    {
+        // Offsets into the source of the last position with each hash. Stale or colliding entries are caught by comparing the bytes
+        std::array<std::uint32_t, 1 << HashBits> table = { };
+
+        const std::uint8_t* const matchEndLimit = sourceEnd - LastLiterals;
+        const std::uint8_t* const matchStartLimit = sourceEnd - MatchFindLimit;
+
+        const std::uint8_t* position = sourceStart;
+
+        while(position <= matchStartLimit)
+        {
+            const std::uint32_t sequence = read32(position);
+            const std::uint32_t hash = (sequence * 2654435761u) >> (32 - HashBits);
+
+            const std::uint8_t* match = sourceStart + table[hash];
+            table[hash] = static_cast<std::uint32_t>(position - sourceStart);
+
+            if(match >= position || static_cast<std::size_t>(position - match) > MaximumOffset || read32(match) != sequence)
+            {
+                ++position;
+                continue;
+            };
+
+            // Matches often start before the sequence that was hashed
+            while(position > literalStart && match > sourceStart && position[-1] == match[-1])
+            {
+                --position;
+                --match;
+            };
+
+            const std::uint8_t* matchEnd = position + MinimumMatch;
+
+            for(const std::uint8_t* reference = match + MinimumMatch; matchEnd < matchEndLimit && *matchEnd == *reference; ++reference)
+            {
+                ++matchEnd;
+            };
+
+            const std::size_t literalLength = static_cast<std::size_t>(position - literalStart);
+            const std::size_t matchLength = static_cast<std::size_t>(matchEnd - position) - MinimumMatch;
+
+            // Token: 4 bits of literal length, 4 bits of match length, longer ones continue in the bytes after
+            std::uint8_t* const token = output++;
+            *token = static_cast<std::uint8_t>((std::min<std::size_t>(literalLength, 15) << 4) | std::min<std::size_t>(matchLength, 15));
+
+            if(literalLength >= 15)
+                writeLength(literalLength - 15);
+
+            std::memcpy(output, literalStart, literalLength);
+            output += literalLength;
+
+            const std::size_t offset = static_cast<std::size_t>(position - match);
+
+            *output++ = static_cast<std::uint8_t>(offset);
+            *output++ = static_cast<std::uint8_t>(offset >> 8);
+
+            if(matchLength >= 15)
+                writeLength(matchLength - 15);
+
+            position = matchEnd;
+            literalStart = position;
+        };
+    };
+
+    // The last sequence is literals only
+    const std::size_t literalLength = static_cast<std::size_t>(sourceEnd - literalStart);
+
+    *output++ = static_cast<std::uint8_t>(std::min<std::size_t>(literalLength, 15) << 4);
+
+    if(literalLength >= 15)
+        writeLength(literalLength - 15);
+
+    std::memcpy(output, literalStart, literalLength);
+    output += literalLength;
+
+    return static_cast<std::size_t>(output - destinationStart);
+};
+
+
+/// <summary>
+/// Decompress an LZ4 block. Every length and offset is checked, so a corrupt block fails instead of reading or writing out of bounds
+/// </summary>
+/// <param name="source"> The block </param>
+/// <param name="destination"> Where to write the bytes, exactly as many as were compressed </param>
+/// <returns> False if the block is corrupt or doesn't decompress to exactly destination.size() bytes </returns>
+inline bool DecompressLZ4(const std::span<const std::byte>& source, const std::span<std::byte>& destination)
+{
+    const std::uint8_t* input = reinterpret_cast<const std::uint8_t*>(source.data());
+    const std::uint8_t* const inputEnd = input + source.size();
+
+    std::uint8_t* const outputStart = reinterpret_cast<std::uint8_t*>(destination.data());
+    std::uint8_t* const outputEnd = outputStart + destination.size();
+    std::uint8_t* output = outputStart;
+
+    const auto readLength = [&](std::size_t& length)
+    {
+        std::uint8_t byte;
+
+        do
+        {
+            if(input == inputEnd)
+                return false;
+
+            byte = *input++;
+            length += byte;
+        }
+        while(byte == 255);
+
+        return true;
+    };
+
+    while(input < inputEnd)
+    {
+        const std::uint8_t token = *input++;
+
+        std::size_t literalLength = token >> 4;
+
+        if(literalLength == 15 && readLength(literalLength) == false)
+            return false;
+
+        if(literalLength > static_cast<std::size_t>(inputEnd - input) || literalLength > static_cast<std::size_t>(outputEnd - output))
+            return false;
+
+        std::memcpy(output, input, literalLength);
+
+        input += literalLength;
+        output += literalLength;
+
+        // The last sequence has no match
+        if(input == inputEnd)
+            break;
+
+        if(inputEnd - input < 2)
+            return false;
+
+        const std::size_t offset = static_cast<std::size_t>(input[0]) | (static_cast<std::size_t>(input[1]) << 8);
+        input += 2;
+
+        if(offset == 0 || offset > static_cast<std::size_t>(output - outputStart))
+            return false;
+
+        std::size_t matchLength = token & 15;
+
+        if(matchLength == 15 && readLength(matchLength) == false)
+            return false;
+
+        matchLength += 4;
+
+        if(matchLength > static_cast<std::size_t>(outputEnd - output))
+            return false;
+
+        // Matches may overlap what they write, e.g. a run of one repeated byte, so they're copied a byte at a time unless they can't
+        const std::uint8_t* match = output - offset;
+
+        if(offset >= matchLength)
+            std::memcpy(output, match, matchLength);
+        else
+        {
+            for(std::size_t index = 0; index < matchLength; ++index)
+            {
+                output[index] = match[index];
+            };
+        };
+
+        output += matchLength;
+    };
+
+    return output == outputEnd;
+};
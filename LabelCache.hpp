@@ -0,0 +1,505 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ShaderProgram.hpp"
+#include "ShaderStorageBuffer.hpp"
+#include "FontSprite.hpp"
+#include "FrameUniformBuffer.hpp"
+#include "GlyphAtlas.hpp"
+#include "WindowsUtilities.hpp"
+#include "GLStateCache.hpp"
+#include "GPUMemory.hpp"
+
+
+/// <summary>
+/// A single cached label's quad, matches the std430 layout of "LabelQuad" in LabelVertexShader.glsl
+/// </summary>
+struct LabelQuad
+{
+    /// <summary>
+    /// The top-left corner of the label, in screen space
+    /// </summary>
+    glm::vec2 Position;
+
+    /// <summary>
+    /// The label's size, in pixels
+    /// </summary>
+    glm::vec2 Size;
+
+    /// <summary>
+    /// Where the label is in the cache texture, left, top, right, bottom
+    /// </summary>
+    glm::vec4 TextureRect;
+};
+
+static_assert(sizeof(LabelQuad) == 32, "LabelQuad must match the std430 struct size");
+
+
+/// <summary>
+/// Text that rarely changes, drawn once into a region of a shared cache texture and from then on drawn as a single quad.
+/// A label is only drawn again when its text, colour or font changes, or when the cache runs out of room and starts over.
+/// Labels aren't wrapped, and are drawn into the cache with their font's own layout and transform otherwise ignored
+/// </summary>
+class LabelCache
+{
+
+private:
+
+    struct Label
+    {
+        FontSprite* Font = nullptr;
+
+        std::string Text;
+
+        glm::vec4 Colour = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+        /// <summary>
+        /// The size of the label's text, in pixels
+        /// </summary>
+        glm::uvec2 Size = { 0, 0 };
+
+        /// <summary>
+        /// The label's top-left corner in the cache texture, nothing if it has to be drawn into the cache again
+        /// </summary>
+        std::optional<glm::uvec2> Region;
+    };
+
+    std::vector<Label> _labels;
+
+
+    /// <summary>
+    /// A premultiplied RGBA8 texture every label is drawn into, and the framebuffer it's attached to
+    /// </summary>
+    std::uint32_t _cacheTextureID = 0;
+
+    std::uint32_t _framebufferID = 0;
+
+    std::uint32_t _cacheSize = 0;
+
+    SkylineAllocator _allocator;
+
+
+    /// <summary>
+    /// Maps the cache texture's pixels while labels are drawn into it
+    /// </summary>
+    FrameUniformBuffer _cacheFrameUniformBuffer;
+
+    /// <summary>
+    /// The frame's own data, bound again once labels were drawn into the cache
+    /// </summary>
+    std::reference_wrapper<const FrameUniformBuffer> _frameUniformBuffer;
+
+
+    /// <summary>
+    /// A program built from LabelVertexShader.glsl and LabelFragmentShader.glsl
+    /// </summary>
+    std::reference_wrapper<const ShaderProgram> _quadProgram;
+
+    std::uint32_t _vao = 0;
+
+    /// <summary>
+    /// The labels drawn since the last flush, by index
+    /// </summary>
+    std::vector<std::pair<std::size_t, glm::vec2>> _queuedLabels;
+
+    ShaderStorageBuffer _quadRingBuffer;
+
+    /// <summary>
+    /// How many times a label was drawn into the cache
+    /// </summary>
+    std::size_t _cacheDrawCount = 0;
+
+
+public:
+
+    /// <param name="quadProgram"> A program built from LabelVertexShader.glsl and LabelFragmentShader.glsl </param>
+    /// <param name="frameUniformBuffer"> The buffer the frame's draws read, bound again after labels were drawn into the cache </param>
+    /// <param name="cacheSize"> The width and height of the cache texture, the largest label that can be cached </param>
+    LabelCache(const ShaderProgram& quadProgram,
+               const FrameUniformBuffer& frameUniformBuffer,
+               const std::uint32_t cacheSize = 2048,
+               const std::size_t quadCapacity = 256) :
+        _cacheSize(cacheSize),
+        _allocator(cacheSize, cacheSize),
+        _frameUniformBuffer(frameUniformBuffer),
+        _quadProgram(quadProgram),
+        _quadRingBuffer(quadCapacity * sizeof(LabelQuad), FramesInFlight)
+    {
+        glCreateTextures(GL_TEXTURE_2D, 1, &_cacheTextureID);
+
+        // Labels are drawn at whole pixels, at the size they were cached at
+        glTextureParameteri(_cacheTextureID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(_cacheTextureID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glTextureParameteri(_cacheTextureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(_cacheTextureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glTextureStorage2D(_cacheTextureID, 1, GL_RGBA8, static_cast<int>(cacheSize), static_cast<int>(cacheSize));
+
+        GPUMemory.TrackTexture(_cacheTextureID, GetTextureSizeInBytes(cacheSize, cacheSize, 1, 1, 32), GPUMemoryCategory::Cache);
+
+
+        glCreateFramebuffers(1, &_framebufferID);
+        glNamedFramebufferTexture(_framebufferID, GL_COLOR_ATTACHMENT0, _cacheTextureID, 0);
+
+        wt::Assert(glCheckNamedFramebufferStatus(_framebufferID, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Label cache framebuffer is incomplete");
+
+
+        // y goes down in the cache's pixels like it does on screen, which puts a label's top row at its lowest t
+        _cacheFrameUniformBuffer.Update(FrameData
+        {
+            .ScreenSpaceProjection = glm::ortho(0.0f, static_cast<float>(cacheSize), 0.0f, static_cast<float>(cacheSize), -1.0f, 1.0f),
+            .ViewportSize = { static_cast<float>(cacheSize), static_cast<float>(cacheSize) },
+        });
+
+        // Constructing the cache's buffer bound it
+        frameUniformBuffer.Bind();
+
+
+        // Quads are generated from gl_VertexID, the VAO is empty but the core profile still requires one to draw
+        glCreateVertexArrays(1, &_vao);
+    };
+
+    LabelCache(const LabelCache&) = delete;
+    LabelCache& operator = (const LabelCache&) = delete;
+
+    ~LabelCache()
+    {
+        GLState.DeleteVertexArray(_vao);
+
+        glDeleteFramebuffers(1, &_framebufferID);
+
+        GLState.DeleteTexture(_cacheTextureID);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Create a label
+    /// </summary>
+    /// <param name="font"> Must outlive the cache </param>
+    /// <returns> The label's index </returns>
+    std::size_t CreateLabel(FontSprite& font, const std::string_view& text, const glm::vec4& colour = { 0.0f, 0.0f, 0.0f, 1.0f })
+    {
+        _labels.emplace_back();
+
+        SetLabel(_labels.size() - 1, font, text, colour);
+
+        return _labels.size() - 1;
+    };
+
+    /// <summary>
+    /// Change a label. It's only drawn into the cache again if anything actually changed
+    /// </summary>
+    void SetLabel(const std::size_t labelIndex, FontSprite& font, const std::string_view& text, const glm::vec4& colour)
+    {
+        Label& label = _labels[labelIndex];
+
+        if(label.Font == &font && label.Text == text && label.Colour == colour)
+            return;
+
+        label.Font = &font;
+        label.Text.assign(text);
+        label.Colour = colour;
+
+        label.Size = MeasureText(font, text);
+
+        wt::Assert(label.Size.x + 2 <= _cacheSize && label.Size.y + 2 <= _cacheSize, "A label is larger than the label cache");
+
+        // The old region is simply abandoned, it's reclaimed when the cache starts over
+        label.Region.reset();
+    };
+
+
+    /// <summary>
+    /// Queue a label to be drawn at a position, in screen space
+    /// </summary>
+    void Draw(const std::size_t labelIndex, const glm::vec2& position)
+    {
+        _queuedLabels.emplace_back(labelIndex, position);
+    };
+
+    /// <summary>
+    /// Draw every queued label into the cache that isn't in it yet, then draw all of them as quads with a single draw call
+    /// </summary>
+    void Flush()
+    {
+        if(_queuedLabels.empty() == true)
+            return;
+
+        CacheQueuedLabels();
+
+
+        const std::size_t drawSizeInBytes = _queuedLabels.size() * sizeof(LabelQuad);
+
+        std::byte* range = _quadRingBuffer.Allocate(drawSizeInBytes);
+
+        // If the current frame's region is out of space, grow the ring so the rest of the frame fits
+        if(range == nullptr)
+        {
+            _quadRingBuffer.Reallocate((_quadRingBuffer.GetRegionSizeInBytes() + drawSizeInBytes) * 2);
+
+            range = _quadRingBuffer.Allocate(drawSizeInBytes);
+        };
+
+
+        const float cacheSize = static_cast<float>(_cacheSize);
+
+        std::size_t quadCount = 0;
+
+        for(const auto& [labelIndex, position] : _queuedLabels)
+        {
+            const Label& label = _labels[labelIndex];
+
+            // Labels whose font isn't loaded yet can't be cached
+            if(label.Region.has_value() == false || label.Size.x == 0)
+                continue;
+
+            const glm::vec2 regionPosition = glm::vec2(*label.Region);
+            const glm::vec2 size = glm::vec2(label.Size);
+
+            const LabelQuad quad
+            {
+                .Position = position,
+                .Size = size,
+                .TextureRect = glm::vec4(regionPosition, regionPosition + size) / cacheSize,
+            };
+
+            // The mapping is write-only, quads are written whole and never read back
+            std::memcpy(range + (quadCount * sizeof(LabelQuad)), &quad, sizeof(quad));
+
+            ++quadCount;
+        };
+
+        _queuedLabels.clear();
+
+        if(quadCount == 0)
+            return;
+
+
+        _quadProgram.get().Bind();
+
+        GLState.BindTextureUnit(0, _cacheTextureID);
+
+        GLState.BindAttributelessVertexArray(_vao);
+
+        _quadRingBuffer.Bind();
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, GlyphQuadVertexCount, static_cast<std::int32_t>(quadCount));
+    };
+
+
+    /// <summary>
+    /// Signal that all of the current frame's flushes were issued
+    /// </summary>
+    void EndFrame() const
+    {
+        _quadRingBuffer.NextFrame();
+    };
+
+
+public:
+
+    glm::uvec2 GetLabelSize(const std::size_t labelIndex) const
+    {
+        return _labels[labelIndex].Size;
+    };
+
+    std::size_t GetLabelCount() const
+    {
+        return _labels.size();
+    };
+
+    /// <summary>
+    /// How many times a label was drawn into the cache, once per label unless labels change or the cache starts over
+    /// </summary>
+    std::size_t GetCacheDrawCount() const
+    {
+        return _cacheDrawCount;
+    };
+
+
+private:
+
+    /// <summary>
+    /// The number of frames the CPU can write ahead of the GPU
+    /// </summary>
+    static constexpr std::uint32_t FramesInFlight = 3;
+
+
+    /// <summary>
+    /// Draw the queued labels that aren't in the cache into it. If the cache is out of room it starts over
+    /// </summary>
+    void CacheQueuedLabels()
+    {
+        const bool anyUncached = std::any_of(_queuedLabels.cbegin(), _queuedLabels.cend(), [&](const std::pair<std::size_t, glm::vec2>& queuedLabel)
+        {
+            const Label& label = _labels[queuedLabel.first];
+
+            return label.Region.has_value() == false && label.Size.x != 0 && label.Font->IsReady() == true;
+        });
+
+        if(anyUncached == false)
+            return;
+
+
+        // Drawing into the cache is rare, so the state it changes is read back and restored rather than tracked
+        GLint previousFramebuffer = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+        GLint previousViewport[4] = { };
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+        // Blending goes through the state cache, the fonts change it too
+        const std::array<GLenum, 4> previousBlend = GLState.GetBlendFunc();
+
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _framebufferID);
+        glViewport(0, 0, static_cast<GLsizei>(_cacheSize), static_cast<GLsizei>(_cacheSize));
+
+        // Blending onto transparent black leaves premultiplied colour, which the quads are drawn with
+        GLState.BlendFuncSeparate({ GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA });
+
+        _cacheFrameUniformBuffer.Bind();
+
+
+        // If the cache runs out of room it starts over with only the queued labels, if even those don't fit the rest are skipped this frame
+        for(std::uint32_t attempt = 0; attempt < 2; ++attempt)
+        {
+            bool outOfRoom = false;
+
+            for(const auto& [labelIndex, position] : _queuedLabels)
+            {
+                Label& label = _labels[labelIndex];
+
+                if(label.Region.has_value() == true || label.Size.x == 0 || label.Font->IsReady() == false)
+                    continue;
+
+                // A pixel of space around every label, so filtering never reaches a neighbour
+                const std::optional<glm::uvec2> region = _allocator.Allocate(label.Size.x + 2, label.Size.y + 2);
+
+                if(region.has_value() == false)
+                {
+                    outOfRoom = true;
+                    break;
+                };
+
+                label.Region = *region + glm::uvec2(1, 1);
+
+                CacheLabel(label);
+            };
+
+            if(outOfRoom == false || attempt == 1)
+                break;
+
+            StartOver();
+        };
+
+
+        _frameUniformBuffer.get().Bind();
+
+        GLState.BlendFuncSeparate(previousBlend);
+
+        glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<std::uint32_t>(previousFramebuffer));
+    };
+
+    /// <summary>
+    /// Draw a label's text into its region of the cache
+    /// </summary>
+    void CacheLabel(const Label& label)
+    {
+        const glm::uvec2 region = *label.Region;
+
+        glClearTexSubImage(_cacheTextureID, 0,
+                           static_cast<int>(region.x) - 1, static_cast<int>(region.y) - 1, 0,
+                           static_cast<int>(label.Size.x) + 2, static_cast<int>(label.Size.y) + 2, 1,
+                           GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+
+        FontSprite& font = *label.Font;
+
+        const glm::mat4 previousTransform = font.Transform;
+        const float previousWrapWidth = font.Layout.WrapWidth;
+
+        font.Transform = glm::translate(glm::mat4(1.0f), { static_cast<float>(region.x), static_cast<float>(region.y), 0.0f });
+        font.Layout.WrapWidth = 0.0f;
+
+        font.Bind();
+        font.Draw(label.Text, label.Colour);
+
+        ++_cacheDrawCount;
+
+        font.Transform = previousTransform;
+        font.Layout.WrapWidth = previousWrapWidth;
+    };
+
+    /// <summary>
+    /// Forget every cached label, they're drawn into the cache again the next time they're drawn
+    /// </summary>
+    void StartOver()
+    {
+        _allocator.Reset();
+
+        for(Label& label : _labels)
+        {
+            label.Region.reset();
+        };
+    };
+
+
+    /// <summary>
+    /// The size of a text's glyphs laid out the way TextLayout does, without wrapping
+    /// </summary>
+    static glm::uvec2 MeasureText(const FontSprite& font, const std::string_view& text)
+    {
+        const std::uint32_t tabSize = std::max(font.Layout.TabSize, 1u);
+
+        std::uint32_t lineCount = 1;
+
+        std::uint32_t column = 0;
+        std::uint32_t longestLine = 0;
+
+        for(const char character : text)
+        {
+            if(character == '\n')
+            {
+                ++lineCount;
+                column = 0;
+
+                continue;
+            };
+
+            if(character == '\t')
+                column = ((column / tabSize) + 1) * tabSize;
+            else
+                ++column;
+
+            longestLine = std::max(longestLine, column);
+        };
+
+        if(longestLine == 0)
+            return { 0, 0 };
+
+        const float height = (static_cast<float>(lineCount - 1) * font.GetLineHeight()) + static_cast<float>(font.GetGlyphHeight());
+
+        return { longestLine * font.GetGlyphWidth(), static_cast<std::uint32_t>(height + 0.5f) };
+    };
+
+};
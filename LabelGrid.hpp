@@ -0,0 +1,488 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include "TextBatch.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// How a LabelGrid's world is shown on screen, a pan and a zoom
+/// </summary>
+struct LabelView
+{
+    /// <summary>
+    /// The world position at the screen's top-left corner
+    /// </summary>
+    glm::vec2 Origin = { 0.0f, 0.0f };
+
+    /// <summary>
+    /// Pixels per world unit
+    /// </summary>
+    float Scale = 1.0f;
+
+    /// <summary>
+    /// The screen's size, in pixels
+    /// </summary>
+    glm::vec2 ViewportSize = { 0.0f, 0.0f };
+
+
+    glm::vec2 WorldToScreen(const glm::vec2& worldPosition) const
+    {
+        return (worldPosition - Origin) * Scale;
+    };
+};
+
+
+/// <summary>
+/// Thousands of world-space labels, e.g. a map's or a graph's, kept in a uniform grid of world cells by their anchor.
+/// Every frame the cells the view covers are culled against it, the labels left are placed in priority order on a grid of screen cells,
+/// skipping those that would overlap one already placed, and the survivors go to a TextBatch as one draw.
+/// Labels keep their size on screen whatever the zoom, moving one within its cell only writes its position
+/// </summary>
+class LabelGrid
+{
+
+public:
+
+    using LabelID = std::uint32_t;
+
+    static constexpr LabelID InvalidLabel = std::numeric_limits<LabelID>::max();
+
+
+private:
+
+    struct Label
+    {
+        std::string Text;
+
+        /// <summary>
+        /// Where the label's top-left corner is, in world units
+        /// </summary>
+        glm::vec2 Position = { 0.0f, 0.0f };
+
+        /// <summary>
+        /// The label's size on screen, in pixels
+        /// </summary>
+        glm::vec2 Size = { 0.0f, 0.0f };
+
+        glm::vec4 Colour = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+        std::uint32_t FontIndex = 0;
+
+        /// <summary>
+        /// Higher priority labels are placed first, and win overlaps
+        /// </summary>
+        float Priority = 0.0f;
+
+        std::uint64_t CellKey = 0;
+
+        bool Alive = false;
+    };
+
+    std::vector<Label> _labels;
+
+    std::vector<LabelID> _freeLabels;
+
+    /// <summary>
+    /// The labels whose anchor is in each world cell, by the cell's packed coordinates
+    /// </summary>
+    std::unordered_map<std::uint64_t, std::vector<LabelID>> _cells;
+
+    float _cellSize = 0.0f;
+
+    /// <summary>
+    /// The largest label size added, culling reaches this far past the view so labels anchored off screen but reaching onto it are kept
+    /// </summary>
+    glm::vec2 _largestLabelSize = { 0.0f, 0.0f };
+
+
+    /// <summary>
+    /// The last cull's labels, and which of them were placed
+    /// </summary>
+    std::vector<LabelID> _visibleLabels;
+
+    std::vector<LabelID> _placedLabels;
+
+    std::vector<glm::vec4> _placedRects;
+
+    /// <summary>
+    /// The indices into _placedRects that overlap each screen cell, reused between frames
+    /// </summary>
+    std::vector<std::vector<std::uint32_t>> _screenCells;
+
+
+public:
+
+    /// <summary>
+    /// Whether labels that overlap a higher priority one are left out
+    /// </summary>
+    bool RejectOverlaps = true;
+
+    /// <summary>
+    /// Space kept clear around every placed label, in pixels
+    /// </summary>
+    float OverlapMargin = 2.0f;
+
+
+public:
+
+    /// <param name="cellSize"> The world cells' size, in world units. Around the typical distance between labels works best </param>
+    LabelGrid(const float cellSize = 256.0f) :
+        _cellSize(cellSize)
+    {
+        wt::Assert(cellSize > 0.0f, "Label grid cells must have a size");
+    };
+
+
+public:
+
+    /// <summary>
+    /// Add a label
+    /// </summary>
+    /// <param name="position"> The label's top-left corner, in world units </param>
+    /// <param name="size"> The label's size on screen, in pixels, e.g. from TextMetrics </param>
+    LabelID Add(const std::string_view& text, const glm::vec2& position, const glm::vec2& size, const glm::vec4& colour = { 0.0f, 0.0f, 0.0f, 1.0f }, const std::uint32_t fontIndex = 0, const float priority = 0.0f)
+    {
+        LabelID id = InvalidLabel;
+
+        if(_freeLabels.empty() == false)
+        {
+            id = _freeLabels.back();
+            _freeLabels.pop_back();
+        }
+        else
+        {
+            id = static_cast<LabelID>(_labels.size());
+            _labels.emplace_back();
+        };
+
+        Label& label = _labels[id];
+
+        label = Label
+        {
+            .Text = std::string(text),
+            .Position = position,
+            .Size = size,
+            .Colour = colour,
+            .FontIndex = fontIndex,
+            .Priority = priority,
+            .CellKey = GetCellKey(position),
+            .Alive = true,
+        };
+
+        _cells[label.CellKey].emplace_back(id);
+
+        _largestLabelSize = glm::max(_largestLabelSize, size);
+
+        return id;
+    };
+
+    void Remove(const LabelID id)
+    {
+        Label& label = GetLabel(id);
+
+        RemoveFromCell(label.CellKey, id);
+
+        label.Alive = false;
+        label.Text.clear();
+
+        _freeLabels.emplace_back(id);
+    };
+
+    /// <summary>
+    /// Move a label, only its position is written unless it leaves its cell
+    /// </summary>
+    void Move(const LabelID id, const glm::vec2& position)
+    {
+        Label& label = GetLabel(id);
+
+        label.Position = position;
+
+        const std::uint64_t cellKey = GetCellKey(position);
+
+        if(cellKey == label.CellKey)
+            return;
+
+        RemoveFromCell(label.CellKey, id);
+
+        _cells[cellKey].emplace_back(id);
+
+        label.CellKey = cellKey;
+    };
+
+    void SetText(const LabelID id, const std::string_view& text, const glm::vec2& size)
+    {
+        Label& label = GetLabel(id);
+
+        label.Text.assign(text);
+        label.Size = size;
+
+        _largestLabelSize = glm::max(_largestLabelSize, size);
+    };
+
+    void SetPriority(const LabelID id, const float priority)
+    {
+        GetLabel(id).Priority = priority;
+    };
+
+    void SetColour(const LabelID id, const glm::vec4& colour)
+    {
+        GetLabel(id).Colour = colour;
+    };
+
+
+    /// <summary>
+    /// Find the labels on screen, then place them, leaving out overlapped ones if RejectOverlaps is set
+    /// </summary>
+    /// <returns> The placed labels, highest priority first, valid until the next call </returns>
+    const std::vector<LabelID>& Cull(const LabelView& view)
+    {
+        CullToView(view);
+
+        PlaceLabels(view);
+
+        return _placedLabels;
+    };
+
+    /// <summary>
+    /// Cull and place the labels, and submit the placed ones to a batch, whose transform should be the identity.
+    /// Flushing the batch is left to the caller, so the labels can share a draw with other text
+    /// </summary>
+    void Submit(TextBatch& batch, const LabelView& view)
+    {
+        Cull(view);
+
+        for(const LabelID id : _placedLabels)
+        {
+            const Label& label = _labels[id];
+
+            batch.Submit(label.Text, view.WorldToScreen(label.Position), label.Colour, label.FontIndex);
+        };
+    };
+
+
+public:
+
+    std::size_t GetLabelCount() const
+    {
+        return _labels.size() - _freeLabels.size();
+    };
+
+    /// <summary>
+    /// How many labels the last cull found on screen, placed or not
+    /// </summary>
+    std::size_t GetVisibleCount() const
+    {
+        return _visibleLabels.size();
+    };
+
+    /// <summary>
+    /// How many labels the last cull placed
+    /// </summary>
+    std::size_t GetPlacedCount() const
+    {
+        return _placedLabels.size();
+    };
+
+
+private:
+
+    Label& GetLabel(const LabelID id)
+    {
+        wt::Assert(id < _labels.size() && _labels[id].Alive == true, "Label doesn't exist");
+
+        return _labels[id];
+    };
+
+
+    std::int32_t GetCellCoordinate(const float worldCoordinate) const
+    {
+        return static_cast<std::int32_t>(std::floor(worldCoordinate / _cellSize));
+    };
+
+    static std::uint64_t PackCellKey(const std::int32_t x, const std::int32_t y)
+    {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+    };
+
+    std::uint64_t GetCellKey(const glm::vec2& position) const
+    {
+        return PackCellKey(GetCellCoordinate(position.x), GetCellCoordinate(position.y));
+    };
+
+    void RemoveFromCell(const std::uint64_t cellKey, const LabelID id)
+    {
+        const auto cell = _cells.find(cellKey);
+
+        std::vector<LabelID>& cellLabels = cell->second;
+
+        // Order within a cell doesn't matter, so the last label takes the removed one's place
+        *std::find(cellLabels.begin(), cellLabels.end(), id) = cellLabels.back();
+        cellLabels.pop_back();
+
+        if(cellLabels.empty() == true)
+            _cells.erase(cell);
+    };
+
+
+    /// <summary>
+    /// Collect the labels whose screen rectangle meets the viewport
+    /// </summary>
+    void CullToView(const LabelView& view)
+    {
+        _visibleLabels.clear();
+
+        if(view.Scale <= 0.0f)
+            return;
+
+        // Labels keep their pixel size, so the largest one reaches further into the world the further out the view is zoomed
+        const glm::vec2 viewMinimum = view.Origin - (_largestLabelSize / view.Scale);
+        const glm::vec2 viewMaximum = view.Origin + (view.ViewportSize / view.Scale);
+
+        const std::int32_t firstColumn = GetCellCoordinate(viewMinimum.x);
+        const std::int32_t lastColumn = GetCellCoordinate(viewMaximum.x);
+        const std::int32_t firstRow = GetCellCoordinate(viewMinimum.y);
+        const std::int32_t lastRow = GetCellCoordinate(viewMaximum.y);
+
+        const auto collectCell = [&](const std::vector<LabelID>& cellLabels)
+        {
+            for(const LabelID id : cellLabels)
+            {
+                const Label& label = _labels[id];
+
+                const glm::vec2 screenPosition = view.WorldToScreen(label.Position);
+
+                if(screenPosition.x + label.Size.x <= 0.0f || screenPosition.y + label.Size.y <= 0.0f ||
+                   screenPosition.x >= view.ViewportSize.x || screenPosition.y >= view.ViewportSize.y)
+                    continue;
+
+                _visibleLabels.emplace_back(id);
+            };
+        };
+
+        // Zoomed far out the view covers more cells than there are occupied ones, walking the occupied cells is then cheaper
+        const std::uint64_t viewCellCount = static_cast<std::uint64_t>(lastColumn - firstColumn + 1) * static_cast<std::uint64_t>(lastRow - firstRow + 1);
+
+        if(viewCellCount > _cells.size())
+        {
+            for(const auto& [cellKey, cellLabels] : _cells)
+            {
+                collectCell(cellLabels);
+            };
+
+            return;
+        };
+
+        for(std::int32_t row = firstRow; row <= lastRow; ++row)
+        {
+            for(std::int32_t column = firstColumn; column <= lastColumn; ++column)
+            {
+                if(const auto cell = _cells.find(PackCellKey(column, row)); cell != _cells.end())
+                    collectCell(cell->second);
+            };
+        };
+    };
+
+    /// <summary>
+    /// Place the visible labels highest priority first, each only if it doesn't overlap one placed before it.
+    /// Placed rectangles are binned into screen cells as large as the largest label, so each test only looks at the few placed labels nearby
+    /// </summary>
+    void PlaceLabels(const LabelView& view)
+    {
+        _placedLabels.clear();
+        _placedRects.clear();
+
+        // Ties keep the order labels were added in, so equal labels don't flicker as the view moves
+        std::sort(_visibleLabels.begin(), _visibleLabels.end(), [&](const LabelID left, const LabelID right)
+        {
+            const float leftPriority = _labels[left].Priority;
+            const float rightPriority = _labels[right].Priority;
+
+            return leftPriority != rightPriority ? leftPriority > rightPriority : left < right;
+        });
+
+        if(RejectOverlaps == false)
+        {
+            _placedLabels.assign(_visibleLabels.cbegin(), _visibleLabels.cend());
+
+            return;
+        };
+
+
+        const glm::vec2 screenCellSize = glm::max(_largestLabelSize + (OverlapMargin * 2.0f), glm::vec2(1.0f, 1.0f));
+
+        const std::int32_t columns = std::max(static_cast<std::int32_t>(std::ceil(view.ViewportSize.x / screenCellSize.x)), 1);
+        const std::int32_t rows = std::max(static_cast<std::int32_t>(std::ceil(view.ViewportSize.y / screenCellSize.y)), 1);
+
+        _screenCells.resize(static_cast<std::size_t>(columns * rows));
+
+        for(std::vector<std::uint32_t>& screenCell : _screenCells)
+        {
+            screenCell.clear();
+        };
+
+
+        for(const LabelID id : _visibleLabels)
+        {
+            const Label& label = _labels[id];
+
+            const glm::vec2 screenPosition = view.WorldToScreen(label.Position);
+
+            const glm::vec4 rect = { screenPosition - OverlapMargin, screenPosition + label.Size + OverlapMargin };
+
+            // Labels reaching past the screen's edges are binned into the edge cells
+            const std::int32_t firstColumn = std::clamp(static_cast<std::int32_t>(std::floor(rect.x / screenCellSize.x)), 0, columns - 1);
+            const std::int32_t lastColumn = std::clamp(static_cast<std::int32_t>(std::floor(rect.z / screenCellSize.x)), 0, columns - 1);
+            const std::int32_t firstRow = std::clamp(static_cast<std::int32_t>(std::floor(rect.y / screenCellSize.y)), 0, rows - 1);
+            const std::int32_t lastRow = std::clamp(static_cast<std::int32_t>(std::floor(rect.w / screenCellSize.y)), 0, rows - 1);
+
+            bool overlaps = false;
+
+            for(std::int32_t row = firstRow; row <= lastRow && overlaps == false; ++row)
+            {
+                for(std::int32_t column = firstColumn; column <= lastColumn && overlaps == false; ++column)
+                {
+                    for(const std::uint32_t placedIndex : _screenCells[static_cast<std::size_t>((row * columns) + column)])
+                    {
+                        const glm::vec4& placedRect = _placedRects[placedIndex];
+
+                        if(rect.x < placedRect.z && placedRect.x < rect.z && rect.y < placedRect.w && placedRect.y < rect.w)
+                        {
+                            overlaps = true;
+                            break;
+                        };
+                    };
+                };
+            };
+
+            if(overlaps == true)
+                continue;
+
+
+            const std::uint32_t placedIndex = static_cast<std::uint32_t>(_placedRects.size());
+
+            _placedRects.emplace_back(rect);
+            _placedLabels.emplace_back(id);
+
+            for(std::int32_t row = firstRow; row <= lastRow; ++row)
+            {
+                for(std::int32_t column = firstColumn; column <= lastColumn; ++column)
+                {
+                    _screenCells[static_cast<std::size_t>((row * columns) + column)].emplace_back(placedIndex);
+                };
+            };
+        };
+    };
+
+};
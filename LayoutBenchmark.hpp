@@ -0,0 +1,339 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/vec4.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "AllocationTracking.hpp"
+#include "DynamicSSBO.hpp"
+#include "GLStateCache.hpp"
+
+
+/// <summary>
+/// The averaged measurements of one DynamicSSBO operation
+/// </summary>
+struct LayoutBenchmarkResult
+{
+    std::string Name;
+
+    /// <summary>
+    /// The size of the layout the operation ran on, what "element" means depends on the operation
+    /// </summary>
+    std::size_t ElementCount = 0;
+
+    /// <summary>
+    /// How many times the operation ran in the measured batch
+    /// </summary>
+    std::uint64_t Operations = 0;
+
+    double NanosecondsPerOperation = 0.0;
+
+    /// <summary>
+    /// Heap allocations made by the operation on the benchmark's thread, see AllocationTracking.hpp
+    /// </summary>
+    double AllocationsPerOperation = 0.0;
+
+    double BytesAllocatedPerOperation = 0.0;
+};
+
+
+/// <summary>
+/// Microbenchmarks of the CPU side of DynamicSSBO: laying out raw layouts, looking elements up, and writing them.
+/// Each operation is repeated in doubling batches until a batch runs long enough to time, and that batch is reported.
+/// Setting elements through glNamedBufferSubData needs a current context, a hidden window is enough
+/// </summary>
+class LayoutBenchmark
+{
+
+private:
+
+    /// <summary>
+    /// A batch has to run at least this long to be reported
+    /// </summary>
+    std::chrono::nanoseconds _minimumBatchDuration;
+
+    /// <summary>
+    /// Every operation's result is added in, so the compiler can't drop an operation whose result is unused
+    /// </summary>
+    mutable std::uint64_t _sink = 0;
+
+
+public:
+
+    LayoutBenchmark(const std::chrono::nanoseconds minimumBatchDuration = std::chrono::milliseconds(200)) :
+        _minimumBatchDuration(minimumBatchDuration)
+    {
+    };
+
+
+public:
+
+    std::vector<LayoutBenchmarkResult> Run() const
+    {
+        std::vector<LayoutBenchmarkResult> results;
+
+        // Laying out a scalar array is a single node no matter its size
+        for(const std::size_t elementCount : { 1, 10, 100, 1'000, 10'000, 100'000, 1'000'000 })
+        {
+            results.emplace_back(Measure("Construct scalar array", elementCount, [elementCount](std::uint64_t)
+            {
+                return CreateScalarArrayLayout(elementCount).GetSizeInBytes();
+            }));
+        };
+
+        // A struct array gets a node per element and member, so the largest sizes are left out
+        for(const std::size_t elementCount : { 1, 10, 100, 1'000, 10'000, 100'000 })
+        {
+            results.emplace_back(Measure("Construct struct array", elementCount, [elementCount](std::uint64_t)
+            {
+                return CreateStructArrayLayout(elementCount).GetSizeInBytes();
+            }));
+        };
+
+        for(const std::size_t elementCount : { 1, 10, 100, 1'000, 10'000 })
+        {
+            results.emplace_back(Measure("Construct nested struct array", elementCount, [elementCount](std::uint64_t)
+            {
+                return CreateNestedStructArrayLayout(elementCount).GetSizeInBytes();
+            }));
+        };
+
+
+        // Members are found by walking the struct's children, the last member is the slowest to find
+        for(const std::size_t memberCount : { 1, 8, 64 })
+        {
+            const SSBOLayout layout = CreateScalarMembersLayout(memberCount);
+
+            const std::string lastMember = GetMemberName(memberCount - 1);
+
+            results.emplace_back(Measure("Get by name", memberCount, [&layout, &lastMember](std::uint64_t)
+            {
+                return layout.Get<ScalarElement>(lastMember).GetOffset();
+            }));
+
+            results.emplace_back(Measure("GetHandle by name", memberCount, [&layout, &lastMember](std::uint64_t)
+            {
+                return layout.GetHandle(lastMember).Offset;
+            }));
+        };
+
+
+        {
+            constexpr std::size_t elementCount = 1'000'000;
+
+            const SSBOLayout layout = CreateScalarArrayLayout(elementCount);
+
+            const ArrayElement values = layout.Get<ArrayElement>("Values");
+
+            results.emplace_back(Measure("GetAtIndex scalar", elementCount, [&values](const std::uint64_t operation)
+            {
+                return values.GetAtIndex<ScalarElement>(SpreadIndex(operation, elementCount)).GetOffset();
+            }));
+        };
+
+        {
+            constexpr std::size_t elementCount = 100'000;
+
+            const SSBOLayout layout = CreateStructArrayLayout(elementCount);
+
+            const ArrayElement values = layout.Get<ArrayElement>("Values");
+
+            results.emplace_back(Measure("GetAtIndex struct member", elementCount, [&values](const std::uint64_t operation)
+            {
+                return values.GetAtIndex<StructElement>(SpreadIndex(operation, elementCount)).Get<ScalarElement>("Colour").GetOffset();
+            }));
+        };
+
+
+        {
+            const SSBOLayout layout = CreateScalarMembersLayout(8);
+
+            const ScalarElement element = layout.Get<ScalarElement>(GetMemberName(7));
+
+            std::vector<std::byte> memory(layout.GetSizeInBytes());
+
+            results.emplace_back(Measure("ScalarElement::Write", 1, [&element, &memory](const std::uint64_t operation)
+            {
+                element.Write(memory.data(), static_cast<std::uint32_t>(operation));
+
+                return std::to_integer<std::uint64_t>(memory[0]);
+            }));
+
+
+            std::uint32_t bufferID = 0;
+
+            glCreateBuffers(1, &bufferID);
+            glNamedBufferStorage(bufferID, static_cast<GLsizeiptr>(layout.GetSizeInBytes()), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+            // Only allocations on this thread are counted, the driver's own are not
+            results.emplace_back(Measure("ScalarElement::Set", 1, [&element, bufferID](const std::uint64_t operation)
+            {
+                element.Set(bufferID, static_cast<std::uint32_t>(operation));
+
+                return operation;
+            }));
+
+            glFinish();
+
+            GLState.DeleteBuffer(bufferID);
+        };
+
+        return results;
+    };
+
+
+private:
+
+    template<typename TOperation>
+    LayoutBenchmarkResult Measure(const std::string& name, const std::size_t elementCount, TOperation&& operation) const
+    {
+        // A cap for operations too fast for the clock, so a batch can't run for ever
+        constexpr std::uint64_t maxOperations = std::uint64_t(1) << 32;
+
+        std::uint64_t operations = 1;
+
+        while(true)
+        {
+            const AllocationCounts allocationsBegin = GetThreadAllocationCounts();
+            const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+            for(std::uint64_t index = 0; index < operations; ++index)
+            {
+                _sink += static_cast<std::uint64_t>(operation(index));
+            };
+
+            const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - begin;
+            const AllocationCounts allocations = GetThreadAllocationCounts() - allocationsBegin;
+
+            if(elapsed >= _minimumBatchDuration || operations >= maxOperations)
+            {
+                const double operationCount = static_cast<double>(operations);
+
+                return LayoutBenchmarkResult
+                {
+                    .Name = name,
+                    .ElementCount = elementCount,
+                    .Operations = operations,
+                    .NanosecondsPerOperation = static_cast<double>(elapsed.count()) / operationCount,
+                    .AllocationsPerOperation = static_cast<double>(allocations.Count) / operationCount,
+                    .BytesAllocatedPerOperation = static_cast<double>(allocations.Bytes) / operationCount,
+                };
+            };
+
+            operations *= 2;
+        };
+    };
+
+
+    /// <summary>
+    /// Walk an array out of order, so lookups don't only ever hit the same cache lines
+    /// </summary>
+    static std::size_t SpreadIndex(const std::uint64_t operation, const std::size_t elementCount)
+    {
+        return static_cast<std::size_t>((operation * 7919) % elementCount);
+    };
+
+    static std::string GetMemberName(const std::size_t index)
+    {
+        return std::string("Member").append(std::to_string(index));
+    };
+
+
+    /// <summary>
+    /// "uint Values[elementCount]"
+    /// </summary>
+    static SSBOLayout CreateScalarArrayLayout(const std::size_t elementCount)
+    {
+        RawLayout rawLayout;
+
+        rawLayout.Add<ArrayElement, DataType::Array>("Values").SetArray(DataType::UInt32, elementCount);
+
+        return SSBOLayout(rawLayout);
+    };
+
+    /// <summary>
+    /// "struct { uint Index; vec4 Colour; } Values[elementCount]"
+    /// </summary>
+    static SSBOLayout CreateStructArrayLayout(const std::size_t elementCount)
+    {
+        RawLayout rawLayout;
+
+        const StructElement valueType = rawLayout.Add<ArrayElement, DataType::Array>("Values").SetCustomArrayType(elementCount);
+
+        valueType.Add<ScalarElement, DataType::UInt32>("Index");
+        valueType.Add<ScalarElement, DataType::Vec4f>("Colour");
+
+        return SSBOLayout(rawLayout);
+    };
+
+    /// <summary>
+    /// "struct { uint Index; struct { vec2 Position; uint Colour; } Points[4]; } Values[elementCount]"
+    /// </summary>
+    static SSBOLayout CreateNestedStructArrayLayout(const std::size_t elementCount)
+    {
+        RawLayout rawLayout;
+
+        const StructElement valueType = rawLayout.Add<ArrayElement, DataType::Array>("Values").SetCustomArrayType(elementCount);
+
+        valueType.Add<ScalarElement, DataType::UInt32>("Index");
+
+        const StructElement pointType = valueType.Add<ArrayElement, DataType::Array>("Points").SetCustomArrayType(4);
+
+        pointType.Add<ScalarElement, DataType::Vec2f>("Position");
+        pointType.Add<ScalarElement, DataType::UInt32>("Colour");
+
+        return SSBOLayout(rawLayout);
+    };
+
+    /// <summary>
+    /// memberCount uint members, "Member0" to "Member{memberCount - 1}"
+    /// </summary>
+    static SSBOLayout CreateScalarMembersLayout(const std::size_t memberCount)
+    {
+        RawLayout rawLayout;
+
+        for(std::size_t index = 0; index < memberCount; ++index)
+        {
+            rawLayout.Add<ScalarElement, DataType::UInt32>(GetMemberName(index));
+        };
+
+        return SSBOLayout(rawLayout);
+    };
+
+};
+
+
+/// <summary>
+/// Write results as a JSON array, one object per operation and size
+/// </summary>
+inline void WriteLayoutBenchmarkResultsJSON(std::ostream& stream, const std::vector<LayoutBenchmarkResult>& results)
+{
+    stream << "[\n";
+
+    for(std::size_t index = 0; index < results.size(); ++index)
+    {
+        const LayoutBenchmarkResult& result = results[index];
+
+        char line[384] = { };
+
+        std::snprintf(line, sizeof(line),
+                      "  { \"name\": \"%s\", \"elements\": %zu, \"operations\": %llu, \"nsPerOperation\": %.2f, \"allocationsPerOperation\": %.3f, \"bytesAllocatedPerOperation\": %.1f }%s\n",
+                      result.Name.c_str(),
+                      result.ElementCount,
+                      static_cast<unsigned long long>(result.Operations),
+                      result.NanosecondsPerOperation,
+                      result.AllocationsPerOperation,
+                      result.BytesAllocatedPerOperation,
+                      index + 1 < results.size() ? "," : "");
+
+        stream << line;
+    };
+
+    stream << "]\n";
+};
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BufferLayout.hpp"
+#include "DynamicSSBO.hpp"
+#include "MappedFile.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The 64-bit FNV-1a hash a layout descriptor names its fields by.
+/// Hashing continues from "hash", so a name's hash can be extended, as in the hash of "Characters[0]" from that of "Characters"
+/// </summary>
+constexpr std::uint64_t HashLayoutName(const std::string_view& name, std::uint64_t hash = 0xCBF29CE484222325ull)
+{
+    for(const char character : name)
+    {
+        hash ^= static_cast<std::uint8_t>(character);
+        hash *= 0x100000001B3ull;
+    };
+
+    return hash;
+};
+
+
+/// <summary>
+/// The start of a layout descriptor, followed by FieldCount LayoutDescriptorFields
+/// </summary>
+struct LayoutDescriptorHeader
+{
+    std::uint32_t Magic;
+    std::uint32_t Version;
+
+    std::uint32_t FieldCount;
+    std::uint32_t Padding;
+
+    /// <summary>
+    /// The layout's size without its trailing unsized array
+    /// </summary>
+    std::uint64_t SizeInBytes;
+
+    /// <summary>
+    /// The element stride of the trailing unsized array, 0 if the layout doesn't end with one
+    /// </summary>
+    std::uint64_t TrailingArrayStride;
+};
+
+static_assert(sizeof(LayoutDescriptorHeader) == 32, "LayoutDescriptorHeader is part of the descriptor format");
+
+
+/// <summary>
+/// A single field of a layout descriptor, a BufferLayoutField with its name hashed
+/// </summary>
+struct LayoutDescriptorField
+{
+    std::uint64_t NameHash;
+
+    std::uint32_t Offset;
+
+    /// <summary>
+    /// 1 for single values, 0 for unsized arrays
+    /// </summary>
+    std::uint32_t Count;
+
+    std::uint32_t Stride;
+
+    /// <summary>
+    /// A DataType
+    /// </summary>
+    std::uint32_t Type;
+};
+
+static_assert(sizeof(LayoutDescriptorField) == 24, "LayoutDescriptorField is part of the descriptor format");
+
+
+/// <summary>
+/// A buffer layout prebuilt into a flat binary table, fields sorted by the hash of their name.
+/// Loading one is a header check, the table is used in place, so buffers created from it skip both the program's block reflection
+/// and laying the layout out. Descriptors live in cache files next to the program binaries, or in bytes embedded in the executable.
+/// See WriteLayoutDescriptor, and ShaderStorageBuffer's constructor that takes one
+/// </summary>
+class LayoutDescriptor
+{
+
+public:
+
+    static constexpr std::uint32_t Magic = 0x59414C53; // "SLAY"
+
+    static constexpr std::uint32_t Version = 1;
+
+    static constexpr std::wstring_view Extension = L".layout";
+
+
+private:
+
+    /// <summary>
+    /// (Loaded from a file) Keeps the mapping the fields are read from alive
+    /// </summary>
+    std::shared_ptr<const MappedFile> _file;
+
+    LayoutDescriptorHeader _header = { };
+
+    std::span<const LayoutDescriptorField> _fields;
+
+    bool _valid = false;
+
+
+public:
+
+    /// <summary>
+    /// Use a descriptor in memory, e.g. embedded in the executable. The bytes must outlive the descriptor, and be 8-byte aligned
+    /// </summary>
+    LayoutDescriptor(const std::span<const std::byte>& bytes)
+    {
+        Read(bytes);
+    };
+
+    /// <summary>
+    /// Map a descriptor file. Files that are missing or out of date are simply invalid, so they can be rebuilt
+    /// </summary>
+    LayoutDescriptor(const std::filesystem::path& path) :
+        _file(std::make_shared<const MappedFile>(path, false))
+    {
+        Read(_file->GetBytes());
+    };
+
+
+public:
+
+    bool IsValid() const
+    {
+        return _valid;
+    };
+
+    /// <summary>
+    /// Look a field up by name, as in "TextColour", "Characters" or "Glyphs[0].Position"
+    /// </summary>
+    /// <returns> The field, or null if the layout has none by that name </returns>
+    const LayoutDescriptorField* Find(const std::string_view& name) const
+    {
+        return Find(HashLayoutName(name));
+    };
+
+    const LayoutDescriptorField* Find(const std::uint64_t nameHash) const
+    {
+        const auto field = std::lower_bound(_fields.begin(), _fields.end(), nameHash, [](const LayoutDescriptorField& field, const std::uint64_t hash)
+        {
+            return field.NameHash < hash;
+        });
+
+        return field != _fields.end() && field->NameHash == nameHash ? &*field : nullptr;
+    };
+
+    std::span<const LayoutDescriptorField> GetFields() const
+    {
+        return _fields;
+    };
+
+    std::size_t GetSizeInBytes() const
+    {
+        return static_cast<std::size_t>(_header.SizeInBytes);
+    };
+
+    /// <summary>
+    /// The size of a buffer holding this layout, with a given element count for the trailing unsized array
+    /// </summary>
+    std::size_t GetSizeInBytes(const std::size_t trailingArrayElementCount) const
+    {
+        return static_cast<std::size_t>(_header.SizeInBytes + (trailingArrayElementCount * _header.TrailingArrayStride));
+    };
+
+
+private:
+
+    void Read(const std::span<const std::byte>& bytes)
+    {
+        if(bytes.size() < sizeof(LayoutDescriptorHeader))
+            return;
+
+        std::memcpy(&_header, bytes.data(), sizeof(LayoutDescriptorHeader));
+
+        _valid = _header.Magic == Magic &&
+                 _header.Version == Version &&
+                 (bytes.size() - sizeof(LayoutDescriptorHeader)) / sizeof(LayoutDescriptorField) >= _header.FieldCount;
+
+        if(_valid == false)
+            return;
+
+        wt::Assert(reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(LayoutDescriptorField) == 0, "Layout descriptors must be 8-byte aligned");
+
+        // The table is used where it is, nothing is copied or parsed
+        _fields = std::span<const LayoutDescriptorField>(reinterpret_cast<const LayoutDescriptorField*>(bytes.data() + sizeof(LayoutDescriptorHeader)), _header.FieldCount);
+    };
+
+};
+
+
+/// <summary>
+/// Write a layout's descriptor
+/// </summary>
+/// <param name="layout"> The layout's fields, usually built from an SSBOLayout or a program's reflected block </param>
+/// <param name="sizeInBytes"> The layout's size without its trailing unsized array </param>
+inline void WriteLayoutDescriptor(std::ostream& stream, const BufferLayout& layout, const std::size_t sizeInBytes)
+{
+    std::vector<LayoutDescriptorField> fields;
+
+    fields.reserve(layout.GetFields().size());
+
+    std::uint64_t trailingArrayStride = 0;
+
+    for(const BufferLayoutField& field : layout.GetFields())
+    {
+        fields.push_back(LayoutDescriptorField
+        {
+            .NameHash = HashLayoutName(field.Name),
+            .Offset = static_cast<std::uint32_t>(field.Offset),
+            .Count = static_cast<std::uint32_t>(field.Count),
+            .Stride = static_cast<std::uint32_t>(field.Stride),
+            .Type = static_cast<std::uint32_t>(field.Type),
+        });
+
+        if(field.Count == 0)
+            trailingArrayStride = field.Stride;
+    };
+
+    std::sort(fields.begin(), fields.end(), [](const LayoutDescriptorField& left, const LayoutDescriptorField& right)
+    {
+        return left.NameHash < right.NameHash;
+    });
+
+    wt::Assert(std::adjacent_find(fields.begin(), fields.end(), [](const LayoutDescriptorField& left, const LayoutDescriptorField& right)
+    {
+        return left.NameHash == right.NameHash;
+    }) == fields.end(), "Two layout fields have the same name hash");
+
+    const LayoutDescriptorHeader header = LayoutDescriptorHeader
+    {
+        .Magic = LayoutDescriptor::Magic,
+        .Version = LayoutDescriptor::Version,
+        .FieldCount = static_cast<std::uint32_t>(fields.size()),
+        .Padding = 0,
+        .SizeInBytes = sizeInBytes,
+        .TrailingArrayStride = trailingArrayStride,
+    };
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(fields.data()), static_cast<std::streamsize>(fields.size() * sizeof(LayoutDescriptorField)));
+};
+
+inline void WriteLayoutDescriptor(std::ostream& stream, const SSBOLayout& layout)
+{
+    WriteLayoutDescriptor(stream, BufferLayout::FromSSBOLayout(layout), layout.GetSizeInBytes());
+};
@@ -0,0 +1,418 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BufferLayout.hpp"
+#include "DynamicSSBO.hpp"
+#include "GLStateCache.hpp"
+#include "SSBOReflection.hpp"
+
+
+/// <summary>
+/// Checks SSBOLayout's std430 offsets against the driver's on randomly generated layouts.
+/// Every layout is built twice, as a RawLayout and as the GLSL block it describes, the block is compiled into a compute program
+/// and its reflection compared to the laid out RawLayout, as ValidateBufferLayout does for the real blocks.
+/// Needs a current context, a hidden window is enough
+/// </summary>
+class SSBOLayoutFuzzer
+{
+
+private:
+
+    /// <summary>
+    /// Layout i is generated from seed + i, so a failing layout can be run again on its own
+    /// </summary>
+    std::uint32_t _seed = 0;
+
+    /// <summary>
+    /// The deepest structs can nest
+    /// </summary>
+    std::uint32_t _maxDepth = 3;
+
+    std::uint32_t _maxMembers = 6;
+
+
+    std::mt19937 _random;
+
+    /// <summary>
+    /// The struct declarations of the layout being generated, inner structs come first
+    /// </summary>
+    std::string _structDeclarations;
+
+    /// <summary>
+    /// An expression per scalar of the layout, the shader reads every one of them so the driver keeps the whole block
+    /// </summary>
+    std::vector<std::string> _reads;
+
+    std::uint32_t _nextStructID = 0;
+    std::uint32_t _nextMemberID = 0;
+
+
+public:
+
+    SSBOLayoutFuzzer(const std::uint32_t seed, const std::uint32_t maxDepth = 3, const std::uint32_t maxMembers = 6) :
+        _seed(seed),
+        _maxDepth(maxDepth),
+        _maxMembers(maxMembers)
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// Generate and check layouts, every mismatch is written to the console with the block's GLSL
+    /// </summary>
+    /// <param name="layoutCount"> The number of layouts to check </param>
+    /// <returns> The number of layouts that didn't match the driver's, or didn't compile </returns>
+    std::size_t Run(const std::size_t layoutCount)
+    {
+        std::size_t failedCount = 0;
+
+        for(std::size_t index = 0; index < layoutCount; ++index)
+        {
+            if(Check(_seed + static_cast<std::uint32_t>(index)) == false)
+                ++failedCount;
+        };
+
+        std::cout << "Layout fuzzing: " << (layoutCount - failedCount) << " of " << layoutCount << " layouts match the driver's (seed " << _seed << ")\n";
+
+        return failedCount;
+    };
+
+
+private:
+
+    bool Check(const std::uint32_t seed)
+    {
+        _random.seed(seed);
+
+        _structDeclarations.clear();
+        _reads.clear();
+        _nextStructID = 0;
+        _nextMemberID = 0;
+
+
+        RawLayout rawLayout;
+
+        std::string blockMembers;
+
+        AddMembers(rawLayout, blockMembers, { std::string() }, 0);
+
+        // An unsized array is only valid at the end of the block
+        if(Roll(4) == 0)
+        {
+            const DataType type = RandomScalarType();
+            const std::string name = NextMemberName();
+
+            rawLayout.Add<ArrayElement, DataType::Array>(name).SetUnsizedArray(type);
+
+            blockMembers.append("    ").append(DataTypeGLSLName(type)).append(" ").append(name).append("[];\n");
+
+            _reads.push_back(ReadAsFloat(type, std::string(name).append("[0]")));
+        };
+
+        const std::string source = CreateShaderSource(blockMembers);
+
+
+        const char* sourcePointer = source.c_str();
+
+        const std::uint32_t programID = glCreateShaderProgramv(GL_COMPUTE_SHADER, 1, &sourcePointer);
+
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(programID, GL_LINK_STATUS, &linkStatus);
+
+        if(linkStatus != GL_TRUE)
+        {
+            GLint infoLogLength = 0;
+            glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &infoLogLength);
+
+            std::string infoLog(static_cast<std::size_t>(std::max(infoLogLength, 1)), '\0');
+            glGetProgramInfoLog(programID, infoLogLength, nullptr, infoLog.data());
+
+            std::cerr << "Layout " << seed << " didn't compile:\n" << infoLog.c_str() << "\n" << source << "\n";
+
+            GLState.DeleteProgram(programID);
+            return false;
+        };
+
+
+        ReflectedSSBOLayout reflectedLayout;
+
+        const bool reflected = ReflectSSBOLayout(programID, "Fuzzed", reflectedLayout);
+
+        GLState.DeleteProgram(programID);
+
+        if(reflected == false)
+        {
+            std::cerr << "Layout " << seed << " has no \"Fuzzed\" block after linking\n" << source << "\n";
+            return false;
+        };
+
+
+        const SSBOLayout layout = SSBOLayout(rawLayout);
+
+        const std::vector<std::string> mismatches = BufferLayout::FromSSBOLayout(layout).Compare(BufferLayout::FromReflection(reflectedLayout));
+
+        if(mismatches.empty() == true)
+            return true;
+
+
+        std::cerr << "Layout " << seed << " doesn't match the driver's:\n";
+
+        for(const std::string& mismatch : mismatches)
+        {
+            std::cerr << "    " << mismatch << "\n";
+        };
+
+        std::cerr << source << "\n";
+
+        return false;
+    };
+
+
+    /// <summary>
+    /// Add random members to a struct, or the block itself
+    /// </summary>
+    /// <param name="parent"> The RawLayout for the block's own members, otherwise a StructElement </param>
+    /// <param name="glslMembers"> Receives the members' GLSL declarations </param>
+    /// <param name="instancePaths"> A GLSL expression for every instance of the struct, empty for the block itself </param>
+    /// <param name="depth"> How deep the struct is nested, 0 for the block </param>
+    template<typename TParent>
+    void AddMembers(TParent& parent, std::string& glslMembers, const std::vector<std::string>& instancePaths, const std::uint32_t depth)
+    {
+        // Empty structs aren't valid GLSL
+        const std::uint32_t memberCount = 1 + Roll(_maxMembers);
+
+        for(std::uint32_t member = 0; member < memberCount; ++member)
+        {
+            const std::string name = NextMemberName();
+
+            // Scalars are the most common so layouts stay small, structs stop at the maximum depth
+            const std::uint32_t kind = depth < _maxDepth ? Roll(8) : Roll(6);
+
+            if(kind < 4)
+            {
+                const DataType type = RandomScalarType();
+
+                AddScalar(parent, name, type);
+
+                glslMembers.append("    ").append(DataTypeGLSLName(type)).append(" ").append(name).append(";\n");
+
+                AddReads(instancePaths, name, type, "");
+            }
+            else if(kind < 6)
+            {
+                const DataType type = RandomScalarType();
+                const std::size_t elementCount = 1 + Roll(5);
+
+                parent.template Add<ArrayElement, DataType::Array>(name).SetArray(type, elementCount);
+
+                glslMembers.append("    ").append(DataTypeGLSLName(type)).append(" ").append(name).append("[").append(std::to_string(elementCount)).append("];\n");
+
+                AddReads(instancePaths, name, type, "[0]");
+            }
+            else if(kind == 6)
+            {
+                const StructElement structElement = parent.template Add<StructElement, DataType::Struct>(name);
+
+                std::vector<std::string> memberPaths;
+
+                for(const std::string& path : instancePaths)
+                {
+                    memberPaths.push_back(JoinPath(path, name));
+                };
+
+                glslMembers.append("    ").append(AddStruct(structElement, memberPaths, depth + 1)).append(" ").append(name).append(";\n");
+            }
+            else
+            {
+                const std::size_t elementCount = 1 + Roll(3);
+
+                const StructElement elementType = parent.template Add<ArrayElement, DataType::Array>(name).SetCustomArrayType(elementCount);
+
+                // The driver lists a nested struct array's every element, so every element is read.
+                // A top-level one is listed once, its first element stands for the rest
+                std::vector<std::string> elementPaths;
+
+                for(const std::string& path : instancePaths)
+                {
+                    const std::size_t readCount = depth == 0 ? 1 : elementCount;
+
+                    for(std::size_t element = 0; element < readCount; ++element)
+                    {
+                        elementPaths.push_back(JoinPath(path, name).append("[").append(std::to_string(element)).append("]"));
+                    };
+                };
+
+                glslMembers.append("    ").append(AddStruct(elementType, elementPaths, depth + 1)).append(" ").append(name).append("[").append(std::to_string(elementCount)).append("];\n");
+            };
+        };
+    };
+
+    /// <summary>
+    /// Element types are template arguments, picked here from the random one
+    /// </summary>
+    template<typename TParent>
+    static void AddScalar(TParent& parent, const std::string& name, const DataType type)
+    {
+        switch(type)
+        {
+            case DataType::UInt32:
+                parent.template Add<ScalarElement, DataType::UInt32>(name);
+                break;
+
+            case DataType::Int32:
+                parent.template Add<ScalarElement, DataType::Int32>(name);
+                break;
+
+            case DataType::Float:
+                parent.template Add<ScalarElement, DataType::Float>(name);
+                break;
+
+            case DataType::Vec2f:
+                parent.template Add<ScalarElement, DataType::Vec2f>(name);
+                break;
+
+            case DataType::Vec3f:
+                parent.template Add<ScalarElement, DataType::Vec3f>(name);
+                break;
+
+            case DataType::Vec4f:
+                parent.template Add<ScalarElement, DataType::Vec4f>(name);
+                break;
+
+            case DataType::Mat4f:
+                parent.template Add<ScalarElement, DataType::Mat4f>(name);
+                break;
+
+            case DataType::Half2:
+                parent.template Add<ScalarElement, DataType::Half2>(name);
+                break;
+
+            case DataType::Half4:
+                parent.template Add<ScalarElement, DataType::Half4>(name);
+                break;
+
+            case DataType::Unorm8x4:
+                parent.template Add<ScalarElement, DataType::Unorm8x4>(name);
+                break;
+
+            default:
+                wt::Assert(false, "Not a scalar type");
+        };
+    };
+
+    /// <summary>
+    /// Fill a struct with random members and declare it
+    /// </summary>
+    /// <returns> The struct's GLSL type name </returns>
+    std::string AddStruct(StructElement structElement, const std::vector<std::string>& instancePaths, const std::uint32_t depth)
+    {
+        const std::string typeName = std::string("Struct").append(std::to_string(_nextStructID++));
+
+        std::string glslMembers;
+
+        AddMembers(structElement, glslMembers, instancePaths, depth);
+
+        _structDeclarations.append("struct ").append(typeName).append("\n{\n").append(glslMembers).append("};\n\n");
+
+        return typeName;
+    };
+
+    void AddReads(const std::vector<std::string>& instancePaths, const std::string& name, const DataType type, const char* suffix)
+    {
+        for(const std::string& path : instancePaths)
+        {
+            _reads.push_back(ReadAsFloat(type, JoinPath(path, name).append(suffix)));
+        };
+    };
+
+
+    std::string CreateShaderSource(const std::string& blockMembers) const
+    {
+        std::string source = "#version 460 core\n\nlayout(local_size_x = 1) in;\n\n";
+
+        source.append(_structDeclarations);
+
+        source.append("layout(std430, binding = 0) buffer Fuzzed\n{\n").append(blockMembers).append("};\n\n");
+
+        source.append("layout(std430, binding = 1) buffer FuzzedOutput\n{\n    float Sum;\n};\n\n");
+
+        source.append("void main()\n{\n    float sum = 0.0;\n\n");
+
+        for(const std::string& read : _reads)
+        {
+            source.append("    sum += ").append(read).append(";\n");
+        };
+
+        source.append("\n    Sum = sum;\n}\n");
+
+        return source;
+    };
+
+
+private:
+
+    std::uint32_t Roll(const std::uint32_t sides)
+    {
+        return std::uniform_int_distribution<std::uint32_t>(0, sides - 1)(_random);
+    };
+
+    DataType RandomScalarType()
+    {
+        static constexpr DataType scalarTypes[] = { DataType::UInt32, DataType::Int32, DataType::Float, DataType::Vec2f, DataType::Vec3f,
+                                                    DataType::Vec4f, DataType::Mat4f, DataType::Half2, DataType::Half4, DataType::Unorm8x4 };
+
+        return scalarTypes[Roll(static_cast<std::uint32_t>(std::size(scalarTypes)))];
+    };
+
+    std::string NextMemberName()
+    {
+        return std::string("Member").append(std::to_string(_nextMemberID++));
+    };
+
+    static std::string JoinPath(const std::string& path, const std::string& name)
+    {
+        return path.empty() == true ? name : std::string(path).append(".").append(name);
+    };
+
+    /// <summary>
+    /// A GLSL expression reading a single float out of a value
+    /// </summary>
+    static std::string ReadAsFloat(const DataType type, const std::string& expression)
+    {
+        switch(type)
+        {
+            case DataType::UInt32:
+            case DataType::Int32:
+                return std::string("float(").append(expression).append(")");
+
+            case DataType::Float:
+                return expression;
+
+            case DataType::Half2:
+                return std::string("unpackHalf2x16(").append(expression).append(").x");
+
+            case DataType::Half4:
+                return std::string("unpackHalf2x16(").append(expression).append(".x).x");
+
+            case DataType::Unorm8x4:
+                return std::string("unpackUnorm4x8(").append(expression).append(").x");
+
+            case DataType::Mat4f:
+                return std::string(expression).append("[0][0]");
+
+            default:
+                return std::string(expression).append(".x");
+        };
+    };
+
+};
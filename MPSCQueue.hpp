@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+
+/// <summary>
+/// A bounded, lock-free queue between any number of producer threads and one consumer thread.
+/// Every slot carries a sequence number that tells producers whether it's free and the consumer whether it's filled,
+/// so producers only ever contend on claiming a position, never on a lock
+/// </summary>
+/// <typeparam name="TElement"> Must be default constructible and move assignable </typeparam>
+/// <typeparam name="Capacity"> The maximum number of queued elements, a power of 2 </typeparam>
+template<typename TElement, std::size_t Capacity>
+class MPSCQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+
+private:
+
+    static constexpr std::size_t CacheLineSize = 64;
+
+
+    struct Slot
+    {
+        /// <summary>
+        /// Equal to the position a producer may fill the slot at, one past it once it's filled, and a lap ahead once it's popped
+        /// </summary>
+        std::atomic<std::size_t> Sequence = 0;
+
+        TElement Element;
+    };
+
+
+    std::array<Slot, Capacity> _slots;
+
+
+    /// <summary>
+    /// The next position to claim, shared by every producer
+    /// </summary>
+    alignas(CacheLineSize) std::atomic<std::size_t> _pushPosition = 0;
+
+    /// <summary>
+    /// The position the next element is popped from, only touched by the consumer
+    /// </summary>
+    alignas(CacheLineSize) std::size_t _popPosition = 0;
+
+
+public:
+
+    MPSCQueue()
+    {
+        for(std::size_t index = 0; index < Capacity; ++index)
+        {
+            _slots[index].Sequence.store(index, std::memory_order_relaxed);
+        };
+    };
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator = (const MPSCQueue&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// (Any thread) Add an element
+    /// </summary>
+    /// <returns> False if the queue is full, in which case the element is left untouched </returns>
+    bool TryPush(TElement&& element)
+    {
+        std::size_t pushPosition = _pushPosition.load(std::memory_order_relaxed);
+
+        while(true)
+        {
+            Slot& slot = _slots[pushPosition & (Capacity - 1)];
+
+            const std::size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+
+            const std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pushPosition);
+
+            if(difference == 0)
+            {
+                // Another producer may have claimed the position first, in which case pushPosition is reloaded
+                if(_pushPosition.compare_exchange_weak(pushPosition, pushPosition + 1, std::memory_order_relaxed) == true)
+                {
+                    slot.Element = std::move(element);
+
+                    slot.Sequence.store(pushPosition + 1, std::memory_order_release);
+
+                    return true;
+                };
+            }
+            // The slot still holds the element from a lap ago
+            else if(difference < 0)
+                return false;
+            else
+                pushPosition = _pushPosition.load(std::memory_order_relaxed);
+        };
+    };
+
+    /// <summary>
+    /// (Consumer) Take the oldest element
+    /// </summary>
+    /// <returns> False if the queue is empty, or its oldest element is claimed but not written yet </returns>
+    bool TryPop(TElement& element)
+    {
+        Slot& slot = _slots[_popPosition & (Capacity - 1)];
+
+        if(slot.Sequence.load(std::memory_order_acquire) != _popPosition + 1)
+            return false;
+
+        element = std::move(slot.Element);
+
+        // Free for the push a lap from now
+        slot.Sequence.store(_popPosition + Capacity, std::memory_order_release);
+
+        ++_popPosition;
+
+        return true;
+    };
+
+};
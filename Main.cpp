@@ -3,64 +3,227 @@
 #include <glad/glad.h>
 #include <Windows.h>
 #include <string_view>
+#include <fstream>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <optional>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <shared_mutex>
 
 #include "ShaderProgram.hpp"
+#include "ProgramPipeline.hpp"
+#include "EmbeddedAssets.hpp"
+#include "ShaderVariants.hpp"
 #include "FontSprite.hpp"
+#include "UploadWorker.hpp"
+#include "AssetLoader.hpp"
+#include "TextBuffer.hpp"
 #include "ShaderStorageBuffer.hpp"
 #include "WindowsUtilities.hpp"
 #include "DynamicSSBO.hpp"
+#include "FrameUniformBuffer.hpp"
+#include "GLExtensions.hpp"
+#include "FrameScheduler.hpp"
+#include "GPUProfiler.hpp"
+#include "FrameArena.hpp"
+#include "FrameBudgetController.hpp"
+#include "FrameStatistics.hpp"
+#include "EventTracing.hpp"
+#include "Benchmark.hpp"
+#include "BenchmarkScenarios.hpp"
+#include "LayoutBenchmark.hpp"
+#include "LayoutFuzzer.hpp"
+#include "GLDiagnostics.hpp"
+#include "SPSCQueue.hpp"
+#include "GLStateCache.hpp"
+#include "BufferLayout.hpp"
+#include "TextConversion.hpp"
+#include "StartupTrace.hpp"
+#include "TypingLatencyBenchmark.hpp"
+#include "GLCallCounting.hpp"
+#include "PipelineStatistics.hpp"
+#include "DamageTracking.hpp"
+#include "CursorOverlay.hpp"
+#include "GLRenderBackend.hpp"
+#include "ContentScale.hpp"
+#include "IncrementalPaste.hpp"
+#include "TextUndo.hpp"
+#include "PipelineWarmUp.hpp"
+#include "FrameLatencyLimiter.hpp"
+#include "DrawCapture.hpp"
+#include "ProfileZones.hpp"
+#include "GlyphAtlas.hpp"
+#include "GlyphCache.hpp"
+#include "HeadlessRenderer.hpp"
+#include "TerminalGrid.hpp"
+#include "GridDeltaProtocol.hpp"
+#include "ScrollbackStore.hpp"
+#include "SharedTextRing.hpp"
+#include "TextStream.hpp"
+#include "RenderWindow.hpp"
+#include "StyledTextParser.hpp"
+#include "TextSelection.hpp"
+#include "LabelCache.hpp"
+#include "TextAnimation.hpp"
+#include "LabelGrid.hpp"
+#include "TextDrawList.hpp"
+#include "TableView.hpp"
+#include "ImmediateText.hpp"
+#include "Minimap.hpp"
 
 
-static int WindowWidth = 0;
-static int WindowHeight = 0;
+/// <summary>
+/// Where the document's text starts, in window units
+/// </summary>
+static const glm::vec2 TextOrigin = { 100.0f, 100.0f };
+
+/// <summary>
+/// The document the editor starts with
+/// </summary>
+static constexpr std::string_view InitialDocument = "Type anything!Type anything!Type ";
 
 
-void APIENTRY GLDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+enum class RenderCommandType
 {
-    // Ignore unused parameter warnings
-    (void*)&type;
-    (void*)&source;
-    (void*)&id;
-    (void*)&length;
-    (void*)&length;
-    (void*)&userParam;
+    /// <summary>
+    /// Append Text to the document
+    /// </summary>
+    Append,
 
-    switch(severity)
-    {
-        case GL_DEBUG_SEVERITY_HIGH:
-        case GL_DEBUG_SEVERITY_MEDIUM:
-        case GL_DEBUG_SEVERITY_LOW:
-        {
-            std::cerr << message << "\n";
+    /// <summary>
+    /// Erase Count characters from the end of the document
+    /// </summary>
+    EraseBack,
 
-            __debugbreak();
-            break;
-        };
+    /// <summary>
+    /// Append Text, undecoded UTF-8 from the clipboard, to the document over as many frames as it takes, see IncrementalPaste
+    /// </summary>
+    Paste,
 
-        default:
-            break;
-    };
+    /// <summary>
+    /// Revert the last edit, see TextUndoHistory
+    /// </summary>
+    Undo,
+
+    /// <summary>
+    /// Apply the last undone edit again
+    /// </summary>
+    Redo,
+
+    /// <summary>
+    /// Select the whole document, without reading any of it
+    /// </summary>
+    SelectAll,
+
+    /// <summary>
+    /// Send a snapshot of the selection back to the input thread for the clipboard, see CopiedSelection
+    /// </summary>
+    Copy,
+
+    /// <summary>
+    /// Draw a new frame, nothing in the document changed
+    /// </summary>
+    Redraw,
+
+    ToggleProfiler,
+
+    /// <summary>
+    /// Print the frame statistics to the console
+    /// </summary>
+    DumpFrameStatistics,
+
+    /// <summary>
+    /// Count the text's shader invocations and fragments, and show them with the profiler
+    /// </summary>
+    TogglePipelineStatistics,
+
+    /// <summary>
+    /// Draw the text as a heatmap of how many fragments were shaded for each pixel
+    /// </summary>
+    ToggleOverdrawHeatmap,
+
+    /// <summary>
+    /// The window was minimized, restored, focused or unfocused, Count is the new WindowVisibility
+    /// </summary>
+    WindowVisibilityChanged,
+
+    /// <summary>
+    /// Leave the render loop
+    /// </summary>
+    Quit,
+};
+
+/// <summary>
+/// A request from the input thread to the render thread
+/// </summary>
+struct RenderCommand
+{
+    RenderCommandType Type = RenderCommandType::Redraw;
+
+    std::size_t Count = 0;
+
+    std::string Text;
+
+    /// <summary>
+    /// When the input behind the command arrived, negative if the command doesn't come from input
+    /// </summary>
+    double InputTime = -1.0;
+};
+
+using RenderCommandQueue = SPSCQueue<RenderCommand, 1024>;
+
+
+/// <summary>
+/// A copy of the editor's selection, from the render thread, which owns the document, to the input thread, which owns the clipboard.
+/// The text is only read when it's pasted
+/// </summary>
+struct CopiedSelection
+{
+    std::shared_ptr<const ISelectionSource> Source;
+
+    TextSelectionRange Range;
 };
 
+using CopiedSelectionQueue = SPSCQueue<CopiedSelection, 16>;
+
+
+/// <summary>
+/// (Render thread writes, input thread reads) Held exclusively while the render thread edits the document,
+/// and shared while a copy of it is pasted, which reads the document's text from the input thread
+/// </summary>
+static std::shared_mutex DocumentMutex;
+
 
 void GLFWErrorCallback(int, const char* err_str) noexcept
 {
     std::cerr << "GLFW Error: " << err_str << "\n";
-    __debugbreak();
+
+    if(GLDiagnostics == GLDiagnosticsLevel::SynchronousBreak)
+        __debugbreak();
 };
 
 
 /// <summary>
-/// Initialize GLFW and show window
+/// Create the window and show it, GLFW must already be initialized
 /// </summary>
-/// <param name="windowWidth"> The width of the window </param>
-/// <param name="windowHeight"> The height of the window </param>
+/// <param name="windowWidth"> The width of the window, in window units </param>
+/// <param name="windowHeight"> The height of the window, in window units </param>
 /// <param name="windowTitle"> The window's tile </param>
+/// <param name="diagnosticsLevel"> Decides whether a debug or no-error context is created </param>
+/// <param name="visible"> Whether the window is shown, hidden windows only provide a context </param>
 /// <returns></returns>
-GLFWwindow* InitializeGLFWWindow(int windowWidth, int windowHeight, const std::string_view& windowTitle)
+GLFWwindow* InitializeGLFWWindow(int windowWidth, int windowHeight, const std::string_view& windowTitle, const GLDiagnosticsLevel diagnosticsLevel, const bool visible = true)
 {
-    glfwInit();
-
     glfwSetErrorCallback(GLFWErrorCallback);
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -68,149 +231,4011 @@ GLFWwindow* InitializeGLFWWindow(int windowWidth, int windowHeight, const std::s
 
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* glfwWindow = glfwCreateWindow(windowWidth, windowHeight, windowTitle.data(), nullptr, nullptr);
+    // The size is in window units, a 200% monitor gets a window with twice the pixels rather than one half the size
+    glfwWindowHint(GLFW_SCALE_TO_MONITOR, GLFW_TRUE);
 
+    SetGLDiagnosticsWindowHints(diagnosticsLevel);
 
-    glfwMakeContextCurrent(glfwWindow);
-
-    // Draw as fast as computerly possible
-    glfwSwapInterval(0);
+    GLFWwindow* glfwWindow = nullptr;
 
-    glfwSetFramebufferSizeCallback(glfwWindow, [](GLFWwindow* glfwWindow, int width, int height) noexcept
     {
-        WindowWidth = width;
-        WindowHeight = height;
+        const StartupPhase phase = StartupPhase("Create window and context");
 
+        glfwWindow = glfwCreateWindow(windowWidth, windowHeight, windowTitle.data(), nullptr, nullptr);
 
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        glfwMakeContextCurrent(glfwWindow);
+    };
 
-        glfwSwapBuffers(glfwWindow);
+    // Frames are paced by the FrameScheduler, not v-sync
+    glfwSwapInterval(0);
 
-        glViewport(0, 0, width, height);
-    });
+    {
+        const StartupPhase phase = StartupPhase("Load GL functions");
 
-    WindowWidth = windowWidth;
-    WindowHeight = windowHeight;
+        gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 
-    gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+        LoadGLExtensions();
+    };
 
-    glfwShowWindow(glfwWindow);
+    if(visible == true)
+        glfwShowWindow(glfwWindow);
 
     return glfwWindow;
 };
 
 
-void SetupOpenGL()
+void SetupOpenGL(const GLDiagnosticsLevel diagnosticsLevel)
 {
-    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-    glEnable(GL_DEBUG_OUTPUT);
-    glDebugMessageCallback(GLDebugCallback, nullptr);
+    EnableGLDiagnostics(diagnosticsLevel);
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Let the driver use as many compiler threads as it wants
+    if(GLExtensions.ParallelShaderCompile == true)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
 };
 
 
 
-int main()
+/// <summary>
+/// Queue a command for the render thread and wake it up. Waits for space if the render thread has fallen a whole queue behind
+/// </summary>
+void PushRenderCommand(RenderCommandQueue& renderCommands, const FrameScheduler& frameScheduler, RenderCommand&& command)
 {
-    constexpr std::uint32_t initialWindowWidth = 800;
-    constexpr std::uint32_t initialWindowHeight = 600;
+    while(renderCommands.TryPush(std::move(command)) == false)
+    {
+        std::this_thread::yield();
+    };
+
+    frameScheduler.Wake();
+};
+
+
+/// <summary>
+/// (Input thread) Characters typed since the last flush, already converted to what the atlas can draw
+/// </summary>
+static std::string TypedText;
+
+/// <summary>
+/// (Input thread) When the first of the typed characters arrived
+/// </summary>
+static double TypedTextInputTime = -1.0;
+
+
+/// <summary>
+/// (Input thread) Send the typed characters to the render thread as a single append
+/// </summary>
+void FlushTypedText(RenderCommandQueue& renderCommands, const FrameScheduler& frameScheduler)
+{
+    if(TypedText.empty() == true)
+        return;
+
+    PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::Append, .Text = std::exchange(TypedText, {}), .InputTime = TypedTextInputTime });
+};
+
+
+/// <summary>
+/// Mark the window interactive, and write the startup trace if one was asked for
+/// </summary>
+void EndStartupTrace(const std::string& tracePath)
+{
+    const double startupMilliseconds = StartupTracer.MarkInteractive();
+
+    if(tracePath.empty() == true || startupMilliseconds < 0.0)
+        return;
+
+    std::cout << "Interactive after " << startupMilliseconds << " ms\n";
+
+    std::ofstream traceFile = std::ofstream(tracePath);
 
-    GLFWwindow* glfwWindow = InitializeGLFWWindow(initialWindowWidth, initialWindowHeight, "OpenGL-TextRenderer");
+    if(traceFile.is_open() == false)
+    {
+        std::cerr << "Unable to write the startup trace to \"" << tracePath << "\"\n";
+        return;
+    };
+
+    StartupTracer.WriteChromeTraceJSON(traceFile);
+};
+
+
+/// <summary>
+/// The render thread's loop, owns the document and the GL context until a Quit command
+/// </summary>
+void RenderLoop(RenderWindow& renderWindow,
+                ShaderVariants& fontShaders,
+                FontSprite& fontSprite,
+                const float atlasScale,
+                const ProgramPipeline& cursorPipeline,
+                RenderCommandQueue& renderCommands,
+                CopiedSelectionQueue& copiedSelections,
+                FrameScheduler& frameScheduler,
+                const GLDiagnosticsLevel diagnosticsLevel,
+                const std::optional<std::uint64_t> maxFrameAllocations,
+                const std::uint32_t maxFrameLatency,
+                const std::string& startupTracePath,
+                const std::string& drawCapturePath,
+                TypingLatencyBenchmark* typingBenchmark)
+{
+    // The swap interval belongs to the context, so it's set on the thread that presents
+    frameScheduler.SetPresentMode(PresentMode::AdaptiveVSync);
+
+    TextBuffer textToDraw = TextBuffer(std::string(InitialDocument));
+
+    // Only the ends are kept, selecting all of a document of any size is instant
+    TextSelection selection;
+
+    GPUProfiler profiler;
+    bool showProfiler = false;
 
+    // The frame's temporaries, such as the profiler overlay's text
+    FrameArena frameArena;
 
-    SetupOpenGL();
+    // Text quality drops on frames that would miss the vertical blank, with a little room left for presenting
+    const double refreshInterval = frameScheduler.GetRefreshInterval();
 
-    const ShaderProgram shaderProgram = ShaderProgram("Shaders\\FontSpriteVertexShader.glsl", "Shaders\\FontSpriteFragmentShader.glsl");
+    FrameBudgetController frameBudget = FrameBudgetController(refreshInterval > 0.0 ? refreshInterval * 900.0 : 15.0);
 
-    FontSprite fontSprite = FontSprite(13, 24, shaderProgram, L"Resources\\Consolas13x24.bmp");
+    // A present that takes half a refresh longer than it should is a visible hitch
+    FrameStatistics frameStatistics;
 
+    frameStatistics.HitchThreshold = refreshInterval > 0.0 ? refreshInterval * 1500.0 : 25.0;
 
-    // Calculate projection and transform
-    fontSprite.ScreenSpaceProjection = glm::ortho(0.0f, static_cast<float>(WindowWidth), static_cast<float>(WindowHeight), 0.0f, -1.0f, 1.0f);
+    // Frames queued ahead of the GPU are frames of input latency, the CPU waits for the oldest before it reads the next input
+    FrameLatencyLimiter frameLatency = FrameLatencyLimiter(maxFrameLatency);
 
-    fontSprite.Transform = glm::translate(glm::mat4(1.0f), { 100, 100, 0.0f });
+    // Splits the render thread's GL calls into frames, with "--count-gl-calls"
+    GLCallCounter glCallCounter;
 
+    profiler.MaxFrameAllocations = maxFrameAllocations;
 
-    static std::string textToDraw = "Type anything!Type anything!Type ";
+    fontSprite.Profiler = &profiler;
 
+    // Counted on request, the queries cost something on every draw
+    PipelineStatisticsProfiler pipelineStatistics;
 
-    // Keyboard input handler
-    glfwSetKeyCallback(glfwWindow, [](GLFWwindow* glfwWindow, int key, int scanCode, int actions, int modBits) noexcept
+    fontSprite.PipelineStatistics = &pipelineStatistics;
+
+    // With "--record-draws", the font's draws are written to a capture for replaying with "--replay-draws"
+    std::optional<DrawRecorder> drawRecorder;
+
+    if(drawCapturePath.empty() == false)
+        fontSprite.Recorder = &drawRecorder.emplace(drawCapturePath);
+
+    // Pooled buffers are the cheapest memory to give back when the budget is exceeded, or the driver runs low
+    GPUMemory.AddEvictionHandler(GPUMemoryCategory::TextBuffer, [&fontSprite]()
     {
-        if(actions == GLFW_PRESS)
-            return;
+        return fontSprite.ReleasePooledBuffers();
+    });
+
+    frameStatistics.RecordGPUMemory(GPUMemory);
+
+    #ifdef TEXT_RENDERER_PROFILE_ZONES
+    // The last frame's zones are shown with the frame statistics
+    ZoneStatisticsBackend zoneStatistics;
+
+    ProfileZones.AddBackend(zoneStatistics);
+    frameStatistics.RecordProfileZones(zoneStatistics);
+    #endif
+
+    // The program the text is drawn with while the heatmap is off
+    const ShaderProgram* textProgram = &fontSprite.GetShaderProgram();
+
+    bool overdrawHeatmap = false;
+
+    // Frames are drawn into a buffer that keeps its pixels, so an edit only redraws the pixels of the glyphs it changed
+    RetainedFramebuffer retainedFramebuffer;
+
+    TextDamageTracker textDamage;
+
+    // Set by anything that changes more than the text, e.g. a shader reload
+    bool redrawAll = true;
+
+    // What's drawn through the backend rather than straight through GL, so far the caret
+    GLRenderBackend renderBackend;
+
+    // The caret is drawn over the retained text, a blink doesn't draw any glyphs
+    CursorOverlay cursorOverlay = CursorOverlay(renderBackend, renderBackend.CreatePipeline(cursorPipeline, BackendBlendMode::Alpha));
+
+    float contentScale = 0.0f;
+
+    bool running = true;
+
+    // Numbers the frames in ETW traces
+    std::uint64_t frameIndex = 0;
+
+    // Pastes are spliced into the document a few milliseconds per frame, with their progress drawn over the text
+    IncrementalPaste incrementalPaste;
+
+    // Every edit is logged as references to the document's pieces, undoing only uploads from where the edit was
+    TextUndoHistory undoHistory;
+
+    // Edits made while a paste is being spliced in, applied in order once it's done
+    std::deque<RenderCommand> deferredEdits;
+
+    // An instance of its own, drawing the progress through the document's would upload the whole document again next frame
+    FontSprite pasteProgressText = FontSprite(fontSprite, 64);
+
+    // Every pipeline the loop draws with is used once offscreen, so neither the first frame nor the first heatmap waits on the driver finishing them
+    if(fontSprite.IsReady() == true)
+    {
+        const StartupPhase phase = StartupPhase("Warm up pipelines");
 
-        if(key == GLFW_KEY_BACKSPACE)
         {
-            if(textToDraw.empty() == true)
-                return;
+            const PipelineWarmUp warmUp;
+
+            const std::uint32_t heatmapFeatures = FontSprite::GetShaderFeatures(fontSprite.GetAtlasFormat(), false, false) |
+                                                  static_cast<std::uint32_t>(FontShaderFeature::OverdrawHeatmap);
+
+            warmUp.DrawText(fontSprite, *textProgram);
+            warmUp.DrawText(fontSprite, fontShaders.Get(heatmapFeatures));
+            warmUp.DrawText(pasteProgressText, *textProgram);
 
-            textToDraw.erase(textToDraw.end() - 1);
+            cursorOverlay.AddRect({ 0.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f });
+            cursorOverlay.Draw();
         };
 
+        fontSprite.EndFrame();
+        pasteProgressText.EndFrame();
+        cursorOverlay.EndFrame();
 
-        const char* pressedKeyName = glfwGetKeyName(key, scanCode);
+        renderBackend.EndFrame();
+    };
 
-        // Paste
-        if((modBits & GLFW_MOD_CONTROL) &&
-           (key == GLFW_KEY_V))
+
+    // Apply every queued command, returns false once the loop should exit
+    const auto executeCommands = [&]()
+    {
+        TEXT_RENDERER_ZONE("Execute commands");
+
+        const AllocationSubsystemScope allocationScope = AllocationSubsystemScope(AllocationSubsystem::Input);
+
+        // A copy being pasted reads the document from the input thread
+        const std::unique_lock<std::shared_mutex> documentLock = std::unique_lock(DocumentMutex);
+
+        // Typing, pasting or erasing over a selection replaces it. Returns whether anything was selected
+        const auto eraseSelection = [&](const double inputTime)
         {
-            const char* clipboardString = glfwGetClipboardString(glfwWindow);
+            if(selection.IsEmpty() == true)
+                return false;
 
-            textToDraw.append(clipboardString);
+            const TextSelectionRange range = selection.GetRange();
 
-            return;
+            undoHistory.Erase(textToDraw, static_cast<std::size_t>(range.Begin), static_cast<std::size_t>(range.GetSize()), inputTime);
+
+            selection.Collapse(textToDraw.GetSize());
+
+            return true;
         };
 
-        // Space key pressed
-        if(key == GLFW_KEY_SPACE)
+        RenderCommand command;
+
+        while(true)
         {
-            textToDraw.append(" ");
-            return;
+            // Deferred edits go first, they were made before anything still queued
+            if(incrementalPaste.IsPasting() == false && deferredEdits.empty() == false)
+            {
+                command = std::move(deferredEdits.front());
+                deferredEdits.pop_front();
+            }
+            else if(renderCommands.TryPop(command) == false)
+                break;
+
+            const bool isEdit = command.Type == RenderCommandType::Append || command.Type == RenderCommandType::EraseBack || command.Type == RenderCommandType::Paste ||
+                                command.Type == RenderCommandType::Undo || command.Type == RenderCommandType::Redo;
+
+            // Everything but edits, quitting included, still applies right away
+            if(isEdit == true && incrementalPaste.IsPasting() == true)
+            {
+                deferredEdits.push_back(std::move(command));
+                continue;
+            };
+
+            switch(command.Type)
+            {
+                case RenderCommandType::Paste:
+                {
+                    eraseSelection(command.InputTime);
+
+                    incrementalPaste.Add(std::move(command.Text));
+
+                    cursorOverlay.ResetBlink(glfwGetTime());
+                    break;
+                };
+
+                case RenderCommandType::Append:
+                {
+                    eraseSelection(command.InputTime);
+
+                    undoHistory.Insert(textToDraw, textToDraw.GetSize(), command.Text, command.InputTime);
+
+                    cursorOverlay.ResetBlink(glfwGetTime());
+                    break;
+                };
+
+                case RenderCommandType::EraseBack:
+                {
+                    if(eraseSelection(command.InputTime) == false)
+                    {
+                        const std::size_t count = std::min(command.Count, textToDraw.GetSize());
+
+                        undoHistory.Erase(textToDraw, textToDraw.GetSize() - count, count, command.InputTime);
+                    };
+
+                    cursorOverlay.ResetBlink(glfwGetTime());
+                    break;
+                };
+
+                case RenderCommandType::Undo:
+                {
+                    undoHistory.Undo(textToDraw);
+
+                    selection.Collapse(textToDraw.GetSize());
+
+                    cursorOverlay.ResetBlink(glfwGetTime());
+                    break;
+                };
+
+                case RenderCommandType::Redo:
+                {
+                    undoHistory.Redo(textToDraw);
+
+                    selection.Collapse(textToDraw.GetSize());
+
+                    cursorOverlay.ResetBlink(glfwGetTime());
+                    break;
+                };
+
+                case RenderCommandType::SelectAll:
+                {
+                    selection.Select(0, textToDraw.GetSize());
+
+                    frameScheduler.RequestRedraw();
+                    break;
+                };
+
+                case RenderCommandType::Copy:
+                {
+                    if(selection.IsEmpty() == true)
+                        break;
+
+                    // Only references to the selected pieces, the text is read when it's pasted
+                    std::shared_ptr<const ISelectionSource> snapshot = std::make_shared<const TextBufferSnapshot>(textToDraw, selection.GetRange(), &DocumentMutex);
+
+                    const TextSelectionRange range = TextSelectionRange { .Begin = 0, .End = snapshot->GetSize() };
+
+                    // The input thread sleeps until an event, an empty one wakes it for the copy
+                    if(copiedSelections.TryPush(CopiedSelection { .Source = std::move(snapshot), .Range = range }) == true)
+                        glfwPostEmptyEvent();
+
+                    break;
+                };
+
+                case RenderCommandType::Redraw:
+                {
+                    frameScheduler.RequestRedraw();
+                    break;
+                };
+
+                case RenderCommandType::ToggleProfiler:
+                {
+                    showProfiler = !showProfiler;
+
+                    redrawAll = true;
+
+                    // The timings change every frame, so the overlay keeps the loop drawing
+                    if(showProfiler == true)
+                        frameScheduler.BeginAnimation();
+                    else
+                        frameScheduler.EndAnimation();
+
+                    break;
+                };
+
+                case RenderCommandType::DumpFrameStatistics:
+                {
+                    frameStatistics.Dump(std::cout);
+                    break;
+                };
+
+                case RenderCommandType::TogglePipelineStatistics:
+                {
+                    pipelineStatistics.Enabled = !pipelineStatistics.Enabled;
+
+                    redrawAll = true;
+
+                    frameScheduler.RequestRedraw();
+                    break;
+                };
+
+                case RenderCommandType::ToggleOverdrawHeatmap:
+                {
+                    overdrawHeatmap = !overdrawHeatmap;
+
+                    if(overdrawHeatmap == true)
+                    {
+                        textProgram = &fontSprite.GetShaderProgram();
+
+                        const std::uint32_t features = FontSprite::GetShaderFeatures(fontSprite.GetAtlasFormat(), false, false) |
+                                                       static_cast<std::uint32_t>(FontShaderFeature::OverdrawHeatmap);
+
+                        fontSprite.SetShaderProgram(fontShaders.Get(features));
+                    }
+                    else
+                        fontSprite.SetShaderProgram(*textProgram);
+
+                    redrawAll = true;
+
+                    frameScheduler.RequestRedraw();
+                    break;
+                };
+
+                case RenderCommandType::WindowVisibilityChanged:
+                {
+                    frameScheduler.SetWindowVisibility(static_cast<WindowVisibility>(command.Count));
+                    break;
+                };
+
+                case RenderCommandType::Quit:
+                {
+                    running = false;
+                    break;
+                };
+            };
+
+            if(command.InputTime >= 0.0)
+                frameScheduler.InputReceived(command.InputTime);
         };
+    };
 
-        // Unrecognized key pressed..
-        if(pressedKeyName == nullptr)
-            // Exit
-            return;
 
-        // Get the actual key's letter
-        char actualKey = *pressedKeyName;
+    while(running == true)
+    {
+        frameScheduler.WaitForEvents();
+
+        executeCommands();
+
+        if(typingBenchmark != nullptr)
+            typingBenchmark->Update();
 
-        // If shift is engaged..
-        if(modBits & GLFW_MOD_SHIFT)
         {
-            // If the pressed key is contained within alphabet character range..
-            if(actualKey >= 97 && actualKey <= 122)
-                // Subtract 32 from the letter so we get capital letters
-                actualKey -= 32;
+            const AllocationSubsystemScope allocationScope = AllocationSubsystemScope(AllocationSubsystem::Shader);
 
-            // If the key is numeric..
-            if(actualKey >= 48 && actualKey <= 57)
-                // Subtract 16 to get the correct symbol
-                actualKey -= 16;
+            if(fontShaders.Update() == true)
+            {
+                redrawAll = true;
 
-        }
+                frameScheduler.RequestRedraw();
+            };
+        };
 
-        textToDraw.append(1, actualKey);
-    });
+        // The atlas is loaded in the background, the text appears once it's in
+        if(fontSprite.Update() == true)
+        {
+            redrawAll = true;
 
+            frameScheduler.RequestRedraw();
+        };
 
-    while(glfwWindowShouldClose(glfwWindow) == false)
-    {
-        glfwPollEvents();
+        if(running == false || frameScheduler.ShouldDraw() == false)
+            continue;
 
-        glClearColor(0.9f, 0.9f, 0.9f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        frameLatency.BeginFrame();
 
-        fontSprite.Bind();
+        // Pick up input that arrived while waiting for the frame
+        frameScheduler.LatchInput();
 
-        fontSprite.Draw(textToDraw,
-                        { 1.0f, 0.0f, 0.0f, 1.0f });
+        executeCommands();
 
-        glfwSwapBuffers(glfwWindow);
-    };
+        // The frame after the paste is done applies the edits deferred behind it
+        if(incrementalPaste.IsPasting() == true)
+        {
+            const AllocationSubsystemScope allocationScope = AllocationSubsystemScope(AllocationSubsystem::Input);
+
+            const std::unique_lock<std::shared_mutex> documentLock = std::unique_lock(DocumentMutex);
+
+            incrementalPaste.Ingest(textToDraw, &undoHistory);
+
+            frameScheduler.RequestRedraw();
+        };
+
+
+        // The window's callbacks only record its size and content scale, the viewport and projection follow them here, once per drawn frame.
+        // A minimized window has nothing to draw into, the frame is dropped rather than presented
+        if(renderWindow.BeginFrame(static_cast<float>(glfwGetTime())) == false)
+        {
+            frameScheduler.FrameDrawn();
+            continue;
+        };
+
+        const int viewportWidth = renderWindow.GetViewportSize().x;
+        const int viewportHeight = renderWindow.GetViewportSize().y;
+
+        // Moving to a monitor with another scale keeps the text's size in window units, its glyphs are drawn at the new monitor's pixels
+        if(const float windowContentScale = renderWindow.GetContentScale(); windowContentScale != contentScale)
+        {
+            fontSprite.Transform = GetContentScaleTransform(TextOrigin, windowContentScale, atlasScale);
+
+            contentScale = windowContentScale;
+
+            redrawAll = true;
+        };
+
+
+        frameArena.Reset();
+
+        const std::int64_t frameStart = wt::etw::GetTime();
+
+        wt::etw::FrameBegin(frameIndex);
+
+        profiler.BeginFrame();
+
+        pipelineStatistics.BeginFrame();
+
+        // The text's layout is followed on every frame, full redraws included, so the next edit's damage is known.
+        // The overlay and the heatmap change all over the window, so they redraw everything
+        const std::optional<DamageRect> textDamageRect = textDamage.Update(textToDraw, fontSprite);
+
+        if(retainedFramebuffer.Resize(viewportWidth, viewportHeight) == true)
+            redrawAll = true;
+
+        const std::optional<DamageRect> damage = redrawAll == true || showProfiler == true || overdrawHeatmap == true ? std::nullopt : textDamageRect;
+
+        redrawAll = false;
+
+        // Nothing in the retained frame changed, e.g. the caret blinked, so only the overlay is drawn
+        const bool textUnchanged = damage.has_value() == true && damage->IsEmpty() == true;
+
+        if(textUnchanged == false)
+        {
+            retainedFramebuffer.Bind(damage);
+
+            {
+                const ProfileScope clearScope = ProfileScope(&profiler, "Clear");
+
+                // The heatmap adds up from black
+                if(overdrawHeatmap == true)
+                    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+                else
+                    glClearColor(0.9f, 0.9f, 0.9f, 1.0f);
+
+                glClear(GL_COLOR_BUFFER_BIT);
+            };
+
+            fontSprite.Bind();
+
+            {
+                const ProfileScope drawScope = ProfileScope(&profiler, "FontSprite::Draw");
+
+                fontSprite.Draw(textToDraw,
+                                { 1.0f, 0.0f, 0.0f, 1.0f });
+            };
+        };
+
+        if(showProfiler == true)
+        {
+            const glm::mat4 textTransform = fontSprite.Transform;
+
+            const glm::vec2 overlayOrigin = { 10.0f, (static_cast<float>(viewportHeight) / contentScale) - (10.0f * fontSprite.GetLineHeight() / atlasScale) };
+
+            fontSprite.Transform = GetContentScaleTransform(overlayOrigin, contentScale, atlasScale);
+
+            std::pmr::string overlay = profiler.FormatResults(&frameArena);
+
+            overlay.append("\n").append(frameStatistics.Format(&frameArena));
+
+            if(pipelineStatistics.Enabled == true)
+            {
+                const std::uint64_t screenPixelCount = static_cast<std::uint64_t>(viewportWidth) * static_cast<std::uint64_t>(viewportHeight);
+
+                overlay.append("\n").append(pipelineStatistics.FormatResults(&frameArena, screenPixelCount));
+            };
+
+            fontSprite.Draw(overlay, { 0.0f, 0.0f, 0.0f, 1.0f });
+
+            fontSprite.Transform = textTransform;
+        };
+
+        {
+            const ProfileScope presentScope = ProfileScope(&profiler, "Present");
+
+            retainedFramebuffer.Present();
+
+            // Drawn into the window's buffer like the caret, only the rows the window shows
+            if(selection.IsEmpty() == false && overdrawHeatmap == false)
+            {
+                const TextSelectionRange range = selection.GetRange();
+
+                const std::uint32_t lastVisibleRow = static_cast<std::uint32_t>(static_cast<float>(viewportHeight) / fontSprite.GetLineHeight());
+
+                textDamage.ForEachRowOf(textToDraw, static_cast<std::size_t>(range.Begin), static_cast<std::size_t>(range.End), lastVisibleRow, [&](const glm::uvec2& cell, const std::uint32_t cellCount)
+                {
+                    cursorOverlay.AddSelection(textDamage.GetCellRect(fontSprite, cell), cellCount);
+                });
+            };
+
+            // Drawn into the window's buffer, so the retained frame never holds a caret
+            if(const std::optional<glm::uvec2> caretCell = textDamage.GetEndCell(); caretCell.has_value() == true && overdrawHeatmap == false)
+            {
+                const double now = glfwGetTime();
+
+                cursorOverlay.AddCaret(textDamage.GetCellRect(fontSprite, *caretCell), now);
+
+                frameScheduler.RequestRedrawAt(cursorOverlay.GetNextBlinkTime(now));
+            };
+
+            // The selection and the caret in a single draw
+            cursorOverlay.Draw();
+
+            // Drawn into the window's buffer too, so it's gone as soon as the paste is
+            if(incrementalPaste.IsPasting() == true)
+            {
+                char progress[96] = { };
+
+                std::snprintf(progress, sizeof(progress), "Pasting %.0f%% (%.1f of %.1f MB)",
+                              incrementalPaste.GetProgress() * 100.0,
+                              static_cast<double>(incrementalPaste.GetIngestedBytes()) / (1024.0 * 1024.0),
+                              static_cast<double>(incrementalPaste.GetTotalBytes()) / (1024.0 * 1024.0));
+
+                pasteProgressText.Transform = GetContentScaleTransform({ 10.0f, 10.0f }, contentScale, atlasScale);
+
+                pasteProgressText.Bind();
+                pasteProgressText.Draw(std::string_view(progress), { 0.2f, 0.2f, 0.8f, 1.0f });
+            };
+
+            TEXT_RENDERER_ZONE("Present");
+
+            wt::etw::Present(frameIndex);
+
+            frameScheduler.Present(renderWindow.GetWindow());
+        };
+
+        frameStatistics.RecordFrame(frameScheduler.GetTimings(), glfwGetTime());
+
+        if(typingBenchmark != nullptr)
+            typingBenchmark->FramePresented(textToDraw.GetSize());
+
+        // Startup ends with the first frame that shows the text
+        if(StartupTracer.IsInteractive() == false && fontSprite.IsReady() == true)
+            EndStartupTrace(startupTracePath);
+
+        fontSprite.EndFrame();
+
+        if(drawRecorder.has_value() == true)
+            drawRecorder->EndFrame();
+
+        cursorOverlay.EndFrame();
+
+        renderBackend.EndFrame();
+
+        frameLatency.EndFrame();
+
+        TEXT_RENDERER_COUNTER("Document bytes", textToDraw.GetSize());
+        TEXT_RENDERER_COUNTER("Frame latency wait ms", frameLatency.GetLastWaitMilliseconds());
+
+        TEXT_RENDERER_FRAME_MARK();
+
+        profiler.EndFrame();
+
+        pipelineStatistics.EndFrame();
+
+        frameStatistics.RecordGPUFrame(profiler);
+
+        if(GLCallCountingInstalled == true)
+        {
+            glCallCounter.EndFrame();
+
+            frameStatistics.RecordGLCalls(glCallCounter);
+        };
+
+        GPUMemory.Update();
+
+        wt::etw::FrameEnd(frameIndex, wt::etw::GetMillisecondsSince(frameStart));
+
+        ++frameIndex;
+
+        if(frameBudget.Update(profiler) == true)
+        {
+            frameBudget.Apply(fontSprite);
+
+            frameScheduler.RequestRedraw();
+        };
+
+        if(diagnosticsLevel == GLDiagnosticsLevel::AsyncLogging)
+            FlushGLDebugLog(std::cerr);
+    };
+
+    fontSprite.Profiler = nullptr;
+    fontSprite.Recorder = nullptr;
+
+    #ifdef TEXT_RENDERER_PROFILE_ZONES
+    ProfileZones.RemoveBackend(zoneStatistics);
+    #endif
+
+    GPUMemory.ClearEvictionHandlers();
+
+    if(typingBenchmark != nullptr)
+        typingBenchmark->EndRendering();
+};
+
+
+/// <summary>
+/// Run benchmark workloads and write their results as JSON, to a file and the console
+/// </summary>
+/// <param name="workloads"> The workloads to run, the default ones if empty </param>
+int RunBenchmarks(FontSprite& fontSprite, const FrameUniformBuffer& frameUniformBuffer, const std::vector<BenchmarkWorkload>& workloads, const std::string& outputPath)
+{
+    const TextBenchmark benchmark = TextBenchmark(fontSprite, frameUniformBuffer);
+
+    const std::vector<BenchmarkResult> results = benchmark.Run(workloads.empty() == true ? GetDefaultBenchmarkWorkloads() : workloads);
+
+    WriteBenchmarkResultsJSON(std::cout, results);
+
+    std::ofstream outputFile = std::ofstream(outputPath);
+
+    if(outputFile.is_open() == false)
+    {
+        std::cerr << "Unable to write benchmark results to \"" << outputPath << "\"\n";
+        return 1;
+    };
+
+    WriteBenchmarkResultsJSON(outputFile, results);
+
+    return 0;
+};
+
+
+/// <summary>
+/// Measure every scene of a scenario file in each of its modes, write the results as JSON to a file, and print a table comparing them against a baseline
+/// </summary>
+/// <param name="styledProgram"> The font's program with FontShaderFeature::Styles, for the scenes with colour spans </param>
+/// <param name="batchProgram"> The font's fragment shader behind TextBatchVertexShader.glsl, for the batched mode </param>
+/// <returns> 2 if anything regressed against the baseline </returns>
+int RunScenarioBenchmarks(FontSprite& fontSprite, const FrameUniformBuffer& frameUniformBuffer, const ShaderProgram& styledProgram, const ShaderProgram& batchProgram,
+                          const std::string& scenarioPath, const std::string& baselinePath, const std::string& outputPath)
+{
+    const std::vector<BenchmarkScenario> scenarios = LoadBenchmarkScenarios(scenarioPath);
+
+    if(scenarios.empty() == true)
+        return 1;
+
+    const TextBenchmark benchmark = TextBenchmark(fontSprite, frameUniformBuffer);
+
+    const std::vector<BenchmarkScenarioResult> results = ScenarioBenchmark(benchmark, &styledProgram, &batchProgram).Run(scenarios);
+
+    const std::vector<BenchmarkScenarioResult> baseline = baselinePath.empty() == false ? LoadBenchmarkScenarioResultsJSON(baselinePath) : std::vector<BenchmarkScenarioResult>();
+
+    const std::size_t regressionCount = WriteBenchmarkComparisonTable(std::cout, results, baseline);
+
+    std::ofstream outputFile = std::ofstream(outputPath);
+
+    if(outputFile.is_open() == false)
+    {
+        std::cerr << "Unable to write scenario results to \"" << outputPath << "\"\n";
+        return 1;
+    };
+
+    WriteBenchmarkScenarioResultsJSON(outputFile, results);
+
+    return regressionCount > 0 ? 2 : 0;
+};
+
+
+/// <summary>
+/// Replay a draw capture as fast as it goes and write the measurements as JSON, to a file and the console
+/// </summary>
+int RunDrawReplay(FontSprite& fontSprite, const FrameUniformBuffer& frameUniformBuffer, const std::string& capturePath, const std::string& outputPath)
+{
+    const DrawCapture capture = DrawCapture(capturePath);
+
+    if(capture.IsValid() == false)
+        return 1;
+
+    const TextBenchmark benchmark = TextBenchmark(fontSprite, frameUniformBuffer);
+
+    const std::vector<BenchmarkResult> results = { benchmark.Replay(capture, nullptr, capturePath) };
+
+    WriteBenchmarkResultsJSON(std::cout, results);
+
+    std::ofstream outputFile = std::ofstream(outputPath);
+
+    if(outputFile.is_open() == false)
+    {
+        std::cerr << "Unable to write replay results to \"" << outputPath << "\"\n";
+        return 1;
+    };
+
+    WriteBenchmarkResultsJSON(outputFile, results);
+
+    return 0;
+};
+
+
+/// <summary>
+/// Load the font's program and atlas again through an AssetLoader, stepping its render thread work like frames would,
+/// and check both arrive ready. Needs the context current on this thread
+/// </summary>
+/// <returns> 0 if both loaded, 1 otherwise </returns>
+int RunAssetLoaderTest(const ScaledAtlas& atlas, const AtlasFormat atlasFormat, const std::string& vertexShaderPath, const std::string& fragmentShaderPath, std::vector<std::string> defines)
+{
+    JobSystem jobs = JobSystem();
+
+    AssetLoader loader = AssetLoader(jobs);
+
+    // Loads that take longer than this are reported as stuck
+    constexpr std::chrono::seconds timeout = std::chrono::seconds(30);
+
+    const auto runUntilDone = [&loader, &timeout](const auto& task)
+    {
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+
+        while(task.IsDone() == false && std::chrono::steady_clock::now() < deadline)
+        {
+            loader.Update();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        };
+
+        return task.IsDone();
+    };
+
+
+    Task<std::unique_ptr<ShaderProgram>> programLoad = loader.LoadShaderProgram(vertexShaderPath, fragmentShaderPath, std::move(defines));
+
+    programLoad.Start();
+
+    if(runUntilDone(programLoad) == false || programLoad.GetResult() == nullptr || programLoad.GetResult()->IsReady() == false)
+    {
+        std::cerr << "AssetLoader: the program \"" << vertexShaderPath << "\", \"" << fragmentShaderPath << "\" didn't load\n";
+        return 1;
+    };
+
+    const ShaderProgram& program = *programLoad.GetResult();
+
+
+    Task<std::shared_ptr<FontSprite>> fontLoad = loader.LoadFont(FontKey
+    {
+        .TexturePath = std::wstring(atlas.Path),
+        .GlyphWidth = atlas.GlyphSize.x,
+        .GlyphHeight = atlas.GlyphSize.y,
+        .Format = atlasFormat,
+        .Program = &program,
+    });
+
+    fontLoad.Start();
+
+    if(runUntilDone(fontLoad) == false || fontLoad.GetResult() == nullptr || fontLoad.GetResult()->IsReady() == false)
+    {
+        std::cerr << "AssetLoader: the font atlas didn't load\n";
+        return 1;
+    };
+
+    std::cout << "AssetLoader: loaded the program and the " << atlas.GlyphSize.x << "x" << atlas.GlyphSize.y << " font atlas\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Draw text the way the window would, but into a HeadlessRenderer's framebuffer, and write the image read back to a BMP file
+/// </summary>
+/// <param name="text"> The text to draw, starting at TextOrigin at a content scale of 1 </param>
+/// <returns> 0 if the image was written, 1 otherwise </returns>
+int RunHeadless(FontSprite& fontSprite, const float atlasScale, const std::uint32_t width, const std::uint32_t height, const std::string_view& text, const std::filesystem::path& outputPath)
+{
+    fontSprite.WaitUntilReady();
+
+    bool written = false;
+
+    {
+        HeadlessRenderer renderer = HeadlessRenderer(width, height, [&written, &outputPath](const ReadbackImage& image)
+        {
+            written = WriteReadbackImageBMP(image, outputPath);
+        });
+
+        fontSprite.Transform = GetContentScaleTransform(TextOrigin, 1.0f, atlasScale);
+
+        renderer.Render([&fontSprite, &text]()
+        {
+            fontSprite.Bind();
+            fontSprite.Draw(text, { 1.0f, 0.0f, 0.0f, 1.0f });
+        }, { 0.9f, 0.9f, 0.9f, 1.0f });
+
+        // Waits for the readback, the image is written before the renderer is gone
+        renderer.Finish();
+    };
+
+    fontSprite.EndFrame();
+
+    if(written == false)
+    {
+        std::cerr << "Unable to write the headless image to \"" << outputPath.string() << "\"\n";
+        return 1;
+    };
+
+    std::cout << "Wrote a " << width << "x" << height << " image of " << text.size() << " characters to \"" << outputPath.string() << "\"\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Check a TerminalGrid only uploads the rows that changed, scrolls by moving its first row, and covers its cells when drawn.
+/// Needs the context current on this thread
+/// </summary>
+/// <param name="gridProgram"> A program built from TerminalGridVertexShader.glsl and TerminalGridFragmentShader.glsl </param>
+/// <param name="image"> Receives the grid drawn offscreen, tightly packed RGBA8 rows from the bottom up </param>
+/// <returns> 0 if the grid behaved, 1 otherwise </returns>
+int RunTerminalGridTest(const FontSprite& fontSprite, const ShaderProgram& gridProgram, std::vector<std::byte>& image)
+{
+    constexpr std::uint32_t rows = 24;
+    constexpr std::uint32_t columns = 80;
+
+    const auto fail = [](const std::string_view& message)
+    {
+        std::cerr << "TerminalGrid: " << message << "\n";
+        return 1;
+    };
+
+    TerminalGrid grid = TerminalGrid(fontSprite, gridProgram, rows, columns);
+
+    for(std::uint32_t row = 0; row < rows; ++row)
+    {
+        const std::string line = "Row " + std::to_string(row) + ": the quick brown fox jumps over the lazy dog";
+
+        grid.Write(row, 0, line, { 0.9f, 0.9f, 0.9f, 1.0f }, { 0.1f, 0.1f, 0.2f + (0.02f * static_cast<float>(row)), 1.0f });
+    };
+
+    grid.Upload();
+
+    const std::size_t gridBytes = grid.GetUploadedByteCount();
+    const std::size_t rowBytes = gridBytes / rows;
+
+    if(gridBytes == 0)
+        return fail("the first upload wrote nothing");
+
+
+    // Setting a cell to what it holds doesn't dirty its row, changing it uploads that row alone
+    grid.SetCell(5, 3, grid.GetCell(5, 3));
+    grid.Upload();
+
+    if(grid.GetUploadedByteCount() != gridBytes)
+        return fail("an unchanged cell was uploaded");
+
+    TerminalCell changedCell = grid.GetCell(5, 3);
+    changedCell.Character = U'#';
+
+    grid.SetCell(5, 3, changedCell);
+    grid.Upload();
+
+    if(grid.GetUploadedByteCount() != gridBytes + rowBytes)
+        return fail("a changed cell didn't upload exactly its row");
+
+
+    // Scrolling moves the ring's first row, only the rows scrolled into view are cleared and uploaded
+    std::size_t uploadedBytes = grid.GetUploadedByteCount();
+
+    grid.Scroll(3);
+    grid.Upload();
+
+    if(grid.GetUploadedByteCount() - uploadedBytes != 3 * rowBytes)
+        return fail("scrolling up 3 rows didn't upload exactly 3 rows");
+
+    if(grid.GetCell(2, 3) != changedCell || grid.GetCell(rows - 1, 0) != TerminalCell())
+        return fail("scrolling up didn't move the rows, or didn't clear the ones scrolled into view");
+
+    uploadedBytes = grid.GetUploadedByteCount();
+
+    grid.Scroll(-2);
+    grid.Upload();
+
+    if(grid.GetUploadedByteCount() - uploadedBytes != 2 * rowBytes)
+        return fail("scrolling down 2 rows didn't upload exactly 2 rows");
+
+    if(grid.GetCell(4, 3) != changedCell || grid.GetCell(0, 0) != TerminalCell())
+        return fail("scrolling down didn't move the rows, or didn't clear the ones scrolled into view");
+
+
+    // Every cell has an opaque background, so the grid covers all of its pixels
+    const std::uint32_t width = columns * fontSprite.GetGlyphWidth();
+    const std::uint32_t height = rows * fontSprite.GetGlyphHeight();
+
+    {
+        HeadlessRenderer renderer = HeadlessRenderer(width, height, [&image](const ReadbackImage& readback)
+        {
+            image.assign(readback.Pixels.begin(), readback.Pixels.end());
+        });
+
+        renderer.Render([&grid]()
+        {
+            grid.Draw();
+        });
+
+        renderer.Finish();
+    };
+
+    std::size_t coveredCount = 0;
+
+    for(std::size_t offset = 3; offset < image.size(); offset += 4)
+    {
+        if(image[offset] != std::byte { 0 })
+            ++coveredCount;
+    };
+
+    if(coveredCount != static_cast<std::size_t>(width) * height)
+        return fail("the drawn grid left " + std::to_string((static_cast<std::size_t>(width) * height) - coveredCount) + " pixels uncovered");
+
+    std::cout << "TerminalGrid: " << rows << "x" << columns << " cells, " << gridBytes << " bytes for the grid, " << rowBytes << " per changed or scrolled row\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Compare the images of a grid drawn with a quad per cell and with a quad per row.
+/// Both sample the same texels, but interpolate their coordinates differently, so channels may be off by a step or two
+/// </summary>
+/// <returns> 0 if the images match, 1 otherwise </returns>
+int CompareTerminalGridImages(const std::vector<std::byte>& cellQuadsImage, const std::vector<std::byte>& rowQuadsImage)
+{
+    constexpr int tolerance = 2;
+
+    if(cellQuadsImage.size() != rowQuadsImage.size())
+    {
+        std::cerr << "TerminalGrid: the row quads image is a different size than the cell quads image\n";
+        return 1;
+    };
+
+    std::size_t differentPixelCount = 0;
+
+    for(std::size_t offset = 0; offset < cellQuadsImage.size(); offset += 4)
+    {
+        for(std::size_t channel = 0; channel < 4; ++channel)
+        {
+            const int difference = std::abs(static_cast<int>(cellQuadsImage[offset + channel]) - static_cast<int>(rowQuadsImage[offset + channel]));
+
+            if(difference > tolerance)
+            {
+                ++differentPixelCount;
+                break;
+            };
+        };
+    };
+
+    if(differentPixelCount > 0)
+    {
+        std::cerr << "TerminalGrid: " << differentPixelCount << " of " << (cellQuadsImage.size() / 4) << " pixels differ between the cell quads and the row quads\n";
+        return 1;
+    };
+
+    std::cout << "TerminalGrid: the row quads draw the same image as the cell quads\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Send a TerminalGrid and a document through GridDeltaEncoder messages and apply them to a second grid and document with a GridDeltaDecoder,
+/// comparing both cell for cell after every message: the whole grid, a few changed cells, a scroll, document edits, and a lost message.
+/// Needs the context current on this thread
+/// </summary>
+/// <param name="gridProgram"> A program built from TerminalGridVertexShader.glsl and TerminalGridFragmentShader.glsl </param>
+/// <returns> 0 if the receiver always matched the sender, 1 otherwise </returns>
+int RunGridDeltaTest(const FontSprite& fontSprite, const ShaderProgram& gridProgram)
+{
+    constexpr std::uint32_t rows = 24;
+    constexpr std::uint32_t columns = 80;
+
+    const glm::vec4 foreground = { 0.9f, 0.9f, 0.9f, 1.0f };
+    const glm::vec4 background = { 0.1f, 0.1f, 0.2f, 1.0f };
+
+    TerminalGrid sender = TerminalGrid(fontSprite, gridProgram, rows, columns);
+
+    // The first message resizes it to the sender's size
+    TerminalGrid receiver = TerminalGrid(fontSprite, gridProgram, 1, 1);
+
+    TextBuffer senderDocument = TextBuffer(std::string(InitialDocument));
+    TextBuffer receiverDocument = TextBuffer(std::string(InitialDocument));
+
+    GridDeltaEncoder encoder;
+    GridDeltaDecoder decoder;
+
+    std::vector<std::byte> message;
+
+    // Sends what changed since the last step, and checks the receiver has the sender's cells and document afterwards
+    const auto sendStep = [&](const std::string_view& step)
+    {
+        encoder.Encode(sender);
+
+        if(encoder.TakeMessage(message) == false)
+        {
+            std::cerr << "GridDelta: " << step << ": nothing was encoded\n";
+            return false;
+        };
+
+        if(const GridDeltaResult result = decoder.Apply(message, &receiver, &receiverDocument); result != GridDeltaResult::Applied)
+        {
+            std::cerr << "GridDelta: " << step << ": the message wasn't applied, " << (result == GridDeltaResult::OutOfSequence ? "out of sequence" : "malformed") << "\n";
+            return false;
+        };
+
+        if(receiver.GetRows() != sender.GetRows() || receiver.GetColumns() != sender.GetColumns())
+        {
+            std::cerr << "GridDelta: " << step << ": the receiver is " << receiver.GetRows() << "x" << receiver.GetColumns() << " cells rather than " << rows << "x" << columns << "\n";
+            return false;
+        };
+
+        for(std::uint32_t row = 0; row < rows; ++row)
+        {
+            for(std::uint32_t column = 0; column < columns; ++column)
+            {
+                if(receiver.GetCell(row, column) != sender.GetCell(row, column))
+                {
+                    std::cerr << "GridDelta: " << step << ": the receiver's cell " << row << ", " << column << " differs from the sender's\n";
+                    return false;
+                };
+            };
+        };
+
+        if(receiverDocument.GetText() != senderDocument.GetText())
+        {
+            std::cerr << "GridDelta: " << step << ": the receiver's document differs from the sender's\n";
+            return false;
+        };
+
+        std::cout << "GridDelta: " << step << ", " << message.size() << " bytes\n";
+
+        return true;
+    };
+
+
+    for(std::uint32_t row = 0; row < rows; ++row)
+    {
+        const std::string line = "Row " + std::to_string(row) + ": the quick brown fox jumps over the lazy dog";
+
+        sender.Write(row, 0, line, foreground, background);
+    };
+
+    if(sendStep("the whole grid") == false)
+        return 1;
+
+    sender.Write(3, 10, "changed", { 1.0f, 0.2f, 0.2f, 1.0f }, background, GlyphStyle::Bold);
+    sender.Write(17, 70, "edge of the row", foreground, background);
+
+    if(sendStep("two changed spans") == false)
+        return 1;
+
+    // The scroll is sent as a command, only the rows scrolled into view are sent as cells
+    sender.Scroll(2);
+    encoder.Scroll(2);
+
+    sender.Write(rows - 2, 0, "a line written after scrolling", foreground, background);
+    sender.Write(rows - 1, 0, "and another one", foreground, background);
+
+    if(sendStep("a scroll by 2 rows") == false)
+        return 1;
+
+    senderDocument.Insert(5, " something");
+    encoder.EncodeInsert(5, " something");
+
+    senderDocument.Erase(0, 4);
+    encoder.EncodeErase(0, 4);
+
+    if(sendStep("a document insertion and erasure") == false)
+        return 1;
+
+
+    // A lost message is detected by the next one, which the receiver refuses until the sender starts over with the whole grid
+    sender.Write(0, 0, "lost", foreground, background);
+
+    encoder.Encode(sender);
+    encoder.TakeMessage(message);
+
+    sender.Write(1, 0, "after the lost one", foreground, background);
+
+    encoder.Encode(sender);
+    encoder.TakeMessage(message);
+
+    if(decoder.Apply(message, &receiver, &receiverDocument) != GridDeltaResult::OutOfSequence)
+    {
+        std::cerr << "GridDelta: a message after a lost one was applied\n";
+        return 1;
+    };
+
+    encoder.Reset();
+    decoder.Resynchronize();
+
+    if(sendStep("the whole grid after a lost message") == false)
+        return 1;
+
+    return 0;
+};
+
+
+/// <summary>
+/// The number of pixels of an RGBA8 image that anything was drawn to, for images cleared to transparent
+/// </summary>
+std::size_t CountDrawnPixels(const std::vector<std::byte>& image)
+{
+    std::size_t drawnCount = 0;
+
+    for(std::size_t offset = 3; offset < image.size(); offset += 4)
+    {
+        if(image[offset] != std::byte { 0 })
+            ++drawnCount;
+    };
+
+    return drawnCount;
+};
+
+
+/// <summary>
+/// Draw a few labels through a LabelCache for several frames offscreen, and check each is drawn into the cache once,
+/// again only after its text changed, and that frames drawn from the cache all look the same. Needs the context current on this thread
+/// </summary>
+/// <param name="labelProgram"> A program built from LabelVertexShader.glsl and LabelFragmentShader.glsl </param>
+/// <returns> 0 if the labels were cached and drawn as expected, 1 otherwise </returns>
+int RunLabelCacheTest(FontSprite& fontSprite, const ShaderProgram& labelProgram)
+{
+    const auto fail = [](const std::string_view& message)
+    {
+        std::cerr << "LabelCache: " << message << "\n";
+        return 1;
+    };
+
+    constexpr std::array<std::string_view, 3> labelTexts = { "Lines: 1024", "UTF-8", "Ln 12, Col 40" };
+
+    std::vector<std::vector<std::byte>> images;
+
+    HeadlessRenderer renderer = HeadlessRenderer(512, 128, [&images](const ReadbackImage& readback)
+    {
+        images.resize(std::max<std::size_t>(images.size(), readback.Tag + 1));
+        images[readback.Tag].assign(readback.Pixels.begin(), readback.Pixels.end());
+    });
+
+    LabelCache labels = LabelCache(labelProgram, renderer.GetFrameUniformBuffer());
+
+    for(const std::string_view& text : labelTexts)
+    {
+        const std::size_t label = labels.CreateLabel(fontSprite, text);
+
+        if(labels.GetLabelSize(label).x != text.size() * fontSprite.GetGlyphWidth())
+            return fail("\"" + std::string(text) + "\" isn't as wide as its glyphs");
+    };
+
+    const auto drawFrame = [&]()
+    {
+        renderer.Render([&]()
+        {
+            for(std::size_t label = 0; label < labels.GetLabelCount(); ++label)
+            {
+                labels.Draw(label, { 10.0f, 10.0f + (static_cast<float>(label) * fontSprite.GetLineHeight() * 1.5f) });
+            };
+
+            labels.Flush();
+        });
+
+        labels.EndFrame();
+    };
+
+
+    // The first frame caches every label, the next ones only draw quads
+    drawFrame();
+
+    if(labels.GetCacheDrawCount() != labelTexts.size())
+        return fail("the first frame drew " + std::to_string(labels.GetCacheDrawCount()) + " labels into the cache rather than " + std::to_string(labelTexts.size()));
+
+    drawFrame();
+
+    // Setting a label to what it holds keeps it cached
+    labels.SetLabel(0, fontSprite, labelTexts[0], { 0.0f, 0.0f, 0.0f, 1.0f });
+
+    drawFrame();
+
+    if(labels.GetCacheDrawCount() != labelTexts.size())
+        return fail("unchanged labels were drawn into the cache again");
+
+    labels.SetLabel(0, fontSprite, "Lines: 1025", { 0.0f, 0.0f, 0.0f, 1.0f });
+
+    drawFrame();
+
+    if(labels.GetCacheDrawCount() != labelTexts.size() + 1)
+        return fail("a changed label wasn't drawn into the cache exactly once");
+
+    renderer.Finish();
+
+
+    if(images.size() != 4)
+        return fail(std::to_string(images.size()) + " of 4 frames were read back");
+
+    if(CountDrawnPixels(images[0]) == 0)
+        return fail("the labels drew nothing");
+
+    if(images[1] != images[0] || images[2] != images[0])
+        return fail("frames drawn from the cache differ from the first one");
+
+    if(images[3] == images[0])
+        return fail("the changed label looks the same");
+
+    std::cout << "LabelCache: " << labels.GetLabelCount() << " labels, " << labels.GetCacheDrawCount() << " drawn into the cache over " << images.size() << " frames\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Draw a line of text offscreen with a TextAnimator's tracks at fixed times, and check a fade hides it, a typewriter shows only its first glyphs,
+/// a wave moves it down, and the glyphs are drawn as laid out again once the tracks finished. Needs the context current on this thread
+/// </summary>
+/// <param name="animatedProgram"> The font's program built with FontShaderFeature::Animation </param>
+/// <returns> 0 if every frame looked as expected, 1 otherwise </returns>
+int RunTextAnimationTest(FontSprite& fontSprite, const ShaderProgram& animatedProgram, const float atlasScale)
+{
+    const auto fail = [](const std::string_view& message)
+    {
+        std::cerr << "TextAnimation: " << message << "\n";
+        return 1;
+    };
+
+    constexpr std::string_view text = "Animated text";
+
+    constexpr float margin = 10.0f;
+    constexpr float waveHeight = 20.0f;
+
+    const std::uint32_t width = static_cast<std::uint32_t>(text.size() * fontSprite.GetGlyphWidth()) + 20;
+    const std::uint32_t height = (fontSprite.GetGlyphHeight() * 2) + 40;
+
+    std::vector<std::vector<std::byte>> images;
+
+    HeadlessRenderer renderer = HeadlessRenderer(width, height, [&images](const ReadbackImage& readback)
+    {
+        images.resize(std::max<std::size_t>(images.size(), readback.Tag + 1));
+        images[readback.Tag].assign(readback.Pixels.begin(), readback.Pixels.end());
+    });
+
+    TextAnimator animator = TextAnimator(1024);
+
+    const ShaderProgram& previousProgram = fontSprite.GetShaderProgram();
+
+    fontSprite.SetShaderProgram(animatedProgram);
+    fontSprite.Transform = GetContentScaleTransform({ margin, margin }, 1.0f, atlasScale);
+
+    // The headless frames are all drawn at time 0, the tracks start relative to it. The CPU's time only decides which tracks finished
+    const auto drawFrame = [&](const double time)
+    {
+        renderer.Render([&]()
+        {
+            animator.Update(time);
+
+            fontSprite.Bind();
+            fontSprite.Draw(text, { 0.0f, 0.0f, 0.0f, 1.0f });
+        });
+
+        fontSprite.EndFrame();
+    };
+
+    // Plain draws lay their glyphs out from instance 0
+    const std::uint32_t glyphCount = static_cast<std::uint32_t>(text.size());
+
+    drawFrame(0.0);
+
+    animator.Play(TextAnimationTrack { .FirstInstance = 0, .InstanceCount = glyphCount, .Effect = TextAnimationEffect::Fade, .StartTime = 0.0f, .Duration = 1.0f });
+
+    drawFrame(0.0);
+
+    // Started 2.5 seconds ago, a glyph a second, so the first 3 glyphs are shown. Replaces the fade, which plays from the same instance
+    animator.Play(TextAnimationTrack { .FirstInstance = 0, .InstanceCount = glyphCount, .Effect = TextAnimationEffect::Typewriter, .StartTime = -2.5f, .Duration = 0.0f, .Stagger = 1.0f });
+
+    drawFrame(0.0);
+
+    // A quarter of the way through its period, at the bottom of the wave
+    animator.Play(TextAnimationTrack { .FirstInstance = 0, .InstanceCount = glyphCount, .Effect = TextAnimationEffect::Wave, .StartTime = -1.0f, .Duration = 4.0f, .Offset = { 0.0f, waveHeight } });
+
+    drawFrame(0.0);
+
+    // The wave never finishes on its own
+    animator.Stop(0);
+
+    drawFrame(1.0);
+
+    renderer.Finish();
+
+    fontSprite.SetShaderProgram(previousProgram);
+
+
+    if(images.size() != 5)
+        return fail(std::to_string(images.size()) + " of 5 frames were read back");
+
+    // The pixels drawn in the image's columns from one on, and the highest row drawn to, from the top
+    const auto measure = [&](const std::vector<std::byte>& image, const std::uint32_t firstColumn)
+    {
+        std::size_t drawnCount = 0;
+        std::uint32_t topRow = height;
+
+        for(std::uint32_t row = 0; row < height; ++row)
+        {
+            for(std::uint32_t column = firstColumn; column < width; ++column)
+            {
+                if(image[((static_cast<std::size_t>(row) * width + column) * 4) + 3] == std::byte { 0 })
+                    continue;
+
+                ++drawnCount;
+
+                // Read back from the bottom up
+                topRow = std::min(topRow, height - 1 - row);
+            };
+        };
+
+        return std::pair<std::size_t, std::uint32_t>(drawnCount, topRow);
+    };
+
+    const auto [laidOutCount, laidOutTop] = measure(images[0], 0);
+
+    if(laidOutCount == 0)
+        return fail("the text drew nothing");
+
+    if(measure(images[1], 0).first != 0)
+        return fail("a fade at its start didn't hide the text");
+
+    // Past the third glyph, with half a glyph left for its overhang
+    const std::uint32_t fourthGlyphColumn = static_cast<std::uint32_t>(margin) + (3 * fontSprite.GetGlyphWidth()) + (fontSprite.GetGlyphWidth() / 2);
+
+    const std::size_t typewriterCount = measure(images[2], 0).first;
+
+    if(typewriterCount == 0 || typewriterCount >= laidOutCount || measure(images[2], fourthGlyphColumn).first != 0)
+        return fail("the typewriter didn't show exactly the first 3 glyphs");
+
+    const std::uint32_t waveTop = measure(images[3], 0).second;
+
+    if(std::abs(static_cast<int>(waveTop) - static_cast<int>(laidOutTop + static_cast<std::uint32_t>(waveHeight))) > 1)
+        return fail("the wave moved the text by " + std::to_string(static_cast<int>(waveTop) - static_cast<int>(laidOutTop)) + " pixels rather than " + std::to_string(waveHeight));
+
+    if(images[4] != images[0])
+        return fail("the glyphs weren't put back once the tracks stopped");
+
+    if(animator.GetTrackCount() != 0)
+        return fail("a stopped track is still playing");
+
+    std::cout << "TextAnimation: " << glyphCount << " glyphs faded, typed and waved, " << typewriterCount << " of " << laidOutCount << " pixels typed\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Cull a LabelGrid's labels against a few views, checking the visible ones against every label's rectangle, that no two placed labels overlap
+/// and that the higher priority of two overlapping labels wins, then draw two of the views offscreen through a TextBatch.
+/// Needs the context current on this thread
+/// </summary>
+/// <param name="batchProgram"> The font's fragment shader behind TextBatchVertexShader.glsl </param>
+/// <returns> 0 if every view culled and placed as expected, 1 otherwise </returns>
+int RunLabelGridTest(FontSprite& fontSprite, const ShaderProgram& batchProgram)
+{
+    const auto fail = [](const std::string_view& message)
+    {
+        std::cerr << "LabelGrid: " << message << "\n";
+        return 1;
+    };
+
+    struct TestLabel
+    {
+        std::string Text;
+        glm::vec2 Position = { 0.0f, 0.0f };
+        glm::vec2 Size = { 0.0f, 0.0f };
+        float Priority = 0.0f;
+    };
+
+    constexpr std::uint32_t width = 512;
+    constexpr std::uint32_t height = 256;
+
+    constexpr std::uint32_t gridSize = 32;
+
+    const float glyphWidth = static_cast<float>(fontSprite.GetGlyphWidth());
+    const float lineHeight = static_cast<float>(fontSprite.GetLineHeight());
+
+    // Spaced so that, unzoomed, the grid's labels never come within each other's margin
+    const float spacing = (glyphWidth * 8.0f) + 20.0f;
+
+    std::vector<TestLabel> testLabels;
+
+    for(std::uint32_t row = 0; row < gridSize; ++row)
+    {
+        for(std::uint32_t column = 0; column < gridSize; ++column)
+        {
+            const std::string text = "L" + std::to_string(row) + "-" + std::to_string(column);
+
+            testLabels.emplace_back(TestLabel
+            {
+                .Text = text,
+                .Position = { static_cast<float>(column) * spacing, (static_cast<float>(row) * spacing) + (lineHeight * 2.0f) },
+                .Size = { glyphWidth * static_cast<float>(text.size()), lineHeight },
+            });
+        };
+    };
+
+    // Two labels overlapping above the grid, the low priority one added first so only the priority decides between them
+    const LabelGrid::LabelID lowLabel = static_cast<LabelGrid::LabelID>(testLabels.size());
+    const LabelGrid::LabelID highLabel = lowLabel + 1;
+
+    testLabels.emplace_back(TestLabel { .Text = "Low", .Position = { 4.0f, 2.0f }, .Size = { glyphWidth * 3.0f, lineHeight }, .Priority = 0.0f });
+    testLabels.emplace_back(TestLabel { .Text = "High", .Position = { 8.0f, 4.0f }, .Size = { glyphWidth * 4.0f, lineHeight }, .Priority = 1.0f });
+
+    LabelGrid grid = LabelGrid(spacing * 2.0f);
+
+    for(const TestLabel& label : testLabels)
+    {
+        grid.Add(label.Text, label.Position, label.Size, { 0.0f, 0.0f, 0.0f, 1.0f }, 0, label.Priority);
+    };
+
+    if(grid.GetLabelCount() != testLabels.size())
+        return fail("the grid holds " + std::to_string(grid.GetLabelCount()) + " of " + std::to_string(testLabels.size()) + " labels");
+
+
+    const auto getScreenRect = [&](const LabelView& view, const LabelGrid::LabelID id)
+    {
+        const glm::vec2 screenPosition = view.WorldToScreen(testLabels[id].Position);
+
+        return glm::vec4(screenPosition, screenPosition + testLabels[id].Size);
+    };
+
+    std::vector<LabelGrid::LabelID> placedLabels;
+
+    // Culls the view and checks the grid against every label, returning what went wrong, if anything
+    const auto checkView = [&](const LabelView& view, const std::string_view& name) -> std::string
+    {
+        placedLabels = grid.Cull(view);
+
+        std::size_t visibleCount = 0;
+
+        for(LabelGrid::LabelID id = 0; id < testLabels.size(); ++id)
+        {
+            const glm::vec4 rect = getScreenRect(view, id);
+
+            if(rect.z > 0.0f && rect.w > 0.0f && rect.x < view.ViewportSize.x && rect.y < view.ViewportSize.y)
+                ++visibleCount;
+        };
+
+        if(grid.GetVisibleCount() != visibleCount)
+            return std::string(name) + " found " + std::to_string(grid.GetVisibleCount()) + " labels on screen rather than " + std::to_string(visibleCount);
+
+        if(placedLabels.empty() == true)
+            return std::string(name) + " placed no labels";
+
+        if(grid.RejectOverlaps == false)
+            return std::string();
+
+        for(std::size_t index = 0; index < placedLabels.size(); ++index)
+        {
+            const glm::vec4 rect = getScreenRect(view, placedLabels[index]);
+
+            for(std::size_t otherIndex = 0; otherIndex < index; ++otherIndex)
+            {
+                const glm::vec4 otherRect = getScreenRect(view, placedLabels[otherIndex]);
+
+                if(rect.x < otherRect.z && otherRect.x < rect.z && rect.y < otherRect.w && otherRect.y < rect.w)
+                    return std::string(name) + " placed \"" + testLabels[placedLabels[index]].Text + "\" over \"" + testLabels[placedLabels[otherIndex]].Text + "\"";
+            };
+        };
+
+        return std::string();
+    };
+
+    const auto isPlaced = [&](const LabelGrid::LabelID id)
+    {
+        return std::find(placedLabels.cbegin(), placedLabels.cend(), id) != placedLabels.cend();
+    };
+
+    const glm::vec2 viewportSize = { static_cast<float>(width), static_cast<float>(height) };
+
+    const LabelView homeView = LabelView { .Origin = { 0.0f, 0.0f }, .Scale = 1.0f, .ViewportSize = viewportSize };
+    const LabelView pannedView = LabelView { .Origin = glm::vec2(spacing * 16.0f), .Scale = 1.0f, .ViewportSize = viewportSize };
+    const LabelView zoomedOutView = LabelView { .Origin = { 0.0f, 0.0f }, .Scale = 0.125f, .ViewportSize = viewportSize };
+
+
+    if(const std::string error = checkView(homeView, "the home view"); error.empty() == false)
+        return fail(error);
+
+    if(isPlaced(highLabel) == false || isPlaced(lowLabel) == true)
+        return fail("the lower priority of two overlapping labels was placed");
+
+    const std::size_t homePlacedCount = placedLabels.size();
+
+    if(const std::string error = checkView(pannedView, "the panned view"); error.empty() == false)
+        return fail(error);
+
+    if(isPlaced(highLabel) == true || grid.GetPlacedCount() != grid.GetVisibleCount())
+        return fail("the panned view placed labels off screen, or left out ones that don't overlap");
+
+    if(const std::string error = checkView(zoomedOutView, "the zoomed out view"); error.empty() == false)
+        return fail(error);
+
+    if(grid.GetPlacedCount() >= grid.GetVisibleCount())
+        return fail("zoomed out, no overlapping labels were left out");
+
+    const std::size_t zoomedOutPlacedCount = placedLabels.size();
+
+    grid.RejectOverlaps = false;
+
+    if(const std::string error = checkView(zoomedOutView, "the zoomed out view"); error.empty() == false)
+        return fail(error);
+
+    if(grid.GetPlacedCount() != grid.GetVisibleCount())
+        return fail("without rejecting overlaps, only " + std::to_string(grid.GetPlacedCount()) + " of " + std::to_string(grid.GetVisibleCount()) + " labels were placed");
+
+    grid.RejectOverlaps = true;
+
+
+    std::vector<std::vector<std::byte>> images;
+
+    HeadlessRenderer renderer = HeadlessRenderer(width, height, [&images](const ReadbackImage& readback)
+    {
+        images.resize(std::max<std::size_t>(images.size(), readback.Tag + 1));
+        images[readback.Tag].assign(readback.Pixels.begin(), readback.Pixels.end());
+    });
+
+    TextBatch batch = TextBatch(fontSprite, batchProgram);
+
+    std::string submitError;
+
+    const auto drawFrame = [&](const LabelView& view)
+    {
+        renderer.Render([&]()
+        {
+            batch.Begin();
+
+            grid.Submit(batch, view);
+
+            std::size_t glyphCount = 0;
+
+            for(const LabelGrid::LabelID id : grid.Cull(view))
+            {
+                glyphCount += testLabels[id].Text.size();
+            };
+
+            if(batch.GetGlyphCount() != glyphCount && submitError.empty() == true)
+                submitError = "submitted " + std::to_string(batch.GetGlyphCount()) + " glyphs rather than the placed labels' " + std::to_string(glyphCount);
+
+            batch.Flush();
+        });
+
+        batch.EndFrame();
+    };
+
+    drawFrame(homeView);
+    drawFrame(pannedView);
+
+    renderer.Finish();
+
+
+    if(submitError.empty() == false)
+        return fail(submitError);
+
+    if(images.size() != 2)
+        return fail(std::to_string(images.size()) + " of 2 frames were read back");
+
+    if(CountDrawnPixels(images[0]) == 0 || CountDrawnPixels(images[1]) == 0)
+        return fail("the placed labels drew nothing");
+
+    if(images[1] == images[0])
+        return fail("panning didn't change the labels drawn");
+
+    std::cout << "LabelGrid: " << grid.GetLabelCount() << " labels, " << homePlacedCount << " placed at home, " << zoomedOutPlacedCount << " zoomed out\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Record overlapping, clipped panels of text into a TextDrawListSet from one worker thread each, started last panel first,
+/// then submit the lists to a TextBatch and flush it, and check the frame matches the same text submitted straight to the batch in panel order.
+/// A second recorded frame checks the lists draw the same once reused. Needs the context current on this thread
+/// </summary>
+/// <param name="batchProgram"> The font's fragment shader behind TextBatchVertexShader.glsl </param>
+/// <returns> 0 if the recorded frames matched the direct one, 1 otherwise </returns>
+int RunTextDrawListTest(FontSprite& fontSprite, const ShaderProgram& batchProgram)
+{
+    const auto fail = [](const std::string_view& message)
+    {
+        std::cerr << "TextDrawList: " << message << "\n";
+        return 1;
+    };
+
+    constexpr std::uint32_t panelCount = 4;
+
+    constexpr std::array<glm::vec4, panelCount> panelColours =
+    {
+        glm::vec4(0.8f, 0.1f, 0.1f, 0.75f),
+        glm::vec4(0.1f, 0.6f, 0.1f, 0.75f),
+        glm::vec4(0.1f, 0.1f, 0.8f, 0.75f),
+        glm::vec4(0.0f, 0.0f, 0.0f, 0.75f),
+    };
+
+    const float glyphWidth = static_cast<float>(fontSprite.GetGlyphWidth());
+    const float lineHeight = static_cast<float>(fontSprite.GetLineHeight());
+
+    // Each panel is 12 glyphs wide and reaches a glyph and a half into the next, so the order the panels are drawn in shows
+    const glm::vec2 panelSize = { glyphWidth * 12.0f, lineHeight * 3.0f };
+    const float panelStep = panelSize.x - (glyphWidth * 1.5f);
+
+    const std::uint32_t width = static_cast<std::uint32_t>((panelStep * static_cast<float>(panelCount - 1)) + panelSize.x) + 20;
+    const std::uint32_t height = static_cast<std::uint32_t>(panelSize.y) + 20;
+
+    // Longer than the panel, so the clip cuts every line
+    const auto getLine = [](const std::uint32_t panel, const std::uint32_t line)
+    {
+        return "Panel " + std::to_string(panel) + ", line " + std::to_string(line) + " runs past its clip";
+    };
+
+    const auto getPanelPosition = [&](const std::uint32_t panel)
+    {
+        return glm::vec2((panelStep * static_cast<float>(panel)) + 10.0f, 10.0f);
+    };
+
+
+    std::vector<std::vector<std::byte>> images;
+
+    HeadlessRenderer renderer = HeadlessRenderer(width, height, [&images](const ReadbackImage& readback)
+    {
+        images.resize(std::max<std::size_t>(images.size(), readback.Tag + 1));
+        images[readback.Tag].assign(readback.Pixels.begin(), readback.Pixels.end());
+    });
+
+    TextBatch batch = TextBatch(fontSprite, batchProgram);
+
+    TextDrawListSet lists;
+
+    std::array<std::size_t, 2> glyphCounts = { 0, 0 };
+
+    // The reference, each panel submitted straight to the batch in order
+    renderer.Render([&]()
+    {
+        batch.Begin();
+
+        for(std::uint32_t panel = 0; panel < panelCount; ++panel)
+        {
+            const glm::vec2 panelPosition = getPanelPosition(panel);
+
+            batch.PushClip({ panelPosition, panelPosition + panelSize });
+
+            for(std::uint32_t line = 0; line < 3; ++line)
+            {
+                batch.Submit(getLine(panel, line), panelPosition + glm::vec2(0.0f, lineHeight * static_cast<float>(line)), panelColours[panel]);
+            };
+
+            batch.PopClip();
+        };
+
+        glyphCounts[0] = batch.GetGlyphCount();
+
+        batch.Flush();
+    });
+
+    batch.EndFrame();
+
+    // Each worker records its panel relative to the list's offset
+    const auto drawRecordedFrame = [&]()
+    {
+        std::vector<std::thread> workers;
+
+        for(std::uint32_t panel = panelCount; panel-- > 0;)
+        {
+            workers.emplace_back([&, panel]()
+            {
+                TextDrawList& list = lists.Acquire(panel);
+
+                list.Offset = getPanelPosition(panel);
+
+                list.PushClip({ 0.0f, 0.0f, panelSize.x, panelSize.y });
+
+                for(std::uint32_t line = 0; line < 3; ++line)
+                {
+                    list.Add(getLine(panel, line), { 0.0f, lineHeight * static_cast<float>(line) }, panelColours[panel]);
+                };
+
+                list.PopClip();
+            });
+        };
+
+        for(std::thread& worker : workers)
+        {
+            worker.join();
+        };
+
+        renderer.Render([&]()
+        {
+            batch.Begin();
+
+            lists.Submit(batch);
+
+            glyphCounts[1] = batch.GetGlyphCount();
+
+            batch.Flush();
+        });
+
+        batch.EndFrame();
+    };
+
+    drawRecordedFrame();
+
+    if(glyphCounts[1] != glyphCounts[0])
+        return fail("the lists submitted " + std::to_string(glyphCounts[1]) + " glyphs rather than " + std::to_string(glyphCounts[0]));
+
+    // The second frame reuses the lists the first one acquired
+    drawRecordedFrame();
+
+    if(glyphCounts[1] != glyphCounts[0])
+        return fail("the reused lists submitted " + std::to_string(glyphCounts[1]) + " glyphs rather than " + std::to_string(glyphCounts[0]));
+
+    renderer.Finish();
+
+
+    if(images.size() != 3)
+        return fail(std::to_string(images.size()) + " of 3 frames were read back");
+
+    if(CountDrawnPixels(images[0]) == 0)
+        return fail("the panels drew nothing");
+
+    if(images[1] != images[0])
+        return fail("the recorded lists drew differently from the direct submits");
+
+    if(images[2] != images[0])
+        return fail("the reused lists drew differently from the direct submits");
+
+    std::cout << "TextDrawList: " << panelCount << " panels recorded on " << panelCount << " threads, " << glyphCounts[0] << " glyphs, matching the direct submits\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Scroll a TableView of a million rows through a TextBatch offscreen, and check only the visible cells are formatted,
+/// scrolling back formats nothing and draws the same, a row's new version formats only its cells again, and scrolling is clamped to the rows.
+/// Needs the context current on this thread
+/// </summary>
+/// <param name="batchProgram"> The font's fragment shader behind TextBatchVertexShader.glsl </param>
+/// <returns> 0 if every frame formatted and drew as expected, 1 otherwise </returns>
+int RunTableViewTest(FontSprite& fontSprite, const ShaderProgram& batchProgram)
+{
+    const auto fail = [](const std::string_view& message)
+    {
+        std::cerr << "TableView: " << message << "\n";
+        return 1;
+    };
+
+    class TestTableSource : public ITableSource
+    {
+
+    public:
+
+        std::size_t ChangedRow = 0;
+
+        std::uint64_t ChangedRowVersion = 0;
+
+
+    public:
+
+        std::size_t GetRowCount() const override
+        {
+            return 1000000;
+        };
+
+        void FormatCell(const std::size_t row, const std::size_t column, std::string& text) const override
+        {
+            const std::uint64_t version = GetRowVersion(row);
+
+            if(column == 0)
+                text = std::to_string(row);
+            else if(column == 1)
+                text = std::to_string(((row * 7919) % 1000) + version);
+            else
+                text = "Item " + std::to_string(row) + (version != 0 ? " was changed" : " has a name longer than its column");
+        };
+
+        std::uint64_t GetRowVersion(const std::size_t row) const override
+        {
+            return row == ChangedRow ? ChangedRowVersion : 0;
+        };
+
+    };
+
+    constexpr std::size_t visibleRowCount = 8;
+
+    const float glyphWidth = static_cast<float>(fontSprite.GetGlyphWidth());
+    const float rowHeight = static_cast<float>(fontSprite.GetLineHeight());
+
+    std::vector<TableColumn> columns =
+    {
+        TableColumn { .Header = "Row", .Width = glyphWidth * 10.0f, .Alignment = TableAlignment::Right },
+        TableColumn { .Header = "Value", .Width = glyphWidth * 8.0f, .Alignment = TableAlignment::Right },
+        TableColumn { .Header = "Name", .Width = glyphWidth * 16.0f },
+    };
+
+    const std::size_t columnCount = columns.size();
+
+    // The header and whole rows, the line height is whole pixels so the rows line up exactly wherever they're scrolled to
+    const glm::vec2 viewportSize = { glyphWidth * 34.0f, rowHeight * static_cast<float>(visibleRowCount + 1) };
+
+    const std::uint32_t width = static_cast<std::uint32_t>(viewportSize.x) + 20;
+    const std::uint32_t height = static_cast<std::uint32_t>(viewportSize.y) + 20;
+
+    TestTableSource source;
+
+    TableView table = TableView(rowHeight, glyphWidth, viewportSize);
+
+    table.Origin = { 10.0f, 10.0f };
+    table.SetColumns(std::move(columns));
+    table.SetSource(&source);
+
+
+    std::vector<std::vector<std::byte>> images;
+
+    HeadlessRenderer renderer = HeadlessRenderer(width, height, [&images](const ReadbackImage& readback)
+    {
+        images.resize(std::max<std::size_t>(images.size(), readback.Tag + 1));
+        images[readback.Tag].assign(readback.Pixels.begin(), readback.Pixels.end());
+    });
+
+    TextBatch batch = TextBatch(fontSprite, batchProgram);
+
+    // Returns how many cells the frame formatted
+    const auto drawFrame = [&]()
+    {
+        const std::uint64_t formattedCellCount = table.GetFormattedCellCount();
+
+        renderer.Render([&]()
+        {
+            batch.Begin();
+
+            table.Submit(batch);
+
+            batch.Flush();
+        });
+
+        batch.EndFrame();
+
+        return table.GetFormattedCellCount() - formattedCellCount;
+    };
+
+    const std::uint64_t visibleCellCount = visibleRowCount * columnCount;
+
+
+    if(const std::uint64_t formattedCount = drawFrame(); formattedCount != visibleCellCount)
+        return fail("the first frame formatted " + std::to_string(formattedCount) + " cells rather than the " + std::to_string(visibleCellCount) + " visible");
+
+    table.ScrollToRow(500000);
+
+    if(const std::uint64_t formattedCount = drawFrame(); formattedCount != visibleCellCount)
+        return fail("half way down, " + std::to_string(formattedCount) + " cells were formatted rather than the " + std::to_string(visibleCellCount) + " visible");
+
+    table.ScrollToRow(0);
+
+    if(const std::uint64_t formattedCount = drawFrame(); formattedCount != 0)
+        return fail("scrolling back formatted " + std::to_string(formattedCount) + " cached cells again");
+
+    source.ChangedRow = 3;
+    source.ChangedRowVersion = 1;
+
+    if(const std::uint64_t formattedCount = drawFrame(); formattedCount != columnCount)
+        return fail("a changed row formatted " + std::to_string(formattedCount) + " cells rather than its " + std::to_string(columnCount));
+
+    renderer.Finish();
+
+
+    // Past the last row the scroll stops with the last row at the bottom
+    table.ScrollTo(1e12);
+
+    const double lastScrollOffset = (static_cast<double>(source.GetRowCount()) * rowHeight) - (rowHeight * static_cast<double>(visibleRowCount));
+
+    if(table.GetScrollOffset() != lastScrollOffset)
+        return fail("scrolling past the end stopped at " + std::to_string(table.GetScrollOffset()) + " rather than " + std::to_string(lastScrollOffset));
+
+    const glm::vec2 lastRowPoint = table.Origin + glm::vec2(glyphWidth * 20.0f, viewportSize.y - (rowHeight * 0.5f));
+
+    if(table.GetRowAt(lastRowPoint) != source.GetRowCount() - 1 || table.GetColumnAt(lastRowPoint) != 2)
+        return fail("the bottom of the scrolled view isn't the last row's name");
+
+    if(table.GetRowAt(table.Origin + glm::vec2(1.0f, 1.0f)) != source.GetRowCount())
+        return fail("the header was hit as a row");
+
+
+    if(images.size() != 4)
+        return fail(std::to_string(images.size()) + " of 4 frames were read back");
+
+    if(CountDrawnPixels(images[0]) == 0)
+        return fail("the table drew nothing");
+
+    if(images[1] == images[0])
+        return fail("scrolling didn't change the rows drawn");
+
+    if(images[2] != images[0])
+        return fail("the cached cells drew differently from the formatted ones");
+
+    if(images[3] == images[0])
+        return fail("the changed row looks the same");
+
+    std::cout << "TableView: " << source.GetRowCount() << " rows, " << table.GetFormattedCellCount() << " cells formatted over " << images.size() << " frames\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Draw a few ImmediateText labels offscreen every frame, and check unchanged labels are drawn from their cached runs without laying out new ones,
+/// a changed label is laid out once, moving a label only moves it, and labels that weren't drawn in a frame are forgotten.
+/// Enables the sprite's glyph run cache. Needs the context current on this thread
+/// </summary>
+/// <param name="queuedProgram"> The font's program built with FontShaderFeature::MultiDraw </param>
+/// <returns> 0 if every frame looked as expected, 1 otherwise </returns>
+int RunImmediateTextTest(FontSprite& fontSprite, const ShaderProgram& queuedProgram, const float atlasScale)
+{
+    const auto fail = [](const std::string_view& message)
+    {
+        std::cerr << "ImmediateText: " << message << "\n";
+        return 1;
+    };
+
+    struct TestLabel
+    {
+        std::string_view ID;
+        std::string_view Text;
+        glm::vec2 Position = { 0.0f, 0.0f };
+    };
+
+    const float lineHeight = static_cast<float>(fontSprite.GetLineHeight());
+
+    const std::uint32_t width = (fontSprite.GetGlyphWidth() * 24) + 40;
+    const std::uint32_t height = (fontSprite.GetLineHeight() * 5) + 20;
+
+    std::vector<std::vector<std::byte>> images;
+
+    HeadlessRenderer renderer = HeadlessRenderer(width, height, [&images](const ReadbackImage& readback)
+    {
+        images.resize(std::max<std::size_t>(images.size(), readback.Tag + 1));
+        images[readback.Tag].assign(readback.Pixels.begin(), readback.Pixels.end());
+    });
+
+    const ShaderProgram& previousProgram = fontSprite.GetShaderProgram();
+
+    fontSprite.SetShaderProgram(queuedProgram);
+    fontSprite.EnableGlyphRunCache();
+    fontSprite.Transform = GetContentScaleTransform({ 10.0f, 10.0f }, 1.0f, atlasScale);
+
+    ImmediateText immediateText = ImmediateText(fontSprite);
+
+    // Returns how many runs the frame laid out
+    const auto drawFrame = [&](const std::vector<TestLabel>& labels)
+    {
+        const std::size_t runCount = fontSprite.GetCachedRunCount();
+
+        renderer.Render([&]()
+        {
+            for(const TestLabel& label : labels)
+            {
+                immediateText.Text(label.ID, label.Text, label.Position);
+            };
+
+            immediateText.EndFrame();
+        });
+
+        fontSprite.EndFrame();
+
+        return fontSprite.GetCachedRunCount() - runCount;
+    };
+
+    const TestLabel title = TestLabel { .ID = "title", .Text = "ImmediateText", .Position = { 0.0f, 0.0f } };
+    const TestLabel frameRate = TestLabel { .ID = "fps", .Text = "60 fps", .Position = { 0.0f, lineHeight * 1.5f } };
+    const TestLabel status = TestLabel { .ID = "status", .Text = "Ready", .Position = { 0.0f, lineHeight * 3.0f } };
+
+
+    if(const std::size_t laidOutCount = drawFrame({ title, frameRate, status }); laidOutCount != 3)
+        return fail("the first frame laid out " + std::to_string(laidOutCount) + " runs rather than 3");
+
+    if(const std::size_t laidOutCount = drawFrame({ title, frameRate, status }); laidOutCount != 0)
+        return fail("unchanged labels laid out " + std::to_string(laidOutCount) + " runs again");
+
+    if(const std::size_t laidOutCount = drawFrame({ title, frameRate, TestLabel { .ID = status.ID, .Text = "Busy", .Position = status.Position } }); laidOutCount != 1)
+        return fail("a changed label laid out " + std::to_string(laidOutCount) + " runs rather than 1");
+
+    if(immediateText.GetStringCount() != 4)
+        return fail("the labels hold " + std::to_string(immediateText.GetStringCount()) + " strings rather than 4");
+
+    if(const std::size_t laidOutCount = drawFrame({ title, frameRate }); laidOutCount != 0 || immediateText.GetLabelCount() != 2)
+        return fail("a label that wasn't drawn is still known, or the others were laid out again");
+
+    if(const std::size_t laidOutCount = drawFrame({ title, TestLabel { .ID = frameRate.ID, .Text = frameRate.Text, .Position = frameRate.Position + glm::vec2(40.0f, 0.0f) } }); laidOutCount != 0)
+        return fail("moving a label laid it out again");
+
+    renderer.Finish();
+
+    fontSprite.SetShaderProgram(previousProgram);
+
+
+    if(images.size() != 5)
+        return fail(std::to_string(images.size()) + " of 5 frames were read back");
+
+    if(CountDrawnPixels(images[0]) == 0)
+        return fail("the labels drew nothing");
+
+    if(images[1] != images[0])
+        return fail("the cached labels drew differently from the laid out ones");
+
+    if(images[2] == images[0])
+        return fail("the changed label looks the same");
+
+    if(CountDrawnPixels(images[3]) >= CountDrawnPixels(images[2]))
+        return fail("the label left out was still drawn");
+
+    if(images[4] == images[3])
+        return fail("the moved label didn't move");
+
+    std::cout << "ImmediateText: " << fontSprite.GetCachedRunCount() << " runs laid out over " << images.size() << " frames\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Draw a Minimap of a hundred thousand generated lines offscreen, and check a view renders only the tiles it shows, drawing a view again renders
+/// nothing and looks the same, an edited line renders only its tile again, and scrolling through more tiles than are cached evicts the oldest.
+/// Needs the context current on this thread
+/// </summary>
+/// <param name="drawProgram"> The program built from MinimapVertexShader.glsl and MinimapFragmentShader.glsl </param>
+/// <returns> 0 if every frame rendered and drew as expected, 1 otherwise </returns>
+int RunMinimapTest(const ShaderProgram& drawProgram)
+{
+    const auto fail = [](const std::string_view& message)
+    {
+        std::cerr << "Minimap: " << message << "\n";
+        return 1;
+    };
+
+    // Lines of varying length, every tenth one starting with a coloured span
+    class TestMinimapSource : public IMinimapSource
+    {
+
+    private:
+
+        /// <summary>
+        /// The text GetLines returned last
+        /// </summary>
+        mutable std::string _lines;
+
+
+    public:
+
+        std::size_t ChangedLine = std::numeric_limits<std::size_t>::max();
+
+
+    public:
+
+        std::size_t GetLineCount() const override
+        {
+            return 100000;
+        };
+
+        std::string_view GetLines(const std::size_t firstLine, const std::size_t endLine) const override
+        {
+            _lines.clear();
+
+            for(std::size_t line = firstLine; line < endLine; ++line)
+            {
+                const std::size_t length = line == ChangedLine ? 0 : (line % 113);
+
+                _lines.append(length, static_cast<char>('a' + (line % 26)));
+
+                if(line + 1 < endLine)
+                    _lines.push_back('\n');
+            };
+
+            return _lines;
+        };
+
+        void GetSpans(const std::size_t firstLine, const std::size_t endLine, std::vector<TextSpan>& spans) const override
+        {
+            std::uint32_t lineStart = 0;
+
+            for(std::size_t line = firstLine; line < endLine; ++line)
+            {
+                const std::uint32_t length = line == ChangedLine ? 0 : static_cast<std::uint32_t>(line % 113);
+
+                if(line % 10 == 0)
+                {
+                    spans.emplace_back(TextSpan { .FirstCharacter = lineStart, .Colour = PackSpanColour({ 0.8f, 0.1f, 0.1f, 1.0f }) });
+                    spans.emplace_back(TextSpan { .FirstCharacter = lineStart + (length / 2), .Colour = PackSpanColour({ 0.0f, 0.0f, 0.0f, 0.6f }) });
+                };
+
+                lineStart += length + 1;
+            };
+        };
+
+    };
+
+    constexpr std::uint32_t tileLines = 256;
+    constexpr std::uint32_t tileCapacity = 16;
+
+    // 250 lines of 2 pixels, so a view starting on a tile's first line shows only that tile
+    const glm::vec4 rect = { 10.0f, 10.0f, 120.0f, 500.0f };
+
+    constexpr std::uint32_t width = 140;
+    constexpr std::uint32_t height = 520;
+
+    TestMinimapSource source;
+
+    Minimap minimap = Minimap(drawProgram, 120, tileLines, tileCapacity, { 1, 2 });
+
+
+    std::vector<std::vector<std::byte>> images;
+
+    HeadlessRenderer renderer = HeadlessRenderer(width, height, [&images](const ReadbackImage& readback)
+    {
+        images.resize(std::max<std::size_t>(images.size(), readback.Tag + 1));
+        images[readback.Tag].assign(readback.Pixels.begin(), readback.Pixels.end());
+    });
+
+    // Returns how many tiles the frame rendered
+    const auto drawFrame = [&](const std::vector<std::size_t>& firstLines)
+    {
+        const std::uint64_t renderedTileCount = minimap.GetRenderedTileCount();
+
+        renderer.Render([&]()
+        {
+            for(const std::size_t firstLine : firstLines)
+            {
+                minimap.Draw(source, rect, firstLine);
+            };
+        });
+
+        return minimap.GetRenderedTileCount() - renderedTileCount;
+    };
+
+
+    if(const std::uint64_t renderedCount = drawFrame({ 0 }); renderedCount != 1)
+        return fail("the first view rendered " + std::to_string(renderedCount) + " tiles rather than 1");
+
+    // Starting half way into a tile shows the next one too
+    if(const std::uint64_t renderedCount = drawFrame({ 50000 }); renderedCount != 2)
+        return fail("a view across two tiles rendered " + std::to_string(renderedCount) + " tiles rather than 2");
+
+    if(const std::uint64_t renderedCount = drawFrame({ 0 }); renderedCount != 0 || minimap.GetCachedTileCount() != 3)
+        return fail("scrolling back rendered cached tiles again");
+
+    source.ChangedLine = 10;
+    minimap.Invalidate(10, 11);
+
+    if(const std::uint64_t renderedCount = drawFrame({ 0 }); renderedCount != 1)
+        return fail("an edited line rendered " + std::to_string(renderedCount) + " tiles rather than its 1");
+
+    // Every view is a new tile, once the cache is full each one takes over the least recently drawn
+    std::vector<std::size_t> scrolledFirstLines;
+
+    for(std::size_t tile = 1; tile <= tileCapacity + 4; ++tile)
+    {
+        scrolledFirstLines.emplace_back(tile * tileLines * 10);
+    };
+
+    if(const std::uint64_t renderedCount = drawFrame(scrolledFirstLines); renderedCount != scrolledFirstLines.size() || minimap.GetCachedTileCount() != tileCapacity)
+        return fail("scrolling through " + std::to_string(scrolledFirstLines.size()) + " tiles rendered " + std::to_string(renderedCount) + " and kept " + std::to_string(minimap.GetCachedTileCount()));
+
+    renderer.Finish();
+
+
+    // 2 pixel lines, 10.5 pixels down is the fifth line under the top of the last view
+    if(const std::size_t line = minimap.GetLineAt(rect.y + 10.5f); line != scrolledFirstLines.back() + 5)
+        return fail("the point 10.5 pixels down the minimap is line " + std::to_string(line) + " rather than " + std::to_string(scrolledFirstLines.back() + 5));
+
+
+    if(images.size() != 5)
+        return fail(std::to_string(images.size()) + " of 5 frames were read back");
+
+    if(CountDrawnPixels(images[0]) == 0)
+        return fail("the minimap drew nothing");
+
+    if(images[1] == images[0])
+        return fail("scrolling didn't change the lines drawn");
+
+    if(images[2] != images[0])
+        return fail("the cached tiles drew differently from the rendered ones");
+
+    if(images[3] == images[0])
+        return fail("the edited line looks the same");
+
+    std::cout << "Minimap: " << source.GetLineCount() << " lines, " << minimap.GetRenderedTileCount() << " tiles rendered over " << images.size() << " frames\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Write numbered lines into a SharedTextRing from a producer thread, through a SharedTextRingWriter that opens the ring by name like another
+/// process would, while this thread consumes them into a TextRing. Checks the text arrives whole and in order. Needs the context current on this thread
+/// </summary>
+/// <param name="lineCount"> How many lines the producer writes, many times the ring's capacity </param>
+/// <returns> 0 if every line arrived in order, 1 otherwise </returns>
+int RunSharedTextRingTest(const std::uint64_t lineCount)
+{
+    const std::wstring name = L"Local\\OpenGL-TextRenderer.SharedTextRingTest." + std::to_wstring(GetCurrentProcessId());
+
+    SharedTextRing sharedRing = SharedTextRing(name, 64 * 1024);
+
+    if(sharedRing.IsMapped() == false)
+    {
+        std::cerr << "SharedTextRing: unable to create the ring\n";
+        return 1;
+    };
+
+    TextRing ring = TextRing(1024 * 1024);
+
+    const auto getLine = [](const std::uint64_t line)
+    {
+        return "telemetry sample " + std::to_string(line) + " value " + std::to_string((line * 7919) % 10007) + "\n";
+    };
+
+    std::atomic<bool> producerFailed = false;
+
+    // The producer never waits on the consumer, it only retries what didn't fit
+    std::thread producer = std::thread([&name, &getLine, &producerFailed, lineCount]()
+    {
+        SharedTextRingWriter writer = SharedTextRingWriter(name);
+
+        if(writer.IsMapped() == false)
+        {
+            producerFailed = true;
+            return;
+        };
+
+        for(std::uint64_t line = 0; line < lineCount; ++line)
+        {
+            const std::string text = getLine(line);
+
+            for(std::string_view unwritten = text; unwritten.empty() == false; )
+            {
+                unwritten.remove_prefix(writer.Write(unwritten));
+
+                if(unwritten.empty() == false)
+                    std::this_thread::yield();
+            };
+        };
+    });
+
+    // Checked a line at a time, the text read may end in the middle of one
+    std::uint64_t nextLine = 0;
+    std::string partialLine;
+    bool outOfOrder = false;
+
+    std::uint64_t totalSize = 0;
+
+    for(std::uint64_t line = 0; line < lineCount; ++line)
+    {
+        totalSize += getLine(line).size();
+    };
+
+    std::uint64_t consumedSize = 0;
+
+    while(consumedSize < totalSize && producerFailed == false)
+    {
+        const std::size_t size = sharedRing.Consume([&](const std::string_view& text)
+        {
+            ring.Append(text);
+
+            partialLine.append(text);
+
+            std::size_t lineStart = 0;
+
+            for(std::size_t newline = partialLine.find('\n'); newline != std::string::npos; newline = partialLine.find('\n', lineStart))
+            {
+                if(std::string_view(partialLine).substr(lineStart, newline + 1 - lineStart) != getLine(nextLine++))
+                    outOfOrder = true;
+
+                lineStart = newline + 1;
+            };
+
+            partialLine.erase(0, lineStart);
+        });
+
+        ring.Upload();
+
+        consumedSize += size;
+
+        if(size == 0)
+            std::this_thread::yield();
+    };
+
+    producer.join();
+
+    if(producerFailed == true)
+    {
+        std::cerr << "SharedTextRing: the producer was unable to open the ring by its name\n";
+        return 1;
+    };
+
+    if(outOfOrder == true || nextLine != lineCount || ring.GetHead() != totalSize)
+    {
+        std::cerr << "SharedTextRing: " << nextLine << " of " << lineCount << " lines arrived, " << (outOfOrder == true ? "some of them changed or out of order" : "in order") << "\n";
+        return 1;
+    };
+
+    std::cout << "SharedTextRing: " << lineCount << " lines, " << totalSize << " bytes through a " << (64 * 1024) << " byte ring, "
+              << ring.GetUploadedByteCount() << " bytes uploaded to the text ring\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Push numbered elements into an MPSCQueue from several producer threads at once and pop them on this one,
+/// checking every element arrives exactly once and every producer's elements in the order it pushed them
+/// </summary>
+/// <returns> 0 if the queue lost, duplicated or reordered nothing, 1 otherwise </returns>
+int RunMPSCQueueTest(const std::uint32_t producerCount, const std::uint32_t elementsPerProducer)
+{
+    // Small, so producers keep finding it full and racing each other for the freed slots
+    MPSCQueue<std::uint64_t, 64> queue;
+
+    std::vector<std::thread> producers;
+
+    for(std::uint32_t producer = 0; producer < producerCount; ++producer)
+    {
+        producers.emplace_back([&queue, producer, elementsPerProducer]()
+        {
+            for(std::uint32_t sequence = 0; sequence < elementsPerProducer; ++sequence)
+            {
+                std::uint64_t element = (static_cast<std::uint64_t>(producer) << 32) | sequence;
+
+                while(queue.TryPush(std::move(element)) == false)
+                {
+                    std::this_thread::yield();
+                };
+            };
+        });
+    };
+
+    std::vector<std::uint32_t> nextSequences = std::vector<std::uint32_t>(producerCount, 0);
+
+    const std::uint64_t elementCount = static_cast<std::uint64_t>(producerCount) * elementsPerProducer;
+
+    bool outOfOrder = false;
+
+    for(std::uint64_t popped = 0; popped < elementCount; )
+    {
+        std::uint64_t element = 0;
+
+        if(queue.TryPop(element) == false)
+        {
+            std::this_thread::yield();
+            continue;
+        };
+
+        const std::uint32_t producer = static_cast<std::uint32_t>(element >> 32);
+
+        if(producer >= producerCount || static_cast<std::uint32_t>(element) != nextSequences[producer]++)
+            outOfOrder = true;
+
+        ++popped;
+    };
+
+    for(std::thread& producer : producers)
+    {
+        producer.join();
+    };
+
+    std::uint64_t leftOver = 0;
+
+    if(outOfOrder == true || queue.TryPop(leftOver) == true)
+    {
+        std::cerr << "MPSCQueue: elements were lost, duplicated or reordered between " << producerCount << " producers\n";
+        return 1;
+    };
+
+    std::cout << "MPSCQueue: " << elementCount << " elements from " << producerCount << " producers arrived once each, in order\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Push whole lines into a TextStream from several producer threads at once while this thread appends what its worker decoded to a TextRing,
+/// then push a UTF-8 sequence split between two chunks. Checks every character and line reaches the ring. Needs the context current on this thread
+/// </summary>
+/// <returns> 0 if all of the text arrived, 1 otherwise </returns>
+int RunTextStreamTest(const std::uint32_t producerCount, const std::uint32_t linesPerProducer)
+{
+    // Lines that are the same length whatever their numbers, so the characters expected are easy to count
+    const auto getLine = [](const std::uint32_t producer, const std::uint32_t line)
+    {
+        char text[64] = { };
+
+        std::snprintf(text, sizeof(text), "producer %02u line %08u\n", producer, line);
+
+        return std::string(text);
+    };
+
+    const std::uint64_t lineCount = static_cast<std::uint64_t>(producerCount) * linesPerProducer;
+    const std::uint64_t characterCount = lineCount * getLine(0, 0).size();
+
+    TextRing ring = TextRing(static_cast<std::size_t>(characterCount) + 1024);
+
+    TextStream stream;
+
+    // Feeds the ring until it holds a number of characters, or gives up after a while
+    const auto updateUntil = [&ring, &stream](const std::uint64_t head)
+    {
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+
+        while(ring.GetHead() < head && std::chrono::steady_clock::now() < deadline)
+        {
+            if(stream.Update(ring) == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            ring.Upload();
+        };
+
+        return ring.GetHead() == head;
+    };
+
+    std::vector<std::thread> producers;
+
+    for(std::uint32_t producer = 0; producer < producerCount; ++producer)
+    {
+        producers.emplace_back([&stream, &getLine, producer, linesPerProducer]()
+        {
+            // A few lines per chunk, chunks never split a line so other producers' chunks can't either
+            std::string chunk;
+
+            for(std::uint32_t line = 0; line < linesPerProducer; ++line)
+            {
+                chunk.append(getLine(producer, line));
+
+                if(line % 7 != 6 && line + 1 != linesPerProducer)
+                    continue;
+
+                while(stream.Push(std::move(chunk)) == false)
+                {
+                    std::this_thread::yield();
+                };
+
+                chunk.clear();
+            };
+        });
+    };
+
+    const bool allArrived = updateUntil(characterCount);
+
+    for(std::thread& producer : producers)
+    {
+        producer.join();
+    };
+
+    if(allArrived == false || ring.GetLineCount() != lineCount + 1)
+    {
+        std::cerr << "TextStream: " << ring.GetHead() << " of " << characterCount << " characters and " << (ring.GetLineCount() - 1) << " of " << lineCount
+                  << " lines reached the ring from " << producerCount << " producers\n";
+        return 1;
+    };
+
+    // "\xC3\xA9" is cut between the chunks, the worker carries its first byte over and decodes it as one character
+    stream.Push(std::string("ab\xC3"));
+    stream.Push(std::string("\xA9" "cd\n"));
+
+    if(updateUntil(characterCount + 6) == false)
+    {
+        std::cerr << "TextStream: a UTF-8 sequence split between chunks wasn't decoded as one character\n";
+        return 1;
+    };
+
+    std::cout << "TextStream: " << lineCount << " lines from " << producerCount << " producers reached the ring, " << stream.GetRejectedChunkCount()
+              << " pushes were retried on a full queue\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Forwards to another rasterizer and counts the glyphs it rasterized, to tell a warm glyph cache from a cold one
+/// </summary>
+class CountingGlyphRasterizer : public IGlyphRasterizer
+{
+
+private:
+
+    std::reference_wrapper<const IGlyphRasterizer> _rasterizer;
+
+    mutable std::size_t _rasterizedCount = 0;
+
+
+public:
+
+    /// <param name="rasterizer"> Must outlive the counting rasterizer </param>
+    CountingGlyphRasterizer(const IGlyphRasterizer& rasterizer) :
+        _rasterizer(rasterizer)
+    {
+    };
+
+
+public:
+
+    bool Rasterize(const char32_t codepoint, RasterizedGlyph& glyph) const override
+    {
+        ++_rasterizedCount;
+
+        return _rasterizer.get().Rasterize(codepoint, glyph);
+    };
+
+    bool RasterizeGlyphIndex(const std::uint32_t glyphIndex, RasterizedGlyph& glyph) const override
+    {
+        ++_rasterizedCount;
+
+        return _rasterizer.get().RasterizeGlyphIndex(glyphIndex, glyph);
+    };
+
+    float GetLineHeight() const override
+    {
+        return _rasterizer.get().GetLineHeight();
+    };
+
+    std::size_t GetRasterizedCount() const
+    {
+        return _rasterizedCount;
+    };
+
+};
+
+
+/// <summary>
+/// Fill a GlyphAtlas through a CachedGlyphRasterizer twice, first with no cache file and then with the one the first run saved on shutdown,
+/// and check the second run rasterizes nothing and gets the same glyphs. Needs the context current on this thread
+/// </summary>
+/// <param name="cachePath"> Where the cache is written, an existing file is replaced </param>
+/// <returns> 0 if the warm run was served from the cache, 1 otherwise </returns>
+int RunGlyphCacheTest(const std::filesystem::path& cachePath)
+{
+    constexpr std::string_view text = "The quick brown fox jumps over the lazy dog. 0123456789 {}[]()<>+-*/=!?;:'\"";
+
+    constexpr std::uint32_t pixelHeight = 32;
+
+    std::error_code removeError;
+    std::filesystem::remove(cachePath, removeError);
+
+    const GDIGlyphRasterizer rasterizer = GDIGlyphRasterizer(L"Consolas", pixelHeight);
+
+    const GlyphCacheFont font = GlyphCacheFont
+    {
+        .FontHash = rasterizer.GetFontHash(),
+        .PixelHeight = pixelHeight,
+        .RenderMode = GlyphRenderMode::Coverage,
+    };
+
+    struct CacheRun
+    {
+        std::size_t CachedCount = 0;
+        std::size_t RasterizedCount = 0;
+        std::vector<RasterizedGlyph> Glyphs;
+        bool Saved = false;
+    };
+
+    // Like a launch of the renderer, the cache is opened before the atlas is filled and saved on shutdown
+    const auto run = [&rasterizer, &font, &cachePath, &text]()
+    {
+        CacheRun result;
+
+        GlyphCacheFile cache = GlyphCacheFile(cachePath);
+
+        result.CachedCount = cache.GetGlyphCount();
+
+        const CountingGlyphRasterizer counter = CountingGlyphRasterizer(rasterizer);
+
+        const CachedGlyphRasterizer cachedRasterizer = CachedGlyphRasterizer(counter, cache, font);
+
+        {
+            GlyphAtlas glyphAtlas = GlyphAtlas(cachedRasterizer);
+
+            glyphAtlas.Prepare(text);
+        };
+
+        result.RasterizedCount = counter.GetRasterizedCount();
+
+        // Every glyph the atlas asked for is cached by now, in memory or in the file
+        for(const char character : text)
+        {
+            RasterizedGlyph glyph;
+
+            cachedRasterizer.Rasterize(static_cast<char32_t>(character), glyph);
+
+            result.Glyphs.emplace_back(std::move(glyph));
+        };
+
+        result.Saved = cache.Save();
+
+        return result;
+    };
+
+    const CacheRun cold = run();
+
+    if(cold.Saved == false)
+    {
+        std::cerr << "GlyphCache: unable to save the cache to \"" << cachePath.string() << "\"\n";
+        return 1;
+    };
+
+    const CacheRun warm = run();
+
+    std::cout << "GlyphCache: the cold run rasterized " << cold.RasterizedCount << " glyphs, the warm run found " << warm.CachedCount
+              << " in the cache and rasterized " << warm.RasterizedCount << "\n";
+
+    if(cold.RasterizedCount == 0 || warm.CachedCount == 0 || warm.RasterizedCount != 0)
+    {
+        std::cerr << "GlyphCache: the warm run wasn't served from the cache\n";
+        return 1;
+    };
+
+    for(std::size_t index = 0; index < text.size(); ++index)
+    {
+        const RasterizedGlyph& coldGlyph = cold.Glyphs[index];
+        const RasterizedGlyph& warmGlyph = warm.Glyphs[index];
+
+        if(coldGlyph.Width != warmGlyph.Width || coldGlyph.Height != warmGlyph.Height || coldGlyph.Bearing != warmGlyph.Bearing ||
+           coldGlyph.Advance != warmGlyph.Advance || coldGlyph.Colour != warmGlyph.Colour || coldGlyph.Coverage != warmGlyph.Coverage)
+        {
+            std::cerr << "GlyphCache: '" << text[index] << "' read back from the cache differs from the rasterized glyph\n";
+            return 1;
+        };
+    };
+
+    return 0;
+};
+
+
+/// <summary>
+/// Write the typing benchmark's results as JSON, to a file and the console
+/// </summary>
+int WriteTypingLatencyResults(TypingLatencyBenchmark& benchmark, const std::string& outputPath)
+{
+    if(benchmark.IsFinished() == false)
+        std::cerr << "The window was closed before the typing benchmark finished, the results are partial\n";
+
+    const std::vector<TypingLatencyResult> results = benchmark.GetResults();
+
+    WriteTypingLatencyResultsJSON(std::cout, results);
+
+    std::ofstream outputFile = std::ofstream(outputPath);
+
+    if(outputFile.is_open() == false)
+    {
+        std::cerr << "Unable to write typing benchmark results to \"" << outputPath << "\"\n";
+        return 1;
+    };
+
+    WriteTypingLatencyResultsJSON(outputFile, results);
+
+    return 0;
+};
+
+
+/// <summary>
+/// Run the DynamicSSBO layout microbenchmarks and write their results as JSON, to a file and the console
+/// </summary>
+int RunLayoutBenchmarks(const std::string& outputPath)
+{
+    const std::vector<LayoutBenchmarkResult> results = LayoutBenchmark().Run();
+
+    WriteLayoutBenchmarkResultsJSON(std::cout, results);
+
+    std::ofstream outputFile = std::ofstream(outputPath);
+
+    if(outputFile.is_open() == false)
+    {
+        std::cerr << "Unable to write layout benchmark results to \"" << outputPath << "\"\n";
+        return 1;
+    };
+
+    WriteLayoutBenchmarkResultsJSON(outputFile, results);
+
+    return 0;
+};
+
+
+/// <summary>
+/// Append a log to a ScrollbackStore, in chunks that split its lines, until most of it is compressed past the recent window,
+/// then read lines back from the compressed blocks and the recent text and compare them with what was appended.
+/// Also round-trips a block through LZ4 on its own and checks a cut-off block is refused.
+/// "--test-scrollback [lines]"
+/// </summary>
+/// <returns> 0 if every line read back matched, 1 otherwise </returns>
+int RunScrollbackTest(const std::uint64_t lineCount)
+{
+    const auto getLine = [](const std::uint64_t line)
+    {
+        return "[" + std::to_string(1000000 + (line * 37)) + "] INFO request " + std::to_string(line) + " served in " + std::to_string(line % 97) + " ms";
+    };
+
+    // A block's worth of text on its own first
+    std::string blockText;
+
+    for(std::uint64_t line = 0; line < 1000; ++line)
+    {
+        blockText.append(getLine(line)).push_back('\n');
+    };
+
+    const std::span<const std::byte> blockBytes = std::as_bytes(std::span<const char>(blockText));
+
+    std::vector<std::byte> compressed = std::vector<std::byte>(GetLZ4CompressedSizeBound(blockBytes.size()));
+    compressed.resize(CompressLZ4(blockBytes, compressed));
+
+    std::vector<std::byte> decompressed = std::vector<std::byte>(blockBytes.size());
+
+    if(DecompressLZ4(compressed, decompressed) == false || std::equal(decompressed.cbegin(), decompressed.cend(), blockBytes.begin()) == false)
+    {
+        std::cerr << "Scrollback: a block didn't decompress to what was compressed\n";
+        return 1;
+    };
+
+    if(DecompressLZ4(std::span<const std::byte>(compressed).first(compressed.size() / 2), decompressed) == true)
+    {
+        std::cerr << "Scrollback: a cut-off block decompressed\n";
+        return 1;
+    };
+
+
+    JobSystem jobs = JobSystem();
+
+    ScrollbackStore store = ScrollbackStore(&jobs);
+
+    // Small enough that most of the log ends up compressed
+    store.RecentSizeInBytes = 256 * 1024;
+    store.BlockSizeInBytes = 32 * 1024;
+
+    std::string chunk;
+
+    for(std::uint64_t line = 0; line < lineCount; ++line)
+    {
+        chunk.append(getLine(line)).push_back('\n');
+
+        // Odd sizes, so appends end in the middle of lines
+        if(chunk.size() > 4093)
+        {
+            store.Append(std::string_view(chunk).substr(0, 4093));
+            chunk.erase(0, 4093);
+        };
+    };
+
+    store.Append(chunk);
+
+    if(store.GetLineCount() != lineCount)
+    {
+        std::cerr << "Scrollback: the store has " << store.GetLineCount() << " lines rather than " << lineCount << "\n";
+        return 1;
+    };
+
+    if(store.GetBlockCount() == 0)
+    {
+        std::cerr << "Scrollback: nothing was compressed, append more lines\n";
+        return 1;
+    };
+
+
+    // Screens of lines from the oldest block, across blocks, and from the recent text, then the whole log a screen at a time
+    constexpr std::size_t screenLineCount = 60;
+
+    std::vector<std::uint64_t> firstLines = { 0, lineCount / 3, lineCount / 2, lineCount - std::min<std::uint64_t>(lineCount, screenLineCount) };
+
+    for(std::uint64_t firstLine = 0; firstLine < lineCount; firstLine += screenLineCount)
+    {
+        firstLines.push_back(firstLine);
+    };
+
+    std::string lines;
+    std::string expectedLines;
+
+    for(const std::uint64_t firstLine : firstLines)
+    {
+        lines.clear();
+        expectedLines.clear();
+
+        store.GetLines(firstLine, screenLineCount, lines);
+
+        for(std::uint64_t line = firstLine; line < std::min<std::uint64_t>(firstLine + screenLineCount, lineCount); ++line)
+        {
+            if(line > firstLine)
+                expectedLines.push_back('\n');
+
+            expectedLines.append(getLine(line));
+        };
+
+        if(lines != expectedLines)
+        {
+            std::cerr << "Scrollback: the lines from " << firstLine << " on differ from the ones appended\n";
+            return 1;
+        };
+    };
+
+    std::cout << "Scrollback: " << lineCount << " lines, " << store.GetUncompressedSizeInBytes() << " bytes in " << store.GetBlockCount() << " blocks of "
+              << store.GetCompressedSizeInBytes() << " bytes and the recent text, " << store.GetMemoryUsageInBytes() << " bytes in memory\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Parse styled text split into chunks and compare the glyph text and spans with the expected ones: tags nested inside each other,
+/// tags and escape sequences split across chunks, tags that are never closed, and braces that aren't tags.
+/// "--test-styled-text"
+/// </summary>
+/// <returns> 0 if every case parsed as expected, 1 otherwise </returns>
+int RunStyledTextTest()
+{
+    struct StyledTextCase
+    {
+        std::string_view Name;
+
+        std::vector<std::string_view> Chunks;
+
+        std::string_view ExpectedText;
+
+        std::vector<TextSpan> ExpectedSpans;
+    };
+
+    const std::uint32_t black = PackSpanColour({ 0.0f, 0.0f, 0.0f, 1.0f });
+    const std::uint32_t red = PackSpanColour({ 1.0f, 0.0f, 0.0f, 1.0f });
+    const std::uint32_t green = PackSpanColour({ 0.0f, 1.0f, 0.0f, 1.0f });
+    const std::uint32_t blue = PackSpanColour({ 0.0f, 0.0f, 1.0f, 1.0f });
+
+    // ANSI red, "ESC[31m", is xterm's 0xCD0000
+    const std::uint32_t ansiRed = PackSpanColour({ 205.0f / 255.0f, 0.0f, 0.0f, 1.0f });
+
+    const std::vector<StyledTextCase> cases =
+    {
+        {
+            .Name = "nested tags",
+            .Chunks = { "{b}a{#FF0000}b{u}c{/u}d{/#}e{/b}f" },
+            .ExpectedText = "abcdef",
+            .ExpectedSpans =
+            {
+                { .FirstCharacter = 0, .Colour = black, .Style = GlyphStyle::Bold },
+                { .FirstCharacter = 1, .Colour = red, .Style = GlyphStyle::Bold },
+                { .FirstCharacter = 2, .Colour = red, .Style = GlyphStyle::Bold | GlyphStyle::Underline },
+                { .FirstCharacter = 3, .Colour = red, .Style = GlyphStyle::Bold },
+                { .FirstCharacter = 4, .Colour = black, .Style = GlyphStyle::Bold },
+                { .FirstCharacter = 5, .Colour = black },
+            },
+        },
+        {
+            .Name = "a background inside a colour, closed by a reset",
+            .Chunks = { "x{#0000FF}y{bg#00FF00}z{/}w" },
+            .ExpectedText = "xyzw",
+            .ExpectedSpans =
+            {
+                { .FirstCharacter = 1, .Colour = blue },
+                { .FirstCharacter = 2, .Colour = blue, .Background = green },
+                { .FirstCharacter = 3, .Colour = black },
+            },
+        },
+        {
+            .Name = "a tag split across chunks",
+            .Chunks = { "x{#00F", "F00}y{", "/}z" },
+            .ExpectedText = "xyz",
+            .ExpectedSpans =
+            {
+                { .FirstCharacter = 1, .Colour = green },
+                { .FirstCharacter = 2, .Colour = black },
+            },
+        },
+        {
+            .Name = "an escape sequence split across chunks",
+            .Chunks = { "\x1B[1;3", "1mR\x1B", "[0mN" },
+            .ExpectedText = "RN",
+            .ExpectedSpans =
+            {
+                { .FirstCharacter = 0, .Colour = ansiRed, .Style = GlyphStyle::Bold },
+                { .FirstCharacter = 1, .Colour = black },
+            },
+        },
+        {
+            .Name = "a tag that's never closed",
+            .Chunks = { "{b}bold{u}still bold" },
+            .ExpectedText = "boldstill bold",
+            .ExpectedSpans =
+            {
+                { .FirstCharacter = 0, .Colour = black, .Style = GlyphStyle::Bold },
+                { .FirstCharacter = 4, .Colour = black, .Style = GlyphStyle::Bold | GlyphStyle::Underline },
+            },
+        },
+        {
+            .Name = "an unterminated tag finished as text",
+            .Chunks = { "a{b c", " d}" },
+            .ExpectedText = "a{b c d}",
+            .ExpectedSpans = { },
+        },
+        {
+            .Name = "an unterminated tag longer than a tag can be",
+            .Chunks = { "{#FF0000 this brace is never closed, so past the longest tag it's drawn as it is" },
+            .ExpectedText = "{#FF0000 this brace is never closed, so past the longest tag it's drawn as it is",
+            .ExpectedSpans = { },
+        },
+        {
+            .Name = "braces that aren't tags",
+            .Chunks = { "{{b}} {x} {#12345} {b" },
+            .ExpectedText = "{b}} {x} {#12345} ",
+            .ExpectedSpans = { },
+        },
+    };
+
+
+    std::string text;
+    std::vector<TextSpan> spans;
+
+    for(const StyledTextCase& styledTextCase : cases)
+    {
+        StyledTextParser parser = StyledTextParser({ 0.0f, 0.0f, 0.0f, 1.0f }, StyledTextSyntax::All);
+
+        text.clear();
+        spans.clear();
+
+        for(const std::string_view& chunk : styledTextCase.Chunks)
+        {
+            parser.Parse(chunk, text, spans);
+        };
+
+        // Whatever is still unfinished at the end is dropped, like a stream that was cut off
+        parser.Reset();
+
+        const bool spansMatch = std::equal(spans.cbegin(), spans.cend(), styledTextCase.ExpectedSpans.cbegin(), styledTextCase.ExpectedSpans.cend(), [](const TextSpan& span, const TextSpan& expectedSpan)
+        {
+            return span.FirstCharacter == expectedSpan.FirstCharacter && span.Colour == expectedSpan.Colour && span.Style == expectedSpan.Style && span.Background == expectedSpan.Background;
+        });
+
+        if(text != styledTextCase.ExpectedText || spansMatch == false)
+        {
+            std::cerr << "Styled text: " << styledTextCase.Name << " parsed into \"" << text << "\" with " << spans.size() << " spans, rather than \""
+                      << styledTextCase.ExpectedText << "\" with " << styledTextCase.ExpectedSpans.size() << "\n";
+            return 1;
+        };
+    };
+
+    std::cout << "Styled text: " << cases.size() << " cases parsed as expected\n";
+
+    return 0;
+};
+
+
+/// <summary>
+/// Bake a font image into a ".fontatlas" package, which loads without decoding or converting anything.
+/// "--bake-atlas input glyphWidth glyphHeight output.fontatlas [coverage|sdf|rgba|lcd] [bc4]"
+/// </summary>
+int BakeAtlas(int argc, char** argv, int index)
+{
+    if(index + 4 >= argc)
+    {
+        std::cerr << "Usage: --bake-atlas <input> <glyph width> <glyph height> <output.fontatlas> [coverage|sdf|rgba|lcd] [bc4]\n";
+        return 1;
+    };
+
+    const std::filesystem::path inputPath = argv[index + 1];
+    const glm::uvec2 glyphSize = { std::stoul(argv[index + 2]), std::stoul(argv[index + 3]) };
+    const std::filesystem::path outputPath = argv[index + 4];
+
+    const std::string_view formatName = index + 5 < argc ? std::string_view(argv[index + 5]) : std::string_view("coverage");
+
+    const AtlasFormat atlasFormat = formatName == "sdf" ? AtlasFormat::DistanceField :
+                                    formatName == "rgba" ? AtlasFormat::ChromaKeyedRGBA :
+                                    formatName == "lcd" ? AtlasFormat::Subpixel :
+                                    AtlasFormat::Coverage;
+
+    // Single channel atlases only, rgba and lcd are stored uncompressed
+    const bool blockCompress = index + 6 < argc && std::string_view(argv[index + 6]) == "bc4";
+
+
+    const TextureImage image = GetTextureLoader(inputPath).Load(inputPath);
+
+    std::ofstream outputFile = std::ofstream(outputPath, std::ios::binary);
+
+    if(outputFile.is_open() == false)
+    {
+        std::cerr << "Unable to write the atlas package to \"" << outputPath.string() << "\"\n";
+        return 1;
+    };
+
+    // The sprite's default chroma key
+    FontSprite::BakeAtlasPackage(image, glyphSize, atlasFormat, { 1.0f, 1.0f, 1.0f, 1.0f }, blockCompress, outputFile);
+
+    return 0;
+};
+
+
+
+int main(int argc, char** argv)
+{
+    // Lets WPA and GPUView sessions see the renderer's events, see EventTracing.hpp
+    const wt::etw::ProviderRegistration eventTracing;
+
+    constexpr std::uint32_t initialWindowWidth = 800;
+    constexpr std::uint32_t initialWindowHeight = 600;
+
+    // Release builds skip validation entirely unless asked for it with "--gl-diagnostics=off|log|break"
+    #ifdef _DEBUG
+    GLDiagnosticsLevel diagnosticsLevel = GLDiagnosticsLevel::SynchronousBreak;
+    #else
+    GLDiagnosticsLevel diagnosticsLevel = GLDiagnosticsLevel::Off;
+    #endif
+
+    // "--benchmark [output.json]" runs the benchmarks in a hidden window and exits.
+    // "--benchmark-workload characters strings frames [changing]", repeatable, runs the given workloads instead of the default ones
+    bool runBenchmarks = false;
+    std::string benchmarkOutputPath = "BenchmarkResults.json";
+    std::vector<BenchmarkWorkload> benchmarkWorkloads;
+
+    // "--scenario-benchmark [scenes] [output.json]" measures every scene of a scenario file in each of its modes in a hidden window, prints them
+    // compared against "--benchmark-baseline results.json", an earlier run's output, and exits
+    bool runScenarioBenchmarks = false;
+    std::string scenarioPath = "Resources\\Benchmarks.scenes";
+    std::string scenarioOutputPath = "ScenarioResults.json";
+    std::string scenarioBaselinePath;
+
+    // "--record-draws capture.bin" records every frame's text draws, "--replay-draws capture.bin [output.json]" plays them back in a hidden window
+    // as fast as they go, measures them like the benchmarks, and exits
+    std::string drawCapturePath;
+    std::string replayCapturePath;
+    std::string replayOutputPath = "ReplayResults.json";
+
+    // "--layout-benchmark [output.json]" runs the DynamicSSBO microbenchmarks and exits
+    bool runLayoutBenchmarks = false;
+    std::string layoutBenchmarkOutputPath = "LayoutBenchmarkResults.json";
+
+    // "--test-layouts [seed] [count]" runs SSBOTest and checks count random layouts against the driver's, then exits
+    bool testLayouts = false;
+    std::uint32_t layoutTestSeed = 1;
+    std::size_t layoutTestCount = 1000;
+
+    // "--test-asset-loader" loads the font's program and atlas again through an AssetLoader, checks they arrive ready, and exits
+    bool testAssetLoader = false;
+
+    // "--test-glyph-cache [cache.bin]" fills a glyph atlas through a glyph cache file twice, checks the second run rasterizes nothing, and exits
+    bool testGlyphCache = false;
+    std::string glyphCacheTestPath = "GlyphCacheTest.bin";
+
+    // "--headless [image.bmp] [text.txt]" draws the text file, or the document the editor starts with, into an offscreen framebuffer
+    // the window's size, writes the image read back, and exits
+    bool runHeadless = false;
+    std::string headlessOutputPath = "Headless.bmp";
+    std::string headlessTextPath;
+
+    // "--test-terminal-grid" checks a terminal grid only uploads the rows that changed or scrolled into view, draws it offscreen with a quad per cell
+    // and with a quad per row, checks both images match, and exits
+    bool testTerminalGrid = false;
+
+    // "--test-grid-delta" sends a terminal grid's changes through the delta protocol into a second grid, checks both match cell for cell, and exits
+    bool testGridDelta = false;
+
+    // "--test-label-cache" draws labels through a label cache offscreen for a few frames, checks each is only drawn into the cache again
+    // once its text changed, and exits
+    bool testLabelCache = false;
+
+    // "--test-text-animation" draws text offscreen through a text animator's fade, typewriter and wave tracks, checks each frame, and exits
+    bool testTextAnimation = false;
+
+    // "--test-label-grid" culls and places a label grid's labels against a few views, checks them against every label, draws two of the views
+    // offscreen, and exits
+    bool testLabelGrid = false;
+
+    // "--test-draw-lists" records text into draw lists on worker threads, submits and flushes them through a text batch offscreen,
+    // checks the frame matches the same text submitted directly, and exits
+    bool testTextDrawList = false;
+
+    // "--test-table-view" scrolls a table of a million rows offscreen, checks only the visible cells are formatted and cached ones aren't again,
+    // and exits
+    bool testTableView = false;
+
+    // "--test-immediate-text" draws immediate-mode labels offscreen for a few frames, checks only changed labels are laid out again
+    // and labels no longer drawn are forgotten, and exits
+    bool testImmediateText = false;
+
+    // "--test-minimap" draws a minimap of generated lines offscreen while scrolling and editing it, checks only the tiles shown or edited
+    // are rendered, and exits
+    bool testMinimap = false;
+
+    // "--test-shared-ring [lines]" writes lines into a shared memory text ring from a producer thread and checks they're all read back in order, then exits
+    bool testSharedTextRing = false;
+    std::uint64_t sharedTextRingTestLineCount = 1000000;
+
+    // "--test-text-stream [producers]" pushes numbered elements into an MPSCQueue and lines into a TextStream from several threads at once,
+    // checks they all arrive, in order for each producer, and exits
+    bool testTextStream = false;
+    std::uint32_t textStreamTestProducerCount = 4;
+
+    // "--max-frame-allocations N" asserts on every frame that allocates more than N times, 0 once the text stopped changing. Allocations are only counted with TEXT_RENDERER_ALLOCATION_TRACKING
+    std::optional<std::uint64_t> maxFrameAllocations;
+
+    // "--max-frame-latency N" lets the CPU queue at most N frames, 1 to 3, ahead of the GPU. 1 is the lowest latency, 3 the most overlap
+    std::uint32_t maxFrameLatency = 2;
+
+    // "--distance-field" draws with a signed distance field atlas, which stays sharp at any scale.
+    // "--subpixel" draws with per-subpixel coverage, sharper at small sizes on LCDs
+    AtlasFormat atlasFormat = AtlasFormat::Coverage;
+
+    // "--typing-benchmark [output.json]" replays keystrokes and pastes into the window, measures how long each takes to be presented, and exits
+    bool runTypingBenchmark = false;
+    std::string typingBenchmarkOutputPath = "TypingLatencyResults.json";
+
+    // "--startup-trace [trace.json]" writes how long every phase of startup took, for chrome://tracing
+    std::string startupTracePath;
+
+    // "--count-gl-calls" counts the GL calls of every frame by entry point, "--count-gl-calls=timed" also times them, shown with the profiler (F3) and dumped with F4
+    std::optional<bool> countGLCalls;
+
+    // "--zone-trace [trace.json]" writes every profile zone and counter for chrome://tracing on exit. Zones are only compiled in with TEXT_RENDERER_PROFILE_ZONES
+    std::string zoneTracePath;
+
+    // "--gpu-memory-budget MB" evicts cached GPU memory once the renderer uses more than this, shown with the profiler (F3)
+    std::uint64_t gpuMemoryBudget = 0;
+
+    for(int index = 1; index < argc; ++index)
+    {
+        const std::string_view argument = argv[index];
+
+        constexpr std::string_view diagnosticsOption = "--gl-diagnostics=";
+
+        if(argument.starts_with(diagnosticsOption) == true)
+            diagnosticsLevel = ParseGLDiagnosticsLevel(argument.substr(diagnosticsOption.size()), diagnosticsLevel);
+        else if(argument == "--benchmark")
+        {
+            runBenchmarks = true;
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                benchmarkOutputPath = argv[++index];
+        }
+        else if(argument == "--benchmark-workload" && index + 3 < argc)
+        {
+            runBenchmarks = true;
+
+            const std::size_t charactersPerString = static_cast<std::size_t>(std::stoull(argv[index + 1]));
+            const std::size_t stringCount = static_cast<std::size_t>(std::stoull(argv[index + 2]));
+            const std::uint32_t frameCount = static_cast<std::uint32_t>(std::stoul(argv[index + 3]));
+
+            index += 3;
+
+            const bool changingText = index + 1 < argc && std::string_view(argv[index + 1]) == "changing";
+
+            if(changingText == true)
+                ++index;
+
+            benchmarkWorkloads.emplace_back(CreateBenchmarkWorkload(charactersPerString, stringCount, frameCount, changingText));
+        }
+        else if(argument == "--scenario-benchmark")
+        {
+            runScenarioBenchmarks = true;
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                scenarioPath = argv[++index];
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                scenarioOutputPath = argv[++index];
+        }
+        else if(argument == "--benchmark-baseline" && index + 1 < argc)
+            scenarioBaselinePath = argv[++index];
+        else if(argument == "--layout-benchmark")
+        {
+            runLayoutBenchmarks = true;
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                layoutBenchmarkOutputPath = argv[++index];
+        }
+        else if(argument == "--test-layouts")
+        {
+            testLayouts = true;
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                layoutTestSeed = static_cast<std::uint32_t>(std::stoul(argv[++index]));
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                layoutTestCount = static_cast<std::size_t>(std::stoull(argv[++index]));
+        }
+        else if(argument == "--test-asset-loader")
+            testAssetLoader = true;
+        else if(argument == "--headless")
+        {
+            runHeadless = true;
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                headlessOutputPath = argv[++index];
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                headlessTextPath = argv[++index];
+        }
+        else if(argument == "--test-terminal-grid")
+            testTerminalGrid = true;
+        else if(argument == "--test-grid-delta")
+            testGridDelta = true;
+        else if(argument == "--test-label-cache")
+            testLabelCache = true;
+        else if(argument == "--test-text-animation")
+            testTextAnimation = true;
+        else if(argument == "--test-label-grid")
+            testLabelGrid = true;
+        else if(argument == "--test-draw-lists")
+            testTextDrawList = true;
+        else if(argument == "--test-table-view")
+            testTableView = true;
+        else if(argument == "--test-immediate-text")
+            testImmediateText = true;
+        else if(argument == "--test-minimap")
+            testMinimap = true;
+        else if(argument == "--test-shared-ring")
+        {
+            testSharedTextRing = true;
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                sharedTextRingTestLineCount = std::stoull(argv[++index]);
+        }
+        else if(argument == "--test-text-stream")
+        {
+            testTextStream = true;
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                textStreamTestProducerCount = static_cast<std::uint32_t>(std::stoul(argv[++index]));
+        }
+        else if(argument == "--test-glyph-cache")
+        {
+            testGlyphCache = true;
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                glyphCacheTestPath = argv[++index];
+        }
+        else if(argument == "--max-frame-allocations" && index + 1 < argc)
+        {
+            maxFrameAllocations = std::stoull(argv[++index]);
+
+            if constexpr(AllocationTrackingEnabled == false)
+                std::cerr << "--max-frame-allocations needs a build with TEXT_RENDERER_ALLOCATION_TRACKING, no allocation is counted without it\n";
+        }
+        else if(argument == "--max-frame-latency" && index + 1 < argc)
+            maxFrameLatency = static_cast<std::uint32_t>(std::stoul(argv[++index]));
+        else if(argument == "--record-draws" && index + 1 < argc)
+            drawCapturePath = argv[++index];
+        else if(argument == "--replay-draws" && index + 1 < argc)
+        {
+            replayCapturePath = argv[++index];
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                replayOutputPath = argv[++index];
+        }
+        else if(argument == "--distance-field")
+            atlasFormat = AtlasFormat::DistanceField;
+        else if(argument == "--subpixel")
+            atlasFormat = AtlasFormat::Subpixel;
+        else if(argument == "--typing-benchmark")
+        {
+            runTypingBenchmark = true;
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                typingBenchmarkOutputPath = argv[++index];
+        }
+        else if(argument == "--count-gl-calls")
+            countGLCalls = false;
+        else if(argument == "--count-gl-calls=timed")
+            countGLCalls = true;
+        else if(argument == "--gpu-memory-budget" && index + 1 < argc)
+            gpuMemoryBudget = std::stoull(argv[++index]) * 1024 * 1024;
+        else if(argument == "--zone-trace")
+        {
+            zoneTracePath = "ZoneTrace.json";
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                zoneTracePath = argv[++index];
+        }
+        else if(argument == "--startup-trace")
+        {
+            startupTracePath = "StartupTrace.json";
+
+            if(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false)
+                startupTracePath = argv[++index];
+        }
+        // The tests below are CPU-only, no window is created
+        else if(argument == "--test-scrollback")
+            return RunScrollbackTest(index + 1 < argc && std::string_view(argv[index + 1]).starts_with("--") == false ? std::stoull(argv[index + 1]) : 200000);
+        else if(argument == "--test-styled-text")
+            return RunStyledTextTest();
+        // Baking is CPU-only, no window is created
+        else if(argument == "--bake-atlas")
+            return BakeAtlas(argc, argv, index);
+    };
+
+    #ifdef TEXT_RENDERER_PROFILE_ZONES
+    // Added before any other thread runs a zone, and only removed once they're all done
+    ChromeTraceZoneBackend zoneTrace;
+
+    if(zoneTracePath.empty() == false)
+        ProfileZones.AddBackend(zoneTrace);
+
+    #ifdef TEXT_RENDERER_TRACY
+    TracyZoneBackend tracyZones;
+
+    ProfileZones.AddBackend(tracyZones);
+    #endif
+    #endif
+
+    const bool drawsText = runLayoutBenchmarks == false && testLayouts == false && testGlyphCache == false && testSharedTextRing == false && testTextStream == false;
+
+    const char* fragmentShaderPath = atlasFormat == AtlasFormat::DistanceField ? "Shaders\\FontSpriteDistanceFieldFragmentShader.glsl" :
+                                     atlasFormat == AtlasFormat::Subpixel ? "Shaders\\FontSpriteSubpixelFragmentShader.glsl" :
+                                     "Shaders\\FontSpriteCoverageFragmentShader.glsl";
+
+    const char* vertexShaderPath = "Shaders\\FontSpriteVertexShader.glsl";
+
+    {
+        const StartupPhase phase = StartupPhase("glfwInit");
+
+        glfwInit();
+    };
+
+    // The atlases the text can be drawn from, one per content scale. The primary monitor's scale picks one before the window exists,
+    // the window usually opens there, and text on another monitor is scaled to it by its transform
+    const std::array<ScaledAtlas, 1> atlases =
+    {
+        ScaledAtlas { .Path = L"Resources\\Consolas13x24.bmp", .GlyphSize = { 13, 24 }, .Scale = 1.0f },
+    };
+
+    const ScaledAtlas& atlas = SelectScaledAtlas(atlases, GetMonitorContentScale(glfwGetPrimaryMonitor()));
+
+    // Nothing about the atlas needs a context but its upload, so its file is read and decoded while the window and context are created.
+    // The shader sources are read ahead first, the driver compiles them as soon as there's a context.
+    // Release builds embed the shaders and the atlas's baked package, so then nothing is read from disk, see EmbeddedAssets
+    std::optional<FontSprite::DecodedAtlas> decodedAtlas;
+
+    std::thread atlasDecoder;
+
+    if(drawsText == true)
+    {
+        atlasDecoder = std::thread([&decodedAtlas, &atlas, atlasFormat, vertexShaderPath, fragmentShaderPath]()
+        {
+            {
+                const StartupPhase phase = StartupPhase("Read shaders");
+
+                if(FindEmbeddedAsset(vertexShaderPath) == nullptr)
+                    MappedFile(vertexShaderPath).ReadAhead();
+
+                if(FindEmbeddedAsset(fragmentShaderPath) == nullptr)
+                    MappedFile(fragmentShaderPath).ReadAhead();
+            };
+
+            const StartupPhase phase = StartupPhase("Read and decode atlas");
+
+            const std::filesystem::path atlasPath = atlas.Path;
+
+            // The package is baked for one atlas format, the others decode the image
+            const std::filesystem::path packagePath = std::filesystem::path(atlasPath).replace_extension(FontAtlasPackage::Extension);
+
+            if(const EmbeddedAsset* embeddedPackage = FindEmbeddedAsset(packagePath); embeddedPackage != nullptr)
+                decodedAtlas = FontSprite::DecodeAtlas(embeddedPackage->GetBytes(), packagePath, atlas.GlyphSize, atlasFormat);
+
+            if(decodedAtlas.has_value() == false)
+                decodedAtlas = FontSprite::DecodeAtlas(std::make_shared<const MappedFile>(atlasPath), atlasPath, nullptr, atlas.GlyphSize, atlasFormat);
+        });
+    };
+
+
+    // The benchmarks and tests run in a hidden window
+    const bool showsWindow = runBenchmarks == false && runScenarioBenchmarks == false && runLayoutBenchmarks == false && replayCapturePath.empty() == true &&
+                             runHeadless == false && testLayouts == false && testAssetLoader == false && testGlyphCache == false && testTerminalGrid == false &&
+                             testGridDelta == false && testLabelCache == false && testTextAnimation == false &&
+                             testLabelGrid == false && testTextDrawList == false && testTableView == false &&
+                             testImmediateText == false && testMinimap == false && testSharedTextRing == false && testTextStream == false;
+
+    GLFWwindow* glfwWindow = InitializeGLFWWindow(initialWindowWidth, initialWindowHeight, "OpenGL-TextRenderer", diagnosticsLevel, showsWindow);
+
+    // Before anything calls GL, so every call of the run is counted
+    if(countGLCalls.has_value() == true)
+        InstallGLCallCounting(*countGLCalls);
+
+    GPUMemory.Budget = gpuMemoryBudget;
+
+
+    {
+        const StartupPhase phase = StartupPhase("Set up GL state");
+
+        SetupOpenGL(diagnosticsLevel);
+    };
+
+    // Tracks the window's size and content scale for the render thread, and holds its projection
+    RenderWindow renderWindow = RenderWindow(glfwWindow);
+
+    // Needs nothing but the context, for setting elements through the buffer
+    if(runLayoutBenchmarks == true)
+        return RunLayoutBenchmarks(layoutBenchmarkOutputPath);
+
+    if(testLayouts == true)
+    {
+        // The hand-written cases break into the debugger on the first wrong offset
+        SSBOTest();
+
+        return SSBOLayoutFuzzer(layoutTestSeed).Run(layoutTestCount) == 0 ? 0 : 1;
+    };
+
+    if(testGlyphCache == true)
+        return RunGlyphCacheTest(glyphCacheTestPath);
+
+    if(testSharedTextRing == true)
+        return RunSharedTextRingTest(sharedTextRingTestLineCount);
+
+    if(testTextStream == true)
+        return RunMPSCQueueTest(textStreamTestProducerCount, 1000000) != 0 || RunTextStreamTest(textStreamTestProducerCount, 100000) != 0 ? 1 : 0;
+
+    if(testMinimap == true)
+    {
+        const ShaderProgram minimapProgram = ShaderProgram("Shaders\\MinimapVertexShader.glsl", "Shaders\\MinimapFragmentShader.glsl");
+
+        return RunMinimapTest(minimapProgram);
+    };
+
+    // The program compiles on driver threads while the atlas finishes decoding
+    ShaderVariants fontShaders = ShaderVariants(vertexShaderPath, fragmentShaderPath, FontShaderFeatureDefines, true, ShaderCompileMode::Asynchronous);
+
+    // The text is drawn plainly, so only the variant without styles or multi-draws is compiled
+    const ShaderProgram* shaderProgramPointer = nullptr;
+
+    {
+        const StartupPhase phase = StartupPhase("Submit shaders");
+
+        shaderProgramPointer = &fontShaders.Get(FontSprite::GetShaderFeatures(atlasFormat, false, false));
+    };
+
+    const ShaderProgram& shaderProgram = *shaderProgramPointer;
+
+    {
+        const StartupPhase phase = StartupPhase("Wait for atlas");
+
+        atlasDecoder.join();
+    };
+
+    // The decoded atlas is small enough to upload straight away, without waiting for the upload worker's context
+    std::optional<FontSprite> fontSpriteStorage;
+
+    {
+        const StartupPhase phase = StartupPhase("Upload atlas");
+
+        fontSpriteStorage.emplace(atlas.GlyphSize.x, atlas.GlyphSize.y, shaderProgram, std::move(*decodedAtlas), 32, SSBOMode::PersistentRing, CharacterPacking::Bits8);
+
+        decodedAtlas.reset();
+    };
+
+    FontSprite& fontSprite = *fontSpriteStorage;
+
+    // Large sub-data uploads, e.g. the benchmarks' documents, are copied on the worker. GLFW only creates its context's window on this thread
+    std::optional<UploadWorker> uploadWorker;
+
+    {
+        const StartupPhase phase = StartupPhase("Create upload context");
+
+        uploadWorker.emplace(glfwWindow);
+    };
+
+    // Instances created from the font share its worker
+    fontSprite.Uploads = &*uploadWorker;
+
+    // Edits to the shaders are picked up while running. The watcher isn't needed to draw, so it starts after everything that is
+    fontShaders.EnableHotReload();
+
+    #ifdef _DEBUG
+    // The input block's offsets are calculated at compile time, a padding mistake would otherwise only show up as garbled text.
+    // Reflection has to wait for the program to link, so release builds skip the check
+    ValidateBufferLayout(BufferLayout::FromStaticLayout<FontSpriteInputLayout>(), shaderProgram, "Input");
+    #endif
+
+
+    const FrameUniformBuffer& frameUniformBuffer = renderWindow.GetFrameUniformBuffer();
+
+    // The build compiles the cursor shaders to SPIR-V when the Vulkan SDK is installed, the driver only has to specialize them
+    const bool cursorFromSPIRV = std::filesystem::exists("Shaders\\SPIRV\\CursorOverlayVertexShader.spv") == true &&
+                                 std::filesystem::exists("Shaders\\SPIRV\\CursorOverlayFragmentShader.spv") == true;
+
+    // The cursor's stages are linked separately and only meet in the pipeline
+    const ShaderStage cursorVertexStage = (cursorFromSPIRV == true) ?
+        ShaderStage::FromSPIRV(GL_VERTEX_SHADER, "Shaders\\SPIRV\\CursorOverlayVertexShader.spv") :
+        ShaderStage(GL_VERTEX_SHADER, "Shaders\\CursorOverlayVertexShader.glsl");
+
+    const ShaderStage cursorFragmentStage = (cursorFromSPIRV == true) ?
+        ShaderStage::FromSPIRV(GL_FRAGMENT_SHADER, "Shaders\\SPIRV\\CursorOverlayFragmentShader.spv") :
+        ShaderStage(GL_FRAGMENT_SHADER, "Shaders\\CursorOverlayFragmentShader.glsl");
+
+    const ProgramPipeline cursorPipeline = ProgramPipeline(cursorVertexStage, cursorFragmentStage);
+
+    #ifdef _DEBUG
+    cursorPipeline.Validate();
+    #endif
+
+    // Calculate transform, the projection is updated every frame and the transform whenever the content scale changes
+    fontSprite.Transform = GetContentScaleTransform(TextOrigin, renderWindow.GetContentScale(), atlas.Scale);
+
+    frameUniformBuffer.SetContentScale(renderWindow.GetContentScale());
+
+    // In the atlas' pixels, so the text wraps at the same width in window units whichever atlas was picked
+    fontSprite.Layout.WrapWidth = 600.0f * atlas.Scale;
+
+
+    if(runBenchmarks == true)
+    {
+        fontSprite.WaitUntilReady();
+
+        return RunBenchmarks(fontSprite, frameUniformBuffer, benchmarkWorkloads, benchmarkOutputPath);
+    };
+
+    if(runScenarioBenchmarks == true)
+    {
+        // Only the scenario benchmark draws styled or batched text with the font
+        const ShaderProgram& styledProgram = fontShaders.Get(FontSprite::GetShaderFeatures(atlasFormat, true, false));
+
+        const ShaderProgram batchProgram = ShaderProgram("Shaders\\TextBatchVertexShader.glsl", fragmentShaderPath);
+
+        fontSprite.WaitUntilReady();
+
+        return RunScenarioBenchmarks(fontSprite, frameUniformBuffer, styledProgram, batchProgram, scenarioPath, scenarioBaselinePath, scenarioOutputPath);
+    };
+
+    if(replayCapturePath.empty() == false)
+    {
+        fontSprite.WaitUntilReady();
+
+        return RunDrawReplay(fontSprite, frameUniformBuffer, replayCapturePath, replayOutputPath);
+    };
+
+    if(testAssetLoader == true)
+        return RunAssetLoaderTest(atlas, atlasFormat, vertexShaderPath, fragmentShaderPath, fontShaders.GetDefines(FontSprite::GetShaderFeatures(atlasFormat, false, false)));
+
+    if(runHeadless == true)
+    {
+        std::string headlessText = std::string(InitialDocument);
+
+        if(headlessTextPath.empty() == false)
+        {
+            std::ifstream textFile = std::ifstream(headlessTextPath, std::ios::binary);
+
+            if(textFile.is_open() == false)
+            {
+                std::cerr << "Unable to read \"" << headlessTextPath << "\"\n";
+                return 1;
+            };
+
+            headlessText.assign(std::istreambuf_iterator<char>(textFile), std::istreambuf_iterator<char>());
+        };
+
+        return RunHeadless(fontSprite, atlas.Scale, initialWindowWidth, initialWindowHeight, headlessText, headlessOutputPath);
+    };
+
+    if(testTerminalGrid == true)
+    {
+        if(atlasFormat != AtlasFormat::Coverage)
+        {
+            std::cerr << "Terminal grids are drawn from coverage atlases, run --test-terminal-grid without --distance-field or --subpixel\n";
+            return 1;
+        };
+
+        const ShaderProgram gridProgram = ShaderProgram("Shaders\\TerminalGridVertexShader.glsl", "Shaders\\TerminalGridFragmentShader.glsl");
+
+        // The same grid drawn with a quad per row, its fragments look their cells up
+        const ShaderProgram rowQuadsProgram = ShaderProgram("Shaders\\TerminalGridVertexShader.glsl", "Shaders\\TerminalGridFragmentShader.glsl", true,
+                                                            ShaderCompileMode::Immediate, { std::string(TerminalGridRowQuadsDefine) });
+
+        fontSprite.WaitUntilReady();
+
+        std::vector<std::byte> cellQuadsImage;
+        std::vector<std::byte> rowQuadsImage;
+
+        if(RunTerminalGridTest(fontSprite, gridProgram, cellQuadsImage) != 0 || RunTerminalGridTest(fontSprite, rowQuadsProgram, rowQuadsImage) != 0)
+            return 1;
+
+        return CompareTerminalGridImages(cellQuadsImage, rowQuadsImage);
+    };
+
+    if(testGridDelta == true)
+    {
+        if(atlasFormat != AtlasFormat::Coverage)
+        {
+            std::cerr << "Terminal grids are drawn from coverage atlases, run --test-grid-delta without --distance-field or --subpixel\n";
+            return 1;
+        };
+
+        const ShaderProgram gridProgram = ShaderProgram("Shaders\\TerminalGridVertexShader.glsl", "Shaders\\TerminalGridFragmentShader.glsl");
+
+        return RunGridDeltaTest(fontSprite, gridProgram);
+    };
+
+    if(testLabelCache == true)
+    {
+        const ShaderProgram labelProgram = ShaderProgram("Shaders\\LabelVertexShader.glsl", "Shaders\\LabelFragmentShader.glsl");
+
+        fontSprite.WaitUntilReady();
+
+        return RunLabelCacheTest(fontSprite, labelProgram);
+    };
+
+    if(testTextAnimation == true)
+    {
+        const ShaderProgram& animatedProgram = fontShaders.Get(FontSprite::GetShaderFeatures(atlasFormat, false, false) | static_cast<std::uint32_t>(FontShaderFeature::Animation));
+
+        fontSprite.WaitUntilReady();
+        animatedProgram.WaitUntilReady();
+
+        return RunTextAnimationTest(fontSprite, animatedProgram, atlas.Scale);
+    };
+
+    if(testLabelGrid == true)
+    {
+        const ShaderProgram batchProgram = ShaderProgram("Shaders\\TextBatchVertexShader.glsl", fragmentShaderPath);
+
+        fontSprite.WaitUntilReady();
+
+        return RunLabelGridTest(fontSprite, batchProgram);
+    };
+
+    if(testTextDrawList == true)
+    {
+        const ShaderProgram batchProgram = ShaderProgram("Shaders\\TextBatchVertexShader.glsl", fragmentShaderPath);
+
+        fontSprite.WaitUntilReady();
+
+        return RunTextDrawListTest(fontSprite, batchProgram);
+    };
+
+    if(testTableView == true)
+    {
+        const ShaderProgram batchProgram = ShaderProgram("Shaders\\TextBatchVertexShader.glsl", fragmentShaderPath);
+
+        fontSprite.WaitUntilReady();
+
+        return RunTableViewTest(fontSprite, batchProgram);
+    };
+
+    if(testImmediateText == true)
+    {
+        const ShaderProgram& queuedProgram = fontShaders.Get(FontSprite::GetShaderFeatures(atlasFormat, false, true));
+
+        fontSprite.WaitUntilReady();
+        queuedProgram.WaitUntilReady();
+
+        return RunImmediateTextTest(fontSprite, queuedProgram, atlas.Scale);
+    };
+
+
+    // Input is handled on this thread, everything GL on the render thread.
+    // Edits reach the render thread through a lock-free queue, so a huge paste never holds up a frame and a slow frame never holds up input
+    static RenderCommandQueue renderCommands;
+
+    // Copies of the selection come back the other way, the clipboard belongs to this thread
+    static CopiedSelectionQueue copiedSelections;
+
+    // Only draw when something changed, v-sync paces the frames that are drawn.
+    // The loop still wakes up 4 times a second so shader hot-reload is picked up
+    static FrameScheduler frameScheduler = FrameScheduler(RenderMode::OnDemand, 0.0, 0.25, FrameWakeSource::WakeEvent);
+
+    // Start frames just before the vertical blank, so a keypress is drawn in the very next one
+    if(const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor()); videoMode != nullptr)
+        frameScheduler.SetRefreshRate(static_cast<double>(videoMode->refreshRate));
+
+    frameScheduler.SetLateLatching(true);
+
+    // Windows left in the background, often dozens of them, shouldn't keep the GPU busy.
+    // Hidden ones draw nothing, unfocused ones still show their animations, slowly
+    frameScheduler.SetUnfocusedFrameCap(10.0);
+
+
+    // Resizing, or the window being uncovered, needs a new frame
+    glfwSetWindowRefreshCallback(glfwWindow, [](GLFWwindow*) noexcept
+    {
+        PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::Redraw });
+    });
+
+
+    // Minimizing, restoring and switching virtual desktops all change the focus or the iconified state
+    static const auto sendWindowVisibility = [](GLFWwindow* glfwWindow) noexcept
+    {
+        PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::WindowVisibilityChanged, .Count = static_cast<std::size_t>(GetWindowVisibility(glfwWindow)) });
+    };
+
+    glfwSetWindowIconifyCallback(glfwWindow, [](GLFWwindow* glfwWindow, int) noexcept
+    {
+        sendWindowVisibility(glfwWindow);
+    });
+
+    glfwSetWindowFocusCallback(glfwWindow, [](GLFWwindow* glfwWindow, int) noexcept
+    {
+        sendWindowVisibility(glfwWindow);
+    });
+
+    sendWindowVisibility(glfwWindow);
+
+
+    // Typed characters arrive through the character callback, which already applies the keyboard layout and modifiers.
+    // They're gathered over a whole batch of events and sent to the render thread as a single append, see FlushTypedText
+    glfwSetCharCallback(glfwWindow, [](GLFWwindow*, unsigned int codepoint) noexcept
+    {
+        if(TypedText.empty() == true)
+            TypedTextInputTime = glfwGetTime();
+
+        AppendCodepointAsGlyphText(static_cast<char32_t>(codepoint), TypedText);
+    });
+
+    // Keys that don't produce characters, and shortcuts
+    glfwSetKeyCallback(glfwWindow, [](GLFWwindow* glfwWindow, int key, int, int actions, int modBits) noexcept
+    {
+        if(actions == GLFW_RELEASE)
+            return;
+
+        // Edits have to reach the document in the order they were made
+        FlushTypedText(renderCommands, frameScheduler);
+
+        // F3 toggles an overlay of the last frame's timings
+        if(key == GLFW_KEY_F3)
+        {
+            if(actions == GLFW_PRESS)
+                PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::ToggleProfiler });
+
+            return;
+        };
+
+        // F4 prints the frame time distribution
+        if(key == GLFW_KEY_F4)
+        {
+            if(actions == GLFW_PRESS)
+                PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::DumpFrameStatistics });
+
+            return;
+        };
+
+        // F5 counts the text's shader invocations and fragments, shown in the F3 overlay
+        if(key == GLFW_KEY_F5)
+        {
+            if(actions == GLFW_PRESS)
+                PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::TogglePipelineStatistics });
+
+            return;
+        };
+
+        // F6 shows the text's overdraw as a heatmap
+        if(key == GLFW_KEY_F6)
+        {
+            if(actions == GLFW_PRESS)
+                PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::ToggleOverdrawHeatmap });
+
+            return;
+        };
+
+        if(key == GLFW_KEY_BACKSPACE)
+        {
+            PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::EraseBack, .Count = 1, .InputTime = glfwGetTime() });
+            return;
+        };
+
+        // Paste
+        if((modBits & GLFW_MOD_CONTROL) &&
+           (key == GLFW_KEY_V))
+        {
+            const char* clipboardString = glfwGetClipboardString(glfwWindow);
+
+            if(clipboardString == nullptr)
+                return;
+
+            // Only copied here, the render thread decodes and splices it in a slice per frame, so neither thread stalls on a huge paste
+            PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::Paste, .Text = clipboardString, .InputTime = glfwGetTime() });
+
+            return;
+        };
+
+        // Select all, instant however large the document is
+        if((modBits & GLFW_MOD_CONTROL) &&
+           (key == GLFW_KEY_A))
+        {
+            PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::SelectAll, .InputTime = glfwGetTime() });
+            return;
+        };
+
+        // Copy, the render thread sends the selection back, see CopiedSelection
+        if((modBits & GLFW_MOD_CONTROL) &&
+           (key == GLFW_KEY_C))
+        {
+            PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::Copy, .InputTime = glfwGetTime() });
+            return;
+        };
+
+        // Undo, and redo with either Ctrl+Y or Ctrl+Shift+Z
+        if((modBits & GLFW_MOD_CONTROL) &&
+           (key == GLFW_KEY_Z))
+        {
+            const RenderCommandType type = (modBits & GLFW_MOD_SHIFT) ? RenderCommandType::Redo : RenderCommandType::Undo;
+
+            PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = type, .InputTime = glfwGetTime() });
+            return;
+        };
+
+        if((modBits & GLFW_MOD_CONTROL) &&
+           (key == GLFW_KEY_Y))
+        {
+            PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::Redo, .InputTime = glfwGetTime() });
+            return;
+        };
+
+        if(key == GLFW_KEY_ENTER || key == GLFW_KEY_KP_ENTER)
+        {
+            PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::Append, .Text = "\n", .InputTime = glfwGetTime() });
+            return;
+        };
+
+        if(key == GLFW_KEY_TAB)
+        {
+            PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::Append, .Text = "\t", .InputTime = glfwGetTime() });
+            return;
+        };
+    });
+
+
+    std::optional<TypingLatencyBenchmark> typingBenchmark;
+
+    if(runTypingBenchmark == true)
+        typingBenchmark.emplace();
+
+
+    // The context moves to the render thread, the objects created with it stay valid
+    RenderWindow::Release();
+
+    std::thread renderThread = std::thread([&]()
+    {
+        // Frames keep their pace while other processes or the asset loaders are busy
+        const wt::MMCSSThread mmcssRegistration = wt::MMCSSThread(L"Games");
+
+        // The cache is per-thread, and starts out not knowing what the main thread bound
+        renderWindow.MakeCurrent();
+
+        RenderLoop(renderWindow, fontShaders, fontSprite, atlas.Scale, cursorPipeline, renderCommands, copiedSelections, frameScheduler, diagnosticsLevel, maxFrameAllocations, maxFrameLatency, startupTracePath, drawCapturePath, typingBenchmark.has_value() == true ? &*typingBenchmark : nullptr);
+
+        // Hand the context back so the objects can be destroyed on this thread
+        RenderWindow::Release();
+    });
+
+    // Injection waits for the render thread's first frame
+    if(typingBenchmark.has_value() == true)
+        typingBenchmark->Start(glfwWindow);
+
+
+    // Copies are only read from the document when another application pastes them
+    DelayedClipboard clipboard;
+
+    while(glfwWindowShouldClose(glfwWindow) == false)
+    {
+        glfwWaitEvents();
+
+        // Everything typed during this batch of events goes out as one edit
+        FlushTypedText(renderCommands, frameScheduler);
+
+        for(CopiedSelection copy; copiedSelections.TryPop(copy) == true;)
+        {
+            clipboard.Copy(std::move(copy.Source), copy.Range);
+        };
+    };
+
+    // The copy still on the clipboard reads the document, which goes away with the render thread
+    clipboard.Detach();
+
+    PushRenderCommand(renderCommands, frameScheduler, RenderCommand { .Type = RenderCommandType::Quit });
+
+    renderThread.join();
+
+    #ifdef TEXT_RENDERER_PROFILE_ZONES
+    #ifdef TEXT_RENDERER_TRACY
+    ProfileZones.RemoveBackend(tracyZones);
+    #endif
+
+    if(zoneTracePath.empty() == false)
+    {
+        ProfileZones.RemoveBackend(zoneTrace);
+
+        std::ofstream zoneTraceFile = std::ofstream(zoneTracePath);
+
+        if(zoneTraceFile.is_open() == true)
+            zoneTrace.WriteChromeTraceJSON(zoneTraceFile);
+        else
+            std::cerr << "Unable to write the zone trace to \"" << zoneTracePath << "\"\n";
+    };
+    #endif
+
+    // The render thread changed the bindings since this thread last cached them
+    renderWindow.MakeCurrent();
+
+    if(typingBenchmark.has_value() == true)
+        return WriteTypingLatencyResults(*typingBenchmark, typingBenchmarkOutputPath);
 };
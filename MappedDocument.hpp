@@ -0,0 +1,567 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <system_error>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "DocumentLayoutCache.hpp"
+#include "JobSystem.hpp"
+#include "MappedFile.hpp"
+#include "TextConversion.hpp"
+
+
+/// <summary>
+/// A read-only document backed by a memory-mapped file, for files too large to read into memory, e.g. logs of several GB.
+/// The file is never copied, its lines are read in place and only the pages that are looked at are ever touched.
+/// Lines are indexed on a background thread, a chunk at a time, and can be read as soon as their chunk is done,
+/// so the start of the file is shown right away while the rest is still being indexed. See TextView::SetDocument.
+/// Given a JobSystem, each round indexes a chunk per thread and publishes them in file order.
+/// A file that's still being written, e.g. a log, is followed with Refresh, which maps it again and only indexes what was appended.
+/// With a layout cache, a large file's line index is kept in a sidecar once it's done, and reopening the file maps it instead of indexing again,
+/// see DocumentLayoutCache
+/// </summary>
+class MappedDocument
+{
+
+private:
+
+    std::filesystem::path _path;
+
+    /// <summary>
+    /// Replaced by Refresh when the file has grown
+    /// </summary>
+    std::unique_ptr<MappedFile> _file;
+
+    /// <summary>
+    /// Bumped every time the file is mapped again, see GetMappingVersion
+    /// </summary>
+    std::uint64_t _mappingVersion = 0;
+
+    std::size_t _chunkSizeInBytes = 0;
+
+    /// <summary>
+    /// Indexes chunks in parallel if set, otherwise the indexer thread scans them alone
+    /// </summary>
+    JobSystem* _jobs = nullptr;
+
+    /// <summary>
+    /// Whether the line index and row counts are kept in sidecars, see DocumentLayoutCache
+    /// </summary>
+    bool _useLayoutCache = false;
+
+    /// <summary>
+    /// (Layout cache) The mapped sidecar of the lines found by a previous run, the first lines. Null if there was none
+    /// </summary>
+    std::unique_ptr<DocumentLayoutCache> _lineCache;
+
+    /// <summary>
+    /// _lineCache's lines, in place
+    /// </summary>
+    std::span<const std::uint64_t> _cachedLineStarts;
+
+    /// <summary>
+    /// The offset of every line's first character that's been found so far, after _cachedLineStarts.
+    /// A deque, so growing never moves the lines already found
+    /// </summary>
+    std::deque<std::uint64_t> _lineStarts = { 0 };
+
+    /// <summary>
+    /// Guards _lineStarts and _cachedLineStarts, held by the indexer only while it appends a chunk's lines or swaps the sidecar
+    /// </summary>
+    mutable std::mutex _lineStartsLock;
+
+    /// <summary>
+    /// How much of the file has been indexed, a line's end is only known up to here
+    /// </summary>
+    std::atomic<std::uint64_t> _indexedSize = 0;
+
+    std::atomic<bool> _indexingDone = false;
+
+    std::atomic<bool> _stopping = false;
+
+    std::thread _indexer;
+
+
+public:
+
+    /// <summary>
+    /// The size of the first chunk indexed, small so the first screen is there almost immediately
+    /// </summary>
+    static constexpr std::size_t FirstChunkSizeInBytes = 64 * 1024;
+
+    /// <summary>
+    /// Smaller files are indexed faster than a sidecar is checked, they don't get one
+    /// </summary>
+    static constexpr std::uint64_t MinLayoutCacheSizeInBytes = 16 * 1024 * 1024;
+
+
+public:
+
+    /// <param name="path"> The file to map. Other processes may keep writing to it </param>
+    /// <param name="chunkSizeInBytes"> How much of the file a single thread indexes at a time </param>
+    /// <param name="jobs"> If given, chunks are indexed on its threads too. Must outlive the document </param>
+    /// <param name="useLayoutCache"> If true, a file of at least MinLayoutCacheSizeInBytes keeps its line index and row counts in sidecars next to it </param>
+    MappedDocument(std::filesystem::path path, const std::size_t chunkSizeInBytes = 4 * 1024 * 1024, JobSystem* jobs = nullptr, const bool useLayoutCache = false) :
+        _path(std::move(path)),
+        _file(std::make_unique<MappedFile>(_path, false, true)),
+        _chunkSizeInBytes(std::max<std::size_t>(chunkSizeInBytes, 1)),
+        _jobs(jobs)
+    {
+        if(_file->IsMapped() == false)
+        {
+            _indexingDone = true;
+            return;
+        };
+
+        _useLayoutCache = useLayoutCache == true && _file->GetSizeInBytes() >= MinLayoutCacheSizeInBytes;
+
+        std::uint64_t indexedSize = 0;
+
+        if(_useLayoutCache == true)
+            indexedSize = LoadLineCache();
+
+        _indexedSize.store(indexedSize, std::memory_order_release);
+
+        // Reopened unchanged, there's nothing left to index
+        if(indexedSize == _file->GetSizeInBytes())
+        {
+            _indexingDone = true;
+            return;
+        };
+
+        // The sidecar is written again once the rest is indexed, or appended to since it was written
+        StartIndexing(indexedSize, _useLayoutCache);
+    };
+
+    MappedDocument(const MappedDocument&) = delete;
+    MappedDocument& operator = (const MappedDocument&) = delete;
+
+    /// <summary>
+    /// Stops indexing at the next chunk
+    /// </summary>
+    ~MappedDocument()
+    {
+        _stopping.store(true, std::memory_order_relaxed);
+
+        if(_indexer.joinable() == true)
+            _indexer.join();
+    };
+
+
+public:
+
+    /// <summary>
+    /// The number of lines found so far, the last one may still grow while the file is being indexed
+    /// </summary>
+    std::size_t GetLineCount() const
+    {
+        const std::lock_guard lock = std::lock_guard(_lineStartsLock);
+
+        return _cachedLineStarts.size() + _lineStarts.size();
+    };
+
+    /// <summary>
+    /// The text of a range of lines, read in place. The last line's trailing newline is left out
+    /// </summary>
+    /// <param name="firstLine"> The first line of the range </param>
+    /// <param name="endLine"> One past the range's last line, at most GetLineCount </param>
+    std::string_view GetLines(const std::size_t firstLine, const std::size_t endLine) const
+    {
+        std::uint64_t start = 0;
+        std::uint64_t end = 0;
+
+        bool lastLine = false;
+
+        {
+            const std::lock_guard lock = std::lock_guard(_lineStartsLock);
+
+            // Published with the lines, so the last line never starts past it
+            const std::uint64_t indexedSize = _indexedSize.load(std::memory_order_relaxed);
+
+            const std::size_t lineCount = _cachedLineStarts.size() + _lineStarts.size();
+
+            wt::Assert(firstLine <= endLine && endLine <= lineCount, "Line range out of bounds");
+
+            if(firstLine == endLine)
+                return { };
+
+            lastLine = endLine == lineCount;
+
+            start = GetLineStart(firstLine);
+            end = lastLine == false ? GetLineStart(endLine) - 1 : indexedSize;
+        };
+
+        const std::string_view text = _file->GetText();
+
+        // The file's own last newline, and the '\r' of "\r\n" files. Inner lines keep theirs, the layout skips control characters
+        if(lastLine == true && end > start && text[end - 1] == '\n')
+            --end;
+
+        if(end > start && text[end - 1] == '\r')
+            --end;
+
+        return text.substr(start, end - start);
+    };
+
+    /// <summary>
+    /// The offset of a line's first character in the file, e.g. to turn a line and column into a TextSelection position
+    /// </summary>
+    /// <param name="line"> Less than GetLineCount </param>
+    std::uint64_t GetLineOffset(const std::size_t line) const
+    {
+        const std::lock_guard lock = std::lock_guard(_lineStartsLock);
+
+        wt::Assert(line < _cachedLineStarts.size() + _lineStarts.size(), "Line out of bounds");
+
+        return GetLineStart(line);
+    };
+
+
+    /// <summary>
+    /// Follow a file that's being appended to, like tail -f. If the file has grown since it was mapped, map it again
+    /// and index only the appended part. Views returned by GetLines and GetText are invalidated, see GetMappingVersion.
+    /// Call from the thread that reads the lines, e.g. once per frame before drawing
+    /// </summary>
+    /// <returns> True if the file was mapped again, false if it hasn't grown or the last part is still being indexed </returns>
+    bool Refresh()
+    {
+        if(IsIndexed() == false)
+            return false;
+
+        const std::uint64_t previousSize = GetSizeInBytes();
+
+        // Cheaper than mapping the file again to find out it hasn't changed. A file that shrank was rewritten, which isn't followed
+        std::error_code error;
+        const std::uint64_t fileSize = std::filesystem::file_size(_path, error);
+
+        if(error || fileSize <= previousSize)
+            return false;
+
+
+        std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>(_path, false, true);
+
+        if(file->IsMapped() == false || file->GetSizeInBytes() <= previousSize)
+            return false;
+
+        // Already done, the thread only has to exit
+        if(_indexer.joinable() == true)
+            _indexer.join();
+
+        _file = std::move(file);
+
+        ++_mappingVersion;
+
+        _indexingDone.store(false, std::memory_order_relaxed);
+
+        StartIndexing(previousSize);
+
+        return true;
+    };
+
+
+public:
+
+    /// <summary>
+    /// The whole file, only the indexed part of it has lines
+    /// </summary>
+    std::string_view GetText() const
+    {
+        return _file->GetText();
+    };
+
+    std::uint64_t GetSizeInBytes() const
+    {
+        return _file->GetSizeInBytes();
+    };
+
+    /// <summary>
+    /// Changes whenever Refresh maps the file again, text read before that must be read again
+    /// </summary>
+    std::uint64_t GetMappingVersion() const
+    {
+        return _mappingVersion;
+    };
+
+    /// <summary>
+    /// How much of the file has been indexed, grows as lines are found
+    /// </summary>
+    std::uint64_t GetIndexedSize() const
+    {
+        return _indexedSize.load(std::memory_order_acquire);
+    };
+
+    bool IsIndexed() const
+    {
+        return _indexingDone.load(std::memory_order_acquire);
+    };
+
+    /// <summary>
+    /// Block until every line has been found
+    /// </summary>
+    void WaitUntilIndexed() const
+    {
+        _indexingDone.wait(false, std::memory_order_acquire);
+    };
+
+    bool IsMapped() const
+    {
+        return _file->IsMapped();
+    };
+
+
+public:
+
+    bool UsesLayoutCache() const
+    {
+        return _useLayoutCache;
+    };
+
+    /// <summary>
+    /// (Layout cache) Map the row counts a previous run wrapped the document's lines into. The last line may have grown since,
+    /// only the ones before it still hold. Call from the thread that reads the lines
+    /// </summary>
+    /// <returns> Null if there are none for the key, or they're of a different file </returns>
+    std::unique_ptr<DocumentLayoutCache> LoadRowCounts(const DocumentWrapKey& wrapKey) const
+    {
+        if(_useLayoutCache == false)
+            return nullptr;
+
+        std::unique_ptr<DocumentLayoutCache> rowCounts = std::make_unique<DocumentLayoutCache>(DocumentLayoutCache::GetRowCountsPath(_path, wrapKey),
+                                                                                               _path,
+                                                                                               _file->GetText(),
+                                                                                               DocumentLayoutCacheKind::RowCounts,
+                                                                                               wrapKey);
+
+        if(rowCounts->IsValid() == false)
+            return nullptr;
+
+        return rowCounts;
+    };
+
+    /// <summary>
+    /// (Layout cache) Keep the row counts of the first lines, wrapped with a key. Rows loaded with the same key must be destroyed first.
+    /// Call from the thread that reads the lines
+    /// </summary>
+    /// <returns> False if the document has no layout cache, or the sidecar couldn't be written </returns>
+    bool SaveRowCounts(const DocumentWrapKey& wrapKey, const std::span<const std::uint32_t>& rowCounts) const
+    {
+        if(_useLayoutCache == false)
+            return false;
+
+        return DocumentLayoutCache::Write<std::uint32_t>(DocumentLayoutCache::GetRowCountsPath(_path, wrapKey),
+                                                         DocumentLayoutCacheKind::RowCounts,
+                                                         DocumentLayoutCache::GetFingerprint(_path, _file->GetText()),
+                                                         wrapKey,
+                                                         rowCounts.size(),
+                                                         [&](const auto& write)
+        {
+            write(rowCounts);
+        });
+    };
+
+
+private:
+
+    /// <summary>
+    /// (_lineStartsLock) A line's first character, from the sidecar or found since
+    /// </summary>
+    std::uint64_t GetLineStart(const std::size_t line) const
+    {
+        return line < _cachedLineStarts.size() ? _cachedLineStarts[line] : _lineStarts[line - _cachedLineStarts.size()];
+    };
+
+    /// <summary>
+    /// Map the line index of a previous run, if it's of this file or of its start before something was appended
+    /// </summary>
+    /// <returns> How much of the file its lines were found in, 0 if there's none </returns>
+    std::uint64_t LoadLineCache()
+    {
+        const std::filesystem::path path = DocumentLayoutCache::GetLineStartsPath(_path);
+
+        // Written by a run that was still reading the previous sidecar, see SaveLineCache. Nothing maps either now
+        std::error_code error;
+
+        if(std::filesystem::exists(GetNewLineCachePath(), error) == true)
+            std::filesystem::rename(GetNewLineCachePath(), path, error);
+
+        std::unique_ptr<DocumentLayoutCache> lineCache = std::make_unique<DocumentLayoutCache>(path, _path, _file->GetText(), DocumentLayoutCacheKind::LineStarts);
+
+        if(lineCache->IsValid() == false || lineCache->GetLineStarts().empty() == true)
+            return 0;
+
+        _lineCache = std::move(lineCache);
+        _cachedLineStarts = _lineCache->GetLineStarts();
+        _lineStarts.clear();
+
+        return _lineCache->GetFingerprint().SizeInBytes;
+    };
+
+    /// <summary>
+    /// (Indexer thread) Write every line found to the sidecar, and read them from it from now on, which frees the ones in memory.
+    /// While the previous sidecar is mapped it can't be replaced, the new one is then left next to it and takes its place on the next open
+    /// </summary>
+    void SaveLineCache()
+    {
+        const std::filesystem::path path = _lineCache == nullptr ? DocumentLayoutCache::GetLineStartsPath(_path) : GetNewLineCachePath();
+
+        const std::string_view text = _file->GetText();
+
+        // Lines are only ever appended, and the indexer is the only one appending, so they can be read outside the lock
+        const std::span<const std::uint64_t> cachedLineStarts = _cachedLineStarts;
+        const std::size_t lineCount = GetLineCount();
+
+        const bool written = DocumentLayoutCache::Write<std::uint64_t>(path,
+                                                                       DocumentLayoutCacheKind::LineStarts,
+                                                                       DocumentLayoutCache::GetFingerprint(_path, text),
+                                                                       { },
+                                                                       lineCount,
+                                                                       [&](const auto& write)
+        {
+            write(cachedLineStarts);
+
+            // Copied a block at a time, the deque isn't contiguous
+            std::vector<std::uint64_t> block;
+            block.reserve(64 * 1024);
+
+            for(std::size_t line = cachedLineStarts.size(); line < lineCount; ++line)
+            {
+                block.push_back(_lineStarts[line - cachedLineStarts.size()]);
+
+                if(block.size() == block.capacity())
+                {
+                    write(std::span<const std::uint64_t>(block));
+                    block.clear();
+                };
+            };
+
+            write(std::span<const std::uint64_t>(block));
+        });
+
+        if(written == false)
+            return;
+
+        std::unique_ptr<DocumentLayoutCache> lineCache = std::make_unique<DocumentLayoutCache>(path, _path, text, DocumentLayoutCacheKind::LineStarts);
+
+        if(lineCache->GetLineStarts().size() != lineCount)
+            return;
+
+        const std::lock_guard lock = std::lock_guard(_lineStartsLock);
+
+        _lineCache = std::move(lineCache);
+        _cachedLineStarts = _lineCache->GetLineStarts();
+        _lineStarts.clear();
+    };
+
+    std::filesystem::path GetNewLineCachePath() const
+    {
+        std::filesystem::path path = DocumentLayoutCache::GetLineStartsPath(_path);
+        path += ".new";
+
+        return path;
+    };
+
+    /// <summary>
+    /// Index the file from an offset on, on a new indexer thread
+    /// </summary>
+    /// <param name="saveLineCache"> Whether to write the sidecar once done. Files that are followed aren't written again every time they grow </param>
+    void StartIndexing(const std::uint64_t offset, const bool saveLineCache = false)
+    {
+        _indexer = std::thread([this, offset, saveLineCache]()
+        {
+            IndexLines(offset);
+
+            if(saveLineCache == true && _stopping.load(std::memory_order_relaxed) == false)
+                SaveLineCache();
+        });
+    };
+
+    /// <summary>
+    /// (Indexer thread) Find every line start from an offset on. Chunks are scanned a round at a time, a chunk per thread,
+    /// and each round's lines are published together in file order
+    /// </summary>
+    void IndexLines(const std::uint64_t startOffset)
+    {
+        const std::string_view text = _file->GetText();
+
+        const std::size_t threadCount = _jobs != nullptr ? _jobs->GetWorkerCount() + 1 : 1;
+
+        // Reused every round, a chunk's lines only need merging once every chunk before it is done
+        std::vector<std::vector<std::uint64_t>> chunkLineStarts = std::vector<std::vector<std::uint64_t>>(threadCount);
+
+        std::uint64_t offset = startOffset;
+
+        // A file that ended with a newline when it was last indexed has had its next line appended since
+        bool lineStartsAtOffset = offset != 0 && text[offset - 1] == '\n';
+
+        // Only the first round of a new file is small, growth is usually small anyway
+        std::size_t chunkSize = offset == 0 ? std::min(FirstChunkSizeInBytes, _chunkSizeInBytes) : _chunkSizeInBytes;
+        std::size_t chunkCount = offset == 0 ? 1 : threadCount;
+
+        while(offset < text.size() && _stopping.load(std::memory_order_relaxed) == false)
+        {
+            const std::uint64_t roundOffset = offset;
+
+            chunkCount = std::min<std::size_t>(chunkCount, (text.size() - roundOffset + chunkSize - 1) / chunkSize);
+
+            const auto indexChunks = [&](const std::size_t firstChunk, const std::size_t endChunk)
+            {
+                for(std::size_t chunk = firstChunk; chunk < endChunk; ++chunk)
+                {
+                    const std::uint64_t chunkOffset = roundOffset + chunk * chunkSize;
+
+                    chunkLineStarts[chunk].clear();
+
+                    FindLineStarts(text.substr(chunkOffset, chunkSize), chunkOffset, chunkLineStarts[chunk]);
+                };
+            };
+
+            if(_jobs != nullptr && chunkCount > 1)
+                _jobs->ParallelFor(chunkCount, 1, indexChunks);
+            else
+                indexChunks(0, chunkCount);
+
+            offset = std::min<std::uint64_t>(roundOffset + chunkCount * chunkSize, text.size());
+
+
+            // A newline at the very end doesn't start another line, until something is appended after it
+            std::vector<std::uint64_t>& lastChunkLineStarts = chunkLineStarts[chunkCount - 1];
+
+            if(lastChunkLineStarts.empty() == false && lastChunkLineStarts.back() == text.size())
+                lastChunkLineStarts.pop_back();
+
+
+            {
+                const std::lock_guard lock = std::lock_guard(_lineStartsLock);
+
+                if(lineStartsAtOffset == true)
+                    _lineStarts.push_back(roundOffset);
+
+                for(std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+                {
+                    _lineStarts.insert(_lineStarts.end(), chunkLineStarts[chunk].cbegin(), chunkLineStarts[chunk].cend());
+                };
+
+                _indexedSize.store(offset, std::memory_order_release);
+            };
+
+            lineStartsAtOffset = false;
+
+            chunkSize = _chunkSizeInBytes;
+            chunkCount = threadCount;
+        };
+
+        _indexingDone.store(true, std::memory_order_release);
+        _indexingDone.notify_all();
+    };
+
+};
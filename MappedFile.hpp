@@ -0,0 +1,151 @@
+#pragma once
+
+#include <Windows.h>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A read-only, memory-mapped file.
+/// The file's contents are accessed in place, without reading them into an intermediate buffer
+/// </summary>
+class MappedFile
+{
+
+private:
+
+    wt::SmartWin32Handle _file = nullptr;
+
+    wt::SmartWin32Handle _fileMapping = nullptr;
+
+    /// <summary>
+    /// The start of the mapped view
+    /// </summary>
+    const std::byte* _view = nullptr;
+
+    std::size_t _sizeInBytes = 0;
+
+
+public:
+
+    /// <summary>
+    /// Map a file
+    /// </summary>
+    /// <param name="path"> The file's path </param>
+    /// <param name="assertOnFailure"> If false, a file that can't be opened is simply left unmapped. See IsMapped </param>
+    /// <param name="allowWriters"> If true, the file can be mapped while another process has it open for writing, e.g. a log. Only the size it had when mapped is visible </param>
+    MappedFile(const std::filesystem::path& path, const bool assertOnFailure = true, const bool allowWriters = false)
+    {
+        const DWORD shareMode = allowWriters == true ? FILE_SHARE_READ | FILE_SHARE_WRITE : FILE_SHARE_READ;
+
+        const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, shareMode, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        wt::Assert(assertOnFailure == false || file != INVALID_HANDLE_VALUE, [&]()
+        {
+            return std::string("Error occured while trying open the file \"").append(path.string()).append("\"");
+        });
+
+        if(file == INVALID_HANDLE_VALUE)
+            return;
+
+        _file = file;
+
+
+        LARGE_INTEGER fileSize {};
+        GetFileSizeEx(_file, &fileSize);
+
+        _sizeInBytes = static_cast<std::size_t>(fileSize.QuadPart);
+
+        // Empty files can't be mapped, they're simply empty views
+        if(_sizeInBytes == 0)
+            return;
+
+
+        _fileMapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        wt::Assert(_fileMapping.Get() != nullptr, [&]()
+        {
+            return std::string("Unable to map the file \"").append(path.string()).append("\"");
+        });
+
+        if(_fileMapping.Get() == nullptr)
+        {
+            _sizeInBytes = 0;
+            return;
+        };
+
+        _view = static_cast<const std::byte*>(MapViewOfFile(_fileMapping, FILE_MAP_READ, 0, 0, 0));
+
+        if(_view == nullptr)
+            _sizeInBytes = 0;
+    };
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        if(_view != nullptr)
+            UnmapViewOfFile(_view);
+    };
+
+
+public:
+
+    /// <summary>
+    /// The file's contents as text, only valid while the file is mapped
+    /// </summary>
+    /// <returns></returns>
+    std::string_view GetText() const
+    {
+        return std::string_view(reinterpret_cast<const char*>(_view), _sizeInBytes);
+    };
+
+    /// <summary>
+    /// The file's contents, only valid while the file is mapped
+    /// </summary>
+    /// <returns></returns>
+    std::span<const std::byte> GetBytes() const
+    {
+        return std::span<const std::byte>(_view, _sizeInBytes);
+    };
+
+    std::size_t GetSizeInBytes() const
+    {
+        return _sizeInBytes;
+    };
+
+    /// <summary>
+    /// Read the whole file into memory now, so whoever reads the view next doesn't stall on page faults.
+    /// Meant for an I/O thread, see AssetLoader
+    /// </summary>
+    void ReadAhead() const
+    {
+        if(_view == nullptr)
+            return;
+
+        WIN32_MEMORY_RANGE_ENTRY range = { const_cast<std::byte*>(_view), _sizeInBytes };
+
+        // Only a hint, the pages are then touched to make sure they're in
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+
+        constexpr std::size_t PageSize = 4096;
+
+        volatile std::byte sink {};
+
+        for(std::size_t offset = 0; offset < _sizeInBytes; offset += PageSize)
+        {
+            sink = _view[offset];
+        };
+    };
+
+    bool IsMapped() const
+    {
+        return _view != nullptr;
+    };
+};
@@ -0,0 +1,581 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/common.hpp>
+
+#include "ComputeProgram.hpp"
+#include "ShaderProgram.hpp"
+#include "GLObject.hpp"
+#include "GLStateCache.hpp"
+#include "GPUMemory.hpp"
+#include "MappedDocument.hpp"
+#include "TextStyle.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The shader storage binding a minimap tile's characters are bound to while it's rendered, see MinimapComputeShader.glsl
+/// </summary>
+constexpr std::uint32_t MinimapCharactersBindingIndex = 21;
+
+/// <summary>
+/// The shader storage binding a minimap tile's colour spans are bound to while it's rendered, see MinimapComputeShader.glsl
+/// </summary>
+constexpr std::uint32_t MinimapSpansBindingIndex = 22;
+
+
+/// <summary>
+/// The lines a Minimap draws
+/// </summary>
+class IMinimapSource
+{
+
+public:
+
+    virtual ~IMinimapSource() = default;
+
+
+public:
+
+    virtual std::size_t GetLineCount() const = 0;
+
+    /// <summary>
+    /// The text of a range of lines, each but the last ending in '\n', e.g. MappedDocument::GetLines
+    /// </summary>
+    virtual std::string_view GetLines(const std::size_t firstLine, const std::size_t endLine) const = 0;
+
+    /// <summary>
+    /// The colour spans of a range of lines, if the text has any, appended in order. FirstCharacter counts from the start of GetLines' text for the same lines.
+    /// Characters before the first span, and text without spans, get the minimap's TextColour
+    /// </summary>
+    virtual void GetSpans(const std::size_t /* firstLine */, const std::size_t /* endLine */, std::vector<TextSpan>& /* spans */) const
+    {
+    };
+
+};
+
+
+/// <summary>
+/// Draws a memory-mapped file's lines, without spans
+/// </summary>
+class MappedDocumentMinimapSource final : public IMinimapSource
+{
+
+private:
+
+    const MappedDocument& _document;
+
+
+public:
+
+    /// <param name="document"> Must outlive the source </param>
+    MappedDocumentMinimapSource(const MappedDocument& document) :
+        _document(document)
+    {
+    };
+
+
+public:
+
+    virtual std::size_t GetLineCount() const override
+    {
+        return _document.GetLineCount();
+    };
+
+    virtual std::string_view GetLines(const std::size_t firstLine, const std::size_t endLine) const override
+    {
+        return _document.GetLines(firstLine, endLine);
+    };
+
+};
+
+
+/// <summary>
+/// A zoomed-out column of the whole document, every character a block of a pixel or two in its colour, for navigating huge files.
+/// The glyph path isn't involved at all: the document is cut into tiles of TileLines lines, and a compute pass writes a tile's blocks straight
+/// from its characters and spans into a layer of a texture array, which is then drawn as a single quad. Tiles are cached, so scrolling
+/// only renders the tiles that come into view, and an edit only renders the tiles it touched again, see Invalidate.
+/// Only the first Columns characters of a line are drawn
+/// </summary>
+class Minimap
+{
+
+private:
+
+    struct Tile
+    {
+        /// <summary>
+        /// The tile's place in the document, its lines start at Index * TileLines. InvalidTile while the layer is free
+        /// </summary>
+        std::size_t Index = InvalidTile;
+
+        std::uint64_t LastUsedFrame = 0;
+
+        /// <summary>
+        /// Whether the tile's lines changed since it was rendered. A stale tile is still drawn until it's rendered again
+        /// </summary>
+        bool Stale = true;
+
+        bool Rendered = false;
+    };
+
+
+    std::reference_wrapper<const ShaderProgram> _drawProgram;
+
+    ComputeProgram _tileProgram;
+
+    UniformHandle _tileRectUniform;
+    UniformHandle _tileTextureRectUniform;
+    UniformHandle _tileLayerUniform;
+
+    std::int32_t _columnsLocation = -1;
+    std::int32_t _tileLinesLocation = -1;
+    std::int32_t _cellSizeLocation = -1;
+    std::int32_t _layerLocation = -1;
+    std::int32_t _spanCountLocation = -1;
+    std::int32_t _textColourLocation = -1;
+
+    std::uint32_t _columns = 0;
+
+    std::uint32_t _tileLines = 0;
+
+    glm::uvec2 _cellSize = { 1, 2 };
+
+    /// <summary>
+    /// A layer per cached tile, RGBA8
+    /// </summary>
+    GLTexture _tileTexture;
+
+    GLVertexArray _vao;
+
+    std::vector<Tile> _tiles;
+
+    /// <summary>
+    /// The layer each cached tile is in
+    /// </summary>
+    std::unordered_map<std::size_t, std::uint32_t> _tileLayers;
+
+    /// <summary>
+    /// A tile's characters, a row of Columns per line, 0 past the end of a line
+    /// </summary>
+    std::vector<char> _cells;
+
+    GLBuffer _cellsBuffer;
+
+    /// <summary>
+    /// The offset of each of a tile's lines in its text
+    /// </summary>
+    std::vector<std::size_t> _lineStarts;
+
+    std::vector<TextSpan> _spans;
+
+    GLBuffer _spansBuffer;
+
+    std::size_t _spanCapacity = 0;
+
+    glm::vec4 _textColour = { 0.0f, 0.0f, 0.0f, 0.6f };
+
+    std::uint64_t _frame = 1;
+
+    std::uint64_t _renderedTileCount = 0;
+
+    /// <summary>
+    /// Where the last Draw put the minimap and the line at its top, for GetLineAt
+    /// </summary>
+    glm::vec4 _drawnRect = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    std::size_t _drawnFirstLine = 0;
+
+
+public:
+
+    /// <summary>
+    /// How many stale tiles a draw renders again at most, the rest are drawn as they were and rendered by the next draws.
+    /// Tiles that were never rendered are always rendered
+    /// </summary>
+    std::size_t MaxTileUpdatesPerDraw = 2;
+
+    static constexpr const char* DefaultComputeShaderPath = "Shaders\\MinimapComputeShader.glsl";
+
+
+public:
+
+    /// <param name="drawProgram"> A program built from MinimapVertexShader.glsl and MinimapFragmentShader.glsl, drawn with alpha blending </param>
+    /// <param name="columns"> How many characters of a line are drawn, the minimap is Columns * cellSize.x pixels wide </param>
+    /// <param name="tileLines"> How many lines a tile holds </param>
+    /// <param name="tileCapacity"> How many tiles are cached, at least as many as the tallest minimap shows at once, plus one </param>
+    /// <param name="cellSize"> Each character's block, in pixels </param>
+    Minimap(const ShaderProgram& drawProgram,
+            const std::uint32_t columns = 120,
+            const std::uint32_t tileLines = 256,
+            const std::uint32_t tileCapacity = 16,
+            const glm::uvec2& cellSize = { 1, 2 },
+            const std::string& computeShaderPath = DefaultComputeShaderPath) :
+        _drawProgram(drawProgram),
+        _tileProgram(computeShaderPath),
+        _columns(std::max(columns, 1u)),
+        _tileLines(std::max(tileLines, 1u)),
+        _cellSize(glm::max(cellSize, glm::uvec2(1, 1))),
+        _tiles(std::max(tileCapacity, 1u))
+    {
+        _tileRectUniform = drawProgram.GetUniformHandle("TileRect");
+        _tileTextureRectUniform = drawProgram.GetUniformHandle("TileTextureRect");
+        _tileLayerUniform = drawProgram.GetUniformHandle("TileLayer");
+
+        _columnsLocation = _tileProgram.GetUniformLocation("Columns");
+        _tileLinesLocation = _tileProgram.GetUniformLocation("TileLines");
+        _cellSizeLocation = _tileProgram.GetUniformLocation("CellSize");
+        _layerLocation = _tileProgram.GetUniformLocation("Layer");
+        _spanCountLocation = _tileProgram.GetUniformLocation("SpanCount");
+        _textColourLocation = _tileProgram.GetUniformLocation("TextColour");
+
+        const std::uint32_t layerWidth = _columns * _cellSize.x;
+        const std::uint32_t layerHeight = _tileLines * _cellSize.y;
+
+        std::uint32_t textureID = 0;
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &textureID);
+
+        _tileTexture = GLTexture(textureID);
+
+        glTextureStorage3D(textureID, 1, GL_RGBA8, static_cast<GLsizei>(layerWidth), static_cast<GLsizei>(layerHeight), static_cast<GLsizei>(_tiles.size()));
+
+        // Each block is a whole number of texels, drawn at its own size
+        glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        GPUMemory.TrackTexture(textureID, GetTextureSizeInBytes(layerWidth, layerHeight, _tiles.size(), 1, 32), GPUMemoryCategory::Cache);
+
+        // Read as uints by the compute shader
+        _cells.resize(((static_cast<std::size_t>(_columns) * _tileLines) + 3) & ~static_cast<std::size_t>(3));
+
+        _cellsBuffer = GLBuffer::Create();
+        glNamedBufferStorage(_cellsBuffer.Get(), static_cast<GLsizeiptr>(_cells.size()), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        _vao = GLVertexArray::Create();
+    };
+
+    Minimap(const Minimap&) = delete;
+    Minimap& operator = (const Minimap&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Render the tiles of a range of lines again the next time they're drawn, after they were edited.
+    /// An edit that adds or removes lines moves every line after it, invalidate from the edit to the end
+    /// </summary>
+    /// <param name="endLine"> One past the last line that changed, the end of the document by default </param>
+    void Invalidate(const std::size_t firstLine, const std::size_t endLine = std::numeric_limits<std::size_t>::max())
+    {
+        const std::size_t firstTile = firstLine / _tileLines;
+        const std::size_t endTile = endLine == std::numeric_limits<std::size_t>::max() ? endLine : (endLine + _tileLines - 1) / _tileLines;
+
+        for(Tile& tile : _tiles)
+        {
+            if(tile.Index != InvalidTile && tile.Index >= firstTile && tile.Index < endTile)
+                tile.Stale = true;
+        };
+    };
+
+    /// <summary>
+    /// Render every tile again, e.g. for a different document
+    /// </summary>
+    void InvalidateAll()
+    {
+        Invalidate(0);
+    };
+
+    /// <summary>
+    /// The colour of characters no span covers. Straight alpha, a minimap is usually drawn faint
+    /// </summary>
+    void SetTextColour(const glm::vec4& textColour)
+    {
+        if(textColour == _textColour)
+            return;
+
+        _textColour = textColour;
+
+        InvalidateAll();
+    };
+
+
+    /// <summary>
+    /// Render the tiles that came into view or were edited, then draw the minimap into the bound framebuffer
+    /// </summary>
+    /// <param name="rect"> Where the minimap goes, in screen space: left, top, width, height. It shows as many lines as fit in the height </param>
+    /// <param name="firstLine"> The line at the top of the minimap, e.g. to keep the view's lines in the middle of it </param>
+    void Draw(const IMinimapSource& source, const glm::vec4& rect, const std::size_t firstLine)
+    {
+        _drawnRect = rect;
+        _drawnFirstLine = firstLine;
+
+        const std::size_t lineCount = source.GetLineCount();
+
+        const std::size_t visibleLineCount = static_cast<std::size_t>(std::ceil(rect.w / static_cast<float>(_cellSize.y)));
+
+        const std::size_t endLine = std::min(firstLine + visibleLineCount, lineCount);
+
+        if(firstLine >= endLine)
+            return;
+
+        const std::size_t firstTile = firstLine / _tileLines;
+        const std::size_t endTile = (endLine + _tileLines - 1) / _tileLines;
+
+        wt::Assert(endTile - firstTile <= _tiles.size(), "The minimap shows more tiles than it caches");
+
+
+        std::size_t updateCount = 0;
+
+        for(std::size_t tileIndex = firstTile; tileIndex < endTile; ++tileIndex)
+        {
+            const std::uint32_t layer = FindOrAllocateLayer(tileIndex);
+
+            Tile& tile = _tiles[layer];
+
+            tile.LastUsedFrame = _frame;
+
+            if(tile.Stale == true && (tile.Rendered == false || updateCount < MaxTileUpdatesPerDraw))
+            {
+                RenderTile(source, tile, layer);
+
+                ++updateCount;
+            };
+        };
+
+        // The tiles are sampled by the draw
+        if(updateCount > 0)
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+
+        const ShaderProgram& drawProgram = _drawProgram.get();
+
+        drawProgram.Bind();
+
+        GLState.BindTextureUnit(0, _tileTexture.Get());
+        GLState.BindAttributelessVertexArray(_vao.Get());
+
+        const float cellWidth = static_cast<float>(_cellSize.x);
+        const float cellHeight = static_cast<float>(_cellSize.y);
+
+        const float width = std::min(rect.z, static_cast<float>(_columns) * cellWidth);
+
+        // Each tile's visible lines, the first and last tiles are usually cut
+        for(std::size_t tileIndex = firstTile; tileIndex < endTile; ++tileIndex)
+        {
+            const std::uint32_t layer = _tileLayers.at(tileIndex);
+
+            const std::size_t tileFirstLine = tileIndex * _tileLines;
+
+            const std::size_t drawnFirstLine = std::max(tileFirstLine, firstLine);
+            const std::size_t drawnEndLine = std::min(tileFirstLine + _tileLines, endLine);
+
+            const float top = rect.y + static_cast<float>(drawnFirstLine - firstLine) * cellHeight;
+            const float height = static_cast<float>(drawnEndLine - drawnFirstLine) * cellHeight;
+
+            const float textureTop = static_cast<float>(drawnFirstLine - tileFirstLine) / static_cast<float>(_tileLines);
+            const float textureBottom = static_cast<float>(drawnEndLine - tileFirstLine) / static_cast<float>(_tileLines);
+
+            drawProgram.SetVector4(_tileRectUniform, glm::vec4(rect.x, top, width, height));
+            drawProgram.SetVector4(_tileTextureRectUniform, glm::vec4(0.0f, textureTop, width / (static_cast<float>(_columns) * cellWidth), textureBottom));
+            drawProgram.SetUInt(_tileLayerUniform, layer);
+
+            // A single quad, drawn as a triangle strip
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        };
+
+        ++_frame;
+    };
+
+
+public:
+
+    /// <summary>
+    /// The line at a point of the last drawn minimap, e.g. to scroll the view there on a click. Past the drawn lines if the point is below them
+    /// </summary>
+    /// <param name="y"> In screen space </param>
+    std::size_t GetLineAt(const float y) const
+    {
+        const float line = std::floor((y - _drawnRect.y) / static_cast<float>(_cellSize.y));
+
+        return _drawnFirstLine + static_cast<std::size_t>(std::max(line, 0.0f));
+    };
+
+    /// <summary>
+    /// How many lines a minimap of a height shows
+    /// </summary>
+    std::size_t GetVisibleLineCount(const float height) const
+    {
+        return static_cast<std::size_t>(height / static_cast<float>(_cellSize.y));
+    };
+
+    /// <summary>
+    /// The width of a minimap that shows every column, in pixels
+    /// </summary>
+    float GetWidth() const
+    {
+        return static_cast<float>(_columns * _cellSize.x);
+    };
+
+    std::size_t GetCachedTileCount() const
+    {
+        return _tileLayers.size();
+    };
+
+    /// <summary>
+    /// How many times a tile was rendered, since construction
+    /// </summary>
+    std::uint64_t GetRenderedTileCount() const
+    {
+        return _renderedTileCount;
+    };
+
+
+private:
+
+    /// <summary>
+    /// The layer a tile is cached in, or the least recently drawn layer, which it then takes over stale
+    /// </summary>
+    std::uint32_t FindOrAllocateLayer(const std::size_t tileIndex)
+    {
+        if(const auto cachedLayer = _tileLayers.find(tileIndex); cachedLayer != _tileLayers.cend())
+            return cachedLayer->second;
+
+        const auto leastRecentlyUsed = std::min_element(_tiles.cbegin(), _tiles.cend(), [](const Tile& left, const Tile& right)
+        {
+            return left.LastUsedFrame < right.LastUsedFrame;
+        });
+
+        const std::uint32_t layer = static_cast<std::uint32_t>(leastRecentlyUsed - _tiles.cbegin());
+
+        Tile& tile = _tiles[layer];
+
+        if(tile.Index != InvalidTile)
+            _tileLayers.erase(tile.Index);
+
+        tile = Tile
+        {
+            .Index = tileIndex,
+        };
+
+        _tileLayers.emplace(tileIndex, layer);
+
+        return layer;
+    };
+
+    /// <summary>
+    /// Cut a tile's lines into cells and spans, and write its blocks into its layer
+    /// </summary>
+    void RenderTile(const IMinimapSource& source, Tile& tile, const std::uint32_t layer)
+    {
+        tile.Stale = false;
+        tile.Rendered = true;
+
+        ++_renderedTileCount;
+
+        std::fill(_cells.begin(), _cells.end(), '\0');
+
+        _spans.clear();
+
+        const std::size_t lineCount = source.GetLineCount();
+
+        const std::size_t firstLine = tile.Index * _tileLines;
+        const std::size_t endLine = std::min(firstLine + _tileLines, lineCount);
+
+        // Past the end of the document the tile stays empty
+        if(firstLine < endLine)
+        {
+            const std::string_view text = source.GetLines(firstLine, endLine);
+
+            _lineStarts.clear();
+
+            std::size_t lineStart = 0;
+
+            for(std::size_t line = 0; line < endLine - firstLine; ++line)
+            {
+                const std::size_t lineEnd = std::min(text.find('\n', lineStart), text.size());
+
+                std::string_view lineText = text.substr(lineStart, lineEnd - lineStart);
+
+                if(lineText.empty() == false && lineText.back() == '\r')
+                    lineText.remove_suffix(1);
+
+                std::memcpy(_cells.data() + (line * _columns), lineText.data(), std::min<std::size_t>(lineText.size(), _columns));
+
+                _lineStarts.emplace_back(lineStart);
+
+                lineStart = std::min(lineEnd + 1, text.size());
+            };
+
+            source.GetSpans(firstLine, endLine, _spans);
+
+            // Spans move from characters to cells. A span that starts past the drawn columns starts at the next line, where it's first seen
+            for(TextSpan& span : _spans)
+            {
+                const std::size_t line = static_cast<std::size_t>(std::upper_bound(_lineStarts.cbegin(), _lineStarts.cend(), static_cast<std::size_t>(span.FirstCharacter)) - _lineStarts.cbegin()) - 1;
+
+                const std::size_t column = std::min<std::size_t>(span.FirstCharacter - _lineStarts[line], _columns);
+
+                span.FirstCharacter = static_cast<std::uint32_t>((line * _columns) + column);
+            };
+        };
+
+
+        glNamedBufferSubData(_cellsBuffer.Get(), 0, static_cast<GLsizeiptr>(_cells.size()), _cells.data());
+
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, MinimapCharactersBindingIndex, _cellsBuffer.Get());
+
+        if(_spans.empty() == false)
+        {
+            if(_spans.size() > _spanCapacity)
+            {
+                _spanCapacity = std::max(_spans.size(), _spanCapacity * 2);
+
+                _spansBuffer = GLBuffer::Create();
+                glNamedBufferStorage(_spansBuffer.Get(), static_cast<GLsizeiptr>(_spanCapacity * sizeof(TextSpan)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+            };
+
+            glNamedBufferSubData(_spansBuffer.Get(), 0, static_cast<GLsizeiptr>(_spans.size() * sizeof(TextSpan)), _spans.data());
+
+            GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, MinimapSpansBindingIndex, _spansBuffer.Get());
+        };
+
+        _tileProgram.SetUInt(_columnsLocation, _columns);
+        _tileProgram.SetUInt(_tileLinesLocation, _tileLines);
+        _tileProgram.SetUInt(_cellSizeLocation, (_cellSize.y << 16) | _cellSize.x);
+        _tileProgram.SetUInt(_layerLocation, layer);
+        _tileProgram.SetUInt(_spanCountLocation, static_cast<std::uint32_t>(_spans.size()));
+        _tileProgram.SetUInt(_textColourLocation, PackSpanColour(_textColour));
+
+        glBindImageTexture(0, _tileTexture.Get(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+        const std::uint32_t cellCount = _columns * _tileLines;
+
+        _tileProgram.Dispatch((cellCount + WorkGroupSize - 1) / WorkGroupSize);
+    };
+
+
+private:
+
+    static constexpr std::size_t InvalidTile = std::numeric_limits<std::size_t>::max();
+
+    /// <summary>
+    /// The compute shader's local_size_x
+    /// </summary>
+    static constexpr std::uint32_t WorkGroupSize = 256;
+
+};
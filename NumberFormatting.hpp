@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+/// <summary>
+/// A number's text, formatted into storage of its own rather than a heap string, see FormatInteger and FormatFixed
+/// </summary>
+struct FormattedNumber
+{
+    /// <summary>
+    /// Room for any 64-bit integer, or a fixed-point number with MaxFixedDecimals decimals below 10^18, with its sign
+    /// </summary>
+    static constexpr std::size_t Capacity = 40;
+
+    /// <summary>
+    /// Digits are written backwards from the end, the text is Characters[Offset ..]
+    /// </summary>
+    std::array<char, Capacity> Characters;
+
+    std::size_t Offset = Capacity;
+
+
+    std::string_view View() const
+    {
+        return std::string_view(Characters.data() + Offset, Capacity - Offset);
+    };
+};
+
+/// <summary>
+/// The most decimals FormatFixed writes
+/// </summary>
+constexpr std::uint32_t MaxFixedDecimals = 9;
+
+
+namespace NumberFormattingKernels
+{
+
+    /// <summary>
+    /// "00" through "99", so digits are written two per division rather than one
+    /// </summary>
+    constexpr std::array<char, 200> DigitPairs = []()
+    {
+        std::array<char, 200> pairs = { };
+
+        for(std::size_t pair = 0; pair < 100; ++pair)
+        {
+            pairs[pair * 2] = static_cast<char>('0' + pair / 10);
+            pairs[pair * 2 + 1] = static_cast<char>('0' + pair % 10);
+        };
+
+        return pairs;
+    }();
+
+    constexpr std::array<std::uint64_t, MaxFixedDecimals + 1> PowersOfTen = { 1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull };
+
+
+    /// <summary>
+    /// Write an unsigned integer's digits so they end at "end", two at a time
+    /// </summary>
+    /// <returns> The first digit </returns>
+    inline char* WriteDigitsBackwards(char* end, std::uint64_t value)
+    {
+        while(value >= 100)
+        {
+            const std::size_t pair = static_cast<std::size_t>(value % 100) * 2;
+            value /= 100;
+
+            *--end = DigitPairs[pair + 1];
+            *--end = DigitPairs[pair];
+        };
+
+        if(value >= 10)
+        {
+            const std::size_t pair = static_cast<std::size_t>(value) * 2;
+
+            *--end = DigitPairs[pair + 1];
+            *--end = DigitPairs[pair];
+        }
+        else
+            *--end = static_cast<char>('0' + value);
+
+        return end;
+    };
+
+    /// <summary>
+    /// Write exactly "digitCount" digits of a value below 10^digitCount so they end at "end", with leading zeros
+    /// </summary>
+    /// <returns> The first digit </returns>
+    inline char* WriteFixedDigitsBackwards(char* end, std::uint64_t value, std::uint32_t digitCount)
+    {
+        for(; digitCount >= 2; digitCount -= 2)
+        {
+            const std::size_t pair = static_cast<std::size_t>(value % 100) * 2;
+            value /= 100;
+
+            *--end = DigitPairs[pair + 1];
+            *--end = DigitPairs[pair];
+        };
+
+        if(digitCount == 1)
+            *--end = static_cast<char>('0' + value % 10);
+
+        return end;
+    };
+
+};
+
+
+/// <summary>
+/// Format an integer, e.g. a counter, without allocating. Two digits are written per division from a table of digit pairs
+/// </summary>
+inline FormattedNumber FormatInteger(const std::int64_t value)
+{
+    FormattedNumber number;
+
+    char* const end = number.Characters.data() + FormattedNumber::Capacity;
+
+    // Negating in unsigned arithmetic keeps the most negative value in range
+    const std::uint64_t magnitude = value < 0 ? 0ull - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+
+    char* first = NumberFormattingKernels::WriteDigitsBackwards(end, magnitude);
+
+    if(value < 0)
+        *--first = '-';
+
+    number.Offset = static_cast<std::size_t>(first - number.Characters.data());
+
+    return number;
+};
+
+/// <summary>
+/// Format a number with a fixed number of decimals, e.g. a frame time in milliseconds, without allocating.
+/// Rounded to the nearest last decimal, then written as two integers through the digit pair table.
+/// Values too large for that, infinities and NaN fall back to std::to_chars
+/// </summary>
+/// <param name="decimals"> The number of digits after the point, at most MaxFixedDecimals. 0 writes no point </param>
+inline FormattedNumber FormatFixed(const double value, std::uint32_t decimals)
+{
+    decimals = decimals < MaxFixedDecimals ? decimals : MaxFixedDecimals;
+
+    FormattedNumber number;
+
+    const std::uint64_t scale = NumberFormattingKernels::PowersOfTen[decimals];
+    const double scaled = std::round(std::abs(value) * static_cast<double>(scale));
+
+    // Every integer below 2^63 converts exactly, and 10^18 leaves room for the rounding
+    if(std::isfinite(scaled) == false || scaled >= 1e18)
+    {
+        const std::to_chars_result result = std::to_chars(number.Characters.data(), number.Characters.data() + FormattedNumber::Capacity, value, std::chars_format::fixed, static_cast<int>(decimals));
+
+        // Too long even for the buffer, the rest is cut off rather than reallocated
+        const std::size_t size = result.ec == std::errc() ? static_cast<std::size_t>(result.ptr - number.Characters.data()) : 0;
+
+        // The text is moved to the end, where View expects it
+        for(std::size_t index = size; index > 0; --index)
+        {
+            number.Characters[FormattedNumber::Capacity - size + index - 1] = number.Characters[index - 1];
+        };
+
+        number.Offset = FormattedNumber::Capacity - size;
+
+        return number;
+    };
+
+    const std::uint64_t units = static_cast<std::uint64_t>(scaled);
+
+    char* first = number.Characters.data() + FormattedNumber::Capacity;
+
+    if(decimals > 0)
+    {
+        first = NumberFormattingKernels::WriteFixedDigitsBackwards(first, units % scale, decimals);
+
+        *--first = '.';
+    };
+
+    first = NumberFormattingKernels::WriteDigitsBackwards(first, units / scale);
+
+    // Values that round to zero aren't given a sign
+    if(value < 0.0 && units != 0)
+        *--first = '-';
+
+    number.Offset = static_cast<std::size_t>(first - number.Characters.data());
+
+    return number;
+};
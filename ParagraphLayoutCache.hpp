@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+
+#include "TextLayout.hpp"
+#include "TextMetrics.hpp"
+
+
+/// <summary>
+/// How many rows paragraphs wrap into, keyed by their content, the layout options and the font. A wrapped document only has to lay out
+/// each distinct paragraph once per width, and going back to a width seen before, e.g. toggling a split pane, lays out nothing at all.
+/// Paragraphs are keyed by a hash of their text rather than the text, so the cache doesn't hold a second copy of the document.
+/// Entries aren't evicted individually, once the cache is full it starts over
+/// </summary>
+class ParagraphLayoutCache
+{
+
+private:
+
+    struct ParagraphKey
+    {
+        std::uint64_t ContentHash = 0;
+
+        std::size_t Size = 0;
+
+        TextLayoutOptions Options;
+
+        TextMetricsFont Font;
+
+
+        bool operator == (const ParagraphKey&) const = default;
+    };
+
+    struct Entry
+    {
+        ParagraphKey Key;
+
+        std::uint32_t RowCount = 0;
+    };
+
+    std::unordered_map<std::uint64_t, Entry> _entries;
+
+    std::size_t _capacity = 0;
+
+    std::uint64_t _layoutCount = 0;
+
+
+public:
+
+    /// <param name="capacity"> The number of paragraph layouts that are kept at once </param>
+    ParagraphLayoutCache(const std::size_t capacity = 1 << 16) :
+        _capacity(std::max<std::size_t>(capacity, 1))
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// The number of rows a paragraph, a line without its '\n', wraps into. Laid out if it isn't cached
+    /// </summary>
+    /// <param name="kerning"> Called as kerning(first, second), see TextMetrics::Build </param>
+    template<typename TKerning>
+    std::uint32_t GetRowCount(const std::string_view& paragraph, const TextLayoutOptions& options, const TextMetricsFont& font, const TKerning& kerning)
+    {
+        if(options.WrapWidth <= 0.0f)
+            return 1;
+
+        // Monospaced rows are counted from the runs between tabs, faster than hashing the paragraph for a lookup
+        if(font.Proportional == false)
+            return static_cast<std::uint32_t>(TextMetrics::CountRows(paragraph, options, font, kerning));
+
+
+        const ParagraphKey key = ParagraphKey
+        {
+            .ContentHash = std::hash<std::string_view>()(paragraph),
+            .Size = paragraph.size(),
+            .Options = options,
+            .Font = font,
+        };
+
+        const std::uint64_t hash = HashKey(key);
+
+        if(const auto entry = _entries.find(hash); entry != _entries.end() && entry->second.Key == key)
+            return entry->second.RowCount;
+
+        if(_entries.size() >= _capacity)
+            _entries.clear();
+
+        const std::uint32_t rowCount = static_cast<std::uint32_t>(TextMetrics::CountRows(paragraph, options, font, kerning));
+
+        _entries.insert_or_assign(hash, Entry { .Key = key, .RowCount = rowCount });
+
+        ++_layoutCount;
+
+        return rowCount;
+    };
+
+    /// <summary>
+    /// Forget every paragraph, e.g. once a font's advances changed
+    /// </summary>
+    void Clear()
+    {
+        _entries.clear();
+    };
+
+
+    std::size_t GetSize() const
+    {
+        return _entries.size();
+    };
+
+    /// <summary>
+    /// How many paragraphs were laid out because they weren't cached, since construction
+    /// </summary>
+    std::uint64_t GetLayoutCount() const
+    {
+        return _layoutCount;
+    };
+
+
+private:
+
+    static std::uint64_t HashKey(const ParagraphKey& key)
+    {
+        std::uint64_t hash = key.ContentHash;
+
+        const auto combine = [&](const std::uint64_t value)
+        {
+            hash ^= value + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        };
+
+        combine(key.Size);
+        combine(std::hash<float>()(key.Options.WrapWidth));
+        combine(key.Options.TabSize);
+        combine(std::hash<const void*>()(key.Font.Advances));
+        combine(key.Font.GlyphWidth);
+        combine(key.Font.Proportional == true ? 1 : 0);
+
+        return hash;
+    };
+
+};
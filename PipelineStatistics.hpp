@@ -0,0 +1,409 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// What a batch of draws cost the GPU's fixed-function stages and shaders, see PipelineStatisticsProfiler
+/// </summary>
+struct PipelineStatisticsResult
+{
+    const char* Name = nullptr;
+
+    std::uint64_t VertexShaderInvocations = 0;
+
+    std::uint64_t PrimitivesSubmitted = 0;
+
+    /// <summary>
+    /// Every fragment that was shaded, discarded ones included. Whether helper invocations count is up to the driver
+    /// </summary>
+    std::uint64_t FragmentShaderInvocations = 0;
+
+    /// <summary>
+    /// The fragments that were written, what's left once discarded fragments are taken away
+    /// </summary>
+    std::uint64_t SamplesPassed = 0;
+
+
+    /// <summary>
+    /// The share of shaded fragments that were discarded, e.g. by a chroma key
+    /// </summary>
+    double GetDiscardedFraction() const
+    {
+        if(FragmentShaderInvocations == 0)
+            return 0.0;
+
+        return 1.0 - static_cast<double>(std::min(SamplesPassed, FragmentShaderInvocations)) / static_cast<double>(FragmentShaderInvocations);
+    };
+};
+
+
+/// <summary>
+/// Counts the vertex shader invocations, primitives, fragment shader invocations and written samples of batches of draws, for telling
+/// fill-bound text passes apart: a batch that shades many more fragments than it writes discards too much, one that writes many more than
+/// the screen has pixels overdraws. Pipeline statistics queries are core since GL 4.6 (GL_ARB_pipeline_statistics_query before).
+/// Like GPUProfiler, results are read back a few frames later, never waited on. Only one batch can be open at a time, a query target
+/// can't be nested
+/// </summary>
+class PipelineStatisticsProfiler
+{
+
+private:
+
+    /// <summary>
+    /// The query targets of a batch, in the order of their queries in Batch::Queries
+    /// </summary>
+    static constexpr std::array<GLenum, 4> QueryTargets =
+    {
+        GL_VERTEX_SHADER_INVOCATIONS,
+        GL_PRIMITIVES_SUBMITTED,
+        GL_FRAGMENT_SHADER_INVOCATIONS,
+        GL_SAMPLES_PASSED,
+    };
+
+    static constexpr std::size_t QueryTargetCount = QueryTargets.size();
+
+    /// <summary>
+    /// How many queries of a target are created whenever its pool runs out
+    /// </summary>
+    static constexpr std::size_t QueryAllocationCount = 16;
+
+
+    struct Batch
+    {
+        const char* Name = nullptr;
+
+        std::array<std::uint32_t, QueryTargetCount> Queries = { };
+    };
+
+    struct Frame
+    {
+        std::vector<Batch> Batches;
+
+        bool Pending = false;
+    };
+
+
+    std::vector<Frame> _frames;
+
+    std::size_t _frameIndex = 0;
+
+    bool _inFrame = false;
+
+    bool _inBatch = false;
+
+    /// <summary>
+    /// Unused queries, one pool per target since a query object is created for its target
+    /// </summary>
+    std::array<std::vector<std::uint32_t>, QueryTargetCount> _queryPools;
+
+    /// <summary>
+    /// Every query created, deleted on destruction
+    /// </summary>
+    std::vector<std::uint32_t> _queries;
+
+    std::vector<PipelineStatisticsResult> _results;
+
+    std::uint64_t _readBackCount = 0;
+
+
+public:
+
+    /// <summary>
+    /// Batches aren't recorded while disabled. The queries cost a little on every draw, so it starts disabled
+    /// </summary>
+    bool Enabled = false;
+
+
+public:
+
+    /// <param name="readbackLatency"> How many frames pass before a frame's results are read </param>
+    PipelineStatisticsProfiler(const std::size_t readbackLatency = 4) :
+        _frames(std::max<std::size_t>(readbackLatency, 1))
+    {
+    };
+
+    PipelineStatisticsProfiler(const PipelineStatisticsProfiler&) = delete;
+    PipelineStatisticsProfiler& operator = (const PipelineStatisticsProfiler&) = delete;
+
+    ~PipelineStatisticsProfiler()
+    {
+        glDeleteQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+    };
+
+
+public:
+
+    /// <summary>
+    /// Start recording a frame, reads back the results of the frame recorded in the same slot
+    /// </summary>
+    void BeginFrame()
+    {
+        if(Enabled == false)
+            return;
+
+        Frame& frame = _frames[_frameIndex];
+
+        if(frame.Pending == true)
+            ReadBack(frame);
+
+        frame.Batches.clear();
+
+        _inFrame = true;
+    };
+
+    void EndFrame()
+    {
+        if(_inFrame == false)
+            return;
+
+        wt::Assert(_inBatch == false, "Pipeline statistics frame ended with an open batch");
+
+        _frames[_frameIndex].Pending = true;
+        _frameIndex = (_frameIndex + 1) % _frames.size();
+
+        _inFrame = false;
+    };
+
+
+    /// <summary>
+    /// Start counting a batch of draws. Must be matched by EndBatch, see PipelineStatisticsScope
+    /// </summary>
+    /// <param name="name"> The batch's name, must outlive the profiler. Usually a literal </param>
+    /// <returns> False if nothing is being recorded, in which case EndBatch must not be called </returns>
+    bool BeginBatch(const char* name)
+    {
+        if(_inFrame == false)
+            return false;
+
+        WT_ASSERT(_inBatch == false, "Pipeline statistics batches can't be nested");
+
+        Batch& batch = _frames[_frameIndex].Batches.emplace_back(Batch { .Name = name });
+
+        for(std::size_t target = 0; target < QueryTargetCount; ++target)
+        {
+            batch.Queries[target] = AcquireQuery(target);
+
+            glBeginQuery(QueryTargets[target], batch.Queries[target]);
+        };
+
+        _inBatch = true;
+
+        return true;
+    };
+
+    void EndBatch()
+    {
+        WT_ASSERT(_inBatch == true, "EndBatch called without a matching BeginBatch");
+
+        for(const GLenum target : QueryTargets)
+        {
+            glEndQuery(target);
+        };
+
+        _inBatch = false;
+    };
+
+
+    /// <summary>
+    /// The batches of the most recently read back frame, in the order they began
+    /// </summary>
+    const std::vector<PipelineStatisticsResult>& GetResults() const
+    {
+        return _results;
+    };
+
+    /// <summary>
+    /// The sum of every batch of the most recently read back frame
+    /// </summary>
+    PipelineStatisticsResult GetTotal() const
+    {
+        PipelineStatisticsResult total = { .Name = "Total" };
+
+        for(const PipelineStatisticsResult& result : _results)
+        {
+            total.VertexShaderInvocations += result.VertexShaderInvocations;
+            total.PrimitivesSubmitted += result.PrimitivesSubmitted;
+            total.FragmentShaderInvocations += result.FragmentShaderInvocations;
+            total.SamplesPassed += result.SamplesPassed;
+        };
+
+        return total;
+    };
+
+    std::uint64_t GetReadBackCount() const
+    {
+        return _readBackCount;
+    };
+
+    /// <summary>
+    /// The results as a table, one batch per line and their total, for drawing on screen
+    /// </summary>
+    /// <param name="memory"> Where the text is allocated, e.g. a FrameArena </param>
+    /// <param name="screenPixelCount"> The framebuffer's pixels, if set the total's fragments per pixel, its overdraw, is shown too </param>
+    std::pmr::string FormatResults(std::pmr::memory_resource* memory = std::pmr::get_default_resource(), const std::uint64_t screenPixelCount = 0) const
+    {
+        std::pmr::string text = std::pmr::string("Batch             VS invoc    Prims  FS invoc   Passed  Discard\n", memory);
+
+        const auto appendResult = [&text](const PipelineStatisticsResult& result)
+        {
+            char line[112] = { };
+
+            std::snprintf(line, sizeof(line), "%-16s %9llu %8llu %9llu %8llu %7.1f%%\n",
+                          result.Name,
+                          static_cast<unsigned long long>(result.VertexShaderInvocations),
+                          static_cast<unsigned long long>(result.PrimitivesSubmitted),
+                          static_cast<unsigned long long>(result.FragmentShaderInvocations),
+                          static_cast<unsigned long long>(result.SamplesPassed),
+                          result.GetDiscardedFraction() * 100.0);
+
+            text.append(line);
+        };
+
+        for(const PipelineStatisticsResult& result : _results)
+        {
+            appendResult(result);
+        };
+
+        const PipelineStatisticsResult total = GetTotal();
+
+        appendResult(total);
+
+        if(screenPixelCount > 0)
+        {
+            char line[112] = { };
+
+            std::snprintf(line, sizeof(line), "Fragments per pixel %.2f shaded, %.2f written\n",
+                          static_cast<double>(total.FragmentShaderInvocations) / static_cast<double>(screenPixelCount),
+                          static_cast<double>(total.SamplesPassed) / static_cast<double>(screenPixelCount));
+
+            text.append(line);
+        };
+
+        return text;
+    };
+
+
+private:
+
+    std::uint32_t AcquireQuery(const std::size_t target)
+    {
+        std::vector<std::uint32_t>& pool = _queryPools[target];
+
+        if(pool.empty() == true)
+        {
+            const std::size_t firstNewQuery = _queries.size();
+
+            _queries.resize(firstNewQuery + QueryAllocationCount);
+            glCreateQueries(QueryTargets[target], static_cast<GLsizei>(QueryAllocationCount), _queries.data() + firstNewQuery);
+
+            pool.insert(pool.end(), _queries.cbegin() + firstNewQuery, _queries.cend());
+        };
+
+        const std::uint32_t query = pool.back();
+        pool.pop_back();
+
+        return query;
+    };
+
+    /// <summary>
+    /// Read a frame's results and return its queries to their pools. A frame the GPU isn't done with yet is dropped
+    /// </summary>
+    void ReadBack(Frame& frame)
+    {
+        frame.Pending = false;
+
+        bool available = true;
+
+        for(const Batch& batch : frame.Batches)
+        {
+            // Queries of a batch end together, the last one is done last
+            std::int32_t lastAvailable = 0;
+            glGetQueryObjectiv(batch.Queries.back(), GL_QUERY_RESULT_AVAILABLE, &lastAvailable);
+
+            if(lastAvailable == 0)
+            {
+                available = false;
+                break;
+            };
+        };
+
+
+        if(available == true)
+        {
+            _results.clear();
+
+            ++_readBackCount;
+
+            for(const Batch& batch : frame.Batches)
+            {
+                std::array<std::uint64_t, QueryTargetCount> counts = { };
+
+                for(std::size_t target = 0; target < QueryTargetCount; ++target)
+                {
+                    glGetQueryObjectui64v(batch.Queries[target], GL_QUERY_RESULT, &counts[target]);
+                };
+
+                _results.emplace_back(PipelineStatisticsResult
+                {
+                    .Name = batch.Name,
+                    .VertexShaderInvocations = counts[0],
+                    .PrimitivesSubmitted = counts[1],
+                    .FragmentShaderInvocations = counts[2],
+                    .SamplesPassed = counts[3],
+                });
+            };
+        };
+
+
+        for(const Batch& batch : frame.Batches)
+        {
+            for(std::size_t target = 0; target < QueryTargetCount; ++target)
+            {
+                _queryPools[target].emplace_back(batch.Queries[target]);
+            };
+        };
+    };
+
+};
+
+
+/// <summary>
+/// Counts the draws made during the lifetime of a scope as a batch. Does nothing if the profiler is null or not recording
+/// </summary>
+class PipelineStatisticsScope
+{
+
+private:
+
+    PipelineStatisticsProfiler* _profiler = nullptr;
+
+
+public:
+
+    PipelineStatisticsScope(PipelineStatisticsProfiler* profiler, const char* name)
+    {
+        if(profiler != nullptr && profiler->BeginBatch(name) == true)
+            _profiler = profiler;
+    };
+
+    PipelineStatisticsScope(const PipelineStatisticsScope&) = delete;
+    PipelineStatisticsScope& operator = (const PipelineStatisticsScope&) = delete;
+
+    ~PipelineStatisticsScope()
+    {
+        if(_profiler != nullptr)
+            _profiler->EndBatch();
+    };
+
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "FontSprite.hpp"
+#include "ShaderProgram.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// Draws what the first frames will draw, once, into a small framebuffer nobody sees, before the first visible frame.
+/// Drivers finish a program's state for the pipeline it's drawn with, place buffers and make textures resident on first use,
+/// which otherwise makes the first frame, and the first one after a toggle like the overdraw heatmap, hitch.
+/// Binds its framebuffer while alive, and waits for the GPU to finish every draw when destroyed
+/// </summary>
+class PipelineWarmUp
+{
+
+private:
+
+    /// <summary>
+    /// Big enough for a few glyphs to land on it, the draws are what counts, not their pixels
+    /// </summary>
+    static constexpr std::int32_t FramebufferSize = 64;
+
+
+    std::uint32_t _framebuffer = 0;
+
+    std::uint32_t _colourRenderbuffer = 0;
+
+    std::array<std::int32_t, 4> _viewport = { };
+
+
+public:
+
+    PipelineWarmUp()
+    {
+        glCreateRenderbuffers(1, &_colourRenderbuffer);
+        glNamedRenderbufferStorage(_colourRenderbuffer, GL_RGBA8, FramebufferSize, FramebufferSize);
+
+        glCreateFramebuffers(1, &_framebuffer);
+        glNamedFramebufferRenderbuffer(_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colourRenderbuffer);
+
+        wt::Assert(glCheckNamedFramebufferStatus(_framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Warm-up framebuffer is incomplete");
+
+        glGetIntegerv(GL_VIEWPORT, _viewport.data());
+
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        glViewport(0, 0, FramebufferSize, FramebufferSize);
+
+        glClear(GL_COLOR_BUFFER_BIT);
+    };
+
+    PipelineWarmUp(const PipelineWarmUp&) = delete;
+    PipelineWarmUp& operator = (const PipelineWarmUp&) = delete;
+
+    ~PipelineWarmUp()
+    {
+        // Everything deferred to the first draw happens by the time the GPU is done with it
+        glFinish();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
+
+        glDeleteFramebuffers(1, &_framebuffer);
+        glDeleteRenderbuffers(1, &_colourRenderbuffer);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Draw every printable ASCII character with a variant of a font's shaders, so the atlas is sampled all over.
+    /// The font draws with its own program again afterwards
+    /// </summary>
+    /// <param name="fontSprite"> The font to draw, must be ready </param>
+    /// <param name="shaderProgram"> One of the variants the font will be drawn with </param>
+    void DrawText(FontSprite& fontSprite, const ShaderProgram& shaderProgram) const
+    {
+        const ShaderProgram& fontProgram = fontSprite.GetShaderProgram();
+
+        fontSprite.SetShaderProgram(shaderProgram);
+
+        fontSprite.Bind();
+        fontSprite.Draw(GetWarmUpText());
+
+        fontSprite.SetShaderProgram(fontProgram);
+    };
+
+
+private:
+
+    static const std::string& GetWarmUpText()
+    {
+        static const std::string text = []()
+        {
+            std::string characters;
+
+            for(char character = ' '; character <= '~'; ++character)
+            {
+                characters.push_back(character);
+            };
+
+            return characters;
+        }();
+
+        return text;
+    };
+
+};
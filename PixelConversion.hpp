@@ -0,0 +1,780 @@
+#pragma once
+
+#include <intrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The conversions ConvertPixels applies to 8-bit, 4 channel pixels. Can be combined
+/// </summary>
+enum class PixelConversion : std::uint32_t
+{
+    None = 0,
+
+    /// <summary>
+    /// Swap the first and third channels, BGRA to RGBA and back
+    /// </summary>
+    SwapRedBlue = 1 << 0,
+
+    /// <summary>
+    /// Write the rows in reverse order
+    /// </summary>
+    FlipVertical = 1 << 1,
+
+    /// <summary>
+    /// Multiply the colour channels by alpha
+    /// </summary>
+    PremultiplyAlpha = 1 << 2,
+};
+
+constexpr PixelConversion operator | (const PixelConversion left, const PixelConversion right)
+{
+    return static_cast<PixelConversion>(static_cast<std::uint32_t>(left) | static_cast<std::uint32_t>(right));
+};
+
+constexpr bool HasConversion(const PixelConversion conversion, const PixelConversion flag)
+{
+    return (static_cast<std::uint32_t>(conversion) & static_cast<std::uint32_t>(flag)) != 0;
+};
+
+
+/// <summary>
+/// The widest instruction set the pixel conversion kernels can use on this CPU
+/// </summary>
+enum class PixelConversionPath
+{
+    Scalar,
+    SSSE3,
+    AVX2,
+};
+
+
+/// <summary>
+/// Detect the widest supported kernel, once
+/// </summary>
+/// <returns></returns>
+inline PixelConversionPath GetPixelConversionPath()
+{
+    static const PixelConversionPath path = []()
+    {
+        int cpuInfo[4] {};
+
+        __cpuid(cpuInfo, 0);
+        const int highestLeaf = cpuInfo[0];
+
+        __cpuid(cpuInfo, 1);
+        const bool ssse3 = (cpuInfo[2] & (1 << 9)) != 0;
+        const bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+
+        // AVX2 also requires the OS to save the YMM registers
+        bool avx2 = false;
+
+        if(highestLeaf >= 7 && osxsave == true && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(cpuInfo, 7, 0);
+            avx2 = (cpuInfo[1] & (1 << 5)) != 0;
+        };
+
+        if(avx2 == true)
+            return PixelConversionPath::AVX2;
+
+        if(ssse3 == true)
+            return PixelConversionPath::SSSE3;
+
+        return PixelConversionPath::Scalar;
+    }();
+
+    return path;
+};
+
+
+namespace PixelConversionKernels
+{
+
+    /// <summary>
+    /// x / 255, rounded, for x up to 255 * 255. Every kernel uses the same approximation so they all give identical results
+    /// </summary>
+    constexpr std::uint32_t DivideBy255(const std::uint32_t value)
+    {
+        const std::uint32_t rounded = value + 128;
+
+        return (rounded + (rounded >> 8)) >> 8;
+    };
+
+
+    inline void ConvertRowScalar(const std::uint8_t* source, std::uint8_t* destination, const std::size_t pixelCount, const bool swapRedBlue, const bool premultiplyAlpha)
+    {
+        for(std::size_t index = 0; index < pixelCount; ++index)
+        {
+            const std::uint8_t* sourcePixel = source + index * 4;
+            std::uint8_t* destinationPixel = destination + index * 4;
+
+            std::uint32_t first = sourcePixel[0];
+            std::uint32_t second = sourcePixel[1];
+            std::uint32_t third = sourcePixel[2];
+            const std::uint32_t alpha = sourcePixel[3];
+
+            if(swapRedBlue == true)
+                std::swap(first, third);
+
+            if(premultiplyAlpha == true)
+            {
+                first = DivideBy255(first * alpha);
+                second = DivideBy255(second * alpha);
+                third = DivideBy255(third * alpha);
+            };
+
+            destinationPixel[0] = static_cast<std::uint8_t>(first);
+            destinationPixel[1] = static_cast<std::uint8_t>(second);
+            destinationPixel[2] = static_cast<std::uint8_t>(third);
+            destinationPixel[3] = static_cast<std::uint8_t>(alpha);
+        };
+    };
+
+
+    /// <summary>
+    /// Premultiply 8 pixels' worth of 16-bit channels (Two 128-bit halves of unpacked pixels)
+    /// </summary>
+    inline __m128i PremultiplyUnpacked(const __m128i channels)
+    {
+        // Broadcast each pixel's alpha over its 4 channels
+        const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(channels, 0xFF), 0xFF);
+
+        const __m128i rounded = _mm_add_epi16(_mm_mullo_epi16(channels, alpha), _mm_set1_epi16(128));
+
+        return _mm_srli_epi16(_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)), 8);
+    };
+
+    inline __m256i PremultiplyUnpacked(const __m256i channels)
+    {
+        const __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(channels, 0xFF), 0xFF);
+
+        const __m256i rounded = _mm256_add_epi16(_mm256_mullo_epi16(channels, alpha), _mm256_set1_epi16(128));
+
+        return _mm256_srli_epi16(_mm256_add_epi16(rounded, _mm256_srli_epi16(rounded, 8)), 8);
+    };
+
+
+    /// <summary>
+    /// Returns the number of pixels converted, the remainder is left to the scalar kernel
+    /// </summary>
+    inline std::size_t ConvertRowSSSE3(const std::uint8_t* source, std::uint8_t* destination, const std::size_t pixelCount, const bool swapRedBlue, const bool premultiplyAlpha)
+    {
+        const __m128i swapMask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        const __m128i zero = _mm_setzero_si128();
+
+        std::size_t index = 0;
+
+        for(; index + 4 <= pixelCount; index += 4)
+        {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + index * 4));
+
+            if(swapRedBlue == true)
+                pixels = _mm_shuffle_epi8(pixels, swapMask);
+
+            if(premultiplyAlpha == true)
+            {
+                const __m128i low = PremultiplyUnpacked(_mm_unpacklo_epi8(pixels, zero));
+                const __m128i high = PremultiplyUnpacked(_mm_unpackhi_epi8(pixels, zero));
+
+                // Alpha itself is kept as-is
+                pixels = _mm_or_si128(_mm_andnot_si128(alphaMask, _mm_packus_epi16(low, high)), _mm_and_si128(alphaMask, pixels));
+            };
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + index * 4), pixels);
+        };
+
+        return index;
+    };
+
+
+    /// <summary>
+    /// Returns the number of pixels converted, the remainder is left to the narrower kernels
+    /// </summary>
+    inline std::size_t ConvertRowAVX2(const std::uint8_t* source, std::uint8_t* destination, const std::size_t pixelCount, const bool swapRedBlue, const bool premultiplyAlpha)
+    {
+        // pshufb and the unpack/pack pairs work per 128-bit lane, so the lanes stay in order
+        const __m256i swapMask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                                  2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+        const __m256i zero = _mm256_setzero_si256();
+
+        std::size_t index = 0;
+
+        for(; index + 8 <= pixelCount; index += 8)
+        {
+            __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + index * 4));
+
+            if(swapRedBlue == true)
+                pixels = _mm256_shuffle_epi8(pixels, swapMask);
+
+            if(premultiplyAlpha == true)
+            {
+                const __m256i low = PremultiplyUnpacked(_mm256_unpacklo_epi8(pixels, zero));
+                const __m256i high = PremultiplyUnpacked(_mm256_unpackhi_epi8(pixels, zero));
+
+                pixels = _mm256_or_si256(_mm256_andnot_si256(alphaMask, _mm256_packus_epi16(low, high)), _mm256_and_si256(alphaMask, pixels));
+            };
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + index * 4), pixels);
+        };
+
+        return index;
+    };
+
+
+    inline void ConvertRow(const std::uint8_t* source, std::uint8_t* destination, const std::size_t pixelCount, const bool swapRedBlue, const bool premultiplyAlpha, const PixelConversionPath path)
+    {
+        std::size_t converted = 0;
+
+        if(path == PixelConversionPath::AVX2)
+            converted = ConvertRowAVX2(source, destination, pixelCount, swapRedBlue, premultiplyAlpha);
+
+        if(path != PixelConversionPath::Scalar)
+            converted += ConvertRowSSSE3(source + converted * 4, destination + converted * 4, pixelCount - converted, swapRedBlue, premultiplyAlpha);
+
+        ConvertRowScalar(source + converted * 4, destination + converted * 4, pixelCount - converted, swapRedBlue, premultiplyAlpha);
+    };
+
+};
+
+
+/// <summary>
+/// Swizzle, flip and/or premultiply 8-bit RGBA/BGRA pixels in a single pass.
+/// Converting in place is allowed if the rows aren't flipped
+/// </summary>
+/// <param name="source"> The first source row </param>
+/// <param name="sourceStride"> The distance between source rows, in bytes </param>
+/// <param name="destination"> The first destination row </param>
+/// <param name="destinationStride"> The distance between destination rows, in bytes </param>
+/// <param name="width"> The width of a row, in pixels </param>
+/// <param name="height"> The number of rows </param>
+/// <param name="conversion"></param>
+/// <param name="path"> Override the detected instruction set, mostly useful for comparing kernels </param>
+inline void ConvertPixels(const std::byte* source,
+                          const std::size_t sourceStride,
+                          std::byte* destination,
+                          const std::size_t destinationStride,
+                          const std::uint32_t width,
+                          const std::uint32_t height,
+                          const PixelConversion conversion,
+                          const PixelConversionPath path = GetPixelConversionPath())
+{
+    const bool swapRedBlue = HasConversion(conversion, PixelConversion::SwapRedBlue);
+    const bool flipVertical = HasConversion(conversion, PixelConversion::FlipVertical);
+    const bool premultiplyAlpha = HasConversion(conversion, PixelConversion::PremultiplyAlpha);
+
+    wt::Assert(flipVertical == false || source != destination, "Pixels can't be flipped in place");
+
+
+    for(std::size_t y = 0; y < height; ++y)
+    {
+        const std::size_t sourceRow = flipVertical == true ? (height - 1) - y : y;
+
+        const std::uint8_t* sourcePixels = reinterpret_cast<const std::uint8_t*>(source + sourceRow * sourceStride);
+        std::uint8_t* destinationPixels = reinterpret_cast<std::uint8_t*>(destination + y * destinationStride);
+
+        if(swapRedBlue == false && premultiplyAlpha == false)
+        {
+            if(sourcePixels != destinationPixels)
+                std::memcpy(destinationPixels, sourcePixels, static_cast<std::size_t>(width) * 4);
+
+            continue;
+        };
+
+        PixelConversionKernels::ConvertRow(sourcePixels, destinationPixels, width, swapRedBlue, premultiplyAlpha, path);
+    };
+};
+
+
+/// <summary>
+/// Convert chroma-keyed 8-bit, 4 channel pixels into a single channel coverage mask.
+/// Pixels matching the key become 0, everything else 255
+/// </summary>
+/// <param name="source"> The first source row </param>
+/// <param name="sourceStride"> The distance between source rows, in bytes </param>
+/// <param name="destination"> The first destination row, one byte per pixel </param>
+/// <param name="destinationStride"> The distance between destination rows, in bytes </param>
+/// <param name="width"> The width of a row, in pixels </param>
+/// <param name="height"> The number of rows </param>
+/// <param name="chromaKey"> The key's first three channels, in the source's channel order </param>
+inline void ExtractChromaKeyCoverage(const std::byte* source,
+                                     const std::size_t sourceStride,
+                                     std::byte* destination,
+                                     const std::size_t destinationStride,
+                                     const std::uint32_t width,
+                                     const std::uint32_t height,
+                                     const std::array<std::uint8_t, 3>& chromaKey)
+{
+    for(std::size_t y = 0; y < height; ++y)
+    {
+        const std::uint8_t* sourcePixels = reinterpret_cast<const std::uint8_t*>(source + y * sourceStride);
+        std::uint8_t* destinationPixels = reinterpret_cast<std::uint8_t*>(destination + y * destinationStride);
+
+        for(std::size_t x = 0; x < width; ++x)
+        {
+            const std::uint8_t* sourcePixel = sourcePixels + x * 4;
+
+            const bool keyed = sourcePixel[0] == chromaKey[0] &&
+                               sourcePixel[1] == chromaKey[1] &&
+                               sourcePixel[2] == chromaKey[2];
+
+            destinationPixels[x] = keyed == true ? 0 : 255;
+        };
+    };
+};
+
+
+namespace DistanceFieldKernels
+{
+    /// <summary>
+    /// Stands in for infinity, which would turn the transform's differences into NaNs
+    /// </summary>
+    constexpr float FarDistance = 1e20f;
+
+
+    /// <summary>
+    /// The exact 1D squared euclidean distance transform of Felzenszwalb and Huttenlocher, the lower envelope of a parabola per sample
+    /// </summary>
+    /// <param name="values"> The samples, read and written count times stride apart </param>
+    /// <param name="sampled"> Scratch, count floats </param>
+    /// <param name="parabolas"> Scratch, count indices </param>
+    /// <param name="boundaries"> Scratch, count + 1 floats </param>
+    inline void SquaredDistance1D(float* values, const std::size_t stride, const std::size_t count, float* sampled, std::size_t* parabolas, float* boundaries)
+    {
+        for(std::size_t index = 0; index < count; ++index)
+        {
+            sampled[index] = values[index * stride];
+        };
+
+
+        std::size_t parabolaCount = 0;
+
+        parabolas[0] = 0;
+        boundaries[0] = -FarDistance;
+        boundaries[1] = FarDistance;
+
+        for(std::size_t q = 1; q < count; ++q)
+        {
+            const float position = static_cast<float>(q);
+
+            // Drop the parabolas the new one is below of, the first boundary is low enough that the first parabola never is
+            float intersection = 0.0f;
+
+            while(true)
+            {
+                const float vertex = static_cast<float>(parabolas[parabolaCount]);
+
+                intersection = ((sampled[q] + position * position) - (sampled[parabolas[parabolaCount]] + vertex * vertex)) / (2.0f * (position - vertex));
+
+                if(intersection > boundaries[parabolaCount])
+                    break;
+
+                --parabolaCount;
+            };
+
+            ++parabolaCount;
+
+            parabolas[parabolaCount] = q;
+            boundaries[parabolaCount] = intersection;
+            boundaries[parabolaCount + 1] = FarDistance;
+        };
+
+
+        std::size_t parabola = 0;
+
+        for(std::size_t q = 0; q < count; ++q)
+        {
+            const float position = static_cast<float>(q);
+
+            while(boundaries[parabola + 1] < position)
+                ++parabola;
+
+            const float offset = position - static_cast<float>(parabolas[parabola]);
+
+            values[q * stride] = offset * offset + sampled[parabolas[parabola]];
+        };
+    };
+
+    /// <summary>
+    /// Transform a grid in place, from 0 at the features and FarDistance elsewhere to the squared distance to the nearest feature
+    /// </summary>
+    inline void SquaredDistance2D(std::vector<float>& grid, const std::uint32_t width, const std::uint32_t height)
+    {
+        const std::size_t longestSide = std::max(width, height);
+
+        std::vector<float> sampled = std::vector<float>(longestSide);
+        std::vector<std::size_t> parabolas = std::vector<std::size_t>(longestSide);
+        std::vector<float> boundaries = std::vector<float>(longestSide + 1);
+
+        for(std::size_t x = 0; x < width; ++x)
+        {
+            SquaredDistance1D(grid.data() + x, width, height, sampled.data(), parabolas.data(), boundaries.data());
+        };
+
+        for(std::size_t y = 0; y < height; ++y)
+        {
+            SquaredDistance1D(grid.data() + (y * width), 1, width, sampled.data(), parabolas.data(), boundaries.data());
+        };
+    };
+};
+
+
+/// <summary>
+/// Convert a coverage mask into a signed distance field, one byte per pixel.
+/// 128 is the edge, values above it are inside, and 0 and 255 are spread pixels or further out and in.
+/// Coverage of at least half counts as inside
+/// </summary>
+/// <param name="source"> The first coverage row </param>
+/// <param name="sourceStride"> The distance between source rows, in bytes </param>
+/// <param name="destination"> The first destination row, may not overlap the source </param>
+/// <param name="destinationStride"> The distance between destination rows, in bytes </param>
+/// <param name="width"> The width of a row, in pixels </param>
+/// <param name="height"> The number of rows </param>
+/// <param name="spread"> The largest distance the field represents, in pixels </param>
+inline void GenerateSignedDistanceField(const std::byte* source,
+                                        const std::size_t sourceStride,
+                                        std::byte* destination,
+                                        const std::size_t destinationStride,
+                                        const std::uint32_t width,
+                                        const std::uint32_t height,
+                                        const float spread)
+{
+    const std::size_t pixelCount = static_cast<std::size_t>(width) * height;
+
+    // The distance from every outside pixel to the ink, and from every inside pixel to the background
+    std::vector<float> outsideDistance = std::vector<float>(pixelCount);
+    std::vector<float> insideDistance = std::vector<float>(pixelCount);
+
+    for(std::size_t y = 0; y < height; ++y)
+    {
+        const std::uint8_t* sourcePixels = reinterpret_cast<const std::uint8_t*>(source + y * sourceStride);
+
+        for(std::size_t x = 0; x < width; ++x)
+        {
+            const bool inside = sourcePixels[x] >= 128;
+
+            outsideDistance[y * width + x] = inside == true ? 0.0f : DistanceFieldKernels::FarDistance;
+            insideDistance[y * width + x] = inside == true ? DistanceFieldKernels::FarDistance : 0.0f;
+        };
+    };
+
+    DistanceFieldKernels::SquaredDistance2D(outsideDistance, width, height);
+    DistanceFieldKernels::SquaredDistance2D(insideDistance, width, height);
+
+
+    for(std::size_t y = 0; y < height; ++y)
+    {
+        std::uint8_t* destinationPixels = reinterpret_cast<std::uint8_t*>(destination + y * destinationStride);
+
+        for(std::size_t x = 0; x < width; ++x)
+        {
+            const std::size_t index = y * width + x;
+
+            // The edge runs between pixel centres, half a pixel from either side
+            const float distance = insideDistance[index] > 0.0f ?
+                0.5f - std::sqrt(insideDistance[index]) :
+                std::sqrt(outsideDistance[index]) - 0.5f;
+
+            const float value = std::clamp(0.5f - (distance / (2.0f * spread)), 0.0f, 1.0f);
+
+            destinationPixels[x] = static_cast<std::uint8_t>(value * 255.0f + 0.5f);
+        };
+    };
+};
+
+
+/// <summary>
+/// Convert a coverage mask into per-subpixel coverage for horizontal RGB stripe LCDs, 4 bytes per pixel.
+/// Red, green and blue are the coverage of the pixel's left, middle and right thirds, alpha is the largest of the three.
+/// The mask is resampled at the subpixels' centres, then low-pass filtered across neighbouring subpixels so edges don't fringe with colour.
+/// Nothing is read past the edges, so converting a glyph cell at a time keeps neighbouring glyphs out of each other
+/// </summary>
+/// <param name="source"> The first coverage row </param>
+/// <param name="sourceStride"> The distance between source rows, in bytes </param>
+/// <param name="destination"> The first destination row </param>
+/// <param name="destinationStride"> The distance between destination rows, in bytes </param>
+/// <param name="width"> The width of a row, in pixels </param>
+/// <param name="height"> The number of rows </param>
+inline void GenerateSubpixelCoverage(const std::byte* source,
+                                     const std::size_t sourceStride,
+                                     std::byte* destination,
+                                     const std::size_t destinationStride,
+                                     const std::uint32_t width,
+                                     const std::uint32_t height)
+{
+    // A 5-tap filter over subpixels, in 256ths. Each pixel's energy is spread a little into its neighbours, like FreeType's default LCD filter
+    constexpr std::array<std::uint32_t, 5> filterWeights = { 8, 77, 86, 77, 8 };
+
+    const std::size_t subpixelCount = static_cast<std::size_t>(width) * 3;
+
+    std::vector<std::uint32_t> subpixels = std::vector<std::uint32_t>(subpixelCount);
+
+    for(std::size_t y = 0; y < height; ++y)
+    {
+        const std::uint8_t* sourcePixels = reinterpret_cast<const std::uint8_t*>(source + y * sourceStride);
+        std::uint8_t* destinationPixels = reinterpret_cast<std::uint8_t*>(destination + y * destinationStride);
+
+        const auto coverageAt = [&](const std::ptrdiff_t x) -> std::uint32_t
+        {
+            return x >= 0 && x < static_cast<std::ptrdiff_t>(width) ? sourcePixels[x] : 0;
+        };
+
+        // The outer subpixels are a third of the way towards the neighbouring pixel
+        for(std::ptrdiff_t x = 0; x < static_cast<std::ptrdiff_t>(width); ++x)
+        {
+            const std::uint32_t centre = coverageAt(x);
+
+            subpixels[x * 3 + 0] = (centre * 2 + coverageAt(x - 1) + 1) / 3;
+            subpixels[x * 3 + 1] = centre;
+            subpixels[x * 3 + 2] = (centre * 2 + coverageAt(x + 1) + 1) / 3;
+        };
+
+
+        for(std::size_t subpixel = 0; subpixel < subpixelCount; ++subpixel)
+        {
+            std::uint32_t filtered = 0;
+
+            for(std::size_t tap = 0; tap < filterWeights.size(); ++tap)
+            {
+                const std::ptrdiff_t sample = static_cast<std::ptrdiff_t>(subpixel + tap) - 2;
+
+                if(sample >= 0 && sample < static_cast<std::ptrdiff_t>(subpixelCount))
+                    filtered += subpixels[static_cast<std::size_t>(sample)] * filterWeights[tap];
+            };
+
+            destinationPixels[(subpixel / 3) * 4 + (subpixel % 3)] = static_cast<std::uint8_t>(std::min<std::uint32_t>((filtered + 128) / 256, 255));
+        };
+
+        for(std::size_t x = 0; x < width; ++x)
+        {
+            std::uint8_t* pixel = destinationPixels + x * 4;
+
+            pixel[3] = std::max({ pixel[0], pixel[1], pixel[2] });
+        };
+    };
+};
+
+
+namespace BC4Kernels
+{
+    /// <summary>
+    /// The size of a 4x4 block, in bytes
+    /// </summary>
+    constexpr std::size_t BlockSizeInBytes = 8;
+
+    /// <summary>
+    /// The 8 values a block's endpoints select from.
+    /// With the first endpoint above the second 6 values are interpolated between them, otherwise 4 are and the last two are 0 and 255
+    /// </summary>
+    inline std::array<std::uint8_t, 8> BuildPalette(const std::uint8_t first, const std::uint8_t second)
+    {
+        std::array<std::uint8_t, 8> palette = { first, second };
+
+        if(first > second)
+        {
+            for(std::uint32_t index = 1; index < 7; ++index)
+            {
+                palette[index + 1] = static_cast<std::uint8_t>((((7 - index) * first) + (index * second) + 3) / 7);
+            };
+        }
+        else
+        {
+            for(std::uint32_t index = 1; index < 5; ++index)
+            {
+                palette[index + 1] = static_cast<std::uint8_t>((((5 - index) * first) + (index * second) + 2) / 5);
+            };
+
+            palette[6] = 0;
+            palette[7] = 255;
+        };
+
+        return palette;
+    };
+
+    /// <summary>
+    /// Encode a block with fixed endpoints, every pixel picks the closest palette value
+    /// </summary>
+    /// <returns> The block's squared error </returns>
+    inline std::uint32_t EncodeBlock(const std::array<std::uint8_t, 16>& pixels, const std::uint8_t first, const std::uint8_t second, std::uint64_t& block)
+    {
+        const std::array<std::uint8_t, 8> palette = BuildPalette(first, second);
+
+        std::uint32_t error = 0;
+
+        block = static_cast<std::uint64_t>(first) | (static_cast<std::uint64_t>(second) << 8);
+
+        for(std::size_t pixel = 0; pixel < pixels.size(); ++pixel)
+        {
+            std::uint32_t bestIndex = 0;
+            std::uint32_t bestError = 0xFFFFFFFF;
+
+            for(std::uint32_t index = 0; index < palette.size(); ++index)
+            {
+                const std::int32_t difference = static_cast<std::int32_t>(pixels[pixel]) - palette[index];
+                const std::uint32_t indexError = static_cast<std::uint32_t>(difference * difference);
+
+                if(indexError < bestError)
+                {
+                    bestIndex = index;
+                    bestError = indexError;
+                };
+            };
+
+            error += bestError;
+
+            block |= static_cast<std::uint64_t>(bestIndex) << (16 + (pixel * 3));
+        };
+
+        return error;
+    };
+
+    /// <summary>
+    /// Encode a block in whichever of the two modes fits it better.
+    /// Coverage and distance fields are mostly fully in or fully out, which the 6 value mode represents exactly
+    /// </summary>
+    inline std::uint64_t CompressBlock(const std::array<std::uint8_t, 16>& pixels)
+    {
+        const auto [minimum, maximum] = std::minmax_element(pixels.cbegin(), pixels.cend());
+
+        // The 6 value mode, interpolating between the values that aren't already exact
+        std::uint8_t innerMinimum = 255;
+        std::uint8_t innerMaximum = 0;
+
+        for(const std::uint8_t pixel : pixels)
+        {
+            if(pixel == 0 || pixel == 255)
+                continue;
+
+            innerMinimum = std::min(innerMinimum, pixel);
+            innerMaximum = std::max(innerMaximum, pixel);
+        };
+
+        if(innerMinimum > innerMaximum)
+        {
+            innerMinimum = *minimum;
+            innerMaximum = *minimum;
+        };
+
+        std::uint64_t block = 0;
+
+        const std::uint32_t error = EncodeBlock(pixels, innerMinimum, innerMaximum, block);
+
+        if(error == 0 || *maximum == *minimum)
+            return block;
+
+
+        // The 8 value mode, interpolating over the whole range
+        std::uint64_t fullRangeBlock = 0;
+
+        if(EncodeBlock(pixels, *maximum, *minimum, fullRangeBlock) < error)
+            return fullRangeBlock;
+
+        return block;
+    };
+};
+
+
+/// <summary>
+/// The size of a BC4 compressed image, in bytes. Partial blocks at the right and bottom edges take a whole block
+/// </summary>
+inline std::size_t GetBC4SizeInBytes(const std::uint32_t width, const std::uint32_t height)
+{
+    return ((static_cast<std::size_t>(width) + 3) / 4) * ((static_cast<std::size_t>(height) + 3) / 4) * BC4Kernels::BlockSizeInBytes;
+};
+
+
+/// <summary>
+/// Compress a single channel image into BC4 blocks, left to right and top to bottom.
+/// Partial blocks at the edges repeat the image's last row and column
+/// </summary>
+/// <param name="source"> The first source row, one byte per pixel </param>
+/// <param name="sourceStride"> The distance between source rows, in bytes </param>
+/// <param name="destination"> Receives GetBC4SizeInBytes(width, height) bytes </param>
+/// <param name="width"> The width of a row, in pixels </param>
+/// <param name="height"> The number of rows </param>
+inline void CompressBC4(const std::byte* source,
+                        const std::size_t sourceStride,
+                        std::byte* destination,
+                        const std::uint32_t width,
+                        const std::uint32_t height)
+{
+    std::array<std::uint8_t, 16> pixels = { };
+
+    for(std::uint32_t blockY = 0; blockY < height; blockY += 4)
+    {
+        for(std::uint32_t blockX = 0; blockX < width; blockX += 4)
+        {
+            for(std::uint32_t y = 0; y < 4; ++y)
+            {
+                const std::uint8_t* sourcePixels = reinterpret_cast<const std::uint8_t*>(source + std::min(blockY + y, height - 1) * sourceStride);
+
+                for(std::uint32_t x = 0; x < 4; ++x)
+                {
+                    pixels[(y * 4) + x] = sourcePixels[std::min(blockX + x, width - 1)];
+                };
+            };
+
+            // Blocks are stored little-endian
+            const std::uint64_t block = BC4Kernels::CompressBlock(pixels);
+
+            std::memcpy(destination, &block, BC4Kernels::BlockSizeInBytes);
+
+            destination += BC4Kernels::BlockSizeInBytes;
+        };
+    };
+};
+
+
+/// <summary>
+/// Decompress BC4 blocks into a single channel image, for drivers that can't sample BC4 or textures that need their mips generated
+/// </summary>
+/// <param name="source"> GetBC4SizeInBytes(width, height) bytes of blocks, as written by CompressBC4 </param>
+/// <param name="destination"> The first destination row, one byte per pixel </param>
+/// <param name="destinationStride"> The distance between destination rows, in bytes </param>
+/// <param name="width"> The width of a row, in pixels </param>
+/// <param name="height"> The number of rows </param>
+inline void DecompressBC4(const std::byte* source,
+                          std::byte* destination,
+                          const std::size_t destinationStride,
+                          const std::uint32_t width,
+                          const std::uint32_t height)
+{
+    for(std::uint32_t blockY = 0; blockY < height; blockY += 4)
+    {
+        for(std::uint32_t blockX = 0; blockX < width; blockX += 4)
+        {
+            std::uint64_t block = 0;
+
+            std::memcpy(&block, source, BC4Kernels::BlockSizeInBytes);
+
+            source += BC4Kernels::BlockSizeInBytes;
+
+
+            const std::array<std::uint8_t, 8> palette = BC4Kernels::BuildPalette(static_cast<std::uint8_t>(block), static_cast<std::uint8_t>(block >> 8));
+
+            for(std::uint32_t y = 0; y < 4 && blockY + y < height; ++y)
+            {
+                std::uint8_t* destinationPixels = reinterpret_cast<std::uint8_t*>(destination + (blockY + y) * destinationStride);
+
+                for(std::uint32_t x = 0; x < 4 && blockX + x < width; ++x)
+                {
+                    const std::uint32_t index = static_cast<std::uint32_t>(block >> (16 + (((y * 4) + x) * 3))) & 7;
+
+                    destinationPixels[blockX + x] = palette[index];
+                };
+            };
+        };
+    };
+};
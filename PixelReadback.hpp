@@ -0,0 +1,239 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "GLStateCache.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A framebuffer's pixels once a PixelReadback finished reading them
+/// </summary>
+struct ReadbackImage
+{
+    std::uint32_t Width = 0;
+    std::uint32_t Height = 0;
+
+    /// <summary>
+    /// The caller's value for the read, e.g. a frame number
+    /// </summary>
+    std::uint64_t Tag = 0;
+
+    /// <summary>
+    /// Tightly packed RGBA8, rows from the bottom of the framebuffer up, as GL reads them.
+    /// Points into the readback's mapped memory, and is only valid until the callback it was passed to returns
+    /// </summary>
+    std::span<const std::byte> Pixels;
+};
+
+
+/// <summary>
+/// Reads framebuffers back without stalling. Each read is copied into one of a ring of pixel pack buffers and fenced,
+/// and only picked up by Collect once the fence signalled, a few frames later, so the GPU never has to drain for the CPU.
+/// The buffers are persistently mapped, picking a read up is a plain memory read
+/// </summary>
+class PixelReadback
+{
+
+private:
+
+    struct Slot
+    {
+        std::uint32_t BufferID = 0;
+
+        const std::byte* MappedPixels = nullptr;
+
+        /// <summary>
+        /// Placed after the read, null while the slot is free
+        /// </summary>
+        GLsync Fence = nullptr;
+
+        std::uint32_t Width = 0;
+        std::uint32_t Height = 0;
+
+        std::uint64_t Tag = 0;
+    };
+
+    std::vector<Slot> _slots;
+
+    /// <summary>
+    /// The oldest read that wasn't collected yet, reads are collected in the order they were made
+    /// </summary>
+    std::size_t _oldestSlot = 0;
+
+    std::size_t _pendingCount = 0;
+
+    std::size_t _slotSizeInBytes = 0;
+
+
+public:
+
+    /// <param name="maxWidth"> The widest read that can be made </param>
+    /// <param name="maxHeight"> The tallest read that can be made </param>
+    /// <param name="slotCount"> The number of reads that can be in flight, the frames of latency before a read is collected </param>
+    PixelReadback(const std::uint32_t maxWidth, const std::uint32_t maxHeight, const std::uint32_t slotCount = 3) :
+        _slots(slotCount),
+        _slotSizeInBytes(static_cast<std::size_t>(maxWidth) * maxHeight * 4)
+    {
+        wt::Assert(slotCount >= 1 && _slotSizeInBytes > 0, "A pixel readback needs at least one non-empty slot");
+
+        // Client storage keeps the buffers in system memory, where the CPU reads them
+        static constexpr GLbitfield storageFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT | GL_CLIENT_STORAGE_BIT;
+        static constexpr GLbitfield mapFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        for(Slot& slot : _slots)
+        {
+            glCreateBuffers(1, &slot.BufferID);
+            glNamedBufferStorage(slot.BufferID, static_cast<GLsizeiptr>(_slotSizeInBytes), nullptr, storageFlags);
+
+            slot.MappedPixels = static_cast<const std::byte*>(glMapNamedBufferRange(slot.BufferID, 0, static_cast<GLsizeiptr>(_slotSizeInBytes), mapFlags));
+
+            wt::Assert(slot.MappedPixels != nullptr, "Failed to map a pixel readback buffer");
+        };
+    };
+
+    PixelReadback(const PixelReadback&) = delete;
+    PixelReadback& operator = (const PixelReadback&) = delete;
+
+    /// <summary>
+    /// Reads that weren't collected are dropped
+    /// </summary>
+    ~PixelReadback()
+    {
+        for(Slot& slot : _slots)
+        {
+            if(slot.Fence != nullptr)
+                glDeleteSync(slot.Fence);
+
+            glUnmapNamedBuffer(slot.BufferID);
+
+            GLState.DeleteBuffer(slot.BufferID);
+        };
+    };
+
+
+public:
+
+    /// <summary>
+    /// Start reading a framebuffer's first colour attachment, or the default framebuffer's back buffer
+    /// </summary>
+    /// <param name="framebufferID"> The framebuffer to read, 0 for the window's </param>
+    /// <param name="tag"> Handed back with the image </param>
+    /// <returns> False if every slot is still in flight, the caller has to Collect first </returns>
+    bool Read(const std::uint32_t framebufferID, const std::uint32_t width, const std::uint32_t height, const std::uint64_t tag = 0)
+    {
+        wt::Assert(CanRead(width, height) == true, "A pixel readback is larger than the readback's slots");
+
+        if(_pendingCount == _slots.size())
+            return false;
+
+        Slot& slot = _slots[(_oldestSlot + _pendingCount) % _slots.size()];
+
+        glNamedFramebufferReadBuffer(framebufferID, framebufferID == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebufferID);
+
+        // With a pack buffer bound the read only queues a copy, the pointer is an offset into the buffer
+        GLState.BindBuffer(GL_PIXEL_PACK_BUFFER, slot.BufferID);
+
+        glReadnPixels(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(_slotSizeInBytes), nullptr);
+
+        GLState.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.Width = width;
+        slot.Height = height;
+        slot.Tag = tag;
+
+        ++_pendingCount;
+
+        return true;
+    };
+
+    /// <summary>
+    /// Hand every finished read to a callback, oldest first. Stops at the first read that isn't finished
+    /// </summary>
+    /// <param name="onImage"> Called with a ReadbackImage per finished read </param>
+    /// <param name="wait"> Wait for the oldest read if it isn't finished, e.g. to free a slot </param>
+    /// <returns> The number of reads collected </returns>
+    template<typename TOnImage>
+    std::size_t Collect(TOnImage&& onImage, const bool wait = false)
+    {
+        std::size_t collectedCount = 0;
+
+        while(_pendingCount > 0)
+        {
+            Slot& slot = _slots[_oldestSlot];
+
+            // The first poll flushes, so the fence is sure to signal eventually
+            GLenum waitResult = glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+            // Only the oldest read is waited for, the ones after it are collected if they happen to be done too
+            while(wait == true && collectedCount == 0 && waitResult == GL_TIMEOUT_EXPIRED)
+            {
+                waitResult = glClientWaitSync(slot.Fence, 0, 1'000'000);
+            };
+
+            if(waitResult == GL_TIMEOUT_EXPIRED)
+                break;
+
+            glDeleteSync(slot.Fence);
+            slot.Fence = nullptr;
+
+            onImage(ReadbackImage
+            {
+                .Width = slot.Width,
+                .Height = slot.Height,
+                .Tag = slot.Tag,
+                .Pixels = std::span<const std::byte>(slot.MappedPixels, static_cast<std::size_t>(slot.Width) * slot.Height * 4),
+            });
+
+            _oldestSlot = (_oldestSlot + 1) % _slots.size();
+            --_pendingCount;
+
+            ++collectedCount;
+        };
+
+        return collectedCount;
+    };
+
+    /// <summary>
+    /// Wait for every read in flight and hand them all to a callback
+    /// </summary>
+    template<typename TOnImage>
+    void Drain(TOnImage&& onImage)
+    {
+        while(_pendingCount > 0)
+        {
+            Collect(onImage, true);
+        };
+    };
+
+
+public:
+
+    /// <summary>
+    /// Check if a read fits in the slots
+    /// </summary>
+    bool CanRead(const std::uint32_t width, const std::uint32_t height) const
+    {
+        return static_cast<std::size_t>(width) * height * 4 <= _slotSizeInBytes;
+    };
+
+    /// <summary>
+    /// The number of reads that weren't collected yet
+    /// </summary>
+    std::size_t GetPendingCount() const
+    {
+        return _pendingCount;
+    };
+
+    std::size_t GetSlotCount() const
+    {
+        return _slots.size();
+    };
+
+};
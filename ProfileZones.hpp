@@ -0,0 +1,555 @@
+#pragma once
+
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory_resource>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef TEXT_RENDERER_TRACY
+#include <tracy/TracyC.h>
+#endif
+
+
+/// <summary>
+/// Where a zone is in the source, one per TEXT_RENDERER_ZONE. Lives for the whole program, so backends can key on its address
+/// </summary>
+struct ProfileZoneSite
+{
+    const char* Name = nullptr;
+    const char* File = nullptr;
+    std::uint32_t Line = 0;
+};
+
+
+/// <summary>
+/// Receives the zones and counters of every subsystem, e.g. to show them in the app or write them to a trace.
+/// Zones on a thread nest, a zone always ends before the one it's in. Called on whichever thread the zone ran on
+/// </summary>
+class IProfileZoneBackend
+{
+
+public:
+
+    virtual ~IProfileZoneBackend() = default;
+
+
+public:
+
+    /// <summary>
+    /// (Any thread) A zone was entered
+    /// </summary>
+    virtual void BeginZone(const ProfileZoneSite&)
+    {
+    };
+
+    /// <summary>
+    /// (Any thread) The thread's innermost zone ended
+    /// </summary>
+    /// <param name="beginTime"> When the zone was entered, in ProfileZoneRegistry::GetTime ticks </param>
+    /// <param name="endTime"> When it ended </param>
+    virtual void EndZone(const ProfileZoneSite& site, const std::int64_t beginTime, const std::int64_t endTime) = 0;
+
+    /// <summary>
+    /// (Any thread) A counter's value changed
+    /// </summary>
+    /// <param name="name"> Must outlive the backend, e.g. a literal </param>
+    virtual void RecordCounter(const char*, const double)
+    {
+    };
+
+    /// <summary>
+    /// (Render thread) A frame was presented
+    /// </summary>
+    virtual void EndFrame()
+    {
+    };
+
+};
+
+
+/// <summary>
+/// Hands zones and counters to the backends that were added. With none added, a zone costs a single relaxed load.
+/// Backends are only added and removed while no zone runs, e.g. before the render thread starts and after it ended
+/// </summary>
+class ProfileZoneRegistry
+{
+
+private:
+
+    std::vector<IProfileZoneBackend*> _backends;
+
+    std::atomic<bool> _enabled = false;
+
+    double _microsecondsPerTick = 0.0;
+
+
+public:
+
+    ProfileZoneRegistry()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+
+        _microsecondsPerTick = 1'000'000.0 / static_cast<double>(frequency.QuadPart);
+    };
+
+    ProfileZoneRegistry(const ProfileZoneRegistry&) = delete;
+    ProfileZoneRegistry& operator = (const ProfileZoneRegistry&) = delete;
+
+
+public:
+
+    void AddBackend(IProfileZoneBackend& backend)
+    {
+        _backends.emplace_back(&backend);
+
+        _enabled.store(true, std::memory_order_relaxed);
+    };
+
+    void RemoveBackend(IProfileZoneBackend& backend)
+    {
+        _backends.erase(std::remove(_backends.begin(), _backends.end(), &backend), _backends.end());
+
+        _enabled.store(_backends.empty() == false, std::memory_order_relaxed);
+    };
+
+    bool IsEnabled() const
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    };
+
+
+    void BeginZone(const ProfileZoneSite& site) const
+    {
+        for(IProfileZoneBackend* backend : _backends)
+        {
+            backend->BeginZone(site);
+        };
+    };
+
+    void EndZone(const ProfileZoneSite& site, const std::int64_t beginTime, const std::int64_t endTime) const
+    {
+        // Ended in reverse, so nesting backends see their innermost zone end first
+        for(auto backend = _backends.crbegin(); backend != _backends.crend(); ++backend)
+        {
+            (*backend)->EndZone(site, beginTime, endTime);
+        };
+    };
+
+    void RecordCounter(const char* name, const double value) const
+    {
+        if(IsEnabled() == false)
+            return;
+
+        for(IProfileZoneBackend* backend : _backends)
+        {
+            backend->RecordCounter(name, value);
+        };
+    };
+
+    void EndFrame() const
+    {
+        if(IsEnabled() == false)
+            return;
+
+        for(IProfileZoneBackend* backend : _backends)
+        {
+            backend->EndFrame();
+        };
+    };
+
+
+    static std::int64_t GetTime()
+    {
+        LARGE_INTEGER time;
+        QueryPerformanceCounter(&time);
+
+        return time.QuadPart;
+    };
+
+    double ToMicroseconds(const std::int64_t ticks) const
+    {
+        return static_cast<double>(ticks) * _microsecondsPerTick;
+    };
+
+};
+
+
+/// <summary>
+/// The backends every zone and counter goes to
+/// </summary>
+inline ProfileZoneRegistry ProfileZones;
+
+
+/// <summary>
+/// Times the lifetime of a scope as a zone. Use TEXT_RENDERER_ZONE rather than this directly, so the zone compiles out
+/// </summary>
+class ProfileZone
+{
+
+private:
+
+    const ProfileZoneSite* _site = nullptr;
+
+    std::int64_t _beginTime = 0;
+
+
+public:
+
+    explicit ProfileZone(const ProfileZoneSite& site)
+    {
+        if(ProfileZones.IsEnabled() == false)
+            return;
+
+        _site = &site;
+
+        ProfileZones.BeginZone(site);
+
+        _beginTime = ProfileZoneRegistry::GetTime();
+    };
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator = (const ProfileZone&) = delete;
+
+    ~ProfileZone()
+    {
+        if(_site != nullptr)
+            ProfileZones.EndZone(*_site, _beginTime, ProfileZoneRegistry::GetTime());
+    };
+
+};
+
+
+#define TEXT_RENDERER_PROFILE_CONCAT_INNER(left, right) left##right
+#define TEXT_RENDERER_PROFILE_CONCAT(left, right) TEXT_RENDERER_PROFILE_CONCAT_INNER(left, right)
+
+/// <summary>
+/// TEXT_RENDERER_ZONE("Name") times the rest of the enclosing scope, TEXT_RENDERER_COUNTER("Name", value) records a value, and
+/// TEXT_RENDERER_FRAME_MARK() ends a frame. All three compile to nothing, arguments included, unless TEXT_RENDERER_PROFILE_ZONES is defined
+/// </summary>
+#ifdef TEXT_RENDERER_PROFILE_ZONES
+    #define TEXT_RENDERER_ZONE(name)                                                                                                            \
+        static constexpr ProfileZoneSite TEXT_RENDERER_PROFILE_CONCAT(profileZoneSite, __LINE__) = { .Name = name, .File = __FILE__, .Line = __LINE__ }; \
+        const ProfileZone TEXT_RENDERER_PROFILE_CONCAT(profileZone, __LINE__) = ProfileZone(TEXT_RENDERER_PROFILE_CONCAT(profileZoneSite, __LINE__))
+
+    #define TEXT_RENDERER_COUNTER(name, value) ProfileZones.RecordCounter(name, static_cast<double>(value))
+
+    #define TEXT_RENDERER_FRAME_MARK() ProfileZones.EndFrame()
+#else
+    #define TEXT_RENDERER_ZONE(name) static_cast<void>(0)
+
+    #define TEXT_RENDERER_COUNTER(name, value) static_cast<void>(0)
+
+    #define TEXT_RENDERER_FRAME_MARK() static_cast<void>(0)
+#endif
+
+
+/// <summary>
+/// Sums every zone's calls and time per frame, and keeps the counters' last values, for the in-app statistics, see FrameStatistics::RecordProfileZones
+/// </summary>
+class ZoneStatisticsBackend : public IProfileZoneBackend
+{
+
+private:
+
+    struct ZoneTotals
+    {
+        std::uint64_t Count = 0;
+        std::int64_t Ticks = 0;
+        std::int64_t MaximumTicks = 0;
+    };
+
+
+    mutable std::mutex _lock;
+
+    /// <summary>
+    /// The frame in progress. Entries are zeroed rather than erased at the end of a frame, so steady frames don't allocate
+    /// </summary>
+    std::unordered_map<const ProfileZoneSite*, ZoneTotals> _currentFrame;
+
+    /// <summary>
+    /// The last frame's zones that ran, the slowest first
+    /// </summary>
+    std::vector<std::pair<const ProfileZoneSite*, ZoneTotals>> _lastFrame;
+
+    std::unordered_map<std::string_view, double> _counters;
+
+
+public:
+
+    void EndZone(const ProfileZoneSite& site, const std::int64_t beginTime, const std::int64_t endTime) override
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        ZoneTotals& totals = _currentFrame[&site];
+
+        ++totals.Count;
+        totals.Ticks += endTime - beginTime;
+        totals.MaximumTicks = std::max(totals.MaximumTicks, endTime - beginTime);
+    };
+
+    void RecordCounter(const char* name, const double value) override
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        _counters[name] = value;
+    };
+
+    void EndFrame() override
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        _lastFrame.clear();
+
+        for(auto& [site, totals] : _currentFrame)
+        {
+            if(totals.Count > 0)
+                _lastFrame.emplace_back(site, std::exchange(totals, ZoneTotals()));
+        };
+
+        std::sort(_lastFrame.begin(), _lastFrame.end(), [](const auto& left, const auto& right)
+        {
+            return left.second.Ticks > right.second.Ticks;
+        });
+    };
+
+
+    /// <summary>
+    /// The last frame's zones, the slowest first, and the counters
+    /// </summary>
+    std::pmr::string Format(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        std::pmr::string text = std::pmr::string(memory);
+
+        char line[128] = { };
+
+        text.append("Zone                      calls       ms      max\n");
+
+        for(const auto& [site, totals] : _lastFrame)
+        {
+            std::snprintf(line, sizeof(line), "%-24s %7llu %8.3f %8.3f\n",
+                          site->Name,
+                          static_cast<unsigned long long>(totals.Count),
+                          ProfileZones.ToMicroseconds(totals.Ticks) / 1000.0,
+                          ProfileZones.ToMicroseconds(totals.MaximumTicks) / 1000.0);
+
+            text.append(line);
+        };
+
+        for(const auto& [name, value] : _counters)
+        {
+            std::snprintf(line, sizeof(line), "%-24.*s %16.2f\n", static_cast<int>(name.size()), name.data(), value);
+
+            text.append(line);
+        };
+
+        return text;
+    };
+
+};
+
+
+/// <summary>
+/// Keeps every zone and counter for a Chrome trace, which chrome://tracing and Perfetto show as one lane per thread.
+/// Stops recording, rather than growing without bound, once it holds its maximum number of events
+/// </summary>
+class ChromeTraceZoneBackend : public IProfileZoneBackend
+{
+
+private:
+
+    struct TraceEvent
+    {
+        const char* Name = nullptr;
+
+        std::uint32_t ThreadID = 0;
+
+        std::int64_t BeginTime = 0;
+
+        /// <summary>
+        /// Equal to BeginTime for counters
+        /// </summary>
+        std::int64_t EndTime = 0;
+
+        double CounterValue = 0.0;
+
+        bool Counter = false;
+    };
+
+
+    mutable std::mutex _lock;
+
+    std::vector<TraceEvent> _events;
+
+    std::size_t _maxEventCount = 0;
+
+    std::uint64_t _droppedEventCount = 0;
+
+    std::int64_t _startTime = 0;
+
+
+public:
+
+    /// <param name="maxEventCount"> How many events are kept, at 40 bytes each </param>
+    ChromeTraceZoneBackend(const std::size_t maxEventCount = 4'000'000) :
+        _maxEventCount(maxEventCount),
+        _startTime(ProfileZoneRegistry::GetTime())
+    {
+    };
+
+
+public:
+
+    void EndZone(const ProfileZoneSite& site, const std::int64_t beginTime, const std::int64_t endTime) override
+    {
+        AddEvent(TraceEvent { .Name = site.Name, .ThreadID = static_cast<std::uint32_t>(GetCurrentThreadId()), .BeginTime = beginTime, .EndTime = endTime });
+    };
+
+    void RecordCounter(const char* name, const double value) override
+    {
+        const std::int64_t time = ProfileZoneRegistry::GetTime();
+
+        AddEvent(TraceEvent { .Name = name, .ThreadID = static_cast<std::uint32_t>(GetCurrentThreadId()), .BeginTime = time, .EndTime = time, .CounterValue = value, .Counter = true });
+    };
+
+    std::uint64_t GetDroppedEventCount() const
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        return _droppedEventCount;
+    };
+
+
+    /// <summary>
+    /// Write the events recorded so far, "{ "traceEvents": [...] }"
+    /// </summary>
+    void WriteChromeTraceJSON(std::ostream& stream) const
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        const std::uint32_t processID = static_cast<std::uint32_t>(GetCurrentProcessId());
+
+        stream << "{ \"traceEvents\": [\n";
+
+        for(std::size_t index = 0; index < _events.size(); ++index)
+        {
+            const TraceEvent& event = _events[index];
+
+            const double start = ProfileZones.ToMicroseconds(event.BeginTime - _startTime);
+
+            // Zone and counter names are ours, nothing in them needs escaping
+            char line[256] = { };
+
+            if(event.Counter == true)
+            {
+                std::snprintf(line, sizeof(line),
+                              "  { \"name\": \"%s\", \"ph\": \"C\", \"pid\": %u, \"tid\": %u, \"ts\": %.3f, \"args\": { \"value\": %.3f } }",
+                              event.Name, processID, event.ThreadID, start, event.CounterValue);
+            }
+            else
+            {
+                std::snprintf(line, sizeof(line),
+                              "  { \"name\": \"%s\", \"ph\": \"X\", \"pid\": %u, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f }",
+                              event.Name, processID, event.ThreadID, start, ProfileZones.ToMicroseconds(event.EndTime - event.BeginTime));
+            };
+
+            stream << line << (index + 1 < _events.size() ? ",\n" : "\n");
+        };
+
+        stream << "] }\n";
+    };
+
+
+private:
+
+    void AddEvent(const TraceEvent& event)
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        if(_events.size() >= _maxEventCount)
+        {
+            ++_droppedEventCount;
+            return;
+        };
+
+        _events.emplace_back(event);
+    };
+
+};
+
+
+#ifdef TEXT_RENDERER_TRACY
+
+/// <summary>
+/// Forwards zones, counters and frames to a Tracy client, built with Tracy's client in Includes and TEXT_RENDERER_TRACY defined
+/// </summary>
+class TracyZoneBackend : public IProfileZoneBackend
+{
+
+private:
+
+    /// <summary>
+    /// The zones the thread is in, innermost last
+    /// </summary>
+    static inline thread_local std::vector<TracyCZoneCtx> _threadZones;
+
+    std::mutex _sourceLocationsLock;
+
+    /// <summary>
+    /// Tracy refers to a zone's source location by address for as long as it runs, a map's nodes never move
+    /// </summary>
+    std::unordered_map<const ProfileZoneSite*, ___tracy_source_location_data> _sourceLocations;
+
+
+public:
+
+    void BeginZone(const ProfileZoneSite& site) override
+    {
+        const ___tracy_source_location_data* sourceLocation = nullptr;
+
+        {
+            const std::lock_guard lock = std::lock_guard(_sourceLocationsLock);
+
+            const auto [location, added] = _sourceLocations.try_emplace(&site);
+
+            if(added == true)
+                location->second = ___tracy_source_location_data { .name = site.Name, .function = site.Name, .file = site.File, .line = site.Line, .color = 0 };
+
+            sourceLocation = &location->second;
+        };
+
+        _threadZones.emplace_back(___tracy_emit_zone_begin(sourceLocation, 1));
+    };
+
+    void EndZone(const ProfileZoneSite&, const std::int64_t, const std::int64_t) override
+    {
+        ___tracy_emit_zone_end(_threadZones.back());
+
+        _threadZones.pop_back();
+    };
+
+    void RecordCounter(const char* name, const double value) override
+    {
+        ___tracy_emit_plot(name, value);
+    };
+
+    void EndFrame() override
+    {
+        ___tracy_emit_frame_mark(nullptr);
+    };
+
+};
+
+#endif
@@ -0,0 +1,381 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "GLObject.hpp"
+#include "GLStateCache.hpp"
+#include "MappedFile.hpp"
+#include "ShaderIncludes.hpp"
+#include "ShaderProgram.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A single shader stage linked into a separable program, combined with other stages at draw time by a ProgramPipeline.
+/// Linking a stage once and pairing it with any other stage avoids linking every vertex/fragment combination as a ShaderProgram.
+/// Stages only meet at the pipeline, so their interfaces are matched by name or location when it's validated
+/// </summary>
+class ShaderStage
+{
+
+private:
+
+    GLProgram _program;
+
+    GLenum _shaderType = GL_VERTEX_SHADER;
+
+    std::string _shaderPath;
+
+
+public:
+
+    /// <param name="shaderType"> GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, ... </param>
+    /// <param name="shaderPath"> Path to the shader's source </param>
+    /// <param name="defines"> Macros to define after the #version line, see ShaderProgram </param>
+    ShaderStage(const GLenum shaderType, std::string shaderPath, const std::vector<std::string>& defines = { }) :
+        _shaderType(shaderType),
+        _shaderPath(std::move(shaderPath))
+    {
+        const MappedFile shaderFile = MappedFile(_shaderPath);
+
+        const ResolvedShaderSource resolvedShader = ShaderIncludes.Resolve(_shaderPath, shaderFile.GetText());
+
+        const std::uint32_t shaderID = glCreateShader(shaderType);
+
+        SetShaderSourceWithDefines(shaderID, resolvedShader.GetText(), defines);
+        glCompileShader(shaderID);
+
+        Link(shaderID);
+    };
+
+    ShaderStage(ShaderStage&&) noexcept = default;
+    ShaderStage& operator = (ShaderStage&&) noexcept = default;
+
+
+    /// <summary>
+    /// Create a stage from a SPIR-V module, see ShaderProgram::FromSPIRV
+    /// </summary>
+    /// <param name="shaderType"> GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, ... </param>
+    /// <param name="modulePath"> Path to the shader's module </param>
+    /// <param name="specialization"> The specialization constants' values, the module's defaults for any that aren't set </param>
+    static ShaderStage FromSPIRV(const GLenum shaderType, std::string modulePath, const ShaderSpecialization& specialization = { })
+    {
+        ShaderStage stage;
+
+        stage._shaderType = shaderType;
+        stage._shaderPath = std::move(modulePath);
+
+        const MappedFile module = MappedFile(stage._shaderPath);
+
+        stage.Link(ShaderProgram::LoadSPIRVShader(shaderType, module.GetBytes(), specialization));
+
+        return stage;
+    };
+
+
+public:
+
+    /// <summary>
+    /// The location of one of the stage's uniforms, -1 if the stage doesn't use it, in which case setting it does nothing
+    /// </summary>
+    std::int32_t GetUniformLocation(const std::string& name) const
+    {
+        return glGetUniformLocation(_program.Get(), name.c_str());
+    };
+
+    // Uniforms are written straight to the stage's program, which doesn't have to be part of the bound pipeline
+
+    void SetMatrix4(const std::int32_t location, const glm::mat4& matrix) const
+    {
+        glProgramUniformMatrix4fv(_program.Get(), location, 1, GL_FALSE, glm::value_ptr(matrix));
+    };
+
+    void SetFloat(const std::int32_t location, const float value) const
+    {
+        glProgramUniform1f(_program.Get(), location, value);
+    };
+
+    void SetInt(const std::int32_t location, const int value) const
+    {
+        glProgramUniform1i(_program.Get(), location, value);
+    };
+
+    void SetUInt(const std::int32_t location, const std::uint32_t value) const
+    {
+        glProgramUniform1ui(_program.Get(), location, value);
+    };
+
+    void SetBool(const std::int32_t location, const bool value) const
+    {
+        SetInt(location, value);
+    };
+
+
+public:
+
+    std::uint32_t GetProgramID() const
+    {
+        return _program.Get();
+    };
+
+    GLenum GetShaderType() const
+    {
+        return _shaderType;
+    };
+
+    /// <summary>
+    /// The stage's bit for glUseProgramStages
+    /// </summary>
+    GLbitfield GetStageBit() const
+    {
+        switch(_shaderType)
+        {
+            case GL_VERTEX_SHADER:
+                return GL_VERTEX_SHADER_BIT;
+
+            case GL_FRAGMENT_SHADER:
+                return GL_FRAGMENT_SHADER_BIT;
+
+            case GL_GEOMETRY_SHADER:
+                return GL_GEOMETRY_SHADER_BIT;
+
+            case GL_TESS_CONTROL_SHADER:
+                return GL_TESS_CONTROL_SHADER_BIT;
+
+            case GL_TESS_EVALUATION_SHADER:
+                return GL_TESS_EVALUATION_SHADER_BIT;
+
+            case GL_COMPUTE_SHADER:
+                return GL_COMPUTE_SHADER_BIT;
+
+            default:
+                return 0;
+        };
+    };
+
+
+private:
+
+    /// <summary>
+    /// An empty stage, filled in by FromSPIRV
+    /// </summary>
+    ShaderStage() = default;
+
+
+    /// <summary>
+    /// Link a compiled shader into the stage's separable program, the shader is deleted afterwards
+    /// </summary>
+    void Link(const std::uint32_t shaderID)
+    {
+        CheckStatus(shaderID, GL_COMPILE_STATUS, "compilation");
+
+
+        _program = GLProgram::Create();
+
+        glProgramParameteri(_program.Get(), GL_PROGRAM_SEPARABLE, GL_TRUE);
+
+        glAttachShader(_program.Get(), shaderID);
+        glLinkProgram(_program.Get());
+
+        // A linked program doesn't need its shader anymore
+        glDetachShader(_program.Get(), shaderID);
+        glDeleteShader(shaderID);
+
+        CheckStatus(_program.Get(), GL_LINK_STATUS, "link");
+    };
+
+    /// <summary>
+    /// Report a failed compile or link, like ShaderProgram does
+    /// </summary>
+    void CheckStatus(const std::uint32_t objectID, const GLenum status, const std::string_view& action) const
+    {
+        const bool isProgram = status == GL_LINK_STATUS;
+
+        int success = 0;
+
+        if(isProgram == true)
+            glGetProgramiv(objectID, status, &success);
+        else
+            glGetShaderiv(objectID, status, &success);
+
+        if(success)
+            return;
+
+
+        int bufferLength = 0;
+
+        if(isProgram == true)
+            glGetProgramiv(objectID, GL_INFO_LOG_LENGTH, &bufferLength);
+        else
+            glGetShaderiv(objectID, GL_INFO_LOG_LENGTH, &bufferLength);
+
+        std::string error;
+        error.resize(bufferLength);
+
+        if(isProgram == true)
+            glGetProgramInfoLog(objectID, bufferLength, &bufferLength, error.data());
+        else
+            glGetShaderInfoLog(objectID, bufferLength, &bufferLength, error.data());
+
+        std::cerr << "Shader stage \"" << _shaderPath << "\" " << action << " error:\n" << error << "\n";
+
+        __debugbreak();
+    };
+
+};
+
+
+/// <summary>
+/// Combines separately linked ShaderStages into what a draw runs. Swapping a stage only changes the pipeline, nothing is linked again
+/// </summary>
+class ProgramPipeline
+{
+
+private:
+
+    GLProgramPipeline _pipeline = GLProgramPipeline::Create();
+
+
+public:
+
+    ProgramPipeline() = default;
+
+    /// <summary>
+    /// A pipeline of a vertex and a fragment stage, the usual pairing
+    /// </summary>
+    ProgramPipeline(const ShaderStage& vertexStage, const ShaderStage& fragmentStage)
+    {
+        wt::Assert(vertexStage.GetShaderType() == GL_VERTEX_SHADER && fragmentStage.GetShaderType() == GL_FRAGMENT_SHADER, "Expected a vertex and a fragment stage");
+
+        SetStage(vertexStage);
+        SetStage(fragmentStage);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Use a stage for its shader type, replacing the pipeline's current one
+    /// </summary>
+    void SetStage(const ShaderStage& stage)
+    {
+        glUseProgramStages(_pipeline.Get(), stage.GetStageBit(), stage.GetProgramID());
+    };
+
+    void Bind() const
+    {
+        GLState.BindProgramPipeline(_pipeline.Get());
+    };
+
+    /// <summary>
+    /// Check that the stages fit together, their interfaces are only matched here. Failures are reported, not fatal
+    /// </summary>
+    /// <returns> True if the pipeline can be drawn with </returns>
+    bool Validate() const
+    {
+        glValidateProgramPipeline(_pipeline.Get());
+
+        int valid = 0;
+        glGetProgramPipelineiv(_pipeline.Get(), GL_VALIDATE_STATUS, &valid);
+
+        if(valid)
+            return true;
+
+
+        int bufferLength = 0;
+        glGetProgramPipelineiv(_pipeline.Get(), GL_INFO_LOG_LENGTH, &bufferLength);
+
+        std::string error;
+        error.resize(bufferLength);
+
+        glGetProgramPipelineInfoLog(_pipeline.Get(), bufferLength, &bufferLength, error.data());
+
+        std::cerr << "Program pipeline validation error:\n" << error << "\n";
+
+        return false;
+    };
+
+
+public:
+
+    std::uint32_t GetPipelineID() const
+    {
+        return _pipeline.Get();
+    };
+
+};
+
+
+/// <summary>
+/// One ProgramPipeline per vertex and fragment stage pairing, created the first time the pair is drawn with.
+/// Switching between cached pipelines is a single bind, rather than re-pointing a pipeline's stages every draw
+/// </summary>
+class ProgramPipelineCache
+{
+
+private:
+
+    /// <summary>
+    /// Keyed by the stages' programs. Pipelines never move, callers may keep references
+    /// </summary>
+    std::map<std::pair<std::uint32_t, std::uint32_t>, std::unique_ptr<ProgramPipeline>> _pipelines;
+
+
+public:
+
+    ProgramPipelineCache() = default;
+
+    ProgramPipelineCache(const ProgramPipelineCache&) = delete;
+    ProgramPipelineCache& operator = (const ProgramPipelineCache&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// The pipeline of a vertex and a fragment stage. The stages must outlive the cache, or be removed with Forget
+    /// </summary>
+    const ProgramPipeline& Get(const ShaderStage& vertexStage, const ShaderStage& fragmentStage)
+    {
+        std::unique_ptr<ProgramPipeline>& pipeline = _pipelines[{ vertexStage.GetProgramID(), fragmentStage.GetProgramID() }];
+
+        if(pipeline == nullptr)
+        {
+            pipeline = std::make_unique<ProgramPipeline>(vertexStage, fragmentStage);
+
+            #ifdef _DEBUG
+            pipeline->Validate();
+            #endif
+        };
+
+        return *pipeline;
+    };
+
+    /// <summary>
+    /// Delete every pipeline that uses a stage, before the stage itself is destroyed
+    /// </summary>
+    void Forget(const ShaderStage& stage)
+    {
+        const std::uint32_t programID = stage.GetProgramID();
+
+        std::erase_if(_pipelines, [&](const auto& pipeline)
+        {
+            return pipeline.first.first == programID || pipeline.first.second == programID;
+        });
+    };
+
+    std::size_t GetPipelineCount() const
+    {
+        return _pipelines.size();
+    };
+
+};
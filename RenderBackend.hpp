@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+
+/// <summary>
+/// A buffer created by an IRenderBackend, only meaningful to the backend that created it
+/// </summary>
+enum class BackendBuffer : std::uint32_t
+{
+    None = 0,
+};
+
+/// <summary>
+/// A texture created by an IRenderBackend
+/// </summary>
+enum class BackendTexture : std::uint32_t
+{
+    None = 0,
+};
+
+/// <summary>
+/// A pipeline created by an IRenderBackend: the shaders and the fixed-function state they're drawn with
+/// </summary>
+enum class BackendPipeline : std::uint32_t
+{
+    None = 0,
+};
+
+
+/// <summary>
+/// How a buffer's contents are written
+/// </summary>
+enum class BackendBufferUsage
+{
+    /// <summary>
+    /// Written once at creation, or rarely with UpdateBuffer, e.g. glyph metrics
+    /// </summary>
+    Static,
+
+    /// <summary>
+    /// Rewritten in parts with UpdateBuffer, e.g. a document's characters
+    /// </summary>
+    Dynamic,
+
+    /// <summary>
+    /// Rewritten every frame through MapStreamingRegion. The backend keeps a region per frame in flight,
+    /// so the CPU never writes what the GPU is still reading, and never waits for it unless it's a whole ring of frames ahead
+    /// </summary>
+    Streaming,
+};
+
+struct BackendBufferDescription
+{
+    /// <summary>
+    /// (Streaming) The size of each frame's region
+    /// </summary>
+    std::size_t SizeInBytes = 0;
+
+    BackendBufferUsage Usage = BackendBufferUsage::Static;
+
+    /// <summary>
+    /// (Static and dynamic) SizeInBytes bytes to fill the buffer with, or null to leave it undefined
+    /// </summary>
+    const void* InitialData = nullptr;
+};
+
+
+enum class BackendTextureFormat
+{
+    R8,
+    RG8,
+    RGBA8,
+
+    /// <summary>
+    /// One channel, block compressed to 4 bits per pixel
+    /// </summary>
+    BC4,
+};
+
+struct BackendTextureDescription
+{
+    std::uint32_t Width = 0;
+    std::uint32_t Height = 0;
+
+    BackendTextureFormat Format = BackendTextureFormat::RGBA8;
+
+    std::uint32_t MipLevelCount = 1;
+
+    /// <summary>
+    /// Sampled with linear filtering, nearest otherwise
+    /// </summary>
+    bool LinearFiltering = true;
+};
+
+
+enum class BackendBlendMode
+{
+    /// <summary>
+    /// Replace the destination
+    /// </summary>
+    Opaque,
+
+    /// <summary>
+    /// Straight alpha over the destination
+    /// </summary>
+    Alpha,
+
+    /// <summary>
+    /// Premultiplied alpha over the destination
+    /// </summary>
+    PremultipliedAlpha,
+
+    /// <summary>
+    /// Add to the destination, e.g. an overdraw heatmap
+    /// </summary>
+    Additive,
+};
+
+struct BackendPipelineDescription
+{
+    /// <summary>
+    /// The shaders' sources, in the backend's shading language
+    /// </summary>
+    std::string VertexShaderPath;
+    std::string FragmentShaderPath;
+
+    /// <summary>
+    /// Macros defined in both shaders, "NAME" or "NAME VALUE"
+    /// </summary>
+    std::vector<std::string> Defines;
+
+    BackendBlendMode BlendMode = BackendBlendMode::Alpha;
+};
+
+
+enum class BackendPrimitive
+{
+    Triangles,
+    TriangleStrip,
+};
+
+
+/// <summary>
+/// The GPU objects and commands the text engine needs, and nothing more: buffers, textures, pipelines and vertex-less instanced draws.
+/// Everything is referred to by opaque handles and every GPU write is explicit, so a backend can sit on an API with explicit memory management
+/// and recorded command buffers as well as on GL. GLRenderBackend is the GL 4.6 implementation.
+/// A backend belongs to the thread its API context is current on
+/// </summary>
+class IRenderBackend
+{
+
+public:
+
+    /// <summary>
+    /// The number of frames the CPU may be ahead of the GPU, and the number of regions of a streaming buffer
+    /// </summary>
+    static constexpr std::uint32_t FramesInFlight = 3;
+
+
+public:
+
+    virtual ~IRenderBackend() = default;
+
+
+public:
+
+    virtual BackendBuffer CreateBuffer(const BackendBufferDescription& description) = 0;
+
+    /// <summary>
+    /// Free a buffer. The GPU may still be reading it, the backend keeps its memory until it's done
+    /// </summary>
+    virtual void DestroyBuffer(const BackendBuffer buffer) = 0;
+
+    /// <summary>
+    /// (Static and dynamic) Write bytes into a buffer, ordered with the draws around the call
+    /// </summary>
+    virtual void UpdateBuffer(const BackendBuffer buffer, const std::size_t offsetInBytes, const std::span<const std::byte>& bytes) = 0;
+
+    /// <summary>
+    /// (Streaming) The current frame's region of a buffer, write-only. Bind the region with GetStreamingRegionOffset
+    /// </summary>
+    virtual std::byte* MapStreamingRegion(const BackendBuffer buffer) = 0;
+
+    /// <summary>
+    /// (Streaming) Where the current frame's region starts in the buffer
+    /// </summary>
+    virtual std::size_t GetStreamingRegionOffset(const BackendBuffer buffer) const = 0;
+
+    /// <summary>
+    /// What offsets passed to BindStorageBuffer must be multiples of
+    /// </summary>
+    virtual std::size_t GetStorageBufferOffsetAlignment() const = 0;
+
+
+    virtual BackendTexture CreateTexture(const BackendTextureDescription& description) = 0;
+
+    /// <summary>
+    /// Free a texture. The GPU may still be sampling it, the backend keeps its memory until it's done
+    /// </summary>
+    virtual void DestroyTexture(const BackendTexture texture) = 0;
+
+    /// <summary>
+    /// Write a rectangle of a mip level's pixels, tightly packed rows. Block compressed rectangles are whole blocks
+    /// </summary>
+    virtual void UpdateTexture(const BackendTexture texture, const std::uint32_t mipLevel,
+                               const std::uint32_t x, const std::uint32_t y, const std::uint32_t width, const std::uint32_t height,
+                               const std::span<const std::byte>& pixels) = 0;
+
+
+    virtual BackendPipeline CreatePipeline(const BackendPipelineDescription& description) = 0;
+
+    virtual void DestroyPipeline(const BackendPipeline pipeline) = 0;
+
+
+    virtual void BindPipeline(const BackendPipeline pipeline) = 0;
+
+    virtual void BindStorageBuffer(const std::uint32_t bindingIndex, const BackendBuffer buffer, const std::size_t offsetInBytes, const std::size_t sizeInBytes) = 0;
+
+    virtual void BindUniformBuffer(const std::uint32_t bindingIndex, const BackendBuffer buffer, const std::size_t offsetInBytes, const std::size_t sizeInBytes) = 0;
+
+    virtual void BindTexture(const std::uint32_t textureUnit, const BackendTexture texture) = 0;
+
+    /// <summary>
+    /// Draw with the bound pipeline. There are no vertex buffers, shaders build vertices from their vertex and instance index
+    /// </summary>
+    virtual void Draw(const BackendPrimitive primitive, const std::uint32_t vertexCount, const std::uint32_t instanceCount,
+                      const std::uint32_t firstVertex = 0, const std::uint32_t firstInstance = 0) = 0;
+
+
+    /// <summary>
+    /// Signal that all of the current frame's commands were issued, streaming buffers move on to their next region
+    /// </summary>
+    virtual void EndFrame() = 0;
+
+};
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <glm/vec2.hpp>
+
+#include "ContentScale.hpp"
+#include "FrameUniformBuffer.hpp"
+#include "GLDiagnostics.hpp"
+#include "GLStateCache.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A window whose context shares objects with the other windows', for drawing the same text to several windows, e.g. one per monitor.
+/// Buffers, textures, programs and sync objects are shared, so FontSprites, their atlases and ShaderPrograms are created once, in any of the contexts.
+/// Each window keeps what isn't shared: an empty vertex array for the attribute-less draws, and a FrameUniformBuffer with its own projection.
+/// Windows can all be drawn from one thread by making each current in turn, or each from its own thread.
+/// A FontSprite's draws write its input buffers, so a sprite must only be drawn by one thread at a time
+/// </summary>
+class RenderWindow
+{
+
+private:
+
+    GLFWwindow* _window = nullptr;
+
+    /// <summary>
+    /// Whether the window was created by this, rather than adopted
+    /// </summary>
+    bool _ownsWindow = false;
+
+    /// <summary>
+    /// The context's own empty vertex array, vertex arrays are the one kind of object the text draws use that isn't shared
+    /// </summary>
+    std::uint32_t _vao = 0;
+
+    /// <summary>
+    /// The window's projection and viewport, created in the window's context but readable from any
+    /// </summary>
+    std::optional<FrameUniformBuffer> _frameUniformBuffer;
+
+    /// <summary>
+    /// Written by the framebuffer size callback on the main thread, picked up by the thread drawing the window on its next frame
+    /// </summary>
+    std::atomic<int> _framebufferWidth = 0;
+    std::atomic<int> _framebufferHeight = 0;
+
+    /// <summary>
+    /// Written by the content scale callback when the window moves to another monitor, picked up like the size
+    /// </summary>
+    std::atomic<float> _contentScale = 1.0f;
+
+    /// <summary>
+    /// The size the viewport and projection were last set to
+    /// </summary>
+    int _viewportWidth = 0;
+    int _viewportHeight = 0;
+
+
+public:
+
+    /// <summary>
+    /// Create a window sharing objects with another's context. Must be called on the main thread, GLFW only creates windows there.
+    /// The current window hints are reused, so the context matches the shared one
+    /// </summary>
+    /// <param name="sharedWindow"> Any window whose context the new one shares objects with </param>
+    /// <param name="monitor"> If set, the window is placed at the monitor's top-left corner </param>
+    RenderWindow(const int width, const int height, const std::string_view& title, GLFWwindow* sharedWindow, GLFWmonitor* monitor = nullptr) :
+        _ownsWindow(true)
+    {
+        _window = glfwCreateWindow(width, height, title.data(), nullptr, sharedWindow);
+
+        wt::Assert(_window != nullptr, "Failed to create a shared window");
+
+        if(monitor != nullptr)
+        {
+            int monitorX = 0;
+            int monitorY = 0;
+
+            glfwGetMonitorPos(monitor, &monitorX, &monitorY);
+            glfwSetWindowPos(_window, monitorX, monitorY);
+        };
+
+        Initialize();
+    };
+
+    /// <summary>
+    /// Adopt an existing window, e.g. the first one, so it's drawn like the shared ones. Replaces its framebuffer size and content scale callbacks and user pointer.
+    /// Must be called on the main thread
+    /// </summary>
+    RenderWindow(GLFWwindow* window) :
+        _window(window)
+    {
+        Initialize();
+    };
+
+    RenderWindow(const RenderWindow&) = delete;
+    RenderWindow& operator = (const RenderWindow&) = delete;
+
+    /// <summary>
+    /// Must be called on the main thread, with the window's context not current on any other thread
+    /// </summary>
+    ~RenderWindow()
+    {
+        GLFWwindow* previousContext = glfwGetCurrentContext();
+
+        glfwMakeContextCurrent(_window);
+
+        glDeleteVertexArrays(1, &_vao);
+
+        _frameUniformBuffer.reset();
+
+        glfwSetFramebufferSizeCallback(_window, nullptr);
+        glfwSetWindowContentScaleCallback(_window, nullptr);
+        glfwSetWindowUserPointer(_window, nullptr);
+
+        glfwMakeContextCurrent(previousContext != _window ? previousContext : nullptr);
+
+        GLState.SetContextVertexArray(0);
+        GLState.Invalidate();
+
+        if(_ownsWindow == true)
+            glfwDestroyWindow(_window);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Make the window's context current on the calling thread, and point the thread's state cache at it.
+    /// With one thread per window the window has to be released by the thread it was current on first, see Release
+    /// </summary>
+    void MakeCurrent() const
+    {
+        glfwMakeContextCurrent(_window);
+
+        // Bindings are per context, the cache only knew the previous context's
+        GLState.Invalidate();
+        GLState.SetContextVertexArray(_vao);
+    };
+
+    /// <summary>
+    /// Detach whatever context is current on the calling thread, so another thread can make it current
+    /// </summary>
+    static void Release()
+    {
+        glfwMakeContextCurrent(nullptr);
+
+        GLState.SetContextVertexArray(0);
+        GLState.Invalidate();
+    };
+
+
+    /// <summary>
+    /// Pick up a resize or a new content scale and bind the window's frame data. Call with the window's context current, before the frame's draws
+    /// </summary>
+    /// <param name="time"> Time since startup, in seconds </param>
+    /// <returns> False if the window is minimized and there's nothing to draw into </returns>
+    bool BeginFrame(const float time)
+    {
+        const int width = _framebufferWidth;
+        const int height = _framebufferHeight;
+
+        if(width == 0 || height == 0)
+            return false;
+
+        if(width != _viewportWidth || height != _viewportHeight)
+        {
+            glViewport(0, 0, width, height);
+
+            _frameUniformBuffer->SetViewportSize(width, height);
+
+            _viewportWidth = width;
+            _viewportHeight = height;
+        };
+
+        _frameUniformBuffer->SetContentScale(_contentScale);
+
+        _frameUniformBuffer->Upload(time);
+        _frameUniformBuffer->Bind();
+
+        return true;
+    };
+
+    void Present() const
+    {
+        glfwSwapBuffers(_window);
+    };
+
+
+public:
+
+    GLFWwindow* GetWindow() const
+    {
+        return _window;
+    };
+
+    const FrameUniformBuffer& GetFrameUniformBuffer() const
+    {
+        return *_frameUniformBuffer;
+    };
+
+    /// <summary>
+    /// Framebuffer pixels per window unit on the monitor the window is on, e.g. for SelectScaledAtlas and GetContentScaleTransform
+    /// </summary>
+    float GetContentScale() const
+    {
+        return _contentScale;
+    };
+
+    /// <summary>
+    /// The size the viewport was set to by the last BeginFrame
+    /// </summary>
+    glm::ivec2 GetViewportSize() const
+    {
+        return { _viewportWidth, _viewportHeight };
+    };
+
+    bool ShouldClose() const
+    {
+        return glfwWindowShouldClose(_window) == GLFW_TRUE;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Track the window's size and content scale, and create the context's own objects inside it
+    /// </summary>
+    void Initialize()
+    {
+        glfwSetWindowUserPointer(_window, this);
+
+        glfwSetFramebufferSizeCallback(_window, [](GLFWwindow* window, int width, int height) noexcept
+        {
+            RenderWindow* renderWindow = static_cast<RenderWindow*>(glfwGetWindowUserPointer(window));
+
+            renderWindow->_framebufferWidth = width;
+            renderWindow->_framebufferHeight = height;
+        });
+
+        glfwSetWindowContentScaleCallback(_window, [](GLFWwindow* window, float scale, float) noexcept
+        {
+            static_cast<RenderWindow*>(glfwGetWindowUserPointer(window))->_contentScale = scale;
+        });
+
+        _contentScale = GetWindowContentScale(_window);
+
+        int width = 0;
+        int height = 0;
+
+        glfwGetFramebufferSize(_window, &width, &height);
+
+        _framebufferWidth = width;
+        _framebufferHeight = height;
+
+
+        GLFWwindow* previousContext = glfwGetCurrentContext();
+
+        glfwMakeContextCurrent(_window);
+
+        // Windows drawn from one thread would each wait for v-sync in turn, pacing is left to the caller
+        glfwSwapInterval(0);
+
+        // The debug callback is per-context
+        EnableGLDiagnostics(GLDiagnostics);
+
+        glCreateVertexArrays(1, &_vao);
+
+        _frameUniformBuffer.emplace();
+
+        glfwMakeContextCurrent(previousContext);
+
+        // Creating the frame buffer bound it in the window's context, not the one that's current again
+        GLState.Invalidate();
+    };
+
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+
+/// <summary>
+/// A bounded, lock-free queue between exactly one producer thread and one consumer thread
+/// </summary>
+/// <typeparam name="TElement"> Must be default constructible and move assignable </typeparam>
+/// <typeparam name="Capacity"> The maximum number of queued elements, a power of 2 </typeparam>
+template<typename TElement, std::size_t Capacity>
+class SPSCQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+
+private:
+
+    /// <summary>
+    /// The producer and consumer positions are on their own cache lines, so the threads don't invalidate each other's line on every operation
+    /// </summary>
+    static constexpr std::size_t CacheLineSize = 64;
+
+
+    std::array<TElement, Capacity> _elements;
+
+
+    /// <summary>
+    /// The position the next element is pushed to, only written by the producer
+    /// </summary>
+    alignas(CacheLineSize) std::atomic<std::size_t> _pushPosition = 0;
+
+    /// <summary>
+    /// (Producer) The last pop position seen, re-read only when the queue looks full
+    /// </summary>
+    std::size_t _cachedPopPosition = 0;
+
+
+    /// <summary>
+    /// The position the next element is popped from, only written by the consumer
+    /// </summary>
+    alignas(CacheLineSize) std::atomic<std::size_t> _popPosition = 0;
+
+    /// <summary>
+    /// (Consumer) The last push position seen, re-read only when the queue looks empty
+    /// </summary>
+    std::size_t _cachedPushPosition = 0;
+
+
+public:
+
+    SPSCQueue() = default;
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator = (const SPSCQueue&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// (Producer) Add an element
+    /// </summary>
+    /// <returns> False if the queue is full, in which case the element is left untouched </returns>
+    bool TryPush(TElement&& element)
+    {
+        const std::size_t pushPosition = _pushPosition.load(std::memory_order_relaxed);
+
+        if(pushPosition - _cachedPopPosition == Capacity)
+        {
+            _cachedPopPosition = _popPosition.load(std::memory_order_acquire);
+
+            if(pushPosition - _cachedPopPosition == Capacity)
+                return false;
+        };
+
+        _elements[pushPosition & (Capacity - 1)] = std::move(element);
+
+        _pushPosition.store(pushPosition + 1, std::memory_order_release);
+
+        return true;
+    };
+
+    /// <summary>
+    /// (Consumer) Take the oldest element
+    /// </summary>
+    /// <returns> False if the queue is empty </returns>
+    bool TryPop(TElement& element)
+    {
+        const std::size_t popPosition = _popPosition.load(std::memory_order_relaxed);
+
+        if(popPosition == _cachedPushPosition)
+        {
+            _cachedPushPosition = _pushPosition.load(std::memory_order_acquire);
+
+            if(popPosition == _cachedPushPosition)
+                return false;
+        };
+
+        // Moving out leaves the slot's resources with the consumer, the producer only ever assigns over it
+        element = std::move(_elements[popPosition & (Capacity - 1)]);
+
+        _popPosition.store(popPosition + 1, std::memory_order_release);
+
+        return true;
+    };
+
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A single buffer variable of a shader storage block, as the driver laid it out
+/// </summary>
+struct ReflectedSSBOVariable
+{
+    /// <summary>
+    /// The driver's name for the variable. Array variables end in "[0]", struct members are named "Block[0].Member"
+    /// </summary>
+    std::string Name;
+
+    /// <summary>
+    /// The variable's GL type, as in GL_FLOAT_VEC4
+    /// </summary>
+    GLenum Type = GL_NONE;
+
+    std::size_t Offset = 0;
+
+    /// <summary>
+    /// The variable's own element count and stride, 1 and 0 if it isn't an array. 0 elements means the array is unsized
+    /// </summary>
+    std::size_t ArraySize = 1;
+    std::size_t ArrayStride = 0;
+
+    std::size_t MatrixStride = 0;
+
+    /// <summary>
+    /// The element count and stride of the block's top-level array the variable is a part of, as with arrays of structs.
+    /// 1 and 0 if the variable isn't part of one
+    /// </summary>
+    std::size_t TopLevelArraySize = 1;
+    std::size_t TopLevelArrayStride = 0;
+
+
+    /// <summary>
+    /// The offset of an element of the variable. For arrays of structs the index selects the struct, otherwise the element
+    /// </summary>
+    std::size_t GetElementOffset(const std::size_t index) const
+    {
+        return Offset + (index * (TopLevelArrayStride != 0 ? TopLevelArrayStride : ArrayStride));
+    };
+};
+
+
+/// <summary>
+/// A shader storage block's layout, queried from a linked program
+/// </summary>
+struct ReflectedSSBOLayout
+{
+    std::string BlockName;
+
+    std::uint32_t Binding = 0;
+
+    /// <summary>
+    /// The block's size, including a single element of a trailing unsized array
+    /// </summary>
+    std::size_t DataSizeInBytes = 0;
+
+    /// <summary>
+    /// Every active variable, sorted by offset
+    /// </summary>
+    std::vector<ReflectedSSBOVariable> Variables;
+
+
+    /// <summary>
+    /// Find a variable by its driver name. Arrays can be looked up without their "[0]" suffix
+    /// </summary>
+    /// <returns> The variable, or null if the block has no such active variable </returns>
+    const ReflectedSSBOVariable* Find(const std::string_view& name) const
+    {
+        for(const ReflectedSSBOVariable& variable : Variables)
+        {
+            if(variable.Name == name)
+                return &variable;
+
+            const std::string_view variableName = variable.Name;
+
+            if(variableName.size() == name.size() + 3 && variableName.starts_with(name) == true && variableName.ends_with("[0]") == true)
+                return &variable;
+        };
+
+        return nullptr;
+    };
+};
+
+
+/// <summary>
+/// Query the layout of one of a linked program's shader storage blocks.
+/// Every variable is read with a single glGetProgramResourceiv call, callers should still cache the result, see ShaderProgram::GetStorageBlockLayout
+/// </summary>
+/// <param name="programID"> A linked program </param>
+/// <param name="blockName"> The block's name, as in "Input" </param>
+/// <param name="layout"> Receives the layout </param>
+/// <returns> False if the program has no such block </returns>
+inline bool ReflectSSBOLayout(const std::uint32_t programID, const std::string_view& blockName, ReflectedSSBOLayout& layout)
+{
+    const GLuint blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, std::string(blockName).c_str());
+
+    if(blockIndex == GL_INVALID_INDEX)
+        return false;
+
+
+    static constexpr std::array<GLenum, 3> blockProperties =
+    {
+        GL_BUFFER_BINDING,
+        GL_BUFFER_DATA_SIZE,
+        GL_NUM_ACTIVE_VARIABLES,
+    };
+
+    std::array<GLint, blockProperties.size()> blockValues = { };
+
+    glGetProgramResourceiv(programID, GL_SHADER_STORAGE_BLOCK, blockIndex, static_cast<GLsizei>(blockProperties.size()), blockProperties.data(), static_cast<GLsizei>(blockValues.size()), nullptr, blockValues.data());
+
+    layout.BlockName = blockName;
+    layout.Binding = static_cast<std::uint32_t>(blockValues[0]);
+    layout.DataSizeInBytes = static_cast<std::size_t>(blockValues[1]);
+
+
+    const GLint variableCount = blockValues[2];
+
+    std::vector<GLint> variableIndices = std::vector<GLint>(static_cast<std::size_t>(variableCount));
+
+    static constexpr GLenum activeVariablesProperty = GL_ACTIVE_VARIABLES;
+    glGetProgramResourceiv(programID, GL_SHADER_STORAGE_BLOCK, blockIndex, 1, &activeVariablesProperty, variableCount, nullptr, variableIndices.data());
+
+
+    static constexpr std::array<GLenum, 8> variableProperties =
+    {
+        GL_NAME_LENGTH,
+        GL_TYPE,
+        GL_OFFSET,
+        GL_ARRAY_SIZE,
+        GL_ARRAY_STRIDE,
+        GL_MATRIX_STRIDE,
+        GL_TOP_LEVEL_ARRAY_SIZE,
+        GL_TOP_LEVEL_ARRAY_STRIDE,
+    };
+
+    layout.Variables.clear();
+    layout.Variables.reserve(variableIndices.size());
+
+    for(const GLint variableIndex : variableIndices)
+    {
+        std::array<GLint, variableProperties.size()> values = { };
+
+        glGetProgramResourceiv(programID, GL_BUFFER_VARIABLE, static_cast<GLuint>(variableIndex), static_cast<GLsizei>(variableProperties.size()), variableProperties.data(), static_cast<GLsizei>(values.size()), nullptr, values.data());
+
+        ReflectedSSBOVariable variable;
+
+        // The name length includes the null terminator
+        variable.Name.resize(static_cast<std::size_t>(std::max(values[0], 1)) - 1);
+        glGetProgramResourceName(programID, GL_BUFFER_VARIABLE, static_cast<GLuint>(variableIndex), values[0], nullptr, variable.Name.data());
+
+        variable.Type = static_cast<GLenum>(values[1]);
+        variable.Offset = static_cast<std::size_t>(values[2]);
+        variable.ArraySize = static_cast<std::size_t>(values[3]);
+        variable.ArrayStride = static_cast<std::size_t>(values[4]);
+        variable.MatrixStride = static_cast<std::size_t>(values[5]);
+        variable.TopLevelArraySize = static_cast<std::size_t>(values[6]);
+        variable.TopLevelArrayStride = static_cast<std::size_t>(values[7]);
+
+        layout.Variables.push_back(std::move(variable));
+    };
+
+    std::sort(layout.Variables.begin(), layout.Variables.end(), [](const ReflectedSSBOVariable& left, const ReflectedSSBOVariable& right)
+    {
+        return left.Offset < right.Offset;
+    });
+
+    return true;
+};
@@ -0,0 +1,474 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "JobSystem.hpp"
+#include "LZ4.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// Lines of scrollback for a log view that runs for days, in memory that grows with their compressed size.
+/// The most recent lines are kept as they are, older ones are packed into blocks of about BlockSizeInBytes and compressed with LZ4,
+/// each with its lines' ends stored after its text, so finding a line is a search over the blocks' first lines.
+/// Blocks are decompressed when their lines are read and the last few are kept decompressed. Given a JobSystem, the blocks next to the
+/// ones read are decompressed ahead on its workers, so scrolling through old lines never waits on decompression.
+/// Only for the thread that appends, reads happen on that thread too
+/// </summary>
+class ScrollbackStore
+{
+
+private:
+
+    /// <summary>
+    /// A run of old lines, compressed. Never changes once sealed
+    /// </summary>
+    struct CompressedBlock
+    {
+        /// <summary>
+        /// The lines' text followed by where every line ends in it, as uint32s
+        /// </summary>
+        std::vector<std::byte> Data;
+
+        std::uint32_t TextSizeInBytes = 0;
+
+        std::uint32_t LineCount = 0;
+
+        std::uint64_t FirstLine = 0;
+    };
+
+    struct DecompressedBlock
+    {
+        std::string Text;
+
+        /// <summary>
+        /// Where every line ends in Text, without its '\n'
+        /// </summary>
+        std::vector<std::uint32_t> LineEnds;
+    };
+
+    struct CachedBlock
+    {
+        std::size_t BlockIndex = 0;
+
+        std::shared_ptr<const DecompressedBlock> Block;
+
+        std::uint64_t LastUse = 0;
+    };
+
+
+    /// <summary>
+    /// A deque, so sealing a block never moves the ones a worker may be decompressing
+    /// </summary>
+    std::deque<CompressedBlock> _blocks;
+
+    /// <summary>
+    /// The lines that aren't compressed yet, from _recentStart on. The last one may not be complete
+    /// </summary>
+    std::string _recent;
+    std::size_t _recentStart = 0;
+
+    /// <summary>
+    /// Where every complete line in _recent ends, without its '\n'
+    /// </summary>
+    std::deque<std::size_t> _recentLineEnds;
+
+    std::uint64_t _recentFirstLine = 0;
+
+    /// <summary>
+    /// The blocks that were decompressed last, shared with the workers that decompress ahead
+    /// </summary>
+    std::vector<CachedBlock> _cache;
+
+    /// <summary>
+    /// Blocks a worker is decompressing, so they aren't scheduled twice
+    /// </summary>
+    std::vector<std::size_t> _pendingBlocks;
+
+    mutable std::mutex _cacheLock;
+
+    std::uint64_t _useCounter = 0;
+
+    std::size_t _compressedSizeInBytes = 0;
+    std::uint64_t _uncompressedSizeInBytes = 0;
+
+    JobSystem* _jobs = nullptr;
+
+    JobGroup _prefetches;
+
+    /// <summary>
+    /// Where blocks are packed before they're compressed, kept so sealing doesn't allocate
+    /// </summary>
+    std::vector<std::byte> _packScratch;
+    std::vector<std::byte> _compressScratch;
+
+
+public:
+
+    /// <summary>
+    /// How much text a compressed block holds, at least. Larger blocks compress better, smaller ones are quicker to decompress for a single line
+    /// </summary>
+    std::size_t BlockSizeInBytes = 64 * 1024;
+
+    /// <summary>
+    /// How much of the newest text is kept uncompressed, so tailing the log never decompresses anything
+    /// </summary>
+    std::size_t RecentSizeInBytes = 1024 * 1024;
+
+    /// <summary>
+    /// How many blocks are kept decompressed, enough for a screen of lines and the blocks on either side of it
+    /// </summary>
+    std::size_t CachedBlockCount = 8;
+
+    /// <summary>
+    /// How many blocks before and after the ones read are decompressed ahead
+    /// </summary>
+    std::size_t PrefetchBlockCount = 2;
+
+
+public:
+
+    /// <param name="jobs"> If given, blocks next to the ones read are decompressed ahead on its workers. Must outlive the store </param>
+    explicit ScrollbackStore(JobSystem* jobs = nullptr) :
+        _jobs(jobs)
+    {
+    };
+
+    ScrollbackStore(const ScrollbackStore&) = delete;
+    ScrollbackStore& operator = (const ScrollbackStore&) = delete;
+
+    /// <summary>
+    /// Waits for the blocks still being decompressed ahead
+    /// </summary>
+    ~ScrollbackStore()
+    {
+        if(_jobs != nullptr)
+            _jobs->Wait(_prefetches);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Add text at the end, lines are split on '\n'. Text after the last '\n' starts a line that the next append continues
+    /// </summary>
+    void Append(const std::string_view& text)
+    {
+        const std::size_t appendStart = _recent.size();
+
+        _recent.append(text);
+
+        for(std::size_t newline = _recent.find('\n', appendStart); newline != std::string::npos; newline = _recent.find('\n', newline + 1))
+        {
+            _recentLineEnds.push_back(newline);
+        };
+
+        _uncompressedSizeInBytes += text.size();
+
+        // Only complete lines are sealed, and only once there's a whole block of them past the recent ones
+        while(_recentLineEnds.empty() == false && _recentLineEnds.back() - _recentStart > RecentSizeInBytes + BlockSizeInBytes)
+        {
+            SealBlock();
+        };
+    };
+
+    /// <summary>
+    /// Append lines to a string, separated by '\n', e.g. a screen of them to draw
+    /// </summary>
+    /// <param name="firstLine"> The first line to read </param>
+    /// <param name="lineCount"> How many lines to read, lines past the last one are skipped </param>
+    /// <param name="destination"> What to append the lines to </param>
+    void GetLines(const std::uint64_t firstLine, const std::size_t lineCount, std::string& destination)
+    {
+        const std::uint64_t endLine = std::min<std::uint64_t>(firstLine + lineCount, GetLineCount());
+
+        std::uint64_t line = firstLine;
+
+        while(line < endLine && line < _recentFirstLine)
+        {
+            const std::size_t blockIndex = FindBlock(line);
+            const CompressedBlock& block = _blocks[blockIndex];
+
+            const std::shared_ptr<const DecompressedBlock> decompressed = GetDecompressedBlock(blockIndex);
+
+            const std::uint64_t blockEndLine = std::min<std::uint64_t>(block.FirstLine + block.LineCount, endLine);
+
+            for(; line < blockEndLine; ++line)
+            {
+                const std::size_t index = static_cast<std::size_t>(line - block.FirstLine);
+                const std::size_t lineStart = index > 0 ? decompressed->LineEnds[index - 1] + 1 : 0;
+
+                if(line > firstLine)
+                    destination.push_back('\n');
+
+                destination.append(decompressed->Text, lineStart, decompressed->LineEnds[index] - lineStart);
+            };
+
+            Prefetch(blockIndex);
+        };
+
+        for(; line < endLine; ++line)
+        {
+            const std::size_t index = static_cast<std::size_t>(line - _recentFirstLine);
+
+            const std::size_t lineStart = index > 0 ? _recentLineEnds[index - 1] + 1 : _recentStart;
+            const std::size_t lineEnd = index < _recentLineEnds.size() ? _recentLineEnds[index] : _recent.size();
+
+            if(line > firstLine)
+                destination.push_back('\n');
+
+            destination.append(_recent, lineStart, lineEnd - lineStart);
+        };
+    };
+
+
+public:
+
+    /// <summary>
+    /// The number of lines, counting an incomplete last one
+    /// </summary>
+    std::uint64_t GetLineCount() const
+    {
+        const bool openLine = _recentLineEnds.empty() == true ? _recent.size() > _recentStart : _recentLineEnds.back() + 1 < _recent.size();
+
+        return _recentFirstLine + _recentLineEnds.size() + (openLine == true ? 1 : 0);
+    };
+
+    /// <summary>
+    /// The size of every line appended, as text
+    /// </summary>
+    std::uint64_t GetUncompressedSizeInBytes() const
+    {
+        return _uncompressedSizeInBytes;
+    };
+
+    /// <summary>
+    /// What the store holds in memory: the compressed blocks, the recent text and the blocks kept decompressed
+    /// </summary>
+    std::size_t GetMemoryUsageInBytes() const
+    {
+        std::size_t sizeInBytes = _compressedSizeInBytes + _recent.capacity() + (_recentLineEnds.size() * sizeof(std::size_t));
+
+        const std::lock_guard lock = std::lock_guard(_cacheLock);
+
+        for(const CachedBlock& cached : _cache)
+        {
+            sizeInBytes += cached.Block->Text.capacity() + (cached.Block->LineEnds.capacity() * sizeof(std::uint32_t));
+        };
+
+        return sizeInBytes;
+    };
+
+    std::size_t GetCompressedSizeInBytes() const
+    {
+        return _compressedSizeInBytes;
+    };
+
+    std::size_t GetBlockCount() const
+    {
+        return _blocks.size();
+    };
+
+
+private:
+
+    /// <summary>
+    /// Compress the oldest recent lines, at least BlockSizeInBytes of them, into a new block
+    /// </summary>
+    void SealBlock()
+    {
+        std::size_t lineCount = 0;
+
+        while(lineCount < _recentLineEnds.size() && _recentLineEnds[lineCount] - _recentStart < BlockSizeInBytes)
+        {
+            ++lineCount;
+        };
+
+        lineCount = std::min(lineCount + 1, _recentLineEnds.size());
+
+        const std::size_t textSize = _recentLineEnds[lineCount - 1] - _recentStart;
+
+        // The text, without the last line's '\n', then the line ends relative to it
+        _packScratch.resize(textSize + (lineCount * sizeof(std::uint32_t)));
+
+        std::memcpy(_packScratch.data(), _recent.data() + _recentStart, textSize);
+
+        for(std::size_t index = 0; index < lineCount; ++index)
+        {
+            const std::uint32_t lineEnd = static_cast<std::uint32_t>(_recentLineEnds[index] - _recentStart);
+
+            std::memcpy(_packScratch.data() + textSize + (index * sizeof(std::uint32_t)), &lineEnd, sizeof(lineEnd));
+        };
+
+        _compressScratch.resize(GetLZ4CompressedSizeBound(_packScratch.size()));
+
+        const std::size_t compressedSize = CompressLZ4(_packScratch, _compressScratch);
+
+        _blocks.push_back(CompressedBlock
+        {
+            .Data = std::vector<std::byte>(_compressScratch.begin(), _compressScratch.begin() + compressedSize),
+            .TextSizeInBytes = static_cast<std::uint32_t>(textSize),
+            .LineCount = static_cast<std::uint32_t>(lineCount),
+            .FirstLine = _recentFirstLine,
+        });
+
+        _compressedSizeInBytes += compressedSize;
+
+        _recentStart = _recentLineEnds[lineCount - 1] + 1;
+        _recentFirstLine += lineCount;
+
+        _recentLineEnds.erase(_recentLineEnds.begin(), _recentLineEnds.begin() + static_cast<std::ptrdiff_t>(lineCount));
+
+        // Move the recent lines to the front once more than half of the string is sealed text, so it doesn't grow forever
+        if(_recentStart > _recent.size() / 2)
+        {
+            _recent.erase(0, _recentStart);
+
+            for(std::size_t& lineEnd : _recentLineEnds)
+            {
+                lineEnd -= _recentStart;
+            };
+
+            _recentStart = 0;
+        };
+    };
+
+    /// <summary>
+    /// The block holding a line that was sealed
+    /// </summary>
+    std::size_t FindBlock(const std::uint64_t line) const
+    {
+        const auto block = std::upper_bound(_blocks.begin(), _blocks.end(), line, [](const std::uint64_t line, const CompressedBlock& block)
+        {
+            return line < block.FirstLine;
+        });
+
+        return static_cast<std::size_t>(block - _blocks.begin()) - 1;
+    };
+
+    /// <summary>
+    /// A block's lines, from the cache, decompressed here if no worker got to it first
+    /// </summary>
+    std::shared_ptr<const DecompressedBlock> GetDecompressedBlock(const std::size_t blockIndex)
+    {
+        {
+            const std::lock_guard lock = std::lock_guard(_cacheLock);
+
+            for(CachedBlock& cached : _cache)
+            {
+                if(cached.BlockIndex == blockIndex)
+                {
+                    cached.LastUse = ++_useCounter;
+                    return cached.Block;
+                };
+            };
+        };
+
+        std::shared_ptr<const DecompressedBlock> decompressed = Decompress(_blocks[blockIndex]);
+
+        AddToCache(blockIndex, decompressed);
+
+        return decompressed;
+    };
+
+    /// <summary>
+    /// Decompress the blocks around one on the workers, unless they're cached or already on their way
+    /// </summary>
+    void Prefetch(const std::size_t blockIndex)
+    {
+        if(_jobs == nullptr)
+            return;
+
+        const std::size_t firstBlock = blockIndex - std::min(blockIndex, PrefetchBlockCount);
+        const std::size_t endBlock = std::min(blockIndex + PrefetchBlockCount + 1, _blocks.size());
+
+        const std::lock_guard lock = std::lock_guard(_cacheLock);
+
+        for(std::size_t index = firstBlock; index < endBlock; ++index)
+        {
+            const bool cached = std::any_of(_cache.begin(), _cache.end(), [&](const CachedBlock& cached)
+            {
+                return cached.BlockIndex == index;
+            });
+
+            if(cached == true || std::find(_pendingBlocks.begin(), _pendingBlocks.end(), index) != _pendingBlocks.end())
+                continue;
+
+            _pendingBlocks.push_back(index);
+
+            // Sealed blocks never change or move, the worker reads this one while more are appended
+            _jobs->Schedule(_prefetches, [this, index, block = &_blocks[index]]()
+            {
+                std::shared_ptr<const DecompressedBlock> decompressed = Decompress(*block);
+
+                AddToCache(index, std::move(decompressed));
+            });
+        };
+    };
+
+    /// <summary>
+    /// Keep a decompressed block, replacing the least recently used one once the cache is full. Called by workers too
+    /// </summary>
+    void AddToCache(const std::size_t blockIndex, std::shared_ptr<const DecompressedBlock> decompressed)
+    {
+        const std::lock_guard lock = std::lock_guard(_cacheLock);
+
+        std::erase(_pendingBlocks, blockIndex);
+
+        const bool cached = std::any_of(_cache.begin(), _cache.end(), [&](const CachedBlock& cached)
+        {
+            return cached.BlockIndex == blockIndex;
+        });
+
+        if(cached == true)
+            return;
+
+        if(_cache.size() >= std::max<std::size_t>(CachedBlockCount, 1))
+        {
+            const auto leastRecentlyUsed = std::min_element(_cache.begin(), _cache.end(), [](const CachedBlock& left, const CachedBlock& right)
+            {
+                return left.LastUse < right.LastUse;
+            });
+
+            _cache.erase(leastRecentlyUsed);
+        };
+
+        _cache.push_back(CachedBlock
+        {
+            .BlockIndex = blockIndex,
+            .Block = std::move(decompressed),
+            .LastUse = ++_useCounter,
+        });
+    };
+
+    static std::shared_ptr<const DecompressedBlock> Decompress(const CompressedBlock& block)
+    {
+        const std::size_t lineEndsSize = block.LineCount * sizeof(std::uint32_t);
+
+        std::vector<std::byte> unpacked = std::vector<std::byte>(block.TextSizeInBytes + lineEndsSize);
+
+        const bool decompressed = DecompressLZ4(block.Data, unpacked);
+
+        wt::Assert(decompressed == true, "A scrollback block failed to decompress");
+
+        std::shared_ptr<DecompressedBlock> result = std::make_shared<DecompressedBlock>();
+
+        result->Text.assign(reinterpret_cast<const char*>(unpacked.data()), block.TextSizeInBytes);
+
+        result->LineEnds.resize(block.LineCount);
+        std::memcpy(result->LineEnds.data(), unpacked.data() + block.TextSizeInBytes, lineEndsSize);
+
+        return result;
+    };
+
+};
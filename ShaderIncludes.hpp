@@ -0,0 +1,290 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "EmbeddedAssets.hpp"
+#include "MappedFile.hpp"
+
+
+/// <summary>
+/// A shader's source with its #include lines replaced by what they include
+/// </summary>
+struct ResolvedShaderSource
+{
+    /// <summary>
+    /// The shader's own source, used as is when it includes nothing
+    /// </summary>
+    std::string_view Original;
+
+    /// <summary>
+    /// The source with every include expanded, empty if there was nothing to expand
+    /// </summary>
+    std::string Expanded;
+
+    /// <summary>
+    /// Every file the shader includes, directly or not. Generated includes aren't files, so they aren't listed
+    /// </summary>
+    std::vector<std::filesystem::path> IncludedFiles;
+
+
+    std::string_view GetText() const
+    {
+        return Expanded.empty() == true ? Original : std::string_view(Expanded);
+    };
+};
+
+
+/// <summary>
+/// Expands #include "Name" lines in shader sources, from files next to the including shader or from sources registered by name,
+/// e.g. block declarations generated from a StaticSSBOLayout. Shaders built from their EmbeddedAsset take their includes from embedded assets too, when there are any.
+/// Included files are read once and kept until they change on disk. Each file is included once per shader, like #pragma once.
+/// Every include gets its own GLSL source string number, set with #line, so errors point at the included file's lines,
+/// and the number's file is printed next to compile errors, see PrintSourceStrings
+/// </summary>
+class ShaderIncludeRegistry
+{
+
+private:
+
+    struct CachedFile
+    {
+        std::string Text;
+
+        std::filesystem::file_time_type WriteTime;
+    };
+
+    /// <summary>
+    /// Sources registered by name, looked up before files
+    /// </summary>
+    std::unordered_map<std::string, std::string> _generatedIncludes;
+
+    /// <summary>
+    /// By normalized path
+    /// </summary>
+    std::unordered_map<std::string, CachedFile> _files;
+
+    /// <summary>
+    /// The include behind every source string number, number N is at index N - 1. Number 0 is the including shader itself
+    /// </summary>
+    std::vector<std::string> _sourceStrings;
+
+
+public:
+
+    /// <summary>
+    /// Make a source includable by name, replacing any source registered under it before
+    /// </summary>
+    /// <returns> Always true, so the registration can initialize a variable at startup </returns>
+    bool Register(std::string name, std::string source)
+    {
+        _generatedIncludes.insert_or_assign(std::move(name), std::move(source));
+
+        return true;
+    };
+
+    /// <summary>
+    /// Expand a shader's includes. Sources without any are passed through without being copied
+    /// </summary>
+    /// <param name="shaderPath"> The shader's path, files are included relative to its directory </param>
+    /// <param name="source"> The shader's source, must outlive the result </param>
+    /// <param name="embedded"> Whether the source is an EmbeddedAsset, its included files are then looked for among the embedded assets before the disk </param>
+    ResolvedShaderSource Resolve(const std::filesystem::path& shaderPath, const std::string_view& source, const bool embedded = false)
+    {
+        ResolvedShaderSource resolved = ResolvedShaderSource
+        {
+            .Original = source,
+        };
+
+        if(source.find("#include") == std::string_view::npos)
+            return resolved;
+
+
+        std::vector<std::string> included;
+
+        resolved.Expanded.reserve(source.size());
+
+        Expand(resolved, included, shaderPath, shaderPath.parent_path(), source, 0, embedded);
+
+        return resolved;
+    };
+
+
+    /// <summary>
+    /// List the include behind every source string number, error messages refer to lines as "number(line)" or "number:line"
+    /// </summary>
+    void PrintSourceStrings(std::ostream& stream) const
+    {
+        if(_sourceStrings.empty() == true)
+            return;
+
+        stream << "Source strings: 0 = the shader";
+
+        for(std::size_t index = 0; index < _sourceStrings.size(); ++index)
+        {
+            stream << ", " << (index + 1) << " = " << _sourceStrings[index];
+        };
+
+        stream << "\n";
+    };
+
+
+private:
+
+    /// <summary>
+    /// Append a source to the expanded text, expanding its own includes in place
+    /// </summary>
+    /// <param name="included"> The includes already expanded into the shader </param>
+    /// <param name="sourceName"> The source's path or name, for error messages </param>
+    /// <param name="directory"> Where the source's includes are looked for </param>
+    /// <param name="sourceString"> The source's GLSL source string number </param>
+    /// <param name="embedded"> Whether included files are looked for among the embedded assets first </param>
+    void Expand(ResolvedShaderSource& resolved, std::vector<std::string>& included, const std::filesystem::path& sourceName, const std::filesystem::path& directory,
+                const std::string_view& source, const std::uint32_t sourceString, const bool embedded)
+    {
+        std::size_t lineNumber = 0;
+
+        for(std::size_t lineStart = 0; lineStart < source.size();)
+        {
+            const std::size_t lineEnd = std::min(source.find('\n', lineStart), source.size());
+
+            const std::string_view line = source.substr(lineStart, lineEnd - lineStart);
+
+            lineStart = lineEnd + 1;
+            ++lineNumber;
+
+
+            const std::size_t directiveStart = line.find_first_not_of(" \t");
+
+            if(directiveStart == std::string_view::npos || line.substr(directiveStart).starts_with("#include") == false)
+            {
+                resolved.Expanded.append(line).append("\n");
+                continue;
+            };
+
+
+            const std::size_t nameStart = line.find_first_of("\"<", directiveStart);
+            const std::size_t nameEnd = nameStart != std::string_view::npos ? line.find_first_of("\">", nameStart + 1) : std::string_view::npos;
+
+            if(nameEnd == std::string_view::npos)
+            {
+                std::cerr << "Shader \"" << sourceName.string() << "\" line " << lineNumber << ": malformed #include\n";
+
+                resolved.Expanded.append("\n");
+                continue;
+            };
+
+            const std::string includeName = std::string(line.substr(nameStart + 1, nameEnd - nameStart - 1));
+
+
+            // Generated includes take precedence over files
+            const auto generatedInclude = _generatedIncludes.find(includeName);
+
+            const std::filesystem::path includePath = (directory / includeName).lexically_normal();
+
+            const std::string includeKey = generatedInclude != _generatedIncludes.cend() ? includeName : includePath.generic_string();
+
+            if(std::find(included.cbegin(), included.cend(), includeKey) != included.cend())
+            {
+                resolved.Expanded.append("\n");
+                continue;
+            };
+
+
+            std::string_view includeText;
+
+            if(generatedInclude != _generatedIncludes.cend())
+            {
+                includeText = generatedInclude->second;
+            }
+            else
+            {
+                const EmbeddedAsset* embeddedInclude = embedded == true ? FindEmbeddedAsset(includePath) : nullptr;
+
+                const std::string* fileText = embeddedInclude == nullptr ? ReadFile(includePath) : nullptr;
+
+                if(embeddedInclude == nullptr && fileText == nullptr)
+                {
+                    std::cerr << "Shader \"" << sourceName.string() << "\" line " << lineNumber << ": can't include \"" << includePath.string() << "\"\n";
+
+                    resolved.Expanded.append("\n");
+                    continue;
+                };
+
+                includeText = embeddedInclude != nullptr ? embeddedInclude->GetText() : std::string_view(*fileText);
+
+                // Embedded includes are still watched, hot reloads read the files
+                resolved.IncludedFiles.push_back(includePath);
+            };
+
+            included.push_back(includeKey);
+
+
+            const std::uint32_t includeSourceString = GetSourceString(includeKey);
+
+            resolved.Expanded.append("#line 1 ").append(std::to_string(includeSourceString)).append("\n");
+
+            Expand(resolved, included, includeKey, includePath.parent_path(), includeText, includeSourceString, embedded);
+
+            // Back to the line after the #include
+            resolved.Expanded.append("#line ").append(std::to_string(lineNumber + 1)).append(" ").append(std::to_string(sourceString)).append("\n");
+        };
+    };
+
+    /// <summary>
+    /// A file's text, read again only if it was written since it was cached
+    /// </summary>
+    /// <returns> Null if the file can't be read </returns>
+    const std::string* ReadFile(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+
+        if(error)
+            return nullptr;
+
+        CachedFile& cachedFile = _files[path.generic_string()];
+
+        if(cachedFile.WriteTime == writeTime && cachedFile.Text.empty() == false)
+            return &cachedFile.Text;
+
+
+        // Editors may still be holding a file that just changed
+        const MappedFile file = MappedFile(path, false);
+
+        if(file.IsMapped() == false)
+            return nullptr;
+
+        cachedFile.Text = std::string(file.GetText());
+        cachedFile.WriteTime = writeTime;
+
+        return &cachedFile.Text;
+    };
+
+    std::uint32_t GetSourceString(const std::string& includeKey)
+    {
+        const auto sourceString = std::find(_sourceStrings.cbegin(), _sourceStrings.cend(), includeKey);
+
+        if(sourceString != _sourceStrings.cend())
+            return static_cast<std::uint32_t>(std::distance(_sourceStrings.cbegin(), sourceString)) + 1;
+
+        _sourceStrings.push_back(includeKey);
+
+        return static_cast<std::uint32_t>(_sourceStrings.size());
+    };
+
+};
+
+
+/// <summary>
+/// The includes of every shader, only for the thread that compiles shaders
+/// </summary>
+inline ShaderIncludeRegistry ShaderIncludes;
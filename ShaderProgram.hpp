@@ -6,14 +6,151 @@
 #include <cstdint>
 #include <glad/glad.h>
 #include <string>
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <cstdio>
+#include <string_view>
+#include <algorithm>
+#include <utility>
 #include <fstream>
 #include <unordered_map>
+#include <filesystem>
+#include <vector>
+#include <memory>
+#include <span>
+#include <optional>
 
 #include "WindowsUtilities.hpp"
+#include "GLExtensions.hpp"
+#include "MappedFile.hpp"
+#include "EmbeddedAssets.hpp"
+#include "FileWatcher.hpp"
+#include "GLStateCache.hpp"
+#include "SSBOReflection.hpp"
+#include "ShaderIncludes.hpp"
+#include "ProfileZones.hpp"
+#include "EventTracing.hpp"
+
+
+/// <summary>
+/// A uniform resolved once through ShaderProgram::GetUniformHandle.
+/// Refers to the program's table of resolved locations, so it stays valid when the program is reloaded
+/// </summary>
+struct UniformHandle
+{
+    std::uint32_t Index = static_cast<std::uint32_t>(-1);
+};
+
+
+/// <summary>
+/// How a ShaderProgram's shaders are compiled
+/// </summary>
+enum class ShaderCompileMode
+{
+    /// <summary>
+    /// Compile and link while the program is constructed
+    /// </summary>
+    Immediate,
+
+    /// <summary>
+    /// Submit the shaders to the driver and return, the program finishes compiling in the background. See ShaderProgram::IsReady
+    /// </summary>
+    Asynchronous,
+};
+
+
+/// <summary>
+/// The values of a SPIR-V module's specialization constants, "layout(constant_id = N) const ..." in GLSL.
+/// The SPIR-V counterpart of defines: one module compiled offline, specialized into any number of programs by the driver's backend alone
+/// </summary>
+struct ShaderSpecialization
+{
+    std::vector<std::uint32_t> ConstantIDs;
+
+    /// <summary>
+    /// The bits of each constant's value, 0 or 1 for a bool
+    /// </summary>
+    std::vector<std::uint32_t> Values;
+
+
+    void Set(const std::uint32_t constantID, const std::uint32_t value)
+    {
+        ConstantIDs.emplace_back(constantID);
+        Values.emplace_back(value);
+    };
+
+    /// <summary>
+    /// "ID=VALUE" per constant, keys the binary cache like a define block
+    /// </summary>
+    std::string ToString() const
+    {
+        std::string text;
+
+        for(std::size_t index = 0; index < ConstantIDs.size(); ++index)
+        {
+            text.append(std::to_string(ConstantIDs[index])).append("=").append(std::to_string(Values[index])).append("\n");
+        };
+
+        return text;
+    };
+};
+
+
+/// <summary>
+/// A #define line per define
+/// </summary>
+inline std::string GetShaderDefineBlock(const std::vector<std::string>& defines)
+{
+    std::string defineBlock;
+
+    for(const std::string& define : defines)
+    {
+        defineBlock.append("#define ").append(define).append("\n");
+    };
+
+    return defineBlock;
+};
+
+/// <summary>
+/// Hand a shader its source, with defines injected after the #version line, which has to come first.
+/// The source is passed in pieces around the defines, so it's never copied
+/// </summary>
+/// <param name="defines"> "NAME" or "NAME VALUE" </param>
+inline void SetShaderSourceWithDefines(const std::uint32_t shaderID, const std::string_view& source, const std::vector<std::string>& defines)
+{
+    if(defines.empty() == true)
+    {
+        const char* sourcePointer = source.data();
+        const int sourceLength = static_cast<int>(source.length());
+
+        glShaderSource(shaderID, 1, &sourcePointer, &sourceLength);
+        return;
+    };
+
+
+    const std::size_t versionStart = source.find("#version");
+    const std::size_t versionEnd = versionStart != std::string_view::npos ? source.find('\n', versionStart) : std::string_view::npos;
+
+    const std::size_t splitIndex = versionEnd != std::string_view::npos ? versionEnd + 1 : (versionStart != std::string_view::npos ? source.size() : 0);
+
+    const std::string_view head = source.substr(0, splitIndex);
+    const std::string_view tail = source.substr(splitIndex);
+
+    // The #line directive keeps error messages pointing at the file's own lines
+    std::string defineBlock = splitIndex == source.size() ? std::string("\n") : std::string();
+
+    defineBlock.append(GetShaderDefineBlock(defines));
+    defineBlock.append("#line ").append(std::to_string(std::count(head.cbegin(), head.cend(), '\n') + 1)).append("\n");
+
+    const char* sourcePointers[] = { head.data(), defineBlock.data(), tail.data() };
+    const int sourceLengths[] = { static_cast<int>(head.size()), static_cast<int>(defineBlock.size()), static_cast<int>(tail.size()) };
+
+    glShaderSource(shaderID, 3, sourcePointers, sourceLengths);
+};
 
 
 /// <summary>
@@ -21,6 +158,8 @@
 /// </summary>
 class ShaderProgram
 {
+    friend class ShaderStage;
+
 private:
 
     /// <summary>
@@ -28,50 +167,389 @@ private:
     /// </summary>
     mutable std::unordered_map<std::string, std::uint32_t> _uniformLocations;
 
+    /// <summary>
+    /// Every storage block layout that was queried, reflected once per link
+    /// </summary>
+    mutable std::unordered_map<std::string, ReflectedSSBOLayout> _storageBlockLayouts;
+
     /// <summary>
     /// An identifier used by the API
     /// </summary>
     std::uint32_t _programID { 0 };
 
 
+    /// <summary>
+    /// (Async mode) The shaders of a program that the driver is still compiling and linking, 0 once the program is ready
+    /// </summary>
+    mutable std::uint32_t _pendingVertexShaderID = 0;
+
+    mutable std::uint32_t _pendingFragmentShaderID = 0;
+
+    /// <summary>
+    /// (Async mode) Where to store the program's binary once it's ready, empty if the program isn't cached
+    /// </summary>
+    std::filesystem::path _pendingCachePath;
+
+
+    /// <summary>
+    /// The location of every handle returned by GetUniformHandle, indexed by UniformHandle::Index
+    /// </summary>
+    mutable std::vector<std::int32_t> _handleLocations;
+
+    /// <summary>
+    /// The name of every resolved handle, used to resolve them again after a reload
+    /// </summary>
+    mutable std::vector<std::string> _handleNames;
+
+
+    std::string _vertexShaderPath;
+
+    std::string _fragmentShaderPath;
+
+    /// <summary>
+    /// Macros defined at the top of both shaders, after their #version line
+    /// </summary>
+    std::vector<std::string> _defines;
+
+    /// <summary>
+    /// The files both shaders include, a change to one rebuilds the program like a change to the shaders
+    /// </summary>
+    std::vector<std::filesystem::path> _includedFiles;
+
+    bool _useBinaryCache = true;
+
+    /// <summary>
+    /// Created by FromSPIRV, the "shader paths" are modules the driver can't compile from source
+    /// </summary>
+    bool _fromSPIRV = false;
+
+
+    /// <summary>
+    /// (Hot-reload) One watcher per directory containing a shader source
+    /// </summary>
+    std::vector<std::unique_ptr<FileWatcher>> _fileWatchers;
+
+    /// <summary>
+    /// (Hot-reload) A source changed, the rebuild starts on the next Update
+    /// </summary>
+    bool _reloadRequested = false;
+
+    /// <summary>
+    /// (Hot-reload) The program being rebuilt, 0 if no rebuild is in progress.
+    /// The current program keeps being used until the new one is linked successfully
+    /// </summary>
+    std::uint32_t _reloadProgramID = 0;
+
+    std::uint32_t _reloadVertexShaderID = 0;
+
+    std::uint32_t _reloadFragmentShaderID = 0;
+
+    std::filesystem::path _reloadCachePath;
+
+
+public:
+
+    /// <summary>
+    /// Where linked program binaries are cached, relative to the working directory
+    /// </summary>
+    static constexpr std::string_view ShaderCacheDirectory = "ShaderCache";
+
+
 public:
 
 
+    /// <summary>
+    /// Create a program from a vertex and fragment shader
+    /// </summary>
+    /// <param name="vertexShaderPath"> Path to the vertex shader's source </param>
+    /// <param name="fragmentShaderPath"> Path to the fragment shader's source </param>
+    /// <param name="useBinaryCache"> If true, the linked program is stored in, and loaded from, ShaderCacheDirectory </param>
+    /// <param name="compileMode"> Whether to wait for the program to compile and link </param>
+    /// <param name="defines"> Macros to define in both shaders, e.g. the features of a ShaderVariants variant. "NAME" or "NAME VALUE" </param>
     ShaderProgram(const std::string& vertexShaderPath,
-                  const std::string& fragmentShaderPath)
+                  const std::string& fragmentShaderPath,
+                  const bool useBinaryCache = true,
+                  const ShaderCompileMode compileMode = ShaderCompileMode::Immediate,
+                  std::vector<std::string> defines = { }) :
+        _vertexShaderPath(vertexShaderPath),
+        _fragmentShaderPath(fragmentShaderPath),
+        _defines(std::move(defines)),
+        _useBinaryCache(useBinaryCache)
     {
+        const std::int64_t buildStart = wt::etw::GetTime();
+
+        // Sources built into the executable are used without touching the disk, hot reloads still read the files.
+        // Others are read straight out of the mapped files
+        const EmbeddedAsset* embeddedVertexShader = FindEmbeddedAsset(vertexShaderPath);
+        const EmbeddedAsset* embeddedFragmentShader = FindEmbeddedAsset(fragmentShaderPath);
+
+        const bool embedded = embeddedVertexShader != nullptr && embeddedFragmentShader != nullptr;
+
+        std::optional<MappedFile> vertexShaderFile;
+        std::optional<MappedFile> fragmentShaderFile;
+
+        if(embedded == false)
+        {
+            vertexShaderFile.emplace(vertexShaderPath);
+            fragmentShaderFile.emplace(fragmentShaderPath);
+        };
+
+        const ResolvedShaderSource resolvedVertexShader = ShaderIncludes.Resolve(vertexShaderPath, embedded == true ? embeddedVertexShader->GetText() : vertexShaderFile->GetText(), embedded);
+        const ResolvedShaderSource resolvedFragmentShader = ShaderIncludes.Resolve(fragmentShaderPath, embedded == true ? embeddedFragmentShader->GetText() : fragmentShaderFile->GetText(), embedded);
+
+        SetIncludedFiles(resolvedVertexShader, resolvedFragmentShader);
+
+        // The cache is keyed by the expanded sources, so changing an include misses it
+        const std::string_view vertexShaderSource = resolvedVertexShader.GetText();
+        const std::string_view fragmentShaderSource = resolvedFragmentShader.GetText();
+
+        std::filesystem::path cachePath;
+
+        if(useBinaryCache == true)
+        {
+            cachePath = GetBinaryCachePath(vertexShaderSource, fragmentShaderSource);
+
+            _programID = LoadProgramBinary(cachePath);
+
+            if(_programID != 0)
+            {
+                wt::etw::ShaderProgramBuild(_vertexShaderPath, _fragmentShaderPath, true, false, wt::etw::GetMillisecondsSince(buildStart));
+
+                Bind();
+                return;
+            };
+        };
+
+
+        // Querying a shader's status forces the driver to finish compiling it, so in async mode the checks wait for IsReady
+        const bool checkStatus = compileMode == ShaderCompileMode::Immediate;
+
         // Compile shaders
-        const std::uint32_t vertexShaderID = CompileVertexShader(vertexShaderPath);
-        const std::uint32_t fragmentShaderID = CompileFragmentShader(fragmentShaderPath);
+        const std::uint32_t vertexShaderID = CompileVertexShader(vertexShaderSource, checkStatus);
+        const std::uint32_t fragmentShaderID = CompileFragmentShader(fragmentShaderSource, checkStatus);
 
         // Link and create the GL program
-        _programID = CreateAndLinkShaderProgram(vertexShaderID, fragmentShaderID);
+        _programID = CreateAndLinkShaderProgram(vertexShaderID, fragmentShaderID, useBinaryCache, checkStatus);
+
+        if(compileMode == ShaderCompileMode::Asynchronous)
+        {
+            _pendingVertexShaderID = vertexShaderID;
+            _pendingFragmentShaderID = fragmentShaderID;
+
+            _pendingCachePath = cachePath;
+
+            wt::etw::ShaderProgramBuild(_vertexShaderPath, _fragmentShaderPath, false, true, wt::etw::GetMillisecondsSince(buildStart));
+            return;
+        };
 
         glDeleteShader(fragmentShaderID);
         glDeleteShader(vertexShaderID);
 
+        if(useBinaryCache == true)
+            StoreProgramBinary(cachePath);
+
+        wt::etw::ShaderProgramBuild(_vertexShaderPath, _fragmentShaderPath, false, false, wt::etw::GetMillisecondsSince(buildStart));
+
         Bind();
     };
 
     ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator = (const ShaderProgram&) = delete;
+
+    /// <summary>
+    /// Create a program from SPIR-V modules compiled offline, by the build, from GLSL written for it: every input, output and block explicitly bound.
+    /// The driver skips its GLSL front-end, which is where most of a compile's time and most vendors' differences are, and only runs its backend.
+    /// Only drivers that read the modules' debug names find uniforms by name, so programs built this way should stick to blocks.
+    /// The program isn't hot-reloaded, the modules only change with a build
+    /// </summary>
+    /// <param name="vertexModulePath"> Path to the vertex shader's module </param>
+    /// <param name="fragmentModulePath"> Path to the fragment shader's module </param>
+    /// <param name="specialization"> The specialization constants' values, the modules' defaults for any that aren't set </param>
+    /// <param name="useBinaryCache"> If true, the linked program is stored in, and loaded from, ShaderCacheDirectory </param>
+    static ShaderProgram FromSPIRV(const std::string& vertexModulePath,
+                                   const std::string& fragmentModulePath,
+                                   const ShaderSpecialization& specialization = { },
+                                   const bool useBinaryCache = true)
+    {
+        const std::int64_t buildStart = wt::etw::GetTime();
+
+        ShaderProgram program;
+
+        program._vertexShaderPath = vertexModulePath;
+        program._fragmentShaderPath = fragmentModulePath;
+        program._useBinaryCache = useBinaryCache;
+        program._fromSPIRV = true;
+
+        const MappedFile vertexModule = MappedFile(vertexModulePath);
+        const MappedFile fragmentModule = MappedFile(fragmentModulePath);
+
+        std::filesystem::path cachePath;
+
+        if(useBinaryCache == true)
+        {
+            cachePath = program.GetBinaryCachePath(vertexModule.GetText(), fragmentModule.GetText(), specialization.ToString());
+
+            program._programID = program.LoadProgramBinary(cachePath);
+
+            if(program._programID != 0)
+            {
+                wt::etw::ShaderProgramBuild(vertexModulePath, fragmentModulePath, true, false, wt::etw::GetMillisecondsSince(buildStart));
+
+                program.Bind();
+                return program;
+            };
+        };
+
+        const std::uint32_t vertexShaderID = LoadSPIRVShader(GL_VERTEX_SHADER, vertexModule.GetBytes(), specialization);
+        const std::uint32_t fragmentShaderID = LoadSPIRVShader(GL_FRAGMENT_SHADER, fragmentModule.GetBytes(), specialization);
+
+        program.CheckCompileStatus(vertexShaderID, "Vertex");
+        program.CheckCompileStatus(fragmentShaderID, "Fragment");
+
+        program._programID = program.CreateAndLinkShaderProgram(vertexShaderID, fragmentShaderID, useBinaryCache);
+
+        glDeleteShader(fragmentShaderID);
+        glDeleteShader(vertexShaderID);
+
+        if(useBinaryCache == true)
+            program.StoreProgramBinary(cachePath);
+
+        wt::etw::ShaderProgramBuild(vertexModulePath, fragmentModulePath, false, false, wt::etw::GetMillisecondsSince(buildStart));
+
+        program.Bind();
+        return program;
+    };
+
+    /// <summary>
+    /// Objects drawing with the program, e.g. FontSprites, refer to it, and have to be created after it's in its final place
+    /// </summary>
+    ShaderProgram(ShaderProgram&& other) noexcept :
+        _uniformLocations(std::exchange(other._uniformLocations, {})),
+        _storageBlockLayouts(std::exchange(other._storageBlockLayouts, {})),
+        _programID(std::exchange(other._programID, 0)),
+        _pendingVertexShaderID(std::exchange(other._pendingVertexShaderID, 0)),
+        _pendingFragmentShaderID(std::exchange(other._pendingFragmentShaderID, 0)),
+        _pendingCachePath(std::exchange(other._pendingCachePath, {})),
+        _handleLocations(std::exchange(other._handleLocations, {})),
+        _handleNames(std::exchange(other._handleNames, {})),
+        _vertexShaderPath(std::exchange(other._vertexShaderPath, {})),
+        _fragmentShaderPath(std::exchange(other._fragmentShaderPath, {})),
+        _defines(std::exchange(other._defines, {})),
+        _includedFiles(std::exchange(other._includedFiles, {})),
+        _useBinaryCache(other._useBinaryCache),
+        _fromSPIRV(other._fromSPIRV),
+        _fileWatchers(std::exchange(other._fileWatchers, {})),
+        _reloadRequested(std::exchange(other._reloadRequested, false)),
+        _reloadProgramID(std::exchange(other._reloadProgramID, 0)),
+        _reloadVertexShaderID(std::exchange(other._reloadVertexShaderID, 0)),
+        _reloadFragmentShaderID(std::exchange(other._reloadFragmentShaderID, 0)),
+        _reloadCachePath(std::exchange(other._reloadCachePath, {}))
+    {
+    };
+
+    ShaderProgram& operator = (ShaderProgram&& other) noexcept
+    {
+        if(this == &other)
+            return *this;
+
+        // The program being replaced is deleted like the destructor would
+        Destroy();
+
+        _uniformLocations = std::exchange(other._uniformLocations, {});
+        _storageBlockLayouts = std::exchange(other._storageBlockLayouts, {});
+        _programID = std::exchange(other._programID, 0);
+        _pendingVertexShaderID = std::exchange(other._pendingVertexShaderID, 0);
+        _pendingFragmentShaderID = std::exchange(other._pendingFragmentShaderID, 0);
+        _pendingCachePath = std::exchange(other._pendingCachePath, {});
+        _handleLocations = std::exchange(other._handleLocations, {});
+        _handleNames = std::exchange(other._handleNames, {});
+        _vertexShaderPath = std::exchange(other._vertexShaderPath, {});
+        _fragmentShaderPath = std::exchange(other._fragmentShaderPath, {});
+        _defines = std::exchange(other._defines, {});
+        _includedFiles = std::exchange(other._includedFiles, {});
+        _useBinaryCache = other._useBinaryCache;
+        _fromSPIRV = other._fromSPIRV;
+        _fileWatchers = std::exchange(other._fileWatchers, {});
+        _reloadRequested = std::exchange(other._reloadRequested, false);
+        _reloadProgramID = std::exchange(other._reloadProgramID, 0);
+        _reloadVertexShaderID = std::exchange(other._reloadVertexShaderID, 0);
+        _reloadFragmentShaderID = std::exchange(other._reloadFragmentShaderID, 0);
+        _reloadCachePath = std::exchange(other._reloadCachePath, {});
+
+        return *this;
+    };
 
     ~ShaderProgram()
     {
-        if(_programID != 0)
-            glDeleteProgram(_programID);
+        Destroy();
     };
 
     void Bind() const
     {
-        glUseProgram(_programID);
+        WaitUntilReady();
+
+        GLState.UseProgram(_programID);
     };
 
 
-    void SetVector3(const std::string& name, const float value1, const float value2, const float value3) const
+    /// <summary>
+    /// (Async mode) Check, without blocking, if the driver has finished compiling and linking the program.
+    /// Without parallel compile support this blocks until the program is ready
+    /// </summary>
+    /// <returns></returns>
+    bool IsReady() const
+    {
+        if(_pendingVertexShaderID == 0)
+            return true;
+
+        if(GLExtensions.ParallelShaderCompile == true)
+        {
+            int completed = 0;
+            glGetProgramiv(_programID, GL_COMPLETION_STATUS_KHR, &completed);
+
+            if(!completed)
+                return false;
+        };
+
+        WaitUntilReady();
+
+        return true;
+    };
+
+    /// <summary>
+    /// Block until the program is compiled and linked, then check for errors
+    /// </summary>
+    void WaitUntilReady() const
     {
-        const std::uint32_t colourUniformLocation = GetUniformLocation(name);
+        if(_pendingVertexShaderID == 0)
+            return;
 
-        glUniform3f(colourUniformLocation, value1, value2, value3);
+        CheckCompileStatus(_pendingVertexShaderID, "Vertex");
+        CheckCompileStatus(_pendingFragmentShaderID, "Fragment");
+
+        CheckLinkStatus(_programID);
+
+        glDeleteShader(_pendingFragmentShaderID);
+        glDeleteShader(_pendingVertexShaderID);
+
+        _pendingVertexShaderID = 0;
+        _pendingFragmentShaderID = 0;
+
+        wt::etw::ShaderProgramReady(_programID);
+
+        if(_pendingCachePath.empty() == false)
+            StoreProgramBinary(_pendingCachePath);
+    };
+
+
+    void SetVector2(const std::string& name, const glm::vec2& vector) const
+    {
+        SetVector2(GetUniformHandle(name), vector);
+    };
+
+    void SetVector3(const std::string& name, const float value1, const float value2, const float value3) const
+    {
+        SetVector3(GetUniformHandle(name), value1, value2, value3);
     };
 
     void SetVector3(const std::string& name, const glm::vec3& vector) const
@@ -79,24 +557,29 @@ public:
         SetVector3(name, vector.x, vector.y, vector.z);
     };
 
+    void SetVector4(const std::string& name, const glm::vec4& vector) const
+    {
+        SetVector4(GetUniformHandle(name), vector);
+    };
+
     void SetFloat(const std::string& name, const float& value) const
     {
-        const std::uint32_t uniformLocation = GetUniformLocation(name);
-        glUniform1f(uniformLocation, value);
+        SetFloat(GetUniformHandle(name), value);
     };
 
     void SetMatrix4(const std::string& name, const glm::mat4& matrix) const
     {
-        const std::uint32_t uniformLocation = GetUniformLocation(name);
-
-        glUniformMatrix4fv(uniformLocation, 1, false, glm::value_ptr(matrix));
+        SetMatrix4(GetUniformHandle(name), matrix);
     };
 
     void SetInt(const std::string& name, const int value) const
     {
-        const std::uint32_t uniformLocation = GetUniformLocation(name);
+        SetInt(GetUniformHandle(name), value);
+    };
 
-        glUniform1i(uniformLocation, value);
+    void SetUInt(const std::string& name, const std::uint32_t value) const
+    {
+        SetUInt(GetUniformHandle(name), value);
     };
 
     void SetBool(const std::string& name, const bool value) const
@@ -105,6 +588,176 @@ public:
     };
 
 
+public:
+
+    // Handle setters write straight to the program, it doesn't have to be bound and no lookup is done
+
+    void SetVector2(const UniformHandle& handle, const glm::vec2& vector) const
+    {
+        glProgramUniform2f(_programID, _handleLocations[handle.Index], vector.x, vector.y);
+    };
+
+    void SetVector3(const UniformHandle& handle, const float value1, const float value2, const float value3) const
+    {
+        glProgramUniform3f(_programID, _handleLocations[handle.Index], value1, value2, value3);
+    };
+
+    void SetVector3(const UniformHandle& handle, const glm::vec3& vector) const
+    {
+        SetVector3(handle, vector.x, vector.y, vector.z);
+    };
+
+    void SetVector4(const UniformHandle& handle, const glm::vec4& vector) const
+    {
+        glProgramUniform4f(_programID, _handleLocations[handle.Index], vector.x, vector.y, vector.z, vector.w);
+    };
+
+    void SetFloat(const UniformHandle& handle, const float& value) const
+    {
+        glProgramUniform1f(_programID, _handleLocations[handle.Index], value);
+    };
+
+    void SetMatrix4(const UniformHandle& handle, const glm::mat4& matrix) const
+    {
+        glProgramUniformMatrix4fv(_programID, _handleLocations[handle.Index], 1, false, glm::value_ptr(matrix));
+    };
+
+    void SetInt(const UniformHandle& handle, const int value) const
+    {
+        glProgramUniform1i(_programID, _handleLocations[handle.Index], value);
+    };
+
+    void SetUInt(const UniformHandle& handle, const std::uint32_t value) const
+    {
+        glProgramUniform1ui(_programID, _handleLocations[handle.Index], value);
+    };
+
+    void SetBool(const UniformHandle& handle, const bool value) const
+    {
+        SetInt(handle, value);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Resolve a uniform's location once, so it can be set without a lookup
+    /// </summary>
+    /// <param name="name"> The uniform's name </param>
+    /// <returns></returns>
+    UniformHandle GetUniformHandle(const std::string& name) const
+    {
+        const auto existingHandle = std::find(_handleNames.cbegin(), _handleNames.cend(), name);
+
+        if(existingHandle != _handleNames.cend())
+        {
+            return UniformHandle
+            {
+                .Index = static_cast<std::uint32_t>(std::distance(_handleNames.cbegin(), existingHandle)),
+            };
+        };
+
+        _handleNames.emplace_back(name);
+        _handleLocations.emplace_back(static_cast<std::int32_t>(GetUniformLocation(name)));
+
+        return UniformHandle
+        {
+            .Index = static_cast<std::uint32_t>(_handleLocations.size() - 1),
+        };
+    };
+
+    /// <summary>
+    /// Resolve a uniform that only some of the program's variants declare. Unlike GetUniformHandle a missing uniform isn't an error,
+    /// setting it just does nothing, until a reload adds it
+    /// </summary>
+    UniformHandle GetOptionalUniformHandle(const std::string& name) const
+    {
+        const auto existingHandle = std::find(_handleNames.cbegin(), _handleNames.cend(), name);
+
+        if(existingHandle != _handleNames.cend())
+        {
+            return UniformHandle
+            {
+                .Index = static_cast<std::uint32_t>(std::distance(_handleNames.cbegin(), existingHandle)),
+            };
+        };
+
+        WaitUntilReady();
+
+        _handleNames.emplace_back(name);
+        _handleLocations.emplace_back(glGetUniformLocation(_programID, name.c_str()));
+
+        return UniformHandle
+        {
+            .Index = static_cast<std::uint32_t>(_handleLocations.size() - 1),
+        };
+    };
+
+
+public:
+
+    /// <summary>
+    /// Watch the shader sources, and rebuild the program whenever one of them changes. See Update
+    /// </summary>
+    void EnableHotReload()
+    {
+        if(_fileWatchers.empty() == false || _fromSPIRV == true)
+            return;
+
+        std::vector<std::filesystem::path> directories = { std::filesystem::absolute(_vertexShaderPath).parent_path(), std::filesystem::absolute(_fragmentShaderPath).parent_path() };
+
+        // Includes are usually next to the shaders, but may be anywhere
+        for(const std::filesystem::path& includedFile : _includedFiles)
+        {
+            directories.push_back(std::filesystem::absolute(includedFile).parent_path());
+        };
+
+        std::sort(directories.begin(), directories.end());
+        directories.erase(std::unique(directories.begin(), directories.end()), directories.end());
+
+        for(const std::filesystem::path& directory : directories)
+        {
+            _fileWatchers.emplace_back(std::make_unique<FileWatcher>(directory));
+        };
+    };
+
+    /// <summary>
+    /// (Hot-reload) Start rebuilding the program if a source changed, and swap in the rebuilt program once the driver is done with it.
+    /// Never blocks when parallel shader compile is supported, should be called once per frame
+    /// </summary>
+    /// <returns> True if a rebuilt program was swapped in, and what's drawn with it should be redrawn </returns>
+    bool Update()
+    {
+        const std::filesystem::path vertexShaderFilename = std::filesystem::path(_vertexShaderPath).filename();
+        const std::filesystem::path fragmentShaderFilename = std::filesystem::path(_fragmentShaderPath).filename();
+
+        for(const std::unique_ptr<FileWatcher>& fileWatcher : _fileWatchers)
+        {
+            for(const std::filesystem::path& changedFile : fileWatcher->TakeChangedFiles())
+            {
+                if(changedFile == vertexShaderFilename || changedFile == fragmentShaderFilename)
+                    _reloadRequested = true;
+
+                for(const std::filesystem::path& includedFile : _includedFiles)
+                {
+                    if(changedFile == includedFile.filename())
+                        _reloadRequested = true;
+                };
+            };
+        };
+
+
+        if(_reloadRequested == true)
+            BeginReload();
+
+        if(_reloadProgramID != 0)
+            return PollReload();
+
+        return false;
+    };
+
+
+
 public:
 
     std::uint32_t GetProgramID() const
@@ -112,48 +765,214 @@ public:
         return _programID;
     };
 
+    const std::vector<std::string>& GetDefines() const
+    {
+        return _defines;
+    };
+
+    /// <summary>
+    /// Whether the program was compiled with a macro defined, by name
+    /// </summary>
+    bool HasDefine(const std::string_view& name) const
+    {
+        return std::any_of(_defines.cbegin(), _defines.cend(), [&](const std::string& define)
+        {
+            return define == name || (define.starts_with(name) == true && define.size() > name.size() && define[name.size()] == ' ');
+        });
+    };
+
+    /// <summary>
+    /// The driver's layout of one of the program's shader storage blocks, reflected on first use.
+    /// Only valid until the program is reloaded
+    /// </summary>
+    /// <param name="blockName"> The block's name </param>
+    /// <returns> The layout, or null if the program has no such block </returns>
+    const ReflectedSSBOLayout* GetStorageBlockLayout(const std::string& blockName) const
+    {
+        const auto cachedLayout = _storageBlockLayouts.find(blockName);
+
+        if(cachedLayout != _storageBlockLayouts.end())
+            return &cachedLayout->second;
+
+        WaitUntilReady();
+
+        ReflectedSSBOLayout layout;
+
+        if(ReflectSSBOLayout(_programID, blockName, layout) == false)
+            return nullptr;
+
+        return &_storageBlockLayouts.emplace(blockName, std::move(layout)).first->second;
+    };
+
 
 private:
 
     /// <summary>
-    /// Compiles a vertex shader
+    /// An empty program, filled in by FromSPIRV
     /// </summary>
-    /// <param name="filename"> The path to the vertex shader </param>
-    /// <returns></returns>
-    std::uint32_t CompileVertexShader(const std::string& filename) const
+    ShaderProgram() = default;
+
+
+    /// <summary>
+    /// Create a shader from a SPIR-V module and specialize its "main" entry point, which is when the driver compiles it
+    /// </summary>
+    static std::uint32_t LoadSPIRVShader(const GLenum shaderType, const std::span<const std::byte>& module, const ShaderSpecialization& specialization)
     {
-        const std::string vertexShaderSource = ReadAllText(filename);
+        const std::uint32_t shaderID = glCreateShader(shaderType);
 
-        std::uint32_t vertexShaderID = 0;
-        vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+        glShaderBinary(1, &shaderID, GL_SHADER_BINARY_FORMAT_SPIR_V, module.data(), static_cast<GLsizei>(module.size()));
 
-        const char* vertexShaderSourcePointer = vertexShaderSource.c_str();
-        const int vertexShaderSourceLength = static_cast<int>(vertexShaderSource.length());
+        glSpecializeShader(shaderID, "main", static_cast<GLuint>(specialization.ConstantIDs.size()), specialization.ConstantIDs.data(), specialization.Values.data());
 
-        glShaderSource(vertexShaderID, 1, &vertexShaderSourcePointer, &vertexShaderSourceLength);
-        glCompileShader(vertexShaderID);
+        return shaderID;
+    };
 
 
-        // Ensure compilation is successful  
-        int success = 0;
-        glGetShaderiv(vertexShaderID, GL_COMPILE_STATUS, &success);
+    /// <summary>
+    /// Submit a rebuild of the program from the current sources
+    /// </summary>
+    void BeginReload()
+    {
+        // Editors may still be holding the file, in which case the reload is retried on the next update
+        const MappedFile vertexShaderFile = MappedFile(_vertexShaderPath, false);
+        const MappedFile fragmentShaderFile = MappedFile(_fragmentShaderPath, false);
 
-        if(!success)
+        if(vertexShaderFile.IsMapped() == false || fragmentShaderFile.IsMapped() == false)
+            return;
+
+        _reloadRequested = false;
+
+        const std::int64_t buildStart = wt::etw::GetTime();
+
+        // A newer change replaces a rebuild that's still in progress
+        DiscardReload();
+
+
+        const ResolvedShaderSource resolvedVertexShader = ShaderIncludes.Resolve(_vertexShaderPath, vertexShaderFile.GetText());
+        const ResolvedShaderSource resolvedFragmentShader = ShaderIncludes.Resolve(_fragmentShaderPath, fragmentShaderFile.GetText());
+
+        // A reload may add includes, their directories are only watched from the next EnableHotReload
+        SetIncludedFiles(resolvedVertexShader, resolvedFragmentShader);
+
+        if(_useBinaryCache == true)
+            _reloadCachePath = GetBinaryCachePath(resolvedVertexShader.GetText(), resolvedFragmentShader.GetText());
+
+        _reloadVertexShaderID = CompileVertexShader(resolvedVertexShader.GetText(), false);
+        _reloadFragmentShaderID = CompileFragmentShader(resolvedFragmentShader.GetText(), false);
+
+        _reloadProgramID = CreateAndLinkShaderProgram(_reloadVertexShaderID, _reloadFragmentShaderID, _useBinaryCache, false);
+
+        wt::etw::ShaderProgramBuild(_vertexShaderPath, _fragmentShaderPath, false, true, wt::etw::GetMillisecondsSince(buildStart));
+    };
+
+    /// <summary>
+    /// Swap in the rebuilt program if the driver is done with it. A broken rebuild is reported and the current program is kept
+    /// </summary>
+    /// <returns> True if the program was replaced </returns>
+    bool PollReload()
+    {
+        if(GLExtensions.ParallelShaderCompile == true)
         {
-            int bufferLength = 0;
-            glGetShaderiv(vertexShaderID, GL_INFO_LOG_LENGTH, &bufferLength);
+            int completed = 0;
+            glGetProgramiv(_reloadProgramID, GL_COMPLETION_STATUS_KHR, &completed);
 
-            std::string error;
-            error.resize(bufferLength);
+            if(!completed)
+                return false;
+        };
+
+
+        const bool success = CheckCompileStatus(_reloadVertexShaderID, "Vertex", false) &&
+                             CheckCompileStatus(_reloadFragmentShaderID, "Fragment", false) &&
+                             CheckLinkStatus(_reloadProgramID, false);
+
+        if(success == false)
+        {
+            DiscardReload();
+            return false;
+        };
+
+
+        // Make sure the old program is done before it's replaced
+        WaitUntilReady();
+
+        GLState.DeleteProgram(_programID);
+
+        _programID = std::exchange(_reloadProgramID, 0);
 
-            glGetShaderInfoLog(vertexShaderID, bufferLength, &bufferLength, error.data());
+        DiscardReload();
 
 
-            std::cerr << "Vertex shader compilation error:\n" << error << "\n";
+        // Locations may have moved, handles are resolved again so their users don't notice the swap
+        _uniformLocations.clear();
+        _storageBlockLayouts.clear();
 
-            __debugbreak();
+        for(std::size_t index = 0; index < _handleNames.size(); ++index)
+        {
+            _handleLocations[index] = glGetUniformLocation(_programID, _handleNames[index].c_str());
+        };
+
+        if(_useBinaryCache == true)
+            StoreProgramBinary(_reloadCachePath);
+
+        wt::etw::ShaderProgramReady(_programID);
+
+        std::cerr << "Reloaded shader program \"" << _vertexShaderPath << "\", \"" << _fragmentShaderPath << "\"\n";
+
+        return true;
+    };
+
+    /// <summary>
+    /// Delete the program and any shaders still compiling
+    /// </summary>
+    void Destroy()
+    {
+        if(_pendingVertexShaderID != 0)
+        {
+            glDeleteShader(_pendingFragmentShaderID);
+            glDeleteShader(_pendingVertexShaderID);
         };
 
+        DiscardReload();
+
+        if(_programID != 0)
+            GLState.DeleteProgram(_programID);
+    };
+
+    /// <summary>
+    /// Delete the objects of a rebuild in progress
+    /// </summary>
+    void DiscardReload()
+    {
+        if(_reloadVertexShaderID != 0)
+            glDeleteShader(std::exchange(_reloadVertexShaderID, 0));
+
+        if(_reloadFragmentShaderID != 0)
+            glDeleteShader(std::exchange(_reloadFragmentShaderID, 0));
+
+        if(_reloadProgramID != 0)
+            GLState.DeleteProgram(std::exchange(_reloadProgramID, 0));
+    };
+
+
+    /// <summary>
+    /// Compiles a vertex shader
+    /// </summary>
+    /// <param name="vertexShaderSource"> The vertex shader's source </param>
+    /// <param name="checkStatus"> If true, wait for the compilation and check for errors </param>
+    /// <returns></returns>
+    std::uint32_t CompileVertexShader(const std::string_view& vertexShaderSource, const bool checkStatus = true) const
+    {
+        TEXT_RENDERER_ZONE("Shader compile");
+
+        std::uint32_t vertexShaderID = 0;
+        vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+
+        SetShaderSource(vertexShaderID, vertexShaderSource);
+        glCompileShader(vertexShaderID);
+
+        if(checkStatus == true)
+            CheckCompileStatus(vertexShaderID, "Vertex");
+
         return vertexShaderID;
     };
 
@@ -161,43 +980,73 @@ private:
     /// <summary>
     /// Compiles a fragment shader
     /// </summary>
-    /// <param name="filename"> The path to the vertex shader </param>
+    /// <param name="fragmentShaderSource"> The fragment shader's source </param>
+    /// <param name="checkStatus"> If true, wait for the compilation and check for errors </param>
     /// <returns></returns>
-    std::uint32_t CompileFragmentShader(const std::string& filename) const
+    std::uint32_t CompileFragmentShader(const std::string_view& fragmentShaderSource, const bool checkStatus = true) const
     {
-        const std::string fragmentShaderSource = ReadAllText(filename);
+        TEXT_RENDERER_ZONE("Shader compile");
 
         std::uint32_t fragmentShaderID = 0;
         fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
 
-        const char* fragmentShaderSourcePointer = fragmentShaderSource.c_str();
-        const int fragmentShaderSourceLength = static_cast<int>(fragmentShaderSource.length());
-
-        glShaderSource(fragmentShaderID, 1, &fragmentShaderSourcePointer, &fragmentShaderSourceLength);
+        SetShaderSource(fragmentShaderID, fragmentShaderSource);
         glCompileShader(fragmentShaderID);
 
+        if(checkStatus == true)
+            CheckCompileStatus(fragmentShaderID, "Fragment");
 
-        // Ensure compilation is successful  
-        int success = 0;
-        glGetShaderiv(fragmentShaderID, GL_COMPILE_STATUS, &success);
+        return fragmentShaderID;
+    };
+
+
+    void SetIncludedFiles(const ResolvedShaderSource& vertexShader, const ResolvedShaderSource& fragmentShader)
+    {
+        _includedFiles = vertexShader.IncludedFiles;
+        _includedFiles.insert(_includedFiles.end(), fragmentShader.IncludedFiles.cbegin(), fragmentShader.IncludedFiles.cend());
+    };
+
+    void SetShaderSource(const std::uint32_t shaderID, const std::string_view& source) const
+    {
+        SetShaderSourceWithDefines(shaderID, source, _defines);
+    };
+
+    std::string GetDefineBlock() const
+    {
+        return GetShaderDefineBlock(_defines);
+    };
 
+    /// <summary>
+    /// Ensure a shader's compilation is successful
+    /// </summary>
+    /// <param name="shaderID"></param>
+    /// <param name="shaderName"> The kind of shader, used in the error message </param>
+    /// <param name="breakOnError"> If false, errors are only reported </param>
+    /// <returns> True if the shader compiled </returns>
+    bool CheckCompileStatus(const std::uint32_t shaderID, const std::string_view& shaderName, const bool breakOnError = true) const
+    {
+        int success = 0;
+        glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
 
         if(!success)
         {
             int bufferLength = 0;
-            glGetShaderiv(fragmentShaderID, GL_INFO_LOG_LENGTH, &bufferLength);
+            glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &bufferLength);
 
             std::string error;
             error.resize(bufferLength);
 
-            glGetShaderInfoLog(fragmentShaderID, bufferLength, &bufferLength, error.data());
+            glGetShaderInfoLog(shaderID, bufferLength, &bufferLength, error.data());
 
-            std::cerr << "Fragment shader compilation error:\n" << error << "\n";
+            std::cerr << shaderName << " shader compilation error:\n" << error << "\n";
 
-            __debugbreak();
+            ShaderIncludes.PrintSourceStrings(std::cerr);
+
+            if(breakOnError == true)
+                __debugbreak();
         };
 
-        return fragmentShaderID;
+        return success;
     };
 
     /// <summary>
@@ -205,16 +1054,36 @@ private:
     /// </summary>
     /// <param name="vertexShaderID"></param>
     /// <param name="fragmentShaderID"></param>
+    /// <param name="retrievable"> If true, the driver is told the program's binary will be retrieved </param>
+    /// <param name="checkStatus"> If true, wait for the link and check for errors </param>
     /// <returns></returns>
-    std::uint32_t CreateAndLinkShaderProgram(const std::uint32_t vertexShaderID, const std::uint32_t fragmentShaderID) const
+    std::uint32_t CreateAndLinkShaderProgram(const std::uint32_t vertexShaderID, const std::uint32_t fragmentShaderID, const bool retrievable = false, const bool checkStatus = true) const
     {
+        TEXT_RENDERER_ZONE("Shader link");
+
         const std::uint32_t programID = glCreateProgram();
 
+        if(retrievable == true)
+            glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
         glAttachShader(programID, vertexShaderID);
         glAttachShader(programID, fragmentShaderID);
         glLinkProgram(programID);
 
-        // Ensure linkage is successful
+        if(checkStatus == true)
+            CheckLinkStatus(programID);
+
+        return programID;
+    };
+
+    /// <summary>
+    /// Ensure a program's linkage is successful
+    /// </summary>
+    /// <param name="programID"></param>
+    /// <param name="breakOnError"> If false, errors are only reported </param>
+    /// <returns> True if the program linked </returns>
+    bool CheckLinkStatus(const std::uint32_t programID, const bool breakOnError = true) const
+    {
         int success = 0;
         glGetProgramiv(programID, GL_LINK_STATUS, &success);
 
@@ -231,12 +1100,144 @@ private:
 
             std::cerr << "Program link error:\n" << error << "\n";
 
-            __debugbreak();
+            if(breakOnError == true)
+                __debugbreak();
+        };
+
+        return success;
+    };
+
+
+    /// <summary>
+    /// The cache file of a program, named after a hash of its sources, its defines and the driver that compiled it.
+    /// Binaries are driver specific, so a driver update or a source change simply misses the cache
+    /// </summary>
+    /// <param name="vertexShaderSource"></param>
+    /// <param name="fragmentShaderSource"></param>
+    /// <param name="specialization"> (SPIR-V) The specialization constants' values, see ShaderSpecialization::ToString </param>
+    /// <returns></returns>
+    std::filesystem::path GetBinaryCachePath(const std::string_view& vertexShaderSource, const std::string_view& fragmentShaderSource, const std::string_view& specialization = { }) const
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+
+        const auto hashText = [&hash](const std::string_view& text)
+        {
+            // FNV-1a, the text is separated from the next one so "ab" + "c" and "a" + "bc" don't collide
+            for(const char character : text)
+            {
+                hash ^= static_cast<std::uint8_t>(character);
+                hash *= 1099511628211ull;
+            };
+
+            hash ^= 0xff;
+            hash *= 1099511628211ull;
+        };
+
+        hashText(vertexShaderSource);
+        hashText(fragmentShaderSource);
+
+        // Every variant of the same sources is cached separately
+        hashText(GetDefineBlock());
+        hashText(specialization);
+
+        hashText(reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+        hashText(reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+        hashText(reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+
+        char hashText16[17] {};
+        std::snprintf(hashText16, sizeof(hashText16), "%016llx", static_cast<unsigned long long>(hash));
+
+        return std::filesystem::path(ShaderCacheDirectory) / std::string(hashText16).append(".bin");
+    };
+
+    /// <summary>
+    /// Create a program from a cached binary
+    /// </summary>
+    /// <param name="cachePath"></param>
+    /// <returns> The program's ID, or 0 if there's no usable binary </returns>
+    std::uint32_t LoadProgramBinary(const std::filesystem::path& cachePath) const
+    {
+        std::ifstream fileStream = std::ifstream(cachePath, std::ios::binary | std::ios::ate);
+
+        if(fileStream.is_open() == false)
+            return 0;
+
+        const std::size_t fileSize = static_cast<std::size_t>(fileStream.tellg());
+
+        if(fileSize <= sizeof(std::uint32_t))
+            return 0;
+
+        fileStream.seekg(std::ios::beg);
+
+
+        // The file holds the binary's format followed by the binary itself
+        std::uint32_t binaryFormat = 0;
+        fileStream.read(reinterpret_cast<char*>(&binaryFormat), sizeof(binaryFormat));
+
+        std::vector<char> binary(fileSize - sizeof(binaryFormat));
+        fileStream.read(binary.data(), static_cast<std::int64_t>(binary.size()));
+
+        if(fileStream.good() == false)
+            return 0;
+
+
+        const std::uint32_t programID = glCreateProgram();
+
+        glProgramBinary(programID, binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        // The driver is allowed to reject a binary at any time, in which case the program is simply compiled
+        int success = 0;
+        glGetProgramiv(programID, GL_LINK_STATUS, &success);
+
+        if(!success)
+        {
+            GLState.DeleteProgram(programID);
+            return 0;
         };
 
         return programID;
     };
 
+    /// <summary>
+    /// Write the linked program's binary to the cache
+    /// </summary>
+    /// <param name="cachePath"></param>
+    void StoreProgramBinary(const std::filesystem::path& cachePath) const
+    {
+        int binaryFormatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+
+        // The driver doesn't support retrieving binaries
+        if(binaryFormatCount == 0)
+            return;
+
+        int binaryLength = 0;
+        glGetProgramiv(_programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+
+        if(binaryLength <= 0)
+            return;
+
+
+        std::vector<char> binary(static_cast<std::size_t>(binaryLength));
+
+        std::uint32_t binaryFormat = 0;
+        glGetProgramBinary(_programID, binaryLength, nullptr, &binaryFormat, binary.data());
+
+
+        std::error_code error;
+        std::filesystem::create_directories(cachePath.parent_path(), error);
+
+        std::ofstream fileStream = std::ofstream(cachePath, std::ios::binary | std::ios::trunc);
+
+        // A missing cache only costs a recompile next launch, so failing to write one isn't an error
+        if(fileStream.is_open() == false)
+            return;
+
+        fileStream.write(reinterpret_cast<const char*>(&binaryFormat), sizeof(binaryFormat));
+        fileStream.write(binary.data(), static_cast<std::int64_t>(binary.size()));
+    };
+
 
     /// <summary>
     /// Find the location of a uniform
@@ -245,6 +1246,9 @@ private:
     /// <returns></returns>
     std::uint32_t GetUniformLocation(const std::string& name) const
     {
+        // Uniform locations are only known once the program is linked
+        WaitUntilReady();
+
         // Check if uniform exists in cache
         const auto result = _uniformLocations.find(name);
 
@@ -277,30 +1281,4 @@ private:
     };
 
 
-    /// <summary>
-    /// Read all text inside a file
-    /// </summary>
-    /// <param name="filename"> Path to sid file </param>
-    /// <returns></returns>
-    std::string ReadAllText(const std::string& filename) const
-    {
-        // Open the file at the end so we can easily find its length
-        std::ifstream fileStream = std::ifstream(filename, std::ios::ate);
-
-        wt::Assert(fileStream.is_open() == true, std::string("Error occured while trying open the file \"").append(filename).append("\""));
-
-        std::string fileContents;
-
-        // Resize the buffer to fit content
-        fileContents.resize(static_cast<std::size_t>(fileStream.tellg()));
-
-        fileStream.seekg(std::ios::beg);
-
-        // Read file contents into the buffer
-        fileStream.read(fileContents.data(), static_cast<std::int64_t>(fileContents.size()));
-
-        return fileContents;
-    };
-
-
 };
\ No newline at end of file
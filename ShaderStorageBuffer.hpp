@@ -1,14 +1,21 @@
 #pragma once
 
-#include <cstddef>
 #include <cstdint>
 #include <glad/glad.h>
 #include <vector>
 #include <unordered_map>
 #include <string_view>
+#include <cstddef>
+#include <utility>
 
 #include "WindowsUtilities.hpp"
 #include "ShaderProgram.hpp"
+#include "GLStateCache.hpp"
+#include "GLExtensions.hpp"
+#include "GPUMemory.hpp"
+#include "BufferUsage.hpp"
+#include "GPUBufferAllocator.hpp"
+#include "LayoutDescriptor.hpp"
 
 
 struct SSBOElement
@@ -19,12 +26,159 @@ public:
 
     std::size_t Offset = 0;
 
+    /// <summary>
+    /// The distance between consecutive elements, the struct's stride for members of an array of structs. 0 for single values
+    /// </summary>
+    std::size_t Stride = 0;
+
 
 public:
-    SSBOElement(const std::size_t offset, const std::size_t count = 1) :
+    SSBOElement(const std::size_t offset, const std::size_t count = 1, const std::size_t stride = 0) :
         Count(count),
-        Offset(offset)
+        Offset(offset),
+        Stride(stride)
+    {
+    };
+
+};
+
+
+/// <summary>
+/// How an SSBO's storage is allocated and written to
+/// </summary>
+enum class SSBOMode
+{
+    /// <summary>
+    /// Mutable storage, written with glNamedBufferSubData
+    /// </summary>
+    SubData,
+
+    /// <summary>
+    /// Immutable, persistently mapped storage split into fenced per-frame regions
+    /// </summary>
+    PersistentRing,
+
+    /// <summary>
+    /// A large virtual range with memory committed only to the pages in use, see ShaderStorageBuffer::CreateSparse
+    /// </summary>
+    Sparse,
+};
+
+
+/// <summary>
+/// What happens to a buffer's contents when it grows
+/// </summary>
+enum class BufferGrowthMode
+{
+    /// <summary>
+    /// The old contents are copied into the new buffer on the GPU
+    /// </summary>
+    Copy,
+
+    /// <summary>
+    /// The new buffer starts out undefined, for buffers whose contents are rewritten anyway. Nothing waits on the GPU
+    /// </summary>
+    Discard,
+};
+
+
+/// <summary>
+/// Buffers that were replaced while the GPU may still be reading them.
+/// Each one is deleted once the fence placed when it was retired signals, so a reallocation never has to wait for the GPU
+/// </summary>
+class DeferredBufferDeleter
+{
+
+private:
+
+    struct RetiredBuffer
+    {
+        std::uint32_t BufferID = 0;
+
+        GLsync Fence = nullptr;
+    };
+
+    std::vector<RetiredBuffer> _retiredBuffers;
+
+
+public:
+
+    DeferredBufferDeleter() = default;
+
+    DeferredBufferDeleter(const DeferredBufferDeleter&) = delete;
+    DeferredBufferDeleter& operator = (const DeferredBufferDeleter&) = delete;
+
+    DeferredBufferDeleter(DeferredBufferDeleter&& other) noexcept :
+        _retiredBuffers(std::exchange(other._retiredBuffers, {}))
+    {
+    };
+
+    DeferredBufferDeleter& operator = (DeferredBufferDeleter&& other) noexcept
+    {
+        DeleteAll();
+
+        _retiredBuffers = std::exchange(other._retiredBuffers, {});
+
+        return *this;
+    };
+
+    ~DeferredBufferDeleter()
+    {
+        DeleteAll();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Delete a buffer once every command issued so far is done with it
+    /// </summary>
+    void Retire(const std::uint32_t bufferID)
+    {
+        if(bufferID == 0)
+            return;
+
+        _retiredBuffers.push_back(RetiredBuffer
+        {
+            .BufferID = bufferID,
+            .Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+        });
+    };
+
+    /// <summary>
+    /// Delete every retired buffer whose fence has signalled, without blocking
+    /// </summary>
+    void Collect()
     {
+        std::erase_if(_retiredBuffers, [](const RetiredBuffer& retiredBuffer)
+        {
+            if(glClientWaitSync(retiredBuffer.Fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+                return false;
+
+            glDeleteSync(retiredBuffer.Fence);
+            GLState.DeleteBuffer(retiredBuffer.BufferID);
+
+            return true;
+        });
+    };
+
+    /// <summary>
+    /// Delete every retired buffer now, the driver keeps any that are still in use alive
+    /// </summary>
+    void DeleteAll()
+    {
+        for(const RetiredBuffer& retiredBuffer : _retiredBuffers)
+        {
+            glDeleteSync(retiredBuffer.Fence);
+            GLState.DeleteBuffer(retiredBuffer.BufferID);
+        };
+
+        _retiredBuffers.clear();
+    };
+
+    std::size_t GetRetiredCount() const
+    {
+        return _retiredBuffers.size();
     };
 
 };
@@ -40,7 +194,10 @@ class ShaderStorageBuffer
 
 private:
 
-    std::unordered_map<std::string, SSBOElement> _ssboElements { };
+    /// <summary>
+    /// Keyed by the hash of their name, see HashLayoutName, so lookups don't build strings and descriptors can fill it without names
+    /// </summary>
+    std::unordered_map<std::uint64_t, SSBOElement> _ssboElements { };
 
     mutable std::uint32_t _bufferID = 0;
 
@@ -48,6 +205,79 @@ private:
 
     mutable std::size_t _sizeInBytes = 0;
 
+    /// <summary>
+    /// (Sub-allocated) Where the buffer's contents start inside the allocator's buffer, 0 for buffers of their own
+    /// </summary>
+    mutable std::size_t _bufferOffset = 0;
+
+    /// <summary>
+    /// (Sub-allocated) The allocator the buffer's range came from, null if the buffer owns its GL buffer
+    /// </summary>
+    GPUBufferAllocator* _allocator = nullptr;
+
+    mutable GPUBufferRange _allocatedRange;
+
+    /// <summary>
+    /// Buffers replaced by Reallocate, deleted once the GPU is done with them
+    /// </summary>
+    mutable DeferredBufferDeleter _retiredBuffers;
+
+
+    SSBOMode _mode = SSBOMode::SubData;
+
+    /// <summary>
+    /// (Sub-data mode) How the buffer's storage is created and written, see CreateBufferStorage
+    /// </summary>
+    BufferUsage _usage = BufferUsage::RarelyUpdated;
+
+    /// <summary>
+    /// (Ring mode) A pointer to the start of the persistently mapped buffer
+    /// </summary>
+    mutable std::byte* _mappedPointer = nullptr;
+
+    /// <summary>
+    /// (Ring mode) The number of regions the buffer is split into
+    /// </summary>
+    std::uint32_t _regionCount = 0;
+
+    /// <summary>
+    /// (Ring mode) The size of a single region, aligned to GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+    /// </summary>
+    mutable std::size_t _regionSizeInBytes = 0;
+
+    /// <summary>
+    /// (Ring mode) The region the CPU is currently writing into
+    /// </summary>
+    mutable std::uint32_t _currentRegion = 0;
+
+    /// <summary>
+    /// (Ring mode) How many bytes of the current region were already handed out
+    /// </summary>
+    mutable std::size_t _regionWriteOffset = 0;
+
+    /// <summary>
+    /// (Ring mode) One fence per region, signalled when the GPU is done reading the region
+    /// </summary>
+    mutable std::vector<GLsync> _regionFences;
+
+    /// <summary>
+    /// (Ring mode) The range returned by the last call to Allocate, bound by Bind()
+    /// </summary>
+    mutable std::size_t _boundRangeOffset = 0;
+    mutable std::size_t _boundRangeSize = 0;
+
+    /// <summary>
+    /// (Sparse mode) GL_SPARSE_BUFFER_PAGE_SIZE_ARB, the granularity memory is committed in
+    /// </summary>
+    std::size_t _sparsePageSize = 0;
+
+    /// <summary>
+    /// (Sparse mode) Whether each page of the virtual range has memory committed to it
+    /// </summary>
+    std::vector<bool> _committedPages;
+
+    std::size_t _committedPageCount = 0;
+
 
 private:
 
@@ -59,9 +289,11 @@ private:
 public:
 
 
-    ShaderStorageBuffer(const std::string_view& ssboName, const ShaderProgram& shaderProgram, const std::size_t sizeInBytes, std::uint32_t bufferBindingIndex = 0) :
+    /// <param name="usage"> How the buffer is written, which picks its storage </param>
+    ShaderStorageBuffer(const std::string_view& ssboName, const ShaderProgram& shaderProgram, const std::size_t sizeInBytes, std::uint32_t bufferBindingIndex = 0, const BufferUsage usage = BufferUsage::RarelyUpdated) :
         _bufferBindingIndex(bufferBindingIndex),
-        _sizeInBytes(sizeInBytes)
+        _sizeInBytes(sizeInBytes),
+        _usage(usage)
     {
         const bool queryResult = QuerySSBOData(ssboName, shaderProgram);
 
@@ -69,10 +301,130 @@ public:
             return;
 
         glCreateBuffers(1, &_bufferID);
-        glNamedBufferData(_bufferID, sizeInBytes, nullptr, GL_DYNAMIC_COPY);
+        CreateBufferStorage(_bufferID, sizeInBytes, usage);
+
+        GPUMemory.TrackBuffer(_bufferID, sizeInBytes, GPUMemoryCategory::TextBuffer);
+
+        Bind();
+
+    };
+
+    /// <summary>
+    /// Create a buffer from a prebuilt layout, without reflecting a program's block, e.g. at startup with the program loaded from its binary cache
+    /// </summary>
+    /// <param name="layout"> The block's layout, must be valid </param>
+    ShaderStorageBuffer(const LayoutDescriptor& layout, const std::size_t sizeInBytes, std::uint32_t bufferBindingIndex = 0, const BufferUsage usage = BufferUsage::RarelyUpdated) :
+        _bufferBindingIndex(bufferBindingIndex),
+        _sizeInBytes(sizeInBytes),
+        _usage(usage)
+    {
+        const bool assertResult = wt::Assert(layout.IsValid() == true, "Invalid layout descriptor");
+
+        if(assertResult == false)
+            return;
+
+        _ssboElements.reserve(layout.GetFields().size() * 2);
+
+        for(const LayoutDescriptorField& field : layout.GetFields())
+        {
+            const SSBOElement element = SSBOElement(field.Offset, field.Count, field.Stride);
+
+            _ssboElements.insert(std::make_pair(field.NameHash, element));
+
+            // Arrays can also be found by their driver name, as in "Characters[0]"
+            if(field.Count != 1)
+                _ssboElements.insert(std::make_pair(HashLayoutName("[0]", field.NameHash), element));
+        };
+
+        glCreateBuffers(1, &_bufferID);
+        CreateBufferStorage(_bufferID, sizeInBytes, usage);
+
+        GPUMemory.TrackBuffer(_bufferID, sizeInBytes, GPUMemoryCategory::TextBuffer);
+
+        Bind();
+    };
+
+    /// <summary>
+    /// Create a buffer as a range of a shared allocator's buffer, rather than a GL buffer of its own
+    /// </summary>
+    /// <param name="allocator"> Must outlive the buffer </param>
+    ShaderStorageBuffer(const std::string_view& ssboName, const ShaderProgram& shaderProgram, const std::size_t sizeInBytes, GPUBufferAllocator& allocator, std::uint32_t bufferBindingIndex = 0) :
+        _bufferBindingIndex(bufferBindingIndex),
+        _sizeInBytes(sizeInBytes),
+        _allocator(&allocator)
+    {
+        const bool queryResult = QuerySSBOData(ssboName, shaderProgram);
+
+        if(queryResult == false)
+            return;
+
+        _allocatedRange = allocator.Allocate(sizeInBytes);
+
+        _bufferID = _allocatedRange.BufferID;
+        _bufferOffset = _allocatedRange.Offset;
 
         Bind();
+    };
+
+    /// <summary>
+    /// Create a persistently mapped ring buffer
+    /// </summary>
+    /// <param name="regionSizeInBytes"> The number of bytes that can be written per frame </param>
+    /// <param name="regionCount"> The number of frames that can be in flight before the CPU has to wait for the GPU </param>
+    /// <param name="bufferBindingIndex"> The SSBO binding point </param>
+    ShaderStorageBuffer(const std::size_t regionSizeInBytes, const std::uint32_t regionCount, std::uint32_t bufferBindingIndex = 0) :
+        _bufferBindingIndex(bufferBindingIndex),
+        _mode(SSBOMode::PersistentRing),
+        _regionCount(regionCount)
+    {
+        wt::Assert(regionCount >= 1, []()
+        {
+            return "Invalid region count";
+        });
+
+        CreateRingStorage(regionSizeInBytes);
+    };
+
+    /// <summary>
+    /// Reserve a sparse buffer, a virtual range that can be far larger than the memory it's backed by, e.g. the glyph instances of a very
+    /// large document. No memory is committed up front, see Commit and Decommit. Requires GLExtensions.SparseBuffer
+    /// </summary>
+    /// <param name="virtualSizeInBytes"> The size of the virtual range, rounded up to whole pages </param>
+    /// <param name="bufferBindingIndex"> The SSBO binding point </param>
+    static ShaderStorageBuffer CreateSparse(const std::size_t virtualSizeInBytes, std::uint32_t bufferBindingIndex = 0)
+    {
+        ShaderStorageBuffer buffer;
+
+        buffer._bufferBindingIndex = bufferBindingIndex;
+        buffer._mode = SSBOMode::Sparse;
+
+        const bool assertResult = wt::Assert(GLExtensions.SparseBuffer == true, []()
+        {
+            return "Sparse buffers aren't supported by this context";
+        });
+
+        if(assertResult == false)
+            return buffer;
+
+        GLint pageSize = 0;
+        glGetIntegerv(GL_SPARSE_BUFFER_PAGE_SIZE_ARB, &pageSize);
+
+        buffer._sparsePageSize = static_cast<std::size_t>(pageSize);
+
+        const std::size_t pageCount = (virtualSizeInBytes + buffer._sparsePageSize - 1) / buffer._sparsePageSize;
+
+        buffer._sizeInBytes = pageCount * buffer._sparsePageSize;
+        buffer._committedPages.assign(pageCount, false);
+
+        glCreateBuffers(1, &buffer._bufferID);
+        glNamedBufferStorage(buffer._bufferID, buffer._sizeInBytes, nullptr, GL_SPARSE_STORAGE_BIT_ARB | GL_DYNAMIC_STORAGE_BIT);
+
+        // Only committed pages use memory, see SetPageCommitment
+        GPUMemory.TrackBuffer(buffer._bufferID, 0, GPUMemoryCategory::TextBuffer);
 
+        buffer.Bind();
+
+        return buffer;
     };
 
     ShaderStorageBuffer(const ShaderStorageBuffer& copy) = delete;
@@ -81,8 +433,24 @@ public:
         _ssboElements(std::exchange(copy._ssboElements, {})),
         _bufferID(std::exchange(copy._bufferID, 0)),
         _bufferBindingIndex(std::exchange(copy._bufferBindingIndex, 0)),
-        _sizeInBytes(std::exchange(copy._sizeInBytes, 0))
-
+        _sizeInBytes(std::exchange(copy._sizeInBytes, 0)),
+        _bufferOffset(std::exchange(copy._bufferOffset, 0)),
+        _allocator(std::exchange(copy._allocator, nullptr)),
+        _allocatedRange(std::exchange(copy._allocatedRange, {})),
+        _retiredBuffers(std::move(copy._retiredBuffers)),
+        _mode(copy._mode),
+        _usage(copy._usage),
+        _mappedPointer(std::exchange(copy._mappedPointer, nullptr)),
+        _regionCount(std::exchange(copy._regionCount, 0)),
+        _regionSizeInBytes(std::exchange(copy._regionSizeInBytes, 0)),
+        _currentRegion(std::exchange(copy._currentRegion, 0)),
+        _regionWriteOffset(std::exchange(copy._regionWriteOffset, 0)),
+        _regionFences(std::exchange(copy._regionFences, {})),
+        _boundRangeOffset(std::exchange(copy._boundRangeOffset, 0)),
+        _boundRangeSize(std::exchange(copy._boundRangeSize, 0)),
+        _sparsePageSize(std::exchange(copy._sparsePageSize, 0)),
+        _committedPages(std::exchange(copy._committedPages, {})),
+        _committedPageCount(std::exchange(copy._committedPageCount, 0))
     {
 
     };
@@ -90,7 +458,7 @@ public:
 
     ~ShaderStorageBuffer()
     {
-        glDeleteBuffers(1, &_bufferID);
+        Destroy();
     };
 
 
@@ -98,17 +466,27 @@ public:
 
     void Bind() const
     {
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferID);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, _bufferBindingIndex, _bufferID);
+        GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferID);
+
+        // In ring mode only the most recently allocated range is visible to the shader
+        if(_mode == SSBOMode::PersistentRing)
+        {
+            if(_boundRangeSize != 0)
+                GLState.BindBufferRange(GL_SHADER_STORAGE_BUFFER, _bufferBindingIndex, _bufferID, _boundRangeOffset, _boundRangeSize);
+        }
+        else if(_allocator != nullptr)
+            GLState.BindBufferRange(GL_SHADER_STORAGE_BUFFER, _bufferBindingIndex, _bufferID, static_cast<GLintptr>(_bufferOffset), static_cast<GLsizeiptr>(_sizeInBytes));
+        else
+            GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, _bufferBindingIndex, _bufferID);
     };
 
 
     template<typename T>
     void SetValue(const std::string_view& name, const T& value) const
     {
-        const auto findResult = _ssboElements.find(name.data());
+        const auto findResult = _ssboElements.find(HashLayoutName(name));
 
-        wt::Assert(findResult != _ssboElements.end(), [&]()
+        WT_ASSERT(findResult != _ssboElements.end(), [&]()
         {
             return std::string("No such variable name \"").append(name).append("\"");
         });
@@ -119,36 +497,127 @@ public:
 
         const std::size_t& offset = ssboElement.Offset;
 
-        glNamedBufferSubData(_bufferID, offset, sizeof(T), &value);
+        glNamedBufferSubData(_bufferID, _bufferOffset + offset, sizeof(T), &value);
+    };
+
+    /// <summary>
+    /// Write a single element of an array, or of a member of an array of structs, as in SetElement("Glyphs[0].Position", 3, position)
+    /// </summary>
+    template<typename T>
+    void SetElement(const std::string_view& name, const std::size_t index, const T& value) const
+    {
+        const auto findResult = _ssboElements.find(HashLayoutName(name));
+
+        WT_ASSERT(findResult != _ssboElements.end(), [&]()
+        {
+            return std::string("No such variable name \"").append(name).append("\"");
+        });
+
+        const SSBOElement& ssboElement = findResult->second;
+
+        WT_ASSERT(ssboElement.Count == 0 || index < ssboElement.Count, [&]()
+        {
+            return std::string("Index out of range for \"").append(name).append("\"");
+        });
+
+        glNamedBufferSubData(_bufferID, _bufferOffset + ssboElement.Offset + (index * ssboElement.Stride), sizeof(T), &value);
     };
 
     template<typename T>
     void SetValue(const std::size_t offset, const T& value) const
     {
-        glNamedBufferSubData(_bufferID, offset, sizeof(T), &value);
+        glNamedBufferSubData(_bufferID, _bufferOffset + offset, sizeof(T), &value);
     };
 
 
+    /// <summary>
+    /// Write raw bytes. Streaming buffers are orphaned first when the write covers the whole buffer
+    /// </summary>
     void SetValue(const std::size_t offset, const std::size_t sizeInBytes, const void* value) const
     {
-        glNamedBufferSubData(_bufferID, offset, sizeInBytes, value);
+        if(_usage == BufferUsage::Streaming && offset == 0 && sizeInBytes >= _sizeInBytes)
+            Orphan();
+
+        glNamedBufferSubData(_bufferID, _bufferOffset + offset, sizeInBytes, value);
+    };
+
+    /// <summary>
+    /// Give the buffer fresh storage, leaving the old contents to the draws still reading them, before the whole buffer is rewritten.
+    /// The contents are undefined until then. Sub-allocated buffers share their GL buffer, so only their own range is invalidated
+    /// </summary>
+    void Orphan() const
+    {
+        if(_mode != SSBOMode::SubData)
+            return;
+
+        if(_allocator != nullptr)
+            glInvalidateBufferSubData(_bufferID, static_cast<GLintptr>(_bufferOffset), static_cast<GLsizeiptr>(_sizeInBytes));
+        else
+            glInvalidateBufferData(_bufferID);
     };
 
 
 
-    void Reallocate(const std::size_t newSizeInBytes) const
+    /// <summary>
+    /// Grow the buffer. The old buffer is retired rather than deleted, so nothing waits for the GPU to finish with it
+    /// </summary>
+    /// <param name="newSizeInBytes"> The buffer's new size </param>
+    /// <param name="growthMode"> Whether the contents are kept. Ring buffers never keep them </param>
+    void Reallocate(const std::size_t newSizeInBytes, const BufferGrowthMode growthMode = BufferGrowthMode::Copy) const
     {
+        WT_ASSERT(_mode != SSBOMode::Sparse, []()
+        {
+            return "Sparse buffers don't grow, reserve a larger virtual range instead";
+        });
+
+        _retiredBuffers.Collect();
+
+        // Ring buffers are rewritten every frame, so there's nothing to preserve.
+        // The regions in flight keep reading the old buffer, which is retired instead of waited on
+        if(_mode == SSBOMode::PersistentRing)
+        {
+            glUnmapNamedBuffer(_bufferID);
+            _mappedPointer = nullptr;
+
+            for(GLsync& fence : _regionFences)
+            {
+                if(fence != nullptr)
+                    glDeleteSync(std::exchange(fence, nullptr));
+            };
+
+            _retiredBuffers.Retire(std::exchange(_bufferID, 0));
+
+            CreateRingStorage(newSizeInBytes);
+            return;
+        };
+
+        // Sub-allocated buffers grow in place when they can, and are copied inside the allocator's buffers otherwise
+        if(_allocator != nullptr)
+        {
+            _allocator->Reallocate(_allocatedRange, newSizeInBytes);
+
+            _bufferID = _allocatedRange.BufferID;
+            _bufferOffset = _allocatedRange.Offset;
+            _sizeInBytes = newSizeInBytes;
+
+            Bind();
+            return;
+        };
+
         // Ensure that this buffer is bound as an SSBO
         Bind();
 
         std::uint32_t newBufferID = 0;
 
         glCreateBuffers(1, &newBufferID);
-        glNamedBufferData(newBufferID, newSizeInBytes, nullptr, GL_DYNAMIC_COPY);
+        CreateBufferStorage(newBufferID, newSizeInBytes, _usage);
 
-        glCopyNamedBufferSubData(_bufferID, newBufferID, 0, 0, _sizeInBytes);
+        GPUMemory.TrackBuffer(newBufferID, newSizeInBytes, GPUMemoryCategory::TextBuffer);
 
-        glDeleteBuffers(1, &_bufferID);
+        if(growthMode == BufferGrowthMode::Copy)
+            glCopyNamedBufferSubData(_bufferID, newBufferID, 0, 0, _sizeInBytes);
+
+        _retiredBuffers.Retire(_bufferID);
 
         _bufferID = newBufferID;
         _sizeInBytes = newSizeInBytes;
@@ -158,6 +627,123 @@ public:
     };
 
 
+    /// <summary>
+    /// (Ring mode) Reserve a range inside the current frame's region and return a pointer to it.
+    /// The returned range becomes the bound range on the next call to Bind()
+    /// </summary>
+    /// <param name="sizeInBytes"> The number of bytes to reserve </param>
+    /// <returns> A pointer into the mapped buffer, or nullptr if the region doesn't have enough space left </returns>
+    std::byte* Allocate(const std::size_t sizeInBytes) const
+    {
+        WT_ASSERT(_mode == SSBOMode::PersistentRing, []()
+        {
+            return "Trying to allocate a range from a non-ring buffer";
+        });
+
+        const std::size_t rangeOffset = AlignToOffset(_regionWriteOffset);
+
+        if(rangeOffset + sizeInBytes > _regionSizeInBytes)
+            return nullptr;
+
+        _regionWriteOffset = rangeOffset + sizeInBytes;
+
+        _boundRangeOffset = (static_cast<std::size_t>(_currentRegion) * _regionSizeInBytes) + rangeOffset;
+        _boundRangeSize = sizeInBytes;
+
+        return _mappedPointer + _boundRangeOffset;
+    };
+
+
+    /// <summary>
+    /// (Ring mode) Fence the current region and move on to the next one.
+    /// Should be called once per frame, after all draws reading from this buffer were issued
+    /// </summary>
+    void NextFrame() const
+    {
+        if(_mode != SSBOMode::PersistentRing)
+            return;
+
+        _regionFences[_currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        _retiredBuffers.Collect();
+
+        _currentRegion = (_currentRegion + 1) % _regionCount;
+        _regionWriteOffset = 0;
+
+        // Make sure the GPU is done reading the region we're about to overwrite
+        WaitForRegion(_currentRegion);
+    };
+
+
+    /// <summary>
+    /// (Sparse mode) Back a range with memory, e.g. once text scrolls into view or is cached. The range is widened to whole pages,
+    /// and only pages that aren't committed yet are. Committed pages start out undefined
+    /// </summary>
+    void Commit(const std::size_t offset, const std::size_t sizeInBytes)
+    {
+        WT_ASSERT(_mode == SSBOMode::Sparse, []()
+        {
+            return "Trying to commit pages of a non-sparse buffer";
+        });
+
+        WT_ASSERT(offset + sizeInBytes <= _sizeInBytes, []()
+        {
+            return "Commit out of the buffer's virtual range";
+        });
+
+        if(sizeInBytes == 0)
+            return;
+
+        const std::size_t firstPage = offset / _sparsePageSize;
+        const std::size_t endPage = (offset + sizeInBytes + _sparsePageSize - 1) / _sparsePageSize;
+
+        SetPageCommitment(firstPage, endPage, true);
+    };
+
+    /// <summary>
+    /// (Sparse mode) Release the memory behind a range, e.g. once its text was evicted. Only pages entirely inside the range are
+    /// decommitted, so neighbouring data sharing its first or last page is kept. Reads of decommitted pages return undefined values,
+    /// and writes to them are discarded
+    /// </summary>
+    void Decommit(const std::size_t offset, const std::size_t sizeInBytes)
+    {
+        WT_ASSERT(_mode == SSBOMode::Sparse, []()
+        {
+            return "Trying to decommit pages of a non-sparse buffer";
+        });
+
+        WT_ASSERT(offset + sizeInBytes <= _sizeInBytes, []()
+        {
+            return "Decommit out of the buffer's virtual range";
+        });
+
+        const std::size_t firstPage = (offset + _sparsePageSize - 1) / _sparsePageSize;
+        const std::size_t endPage = (offset + sizeInBytes) / _sparsePageSize;
+
+        if(firstPage < endPage)
+            SetPageCommitment(firstPage, endPage, false);
+    };
+
+    /// <summary>
+    /// (Sparse mode) Whether every page of a range has memory committed to it
+    /// </summary>
+    bool IsCommitted(const std::size_t offset, const std::size_t sizeInBytes) const
+    {
+        if(_mode != SSBOMode::Sparse || sizeInBytes == 0)
+            return _mode != SSBOMode::Sparse;
+
+        const std::size_t endPage = (offset + sizeInBytes + _sparsePageSize - 1) / _sparsePageSize;
+
+        for(std::size_t page = offset / _sparsePageSize; page < endPage; ++page)
+        {
+            if(_committedPages[page] == false)
+                return false;
+        };
+
+        return true;
+    };
+
+
 public:
 
     std::uint32_t GetBufferID() const
@@ -165,6 +751,61 @@ public:
         return _bufferID;
     };
 
+    /// <summary>
+    /// Where the buffer's contents start inside GetBufferID's buffer, non-zero for sub-allocated buffers
+    /// </summary>
+    std::size_t GetBufferOffset() const
+    {
+        return _bufferOffset;
+    };
+
+    /// <summary>
+    /// (Ring mode) Where the most recently allocated range starts inside GetBufferID's buffer, for ranges that are read as something other than storage
+    /// </summary>
+    std::size_t GetAllocatedRangeOffset() const
+    {
+        return _boundRangeOffset;
+    };
+
+    SSBOMode GetMode() const
+    {
+        return _mode;
+    };
+
+    BufferUsage GetUsage() const
+    {
+        return _usage;
+    };
+
+    std::size_t GetRegionSizeInBytes() const
+    {
+        return _regionSizeInBytes;
+    };
+
+    /// <summary>
+    /// (Sparse mode) The granularity Commit and Decommit work in
+    /// </summary>
+    std::size_t GetSparsePageSize() const
+    {
+        return _sparsePageSize;
+    };
+
+    /// <summary>
+    /// (Sparse mode) The memory actually backing the virtual range
+    /// </summary>
+    std::size_t GetCommittedSizeInBytes() const
+    {
+        return _committedPageCount * _sparsePageSize;
+    };
+
+    /// <summary>
+    /// The buffer's size, in sparse mode the size of the whole virtual range
+    /// </summary>
+    std::size_t GetSizeInBytes() const
+    {
+        return _sizeInBytes;
+    };
+
 
 public:
 
@@ -172,91 +813,209 @@ public:
 
     ShaderStorageBuffer& operator = (ShaderStorageBuffer&& copy) noexcept
     {
+        if(this == &copy)
+            return *this;
+
+        // The buffer being replaced is released like the destructor would, rather than leaked
+        Destroy();
+
         _ssboElements = std::exchange(copy._ssboElements, {});
         _bufferID = std::exchange(copy._bufferID, 0);
         _bufferBindingIndex = std::exchange(copy._bufferBindingIndex, 0);
         _sizeInBytes = std::exchange(copy._sizeInBytes, 0);
+        _bufferOffset = std::exchange(copy._bufferOffset, 0);
+        _allocator = std::exchange(copy._allocator, nullptr);
+        _allocatedRange = std::exchange(copy._allocatedRange, {});
+        _retiredBuffers = std::move(copy._retiredBuffers);
+        _mode = copy._mode;
+        _usage = copy._usage;
+        _mappedPointer = std::exchange(copy._mappedPointer, nullptr);
+        _regionCount = std::exchange(copy._regionCount, 0);
+        _regionSizeInBytes = std::exchange(copy._regionSizeInBytes, 0);
+        _currentRegion = std::exchange(copy._currentRegion, 0);
+        _regionWriteOffset = std::exchange(copy._regionWriteOffset, 0);
+        _regionFences = std::exchange(copy._regionFences, {});
+        _boundRangeOffset = std::exchange(copy._boundRangeOffset, 0);
+        _boundRangeSize = std::exchange(copy._boundRangeSize, 0);
+        _sparsePageSize = std::exchange(copy._sparsePageSize, 0);
+        _committedPages = std::exchange(copy._committedPages, {});
+        _committedPageCount = std::exchange(copy._committedPageCount, 0);
 
         return *this;
     };
 
 private:
 
-    bool QuerySSBOData(const std::string_view& ssboName, const ShaderProgram& shaderProgram)
+    /// <summary>
+    /// Release the buffer, or its range of the allocator's
+    /// </summary>
+    void Destroy()
     {
-        // TODO: Arrays and struct are somewhat problematic, fix in sometime in the future
+        DestroyRingStorage();
 
-        // Get SSBO index
-        GLint ssboIndex = glGetProgramResourceIndex(shaderProgram.GetProgramID(), GL_SHADER_STORAGE_BLOCK, ssboName.data());
+        if(_allocator != nullptr)
+            _allocator->Free(_allocatedRange);
+        else
+            GLState.DeleteBuffer(_bufferID);
+    };
 
+    /// <summary>
+    /// (Sparse mode) Commit or decommit the pages [firstPage, endPage), one call per run of pages that change
+    /// </summary>
+    void SetPageCommitment(const std::size_t firstPage, const std::size_t endPage, const bool commit)
+    {
+        std::size_t page = firstPage;
 
-        const bool assertResult = wt::Assert(ssboIndex != -1, [&]()
+        while(page < endPage)
         {
-            return std::string("SSBO \"").append(ssboName).append("\" was not found in prorgam \"").append(std::to_string(shaderProgram.GetProgramID()).append("\""));
-        });
+            if(_committedPages[page] == commit)
+            {
+                ++page;
+                continue;
+            };
+
+            const std::size_t runStart = page;
+
+            while(page < endPage && _committedPages[page] != commit)
+            {
+                _committedPages[page] = commit;
+                ++page;
+            };
+
+            glNamedBufferPageCommitmentARB(_bufferID, static_cast<GLintptr>(runStart * _sparsePageSize), static_cast<GLsizeiptr>((page - runStart) * _sparsePageSize), commit == true ? GL_TRUE : GL_FALSE);
+
+            if(commit == true)
+                _committedPageCount += page - runStart;
+            else
+                _committedPageCount -= page - runStart;
+        };
 
-        if(assertResult == false)
-            return false;
+        GPUMemory.TrackBuffer(_bufferID, GetCommittedSizeInBytes(), GPUMemoryCategory::TextBuffer);
+    };
+
+    /// <summary>
+    /// (Ring mode) Create immutable storage for all regions and map it persistently
+    /// </summary>
+    /// <param name="regionSizeInBytes"> The requested size of a single region </param>
+    void CreateRingStorage(const std::size_t regionSizeInBytes) const
+    {
+        _regionSizeInBytes = AlignToOffset(regionSizeInBytes);
+        _sizeInBytes = _regionSizeInBytes * _regionCount;
 
+        _currentRegion = 0;
+        _regionWriteOffset = 0;
+        _boundRangeOffset = 0;
+        _boundRangeSize = 0;
 
-        static constexpr GLenum bufferSizeProperty = GL_BUFFER_DATA_SIZE;
-        GLint bufferSize = 0;
+        _regionFences.assign(_regionCount, nullptr);
 
-        glGetProgramResourceiv(shaderProgram.GetProgramID(), GL_SHADER_STORAGE_BLOCK, ssboIndex, 1, &bufferSizeProperty, 1, nullptr, &bufferSize);
+        static constexpr GLbitfield storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glCreateBuffers(1, &_bufferID);
+        glNamedBufferStorage(_bufferID, _sizeInBytes, nullptr, storageFlags);
 
+        GPUMemory.TrackBuffer(_bufferID, _sizeInBytes, GPUMemoryCategory::TextBuffer);
 
-        // Get number of active SSBO variables
-        static constexpr GLenum numberOfActiveVariablesProperty = GL_NUM_ACTIVE_VARIABLES;
-        GLint numberOfVariables = 0;
+        _mappedPointer = static_cast<std::byte*>(glMapNamedBufferRange(_bufferID, 0, _sizeInBytes, storageFlags));
+
+        wt::Assert(_mappedPointer != nullptr, []()
+        {
+            return "Failed to map ring buffer";
+        });
+    };
+
+    /// <summary>
+    /// (Ring mode) Wait for the GPU to release every region, delete the fences and unmap the buffer
+    /// </summary>
+    void DestroyRingStorage() const
+    {
+        if(_mode != SSBOMode::PersistentRing)
+            return;
+
+        for(std::uint32_t region = 0; region < _regionFences.size(); ++region)
+        {
+            WaitForRegion(region);
+        };
 
-        glGetProgramResourceiv(shaderProgram.GetProgramID(), GL_SHADER_STORAGE_BLOCK, ssboIndex, 1, &numberOfActiveVariablesProperty, 1, nullptr, &numberOfVariables);
+        if(_mappedPointer != nullptr)
+        {
+            glUnmapNamedBuffer(_bufferID);
+            _mappedPointer = nullptr;
+        };
+    };
 
-        _ssboElements.reserve(numberOfVariables);
+    /// <summary>
+    /// (Ring mode) Block until the GPU has finished reading a region
+    /// </summary>
+    /// <param name="region"> The region's index </param>
+    void WaitForRegion(const std::uint32_t region) const
+    {
+        GLsync& fence = _regionFences[region];
 
+        if(fence == nullptr)
+            return;
 
-        // Get SSBO variable indices
-        static constexpr  GLenum activeVariablesProperty = GL_ACTIVE_VARIABLES;
-        std::vector<GLint> variableIndices = std::vector<GLint> (numberOfVariables);
+        // Only flush on the first attempt, a single flush is enough for the fence to eventually signal
+        GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
 
-        glGetProgramResourceiv(shaderProgram.GetProgramID(), GL_SHADER_STORAGE_BLOCK, ssboIndex, 1, &activeVariablesProperty, numberOfVariables, nullptr, variableIndices.data());
+        while(waitResult == GL_TIMEOUT_EXPIRED)
+        {
+            waitResult = glClientWaitSync(fence, 0, 1'000'000);
+        };
 
+        glDeleteSync(fence);
+        fence = nullptr;
+    };
 
-        // Get SSBO variable offsets
-        for(std::size_t i = 0; i < variableIndices.size(); ++i)
+    /// <summary>
+    /// Align an offset up to the implementation's required SSBO binding offset alignment
+    /// </summary>
+    /// <param name="offset"></param>
+    /// <returns></returns>
+    std::size_t AlignToOffset(const std::size_t offset) const
+    {
+        static const std::size_t offsetAlignment = []()
         {
-            static constexpr GLenum topLevelArrayPropety = GL_TOP_LEVEL_ARRAY_SIZE;
+            GLint alignment = 0;
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
 
-            int topLevelArraySize = 0;
-            glGetProgramResourceiv(shaderProgram.GetProgramID(), GL_BUFFER_VARIABLE, variableIndices[i], 1, &topLevelArrayPropety, sizeof(topLevelArraySize), nullptr, &topLevelArraySize);
+            return static_cast<std::size_t>(alignment > 0 ? alignment : 1);
+        }();
 
+        return (offset + (offsetAlignment - 1)) / offsetAlignment * offsetAlignment;
+    };
 
-            // Get SSBO variable array size
-            int arraySize = 0;
 
-            static constexpr GLenum arraySizeProperty = GL_ARRAY_SIZE;
-            glGetProgramResourceiv(shaderProgram.GetProgramID(), GL_BUFFER_VARIABLE, variableIndices[i], 1, &arraySizeProperty, sizeof(arraySize), nullptr, &arraySize);
+    bool QuerySSBOData(const std::string_view& ssboName, const ShaderProgram& shaderProgram)
+    {
+        // The program reflects each block once, so creating more buffers for the same block doesn't query the driver again
+        const ReflectedSSBOLayout* layout = shaderProgram.GetStorageBlockLayout(std::string(ssboName));
 
-            // Length of variable name 
-            int nameBufferLength = 0;
 
-            static constexpr GLenum nameLengthProperty = GL_NAME_LENGTH;
-            glGetProgramResourceiv(shaderProgram.GetProgramID(), GL_BUFFER_VARIABLE, variableIndices[i], 1, &nameLengthProperty, sizeof(nameBufferLength), nullptr, &nameBufferLength);
+        const bool assertResult = wt::Assert(layout != nullptr, [&]()
+        {
+            return std::string("SSBO \"").append(ssboName).append("\" was not found in prorgam \"").append(std::to_string(shaderProgram.GetProgramID()).append("\""));
+        });
 
-            // SSBO variable name
-            std::string name;
-            name.resize(static_cast<std::size_t>(nameBufferLength) - 1);
+        if(assertResult == false)
+            return false;
 
-            glGetProgramResourceName(shaderProgram.GetProgramID(), GL_BUFFER_VARIABLE, variableIndices[i], nameBufferLength, nullptr, name.data());
 
+        _ssboElements.reserve(layout->Variables.size() * 2);
 
-            GLint offset = 0;
+        for(const ReflectedSSBOVariable& variable : layout->Variables)
+        {
+            // Members of an array of structs are indexed by struct, everything else by its own elements
+            const bool inStructArray = variable.TopLevelArrayStride != 0 && variable.ArrayStride != variable.TopLevelArrayStride;
 
-            // SSBO variable offset
-            static constexpr GLenum offsetProperty = GL_OFFSET;
-            glGetProgramResourceiv(shaderProgram.GetProgramID(), GL_BUFFER_VARIABLE, variableIndices[i], 1, &offsetProperty, sizeof(GLint), nullptr, &offset);
+            const std::size_t count = inStructArray == true ? variable.TopLevelArraySize : variable.ArraySize;
+            const std::size_t stride = inStructArray == true ? variable.TopLevelArrayStride : variable.ArrayStride;
 
+            _ssboElements.insert(std::make_pair(HashLayoutName(variable.Name), SSBOElement(variable.Offset, count, stride)));
 
-            _ssboElements.insert(std::make_pair(name, SSBOElement(offset, arraySize)));
+            // Arrays can also be found by their plain name, as in "Characters" for "Characters[0]"
+            if(variable.Name.ends_with("[0]") == true)
+                _ssboElements.insert(std::make_pair(HashLayoutName(std::string_view(variable.Name).substr(0, variable.Name.size() - 3)), SSBOElement(variable.Offset, count, stride)));
         };
 
         return true;
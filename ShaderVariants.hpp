@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ShaderProgram.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The programs built from one pair of shaders with different features compiled in, instead of branching on them at run time.
+/// A feature is a bit of a mask, and a macro the shaders check with #ifdef. Only the variants that are asked for are compiled,
+/// each is kept for as long as the set lives and its binary is cached separately by ShaderProgram
+/// </summary>
+class ShaderVariants
+{
+
+private:
+
+    std::string _vertexShaderPath;
+    std::string _fragmentShaderPath;
+
+    /// <summary>
+    /// The macro of every feature, indexed by its bit
+    /// </summary>
+    std::vector<std::string> _featureDefines;
+
+    bool _useBinaryCache = true;
+
+    ShaderCompileMode _compileMode = ShaderCompileMode::Immediate;
+
+    bool _hotReload = false;
+
+    /// <summary>
+    /// (SPIR-V) The modules every variant is specialized from, empty to compile the GLSL sources
+    /// </summary>
+    std::string _vertexModulePath;
+    std::string _fragmentModulePath;
+
+    /// <summary>
+    /// Fonts refer to their programs, so the programs never move
+    /// </summary>
+    std::map<std::uint32_t, std::unique_ptr<ShaderProgram>> _variants;
+
+
+public:
+
+    /// <param name="vertexShaderPath"> Path to the vertex shader's source </param>
+    /// <param name="fragmentShaderPath"> Path to the fragment shader's source </param>
+    /// <param name="featureDefines"> The macro each feature bit defines, the first is bit 0 </param>
+    /// <param name="useBinaryCache"> If true, each variant's linked program is cached, see ShaderProgram </param>
+    /// <param name="compileMode"> Whether Get waits for a new variant to compile and link </param>
+    ShaderVariants(std::string vertexShaderPath,
+                   std::string fragmentShaderPath,
+                   std::vector<std::string> featureDefines,
+                   const bool useBinaryCache = true,
+                   const ShaderCompileMode compileMode = ShaderCompileMode::Immediate) :
+        _vertexShaderPath(std::move(vertexShaderPath)),
+        _fragmentShaderPath(std::move(fragmentShaderPath)),
+        _featureDefines(std::move(featureDefines)),
+        _useBinaryCache(useBinaryCache),
+        _compileMode(compileMode)
+    {
+        wt::Assert(_featureDefines.size() <= 32, "Features are bits of a 32-bit mask");
+    };
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator = (const ShaderVariants&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Get the variant with a set of features, compiling it the first time it's asked for
+    /// </summary>
+    /// <param name="features"> A bit per feature, in the order of the constructor's featureDefines </param>
+    const ShaderProgram& Get(const std::uint32_t features)
+    {
+        wt::Assert(_featureDefines.size() == 32 || (features >> _featureDefines.size()) == 0, "A feature bit has no define");
+
+        std::unique_ptr<ShaderProgram>& variant = _variants[features];
+
+        if(variant != nullptr)
+            return *variant;
+
+
+        if(_vertexModulePath.empty() == false)
+            variant = std::make_unique<ShaderProgram>(ShaderProgram::FromSPIRV(_vertexModulePath, _fragmentModulePath, GetSpecialization(features), _useBinaryCache));
+        else
+            variant = std::make_unique<ShaderProgram>(_vertexShaderPath, _fragmentShaderPath, _useBinaryCache, _compileMode, GetDefines(features));
+
+        if(_hotReload == true)
+            variant->EnableHotReload();
+
+        return *variant;
+    };
+
+    /// <summary>
+    /// Build variants from SPIR-V modules compiled offline from the sources, instead of the sources.
+    /// The sources have to declare each feature as "layout(constant_id = BIT) const bool", and check it with if instead of #ifdef,
+    /// the driver's backend folds away the branches of every constant. SPIR-V variants aren't hot-reloaded
+    /// </summary>
+    void SetSPIRVModules(std::string vertexModulePath, std::string fragmentModulePath)
+    {
+        wt::Assert(_variants.empty() == true, "Set the modules before the first variant is built");
+
+        _vertexModulePath = std::move(vertexModulePath);
+        _fragmentModulePath = std::move(fragmentModulePath);
+    };
+
+    /// <summary>
+    /// Start compiling variants ahead of their first use, e.g. at load time in asynchronous mode
+    /// </summary>
+    void Preload(const std::vector<std::uint32_t>& featureSets)
+    {
+        for(const std::uint32_t features : featureSets)
+        {
+            Get(features);
+        };
+    };
+
+
+    /// <summary>
+    /// Rebuild every variant whenever a source changes, including variants compiled later
+    /// </summary>
+    void EnableHotReload()
+    {
+        _hotReload = true;
+
+        for(auto& [features, variant] : _variants)
+        {
+            variant->EnableHotReload();
+        };
+    };
+
+    /// <summary>
+    /// (Hot-reload) Update every variant, see ShaderProgram::Update
+    /// </summary>
+    /// <returns> True if any variant was rebuilt </returns>
+    bool Update()
+    {
+        bool reloaded = false;
+
+        for(auto& [features, variant] : _variants)
+        {
+            if(variant->Update() == true)
+                reloaded = true;
+        };
+
+        return reloaded;
+    };
+
+
+public:
+
+    /// <summary>
+    /// The macros a set of features defines
+    /// </summary>
+    std::vector<std::string> GetDefines(const std::uint32_t features) const
+    {
+        std::vector<std::string> defines;
+
+        for(std::size_t bit = 0; bit < _featureDefines.size(); ++bit)
+        {
+            if((features & (1u << bit)) != 0)
+                defines.emplace_back(_featureDefines[bit]);
+        };
+
+        return defines;
+    };
+
+    /// <summary>
+    /// (SPIR-V) The specialization constants a set of features sets, a bool per feature with its bit as the constant's ID
+    /// </summary>
+    ShaderSpecialization GetSpecialization(const std::uint32_t features) const
+    {
+        ShaderSpecialization specialization;
+
+        for(std::size_t bit = 0; bit < _featureDefines.size(); ++bit)
+        {
+            specialization.Set(static_cast<std::uint32_t>(bit), (features & (1u << bit)) != 0 ? 1u : 0u);
+        };
+
+        return specialization;
+    };
+
+    /// <summary>
+    /// The number of variants compiled so far
+    /// </summary>
+    std::size_t GetVariantCount() const
+    {
+        return _variants.size();
+    };
+
+};
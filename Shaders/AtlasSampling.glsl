@@ -0,0 +1,46 @@
+// Included by the bitmap FontSprite fragment shaders, after their "Texutre" sampler. SampleAtlas reads the atlas under the fragment,
+// offset by a distance in texture coordinates, e.g. the bold offset
+
+#ifdef PIXEL_SNAPPED
+
+// The fragment's position in the atlas, in texels. The vertex shader put the glyph's top-left corner on a pixel corner, see FontShaderFeature::PixelSnap
+in vec2 VertexShaderTexelCoordinateOutput;
+
+// Text drawn at the atlas' own size lands every pixel centre on a texel centre, so the texel is fetched exactly, without filtering or rounded texture coordinates
+vec4 SampleAtlas(const vec2 offset)
+{
+    return texelFetch(Texutre, ivec2(floor(VertexShaderTexelCoordinateOutput - (offset * vec2(textureSize(Texutre, 0))))), 0);
+};
+
+#else
+
+vec4 SampleAtlas(const vec2 offset)
+{
+    return texture(Texutre, VertexShaderTextureCoordinateOutput - offset);
+};
+
+#endif
+
+
+// The style bit the vertex shader sets on the missing glyph, which characters the atlas has no glyph for are drawn as
+const uint GlyphStyleMissing = 0x20u;
+
+bool IsMissingGlyph()
+{
+    return (VertexShaderGlyphStyleOutput & GlyphStyleMissing) != 0;
+};
+
+// The missing glyph's coverage: a hollow box, "tofu", inset from the glyph's quad and about a pixel thick at any scale,
+// so a character the font can't draw stands out rather than passing for a real '?'
+float GetMissingGlyphCoverage()
+{
+    const vec2 coordinate = VertexShaderGlyphCoordinateOutput;
+    const vec2 thickness = fwidth(coordinate);
+
+    const vec2 inset = vec2(0.15f, 0.1f);
+
+    const bool inside = all(greaterThanEqual(coordinate, inset)) && all(lessThanEqual(coordinate, vec2(1.0f) - inset));
+    const bool interior = all(greaterThanEqual(coordinate, inset + thickness)) && all(lessThanEqual(coordinate, vec2(1.0f) - inset - thickness));
+
+    return inside == true && interior == false ? 1.0f : 0.0f;
+};
\ No newline at end of file
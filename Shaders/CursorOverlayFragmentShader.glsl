@@ -0,0 +1,13 @@
+#version 460 core
+
+
+layout(location = 0) flat in vec4 VertexShaderColourOutput;
+
+out vec4 OutputColour;
+
+
+
+void main()
+{
+    OutputColour = VertexShaderColourOutput;
+};
\ No newline at end of file
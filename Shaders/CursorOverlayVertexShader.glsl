@@ -0,0 +1,51 @@
+#version 460 core
+
+struct CursorQuad
+{
+    // The top-left corner of the rectangle, in screen space
+    vec2 Position;
+
+    vec2 Size;
+
+    vec4 Colour;
+};
+
+
+layout(std430, binding = 0) readonly buffer CursorQuads
+{
+    CursorQuad Quads[];
+};
+
+// Shared by every draw in a frame, see FrameUniformBuffer.hpp
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 Projection;
+    mat4 View;
+
+    vec2 ViewportSize;
+    float Time;
+};
+
+
+
+// Linked as a separable stage, which needs its built-in outputs declared
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+// Matched to the fragment stage by location, the stages are linked separately
+layout(location = 0) flat out vec4 VertexShaderColourOutput;
+
+
+void main()
+{
+    const CursorQuad quad = Quads[gl_InstanceID];
+
+    // The quad's corner, drawn as a triangle strip: (0, 0), (1, 0), (0, 1), (1, 1)
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    VertexShaderColourOutput = quad.Colour;
+
+    gl_Position = Projection * View * vec4(quad.Position + (corner * quad.Size), 0.0f, 1.0f);
+};
\ No newline at end of file
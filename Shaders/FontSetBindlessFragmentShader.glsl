@@ -0,0 +1,73 @@
+#version 460 core
+#extension GL_ARB_bindless_texture : require
+
+
+in vec2 VertexShaderTextureCoordinateOutput;
+in vec4 VertexShaderTextColourOutput;
+flat in uint VertexShaderLayerOutput;
+in vec2 VertexShaderGlyphCoordinateOutput;
+flat in uint VertexShaderGlyphStyleOutput;
+flat in vec4 VertexShaderTextureRectOutput;
+// (Picking) The glyph's run and its index in the run
+flat in uvec2 VertexShaderPickOutput;
+
+// A coverage atlas per font, see FontSet.hpp
+layout(std430, binding = 7) readonly buffer FontTextureHandles
+{
+    sampler2D FontTextures[];
+};
+
+layout(location = 0) out vec4 OutputColour;
+
+// (Picking) Only a TextPickingBuffer has a draw buffer at location 1, other targets drop it
+layout(location = 1) out uvec2 PickOutput;
+
+uniform bool TextPicking = false;
+
+// GlyphStyle bits, see TextStyle.hpp
+const uint GlyphStyleUnderline = 1u << 0;
+const uint GlyphStyleStrikethrough = 1u << 1;
+
+
+// The style's underline or strikethrough, about a pixel and a half thick at any scale. A decorated glyph's quad is its cell, see TextBatchVertexShader.glsl
+float GetDecorationCoverage()
+{
+    const float y = VertexShaderGlyphCoordinateOutput.y;
+    const float thickness = fwidth(y) * 1.5f;
+
+    const bool underline = (VertexShaderGlyphStyleOutput & GlyphStyleUnderline) != 0u && y >= 1.0f - thickness;
+    const bool strikethrough = (VertexShaderGlyphStyleOutput & GlyphStyleStrikethrough) != 0u && abs(y - 0.55f) <= thickness * 0.5f;
+
+    return underline == true || strikethrough == true ? 1.0f : 0.0f;
+};
+
+// Whether the fragment is on the glyph's bitmap, rather than on the part of its cell a decoration stretched the quad over
+bool IsInsideGlyph()
+{
+    return all(greaterThanEqual(VertexShaderTextureCoordinateOutput, VertexShaderTextureRectOutput.xy)) &&
+           all(lessThanEqual(VertexShaderTextureCoordinateOutput, VertexShaderTextureRectOutput.zw));
+};
+
+// (Picking) Only the pixels a glyph visibly covers are its, the rest of its quad doesn't catch picks. See TextPicking.hpp
+void WritePick(const float coverage)
+{
+    if(TextPicking == true && coverage < 0.5f)
+        discard;
+
+    PickOutput = VertexShaderPickOutput;
+};
+
+
+
+void main()
+{
+    // Flat, so a glyph's quad always samples a single font
+    const sampler2D fontTexture = FontTextures[VertexShaderLayerOutput];
+
+    const float coverage = max(IsInsideGlyph() == true ? texture(fontTexture, VertexShaderTextureCoordinateOutput).r : 0.0f, GetDecorationCoverage());
+
+    WritePick(coverage);
+
+    // Nothing is discarded, uncovered pixels are simply blended away
+    OutputColour = vec4(VertexShaderTextColourOutput.rgb, VertexShaderTextColourOutput.a * coverage);
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+#version 460 core
+
+
+in vec2 VertexShaderTextureCoordinateOutput;
+in vec4 VertexShaderTextColourOutput;
+in vec2 VertexShaderGlyphCoordinateOutput;
+flat in uint VertexShaderGlyphStyleOutput;
+
+// A single-channel coverage atlas, see AtlasFormat::Coverage
+uniform sampler2D Texutre;
+
+out vec4 OutputColour;
+
+#include "OverdrawHeatmap.glsl"
+#include "TextBlending.glsl"
+#include "AtlasSampling.glsl"
+
+
+#ifdef STYLED_TEXT
+
+// GlyphStyle bits, see TextStyle.hpp
+const uint GlyphStyleUnderline = 1u << 0;
+const uint GlyphStyleStrikethrough = 1u << 1;
+const uint GlyphStyleBold = 1u << 2;
+
+// Set by the layout pass on a span's background instances, see TextLayoutComputeShader.glsl
+const uint GlyphStyleBackground = 0x40u;
+
+
+// Whether the pixel is filled by a background, or covered by the style's underline or strikethrough, which are about a pixel and a half thick at any scale
+bool IsDecoration()
+{
+    const float y = VertexShaderGlyphCoordinateOutput.y;
+    const float thickness = fwidth(y) * 1.5f;
+
+    const bool underline = (VertexShaderGlyphStyleOutput & GlyphStyleUnderline) != 0 && y >= 1.0f - thickness;
+    const bool strikethrough = (VertexShaderGlyphStyleOutput & GlyphStyleStrikethrough) != 0 && abs(y - 0.55f) <= thickness * 0.5f;
+
+    // Backgrounds are filled just like decorations
+    const bool background = (VertexShaderGlyphStyleOutput & GlyphStyleBackground) != 0;
+
+    return underline == true || strikethrough == true || background == true;
+};
+
+// Bold glyphs are also sampled a texel to the left, which thickens every stem by a texel
+vec2 GetBoldOffset()
+{
+    return (VertexShaderGlyphStyleOutput & GlyphStyleBold) != 0 ? vec2(1.0f / float(textureSize(Texutre, 0).x), 0.0f) : vec2(0.0f);
+};
+
+#else
+
+// Unstyled variants have no decorations or bold, so the checks and the bold sample fold away
+bool IsDecoration()
+{
+    return false;
+};
+
+vec2 GetBoldOffset()
+{
+    return vec2(0.0f);
+};
+
+#endif
+
+
+
+void main()
+{
+    #ifdef OVERDRAW_HEATMAP
+    OutputColour = OverdrawHeat;
+    return;
+    #endif
+
+    const vec2 boldOffset = GetBoldOffset();
+
+    float coverage = ApplyContrast(max(SampleAtlas(vec2(0.0f)).r, SampleAtlas(boldOffset).r));
+
+    if(IsMissingGlyph() == true)
+        coverage = GetMissingGlyphCoverage();
+
+    if(IsDecoration() == true)
+        coverage = 1.0f;
+
+    // Nothing is discarded, uncovered pixels are simply blended away
+    OutputColour = ToBlendedOutput(vec4(VertexShaderTextColourOutput.rgb, VertexShaderTextColourOutput.a * coverage));
+};
\ No newline at end of file
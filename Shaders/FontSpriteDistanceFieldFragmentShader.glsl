@@ -0,0 +1,176 @@
+#version 460 core
+
+
+in vec2 VertexShaderTextureCoordinateOutput;
+in vec4 VertexShaderTextColourOutput;
+in vec2 VertexShaderGlyphCoordinateOutput;
+flat in uint VertexShaderGlyphStyleOutput;
+
+// A single-channel signed distance field, see AtlasFormat::DistanceField. 0.5 is the glyph's edge, higher is inside
+uniform sampler2D Texutre;
+
+#ifdef TEXT_EFFECTS
+flat in vec4 VertexShaderTextureRectOutput;
+flat in vec2 VertexShaderTexturePerPixelOutput;
+
+// The distance the outline's outer edge is at, 0.5 is the glyph's own edge so there's no outline. See FontSprite::UploadTextEffects
+uniform float OutlineDistance = 0.5f;
+uniform vec4 OutlineColour = vec4(0.0f);
+
+// In the font's pixels
+uniform vec2 ShadowOffset = vec2(0.0f);
+
+// How much wider the shadow's smoothed edge is than the glyph's, in distance
+uniform float ShadowSoftness = 0.0f;
+
+// Transparent for no shadow
+uniform vec4 ShadowColour = vec4(0.0f);
+#endif
+
+#ifdef SUPERSAMPLE
+// Whether edges are sampled at four points across the pixel, see FontSprite::Supersample. Off on heavy frames
+uniform bool Supersample = true;
+#endif
+
+out vec4 OutputColour;
+
+#include "OverdrawHeatmap.glsl"
+#include "TextBlending.glsl"
+
+
+#ifdef STYLED_TEXT
+
+// GlyphStyle bits, see TextStyle.hpp
+const uint GlyphStyleUnderline = 1u << 0;
+const uint GlyphStyleStrikethrough = 1u << 1;
+const uint GlyphStyleBold = 1u << 2;
+
+// Set by the layout pass on a span's background instances, see TextLayoutComputeShader.glsl
+const uint GlyphStyleBackground = 0x40u;
+
+
+// Whether the pixel is filled by a background, or covered by the style's underline or strikethrough, which are about a pixel and a half thick at any scale
+bool IsDecoration()
+{
+    const float y = VertexShaderGlyphCoordinateOutput.y;
+    const float thickness = fwidth(y) * 1.5f;
+
+    // Quads grown for the text's effects reach below the glyph, the underline stays at its bottom
+    const bool underline = (VertexShaderGlyphStyleOutput & GlyphStyleUnderline) != 0 && y >= 1.0f - thickness && y <= 1.0f;
+    const bool strikethrough = (VertexShaderGlyphStyleOutput & GlyphStyleStrikethrough) != 0 && abs(y - 0.55f) <= thickness * 0.5f;
+
+    // Backgrounds are filled just like decorations
+    const bool background = (VertexShaderGlyphStyleOutput & GlyphStyleBackground) != 0;
+
+    return underline == true || strikethrough == true || background == true;
+};
+
+// Bold glyphs are also sampled a texel to the left, which thickens every stem by a texel
+vec2 GetBoldOffset()
+{
+    return (VertexShaderGlyphStyleOutput & GlyphStyleBold) != 0 ? vec2(1.0f / float(textureSize(Texutre, 0).x), 0.0f) : vec2(0.0f);
+};
+
+#else
+
+// Unstyled variants have no decorations or bold, so the checks and the bold sample fold away
+bool IsDecoration()
+{
+    return false;
+};
+
+vec2 GetBoldOffset()
+{
+    return vec2(0.0f);
+};
+
+#endif
+
+
+
+// Explicit gradients, the supersamples are taken in a non-uniform branch where implicit ones aren't defined
+float SampleAtlas(const vec2 textureCoordinate, const vec2 dx, const vec2 dy)
+{
+    #ifdef TEXT_EFFECTS
+    // Grown quads reach past the glyph's rectangle, the atlas' other glyphs mustn't show through. Past the rectangle is as far outside as the field goes
+    const vec2 rectMinimum = min(VertexShaderTextureRectOutput.xy, VertexShaderTextureRectOutput.zw);
+    const vec2 rectMaximum = max(VertexShaderTextureRectOutput.xy, VertexShaderTextureRectOutput.zw);
+
+    if(any(lessThan(textureCoordinate, rectMinimum)) || any(greaterThan(textureCoordinate, rectMaximum)))
+        return 0.0f;
+    #endif
+
+    return textureGrad(Texutre, textureCoordinate, dx, dy).r;
+};
+
+float SampleDistance(const vec2 textureCoordinate, const vec2 boldOffset, const vec2 dx, const vec2 dy)
+{
+    return max(SampleAtlas(textureCoordinate, dx, dy), SampleAtlas(textureCoordinate - boldOffset, dx, dy));
+};
+
+
+
+void main()
+{
+    #ifdef OVERDRAW_HEATMAP
+    OutputColour = OverdrawHeat;
+    return;
+    #endif
+
+    const vec2 boldOffset = GetBoldOffset();
+
+    const vec2 dx = dFdx(VertexShaderTextureCoordinateOutput);
+    const vec2 dy = dFdy(VertexShaderTextureCoordinateOutput);
+
+    const float distance = SampleDistance(VertexShaderTextureCoordinateOutput, boldOffset, dx, dy);
+
+    // How much the distance changes across a screen pixel, so the edge is smoothed over about one pixel at any scale
+    const float edgeWidth = max(fwidth(distance) * 0.5f, 1.0f / 255.0f);
+
+    float coverage = smoothstep(0.5f - edgeWidth, 0.5f + edgeWidth, distance);
+
+    #ifdef SUPERSAMPLE
+    // Pixels on an edge average four samples in a rotated grid, the centre sample alone decides the rest
+    if(Supersample == true && coverage > 0.0f && coverage < 1.0f)
+    {
+        const vec2 offsets[4] = vec2[4](vec2(-0.125f, -0.375f), vec2(0.375f, -0.125f), vec2(0.125f, 0.375f), vec2(-0.375f, 0.125f));
+
+        coverage = 0.0f;
+
+        for(int index = 0; index < 4; ++index)
+        {
+            const vec2 textureCoordinate = VertexShaderTextureCoordinateOutput + dx * offsets[index].x + dy * offsets[index].y;
+
+            coverage += smoothstep(0.5f - edgeWidth, 0.5f + edgeWidth, SampleDistance(textureCoordinate, boldOffset, dx, dy));
+        };
+
+        coverage *= 0.25f;
+    };
+    #endif
+
+    coverage = ApplyContrast(coverage);
+
+    if(IsDecoration() == true)
+        coverage = 1.0f;
+
+    #ifdef TEXT_EFFECTS
+    // The outline and shadow are thresholds of the same field, so they cost a sample rather than drawing the text again.
+    // The shadow takes the outline's shape, and the layers are composited premultiplied: shadow, outline, then the glyph
+    const float outline = smoothstep(OutlineDistance - edgeWidth, OutlineDistance + edgeWidth, distance) * OutlineColour.a;
+
+    const vec2 shadowCoordinate = VertexShaderTextureCoordinateOutput - (ShadowOffset * VertexShaderTexturePerPixelOutput);
+    const float shadowEdgeWidth = edgeWidth + ShadowSoftness;
+
+    const float shadow = smoothstep(OutlineDistance - shadowEdgeWidth, OutlineDistance + shadowEdgeWidth, SampleDistance(shadowCoordinate, boldOffset, dx, dy)) * ShadowColour.a;
+
+    vec4 layers = vec4(ShadowColour.rgb * shadow, shadow);
+    layers = vec4(OutlineColour.rgb * outline, outline) + (layers * (1.0f - outline));
+    layers = vec4(VertexShaderTextColourOutput.rgb * coverage, coverage) + (layers * (1.0f - coverage));
+
+    // The text's alpha fades its effects with it
+    OutputColour = ToBlendedOutput(vec4(layers.a > 0.0f ? layers.rgb / layers.a : vec3(0.0f), layers.a * VertexShaderTextColourOutput.a));
+    #else
+    // Nothing is discarded, uncovered pixels are simply blended away
+    OutputColour = ToBlendedOutput(vec4(VertexShaderTextColourOutput.rgb, VertexShaderTextColourOutput.a * coverage));
+    #endif
+};
\ No newline at end of file
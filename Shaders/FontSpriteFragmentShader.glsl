@@ -4,21 +4,88 @@
 in vec2 VertexShaderTextureCoordinateOutput;
 in vec4 VertexShaderChromaKeyOutput;
 in vec4 VertexShaderTextColourOutput;
+in vec2 VertexShaderGlyphCoordinateOutput;
+flat in uint VertexShaderGlyphStyleOutput;
 
 uniform sampler2D Texutre;
 
 out vec4 OutputColour;
 
+#include "OverdrawHeatmap.glsl"
+#include "TextBlending.glsl"
+#include "AtlasSampling.glsl"
+
+
+#ifdef STYLED_TEXT
+
+// GlyphStyle bits, see TextStyle.hpp
+const uint GlyphStyleUnderline = 1u << 0;
+const uint GlyphStyleStrikethrough = 1u << 1;
+const uint GlyphStyleBold = 1u << 2;
+
+// Set by the layout pass on a span's background instances, see TextLayoutComputeShader.glsl
+const uint GlyphStyleBackground = 0x40u;
+
+
+// Whether the pixel is filled by a background, or covered by the style's underline or strikethrough, which are about a pixel and a half thick at any scale
+bool IsDecoration()
+{
+    const float y = VertexShaderGlyphCoordinateOutput.y;
+    const float thickness = fwidth(y) * 1.5f;
+
+    const bool underline = (VertexShaderGlyphStyleOutput & GlyphStyleUnderline) != 0 && y >= 1.0f - thickness;
+    const bool strikethrough = (VertexShaderGlyphStyleOutput & GlyphStyleStrikethrough) != 0 && abs(y - 0.55f) <= thickness * 0.5f;
+
+    // Backgrounds are filled just like decorations
+    const bool background = (VertexShaderGlyphStyleOutput & GlyphStyleBackground) != 0;
+
+    return underline == true || strikethrough == true || background == true;
+};
+
+// Bold glyphs are also sampled a texel to the left, which thickens every stem by a texel
+vec2 GetBoldOffset()
+{
+    return (VertexShaderGlyphStyleOutput & GlyphStyleBold) != 0 ? vec2(1.0f / float(textureSize(Texutre, 0).x), 0.0f) : vec2(0.0f);
+};
+
+#else
+
+// Unstyled variants have no decorations or bold, so the checks and the bold sample fold away
+bool IsDecoration()
+{
+    return false;
+};
+
+vec2 GetBoldOffset()
+{
+    return vec2(0.0f);
+};
+
+#endif
+
 
 
 void main()
 {
-    const vec4 pixel = texture(Texutre, VertexShaderTextureCoordinateOutput);
+    #ifdef OVERDRAW_HEATMAP
+    // Before the chroma key, a fragment that's discarded was shaded all the same
+    OutputColour = OverdrawHeat;
+    return;
+    #endif
+
+    const bool decoration = IsDecoration();
+
+    const vec4 pixel = SampleAtlas(vec2(0.0f));
+    const vec4 boldPixel = SampleAtlas(GetBoldOffset());
+
+    // The missing glyph is drawn as a box rather than from the atlas
+    if(IsMissingGlyph() == true && GetMissingGlyphCoverage() < 0.5f && decoration == false)
+        discard;
 
-    // If the current pixel matches the chroma key colour..
-    if(pixel.rgb == VertexShaderChromaKeyOutput.rgb)
+    // If the current pixel, and its bold neighbour, match the chroma key colour..
+    if(IsMissingGlyph() == false && pixel.rgb == VertexShaderChromaKeyOutput.rgb && boldPixel.rgb == VertexShaderChromaKeyOutput.rgb && decoration == false)
         // Then throw pixel away
         discard;
 
-    OutputColour = VertexShaderTextColourOutput;
+    OutputColour = ToBlendedOutput(VertexShaderTextColourOutput);
 };
\ No newline at end of file
@@ -0,0 +1,93 @@
+#version 460 core
+
+
+in vec2 VertexShaderTextureCoordinateOutput;
+in vec4 VertexShaderTextColourOutput;
+in vec2 VertexShaderGlyphCoordinateOutput;
+flat in uint VertexShaderGlyphStyleOutput;
+
+// Per-subpixel coverage, red, green and blue for the pixel's left, middle and right thirds. See AtlasFormat::Subpixel
+uniform sampler2D Texutre;
+
+// Dual-source blending, the destination is blended as colour * coverage + destination * (1 - coverage) per channel.
+// FontSprite sets the blend factors to GL_SRC1_COLOR and GL_ONE_MINUS_SRC1_COLOR for the draw
+layout(location = 0, index = 0) out vec4 OutputColour;
+layout(location = 0, index = 1) out vec4 OutputCoverage;
+
+#include "OverdrawHeatmap.glsl"
+#include "TextBlending.glsl"
+#include "AtlasSampling.glsl"
+
+
+#ifdef STYLED_TEXT
+
+// GlyphStyle bits, see TextStyle.hpp
+const uint GlyphStyleUnderline = 1u << 0;
+const uint GlyphStyleStrikethrough = 1u << 1;
+const uint GlyphStyleBold = 1u << 2;
+
+// Set by the layout pass on a span's background instances, see TextLayoutComputeShader.glsl
+const uint GlyphStyleBackground = 0x40u;
+
+
+// Whether the pixel is filled by a background, or covered by the style's underline or strikethrough, which are about a pixel and a half thick at any scale
+bool IsDecoration()
+{
+    const float y = VertexShaderGlyphCoordinateOutput.y;
+    const float thickness = fwidth(y) * 1.5f;
+
+    const bool underline = (VertexShaderGlyphStyleOutput & GlyphStyleUnderline) != 0 && y >= 1.0f - thickness;
+    const bool strikethrough = (VertexShaderGlyphStyleOutput & GlyphStyleStrikethrough) != 0 && abs(y - 0.55f) <= thickness * 0.5f;
+
+    // Backgrounds are filled just like decorations
+    const bool background = (VertexShaderGlyphStyleOutput & GlyphStyleBackground) != 0;
+
+    return underline == true || strikethrough == true || background == true;
+};
+
+// Bold glyphs are also sampled a texel to the left, which thickens every stem by a texel
+vec2 GetBoldOffset()
+{
+    return (VertexShaderGlyphStyleOutput & GlyphStyleBold) != 0 ? vec2(1.0f / float(textureSize(Texutre, 0).x), 0.0f) : vec2(0.0f);
+};
+
+#else
+
+// Unstyled variants have no decorations or bold, so the checks and the bold sample fold away
+bool IsDecoration()
+{
+    return false;
+};
+
+vec2 GetBoldOffset()
+{
+    return vec2(0.0f);
+};
+
+#endif
+
+
+
+void main()
+{
+    #ifdef OVERDRAW_HEATMAP
+    // The heatmap is blended without the second source
+    OutputColour = OverdrawHeat;
+    OutputCoverage = vec4(1.0f);
+    return;
+    #endif
+
+    const vec2 boldOffset = GetBoldOffset();
+
+    vec3 coverage = ApplyContrast(max(SampleAtlas(vec2(0.0f)).rgb, SampleAtlas(boldOffset).rgb));
+
+    if(IsMissingGlyph() == true)
+        coverage = vec3(GetMissingGlyphCoverage());
+
+    if(IsDecoration() == true)
+        coverage = vec3(1.0f);
+
+    // Blended by the second output, which already weighs each channel by its coverage, so the colour is only decoded
+    OutputColour = vec4(LinearBlending == true ? DecodeSRGB(VertexShaderTextColourOutput.rgb) : VertexShaderTextColourOutput.rgb, 1.0f);
+    OutputCoverage = vec4(coverage * VertexShaderTextColourOutput.a, max(max(coverage.r, coverage.g), coverage.b) * VertexShaderTextColourOutput.a);
+};
\ No newline at end of file
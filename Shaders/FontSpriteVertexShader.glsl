@@ -1,92 +1,261 @@
 #version 460 core
 
-layout(location = 0) in vec2 VertexPosition;
+// The "Input" block, generated from FontSpriteInputLayout. Characters are only read by the layout pass
+#include "FontSpriteInput.glsl"
 
+struct GlyphMetrics
+{
+    // Left, top, right, bottom
+    vec4 TextureRect;
+
+    vec2 Size;
+    vec2 Bearing;
+
+    float Advance;
+
+    // The texture array layer, see GlyphAtlas.hpp
+    uint Layer;
 
-layout(std430, binding = 0) readonly buffer Input
+    // GlyphMissingFlag for the glyph characters without one are drawn as, see GlyphMetrics.hpp
+    uint Flags;
+};
+
+// Built once by FontSprite, indexed by glyph
+layout(std430, binding = 1) readonly buffer GlyphMetricsTable
 {
-    uint GlyphWidth;
-    uint GlyphHeight;
+    GlyphMetrics GlyphTable[];
+};
 
-    uint TextureWidth;
-    uint TextureHeight;
+struct LaidOutGlyph
+{
+    // The glyph's top-left corner, relative to the text's origin
+    vec2 Position;
 
-    vec4 ChromaKey;
+    // The glyph's index in the low 24 bits, its span's style in the high 8
+    uint GlyphIndex;
 
-    vec4 TextColour;
+    // Packed RGBA8, only used when the style has GlyphStyleHasColour set
+    uint Colour;
+};
+
+const uint GlyphStyleShift = 24;
+const uint GlyphStyleUnderline = 1u << 0;
+const uint GlyphStyleStrikethrough = 1u << 1;
+const uint GlyphStyleHasColour = 0x80u;
+const uint GlyphStyleBackground = 0x40u;
 
-    // No 8-bit integers, so I'm using a uint
-    uint Characters[];
+// Set here on the missing glyph, the fragment shader draws it as a box, see AtlasSampling.glsl
+const uint GlyphStyleMissing = 0x20u;
+const uint GlyphMissingFlag = 2u;
+
+// The visible glyphs, written by the layout pass. See TextLayoutComputeShader.glsl
+layout(std430, binding = 2) readonly buffer GlyphInstancesBuffer
+{
+    LaidOutGlyph GlyphInstances[];
 };
 
-uniform mat4 Projection = mat4(1.0f);
+// Shared by every draw in a frame, see FrameUniformBuffer.hpp
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 Projection;
+    mat4 View;
+
+    vec2 ViewportSize;
+    float Time;
+
+    // Framebuffer pixels per window unit, see ContentScale.hpp
+    float ContentScale;
+};
 
 uniform mat4 TextTransform = mat4(1.0f);
 
+#ifdef MULTI_DRAW
+struct QueuedDraw
+{
+    mat4 Transform;
+    vec4 Colour;
+};
+
+// One per draw of a multi-draw, see GlyphRunCache::SubmitQueued
+layout(std430, binding = 13) readonly buffer QueuedDrawsBuffer
+{
+    QueuedDraw QueuedDraws[];
+};
+
+// Set for a multi-draw, the transform and colour then come from the draw's QueuedDraw instead of TextTransform and TextColour
+uniform bool MultiDraw = false;
+#endif
+
+#ifdef TEXT_EFFECTS
+// (Distance field atlases) How far glyph quads grow on every side to fit the outline and shadow, in the font's pixels, see FontSprite::Effects
+uniform float EffectPadding = 0.0f;
+#endif
+
+#ifdef BILLBOARD_TEXT
+// World units per pixel of the font, or with BillboardConstantScreenSize, window units per pixel of the font, see FontSprite::Billboard
+uniform float BillboardScale = 1.0f;
+
+uniform bool BillboardConstantScreenSize = false;
+#endif
+
+#ifdef ANIMATED_TEXT
+struct GlyphAnimation
+{
+    vec2 Offset;
+    float Opacity;
+    float Padding;
+};
+
+// Indexed like GlyphInstances, written once a frame by TextAnimationComputeShader.glsl, see TextAnimator
+layout(std430, binding = 14) readonly buffer GlyphAnimationsBuffer
+{
+    GlyphAnimation GlyphAnimations[];
+};
+#endif
+
 
 
 out vec2 VertexShaderTextureCoordinateOutput;
 out vec4 VertexShaderChromaKeyOutput;
 out vec4 VertexShaderTextColourOutput;
 
+// The position within the glyph's quad, 0 to 1 from the top-left corner, for the style's decorations
+out vec2 VertexShaderGlyphCoordinateOutput;
+
+// The GlyphStyle bits, see TextStyle.hpp
+flat out uint VertexShaderGlyphStyleOutput;
+
+#ifdef PIXEL_SNAPPED
+// The vertex's position in the atlas in texels, for texelFetch, see AtlasSampling.glsl
+out vec2 VertexShaderTexelCoordinateOutput;
+#endif
+
+#ifdef TEXT_EFFECTS
+// The glyph's rectangle in the atlas, grown quads reach past it
+flat out vec4 VertexShaderTextureRectOutput;
+
+// How far the texture coordinate moves per pixel of the font, for offsetting the shadow
+flat out vec2 VertexShaderTexturePerPixelOutput;
+#endif
+
 
 void main()
 {
-    // Subtract 32 (The space character) from the selected character to get the correct character index
-    const uint glyphIndex = Characters[gl_InstanceID] - 32;
+    // The layout pass already converted the character into a glyph index. Cached glyph runs are drawn from their own base instance
+    const LaidOutGlyph glyph = GlyphInstances[gl_BaseInstance + gl_InstanceID];
+
+    const GlyphMetrics metrics = GlyphTable[glyph.GlyphIndex & ((1u << GlyphStyleShift) - 1u)];
 
-    const uint columns = TextureWidth / GlyphWidth;
-    const uint rows = TextureHeight / GlyphHeight;
+    const uint style = (glyph.GlyphIndex >> GlyphStyleShift) | ((metrics.Flags & GlyphMissingFlag) != 0 ? GlyphStyleMissing : 0u);
 
-    // Convert 1D character to 2D.
-    const uint glpyhX = glyphIndex % columns;
-    const uint glpyhY = glyphIndex / columns;
+    // The quad's corner, drawn as a triangle strip: (0, 0), (1, 0), (0, 1), (1, 1)
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
 
-    // Calculate texutre sampling bounds
-    const float textureCoordinateLeft = float(glpyhX) / float(columns);
-    const float textureCoordinateBottom = float((2 - glpyhY)) / float(rows);
+    // The vertex's position within the glyph, 0 to 1 across it
+    vec2 glyphCoordinate = corner;
 
-    const float textureCoordinateRight = float(glpyhX + 1) / float(columns);
-    const float textureCoordinateTop = float((2 - glpyhY) + 1) / float(rows);
+    #ifdef TEXT_EFFECTS
+    // Grown quads reach past the glyph on every side, and their texture coordinates past its rectangle with them
+    const vec2 glyphSize = max(metrics.Size, vec2(1.0f));
 
+    glyphCoordinate = mix(vec2(-EffectPadding) / glyphSize, vec2(1.0f) + (vec2(EffectPadding) / glyphSize), corner);
 
-    // Create a texture sampling point
-    switch(gl_VertexID)
+    VertexShaderTextureRectOutput = metrics.TextureRect;
+    VertexShaderTexturePerPixelOutput = (metrics.TextureRect.zw - metrics.TextureRect.xy) / glyphSize;
+    #endif
+
+    VertexShaderTextureCoordinateOutput = mix(metrics.TextureRect.xy, metrics.TextureRect.zw, glyphCoordinate);
+
+    #ifdef PIXEL_SNAPPED
+    // The glyph's corner is a whole texel, rounding undoes the division that normalized it
+    VertexShaderTexelCoordinateOutput = round(metrics.TextureRect.xy * vec2(TextureWidth, TextureHeight)) + (glyphCoordinate * metrics.Size);
+    #endif
+
+    #ifdef STYLED_TEXT
+    // A span's background fills the glyph's whole cell, the glyph itself is a separate instance drawn over it
+    vec2 vertexPosition = (style & GlyphStyleBackground) != 0 ?
+        corner * vec2(metrics.Advance, float(GlyphHeight)) :
+        metrics.Bearing + (glyphCoordinate * metrics.Size);
+
+    // Grid glyphs' quads only cover their ink, see FontSprite::BuildInkGlyphMetrics. Decorations are placed across the whole cell,
+    // so decorated glyphs fill it, their texture coordinates continuing past the ink at a texel per pixel
+    if((style & (GlyphStyleUnderline | GlyphStyleStrikethrough)) != 0 && (style & GlyphStyleBackground) == 0)
     {
-        // Top left
-        case 0:
-        {
-            VertexShaderTextureCoordinateOutput = vec2(textureCoordinateLeft, textureCoordinateTop);
-            break;
-        };
-
-        // Top right      
-        case 3:
-        case 1:
-        {
-            VertexShaderTextureCoordinateOutput = vec2(textureCoordinateRight, textureCoordinateTop);
-            break;
-        };
-
-        // Bottom left    
-        case 2:
-        case 5:
-        {
-            VertexShaderTextureCoordinateOutput = vec2(textureCoordinateLeft, textureCoordinateBottom);
-            break;
-        };
-
-        // Bottom right
-        case 4:
-        {
-            VertexShaderTextureCoordinateOutput = vec2(textureCoordinateRight, textureCoordinateBottom);
-            break;
-        };
+        vertexPosition = corner * vec2(metrics.Advance, float(GlyphHeight));
+        glyphCoordinate = corner;
+
+        const vec2 atlasSize = vec2(TextureWidth, TextureHeight);
+
+        VertexShaderTextureCoordinateOutput = metrics.TextureRect.xy + ((vertexPosition - metrics.Bearing) / atlasSize);
+
+        #ifdef PIXEL_SNAPPED
+        VertexShaderTexelCoordinateOutput = round(metrics.TextureRect.xy * atlasSize) + (vertexPosition - metrics.Bearing);
+        #endif
     };
+    #else
+    const vec2 vertexPosition = metrics.Bearing + (glyphCoordinate * metrics.Size);
+    #endif
 
 
-    VertexShaderTextColourOutput = TextColour;
+    #ifdef MULTI_DRAW
+    const vec4 drawColour = MultiDraw == true ? QueuedDraws[gl_DrawID].Colour : TextColour;
+    const mat4 drawTransform = MultiDraw == true ? QueuedDraws[gl_DrawID].Transform : TextTransform;
+    #else
+    const vec4 drawColour = TextColour;
+    const mat4 drawTransform = TextTransform;
+    #endif
+
+
+    #ifdef STYLED_TEXT
+    VertexShaderTextColourOutput = (style & GlyphStyleHasColour) != 0 ? unpackUnorm4x8(glyph.Colour) : drawColour;
+    #else
+    VertexShaderTextColourOutput = drawColour;
+    #endif
+    VertexShaderGlyphCoordinateOutput = glyphCoordinate;
+    VertexShaderGlyphStyleOutput = style;
     VertexShaderChromaKeyOutput = ChromaKey;
 
-    gl_Position = Projection * TextTransform * vec4(VertexPosition.x + (gl_InstanceID * GlyphWidth), VertexPosition.y, 0.0f, 1.0f);
+    vec2 glyphPosition = glyph.Position;
+
+    #ifdef ANIMATED_TEXT
+    const GlyphAnimation animation = GlyphAnimations[gl_BaseInstance + gl_InstanceID];
+
+    glyphPosition += animation.Offset;
+    VertexShaderTextColourOutput.a *= animation.Opacity;
+    #endif
+
+    #ifdef BILLBOARD_TEXT
+    // The transform only places the text's anchor, the glyphs are laid out across the camera's plane around it, y going down like on screen
+    const vec4 anchor = drawTransform * vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const vec2 textPosition = vertexPosition + glyphPosition;
+
+    if(BillboardConstantScreenSize == true)
+    {
+        // Offsetting in clip space after the projection keeps the text the same number of pixels tall at any distance
+        const vec4 clipAnchor = Projection * View * anchor;
+
+        gl_Position = clipAnchor + vec4((textPosition * BillboardScale * ContentScale * vec2(2.0f, -2.0f) / ViewportSize) * clipAnchor.w, 0.0f, 0.0f);
+    }
+    else
+    {
+        // The view matrix' rows are the camera's axes in the world
+        const vec3 cameraRight = vec3(View[0][0], View[1][0], View[2][0]);
+        const vec3 cameraUp = vec3(View[0][1], View[1][1], View[2][1]);
+
+        const vec3 worldPosition = anchor.xyz + (((cameraRight * textPosition.x) - (cameraUp * textPosition.y)) * BillboardScale);
+
+        gl_Position = Projection * View * vec4(worldPosition, 1.0f);
+    };
+    #else
+    gl_Position = Projection * View * drawTransform * vec4(vertexPosition + glyphPosition, 0.0f, 1.0f);
+    #endif
+
+    #ifdef PIXEL_SNAPPED
+    // Every corner moves by as much as the glyph's top-left corner needs to reach a pixel corner, so the glyph's texels cover pixels one to one
+    const vec4 clipOrigin = Projection * View * drawTransform * vec4(metrics.Bearing + glyphPosition, 0.0f, 1.0f);
+
+    const vec2 pixelOrigin = (((clipOrigin.xy / clipOrigin.w) * 0.5f) + 0.5f) * ViewportSize;
+
+    gl_Position.xy += ((round(pixelOrigin) - pixelOrigin) * 2.0f / ViewportSize) * gl_Position.w;
+    #endif
 };
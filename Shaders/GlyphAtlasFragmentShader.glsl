@@ -0,0 +1,90 @@
+#version 460 core
+
+
+in vec2 VertexShaderTextureCoordinateOutput;
+in vec4 VertexShaderTextColourOutput;
+flat in uint VertexShaderLayerOutput;
+flat in uint VertexShaderGlyphFlagsOutput;
+in vec2 VertexShaderGlyphCoordinateOutput;
+flat in uint VertexShaderGlyphStyleOutput;
+flat in vec4 VertexShaderTextureRectOutput;
+// (Picking) The glyph's run and its index in the run
+flat in uvec2 VertexShaderPickOutput;
+
+// The coverage layers of a GlyphAtlas, see GlyphAtlas.hpp
+uniform sampler2DArray Texutre;
+
+// The colour layers, GlyphAtlas::Bind binds them to the unit after the coverage layers
+layout(binding = 1) uniform sampler2DArray ColourTexture;
+
+// Matches GlyphColourFlag in GlyphMetrics.hpp
+const uint GLYPH_COLOUR = 1u;
+
+layout(location = 0) out vec4 OutputColour;
+
+// (Picking) Only a TextPickingBuffer has a draw buffer at location 1, other targets drop it
+layout(location = 1) out uvec2 PickOutput;
+
+uniform bool TextPicking = false;
+
+// GlyphStyle bits, see TextStyle.hpp
+const uint GlyphStyleUnderline = 1u << 0;
+const uint GlyphStyleStrikethrough = 1u << 1;
+
+
+// The style's underline or strikethrough, about a pixel and a half thick at any scale. A decorated glyph's quad is its cell, see TextBatchVertexShader.glsl
+float GetDecorationCoverage()
+{
+    const float y = VertexShaderGlyphCoordinateOutput.y;
+    const float thickness = fwidth(y) * 1.5f;
+
+    const bool underline = (VertexShaderGlyphStyleOutput & GlyphStyleUnderline) != 0u && y >= 1.0f - thickness;
+    const bool strikethrough = (VertexShaderGlyphStyleOutput & GlyphStyleStrikethrough) != 0u && abs(y - 0.55f) <= thickness * 0.5f;
+
+    return underline == true || strikethrough == true ? 1.0f : 0.0f;
+};
+
+// Whether the fragment is on the glyph's bitmap, rather than on the part of its cell a decoration stretched the quad over
+bool IsInsideGlyph()
+{
+    return all(greaterThanEqual(VertexShaderTextureCoordinateOutput, VertexShaderTextureRectOutput.xy)) &&
+           all(lessThanEqual(VertexShaderTextureCoordinateOutput, VertexShaderTextureRectOutput.zw));
+};
+
+// (Picking) Only the pixels a glyph visibly covers are its, the rest of its quad doesn't catch picks. See TextPicking.hpp
+void WritePick(const float coverage)
+{
+    if(TextPicking == true && coverage < 0.5f)
+        discard;
+
+    PickOutput = VertexShaderPickOutput;
+};
+
+
+
+void main()
+{
+    const vec3 textureCoordinate = vec3(VertexShaderTextureCoordinateOutput, float(VertexShaderLayerOutput));
+
+    const bool insideGlyph = IsInsideGlyph();
+
+    const float decoration = GetDecorationCoverage();
+
+    // Colour glyphs keep their own colours, the text colour only fades them
+    if((VertexShaderGlyphFlagsOutput & GLYPH_COLOUR) != 0u && decoration == 0.0f)
+    {
+        const vec4 texel = insideGlyph == true ? texture(ColourTexture, textureCoordinate) : vec4(0.0f);
+
+        WritePick(texel.a);
+
+        OutputColour = vec4(texel.rgb, texel.a * VertexShaderTextColourOutput.a);
+        return;
+    };
+
+    const float coverage = max(insideGlyph == true ? texture(Texutre, textureCoordinate).r : 0.0f, decoration);
+
+    WritePick(coverage);
+
+    // Nothing is discarded, uncovered pixels are simply blended away
+    OutputColour = vec4(VertexShaderTextColourOutput.rgb, VertexShaderTextColourOutput.a * coverage);
+};
\ No newline at end of file
@@ -0,0 +1,19 @@
+#version 460 core
+
+
+in vec2 VertexShaderTextureCoordinateOutput;
+
+// The label cache, premultiplied, see LabelCache.hpp
+uniform sampler2D Texutre;
+
+out vec4 OutputColour;
+
+
+
+void main()
+{
+    const vec4 pixel = texture(Texutre, VertexShaderTextureCoordinateOutput);
+
+    // The frame blends straight alpha, a label's pixels all come from a single text colour so dividing it back out is exact enough
+    OutputColour = pixel.a > 0.0f ? vec4(pixel.rgb / pixel.a, pixel.a) : vec4(0.0f);
+};
\ No newline at end of file
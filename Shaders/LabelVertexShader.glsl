@@ -0,0 +1,45 @@
+#version 460 core
+
+struct LabelQuad
+{
+    // The top-left corner of the label, in screen space
+    vec2 Position;
+
+    vec2 Size;
+
+    // Where the label is in the cache texture, left, top, right, bottom
+    vec4 TextureRect;
+};
+
+
+layout(std430, binding = 0) readonly buffer LabelQuads
+{
+    LabelQuad Quads[];
+};
+
+// Shared by every draw in a frame, see FrameUniformBuffer.hpp
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 Projection;
+    mat4 View;
+
+    vec2 ViewportSize;
+    float Time;
+};
+
+
+
+out vec2 VertexShaderTextureCoordinateOutput;
+
+
+void main()
+{
+    const LabelQuad quad = Quads[gl_InstanceID];
+
+    // The quad's corner, drawn as a triangle strip: (0, 0), (1, 0), (0, 1), (1, 1)
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    VertexShaderTextureCoordinateOutput = mix(quad.TextureRect.xy, quad.TextureRect.zw, corner);
+
+    gl_Position = Projection * View * vec4(quad.Position + (corner * quad.Size), 0.0f, 1.0f);
+};
\ No newline at end of file
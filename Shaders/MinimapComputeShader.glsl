@@ -0,0 +1,99 @@
+#version 460 core
+
+// An invocation per character cell of a tile, see Minimap::RenderTile
+layout(local_size_x = 256) in;
+
+
+// A row of Columns bytes per line, 0 past the end of a line, four to a uint
+layout(std430, binding = 21) readonly buffer MinimapCharacters
+{
+    uint Characters[];
+};
+
+// Matches TextSpan in TextStyle.hpp, FirstCharacter counts cells rather than characters
+struct TextSpan
+{
+    uint FirstCharacter;
+    uint Colour;
+    uint Style;
+    uint Background;
+};
+
+// Ordered by FirstCharacter, each span runs until the next one. Only bound if SpanCount isn't 0
+layout(std430, binding = 22) readonly buffer MinimapSpans
+{
+    TextSpan Spans[];
+};
+
+// The tile's layer, written whole
+layout(binding = 0, rgba8) uniform writeonly image2DArray Tiles;
+
+uniform uint Columns;
+uniform uint TileLines;
+
+// A cell's width in the low 16 bits and height in the high 16, in texels
+uniform uint CellSize;
+
+uniform uint Layer;
+
+uniform uint SpanCount;
+
+// RGBA8, for cells before the first span
+uniform uint TextColour;
+
+
+
+// The colour of the last span that starts at or before a cell
+uint FindSpanColour(const uint cell)
+{
+    uint low = 0u;
+    uint high = SpanCount;
+
+    while(low < high)
+    {
+        const uint middle = (low + high) / 2u;
+
+        if(Spans[middle].FirstCharacter <= cell)
+            low = middle + 1u;
+        else
+            high = middle;
+    };
+
+    return low == 0u ? TextColour : Spans[low - 1u].Colour;
+};
+
+
+void main()
+{
+    const uint cell = gl_GlobalInvocationID.x;
+
+    if(cell >= Columns * TileLines)
+        return;
+
+    const uint character = (Characters[cell >> 2] >> ((cell & 3u) * 8u)) & 0xFFu;
+
+    // Whitespace and control characters leave a gap, the shape of the text is what a minimap shows
+    vec4 colour = vec4(0.0f);
+
+    if(character > 32u && character != 127u)
+    {
+        colour = unpackUnorm4x8(SpanCount > 0u ? FindSpanColour(cell) : TextColour);
+
+        const bool alphanumeric = (character >= 48u && character <= 57u) || ((character | 32u) >= 97u && (character | 32u) <= 122u);
+
+        // Punctuation is lighter than words, so the blocks still read as words
+        if(alphanumeric == false)
+            colour.a *= 0.6f;
+    };
+
+    const uvec2 cellSize = uvec2(CellSize & 0xFFFFu, CellSize >> 16);
+    const uvec2 cellOrigin = uvec2(cell % Columns, cell / Columns) * cellSize;
+
+    for(uint y = 0u; y < cellSize.y; ++y)
+    {
+        for(uint x = 0u; x < cellSize.x; ++x)
+        {
+            imageStore(Tiles, ivec3(cellOrigin + uvec2(x, y), Layer), colour);
+        };
+    };
+};
\ No newline at end of file
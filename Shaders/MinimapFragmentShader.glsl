@@ -0,0 +1,19 @@
+#version 460 core
+
+
+in vec2 VertexShaderTextureCoordinateOutput;
+
+// A layer per cached tile, see Minimap.hpp
+layout(binding = 0) uniform sampler2DArray Tiles;
+
+uniform uint TileLayer;
+
+out vec4 OutputColour;
+
+
+
+void main()
+{
+    // Straight alpha, as the compute pass wrote it
+    OutputColour = texture(Tiles, vec3(VertexShaderTextureCoordinateOutput, float(TileLayer)));
+};
\ No newline at end of file
@@ -0,0 +1,33 @@
+#version 460 core
+
+
+// Shared by every draw in a frame, see FrameUniformBuffer.hpp
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 Projection;
+    mat4 View;
+
+    vec2 ViewportSize;
+    float Time;
+};
+
+// The part of a tile that's drawn, in screen space: left, top, width, height
+uniform vec4 TileRect;
+
+// The same part of the tile's layer: left, top, right, bottom
+uniform vec4 TileTextureRect;
+
+
+
+out vec2 VertexShaderTextureCoordinateOutput;
+
+
+void main()
+{
+    // The quad's corner, drawn as a triangle strip: (0, 0), (1, 0), (0, 1), (1, 1)
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    VertexShaderTextureCoordinateOutput = mix(TileTextureRect.xy, TileTextureRect.zw, corner);
+
+    gl_Position = Projection * View * vec4(TileRect.xy + (corner * TileRect.zw), 0.0f, 1.0f);
+};
\ No newline at end of file
@@ -0,0 +1,9 @@
+// Included by the FontSprite fragment shaders. Their OVERDRAW_HEATMAP variants write OverdrawHeat for every fragment they shade,
+// discarded ones included, and FontSprite blends them additively onto a black background. One fragment is a dark red,
+// four saturate red, sixteen are yellow and sixty-four white, so the heat of a pixel reads as how many times it was shaded
+
+#ifdef OVERDRAW_HEATMAP
+
+const vec4 OverdrawHeat = vec4(1.0f / 4.0f, 1.0f / 16.0f, 1.0f / 64.0f, 1.0f);
+
+#endif
@@ -0,0 +1,17 @@
+// Unpacks the packed DataTypes of DynamicSSBO.hpp, for blocks declared with them. Half2 and Unorm8x4 are declared as uint, Half4 as uvec2
+
+vec2 UnpackHalf2(const uint packed)
+{
+    return unpackHalf2x16(packed);
+};
+
+vec4 UnpackHalf4(const uvec2 packed)
+{
+    return vec4(unpackHalf2x16(packed.x), unpackHalf2x16(packed.y));
+};
+
+// Each byte is a value in [0, 1], the lowest byte is x, as written by PackedUnorm8x4::Pack
+vec4 UnpackUnorm8x4(const uint packed)
+{
+    return unpackUnorm4x8(packed);
+};
@@ -0,0 +1,47 @@
+// Included by the TerminalGrid shaders. The cells, and the glyph metrics they're drawn with, are read by the vertex shader
+// when every cell is its own instance, and by the fragment shader when every row is a single quad, see ROW_QUADS
+
+struct TerminalCell
+{
+    // Index into GlyphTable, already converted from the cell's character
+    uint GlyphIndex;
+
+    // Packed RGBA8, see TextStyle.hpp
+    uint Foreground;
+    uint Background;
+
+    // GlyphStyle bits
+    uint Style;
+};
+
+// Every cell of the grid, a row at a time. Visible row 0 is stored at FirstRow, see TerminalGrid.hpp
+layout(std430, binding = 12) readonly buffer TerminalCells
+{
+    TerminalCell Cells[];
+};
+
+struct GlyphMetrics
+{
+    // Left, top, right, bottom
+    vec4 TextureRect;
+
+    vec2 Size;
+    vec2 Bearing;
+
+    float Advance;
+
+    // The texture array layer, see GlyphAtlas.hpp
+    uint Layer;
+};
+
+// Built once by FontSprite, indexed by glyph
+layout(std430, binding = 1) readonly buffer GlyphMetricsTable
+{
+    GlyphMetrics GlyphTable[];
+};
+
+uniform uint Columns;
+uniform uint Rows;
+
+// The size of a single cell, the font's glyph size
+uniform vec2 CellSize;
\ No newline at end of file
@@ -0,0 +1,123 @@
+#version 460 core
+
+#ifdef ROW_QUADS
+
+#include "TerminalGridCells.glsl"
+
+in float VertexShaderColumnOutput;
+in vec2 VertexShaderCellCoordinateOutput;
+
+flat in uint VertexShaderStoredRowOutput;
+
+#else
+
+in vec2 VertexShaderGlyphCoordinateOutput;
+in vec2 VertexShaderCellCoordinateOutput;
+
+flat in vec4 VertexShaderTextureRectOutput;
+flat in vec4 VertexShaderForegroundOutput;
+flat in vec4 VertexShaderBackgroundOutput;
+flat in uint VertexShaderGlyphStyleOutput;
+
+#endif
+
+// A single-channel coverage atlas, see AtlasFormat::Coverage
+uniform sampler2D Texutre;
+
+out vec4 OutputColour;
+
+
+// GlyphStyle bits, see TextStyle.hpp
+const uint GlyphStyleUnderline = 1u << 0;
+const uint GlyphStyleStrikethrough = 1u << 1;
+const uint GlyphStyleBold = 1u << 2;
+
+
+// The pixel's cell, filled in by LoadCell
+vec2 GlyphCoordinate;
+vec2 CellCoordinate;
+vec4 TextureRect;
+vec4 Foreground;
+vec4 Background;
+uint Style;
+
+
+// With ROW_QUADS the quad spans a whole row, so the cell is found from the pixel's position along it and fetched here rather than in the vertex shader.
+// The position is interpolated rather than derived from gl_FragCoord, so the grid can still be transformed
+void LoadCell()
+{
+    #ifdef ROW_QUADS
+
+    const uint column = min(uint(VertexShaderColumnOutput), Columns - 1u);
+
+    const TerminalCell cell = Cells[(VertexShaderStoredRowOutput * Columns) + column];
+
+    const GlyphMetrics metrics = GlyphTable[cell.GlyphIndex];
+
+    CellCoordinate = vec2(VertexShaderColumnOutput - float(column), VertexShaderCellCoordinateOutput.y);
+
+    GlyphCoordinate = ((CellCoordinate * CellSize) - metrics.Bearing) / max(metrics.Size, vec2(1.0f));
+
+    TextureRect = metrics.TextureRect;
+    Foreground = unpackUnorm4x8(cell.Foreground);
+    Background = unpackUnorm4x8(cell.Background);
+    Style = cell.Style;
+
+    #else
+
+    GlyphCoordinate = VertexShaderGlyphCoordinateOutput;
+    CellCoordinate = VertexShaderCellCoordinateOutput;
+
+    TextureRect = VertexShaderTextureRectOutput;
+    Foreground = VertexShaderForegroundOutput;
+    Background = VertexShaderBackgroundOutput;
+    Style = VertexShaderGlyphStyleOutput;
+
+    #endif
+};
+
+// Whether the pixel is covered by the style's underline or strikethrough, about a pixel and a half thick at any scale.
+// Measured in the cell rather than the glyph, so decorations line up across a row
+bool IsDecoration()
+{
+    const float y = CellCoordinate.y;
+    const float thickness = fwidth(y) * 1.5f;
+
+    const bool underline = (Style & GlyphStyleUnderline) != 0 && y >= 1.0f - thickness;
+    const bool strikethrough = (Style & GlyphStyleStrikethrough) != 0 && abs(y - 0.55f) <= thickness * 0.5f;
+
+    return underline == true || strikethrough == true;
+};
+
+// The glyph's coverage, 0 outside the glyph's own rectangle.
+// Cells are drawn at their font's size, so the top level is sampled explicitly rather than relying on derivatives inside the branch
+float SampleCoverage(const vec2 glyphCoordinate)
+{
+    if(any(lessThan(glyphCoordinate, vec2(0.0f))) || any(greaterThan(glyphCoordinate, vec2(1.0f))))
+        return 0.0f;
+
+    return textureLod(Texutre, mix(TextureRect.xy, TextureRect.zw, glyphCoordinate), 0.0f).r;
+};
+
+
+
+void main()
+{
+    LoadCell();
+
+    float coverage = SampleCoverage(GlyphCoordinate);
+
+    // Bold glyphs are also sampled a texel to the left, which thickens every stem by a texel
+    if((Style & GlyphStyleBold) != 0)
+    {
+        const float texelInGlyph = (1.0f / float(textureSize(Texutre, 0).x)) / max(TextureRect.z - TextureRect.x, 1e-6f);
+
+        coverage = max(coverage, SampleCoverage(GlyphCoordinate - vec2(texelInGlyph, 0.0f)));
+    };
+
+    if(IsDecoration() == true)
+        coverage = 1.0f;
+
+    // The cell is opaque where its background is, the glyph is blended over it
+    OutputColour = mix(Background, Foreground, Foreground.a * coverage);
+};
\ No newline at end of file
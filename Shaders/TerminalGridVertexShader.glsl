@@ -0,0 +1,91 @@
+#version 460 core
+
+#include "TerminalGridCells.glsl"
+
+// Shared by every draw in a frame, see FrameUniformBuffer.hpp
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 Projection;
+    mat4 View;
+
+    vec2 ViewportSize;
+    float Time;
+};
+
+uniform mat4 TextTransform = mat4(1.0f);
+
+// Scrolling only moves the ring's first row, the cells stay where they are
+uniform uint FirstRow = 0;
+
+
+
+// The position within the cell, 0 to 1 from its top-left corner, for the style's decorations. Only y is used with ROW_QUADS
+out vec2 VertexShaderCellCoordinateOutput;
+
+#ifdef ROW_QUADS
+
+// The position along the row, in cells
+out float VertexShaderColumnOutput;
+
+// Where the row is stored in Cells
+flat out uint VertexShaderStoredRowOutput;
+
+#else
+
+// The position within the glyph, 0 to 1 from its top-left corner. Cells are usually larger than their glyph, outside 0 to 1 there's only background
+out vec2 VertexShaderGlyphCoordinateOutput;
+
+flat out vec4 VertexShaderTextureRectOutput;
+flat out vec4 VertexShaderForegroundOutput;
+flat out vec4 VertexShaderBackgroundOutput;
+flat out uint VertexShaderGlyphStyleOutput;
+
+#endif
+
+
+void main()
+{
+    #ifdef ROW_QUADS
+
+    // Every instance is a whole row, the fragment shader finds the cell it's in, so a row costs 4 vertices rather than 4 per cell
+    const uint row = uint(gl_InstanceID);
+
+    // The quad's corner, drawn as a triangle strip: (0, 0), (1, 0), (0, 1), (1, 1)
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    VertexShaderColumnOutput = corner.x * float(Columns);
+    VertexShaderStoredRowOutput = (row + FirstRow) % Rows;
+
+    VertexShaderCellCoordinateOutput = corner;
+
+    gl_Position = Projection * View * TextTransform * vec4((vec2(0.0f, row) + (corner * vec2(Columns, 1.0f))) * CellSize, 0.0f, 1.0f);
+
+    #else
+
+    // Every instance is a cell, in visible order
+    const uint row = uint(gl_InstanceID) / Columns;
+    const uint column = uint(gl_InstanceID) % Columns;
+
+    const TerminalCell cell = Cells[(((row + FirstRow) % Rows) * Columns) + column];
+
+    const GlyphMetrics metrics = GlyphTable[cell.GlyphIndex];
+
+    // The quad's corner, drawn as a triangle strip: (0, 0), (1, 0), (0, 1), (1, 1)
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    // The quad covers the whole cell so the background is filled, the glyph is placed inside it by its bearing
+    const vec2 cellPosition = corner * CellSize;
+
+
+    VertexShaderGlyphCoordinateOutput = (cellPosition - metrics.Bearing) / max(metrics.Size, vec2(1.0f));
+    VertexShaderCellCoordinateOutput = corner;
+
+    VertexShaderTextureRectOutput = metrics.TextureRect;
+    VertexShaderForegroundOutput = unpackUnorm4x8(cell.Foreground);
+    VertexShaderBackgroundOutput = unpackUnorm4x8(cell.Background);
+    VertexShaderGlyphStyleOutput = cell.Style;
+
+    gl_Position = Projection * View * TextTransform * vec4((vec2(column, row) * CellSize) + cellPosition, 0.0f, 1.0f);
+
+    #endif
+};
@@ -0,0 +1,123 @@
+#version 460 core
+
+// An invocation per glyph instance, see TextAnimator::Update
+layout(local_size_x = 256) in;
+
+
+struct TextAnimationTrack
+{
+    uint FirstInstance;
+    uint InstanceCount;
+
+    // One of the effects below, see TextAnimationEffect
+    uint Effect;
+
+    float StartTime;
+
+    // How long each glyph takes, or a wave's period, in seconds
+    float Duration;
+
+    // How much later each glyph starts than the one before it
+    float Stagger;
+
+    // (Slide) Where glyphs start. (Wave) How far glyphs move at the top of the wave
+    vec2 Offset;
+};
+
+const uint EffectFade = 0;
+const uint EffectSlide = 1;
+const uint EffectWave = 2;
+const uint EffectTypewriter = 3;
+
+// Only uploaded when a track starts or stops
+layout(std430, binding = 15) readonly buffer TextAnimationTracksBuffer
+{
+    TextAnimationTrack Tracks[];
+};
+
+struct GlyphAnimation
+{
+    // Added to the glyph's laid out position
+    vec2 Offset;
+
+    // Multiplies the glyph's alpha
+    float Opacity;
+
+    float Padding;
+};
+
+// Indexed like GlyphInstances, read by FontSpriteVertexShader.glsl
+layout(std430, binding = 14) writeonly buffer GlyphAnimationsBuffer
+{
+    GlyphAnimation GlyphAnimations[];
+};
+
+
+// Shared by every draw in a frame, see FrameUniformBuffer.hpp
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 Projection;
+    mat4 View;
+
+    vec2 ViewportSize;
+    float Time;
+};
+
+
+uniform uint InstanceCount = 0;
+uniform uint TrackCount = 0;
+
+const float Tau = 6.28318530718f;
+
+
+// How far through its own animation a glyph is, 0 before it starts and 1 once it's done. Instant when duration is 0
+float GetProgress(const float glyphTime, const float duration)
+{
+    if(duration <= 0.0f)
+        return glyphTime >= 0.0f ? 1.0f : 0.0f;
+
+    return clamp(glyphTime / duration, 0.0f, 1.0f);
+};
+
+
+void main()
+{
+    const uint instance = gl_GlobalInvocationID.x;
+
+    if(instance >= InstanceCount)
+        return;
+
+    // Glyphs no track covers are drawn as they were laid out, which also puts back the glyphs of tracks that just finished
+    GlyphAnimation animation = GlyphAnimation(vec2(0.0f), 1.0f, 0.0f);
+
+    // A handful of tracks play at once, so every glyph looks through all of them. Later tracks win where they overlap
+    for(uint trackIndex = 0; trackIndex < TrackCount; ++trackIndex)
+    {
+        const TextAnimationTrack track = Tracks[trackIndex];
+
+        if(instance < track.FirstInstance || instance - track.FirstInstance >= track.InstanceCount)
+            continue;
+
+        // The time since this glyph's own start
+        const float glyphTime = Time - track.StartTime - (float(instance - track.FirstInstance) * track.Stagger);
+
+        const float progress = GetProgress(glyphTime, track.Duration);
+
+        if(track.Effect == EffectFade || track.Effect == EffectTypewriter)
+        {
+            animation = GlyphAnimation(vec2(0.0f), progress, 0.0f);
+        }
+        else if(track.Effect == EffectSlide)
+        {
+            animation = GlyphAnimation(track.Offset * (1.0f - smoothstep(0.0f, 1.0f, progress)), progress, 0.0f);
+        }
+        else if(track.Effect == EffectWave)
+        {
+            const float phase = track.Duration > 0.0f ? glyphTime / track.Duration : 0.0f;
+
+            animation = GlyphAnimation(track.Offset * sin(phase * Tau), 1.0f, 0.0f);
+        };
+    };
+
+    GlyphAnimations[instance] = animation;
+};
\ No newline at end of file
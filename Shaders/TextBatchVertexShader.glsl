@@ -0,0 +1,201 @@
+#version 460 core
+
+struct GlyphInstance
+{
+    // The top-left corner of the glyph, in screen space
+    vec2 Position;
+
+    // Index of the glyph inside the font sprite in the low 24 bits, the string's layer in the high 8
+    uint GlyphIndex;
+
+    // The font's index in a FontSet, 0 otherwise, in the low 8 bits. The string's GlyphStyle in the next 8. The glyph's clip rectangle in the high 16, 0 if it isn't clipped
+    uint FontStyleAndClipIndex;
+
+    // RGBA8, red in the low byte
+    uint Colour;
+
+    // Half floats: how much the glyph is scaled from the size it was rasterized at, its position already is, then the width of its cell, scaled
+    uint ScaleAndCellWidth;
+};
+
+
+layout(std430, binding = 0) readonly buffer BatchInput
+{
+    uint GlyphWidth;
+    uint GlyphHeight;
+
+    uint TextureWidth;
+    uint TextureHeight;
+
+    vec4 ChromaKey;
+
+    GlyphInstance Glyphs[];
+};
+
+struct GlyphMetrics
+{
+    // Left, top, right, bottom
+    vec4 TextureRect;
+
+    vec2 Size;
+    vec2 Bearing;
+
+    float Advance;
+
+    // The texture array layer, see GlyphAtlas.hpp
+    uint Layer;
+
+    // GLYPH_COLOUR if the layer is a colour layer
+    uint Flags;
+};
+
+// Built once by FontSprite, or filled on demand by a GlyphAtlas. Indexed by glyph
+layout(std430, binding = 1) readonly buffer GlyphMetricsTable
+{
+    GlyphMetrics GlyphTable[];
+};
+
+// Left, top, right, bottom, in the same space as the glyphs' positions. Clip index N is at N - 1, see TextBatch::PushClip
+layout(std430, binding = 16) readonly buffer ClipRectsBuffer
+{
+    vec4 ClipRects[];
+};
+
+// Shared by every draw in a frame, see FrameUniformBuffer.hpp
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 Projection;
+    mat4 View;
+
+    vec2 ViewportSize;
+    float Time;
+};
+
+// (GlyphAtlas usage feedback) A bit per metrics slot, set for every glyph that's drawn, see GlyphAtlas::EndFrame
+layout(std430, binding = 19) buffer GlyphUsageBuffer
+{
+    uint GlyphUsage[];
+};
+
+uniform bool GlyphUsageFeedback = false;
+
+// (Picking) Each instance's run and its index in the run, only bound while a TextBatch draws into its TextPickingBuffer
+layout(std430, binding = 20) readonly buffer TextPickIDsBuffer
+{
+    uvec2 PickIDs[];
+};
+
+uniform bool TextPicking = false;
+
+uniform mat4 TextTransform = mat4(1.0f);
+
+// GlyphStyle bits, see TextStyle.hpp
+const uint GlyphStyleUnderline = 1u << 0;
+const uint GlyphStyleStrikethrough = 1u << 1;
+
+
+
+out vec2 VertexShaderTextureCoordinateOutput;
+out vec4 VertexShaderChromaKeyOutput;
+out vec4 VertexShaderTextColourOutput;
+// The texture array layer, or the texture handle's index with a bindless FontSet
+flat out uint VertexShaderLayerOutput;
+// See GlyphMetrics.Flags
+flat out uint VertexShaderGlyphFlagsOutput;
+
+// The fragment shaders' decoration inputs: where the fragment is in the glyph's quad, and the string's style. See TextStyle.hpp
+out vec2 VertexShaderGlyphCoordinateOutput;
+flat out uint VertexShaderGlyphStyleOutput;
+// The glyph's texture rectangle, a decorated glyph's quad reaches past it
+flat out vec4 VertexShaderTextureRectOutput;
+// (Picking) Written to the pick target rather than a colour, see TextPicking.hpp
+flat out uvec2 VertexShaderPickOutput;
+
+// A clip rectangle's four edges, only enabled while a batch with clipped strings draws
+out float gl_ClipDistance[4];
+
+
+void main()
+{
+    const GlyphInstance glyph = Glyphs[gl_InstanceID];
+
+    const GlyphMetrics metrics = GlyphTable[glyph.GlyphIndex & 0xFFFFFFu];
+
+    const uint layer = glyph.GlyphIndex >> 24;
+
+    // The quad's corner, drawn as a triangle strip: (0, 0), (1, 0), (0, 1), (1, 1)
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    const uint style = (glyph.FontStyleAndClipIndex >> 8) & 0xFFu;
+
+    const vec2 scaleAndCellWidth = unpackHalf2x16(glyph.ScaleAndCellWidth);
+
+    const vec2 glyphBearing = metrics.Bearing * scaleAndCellWidth.x;
+    const vec2 glyphSize = metrics.Size * scaleAndCellWidth.x;
+
+    vec2 quadMinimum = glyphBearing;
+    vec2 quadMaximum = glyphBearing + glyphSize;
+
+    // Glyphs' quads only cover their ink. A decorated glyph's quad covers its whole cell instead, from the pen to the next glyph's pen and over the line's height,
+    // so the fragment shader draws the underline and strikethrough unbroken across it. See FontSpriteVertexShader.glsl
+    if((style & (GlyphStyleUnderline | GlyphStyleStrikethrough)) != 0u)
+    {
+        quadMinimum = min(quadMinimum, vec2(0.0f));
+        quadMaximum = max(quadMaximum, vec2(scaleAndCellWidth.y, float(GlyphHeight) * scaleAndCellWidth.x));
+    };
+
+    const vec2 vertexPosition = mix(quadMinimum, quadMaximum, corner);
+
+    // Past the glyph's bitmap the coordinates run on out of its texture rectangle, which the fragment shaders test against
+    const vec2 bitmapCoordinate = (vertexPosition - glyphBearing) / max(glyphSize, vec2(1e-6f));
+
+
+    VertexShaderTextureCoordinateOutput = mix(metrics.TextureRect.xy, metrics.TextureRect.zw, bitmapCoordinate);
+    VertexShaderTextureRectOutput = metrics.TextureRect;
+    VertexShaderTextColourOutput = unpackUnorm4x8(glyph.Colour);
+    VertexShaderChromaKeyOutput = ChromaKey;
+    VertexShaderLayerOutput = metrics.Layer + (glyph.FontStyleAndClipIndex & 0xFFu);
+    VertexShaderGlyphFlagsOutput = metrics.Flags;
+    VertexShaderGlyphCoordinateOutput = corner;
+    VertexShaderGlyphStyleOutput = style;
+    VertexShaderPickOutput = TextPicking == true ? PickIDs[gl_InstanceID] : uvec2(0u);
+
+    const vec2 position = vertexPosition + glyph.Position;
+
+    const uint clipIndex = glyph.FontStyleAndClipIndex >> 16;
+
+    // The clip is per glyph rather than per draw, so differently clipped strings still share one draw without a scissor change between them
+    vec4 clip = vec4(-1e30f, -1e30f, 1e30f, 1e30f);
+
+    if(clipIndex != 0)
+        clip = ClipRects[clipIndex - 1];
+
+    // Edges crossing the glyph are clipped by the rasterizer
+    gl_ClipDistance[0] = position.x - clip.x;
+    gl_ClipDistance[1] = clip.z - position.x;
+    gl_ClipDistance[2] = position.y - clip.y;
+    gl_ClipDistance[3] = clip.w - position.y;
+
+    // Glyphs entirely outside their clip are collapsed to a point, so they're never set up or rasterized
+    const vec2 glyphMinimum = quadMinimum + glyph.Position;
+    const vec2 glyphMaximum = quadMaximum + glyph.Position;
+
+    const bool clippedAway = any(greaterThanEqual(glyphMinimum, clip.zw)) || any(lessThanEqual(glyphMaximum, clip.xy));
+
+    vec4 clipPosition = Projection * View * TextTransform * vec4(position, 0.0f, 1.0f);
+
+    // Higher layers are nearer, for batches that are depth-tested against other draws, see TextBatch::DepthTest
+    clipPosition.z = (0.5f - (float(layer) / 512.0f)) * clipPosition.w;
+
+    gl_Position = clippedAway == true ? vec4(0.0f) : clipPosition;
+
+    // Once per glyph, and only for glyphs that are drawn. Most glyphs were already marked by another instance, the read skips their atomic
+    if(GlyphUsageFeedback == true && gl_VertexID == 0 && clippedAway == false)
+    {
+        const uint slot = glyph.GlyphIndex & 0xFFFFFFu;
+        const uint bit = 1u << (slot & 31u);
+
+        if((GlyphUsage[slot >> 5] & bit) == 0u)
+            atomicOr(GlyphUsage[slot >> 5], bit);
+    };
+};
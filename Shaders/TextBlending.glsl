@@ -0,0 +1,33 @@
+// Included by the FontSprite fragment shaders. With LinearBlending set FontSprite blends the draw in linear light, through GL_FRAMEBUFFER_SRGB
+// and premultiplied alpha, so the text's sRGB colour is decoded and written premultiplied. See FontSprite::Blending
+
+uniform bool LinearBlending = false;
+
+// Raises partial coverage, 0 leaves it as it is. Strokes blended in linear light look thinner, this gives small text its weight back
+uniform float CoverageContrast = 0.0f;
+
+
+// A power curve, so empty and full coverage stay where they are
+float ApplyContrast(const float coverage)
+{
+    return CoverageContrast > 0.0f ? pow(coverage, 1.0f / (1.0f + CoverageContrast)) : coverage;
+};
+
+vec3 ApplyContrast(const vec3 coverage)
+{
+    return CoverageContrast > 0.0f ? pow(coverage, vec3(1.0f / (1.0f + CoverageContrast))) : coverage;
+};
+
+vec3 DecodeSRGB(const vec3 colour)
+{
+    return mix(colour / 12.92f, pow((colour + 0.055f) / 1.055f, vec3(2.4f)), greaterThan(colour, vec3(0.04045f)));
+};
+
+// The colour to write for a straight alpha colour, as the draw blends it
+vec4 ToBlendedOutput(const vec4 colour)
+{
+    if(LinearBlending == false)
+        return colour;
+
+    return vec4(DecodeSRGB(colour.rgb) * colour.a, colour.a);
+};
\ No newline at end of file
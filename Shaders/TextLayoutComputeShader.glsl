@@ -0,0 +1,709 @@
+#version 460 core
+
+// A single work group lays out the whole text, each phase is separated by a barrier so it all fits in one dispatch
+layout(local_size_x = 1024) in;
+
+const uint WorkGroupSize = 1024;
+
+
+// The "Input" block, generated from FontSpriteInputLayout. No 8-bit integers, so Characters are packed into uints, see BitsPerCharacter
+#include "FontSpriteInput.glsl"
+
+struct LaidOutGlyph
+{
+    // The glyph's top-left corner, relative to the text's origin
+    vec2 Position;
+
+    // The glyph's index in the low 24 bits, its span's style in the high 8, see GlyphStyleShift
+    uint GlyphIndex;
+
+    // Packed RGBA8, only used when the style has GlyphStyleHasColour set
+    uint Colour;
+};
+
+const uint GlyphStyleShift = 24;
+
+// Set in the style byte of glyphs that take their colour from a span instead of TextColour
+const uint GlyphStyleHasColour = 0x80u;
+
+// Set in the style byte of a span's background instances, which fill the glyph's cell with Colour instead of drawing the glyph
+const uint GlyphStyleBackground = 0x40u;
+
+// The style bits spans can set, the rest are the layout's own
+const uint GlyphStyleSpanMask = 0x3Fu;
+
+// The output, only the visible glyphs, compacted, starting at FirstInstance
+layout(std430, binding = 2) writeonly buffer GlyphInstancesBuffer
+{
+    LaidOutGlyph GlyphInstances[];
+};
+
+struct DrawArraysIndirectCommand
+{
+    uint VertexCount;
+    uint InstanceCount;
+    uint FirstVertex;
+    uint BaseInstance;
+};
+
+// The arguments of the glDrawArraysIndirect call that draws GlyphInstances, written to DrawCommands[DrawCommandIndex]
+layout(std430, binding = 6) writeonly buffer DrawCommandBuffer
+{
+    DrawArraysIndirectCommand DrawCommands[];
+};
+
+// Each character's column and row within its line
+layout(std430, binding = 5) coherent buffer GlyphCellsBuffer
+{
+    vec2 GlyphCells[];
+};
+
+// The line each character belongs to
+layout(std430, binding = 3) coherent buffer CharacterLinesBuffer
+{
+    uint CharacterLines[];
+};
+
+// x: The line's first character. y: The number of rows the line wraps into, then the line's first row
+layout(std430, binding = 4) coherent buffer LinesBuffer
+{
+    uvec2 Lines[];
+};
+
+// (UTF-8) The codepoints decoded from Characters[], one per character, which every later phase reads instead
+layout(std430, binding = 17) coherent buffer DecodedCharactersBuffer
+{
+    uint DecodedCharacters[];
+};
+
+
+// Character to glyph index, a page directory followed by the pages, see CodepointGlyphTable.hpp
+layout(std430, binding = 8) readonly buffer CodepointGlyphTableBuffer
+{
+    uint CodepointGlyphTable[];
+};
+
+const uint CodepointPageBits = 8;
+const uint CodepointDirectorySize = 0x110000u >> CodepointPageBits;
+
+struct GlyphMetrics
+{
+    // Left, top, right, bottom
+    vec4 TextureRect;
+
+    vec2 Size;
+    vec2 Bearing;
+
+    float Advance;
+
+    uint Layer;
+};
+
+// Only the advances are read, and only by proportional layouts
+layout(std430, binding = 1) readonly buffer GlyphMetricsTable
+{
+    GlyphMetrics GlyphTable[];
+};
+
+// A glyph's kerning pairs are KerningEntries[KerningRanges[glyph] .. KerningRanges[glyph + 1]), sorted by SecondGlyph. See KerningTable.hpp
+layout(std430, binding = 9) readonly buffer KerningRangesBuffer
+{
+    uint KerningRanges[];
+};
+
+struct KerningEntry
+{
+    uint SecondGlyph;
+    float Adjustment;
+};
+
+layout(std430, binding = 10) readonly buffer KerningEntriesBuffer
+{
+    KerningEntry KerningEntries[];
+};
+
+
+uniform uint CharacterCount = 0;
+
+// How many bits a single character occupies in Characters[], either 32, 16 or 8
+uniform uint BitsPerCharacter = 32;
+
+// Characters[] holds UTF-8, 8 bits per byte, and CharacterCount counts bytes. The first phase decodes it into DecodedCharacters
+uniform uint Utf8 = 0;
+
+// The high bits of every character that index PaletteColours, 0 for none. Index 0 is the draw's own colour
+uniform uint PaletteBits = 0;
+
+// Packed RGBA8, see FontSprite::SetPalette
+layout(std430, binding = 18) readonly buffer TextPaletteBuffer
+{
+    uint PaletteColours[];
+};
+
+// (Text rings) Characters[] is a ring of this many characters, and the text starts at RingFirstCharacter. 0 reads the text from the start of Characters[]
+uniform uint RingCapacity = 0;
+uniform uint RingFirstCharacter = 0;
+
+// Tabs advance to the next multiple of TabSize columns
+uniform uint TabSize = 4;
+
+// Lines wrap after this many columns, 0 disables wrapping
+uniform uint WrapColumns = 0;
+
+// A styled draw's colour and style changes, sorted by FirstCharacter. See TextStyle.hpp
+struct TextSpan
+{
+    uint FirstCharacter;
+    uint Colour;
+    uint Style;
+
+    // Packed RGBA8, 0 alpha for no background
+    uint Background;
+};
+
+layout(std430, binding = 11) readonly buffer TextSpansBuffer
+{
+    TextSpan Spans[];
+};
+
+// 0 draws every glyph with TextColour and no style
+uniform uint SpanCount = 0;
+
+// Advance by each glyph's metrics and kerning rather than by columns, GlyphCells then holds pixels
+uniform uint Proportional = 0;
+
+// (Proportional) Lines wrap once they're wider than this, in pixels. 0 disables wrapping
+uniform float WrapWidth = 0.0f;
+
+uniform float LineHeight = 0.0f;
+
+// The height of a glyph's quad, used to cull glyphs outside the viewport
+uniform float GlyphHeightForCulling = 0.0f;
+
+uniform mat4 TextTransform = mat4(1.0f);
+
+// Glyphs outside the viewport are left out, unless the glyphs are kept and drawn with other transforms later
+uniform uint CullGlyphs = 1;
+
+// Where the glyphs and the draw command are written, the command draws from FirstInstance through its base instance
+uniform uint FirstInstance = 0;
+uniform uint DrawCommandIndex = 0;
+
+// Glyph quads are 4 vertex triangle strips
+const uint GlyphQuadVertexCount = 4;
+
+
+// Shared by every draw in a frame, see FrameUniformBuffer.hpp
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 Projection;
+    mat4 View;
+
+    vec2 ViewportSize;
+    float Time;
+};
+
+
+shared uint ScanShared[WorkGroupSize];
+
+// The number of characters laid out, CharacterCount, or the number of codepoints decoded from it
+uint TextLength = 0;
+
+
+// Read a single, possibly packed, character, or byte of UTF-8
+uint GetPackedCharacter(uint index)
+{
+    if(RingCapacity != 0)
+        index = (RingFirstCharacter + index) % RingCapacity;
+
+    if(BitsPerCharacter == 32)
+        return Characters[index];
+
+    const uint charactersPerWord = 32 / BitsPerCharacter;
+
+    const uint word = Characters[index / charactersPerWord];
+
+    return bitfieldExtract(word, int((index % charactersPerWord) * BitsPerCharacter), int(BitsPerCharacter));
+};
+
+// Read a single character, once the text was decoded, without its palette index
+uint GetCharacter(uint index)
+{
+    if(Utf8 != 0)
+        return DecodedCharacters[index];
+
+    return PaletteBits != 0 ? bitfieldExtract(GetPackedCharacter(index), 0, int(BitsPerCharacter - PaletteBits)) : GetPackedCharacter(index);
+};
+
+// A paletted character's palette index
+uint GetPaletteIndex(uint index)
+{
+    return bitfieldExtract(GetPackedCharacter(index), int(BitsPerCharacter - PaletteBits), int(PaletteBits));
+};
+
+
+// Look a character up in CodepointGlyphTable, anything past U+10FFFF reads the default page
+uint GetGlyphIndex(uint character)
+{
+    const uint page = character < (CodepointDirectorySize << CodepointPageBits) ? CodepointGlyphTable[character >> CodepointPageBits] : 0u;
+
+    return CodepointGlyphTable[CodepointDirectorySize + (page << CodepointPageBits) + (character & ((1u << CodepointPageBits) - 1u))];
+};
+
+
+// The adjustment to the first glyph's advance when it's followed by the second
+float GetKerning(uint firstGlyph, uint secondGlyph)
+{
+    if(firstGlyph + 1 >= uint(KerningRanges.length()))
+        return 0.0f;
+
+    uint low = KerningRanges[firstGlyph];
+    uint high = KerningRanges[firstGlyph + 1];
+
+    while(low < high)
+    {
+        const uint middle = (low + high) / 2;
+
+        if(KerningEntries[middle].SecondGlyph < secondGlyph)
+            low = middle + 1;
+        else
+            high = middle;
+    };
+
+    return (low < KerningRanges[firstGlyph + 1] && KerningEntries[low].SecondGlyph == secondGlyph) ? KerningEntries[low].Adjustment : 0.0f;
+};
+
+
+// The span a character belongs to, SpanCount if it comes before the first one
+uint FindSpan(uint characterIndex)
+{
+    uint low = 0;
+    uint high = SpanCount;
+
+    while(low < high)
+    {
+        const uint middle = (low + high) / 2;
+
+        if(Spans[middle].FirstCharacter <= characterIndex)
+            low = middle + 1;
+        else
+            high = middle;
+    };
+
+    return low == 0 ? SpanCount : low - 1;
+};
+
+
+// A laid out character's top-left corner, in pixels from the text's origin. Only valid once the rows were turned into first rows
+vec2 GetGlyphPosition(uint characterIndex)
+{
+    const vec2 cell = GlyphCells[characterIndex];
+    const float row = float(Lines[CharacterLines[characterIndex]].y) + cell.y;
+
+    return vec2(Proportional != 0 ? cell.x : cell.x * float(GlyphWidth), row * LineHeight);
+};
+
+// Whether a rectangle of the text is inside the viewport, always true if glyphs aren't culled
+bool IsOnScreen(vec2 position, vec2 size)
+{
+    if(CullGlyphs == 0)
+        return true;
+
+    const mat4 textToClip = Projection * View * TextTransform;
+
+    const vec4 topLeft = textToClip * vec4(position, 0.0f, 1.0f);
+    const vec4 bottomRight = textToClip * vec4(position + size, 0.0f, 1.0f);
+
+    const vec2 clipMin = min(topLeft.xy / topLeft.w, bottomRight.xy / bottomRight.w);
+    const vec2 clipMax = max(topLeft.xy / topLeft.w, bottomRight.xy / bottomRight.w);
+
+    return all(greaterThanEqual(clipMax, vec2(-1.0f))) && all(lessThanEqual(clipMin, vec2(1.0f)));
+};
+
+
+// Work group wide exclusive prefix sum, must be called by every invocation
+uint ExclusiveScan(uint value, out uint total)
+{
+    const uint index = gl_LocalInvocationIndex;
+
+    ScanShared[index] = value;
+    barrier();
+
+    for(uint offset = 1; offset < WorkGroupSize; offset <<= 1)
+    {
+        const uint addend = index >= offset ? ScanShared[index - offset] : 0u;
+        barrier();
+
+        ScanShared[index] += addend;
+        barrier();
+    };
+
+    total = ScanShared[WorkGroupSize - 1];
+    const uint inclusive = ScanShared[index];
+    barrier();
+
+    return inclusive - value;
+};
+
+
+const uint ReplacementCharacter = 0xFFFDu;
+
+bool IsContinuationByte(uint byte)
+{
+    return (byte & 0xC0u) == 0x80u;
+};
+
+// The number of bytes a lead byte's sequence takes, 0 for bytes that can't start one
+uint GetSequenceLength(uint byte)
+{
+    if(byte < 0x80u)
+        return 1;
+
+    if(byte >= 0xC2u && byte <= 0xDFu)
+        return 2;
+
+    if(byte >= 0xE0u && byte <= 0xEFu)
+        return 3;
+
+    if(byte >= 0xF0u && byte <= 0xF4u)
+        return 4;
+
+    return 0;
+};
+
+// Whether a byte starts a character: anything but a continuation byte that belongs to the lead byte before it.
+// Stray continuation bytes start characters of their own, which decode as the replacement character, the way DecodeUTF8ToGlyphText replaces them
+bool IsCharacterStart(uint byteIndex)
+{
+    if(IsContinuationByte(GetPackedCharacter(byteIndex)) == false)
+        return true;
+
+    for(uint distance = 1; distance <= 3 && distance <= byteIndex; ++distance)
+    {
+        const uint byte = GetPackedCharacter(byteIndex - distance);
+
+        if(IsContinuationByte(byte) == false)
+            return GetSequenceLength(byte) <= distance;
+    };
+
+    return true;
+};
+
+// Decode the character starting at a byte, anything malformed, overlong, a surrogate or past U+10FFFF is the replacement character
+uint DecodeCharacter(uint byteIndex)
+{
+    const uint lead = GetPackedCharacter(byteIndex);
+    const uint length = GetSequenceLength(lead);
+
+    if(length == 1)
+        return lead;
+
+    if(length == 0 || byteIndex + length > CharacterCount)
+        return ReplacementCharacter;
+
+    uint codepoint = lead & (0x7Fu >> length);
+
+    for(uint offset = 1; offset < length; ++offset)
+    {
+        const uint byte = GetPackedCharacter(byteIndex + offset);
+
+        if(IsContinuationByte(byte) == false)
+            return ReplacementCharacter;
+
+        codepoint = (codepoint << 6) | (byte & 0x3Fu);
+    };
+
+    const uint shortest = length == 2 ? 0x80u : (length == 3 ? 0x800u : 0x10000u);
+
+    if(codepoint < shortest || codepoint > 0x10FFFFu || (codepoint >= 0xD800u && codepoint <= 0xDFFFu))
+        return ReplacementCharacter;
+
+    return codepoint;
+};
+
+// Decode every byte into DecodedCharacters, in parallel: each byte is classified as a character start or not,
+// a scan of the starts numbers the characters, and each start decodes its own sequence into its slot. Returns the number of characters
+uint DecodeUtf8()
+{
+    const uint invocation = gl_LocalInvocationIndex;
+
+    uint characterCount = 0;
+
+    for(uint tileStart = 0; tileStart < CharacterCount; tileStart += WorkGroupSize)
+    {
+        const uint byteIndex = tileStart + invocation;
+        const bool start = byteIndex < CharacterCount && IsCharacterStart(byteIndex) == true;
+
+        uint tileCharacters = 0;
+        const uint characterIndex = characterCount + ExclusiveScan(start == true ? 1u : 0u, tileCharacters);
+
+        if(start == true)
+            DecodedCharacters[characterIndex] = DecodeCharacter(byteIndex);
+
+        characterCount += tileCharacters;
+    };
+
+    memoryBarrierBuffer();
+    barrier();
+
+    return characterCount;
+};
+
+
+void main()
+{
+    const uint invocation = gl_LocalInvocationIndex;
+
+    TextLength = Utf8 != 0 ? DecodeUtf8() : CharacterCount;
+
+
+    // Find where every line starts, a newline's line index is the number of newlines before it
+    uint lineCount = 0;
+
+    for(uint tileStart = 0; tileStart < TextLength; tileStart += WorkGroupSize)
+    {
+        const uint characterIndex = tileStart + invocation;
+        const bool inRange = characterIndex < TextLength;
+
+        const uint newline = (inRange == true && GetCharacter(characterIndex) == 10) ? 1u : 0u;
+
+        uint tileNewlines = 0;
+        const uint line = lineCount + ExclusiveScan(newline, tileNewlines);
+
+        if(inRange == true)
+        {
+            CharacterLines[characterIndex] = line;
+
+            if(newline == 1)
+                Lines[line + 1].x = characterIndex + 1;
+        };
+
+        lineCount += tileNewlines;
+    };
+
+    lineCount += 1;
+
+    // The sentinel makes every line end one character before the next line starts
+    if(invocation == 0)
+    {
+        Lines[0].x = 0;
+        Lines[lineCount].x = TextLength + 1;
+    };
+
+    memoryBarrierBuffer();
+    barrier();
+
+
+    // Lay out each line's characters, one line per invocation
+    const float tabWidth = Proportional != 0 ? max(float(TabSize) * GlyphTable[GetGlyphIndex(32)].Advance, 1.0f) : 0.0f;
+
+    for(uint line = invocation; line < lineCount; line += WorkGroupSize)
+    {
+        const uint lineStart = Lines[line].x;
+        const uint lineEnd = min(Lines[line + 1].x - 1, TextLength);
+
+        // A running sum of the advances, so every glyph's offset is computed once per layout rather than per draw
+        if(Proportional != 0)
+        {
+            float penX = 0.0f;
+            uint row = 0;
+
+            uint previousGlyph = 0xFFFFFFFFu;
+
+            for(uint characterIndex = lineStart; characterIndex < lineEnd; ++characterIndex)
+            {
+                const uint character = GetCharacter(characterIndex);
+
+                // Control characters have no width, tabs advance to the next stop
+                uint glyph = 0xFFFFFFFFu;
+                float advance = 0.0f;
+
+                if(character >= 32)
+                {
+                    glyph = GetGlyphIndex(character);
+                    advance = GlyphTable[glyph].Advance;
+
+                    if(previousGlyph != 0xFFFFFFFFu)
+                        penX += GetKerning(previousGlyph, glyph);
+                }
+                else if(character == 9)
+                    advance = (floor(penX / tabWidth) + 1.0f) * tabWidth - penX;
+
+                if(WrapWidth > 0.0f && penX > 0.0f && penX + advance > WrapWidth)
+                {
+                    row += 1;
+                    penX = 0.0f;
+
+                    if(character == 9)
+                        advance = tabWidth;
+                };
+
+                GlyphCells[characterIndex] = vec2(penX, row);
+
+                penX += advance;
+                previousGlyph = glyph;
+            };
+
+            if(lineEnd < TextLength)
+                GlyphCells[lineEnd] = vec2(penX, row);
+
+            Lines[line].y = row + 1;
+            continue;
+        };
+
+        uint column = 0;
+        uint row = 0;
+
+        for(uint characterIndex = lineStart; characterIndex < lineEnd; ++characterIndex)
+        {
+            uint nextColumn = column + 1;
+
+            if(GetCharacter(characterIndex) == 9)
+                nextColumn = ((column / TabSize) + 1) * TabSize;
+
+            if(WrapColumns != 0 && column != 0 && nextColumn > WrapColumns)
+            {
+                row += 1;
+
+                nextColumn -= column;
+                column = 0;
+            };
+
+            GlyphCells[characterIndex] = vec2(column, row);
+
+            column = nextColumn;
+        };
+
+        // The newline itself, it's never drawn but still needs a position
+        if(lineEnd < TextLength)
+            GlyphCells[lineEnd] = vec2(column, row);
+
+        Lines[line].y = row + 1;
+    };
+
+    memoryBarrierBuffer();
+    barrier();
+
+
+    // Turn each line's row count into its first row
+    uint rowCount = 0;
+
+    for(uint tileStart = 0; tileStart < lineCount; tileStart += WorkGroupSize)
+    {
+        const uint line = tileStart + invocation;
+        const bool inRange = line < lineCount;
+
+        uint tileRows = 0;
+        const uint firstRow = rowCount + ExclusiveScan(inRange == true ? Lines[line].y : 0u, tileRows);
+
+        if(inRange == true)
+            Lines[line].y = firstRow;
+
+        rowCount += tileRows;
+    };
+
+    memoryBarrierBuffer();
+    barrier();
+
+
+    // Convert columns and rows into pixels, and compact the glyphs that actually draw something.
+    // Span backgrounds are written first, so every glyph is drawn over them within the same draw
+    uint instanceCount = 0;
+
+    if(SpanCount != 0)
+    {
+        for(uint tileStart = 0; tileStart < TextLength; tileStart += WorkGroupSize)
+        {
+            const uint characterIndex = tileStart + invocation;
+
+            bool visible = false;
+            vec2 position = vec2(0.0f);
+            uint glyph = 0;
+            uint background = 0;
+
+            if(characterIndex < TextLength)
+            {
+                const uint character = GetCharacter(characterIndex);
+                const uint span = FindSpan(characterIndex);
+
+                // Spaces are filled too, so a highlighted run has no gaps. Tabs and newlines aren't
+                if(span < SpanCount && character >= 32 && (Spans[span].Background >> 24) != 0)
+                {
+                    glyph = GetGlyphIndex(character);
+                    background = Spans[span].Background;
+
+                    position = GetGlyphPosition(characterIndex);
+
+                    const float width = Proportional != 0 ? GlyphTable[glyph].Advance : float(GlyphWidth);
+
+                    visible = IsOnScreen(position, vec2(width, LineHeight));
+                };
+            };
+
+            uint tileInstances = 0;
+            const uint instanceIndex = instanceCount + ExclusiveScan(visible == true ? 1u : 0u, tileInstances);
+
+            if(visible == true)
+                GlyphInstances[FirstInstance + instanceIndex] = LaidOutGlyph(position, glyph | ((GlyphStyleBackground | GlyphStyleHasColour) << GlyphStyleShift), background);
+
+            instanceCount += tileInstances;
+        };
+    };
+
+
+    for(uint tileStart = 0; tileStart < TextLength; tileStart += WorkGroupSize)
+    {
+        const uint characterIndex = tileStart + invocation;
+
+        bool visible = false;
+        vec2 position = vec2(0.0f);
+        uint character = 0;
+
+        if(characterIndex < TextLength)
+        {
+            character = GetCharacter(characterIndex);
+
+            position = GetGlyphPosition(characterIndex);
+
+            // Control characters and spaces only move the following characters
+            if(character > 32)
+                visible = IsOnScreen(position, vec2(float(GlyphWidth), GlyphHeightForCulling));
+        };
+
+        uint tileInstances = 0;
+        const uint instanceIndex = instanceCount + ExclusiveScan(visible == true ? 1u : 0u, tileInstances);
+
+        if(visible == true)
+        {
+            uint style = 0;
+            uint colour = 0;
+
+            const uint span = SpanCount != 0 ? FindSpan(characterIndex) : SpanCount;
+
+            if(span < SpanCount)
+            {
+                style = (Spans[span].Style & GlyphStyleSpanMask) | GlyphStyleHasColour;
+                colour = Spans[span].Colour;
+            };
+
+            // A palette index picks the glyph's colour as a span's colour would, so it's drawn the same way
+            const uint paletteIndex = PaletteBits != 0 ? GetPaletteIndex(characterIndex) : 0u;
+
+            if(paletteIndex != 0)
+            {
+                style |= GlyphStyleHasColour;
+                colour = PaletteColours[paletteIndex];
+            };
+
+            GlyphInstances[FirstInstance + instanceIndex] = LaidOutGlyph(position, GetGlyphIndex(character) | (style << GlyphStyleShift), colour);
+        };
+
+        instanceCount += tileInstances;
+    };
+
+
+    if(invocation == 0)
+    {
+        DrawCommands[DrawCommandIndex] = DrawArraysIndirectCommand(GlyphQuadVertexCount, instanceCount, 0, FirstInstance);
+    };
+};
\ No newline at end of file
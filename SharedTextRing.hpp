@@ -0,0 +1,397 @@
+#pragma once
+
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "TextRing.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The start of a shared text ring's mapping, followed by CapacityInBytes bytes of text.
+/// Shared between processes, so it only holds plain integers and lock-free atomics
+/// </summary>
+struct SharedTextRingHeader
+{
+    static constexpr std::uint32_t Magic = 0x474E5254; // "TRNG"
+
+    static constexpr std::uint32_t Version = 1;
+
+
+    std::uint32_t MagicValue;
+    std::uint32_t VersionValue;
+
+    /// <summary>
+    /// A power of 2, so positions wrap with a mask
+    /// </summary>
+    std::uint64_t CapacityInBytes;
+
+    /// <summary>
+    /// The total number of bytes ever written, only written by the producer.
+    /// On its own cache line, so the processes don't invalidate each other's line on every write and read
+    /// </summary>
+    alignas(64) std::atomic<std::uint64_t> Head;
+
+    /// <summary>
+    /// The bytes the producer couldn't write because the ring was full
+    /// </summary>
+    std::atomic<std::uint64_t> DroppedBytes;
+
+    /// <summary>
+    /// The total number of bytes ever read, only written by the consumer
+    /// </summary>
+    alignas(64) std::atomic<std::uint64_t> Tail;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free == true, "Atomics shared between processes must be lock-free");
+
+static_assert(sizeof(SharedTextRingHeader) == 192, "SharedTextRingHeader is shared with producers built separately");
+
+
+/// <summary>
+/// The mapping of a shared text ring, created by the renderer or opened by a producer
+/// </summary>
+class SharedTextRingMapping
+{
+
+private:
+
+    wt::SmartWin32Handle _mapping = nullptr;
+
+    SharedTextRingHeader* _header = nullptr;
+
+    std::byte* _data = nullptr;
+
+    /// <summary>
+    /// The header's capacity, read once when mapped so the other process can't change it under us
+    /// </summary>
+    std::uint64_t _capacity = 0;
+
+
+public:
+
+    /// <summary>
+    /// Create a ring's mapping, in the page file, or open it if it exists
+    /// </summary>
+    /// <param name="name"> The mapping's name, e.g. L"Local\\TelemetryText" </param>
+    /// <param name="capacityInBytes"> Rounded up to a power of 2. Ignored if the mapping already exists </param>
+    SharedTextRingMapping(const std::wstring& name, const std::size_t capacityInBytes)
+    {
+        const std::uint64_t capacity = std::bit_ceil<std::uint64_t>(std::max<std::uint64_t>(capacityInBytes, 4096));
+        const std::uint64_t mappingSize = sizeof(SharedTextRingHeader) + capacity;
+
+        _mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize), name.c_str());
+
+        const bool alreadyExists = GetLastError() == ERROR_ALREADY_EXISTS;
+
+        wt::Assert(_mapping.Get() != nullptr, "Unable to create a shared text ring's mapping");
+
+        if(Map() == false)
+            return;
+
+        // A new mapping is zeroed until the magic is stored. A producer opening it before then fails validation and has to open it again
+        if(alreadyExists == false)
+        {
+            _header->CapacityInBytes = capacity;
+            _header->VersionValue = SharedTextRingHeader::Version;
+
+            _capacity = capacity;
+
+            std::atomic_ref<std::uint32_t>(_header->MagicValue).store(SharedTextRingHeader::Magic, std::memory_order_release);
+        }
+        else if(Validate() == false)
+            Unmap();
+    };
+
+    /// <summary>
+    /// Open an existing ring's mapping, from a producer
+    /// </summary>
+    /// <param name="name"> The mapping's name </param>
+    explicit SharedTextRingMapping(const std::wstring& name)
+    {
+        _mapping = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+
+        if(_mapping.Get() == nullptr)
+            return;
+
+        if(Map() == false || Validate() == false)
+            Unmap();
+    };
+
+    SharedTextRingMapping(const SharedTextRingMapping&) = delete;
+    SharedTextRingMapping& operator = (const SharedTextRingMapping&) = delete;
+
+    ~SharedTextRingMapping()
+    {
+        Unmap();
+    };
+
+
+public:
+
+    /// <summary>
+    /// False if the mapping couldn't be created or opened, or was created by an incompatible version
+    /// </summary>
+    bool IsMapped() const
+    {
+        return _header != nullptr;
+    };
+
+    SharedTextRingHeader& GetHeader() const
+    {
+        return *_header;
+    };
+
+    std::byte* GetData() const
+    {
+        return _data;
+    };
+
+    /// <summary>
+    /// The size of the ring's text, validated against the mapped view when it was mapped
+    /// </summary>
+    std::uint64_t GetCapacity() const
+    {
+        return _capacity;
+    };
+
+
+private:
+
+    bool Map()
+    {
+        void* view = MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+
+        if(view == nullptr)
+            return false;
+
+        _header = static_cast<SharedTextRingHeader*>(view);
+        _data = static_cast<std::byte*>(view) + sizeof(SharedTextRingHeader);
+
+        return true;
+    };
+
+    bool Validate()
+    {
+        if(std::atomic_ref<std::uint32_t>(_header->MagicValue).load(std::memory_order_acquire) != SharedTextRingHeader::Magic ||
+           _header->VersionValue != SharedTextRingHeader::Version)
+            return false;
+
+        const std::uint64_t capacity = _header->CapacityInBytes;
+
+        if(std::has_single_bit(capacity) == false)
+            return false;
+
+        // The mapping may have been created, by another process, smaller than its header claims
+        MEMORY_BASIC_INFORMATION viewInformation = { };
+
+        if(VirtualQuery(_header, &viewInformation, sizeof(viewInformation)) == 0 ||
+           viewInformation.RegionSize < sizeof(SharedTextRingHeader) + capacity)
+            return false;
+
+        _capacity = capacity;
+
+        return true;
+    };
+
+    void Unmap()
+    {
+        if(_header != nullptr)
+            UnmapViewOfFile(_header);
+
+        _header = nullptr;
+        _data = nullptr;
+        _capacity = 0;
+    };
+
+};
+
+
+/// <summary>
+/// The renderer's end of a named shared-memory ring that another process writes text into, e.g. a telemetry collector.
+/// Exactly one producer and one consumer, synchronized only by the header's head and tail, so neither ever waits on the other.
+/// The text is read where the producer wrote it: Consume hands out views into the mapping, at most 2 when the text wraps around,
+/// which TextRing converts straight into its upload, so nothing is copied in between. See SharedTextRingWriter for the producer's end
+/// </summary>
+class SharedTextRing
+{
+
+private:
+
+    SharedTextRingMapping _mapping;
+
+
+public:
+
+    /// <param name="name"> The mapping's name, which producers open the ring by </param>
+    /// <param name="capacityInBytes"> How much unread text the ring holds, rounded up to a power of 2 </param>
+    SharedTextRing(const std::wstring& name, const std::size_t capacityInBytes) :
+        _mapping(name, capacityInBytes)
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// Read everything written since the last call
+    /// </summary>
+    /// <param name="consume"> Called with the unread text, once or twice when it wraps around. The views are only valid during the call </param>
+    /// <returns> The number of bytes read </returns>
+    template<typename TFunction>
+    std::size_t Consume(TFunction&& consume)
+    {
+        if(_mapping.IsMapped() == false)
+            return 0;
+
+        SharedTextRingHeader& header = _mapping.GetHeader();
+
+        const std::uint64_t capacity = _mapping.GetCapacity();
+
+        std::uint64_t tail = header.Tail.load(std::memory_order_relaxed);
+        const std::uint64_t head = header.Head.load(std::memory_order_acquire);
+
+        if(head == tail)
+            return 0;
+
+        // The producer never writes more than the capacity ahead of the tail, so a larger distance, or a head behind the tail, is corruption.
+        // Only the last capacity's worth of bytes is read, the rest are counted as dropped
+        if(head - tail > capacity)
+        {
+            header.DroppedBytes.fetch_add(head - tail - capacity, std::memory_order_relaxed);
+
+            tail = head - capacity;
+        };
+
+        const std::uint64_t mask = capacity - 1;
+
+        const std::size_t size = static_cast<std::size_t>(head - tail);
+        const std::size_t start = static_cast<std::size_t>(tail & mask);
+        const std::size_t firstPieceSize = std::min<std::size_t>(size, static_cast<std::size_t>(capacity) - start);
+
+        const char* data = reinterpret_cast<const char*>(_mapping.GetData());
+
+        consume(std::string_view(data + start, firstPieceSize));
+
+        if(firstPieceSize < size)
+            consume(std::string_view(data, size - firstPieceSize));
+
+        // Only now may the producer overwrite what was read
+        header.Tail.store(head, std::memory_order_release);
+
+        return size;
+    };
+
+    /// <summary>
+    /// Read everything written since the last call into a TextRing, which converts it straight out of the mapping
+    /// </summary>
+    /// <returns> The number of bytes read </returns>
+    std::size_t Consume(TextRing& ring)
+    {
+        return Consume([&](const std::string_view& text)
+        {
+            ring.Append(text);
+        });
+    };
+
+
+public:
+
+    bool IsMapped() const
+    {
+        return _mapping.IsMapped();
+    };
+
+    /// <summary>
+    /// The bytes producers couldn't write because the renderer didn't read fast enough
+    /// </summary>
+    std::uint64_t GetDroppedBytes() const
+    {
+        return _mapping.IsMapped() == true ? _mapping.GetHeader().DroppedBytes.load(std::memory_order_relaxed) : 0;
+    };
+
+};
+
+
+/// <summary>
+/// A producer's end of a SharedTextRing, opened by name from another process. Only one producer may write at a time
+/// </summary>
+class SharedTextRingWriter
+{
+
+private:
+
+    SharedTextRingMapping _mapping;
+
+    /// <summary>
+    /// The last tail seen, re-read only when the ring looks full
+    /// </summary>
+    std::uint64_t _cachedTail = 0;
+
+
+public:
+
+    /// <param name="name"> The name the renderer created the ring with </param>
+    explicit SharedTextRingWriter(const std::wstring& name) :
+        _mapping(name)
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// Write text into the ring, as much of it as fits. Text that doesn't is dropped and counted, the renderer is never waited on
+    /// </summary>
+    /// <returns> The number of bytes written </returns>
+    std::size_t Write(const std::string_view& text)
+    {
+        if(_mapping.IsMapped() == false || text.empty() == true)
+            return 0;
+
+        SharedTextRingHeader& header = _mapping.GetHeader();
+
+        const std::uint64_t capacity = _mapping.GetCapacity();
+        const std::uint64_t head = header.Head.load(std::memory_order_relaxed);
+
+        if(head - _cachedTail + text.size() > capacity)
+            _cachedTail = header.Tail.load(std::memory_order_acquire);
+
+        const std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(text.size(), capacity - (head - _cachedTail)));
+
+        if(size < text.size())
+            header.DroppedBytes.fetch_add(text.size() - size, std::memory_order_relaxed);
+
+        if(size == 0)
+            return 0;
+
+        const std::size_t start = static_cast<std::size_t>(head & (capacity - 1));
+        const std::size_t firstPieceSize = std::min<std::size_t>(size, static_cast<std::size_t>(capacity) - start);
+
+        std::byte* data = _mapping.GetData();
+
+        std::memcpy(data + start, text.data(), firstPieceSize);
+        std::memcpy(data, text.data() + firstPieceSize, size - firstPieceSize);
+
+        // Publishes the text to the renderer
+        header.Head.store(head + size, std::memory_order_release);
+
+        return size;
+    };
+
+
+public:
+
+    bool IsMapped() const
+    {
+        return _mapping.IsMapped();
+    };
+
+};
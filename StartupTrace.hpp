@@ -0,0 +1,218 @@
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+
+/// <summary>
+/// A phase of startup, as it appears in the trace
+/// </summary>
+struct StartupTraceEvent
+{
+    const char* Name = nullptr;
+
+    std::uint32_t ThreadID = 0;
+
+    /// <summary>
+    /// Since the trace started, which is before main
+    /// </summary>
+    double StartMicroseconds = 0.0;
+
+    /// <summary>
+    /// 0 for instant events, see StartupTrace::MarkInteractive
+    /// </summary>
+    double DurationMicroseconds = 0.0;
+
+    bool Instant = false;
+};
+
+
+/// <summary>
+/// Records how long every phase of startup takes, on whichever thread it runs, up to the point the window is interactive.
+/// Phases are timed by StartupPhase scopes, and the result is written in Chrome's trace event format,
+/// which chrome://tracing and Perfetto show as one lane per thread, so overlapping phases are easy to spot
+/// </summary>
+class StartupTrace
+{
+
+private:
+
+    mutable std::mutex _lock;
+
+    std::vector<StartupTraceEvent> _events;
+
+    std::int64_t _startTime = 0;
+
+    double _microsecondsPerTick = 0.0;
+
+    /// <summary>
+    /// Set by MarkInteractive, phases that end later aren't part of startup
+    /// </summary>
+    std::atomic<bool> _interactive = false;
+
+
+public:
+
+    StartupTrace()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+
+        _microsecondsPerTick = 1'000'000.0 / static_cast<double>(frequency.QuadPart);
+
+        _startTime = GetTime();
+
+        _events.reserve(64);
+    };
+
+    StartupTrace(const StartupTrace&) = delete;
+    StartupTrace& operator = (const StartupTrace&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// (Any thread) Record a phase that ran between two GetTime readings. Ignored once startup is over
+    /// </summary>
+    /// <param name="name"> Must outlive the trace, e.g. a literal </param>
+    void Record(const char* name, const std::int64_t beginTime, const std::int64_t endTime)
+    {
+        if(_interactive.load(std::memory_order_relaxed) == true)
+            return;
+
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        _events.push_back(StartupTraceEvent { .Name = name,
+                                              .ThreadID = static_cast<std::uint32_t>(GetCurrentThreadId()),
+                                              .StartMicroseconds = ToMicroseconds(beginTime - _startTime),
+                                              .DurationMicroseconds = ToMicroseconds(endTime - beginTime) });
+    };
+
+    /// <summary>
+    /// (Any thread) End startup, e.g. once the first frame is presented. Only the first call counts
+    /// </summary>
+    /// <returns> The milliseconds startup took, negative if it had already ended </returns>
+    double MarkInteractive()
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        if(_interactive.exchange(true, std::memory_order_relaxed) == true)
+            return -1.0;
+
+        const double now = ToMicroseconds(GetTime() - _startTime);
+
+        _events.push_back(StartupTraceEvent { .Name = "Interactive",
+                                              .ThreadID = static_cast<std::uint32_t>(GetCurrentThreadId()),
+                                              .StartMicroseconds = now,
+                                              .Instant = true });
+
+        return now / 1000.0;
+    };
+
+    bool IsInteractive() const
+    {
+        return _interactive.load(std::memory_order_relaxed);
+    };
+
+
+    /// <summary>
+    /// Write the phases recorded so far as a Chrome trace, "{ "traceEvents": [...] }"
+    /// </summary>
+    void WriteChromeTraceJSON(std::ostream& stream) const
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        const std::uint32_t processID = static_cast<std::uint32_t>(GetCurrentProcessId());
+
+        stream << "{ \"traceEvents\": [\n";
+
+        for(std::size_t index = 0; index < _events.size(); ++index)
+        {
+            const StartupTraceEvent& event = _events[index];
+
+            // Phase names are ours, nothing in them needs escaping
+            char line[256] = { };
+
+            if(event.Instant == true)
+            {
+                std::snprintf(line, sizeof(line),
+                              "  { \"name\": \"%s\", \"ph\": \"i\", \"s\": \"g\", \"pid\": %u, \"tid\": %u, \"ts\": %.3f }",
+                              event.Name, processID, event.ThreadID, event.StartMicroseconds);
+            }
+            else
+            {
+                std::snprintf(line, sizeof(line),
+                              "  { \"name\": \"%s\", \"ph\": \"X\", \"pid\": %u, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f }",
+                              event.Name, processID, event.ThreadID, event.StartMicroseconds, event.DurationMicroseconds);
+            };
+
+            stream << line << (index + 1 < _events.size() ? ",\n" : "\n");
+        };
+
+        stream << "] }\n";
+    };
+
+
+public:
+
+    static std::int64_t GetTime()
+    {
+        LARGE_INTEGER time;
+        QueryPerformanceCounter(&time);
+
+        return time.QuadPart;
+    };
+
+
+private:
+
+    double ToMicroseconds(const std::int64_t ticks) const
+    {
+        return static_cast<double>(ticks) * _microsecondsPerTick;
+    };
+
+};
+
+
+/// <summary>
+/// Startup's trace, started during static initialization so it also covers the time before main
+/// </summary>
+inline StartupTrace StartupTracer;
+
+
+/// <summary>
+/// Times the lifetime of a scope as a phase of StartupTracer
+/// </summary>
+class StartupPhase
+{
+
+private:
+
+    const char* _name = nullptr;
+
+    std::int64_t _beginTime = 0;
+
+
+public:
+
+    /// <param name="name"> Must outlive the trace, e.g. a literal </param>
+    explicit StartupPhase(const char* name) :
+        _name(name),
+        _beginTime(StartupTrace::GetTime())
+    {
+    };
+
+    StartupPhase(const StartupPhase&) = delete;
+    StartupPhase& operator = (const StartupPhase&) = delete;
+
+    ~StartupPhase()
+    {
+        StartupTracer.Record(_name, _beginTime, StartupTrace::GetTime());
+    };
+
+};
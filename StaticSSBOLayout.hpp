@@ -0,0 +1,385 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <glad/glad.h>
+
+#include "DynamicSSBO.hpp"
+
+
+class BufferLayout;
+
+
+/// <summary>
+/// A string literal that can be passed as a template argument, used to name the fields of a StaticSSBOLayout
+/// </summary>
+template<std::size_t N>
+struct FieldName
+{
+    char Value[N] {};
+
+    constexpr FieldName(const char (&name)[N])
+    {
+        std::copy_n(name, N, Value);
+    };
+
+    constexpr std::string_view View() const
+    {
+        return std::string_view(Value, N - 1);
+    };
+};
+
+
+/// <summary>
+/// A single named field of a StaticSSBOLayout
+/// </summary>
+/// <typeparam name="TName"> The field's name </typeparam>
+/// <typeparam name="TType"> The field's scalar type </typeparam>
+/// <typeparam name="TCount"> 1 for a single value, the element count for an array, or 0 for an unsized array </typeparam>
+template<FieldName TName, DataType TType, std::size_t TCount = 1>
+struct SSBOField
+{
+    static_assert(TType != DataType::Struct && TType != DataType::Array && TType != DataType::None, "Static layouts only support scalar field types");
+
+    static constexpr std::string_view Name = TName.View();
+
+    static constexpr DataType Type = TType;
+
+    static constexpr std::size_t Count = TCount;
+};
+
+/// <summary>
+/// A runtime-sized array field, as in "uint Characters[]". Must be the last field of a layout
+/// </summary>
+template<FieldName TName, DataType TType>
+using SSBOUnsizedArrayField = SSBOField<TName, TType, 0>;
+
+
+/// <summary>
+/// Round an offset up to a multiple of an alignment
+/// </summary>
+/// <param name="offset"></param>
+/// <param name="alignment"></param>
+/// <returns></returns>
+static constexpr std::size_t AlignToBoundary(const std::size_t offset, const std::size_t alignment)
+{
+    return (offset + (alignment - 1)) / alignment * alignment;
+};
+
+
+/// <summary>
+/// The std430 offset of every field, the last entry holds the fixed size of the layout
+/// </summary>
+/// <param name="types"> The fields' types </param>
+/// <param name="counts"> The fields' element counts </param>
+/// <returns></returns>
+template<std::size_t N>
+static constexpr std::array<std::size_t, N + 1> CalculateStaticLayoutOffsets(const std::array<DataType, N>& types, const std::array<std::size_t, N>& counts)
+{
+    std::array<std::size_t, N + 1> offsets {};
+
+    std::size_t currentOffset = 0;
+
+    for(std::size_t index = 0; index < N; ++index)
+    {
+        const std::size_t alignment = DataTypeAlignment(types[index]);
+        const std::size_t stride = AlignToBoundary(DataTypeSizeInBytes(types[index]), alignment);
+
+        offsets[index] = AlignToBoundary(currentOffset, alignment);
+
+        // A single vec3 only takes its 12 bytes, the next field may start in its padding
+        currentOffset = offsets[index] + (counts[index] == 1 ? DataTypeSizeInBytes(types[index]) : stride * counts[index]);
+    };
+
+    offsets[N] = currentOffset;
+
+    return offsets;
+};
+
+
+/// <summary>
+/// An SSBO layout described entirely by its field types.
+/// Offsets and sizes are calculated at compile time using std430 rules, and field lookups resolve to a constant offset
+/// </summary>
+/// <typeparam name="TFields"> The layout's SSBOFields, in declaration order </typeparam>
+template<typename... TFields>
+class StaticSSBOLayout
+{
+    friend class BufferLayout;
+
+private:
+
+    static constexpr std::size_t FieldCount = sizeof...(TFields);
+
+    static_assert(FieldCount >= 1, "A layout must have at least one field");
+
+
+    static constexpr std::array<std::string_view, FieldCount> _fieldNames = { TFields::Name... };
+
+    static constexpr std::array<DataType, FieldCount> _fieldTypes = { TFields::Type... };
+
+    static constexpr std::array<std::size_t, FieldCount> _fieldCounts = { TFields::Count... };
+
+    static constexpr std::array<std::size_t, FieldCount + 1> _fieldOffsets = CalculateStaticLayoutOffsets(_fieldTypes, _fieldCounts);
+
+
+    static_assert(std::find(_fieldCounts.cbegin(), std::prev(_fieldCounts.cend()), 0) == std::prev(_fieldCounts.cend()),
+                  "An unsized array must be the last field in the layout");
+
+
+public:
+
+    /// <summary>
+    /// The size of the layout, not including the elements of a trailing unsized array
+    /// </summary>
+    static constexpr std::size_t SizeInBytes = _fieldOffsets[FieldCount];
+
+
+public:
+
+    /// <summary>
+    /// The size of a buffer holding this layout, with a given element count for the trailing unsized array
+    /// </summary>
+    /// <param name="trailingArrayElementCount"> The number of elements in the unsized array </param>
+    /// <returns></returns>
+    static constexpr std::size_t GetSizeInBytes(const std::size_t trailingArrayElementCount)
+    {
+        if constexpr(_fieldCounts[FieldCount - 1] != 0)
+            return SizeInBytes;
+        else
+            return SizeInBytes + (trailingArrayElementCount * GetStrideAt(FieldCount - 1));
+    };
+
+
+    template<FieldName TName>
+    static constexpr std::size_t GetOffset()
+    {
+        return _fieldOffsets[GetFieldIndex<TName>()];
+    };
+
+    /// <summary>
+    /// The distance in bytes between two consecutive elements of a field
+    /// </summary>
+    template<FieldName TName>
+    static constexpr std::size_t GetStride()
+    {
+        return GetStrideAt(GetFieldIndex<TName>());
+    };
+
+    template<FieldName TName>
+    static constexpr std::size_t GetElementOffset(const std::size_t index)
+    {
+        return GetOffset<TName>() + (index * GetStride<TName>());
+    };
+
+
+    /// <summary>
+    /// Write a single value field, using a buffer call
+    /// </summary>
+    /// <param name="bufferID"> The buffer to write into </param>
+    /// <param name="value"> The field's new value </param>
+    template<FieldName TName, typename T>
+    static void Set(const std::uint32_t bufferID, const T& value)
+    {
+        AssertValueField<TName, T>();
+
+        glNamedBufferSubData(bufferID, GetOffset<TName>(), sizeof(T), &value);
+    };
+
+    /// <summary>
+    /// Write a single value field directly into a mapped buffer
+    /// </summary>
+    /// <param name="mappedBuffer"> Pointer to the start of the layout inside a mapped buffer </param>
+    /// <param name="value"> The field's new value </param>
+    template<FieldName TName, typename T>
+    static void Write(std::byte* mappedBuffer, const T& value)
+    {
+        AssertValueField<TName, T>();
+
+        std::memcpy(mappedBuffer + GetOffset<TName>(), &value, sizeof(T));
+    };
+
+
+    /// <summary>
+    /// Upload a contiguous range of array elements using a single buffer call
+    /// </summary>
+    /// <param name="bufferID"> The buffer to write into </param>
+    /// <param name="firstIndex"> The index of the first element to write </param>
+    /// <param name="values"> The values to write, one per array element </param>
+    template<FieldName TName, typename T>
+    static void SetRange(const std::uint32_t bufferID, const std::size_t firstIndex, const std::span<const T>& values)
+    {
+        AssertArrayRange<TName, T>(firstIndex, values.size());
+
+        if(values.empty() == true)
+            return;
+
+        glNamedBufferSubData(bufferID, GetElementOffset<TName>(firstIndex), values.size_bytes(), values.data());
+    };
+
+    /// <summary>
+    /// Write a contiguous range of array elements directly into a mapped buffer
+    /// </summary>
+    /// <param name="mappedBuffer"> Pointer to the start of the layout inside a mapped buffer </param>
+    /// <param name="firstIndex"> The index of the first element to write </param>
+    /// <param name="values"> The values to write, one per array element </param>
+    template<FieldName TName, typename T>
+    static void WriteRange(std::byte* mappedBuffer, const std::size_t firstIndex, const std::span<const T>& values)
+    {
+        AssertArrayRange<TName, T>(firstIndex, values.size());
+
+        if(values.empty() == true)
+            return;
+
+        std::memcpy(mappedBuffer + GetElementOffset<TName>(firstIndex), values.data(), values.size_bytes());
+    };
+
+
+    /// <summary>
+    /// The GLSL declaration of a block with this layout. Shaders include it rather than declaring the block themselves,
+    /// so the shader's block can't drift from the offsets the CPU writes at, see ShaderIncludeRegistry
+    /// </summary>
+    /// <param name="blockName"> The block's name </param>
+    /// <param name="binding"> The block's shader storage binding </param>
+    /// <param name="qualifiers"> Memory qualifiers, e.g. "readonly" </param>
+    static std::string GetGLSLDeclaration(const std::string_view& blockName, const std::uint32_t binding, const std::string_view& qualifiers = "readonly")
+    {
+        std::string declaration = std::string("layout(std430, binding = ").append(std::to_string(binding)).append(") ");
+
+        if(qualifiers.empty() == false)
+            declaration.append(qualifiers).append(" ");
+
+        declaration.append("buffer ").append(blockName).append("\n{\n");
+
+        for(std::size_t index = 0; index < FieldCount; ++index)
+        {
+            declaration.append("    ").append(DataTypeGLSLName(_fieldTypes[index])).append(" ").append(_fieldNames[index]);
+
+            if(_fieldCounts[index] == 0)
+                declaration.append("[]");
+            else if(_fieldCounts[index] != 1)
+                declaration.append("[").append(std::to_string(_fieldCounts[index])).append("]");
+
+            declaration.append(";\n");
+        };
+
+        declaration.append("};\n");
+
+        return declaration;
+    };
+
+
+private:
+
+    static constexpr std::size_t GetStrideAt(const std::size_t index)
+    {
+        return AlignToBoundary(DataTypeSizeInBytes(_fieldTypes[index]), DataTypeAlignment(_fieldTypes[index]));
+    };
+
+
+    template<FieldName TName>
+    static constexpr std::size_t GetFieldIndex()
+    {
+        constexpr std::size_t index = static_cast<std::size_t>(std::distance(_fieldNames.cbegin(), std::find(_fieldNames.cbegin(), _fieldNames.cend(), TName.View())));
+
+        static_assert(index != FieldCount, "No such field in layout");
+
+        return index;
+    };
+
+
+    template<FieldName TName, typename T>
+    static constexpr void AssertValueField()
+    {
+        constexpr std::size_t index = GetFieldIndex<TName>();
+
+        static_assert(_fieldCounts[index] == 1, "Cannot write a single value into an array field, use SetRange or WriteRange instead");
+        static_assert(sizeof(T) == DataTypeSizeInBytes(_fieldTypes[index]), "Invalid value type. Value size doesn't match field size");
+    };
+
+    template<FieldName TName, typename T>
+    static void AssertArrayRange(const std::size_t firstIndex, const std::size_t count)
+    {
+        constexpr std::size_t elementCount = _fieldCounts[GetFieldIndex<TName>()];
+
+        static_assert(sizeof(T) == GetStride<TName>(), "Invalid value type. Value size doesn't match array element stride");
+
+        wt::Assert(elementCount == 0 || firstIndex + count <= elementCount, []()
+        {
+            return "Invalid range";
+        });
+    };
+
+};
+
+
+/// <summary>
+/// The compile-time equivalent of SSBOTest()'s scalar and array cases, the layouts are checked when this header is compiled
+/// </summary>
+inline void StaticSSBOTest()
+{
+    using StaticTestUintVec4 = StaticSSBOLayout<SSBOField<"Uint_off_0", DataType::UInt32>,
+                                                SSBOField<"Vec4_off_16", DataType::Vec4f>>;
+
+    static_assert(StaticTestUintVec4::GetOffset<"Uint_off_0">() == 0);
+    static_assert(StaticTestUintVec4::GetOffset<"Vec4_off_16">() == 16);
+
+
+    using StaticTestContiguous = StaticSSBOLayout<SSBOField<"Uint_off_0", DataType::UInt32>,
+                                                  SSBOField<"Uint_off_4", DataType::UInt32>,
+                                                  SSBOField<"Uint_off_8", DataType::UInt32>,
+                                                  SSBOField<"Uint_off_12", DataType::UInt32>,
+                                                  SSBOField<"Uint_off_16", DataType::UInt32>>;
+
+    static_assert(StaticTestContiguous::GetOffset<"Uint_off_4">() == 4);
+    static_assert(StaticTestContiguous::GetOffset<"Uint_off_8">() == 8);
+    static_assert(StaticTestContiguous::GetOffset<"Uint_off_12">() == 12);
+    static_assert(StaticTestContiguous::GetOffset<"Uint_off_16">() == 16);
+    static_assert(StaticTestContiguous::SizeInBytes == 20);
+
+
+    using StaticTestVec2Uint = StaticSSBOLayout<SSBOField<"Vec2_off_0", DataType::Vec2f>,
+                                                SSBOField<"Uint_off_8", DataType::UInt32>>;
+
+    static_assert(StaticTestVec2Uint::GetOffset<"Uint_off_8">() == 8);
+
+
+    using StaticTestUintArray = StaticSSBOLayout<SSBOField<"Uint_off_0", DataType::UInt32, 3>,
+                                                 SSBOField<"Uint_off_12", DataType::UInt32>>;
+
+    static_assert(StaticTestUintArray::GetElementOffset<"Uint_off_0">(2) == 8);
+    static_assert(StaticTestUintArray::GetOffset<"Uint_off_12">() == 12);
+
+
+    using StaticTestPaddedArray = StaticSSBOLayout<SSBOField<"Uint_off_0", DataType::UInt32>,
+                                                   SSBOField<"Array_off_16", DataType::Vec4f, 3>>;
+
+    static_assert(StaticTestPaddedArray::GetElementOffset<"Array_off_16">(0) == 16);
+    static_assert(StaticTestPaddedArray::GetElementOffset<"Array_off_16">(2) == 48);
+    static_assert(StaticTestPaddedArray::SizeInBytes == 64);
+
+
+    using StaticTestUnsizedArray = StaticSSBOLayout<SSBOField<"Uint_off_0", DataType::UInt32>,
+                                                    SSBOUnsizedArrayField<"Vec2_off_8", DataType::Vec2f>>;
+
+    static_assert(StaticTestUnsizedArray::SizeInBytes == 8);
+    static_assert(StaticTestUnsizedArray::GetSizeInBytes(4) == 40);
+
+
+    using StaticTestPackedTypes = StaticSSBOLayout<SSBOField<"Float_off_0", DataType::Float>,
+                                                   SSBOField<"Vec3_off_16", DataType::Vec3f>,
+                                                   SSBOField<"Unorm_off_28", DataType::Unorm8x4>,
+                                                   SSBOField<"Half4_off_32", DataType::Half4>,
+                                                   SSBOField<"Vec3_off_48", DataType::Vec3f, 2>>;
+
+    static_assert(StaticTestPackedTypes::GetOffset<"Unorm_off_28">() == 28);
+    static_assert(StaticTestPackedTypes::GetOffset<"Half4_off_32">() == 32);
+    static_assert(StaticTestPackedTypes::GetElementOffset<"Vec3_off_48">(1) == 64);
+    static_assert(StaticTestPackedTypes::SizeInBytes == 80);
+};
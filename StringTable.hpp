@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A string interned in a StringTable, a compact id that stands for its text. Equal text always gets the same id from the same table
+/// </summary>
+struct InternedString
+{
+    static constexpr std::uint32_t Invalid = std::numeric_limits<std::uint32_t>::max();
+
+    std::uint32_t ID = Invalid;
+
+
+    bool IsValid() const
+    {
+        return ID != Invalid;
+    };
+
+    bool operator == (const InternedString&) const = default;
+};
+
+
+/// <summary>
+/// Hash-consed strings, e.g. the unit names and column headers a dashboard draws thousands of times a frame.
+/// Interning a string once gives an id that's cheap to keep, compare and hash, and that drawing code can key caches of converted,
+/// GPU-resident text by, so identical text isn't hashed, converted or uploaded again every time it's drawn, see FontSprite::DrawCached.
+/// Interned text is never moved or freed until Clear, so its views stay valid, and ids are never reused, not even after a Clear. Not thread safe
+/// </summary>
+class StringTable
+{
+
+private:
+
+    /// <summary>
+    /// The text of every interned string, back to back in blocks that are never reallocated
+    /// </summary>
+    std::pmr::monotonic_buffer_resource _characters;
+
+    /// <summary>
+    /// Each id's text, views into _characters
+    /// </summary>
+    std::vector<std::string_view> _strings;
+
+    /// <summary>
+    /// Each string's id, keyed by the same views
+    /// </summary>
+    std::unordered_map<std::string_view, std::uint32_t> _ids;
+
+    /// <summary>
+    /// The id of _strings[0], ids continue where they were after a Clear
+    /// </summary>
+    std::uint32_t _firstID = 0;
+
+    std::size_t _characterCount = 0;
+
+
+public:
+
+    /// <param name="initialCapacity"> The number of strings room is made for up front </param>
+    StringTable(const std::size_t initialCapacity = 256) :
+        _characters(initialCapacity * 16)
+    {
+        _strings.reserve(initialCapacity);
+        _ids.reserve(initialCapacity);
+    };
+
+    StringTable(const StringTable&) = delete;
+    StringTable& operator = (const StringTable&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// The id of a string, interning it if it's new. Only new strings are copied
+    /// </summary>
+    InternedString Intern(const std::string_view& text)
+    {
+        const auto existing = _ids.find(text);
+
+        if(existing != _ids.end())
+            return InternedString { .ID = existing->second };
+
+        wt::Assert(_strings.size() < static_cast<std::size_t>(InternedString::Invalid - _firstID), "Too many interned strings");
+
+        // Empty strings still get a distinct, valid view
+        char* characters = static_cast<char*>(_characters.allocate(std::max<std::size_t>(text.size(), 1), alignof(char)));
+        std::memcpy(characters, text.data(), text.size());
+
+        const std::string_view interned = std::string_view(characters, text.size());
+        const std::uint32_t id = _firstID + static_cast<std::uint32_t>(_strings.size());
+
+        _strings.push_back(interned);
+        _ids.emplace(interned, id);
+
+        _characterCount += text.size();
+
+        return InternedString { .ID = id };
+    };
+
+    /// <summary>
+    /// The id of a string that was interned before, without interning it
+    /// </summary>
+    /// <returns> The id, or an invalid one if the string was never interned </returns>
+    InternedString Find(const std::string_view& text) const
+    {
+        const auto existing = _ids.find(text);
+
+        return existing != _ids.end() ? InternedString { .ID = existing->second } : InternedString();
+    };
+
+    /// <summary>
+    /// An interned string's text, valid until Clear
+    /// </summary>
+    std::string_view Get(const InternedString string) const
+    {
+        WT_ASSERT(string.ID >= _firstID && string.ID - _firstID < _strings.size(), "String wasn't interned in this table, or was cleared");
+
+        return _strings[string.ID - _firstID];
+    };
+
+    /// <summary>
+    /// Forget every string and free their text. New strings get new ids, so caches keyed by the old ones simply miss
+    /// </summary>
+    void Clear()
+    {
+        _firstID += static_cast<std::uint32_t>(_strings.size());
+
+        _ids.clear();
+        _strings.clear();
+
+        _characters.release();
+
+        _characterCount = 0;
+    };
+
+
+    std::size_t GetStringCount() const
+    {
+        return _strings.size();
+    };
+
+    /// <summary>
+    /// The total length of every interned string, in bytes
+    /// </summary>
+    std::size_t GetCharacterCount() const
+    {
+        return _characterCount;
+    };
+
+};
@@ -0,0 +1,624 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <glm/vec4.hpp>
+
+#include "TextConversion.hpp"
+#include "TextStyle.hpp"
+
+
+/// <summary>
+/// The notations StyledTextParser reads. Can be combined
+/// </summary>
+enum class StyledTextSyntax : std::uint32_t
+{
+    /// <summary>
+    /// ANSI escape sequences. SGR sets colours and styles: 0 reset, 1/22 bold, 4/24 underline, 9/29 strikethrough, 30-37, 90-97, 38;5;n
+    /// and 38;2;r;g;b foregrounds, 39 the default one, and the same for backgrounds from 40. Every other sequence is dropped
+    /// </summary>
+    Ansi = 1 << 0,
+
+    /// <summary>
+    /// Tags in braces: {b} {u} {s} and {/b} {/u} {/s}, {#RRGGBB} or {#RRGGBBAA} and {/#}, {bg#RRGGBB} and {/bg}, {/} resets everything.
+    /// "{{" is a '{', anything else in braces is left as it is
+    /// </summary>
+    Markup = 1 << 1,
+
+    All = Ansi | Markup,
+};
+
+constexpr bool operator & (const StyledTextSyntax left, const StyledTextSyntax right)
+{
+    return (static_cast<std::uint32_t>(left) & static_cast<std::uint32_t>(right)) != 0;
+};
+
+
+/// <summary>
+/// Turns coloured text, e.g. a program's ANSI coloured output, straight into what a single styled draw takes: glyph text and its spans for
+/// FontSprite::DrawStyled, or characters with palette indices for FontSprite::DrawPaletted. There's no string per colour and no draw per colour.
+/// Runs without escape bytes, nearly all of a log, are found with FindStyleEscape and converted in one go.
+/// Parsing is streamed: text can arrive in chunks of any size, an escape sequence or tag split across chunks is finished by the next one
+/// </summary>
+class StyledTextParser
+{
+
+private:
+
+    /// <summary>
+    /// Longer sequences and tags are malformed, they're dropped rather than waited for
+    /// </summary>
+    static constexpr std::size_t MaxSequenceSize = 64;
+
+    /// <summary>
+    /// Operating system commands carry text, e.g. a window title, so they may be longer
+    /// </summary>
+    static constexpr std::size_t MaxCommandSize = 4096;
+
+    StyledTextSyntax _syntax = StyledTextSyntax::All;
+
+    std::uint32_t _defaultColour = 0;
+
+    /// <summary>
+    /// The style of the next character
+    /// </summary>
+    std::uint32_t _colour = 0;
+
+    std::uint32_t _background = 0;
+
+    GlyphStyle _style = GlyphStyle::None;
+
+    /// <summary>
+    /// The palette index of the foreground colour, its ANSI colour + 1, see GetAnsiPalette. 0 for the default colour and any colour not in the palette
+    /// </summary>
+    std::uint32_t _paletteIndex = 0;
+
+    /// <summary>
+    /// Whether the style changed since the last span
+    /// </summary>
+    bool _styleChanged = false;
+
+    /// <summary>
+    /// The unfinished end of the previous chunk, an escape sequence, a tag or a UTF-8 sequence
+    /// </summary>
+    std::string _pending;
+
+    /// <summary>
+    /// _pending and the next chunk, reused
+    /// </summary>
+    std::string _joined;
+
+    /// <summary>
+    /// (Paletted) A run's glyph text, reused
+    /// </summary>
+    std::string _run;
+
+
+public:
+
+    /// <param name="textColour"> The colour of characters no colour was given, and what a reset goes back to </param>
+    StyledTextParser(const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }, const StyledTextSyntax syntax = StyledTextSyntax::All) :
+        _syntax(syntax),
+        _defaultColour(PackSpanColour(textColour)),
+        _colour(_defaultColour)
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// Parse a chunk into glyph text and spans for DrawStyled, appended. A span is added wherever the style changes, and at the start of
+    /// empty text if the style isn't the default, so text can be cleared and parsed into again, e.g. every frame
+    /// </summary>
+    /// <param name="text"> Receives the characters, converted like DecodeUTF8ToGlyphText </param>
+    /// <param name="spans"> Receives the spans, indexed into text </param>
+    void Parse(const std::string_view& input, std::string& text, std::vector<TextSpan>& spans)
+    {
+        ParseChunk(input, [&](const std::string_view& run)
+        {
+            const std::size_t firstCharacter = text.size();
+
+            DecodeUTF8ToGlyphText(run, text);
+
+            if(text.size() == firstCharacter)
+                return;
+
+            if(_styleChanged == false && (firstCharacter != 0 || IsDefaultStyle() == true))
+                return;
+
+            _styleChanged = false;
+
+            const TextSpan span = TextSpan
+            {
+                .FirstCharacter = static_cast<std::uint32_t>(firstCharacter),
+                .Colour = _colour,
+                .Style = _style,
+                .Background = _background,
+            };
+
+            if(spans.empty() == false && spans.back().FirstCharacter == span.FirstCharacter)
+                spans.back() = span;
+            else
+                spans.push_back(span);
+        });
+    };
+
+    /// <summary>
+    /// Parse a chunk into characters for DrawPaletted, appended. Only colours of the palette are kept, see GetAnsiPalette,
+    /// other colours, backgrounds and styles have no room in the characters
+    /// </summary>
+    template<typename TCharacter>
+    void ParsePaletted(const std::string_view& input, std::vector<TCharacter>& characters)
+    {
+        static_assert(std::is_same_v<TCharacter, std::uint16_t> == true || std::is_same_v<TCharacter, std::uint32_t> == true, "Paletted characters are 16 or 32 bits");
+
+        ParseChunk(input, [&](const std::string_view& run)
+        {
+            _run.clear();
+
+            DecodeUTF8ToGlyphText(run, _run);
+
+            // 16-bit characters only have room for the first 15 colours
+            const std::uint32_t paletteIndex = _paletteIndex < (1u << PaletteIndexBits<TCharacter>) ? _paletteIndex : 0;
+
+            const std::size_t firstCharacter = characters.size();
+
+            characters.resize(firstCharacter + _run.size());
+
+            std::transform(_run.cbegin(), _run.cend(), characters.begin() + static_cast<std::ptrdiff_t>(firstCharacter), [&](const char character)
+            {
+                return PackPalettedCharacter<TCharacter>(static_cast<std::uint8_t>(character), paletteIndex);
+            });
+        });
+    };
+
+    /// <summary>
+    /// Go back to the default style and drop an unfinished sequence, e.g. before parsing another stream
+    /// </summary>
+    void Reset()
+    {
+        ResetStyle();
+
+        _pending.clear();
+    };
+
+
+    /// <summary>
+    /// The colours for FontSprite::SetPalette that ParsePaletted's indices pick from: the default colour at 0, then the 256 xterm colours but the last
+    /// </summary>
+    static std::array<glm::vec4, 256> GetAnsiPalette(const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f })
+    {
+        std::array<glm::vec4, 256> palette = { };
+
+        palette[0] = textColour;
+
+        for(std::uint32_t index = 0; index + 1 < palette.size(); ++index)
+        {
+            palette[index + 1] = UnpackColour(GetAnsiColour(index));
+        };
+
+        return palette;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Find the runs of plain text between sequences and tags, and apply those
+    /// </summary>
+    /// <param name="onRun"> Called as onRun(run) with UTF-8 text in the current style </param>
+    template<typename TFunction>
+    void ParseChunk(const std::string_view& input, const TFunction& onRun)
+    {
+        std::string_view text = input;
+
+        if(_pending.empty() == false)
+        {
+            _joined.assign(_pending).append(input);
+            _pending.clear();
+
+            text = _joined;
+        };
+
+        const bool markup = _syntax & StyledTextSyntax::Markup;
+
+        std::size_t index = 0;
+
+        while(index < text.size())
+        {
+            const std::size_t runSize = FindStyleEscape(text.substr(index), markup);
+
+            if(runSize > 0)
+            {
+                std::string_view run = text.substr(index, runSize);
+
+                // A character split across chunks, or a '\r' whose '\n' may be next, waits for the next chunk
+                if(index + runSize == text.size())
+                {
+                    const std::size_t tailSize = GetUnfinishedTailSize(run);
+
+                    _pending.assign(run.substr(run.size() - tailSize));
+                    run.remove_suffix(tailSize);
+                };
+
+                onRun(run);
+
+                index += runSize;
+
+                continue;
+            };
+
+            // Without ANSI a lone ESC is drawn like any other control character, as whatever has no glyph
+            if(text[index] == 0x1B && (_syntax & StyledTextSyntax::Ansi) == false)
+            {
+                onRun(text.substr(index, 1));
+
+                ++index;
+                continue;
+            };
+
+            const std::size_t sequenceSize = text[index] == 0x1B ? ParseEscapeSequence(text.substr(index)) : ParseTag(text.substr(index), onRun);
+
+            // Unfinished, the rest comes with the next chunk
+            if(sequenceSize == 0)
+            {
+                _pending.assign(text.substr(index));
+                break;
+            };
+
+            index += sequenceSize;
+        };
+    };
+
+    /// <summary>
+    /// Apply the escape sequence at the start of the text, see StyledTextSyntax::Ansi
+    /// </summary>
+    /// <returns> Its size, 0 if it's unfinished </returns>
+    std::size_t ParseEscapeSequence(const std::string_view& text)
+    {
+        if(text.size() < 2)
+            return 0;
+
+        // Control Sequence Introducer, parameters and intermediates up to a final byte
+        if(text[1] == '[')
+        {
+            std::size_t end = 2;
+
+            while(end < text.size() && end < MaxSequenceSize && (static_cast<std::uint8_t>(text[end]) < 0x40 || static_cast<std::uint8_t>(text[end]) > 0x7E))
+            {
+                ++end;
+            };
+
+            if(end == text.size())
+                return text.size() < MaxSequenceSize ? 0 : 1;
+
+            if(end == MaxSequenceSize)
+                return 1;
+
+            if(text[end] == 'm')
+                ApplySelectGraphicRendition(text.substr(2, end - 2));
+
+            return end + 1;
+        };
+
+        // Operating System Command, e.g. a window title, up to BEL or ESC '\'
+        if(text[1] == ']')
+        {
+            for(std::size_t end = 2; end < text.size(); ++end)
+            {
+                if(text[end] == '\a')
+                    return end + 1;
+
+                if(text[end] == 0x1B && end + 1 < text.size() && text[end + 1] == '\\')
+                    return end + 2;
+
+                if(text[end] == 0x1B && end + 1 == text.size())
+                    return 0;
+            };
+
+            return text.size() < MaxCommandSize ? 0 : 1;
+        };
+
+        // Every other sequence is two bytes
+        return 2;
+    };
+
+    /// <summary>
+    /// Apply the tag at the start of the text, see StyledTextSyntax::Markup. Text that isn't a tag is passed on as it is
+    /// </summary>
+    /// <returns> Its size, 0 if it's unfinished </returns>
+    template<typename TFunction>
+    std::size_t ParseTag(const std::string_view& text, const TFunction& onRun)
+    {
+        if(text.size() < 2)
+            return 0;
+
+        if(text[1] == '{')
+        {
+            onRun(text.substr(0, 1));
+            return 2;
+        };
+
+        const std::size_t end = text.substr(0, MaxSequenceSize).find('}');
+
+        if(end == std::string_view::npos)
+        {
+            if(text.size() < MaxSequenceSize)
+                return 0;
+
+            onRun(text.substr(0, 1));
+            return 1;
+        };
+
+        if(ApplyTag(text.substr(1, end - 1)) == false)
+        {
+            onRun(text.substr(0, 1));
+            return 1;
+        };
+
+        return end + 1;
+    };
+
+    /// <returns> False if it isn't a tag </returns>
+    bool ApplyTag(const std::string_view& tag)
+    {
+        std::uint32_t colour = 0;
+
+        if(tag == "/")
+            ResetStyle();
+        else if(tag == "b" || tag == "/b")
+            SetStyle(GlyphStyle::Bold, tag.front() != '/');
+        else if(tag == "u" || tag == "/u")
+            SetStyle(GlyphStyle::Underline, tag.front() != '/');
+        else if(tag == "s" || tag == "/s")
+            SetStyle(GlyphStyle::Strikethrough, tag.front() != '/');
+        else if(tag == "/#")
+            SetColour(_defaultColour, 0);
+        else if(tag == "/bg")
+            SetBackground(0);
+        else if(tag.starts_with("#") == true && ParseHexColour(tag.substr(1), colour) == true)
+            SetColour(colour, 0);
+        else if(tag.starts_with("bg#") == true && ParseHexColour(tag.substr(3), colour) == true)
+            SetBackground(colour);
+        else
+            return false;
+
+        return true;
+    };
+
+    /// <summary>
+    /// Apply the parameters of an SGR sequence, "ESC[...m"
+    /// </summary>
+    void ApplySelectGraphicRendition(const std::string_view& parameters)
+    {
+        std::array<std::uint32_t, 16> values = { };
+        std::size_t valueCount = 0;
+
+        // Empty parameters are 0, "ESC[m" included
+        for(std::size_t start = 0; start <= parameters.size() && valueCount < values.size();)
+        {
+            std::size_t end = parameters.find_first_of(";:", start);
+
+            if(end == std::string_view::npos)
+                end = parameters.size();
+
+            std::uint32_t value = 0;
+
+            for(std::size_t index = start; index < end; ++index)
+            {
+                if(parameters[index] >= '0' && parameters[index] <= '9')
+                    value = std::min(value * 10 + static_cast<std::uint32_t>(parameters[index] - '0'), 0xFFFFu);
+            };
+
+            values[valueCount++] = value;
+
+            start = end + 1;
+        };
+
+        for(std::size_t index = 0; index < valueCount; ++index)
+        {
+            const std::uint32_t value = values[index];
+
+            if(value == 0)
+                ResetStyle();
+            else if(value == 1)
+                SetStyle(GlyphStyle::Bold, true);
+            else if(value == 22)
+                SetStyle(GlyphStyle::Bold, false);
+            else if(value == 4)
+                SetStyle(GlyphStyle::Underline, true);
+            else if(value == 24)
+                SetStyle(GlyphStyle::Underline, false);
+            else if(value == 9)
+                SetStyle(GlyphStyle::Strikethrough, true);
+            else if(value == 29)
+                SetStyle(GlyphStyle::Strikethrough, false);
+            else if(value >= 30 && value <= 37)
+                SetColour(GetAnsiColour(value - 30), value - 30 + 1);
+            else if(value >= 90 && value <= 97)
+                SetColour(GetAnsiColour(value - 90 + 8), value - 90 + 8 + 1);
+            else if(value == 39)
+                SetColour(_defaultColour, 0);
+            else if(value >= 40 && value <= 47)
+                SetBackground(GetAnsiColour(value - 40));
+            else if(value >= 100 && value <= 107)
+                SetBackground(GetAnsiColour(value - 100 + 8));
+            else if(value == 49)
+                SetBackground(0);
+            else if((value == 38 || value == 48) && index + 2 < valueCount && values[index + 1] == 5)
+            {
+                const std::uint32_t ansiColour = std::min(values[index + 2], 255u);
+
+                if(value == 38)
+                    SetColour(GetAnsiColour(ansiColour), ansiColour + 1);
+                else
+                    SetBackground(GetAnsiColour(ansiColour));
+
+                index += 2;
+            }
+            else if((value == 38 || value == 48) && index + 4 < valueCount && values[index + 1] == 2)
+            {
+                const std::uint32_t colour = PackRGB(values[index + 2], values[index + 3], values[index + 4]);
+
+                if(value == 38)
+                    SetColour(colour, 0);
+                else
+                    SetBackground(colour);
+
+                index += 4;
+            };
+        };
+    };
+
+
+    bool IsDefaultStyle() const
+    {
+        return _colour == _defaultColour && _background == 0 && _style == GlyphStyle::None;
+    };
+
+    void ResetStyle()
+    {
+        SetColour(_defaultColour, 0);
+        SetBackground(0);
+
+        if(_style != GlyphStyle::None)
+        {
+            _style = GlyphStyle::None;
+            _styleChanged = true;
+        };
+    };
+
+    void SetStyle(const GlyphStyle style, const bool enabled)
+    {
+        const std::uint32_t styles = enabled == true ?
+            static_cast<std::uint32_t>(_style) | static_cast<std::uint32_t>(style) :
+            static_cast<std::uint32_t>(_style) & ~static_cast<std::uint32_t>(style);
+
+        _styleChanged |= static_cast<GlyphStyle>(styles) != _style;
+        _style = static_cast<GlyphStyle>(styles);
+    };
+
+    void SetColour(const std::uint32_t colour, const std::uint32_t paletteIndex)
+    {
+        _styleChanged |= colour != _colour;
+
+        _colour = colour;
+        _paletteIndex = paletteIndex;
+    };
+
+    void SetBackground(const std::uint32_t background)
+    {
+        _styleChanged |= background != _background;
+
+        _background = background;
+    };
+
+
+    /// <summary>
+    /// How many bytes at the end of a run can only be finished by the next chunk: a UTF-8 sequence missing its last bytes, or a '\r'
+    /// </summary>
+    static std::size_t GetUnfinishedTailSize(const std::string_view& run)
+    {
+        if(run.back() == '\r')
+            return 1;
+
+        // The last lead byte, at most 3 bytes back
+        for(std::size_t size = 1; size <= std::min<std::size_t>(run.size(), 3); ++size)
+        {
+            const std::uint8_t byte = static_cast<std::uint8_t>(run[run.size() - size]);
+
+            if(TextConversionKernels::IsContinuationByte(byte) == true)
+                continue;
+
+            const std::size_t length = byte >= 0xC2 && byte <= 0xDF ? 2 :
+                                       byte >= 0xE0 && byte <= 0xEF ? 3 :
+                                       byte >= 0xF0 && byte <= 0xF4 ? 4 :
+                                       1;
+
+            return length > size ? size : 0;
+        };
+
+        return 0;
+    };
+
+    /// <summary>
+    /// "RRGGBB" or "RRGGBBAA"
+    /// </summary>
+    static bool ParseHexColour(const std::string_view& hex, std::uint32_t& colour)
+    {
+        if(hex.size() != 6 && hex.size() != 8)
+            return false;
+
+        std::uint32_t value = 0;
+
+        for(const char digit : hex)
+        {
+            const std::uint32_t nibble = digit >= '0' && digit <= '9' ? static_cast<std::uint32_t>(digit - '0') :
+                                         digit >= 'a' && digit <= 'f' ? static_cast<std::uint32_t>(digit - 'a' + 10) :
+                                         digit >= 'A' && digit <= 'F' ? static_cast<std::uint32_t>(digit - 'A' + 10) :
+                                         16;
+
+            if(nibble == 16)
+                return false;
+
+            value = value << 4 | nibble;
+        };
+
+        if(hex.size() == 6)
+            value = value << 8 | 0xFF;
+
+        // Red in the low byte, like PackSpanColour
+        colour = (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+
+        return true;
+    };
+
+    static std::uint32_t PackRGB(const std::uint32_t red, const std::uint32_t green, const std::uint32_t blue)
+    {
+        return std::min(red, 255u) | std::min(green, 255u) << 8 | std::min(blue, 255u) << 16 | 0xFFu << 24;
+    };
+
+    static glm::vec4 UnpackColour(const std::uint32_t colour)
+    {
+        return glm::vec4(static_cast<float>(colour & 0xFF), static_cast<float>((colour >> 8) & 0xFF), static_cast<float>((colour >> 16) & 0xFF), static_cast<float>(colour >> 24)) / 255.0f;
+    };
+
+    /// <summary>
+    /// The xterm colours: 16 system colours, a 6x6x6 cube, then 24 greys
+    /// </summary>
+    static std::uint32_t GetAnsiColour(const std::uint32_t index)
+    {
+        static constexpr std::array<std::uint32_t, 16> systemColours =
+        {
+            0x000000, 0xCD0000, 0x00CD00, 0xCDCD00, 0x0000EE, 0xCD00CD, 0x00CDCD, 0xE5E5E5,
+            0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00, 0x5C5CFF, 0xFF00FF, 0x00FFFF, 0xFFFFFF,
+        };
+
+        if(index < 16)
+            return PackRGB(systemColours[index] >> 16, (systemColours[index] >> 8) & 0xFF, systemColours[index] & 0xFF);
+
+        if(index < 232)
+        {
+            const auto level = [](const std::uint32_t step)
+            {
+                return step == 0 ? 0u : 55u + step * 40u;
+            };
+
+            const std::uint32_t cube = index - 16;
+
+            return PackRGB(level(cube / 36), level(cube / 6 % 6), level(cube % 6));
+        };
+
+        const std::uint32_t grey = 8 + (std::min(index, 255u) - 232) * 10;
+
+        return PackRGB(grey, grey, grey);
+    };
+
+};
@@ -0,0 +1,457 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "TextBatch.hpp"
+
+
+/// <summary>
+/// The rows a TableView shows, formatted a cell at a time and only when a cell is visible and not cached
+/// </summary>
+class ITableSource
+{
+
+public:
+
+    virtual ~ITableSource() = default;
+
+
+public:
+
+    virtual std::size_t GetRowCount() const = 0;
+
+    /// <summary>
+    /// Write a cell's text
+    /// </summary>
+    /// <param name="text"> Empty, receives the text </param>
+    virtual void FormatCell(const std::size_t row, const std::size_t column, std::string& text) const = 0;
+
+    /// <summary>
+    /// Changes whenever the row's cells would be formatted differently, cells cached for another version are formatted again.
+    /// Rows that never change can keep the default
+    /// </summary>
+    virtual std::uint64_t GetRowVersion(const std::size_t) const
+    {
+        return 0;
+    };
+
+};
+
+
+enum class TableAlignment
+{
+    Left,
+
+    /// <summary>
+    /// Against the column's right edge, e.g. for numbers. Measured in columns, so only exact with a monospaced font
+    /// </summary>
+    Right,
+};
+
+struct TableColumn
+{
+    std::string Header;
+
+    /// <summary>
+    /// In pixels, padding included
+    /// </summary>
+    float Width = 100.0f;
+
+    TableAlignment Alignment = TableAlignment::Left;
+};
+
+
+/// <summary>
+/// A table of any number of rows, e.g. a million, drawn through a TextBatch so the whole table, and other widgets, share a single draw.
+/// Rows are virtualized: only the visible ones are formatted and submitted, so a frame costs the same whatever the row count and scroll position.
+/// The columns' edges and clip rects are laid out once, when the columns change, every cell is clipped to its column by the batch.
+/// Formatted cells are cached by row, column and the row's version, so scrolling back over rows seen before formats nothing.
+/// Entries aren't evicted individually, once the cache is full it starts over
+/// </summary>
+class TableView
+{
+
+private:
+
+    struct CellKey
+    {
+        std::size_t Row = 0;
+        std::size_t Column = 0;
+
+        std::uint64_t Version = 0;
+
+
+        bool operator == (const CellKey&) const = default;
+    };
+
+    struct CellHash
+    {
+        std::size_t operator () (const CellKey& key) const
+        {
+            std::uint64_t hash = std::hash<std::size_t>()(key.Row);
+
+            hash ^= std::hash<std::size_t>()(key.Column) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<std::uint64_t>()(key.Version) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+
+            return static_cast<std::size_t>(hash);
+        };
+    };
+
+
+    const ITableSource* _source = nullptr;
+
+    std::vector<TableColumn> _columns;
+
+    /// <summary>
+    /// Every column's left edge from the table's, followed by the table's width. Laid out by SetColumns
+    /// </summary>
+    std::vector<float> _columnEdges = { 0.0f };
+
+    float _rowHeight = 0.0f;
+
+    float _characterWidth = 0.0f;
+
+    glm::vec2 _viewportSize = { 0.0f, 0.0f };
+
+    /// <summary>
+    /// How far the rows are scrolled down, in pixels. A double, a million rows are past where floats have fractions
+    /// </summary>
+    double _scrollOffset = 0.0;
+
+
+    std::unordered_map<CellKey, std::string, CellHash> _cells;
+
+    std::size_t _cellCapacity = 0;
+
+    std::uint64_t _formattedCellCount = 0;
+
+    /// <summary>
+    /// Reused by FormatCell
+    /// </summary>
+    std::string _scratch;
+
+
+public:
+
+    /// <summary>
+    /// Where the table's top-left corner is, in screen space like the batch's strings
+    /// </summary>
+    glm::vec2 Origin = { 0.0f, 0.0f };
+
+    /// <summary>
+    /// Space between a column's edges and its text, in pixels
+    /// </summary>
+    float CellPadding = 4.0f;
+
+    glm::vec4 HeaderColour = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    glm::vec4 TextColour = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    /// <summary>
+    /// Whether the columns' headers are drawn as a row that doesn't scroll
+    /// </summary>
+    bool ShowHeader = true;
+
+
+public:
+
+    /// <param name="rowHeight"> The height of a row, the font's line height or more for spacing </param>
+    /// <param name="characterWidth"> The font's advance, for right-aligned columns </param>
+    /// <param name="viewportSize"> The table's visible size, in pixels, header included </param>
+    /// <param name="cellCapacity"> The number of formatted cells that are kept at once, several screens' worth </param>
+    TableView(const float rowHeight, const float characterWidth, const glm::vec2& viewportSize, const std::size_t cellCapacity = 1 << 16) :
+        _rowHeight(rowHeight),
+        _characterWidth(characterWidth),
+        _viewportSize(viewportSize),
+        _cellCapacity(std::max<std::size_t>(cellCapacity, 1))
+    {
+        wt::Assert(rowHeight > 0.0f, "Rows must have a height");
+    };
+
+
+public:
+
+    /// <summary>
+    /// Show a source's rows. The source must outlive the view, or be replaced first
+    /// </summary>
+    void SetSource(const ITableSource* source)
+    {
+        _source = source;
+
+        _cells.clear();
+
+        ScrollTo(_scrollOffset);
+    };
+
+    /// <summary>
+    /// Lay the columns out, left to right
+    /// </summary>
+    void SetColumns(std::vector<TableColumn> columns)
+    {
+        _columns = std::move(columns);
+
+        _cells.clear();
+
+        LayOutColumns();
+    };
+
+    /// <summary>
+    /// Resize a column, the columns after it move with it. Cached cells stay, they're only clipped differently
+    /// </summary>
+    void SetColumnWidth(const std::size_t column, const float width)
+    {
+        wt::Assert(column < _columns.size(), "Column out of bounds");
+
+        _columns[column].Width = std::max(width, 0.0f);
+
+        LayOutColumns();
+    };
+
+    void SetViewportSize(const glm::vec2& viewportSize)
+    {
+        _viewportSize = viewportSize;
+
+        ScrollTo(_scrollOffset);
+    };
+
+    /// <summary>
+    /// Forget every formatted cell, e.g. once the source's rows were replaced without their versions changing
+    /// </summary>
+    void Invalidate()
+    {
+        _cells.clear();
+    };
+
+
+    /// <summary>
+    /// Scroll the rows to an offset in pixels from the first row's top, clamped to the rows
+    /// </summary>
+    void ScrollTo(const double scrollOffset)
+    {
+        const double maximumScrollOffset = std::max(static_cast<double>(GetRowCount()) * _rowHeight - GetRowsHeight(), 0.0);
+
+        _scrollOffset = std::clamp(scrollOffset, 0.0, maximumScrollOffset);
+    };
+
+    void ScrollBy(const double delta)
+    {
+        ScrollTo(_scrollOffset + delta);
+    };
+
+    /// <summary>
+    /// Scroll so a row is at the top of the view
+    /// </summary>
+    void ScrollToRow(const std::size_t row)
+    {
+        ScrollTo(static_cast<double>(row) * _rowHeight);
+    };
+
+
+    /// <summary>
+    /// Submit the header and the visible rows to a batch between its Begin and Flush, each column's cells clipped to the column
+    /// and everything to the viewport
+    /// </summary>
+    void Submit(TextBatch& batch)
+    {
+        const float headerHeight = GetHeaderHeight();
+
+        batch.PushClip({ Origin.x, Origin.y, Origin.x + _viewportSize.x, Origin.y + _viewportSize.y });
+
+        if(ShowHeader == true)
+        {
+            for(std::size_t column = 0; column < _columns.size(); ++column)
+            {
+                batch.PushClip(GetColumnClip(column, Origin.y, Origin.y + headerHeight));
+
+                batch.Submit(_columns[column].Header, GetCellOrigin(column, Origin.y, _columns[column].Header.size()), HeaderColour);
+
+                batch.PopClip();
+            };
+        };
+
+        const std::size_t rowCount = GetRowCount();
+
+        if(_source != nullptr && rowCount > 0)
+        {
+            const std::size_t firstRow = std::min(static_cast<std::size_t>(_scrollOffset / _rowHeight), rowCount - 1);
+            const std::size_t endRow = std::min(static_cast<std::size_t>(std::ceil((_scrollOffset + GetRowsHeight()) / _rowHeight)), rowCount);
+
+            const float rowsTop = Origin.y + headerHeight;
+
+            // Column by column, so each column's clip is pushed once however many rows are visible
+            for(std::size_t column = 0; column < _columns.size(); ++column)
+            {
+                batch.PushClip(GetColumnClip(column, rowsTop, Origin.y + _viewportSize.y));
+
+                for(std::size_t row = firstRow; row < endRow; ++row)
+                {
+                    const std::string_view text = GetCellText(row, column);
+
+                    if(text.empty() == true)
+                        continue;
+
+                    const float rowTop = rowsTop + static_cast<float>(static_cast<double>(row) * _rowHeight - _scrollOffset);
+
+                    batch.Submit(text, GetCellOrigin(column, rowTop, text.size()), TextColour);
+                };
+
+                batch.PopClip();
+            };
+        };
+
+        batch.PopClip();
+    };
+
+
+public:
+
+    std::size_t GetRowCount() const
+    {
+        return _source != nullptr ? _source->GetRowCount() : 0;
+    };
+
+    double GetScrollOffset() const
+    {
+        return _scrollOffset;
+    };
+
+    /// <summary>
+    /// The width of every column together
+    /// </summary>
+    float GetWidth() const
+    {
+        return _columnEdges.back();
+    };
+
+    /// <summary>
+    /// The row at a point, in screen space, e.g. for selecting a row with the mouse
+    /// </summary>
+    /// <returns> GetRowCount() if the point is over the header or past the last row </returns>
+    std::size_t GetRowAt(const glm::vec2& point) const
+    {
+        const float rowsY = point.y - Origin.y - GetHeaderHeight();
+
+        if(rowsY < 0.0f)
+            return GetRowCount();
+
+        return std::min(static_cast<std::size_t>((rowsY + _scrollOffset) / _rowHeight), GetRowCount());
+    };
+
+    /// <summary>
+    /// The column at a point, in screen space
+    /// </summary>
+    /// <returns> The column count if the point is outside the columns </returns>
+    std::size_t GetColumnAt(const glm::vec2& point) const
+    {
+        const float x = point.x - Origin.x;
+
+        if(x < 0.0f || x >= GetWidth())
+            return _columns.size();
+
+        return static_cast<std::size_t>(std::upper_bound(_columnEdges.cbegin(), _columnEdges.cend(), x) - _columnEdges.cbegin()) - 1;
+    };
+
+    std::size_t GetCachedCellCount() const
+    {
+        return _cells.size();
+    };
+
+    /// <summary>
+    /// How many cells the source was asked to format, since construction
+    /// </summary>
+    std::uint64_t GetFormattedCellCount() const
+    {
+        return _formattedCellCount;
+    };
+
+
+private:
+
+    void LayOutColumns()
+    {
+        _columnEdges.resize(_columns.size() + 1);
+
+        float x = 0.0f;
+
+        for(std::size_t column = 0; column < _columns.size(); ++column)
+        {
+            _columnEdges[column] = x;
+
+            x += _columns[column].Width;
+        };
+
+        _columnEdges.back() = x;
+    };
+
+    /// <summary>
+    /// A cell's text, formatted by the source if it isn't cached for the row's version
+    /// </summary>
+    std::string_view GetCellText(const std::size_t row, const std::size_t column)
+    {
+        const CellKey key = CellKey
+        {
+            .Row = row,
+            .Column = column,
+            .Version = _source->GetRowVersion(row),
+        };
+
+        if(const auto cell = _cells.find(key); cell != _cells.end())
+            return cell->second;
+
+        if(_cells.size() >= _cellCapacity)
+            _cells.clear();
+
+        _scratch.clear();
+
+        _source->FormatCell(row, column, _scratch);
+
+        ++_formattedCellCount;
+
+        return _cells.insert_or_assign(key, _scratch).first->second;
+    };
+
+    /// <summary>
+    /// Where a cell's text starts, in screen space
+    /// </summary>
+    glm::vec2 GetCellOrigin(const std::size_t column, const float top, const std::size_t characterCount) const
+    {
+        const float left = Origin.x + _columnEdges[column] + CellPadding;
+
+        if(_columns[column].Alignment == TableAlignment::Right)
+            return { std::max(Origin.x + _columnEdges[column + 1] - CellPadding - static_cast<float>(characterCount) * _characterWidth, left), top };
+
+        return { left, top };
+    };
+
+    /// <summary>
+    /// A column's clip rect between two heights, its padding on the right left out so text doesn't run into the next column
+    /// </summary>
+    glm::vec4 GetColumnClip(const std::size_t column, const float top, const float bottom) const
+    {
+        return { Origin.x + _columnEdges[column], top, Origin.x + _columnEdges[column + 1] - CellPadding, bottom };
+    };
+
+    float GetHeaderHeight() const
+    {
+        return ShowHeader == true ? _rowHeight : 0.0f;
+    };
+
+    /// <summary>
+    /// The height the rows are shown in, below the header
+    /// </summary>
+    float GetRowsHeight() const
+    {
+        return std::max(_viewportSize.y - GetHeaderHeight(), 0.0f);
+    };
+
+};
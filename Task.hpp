@@ -0,0 +1,454 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "JobSystem.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A coroutine that produces a value. Tasks start suspended and run when they're awaited, or when a top-level task is started with Start.
+/// A task hops between threads by awaiting a scheduler, see TaskQueue and ResumeOn, and resumes whoever awaited it on the thread it finished on.
+/// The task owns its coroutine, which must not be running when the task is destroyed
+/// </summary>
+/// <typeparam name="TResult"> The value the coroutine co_returns </typeparam>
+template<typename TResult>
+class Task
+{
+
+public:
+
+    struct promise_type;
+
+
+private:
+
+    /// <summary>
+    /// Hands control to the awaiting coroutine, if any, once the task's body is done
+    /// </summary>
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        };
+
+        std::coroutine_handle<> await_suspend(const std::coroutine_handle<promise_type> handle) const noexcept
+        {
+            const std::coroutine_handle<> continuation = handle.promise().Continuation;
+
+            // Last, the owner may destroy the coroutine as soon as it sees this
+            handle.promise().Done.store(true, std::memory_order_release);
+
+            return continuation != nullptr ? continuation : std::noop_coroutine();
+        };
+
+        void await_resume() const noexcept
+        {
+        };
+    };
+
+
+public:
+
+    struct promise_type
+    {
+        std::optional<TResult> Result;
+
+        std::exception_ptr Exception;
+
+        /// <summary>
+        /// The coroutine awaiting the task, resumed when it's done
+        /// </summary>
+        std::coroutine_handle<> Continuation;
+
+        /// <summary>
+        /// Set once the body is done, for owners that poll rather than await
+        /// </summary>
+        std::atomic<bool> Done = false;
+
+
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        };
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return { };
+        };
+
+        FinalAwaiter final_suspend() const noexcept
+        {
+            return { };
+        };
+
+        void return_value(TResult result)
+        {
+            Result.emplace(std::move(result));
+        };
+
+        void unhandled_exception()
+        {
+            Exception = std::current_exception();
+        };
+    };
+
+
+private:
+
+    /// <summary>
+    /// Starts the task when it's awaited, the awaiting coroutine continues once the task is done
+    /// </summary>
+    struct Awaiter
+    {
+        std::coroutine_handle<promise_type> Handle;
+
+
+        bool await_ready() const noexcept
+        {
+            return Handle.done() == true;
+        };
+
+        std::coroutine_handle<> await_suspend(const std::coroutine_handle<> continuation) const noexcept
+        {
+            Handle.promise().Continuation = continuation;
+
+            return Handle;
+        };
+
+        TResult await_resume() const
+        {
+            if(Handle.promise().Exception != nullptr)
+                std::rethrow_exception(Handle.promise().Exception);
+
+            return std::move(*Handle.promise().Result);
+        };
+    };
+
+
+    std::coroutine_handle<promise_type> _handle = nullptr;
+
+
+    explicit Task(const std::coroutine_handle<promise_type> handle) :
+        _handle(handle)
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// No coroutine, which counts as done
+    /// </summary>
+    Task() = default;
+
+    Task(const Task&) = delete;
+    Task& operator = (const Task&) = delete;
+
+    Task(Task&& other) noexcept :
+        _handle(std::exchange(other._handle, nullptr))
+    {
+    };
+
+    Task& operator = (Task&& other) noexcept
+    {
+        if(this != &other)
+        {
+            if(_handle != nullptr)
+                _handle.destroy();
+
+            _handle = std::exchange(other._handle, nullptr);
+        };
+
+        return *this;
+    };
+
+    ~Task()
+    {
+        if(_handle != nullptr)
+            _handle.destroy();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Run a top-level task on the current thread up to its first suspension. Poll IsDone to find out when it's finished
+    /// </summary>
+    void Start()
+    {
+        wt::Assert(_handle != nullptr && _handle.promise().Continuation == nullptr, "Only top-level tasks are started, awaited ones start on their own");
+
+        _handle.resume();
+    };
+
+    /// <summary>
+    /// Whether the task finished, from any thread
+    /// </summary>
+    bool IsDone() const
+    {
+        return _handle == nullptr || _handle.promise().Done.load(std::memory_order_acquire) == true;
+    };
+
+    /// <summary>
+    /// The task's value, once it's done. Rethrows what the task threw
+    /// </summary>
+    TResult& GetResult()
+    {
+        wt::Assert(_handle != nullptr && IsDone() == true, "The task isn't done");
+
+        if(_handle.promise().Exception != nullptr)
+            std::rethrow_exception(_handle.promise().Exception);
+
+        return *_handle.promise().Result;
+    };
+
+
+    Awaiter operator co_await() const noexcept
+    {
+        return Awaiter { _handle };
+    };
+
+};
+
+
+/// <summary>
+/// Coroutines waiting to be resumed by a particular thread. Coroutines get in by awaiting Schedule,
+/// and the thread resumes them either once per frame with RunPending, e.g. the render thread at a point the context is free,
+/// or for as long as it lives with Run, see TaskThread
+/// </summary>
+class TaskQueue
+{
+
+private:
+
+    std::mutex _lock;
+
+    std::condition_variable _changed;
+
+    std::deque<std::coroutine_handle<>> _handles;
+
+    bool _stopping = false;
+
+
+public:
+
+    struct ScheduleAwaiter
+    {
+        TaskQueue& Queue;
+
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        };
+
+        void await_suspend(const std::coroutine_handle<> handle) const
+        {
+            Queue.Push(handle);
+        };
+
+        void await_resume() const noexcept
+        {
+        };
+    };
+
+
+public:
+
+    TaskQueue() = default;
+
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator = (const TaskQueue&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Await to continue on the queue's thread
+    /// </summary>
+    ScheduleAwaiter Schedule()
+    {
+        return ScheduleAwaiter { *this };
+    };
+
+    /// <summary>
+    /// Resume the coroutines queued so far. Ones that schedule themselves again while running wait for the next call
+    /// </summary>
+    /// <returns> The number of coroutines resumed </returns>
+    std::size_t RunPending()
+    {
+        std::deque<std::coroutine_handle<>> handles;
+
+        {
+            const std::lock_guard lock = std::lock_guard(_lock);
+
+            handles.swap(_handles);
+        };
+
+        for(const std::coroutine_handle<> handle : handles)
+        {
+            handle.resume();
+        };
+
+        return handles.size();
+    };
+
+    /// <summary>
+    /// Resume coroutines as they're queued, until Stop
+    /// </summary>
+    void Run()
+    {
+        while(true)
+        {
+            std::coroutine_handle<> handle = nullptr;
+
+            {
+                std::unique_lock lock = std::unique_lock(_lock);
+
+                _changed.wait(lock, [this]()
+                {
+                    return _handles.empty() == false || _stopping == true;
+                });
+
+                if(_stopping == true)
+                    return;
+
+                handle = _handles.front();
+                _handles.pop_front();
+            };
+
+            handle.resume();
+        };
+    };
+
+    /// <summary>
+    /// Make Run return, coroutines still queued are left to their owners
+    /// </summary>
+    void Stop()
+    {
+        {
+            const std::lock_guard lock = std::lock_guard(_lock);
+
+            _stopping = true;
+        };
+
+        _changed.notify_all();
+    };
+
+
+private:
+
+    void Push(const std::coroutine_handle<> handle)
+    {
+        {
+            const std::lock_guard lock = std::lock_guard(_lock);
+
+            _handles.push_back(handle);
+        };
+
+        _changed.notify_one();
+    };
+
+};
+
+
+/// <summary>
+/// A thread of its own that resumes the coroutines scheduled on it, e.g. for blocking file reads
+/// </summary>
+class TaskThread
+{
+
+private:
+
+    TaskQueue _queue;
+
+    std::thread _thread;
+
+
+public:
+
+    TaskThread() :
+        _thread([this]()
+        {
+            _queue.Run();
+        })
+    {
+    };
+
+    TaskThread(const TaskThread&) = delete;
+    TaskThread& operator = (const TaskThread&) = delete;
+
+    /// <summary>
+    /// Finishes the coroutine that's running, if any
+    /// </summary>
+    ~TaskThread()
+    {
+        _queue.Stop();
+
+        _thread.join();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Await to continue on the thread
+    /// </summary>
+    TaskQueue::ScheduleAwaiter Schedule()
+    {
+        return _queue.Schedule();
+    };
+
+};
+
+
+/// <summary>
+/// Continues a coroutine as a job of a JobSystem
+/// </summary>
+struct JobSystemAwaiter
+{
+    JobSystem& Jobs;
+
+    /// <summary>
+    /// Outlives the coroutine's frame, the job is only counted done after the coroutine it resumed has suspended again or finished
+    /// </summary>
+    JobGroup& Group;
+
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    };
+
+    void await_suspend(const std::coroutine_handle<> handle) const
+    {
+        Jobs.Schedule(Group, [handle]()
+        {
+            handle.resume();
+        });
+    };
+
+    void await_resume() const noexcept
+    {
+    };
+};
+
+/// <summary>
+/// Await to continue on one of a JobSystem's threads, e.g. for decoding
+/// </summary>
+/// <param name="group"> Counts the coroutines running on the jobs, must outlive them </param>
+inline JobSystemAwaiter ResumeOn(JobSystem& jobs, JobGroup& group)
+{
+    return JobSystemAwaiter { jobs, group };
+};
@@ -0,0 +1,453 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "ShaderProgram.hpp"
+#include "FontSprite.hpp"
+#include "TextStyle.hpp"
+#include "WindowsUtilities.hpp"
+#include "GLStateCache.hpp"
+
+
+/// <summary>
+/// The shader storage binding a TerminalGrid's cells are bound to, see TerminalGridVertexShader.glsl
+/// </summary>
+constexpr std::uint32_t TerminalCellsBindingIndex = 12;
+
+/// <summary>
+/// Build the grid's program with this define to draw a quad per row rather than per cell, see TerminalGridFragmentShader.glsl
+/// </summary>
+constexpr std::string_view TerminalGridRowQuadsDefine = "ROW_QUADS";
+
+
+/// <summary>
+/// A single character cell of a TerminalGrid
+/// </summary>
+struct TerminalCell
+{
+    char32_t Character = U' ';
+
+    /// <summary>
+    /// The glyph's colour, packed as RGBA8 with red in the low byte. See PackSpanColour
+    /// </summary>
+    std::uint32_t Foreground = 0xFFFFFFFF;
+
+    /// <summary>
+    /// The colour the whole cell is filled with behind the glyph, packed like Foreground
+    /// </summary>
+    std::uint32_t Background = 0xFF000000;
+
+    GlyphStyle Style = GlyphStyle::None;
+
+
+    bool operator == (const TerminalCell&) const = default;
+};
+
+
+/// <summary>
+/// A fixed rows x columns grid of character cells drawn with a FontSprite's atlas, for terminal emulators.
+/// The cells are mirrored in a shader storage buffer that only changed rows are uploaded to, and the whole grid is drawn with a single instanced draw,
+/// every instance derives its cell from gl_InstanceID. Built with the ROW_QUADS define, every instance is a whole row instead
+/// and the fragment shader looks up the cell under each pixel, which keeps the vertex work per row rather than per cell on dense grids.
+/// The rows are a ring, scrolling moves the first row instead of the cells, so only the rows scrolled into view have to be uploaded
+/// </summary>
+class TerminalGrid
+{
+
+private:
+
+    /// <summary>
+    /// A cell as it's stored on the GPU, matches the std430 layout of "TerminalCell" in TerminalGridCells.glsl
+    /// </summary>
+    struct UploadedCell
+    {
+        std::uint32_t GlyphIndex = 0;
+
+        std::uint32_t Foreground = 0;
+        std::uint32_t Background = 0;
+
+        std::uint32_t Style = 0;
+    };
+
+    static_assert(sizeof(UploadedCell) == 16, "UploadedCell must match the std430 struct size");
+
+
+private:
+
+    /// <summary>
+    /// The font the grid draws with, provides the atlas, the glyphs' metrics and the cell size
+    /// </summary>
+    std::reference_wrapper<const FontSprite> _fontSprite;
+
+    /// <summary>
+    /// A program built from TerminalGridVertexShader.glsl and TerminalGridFragmentShader.glsl
+    /// </summary>
+    std::reference_wrapper<const ShaderProgram> _shaderProgram;
+
+    UniformHandle _textTransformUniform;
+    UniformHandle _columnsUniform;
+    UniformHandle _rowsUniform;
+    UniformHandle _firstRowUniform;
+    UniformHandle _cellSizeUniform;
+
+    /// <summary>
+    /// Whether the program is a ROW_QUADS variant, drawn with an instance per row rather than per cell
+    /// </summary>
+    bool _rowQuads = false;
+
+
+    std::uint32_t _rows = 0;
+    std::uint32_t _columns = 0;
+
+    /// <summary>
+    /// The cells in the order they're stored in the buffer, a row at a time. Visible row 0 is stored at _firstRow
+    /// </summary>
+    std::vector<TerminalCell> _cells;
+
+    /// <summary>
+    /// Whether each stored row changed since it was last uploaded, indexed like _cells' rows
+    /// </summary>
+    std::vector<bool> _dirtyRows;
+
+    /// <summary>
+    /// The stored row that's drawn at the top of the grid
+    /// </summary>
+    std::uint32_t _firstRow = 0;
+
+    std::uint32_t _cellsBufferID = 0;
+
+    /// <summary>
+    /// The dirty rows' cells, converted to glyph indices before they're uploaded
+    /// </summary>
+    std::vector<UploadedCell> _stagingCells;
+
+    /// <summary>
+    /// The number of bytes written to the cells buffer since construction
+    /// </summary>
+    std::size_t _uploadedByteCount = 0;
+
+
+public:
+
+    /// <summary>
+    /// The grid's transform, the top-left corner of the first cell is at the origin.
+    /// The projection is shared by all draws, and comes from the FrameUniformBuffer
+    /// </summary>
+    glm::mat4 Transform = glm::mat4(1.0f);
+
+
+public:
+
+    /// <param name="fontSprite"> Must outlive the grid. Cells are its glyph size, and its atlas must be AtlasFormat::Coverage </param>
+    /// <param name="shaderProgram"> A program built from TerminalGridVertexShader.glsl and TerminalGridFragmentShader.glsl </param>
+    TerminalGrid(const FontSprite& fontSprite,
+                 const ShaderProgram& shaderProgram,
+                 const std::uint32_t rows,
+                 const std::uint32_t columns) :
+        _fontSprite(fontSprite),
+        _shaderProgram(shaderProgram)
+    {
+        wt::Assert(fontSprite._atlasFormat == AtlasFormat::Coverage, "Terminal grids are drawn from coverage atlases");
+
+        _textTransformUniform = shaderProgram.GetUniformHandle("TextTransform");
+        _columnsUniform = shaderProgram.GetUniformHandle("Columns");
+        _rowsUniform = shaderProgram.GetUniformHandle("Rows");
+        _firstRowUniform = shaderProgram.GetUniformHandle("FirstRow");
+        _cellSizeUniform = shaderProgram.GetUniformHandle("CellSize");
+
+        _rowQuads = shaderProgram.HasDefine(TerminalGridRowQuadsDefine);
+
+        Resize(rows, columns);
+    };
+
+    TerminalGrid(const TerminalGrid&) = delete;
+    TerminalGrid& operator = (const TerminalGrid&) = delete;
+
+    ~TerminalGrid()
+    {
+        GLState.DeleteBuffer(_cellsBufferID);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Change the grid's size. Cells that are still inside the grid keep their contents, new cells are blank
+    /// </summary>
+    void Resize(const std::uint32_t rows, const std::uint32_t columns)
+    {
+        wt::Assert(rows > 0 && columns > 0, "A terminal grid must have at least one cell");
+
+        std::vector<TerminalCell> cells = std::vector<TerminalCell>(static_cast<std::size_t>(rows) * columns);
+
+        // Copied in visible order, which unwinds the ring
+        const std::uint32_t keptRows = std::min(rows, _rows);
+        const std::uint32_t keptColumns = std::min(columns, _columns);
+
+        for(std::uint32_t row = 0; row < keptRows; ++row)
+        {
+            const TerminalCell* source = _cells.data() + GetCellIndex(row, 0);
+
+            std::copy(source, source + keptColumns, cells.data() + (static_cast<std::size_t>(row) * columns));
+        };
+
+        _cells = std::move(cells);
+
+        _rows = rows;
+        _columns = columns;
+
+        _firstRow = 0;
+
+        _dirtyRows.assign(rows, true);
+
+
+        GLState.DeleteBuffer(_cellsBufferID);
+
+        glCreateBuffers(1, &_cellsBufferID);
+        glNamedBufferStorage(_cellsBufferID, static_cast<GLsizeiptr>(_cells.size() * sizeof(UploadedCell)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    };
+
+
+    const TerminalCell& GetCell(const std::uint32_t row, const std::uint32_t column) const
+    {
+        return _cells[GetCellIndex(row, column)];
+    };
+
+    /// <summary>
+    /// Change a cell. Its row is only uploaded again if the cell actually changed
+    /// </summary>
+    /// <param name="row"> The visible row, 0 is the top of the grid </param>
+    void SetCell(const std::uint32_t row, const std::uint32_t column, const TerminalCell& cell)
+    {
+        TerminalCell& storedCell = _cells[GetCellIndex(row, column)];
+
+        if(storedCell == cell)
+            return;
+
+        storedCell = cell;
+
+        _dirtyRows[GetStoredRow(row)] = true;
+    };
+
+    /// <summary>
+    /// Write text into a row, starting at a column. Text past the end of the row is cut off
+    /// </summary>
+    /// <param name="text"> One cell per character, only ASCII has glyphs </param>
+    /// <returns> The number of cells written </returns>
+    std::uint32_t Write(const std::uint32_t row, const std::uint32_t column, const std::string_view& text, const glm::vec4& foreground, const glm::vec4& background, const GlyphStyle style = GlyphStyle::None)
+    {
+        if(column >= _columns)
+            return 0;
+
+        const std::uint32_t cellCount = static_cast<std::uint32_t>(std::min<std::size_t>(text.size(), _columns - column));
+
+        TerminalCell cell =
+        {
+            .Foreground = PackSpanColour(foreground),
+            .Background = PackSpanColour(background),
+            .Style = style,
+        };
+
+        for(std::uint32_t index = 0; index < cellCount; ++index)
+        {
+            cell.Character = static_cast<char32_t>(static_cast<std::uint8_t>(text[index]));
+
+            SetCell(row, column + index, cell);
+        };
+
+        return cellCount;
+    };
+
+    /// <summary>
+    /// Fill a whole row with the same cell
+    /// </summary>
+    void ClearRow(const std::uint32_t row, const TerminalCell& cell = { })
+    {
+        const std::uint32_t storedRow = GetStoredRow(row);
+
+        const auto rowBegin = _cells.begin() + (static_cast<std::size_t>(storedRow) * _columns);
+
+        std::fill(rowBegin, rowBegin + _columns, cell);
+
+        _dirtyRows[storedRow] = true;
+    };
+
+    /// <summary>
+    /// Move the grid's contents up by a number of rows, as a terminal does when a line is written past its bottom.
+    /// Only the first row moves, the rows scrolled into view are cleared and are the only ones uploaded again
+    /// </summary>
+    /// <param name="rowCount"> Positive scrolls the contents up, negative scrolls them down </param>
+    /// <param name="blank"> What the rows scrolled into view are cleared to </param>
+    void Scroll(const std::int32_t rowCount, const TerminalCell& blank = { })
+    {
+        const std::uint32_t distance = static_cast<std::uint32_t>(std::min<std::int64_t>(std::abs(static_cast<std::int64_t>(rowCount)), _rows));
+
+        if(distance == 0)
+            return;
+
+        if(rowCount > 0)
+        {
+            _firstRow = (_firstRow + distance) % _rows;
+
+            for(std::uint32_t row = _rows - distance; row < _rows; ++row)
+            {
+                ClearRow(row, blank);
+            };
+        }
+        else
+        {
+            _firstRow = (_firstRow + (_rows - distance)) % _rows;
+
+            for(std::uint32_t row = 0; row < distance; ++row)
+            {
+                ClearRow(row, blank);
+            };
+        };
+    };
+
+
+    /// <summary>
+    /// Upload the rows that changed since the last upload, consecutive dirty rows with a single call.
+    /// Nothing is uploaded until the font's atlas is ready, as cells are converted to its glyphs
+    /// </summary>
+    void Upload()
+    {
+        const FontSprite& fontSprite = _fontSprite.get();
+
+        if(fontSprite.IsReady() == false)
+            return;
+
+        // Control characters are drawn as blanks rather than as the fallback glyph
+        const std::uint32_t blankGlyph = fontSprite._font->GlyphTable.Find(U' ');
+
+        std::uint32_t storedRow = 0;
+
+        while(storedRow < _rows)
+        {
+            if(_dirtyRows[storedRow] == false)
+            {
+                ++storedRow;
+                continue;
+            };
+
+            const std::uint32_t firstRow = storedRow;
+
+            while(storedRow < _rows && _dirtyRows[storedRow] == true)
+            {
+                _dirtyRows[storedRow] = false;
+                ++storedRow;
+            };
+
+
+            const std::size_t firstCell = static_cast<std::size_t>(firstRow) * _columns;
+            const std::size_t cellCount = static_cast<std::size_t>(storedRow - firstRow) * _columns;
+
+            _stagingCells.resize(cellCount);
+
+            std::transform(_cells.cbegin() + firstCell, _cells.cbegin() + (firstCell + cellCount), _stagingCells.begin(), [&](const TerminalCell& cell)
+            {
+                return UploadedCell
+                {
+                    .GlyphIndex = cell.Character < 32 ? blankGlyph : fontSprite._font->GlyphTable.Find(cell.Character),
+                    .Foreground = cell.Foreground,
+                    .Background = cell.Background,
+                    .Style = static_cast<std::uint32_t>(cell.Style),
+                };
+            });
+
+            glNamedBufferSubData(_cellsBufferID,
+                                 static_cast<GLintptr>(firstCell * sizeof(UploadedCell)),
+                                 static_cast<GLsizeiptr>(cellCount * sizeof(UploadedCell)),
+                                 _stagingCells.data());
+
+            _uploadedByteCount += cellCount * sizeof(UploadedCell);
+        };
+    };
+
+    /// <summary>
+    /// Upload the changed rows, and draw every cell with a single instanced draw. An instance per cell, or per row with ROW_QUADS
+    /// </summary>
+    void Draw()
+    {
+        const FontSprite& fontSprite = _fontSprite.get();
+
+        if(fontSprite.IsReady() == false)
+            return;
+
+        Upload();
+
+
+        const ShaderProgram& shaderProgram = _shaderProgram.get();
+
+        shaderProgram.Bind();
+
+        shaderProgram.SetMatrix4(_textTransformUniform, Transform);
+        shaderProgram.SetUInt(_columnsUniform, _columns);
+        shaderProgram.SetUInt(_rowsUniform, _rows);
+        shaderProgram.SetUInt(_firstRowUniform, _firstRow);
+        shaderProgram.SetVector2(_cellSizeUniform, glm::vec2(static_cast<float>(fontSprite._glyphWidth), static_cast<float>(fontSprite._glyphHeight)));
+
+        GLState.BindTextureUnit(0, fontSprite._font->Texture.Get());
+
+        GLState.BindAttributelessVertexArray(fontSprite._font->VertexArray.Get());
+
+        fontSprite.BindGlyphMetrics();
+
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, TerminalCellsBindingIndex, _cellsBufferID);
+
+        const std::size_t instanceCount = _rowQuads == true ? _rows : _cells.size();
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, GlyphQuadVertexCount, static_cast<std::int32_t>(instanceCount));
+    };
+
+
+public:
+
+    std::uint32_t GetRows() const
+    {
+        return _rows;
+    };
+
+    std::uint32_t GetColumns() const
+    {
+        return _columns;
+    };
+
+    /// <summary>
+    /// The total number of bytes written to the GPU since construction
+    /// </summary>
+    std::size_t GetUploadedByteCount() const
+    {
+        return _uploadedByteCount;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Where a visible row is stored in the ring
+    /// </summary>
+    std::uint32_t GetStoredRow(const std::uint32_t row) const
+    {
+        wt::Assert(row < _rows, "Terminal grid row out of range");
+
+        return (_firstRow + row) % _rows;
+    };
+
+    std::size_t GetCellIndex(const std::uint32_t row, const std::uint32_t column) const
+    {
+        wt::Assert(column < _columns, "Terminal grid column out of range");
+
+        return (static_cast<std::size_t>(GetStoredRow(row)) * _columns) + column;
+    };
+
+};
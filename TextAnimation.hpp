@@ -0,0 +1,339 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include "ComputeProgram.hpp"
+#include "GLObject.hpp"
+#include "GLStateCache.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The shader storage binding every glyph instance's animation state is bound to, written by TextAnimationComputeShader.glsl and read by FontSpriteVertexShader.glsl
+/// </summary>
+constexpr std::uint32_t GlyphAnimationsBindingIndex = 14;
+
+/// <summary>
+/// The shader storage binding the playing TextAnimationTracks are bound to, see TextAnimationComputeShader.glsl
+/// </summary>
+constexpr std::uint32_t TextAnimationTracksBindingIndex = 15;
+
+
+/// <summary>
+/// How a TextAnimationTrack moves its glyphs, matches the constants in TextAnimationComputeShader.glsl
+/// </summary>
+enum class TextAnimationEffect : std::uint32_t
+{
+    /// <summary>
+    /// Each glyph fades in over Duration
+    /// </summary>
+    Fade = 0,
+
+    /// <summary>
+    /// Each glyph eases from Offset to its laid out position over Duration, fading in as it goes
+    /// </summary>
+    Slide = 1,
+
+    /// <summary>
+    /// Glyphs bob by up to Offset, one cycle every Duration seconds, each Stagger seconds behind the previous one. Never finishes
+    /// </summary>
+    Wave = 2,
+
+    /// <summary>
+    /// Glyphs appear one at a time, Stagger seconds apart, each fading in over Duration, 0 for instantly
+    /// </summary>
+    Typewriter = 3,
+};
+
+
+/// <summary>
+/// An animation of a range of glyph instances, matches the std430 layout of "TextAnimationTrack" in TextAnimationComputeShader.glsl.
+/// Tracks are uploaded when they're played and not again, the compute shader evaluates them against FrameData's time every frame
+/// </summary>
+struct TextAnimationTrack
+{
+    /// <summary>
+    /// The first glyph instance animated, gl_BaseInstance + gl_InstanceID in FontSpriteVertexShader.glsl.
+    /// Plain draws lay their glyphs out from instance 0, cached ones from their run's first instance, see FontSprite::FindCachedRun
+    /// </summary>
+    std::uint32_t FirstInstance = 0;
+
+    std::uint32_t InstanceCount = 0;
+
+    TextAnimationEffect Effect = TextAnimationEffect::Fade;
+
+    /// <summary>
+    /// When the first glyph starts, in the clock FrameUniformBuffer::Upload is given, e.g. glfwGetTime
+    /// </summary>
+    float StartTime = 0.0f;
+
+    /// <summary>
+    /// How long each glyph takes, or a Wave's period, in seconds
+    /// </summary>
+    float Duration = 0.5f;
+
+    /// <summary>
+    /// How much later each glyph starts than the one before it, in seconds
+    /// </summary>
+    float Stagger = 0.0f;
+
+    /// <summary>
+    /// (Slide) Where glyphs start, relative to their laid out position. (Wave) How far glyphs move at the top of the wave. In pixels
+    /// </summary>
+    glm::vec2 Offset = { 0.0f, 0.0f };
+};
+
+static_assert(sizeof(TextAnimationTrack) == 32, "TextAnimationTrack must match the std430 struct size");
+
+
+/// <summary>
+/// A glyph instance's animated state, matches the std430 layout of "GlyphAnimation" in TextAnimationComputeShader.glsl
+/// </summary>
+struct GlyphAnimation
+{
+    /// <summary>
+    /// Added to the glyph's laid out position, in pixels
+    /// </summary>
+    glm::vec2 Offset = { 0.0f, 0.0f };
+
+    /// <summary>
+    /// Multiplies the glyph's alpha
+    /// </summary>
+    float Opacity = 1.0f;
+
+    float Padding = 0.0f;
+};
+
+static_assert(sizeof(GlyphAnimation) == 16, "GlyphAnimation must match the std430 struct size");
+
+
+/// <summary>
+/// Animates text on the GPU. Every glyph instance has a GlyphAnimation, which a compute pass re-evaluates from the playing tracks and FrameData's time
+/// once a frame, and which FontSprite programs built with FontShaderFeature::Animation apply as they draw.
+/// Once a track is played the CPU does nothing per frame beyond the dispatch, the only upload is the frame time FrameUniformBuffer already makes
+/// </summary>
+class TextAnimator
+{
+
+private:
+
+    ComputeProgram _animationProgram;
+
+    std::int32_t _instanceCountLocation = -1;
+    std::int32_t _trackCountLocation = -1;
+
+    /// <summary>
+    /// A GlyphAnimation per glyph instance
+    /// </summary>
+    GLBuffer _glyphAnimationsBuffer;
+
+    std::uint32_t _instanceCapacity = 0;
+
+    GLBuffer _tracksBuffer;
+
+    std::uint32_t _trackCapacity = 0;
+
+    std::vector<TextAnimationTrack> _tracks;
+
+    /// <summary>
+    /// Whether _tracks changed since they were last uploaded
+    /// </summary>
+    bool _tracksChanged = false;
+
+    /// <summary>
+    /// One past the last instance the previous pass wrote. Instances a finished track animated are reset by the next pass
+    /// </summary>
+    std::uint32_t _animatedInstanceEnd = 0;
+
+
+public:
+
+    static constexpr const char* DefaultComputeShaderPath = "Shaders\\TextAnimationComputeShader.glsl";
+
+
+public:
+
+    /// <param name="instanceCapacity"> How many glyph instances can be animated, as many as the largest draw or glyph run cache the programs read </param>
+    TextAnimator(const std::uint32_t instanceCapacity = 65536, const std::string& computeShaderPath = DefaultComputeShaderPath) :
+        _animationProgram(computeShaderPath),
+        _instanceCapacity(std::max(instanceCapacity, 1u))
+    {
+        _instanceCountLocation = _animationProgram.GetUniformLocation("InstanceCount");
+        _trackCountLocation = _animationProgram.GetUniformLocation("TrackCount");
+
+        _glyphAnimationsBuffer = GLBuffer::Create();
+        glNamedBufferStorage(_glyphAnimationsBuffer.Get(), static_cast<GLsizeiptr>(_instanceCapacity * sizeof(GlyphAnimation)), nullptr, 0);
+
+        // Unanimated glyphs are drawn as they were laid out
+        const GlyphAnimation identity = GlyphAnimation();
+        glClearNamedBufferData(_glyphAnimationsBuffer.Get(), GL_RGBA32F, GL_RGBA, GL_FLOAT, &identity);
+    };
+
+    TextAnimator(const TextAnimator&) = delete;
+    TextAnimator& operator = (const TextAnimator&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Start a track. A track already playing from the same first instance is replaced
+    /// </summary>
+    void Play(const TextAnimationTrack& track)
+    {
+        wt::Assert(track.FirstInstance + track.InstanceCount <= _instanceCapacity, "Text animation track is outside the animator's instances");
+
+        const auto existingTrack = std::find_if(_tracks.begin(), _tracks.end(), [&](const TextAnimationTrack& playingTrack)
+        {
+            return playingTrack.FirstInstance == track.FirstInstance;
+        });
+
+        if(existingTrack != _tracks.end())
+            *existingTrack = track;
+        else
+            _tracks.emplace_back(track);
+
+        _tracksChanged = true;
+    };
+
+    /// <summary>
+    /// Stop the track playing from an instance, its glyphs are drawn as laid out from the next Update
+    /// </summary>
+    void Stop(const std::uint32_t firstInstance)
+    {
+        _tracksChanged |= std::erase_if(_tracks, [&](const TextAnimationTrack& track)
+        {
+            return track.FirstInstance == firstInstance;
+        }) != 0;
+    };
+
+    void StopAll()
+    {
+        _tracksChanged |= _tracks.empty() == false;
+
+        _tracks.clear();
+    };
+
+
+    /// <summary>
+    /// Whether any track still moves its glyphs at a time, e.g. to keep an on-demand renderer drawing frames
+    /// </summary>
+    bool IsAnimating(const double time) const
+    {
+        return std::any_of(_tracks.cbegin(), _tracks.cend(), [&](const TextAnimationTrack& track)
+        {
+            return IsTrackPlaying(track, time);
+        });
+    };
+
+
+    /// <summary>
+    /// Drop the tracks that finished by a time, and evaluate the rest into the glyphs' animation state. Call once a frame, after FrameUniformBuffer::Upload
+    /// and before the animated text is drawn. Leaves the state bound to GlyphAnimationsBindingIndex
+    /// </summary>
+    void Update(const double time)
+    {
+        // Finished tracks leave their glyphs where they were laid out, so they're simply dropped
+        _tracksChanged |= std::erase_if(_tracks, [&](const TextAnimationTrack& track)
+        {
+            return IsTrackPlaying(track, time) == false;
+        }) != 0;
+
+        Bind();
+
+        if(_tracksChanged == false && _tracks.empty() == true)
+            return;
+
+        if(_tracksChanged == true)
+            UploadTracks();
+
+
+        std::uint32_t instanceEnd = 0;
+
+        for(const TextAnimationTrack& track : _tracks)
+        {
+            instanceEnd = std::max(instanceEnd, track.FirstInstance + track.InstanceCount);
+        };
+
+        // The previous pass's range is covered too, so glyphs whose track was dropped are put back
+        const std::uint32_t instanceCount = std::max(instanceEnd, _animatedInstanceEnd);
+
+        _animatedInstanceEnd = instanceEnd;
+
+        if(instanceCount == 0)
+            return;
+
+        _animationProgram.SetUInt(_instanceCountLocation, instanceCount);
+        _animationProgram.SetUInt(_trackCountLocation, static_cast<std::uint32_t>(_tracks.size()));
+
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, TextAnimationTracksBindingIndex, _tracksBuffer.Get());
+
+        _animationProgram.Dispatch((instanceCount + WorkGroupSize - 1) / WorkGroupSize);
+
+        // The state is read as storage by the vertex shader
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    };
+
+    /// <summary>
+    /// Bind the glyphs' animation state to GlyphAnimationsBindingIndex, for programs built with FontShaderFeature::Animation
+    /// </summary>
+    void Bind() const
+    {
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, GlyphAnimationsBindingIndex, _glyphAnimationsBuffer.Get());
+    };
+
+
+    std::size_t GetTrackCount() const
+    {
+        return _tracks.size();
+    };
+
+
+private:
+
+    /// <summary>
+    /// Write the tracks, growing the buffer if necessary
+    /// </summary>
+    void UploadTracks()
+    {
+        _tracksChanged = false;
+
+        if(_tracks.empty() == true)
+            return;
+
+        if(_tracks.size() > _trackCapacity)
+        {
+            _trackCapacity = std::max(static_cast<std::uint32_t>(_tracks.size()), _trackCapacity * 2);
+
+            _tracksBuffer = GLBuffer::Create();
+            glNamedBufferStorage(_tracksBuffer.Get(), static_cast<GLsizeiptr>(_trackCapacity * sizeof(TextAnimationTrack)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        };
+
+        glNamedBufferSubData(_tracksBuffer.Get(), 0, static_cast<GLsizeiptr>(_tracks.size() * sizeof(TextAnimationTrack)), _tracks.data());
+    };
+
+
+    static bool IsTrackPlaying(const TextAnimationTrack& track, const double time)
+    {
+        if(track.Effect == TextAnimationEffect::Wave)
+            return true;
+
+        const double lastGlyphStart = static_cast<double>(track.StartTime) + static_cast<double>(track.Stagger) * static_cast<double>(std::max(track.InstanceCount, 1u) - 1);
+
+        return time < lastGlyphStart + static_cast<double>(track.Duration);
+    };
+
+
+private:
+
+    /// <summary>
+    /// The compute shader's local_size_x
+    /// </summary>
+    static constexpr std::uint32_t WorkGroupSize = 256;
+
+};
@@ -0,0 +1,1171 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/packing.hpp>
+
+#include "ShaderProgram.hpp"
+#include "ShaderStorageBuffer.hpp"
+#include "FontSprite.hpp"
+#include "TextStyle.hpp"
+#include "GlyphAtlas.hpp"
+#include "TextShaping.hpp"
+#include "FontSet.hpp"
+#include "FontFallback.hpp"
+#include "StringTable.hpp"
+#include "JobSystem.hpp"
+#include "GLStateCache.hpp"
+#include "TextPicking.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The shader storage binding a TextBatch's clip rectangles are bound to, see TextBatchVertexShader.glsl
+/// </summary>
+constexpr std::uint32_t TextBatchClipRectsBindingIndex = 16;
+
+/// <summary>
+/// The shader storage binding a TextBatch's pick ids are bound to while it draws into a TextPickingBuffer, see TextBatchVertexShader.glsl
+/// </summary>
+constexpr std::uint32_t TextBatchPickIDsBindingIndex = 20;
+
+
+/// <summary>
+/// A single glyph instance, matches the std430 layout of "GlyphInstance" in TextBatchVertexShader.glsl
+/// </summary>
+struct GlyphInstance
+{
+    /// <summary>
+    /// The top-left corner of the glyph, in screen space
+    /// </summary>
+    glm::vec2 Position;
+
+    /// <summary>
+    /// Index of the glyph inside the font sprite in the low 24 bits, the string's layer in the high 8, see TextBatch::Submit
+    /// </summary>
+    std::uint32_t GlyphIndex;
+
+    /// <summary>
+    /// (Font sets) The index of the glyph's font, selects its texture
+    /// </summary>
+    std::uint8_t FontIndex;
+
+    /// <summary>
+    /// The string's GlyphStyle, its decorations are drawn by the fragment shader within the glyph's cell, see TextBatch::Submit
+    /// </summary>
+    std::uint8_t Style;
+
+    /// <summary>
+    /// The glyph's clip rectangle, 0 if it isn't clipped, see TextBatch::PushClip
+    /// </summary>
+    std::uint16_t ClipIndex;
+
+    /// <summary>
+    /// The string's colour, packed as RGBA8 with red in the low byte. See PackSpanColour
+    /// </summary>
+    std::uint32_t Colour;
+
+    /// <summary>
+    /// How much the glyph is scaled from the size it was rasterized at in the low 16 bits, see TextBatch::Submit.
+    /// The width of its cell, how far the pen moves past it, in the high 16. Both are half floats, see glm::packHalf2x16
+    /// </summary>
+    std::uint32_t ScaleAndCellWidth;
+};
+
+static_assert(sizeof(GlyphInstance) == 24, "GlyphInstance must match the std430 struct size");
+
+
+/// <summary>
+/// The fixed part of the batch input block, matches "BatchInput" in TextBatchVertexShader.glsl
+/// </summary>
+struct TextBatchHeader
+{
+    std::uint32_t GlyphWidth;
+    std::uint32_t GlyphHeight;
+
+    std::uint32_t TextureWidth;
+    std::uint32_t TextureHeight;
+
+    glm::vec4 ChromaKey;
+};
+
+static_assert(sizeof(TextBatchHeader) == 32, "TextBatchHeader must match the std430 block header");
+
+
+/// <summary>
+/// Accumulates text from multiple submissions and draws all of it with a single instanced draw call.
+/// Draws with either a FontSprite's fixed atlas, a GlyphAtlas that takes UTF-8 text, or a FontSet that mixes several FontSprites
+/// </summary>
+class TextBatch
+{
+
+private:
+
+    /// <summary>
+    /// The font the batch draws with, provides the texture and glyph quad
+    /// </summary>
+    const FontSprite* _fontSprite = nullptr;
+
+    /// <summary>
+    /// (Dynamic atlas) The atlas the batch draws with, its glyphs are added as strings are submitted
+    /// </summary>
+    GlyphAtlas* _glyphAtlas = nullptr;
+
+    /// <summary>
+    /// (Font set) The fonts the batch draws with, every string picks one of them
+    /// </summary>
+    const FontSet* _fontSet = nullptr;
+
+    /// <summary>
+    /// (Fallback chain) Picks every character's font from the chain's FontSet, which _fontSet then points at
+    /// </summary>
+    FontFallbackChain* _fallbackChain = nullptr;
+
+    /// <summary>
+    /// (Dynamic atlas and font set) An empty VAO, a FontSprite's is used otherwise
+    /// </summary>
+    std::uint32_t _vao = 0;
+
+    /// <summary>
+    /// A program built from TextBatchVertexShader.glsl
+    /// </summary>
+    std::reference_wrapper<const ShaderProgram> _shaderProgram;
+
+    UniformHandle _textTransformUniform;
+
+    UniformHandle _glyphUsageFeedbackUniform;
+
+    UniformHandle _textPickingUniform;
+
+
+    /// <summary>
+    /// A string submitted since the last flush, laid out when the batch is flushed
+    /// </summary>
+    struct SubmittedString
+    {
+        /// <summary>
+        /// Where the string's characters are in _submittedText, or a shaped string's glyphs in _shapedGlyphs
+        /// </summary>
+        std::size_t TextOffset = 0;
+        std::size_t TextSize = 0;
+
+        glm::vec2 Origin = { 0.0f, 0.0f };
+
+        /// <summary>
+        /// See GlyphInstance::Colour
+        /// </summary>
+        std::uint32_t Colour = 0xFF000000;
+
+        float Scale = 1.0f;
+
+        GlyphStyle Style = GlyphStyle::None;
+
+        /// <summary>
+        /// (Font set) The index of the string's font
+        /// </summary>
+        std::uint32_t FontIndex = 0;
+
+        std::uint16_t ClipIndex = 0;
+
+        std::uint8_t Layer = 0;
+
+        /// <summary>
+        /// (Dynamic atlas) Whether the string was submitted already shaped, see SubmitShaped
+        /// </summary>
+        bool Shaped = false;
+
+        /// <summary>
+        /// The number of glyph instances the string lays out to
+        /// </summary>
+        std::size_t GlyphCount = 0;
+
+        /// <summary>
+        /// The index of the string's first glyph instance, every string writes its own slice of the input block
+        /// </summary>
+        std::size_t FirstInstance = 0;
+
+        /// <summary>
+        /// The run id Picking gave the string, 0 without picking
+        /// </summary>
+        std::uint32_t PickRun = 0;
+    };
+
+    std::pmr::vector<SubmittedString> _strings;
+
+    /// <summary>
+    /// The characters of every submitted string, back to back
+    /// </summary>
+    std::pmr::string _submittedText;
+
+    /// <summary>
+    /// (Dynamic atlas) The glyphs of every string submitted shaped, back to back
+    /// </summary>
+    std::pmr::vector<ShapedGlyph> _shapedGlyphs;
+
+    /// <summary>
+    /// The number of glyph instances the submitted strings lay out to
+    /// </summary>
+    std::size_t _glyphCount = 0;
+
+    /// <summary>
+    /// The number of glyph instances each interned string lays out to, counted the first time it's submitted
+    /// </summary>
+    std::unordered_map<std::uint32_t, std::size_t> _internedGlyphCounts;
+
+    /// <summary>
+    /// The table the interned strings were submitted from, their ids mean nothing in any other one
+    /// </summary>
+    const StringTable* _internedStrings = nullptr;
+
+    /// <summary>
+    /// Whether any string since the last flush is above layer 0, the strings are then sorted before they're laid out
+    /// </summary>
+    bool _layered = false;
+
+    /// <summary>
+    /// A persistently mapped ring the batch's input block is written into
+    /// </summary>
+    ShaderStorageBuffer _inputRingBuffer;
+
+    /// <summary>
+    /// The clip rectangles the submitted strings use, left, top, right, bottom. Clip index N is at N - 1, 0 is unclipped
+    /// </summary>
+    std::pmr::vector<glm::vec4> _clipRects;
+
+    /// <summary>
+    /// The rectangles pushed by PushClip, each already intersected with the one below it
+    /// </summary>
+    std::vector<glm::vec4> _clipStack;
+
+    /// <summary>
+    /// The clip index strings submitted now get, the top of _clipStack
+    /// </summary>
+    std::uint16_t _clipIndex = 0;
+
+    /// <summary>
+    /// A ring the clip rectangles are written into, only when any are used
+    /// </summary>
+    ShaderStorageBuffer _clipRingBuffer;
+
+    /// <summary>
+    /// A ring the (run, glyph) pair of every instance is written into, created the first time the batch draws into Picking
+    /// </summary>
+    std::optional<ShaderStorageBuffer> _pickRingBuffer;
+
+
+public:
+
+    /// <summary>
+    /// The batch's transform. The projection is shared by all draws, and comes from the FrameUniformBuffer
+    /// </summary>
+    glm::mat4 Transform = glm::mat4(1.0f);
+
+    /// <summary>
+    /// If set, the submitted strings are laid out in parallel on its workers
+    /// </summary>
+    JobSystem* Jobs = nullptr;
+
+    /// <summary>
+    /// Depth-test and write the strings' layers, so the batch also overlaps other depth-tested draws by layer rather than by draw order.
+    /// The target needs a depth buffer. Layers within the batch blend correctly either way, but the antialiased edges of nearer text
+    /// can hide farther text that a later draw adds
+    /// </summary>
+    bool DepthTest = false;
+
+    /// <summary>
+    /// If set, the string submits, clips and flushes are recorded for replaying, see DrawRecorder. Shaped submits aren't
+    /// </summary>
+    DrawRecorder* Recorder = nullptr;
+
+    /// <summary>
+    /// If set, every string gets a run id, see GetLastRun, and on frames that pick the batch draws a second time into the buffer.
+    /// Needs a program with GlyphAtlasFragmentShader.glsl or FontSetBindlessFragmentShader.glsl, which write the pick
+    /// </summary>
+    TextPickingBuffer* Picking = nullptr;
+
+
+public:
+
+    TextBatch(const FontSprite& fontSprite,
+              const ShaderProgram& shaderProgram,
+              const std::size_t glyphCapacity = 1024) :
+        _fontSprite(&fontSprite),
+        _shaderProgram(shaderProgram),
+        _inputRingBuffer(sizeof(TextBatchHeader) + (glyphCapacity * sizeof(GlyphInstance)), FramesInFlight),
+        _clipRingBuffer(ClipRectCapacity * sizeof(glm::vec4), FramesInFlight, TextBatchClipRectsBindingIndex)
+    {
+        _submittedText.reserve(glyphCapacity);
+
+        _textTransformUniform = shaderProgram.GetUniformHandle("TextTransform");
+        _textPickingUniform = shaderProgram.GetUniformHandle("TextPicking");
+    };
+
+    /// <param name="glyphAtlas"> Must outlive the batch </param>
+    /// <param name="shaderProgram"> A program built from TextBatchVertexShader.glsl and GlyphAtlasFragmentShader.glsl </param>
+    TextBatch(GlyphAtlas& glyphAtlas,
+              const ShaderProgram& shaderProgram,
+              const std::size_t glyphCapacity = 1024) :
+        _glyphAtlas(&glyphAtlas),
+        _shaderProgram(shaderProgram),
+        _inputRingBuffer(sizeof(TextBatchHeader) + (glyphCapacity * sizeof(GlyphInstance)), FramesInFlight),
+        _clipRingBuffer(ClipRectCapacity * sizeof(glm::vec4), FramesInFlight, TextBatchClipRectsBindingIndex)
+    {
+        _submittedText.reserve(glyphCapacity);
+
+        _textTransformUniform = shaderProgram.GetUniformHandle("TextTransform");
+        _textPickingUniform = shaderProgram.GetUniformHandle("TextPicking");
+        _glyphUsageFeedbackUniform = shaderProgram.GetUniformHandle("GlyphUsageFeedback");
+
+        glCreateVertexArrays(1, &_vao);
+    };
+
+    /// <param name="fontSet"> Must outlive the batch </param>
+    /// <param name="shaderProgram"> A program built from TextBatchVertexShader.glsl and the fragment shader FontSet::IsBindless calls for </param>
+    TextBatch(const FontSet& fontSet,
+              const ShaderProgram& shaderProgram,
+              const std::size_t glyphCapacity = 1024) :
+        _fontSet(&fontSet),
+        _shaderProgram(shaderProgram),
+        _inputRingBuffer(sizeof(TextBatchHeader) + (glyphCapacity * sizeof(GlyphInstance)), FramesInFlight),
+        _clipRingBuffer(ClipRectCapacity * sizeof(glm::vec4), FramesInFlight, TextBatchClipRectsBindingIndex)
+    {
+        _submittedText.reserve(glyphCapacity);
+
+        _textTransformUniform = shaderProgram.GetUniformHandle("TextTransform");
+        _textPickingUniform = shaderProgram.GetUniformHandle("TextPicking");
+
+        glCreateVertexArrays(1, &_vao);
+    };
+
+    /// <param name="fallbackChain"> Must outlive the batch. Strings are UTF-8, each character is drawn in the chain's first font that has it </param>
+    /// <param name="shaderProgram"> See the FontSet constructor </param>
+    TextBatch(FontFallbackChain& fallbackChain,
+              const ShaderProgram& shaderProgram,
+              const std::size_t glyphCapacity = 1024) :
+        TextBatch(fallbackChain.GetFontSet(), shaderProgram, glyphCapacity)
+    {
+        _fallbackChain = &fallbackChain;
+    };
+
+    TextBatch(const TextBatch&) = delete;
+    TextBatch& operator = (const TextBatch&) = delete;
+
+    ~TextBatch()
+    {
+        GLState.DeleteVertexArray(_vao);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Discard any glyphs submitted since the last flush
+    /// </summary>
+    /// <param name="frameMemory"> If set, the submitted strings are kept in it until the next Begin, e.g. a FrameArena that was just reset.
+    /// Otherwise they're kept on the heap, in storage that's reused from frame to frame </param>
+    void Begin(std::pmr::memory_resource* frameMemory = nullptr)
+    {
+        if(Recorder != nullptr)
+            Recorder->RecordBatchBegin();
+
+        std::pmr::memory_resource* memory = frameMemory != nullptr ? frameMemory : std::pmr::get_default_resource();
+
+        // Storage from a frame's memory is gone by the next frame, so it's never cleared and reused, the containers start over in the new memory.
+        // Assigning wouldn't do, pmr containers keep the resource they were created with
+        if(frameMemory != nullptr || _strings.get_allocator().resource() != memory)
+        {
+            std::destroy_at(&_strings);
+            std::construct_at(&_strings, memory);
+
+            std::destroy_at(&_submittedText);
+            std::construct_at(&_submittedText, memory);
+
+            std::destroy_at(&_shapedGlyphs);
+            std::construct_at(&_shapedGlyphs, memory);
+
+            std::destroy_at(&_clipRects);
+            std::construct_at(&_clipRects, memory);
+        };
+
+        Clear();
+    };
+
+
+    /// <summary>
+    /// Add a string to the batch
+    /// </summary>
+    /// <param name="text"> The text to draw. UTF-8 with a GlyphAtlas or a fallback chain, otherwise only ASCII has glyphs </param>
+    /// <param name="origin"> The top-left corner of the first character, in screen space </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    /// <param name="fontIndex"> (Font set) Which of the set's fonts the text is drawn in. A fallback chain picks every character's font itself </param>
+    /// <param name="layer"> Higher layers are drawn over lower ones whatever order they're submitted in, strings in the same layer overlap in submission order </param>
+    /// <param name="scale"> How much the string is scaled from the size its font was rasterized at, its advances included.
+    /// Headings and body text in the same font share its atlas and the batch's single draw this way. Distance field atlases stay sharp at any scale,
+    /// bitmap ones blur when scaled up </param>
+    /// <param name="style"> Underline and strikethrough are drawn by the fragment shader across every glyph's cell, spaces included, without any extra geometry.
+    /// A FontSprite's programs only draw them, and bold, with FontShaderFeature::Styles </param>
+    void Submit(const std::string_view& text, const glm::vec2& origin, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }, const std::uint32_t fontIndex = 0, const std::uint8_t layer = 0,
+                const float scale = 1.0f, const GlyphStyle style = GlyphStyle::None)
+    {
+        if(Recorder != nullptr)
+            Recorder->RecordBatchSubmit(text, origin, textColour, fontIndex, layer, scale, style);
+
+        PrepareText(text);
+
+        AddString(text, CountGlyphs(text, IsDecorated(style)), origin, textColour, fontIndex, layer, scale, style);
+    };
+
+    /// <summary>
+    /// Add an interned string to the batch, e.g. a label drawn every frame. Its glyphs are only counted the first time it's submitted, see StringTable
+    /// </summary>
+    /// <param name="strings"> The table the string was interned in, the same one for every interned string the batch draws </param>
+    /// <param name="string"> The string to draw </param>
+    /// <param name="origin"> See Submit </param>
+    /// <param name="textColour"> The text's foreground colour </param>
+    /// <param name="fontIndex"> See Submit </param>
+    /// <param name="layer"> See Submit </param>
+    /// <param name="scale"> See Submit </param>
+    /// <param name="style"> See Submit </param>
+    void Submit(const StringTable& strings, const InternedString string, const glm::vec2& origin, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }, const std::uint32_t fontIndex = 0, const std::uint8_t layer = 0,
+                const float scale = 1.0f, const GlyphStyle style = GlyphStyle::None)
+    {
+        if(_internedStrings != &strings)
+        {
+            _internedGlyphCounts.clear();
+            _internedStrings = &strings;
+        };
+
+        const std::string_view text = strings.Get(string);
+
+        if(Recorder != nullptr)
+            Recorder->RecordBatchSubmit(text, origin, textColour, fontIndex, layer, scale, style);
+
+        PrepareText(text);
+
+        // Decorated strings also count their spaces, only the plain count is kept
+        if(IsDecorated(style) == true)
+        {
+            AddString(text, CountGlyphs(text, true), origin, textColour, fontIndex, layer, scale, style);
+            return;
+        };
+
+        const auto [glyphCount, added] = _internedGlyphCounts.try_emplace(string.ID, 0);
+
+        if(added == true)
+            glyphCount->second = CountGlyphs(text, false);
+
+        AddString(text, glyphCount->second, origin, textColour, fontIndex, layer, scale, style);
+    };
+
+    /// <summary>
+    /// Add a string that was already shaped, e.g. from a ShapedTextCache, so its ligatures and contextual forms are drawn.
+    /// Only a GlyphAtlas draws shaped strings, its rasterizer must use the font the text was shaped with
+    /// </summary>
+    /// <param name="origin"> The top-left corner of the run, in screen space </param>
+    /// <param name="layer"> See Submit </param>
+    /// <param name="scale"> See Submit, the run's glyph positions are scaled with it </param>
+    /// <param name="style"> See Submit </param>
+    void SubmitShaped(const ShapedRun& run, const glm::vec2& origin, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }, const std::uint8_t layer = 0,
+                      const float scale = 1.0f, const GlyphStyle style = GlyphStyle::None)
+    {
+        wt::Assert(_glyphAtlas != nullptr, "Only a batch that draws with a GlyphAtlas takes shaped text");
+
+        // Rasterizing can't happen in parallel, the layout only looks glyphs up
+        for(const ShapedGlyph& glyph : run.Glyphs)
+        {
+            _glyphAtlas->PrepareGlyphIndex(glyph.GlyphIndex);
+        };
+
+        _strings.emplace_back(SubmittedString
+        {
+            .TextOffset = _shapedGlyphs.size(),
+            .TextSize = run.Glyphs.size(),
+            .Origin = origin,
+            .Colour = PackSpanColour(textColour),
+            .Scale = scale,
+            .Style = MaskBatchStyle(style),
+            .ClipIndex = _clipIndex,
+            .Layer = layer,
+            .Shaped = true,
+            .GlyphCount = run.Glyphs.size(),
+            .FirstInstance = _glyphCount,
+            .PickRun = Picking != nullptr ? Picking->AddRun() : 0,
+        });
+
+        _shapedGlyphs.insert(_shapedGlyphs.end(), run.Glyphs.cbegin(), run.Glyphs.cend());
+
+        _glyphCount += run.Glyphs.size();
+
+        _layered |= layer != 0;
+    };
+
+    /// <summary>
+    /// Add every paragraph of a shaped document, one line apart
+    /// </summary>
+    /// <param name="origin"> The top-left corner of the first paragraph, in screen space </param>
+    /// <param name="alignRight"> Right-align the paragraphs at origin.x + width instead, for right-to-left documents </param>
+    void SubmitShaped(const ShapedParagraphs& paragraphs, const glm::vec2& origin, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }, const std::uint8_t layer = 0,
+                      const bool alignRight = false, const float width = 0.0f)
+    {
+        wt::Assert(_glyphAtlas != nullptr, "Only a batch that draws with a GlyphAtlas takes shaped text");
+
+        const float lineHeight = _glyphAtlas->GetLineHeight();
+
+        for(std::size_t paragraph = 0; paragraph < paragraphs.GetParagraphCount(); ++paragraph)
+        {
+            const ShapedRun& run = paragraphs.GetRun(paragraph);
+
+            const float x = alignRight == true ? origin.x + width - run.Width : origin.x;
+
+            if(run.Glyphs.empty() == false)
+                SubmitShaped(run, { x, origin.y + static_cast<float>(paragraph) * lineHeight }, textColour, layer);
+        };
+    };
+
+
+    /// <summary>
+    /// Clip the strings submitted from now on to a rectangle, e.g. a scroll view's viewport, until the matching PopClip.
+    /// Nested clips are intersected. The rectangles travel with the glyphs, so clipped strings still share the batch's single draw
+    /// </summary>
+    /// <param name="rect"> Left, top, right, bottom, in screen space like the strings' origins </param>
+    void PushClip(const glm::vec4& rect)
+    {
+        if(Recorder != nullptr)
+            Recorder->RecordBatchPushClip(rect);
+
+        glm::vec4 clip = rect;
+
+        if(_clipStack.empty() == false)
+        {
+            const glm::vec4& parent = _clipStack.back();
+
+            clip = glm::vec4(std::max(clip.x, parent.x), std::max(clip.y, parent.y), std::min(clip.z, parent.z), std::min(clip.w, parent.w));
+        };
+
+        _clipStack.emplace_back(clip);
+
+        _clipIndex = AddClipRect(clip);
+    };
+
+    /// <summary>
+    /// Go back to the clip before the last PushClip
+    /// </summary>
+    void PopClip()
+    {
+        wt::Assert(_clipStack.empty() == false, "PopClip without a matching PushClip");
+
+        if(Recorder != nullptr)
+            Recorder->RecordBatchPopClip();
+
+        _clipStack.pop_back();
+
+        _clipIndex = _clipStack.empty() == true ? 0 : AddClipRect(_clipStack.back());
+    };
+
+
+    /// <summary>
+    /// Upload every submitted glyph and draw them all with a single draw call
+    /// </summary>
+    void Flush()
+    {
+        if(Recorder != nullptr)
+            Recorder->RecordBatchFlush(Transform);
+
+        if(_glyphCount == 0 || (_fontSprite != nullptr && _fontSprite->IsReady() == false))
+            return;
+
+        // Glyphs added since the last flush
+        if(_glyphAtlas != nullptr)
+            _glyphAtlas->Upload();
+
+        const std::size_t instancesSizeInBytes = _glyphCount * sizeof(GlyphInstance);
+        const std::size_t drawSizeInBytes = sizeof(TextBatchHeader) + instancesSizeInBytes;
+
+        std::byte* range = _inputRingBuffer.Allocate(drawSizeInBytes);
+
+        // If the current frame's region is out of space, grow the ring so the rest of the frame fits
+        if(range == nullptr)
+        {
+            _inputRingBuffer.Reallocate((_inputRingBuffer.GetRegionSizeInBytes() + drawSizeInBytes) * 2);
+
+            range = _inputRingBuffer.Allocate(drawSizeInBytes);
+        };
+
+
+        // Strings are drawn back to front by layer, whatever order they were submitted in, so overlapping layers blend correctly in the single draw
+        if(_layered == true)
+            SortStringsByLayer();
+
+        const TextBatchHeader header = GetHeader();
+
+        std::memcpy(range, &header, sizeof(header));
+
+
+        // The strings' slices don't overlap, so they're laid out straight into the mapped range from any thread
+        std::byte* instances = range + sizeof(header);
+
+        const bool picking = Picking != nullptr && Picking->IsPicking() == true;
+
+        std::byte* pickIDs = picking == true ? AllocatePickIDs() : nullptr;
+
+        const auto layoutStrings = [&](const std::size_t firstString, const std::size_t endString)
+        {
+            for(std::size_t index = firstString; index < endString; ++index)
+            {
+                LayoutString(_strings[index], instances, pickIDs);
+            };
+        };
+
+        if(Jobs != nullptr)
+            Jobs->ParallelFor(_strings.size(), StringsPerLayoutJob, layoutStrings);
+        else
+            layoutStrings(0, _strings.size());
+
+
+        const ShaderProgram& shaderProgram = _shaderProgram.get();
+
+        shaderProgram.Bind();
+
+        shaderProgram.SetMatrix4(_textTransformUniform, Transform);
+
+        if(_glyphAtlas != nullptr)
+        {
+            _glyphAtlas->Bind(0);
+
+            // Batches of atlases with and without feedback may share the program
+            shaderProgram.SetBool(_glyphUsageFeedbackUniform, _glyphAtlas->HasUsageFeedback());
+
+            GLState.BindAttributelessVertexArray(_vao);
+        }
+        else if(_fontSet != nullptr)
+        {
+            // Every font is bound at once, so strings in different fonts still share the draw
+            _fontSet->Bind(0);
+
+            GLState.BindAttributelessVertexArray(_vao);
+        }
+        else
+        {
+            GLState.BindTextureUnit(0, _fontSprite->_font->Texture.Get());
+
+            GLState.BindAttributelessVertexArray(_fontSprite->_font->VertexArray.Get());
+
+            _fontSprite->BindGlyphMetrics();
+        };
+
+        _inputRingBuffer.Bind();
+
+        const bool clipped = _clipRects.empty() == false;
+
+        if(clipped == true)
+            UploadClipRects();
+
+        if(DepthTest == true)
+        {
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_LEQUAL);
+        };
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, GlyphQuadVertexCount, static_cast<std::int32_t>(_glyphCount));
+
+        // The same instances again, clipped and depth-tested alike, writing their pick ids rather than their colours
+        if(picking == true)
+        {
+            _pickRingBuffer->Bind();
+
+            shaderProgram.SetBool(_textPickingUniform, true);
+
+            Picking->BeginDraw();
+
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, GlyphQuadVertexCount, static_cast<std::int32_t>(_glyphCount));
+
+            Picking->EndDraw();
+
+            shaderProgram.SetBool(_textPickingUniform, false);
+        };
+
+        if(DepthTest == true)
+            glDisable(GL_DEPTH_TEST);
+
+        if(clipped == true)
+            EnableClipDistances(false);
+
+        Clear();
+    };
+
+
+    /// <summary>
+    /// Signal that all of the current frame's flushes were issued
+    /// </summary>
+    void EndFrame() const
+    {
+        _inputRingBuffer.NextFrame();
+        _clipRingBuffer.NextFrame();
+
+        if(_pickRingBuffer.has_value() == true)
+            _pickRingBuffer->NextFrame();
+    };
+
+
+public:
+
+    std::size_t GetGlyphCount() const
+    {
+        return _glyphCount;
+    };
+
+    /// <summary>
+    /// The run id Picking gave the string added last, to match picks against. 0 without picking
+    /// </summary>
+    std::uint32_t GetLastRun() const
+    {
+        return _strings.empty() == false ? _strings.back().PickRun : 0;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Add the glyphs a string needs to the atlas, or resolve its characters' fonts. Rasterizing and resolving can't happen in parallel,
+    /// the layout only looks glyphs up
+    /// </summary>
+    void PrepareText(const std::string_view& text)
+    {
+        if(_glyphAtlas != nullptr)
+            _glyphAtlas->Prepare(text);
+        else if(_fallbackChain != nullptr)
+            _fallbackChain->Prepare(text);
+    };
+
+    /// <summary>
+    /// The styles a batch draws. The rest of the bits are the FontSprite layout's own, see AtlasSampling.glsl
+    /// </summary>
+    static constexpr GlyphStyle MaskBatchStyle(const GlyphStyle style)
+    {
+        return static_cast<GlyphStyle>(static_cast<std::uint32_t>(style) & static_cast<std::uint32_t>(GlyphStyle::Underline | GlyphStyle::Strikethrough | GlyphStyle::Bold));
+    };
+
+    static constexpr bool IsDecorated(const GlyphStyle style)
+    {
+        return (static_cast<std::uint32_t>(style) & static_cast<std::uint32_t>(GlyphStyle::Underline | GlyphStyle::Strikethrough)) != 0;
+    };
+
+    /// <summary>
+    /// Whether a codepoint is drawn as a glyph instance, see HasGlyphInstance. A decorated space is, so the decoration runs on across its cell
+    /// </summary>
+    static constexpr bool HasInstance(const char32_t codepoint, const bool decorated)
+    {
+        return decorated == true ? codepoint >= 32 : HasGlyphInstance(codepoint);
+    };
+
+    /// <summary>
+    /// The number of glyph instances a string lays out to. Control characters and spaces have none, see HasGlyphInstance.
+    /// Counting them up front gives every string its slice before any of them is laid out
+    /// </summary>
+    /// <param name="decorated"> Whether spaces get instances too, see HasInstance </param>
+    std::size_t CountGlyphs(const std::string_view& text, const bool decorated) const
+    {
+        const bool utf8 = _glyphAtlas != nullptr || _fallbackChain != nullptr;
+
+        if(decorated == true)
+        {
+            return static_cast<std::size_t>(std::count_if(text.cbegin(), text.cend(), [utf8](const char character)
+            {
+                const std::uint8_t byte = static_cast<std::uint8_t>(character);
+
+                return (utf8 == false || (byte & 0xC0) != 0x80) && HasInstance(byte, true) == true;
+            }));
+        };
+
+        if(utf8 == true)
+            return CountUTF8Glyphs(text);
+
+        return static_cast<std::size_t>(std::count_if(text.cbegin(), text.cend(), [](const char character)
+        {
+            return HasGlyphInstance(static_cast<std::uint8_t>(character));
+        }));
+    };
+
+    void AddString(const std::string_view& text, const std::size_t glyphCount, const glm::vec2& origin, const glm::vec4& textColour, const std::uint32_t fontIndex, const std::uint8_t layer,
+                   const float scale, const GlyphStyle style)
+    {
+        _strings.emplace_back(SubmittedString
+        {
+            .TextOffset = _submittedText.size(),
+            .TextSize = text.size(),
+            .Origin = origin,
+            .Colour = PackSpanColour(textColour),
+            .Scale = scale,
+            .Style = MaskBatchStyle(style),
+            .FontIndex = fontIndex,
+            .ClipIndex = _clipIndex,
+            .Layer = layer,
+            .GlyphCount = glyphCount,
+            .FirstInstance = _glyphCount,
+            .PickRun = Picking != nullptr ? Picking->AddRun() : 0,
+        });
+
+        _submittedText.append(text);
+
+        _glyphCount += glyphCount;
+
+        _layered |= layer != 0;
+    };
+
+
+    void Clear()
+    {
+        _strings.clear();
+        _submittedText.clear();
+        _shapedGlyphs.clear();
+        _clipRects.clear();
+
+        _glyphCount = 0;
+
+        _layered = false;
+
+        // A clip that's still pushed carries on into the next flush
+        _clipIndex = _clipStack.empty() == true ? 0 : AddClipRect(_clipStack.back());
+    };
+
+
+    /// <summary>
+    /// Order the strings by layer, keeping their submission order within a layer, and give them their new slices of the instances
+    /// </summary>
+    void SortStringsByLayer()
+    {
+        std::stable_sort(_strings.begin(), _strings.end(), [](const SubmittedString& left, const SubmittedString& right)
+        {
+            return left.Layer < right.Layer;
+        });
+
+        std::size_t firstInstance = 0;
+
+        for(SubmittedString& string : _strings)
+        {
+            string.FirstInstance = firstInstance;
+
+            firstInstance += string.GlyphCount;
+        };
+    };
+
+
+    /// <summary>
+    /// Add a rectangle to the clip table
+    /// </summary>
+    /// <returns> Its clip index </returns>
+    std::uint16_t AddClipRect(const glm::vec4& rect)
+    {
+        wt::Assert(_clipRects.size() < std::numeric_limits<std::uint16_t>::max(), "Too many clip rectangles in a single flush");
+
+        _clipRects.emplace_back(rect);
+
+        return static_cast<std::uint16_t>(_clipRects.size());
+    };
+
+    /// <summary>
+    /// Write the clip table into its ring, bind it, and turn on the clip distances the vertex shader writes
+    /// </summary>
+    void UploadClipRects()
+    {
+        const std::size_t sizeInBytes = _clipRects.size() * sizeof(glm::vec4);
+
+        std::byte* range = _clipRingBuffer.Allocate(sizeInBytes);
+
+        if(range == nullptr)
+        {
+            _clipRingBuffer.Reallocate((_clipRingBuffer.GetRegionSizeInBytes() + sizeInBytes) * 2);
+
+            range = _clipRingBuffer.Allocate(sizeInBytes);
+        };
+
+        std::memcpy(range, _clipRects.data(), sizeInBytes);
+
+        _clipRingBuffer.Bind();
+
+        EnableClipDistances(true);
+    };
+
+    /// <summary>
+    /// Make room for a pick id per glyph instance, the strings write theirs as they're laid out
+    /// </summary>
+    std::byte* AllocatePickIDs()
+    {
+        const std::size_t sizeInBytes = _glyphCount * sizeof(glm::uvec2);
+
+        if(_pickRingBuffer.has_value() == false)
+            _pickRingBuffer.emplace(std::max(sizeInBytes, _inputRingBuffer.GetRegionSizeInBytes() / sizeof(GlyphInstance) * sizeof(glm::uvec2)), FramesInFlight, TextBatchPickIDsBindingIndex);
+
+        std::byte* range = _pickRingBuffer->Allocate(sizeInBytes);
+
+        if(range == nullptr)
+        {
+            _pickRingBuffer->Reallocate((_pickRingBuffer->GetRegionSizeInBytes() + sizeInBytes) * 2);
+
+            range = _pickRingBuffer->Allocate(sizeInBytes);
+        };
+
+        return range;
+    };
+
+    /// <summary>
+    /// The vertex shader clips against a rectangle's four edges, with gl_ClipDistance 0 to 3
+    /// </summary>
+    static void EnableClipDistances(const bool enable)
+    {
+        for(std::uint32_t plane = 0; plane < 4; ++plane)
+        {
+            if(enable == true)
+                glEnable(GL_CLIP_DISTANCE0 + plane);
+            else
+                glDisable(GL_CLIP_DISTANCE0 + plane);
+        };
+    };
+
+
+    TextBatchHeader GetHeader() const
+    {
+        if(_glyphAtlas != nullptr)
+        {
+            return TextBatchHeader
+            {
+                .GlyphWidth = 0,
+                .GlyphHeight = static_cast<std::uint32_t>(_glyphAtlas->GetLineHeight()),
+                .TextureWidth = _glyphAtlas->GetLayerSize(),
+                .TextureHeight = _glyphAtlas->GetLayerSize(),
+                .ChromaKey = { 0.0f, 0.0f, 0.0f, 0.0f },
+            };
+        };
+
+        // Fonts have sizes of their own, the instances are already positioned. Decorations span the first font's line
+        if(_fontSet != nullptr)
+            return TextBatchHeader { .GlyphHeight = _fontSet->GetFont(0)._glyphHeight };
+
+        return TextBatchHeader
+        {
+            .GlyphWidth = _fontSprite->_glyphWidth,
+            .GlyphHeight = _fontSprite->_glyphHeight,
+            .TextureWidth = _fontSprite->_font->Width,
+            .TextureHeight = _fontSprite->_font->Height,
+            .ChromaKey = _fontSprite->_chromaKey,
+        };
+    };
+
+
+    /// <summary>
+    /// Write a string's glyph instances into its slice
+    /// </summary>
+    /// <param name="instances"> The start of the input block's instance array </param>
+    /// <param name="pickIDs"> The start of the pick id array, null if the frame doesn't pick </param>
+    void LayoutString(const SubmittedString& string, std::byte* instances, std::byte* pickIDs) const
+    {
+        std::byte* destination = instances + (string.FirstInstance * sizeof(GlyphInstance));
+
+        std::byte* pickDestination = pickIDs != nullptr ? pickIDs + (string.FirstInstance * sizeof(glm::uvec2)) : nullptr;
+
+        std::uint32_t pickGlyph = 0;
+
+        // Relative to the string's origin and at the font's own size, scaled as the instances are written
+        glm::vec2 position = { 0.0f, 0.0f };
+
+        // The mapping is write-only, instances are written whole and never read back
+        const std::uint32_t layerBits = static_cast<std::uint32_t>(string.Layer) << GlyphLayerShift;
+
+        const bool decorated = IsDecorated(string.Style);
+
+        // The advance is the cell's width, which only decorated glyphs are drawn across
+        const auto writeInstance = [&](const std::uint32_t glyphIndex, const std::uint32_t fontIndex, const float advance)
+        {
+            WT_ASSERT(glyphIndex < (1u << GlyphLayerShift), "Batched glyph indices must fit in 24 bits");
+            WT_ASSERT(fontIndex <= std::numeric_limits<std::uint8_t>::max(), "Batched font indices must fit in 8 bits");
+
+            const GlyphInstance instance
+            {
+                .Position = string.Origin + (position * string.Scale),
+                .GlyphIndex = glyphIndex | layerBits,
+                .FontIndex = static_cast<std::uint8_t>(fontIndex),
+                .Style = static_cast<std::uint8_t>(string.Style),
+                .ClipIndex = string.ClipIndex,
+                .Colour = string.Colour,
+                .ScaleAndCellWidth = glm::packHalf2x16(glm::vec2(string.Scale, advance * string.Scale)),
+            };
+
+            std::memcpy(destination, &instance, sizeof(instance));
+            destination += sizeof(instance);
+
+            if(pickDestination != nullptr)
+            {
+                const glm::uvec2 pickID = { string.PickRun, pickGlyph++ };
+
+                std::memcpy(pickDestination, &pickID, sizeof(pickID));
+                pickDestination += sizeof(pickID);
+            };
+        };
+
+
+        // Shaped glyphs were positioned when they were shaped, only their atlas slots are looked up
+        if(string.Shaped == true)
+        {
+            for(std::size_t index = string.TextOffset; index < string.TextOffset + string.TextSize; ++index)
+            {
+                const ShapedGlyph& shapedGlyph = _shapedGlyphs[index];
+
+                position = shapedGlyph.Position;
+
+                writeInstance(_glyphAtlas->FindGlyphIndex(shapedGlyph.GlyphIndex).Slot, string.FontIndex, shapedGlyph.Advance);
+            };
+
+            return;
+        };
+
+
+        const std::string_view text = std::string_view(_submittedText).substr(string.TextOffset, string.TextSize);
+
+        if(_glyphAtlas != nullptr)
+        {
+            ForEachCodepoint(text, [&](const char32_t codepoint)
+            {
+                // Control characters have no glyph, skip them
+                if(codepoint < 32)
+                    return;
+
+                const GlyphAtlas::Glyph glyph = _glyphAtlas->FindGlyph(codepoint);
+
+                // Spaces only advance, unless they're decorated. See CountGlyphs
+                if(HasInstance(codepoint, decorated) == true)
+                    writeInstance(glyph.Slot, string.FontIndex, glyph.Advance);
+
+                position.x += glyph.Advance;
+            });
+
+            return;
+        };
+
+
+        if(_fallbackChain != nullptr)
+        {
+            const FontSprite& primaryFont = _fallbackChain->GetFont(0);
+
+            std::uint32_t previousFont = 0;
+            std::uint32_t previousGlyph = KerningTable::NoGlyph;
+
+            ForEachCodepoint(text, [&](const char32_t codepoint)
+            {
+                // Control characters have no glyph, skip them. They take up a column in monospaced text, as in a single font
+                if(codepoint < 32)
+                {
+                    if(primaryFont._font->Proportional == false)
+                        position.x += static_cast<float>(primaryFont._glyphWidth);
+
+                    previousGlyph = KerningTable::NoGlyph;
+                    return;
+                };
+
+                const FontFallbackChain::ResolvedGlyph glyph = _fallbackChain->Find(codepoint);
+
+                const FontSprite& fontSprite = _fallbackChain->GetFont(glyph.FontIndex);
+
+                // Only glyphs of the same font kern with each other
+                if(fontSprite._font->Proportional == true && previousGlyph != KerningTable::NoGlyph && previousFont == glyph.FontIndex)
+                    position.x += fontSprite._font->Kerning.Find(previousGlyph, glyph.GlyphIndex);
+
+                const float advance = fontSprite._font->Proportional == true ? fontSprite._font->Metrics[glyph.GlyphIndex].Advance : static_cast<float>(fontSprite._glyphWidth);
+
+                if(HasInstance(codepoint, decorated) == true)
+                    writeInstance(_fontSet->GetFirstGlyph(glyph.FontIndex) + glyph.GlyphIndex, glyph.FontIndex, advance);
+
+                position.x += advance;
+
+                previousFont = glyph.FontIndex;
+                previousGlyph = glyph.GlyphIndex;
+            });
+
+            return;
+        };
+
+
+        // A font set's fonts share one metrics table, each font's glyphs start where the previous font's end
+        const FontSprite& fontSprite = _fontSet != nullptr ? _fontSet->GetFont(string.FontIndex) : *_fontSprite;
+
+        const std::uint32_t firstGlyph = _fontSet != nullptr ? _fontSet->GetFirstGlyph(string.FontIndex) : 0;
+
+        const float glyphWidth = static_cast<float>(fontSprite._glyphWidth);
+
+        std::uint32_t previousGlyph = KerningTable::NoGlyph;
+
+        for(const char character : text)
+        {
+            const std::uint8_t characterAsByte = static_cast<std::uint8_t>(character);
+
+            // Control characters have no glyph, skip them. They only take up a column in monospaced text, as in the GPU layout
+            if(characterAsByte < 32)
+            {
+                if(fontSprite._font->Proportional == false)
+                    position.x += glyphWidth;
+
+                previousGlyph = KerningTable::NoGlyph;
+                continue;
+            };
+
+            // Characters past the atlas's last glyph map to the fallback, rather than to the next font's first glyph
+            const std::uint32_t glyph = fontSprite._font->GlyphTable.Find(static_cast<char32_t>(characterAsByte));
+
+            // Spaces only advance, unless they're decorated. See CountGlyphs
+            const bool hasInstance = HasInstance(characterAsByte, decorated);
+
+            if(fontSprite._font->Proportional == false)
+            {
+                if(hasInstance == true)
+                    writeInstance(firstGlyph + glyph, string.FontIndex, glyphWidth);
+
+                position.x += glyphWidth;
+                continue;
+            };
+
+            if(previousGlyph != KerningTable::NoGlyph)
+                position.x += fontSprite._font->Kerning.Find(previousGlyph, glyph);
+
+            if(hasInstance == true)
+                writeInstance(firstGlyph + glyph, string.FontIndex, fontSprite._font->Metrics[glyph].Advance);
+
+            position.x += fontSprite._font->Metrics[glyph].Advance;
+            previousGlyph = glyph;
+        };
+    };
+
+
+    /// <summary>
+    /// How many strings a single layout job handles
+    /// </summary>
+    static constexpr std::size_t StringsPerLayoutJob = 16;
+
+    /// <summary>
+    /// The clip rectangles the ring starts with room for per frame, it grows if a frame needs more
+    /// </summary>
+    static constexpr std::size_t ClipRectCapacity = 64;
+
+    /// <summary>
+    /// Where a string's layer is in GlyphInstance::GlyphIndex
+    /// </summary>
+    static constexpr std::uint32_t GlyphLayerShift = 24;
+
+    /// <summary>
+    /// The number of frames the CPU can write ahead of the GPU
+    /// </summary>
+    static constexpr std::uint32_t FramesInFlight = 3;
+
+};
@@ -0,0 +1,537 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+/// <summary>
+/// A range of characters that changed since it was last taken, [Begin, End)
+/// </summary>
+struct TextDirtyRange
+{
+    std::size_t Begin = 0;
+    std::size_t End = 0;
+
+
+    bool IsEmpty() const
+    {
+        return Begin >= End;
+    };
+};
+
+
+/// <summary>
+/// A piece table for editable text.
+/// The text is a sequence of pieces referring to either the original text or an append-only buffer of insertions.
+/// Pieces are kept in an implicit treap ordered by position, so inserting and erasing anywhere is O(log n) regardless of the text's size
+/// </summary>
+class TextBuffer
+{
+
+public:
+
+    /// <summary>
+    /// Characters in one of the buffer's append-only buffers. Both only ever grow, so a reference stays valid for as long as the buffer exists,
+    /// which is how erased text is kept, e.g. by a TextUndoHistory, without copying it
+    /// </summary>
+    struct PieceReference
+    {
+        bool InAddBuffer = false;
+
+        std::size_t Start = 0;
+        std::size_t Length = 0;
+    };
+
+
+private:
+
+    static constexpr std::uint32_t InvalidPieceIndex = static_cast<std::uint32_t>(-1);
+
+
+    struct Piece
+    {
+        /// <summary>
+        /// The piece's text is in _addBuffer if true, _originalBuffer otherwise
+        /// </summary>
+        bool InAddBuffer = false;
+
+        std::size_t Start = 0;
+        std::size_t Length = 0;
+
+        /// <summary>
+        /// The total length of this piece and its children
+        /// </summary>
+        std::size_t SubtreeLength = 0;
+
+        /// <summary>
+        /// Random heap priority, keeps the tree balanced on average
+        /// </summary>
+        std::uint32_t Priority = 0;
+
+        std::uint32_t Left = InvalidPieceIndex;
+        std::uint32_t Right = InvalidPieceIndex;
+    };
+
+
+    std::string _originalBuffer;
+
+    std::string _addBuffer;
+
+    /// <summary>
+    /// Every piece, referred to by index. Erased pieces are recycled through _freePieces
+    /// </summary>
+    std::vector<Piece> _pieces;
+
+    std::vector<std::uint32_t> _freePieces;
+
+    std::uint32_t _root = InvalidPieceIndex;
+
+    std::uint32_t _randomState = 0x9E3779B9;
+
+
+    /// <summary>
+    /// The characters changed since the last call to TakeDirtyRange
+    /// </summary>
+    TextDirtyRange _dirtyRange;
+
+
+public:
+
+    TextBuffer() = default;
+
+    TextBuffer(std::string text) :
+        _originalBuffer(std::move(text))
+    {
+        if(_originalBuffer.empty() == false)
+            _root = CreatePiece(false, 0, _originalBuffer.size());
+
+        _dirtyRange = TextDirtyRange { 0, _originalBuffer.size() };
+    };
+
+
+public:
+
+    /// <summary>
+    /// Insert text before a position
+    /// </summary>
+    void Insert(const std::size_t position, const std::string_view& text)
+    {
+        if(text.empty() == true)
+            return;
+
+        const std::size_t insertPosition = std::min(position, GetSize());
+
+        const std::size_t addStart = _addBuffer.size();
+        _addBuffer.append(text);
+
+
+        auto [left, right] = Split(_root, insertPosition);
+
+        // Typing appends to the add buffer right after the previous insertion, so the previous piece can simply grow
+        const std::uint32_t previousPiece = GetLastPiece(left);
+
+        if(previousPiece != InvalidPieceIndex &&
+           _pieces[previousPiece].InAddBuffer == true &&
+           _pieces[previousPiece].Start + _pieces[previousPiece].Length == addStart)
+        {
+            _pieces[previousPiece].Length += text.size();
+
+            UpdatePath(left, insertPosition - 1);
+
+            _root = Merge(left, right);
+        }
+        else
+        {
+            const std::uint32_t piece = CreatePiece(true, addStart, text.size());
+
+            _root = Merge(Merge(left, piece), right);
+        };
+
+
+        // Everything after the insertion moved
+        MarkDirty(insertPosition, GetSize());
+    };
+
+    /// <summary>
+    /// Erase a number of characters starting at a position
+    /// </summary>
+    void Erase(const std::size_t position, const std::size_t count)
+    {
+        const std::size_t size = GetSize();
+
+        if(position >= size || count == 0)
+            return;
+
+        const std::size_t eraseCount = std::min(count, size - position);
+
+        auto [left, rest] = Split(_root, position);
+        auto [erased, right] = Split(rest, eraseCount);
+
+        FreePieces(erased);
+
+        _root = Merge(left, right);
+
+        // Everything after the erased range moved, the characters past the new end don't need to be uploaded
+        MarkDirty(position, GetSize());
+    };
+
+    /// <summary>
+    /// Insert text that's already in the buffer before a position, e.g. erased text being restored, without copying it.
+    /// A piece per reference is spliced in, O(log n) for a single reference
+    /// </summary>
+    /// <param name="pieces"> References from GetPieces, in order </param>
+    void InsertPieces(const std::size_t position, const std::span<const PieceReference>& pieces)
+    {
+        const std::size_t insertPosition = std::min(position, GetSize());
+
+        std::uint32_t inserted = InvalidPieceIndex;
+
+        for(const PieceReference& reference : pieces)
+        {
+            if(reference.Length == 0)
+                continue;
+
+            inserted = Merge(inserted, CreatePiece(reference.InAddBuffer, reference.Start, reference.Length));
+        };
+
+        if(inserted == InvalidPieceIndex)
+            return;
+
+        auto [left, right] = Split(_root, insertPosition);
+
+        _root = Merge(Merge(left, inserted), right);
+
+        MarkDirty(insertPosition, GetSize());
+    };
+
+    void Append(const std::string_view& text)
+    {
+        Insert(GetSize(), text);
+    };
+
+    void Clear()
+    {
+        Erase(0, GetSize());
+    };
+
+
+    /// <summary>
+    /// Call a function with every contiguous run of characters in a range, in order
+    /// </summary>
+    /// <param name="position"> The range's first character </param>
+    /// <param name="count"> The number of characters </param>
+    /// <param name="function"> Called with a std::string_view per run </param>
+    template<typename TFunction>
+    void ForEachRun(const std::size_t position, const std::size_t count, TFunction&& function) const
+    {
+        const std::size_t size = GetSize();
+
+        if(position >= size)
+            return;
+
+        ForEachRun(_root, position, std::min(position + count, size), 0, function);
+    };
+
+    /// <summary>
+    /// Get references to the characters of a range, a piece at a time, see InsertPieces
+    /// </summary>
+    /// <param name="pieces"> Receives the references, appended in order </param>
+    void GetPieces(const std::size_t position, const std::size_t count, std::vector<PieceReference>& pieces) const
+    {
+        const std::size_t size = GetSize();
+
+        if(position >= size)
+            return;
+
+        ForEachPiece(_root, position, std::min(position + count, size), 0, [&](const Piece& piece, const std::size_t offset, const std::size_t length)
+        {
+            pieces.push_back(PieceReference { .InAddBuffer = piece.InAddBuffer, .Start = piece.Start + offset, .Length = length });
+        });
+    };
+
+    /// <summary>
+    /// The characters a reference from GetPieces refers to. The reference stays valid whatever is edited, the view only until the next insert
+    /// </summary>
+    std::string_view GetPieceText(const PieceReference& piece) const
+    {
+        const std::string& buffer = piece.InAddBuffer == true ? _addBuffer : _originalBuffer;
+
+        return std::string_view(buffer).substr(piece.Start, piece.Length);
+    };
+
+    /// <summary>
+    /// Copy a range of characters into a string
+    /// </summary>
+    std::string GetText(const std::size_t position = 0, const std::size_t count = static_cast<std::size_t>(-1)) const
+    {
+        std::string text;
+
+        ForEachRun(position, count, [&](const std::string_view& run)
+        {
+            text.append(run);
+        });
+
+        return text;
+    };
+
+
+    /// <summary>
+    /// The range of characters changed since TakeDirtyRange was last called, left for it
+    /// </summary>
+    const TextDirtyRange& GetDirtyRange() const
+    {
+        return _dirtyRange;
+    };
+
+    /// <summary>
+    /// Get, and clear, the range of characters changed since the last call
+    /// </summary>
+    TextDirtyRange TakeDirtyRange()
+    {
+        return std::exchange(_dirtyRange, TextDirtyRange());
+    };
+
+
+    std::size_t GetSize() const
+    {
+        return GetSubtreeLength(_root);
+    };
+
+    bool IsEmpty() const
+    {
+        return GetSize() == 0;
+    };
+
+    /// <summary>
+    /// The number of pieces the text is currently split into
+    /// </summary>
+    std::size_t GetPieceCount() const
+    {
+        return _pieces.size() - _freePieces.size();
+    };
+
+
+private:
+
+    void MarkDirty(const std::size_t begin, const std::size_t end)
+    {
+        if(_dirtyRange.IsEmpty() == true)
+        {
+            _dirtyRange = TextDirtyRange { begin, end };
+            return;
+        };
+
+        // Every change dirties through to the end of the text, anything past the current end no longer exists
+        _dirtyRange.Begin = std::min(_dirtyRange.Begin, begin);
+        _dirtyRange.End = end;
+    };
+
+
+    std::uint32_t CreatePiece(const bool inAddBuffer, const std::size_t start, const std::size_t length)
+    {
+        // xorshift32
+        _randomState ^= _randomState << 13;
+        _randomState ^= _randomState >> 17;
+        _randomState ^= _randomState << 5;
+
+        const Piece piece
+        {
+            .InAddBuffer = inAddBuffer,
+            .Start = start,
+            .Length = length,
+            .SubtreeLength = length,
+            .Priority = _randomState,
+        };
+
+        if(_freePieces.empty() == false)
+        {
+            const std::uint32_t index = _freePieces.back();
+            _freePieces.pop_back();
+
+            _pieces[index] = piece;
+            return index;
+        };
+
+        _pieces.emplace_back(piece);
+
+        return static_cast<std::uint32_t>(_pieces.size() - 1);
+    };
+
+    void FreePieces(const std::uint32_t piece)
+    {
+        if(piece == InvalidPieceIndex)
+            return;
+
+        FreePieces(_pieces[piece].Left);
+        FreePieces(_pieces[piece].Right);
+
+        _freePieces.emplace_back(piece);
+    };
+
+
+    std::size_t GetSubtreeLength(const std::uint32_t piece) const
+    {
+        return piece == InvalidPieceIndex ? 0 : _pieces[piece].SubtreeLength;
+    };
+
+    void UpdateLength(const std::uint32_t piece)
+    {
+        Piece& node = _pieces[piece];
+
+        node.SubtreeLength = GetSubtreeLength(node.Left) + node.Length + GetSubtreeLength(node.Right);
+    };
+
+    /// <summary>
+    /// Recompute the subtree lengths on the path to the piece containing a position, after that piece changed length
+    /// </summary>
+    void UpdatePath(const std::uint32_t piece, const std::size_t position)
+    {
+        if(piece == InvalidPieceIndex)
+            return;
+
+        const Piece& node = _pieces[piece];
+        const std::size_t leftLength = GetSubtreeLength(node.Left);
+
+        if(position < leftLength)
+            UpdatePath(node.Left, position);
+        else if(position >= leftLength + node.Length && node.Right != InvalidPieceIndex)
+            UpdatePath(node.Right, position - leftLength - node.Length);
+
+        UpdateLength(piece);
+    };
+
+
+    std::uint32_t GetLastPiece(std::uint32_t piece) const
+    {
+        if(piece == InvalidPieceIndex)
+            return InvalidPieceIndex;
+
+        while(_pieces[piece].Right != InvalidPieceIndex)
+        {
+            piece = _pieces[piece].Right;
+        };
+
+        return piece;
+    };
+
+
+    /// <summary>
+    /// Split a tree into the first "position" characters and the rest, splitting the piece the position falls inside of if necessary
+    /// </summary>
+    std::pair<std::uint32_t, std::uint32_t> Split(const std::uint32_t piece, const std::size_t position)
+    {
+        if(piece == InvalidPieceIndex)
+            return { InvalidPieceIndex, InvalidPieceIndex };
+
+        const std::size_t leftLength = GetSubtreeLength(_pieces[piece].Left);
+        const std::size_t pieceLength = _pieces[piece].Length;
+
+        if(position <= leftLength)
+        {
+            auto [left, right] = Split(_pieces[piece].Left, position);
+
+            _pieces[piece].Left = right;
+            UpdateLength(piece);
+
+            return { left, piece };
+        };
+
+        if(position >= leftLength + pieceLength)
+        {
+            auto [left, right] = Split(_pieces[piece].Right, position - leftLength - pieceLength);
+
+            _pieces[piece].Right = left;
+            UpdateLength(piece);
+
+            return { piece, right };
+        };
+
+
+        // The position is inside this piece, its tail becomes a new piece that takes over the right subtree
+        const std::size_t splitOffset = position - leftLength;
+
+        const std::uint32_t tail = CreatePiece(_pieces[piece].InAddBuffer, _pieces[piece].Start + splitOffset, pieceLength - splitOffset);
+
+        // Keeping the same priority keeps the heap order intact
+        _pieces[tail].Priority = _pieces[piece].Priority;
+        _pieces[tail].Right = _pieces[piece].Right;
+        UpdateLength(tail);
+
+        _pieces[piece].Length = splitOffset;
+        _pieces[piece].Right = InvalidPieceIndex;
+        UpdateLength(piece);
+
+        return { piece, tail };
+    };
+
+    /// <summary>
+    /// Join two trees, every character of "left" comes before "right"
+    /// </summary>
+    std::uint32_t Merge(const std::uint32_t left, const std::uint32_t right)
+    {
+        if(left == InvalidPieceIndex)
+            return right;
+
+        if(right == InvalidPieceIndex)
+            return left;
+
+        if(_pieces[left].Priority > _pieces[right].Priority)
+        {
+            _pieces[left].Right = Merge(_pieces[left].Right, right);
+            UpdateLength(left);
+
+            return left;
+        };
+
+        _pieces[right].Left = Merge(left, _pieces[right].Left);
+        UpdateLength(right);
+
+        return right;
+    };
+
+
+    template<typename TFunction>
+    void ForEachRun(const std::uint32_t piece, const std::size_t begin, const std::size_t end, const std::size_t subtreeStart, TFunction& function) const
+    {
+        ForEachPiece(piece, begin, end, subtreeStart, [&](const Piece& node, const std::size_t offset, const std::size_t length)
+        {
+            const std::string& buffer = node.InAddBuffer == true ? _addBuffer : _originalBuffer;
+
+            function(std::string_view(buffer).substr(node.Start + offset, length));
+        });
+    };
+
+    /// <summary>
+    /// Call a function with every piece overlapping [begin, end), in order, with the offset and length of the overlapping part
+    /// </summary>
+    template<typename TFunction>
+    void ForEachPiece(const std::uint32_t piece, const std::size_t begin, const std::size_t end, const std::size_t subtreeStart, TFunction&& function) const
+    {
+        if(piece == InvalidPieceIndex)
+            return;
+
+        const Piece& node = _pieces[piece];
+
+        const std::size_t pieceStart = subtreeStart + GetSubtreeLength(node.Left);
+        const std::size_t pieceEnd = pieceStart + node.Length;
+
+        if(begin < pieceStart)
+            ForEachPiece(node.Left, begin, end, subtreeStart, function);
+
+        const std::size_t runBegin = std::max(begin, pieceStart);
+        const std::size_t runEnd = std::min(end, pieceEnd);
+
+        if(runBegin < runEnd)
+            function(node, runBegin - pieceStart, runEnd - runBegin);
+
+        if(end > pieceEnd)
+            ForEachPiece(node.Right, begin, end, pieceEnd, function);
+    };
+
+};
@@ -0,0 +1,653 @@
+#pragma once
+
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "PixelConversion.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The character drawn in place of anything the ASCII atlas has no glyph for
+/// </summary>
+constexpr char FallbackGlyphCharacter = '?';
+
+
+namespace TextConversionKernels
+{
+
+    /// <summary>
+    /// Whether a byte is kept as it is: printable ASCII, or the '\n' and '\t' the layout handles
+    /// </summary>
+    constexpr bool IsPlainCharacter(const std::uint8_t character)
+    {
+        return (character >= 0x20 && character <= 0x7E) || character == '\n' || character == '\t';
+    };
+
+    constexpr bool IsContinuationByte(const std::uint8_t byte)
+    {
+        return (byte & 0xC0) == 0x80;
+    };
+
+
+    /// <summary>
+    /// The length of the run of plain characters at the start of the text, 16 bytes at a time.
+    /// SSE2 is part of x64, so this needs no detection
+    /// </summary>
+    inline std::size_t FindPlainRunSSE2(const std::uint8_t* text, const std::size_t size)
+    {
+        const __m128i lowest = _mm_set1_epi8(0x1F);
+        const __m128i highest = _mm_set1_epi8(0x7F);
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i tab = _mm_set1_epi8('\t');
+
+        std::size_t index = 0;
+
+        for(; index + 16 <= size; index += 16)
+        {
+            const __m128i characters = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + index));
+
+            // Signed compares, bytes of 0x80 and up are negative and fail the first one
+            const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(characters, lowest), _mm_cmplt_epi8(characters, highest));
+            const __m128i plain = _mm_or_si128(printable, _mm_or_si128(_mm_cmpeq_epi8(characters, newline), _mm_cmpeq_epi8(characters, tab)));
+
+            const int plainMask = _mm_movemask_epi8(plain);
+
+            if(plainMask != 0xFFFF)
+            {
+                return index + static_cast<std::size_t>(std::countr_zero(static_cast<std::uint32_t>(~plainMask & 0xFFFF)));
+            };
+        };
+
+        while(index < size && IsPlainCharacter(text[index]) == true)
+        {
+            ++index;
+        };
+
+        return index;
+    };
+
+
+    /// <summary>
+    /// Decode a single character that isn't plain, starting at text[0]
+    /// </summary>
+    /// <param name="output"> Receives the character to draw, if any </param>
+    /// <returns> The number of bytes consumed, at least 1 </returns>
+    inline std::size_t DecodeOtherCharacter(const std::uint8_t* text, const std::size_t size, std::string& output)
+    {
+        const std::uint8_t lead = text[0];
+
+        if(lead < 0x80)
+        {
+            // "\r\n" line endings from the clipboard become a single '\n', other control characters have no glyph
+            if(lead != '\r')
+                output.push_back(FallbackGlyphCharacter);
+            else if(size < 2 || text[1] != '\n')
+                output.push_back('\n');
+
+            return 1;
+        };
+
+
+        // Leads that start no valid sequence, including overlong 2 byte forms and anything past U+10FFFF
+        const std::size_t length = lead >= 0xC2 && lead <= 0xDF ? 2 :
+                                   lead >= 0xE0 && lead <= 0xEF ? 3 :
+                                   lead >= 0xF0 && lead <= 0xF4 ? 4 :
+                                   0;
+
+        bool valid = length != 0 && length <= size;
+
+        for(std::size_t index = 1; valid == true && index < length; ++index)
+        {
+            valid = IsContinuationByte(text[index]);
+        };
+
+        // Overlong 3 and 4 byte forms, surrogates, and code points past U+10FFFF
+        if(valid == true)
+        {
+            const std::uint8_t second = text[1];
+
+            valid = (lead != 0xE0 || second >= 0xA0) &&
+                    (lead != 0xED || second <= 0x9F) &&
+                    (lead != 0xF0 || second >= 0x90) &&
+                    (lead != 0xF4 || second <= 0x8F);
+        };
+
+        // The atlas only has ASCII glyphs, so every valid non-ASCII code point draws as the fallback too.
+        // An invalid sequence only consumes its lead byte, so the next character isn't lost with it
+        output.push_back(FallbackGlyphCharacter);
+
+        return valid == true ? length : 1;
+    };
+
+
+    /// <summary>
+    /// Returns the number of characters packed, the remainder is left to PackGlyphCharactersScalar
+    /// </summary>
+    /// <param name="bytesPerCharacter"> 1, 2 or 4 </param>
+    inline std::size_t PackGlyphCharactersSSE2(const std::uint8_t* text, std::byte* destination, const std::size_t characterCount, const std::size_t bytesPerCharacter)
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        std::size_t index = 0;
+
+        for(; index + 16 <= characterCount; index += 16)
+        {
+            const __m128i characters = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + index));
+
+            // Runs start at any character, so the destination is only byte aligned
+            __m128i* output = reinterpret_cast<__m128i*>(destination + index * bytesPerCharacter);
+
+            if(bytesPerCharacter == 1)
+            {
+                _mm_storeu_si128(output, characters);
+                continue;
+            };
+
+            // Zero extending in order keeps the first character of a pair or quad in the low bits of its uint
+            const __m128i low = _mm_unpacklo_epi8(characters, zero);
+            const __m128i high = _mm_unpackhi_epi8(characters, zero);
+
+            if(bytesPerCharacter == 2)
+            {
+                _mm_storeu_si128(output, low);
+                _mm_storeu_si128(output + 1, high);
+                continue;
+            };
+
+            _mm_storeu_si128(output, _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(output + 1, _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(output + 2, _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(output + 3, _mm_unpackhi_epi16(high, zero));
+        };
+
+        return index;
+    };
+
+    /// <summary>
+    /// Returns the number of characters packed, the remainder is left to the narrower kernels
+    /// </summary>
+    inline std::size_t PackGlyphCharactersAVX2(const std::uint8_t* text, std::byte* destination, const std::size_t characterCount, const std::size_t bytesPerCharacter)
+    {
+        std::size_t index = 0;
+
+        for(; index + 32 <= characterCount; index += 32)
+        {
+            const __m256i characters = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + index));
+
+            __m256i* output = reinterpret_cast<__m256i*>(destination + index * bytesPerCharacter);
+
+            if(bytesPerCharacter == 1)
+            {
+                _mm256_storeu_si256(output, characters);
+                continue;
+            };
+
+            // The widening moves cross lanes, unlike unpack, so each half stays in order
+            const __m128i low = _mm256_castsi256_si128(characters);
+            const __m128i high = _mm256_extracti128_si256(characters, 1);
+
+            if(bytesPerCharacter == 2)
+            {
+                _mm256_storeu_si256(output, _mm256_cvtepu8_epi16(low));
+                _mm256_storeu_si256(output + 1, _mm256_cvtepu8_epi16(high));
+                continue;
+            };
+
+            _mm256_storeu_si256(output, _mm256_cvtepu8_epi32(low));
+            _mm256_storeu_si256(output + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(low, 8)));
+            _mm256_storeu_si256(output + 2, _mm256_cvtepu8_epi32(high));
+            _mm256_storeu_si256(output + 3, _mm256_cvtepu8_epi32(_mm_srli_si128(high, 8)));
+        };
+
+        return index;
+    };
+
+    inline void PackGlyphCharactersScalar(const std::uint8_t* text, std::byte* destination, const std::size_t characterCount, const std::size_t bytesPerCharacter)
+    {
+        for(std::size_t index = 0; index < characterCount; ++index)
+        {
+            const std::uint32_t character = text[index];
+
+            // Little-endian, copying the low bytes of the uint is the narrowing
+            std::memcpy(destination + index * bytesPerCharacter, &character, bytesPerCharacter);
+        };
+    };
+
+
+    /// <summary>
+    /// Returns the number of bytes scanned, the remainder is left to the narrower kernels
+    /// </summary>
+    /// <param name="baseOffset"> The offset of text[0] in the document, line starts are document offsets </param>
+    inline std::size_t FindLineStartsSSE2(const std::uint8_t* text, const std::size_t size, const std::uint64_t baseOffset, std::vector<std::uint64_t>& lineStarts)
+    {
+        const __m128i newline = _mm_set1_epi8('\n');
+
+        std::size_t index = 0;
+
+        for(; index + 16 <= size; index += 16)
+        {
+            std::uint32_t newlineMask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + index)), newline)));
+
+            // Most blocks of a log hold no newline at all
+            while(newlineMask != 0)
+            {
+                lineStarts.push_back(baseOffset + index + static_cast<std::size_t>(std::countr_zero(newlineMask)) + 1);
+
+                newlineMask &= newlineMask - 1;
+            };
+        };
+
+        return index;
+    };
+
+    /// <summary>
+    /// Returns the number of bytes scanned, the remainder is left to the narrower kernels
+    /// </summary>
+    inline std::size_t FindLineStartsAVX2(const std::uint8_t* text, const std::size_t size, const std::uint64_t baseOffset, std::vector<std::uint64_t>& lineStarts)
+    {
+        const __m256i newline = _mm256_set1_epi8('\n');
+
+        std::size_t index = 0;
+
+        for(; index + 32 <= size; index += 32)
+        {
+            std::uint32_t newlineMask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + index)), newline)));
+
+            while(newlineMask != 0)
+            {
+                lineStarts.push_back(baseOffset + index + static_cast<std::size_t>(std::countr_zero(newlineMask)) + 1);
+
+                newlineMask &= newlineMask - 1;
+            };
+        };
+
+        return index;
+    };
+
+    inline void FindLineStartsScalar(const std::uint8_t* text, const std::size_t size, const std::uint64_t baseOffset, std::vector<std::uint64_t>& lineStarts)
+    {
+        for(std::size_t index = 0; index < size; ++index)
+        {
+            if(text[index] == '\n')
+                lineStarts.push_back(baseOffset + index + 1);
+        };
+    };
+
+
+    /// <summary>
+    /// Returns the number of positions checked, the remainder is left to the narrower kernels.
+    /// A position is only compared in full if the query's first and last bytes are both there, which rules out nearly every position
+    /// </summary>
+    /// <param name="count"> The number of positions a match may start at </param>
+    inline std::size_t FindSubstringSSE2(const std::uint8_t* text, const std::size_t count, const std::string_view& query, const std::uint64_t baseOffset, std::vector<std::uint64_t>& matches)
+    {
+        const std::size_t last = query.size() - 1;
+
+        const __m128i first = _mm_set1_epi8(query.front());
+        const __m128i lastByte = _mm_set1_epi8(query.back());
+
+        std::size_t index = 0;
+
+        for(; index + 16 <= count; index += 16)
+        {
+            const __m128i firstBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + index));
+            const __m128i lastBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + index + last));
+
+            std::uint32_t candidateMask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firstBlock, first), _mm_cmpeq_epi8(lastBlock, lastByte))));
+
+            while(candidateMask != 0)
+            {
+                const std::size_t position = index + static_cast<std::size_t>(std::countr_zero(candidateMask));
+
+                if(last < 2 || std::memcmp(text + position + 1, query.data() + 1, last - 1) == 0)
+                    matches.push_back(baseOffset + position);
+
+                candidateMask &= candidateMask - 1;
+            };
+        };
+
+        return index;
+    };
+
+    /// <summary>
+    /// Returns the number of positions checked, the remainder is left to the narrower kernels
+    /// </summary>
+    inline std::size_t FindSubstringAVX2(const std::uint8_t* text, const std::size_t count, const std::string_view& query, const std::uint64_t baseOffset, std::vector<std::uint64_t>& matches)
+    {
+        const std::size_t last = query.size() - 1;
+
+        const __m256i first = _mm256_set1_epi8(query.front());
+        const __m256i lastByte = _mm256_set1_epi8(query.back());
+
+        std::size_t index = 0;
+
+        for(; index + 32 <= count; index += 32)
+        {
+            const __m256i firstBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + index));
+            const __m256i lastBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + index + last));
+
+            std::uint32_t candidateMask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(firstBlock, first), _mm256_cmpeq_epi8(lastBlock, lastByte))));
+
+            while(candidateMask != 0)
+            {
+                const std::size_t position = index + static_cast<std::size_t>(std::countr_zero(candidateMask));
+
+                if(last < 2 || std::memcmp(text + position + 1, query.data() + 1, last - 1) == 0)
+                    matches.push_back(baseOffset + position);
+
+                candidateMask &= candidateMask - 1;
+            };
+        };
+
+        return index;
+    };
+
+    inline void FindSubstringScalar(const std::uint8_t* text, const std::size_t count, const std::string_view& query, const std::uint64_t baseOffset, std::vector<std::uint64_t>& matches)
+    {
+        for(std::size_t index = 0; index < count; ++index)
+        {
+            if(std::memcmp(text + index, query.data(), query.size()) == 0)
+                matches.push_back(baseOffset + index);
+        };
+    };
+
+
+    /// <summary>
+    /// Returns the number of bytes scanned, the remainder is left to the narrower kernels
+    /// </summary>
+    template<typename TFunction>
+    inline std::size_t ForEachLayoutControlSSE2(const std::uint8_t* text, const std::size_t size, TFunction& onControl)
+    {
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i newline = _mm_set1_epi8('\n');
+
+        std::size_t index = 0;
+
+        for(; index + 16 <= size; index += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + index));
+
+            std::uint32_t controlMask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, tab), _mm_cmpeq_epi8(block, newline))));
+
+            while(controlMask != 0)
+            {
+                onControl(index + static_cast<std::size_t>(std::countr_zero(controlMask)));
+
+                controlMask &= controlMask - 1;
+            };
+        };
+
+        return index;
+    };
+
+    /// <summary>
+    /// Returns the number of bytes scanned, the remainder is left to the narrower kernels. Two blocks make a 64-bit mask, so a step without
+    /// controls, nearly all of them, costs a single branch per 64 bytes
+    /// </summary>
+    template<typename TFunction>
+    inline std::size_t ForEachLayoutControlAVX2(const std::uint8_t* text, const std::size_t size, TFunction& onControl)
+    {
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i newline = _mm256_set1_epi8('\n');
+
+        std::size_t index = 0;
+
+        for(; index + 64 <= size; index += 64)
+        {
+            const __m256i lowBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + index));
+            const __m256i highBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + index + 32));
+
+            const std::uint32_t lowMask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(lowBlock, tab), _mm256_cmpeq_epi8(lowBlock, newline))));
+            const std::uint32_t highMask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(highBlock, tab), _mm256_cmpeq_epi8(highBlock, newline))));
+
+            std::uint64_t controlMask = static_cast<std::uint64_t>(highMask) << 32 | lowMask;
+
+            while(controlMask != 0)
+            {
+                onControl(index + static_cast<std::size_t>(std::countr_zero(controlMask)));
+
+                controlMask &= controlMask - 1;
+            };
+        };
+
+        return index;
+    };
+
+    template<typename TFunction>
+    inline void ForEachLayoutControlScalar(const std::uint8_t* text, const std::size_t size, TFunction& onControl)
+    {
+        for(std::size_t index = 0; index < size; ++index)
+        {
+            if(text[index] == '\t' || text[index] == '\n')
+                onControl(index);
+        };
+    };
+
+
+    /// <summary>
+    /// The length of the text before its first ESC, or its first '{' if markup is read too. Returns size if there's neither
+    /// </summary>
+    inline std::size_t FindStyleEscapeSSE2(const std::uint8_t* text, const std::size_t size, const bool markup)
+    {
+        const __m128i escape = _mm_set1_epi8(0x1B);
+        const __m128i brace = _mm_set1_epi8(markup == true ? '{' : 0x1B);
+
+        std::size_t index = 0;
+
+        for(; index + 16 <= size; index += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + index));
+
+            const std::uint32_t escapeMask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, escape), _mm_cmpeq_epi8(block, brace))));
+
+            if(escapeMask != 0)
+                return index + static_cast<std::size_t>(std::countr_zero(escapeMask));
+        };
+
+        for(; index < size; ++index)
+        {
+            if(text[index] == 0x1B || (markup == true && text[index] == '{'))
+                return index;
+        };
+
+        return size;
+    };
+
+    /// <summary>
+    /// Returns the number of bytes scanned without finding one, the remainder is left to FindStyleEscapeSSE2
+    /// </summary>
+    inline std::size_t FindStyleEscapeAVX2(const std::uint8_t* text, const std::size_t size, const bool markup)
+    {
+        const __m256i escape = _mm256_set1_epi8(0x1B);
+        const __m256i brace = _mm256_set1_epi8(markup == true ? '{' : 0x1B);
+
+        std::size_t index = 0;
+
+        for(; index + 32 <= size; index += 32)
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + index));
+
+            const std::uint32_t escapeMask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, escape), _mm256_cmpeq_epi8(block, brace))));
+
+            if(escapeMask != 0)
+                return index + static_cast<std::size_t>(std::countr_zero(escapeMask));
+        };
+
+        return index;
+    };
+
+};
+
+
+/// <summary>
+/// Decode UTF-8 into the characters the atlas can draw, appended to output.
+/// Every code point becomes one character: plain ASCII as it is, anything else as FallbackGlyphCharacter, and "\r\n" as '\n'.
+/// Runs of plain ASCII, the bulk of any pasted log, are found 16 bytes at a time and copied in one go
+/// </summary>
+/// <param name="utf8"> The text, invalid sequences are replaced rather than rejected </param>
+/// <param name="output"> Receives the converted characters </param>
+inline void DecodeUTF8ToGlyphText(const std::string_view& utf8, std::string& output)
+{
+    const std::uint8_t* text = reinterpret_cast<const std::uint8_t*>(utf8.data());
+    const std::size_t size = utf8.size();
+
+    // Never more characters than bytes
+    output.reserve(output.size() + size);
+
+    std::size_t index = 0;
+
+    while(index < size)
+    {
+        const std::size_t plainRun = TextConversionKernels::FindPlainRunSSE2(text + index, size - index);
+
+        output.append(utf8.data() + index, plainRun);
+        index += plainRun;
+
+        if(index < size)
+            index += TextConversionKernels::DecodeOtherCharacter(text + index, size - index, output);
+    };
+};
+
+/// <summary>
+/// Append a single code point, as typed, converted the same way DecodeUTF8ToGlyphText converts text
+/// </summary>
+inline void AppendCodepointAsGlyphText(const char32_t codepoint, std::string& output)
+{
+    if(codepoint < 0x80 && TextConversionKernels::IsPlainCharacter(static_cast<std::uint8_t>(codepoint)) == true)
+        output.push_back(static_cast<char>(codepoint));
+    else
+        output.push_back(FallbackGlyphCharacter);
+};
+
+
+/// <summary>
+/// Write characters the way the Input block's Characters array holds them for a packing of "bitsPerCharacter".
+/// Bytes are only widened: the layout pass maps every character through the font's glyph table, which sends characters the atlas has no glyph for
+/// to its missing glyph and skips control characters, so raw bytes can be passed without checking them first.
+/// 32 or 16 characters are converted per step with AVX2 or SSE2, straight into the destination, which can be a mapped buffer
+/// </summary>
+/// <param name="text"> The characters, one byte each </param>
+/// <param name="destination"> Receives text.size() * bitsPerCharacter / 8 bytes, no alignment required </param>
+/// <param name="bitsPerCharacter"> 8, 16 or 32 </param>
+inline void PackGlyphCharacters(const std::string_view& text, std::byte* destination, const std::size_t bitsPerCharacter)
+{
+    wt::Assert(bitsPerCharacter == 8 || bitsPerCharacter == 16 || bitsPerCharacter == 32, "Invalid character packing");
+
+    const std::uint8_t* characters = reinterpret_cast<const std::uint8_t*>(text.data());
+    const std::size_t bytesPerCharacter = bitsPerCharacter / 8;
+
+    // Same CPU detection as the pixel kernels, AVX2 is all that matters here since SSE2 is part of x64
+    std::size_t packed = 0;
+
+    if(GetPixelConversionPath() == PixelConversionPath::AVX2)
+        packed = TextConversionKernels::PackGlyphCharactersAVX2(characters, destination, text.size(), bytesPerCharacter);
+
+    packed += TextConversionKernels::PackGlyphCharactersSSE2(characters + packed, destination + packed * bytesPerCharacter, text.size() - packed, bytesPerCharacter);
+
+    TextConversionKernels::PackGlyphCharactersScalar(characters + packed, destination + packed * bytesPerCharacter, text.size() - packed, bytesPerCharacter);
+};
+
+
+/// <summary>
+/// Append the offset of every line that starts in a text, the offset after each '\n'.
+/// 32 or 16 bytes are compared per step with AVX2 or SSE2, so indexing a large file is bound by memory rather than by the scan
+/// </summary>
+/// <param name="text"> The text to scan, any part of a document </param>
+/// <param name="baseOffset"> The offset of the text's first byte in the document </param>
+/// <param name="lineStarts"> Receives the line starts, in order </param>
+inline void FindLineStarts(const std::string_view& text, const std::uint64_t baseOffset, std::vector<std::uint64_t>& lineStarts)
+{
+    const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(text.data());
+
+    std::size_t scanned = 0;
+
+    if(GetPixelConversionPath() == PixelConversionPath::AVX2)
+        scanned = TextConversionKernels::FindLineStartsAVX2(bytes, text.size(), baseOffset, lineStarts);
+
+    scanned += TextConversionKernels::FindLineStartsSSE2(bytes + scanned, text.size() - scanned, baseOffset + scanned, lineStarts);
+
+    TextConversionKernels::FindLineStartsScalar(bytes + scanned, text.size() - scanned, baseOffset + scanned, lineStarts);
+};
+
+
+/// <summary>
+/// Append the offset of every occurrence of a query in a text, overlapping ones included.
+/// 32 or 16 positions are ruled out per step with AVX2 or SSE2 by the query's first and last bytes, only the rest are compared in full
+/// </summary>
+/// <param name="text"> The text to search, any part of a document </param>
+/// <param name="query"> What to look for, nothing is found for an empty query </param>
+/// <param name="baseOffset"> The offset of the text's first byte in the document </param>
+/// <param name="matches"> Receives the offsets of the matches' first bytes, in order </param>
+inline void FindSubstring(const std::string_view& text, const std::string_view& query, const std::uint64_t baseOffset, std::vector<std::uint64_t>& matches)
+{
+    if(query.empty() == true || query.size() > text.size())
+        return;
+
+    const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(text.data());
+
+    // Every block also reads query.size() - 1 bytes past its last position, which stay inside the text
+    const std::size_t positionCount = text.size() - query.size() + 1;
+
+    std::size_t checked = 0;
+
+    if(GetPixelConversionPath() == PixelConversionPath::AVX2)
+        checked = TextConversionKernels::FindSubstringAVX2(bytes, positionCount, query, baseOffset, matches);
+
+    checked += TextConversionKernels::FindSubstringSSE2(bytes + checked, positionCount - checked, query, baseOffset + checked, matches);
+
+    TextConversionKernels::FindSubstringScalar(bytes + checked, positionCount - checked, query, baseOffset + checked, matches);
+};
+
+
+/// <summary>
+/// Call a function for every '\t' and '\n' of a text, in order. They're the only characters a monospaced layout doesn't advance a column for,
+/// so everything between two of them is a run whose rows follow from its length, see TextMetrics::CountRows.
+/// 64 or 16 bytes are classified per step with AVX2 or SSE2 into a mask, and only its set bits are visited
+/// </summary>
+/// <param name="onControl"> Called as onControl(index) </param>
+template<typename TFunction>
+inline void ForEachLayoutControl(const std::string_view& text, TFunction&& onControl)
+{
+    const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(text.data());
+
+    std::size_t scanned = 0;
+
+    const auto onControlAt = [&](const std::size_t index)
+    {
+        onControl(scanned + index);
+    };
+
+    if(GetPixelConversionPath() == PixelConversionPath::AVX2)
+        scanned = TextConversionKernels::ForEachLayoutControlAVX2(bytes, text.size(), onControlAt);
+
+    scanned += TextConversionKernels::ForEachLayoutControlSSE2(bytes + scanned, text.size() - scanned, onControlAt);
+
+    TextConversionKernels::ForEachLayoutControlScalar(bytes + scanned, text.size() - scanned, onControlAt);
+};
+
+
+/// <summary>
+/// The length of a text's run before its first escape byte, ESC for ANSI sequences or '{' for StyledTextParser's markup.
+/// 32 or 16 bytes are compared per step with AVX2 or SSE2, plain log text is skipped over at memory speed
+/// </summary>
+/// <param name="markup"> Whether '{' counts too </param>
+/// <returns> text.size() if there's none </returns>
+inline std::size_t FindStyleEscape(const std::string_view& text, const bool markup)
+{
+    const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(text.data());
+
+    std::size_t scanned = 0;
+
+    if(GetPixelConversionPath() == PixelConversionPath::AVX2)
+        scanned = TextConversionKernels::FindStyleEscapeAVX2(bytes, text.size(), markup);
+
+    return scanned + TextConversionKernels::FindStyleEscapeSSE2(bytes + scanned, text.size() - scanned, markup);
+};
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include "TextBatch.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// Text recorded for a TextBatch, on any thread. A widget updated on a worker records its strings, positions, colours and clips here
+/// without touching GL, and the render thread submits the recorded lists to a batch, which lays them all out and draws them together.
+/// A list is written by one thread at a time and keeps its storage from frame to frame, so recording stops allocating once it grew.
+/// See TextDrawListSet for handing lists out to workers
+/// </summary>
+class TextDrawList
+{
+
+private:
+
+    struct RecordedString
+    {
+        std::size_t TextOffset = 0;
+        std::size_t TextSize = 0;
+
+        glm::vec2 Origin = { 0.0f, 0.0f };
+
+        glm::vec4 Colour = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+        std::uint32_t FontIndex = 0;
+
+        /// <summary>
+        /// Clip rectangle N is at _clipRects[N - 1], 0 is unclipped
+        /// </summary>
+        std::uint32_t ClipIndex = 0;
+
+        std::uint8_t Layer = 0;
+    };
+
+
+    std::vector<RecordedString> _strings;
+
+    /// <summary>
+    /// The characters of every recorded string, back to back
+    /// </summary>
+    std::string _text;
+
+    std::vector<glm::vec4> _clipRects;
+
+    /// <summary>
+    /// The rectangles pushed by PushClip, each already intersected with the one below it
+    /// </summary>
+    std::vector<glm::vec4> _clipStack;
+
+    std::uint32_t _clipIndex = 0;
+
+
+public:
+
+    /// <summary>
+    /// Added to the origin and clip rectangles of everything recorded, e.g. the position of the widget being recorded
+    /// </summary>
+    glm::vec2 Offset = { 0.0f, 0.0f };
+
+
+public:
+
+    /// <summary>
+    /// Record a string, see TextBatch::Submit
+    /// </summary>
+    /// <param name="origin"> The top-left corner of the first character, relative to Offset </param>
+    void Add(const std::string_view& text, const glm::vec2& origin, const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }, const std::uint32_t fontIndex = 0, const std::uint8_t layer = 0)
+    {
+        if(text.empty() == true)
+            return;
+
+        _strings.emplace_back(RecordedString
+        {
+            .TextOffset = _text.size(),
+            .TextSize = text.size(),
+            .Origin = origin + Offset,
+            .Colour = textColour,
+            .FontIndex = fontIndex,
+            .ClipIndex = _clipIndex,
+            .Layer = layer,
+        });
+
+        _text.append(text);
+    };
+
+    /// <summary>
+    /// Clip the strings recorded from now on, see TextBatch::PushClip
+    /// </summary>
+    /// <param name="rect"> Left, top, right, bottom, relative to Offset </param>
+    void PushClip(const glm::vec4& rect)
+    {
+        glm::vec4 clip = rect + glm::vec4(Offset, Offset);
+
+        if(_clipStack.empty() == false)
+        {
+            const glm::vec4& parent = _clipStack.back();
+
+            clip = glm::vec4(std::max(clip.x, parent.x), std::max(clip.y, parent.y), std::min(clip.z, parent.z), std::min(clip.w, parent.w));
+        };
+
+        _clipStack.emplace_back(clip);
+        _clipRects.emplace_back(clip);
+
+        _clipIndex = static_cast<std::uint32_t>(_clipRects.size());
+    };
+
+    void PopClip()
+    {
+        wt::Assert(_clipStack.empty() == false, "PopClip without a matching PushClip");
+
+        _clipStack.pop_back();
+
+        if(_clipStack.empty() == true)
+            _clipIndex = 0;
+        else
+        {
+            _clipRects.emplace_back(_clipStack.back());
+
+            _clipIndex = static_cast<std::uint32_t>(_clipRects.size());
+        };
+    };
+
+    /// <summary>
+    /// Forget everything recorded, keeping the storage
+    /// </summary>
+    void Clear()
+    {
+        _strings.clear();
+        _text.clear();
+        _clipRects.clear();
+        _clipStack.clear();
+
+        _clipIndex = 0;
+
+        Offset = { 0.0f, 0.0f };
+    };
+
+
+    /// <summary>
+    /// (Render thread) Submit every recorded string to a batch, in the order they were recorded.
+    /// Clips are pushed on the batch's own, so a list submitted inside a clip stays inside it
+    /// </summary>
+    void SubmitTo(TextBatch& batch) const
+    {
+        std::uint32_t clipIndex = 0;
+
+        for(const RecordedString& string : _strings)
+        {
+            if(string.ClipIndex != clipIndex)
+            {
+                if(clipIndex != 0)
+                    batch.PopClip();
+
+                if(string.ClipIndex != 0)
+                    batch.PushClip(_clipRects[string.ClipIndex - 1]);
+
+                clipIndex = string.ClipIndex;
+            };
+
+            batch.Submit(std::string_view(_text).substr(string.TextOffset, string.TextSize), string.Origin, string.Colour, string.FontIndex, string.Layer);
+        };
+
+        if(clipIndex != 0)
+            batch.PopClip();
+    };
+
+
+public:
+
+    bool IsEmpty() const
+    {
+        return _strings.empty();
+    };
+
+    std::size_t GetStringCount() const
+    {
+        return _strings.size();
+    };
+
+};
+
+
+/// <summary>
+/// Hands TextDrawLists out to any number of threads, and submits them all to a batch on the render thread.
+/// Every list is owned by the thread that acquired it until the set is submitted, so recording never takes a lock, only acquiring does.
+/// Lists are submitted by their order key rather than by which thread got there first, so the frame draws the same however the workers ran
+/// </summary>
+class TextDrawListSet
+{
+
+private:
+
+    struct AcquiredList
+    {
+        std::uint32_t Order = 0;
+
+        TextDrawList* List = nullptr;
+    };
+
+
+    /// <summary>
+    /// A deque, so handing out a list never moves the ones other threads are writing
+    /// </summary>
+    std::deque<TextDrawList> _lists;
+
+    std::vector<AcquiredList> _acquired;
+
+    std::mutex _lock;
+
+
+public:
+
+    TextDrawListSet() = default;
+
+    TextDrawListSet(const TextDrawListSet&) = delete;
+    TextDrawListSet& operator = (const TextDrawListSet&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// (Any thread) Get an empty list to record into, the calling thread owns it until Submit
+    /// </summary>
+    /// <param name="order"> Where the list is drawn among the others, lower first. Lists with the same order are drawn in acquisition order </param>
+    TextDrawList& Acquire(const std::uint32_t order = 0)
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        // Lists submitted last frame are reused with their storage
+        if(_acquired.size() == _lists.size())
+            _lists.emplace_back();
+
+        TextDrawList& list = _lists[_acquired.size()];
+
+        list.Clear();
+
+        _acquired.push_back(AcquiredList
+        {
+            .Order = order,
+            .List = &list,
+        });
+
+        return list;
+    };
+
+    /// <summary>
+    /// (Render thread) Submit every acquired list to a batch and take them back. Every thread must be done recording
+    /// </summary>
+    void Submit(TextBatch& batch)
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        std::stable_sort(_acquired.begin(), _acquired.end(), [](const AcquiredList& left, const AcquiredList& right)
+        {
+            return left.Order < right.Order;
+        });
+
+        for(const AcquiredList& acquired : _acquired)
+        {
+            acquired.List->SubmitTo(batch);
+        };
+
+        _acquired.clear();
+    };
+
+};
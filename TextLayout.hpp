@@ -0,0 +1,473 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <glm/mat4x4.hpp>
+
+#include "ComputeProgram.hpp"
+#include "GLObject.hpp"
+#include "GLStateCache.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// The shader storage binding the visible, laid out glyphs are written to, read by FontSpriteVertexShader.glsl
+/// </summary>
+constexpr std::uint32_t GlyphInstancesBindingIndex = 2;
+
+/// <summary>
+/// Scratch bindings used by the layout pass
+/// </summary>
+constexpr std::uint32_t LayoutCharacterLinesBindingIndex = 3;
+constexpr std::uint32_t LayoutLinesBindingIndex = 4;
+constexpr std::uint32_t LayoutGlyphCellsBindingIndex = 5;
+
+/// <summary>
+/// The shader storage binding the layout pass writes its indirect draw command to
+/// </summary>
+constexpr std::uint32_t LayoutDrawCommandBindingIndex = 6;
+
+/// <summary>
+/// Scratch binding the layout pass decodes UTF-8 input into
+/// </summary>
+constexpr std::uint32_t LayoutDecodedCharactersBindingIndex = 17;
+
+
+/// <summary>
+/// The arguments of glDrawArraysIndirect, as written by the layout pass
+/// </summary>
+struct DrawArraysIndirectCommand
+{
+    std::uint32_t VertexCount;
+    std::uint32_t InstanceCount;
+    std::uint32_t FirstVertex;
+    std::uint32_t BaseInstance;
+};
+
+
+/// <summary>
+/// (Text rings) Where the layout pass reads characters when Characters[] is a ring, see TextRing
+/// </summary>
+struct CharacterRing
+{
+    /// <summary>
+    /// The number of characters in the ring, 0 if Characters[] isn't a ring
+    /// </summary>
+    std::uint32_t Capacity = 0;
+
+    /// <summary>
+    /// Where the text's first character is in the ring
+    /// </summary>
+    std::uint32_t FirstCharacter = 0;
+};
+
+
+/// <summary>
+/// How the layout pass reads Characters[] beyond their packing
+/// </summary>
+struct CharacterEncoding
+{
+    /// <summary>
+    /// The characters are UTF-8 bytes, 8 bits each, decoded by the layout pass itself
+    /// </summary>
+    bool Utf8 = false;
+
+    /// <summary>
+    /// The number of high bits of every character that index the colour palette bound to TextPaletteBindingIndex, 0 for none.
+    /// Index 0 is the draw's own colour, see FontSprite::DrawPaletted
+    /// </summary>
+    std::uint32_t PaletteBits = 0;
+};
+
+
+/// <summary>
+/// How text is broken into lines
+/// </summary>
+struct TextLayoutOptions
+{
+    /// <summary>
+    /// Lines longer than this, in pixels, wrap onto the next row. 0 disables wrapping
+    /// </summary>
+    float WrapWidth = 0.0f;
+
+    /// <summary>
+    /// Tabs advance to the next multiple of this many columns, or of this many spaces for proportional fonts
+    /// </summary>
+    std::uint32_t TabSize = 4;
+
+    /// <summary>
+    /// The distance between rows, in pixels. 0 uses the glyph height
+    /// </summary>
+    float LineHeight = 0.0f;
+
+
+    bool operator == (const TextLayoutOptions&) const = default;
+};
+
+
+/// <summary>
+/// A hash of a string and the options it's laid out with, for caches of laid out text. Entries still compare both, a collision is a miss
+/// </summary>
+inline std::uint64_t HashLaidOutText(const std::string_view& text, const TextLayoutOptions& options)
+{
+    std::uint64_t hash = std::hash<std::string_view>()(text);
+
+    const auto combine = [&](const std::uint64_t value)
+    {
+        hash ^= value + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+    };
+
+    combine(std::hash<float>()(options.WrapWidth));
+    combine(options.TabSize);
+    combine(std::hash<float>()(options.LineHeight));
+
+    return hash;
+};
+
+
+/// <summary>
+/// Lays out text on the GPU. Handles '\n', '\t' and wrapping, in columns for monospaced fonts or by advance and kerning for proportional ones,
+/// culls invisible glyphs and writes the rest, compacted, along with the indirect draw command that draws them.
+/// The CPU never reads the glyph count back. See TextLayoutComputeShader.glsl
+/// </summary>
+class TextLayout
+{
+
+private:
+
+    /// <summary>
+    /// Shared by every TextLayout on the thread's context that uses the same shader, see GetSharedProgram
+    /// </summary>
+    std::shared_ptr<const ComputeProgram> _layoutProgram;
+
+    std::int32_t _characterCountLocation = -1;
+    std::int32_t _bitsPerCharacterLocation = -1;
+    std::int32_t _utf8Location = -1;
+    std::int32_t _paletteBitsLocation = -1;
+    std::int32_t _ringCapacityLocation = -1;
+    std::int32_t _ringFirstCharacterLocation = -1;
+    std::int32_t _tabSizeLocation = -1;
+    std::int32_t _wrapColumnsLocation = -1;
+    std::int32_t _proportionalLocation = -1;
+    std::int32_t _wrapWidthLocation = -1;
+    std::int32_t _spanCountLocation = -1;
+    std::int32_t _lineHeightLocation = -1;
+    std::int32_t _glyphHeightForCullingLocation = -1;
+    std::int32_t _textTransformLocation = -1;
+    std::int32_t _cullGlyphsLocation = -1;
+    std::int32_t _firstInstanceLocation = -1;
+    std::int32_t _drawCommandIndexLocation = -1;
+
+
+    /// <summary>
+    /// A 16 byte LaidOutGlyph per character, and one per background, the layout's output
+    /// </summary>
+    mutable GLBuffer _glyphInstancesBuffer;
+
+    /// <summary>
+    /// How many LaidOutGlyphs _glyphInstancesBuffer can hold
+    /// </summary>
+    mutable std::size_t _instanceCapacity = 0;
+
+    /// <summary>
+    /// A vec2 per character
+    /// </summary>
+    mutable GLBuffer _glyphCellsBuffer;
+
+    /// <summary>
+    /// A uint per character
+    /// </summary>
+    mutable GLBuffer _characterLinesBuffer;
+
+    /// <summary>
+    /// A uvec2 per line, at most every character is a newline, plus the sentinel
+    /// </summary>
+    mutable GLBuffer _linesBuffer;
+
+    /// <summary>
+    /// A uint per character, only created once UTF-8 is laid out
+    /// </summary>
+    mutable GLBuffer _decodedCharactersBuffer;
+
+    /// <summary>
+    /// How many characters the buffers can lay out
+    /// </summary>
+    mutable std::size_t _capacity = 0;
+
+    /// <summary>
+    /// A single DrawArraysIndirectCommand, filled by the GPU
+    /// </summary>
+    GLBuffer _drawCommandBuffer;
+
+
+public:
+
+    static constexpr const char* DefaultComputeShaderPath = "Shaders\\TextLayoutComputeShader.glsl";
+
+
+public:
+
+    TextLayout(const std::string& computeShaderPath = DefaultComputeShaderPath) :
+        _layoutProgram(GetSharedProgram(computeShaderPath))
+    {
+        _characterCountLocation = _layoutProgram->GetUniformLocation("CharacterCount");
+        _bitsPerCharacterLocation = _layoutProgram->GetUniformLocation("BitsPerCharacter");
+        _utf8Location = _layoutProgram->GetUniformLocation("Utf8");
+        _paletteBitsLocation = _layoutProgram->GetUniformLocation("PaletteBits");
+        _ringCapacityLocation = _layoutProgram->GetUniformLocation("RingCapacity");
+        _ringFirstCharacterLocation = _layoutProgram->GetUniformLocation("RingFirstCharacter");
+        _tabSizeLocation = _layoutProgram->GetUniformLocation("TabSize");
+        _wrapColumnsLocation = _layoutProgram->GetUniformLocation("WrapColumns");
+        _proportionalLocation = _layoutProgram->GetUniformLocation("Proportional");
+        _wrapWidthLocation = _layoutProgram->GetUniformLocation("WrapWidth");
+        _spanCountLocation = _layoutProgram->GetUniformLocation("SpanCount");
+        _lineHeightLocation = _layoutProgram->GetUniformLocation("LineHeight");
+        _glyphHeightForCullingLocation = _layoutProgram->GetUniformLocation("GlyphHeightForCulling");
+        _textTransformLocation = _layoutProgram->GetUniformLocation("TextTransform");
+        _cullGlyphsLocation = _layoutProgram->GetUniformLocation("CullGlyphs");
+        _firstInstanceLocation = _layoutProgram->GetUniformLocation("FirstInstance");
+        _drawCommandIndexLocation = _layoutProgram->GetUniformLocation("DrawCommandIndex");
+
+        _drawCommandBuffer = GLBuffer::Create();
+        glNamedBufferStorage(_drawCommandBuffer.Get(), sizeof(DrawArraysIndirectCommand), nullptr, 0);
+    };
+
+    TextLayout(const TextLayout&) = delete;
+    TextLayout& operator = (const TextLayout&) = delete;
+
+    TextLayout(TextLayout&&) noexcept = default;
+    TextLayout& operator = (TextLayout&&) noexcept = default;
+
+
+public:
+
+    /// <summary>
+    /// Lay out the characters in the "Input" block currently bound to binding 0.
+    /// The glyphs and draw command are ready to be used by any following draw, see DrawGlyphs.
+    /// Proportional layouts read the glyph metrics, the codepoint table and the kerning table from their bindings
+    /// </summary>
+    /// <param name="characterCount"> The number of characters in the input block </param>
+    /// <param name="bitsPerCharacter"> How the characters are packed, see CharacterPacking </param>
+    /// <param name="glyphWidth"> The width of a column, in pixels </param>
+    /// <param name="glyphHeight"> The default row height, in pixels </param>
+    /// <param name="textTransform"> The transform the text is drawn with, glyphs outside the viewport are culled </param>
+    /// <param name="options"></param>
+    /// <param name="proportional"> Advance glyphs by their metrics and kerning instead of by glyphWidth </param>
+    /// <param name="spanCount"> The number of TextSpans bound to TextSpansBindingIndex, 0 draws the whole text in the input block's colour </param>
+    /// <param name="ring"> (Text rings) Where the text starts in the ring Characters[] wraps around </param>
+    /// <param name="backgroundCount"> At most how many characters are in spans with a background, each one is an extra instance </param>
+    /// <param name="encoding"> (UTF-8) The input block holds UTF-8 bytes, 8 bits each, and characterCount counts bytes. They're decoded by the pass itself,
+    /// so text can be uploaded as it is instead of at 32 bits per codepoint. Character indices, e.g. the spans', count decoded characters.
+    /// (Palette) The characters' high bits pick their colour from the palette bound to TextPaletteBindingIndex </param>
+    /// <param name="cullGlyphs"> If false every glyph is kept, so the output can be drawn again with any transform, see FontSprite::DrawRetained </param>
+    void Dispatch(const std::size_t characterCount,
+                  const std::uint32_t bitsPerCharacter,
+                  const std::uint32_t glyphWidth,
+                  const std::uint32_t glyphHeight,
+                  const glm::mat4& textTransform,
+                  const TextLayoutOptions& options,
+                  const bool proportional = false,
+                  const std::uint32_t spanCount = 0,
+                  const CharacterRing& ring = { },
+                  const std::size_t backgroundCount = 0,
+                  const CharacterEncoding& encoding = { },
+                  const bool cullGlyphs = true) const
+    {
+        wt::Assert(encoding.Utf8 == false || (bitsPerCharacter == 8 && encoding.PaletteBits == 0), "UTF-8 is laid out from 8-bit characters without a palette");
+        wt::Assert(encoding.PaletteBits < bitsPerCharacter, "Palette indices leave no bits for the characters");
+
+        // Decoding never makes more characters than there are bytes, so the byte count sizes everything
+        Reserve(characterCount, characterCount + backgroundCount);
+
+        if(encoding.Utf8 == true)
+            ReserveDecodedCharacters();
+
+        DispatchLayout(characterCount, bitsPerCharacter, glyphWidth, glyphHeight, textTransform, options, proportional, spanCount, ring, cullGlyphs, _glyphInstancesBuffer.Get(), 0, _drawCommandBuffer.Get(), 0, encoding);
+    };
+
+    /// <summary>
+    /// Lay out the characters in the "Input" block currently bound to binding 0 into buffers the caller keeps.
+    /// Nothing is culled, so the glyphs can be drawn again with any transform.
+    /// The draw command's base instance is firstInstance, see FontSpriteVertexShader.glsl
+    /// </summary>
+    /// <param name="instancesBuffer"> Receives up to characterCount LaidOutGlyphs, starting at firstInstance </param>
+    /// <param name="commandBuffer"> Receives the DrawArraysIndirectCommand at commandIndex </param>
+    void DispatchInto(const std::size_t characterCount,
+                      const std::uint32_t bitsPerCharacter,
+                      const std::uint32_t glyphWidth,
+                      const std::uint32_t glyphHeight,
+                      const TextLayoutOptions& options,
+                      const std::uint32_t instancesBuffer,
+                      const std::uint32_t firstInstance,
+                      const std::uint32_t commandBuffer,
+                      const std::uint32_t commandIndex,
+                      const bool proportional = false) const
+    {
+        Reserve(characterCount);
+
+        DispatchLayout(characterCount, bitsPerCharacter, glyphWidth, glyphHeight, glm::mat4(1.0f), options, proportional, 0, CharacterRing { }, false, instancesBuffer, firstInstance, commandBuffer, commandIndex, CharacterEncoding { });
+    };
+
+
+    /// <summary>
+    /// Bind the output of the last dispatch to GlyphInstancesBindingIndex
+    /// </summary>
+    void BindGlyphInstances() const
+    {
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, GlyphInstancesBindingIndex, _glyphInstancesBuffer.Get());
+    };
+
+    /// <summary>
+    /// Draw the glyphs of the last dispatch, with the instance count it wrote
+    /// </summary>
+    void DrawGlyphs() const
+    {
+        GLState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, _drawCommandBuffer.Get());
+        glDrawArraysIndirect(GL_TRIANGLE_STRIP, nullptr);
+    };
+
+
+    /// <summary>
+    /// Make sure a number of characters can be laid out without reallocating
+    /// </summary>
+    /// <param name="characterCount"></param>
+    /// <param name="instanceCount"> The number of glyphs and backgrounds the layout may write, at least characterCount </param>
+    void Reserve(const std::size_t characterCount, const std::size_t instanceCount = 0) const
+    {
+        // The buffers' contents never outlive a single dispatch, so there's nothing to copy
+        const std::size_t requiredInstances = std::max(characterCount, instanceCount);
+
+        if(requiredInstances > _instanceCapacity)
+        {
+            _instanceCapacity = std::max(requiredInstances, _instanceCapacity * 2);
+
+            _glyphInstancesBuffer = GLBuffer::Create();
+            glNamedBufferStorage(_glyphInstancesBuffer.Get(), static_cast<GLsizeiptr>(_instanceCapacity * sizeof(std::uint32_t) * 4), nullptr, 0);
+        };
+
+        if(characterCount <= _capacity)
+            return;
+
+        DestroyScratchBuffers();
+
+        _capacity = std::max(characterCount, _capacity * 2);
+
+        _glyphCellsBuffer = GLBuffer::Create();
+        glNamedBufferStorage(_glyphCellsBuffer.Get(), static_cast<GLsizeiptr>(_capacity * sizeof(float) * 2), nullptr, 0);
+
+        _characterLinesBuffer = GLBuffer::Create();
+        glNamedBufferStorage(_characterLinesBuffer.Get(), static_cast<GLsizeiptr>(_capacity * sizeof(std::uint32_t)), nullptr, 0);
+
+        _linesBuffer = GLBuffer::Create();
+        glNamedBufferStorage(_linesBuffer.Get(), static_cast<GLsizeiptr>((_capacity + 2) * sizeof(std::uint32_t) * 2), nullptr, 0);
+    };
+
+
+private:
+
+    /// <summary>
+    /// Make sure UTF-8 can be decoded into a character per byte, up to the current capacity
+    /// </summary>
+    void ReserveDecodedCharacters() const
+    {
+        if(_decodedCharactersBuffer.Get() != 0)
+            return;
+
+        _decodedCharactersBuffer = GLBuffer::Create();
+        glNamedBufferStorage(_decodedCharactersBuffer.Get(), static_cast<GLsizeiptr>(_capacity * sizeof(std::uint32_t)), nullptr, 0);
+    };
+
+
+    void DispatchLayout(const std::size_t characterCount,
+                        const std::uint32_t bitsPerCharacter,
+                        const std::uint32_t glyphWidth,
+                        const std::uint32_t glyphHeight,
+                        const glm::mat4& textTransform,
+                        const TextLayoutOptions& options,
+                        const bool proportional,
+                        const std::uint32_t spanCount,
+                        const CharacterRing& ring,
+                        const bool cullGlyphs,
+                        const std::uint32_t instancesBuffer,
+                        const std::uint32_t firstInstance,
+                        const std::uint32_t commandBuffer,
+                        const std::uint32_t commandIndex,
+                        const CharacterEncoding& encoding) const
+    {
+        const std::uint32_t wrapColumns = options.WrapWidth > 0.0f ? std::max(static_cast<std::uint32_t>(options.WrapWidth / static_cast<float>(glyphWidth)), 1u) : 0u;
+
+        _layoutProgram->SetUInt(_characterCountLocation, static_cast<std::uint32_t>(characterCount));
+        _layoutProgram->SetUInt(_bitsPerCharacterLocation, bitsPerCharacter);
+        _layoutProgram->SetUInt(_utf8Location, encoding.Utf8 == true ? 1u : 0u);
+        _layoutProgram->SetUInt(_paletteBitsLocation, encoding.PaletteBits);
+        _layoutProgram->SetUInt(_ringCapacityLocation, ring.Capacity);
+        _layoutProgram->SetUInt(_ringFirstCharacterLocation, ring.FirstCharacter);
+        _layoutProgram->SetUInt(_tabSizeLocation, std::max(options.TabSize, 1u));
+        _layoutProgram->SetUInt(_wrapColumnsLocation, wrapColumns);
+        _layoutProgram->SetUInt(_proportionalLocation, proportional == true ? 1u : 0u);
+        _layoutProgram->SetFloat(_wrapWidthLocation, std::max(options.WrapWidth, 0.0f));
+        _layoutProgram->SetUInt(_spanCountLocation, spanCount);
+        _layoutProgram->SetFloat(_lineHeightLocation, options.LineHeight > 0.0f ? options.LineHeight : static_cast<float>(glyphHeight));
+        _layoutProgram->SetFloat(_glyphHeightForCullingLocation, static_cast<float>(glyphHeight));
+        _layoutProgram->SetMatrix4(_textTransformLocation, textTransform);
+        _layoutProgram->SetUInt(_cullGlyphsLocation, cullGlyphs == true ? 1u : 0u);
+        _layoutProgram->SetUInt(_firstInstanceLocation, firstInstance);
+        _layoutProgram->SetUInt(_drawCommandIndexLocation, commandIndex);
+
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, GlyphInstancesBindingIndex, instancesBuffer);
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, LayoutCharacterLinesBindingIndex, _characterLinesBuffer.Get());
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, LayoutLinesBindingIndex, _linesBuffer.Get());
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, LayoutGlyphCellsBindingIndex, _glyphCellsBuffer.Get());
+        GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, LayoutDrawCommandBindingIndex, commandBuffer);
+
+        if(encoding.Utf8 == true)
+            GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, LayoutDecodedCharactersBindingIndex, _decodedCharactersBuffer.Get());
+
+        _layoutProgram->Dispatch(1);
+
+        // The glyphs are read as storage, the command as indirect arguments
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    };
+
+
+    /// <summary>
+    /// Delete the per-character buffers only the layout pass itself uses
+    /// </summary>
+    void DestroyScratchBuffers() const
+    {
+        _glyphCellsBuffer.Reset();
+        _characterLinesBuffer.Reset();
+        _linesBuffer.Reset();
+        _decodedCharactersBuffer.Reset();
+    };
+
+    /// <summary>
+    /// The layout program for a shader, compiled the first time a TextLayout on this thread asks for it.
+    /// Programs belong to the thread's context, and are deleted with the last TextLayout that uses them
+    /// </summary>
+    static std::shared_ptr<const ComputeProgram> GetSharedProgram(const std::string& computeShaderPath)
+    {
+        thread_local std::unordered_map<std::string, std::weak_ptr<const ComputeProgram>> programs;
+
+        std::weak_ptr<const ComputeProgram>& cachedProgram = programs[computeShaderPath];
+
+        std::shared_ptr<const ComputeProgram> program = cachedProgram.lock();
+
+        if(program == nullptr)
+        {
+            program = std::make_shared<const ComputeProgram>(computeShaderPath);
+            cachedProgram = program;
+        };
+
+        return program;
+    };
+
+};
@@ -0,0 +1,467 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include "TextConversion.hpp"
+#include "TextLayout.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// What TextMetrics needs to know about a font to lay text out the way TextLayoutComputeShader.glsl does
+/// </summary>
+struct TextMetricsFont
+{
+    /// <summary>
+    /// Every character's advance, in pixels, 0 for control characters. Indexed by the character's byte, see FontSprite::GetAdvances
+    /// </summary>
+    const std::array<float, 256>* Advances = nullptr;
+
+    /// <summary>
+    /// The width of a column, monospaced fonts advance by it
+    /// </summary>
+    std::uint32_t GlyphWidth = 0;
+
+    float LineHeight = 0.0f;
+
+    bool Proportional = false;
+
+
+    bool operator == (const TextMetricsFont&) const = default;
+};
+
+
+/// <summary>
+/// A string's layout on the CPU, for measuring text and for mapping points to characters, e.g. for mouse selection.
+/// Follows TextLayoutComputeShader.glsl's rules for newlines, tabs, wrapping and kerning, so the positions match what's drawn.
+/// Each character's position is a prefix sum of the advances before it on its row, computed once when the metrics are built,
+/// so measuring is constant time and a hit-test is a row lookup and a binary search of that row
+/// </summary>
+class TextMetrics
+{
+
+public:
+
+    /// <summary>
+    /// A row of the text, a whole line or the part of one that wrapped
+    /// </summary>
+    struct Row
+    {
+        std::size_t FirstCharacter = 0;
+
+        /// <summary>
+        /// One past the row's last character. A line's '\n' is not part of it
+        /// </summary>
+        std::size_t EndCharacter = 0;
+
+        /// <summary>
+        /// Where the row's pen ends up, in pixels
+        /// </summary>
+        float Width = 0.0f;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Every character's left edge on its row, in pixels, followed by where the next character appended to the text would go
+    /// </summary>
+    std::vector<float> _characterX;
+
+    std::vector<Row> _rows;
+
+    float _lineHeight = 0.0f;
+
+    glm::vec2 _size = { 0.0f, 0.0f };
+
+
+public:
+
+    /// <summary>
+    /// Lay a string out
+    /// </summary>
+    /// <param name="kerning"> Called as kerning(first, second) for consecutive printable characters, returns the adjustment to the first's advance </param>
+    template<typename TKerning>
+    static TextMetrics Build(const std::string_view& text, const TextLayoutOptions& options, const TextMetricsFont& font, const TKerning& kerning)
+    {
+        wt::Assert(font.Advances != nullptr, "Text metrics need the font's advances");
+
+        TextMetrics metrics;
+
+        metrics._lineHeight = options.LineHeight > 0.0f ? options.LineHeight : font.LineHeight;
+
+        metrics._characterX.resize(text.size() + 1);
+
+
+        Row row;
+
+        const float penX = LayOut(text, options, font, kerning, [&](const std::size_t index, const float x)
+        {
+            metrics._characterX[index] = x;
+        },
+        [&](const std::size_t endCharacter, const float width, const std::size_t nextFirstCharacter)
+        {
+            row.EndCharacter = endCharacter;
+            row.Width = width;
+
+            metrics._rows.emplace_back(row);
+
+            row = Row { .FirstCharacter = nextFirstCharacter };
+        });
+
+        metrics._characterX[text.size()] = penX;
+
+        row.EndCharacter = text.size();
+        row.Width = penX;
+
+        metrics._rows.emplace_back(row);
+
+
+        float width = 0.0f;
+
+        for(const Row& laidOutRow : metrics._rows)
+        {
+            width = std::max(width, laidOutRow.Width);
+        };
+
+        metrics._size = { width, static_cast<float>(metrics._rows.size()) * metrics._lineHeight };
+
+        return metrics;
+    };
+
+    /// <summary>
+    /// The number of rows Build would lay a string out into, without keeping any positions.
+    /// A monospaced string is only looked at where it has tabs and newlines, found with ForEachLayoutControl, every run between them
+    /// fills its rows column by column so its rows follow from its length. Rewrapping a monospaced document is bound by memory that way.
+    /// A proportional string is laid out character by character, its advances and kerning aren't known without looking them up
+    /// </summary>
+    template<typename TKerning>
+    static std::size_t CountRows(const std::string_view& text, const TextLayoutOptions& options, const TextMetricsFont& font, const TKerning& kerning)
+    {
+        if(font.Proportional == true)
+        {
+            wt::Assert(font.Advances != nullptr, "Text metrics need the font's advances");
+
+            std::size_t rowCount = 1;
+
+            LayOut(text, options, font, kerning, [](const std::size_t, const float)
+            {
+            },
+            [&](const std::size_t, const float, const std::size_t)
+            {
+                ++rowCount;
+            });
+
+            return rowCount;
+        };
+
+
+        // Counted in columns, which the pixel positions of Build are exact multiples of
+        const bool wraps = options.WrapWidth > 0.0f;
+
+        const std::size_t wrapColumns = wraps == true ? std::max<std::size_t>(static_cast<std::size_t>(options.WrapWidth / static_cast<float>(font.GlyphWidth)), 1) : 0;
+        const std::size_t tabColumns = std::max(options.TabSize, 1u);
+
+        std::size_t rowCount = 1;
+
+        std::size_t column = 0;
+        std::size_t runStart = 0;
+
+        // A run of characters a column each. Only its first character can wrap by itself, after a tab that overran the row
+        const auto placeRun = [&](const std::size_t length)
+        {
+            if(length == 0 || wraps == false)
+                return;
+
+            if(column >= wrapColumns)
+            {
+                ++rowCount;
+                column = 0;
+            };
+
+            const std::size_t end = column + length;
+
+            rowCount += (end - 1) / wrapColumns;
+            column = (end - 1) % wrapColumns + 1;
+        };
+
+        ForEachLayoutControl(text, [&](const std::size_t index)
+        {
+            placeRun(index - runStart);
+
+            runStart = index + 1;
+
+            if(text[index] == '\n')
+            {
+                ++rowCount;
+                column = 0;
+
+                return;
+            };
+
+            const std::size_t advance = tabColumns - column % tabColumns;
+
+            // A monospaced tab that wraps keeps its width
+            if(wraps == true && column > 0 && column + advance > wrapColumns)
+            {
+                ++rowCount;
+                column = advance;
+            }
+            else
+                column += advance;
+        });
+
+        placeRun(text.size() - runStart);
+
+        return rowCount;
+    };
+
+
+private:
+
+    /// <summary>
+    /// The rules of Build, TextLayoutComputeShader.glsl's, one character at a time
+    /// </summary>
+    /// <param name="onCharacter"> Called as onCharacter(index, x) with every character's left edge, '\n' included </param>
+    /// <param name="onRow"> Called as onRow(endCharacter, width, nextFirstCharacter) whenever a row ends, except for the last one </param>
+    /// <returns> Where the pen ends up on the last row </returns>
+    template<typename TKerning, typename TCharacterFunction, typename TRowFunction>
+    static float LayOut(const std::string_view& text,
+                        const TextLayoutOptions& options,
+                        const TextMetricsFont& font,
+                        const TKerning& kerning,
+                        const TCharacterFunction& onCharacter,
+                        const TRowFunction& onRow)
+    {
+        // Monospaced layouts don't need the advances
+        const float* advances = font.Advances != nullptr ? font.Advances->data() : nullptr;
+
+        const std::uint32_t tabSize = std::max(options.TabSize, 1u);
+
+        // Monospaced layouts wrap and tab by columns, proportional ones by pixels
+        const float wrapWidth = font.Proportional == true ?
+            options.WrapWidth :
+            options.WrapWidth > 0.0f ? static_cast<float>(std::max(static_cast<std::uint32_t>(options.WrapWidth / static_cast<float>(font.GlyphWidth)), 1u) * font.GlyphWidth) : 0.0f;
+
+        const float tabWidth = font.Proportional == true ? std::max(static_cast<float>(tabSize) * advances[' '], 1.0f) : static_cast<float>(tabSize * font.GlyphWidth);
+
+        const float columnWidth = static_cast<float>(font.GlyphWidth);
+
+
+        float penX = 0.0f;
+
+        // The previous printable character, kerning only applies between two of them
+        std::int32_t previous = -1;
+
+        for(std::size_t index = 0; index < text.size(); ++index)
+        {
+            const std::uint8_t character = static_cast<std::uint8_t>(text[index]);
+
+            if(character == '\n')
+            {
+                onCharacter(index, penX);
+                onRow(index, penX, index + 1);
+
+                penX = 0.0f;
+                previous = -1;
+
+                continue;
+            };
+
+
+            float advance = 0.0f;
+
+            if(font.Proportional == false)
+                advance = character == '\t' ? (std::floor(penX / tabWidth) + 1.0f) * tabWidth - penX : columnWidth;
+            else if(character >= 32)
+            {
+                advance = advances[character];
+
+                if(previous >= 0)
+                    penX += kerning(static_cast<char32_t>(previous), static_cast<char32_t>(character));
+            }
+            else if(character == '\t')
+                advance = (std::floor(penX / tabWidth) + 1.0f) * tabWidth - penX;
+
+            if(wrapWidth > 0.0f && penX > 0.0f && penX + advance > wrapWidth)
+            {
+                onRow(index, penX, index);
+
+                // A proportional tab that wraps fills the new row up to the first stop, a monospaced one keeps its width
+                if(character == '\t' && font.Proportional == true)
+                    advance = tabWidth;
+
+                penX = 0.0f;
+            };
+
+            onCharacter(index, penX);
+
+            penX += advance;
+
+            previous = font.Proportional == true && character >= 32 ? static_cast<std::int32_t>(character) : -1;
+        };
+
+        return penX;
+    };
+
+
+public:
+
+    /// <summary>
+    /// The width of the widest row and the height of all of them, in pixels
+    /// </summary>
+    glm::vec2 GetSize() const
+    {
+        return _size;
+    };
+
+    const std::vector<Row>& GetRows() const
+    {
+        return _rows;
+    };
+
+    std::size_t GetCharacterCount() const
+    {
+        return _characterX.size() - 1;
+    };
+
+
+    /// <summary>
+    /// The row a character is on. The text's end is on the last row
+    /// </summary>
+    std::size_t GetRowIndex(const std::size_t character) const
+    {
+        const auto row = std::upper_bound(_rows.cbegin(), _rows.cend(), character, [](const std::size_t character, const Row& row)
+        {
+            return character < row.FirstCharacter;
+        });
+
+        return static_cast<std::size_t>(std::max<std::ptrdiff_t>(row - _rows.cbegin() - 1, 0));
+    };
+
+    /// <summary>
+    /// A character's top-left corner, in pixels from the text's origin. The text's size is where the next character would go
+    /// </summary>
+    glm::vec2 GetCharacterPosition(const std::size_t character) const
+    {
+        const std::size_t clampedCharacter = std::min(character, GetCharacterCount());
+
+        return { _characterX[clampedCharacter], static_cast<float>(GetRowIndex(clampedCharacter)) * _lineHeight };
+    };
+
+    /// <summary>
+    /// The character boundary nearest to a point, where a caret placed there goes. Points outside the text snap to its nearest row and edge
+    /// </summary>
+    /// <param name="point"> In pixels from the text's origin </param>
+    /// <returns> A character index, the text's size for the end of the text </returns>
+    std::size_t HitTest(const glm::vec2& point) const
+    {
+        // Rows are all as high as each other, so the row is found without searching
+        const float rowPosition = _lineHeight > 0.0f ? std::floor(point.y / _lineHeight) : 0.0f;
+
+        const Row& row = _rows[static_cast<std::size_t>(std::clamp(rowPosition, 0.0f, static_cast<float>(_rows.size() - 1)))];
+
+        const auto rowBegin = _characterX.cbegin() + static_cast<std::ptrdiff_t>(row.FirstCharacter);
+        const auto rowEnd = _characterX.cbegin() + static_cast<std::ptrdiff_t>(row.EndCharacter);
+
+        // The character the point is over is the last one starting left of it, it's split in the middle between its two boundaries
+        const auto next = std::upper_bound(rowBegin, rowEnd, point.x);
+
+        if(next == rowBegin)
+            return row.FirstCharacter;
+
+        const std::size_t character = static_cast<std::size_t>(next - _characterX.cbegin()) - 1;
+
+        const float left = _characterX[character];
+        const float right = character + 1 < row.EndCharacter ? _characterX[character + 1] : row.Width;
+
+        return point.x - left < right - point.x ? character : character + 1;
+    };
+
+};
+
+
+/// <summary>
+/// Laid out TextMetrics, keyed by their text and layout options like GlyphRunCache's runs, so measuring a string seen before is a lookup.
+/// Entries aren't evicted individually, once the cache is full it starts over
+/// </summary>
+class TextMetricsCache
+{
+
+private:
+
+    struct Entry
+    {
+        /// <summary>
+        /// Compared on lookup so a hash collision is a miss rather than the wrong text
+        /// </summary>
+        std::string Text;
+
+        TextLayoutOptions Options;
+
+        TextMetrics Metrics;
+    };
+
+    std::unordered_map<std::uint64_t, Entry> _entries;
+
+    std::size_t _capacity = 0;
+
+
+public:
+
+    /// <param name="capacity"> The number of strings that are kept at once </param>
+    TextMetricsCache(const std::size_t capacity = 1024) :
+        _capacity(std::max<std::size_t>(capacity, 1))
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// A string's metrics, laid out if they aren't cached. Only valid until the next call, which may start the cache over
+    /// </summary>
+    template<typename TKerning>
+    const TextMetrics& Get(const std::string_view& text, const TextLayoutOptions& options, const TextMetricsFont& font, const TKerning& kerning)
+    {
+        const std::uint64_t hash = HashLaidOutText(text, options);
+
+        if(const auto entry = _entries.find(hash); entry != _entries.end() && entry->second.Text == text && entry->second.Options == options)
+            return entry->second.Metrics;
+
+        if(_entries.size() >= _capacity)
+            _entries.clear();
+
+        Entry entry = Entry
+        {
+            .Text = std::string(text),
+            .Options = options,
+            .Metrics = TextMetrics::Build(text, options, font, kerning),
+        };
+
+        return _entries.insert_or_assign(hash, std::move(entry)).first->second.Metrics;
+    };
+
+    /// <summary>
+    /// Forget every string, e.g. once the font's advances changed
+    /// </summary>
+    void Clear()
+    {
+        _entries.clear();
+    };
+
+    std::size_t GetSize() const
+    {
+        return _entries.size();
+    };
+
+};
@@ -0,0 +1,377 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include "GLStateCache.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// What was under a picked pixel, see TextPickingBuffer::Collect
+/// </summary>
+struct TextPick
+{
+    /// <summary>
+    /// The run drawn at the pixel, as TextPickingBuffer::AddRun handed it out in the frame the pick was made. 0 if no text was drawn there
+    /// </summary>
+    std::uint32_t Run = 0;
+
+    /// <summary>
+    /// Which of the run's glyphs was drawn at the pixel, counting the glyph instances the run laid out to from 0
+    /// </summary>
+    std::uint32_t Glyph = 0;
+
+    /// <summary>
+    /// The pixel, from the window's top-left corner
+    /// </summary>
+    glm::uvec2 Pixel = { 0, 0 };
+
+    std::uint64_t Tag = 0;
+
+
+    bool IsHit() const
+    {
+        return Run != 0;
+    };
+};
+
+
+/// <summary>
+/// Hit-tests text on the GPU rather than by walking layouts. On a frame with a pick requested, text batches draw a second time into
+/// an integer target, writing a (run, glyph) pair wherever a glyph covers a pixel, and the single requested pixel is read back without stalling.
+/// The answer arrives a few frames later through Collect, which is the same for any amount of text on screen.
+/// Frames without a pick requested cost nothing but a run counter
+/// </summary>
+class TextPickingBuffer
+{
+
+private:
+
+    struct Slot
+    {
+        std::uint32_t BufferID = 0;
+
+        const std::byte* MappedPick = nullptr;
+
+        /// <summary>
+        /// Placed after the read, null while the slot is free
+        /// </summary>
+        GLsync Fence = nullptr;
+
+        glm::uvec2 Pixel = { 0, 0 };
+
+        std::uint64_t Tag = 0;
+    };
+
+
+    std::int32_t _width = 0;
+    std::int32_t _height = 0;
+
+    /// <summary>
+    /// RG32UI, the run in red and the glyph in green
+    /// </summary>
+    std::uint32_t _pickRenderbuffer = 0;
+
+    std::uint32_t _framebuffer = 0;
+
+    std::vector<Slot> _slots;
+
+    /// <summary>
+    /// The oldest read that wasn't collected yet, reads are collected in the order they were made
+    /// </summary>
+    std::size_t _oldestSlot = 0;
+
+    std::size_t _pendingCount = 0;
+
+    /// <summary>
+    /// The latest pick requested, taken by the next BeginFrame that has a slot free
+    /// </summary>
+    std::optional<glm::uvec2> _requestedPixel;
+
+    std::uint64_t _requestedTag = 0;
+
+    /// <summary>
+    /// The pixel the current frame picks, unset on frames that don't
+    /// </summary>
+    std::optional<glm::uvec2> _pickingPixel;
+
+    std::uint64_t _pickingTag = 0;
+
+    std::uint32_t _runCount = 0;
+
+    /// <summary>
+    /// The draw framebuffer BeginDraw replaced
+    /// </summary>
+    GLint _previousFramebuffer = 0;
+
+
+public:
+
+    /// <param name="slotCount"> The number of picks that can be in flight, the frames of latency before a pick is collected </param>
+    TextPickingBuffer(const std::int32_t width, const std::int32_t height, const std::uint32_t slotCount = 3) :
+        _slots(slotCount)
+    {
+        wt::Assert(slotCount >= 1, "A text picking buffer needs at least one slot");
+
+        static constexpr GLbitfield storageFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT | GL_CLIENT_STORAGE_BIT;
+        static constexpr GLbitfield mapFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        for(Slot& slot : _slots)
+        {
+            glCreateBuffers(1, &slot.BufferID);
+            glNamedBufferStorage(slot.BufferID, PickSizeInBytes, nullptr, storageFlags);
+
+            slot.MappedPick = static_cast<const std::byte*>(glMapNamedBufferRange(slot.BufferID, 0, PickSizeInBytes, mapFlags));
+
+            wt::Assert(slot.MappedPick != nullptr, "Failed to map a text picking buffer");
+        };
+
+        Resize(width, height);
+    };
+
+    TextPickingBuffer(const TextPickingBuffer&) = delete;
+    TextPickingBuffer& operator = (const TextPickingBuffer&) = delete;
+
+    /// <summary>
+    /// Picks that weren't collected are dropped
+    /// </summary>
+    ~TextPickingBuffer()
+    {
+        for(Slot& slot : _slots)
+        {
+            if(slot.Fence != nullptr)
+                glDeleteSync(slot.Fence);
+
+            glUnmapNamedBuffer(slot.BufferID);
+
+            GLState.DeleteBuffer(slot.BufferID);
+        };
+
+        Destroy();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Match the window's size
+    /// </summary>
+    void Resize(const std::int32_t width, const std::int32_t height)
+    {
+        if(_framebuffer != 0 && width == _width && height == _height)
+            return;
+
+        Destroy();
+
+        _width = width;
+        _height = height;
+
+        glCreateRenderbuffers(1, &_pickRenderbuffer);
+        glNamedRenderbufferStorage(_pickRenderbuffer, GL_RG32UI, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height));
+
+        glCreateFramebuffers(1, &_framebuffer);
+        glNamedFramebufferRenderbuffer(_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _pickRenderbuffer);
+
+        // The fragment shaders write their colour to location 0 and the pick to location 1, only the pick lands here
+        static constexpr GLenum drawBuffers[] = { GL_NONE, GL_COLOR_ATTACHMENT0 };
+
+        glNamedFramebufferDrawBuffers(_framebuffer, 2, drawBuffers);
+        glNamedFramebufferReadBuffer(_framebuffer, GL_COLOR_ATTACHMENT0);
+
+        wt::Assert(glCheckNamedFramebufferStatus(_framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Text picking framebuffer is incomplete");
+    };
+
+
+    /// <summary>
+    /// Ask what text is under a pixel, e.g. on a click or when the mouse moves. Only the latest request before a frame is picked
+    /// </summary>
+    /// <param name="pixel"> From the window's top-left corner, in framebuffer pixels </param>
+    /// <param name="tag"> Handed back with the pick </param>
+    void RequestPick(const glm::uvec2& pixel, const std::uint64_t tag = 0)
+    {
+        _requestedPixel = pixel;
+        _requestedTag = tag;
+    };
+
+    /// <summary>
+    /// Start a frame's runs over, and clear the buffer if the frame picks. Call before the frame's first text batch submits
+    /// </summary>
+    void BeginFrame()
+    {
+        _runCount = 0;
+
+        _pickingPixel.reset();
+
+        // A request waits while every slot is in flight, the next free frame picks it
+        if(_requestedPixel.has_value() == false || _pendingCount == _slots.size())
+            return;
+
+        if(_requestedPixel->x >= static_cast<std::uint32_t>(_width) || _requestedPixel->y >= static_cast<std::uint32_t>(_height))
+        {
+            _requestedPixel.reset();
+            return;
+        };
+
+        _pickingPixel = _requestedPixel;
+        _pickingTag = _requestedTag;
+
+        _requestedPixel.reset();
+
+        static constexpr std::uint32_t noRun[4] = { 0, 0, 0, 0 };
+
+        // Draw buffer 1 is the pick attachment
+        glClearNamedFramebufferuiv(_framebuffer, GL_COLOR, 1, noRun);
+    };
+
+    /// <summary>
+    /// Hand out the id of a run of text, unique within the frame. TextBatch does this for every string it's given
+    /// </summary>
+    std::uint32_t AddRun()
+    {
+        return ++_runCount;
+    };
+
+    /// <summary>
+    /// Whether the current frame picks, text batches only draw into the buffer if so
+    /// </summary>
+    bool IsPicking() const
+    {
+        return _pickingPixel.has_value();
+    };
+
+    /// <summary>
+    /// Draw into the buffer, until EndDraw
+    /// </summary>
+    void BeginDraw()
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &_previousFramebuffer);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _framebuffer);
+    };
+
+    /// <summary>
+    /// Draw into the framebuffer BeginDraw replaced again
+    /// </summary>
+    void EndDraw() const
+    {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<std::uint32_t>(_previousFramebuffer));
+    };
+
+    /// <summary>
+    /// Start reading the picked pixel back. Call after the frame's last text batch flushed
+    /// </summary>
+    void EndFrame()
+    {
+        if(_pickingPixel.has_value() == false)
+            return;
+
+        Slot& slot = _slots[(_oldestSlot + _pendingCount) % _slots.size()];
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+
+        // With a pack buffer bound the read only queues a copy. The buffer's origin is the bottom-left corner
+        GLState.BindBuffer(GL_PIXEL_PACK_BUFFER, slot.BufferID);
+
+        glReadnPixels(static_cast<GLint>(_pickingPixel->x), _height - 1 - static_cast<GLint>(_pickingPixel->y), 1, 1, GL_RG_INTEGER, GL_UNSIGNED_INT, PickSizeInBytes, nullptr);
+
+        GLState.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+        slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.Pixel = *_pickingPixel;
+        slot.Tag = _pickingTag;
+
+        ++_pendingCount;
+
+        _pickingPixel.reset();
+    };
+
+    /// <summary>
+    /// Hand every finished pick to a callback, oldest first, without waiting for any
+    /// </summary>
+    /// <param name="onPick"> Called with a TextPick per finished pick </param>
+    /// <returns> The number of picks collected </returns>
+    template<typename TOnPick>
+    std::size_t Collect(TOnPick&& onPick)
+    {
+        std::size_t collectedCount = 0;
+
+        while(_pendingCount > 0)
+        {
+            Slot& slot = _slots[_oldestSlot];
+
+            // The first poll flushes, so the fence is sure to signal eventually
+            if(glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+                break;
+
+            glDeleteSync(slot.Fence);
+            slot.Fence = nullptr;
+
+            std::uint32_t pick[2] = { 0, 0 };
+
+            std::memcpy(pick, slot.MappedPick, sizeof(pick));
+
+            onPick(TextPick
+            {
+                .Run = pick[0],
+                .Glyph = pick[1],
+                .Pixel = slot.Pixel,
+                .Tag = slot.Tag,
+            });
+
+            _oldestSlot = (_oldestSlot + 1) % _slots.size();
+            --_pendingCount;
+
+            ++collectedCount;
+        };
+
+        return collectedCount;
+    };
+
+
+public:
+
+    /// <summary>
+    /// The number of runs handed out this frame, the id the last one got
+    /// </summary>
+    std::uint32_t GetRunCount() const
+    {
+        return _runCount;
+    };
+
+    /// <summary>
+    /// The number of picks that weren't collected yet
+    /// </summary>
+    std::size_t GetPendingCount() const
+    {
+        return _pendingCount;
+    };
+
+
+private:
+
+    void Destroy()
+    {
+        glDeleteFramebuffers(1, &_framebuffer);
+        glDeleteRenderbuffers(1, &_pickRenderbuffer);
+
+        _framebuffer = 0;
+        _pickRenderbuffer = 0;
+    };
+
+
+private:
+
+    /// <summary>
+    /// A single RG32UI texel
+    /// </summary>
+    static constexpr GLsizeiptr PickSizeInBytes = sizeof(std::uint32_t) * 2;
+
+};
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "TextConversion.hpp"
+#include "WindowsUtilities.hpp"
+#include "GLStateCache.hpp"
+
+
+/// <summary>
+/// The size of the input block's header in front of the ring's characters, see FontSpriteInputLayout
+/// </summary>
+constexpr std::size_t TextRingHeaderSizeInBytes = 48;
+
+
+/// <summary>
+/// A run of a TextRing's characters to draw
+/// </summary>
+struct TextRingWindow
+{
+    /// <summary>
+    /// The window's first character, counted from the first character ever appended
+    /// </summary>
+    std::uint64_t FirstCharacter = 0;
+
+    std::size_t CharacterCount = 0;
+
+
+    bool IsEmpty() const
+    {
+        return CharacterCount == 0;
+    };
+};
+
+
+/// <summary>
+/// Append-only text in GPU memory, for tailing logs. New characters are written at the head and wrap around at the ring's capacity,
+/// overwriting the oldest ones, so appending only ever uploads the new characters.
+/// Characters are stored 8 bits each behind room for the input block's header, the layout pass reads them modulo the capacity, see FontSprite::Draw(TextRing&, ...)
+/// </summary>
+class TextRing
+{
+
+private:
+
+    /// <summary>
+    /// The number of characters the ring holds, a multiple of 4 so every character's uint is inside the buffer
+    /// </summary>
+    std::size_t _capacity = 0;
+
+    /// <summary>
+    /// The input block's header, followed by _capacity characters
+    /// </summary>
+    std::uint32_t _bufferID = 0;
+
+    /// <summary>
+    /// The total number of characters ever appended, the next character is written at _head % _capacity
+    /// </summary>
+    std::uint64_t _head = 0;
+
+    /// <summary>
+    /// The characters appended since the last upload, already converted. Only the last _capacity of them are uploaded
+    /// </summary>
+    std::vector<std::byte> _pendingCharacters;
+
+    /// <summary>
+    /// Where every line still in the ring starts, counted like _head. The first line may have been partly overwritten
+    /// </summary>
+    std::deque<std::uint64_t> _lineStarts = { 0 };
+
+    /// <summary>
+    /// The number of bytes written to the buffer since construction
+    /// </summary>
+    std::size_t _uploadedByteCount = 0;
+
+
+public:
+
+    /// <param name="capacity"> The number of characters kept, rounded up to a multiple of 4 </param>
+    TextRing(const std::size_t capacity)
+    {
+        _capacity = (std::max<std::size_t>(capacity, 4) + 3) & ~std::size_t(3);
+
+        wt::Assert(_capacity <= 0xFFFFFFFF, "Text rings are indexed with 32-bit integers");
+
+        glCreateBuffers(1, &_bufferID);
+        glNamedBufferStorage(_bufferID, static_cast<GLsizeiptr>(TextRingHeaderSizeInBytes + _capacity), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    };
+
+    TextRing(const TextRing&) = delete;
+    TextRing& operator = (const TextRing&) = delete;
+
+    ~TextRing()
+    {
+        GLState.DeleteBuffer(_bufferID);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Add text at the head of the ring. It's converted right away but only uploaded by the next Upload, so many appends in a frame still upload once
+    /// </summary>
+    void Append(const std::string_view& text)
+    {
+        if(text.empty() == true)
+            return;
+
+        // Characters that would be overwritten before the next upload are never kept
+        const std::string_view keptText = text.size() > _capacity ? text.substr(text.size() - _capacity) : text;
+
+        const std::size_t pendingSize = _pendingCharacters.size();
+
+        _pendingCharacters.resize(pendingSize + keptText.size());
+
+        PackGlyphCharacters(keptText, _pendingCharacters.data() + pendingSize, 8);
+
+        AdvanceHead(text);
+    };
+
+    /// <summary>
+    /// Add characters that were already converted, 8 bits each as PackGlyphCharacters writes them, e.g. by a TextStream's worker.
+    /// Only copied, so converting large amounts of text can be kept off the thread that uploads the ring
+    /// </summary>
+    void AppendConverted(const std::span<const std::byte>& characters)
+    {
+        if(characters.empty() == true)
+            return;
+
+        const std::span<const std::byte> keptCharacters = characters.size() > _capacity ? characters.last(_capacity) : characters;
+
+        _pendingCharacters.insert(_pendingCharacters.end(), keptCharacters.begin(), keptCharacters.end());
+
+        // Converted characters keep their newlines, so the lines are found the same way
+        AdvanceHead(std::string_view(reinterpret_cast<const char*>(characters.data()), characters.size()));
+    };
+
+
+    /// <summary>
+    /// Upload the characters appended since the last upload, in at most 2 pieces when they wrap around the end of the buffer
+    /// </summary>
+    void Upload()
+    {
+        if(_pendingCharacters.empty() == true)
+            return;
+
+        const std::size_t characterCount = std::min(_pendingCharacters.size(), _capacity);
+
+        const std::byte* characters = _pendingCharacters.data() + (_pendingCharacters.size() - characterCount);
+
+        const std::size_t firstCharacter = static_cast<std::size_t>((_head - characterCount) % _capacity);
+
+        const std::size_t firstPieceSize = std::min(characterCount, _capacity - firstCharacter);
+
+        glNamedBufferSubData(_bufferID, static_cast<GLintptr>(TextRingHeaderSizeInBytes + firstCharacter), static_cast<GLsizeiptr>(firstPieceSize), characters);
+
+        if(firstPieceSize < characterCount)
+            glNamedBufferSubData(_bufferID, static_cast<GLintptr>(TextRingHeaderSizeInBytes), static_cast<GLsizeiptr>(characterCount - firstPieceSize), characters + firstPieceSize);
+
+        _uploadedByteCount += characterCount;
+
+        _pendingCharacters.clear();
+    };
+
+
+    /// <summary>
+    /// A range of the lines still in the ring
+    /// </summary>
+    /// <param name="firstLine"> 0 is the oldest line still in the ring </param>
+    TextRingWindow GetLines(const std::size_t firstLine, const std::size_t lineCount) const
+    {
+        if(firstLine >= _lineStarts.size() || lineCount == 0)
+            return TextRingWindow { _head, 0 };
+
+        const std::uint64_t first = std::max(_lineStarts[firstLine], GetTail());
+
+        // The last line's newline isn't part of the window, it would only add an empty row
+        const std::size_t endLine = firstLine + lineCount;
+
+        const std::uint64_t end = endLine < _lineStarts.size() ? _lineStarts[endLine] - 1 : _head;
+
+        return TextRingWindow { first, static_cast<std::size_t>(end - first) };
+    };
+
+    /// <summary>
+    /// The newest lines, including the line still being appended to
+    /// </summary>
+    TextRingWindow GetLastLines(const std::size_t lineCount) const
+    {
+        const std::size_t firstLine = _lineStarts.size() - std::min(lineCount, _lineStarts.size());
+
+        return GetLines(firstLine, lineCount);
+    };
+
+
+public:
+
+    /// <summary>
+    /// The number of lines still in the ring
+    /// </summary>
+    std::size_t GetLineCount() const
+    {
+        return _lineStarts.size();
+    };
+
+    std::size_t GetCapacity() const
+    {
+        return _capacity;
+    };
+
+    /// <summary>
+    /// The total number of characters ever appended
+    /// </summary>
+    std::uint64_t GetHead() const
+    {
+        return _head;
+    };
+
+    /// <summary>
+    /// The oldest character still in the ring, counted like GetHead
+    /// </summary>
+    std::uint64_t GetTail() const
+    {
+        return _head > _capacity ? _head - _capacity : 0;
+    };
+
+    std::uint32_t GetBufferID() const
+    {
+        return _bufferID;
+    };
+
+    /// <summary>
+    /// The total number of bytes of characters written to the GPU since construction
+    /// </summary>
+    std::size_t GetUploadedByteCount() const
+    {
+        return _uploadedByteCount;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Track the lines of text that was just added to the pending characters, and move the head past it
+    /// </summary>
+    void AdvanceHead(const std::string_view& text)
+    {
+        if(_pendingCharacters.size() > _capacity * 2)
+            _pendingCharacters.erase(_pendingCharacters.begin(), _pendingCharacters.end() - static_cast<std::ptrdiff_t>(_capacity));
+
+
+        // Lines are tracked over the whole text, even the part that was cut off
+        const char* newline = text.data();
+        const char* const end = text.data() + text.size();
+
+        while((newline = static_cast<const char*>(std::memchr(newline, '\n', static_cast<std::size_t>(end - newline)))) != nullptr)
+        {
+            ++newline;
+
+            _lineStarts.push_back(_head + static_cast<std::uint64_t>(newline - text.data()));
+        };
+
+        _head += text.size();
+
+
+        // Drop lines that were overwritten entirely
+        const std::uint64_t tail = GetTail();
+
+        while(_lineStarts.size() > 1 && _lineStarts[1] <= tail)
+        {
+            _lineStarts.pop_front();
+        };
+    };
+
+};
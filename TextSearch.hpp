@@ -0,0 +1,234 @@
+#pragma once
+
+#include <glm/vec4.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "JobSystem.hpp"
+#include "TextConversion.hpp"
+#include "TextStyle.hpp"
+
+
+/// <summary>
+/// Finds every occurrence of a query in a text, e.g. a MappedDocument, and turns the ones in a range into highlight spans for FontSprite::DrawStyled.
+/// Meant to follow a search box as it's typed into: a query that extends the previous one only re-checks the previous matches,
+/// anything else searches the whole text again, in chunks on a JobSystem if one is given
+/// </summary>
+class TextSearch
+{
+
+private:
+
+    std::string_view _text;
+
+    std::string _query;
+
+    /// <summary>
+    /// The offset of every match's first byte, sorted
+    /// </summary>
+    std::vector<std::uint64_t> _matches;
+
+    /// <summary>
+    /// Bumped whenever the matches change, see GetVersion
+    /// </summary>
+    std::uint64_t _version = 0;
+
+    JobSystem* _jobs = nullptr;
+
+    /// <summary>
+    /// Every chunk's matches of the last search, kept so their capacity is reused
+    /// </summary>
+    std::vector<std::vector<std::uint64_t>> _chunkMatches;
+
+
+public:
+
+    /// <summary>
+    /// How much of the text a single job searches
+    /// </summary>
+    static constexpr std::size_t ChunkSizeInBytes = 4 * 1024 * 1024;
+
+
+public:
+
+    /// <param name="jobs"> If given, large texts are searched a chunk per job. Must outlive the search </param>
+    explicit TextSearch(JobSystem* jobs = nullptr) :
+        _jobs(jobs)
+    {
+    };
+
+    TextSearch(const TextSearch&) = delete;
+    TextSearch& operator = (const TextSearch&) = delete;
+
+
+public:
+
+    /// <summary>
+    /// Search another text, or the same one after it was mapped again, for the current query
+    /// </summary>
+    /// <param name="text"> Must outlive the search, or be replaced first </param>
+    void SetText(const std::string_view& text)
+    {
+        _text = text;
+
+        SearchAll();
+    };
+
+    /// <summary>
+    /// Change the query. If it extends the previous query, only the previous matches are checked again
+    /// </summary>
+    void SetQuery(const std::string_view& query)
+    {
+        if(query == _query)
+            return;
+
+        const bool refine = _query.empty() == false && query.starts_with(_query) == true;
+
+        _query = query;
+
+        if(refine == true)
+            Refine();
+        else
+            SearchAll();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Changes whenever the matches do, so highlights built from them know to be built again
+    /// </summary>
+    std::uint64_t GetVersion() const
+    {
+        return _version;
+    };
+
+    const std::string& GetQuery() const
+    {
+        return _query;
+    };
+
+    const std::vector<std::uint64_t>& GetMatches() const
+    {
+        return _matches;
+    };
+
+    std::size_t GetMatchCount() const
+    {
+        return _matches.size();
+    };
+
+    /// <summary>
+    /// The first match at or after an offset, e.g. for jumping to the next match. GetMatchCount if there is none
+    /// </summary>
+    std::size_t FindNextMatch(const std::uint64_t offset) const
+    {
+        return static_cast<std::size_t>(std::distance(_matches.cbegin(), std::lower_bound(_matches.cbegin(), _matches.cend(), offset)));
+    };
+
+
+    /// <summary>
+    /// Give every character of a range that's part of a match a background, on top of the spans the range already has
+    /// </summary>
+    /// <param name="rangeStart"> The offset of the range's first character in the text, span characters are relative to it </param>
+    /// <param name="rangeEnd"> One past the range's last character </param>
+    /// <param name="spans"> The range's spans, sorted by FirstCharacter. Stays sorted, see SetSpanBackground </param>
+    /// <param name="textColour"> The colour the range is drawn with, for characters before the first span </param>
+    void AddHighlightSpans(const std::uint64_t rangeStart, const std::uint64_t rangeEnd, const glm::vec4& background, const glm::vec4& textColour, std::vector<TextSpan>& spans) const
+    {
+        if(_matches.empty() == true || rangeStart >= rangeEnd)
+            return;
+
+        const std::uint64_t matchLength = _query.size();
+
+        // The first match that could still reach into the range
+        auto match = std::lower_bound(_matches.cbegin(), _matches.cend(), rangeStart - std::min(rangeStart, matchLength - 1));
+
+        for(; match != _matches.cend() && *match < rangeEnd; ++match)
+        {
+            const std::uint64_t first = std::max(*match, rangeStart);
+            const std::uint64_t end = std::min(*match + matchLength, rangeEnd);
+
+            if(first < end)
+                SetSpanBackground(spans, static_cast<std::uint32_t>(first - rangeStart), static_cast<std::uint32_t>(end - rangeStart), background, textColour);
+        };
+    };
+
+
+private:
+
+    /// <summary>
+    /// Find the query in the whole text. Chunks overlap by the query's length, so matches across their edges are found exactly once
+    /// </summary>
+    void SearchAll()
+    {
+        _matches.clear();
+        ++_version;
+
+        if(_query.empty() == true || _query.size() > _text.size())
+            return;
+
+
+        const std::size_t positionCount = _text.size() - _query.size() + 1;
+
+        const std::size_t chunkCount = (positionCount + ChunkSizeInBytes - 1) / ChunkSizeInBytes;
+
+        if(_jobs == nullptr || chunkCount == 1)
+        {
+            FindSubstring(_text, _query, 0, _matches);
+            return;
+        };
+
+
+        if(_chunkMatches.size() < chunkCount)
+            _chunkMatches.resize(chunkCount);
+
+        _jobs->ParallelFor(chunkCount, 1, [&](const std::size_t firstChunk, const std::size_t endChunk)
+        {
+            for(std::size_t chunk = firstChunk; chunk < endChunk; ++chunk)
+            {
+                const std::size_t chunkStart = chunk * ChunkSizeInBytes;
+
+                // Positions within the chunk, plus the bytes a match starting at its last position reads
+                const std::size_t chunkPositions = std::min(ChunkSizeInBytes, positionCount - chunkStart);
+
+                _chunkMatches[chunk].clear();
+
+                FindSubstring(_text.substr(chunkStart, chunkPositions + _query.size() - 1), _query, chunkStart, _chunkMatches[chunk]);
+            };
+        });
+
+
+        std::size_t matchCount = 0;
+
+        for(std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            matchCount += _chunkMatches[chunk].size();
+        };
+
+        _matches.reserve(matchCount);
+
+        for(std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            _matches.insert(_matches.end(), _chunkMatches[chunk].cbegin(), _chunkMatches[chunk].cend());
+        };
+    };
+
+    /// <summary>
+    /// Keep the previous matches that are still matches, every match of a longer query starts where a match of its prefix did
+    /// </summary>
+    void Refine()
+    {
+        std::erase_if(_matches, [&](const std::uint64_t match)
+        {
+            return _text.size() - match < _query.size() || _text.compare(match, _query.size(), _query) != 0;
+        });
+
+        ++_version;
+    };
+
+};
@@ -0,0 +1,522 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+#include "MappedDocument.hpp"
+#include "TextBuffer.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A range of a document's characters, [Begin, End)
+/// </summary>
+struct TextSelectionRange
+{
+    std::uint64_t Begin = 0;
+    std::uint64_t End = 0;
+
+
+    bool IsEmpty() const
+    {
+        return Begin >= End;
+    };
+
+    std::uint64_t GetSize() const
+    {
+        return IsEmpty() == false ? End - Begin : 0;
+    };
+};
+
+
+/// <summary>
+/// Where selected text is read from, only once it's actually needed, e.g. when a copy is pasted
+/// </summary>
+class ISelectionSource
+{
+
+public:
+
+    virtual ~ISelectionSource() = default;
+
+
+public:
+
+    virtual std::uint64_t GetSize() const = 0;
+
+    /// <summary>
+    /// Call a function with a range's text, a chunk at a time and in order. Chunks are views of the source, nothing is copied.
+    /// The range is clamped to the source
+    /// </summary>
+    virtual void ForEachChunk(const TextSelectionRange& range, const std::function<void(const std::string_view&)>& onChunk) const = 0;
+
+};
+
+
+/// <summary>
+/// Selects from a memory-mapped file in place. A range of the whole file is a single view of the mapping
+/// </summary>
+class MappedDocumentSelectionSource final : public ISelectionSource
+{
+
+private:
+
+    const MappedDocument& _document;
+
+
+public:
+
+    /// <param name="document"> Must outlive the source. The mapping is read when the text is needed, Refresh may have mapped it again by then </param>
+    MappedDocumentSelectionSource(const MappedDocument& document) :
+        _document(document)
+    {
+    };
+
+
+public:
+
+    virtual std::uint64_t GetSize() const override
+    {
+        return _document.GetSizeInBytes();
+    };
+
+    virtual void ForEachChunk(const TextSelectionRange& range, const std::function<void(const std::string_view&)>& onChunk) const override
+    {
+        const std::string_view text = _document.GetText();
+
+        const std::uint64_t end = std::min<std::uint64_t>(range.End, text.size());
+
+        if(range.Begin >= end)
+            return;
+
+        onChunk(text.substr(static_cast<std::size_t>(range.Begin), static_cast<std::size_t>(end - range.Begin)));
+    };
+
+};
+
+
+/// <summary>
+/// A range of an editable document as it was when it was copied. Only references to the piece table's pieces are kept,
+/// which stay valid however the document is edited since, so taking a snapshot of any size is O(pieces) rather than a copy of its text
+/// </summary>
+class TextBufferSnapshot final : public ISelectionSource
+{
+
+private:
+
+    const TextBuffer& _buffer;
+
+    /// <summary>
+    /// Held shared while the pieces' text is read, null if the buffer is only used on the thread that reads the snapshot
+    /// </summary>
+    std::shared_mutex* _bufferMutex = nullptr;
+
+    std::vector<TextBuffer::PieceReference> _pieces;
+
+    std::uint64_t _size = 0;
+
+
+public:
+
+    /// <param name="buffer"> Must outlive the snapshot </param>
+    /// <param name="range"> The characters the snapshot holds, its positions start from 0 at range.Begin </param>
+    /// <param name="bufferMutex"> For a buffer edited on another thread than the one the snapshot is read on, e.g. by a DelayedClipboard.
+    /// Edits hold it exclusively, appending may move the buffer's text </param>
+    TextBufferSnapshot(const TextBuffer& buffer, const TextSelectionRange& range, std::shared_mutex* bufferMutex = nullptr) :
+        _buffer(buffer),
+        _bufferMutex(bufferMutex)
+    {
+        if(range.IsEmpty() == true)
+            return;
+
+        buffer.GetPieces(static_cast<std::size_t>(range.Begin), static_cast<std::size_t>(range.GetSize()), _pieces);
+
+        for(const TextBuffer::PieceReference& piece : _pieces)
+        {
+            _size += piece.Length;
+        };
+    };
+
+
+public:
+
+    virtual std::uint64_t GetSize() const override
+    {
+        return _size;
+    };
+
+    virtual void ForEachChunk(const TextSelectionRange& range, const std::function<void(const std::string_view&)>& onChunk) const override
+    {
+        const std::shared_lock<std::shared_mutex> bufferLock = _bufferMutex != nullptr ? std::shared_lock(*_bufferMutex) : std::shared_lock<std::shared_mutex>();
+
+        std::uint64_t pieceStart = 0;
+
+        for(const TextBuffer::PieceReference& piece : _pieces)
+        {
+            const std::uint64_t pieceEnd = pieceStart + piece.Length;
+
+            const std::uint64_t begin = std::max(range.Begin, pieceStart);
+            const std::uint64_t end = std::min(range.End, pieceEnd);
+
+            if(begin < end)
+                onChunk(_buffer.GetPieceText(piece).substr(static_cast<std::size_t>(begin - pieceStart), static_cast<std::size_t>(end - begin)));
+
+            if(pieceEnd >= range.End)
+                break;
+
+            pieceStart = pieceEnd;
+        };
+    };
+
+};
+
+
+/// <summary>
+/// A selection of a document's characters, as an anchor where it started and a caret where it ends.
+/// Only the two positions are kept, so selecting all of a file of any size is instant, the text is only read when the copy is pasted, see DelayedClipboard
+/// </summary>
+class TextSelection
+{
+
+private:
+
+    std::uint64_t _anchor = 0;
+
+    std::uint64_t _caret = 0;
+
+
+public:
+
+    /// <summary>
+    /// Select from an anchor to a caret, in either order
+    /// </summary>
+    void Select(const std::uint64_t anchor, const std::uint64_t caret)
+    {
+        _anchor = anchor;
+        _caret = caret;
+    };
+
+    void SelectAll(const ISelectionSource& source)
+    {
+        Select(0, source.GetSize());
+    };
+
+    /// <summary>
+    /// Move the caret and keep the anchor, e.g. for a mouse drag or Shift+click
+    /// </summary>
+    void ExtendTo(const std::uint64_t caret)
+    {
+        _caret = caret;
+    };
+
+    /// <summary>
+    /// Select nothing, with the caret at a position
+    /// </summary>
+    void Collapse(const std::uint64_t position)
+    {
+        Select(position, position);
+    };
+
+    /// <summary>
+    /// Keep the selection inside a document that got shorter
+    /// </summary>
+    void Clamp(const std::uint64_t size)
+    {
+        _anchor = std::min(_anchor, size);
+        _caret = std::min(_caret, size);
+    };
+
+
+public:
+
+    /// <summary>
+    /// The selected characters, in document order
+    /// </summary>
+    TextSelectionRange GetRange() const
+    {
+        return TextSelectionRange { .Begin = std::min(_anchor, _caret), .End = std::max(_anchor, _caret) };
+    };
+
+    bool IsEmpty() const
+    {
+        return _anchor == _caret;
+    };
+
+    std::uint64_t GetAnchor() const
+    {
+        return _anchor;
+    };
+
+    std::uint64_t GetCaret() const
+    {
+        return _caret;
+    };
+
+};
+
+
+/// <summary>
+/// Copies selections to the Windows clipboard with delayed rendering. Copying only tells the clipboard that text is available,
+/// and the text is converted from its source when an application pastes it, by WM_RENDERFORMAT, so copying a selection of hundreds of megabytes is instant
+/// and costs nothing if it's never pasted. The conversion streams the source's chunks straight into the clipboard's memory, without a std::string of the text.
+/// A hidden message-only window owns the clipboard, its messages are dispatched by the thread's message loop, e.g. glfwPollEvents, so use it from the window's thread
+/// </summary>
+class DelayedClipboard
+{
+
+private:
+
+    HWND _window = nullptr;
+
+    /// <summary>
+    /// The copy the clipboard is promised, null once it was rendered or another copy replaced it
+    /// </summary>
+    std::shared_ptr<const ISelectionSource> _source;
+
+    TextSelectionRange _range;
+
+
+public:
+
+    DelayedClipboard()
+    {
+        static const ATOM windowClass = RegisterWindowClass();
+
+        _window = CreateWindowExW(0, MAKEINTATOM(windowClass), L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, GetModuleHandleW(nullptr), nullptr);
+
+        wt::Assert(_window != nullptr, "Failed to create the clipboard window");
+
+        SetWindowLongPtrW(_window, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+    };
+
+    DelayedClipboard(const DelayedClipboard&) = delete;
+    DelayedClipboard& operator = (const DelayedClipboard&) = delete;
+
+    /// <summary>
+    /// A copy that's still on the clipboard is rendered first, so it can still be pasted after the application exits
+    /// </summary>
+    ~DelayedClipboard()
+    {
+        Detach();
+
+        DestroyWindow(_window);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Put a selection on the clipboard, without reading any of it
+    /// </summary>
+    /// <param name="source"> Read when the copy is pasted, kept until then. Its text mustn't change, e.g. copy a TextBufferSnapshot rather than a document being edited </param>
+    /// <returns> False if another application has the clipboard open </returns>
+    bool Copy(std::shared_ptr<const ISelectionSource> source, const TextSelectionRange& range)
+    {
+        if(OpenClipboard(_window) == FALSE)
+            return false;
+
+        // Sends the previous owner WM_DESTROYCLIPBOARD, which is this window if the last copy was ours
+        EmptyClipboard();
+
+        _source = std::move(source);
+        _range = range;
+
+        // A null handle promises the format, WM_RENDERFORMAT asks for it
+        SetClipboardData(CF_UNICODETEXT, nullptr);
+
+        CloseClipboard();
+
+        return true;
+    };
+
+    /// <summary>
+    /// Render the copy on the clipboard now, if it's still ours, so its source can go, e.g. before the document it reads from is closed
+    /// </summary>
+    void Detach()
+    {
+        if(_source == nullptr)
+            return;
+
+        if(OpenClipboard(_window) == TRUE)
+        {
+            if(GetClipboardOwner() == _window)
+                RenderToClipboard();
+
+            CloseClipboard();
+        };
+
+        _source.reset();
+    };
+
+
+public:
+
+    /// <summary>
+    /// Whether a copy is promised and not rendered yet
+    /// </summary>
+    bool IsPending() const
+    {
+        return _source != nullptr;
+    };
+
+
+private:
+
+    static ATOM RegisterWindowClass()
+    {
+        const WNDCLASSEXW windowClass
+        {
+            .cbSize = sizeof(WNDCLASSEXW),
+            .lpfnWndProc = &WindowProcedure,
+            .hInstance = GetModuleHandleW(nullptr),
+            .lpszClassName = L"TextRendererDelayedClipboard",
+        };
+
+        const ATOM atom = RegisterClassExW(&windowClass);
+
+        wt::Assert(atom != 0, "Failed to register the clipboard window class");
+
+        return atom;
+    };
+
+    static LRESULT CALLBACK WindowProcedure(const HWND window, const UINT message, const WPARAM wParam, const LPARAM lParam)
+    {
+        DelayedClipboard* clipboard = reinterpret_cast<DelayedClipboard*>(GetWindowLongPtrW(window, GWLP_USERDATA));
+
+        if(clipboard == nullptr)
+            return DefWindowProcW(window, message, wParam, lParam);
+
+        switch(message)
+        {
+            // Another application is pasting, the clipboard is already open for it
+            case WM_RENDERFORMAT:
+            {
+                if(wParam == CF_UNICODETEXT)
+                    clipboard->RenderToClipboard();
+
+                return 0;
+            };
+
+            // The window is going away while the copy is still promised
+            case WM_RENDERALLFORMATS:
+            {
+                if(OpenClipboard(window) == TRUE)
+                {
+                    if(GetClipboardOwner() == window)
+                        clipboard->RenderToClipboard();
+
+                    CloseClipboard();
+                };
+
+                return 0;
+            };
+
+            // Something else was copied, the promise is off
+            case WM_DESTROYCLIPBOARD:
+            {
+                clipboard->_source.reset();
+
+                return 0;
+            };
+        };
+
+        return DefWindowProcW(window, message, wParam, lParam);
+    };
+
+
+    /// <summary>
+    /// Convert the copy to UTF-16 and hand it to the open clipboard
+    /// </summary>
+    void RenderToClipboard()
+    {
+        if(_source == nullptr)
+            return;
+
+        const HGLOBAL memory = RenderUnicodeText(*_source, _range);
+
+        // The clipboard owns the memory from here on, unless it refused it
+        if(memory != nullptr && SetClipboardData(CF_UNICODETEXT, memory) == nullptr)
+            GlobalFree(memory);
+
+        _source.reset();
+    };
+
+    /// <summary>
+    /// Convert a range of UTF-8 to null-terminated UTF-16 in clipboard memory. The source is read twice, once to size the memory
+    /// and once to convert into it, which is still far cheaper than holding the text in between
+    /// </summary>
+    /// <returns> Null if the memory couldn't be allocated </returns>
+    static HGLOBAL RenderUnicodeText(const ISelectionSource& source, const TextSelectionRange& range)
+    {
+        std::size_t characterCount = 0;
+
+        source.ForEachChunk(range, [&](const std::string_view& chunk)
+        {
+            ForEachSlice(chunk, [&](const std::string_view& slice)
+            {
+                characterCount += static_cast<std::size_t>(MultiByteToWideChar(CP_UTF8, 0, slice.data(), static_cast<int>(slice.size()), nullptr, 0));
+            });
+        });
+
+        const HGLOBAL memory = GlobalAlloc(GMEM_MOVEABLE, (characterCount + 1) * sizeof(wchar_t));
+
+        if(memory == nullptr)
+            return nullptr;
+
+        wchar_t* const characters = static_cast<wchar_t*>(GlobalLock(memory));
+
+        std::size_t written = 0;
+
+        source.ForEachChunk(range, [&](const std::string_view& chunk)
+        {
+            ForEachSlice(chunk, [&](const std::string_view& slice)
+            {
+                written += static_cast<std::size_t>(MultiByteToWideChar(CP_UTF8, 0, slice.data(), static_cast<int>(slice.size()), characters + written, static_cast<int>(characterCount - written)));
+            });
+        });
+
+        characters[written] = L'\0';
+
+        GlobalUnlock(memory);
+
+        return memory;
+    };
+
+    /// <summary>
+    /// Cut a chunk into slices MultiByteToWideChar takes, at most SliceSizeInBytes each and never splitting a UTF-8 sequence.
+    /// A sequence split across two chunks is replaced, the sources only split pieces of ASCII text
+    /// </summary>
+    template<typename TOnSlice>
+    static void ForEachSlice(std::string_view chunk, TOnSlice&& onSlice)
+    {
+        while(chunk.empty() == false)
+        {
+            std::size_t size = std::min(chunk.size(), SliceSizeInBytes);
+
+            // Continuation bytes are 10xxxxxx, back up to the sequence's first byte
+            while(size < chunk.size() && size > 1 && (static_cast<std::uint8_t>(chunk[size]) & 0xC0) == 0x80)
+            {
+                --size;
+            };
+
+            onSlice(chunk.substr(0, size));
+
+            chunk.remove_prefix(size);
+        };
+    };
+
+
+private:
+
+    /// <summary>
+    /// How much UTF-8 is converted by a single MultiByteToWideChar
+    /// </summary>
+    static constexpr std::size_t SliceSizeInBytes = 16 * 1024 * 1024;
+
+};
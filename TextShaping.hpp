@@ -0,0 +1,609 @@
+#pragma once
+
+#include <Windows.h>
+#include <usp10.h>
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include "GlyphAtlas.hpp"
+#include "GlyphRasterizer.hpp"
+#include "WindowsUtilities.hpp"
+
+#pragma comment(lib, "usp10.lib")
+
+
+/// <summary>
+/// A glyph a shaper placed, by its index in the font rather than by codepoint. Ligatures, contextual forms and marks
+/// don't map to a codepoint of their own, see GlyphAtlas::PrepareGlyphIndex
+/// </summary>
+struct ShapedGlyph
+{
+    std::uint32_t GlyphIndex = 0;
+
+    /// <summary>
+    /// The byte offset in the UTF-8 text of the first character of the cluster the glyph belongs to, e.g. for hit-testing
+    /// </summary>
+    std::uint32_t Cluster = 0;
+
+    /// <summary>
+    /// Where the glyph is drawn relative to the run's origin, its pen position plus the shaper's offset, in pixels
+    /// </summary>
+    glm::vec2 Position = { 0.0f, 0.0f };
+
+    float Advance = 0.0f;
+};
+
+
+/// <summary>
+/// The options text is shaped with, part of a shaped run's cache key
+/// </summary>
+struct ShapingOptions
+{
+    /// <summary>
+    /// The paragraph's base direction, which decides the order of its directional runs and the direction of neutral characters between them
+    /// </summary>
+    bool RightToLeft = false;
+
+    /// <summary>
+    /// The language the text is shaped for, which picks localized forms, 0 for the user's default
+    /// </summary>
+    LANGID Language = 0;
+
+
+    auto operator <=> (const ShapingOptions&) const = default;
+};
+
+
+/// <summary>
+/// A stretch of a shaped line in a single direction and script, its glyphs are consecutive in ShapedRun::Glyphs
+/// </summary>
+struct DirectionalRun
+{
+    std::uint32_t FirstGlyph = 0;
+
+    std::uint32_t GlyphCount = 0;
+
+    /// <summary>
+    /// The byte range of the UTF-8 text the run was shaped from
+    /// </summary>
+    std::uint32_t FirstCluster = 0;
+    std::uint32_t EndCluster = 0;
+
+    /// <summary>
+    /// The run's bidi embedding level, odd levels are right-to-left
+    /// </summary>
+    std::uint8_t Level = 0;
+
+
+    bool IsRightToLeft() const
+    {
+        return (Level & 1) != 0;
+    };
+};
+
+
+/// <summary>
+/// A line of text shaped into glyphs, in visual order: mixed-direction text is already reordered, so the glyphs are drawn left to right as they are
+/// </summary>
+struct ShapedRun
+{
+    std::vector<ShapedGlyph> Glyphs;
+
+    /// <summary>
+    /// The line's directional runs, in visual order, e.g. to map a caret between logical and visual positions
+    /// </summary>
+    std::vector<DirectionalRun> Runs;
+
+    /// <summary>
+    /// The sum of the glyphs' advances, in pixels
+    /// </summary>
+    float Width = 0.0f;
+};
+
+
+/// <summary>
+/// Turns text into positioned glyphs of a font, applying its ligatures, contextual forms and mark positioning.
+/// Scripts like Arabic or Devanagari can't be drawn a codepoint at a time, simple scripts don't need a shaper
+/// </summary>
+class ITextShaper
+{
+
+public:
+
+    virtual ~ITextShaper() = default;
+
+
+public:
+
+    /// <summary>
+    /// Shape a line of UTF-8 text. Control characters, including '\n', are shaped like any other character and usually come out blank
+    /// </summary>
+    virtual ShapedRun Shape(const std::string_view& text, const ShapingOptions& options) const = 0;
+
+};
+
+
+/// <summary>
+/// Shapes text with Uniscribe, in the font a GDIGlyphRasterizer rasterizes, so the glyph indices it outputs can go straight to the rasterizer's GlyphAtlas.
+/// Each script item is shaped on its own, and a font that doesn't cover an item's script shapes it without script processing rather than failing.
+/// Itemizing also resolves the Unicode bidi levels, the items are shaped in logical order and then laid out in visual order
+/// </summary>
+class UniscribeTextShaper : public ITextShaper
+{
+
+private:
+
+    std::reference_wrapper<const GDIGlyphRasterizer> _rasterizer;
+
+    /// <summary>
+    /// Uniscribe's cache of the font's shaping tables, filled by the first call that needs it
+    /// </summary>
+    mutable SCRIPT_CACHE _scriptCache = nullptr;
+
+
+public:
+
+    /// <param name="rasterizer"> Must outlive the shaper </param>
+    UniscribeTextShaper(const GDIGlyphRasterizer& rasterizer) :
+        _rasterizer(rasterizer)
+    {
+    };
+
+    UniscribeTextShaper(const UniscribeTextShaper&) = delete;
+    UniscribeTextShaper& operator = (const UniscribeTextShaper&) = delete;
+
+    ~UniscribeTextShaper()
+    {
+        ScriptFreeCache(&_scriptCache);
+    };
+
+
+public:
+
+    ShapedRun Shape(const std::string_view& text, const ShapingOptions& options) const override
+    {
+        ShapedRun run;
+
+        if(text.empty() == true)
+            return run;
+
+
+        // Uniscribe takes UTF-16, every UTF-16 unit remembers the byte offset of the UTF-8 character it came from
+        std::wstring wideText;
+        std::vector<std::uint32_t> wideClusters;
+
+        wideText.reserve(text.size());
+        wideClusters.reserve(text.size());
+
+        std::size_t byteOffset = 0;
+
+        ForEachCodepoint(text, [&](const char32_t codepoint)
+        {
+            // Every byte that isn't a continuation byte is exactly 1 codepoint
+            while((static_cast<std::uint8_t>(text[byteOffset]) & 0xC0) == 0x80)
+                ++byteOffset;
+
+            const std::uint32_t cluster = static_cast<std::uint32_t>(byteOffset++);
+
+            if(codepoint > 0xFFFF)
+            {
+                wideText.push_back(static_cast<wchar_t>(0xD800 + ((codepoint - 0x10000) >> 10)));
+                wideText.push_back(static_cast<wchar_t>(0xDC00 + ((codepoint - 0x10000) & 0x3FF)));
+
+                wideClusters.insert(wideClusters.end(), 2, cluster);
+            }
+            else
+            {
+                wideText.push_back(static_cast<wchar_t>(codepoint));
+
+                wideClusters.push_back(cluster);
+            };
+        });
+
+        const int wideSize = static_cast<int>(wideText.size());
+
+
+        SCRIPT_CONTROL control = { };
+        control.uDefaultLanguage = options.Language;
+
+        SCRIPT_STATE state = { };
+        state.uBidiLevel = options.RightToLeft == true ? 1 : 0;
+
+        // ScriptItemize needs one more item than it fills
+        std::vector<SCRIPT_ITEM> items(static_cast<std::size_t>(wideSize) + 1);
+
+        int itemCount = 0;
+
+        wt::Assert(SUCCEEDED(ScriptItemize(wideText.c_str(), wideSize, wideSize, &control, &state, items.data(), &itemCount)), "Failed to itemize text for shaping");
+
+
+        const HDC deviceContext = _rasterizer.get().GetDeviceContext();
+
+        std::vector<WORD> glyphs;
+        std::vector<WORD> logicalClusters;
+        std::vector<SCRIPT_VISATTR> visualAttributes;
+        std::vector<int> advances;
+        std::vector<GOFFSET> offsets;
+
+        // The items are shaped in logical order, each at its own origin, and moved into visual order once they all are
+        std::vector<ShapedGlyph> logicalGlyphs;
+        std::vector<DirectionalRun> logicalRuns;
+        std::vector<float> runWidths;
+
+        for(int itemIndex = 0; itemIndex < itemCount; ++itemIndex)
+        {
+            SCRIPT_ITEM& item = items[static_cast<std::size_t>(itemIndex)];
+
+            const int itemStart = item.iCharPos;
+            const int itemSize = items[static_cast<std::size_t>(itemIndex) + 1].iCharPos - itemStart;
+
+            // Uniscribe's recommended first guess, doubled whenever it's too small
+            int glyphCapacity = (itemSize * 3) / 2 + 16;
+            int glyphCount = 0;
+
+            logicalClusters.resize(static_cast<std::size_t>(itemSize));
+
+            HRESULT result = E_OUTOFMEMORY;
+
+            while(true)
+            {
+                glyphs.resize(static_cast<std::size_t>(glyphCapacity));
+                visualAttributes.resize(static_cast<std::size_t>(glyphCapacity));
+
+                result = ScriptShape(deviceContext, &_scriptCache, wideText.c_str() + itemStart, itemSize, glyphCapacity,
+                                     &item.a, glyphs.data(), logicalClusters.data(), visualAttributes.data(), &glyphCount);
+
+                if(result == E_OUTOFMEMORY)
+                    glyphCapacity *= 2;
+                // The font has no glyphs for the script, the characters are shaped one to one instead, mostly into the missing glyph
+                else if(result == USP_E_SCRIPT_NOT_IN_FONT)
+                    item.a.eScript = SCRIPT_UNDEFINED;
+                else
+                    break;
+            };
+
+            wt::Assert(SUCCEEDED(result), "Failed to shape text");
+
+
+            advances.resize(static_cast<std::size_t>(glyphCount));
+            offsets.resize(static_cast<std::size_t>(glyphCount));
+
+            ABC itemABC = { };
+
+            wt::Assert(SUCCEEDED(ScriptPlace(deviceContext, &_scriptCache, glyphs.data(), glyphCount, visualAttributes.data(), &item.a,
+                                             advances.data(), offsets.data(), &itemABC)), "Failed to place shaped glyphs");
+
+
+            // A glyph's cluster is the first character that maps to it. Glyphs no character maps to, e.g. a split vowel's second half,
+            // belong to the cluster of the glyph before them in logical order
+            std::vector<std::uint32_t> glyphClusters(static_cast<std::size_t>(glyphCount), NoCluster);
+
+            for(int character = itemSize - 1; character >= 0; --character)
+            {
+                glyphClusters[logicalClusters[static_cast<std::size_t>(character)]] = wideClusters[static_cast<std::size_t>(itemStart + character)];
+            };
+
+            // Glyphs of right-to-left items come out in visual order, so their logical order runs backwards
+            const bool rightToLeft = item.a.fRTL != 0;
+
+            std::uint32_t cluster = wideClusters[static_cast<std::size_t>(itemStart)];
+
+            for(int step = 0; step < glyphCount; ++step)
+            {
+                const std::size_t glyph = static_cast<std::size_t>(rightToLeft == true ? glyphCount - 1 - step : step);
+
+                if(glyphClusters[glyph] == NoCluster)
+                    glyphClusters[glyph] = cluster;
+                else
+                    cluster = glyphClusters[glyph];
+            };
+
+
+            const std::size_t itemEnd = static_cast<std::size_t>(itemStart + itemSize);
+
+            logicalRuns.emplace_back(DirectionalRun
+            {
+                .FirstGlyph = static_cast<std::uint32_t>(logicalGlyphs.size()),
+                .GlyphCount = static_cast<std::uint32_t>(glyphCount),
+                .FirstCluster = wideClusters[static_cast<std::size_t>(itemStart)],
+                .EndCluster = itemEnd < wideClusters.size() ? wideClusters[itemEnd] : static_cast<std::uint32_t>(text.size()),
+                .Level = static_cast<std::uint8_t>(item.a.s.uBidiLevel),
+            });
+
+            float runWidth = 0.0f;
+
+            for(std::size_t glyph = 0; glyph < static_cast<std::size_t>(glyphCount); ++glyph)
+            {
+                const float advance = static_cast<float>(advances[glyph]);
+
+                // GDI's offsets point up, the renderer's y points down
+                logicalGlyphs.emplace_back(ShapedGlyph
+                {
+                    .GlyphIndex = glyphs[glyph],
+                    .Cluster = glyphClusters[glyph],
+                    .Position = { runWidth + static_cast<float>(offsets[glyph].du), -static_cast<float>(offsets[glyph].dv) },
+                    .Advance = advance,
+                });
+
+                runWidth += advance;
+            };
+
+            runWidths.emplace_back(runWidth);
+        };
+
+
+        // Reorder the runs by their levels, the glyphs within a right-to-left run already are in visual order
+        std::vector<BYTE> levels(logicalRuns.size());
+        std::vector<int> visualToLogical(logicalRuns.size());
+
+        for(std::size_t index = 0; index < logicalRuns.size(); ++index)
+        {
+            levels[index] = logicalRuns[index].Level;
+        };
+
+        wt::Assert(SUCCEEDED(ScriptLayout(static_cast<int>(levels.size()), levels.data(), visualToLogical.data(), nullptr)), "Failed to reorder bidi runs");
+
+        run.Glyphs.reserve(logicalGlyphs.size());
+        run.Runs.reserve(logicalRuns.size());
+
+        for(const int logicalIndex : visualToLogical)
+        {
+            DirectionalRun directionalRun = logicalRuns[static_cast<std::size_t>(logicalIndex)];
+
+            const auto firstGlyph = logicalGlyphs.cbegin() + directionalRun.FirstGlyph;
+
+            directionalRun.FirstGlyph = static_cast<std::uint32_t>(run.Glyphs.size());
+
+            for(auto glyph = firstGlyph; glyph != firstGlyph + directionalRun.GlyphCount; ++glyph)
+            {
+                ShapedGlyph& placedGlyph = run.Glyphs.emplace_back(*glyph);
+
+                placedGlyph.Position.x += run.Width;
+            };
+
+            run.Runs.emplace_back(directionalRun);
+
+            run.Width += runWidths[static_cast<std::size_t>(logicalIndex)];
+        };
+
+        return run;
+    };
+
+
+private:
+
+    static constexpr std::uint32_t NoCluster = std::numeric_limits<std::uint32_t>::max();
+
+};
+
+
+/// <summary>
+/// Shaped runs, keyed by their text, shaper and options like TextMetricsCache's metrics, so only text that changed is shaped again.
+/// Shaping is far more expensive than laying out a codepoint at a time, and most drawn text is the same from frame to frame.
+/// Entries aren't evicted individually, once the cache is full it starts over
+/// </summary>
+class ShapedTextCache
+{
+
+private:
+
+    struct Entry
+    {
+        /// <summary>
+        /// Compared on lookup so a hash collision is a miss rather than the wrong text
+        /// </summary>
+        std::string Text;
+
+        const ITextShaper* Shaper = nullptr;
+
+        ShapingOptions Options;
+
+        ShapedRun Run;
+    };
+
+    std::unordered_map<std::uint64_t, Entry> _entries;
+
+    std::size_t _capacity = 0;
+
+    std::uint64_t _shapeCount = 0;
+
+
+public:
+
+    /// <param name="capacity"> The number of runs that are kept at once </param>
+    ShapedTextCache(const std::size_t capacity = 1024) :
+        _capacity(std::max<std::size_t>(capacity, 1))
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// A line's shaped run, shaped if it isn't cached. Only valid until the next call, which may start the cache over
+    /// </summary>
+    const ShapedRun& Get(const std::string_view& text, const ITextShaper& shaper, const ShapingOptions& options = { })
+    {
+        const std::uint64_t hash = HashKey(text, shaper, options);
+
+        if(const auto entry = _entries.find(hash); entry != _entries.end() && entry->second.Shaper == &shaper && entry->second.Options == options && entry->second.Text == text)
+            return entry->second.Run;
+
+        if(_entries.size() >= _capacity)
+            _entries.clear();
+
+        Entry entry = Entry
+        {
+            .Text = std::string(text),
+            .Shaper = &shaper,
+            .Options = options,
+            .Run = shaper.Shape(text, options),
+        };
+
+        ++_shapeCount;
+
+        return _entries.insert_or_assign(hash, std::move(entry)).first->second.Run;
+    };
+
+    /// <summary>
+    /// Forget every run, e.g. once a shaper's font changed
+    /// </summary>
+    void Clear()
+    {
+        _entries.clear();
+    };
+
+
+    std::size_t GetSize() const
+    {
+        return _entries.size();
+    };
+
+    /// <summary>
+    /// How many runs were shaped because they weren't cached, since construction
+    /// </summary>
+    std::uint64_t GetShapeCount() const
+    {
+        return _shapeCount;
+    };
+
+
+private:
+
+    static std::uint64_t HashKey(const std::string_view& text, const ITextShaper& shaper, const ShapingOptions& options)
+    {
+        std::uint64_t hash = std::hash<std::string_view>()(text);
+
+        const auto combine = [&](const std::uint64_t value)
+        {
+            hash ^= value + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        };
+
+        combine(std::hash<const void*>()(&shaper));
+        combine(options.RightToLeft == true ? 1 : 0);
+        combine(options.Language);
+
+        return hash;
+    };
+
+};
+
+
+/// <summary>
+/// A document's paragraphs, shaped and reordered for drawing. Update is only called when the text changes and only shapes the paragraphs
+/// that did: an edited paragraph is shaped again, every other one keeps its run, even if lines were inserted or removed above it.
+/// Static text costs nothing per frame, its runs are submitted as they are, see TextBatch::SubmitShaped.
+/// Paragraphs are matched by a hash of their text rather than the text, so the document isn't kept a second time
+/// </summary>
+class ShapedParagraphs
+{
+
+private:
+
+    struct Paragraph
+    {
+        std::uint64_t ContentHash = 0;
+
+        std::size_t Size = 0;
+
+        ShapedRun Run;
+    };
+
+    std::vector<Paragraph> _paragraphs;
+
+    std::uint64_t _shapeCount = 0;
+
+
+public:
+
+    /// <summary>
+    /// Bring the paragraphs up to date with a document, split at '\n'
+    /// </summary>
+    /// <param name="shaper"> Paragraphs kept from the last update aren't shaped again, a different shaper or options need a Clear first </param>
+    void Update(const std::string_view& text, const ITextShaper& shaper, const ShapingOptions& options = { })
+    {
+        std::vector<Paragraph> previousParagraphs = std::move(_paragraphs);
+
+        _paragraphs.clear();
+
+        // Where each unchanged paragraph went, so a paragraph that moved is still found. Equal paragraphs are taken in order
+        std::unordered_multimap<std::uint64_t, std::size_t> previousIndices;
+
+        previousIndices.reserve(previousParagraphs.size());
+
+        for(std::size_t index = 0; index < previousParagraphs.size(); ++index)
+        {
+            previousIndices.emplace(previousParagraphs[index].ContentHash, index);
+        };
+
+
+        std::size_t paragraphStart = 0;
+
+        while(paragraphStart <= text.size())
+        {
+            const std::size_t paragraphEnd = std::min(text.find('\n', paragraphStart), text.size());
+
+            const std::string_view paragraph = text.substr(paragraphStart, paragraphEnd - paragraphStart);
+
+            const std::uint64_t contentHash = std::hash<std::string_view>()(paragraph);
+
+            Paragraph& shapedParagraph = _paragraphs.emplace_back(Paragraph { .ContentHash = contentHash, .Size = paragraph.size() });
+
+            const auto [first, last] = previousIndices.equal_range(contentHash);
+
+            const auto previous = std::find_if(first, last, [&](const auto& entry)
+            {
+                return previousParagraphs[entry.second].Size == paragraph.size();
+            });
+
+            if(previous != last)
+            {
+                shapedParagraph.Run = std::move(previousParagraphs[previous->second].Run);
+
+                previousIndices.erase(previous);
+            }
+            else
+            {
+                shapedParagraph.Run = shaper.Shape(paragraph, options);
+
+                ++_shapeCount;
+            };
+
+            paragraphStart = paragraphEnd + 1;
+        };
+    };
+
+    void Clear()
+    {
+        _paragraphs.clear();
+    };
+
+
+    std::size_t GetParagraphCount() const
+    {
+        return _paragraphs.size();
+    };
+
+    const ShapedRun& GetRun(const std::size_t paragraph) const
+    {
+        return _paragraphs[paragraph].Run;
+    };
+
+    /// <summary>
+    /// How many paragraphs were shaped because they were new or edited, since construction
+    /// </summary>
+    std::uint64_t GetShapeCount() const
+    {
+        return _shapeCount;
+    };
+
+};
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "MPSCQueue.hpp"
+#include "SPSCQueue.hpp"
+#include "TextConversion.hpp"
+#include "TextRing.hpp"
+
+
+/// <summary>
+/// Feeds a TextRing from text that arrives on other threads, e.g. from a socket.
+/// Producers push raw UTF-8 chunks into a lock-free queue and never wait on anything, least of all the render thread.
+/// A worker thread decodes the chunks into the characters the atlas can draw, merging small chunks together,
+/// and hands the ready text to the render thread, which only copies it into the ring, see Update.
+/// Sequences and "\r\n" line endings split between chunks are decoded as if the chunks had arrived as one
+/// </summary>
+class TextStream
+{
+
+private:
+
+    /// <summary>
+    /// Raw chunks, from any number of producers
+    /// </summary>
+    MPSCQueue<std::string, 1024> _chunks;
+
+    /// <summary>
+    /// Decoded text, from the worker to the render thread
+    /// </summary>
+    SPSCQueue<std::string, 64> _readyText;
+
+    /// <summary>
+    /// Bumped for every chunk pushed, the worker sleeps on it while there's nothing to decode
+    /// </summary>
+    std::atomic<std::uint32_t> _pushedCount = 0;
+
+    /// <summary>
+    /// Bumped whenever the render thread takes ready text, the worker sleeps on it while _readyText is full
+    /// </summary>
+    std::atomic<std::uint32_t> _takenCount = 0;
+
+    std::atomic<std::uint64_t> _rejectedChunkCount = 0;
+
+    std::atomic<bool> _stopping = false;
+
+    std::thread _worker;
+
+
+public:
+
+    /// <summary>
+    /// At most how much decoded text the worker merges into a single hand-off
+    /// </summary>
+    static constexpr std::size_t MaxReadySizeInBytes = 1024 * 1024;
+
+
+public:
+
+    TextStream()
+    {
+        _worker = std::thread([this]()
+        {
+            Run();
+        });
+    };
+
+    TextStream(const TextStream&) = delete;
+    TextStream& operator = (const TextStream&) = delete;
+
+    /// <summary>
+    /// Chunks that weren't decoded yet are dropped
+    /// </summary>
+    ~TextStream()
+    {
+        _stopping.store(true, std::memory_order_relaxed);
+
+        WakeWorker(_pushedCount);
+        WakeWorker(_takenCount);
+
+        _worker.join();
+    };
+
+
+public:
+
+    /// <summary>
+    /// (Any thread) Queue a chunk of UTF-8 text. Never blocks
+    /// </summary>
+    /// <returns> False if the queue is full because the worker can't keep up, the chunk is then left untouched so it can be pushed again </returns>
+    bool Push(std::string&& chunk)
+    {
+        if(chunk.empty() == true)
+            return true;
+
+        if(_chunks.TryPush(std::move(chunk)) == false)
+        {
+            _rejectedChunkCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        };
+
+        WakeWorker(_pushedCount);
+
+        return true;
+    };
+
+    /// <summary>
+    /// (Any thread) Queue a copy of a chunk of UTF-8 text, e.g. straight from a receive buffer. Never blocks
+    /// </summary>
+    bool Push(const char* data, const std::size_t size)
+    {
+        return Push(std::string(data, size));
+    };
+
+
+    /// <summary>
+    /// (Render thread) Append all of the text decoded so far to a ring, to be uploaded by its next Upload
+    /// </summary>
+    /// <returns> The number of characters appended </returns>
+    std::size_t Update(TextRing& ring)
+    {
+        std::size_t characterCount = 0;
+
+        std::string text;
+
+        while(_readyText.TryPop(text) == true)
+        {
+            ring.AppendConverted(std::as_bytes(std::span(text)));
+
+            characterCount += text.size();
+        };
+
+        if(characterCount != 0)
+            WakeWorker(_takenCount);
+
+        return characterCount;
+    };
+
+
+public:
+
+    /// <summary>
+    /// How many pushes failed because the queue was full
+    /// </summary>
+    std::uint64_t GetRejectedChunkCount() const
+    {
+        return _rejectedChunkCount.load(std::memory_order_relaxed);
+    };
+
+
+private:
+
+    static void WakeWorker(std::atomic<std::uint32_t>& counter)
+    {
+        counter.fetch_add(1, std::memory_order_release);
+        counter.notify_one();
+    };
+
+
+    /// <summary>
+    /// (Worker) Decode chunks as they arrive, until the stream is destroyed
+    /// </summary>
+    void Run()
+    {
+        // The end of the last chunk that couldn't be decoded without the next one
+        std::string carriedBytes;
+
+        std::string chunk;
+
+        while(true)
+        {
+            // Read before looking at the queue and at _stopping, so anything that happens after still wakes the wait below
+            const std::uint32_t pushedCount = _pushedCount.load(std::memory_order_acquire);
+
+            if(_stopping.load(std::memory_order_relaxed) == true)
+                return;
+
+            std::string decoded;
+
+            while(decoded.size() < MaxReadySizeInBytes && _chunks.TryPop(chunk) == true)
+            {
+                if(carriedBytes.empty() == false)
+                {
+                    carriedBytes.append(chunk);
+                    std::swap(carriedBytes, chunk);
+                    carriedBytes.clear();
+                };
+
+                const std::size_t decodableSize = GetDecodableSize(chunk);
+
+                DecodeUTF8ToGlyphText(std::string_view(chunk).substr(0, decodableSize), decoded);
+
+                carriedBytes.assign(chunk, decodableSize);
+            };
+
+            if(decoded.empty() == true)
+            {
+                _pushedCount.wait(pushedCount, std::memory_order_acquire);
+                continue;
+            };
+
+
+            // Only the worker waits on a full hand-off, producers keep pushing until their own queue fills up
+            while(true)
+            {
+                const std::uint32_t takenCount = _takenCount.load(std::memory_order_acquire);
+
+                if(_stopping.load(std::memory_order_relaxed) == true)
+                    return;
+
+                if(_readyText.TryPush(std::move(decoded)) == true)
+                    break;
+
+                _takenCount.wait(takenCount, std::memory_order_acquire);
+            };
+        };
+    };
+
+    /// <summary>
+    /// The length of a chunk without the bytes that have to wait for the next chunk: a UTF-8 sequence that's cut off,
+    /// or a '\r' whose '\n' may be next
+    /// </summary>
+    static std::size_t GetDecodableSize(const std::string_view& chunk)
+    {
+        const std::size_t size = chunk.size();
+
+        // A sequence is at most 4 bytes long, so its lead byte is within the last 3
+        for(std::size_t back = 1; back <= std::min<std::size_t>(size, 3); ++back)
+        {
+            const std::uint8_t byte = static_cast<std::uint8_t>(chunk[size - back]);
+
+            if(TextConversionKernels::IsContinuationByte(byte) == true)
+                continue;
+
+            const std::size_t length = byte >= 0xC2 && byte <= 0xDF ? 2 :
+                                       byte >= 0xE0 && byte <= 0xEF ? 3 :
+                                       byte >= 0xF0 && byte <= 0xF4 ? 4 :
+                                       1;
+
+            if(length > back)
+                return size - back;
+
+            break;
+        };
+
+        return size != 0 && chunk.back() == '\r' ? size - 1 : size;
+    };
+
+};
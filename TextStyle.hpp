@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <glm/vec4.hpp>
+#include <glm/packing.hpp>
+
+
+/// <summary>
+/// The shader storage binding a styled draw's spans are bound to, read by the layout pass
+/// </summary>
+constexpr std::uint32_t TextSpansBindingIndex = 11;
+
+/// <summary>
+/// The shader storage binding a paletted draw's colours are bound to, read by the layout pass
+/// </summary>
+constexpr std::uint32_t TextPaletteBindingIndex = 18;
+
+
+/// <summary>
+/// Decorations a span's glyphs are drawn with. Can be combined
+/// </summary>
+enum class GlyphStyle : std::uint32_t
+{
+    None = 0,
+
+    /// <summary>
+    /// A line along the bottom of the glyph's quad, which for grid atlases is the bottom of its cell
+    /// </summary>
+    Underline = 1 << 0,
+
+    /// <summary>
+    /// A line through the middle of the glyph's quad
+    /// </summary>
+    Strikethrough = 1 << 1,
+
+    /// <summary>
+    /// Thickened by sampling the atlas a texel to the left as well
+    /// </summary>
+    Bold = 1 << 2,
+};
+
+constexpr GlyphStyle operator | (const GlyphStyle left, const GlyphStyle right)
+{
+    return static_cast<GlyphStyle>(static_cast<std::uint32_t>(left) | static_cast<std::uint32_t>(right));
+};
+
+
+/// <summary>
+/// A run of characters drawn with the same colour and style, matches the std430 layout of "TextSpan" in TextLayoutComputeShader.glsl.
+/// A span lasts until the next span's first character, characters before the first span use the draw's text colour
+/// </summary>
+struct TextSpan
+{
+    std::uint32_t FirstCharacter = 0;
+
+    /// <summary>
+    /// The span's colour, packed as RGBA8 with red in the low byte. See PackSpanColour
+    /// </summary>
+    std::uint32_t Colour = 0;
+
+    GlyphStyle Style = GlyphStyle::None;
+
+    /// <summary>
+    /// The colour the span's cells are filled with behind its glyphs, packed like Colour. 0 alpha for no background
+    /// </summary>
+    std::uint32_t Background = 0;
+};
+
+static_assert(sizeof(TextSpan) == 16, "TextSpan must match the std430 struct size");
+
+
+/// <summary>
+/// Pack a colour the way the shaders' unpackUnorm4x8 reads it
+/// </summary>
+inline std::uint32_t PackSpanColour(const glm::vec4& colour)
+{
+    return glm::packUnorm4x8(colour);
+};
+
+/// <summary>
+/// The number of high bits of a paletted character that index the palette: 4 of a 16-bit character, up to 16 colours for characters below 4096,
+/// and 8 of a 32-bit one, up to 256 colours for any codepoint
+/// </summary>
+template<typename TCharacter>
+constexpr std::uint32_t PaletteIndexBits = sizeof(TCharacter) == 2 ? 4 : 8;
+
+/// <summary>
+/// A character with a palette index in its high bits, see FontSprite::DrawPaletted. Index 0 draws in the draw's own colour
+/// </summary>
+template<typename TCharacter>
+constexpr TCharacter PackPalettedCharacter(const char32_t character, const std::uint32_t paletteIndex)
+{
+    static_assert(std::is_same_v<TCharacter, std::uint16_t> == true || std::is_same_v<TCharacter, std::uint32_t> == true, "Paletted characters are 16 or 32 bits");
+
+    constexpr std::uint32_t characterBits = sizeof(TCharacter) * 8 - PaletteIndexBits<TCharacter>;
+
+    return static_cast<TCharacter>((paletteIndex << characterBits) | (static_cast<std::uint32_t>(character) & ((1u << characterBits) - 1u)));
+};
+
+
+inline TextSpan MakeTextSpan(const std::uint32_t firstCharacter, const glm::vec4& colour, const GlyphStyle style = GlyphStyle::None, const glm::vec4& background = { 0.0f, 0.0f, 0.0f, 0.0f })
+{
+    return TextSpan
+    {
+        .FirstCharacter = firstCharacter,
+        .Colour = PackSpanColour(colour),
+        .Style = style,
+        .Background = PackSpanColour(background),
+    };
+};
+
+
+/// <summary>
+/// Give a range of characters a background, such as a selection, on top of the spans they're already in.
+/// Spans are split at the range's ends, so the characters keep their colour and style
+/// </summary>
+/// <param name="spans"> Sorted by FirstCharacter, stays sorted </param>
+/// <param name="endCharacter"> One past the range's last character </param>
+/// <param name="textColour"> The draw's text colour, for characters before the first span </param>
+inline void SetSpanBackground(std::vector<TextSpan>& spans, const std::uint32_t firstCharacter, const std::uint32_t endCharacter, const glm::vec4& background, const glm::vec4& textColour)
+{
+    if(firstCharacter >= endCharacter)
+        return;
+
+    // Make sure a span starts exactly at a character, copying the span it was in
+    const auto splitAt = [&](const std::uint32_t character)
+    {
+        const auto next = std::upper_bound(spans.begin(), spans.end(), character, [](const std::uint32_t first, const TextSpan& span)
+        {
+            return first < span.FirstCharacter;
+        });
+
+        if(next != spans.begin() && std::prev(next)->FirstCharacter == character)
+            return;
+
+        TextSpan span = next != spans.begin() ? *std::prev(next) : MakeTextSpan(0, textColour);
+        span.FirstCharacter = character;
+
+        spans.insert(next, span);
+    };
+
+    splitAt(firstCharacter);
+    splitAt(endCharacter);
+
+    const std::uint32_t packedBackground = PackSpanColour(background);
+
+    for(TextSpan& span : spans)
+    {
+        if(span.FirstCharacter >= firstCharacter && span.FirstCharacter < endCharacter)
+            span.Background = packedBackground;
+    };
+};
+
+
+/// <summary>
+/// At most how many of a text's characters are in spans with a background, each of them is laid out as an extra instance
+/// </summary>
+inline std::size_t CountBackgroundCharacters(const std::span<const TextSpan>& spans, const std::size_t characterCount)
+{
+    std::size_t count = 0;
+
+    for(std::size_t index = 0; index < spans.size(); ++index)
+    {
+        if((spans[index].Background >> 24) == 0 || spans[index].FirstCharacter >= characterCount)
+            continue;
+
+        const std::size_t end = index + 1 < spans.size() ? std::min<std::size_t>(spans[index + 1].FirstCharacter, characterCount) : characterCount;
+
+        count += end - spans[index].FirstCharacter;
+    };
+
+    return count;
+};
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string_view>
+#include <vector>
+
+#include "TextBuffer.hpp"
+
+
+/// <summary>
+/// Undo and redo for a TextBuffer, without snapshots or copies of the text.
+/// Edits are logged as a position and references to the buffer's pieces: an insertion's are in the add buffer, an erasure's are
+/// taken before the pieces are erased. Both buffers are append-only, so the references stay valid, undoing an erasure splices
+/// them back in and undoing an insertion erases its range, each O(log n). Either only dirties from the edit's position on,
+/// so the renderer uploads the same range it would for the edit itself.
+/// Runs of typing, and of backspacing, are merged into a single edit while they're contiguous and quick enough.
+/// The log is bounded, the oldest edits are forgotten first. Forgetting them doesn't shrink the buffer's add buffer
+/// </summary>
+class TextUndoHistory
+{
+
+private:
+
+    enum class EditType
+    {
+        Insert,
+        Erase,
+    };
+
+    struct Edit
+    {
+        EditType Type = EditType::Insert;
+
+        std::size_t Position = 0;
+
+        std::size_t Length = 0;
+
+        /// <summary>
+        /// The inserted or erased characters
+        /// </summary>
+        std::vector<TextBuffer::PieceReference> Pieces;
+
+        /// <summary>
+        /// When the edit was last extended, for merging runs
+        /// </summary>
+        double Time = 0.0;
+    };
+
+
+    std::deque<Edit> _edits;
+
+    /// <summary>
+    /// The number of edits applied, the ones after it were undone and can be redone
+    /// </summary>
+    std::size_t _appliedCount = 0;
+
+    std::size_t _pieceCount = 0;
+
+    /// <summary>
+    /// Set by undoing, redoing and BreakCoalescing, so the next edit starts a new one
+    /// </summary>
+    bool _coalescingBroken = true;
+
+    /// <summary>
+    /// Where GetPieces writes, kept so recording an erasure doesn't allocate once it grew
+    /// </summary>
+    std::vector<TextBuffer::PieceReference> _pieceScratch;
+
+
+public:
+
+    /// <summary>
+    /// Contiguous edits of the same kind further apart than this, in seconds, aren't merged
+    /// </summary>
+    double CoalesceInterval = 1.0;
+
+    /// <summary>
+    /// The most edits kept
+    /// </summary>
+    std::size_t MaxEditCount = 10000;
+
+    /// <summary>
+    /// The most piece references kept, together with MaxEditCount it bounds the log's memory
+    /// </summary>
+    std::size_t MaxPieceCount = 65536;
+
+
+public:
+
+    /// <summary>
+    /// Insert text and log it
+    /// </summary>
+    /// <param name="time"> When the edit was made, in seconds, for merging runs </param>
+    void Insert(TextBuffer& buffer, const std::size_t position, const std::string_view& text, const double time)
+    {
+        if(text.empty() == true)
+            return;
+
+        const std::size_t insertPosition = std::min(position, buffer.GetSize());
+
+        buffer.Insert(insertPosition, text);
+
+        _pieceScratch.clear();
+        buffer.GetPieces(insertPosition, text.size(), _pieceScratch);
+
+        // Typing right after the previous insertion, with its characters right after the previous ones in the add buffer, grows the same piece
+        if(Edit* last = GetCoalescable(EditType::Insert, time);
+           last != nullptr &&
+           insertPosition == last->Position + last->Length &&
+           _pieceScratch.size() == 1 &&
+           last->Pieces.back().InAddBuffer == true &&
+           last->Pieces.back().Start + last->Pieces.back().Length == _pieceScratch.front().Start)
+        {
+            last->Pieces.back().Length += text.size();
+            last->Length += text.size();
+            last->Time = time;
+
+            return;
+        };
+
+        Push(EditType::Insert, insertPosition, text.size(), time);
+    };
+
+    /// <summary>
+    /// Erase characters and log them
+    /// </summary>
+    void Erase(TextBuffer& buffer, const std::size_t position, const std::size_t count, const double time)
+    {
+        if(position >= buffer.GetSize() || count == 0)
+            return;
+
+        const std::size_t eraseCount = std::min(count, buffer.GetSize() - position);
+
+        _pieceScratch.clear();
+        buffer.GetPieces(position, eraseCount, _pieceScratch);
+
+        buffer.Erase(position, eraseCount);
+
+        if(Edit* last = GetCoalescable(EditType::Erase, time); last != nullptr)
+        {
+            // Backspacing, the erased characters come before the previous ones
+            if(position + eraseCount == last->Position)
+            {
+                last->Pieces.insert(last->Pieces.begin(), _pieceScratch.begin(), _pieceScratch.end());
+                last->Position = position;
+                last->Length += eraseCount;
+                last->Time = time;
+
+                _pieceCount += _pieceScratch.size();
+                Trim();
+
+                return;
+            };
+
+            // Deleting forwards, they come after
+            if(position == last->Position)
+            {
+                last->Pieces.insert(last->Pieces.end(), _pieceScratch.begin(), _pieceScratch.end());
+                last->Length += eraseCount;
+                last->Time = time;
+
+                _pieceCount += _pieceScratch.size();
+                Trim();
+
+                return;
+            };
+        };
+
+        Push(EditType::Erase, position, eraseCount, time);
+    };
+
+
+    /// <summary>
+    /// Revert the last applied edit
+    /// </summary>
+    /// <returns> False if there's nothing to undo </returns>
+    bool Undo(TextBuffer& buffer)
+    {
+        if(_appliedCount == 0)
+            return false;
+
+        const Edit& edit = _edits[--_appliedCount];
+
+        if(edit.Type == EditType::Insert)
+            buffer.Erase(edit.Position, edit.Length);
+        else
+            buffer.InsertPieces(edit.Position, edit.Pieces);
+
+        _coalescingBroken = true;
+
+        return true;
+    };
+
+    /// <summary>
+    /// Apply the last undone edit again
+    /// </summary>
+    /// <returns> False if there's nothing to redo </returns>
+    bool Redo(TextBuffer& buffer)
+    {
+        if(_appliedCount == _edits.size())
+            return false;
+
+        const Edit& edit = _edits[_appliedCount++];
+
+        if(edit.Type == EditType::Insert)
+            buffer.InsertPieces(edit.Position, edit.Pieces);
+        else
+            buffer.Erase(edit.Position, edit.Length);
+
+        _coalescingBroken = true;
+
+        return true;
+    };
+
+    /// <summary>
+    /// Start a new edit with the next one, e.g. before and after a paste, so it's undone on its own
+    /// </summary>
+    void BreakCoalescing()
+    {
+        _coalescingBroken = true;
+    };
+
+    void Clear()
+    {
+        _edits.clear();
+
+        _appliedCount = 0;
+        _pieceCount = 0;
+
+        _coalescingBroken = true;
+    };
+
+
+public:
+
+    bool CanUndo() const
+    {
+        return _appliedCount > 0;
+    };
+
+    bool CanRedo() const
+    {
+        return _appliedCount < _edits.size();
+    };
+
+    std::size_t GetEditCount() const
+    {
+        return _edits.size();
+    };
+
+    /// <summary>
+    /// The number of piece references the log keeps, what its memory grows with
+    /// </summary>
+    std::size_t GetPieceCount() const
+    {
+        return _pieceCount;
+    };
+
+
+private:
+
+    /// <summary>
+    /// The last edit, if the next one of a type may be merged into it
+    /// </summary>
+    Edit* GetCoalescable(const EditType type, const double time)
+    {
+        if(_coalescingBroken == true || _appliedCount == 0 || _appliedCount != _edits.size())
+            return nullptr;
+
+        Edit& last = _edits.back();
+
+        if(last.Type != type || time - last.Time > CoalesceInterval)
+            return nullptr;
+
+        return &last;
+    };
+
+    /// <summary>
+    /// Log an edit with the pieces in _pieceScratch, forgetting the undone ones
+    /// </summary>
+    void Push(const EditType type, const std::size_t position, const std::size_t length, const double time)
+    {
+        while(_edits.size() > _appliedCount)
+        {
+            _pieceCount -= _edits.back().Pieces.size();
+            _edits.pop_back();
+        };
+
+        _edits.push_back(Edit
+        {
+            .Type = type,
+            .Position = position,
+            .Length = length,
+            .Pieces = _pieceScratch,
+            .Time = time,
+        });
+
+        ++_appliedCount;
+        _pieceCount += _pieceScratch.size();
+
+        _coalescingBroken = false;
+
+        Trim();
+    };
+
+    /// <summary>
+    /// Forget the oldest edits until the log is within its bounds, the last one is always kept
+    /// </summary>
+    void Trim()
+    {
+        while(_edits.size() > 1 && (_edits.size() > MaxEditCount || _pieceCount > MaxPieceCount))
+        {
+            _pieceCount -= _edits.front().Pieces.size();
+            _edits.pop_front();
+
+            if(_appliedCount > 0)
+                --_appliedCount;
+        };
+    };
+
+};
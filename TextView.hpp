@@ -0,0 +1,815 @@
+#pragma once
+
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "FontSprite.hpp"
+#include "MappedDocument.hpp"
+#include "ParagraphLayoutCache.hpp"
+#include "TextSearch.hpp"
+
+
+/// <summary>
+/// A scrollable view over a document of any size.
+/// Only the visible lines, plus a prefetch margin, are ever handed to the FontSprite. Scrolling within that window, by fractions of a pixel too,
+/// and zooming only change the transform, the window's layout is kept until the window moves or the layout changes, see FontSprite::DrawRetained.
+/// If the font's layout wraps, the view keeps how many rows every line wraps into. A new width wraps the visible lines again right away
+/// and the rest a batch per draw, see RewrapBudget, with the row counts of paragraphs seen before coming from a ParagraphLayoutCache
+/// </summary>
+class TextView
+{
+
+private:
+
+    std::reference_wrapper<FontSprite> _fontSprite;
+
+    std::string _document;
+
+    /// <summary>
+    /// The offset of every line's first character in _document
+    /// </summary>
+    std::vector<std::size_t> _lineStarts = { 0 };
+
+    /// <summary>
+    /// A file shown instead of _document, see SetDocument
+    /// </summary>
+    const MappedDocument* _mappedDocument = nullptr;
+
+
+    /// <summary>
+    /// How far the view is scrolled down, in pixels of the document before the zoom. Moved by draws when lines above the view wrap into a different number of rows,
+    /// so the view stays on its text
+    /// </summary>
+    mutable float _scrollOffset = 0.0f;
+
+    float _viewportHeight = 0.0f;
+
+    /// <summary>
+    /// Pixels of the viewport per pixel of the document
+    /// </summary>
+    float _zoom = 1.0f;
+
+    /// <summary>
+    /// How many lines past each edge of the viewport are kept in the window
+    /// </summary>
+    std::size_t _prefetchLines = 0;
+
+
+    /// <summary>
+    /// The lines currently uploaded, [_windowFirstLine, _windowEndLine)
+    /// </summary>
+    mutable std::size_t _windowFirstLine = 0;
+    mutable std::size_t _windowEndLine = 0;
+
+    /// <summary>
+    /// The window's text, the FontSprite only re-uploads it when it changes. Either _windowText or part of the mapped document
+    /// </summary>
+    mutable std::string_view _window;
+
+    mutable std::string _windowText;
+
+    /// <summary>
+    /// (Mapped documents) The document's line count and indexed size when the window was taken.
+    /// A window that holds the last line is taken again once more of the file is indexed, the line may have grown
+    /// </summary>
+    mutable std::size_t _windowLineCount = 0;
+
+    mutable std::uint64_t _windowIndexedSize = 0;
+
+    /// <summary>
+    /// (Mapped documents) The window points into the mapping, which MappedDocument::Refresh replaces
+    /// </summary>
+    mutable std::uint64_t _windowMappingVersion = 0;
+
+    mutable bool _windowValid = false;
+
+    /// <summary>
+    /// The offset of the window's first character in the document
+    /// </summary>
+    mutable std::uint64_t _windowOffset = 0;
+
+
+    /// <summary>
+    /// Whose matches are highlighted, see SetSearch
+    /// </summary>
+    const TextSearch* _search = nullptr;
+
+    glm::vec4 _highlightColour = { 1.0f, 0.85f, 0.2f, 1.0f };
+
+    /// <summary>
+    /// The highlights of the matches in the window, built again when the window, the matches or the text colour change
+    /// </summary>
+    mutable std::vector<TextSpan> _windowHighlights;
+
+    mutable std::uint64_t _windowHighlightsVersion = 0;
+
+    mutable glm::vec4 _windowHighlightsColour = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    mutable bool _windowHighlightsValid = false;
+
+
+    /// <summary>
+    /// (Wrapping) How many rows each line wraps into
+    /// </summary>
+    mutable std::vector<std::uint32_t> _lineRows;
+
+    /// <summary>
+    /// (Wrapping) Each line's first row, followed by the number of rows of the whole document
+    /// </summary>
+    mutable std::vector<std::size_t> _lineFirstRows = { 0 };
+
+    /// <summary>
+    /// (Wrapping) Whether a line was wrapped with the current layout. Stale lines keep their previous row count until they're wrapped again
+    /// </summary>
+    mutable std::vector<bool> _lineRowsCurrent;
+
+    mutable std::size_t _staleLineCount = 0;
+
+    /// <summary>
+    /// (Wrapping) Where the next batch of stale lines is looked for
+    /// </summary>
+    mutable std::size_t _rewrapCursor = 0;
+
+    /// <summary>
+    /// (Wrapping) The layout and font the row counts are for
+    /// </summary>
+    mutable TextLayoutOptions _rowsLayout;
+
+    mutable TextMetricsFont _rowsFont;
+
+    /// <summary>
+    /// (Mapped documents) The indexed size when the row counts were last updated, the last line may have grown since
+    /// </summary>
+    mutable std::uint64_t _rowsIndexedSize = 0;
+
+    /// <summary>
+    /// (Mapped documents) The row counts a previous run wrapped the document into with the current layout, mapped from its sidecar.
+    /// Lines take them as they appear instead of being wrapped. Null if there are none
+    /// </summary>
+    mutable std::unique_ptr<DocumentLayoutCache> _cachedRows;
+
+    /// <summary>
+    /// (Mapped documents) Whether _cachedRows is still to be loaded for a new document
+    /// </summary>
+    mutable bool _cachedRowsPending = false;
+
+    mutable ParagraphLayoutCache _paragraphLayouts;
+
+
+public:
+
+    /// <summary>
+    /// Where the view's top-left corner is drawn
+    /// </summary>
+    glm::mat4 Transform = glm::mat4(1.0f);
+
+    /// <summary>
+    /// (Wrapping) How many lines outside the viewport a draw wraps again at most, after the width or the font changed.
+    /// The view is drawn correctly all along, only the scroll range is an estimate until IsRewrapping is false
+    /// </summary>
+    std::size_t RewrapBudget = 4096;
+
+
+public:
+
+    /// <param name="fontSprite"> The font the view draws with. If its layout wraps, lines are wrapped rows and scrolled by rows </param>
+    /// <param name="viewportHeight"> The view's visible height, in pixels </param>
+    /// <param name="prefetchLines"> How many lines beyond the viewport are uploaded, so small scrolls don't change the window </param>
+    TextView(FontSprite& fontSprite,
+             const float viewportHeight,
+             const std::size_t prefetchLines = 16) :
+        _fontSprite(fontSprite),
+        _viewportHeight(viewportHeight),
+        _prefetchLines(prefetchLines)
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// Replace the whole document
+    /// </summary>
+    void SetDocument(std::string document)
+    {
+        _document = std::move(document);
+        _mappedDocument = nullptr;
+
+        _lineStarts.assign(1, 0);
+        IndexLines(0);
+
+        ResetRows();
+
+        _windowValid = false;
+    };
+
+    /// <summary>
+    /// Show a memory-mapped file, e.g. a log too large to copy. Lines are read in place, and appear as the document indexes them.
+    /// The document must outlive the view, or be replaced first
+    /// </summary>
+    void SetDocument(const MappedDocument& document)
+    {
+        _document.clear();
+        _lineStarts.assign(1, 0);
+
+        _mappedDocument = &document;
+
+        ResetRows();
+
+        _windowValid = false;
+    };
+
+    /// <summary>
+    /// (Mapped documents) Keep the row counts the lines were wrapped into with the current layout in the document's sidecar,
+    /// so the next run showing the document at this width doesn't wrap every line again. See MappedDocument's useLayoutCache
+    /// </summary>
+    /// <returns> False if lines are still being wrapped, the document has no layout cache or the sidecar couldn't be written </returns>
+    bool SaveLayoutCache()
+    {
+        if(_mappedDocument == nullptr || IsWrapping() == false || _staleLineCount > 0 || _lineRows.empty() == true)
+            return false;
+
+        // The sidecar about to be replaced can't be while it's mapped, and every line is current anyway
+        _cachedRows.reset();
+
+        return _mappedDocument->SaveRowCounts(DocumentLayoutCache::GetWrapKey(_rowsLayout, _rowsFont), _lineRows);
+    };
+
+    /// <summary>
+    /// Highlight a search's matches. Highlights are drawn as span backgrounds, so the FontSprite's program needs FontShaderFeature::Styles.
+    /// The search must be over the view's document, and outlive the view or be replaced first
+    /// </summary>
+    /// <param name="search"> Null to stop highlighting </param>
+    void SetSearch(const TextSearch* search, const glm::vec4& highlightColour = { 1.0f, 0.85f, 0.2f, 1.0f })
+    {
+        _search = search;
+        _highlightColour = highlightColour;
+
+        _windowHighlightsValid = false;
+    };
+
+    /// <summary>
+    /// Append text to the end of the document, only the appended text is indexed
+    /// </summary>
+    void Append(const std::string_view& text)
+    {
+        wt::Assert(_mappedDocument == nullptr, "Mapped documents are read-only");
+
+        const std::size_t previousSize = _document.size();
+        const std::size_t previousLineCount = GetLineCount();
+
+        _document.append(text);
+
+        IndexLines(previousSize);
+
+        // The previous last line may have grown, lines after it are new
+        MarkLineStale(previousLineCount - 1);
+
+        // Only a window containing the previous last line can see the new text
+        if(_windowEndLine >= previousLineCount)
+            _windowValid = false;
+    };
+
+
+    /// <summary>
+    /// Scroll to an absolute offset, in pixels of the document from its top, fractions included
+    /// </summary>
+    void ScrollTo(const float scrollOffset)
+    {
+        if(IsWrapping() == true)
+            UpdateRows();
+
+        const float maximumScrollOffset = std::max(static_cast<float>(GetRowCount()) * _fontSprite.get().GetLineHeight() - GetVisibleHeight(), 0.0f);
+
+        _scrollOffset = std::clamp(scrollOffset, 0.0f, maximumScrollOffset);
+    };
+
+    void ScrollBy(const float delta)
+    {
+        ScrollTo(_scrollOffset + delta);
+    };
+
+    /// <summary>
+    /// Scroll so a line is at the top of the view
+    /// </summary>
+    void ScrollToLine(const std::size_t line)
+    {
+        if(IsWrapping() == true)
+        {
+            UpdateRows();
+
+            // Its rows have to be known to be scrolled to exactly
+            WrapLines(0, std::min(line + 1, _lineRows.size()));
+        };
+
+        ScrollTo(static_cast<float>(GetFirstRow(line)) * _fontSprite.get().GetLineHeight());
+    };
+
+
+    /// <summary>
+    /// Scale the view, keeping the part of the document at anchorY, in pixels from the view's top, where it is.
+    /// Glyphs are scaled by the transform, distance field atlases stay sharp at any zoom, see FontSpriteDistanceFieldFragmentShader.glsl
+    /// </summary>
+    void SetZoom(const float zoom, const float anchorY = 0.0f)
+    {
+        wt::Assert(zoom > 0.0f, "The zoom has to be positive");
+
+        const float anchorOffset = _scrollOffset + (anchorY / _zoom);
+
+        _zoom = zoom;
+
+        ScrollTo(anchorOffset - (anchorY / _zoom));
+    };
+
+
+    void SetViewportHeight(const float viewportHeight)
+    {
+        _viewportHeight = viewportHeight;
+
+        ScrollTo(_scrollOffset);
+    };
+
+    /// <summary>
+    /// Change the prefetch margin, it applies the next time the window moves so nothing is uploaded for it now
+    /// </summary>
+    void SetPrefetchLines(const std::size_t prefetchLines)
+    {
+        _prefetchLines = prefetchLines;
+    };
+
+
+    /// <summary>
+    /// Draw the visible part of the document. The cost doesn't depend on the document's size
+    /// </summary>
+    void Draw(const glm::vec4& textColour = { 0.0f, 0.0f, 0.0f, 1.0f }) const
+    {
+        FontSprite& fontSprite = _fontSprite.get();
+
+        const float lineHeight = fontSprite.GetLineHeight();
+
+        const std::size_t lineCount = GetLineCount();
+
+        std::size_t firstVisibleLine = 0;
+        std::size_t endVisibleLine = 0;
+
+        const auto findVisibleLines = [&]()
+        {
+            const std::size_t firstVisibleRow = static_cast<std::size_t>(_scrollOffset / lineHeight);
+            const std::size_t endVisibleRow = static_cast<std::size_t>(std::ceil((_scrollOffset + GetVisibleHeight()) / lineHeight)) + 1;
+
+            firstVisibleLine = std::min(GetLineAtRow(firstVisibleRow), lineCount - 1);
+            endVisibleLine = std::min(GetLineAtRow(endVisibleRow - 1) + 1, lineCount);
+        };
+
+        if(IsWrapping() == true)
+        {
+            UpdateRows();
+
+            // The visible lines are wrapped right away. That can change which lines are visible, rows above the view move it
+            for(std::uint32_t attempt = 0; attempt < 4; ++attempt)
+            {
+                findVisibleLines();
+
+                if(WrapLines(firstVisibleLine, endVisibleLine) == false)
+                    break;
+            };
+
+            // The rest a batch per draw
+            if(_staleLineCount > 0)
+                RewrapStaleLines(firstVisibleLine);
+        };
+
+        findVisibleLines();
+
+        // The window's last line may have grown since the window was taken
+        if(_mappedDocument != nullptr && _windowEndLine == _windowLineCount && _mappedDocument->GetIndexedSize() != _windowIndexedSize)
+            _windowValid = false;
+
+        if(_mappedDocument != nullptr && _mappedDocument->GetMappingVersion() != _windowMappingVersion)
+            _windowValid = false;
+
+        // Move the window only once the viewport leaves it
+        if(_windowValid == false || firstVisibleLine < _windowFirstLine || endVisibleLine > _windowEndLine)
+        {
+            const std::size_t windowFirstLine = firstVisibleLine - std::min(firstVisibleLine, _prefetchLines);
+            const std::size_t windowEndLine = std::min(endVisibleLine + _prefetchLines, lineCount);
+
+            UpdateWindow(windowFirstLine, windowEndLine);
+        };
+
+
+        // Scrolling and zooming within the window are only a transform
+        const float windowOffset = static_cast<float>(GetFirstRow(_windowFirstLine)) * lineHeight - _scrollOffset;
+
+        fontSprite.Transform = Transform * glm::scale(glm::mat4(1.0f), { _zoom, _zoom, 1.0f }) * glm::translate(glm::mat4(1.0f), { 0.0f, windowOffset, 0.0f });
+
+        if(_search != nullptr && UpdateHighlights(textColour) == true)
+            fontSprite.DrawStyled(_window, _windowHighlights, textColour);
+        else
+            fontSprite.DrawRetained(_window, textColour);
+    };
+
+
+public:
+
+    std::size_t GetLineCount() const
+    {
+        if(_mappedDocument != nullptr)
+            return _mappedDocument->GetLineCount();
+
+        return _lineStarts.size();
+    };
+
+    /// <summary>
+    /// The number of rows the document takes up, its line count if the layout doesn't wrap. An estimate while IsRewrapping
+    /// </summary>
+    std::size_t GetRowCount() const
+    {
+        return IsWrapping() == true ? _lineFirstRows.back() : GetLineCount();
+    };
+
+    /// <summary>
+    /// Whether lines outside the view still have to be wrapped with the current width. Draw again until they are
+    /// </summary>
+    bool IsRewrapping() const
+    {
+        return IsWrapping() == true && _staleLineCount > 0;
+    };
+
+    std::size_t GetPrefetchLines() const
+    {
+        return _prefetchLines;
+    };
+
+    float GetScrollOffset() const
+    {
+        return _scrollOffset;
+    };
+
+    float GetZoom() const
+    {
+        return _zoom;
+    };
+
+    const std::string& GetDocument() const
+    {
+        return _document;
+    };
+
+
+private:
+
+    /// <summary>
+    /// Add the lines starting after an offset to the line index
+    /// </summary>
+    void IndexLines(const std::size_t offset)
+    {
+        std::size_t newline = _document.find('\n', offset);
+
+        while(newline != std::string::npos)
+        {
+            _lineStarts.emplace_back(newline + 1);
+
+            newline = _document.find('\n', newline + 1);
+        };
+    };
+
+
+    /// <summary>
+    /// A line's text without its '\n'
+    /// </summary>
+    std::string_view GetLineText(const std::size_t line) const
+    {
+        if(_mappedDocument != nullptr)
+            return _mappedDocument->GetLines(line, line + 1);
+
+        const std::size_t lineEnd = line + 1 < _lineStarts.size() ? _lineStarts[line + 1] - 1 : _document.size();
+
+        return std::string_view(_document).substr(_lineStarts[line], lineEnd - _lineStarts[line]);
+    };
+
+
+    /// <summary>
+    /// The viewport's height in pixels of the document
+    /// </summary>
+    float GetVisibleHeight() const
+    {
+        return _viewportHeight / _zoom;
+    };
+
+    bool IsWrapping() const
+    {
+        const FontSprite& fontSprite = _fontSprite.get();
+
+        // Advances aren't known before the atlas is in
+        return fontSprite.Layout.WrapWidth > 0.0f && fontSprite.IsReady() == true;
+    };
+
+    std::size_t GetFirstRow(const std::size_t line) const
+    {
+        if(IsWrapping() == false)
+            return line;
+
+        return _lineFirstRows[std::min(line, _lineFirstRows.size() - 1)];
+    };
+
+    /// <summary>
+    /// The line a row belongs to, the last line for rows past the end
+    /// </summary>
+    std::size_t GetLineAtRow(const std::size_t row) const
+    {
+        if(IsWrapping() == false)
+            return row;
+
+        const auto line = std::upper_bound(_lineFirstRows.cbegin(), _lineFirstRows.cend() - 1, row);
+
+        return static_cast<std::size_t>(std::max<std::ptrdiff_t>(line - _lineFirstRows.cbegin() - 1, 0));
+    };
+
+
+    void ResetRows()
+    {
+        _lineRows.clear();
+        _lineRowsCurrent.clear();
+        _lineFirstRows.assign(1, 0);
+
+        _staleLineCount = 0;
+        _rewrapCursor = 0;
+        _rowsIndexedSize = 0;
+
+        _cachedRows.reset();
+        _cachedRowsPending = _mappedDocument != nullptr && _mappedDocument->UsesLayoutCache() == true;
+    };
+
+    void MarkLineStale(const std::size_t line) const
+    {
+        if(line >= _lineRowsCurrent.size() || _lineRowsCurrent[line] == false)
+            return;
+
+        _lineRowsCurrent[line] = false;
+        ++_staleLineCount;
+    };
+
+    /// <summary>
+    /// Follow the document's lines and the font's layout. New lines count as a single row until they're wrapped,
+    /// after a change of layout every line keeps its rows until it's wrapped again
+    /// </summary>
+    void UpdateRows() const
+    {
+        const FontSprite& fontSprite = _fontSprite.get();
+
+        const TextMetricsFont font = fontSprite.GetTextMetricsFont();
+
+        if(fontSprite.Layout != _rowsLayout || font != _rowsFont || _cachedRowsPending == true)
+        {
+            _rowsLayout = fontSprite.Layout;
+            _rowsFont = font;
+
+            _lineRowsCurrent.assign(_lineRowsCurrent.size(), false);
+            _staleLineCount = _lineRowsCurrent.size();
+
+            _cachedRows.reset();
+            _cachedRowsPending = false;
+
+            if(_mappedDocument != nullptr && IsWrapping() == true)
+                _cachedRows = _mappedDocument->LoadRowCounts(DocumentLayoutCache::GetWrapKey(_rowsLayout, _rowsFont));
+
+            if(ApplyCachedRows(0, _lineRows.size()) == true)
+                RebuildFirstRows();
+        };
+
+        // The last line of a mapped document grows as the file is indexed
+        if(_mappedDocument != nullptr && _mappedDocument->GetIndexedSize() != _rowsIndexedSize)
+        {
+            _rowsIndexedSize = _mappedDocument->GetIndexedSize();
+
+            if(_lineRowsCurrent.empty() == false)
+                MarkLineStale(_lineRowsCurrent.size() - 1);
+        };
+
+        const std::size_t lineCount = GetLineCount();
+
+        if(lineCount != _lineRows.size())
+        {
+            _staleLineCount += lineCount - _lineRows.size();
+
+            const std::size_t previousLineCount = _lineRows.size();
+
+            _lineRows.resize(lineCount, 1);
+            _lineRowsCurrent.resize(lineCount, false);
+
+            ApplyCachedRows(previousLineCount, lineCount);
+
+            RebuildFirstRows();
+        };
+    };
+
+    /// <summary>
+    /// Take the cached row counts of a range of stale lines, except the last cached line's, which may have grown since
+    /// </summary>
+    /// <returns> True if any line took them </returns>
+    bool ApplyCachedRows(const std::size_t firstLine, const std::size_t endLine) const
+    {
+        if(_cachedRows == nullptr)
+            return false;
+
+        const std::span<const std::uint32_t> cachedRows = _cachedRows->GetRowCounts();
+
+        const std::size_t endCachedLine = std::min(endLine, cachedRows.empty() == false ? cachedRows.size() - 1 : 0);
+
+        bool applied = false;
+
+        for(std::size_t line = firstLine; line < endCachedLine; ++line)
+        {
+            if(_lineRowsCurrent[line] == true)
+                continue;
+
+            _lineRows[line] = cachedRows[line];
+            _lineRowsCurrent[line] = true;
+            --_staleLineCount;
+
+            applied = true;
+        };
+
+        return applied;
+    };
+
+    void RebuildFirstRows() const
+    {
+        _lineFirstRows.resize(_lineRows.size() + 1);
+
+        std::size_t row = 0;
+
+        for(std::size_t line = 0; line < _lineRows.size(); ++line)
+        {
+            _lineFirstRows[line] = row;
+
+            row += _lineRows[line];
+        };
+
+        _lineFirstRows.back() = row;
+    };
+
+    /// <summary>
+    /// Wrap a line with the current layout, if it's stale
+    /// </summary>
+    /// <returns> How many rows the line gained </returns>
+    std::int64_t WrapLine(const std::size_t line) const
+    {
+        if(_lineRowsCurrent[line] == true)
+            return 0;
+
+        const FontSprite& fontSprite = _fontSprite.get();
+
+        const std::uint32_t rows = _paragraphLayouts.GetRowCount(GetLineText(line), _rowsLayout, _rowsFont, [&](const char32_t first, const char32_t second)
+        {
+            return fontSprite.GetKerning(first, second);
+        });
+
+        const std::int64_t gained = static_cast<std::int64_t>(rows) - static_cast<std::int64_t>(_lineRows[line]);
+
+        _lineRows[line] = rows;
+        _lineRowsCurrent[line] = true;
+        --_staleLineCount;
+
+        return gained;
+    };
+
+    /// <summary>
+    /// Wrap the stale lines of a range
+    /// </summary>
+    /// <returns> True if any line's row count changed </returns>
+    bool WrapLines(const std::size_t firstLine, const std::size_t endLine) const
+    {
+        bool changed = false;
+
+        for(std::size_t line = firstLine; line < endLine; ++line)
+        {
+            if(WrapLine(line) != 0)
+                changed = true;
+        };
+
+        if(changed == true)
+            RebuildFirstRows();
+
+        return changed;
+    };
+
+    /// <summary>
+    /// Wrap up to RewrapBudget stale lines, continuing from where the previous batch stopped.
+    /// Rows gained or lost above the view move the scroll offset with them
+    /// </summary>
+    void RewrapStaleLines(const std::size_t firstVisibleLine) const
+    {
+        std::int64_t rowsGainedAbove = 0;
+
+        bool changed = false;
+
+        std::size_t budget = RewrapBudget;
+
+        // A stale line is found within one pass over the lines
+        for(std::size_t visited = 0; visited < _lineRows.size() && _staleLineCount > 0 && budget > 0; ++visited)
+        {
+            if(_rewrapCursor >= _lineRows.size())
+                _rewrapCursor = 0;
+
+            const std::size_t line = _rewrapCursor++;
+
+            if(_lineRowsCurrent[line] == true)
+                continue;
+
+            --budget;
+
+            const std::int64_t gained = WrapLine(line);
+
+            if(gained == 0)
+                continue;
+
+            changed = true;
+
+            if(line < firstVisibleLine)
+                rowsGainedAbove += gained;
+        };
+
+        if(changed == false)
+            return;
+
+        RebuildFirstRows();
+
+        const float lineHeight = _fontSprite.get().GetLineHeight();
+
+        const float maximumScrollOffset = std::max(static_cast<float>(_lineFirstRows.back()) * lineHeight - GetVisibleHeight(), 0.0f);
+
+        _scrollOffset = std::clamp(_scrollOffset + static_cast<float>(rowsGainedAbove) * lineHeight, 0.0f, maximumScrollOffset);
+    };
+
+
+    /// <summary>
+    /// Take a range of lines as the window
+    /// </summary>
+    void UpdateWindow(const std::size_t firstLine, const std::size_t endLine) const
+    {
+        _windowFirstLine = firstLine;
+        _windowEndLine = endLine;
+
+        _windowValid = true;
+        _windowHighlightsValid = false;
+
+        // Mapped documents are drawn straight from the mapping
+        if(_mappedDocument != nullptr)
+        {
+            // Taken before the lines, a chunk indexed in between only takes the window again on the next draw
+            _windowIndexedSize = _mappedDocument->GetIndexedSize();
+            _windowLineCount = _mappedDocument->GetLineCount();
+            _windowMappingVersion = _mappedDocument->GetMappingVersion();
+
+            _window = _mappedDocument->GetLines(firstLine, std::min(endLine, _windowLineCount));
+            _windowOffset = _window.empty() == false ? static_cast<std::uint64_t>(_window.data() - _mappedDocument->GetText().data()) : 0;
+            return;
+        };
+
+
+        const std::size_t windowStart = _lineStarts[firstLine];
+
+        // The last line's trailing newline is left out
+        const std::size_t windowEnd = endLine < GetLineCount() ? _lineStarts[endLine] - 1 : _document.size();
+
+        _windowText.assign(_document, windowStart, windowEnd - windowStart);
+
+        _window = _windowText;
+        _windowOffset = windowStart;
+    };
+
+    /// <summary>
+    /// Build the window's highlights if they're out of date
+    /// </summary>
+    /// <returns> True if any of the window's characters are highlighted </returns>
+    bool UpdateHighlights(const glm::vec4& textColour) const
+    {
+        if(_windowHighlightsValid == false || _search->GetVersion() != _windowHighlightsVersion || textColour != _windowHighlightsColour)
+        {
+            _windowHighlights.clear();
+
+            _search->AddHighlightSpans(_windowOffset, _windowOffset + _window.size(), _highlightColour, textColour, _windowHighlights);
+
+            _windowHighlightsVersion = _search->GetVersion();
+            _windowHighlightsColour = textColour;
+            _windowHighlightsValid = true;
+        };
+
+        return _windowHighlights.empty() == false;
+    };
+
+};
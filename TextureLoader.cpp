@@ -0,0 +1,3 @@
+// stb_image is header-only, its implementation is compiled once, here
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <stb_image.h>
+
+#include "MappedFile.hpp"
+#include "PixelConversion.hpp"
+#include "ProfileZones.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// A decoded image, ready to be uploaded as-is.
+/// Rows are stored top to bottom, flipping is left to the texture coordinates
+/// </summary>
+struct TextureImage
+{
+    std::uint32_t Width = 0;
+    std::uint32_t Height = 0;
+
+    /// <summary>
+    /// The client-side pixel format, GL_RGBA or GL_BGRA. Always 8 bits per channel, 4 channels
+    /// </summary>
+    GLenum PixelFormat = GL_RGBA;
+
+    /// <summary>
+    /// Width * Height * 4 bytes of pixel data
+    /// </summary>
+    std::span<const std::byte> Pixels;
+
+    /// <summary>
+    /// Keeps Pixels alive, either a decoded buffer or the mapped file itself
+    /// </summary>
+    std::shared_ptr<const void> PixelStorage;
+
+
+    bool IsValid() const
+    {
+        return Pixels.empty() == false;
+    };
+};
+
+
+/// <summary>
+/// Decodes an image file into a TextureImage
+/// </summary>
+class ITextureLoader
+{
+
+public:
+
+    virtual ~ITextureLoader() = default;
+
+
+public:
+
+    /// <summary>
+    /// Decode an image file that's already mapped, e.g. read ahead on an I/O thread. The image may keep the file alive
+    /// </summary>
+    /// <param name="path"> The file's path, for error messages </param>
+    virtual TextureImage Load(const std::shared_ptr<const MappedFile>& file, const std::filesystem::path& path) const = 0;
+
+    TextureImage Load(const std::filesystem::path& path) const
+    {
+        return Load(std::make_shared<const MappedFile>(path), path);
+    };
+
+};
+
+
+/// <summary>
+/// Decodes the common image formats (BMP, PNG, TGA, JPEG...) through stb_image
+/// </summary>
+class STBITextureLoader : public ITextureLoader
+{
+
+private:
+
+    bool _premultiplyAlpha = false;
+
+
+public:
+
+    STBITextureLoader(const bool premultiplyAlpha = false) :
+        _premultiplyAlpha(premultiplyAlpha)
+    {
+    };
+
+
+public:
+
+    using ITextureLoader::Load;
+
+    TextureImage Load(const std::shared_ptr<const MappedFile>& file, const std::filesystem::path& path) const override
+    {
+        TEXT_RENDERER_ZONE("Texture load");
+
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+
+        // Always decode to 4 channels so every texture shares the same upload path
+        stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file->GetBytes().data()),
+                                                static_cast<int>(file->GetSizeInBytes()),
+                                                &width, &height, &channels,
+                                                4);
+
+        wt::Assert(pixels != nullptr, [&]()
+        {
+            return std::string("Unable to decode the image \"").append(path.string()).append("\": ").append(stbi_failure_reason());
+        });
+
+        if(pixels == nullptr)
+            return TextureImage();
+
+
+        const std::size_t sizeInBytes = static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4;
+
+        // The decoded buffer is ours, so it's converted in place
+        if(_premultiplyAlpha == true)
+        {
+            const std::size_t stride = static_cast<std::size_t>(width) * 4;
+
+            ConvertPixels(reinterpret_cast<const std::byte*>(pixels), stride,
+                          reinterpret_cast<std::byte*>(pixels), stride,
+                          static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height),
+                          PixelConversion::PremultiplyAlpha);
+        };
+
+        return TextureImage
+        {
+            .Width = static_cast<std::uint32_t>(width),
+            .Height = static_cast<std::uint32_t>(height),
+            .PixelFormat = GL_RGBA,
+            .Pixels = std::span<const std::byte>(reinterpret_cast<const std::byte*>(pixels), sizeInBytes),
+            .PixelStorage = std::shared_ptr<const void>(pixels, [](const void* pixels)
+            {
+                stbi_image_free(const_cast<void*>(pixels));
+            }),
+        };
+    };
+
+};
+
+
+/// <summary>
+/// Loads pre-converted ".rawtex" images, which are uploaded straight out of the mapped file without any decoding.
+/// The file is a RawTextureHeader followed by top-to-bottom rows of BGRA8 pixels
+/// </summary>
+class RawTextureLoader : public ITextureLoader
+{
+
+public:
+
+    static constexpr std::uint32_t Magic = 0x58455452; // "RTEX"
+
+    struct RawTextureHeader
+    {
+        std::uint32_t Magic;
+        std::uint32_t Width;
+        std::uint32_t Height;
+        std::uint32_t Reserved;
+    };
+
+
+public:
+
+    using ITextureLoader::Load;
+
+    TextureImage Load(const std::shared_ptr<const MappedFile>& file, const std::filesystem::path& path) const override
+    {
+        TEXT_RENDERER_ZONE("Texture load");
+
+        RawTextureHeader header {};
+
+        if(file->GetSizeInBytes() >= sizeof(RawTextureHeader))
+            std::memcpy(&header, file->GetBytes().data(), sizeof(RawTextureHeader));
+
+        const std::size_t sizeInBytes = static_cast<std::size_t>(header.Width) * static_cast<std::size_t>(header.Height) * 4;
+
+        const bool valid = header.Magic == Magic &&
+                           file->GetSizeInBytes() >= sizeof(RawTextureHeader) + sizeInBytes;
+
+        wt::Assert(valid, [&]()
+        {
+            return std::string("\"").append(path.string()).append("\" is not a valid raw texture");
+        });
+
+        if(valid == false)
+            return TextureImage();
+
+
+        return TextureImage
+        {
+            .Width = header.Width,
+            .Height = header.Height,
+            .PixelFormat = GL_BGRA,
+            .Pixels = file->GetBytes().subspan(sizeof(RawTextureHeader), sizeInBytes),
+            .PixelStorage = file,
+        };
+    };
+
+};
+
+
+/// <summary>
+/// Picks a loader by the file's extension
+/// </summary>
+/// <param name="path"></param>
+/// <returns></returns>
+inline const ITextureLoader& GetTextureLoader(const std::filesystem::path& path)
+{
+    static const STBITextureLoader stbiTextureLoader;
+    static const RawTextureLoader rawTextureLoader;
+
+    if(path.extension() == ".rawtex")
+        return rawTextureLoader;
+
+    return stbiTextureLoader;
+};
@@ -0,0 +1,616 @@
+#pragma once
+
+#include <Windows.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// How a typing workload's text reaches the window
+/// </summary>
+enum class TypingInputType
+{
+    /// <summary>
+    /// One keystroke per character, every keystroke is a sample
+    /// </summary>
+    Keystrokes,
+
+    /// <summary>
+    /// The whole text through the clipboard and Ctrl+V, every paste is a sample
+    /// </summary>
+    Paste,
+};
+
+
+/// <summary>
+/// Input replayed into the window by a TypingLatencyBenchmark
+/// </summary>
+struct TypingWorkload
+{
+    std::string Name;
+
+    TypingInputType Type = TypingInputType::Keystrokes;
+
+    /// <summary>
+    /// Printable ASCII only, so every character that's injected adds exactly one character to the document
+    /// </summary>
+    std::string Text;
+
+    std::uint32_t Repetitions = 1;
+
+    /// <summary>
+    /// The pause after every injection, long enough for its frame to be presented before the next one arrives
+    /// </summary>
+    double IntervalSeconds = 0.05;
+};
+
+
+/// <summary>
+/// The keystroke-to-present latencies of a workload, in milliseconds
+/// </summary>
+struct TypingLatencyResult
+{
+    std::string Name;
+
+    std::size_t SampleCount = 0;
+
+    /// <summary>
+    /// Injections that never showed up in a presented frame, e.g. because the window lost focus
+    /// </summary>
+    std::size_t MissedCount = 0;
+
+    /// <summary>
+    /// From the injection until the frame that shows it was swapped
+    /// </summary>
+    double PresentP50 = 0.0;
+    double PresentP95 = 0.0;
+    double PresentP99 = 0.0;
+    double PresentMaximum = 0.0;
+
+    /// <summary>
+    /// From the injection until the GPU finished drawing the frame that shows it, from a GL_TIMESTAMP query
+    /// </summary>
+    double GPUDoneP50 = 0.0;
+    double GPUDoneP95 = 0.0;
+    double GPUDoneP99 = 0.0;
+    double GPUDoneMaximum = 0.0;
+};
+
+
+/// <summary>
+/// A sentence typed at about 120 words per minute, and pastes from a line to a large file
+/// </summary>
+inline std::vector<TypingWorkload> GetDefaultTypingWorkloads()
+{
+    const std::string sentence = "The quick brown fox jumps over the lazy dog. ";
+
+    std::string line = std::string(80, 'x');
+
+    std::string page;
+
+    while(page.size() < 4 * 1024)
+    {
+        page += sentence;
+    };
+
+    std::string file;
+
+    while(file.size() < 256 * 1024)
+    {
+        file += page;
+    };
+
+    return
+    {
+        { .Name = "Typing",         .Type = TypingInputType::Keystrokes, .Text = sentence,          .Repetitions = 4,  .IntervalSeconds = 0.1 },
+        { .Name = "Paste 80 chars", .Type = TypingInputType::Paste,      .Text = std::move(line),   .Repetitions = 20, .IntervalSeconds = 0.1 },
+        { .Name = "Paste 4KB",      .Type = TypingInputType::Paste,      .Text = std::move(page),   .Repetitions = 20, .IntervalSeconds = 0.15 },
+        { .Name = "Paste 256KB",    .Type = TypingInputType::Paste,      .Text = std::move(file),   .Repetitions = 10, .IntervalSeconds = 0.3 },
+    };
+};
+
+
+/// <summary>
+/// Measures keystroke-to-present latency the way a user sees it: keystrokes and pastes are injected with SendInput into the focused window,
+/// so they take the same path as real input, and each is matched to the first presented frame whose document contains it.
+/// Matching is by document size, which only works for workloads that append, see TypingWorkload::Text.
+/// The injection runs on a thread of its own, the render thread reports its frames with FramePresented and Update
+/// </summary>
+class TypingLatencyBenchmark
+{
+
+private:
+
+    /// <summary>
+    /// An injected keystroke or paste, waiting for the frame that shows it
+    /// </summary>
+    struct Injection
+    {
+        std::size_t Workload = 0;
+
+        double InjectionTime = 0.0;
+
+        /// <summary>
+        /// The document's size once the injection arrived
+        /// </summary>
+        std::size_t DocumentSize = 0;
+    };
+
+    /// <summary>
+    /// (Render thread) A presented frame whose GPU timestamp hasn't been read yet
+    /// </summary>
+    struct PendingFrame
+    {
+        std::uint32_t Query = 0;
+
+        /// <summary>
+        /// Converts GPU timestamps to glfwGetTime seconds, measured as the frame was presented
+        /// </summary>
+        double GPUTimeOffset = 0.0;
+
+        std::vector<Injection> Injections;
+    };
+
+
+    std::vector<TypingWorkload> _workloads;
+
+    GLFWwindow* _window = nullptr;
+
+    std::thread _injector;
+
+    std::mutex _lock;
+
+    /// <summary>
+    /// Injected but not presented yet, in injection order
+    /// </summary>
+    std::deque<Injection> _pendingInjections;
+
+    /// <summary>
+    /// Presented, but waiting for the frame's GPU timestamp
+    /// </summary>
+    std::size_t _pendingGPUSampleCount = 0;
+
+    /// <summary>
+    /// Per workload
+    /// </summary>
+    std::vector<std::vector<double>> _presentLatencies;
+    std::vector<std::vector<double>> _gpuDoneLatencies;
+
+    std::vector<std::size_t> _missedCounts;
+
+    /// <summary>
+    /// The size of the document in the last presented frame, unknown until the first one
+    /// </summary>
+    std::atomic<std::int64_t> _presentedDocumentSize = -1;
+
+    std::atomic<bool> _finished = false;
+
+
+    // Render thread
+
+    std::deque<PendingFrame> _pendingFrames;
+
+    std::vector<std::uint32_t> _freeQueries;
+
+    std::vector<std::uint32_t> _queries;
+
+
+public:
+
+    /// <summary>
+    /// How long injections that weren't presented yet are waited for once the last one is sent
+    /// </summary>
+    static constexpr double DrainTimeoutSeconds = 2.0;
+
+
+public:
+
+    explicit TypingLatencyBenchmark(std::vector<TypingWorkload> workloads = GetDefaultTypingWorkloads()) :
+        _workloads(std::move(workloads)),
+        _presentLatencies(_workloads.size()),
+        _gpuDoneLatencies(_workloads.size()),
+        _missedCounts(_workloads.size())
+    {
+    };
+
+    TypingLatencyBenchmark(const TypingLatencyBenchmark&) = delete;
+    TypingLatencyBenchmark& operator = (const TypingLatencyBenchmark&) = delete;
+
+    ~TypingLatencyBenchmark()
+    {
+        if(_injector.joinable() == true)
+            _injector.join();
+    };
+
+
+public:
+
+    /// <summary>
+    /// (Main thread) Start injecting into a window, once it has presented its first frame.
+    /// The window is focused, since SendInput goes to whichever window has focus, and asked to close after the last workload
+    /// </summary>
+    void Start(GLFWwindow* window)
+    {
+        _window = window;
+
+        glfwFocusWindow(window);
+
+        _injector = std::thread([this]()
+        {
+            Inject();
+        });
+    };
+
+    /// <summary>
+    /// Whether every workload was injected and drained, and the results are final
+    /// </summary>
+    bool IsFinished() const
+    {
+        return _finished.load(std::memory_order_acquire);
+    };
+
+
+    /// <summary>
+    /// (Render thread) Report a frame right after it was presented
+    /// </summary>
+    /// <param name="documentSize"> The number of characters the frame showed </param>
+    void FramePresented(const std::size_t documentSize)
+    {
+        const double presentTime = glfwGetTime();
+
+        PendingFrame frame;
+
+        {
+            const std::lock_guard lock = std::lock_guard(_lock);
+
+            while(_pendingInjections.empty() == false && _pendingInjections.front().DocumentSize <= documentSize)
+            {
+                const Injection& injection = _pendingInjections.front();
+
+                _presentLatencies[injection.Workload].push_back((presentTime - injection.InjectionTime) * 1000.0);
+
+                frame.Injections.push_back(injection);
+
+                _pendingInjections.pop_front();
+            };
+
+            _pendingGPUSampleCount += frame.Injections.size();
+        };
+
+        _presentedDocumentSize.store(static_cast<std::int64_t>(documentSize), std::memory_order_release);
+
+
+        if(frame.Injections.empty() == false)
+        {
+            frame.Query = AcquireQuery();
+
+            glQueryCounter(frame.Query, GL_TIMESTAMP);
+
+            // The GPU's clock right now, against the CPU's. Both clocks run at a fixed rate, so the offset holds for the frame's timestamp
+            GLint64 gpuTime = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+
+            frame.GPUTimeOffset = glfwGetTime() - static_cast<double>(gpuTime) * 1e-9;
+
+            _pendingFrames.push_back(std::move(frame));
+        };
+
+        Update();
+    };
+
+    /// <summary>
+    /// (Render thread) Read the timestamps of earlier frames that are ready. Call every iteration of the loop,
+    /// so the last frames are resolved even when nothing is drawn after them
+    /// </summary>
+    void Update()
+    {
+        while(_pendingFrames.empty() == false)
+        {
+            PendingFrame& frame = _pendingFrames.front();
+
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(frame.Query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+            if(available == GL_FALSE)
+                return;
+
+            GLuint64 timestamp = 0;
+            glGetQueryObjectui64v(frame.Query, GL_QUERY_RESULT, &timestamp);
+
+            const double gpuDoneTime = static_cast<double>(timestamp) * 1e-9 + frame.GPUTimeOffset;
+
+            {
+                const std::lock_guard lock = std::lock_guard(_lock);
+
+                for(const Injection& injection : frame.Injections)
+                {
+                    _gpuDoneLatencies[injection.Workload].push_back((gpuDoneTime - injection.InjectionTime) * 1000.0);
+                };
+
+                _pendingGPUSampleCount -= frame.Injections.size();
+            };
+
+            _freeQueries.push_back(frame.Query);
+
+            _pendingFrames.pop_front();
+        };
+    };
+
+    /// <summary>
+    /// (Render thread) Delete the queries, before the context goes away
+    /// </summary>
+    void EndRendering()
+    {
+        if(_queries.empty() == false)
+            glDeleteQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+
+        _queries.clear();
+        _freeQueries.clear();
+        _pendingFrames.clear();
+    };
+
+
+    /// <summary>
+    /// The latencies measured so far, final once IsFinished
+    /// </summary>
+    std::vector<TypingLatencyResult> GetResults()
+    {
+        const std::lock_guard lock = std::lock_guard(_lock);
+
+        std::vector<TypingLatencyResult> results;
+        results.reserve(_workloads.size());
+
+        for(std::size_t workload = 0; workload < _workloads.size(); ++workload)
+        {
+            std::vector<double>& presentLatencies = _presentLatencies[workload];
+            std::vector<double>& gpuDoneLatencies = _gpuDoneLatencies[workload];
+
+            std::sort(presentLatencies.begin(), presentLatencies.end());
+            std::sort(gpuDoneLatencies.begin(), gpuDoneLatencies.end());
+
+            results.push_back(TypingLatencyResult { .Name = _workloads[workload].Name,
+                                                    .SampleCount = presentLatencies.size(),
+                                                    .MissedCount = _missedCounts[workload],
+                                                    .PresentP50 = GetPercentile(presentLatencies, 0.50),
+                                                    .PresentP95 = GetPercentile(presentLatencies, 0.95),
+                                                    .PresentP99 = GetPercentile(presentLatencies, 0.99),
+                                                    .PresentMaximum = presentLatencies.empty() == true ? 0.0 : presentLatencies.back(),
+                                                    .GPUDoneP50 = GetPercentile(gpuDoneLatencies, 0.50),
+                                                    .GPUDoneP95 = GetPercentile(gpuDoneLatencies, 0.95),
+                                                    .GPUDoneP99 = GetPercentile(gpuDoneLatencies, 0.99),
+                                                    .GPUDoneMaximum = gpuDoneLatencies.empty() == true ? 0.0 : gpuDoneLatencies.back() });
+        };
+
+        return results;
+    };
+
+
+private:
+
+    /// <summary>
+    /// (Injector) Replay every workload, then wait for the injections to be presented and close the window
+    /// </summary>
+    void Inject()
+    {
+        // Nothing can be matched before the document's starting size is known
+        while(_presentedDocumentSize.load(std::memory_order_acquire) < 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        };
+
+        // Let the window finish coming up, its first frames aren't representative
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+        std::size_t documentSize = static_cast<std::size_t>(_presentedDocumentSize.load(std::memory_order_acquire));
+
+        for(std::size_t workload = 0; workload < _workloads.size() && glfwWindowShouldClose(_window) == false; ++workload)
+        {
+            const TypingWorkload& typingWorkload = _workloads[workload];
+
+            const auto interval = std::chrono::duration<double>(typingWorkload.IntervalSeconds);
+
+            for(std::uint32_t repetition = 0; repetition < typingWorkload.Repetitions; ++repetition)
+            {
+                if(typingWorkload.Type == TypingInputType::Paste)
+                {
+                    // Setting the clipboard isn't part of the latency, only the keystroke that pastes it is
+                    SetClipboardText(typingWorkload.Text);
+
+                    documentSize += typingWorkload.Text.size();
+
+                    Send(workload, documentSize, GetPasteInputs());
+
+                    std::this_thread::sleep_for(interval);
+                    continue;
+                };
+
+                for(const char character : typingWorkload.Text)
+                {
+                    ++documentSize;
+
+                    Send(workload, documentSize, wt::Input::StringToInputListA(std::string(1, character)));
+
+                    std::this_thread::sleep_for(interval);
+                };
+            };
+        };
+
+
+        const double drainStart = glfwGetTime();
+
+        while(glfwGetTime() - drainStart < DrainTimeoutSeconds)
+        {
+            {
+                const std::lock_guard lock = std::lock_guard(_lock);
+
+                if(_pendingInjections.empty() == true && _pendingGPUSampleCount == 0)
+                    break;
+            };
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        };
+
+        {
+            const std::lock_guard lock = std::lock_guard(_lock);
+
+            for(const Injection& injection : _pendingInjections)
+            {
+                ++_missedCounts[injection.Workload];
+            };
+
+            _pendingInjections.clear();
+        };
+
+        _finished.store(true, std::memory_order_release);
+
+        glfwSetWindowShouldClose(_window, GLFW_TRUE);
+        glfwPostEmptyEvent();
+    };
+
+    /// <summary>
+    /// (Injector) Timestamp an injection and send its inputs
+    /// </summary>
+    void Send(const std::size_t workload, const std::size_t documentSize, const std::vector<INPUT>& inputs)
+    {
+        {
+            const std::lock_guard lock = std::lock_guard(_lock);
+
+            // Queued before it's sent, so even a frame that's presented immediately finds it
+            _pendingInjections.push_back(Injection { .Workload = workload, .InjectionTime = glfwGetTime(), .DocumentSize = documentSize });
+        };
+
+        wt::Input::SendKeyPress(inputs);
+    };
+
+
+    std::uint32_t AcquireQuery()
+    {
+        if(_freeQueries.empty() == true)
+        {
+            std::uint32_t query = 0;
+            glCreateQueries(GL_TIMESTAMP, 1, &query);
+
+            _queries.push_back(query);
+
+            return query;
+        };
+
+        const std::uint32_t query = _freeQueries.back();
+        _freeQueries.pop_back();
+
+        return query;
+    };
+
+
+    static std::vector<INPUT> GetPasteInputs()
+    {
+        std::vector<INPUT> inputs = std::vector<INPUT>(4);
+
+        for(INPUT& input : inputs)
+        {
+            input.type = INPUT_KEYBOARD;
+        };
+
+        inputs[0].ki.wVk = VK_CONTROL;
+        inputs[1].ki.wVk = 'V';
+        inputs[2].ki.wVk = 'V';
+        inputs[2].ki.dwFlags = KEYEVENTF_KEYUP;
+        inputs[3].ki.wVk = VK_CONTROL;
+        inputs[3].ki.dwFlags = KEYEVENTF_KEYUP;
+
+        return inputs;
+    };
+
+    /// <summary>
+    /// Put ANSI text on the clipboard, Windows converts it for readers of CF_UNICODETEXT such as GLFW
+    /// </summary>
+    static void SetClipboardText(const std::string& text)
+    {
+        if(OpenClipboard(nullptr) == FALSE)
+            return;
+
+        EmptyClipboard();
+
+        const HGLOBAL memory = GlobalAlloc(GMEM_MOVEABLE, text.size() + 1);
+
+        if(memory != nullptr)
+        {
+            std::memcpy(GlobalLock(memory), text.c_str(), text.size() + 1);
+            GlobalUnlock(memory);
+
+            // The clipboard owns the memory from here on, unless it refused it
+            if(SetClipboardData(CF_TEXT, memory) == nullptr)
+                GlobalFree(memory);
+        };
+
+        CloseClipboard();
+    };
+
+    /// <summary>
+    /// Nearest-rank percentile of sorted samples
+    /// </summary>
+    static double GetPercentile(const std::vector<double>& sortedSamples, const double percentile)
+    {
+        if(sortedSamples.empty() == true)
+            return 0.0;
+
+        const std::size_t rank = static_cast<std::size_t>(std::ceil(percentile * static_cast<double>(sortedSamples.size())));
+
+        return sortedSamples[std::clamp<std::size_t>(rank, 1, sortedSamples.size()) - 1];
+    };
+
+};
+
+
+/// <summary>
+/// Write results as a JSON array, one object per workload
+/// </summary>
+inline void WriteTypingLatencyResultsJSON(std::ostream& stream, const std::vector<TypingLatencyResult>& results)
+{
+    stream << "[\n";
+
+    for(std::size_t index = 0; index < results.size(); ++index)
+    {
+        const TypingLatencyResult& result = results[index];
+
+        // Workload names are ours, nothing in them needs escaping
+        char line[512] = { };
+
+        std::snprintf(line, sizeof(line),
+                      "  { \"name\": \"%s\", \"samples\": %zu, \"missed\": %zu, "
+                      "\"presentMsP50\": %.3f, \"presentMsP95\": %.3f, \"presentMsP99\": %.3f, \"presentMsMax\": %.3f, "
+                      "\"gpuDoneMsP50\": %.3f, \"gpuDoneMsP95\": %.3f, \"gpuDoneMsP99\": %.3f, \"gpuDoneMsMax\": %.3f }%s\n",
+                      result.Name.c_str(),
+                      result.SampleCount,
+                      result.MissedCount,
+                      result.PresentP50,
+                      result.PresentP95,
+                      result.PresentP99,
+                      result.PresentMaximum,
+                      result.GPUDoneP50,
+                      result.GPUDoneP95,
+                      result.GPUDoneP99,
+                      result.GPUDoneMaximum,
+                      index + 1 < results.size() ? "," : "");
+
+        stream << line;
+    };
+
+    stream << "]\n";
+};
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GLDiagnostics.hpp"
+#include "WindowsUtilities.hpp"
+
+
+/// <summary>
+/// Tracks an upload submitted to an UploadWorker.
+/// The upload is complete once its fence is signalled, which any context sharing objects with the worker's can check
+/// </summary>
+class UploadTicket
+{
+    friend class UploadWorker;
+
+private:
+
+    struct State
+    {
+        /// <summary>
+        /// Set by the worker once the upload's commands were issued and flushed, with Fence written before it
+        /// </summary>
+        std::atomic<bool> Submitted = false;
+
+        GLsync Fence = nullptr;
+
+
+        State() = default;
+
+        State(const State&) = delete;
+        State& operator = (const State&) = delete;
+
+        /// <summary>
+        /// The last reference may be dropped on any thread with a context current, sync objects are shared between contexts
+        /// </summary>
+        ~State()
+        {
+            if(Fence != nullptr)
+                glDeleteSync(Fence);
+        };
+    };
+
+
+    std::shared_ptr<State> _state;
+
+
+    UploadTicket(std::shared_ptr<State> state) :
+        _state(std::move(state))
+    {
+    };
+
+
+public:
+
+    /// <summary>
+    /// An empty ticket, which is always complete
+    /// </summary>
+    UploadTicket() = default;
+
+
+public:
+
+    bool IsValid() const
+    {
+        return _state != nullptr;
+    };
+
+    /// <summary>
+    /// Check whether the GPU is done with the upload, without waiting
+    /// </summary>
+    bool IsComplete() const
+    {
+        if(_state == nullptr)
+            return true;
+
+        if(_state->Submitted.load(std::memory_order_acquire) == false)
+            return false;
+
+        return glClientWaitSync(_state->Fence, 0, 0) != GL_TIMEOUT_EXPIRED;
+    };
+
+    /// <summary>
+    /// Block until the GPU is done with the upload
+    /// </summary>
+    void Wait() const
+    {
+        if(_state == nullptr)
+            return;
+
+        _state->Submitted.wait(false, std::memory_order_acquire);
+
+        while(glClientWaitSync(_state->Fence, 0, 1'000'000) == GL_TIMEOUT_EXPIRED)
+        {
+        };
+    };
+
+    /// <summary>
+    /// Make the current context's command stream wait for the upload, without blocking the CPU once the upload was submitted.
+    /// Commands issued after this call may use the uploaded data
+    /// </summary>
+    void WaitOnGPU() const
+    {
+        if(_state == nullptr)
+            return;
+
+        _state->Submitted.wait(false, std::memory_order_acquire);
+
+        glWaitSync(_state->Fence, 0, GL_TIMEOUT_IGNORED);
+    };
+
+};
+
+
+/// <summary>
+/// Performs uploads on a thread of its own, with a hidden context that shares objects with the main window's.
+/// Large texture and buffer uploads go through staging buffers on the worker, so the render thread never stalls on the copy.
+/// Every upload ends with a fence, see UploadTicket
+/// </summary>
+class UploadWorker
+{
+
+private:
+
+    struct Job
+    {
+        std::function<void()> Upload;
+
+        std::shared_ptr<UploadTicket::State> State;
+    };
+
+
+    /// <summary>
+    /// A hidden 1x1 window, only there for its context
+    /// </summary>
+    GLFWwindow* _uploadWindow = nullptr;
+
+    std::thread _thread;
+
+
+    std::mutex _jobsLock;
+
+    std::condition_variable _jobsChanged;
+
+    std::deque<Job> _jobs;
+
+    /// <summary>
+    /// Set on destruction, the worker finishes the queued jobs and exits
+    /// </summary>
+    bool _stopping = false;
+
+
+public:
+
+    /// <summary>
+    /// Must be called on the main thread, GLFW only creates windows there.
+    /// The current window hints are reused, so the worker's context matches the shared one
+    /// </summary>
+    /// <param name="sharedWindow"> The window whose context's objects the uploads are written into </param>
+    /// <param name="scheduling"> The upload thread's priority and affinity </param>
+    UploadWorker(GLFWwindow* sharedWindow, const wt::ThreadScheduling& scheduling = { })
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        _uploadWindow = glfwCreateWindow(1, 1, "", nullptr, sharedWindow);
+
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+        wt::Assert(_uploadWindow != nullptr, "Failed to create the upload context");
+
+
+        _thread = std::thread([this, scheduling]()
+        {
+            scheduling.ApplyToCurrentThread();
+
+            Run();
+        });
+    };
+
+    UploadWorker(const UploadWorker&) = delete;
+    UploadWorker& operator = (const UploadWorker&) = delete;
+
+    /// <summary>
+    /// Finishes the queued uploads first. Must be called on the main thread
+    /// </summary>
+    ~UploadWorker()
+    {
+        {
+            const std::lock_guard lock = std::lock_guard(_jobsLock);
+
+            _stopping = true;
+        };
+
+        _jobsChanged.notify_one();
+
+        _thread.join();
+
+        glfwDestroyWindow(_uploadWindow);
+    };
+
+
+public:
+
+    /// <summary>
+    /// Queue a function to run on the worker, with the upload context current
+    /// </summary>
+    /// <param name="upload"> Issues the upload's GL commands. Anything it captures must stay valid until the ticket is complete </param>
+    UploadTicket Submit(std::function<void()> upload)
+    {
+        std::shared_ptr<UploadTicket::State> state = std::make_shared<UploadTicket::State>();
+
+        {
+            const std::lock_guard lock = std::lock_guard(_jobsLock);
+
+            _jobs.emplace_back(Job
+            {
+                .Upload = std::move(upload),
+                .State = state,
+            });
+        };
+
+        _jobsChanged.notify_one();
+
+        return UploadTicket(std::move(state));
+    };
+
+
+    /// <summary>
+    /// Write pixels into a region of an existing texture's storage, through a pixel unpack buffer
+    /// </summary>
+    /// <param name="texture"> The texture, must not be deleted before the ticket is complete </param>
+    /// <param name="pixels"> The region's pixels, tightly packed rows of the given alignment </param>
+    UploadTicket UploadTexture(const std::uint32_t texture,
+                               const int level,
+                               const int x, const int y,
+                               const int width, const int height,
+                               const GLenum pixelFormat,
+                               const GLenum pixelType,
+                               std::vector<std::byte> pixels,
+                               const int unpackAlignment = 4)
+    {
+        return Submit([=, pixels = std::move(pixels)]()
+        {
+            const std::uint32_t stagingBuffer = CreateStagingBuffer(pixels);
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+            // With an unpack buffer bound the pointer is an offset into it
+            glTextureSubImage2D(texture, level, x, y, width, height, pixelFormat, pixelType, nullptr);
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            // The storage lives on until the copy is done
+            glDeleteBuffers(1, &stagingBuffer);
+        });
+    };
+
+    /// <summary>
+    /// Write data into a range of an existing buffer, through a staging buffer
+    /// </summary>
+    /// <param name="buffer"> The buffer, must not be deleted before the ticket is complete </param>
+    /// <param name="offset"> Where in the buffer the data is written, in bytes </param>
+    UploadTicket UploadBuffer(const std::uint32_t buffer, const std::size_t offset, std::vector<std::byte> data)
+    {
+        return Submit([=, data = std::move(data)]()
+        {
+            const std::uint32_t stagingBuffer = CreateStagingBuffer(data);
+
+            glCopyNamedBufferSubData(stagingBuffer, buffer, 0, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(data.size()));
+
+            glDeleteBuffers(1, &stagingBuffer);
+        });
+    };
+
+
+private:
+
+    void Run()
+    {
+        glfwMakeContextCurrent(_uploadWindow);
+
+        // The worker's context is created with the same debug flags, but the callback is per-context
+        EnableGLDiagnostics(GLDiagnostics);
+
+        while(true)
+        {
+            Job job;
+
+            {
+                std::unique_lock lock = std::unique_lock(_jobsLock);
+
+                _jobsChanged.wait(lock, [this]()
+                {
+                    return _jobs.empty() == false || _stopping == true;
+                });
+
+                if(_jobs.empty() == true)
+                    break;
+
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+            };
+
+
+            job.Upload();
+
+            job.State->Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+            // Other contexts can only wait on a fence that has reached the GPU
+            glFlush();
+
+            job.State->Submitted.store(true, std::memory_order_release);
+            job.State->Submitted.notify_all();
+        };
+
+        glfwMakeContextCurrent(nullptr);
+    };
+
+
+    static std::uint32_t CreateStagingBuffer(const std::vector<std::byte>& data)
+    {
+        std::uint32_t stagingBuffer = 0;
+
+        glCreateBuffers(1, &stagingBuffer);
+        glNamedBufferStorage(stagingBuffer, static_cast<GLsizeiptr>(data.size()), data.data(), 0);
+
+        return stagingBuffer;
+    };
+
+};
@@ -100,23 +100,6 @@
 layout(location = 0) in vec2 VertexPosition;
 
 
-struct Particle
-{
-    float TrajectoryA;
-    float TrajectoryB;
-
-    vec2 Trajectory;
-
-    mat4 Transform;
-    
-    float Rate;
-
-    float Opacity;
-
-    float OpacityDecreaseRate;
-};
-
-
 struct Test_Struct
 {
     vec2 Test_Vec2_1;
@@ -160,7 +143,6 @@ out vec4 VertexShaderTextColourOutput;
 
 void main()
 {
-    // VertexShaderTextureCoordinateOutput = Particles[0].Trajectory;
     VertexShaderTextureCoordinateOutput = test_structs[1].Test_Vec2_1 + test_structs[0].Test_Vec2_2;
 
     // gl_Position = Projection * TextTransform * VertexShaderTextColourOutput;
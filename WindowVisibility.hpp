@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Windows.h>
+#include <dwmapi.h>
+#include <GLFW/glfw3.h>
+
+#define GLFW_EXPOSE_NATIVE_WIN32
+#include <GLFW/glfw3native.h>
+
+#pragma comment(lib, "Dwmapi.lib")
+
+
+/// <summary>
+/// How much of a window the user can see, which decides how often it's worth drawing
+/// </summary>
+enum class WindowVisibility
+{
+    /// <summary>
+    /// Shown and focused, frames are drawn as usual
+    /// </summary>
+    Focused,
+
+    /// <summary>
+    /// Shown behind or next to the focused window, frames are drawn at a reduced rate
+    /// </summary>
+    Unfocused,
+
+    /// <summary>
+    /// Minimized, or cloaked by the compositor, e.g. on another virtual desktop. Nothing drawn would reach the screen
+    /// </summary>
+    Hidden,
+};
+
+
+/// <summary>
+/// (Main thread) A window's current visibility. Call from the iconify and focus callbacks, switching virtual desktops moves the focus too.
+/// A GL window has no swap chain that reports occlusion like DXGI's, a window merely covered by others counts as unfocused
+/// </summary>
+inline WindowVisibility GetWindowVisibility(GLFWwindow* window)
+{
+    if(glfwGetWindowAttrib(window, GLFW_ICONIFIED) == GLFW_TRUE || glfwGetWindowAttrib(window, GLFW_VISIBLE) == GLFW_FALSE)
+        return WindowVisibility::Hidden;
+
+    DWORD cloaked = 0;
+
+    if(SUCCEEDED(DwmGetWindowAttribute(glfwGetWin32Window(window), DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked != 0)
+        return WindowVisibility::Hidden;
+
+    if(glfwGetWindowAttrib(window, GLFW_FOCUSED) == GLFW_FALSE)
+        return WindowVisibility::Unfocused;
+
+    return WindowVisibility::Focused;
+};
@@ -16,11 +16,13 @@
 #include <Windows.h>
 #include <comdef.h>
 #include <string>
+#include <algorithm>
 #include <memory>
 #include <cstdint>
 #include <gdiplus.h>
 #include <vector>
 #include <bcrypt.h>
+#include <avrt.h>
 #include <shellapi.h>
 #include <locale>
 #include <codecvt>
@@ -30,10 +32,12 @@
 #include <thread>
 #include <cassert>
 #include <source_location>
+#include <concepts>
 #include <filesystem>
 
 
 #pragma comment(lib, "Bcrypt.lib")
+#pragma comment(lib, "Avrt.lib")
 
 
 #pragma region // Forward declarations, don't you just *love* C ?
@@ -545,12 +549,15 @@ namespace WindowsUtilities
 
     /// <summary>
     /// A function that will assert an expression. 
-    /// Will throw CRT exception if expression results in "false"
+    /// Will throw CRT exception if expression results in "false".
+    /// The message is taken as a template parameter rather than an std::function, so nothing is constructed unless the assertion fails
     /// </summary>
     /// <param name="expression"> The expression to assert </param>
-    /// <param name="messageResult"> A callable function that will return a message as a "std::string". Will only be called if the expression fails </param>
+    /// <param name="messageResult"> A callable returning the message, as anything a "std::string" can be made from. Will only be called if the expression fails </param>
     /// <param name="sourceLocation"> The location at which this function was called  </param>
-    static bool Assert(const bool expression, const std::function<std::string(void)>& messageResult, const std::source_location sourceLocation = std::source_location::current())
+    template<typename TMessage>
+    requires std::invocable<TMessage&>
+    static bool Assert(const bool expression, TMessage&& messageResult, const std::source_location sourceLocation = std::source_location::current())
     {
         #ifdef _DEBUG
 
@@ -561,7 +568,9 @@ namespace WindowsUtilities
 
             const std::string moduleFilename = std::filesystem::path(modulePath).filename().string();
 
-            const int reportResult = _CrtDbgReport(_CRT_ASSERT, sourceLocation.file_name(), sourceLocation.line(), moduleFilename.c_str(), "%s", messageResult().data());
+            const std::string message = std::string(messageResult());
+
+            const int reportResult = _CrtDbgReport(_CRT_ASSERT, sourceLocation.file_name(), sourceLocation.line(), moduleFilename.c_str(), "%s", message.c_str());
 
             if(reportResult == 1)
                 __debugbreak();
@@ -575,36 +584,35 @@ namespace WindowsUtilities
     };
 
     /// <summary>
-    /// Asserts an expressions as an std::function for more complex assertions
+    /// Asserts an expressions as a callable for more complex assertions. In release builds the expression isn't called
     /// </summary>
      /// <param name="expression"> The expression to assert </param>
-    /// <param name="messageResult"> A callable function that will return a message as a "std::string". Will only be called if the expression fails </param>
+    /// <param name="messageResult"> A callable function that will return a message. Will only be called if the expression fails </param>
     /// <param name="sourceLocation"> The location at which this function was called  </param>
     /// <returns></returns>
-    static bool Assert(const std::function<bool(void)>& expression, const std::function<std::string(void)>& messageResult, const std::source_location sourceLocation = std::source_location::current())
+    template<typename TExpression, typename TMessage>
+    requires std::invocable<TExpression&> && std::invocable<TMessage&>
+    static bool Assert(TExpression&& expression, TMessage&& messageResult, const std::source_location sourceLocation = std::source_location::current())
     {
         #ifdef _DEBUG
         const bool expressionResult = expression();
-        
-        if(expressionResult == false)
-        {
-            char modulePath[MAX_PATH + 1] { 0 };
-            GetModuleFileNameA(nullptr, modulePath, MAX_PATH + 1);
-
-            const std::string moduleFilename = std::filesystem::path(modulePath).filename().string();
 
-            const int reportResult = _CrtDbgReport(_CRT_ASSERT, sourceLocation.file_name(), sourceLocation.line(), moduleFilename.c_str(), "%s", messageResult().data());
-
-            if(reportResult == 1)
-                __debugbreak();
-        };
-
-        return expressionResult;
+        return Assert(expressionResult, messageResult, sourceLocation);
         #else
         return true;
         #endif
     };
 
+    /// <summary>
+    /// Assert for hot paths. Unlike wt::Assert, which still evaluates its expression in release builds, nothing of this is left in them,
+    /// so the expression must not have side effects. Takes the same messages as wt::Assert
+    /// </summary>
+    #ifdef _DEBUG
+    #define WT_ASSERT(expression, ...) ::WindowsUtilities::Assert((expression), __VA_ARGS__)
+    #else
+    #define WT_ASSERT(expression, ...) ((void)sizeof((expression) == true))
+    #endif
+
     #pragma warning(pop)
 
 
@@ -832,6 +840,150 @@ namespace WindowsUtilities
     #pragma endregion
 
 
+    #pragma region Thread scheduling
+
+    /// <summary>
+    /// How a thread is scheduled, applied by the thread itself when it starts, e.g. by JobSystem and UploadWorker's threads
+    /// </summary>
+    struct ThreadScheduling
+    {
+        /// <summary>
+        /// A THREAD_PRIORITY_ value
+        /// </summary>
+        int Priority = THREAD_PRIORITY_NORMAL;
+
+        /// <summary>
+        /// The cores the thread may run on, a bit per logical processor in the process' group. 0 leaves it on any
+        /// </summary>
+        std::uint64_t AffinityMask = 0;
+
+
+        /// <returns> False if the priority or the affinity couldn't be set </returns>
+        bool ApplyToCurrentThread() const
+        {
+            bool applied = true;
+
+            if (Priority != THREAD_PRIORITY_NORMAL)
+                applied &= SetThreadPriority(GetCurrentThread(), Priority) != FALSE;
+
+            if (AffinityMask != 0)
+                applied &= SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(AffinityMask)) != 0;
+
+            return applied;
+        };
+    };
+
+
+    /// <summary>
+    /// Registers the calling thread with the Multimedia Class Scheduler Service for as long as the object lives.
+    /// MMCSS raises a registered thread's priority for most of every period and only lowers it briefly, so background work can't starve it,
+    /// which keeps a render thread's frame times steady while other processes, or the process' own workers, are busy.
+    /// Must be created and destroyed on the same thread
+    /// </summary>
+    class MMCSSThread
+    {
+    private:
+
+        HANDLE _task = nullptr;
+
+
+    public:
+
+        /// <param name="taskName"> A task under HKLM\SOFTWARE\Microsoft\Windows NT\CurrentVersion\Multimedia\SystemProfile\Tasks, e.g. L"Games" or L"Pro Audio" </param>
+        /// <param name="priority"> The thread's priority relative to other threads of the same task </param>
+        MMCSSThread(const wchar_t* taskName = L"Games", const AVRT_PRIORITY priority = AVRT_PRIORITY_HIGH)
+        {
+            DWORD taskIndex = 0;
+
+            // Fails without the service, e.g. on some server editions, the thread then simply keeps its priority
+            _task = AvSetMmThreadCharacteristicsW(taskName, &taskIndex);
+
+            if (_task != nullptr)
+                AvSetMmThreadPriority(_task, priority);
+        };
+
+        MMCSSThread(const MMCSSThread&) = delete;
+        MMCSSThread& operator = (const MMCSSThread&) = delete;
+
+        ~MMCSSThread()
+        {
+            if (_task != nullptr)
+                AvRevertMmThreadCharacteristics(_task);
+        };
+
+
+    public:
+
+        bool IsRegistered() const
+        {
+            return _task != nullptr;
+        };
+
+    };
+
+
+    /// <summary>
+    /// A waitable timer with the resolution of the system's high-resolution timer, a fraction of a millisecond,
+    /// rather than the default tick of about 15.6 ms that Sleep and wait timeouts are rounded to.
+    /// Falls back to a regular waitable timer before Windows 10 1803
+    /// </summary>
+    class HighResolutionTimer
+    {
+    private:
+
+        SmartWin32Handle _timer = nullptr;
+
+
+    public:
+
+        HighResolutionTimer()
+        {
+            _timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+            if (_timer.Get() == nullptr)
+                _timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        };
+
+        HighResolutionTimer(const HighResolutionTimer&) = delete;
+        HighResolutionTimer& operator = (const HighResolutionTimer&) = delete;
+
+
+    public:
+
+        /// <summary>
+        /// Signal the timer after a duration, wait on GetHandle along with other handles
+        /// </summary>
+        template <class _Rep, class _Period>
+        void Set(const std::chrono::duration<_Rep, _Period>& duration)
+        {
+            // Negative due times are relative, in 100 ns units
+            LARGE_INTEGER dueTime = { };
+            dueTime.QuadPart = -std::max<long long>(std::chrono::duration_cast<std::chrono::duration<long long, std::ratio<1, 10000000>>>(duration).count(), 1);
+
+            SetWaitableTimer(_timer, &dueTime, 0, nullptr, nullptr, FALSE);
+        };
+
+        /// <summary>
+        /// Block the calling thread for a duration
+        /// </summary>
+        template <class _Rep, class _Period>
+        void Wait(const std::chrono::duration<_Rep, _Period>& duration)
+        {
+            Set(duration);
+
+            WaitForSingleObject(_timer, INFINITE);
+        };
+
+        HANDLE GetHandle()
+        {
+            return _timer.Get();
+        };
+
+    };
+
+    #pragma endregion
+
+
 };
 
 